@@ -0,0 +1,238 @@
+##
+# @file test_DebuggerCaptureBuffer.py
+#
+# @author Sina Karvandi (sina@hyperdbg.org)
+#
+# @brief Testing module for DebuggerCaptureBuffer (logic analyzer)
+#
+# @details
+#
+# @version 0.1
+#
+# @date 2024-12-10
+#
+# @copyright This project is released under the GNU Public License v3.
+#
+
+import os
+import json
+
+import cocotb
+from cocotb.clock import Clock
+from cocotb.triggers import Timer
+
+'''
+  input         clock,
+                reset,
+                io_en,
+                io_inputPin_0,
+                ...
+                io_inputPin_31,
+                io_triggerPin_0,
+                ...
+                io_triggerPin_31,
+                io_arm,
+  input  [31:0] io_configuration_TriggerPin,
+                io_configuration_PreTriggerEntries,
+                io_configuration_PostTriggerEntries,
+  output [1:0]  io_status_captureState,
+  output [10:0] io_status_numberOfEntries,
+                io_status_triggerEntry,
+  input  [9:0]  io_readEntryIndex,
+  output [15:0] io_readEntry_RunLength,
+  output [31:0] io_readEntry_Sample
+'''
+
+#
+# Capture states (same as HwdbgCaptureStateEnums)
+#
+CAPTURE_STATE_DONE = 3
+
+#
+# Capture window (in entries)
+#
+PRE_TRIGGER_ENTRIES = 16
+POST_TRIGGER_ENTRIES = 32
+
+def read_capture_configurations():
+    """Read the capture buffer configurations of the generated hwdbg"""
+
+    config_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "../../../../src/main/scala/hwdbg/configs/config.json")
+
+    with open(config_path) as config_file:
+        return json.load(config_file)["CaptureConfigurations"]
+
+def slow_pattern(clock):
+    """Slowly changing pins (e.g., control signals)"""
+
+    return ((clock // 37) & 1) | (((clock // 101) & 1) << 1)
+
+def bursty_pattern(clock):
+    """Pin 2 toggles at each clock during the bursts (e.g., a data line)"""
+
+    burst = ((clock // 64) & 1) == 1
+
+    return ((clock // 7) & 1) | (((clock & 1) if burst else 0) << 2)
+
+def toggling_pattern(clock):
+    """Pin 0 toggles at each clock (each sample needs a separate entry)"""
+
+    return clock & 1
+
+def apply_pins(dut, number_of_pins, sample):
+    """Apply the input pins"""
+
+    for i in range(number_of_pins):
+        getattr(dut, "io_inputPin_" + str(i)).value = (sample >> i) & 1
+
+async def capture(dut, number_of_pins, trigger_pin, pattern, trigger_clock, pre_trigger_entries, post_trigger_entries):
+    """Arm the capture buffer, drive the pattern, raise the trigger pin and return the applied samples"""
+
+    #
+    # Arm the capture buffer (the sample of this clock is not captured)
+    #
+    dut.io_arm.value = 1
+    dut.io_configuration_TriggerPin.value = trigger_pin
+    dut.io_configuration_PreTriggerEntries.value = pre_trigger_entries
+    dut.io_configuration_PostTriggerEntries.value = post_trigger_entries
+    await Timer(10, units="ns")
+    dut.io_arm.value = 0
+
+    samples = []
+    clock = 0
+
+    while dut.io_status_captureState.value != CAPTURE_STATE_DONE:
+
+        assert clock < 200000, "err, the capture is not finished"
+
+        sample = pattern(clock)
+        apply_pins(dut, number_of_pins, sample)
+        getattr(dut, "io_triggerPin_" + str(trigger_pin)).value = 1 if clock == trigger_clock else 0
+
+        samples.append(sample)
+        clock = clock + 1
+
+        await Timer(10, units="ns")
+
+    getattr(dut, "io_triggerPin_" + str(trigger_pin)).value = 0
+
+    return samples
+
+async def read_capture_window(dut):
+    """Read the entries of the capture window (each entry is available one clock after its index)"""
+
+    entries = []
+
+    for index in range(int(dut.io_status_numberOfEntries.value)):
+        dut.io_readEntryIndex.value = index
+        await Timer(10, units="ns")
+        entries.append((int(dut.io_readEntry_RunLength.value), int(dut.io_readEntry_Sample.value)))
+
+    return entries
+
+async def check_capture(dut, number_of_pins, depth, name, pattern, trigger_clock,
+                        pre_trigger_entries=PRE_TRIGGER_ENTRIES, post_trigger_entries=POST_TRIGGER_ENTRIES):
+    """Capture the pattern and check the decoded capture window with the applied samples"""
+
+    trigger_pin = number_of_pins - 1
+
+    #
+    # The window is clamped into the buffer by the hardware (at least the trigger
+    # entry is captured)
+    #
+    expected_post_trigger_entries = min(max(post_trigger_entries, 1), depth)
+    expected_pre_trigger_entries = min(pre_trigger_entries, depth - expected_post_trigger_entries)
+
+    samples = await capture(dut, number_of_pins, trigger_pin, pattern, trigger_clock, pre_trigger_entries, post_trigger_entries)
+    entries = await read_capture_window(dut)
+    trigger_entry = int(dut.io_status_triggerEntry.value)
+
+    assert len(entries) == expected_pre_trigger_entries + expected_post_trigger_entries
+    assert trigger_entry == expected_pre_trigger_entries
+
+    #
+    # Decode the run-length encoded entries
+    #
+    decoded = []
+
+    for (run_length, sample) in entries:
+        assert run_length != 0
+        decoded += [sample] * run_length
+
+    #
+    # The trigger entry starts from the sample that is applied along with the trigger
+    #
+    trigger_offset = sum(run_length for (run_length, _) in entries[:trigger_entry])
+    first_sample = trigger_clock - trigger_offset
+
+    assert first_sample >= 0
+    assert decoded == samples[first_sample:first_sample + len(decoded)]
+
+    #
+    # Raw sampling stores a single sample in each entry of the same buffer
+    #
+    dut._log.info(name + ": " + str(len(entries)) + " entries cover " + str(len(decoded)) + " samples (raw sampling: " +
+                  str(len(entries)) + " samples), effective depth of the buffer: " + str(len(decoded) * depth // len(entries)) +
+                  " samples (" + "{:.2f}".format(len(decoded) / len(entries)) + "x of " + str(depth) + " samples)")
+
+@cocotb.test()
+async def DebuggerCaptureBuffer_test(dut):
+    """Test DebuggerCaptureBuffer module"""
+
+    configs = read_capture_configurations()
+    number_of_pins = len([name for name in dir(dut) if name.startswith("io_inputPin_")])
+    depth = configs["CAPTURE_BUFFER_DEPTH"]
+
+    clock = Clock(dut.clock, 10, units="ns")  # Create a 10ns period clock on port clock
+
+    #
+    # Start the clock. Start it low to avoid issues on the first RisingEdge
+    #
+    cocotb.start_soon(clock.start(start_high=False))
+
+    dut._log.info("Initialize and reset module")
+
+    #
+    # Initial values
+    #
+    dut.io_en.value = 0
+    dut.io_arm.value = 0
+    dut.io_configuration_TriggerPin.value = 0
+    dut.io_configuration_PreTriggerEntries.value = 0
+    dut.io_configuration_PostTriggerEntries.value = 0
+    dut.io_readEntryIndex.value = 0
+    apply_pins(dut, number_of_pins, 0)
+
+    for i in range(number_of_pins):
+        getattr(dut, "io_triggerPin_" + str(i)).value = 0
+
+    #
+    # Reset DUT
+    #
+    dut.reset.value = 1
+    for _ in range(10):
+        await Timer(10, units="ns")
+    dut.reset.value = 0
+
+    dut._log.info("Enabling chip")
+
+    #
+    # Enable chip
+    #
+    dut.io_en.value = 1
+
+    #
+    # Capture slowly changing pins and bursts of a data line, the buffer
+    # is armed again for each capture
+    #
+    await check_capture(dut, number_of_pins, depth, "Slow pins", slow_pattern, 800)
+    await check_capture(dut, number_of_pins, depth, "Bursty pins", bursty_pattern, 300)
+
+    #
+    # Windows that don't fit into the buffer are clamped (the post-trigger entries
+    # never overwrite the pre-trigger entries), and a capture without post-trigger
+    # entries is finished once the trigger entry is written
+    #
+    await check_capture(dut, number_of_pins, depth, "Window larger than the buffer", toggling_pattern, depth + 100, depth, 64)
+    await check_capture(dut, number_of_pins, depth, "Post-trigger window larger than the buffer", toggling_pattern, depth + 100, 16, depth * 2)
+    await check_capture(dut, number_of_pins, depth, "No post-trigger entries", toggling_pattern, 300, 16, 0)
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# Generate and simulate the script execution engine for different numbers of
+# fused operators per stage (MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE), and report
+# the stages used by the test script, the latency of the pipeline and (if Yosys
+# is installed) the longest combinational path (in 6-input LUTs) of the engine
+#
+# Usage: ./sweep.sh [N...] (default: 1 2 4)
+#
+set -e
+
+cd "$(dirname "$0")"
+
+ROOT_DIR=$(cd ../../../.. && pwd)
+CONFIG_FILE=$ROOT_DIR/src/main/scala/hwdbg/configs/config.json
+OPERATORS_PER_STAGE=${@:-1 2 4}
+
+#
+# Restore the configuration once the sweep is finished
+#
+cp "$CONFIG_FILE" config.json.bak
+trap 'mv config.json.bak "$CONFIG_FILE"' EXIT
+
+for N in $OPERATORS_PER_STAGE; do
+
+    python3 - "$CONFIG_FILE" "$N" <<'PYTHON'
+import json
+import sys
+
+with open(sys.argv[1]) as config_file:
+    config = json.load(config_file)
+
+config["ScriptEngineConfigurations"]["MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE"] = int(sys.argv[2])
+
+with open(sys.argv[1], "w") as config_file:
+    json.dump(config, config_file, indent=4)
+PYTHON
+
+    (cd "$ROOT_DIR" && sbt "runMain hwdbg.Main")
+
+    rm -rf sim_build results.xml
+    make SIM=icarus > sweep_$N.log 2>&1 || true
+
+    echo "N=$N:"
+    grep -E "packed into|latency:|FAIL|PASS" sweep_$N.log | sed 's/^.*INFO *[^ ]* *//'
+
+    if command -v yosys > /dev/null; then
+        yosys -q -p "read_verilog -sv $ROOT_DIR/generated/ScriptExecutionEngine.sv $ROOT_DIR/generated/ScriptEngine*.sv; \
+                     synth -flatten -top ScriptExecutionEngine; abc -lut 6; opt_clean; tee -o yosys_$N.log ltp -noff" > /dev/null
+        grep "Longest topological path" yosys_$N.log
+    fi
+done
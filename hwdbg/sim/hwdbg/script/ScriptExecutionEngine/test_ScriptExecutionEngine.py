@@ -0,0 +1,233 @@
+##
+# @file test_ScriptExecutionEngine.py
+#
+# @author Sina Karvandi (sina@hyperdbg.org)
+#
+# @brief Testing module for ScriptExecutionEngine (fused operators)
+#
+# @details
+#
+# @version 0.1
+#
+# @date 2024-12-10
+#
+# @copyright This project is released under the GNU Public License v3.
+#
+
+import os
+import json
+
+import cocotb
+from cocotb.clock import Clock
+from cocotb.triggers import Timer
+
+'''
+  input        clock,
+               reset,
+               io_en,
+               io_finishedScriptConfiguration,
+               io_configureStage,
+  input  [7:0] io_targetOperator_Type,
+               io_targetOperator_Value,
+  input        io_inputPin_0,
+               ...
+               io_inputPin_31,
+  output       io_outputPin_0,
+               ...
+               io_outputPin_31
+'''
+
+#
+# Symbol types (same as SYMBOL_*_TYPE in ScriptEngineCommonDefinitions.h)
+#
+SYMBOL_NUM_TYPE = 3
+SYMBOL_REGISTER_TYPE = 4
+SYMBOL_SEMANTIC_RULE_TYPE = 6
+SYMBOL_TEMP_TYPE = 7
+
+#
+# Operators (same as FUNC_* in ScriptEngineCommonDefinitions.h)
+#
+FUNC_AND = 7
+FUNC_EQUAL = 19
+FUNC_JZ = 22
+FUNC_MOV = 24
+
+#
+# Operators that can be fused into a stage (same as
+# HardwareScriptInterpreterIsFusibleOperator in HyperDbg)
+#
+FUSIBLE_OPERATORS = [5, 6, 7, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24]
+
+#
+# Test script (the symbol index of the end of the script is 18):
+#     if (@hw_pin0 == 1 && @hw_pin1 == 1) { @hw_pin31 = 1; }
+#
+# Each operator is followed by its GET and SET operands
+#
+TEST_SCRIPT = [
+    (FUNC_EQUAL, [(SYMBOL_REGISTER_TYPE, 0), (SYMBOL_NUM_TYPE, 1)], [(SYMBOL_TEMP_TYPE, 0)]),
+    (FUNC_EQUAL, [(SYMBOL_REGISTER_TYPE, 1), (SYMBOL_NUM_TYPE, 1)], [(SYMBOL_TEMP_TYPE, 1)]),
+    (FUNC_AND, [(SYMBOL_TEMP_TYPE, 0), (SYMBOL_TEMP_TYPE, 1)], [(SYMBOL_TEMP_TYPE, 0)]),
+    (FUNC_JZ, [(SYMBOL_NUM_TYPE, 18), (SYMBOL_TEMP_TYPE, 0)], []),
+    (FUNC_MOV, [(SYMBOL_NUM_TYPE, 1)], [(SYMBOL_REGISTER_TYPE, 31)]),
+]
+
+def read_script_engine_configurations():
+    """Read the script engine configurations of the generated hwdbg"""
+
+    config_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "../../../../src/main/scala/hwdbg/configs/config.json")
+
+    with open(config_path) as config_file:
+        return json.load(config_file)["ScriptEngineConfigurations"]
+
+def pack_script(script, configs):
+    """Pack the operators into stages (same as HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer)"""
+
+    operators_per_stage = configs["MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE"]
+    get_operands = configs["MAXIMUM_NUMBER_OF_SUPPORTED_GET_SCRIPT_OPERATORS"]
+    set_operands = configs["MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS"]
+
+    stages = []
+
+    for (operator, get_symbols, set_symbols) in script:
+
+        #
+        # Start a new stage if the operator can't be fused into the current stage
+        #
+        if len(stages) == 0 or len(stages[-1]) == operators_per_stage or operator not in FUSIBLE_OPERATORS:
+            stages.append([])
+
+        stages[-1].append(
+            [(SYMBOL_SEMANTIC_RULE_TYPE, operator)]
+            + get_symbols + [(0, 0)] * (get_operands - len(get_symbols))
+            + set_symbols + [(0, 0)] * (set_operands - len(set_symbols))
+        )
+
+    #
+    # Empty operators are not evaluated (and not counted in the symbol indexes)
+    #
+    symbols = []
+
+    for stage in stages:
+        stage = stage + [[(0, 0)] * (1 + get_operands + set_operands)] * (operators_per_stage - len(stage))
+
+        for operator_symbols in stage:
+            symbols += operator_symbols
+
+    return (len(stages), symbols)
+
+async def apply_pins(dut, number_of_pins, pin0, pin1):
+    """Apply the input pins"""
+
+    for i in range(number_of_pins):
+        getattr(dut, "io_inputPin_" + str(i)).value = 0
+
+    dut.io_inputPin_0.value = pin0
+    dut.io_inputPin_1.value = pin1
+
+@cocotb.test()
+async def ScriptExecutionEngine_test(dut):
+    """Test ScriptExecutionEngine module"""
+
+    configs = read_script_engine_configurations()
+    number_of_pins = len([name for name in dir(dut) if name.startswith("io_inputPin_")])
+    maximum_number_of_stages = configs["MAXIMUM_NUMBER_OF_STAGES"]
+    operators_per_stage = configs["MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE"]
+
+    (number_of_stages, symbols) = pack_script(TEST_SCRIPT, configs)
+
+    dut._log.info("Operators: " + str(len(TEST_SCRIPT)) + ", operators per stage: " + str(operators_per_stage) +
+                  ", packed into " + str(number_of_stages) + " stages (of " + str(maximum_number_of_stages) + " stages)")
+
+    clock = Clock(dut.clock, 10, units="ns")  # Create a 10ns period clock on port clock
+
+    #
+    # Start the clock. Start it low to avoid issues on the first RisingEdge
+    #
+    cocotb.start_soon(clock.start(start_high=False))
+
+    dut._log.info("Initialize and reset module")
+
+    #
+    # Initial values
+    #
+    dut.io_en.value = 0
+    dut.io_configureStage.value = 0
+    dut.io_finishedScriptConfiguration.value = 0
+    dut.io_targetOperator_Type.value = 0
+    dut.io_targetOperator_Value.value = 0
+    await apply_pins(dut, number_of_pins, 0, 0)
+
+    #
+    # Reset DUT
+    #
+    dut.reset.value = 1
+    for _ in range(10):
+        await Timer(10, units="ns")
+    dut.reset.value = 0
+
+    dut._log.info("Enabling chip")
+
+    #
+    # Enable chip
+    #
+    dut.io_en.value = 1
+
+    #
+    # Configure the stages, each symbol is configured in one clock and the
+    # configuration is finished along with the last symbol
+    #
+    for (index, (symbol_type, symbol_value)) in enumerate(symbols):
+        dut.io_configureStage.value = 1
+        dut.io_targetOperator_Type.value = symbol_type
+        dut.io_targetOperator_Value.value = symbol_value
+        dut.io_finishedScriptConfiguration.value = 1 if index == len(symbols) - 1 else 0
+        await Timer(10, units="ns")
+
+    dut.io_configureStage.value = 0
+    dut.io_finishedScriptConfiguration.value = 0
+
+    #
+    # Check the number of stages that are used by the script
+    #
+    enabled_stages = 0
+
+    for i in range(maximum_number_of_stages):
+        if getattr(dut, "stageRegs_" + str(i) + "_stageEnable").value == 1:
+            enabled_stages = enabled_stages + 1
+
+    dut._log.info("Enabled stages: " + str(enabled_stages))
+    assert enabled_stages == number_of_stages
+
+    #
+    # Check the result of the script for all the combinations of the input pins,
+    # the pins are passed through the pipeline so the latency is measured as well
+    #
+    for (pin0, pin1) in [(0, 0), (1, 0), (0, 1), (1, 1), (0, 0)]:
+
+        expected = pin0 & pin1
+
+        await apply_pins(dut, number_of_pins, pin0, pin1)
+
+        latency = 0
+
+        for _ in range(maximum_number_of_stages * 2):
+            await Timer(10, units="ns")
+            latency = latency + 1
+
+            if dut.io_outputPin_31.value == expected and dut.io_outputPin_0.value == pin0 and dut.io_outputPin_1.value == pin1:
+                break
+
+        dut._log.info("pin0: " + str(pin0) + ", pin1: " + str(pin1) + ", pin31: " + str(dut.io_outputPin_31.value) +
+                      " (latency: " + str(latency) + " clocks)")
+
+        assert dut.io_outputPin_31.value == expected
+        assert latency <= maximum_number_of_stages - 1
+
+    #
+    # The maximum clock rate depends on the depth of the chained (fused) operators
+    # of each stage, so it should be taken from the timing report of the synthesis
+    #
+    dut._log.info("Script is executed in " + str(number_of_stages) + " stages with " + str(operators_per_stage) +
+                  " chained operator(s) per stage, check the synthesis timing report for the maximum clock rate")
@@ -0,0 +1,187 @@
+/**
+ * @file bram_image.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Binary BRAM images (shared memory between HyperDbg and the simulated hwdbg)
+ * @details
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "pch.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//////////////////////////////////////////////////
+//                   Structures                 //
+//////////////////////////////////////////////////
+
+/**
+ * @brief A mapped BRAM image
+ *
+ */
+typedef struct _BRAM_IMAGE
+{
+    int                                Fd;   // -1 if the image is anonymous (not backed by a file)
+    size_t                             Size; // Size of the mapping
+    volatile HWDBG_BRAM_IMAGE_HEADER * Header;
+    uint32_t *                         Words; // Content of the BRAM
+
+} BRAM_IMAGE, *PBRAM_IMAGE;
+
+//////////////////////////////////////////////////
+//                   Functions                  //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Map a binary BRAM image
+ * @details If the path is empty, an anonymous image is created, otherwise
+ * the image is created (if it doesn't exist) and mapped as shared, thus
+ * the packets that HyperDbg writes into the image are directly visible
+ * to the simulated BRAM
+ *
+ * @param Path
+ * @param NumberOfWords number of words if the image is created
+ * @param Image
+ *
+ * @return bool
+ */
+static inline bool
+BramImageMap(const std::string & Path, uint32_t NumberOfWords, PBRAM_IMAGE Image)
+{
+    HWDBG_BRAM_IMAGE_HEADER Header;
+    struct stat             FileStat;
+    void *                  Mapping;
+
+    HwdbgPacketInitializeBramImageHeader(&Header, NumberOfWords);
+
+    Image->Fd = -1;
+
+    if (!Path.empty())
+    {
+        Image->Fd = open(Path.c_str(), O_RDWR | O_CREAT, 0644);
+
+        if (Image->Fd == -1 || fstat(Image->Fd, &FileStat) != 0)
+        {
+            return false;
+        }
+
+        if ((size_t)FileStat.st_size >= sizeof(HWDBG_BRAM_IMAGE_HEADER))
+        {
+            //
+            // Use the size of the existing image
+            //
+            if (pread(Image->Fd, &Header, sizeof(Header), 0) != sizeof(Header) ||
+                !HwdbgPacketIsValidBramImageHeader(&Header, FileStat.st_size))
+            {
+                close(Image->Fd);
+                return false;
+            }
+        }
+        else
+        {
+            //
+            // Create an empty image
+            //
+            if (ftruncate(Image->Fd, Header.HeaderSize + NumberOfWords * sizeof(uint32_t)) != 0 ||
+                pwrite(Image->Fd, &Header, sizeof(Header), 0) != sizeof(Header))
+            {
+                close(Image->Fd);
+                return false;
+            }
+        }
+    }
+
+    Image->Size = Header.HeaderSize + Header.NumberOfWords * sizeof(uint32_t);
+
+    Mapping = mmap(NULL,
+                   Image->Size,
+                   PROT_READ | PROT_WRITE,
+                   Image->Fd == -1 ? MAP_SHARED | MAP_ANONYMOUS : MAP_SHARED,
+                   Image->Fd,
+                   0);
+
+    if (Mapping == MAP_FAILED)
+    {
+        if (Image->Fd != -1)
+        {
+            close(Image->Fd);
+        }
+
+        return false;
+    }
+
+    Image->Header = (volatile HWDBG_BRAM_IMAGE_HEADER *)Mapping;
+    Image->Words  = (uint32_t *)((char *)Mapping + Header.HeaderSize);
+
+    if (Image->Fd == -1)
+    {
+        memcpy(Mapping, &Header, sizeof(Header));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Unmap a binary BRAM image
+ *
+ * @param Image
+ *
+ * @return void
+ */
+static inline void
+BramImageUnmap(PBRAM_IMAGE Image)
+{
+    munmap((void *)Image->Header, Image->Size);
+
+    if (Image->Fd != -1)
+    {
+        close(Image->Fd);
+    }
+}
+
+/**
+ * @brief Read a text hex file of the BRAM (same as HyperDbg)
+ * @details The lines are parsed by HwdbgPacketParseTextLine, thus both the
+ * requests (readmemh) and the responses of the test bench are accepted
+ *
+ * @param Path
+ * @param Words
+ *
+ * @return bool
+ */
+static inline bool
+BramImageReadTextFile(const std::string & Path, std::vector<uint32_t> & Words)
+{
+    std::ifstream File(Path);
+    std::string   Line;
+
+    if (!File.is_open())
+    {
+        return false;
+    }
+
+    Words.clear();
+
+    while (std::getline(File, Line))
+    {
+        if (!HwdbgPacketParseTextLine(Line, Words))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,633 @@
+/**
+ * @file cosim.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Verilator co-simulation harness of hwdbg
+ * @details The Verilator model of the debugger (DebuggerModule) is connected to
+ * a binary BRAM image that is mapped as shared memory, thus HyperDbg (or the
+ * benchmark) writes the packets directly into the BRAM of the simulated debugger
+ * without converting them to text hex files
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <thread>
+
+#include "verilated.h"
+#include "VDebuggerModule.h"
+
+#include "bram_image.h"
+
+//////////////////////////////////////////////////
+//                 Definitions                  //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Default size of the shared memory (same as config.json)
+ *
+ */
+#define COSIM_DEFAULT_SHARED_MEMORY_SIZE 1024
+
+/**
+ * @brief Default offset of the debuggee area (same as config.json)
+ *
+ */
+#define COSIM_DEFAULT_DEBUGGEE_AREA_OFFSET 512
+
+/**
+ * @brief Maximum number of clock cycles of each packet
+ *
+ */
+#define COSIM_MAXIMUM_NUMBER_OF_CLOCK_CYCLES 100000
+
+/**
+ * @brief Number of clock cycles of the reset
+ *
+ */
+#define COSIM_NUMBER_OF_RESET_CLOCK_CYCLES 10
+
+/**
+ * @brief Interval of checking the image for new packets (in microseconds)
+ *
+ */
+#define COSIM_SERVE_POLLING_INTERVAL 100
+
+/**
+ * @brief Default number of iterations of the benchmark
+ *
+ */
+#define COSIM_DEFAULT_BENCHMARK_ITERATIONS 1000
+
+/**
+ * @brief Test vectors (text hex files) that are used by the benchmark
+ *
+ */
+#define COSIM_INSTANCE_INFO_REQUEST_PATH "../../src/test/bram/instance_info.hex.txt"
+#define COSIM_SCRIPT_BUFFER_REQUEST_PATH "../../src/test/bram/script_buffer.hex.txt"
+
+//////////////////////////////////////////////////
+//                   Structures                 //
+//////////////////////////////////////////////////
+
+/**
+ * @brief The state of the co-simulation
+ * @details The BRAM is emulated the same as InitRegMemFromFile (with
+ * ENABLE_BLOCK_RAM_DELAY), the address, the data, and the write enable
+ * are delayed for one clock cycle
+ *
+ */
+typedef struct _COSIM_STATE
+{
+    VDebuggerModule * Model;
+    PBRAM_IMAGE       Image;
+    uint64_t          Cycles;
+    uint32_t          DelayedAddress;
+    uint32_t          DelayedData;
+    bool              DelayedWrite;
+
+} COSIM_STATE, *PCOSIM_STATE;
+
+/**
+ * @brief Results of the benchmark of a packet
+ *
+ */
+typedef struct _COSIM_BENCHMARK_RESULT
+{
+    uint64_t Cycles;         // Clock cycles of the simulated debugger
+    double   SimulationTime; // Time of the simulation (in microseconds)
+    double   TextTransfer;   // Time of exchanging the packet as text hex files (in microseconds)
+    double   BinaryTransfer; // Time of exchanging the packet through the shared image (in microseconds)
+    uint32_t InvalidResponses;
+
+} COSIM_BENCHMARK_RESULT, *PCOSIM_BENCHMARK_RESULT;
+
+//
+// Global Variables
+//
+static volatile std::sig_atomic_t g_CosimStop = 0;
+
+//////////////////////////////////////////////////
+//                   Functions                  //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Get the current time in microseconds
+ *
+ * @return double
+ */
+static double
+CosimGetTime()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Run a single clock cycle of the model and the emulated BRAM
+ *
+ * @param State
+ *
+ * @return void
+ */
+static void
+CosimTick(PCOSIM_STATE State)
+{
+    VDebuggerModule * Model         = State->Model;
+    uint32_t          NumberOfWords = State->Image->Header->NumberOfWords;
+    uint32_t          Address;
+    uint32_t          Data;
+    bool              Write;
+
+    //
+    // The read data of the BRAM is the content of the delayed address
+    //
+    Model->io_rdData = Model->io_en ? State->Image->Words[State->DelayedAddress] : 0;
+
+    Model->clock = 0;
+    Model->eval();
+
+    //
+    // Sample the BRAM signals of the debugger (the addresses are in bytes)
+    //
+    Address = (Model->io_rdWrAddr >> 2) % NumberOfWords;
+    Data    = Model->io_wrData;
+    Write   = Model->io_wrEna && Model->io_en;
+
+    //
+    // Rising edge, the delayed write is applied to the BRAM
+    //
+    if (State->DelayedWrite)
+    {
+        State->Image->Words[State->DelayedAddress] = State->DelayedData;
+    }
+
+    State->DelayedAddress = Address;
+    State->DelayedData    = Data;
+    State->DelayedWrite   = Write;
+
+    Model->clock = 1;
+    Model->eval();
+
+    State->Cycles++;
+}
+
+/**
+ * @brief Reset the debugger
+ *
+ * @param State
+ *
+ * @return void
+ */
+static void
+CosimReset(PCOSIM_STATE State)
+{
+    State->Model->io_en         = 0;
+    State->Model->io_plInSignal = 0;
+    State->Model->reset         = 1;
+
+    for (int i = 0; i < COSIM_NUMBER_OF_RESET_CLOCK_CYCLES; i++)
+    {
+        CosimTick(State);
+    }
+
+    State->Model->reset = 0;
+    State->Model->io_en = 1;
+}
+
+/**
+ * @brief Notify the debugger about the packet in the BRAM and wait for the response
+ * @details Same as the cocotb test bench, the PS to PL signal is set for a
+ * clock cycle and the debugger is executed until it interrupts the PS
+ *
+ * @param State
+ *
+ * @return uint64_t number of clock cycles, zero if the debugger didn't respond
+ */
+static uint64_t
+CosimExchangePacket(PCOSIM_STATE State)
+{
+    uint64_t StartCycles = State->Cycles;
+
+    State->Model->io_plInSignal = 1;
+    CosimTick(State);
+    State->Model->io_plInSignal = 0;
+
+    while (!State->Model->io_psOutInterrupt)
+    {
+        if (State->Cycles - StartCycles >= COSIM_MAXIMUM_NUMBER_OF_CLOCK_CYCLES)
+        {
+            return 0;
+        }
+
+        CosimTick(State);
+    }
+
+    //
+    // Run one more clock cycle to apply the latest BRAM modifications
+    //
+    CosimTick(State);
+
+    return State->Cycles - StartCycles;
+}
+
+/**
+ * @brief Check whether the response of the debugger is valid
+ * @details The response is decoded the same as HyperDbg (HwdbgInterpretPacket)
+ *
+ * @param Words
+ * @param NumberOfWords
+ * @param DebuggeeAreaOffset
+ *
+ * @return bool
+ */
+static bool
+CosimIsValidResponse(const uint32_t * Words, uint32_t NumberOfWords, uint32_t DebuggeeAreaOffset)
+{
+    DEBUGGER_REMOTE_PACKET * Response = HwdbgPacketDecode(Words, NumberOfWords * sizeof(uint32_t), DebuggeeAreaOffset);
+
+    return Response != NULL &&
+           Response->TypeOfThePacket == DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER_HARDWARE_LEVEL;
+}
+
+/**
+ * @brief Write the BRAM as a text hex file (same as HyperDbg)
+ *
+ * @param Path
+ * @param Words
+ * @param NumberOfWords
+ *
+ * @return void
+ */
+static void
+CosimWriteTextFile(const std::string & Path, const uint32_t * Words, uint32_t NumberOfWords)
+{
+    std::ofstream File(Path);
+
+    HwdbgPacketWriteTextFile(File, Words, NumberOfWords, 0, NumberOfWords > 5 ? Words[5] : 0);
+}
+
+/**
+ * @brief Run the benchmark of a packet
+ * @details The text flow writes the request into a text hex file which is
+ * read by the simulator, and writes the BRAM after the simulation into
+ * another text hex file which is read by the debugger, while the binary
+ * flow writes the request into the shared image and reads the response
+ * from it
+ *
+ * @param State
+ * @param Request
+ * @param Iterations
+ * @param DebuggeeAreaOffset
+ * @param Result
+ *
+ * @return void
+ */
+static void
+CosimBenchmarkPacket(PCOSIM_STATE                  State,
+                     const std::vector<uint32_t> & Request,
+                     uint32_t                      Iterations,
+                     uint32_t                      DebuggeeAreaOffset,
+                     PCOSIM_BENCHMARK_RESULT       Result)
+{
+    uint32_t              NumberOfWords = State->Image->Header->NumberOfWords;
+    size_t                RequestWords  = std::min<size_t>(Request.size(), DebuggeeAreaOffset / sizeof(uint32_t));
+    std::string           TextPath      = (std::filesystem::temp_directory_path() / "hwdbg_cosim_bram.hex.txt").string();
+    std::vector<uint32_t> Words(NumberOfWords);
+    std::vector<uint32_t> TextWords;
+    double                Start;
+    uint64_t              Cycles;
+
+    *Result = {0};
+
+    for (uint32_t i = 0; i < Iterations; i++)
+    {
+        //
+        // Text flow, the request is written into a text hex file by the
+        // debugger and read by the simulator
+        //
+        Start = CosimGetTime();
+
+        std::fill(Words.begin(), Words.end(), 0);
+        std::copy(Request.begin(), Request.begin() + RequestWords, Words.begin());
+
+        CosimWriteTextFile(TextPath, Words.data(), NumberOfWords);
+        BramImageReadTextFile(TextPath, TextWords);
+
+        Result->TextTransfer += CosimGetTime() - Start;
+
+        //
+        // Binary flow, the request is written into the shared image
+        //
+        Start = CosimGetTime();
+
+        memset(State->Image->Words, 0, NumberOfWords * sizeof(uint32_t));
+        memcpy(State->Image->Words, Request.data(), RequestWords * sizeof(uint32_t));
+        State->Image->Header->DebuggerSequence++;
+
+        Result->BinaryTransfer += CosimGetTime() - Start;
+
+        //
+        // Run the debugger
+        //
+        Start  = CosimGetTime();
+        Cycles = CosimExchangePacket(State);
+
+        Result->SimulationTime += CosimGetTime() - Start;
+        Result->Cycles         += Cycles;
+
+        //
+        // Text flow, the BRAM is written into a text hex file by the
+        // simulator and read by the debugger
+        //
+        Start = CosimGetTime();
+
+        CosimWriteTextFile(TextPath, State->Image->Words, NumberOfWords);
+        BramImageReadTextFile(TextPath, TextWords);
+
+        Result->TextTransfer += CosimGetTime() - Start;
+
+        //
+        // Binary flow, the response is read from the shared image
+        //
+        Start = CosimGetTime();
+
+        memcpy(Words.data(), State->Image->Words, NumberOfWords * sizeof(uint32_t));
+        State->Image->Header->DebuggeeSequence = State->Image->Header->DebuggerSequence;
+
+        Result->BinaryTransfer += CosimGetTime() - Start;
+
+        if (Cycles == 0 || !CosimIsValidResponse(Words.data(), NumberOfWords, DebuggeeAreaOffset))
+        {
+            Result->InvalidResponses++;
+        }
+    }
+
+    std::filesystem::remove(TextPath);
+}
+
+/**
+ * @brief Show the results of the benchmark of a packet
+ *
+ * @param Name
+ * @param Iterations
+ * @param Result
+ *
+ * @return void
+ */
+static void
+CosimShowBenchmarkResult(const char * Name, uint32_t Iterations, PCOSIM_BENCHMARK_RESULT Result)
+{
+    double Simulation = Result->SimulationTime / Iterations;
+    double Text       = Result->TextTransfer / Iterations;
+    double Binary     = Result->BinaryTransfer / Iterations;
+
+    printf("%s:\n", Name);
+    printf("\tclock cycles per packet   : %llu\n", (unsigned long long)(Result->Cycles / Iterations));
+    printf("\tsimulation per packet     : %.2f us\n", Simulation);
+    printf("\ttext transfer per packet  : %.2f us\n", Text);
+    printf("\tbinary transfer per packet: %.2f us\n", Binary);
+    printf("\tthroughput (text)         : %.0f packets/s\n", 1000000.0 / (Simulation + Text));
+    printf("\tthroughput (binary)       : %.0f packets/s\n", 1000000.0 / (Simulation + Binary));
+    printf("\tinvalid responses         : %u\n", Result->InvalidResponses);
+}
+
+/**
+ * @brief Measure the throughput of script configuration and instance info packets
+ *
+ * @param State
+ * @param Iterations
+ *
+ * @return int
+ */
+static int
+CosimBenchmark(PCOSIM_STATE State, uint32_t Iterations)
+{
+    std::vector<uint32_t>  InstanceInfoRequest;
+    std::vector<uint32_t>  ScriptBufferRequest;
+    COSIM_BENCHMARK_RESULT InstanceInfoResult;
+    COSIM_BENCHMARK_RESULT ScriptBufferResult;
+
+    if (!BramImageReadTextFile(COSIM_INSTANCE_INFO_REQUEST_PATH, InstanceInfoRequest) ||
+        !BramImageReadTextFile(COSIM_SCRIPT_BUFFER_REQUEST_PATH, ScriptBufferRequest))
+    {
+        printf("err, unable to read the test vectors (%s, %s)\n",
+               COSIM_INSTANCE_INFO_REQUEST_PATH,
+               COSIM_SCRIPT_BUFFER_REQUEST_PATH);
+        return 1;
+    }
+
+    CosimBenchmarkPacket(State, InstanceInfoRequest, Iterations, COSIM_DEFAULT_DEBUGGEE_AREA_OFFSET, &InstanceInfoResult);
+    CosimBenchmarkPacket(State, ScriptBufferRequest, Iterations, COSIM_DEFAULT_DEBUGGEE_AREA_OFFSET, &ScriptBufferResult);
+
+    printf("hwdbg co-simulation benchmark (%u iterations)\n\n", Iterations);
+
+    CosimShowBenchmarkResult("instance info (request and response)", Iterations, &InstanceInfoResult);
+    CosimShowBenchmarkResult("script configuration (request and response)", Iterations, &ScriptBufferResult);
+
+    return InstanceInfoResult.InvalidResponses + ScriptBufferResult.InvalidResponses != 0;
+}
+
+/**
+ * @brief Serve the packets that the debugger writes into the shared image
+ * @details The debugger increments the debugger sequence once the packet
+ * is written, and the sequence of the debuggee is set to the same value
+ * once the debugger (hwdbg) responds
+ *
+ * @param State
+ *
+ * @return int
+ */
+static int
+CosimServe(PCOSIM_STATE State)
+{
+    uint32_t DebuggerSequence;
+    uint64_t Cycles;
+
+    printf("waiting for packets (press CTRL+C to stop)...\n");
+
+    while (!g_CosimStop)
+    {
+        DebuggerSequence = State->Image->Header->DebuggerSequence;
+
+        if (DebuggerSequence == State->Image->Header->DebuggeeSequence)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(COSIM_SERVE_POLLING_INTERVAL));
+            continue;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        Cycles = CosimExchangePacket(State);
+
+        std::atomic_thread_fence(std::memory_order_release);
+
+        State->Image->Header->DebuggeeSequence = DebuggerSequence;
+
+        if (Cycles == 0)
+        {
+            printf("err, the debugger didn't respond to the packet (sequence: %u)\n", DebuggerSequence);
+        }
+        else
+        {
+            printf("packet (sequence: %u) is handled in %llu clock cycles\n", DebuggerSequence, (unsigned long long)Cycles);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Convert a text hex file into a binary BRAM image
+ *
+ * @param TextPath
+ * @param ImagePath
+ *
+ * @return int
+ */
+static int
+CosimConvert(const char * TextPath, const char * ImagePath)
+{
+    std::vector<uint32_t> Words;
+    BRAM_IMAGE            Image;
+
+    if (!BramImageReadTextFile(TextPath, Words))
+    {
+        printf("err, unable to read %s\n", TextPath);
+        return 1;
+    }
+
+    if (!BramImageMap(ImagePath, (uint32_t)Words.size(), &Image))
+    {
+        printf("err, unable to map %s\n", ImagePath);
+        return 1;
+    }
+
+    memcpy(Image.Words, Words.data(), std::min<size_t>(Words.size(), Image.Header->NumberOfWords) * sizeof(uint32_t));
+
+    BramImageUnmap(&Image);
+
+    return 0;
+}
+
+/**
+ * @brief Show the usage of the harness
+ *
+ * @param Name
+ *
+ * @return void
+ */
+static void
+CosimShowUsage(const char * Name)
+{
+    printf("usage : %s benchmark [Iterations]\n", Name);
+    printf("usage : %s serve [ImagePath]\n", Name);
+    printf("usage : %s convert [TextPath] [ImagePath]\n", Name);
+}
+
+/**
+ * @brief Main function of the harness
+ *
+ * @param argc
+ * @param argv
+ *
+ * @return int
+ */
+int
+main(int argc, char ** argv)
+{
+    std::unique_ptr<VerilatedContext> Context(new VerilatedContext);
+    BRAM_IMAGE                        Image;
+    COSIM_STATE                       State = {0};
+    std::string                       ImagePath;
+    std::string                       Mode;
+    uint32_t                          Iterations = COSIM_DEFAULT_BENCHMARK_ITERATIONS;
+    int                               Result;
+
+    if (argc < 2)
+    {
+        CosimShowUsage(argv[0]);
+        return 1;
+    }
+
+    Mode = argv[1];
+
+    if (Mode == "convert")
+    {
+        if (argc != 4)
+        {
+            CosimShowUsage(argv[0]);
+            return 1;
+        }
+
+        return CosimConvert(argv[2], argv[3]);
+    }
+    else if (Mode == "serve")
+    {
+        if (argc != 3)
+        {
+            CosimShowUsage(argv[0]);
+            return 1;
+        }
+
+        ImagePath = argv[2];
+    }
+    else if (Mode != "benchmark")
+    {
+        CosimShowUsage(argv[0]);
+        return 1;
+    }
+    else if (argc > 2)
+    {
+        Iterations = (uint32_t)strtoul(argv[2], NULL, 0);
+
+        if (Iterations == 0)
+        {
+            CosimShowUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    //
+    // The benchmark uses an anonymous image
+    //
+    if (!BramImageMap(ImagePath, COSIM_DEFAULT_SHARED_MEMORY_SIZE / sizeof(uint32_t), &Image))
+    {
+        printf("err, unable to map the BRAM image\n");
+        return 1;
+    }
+
+    Context->commandArgs(argc, argv);
+
+    State.Model = new VDebuggerModule(Context.get());
+    State.Image = &Image;
+
+    CosimReset(&State);
+
+    if (Mode == "serve")
+    {
+        std::signal(SIGINT, [](int) { g_CosimStop = 1; });
+
+        Result = CosimServe(&State);
+    }
+    else
+    {
+        Result = CosimBenchmark(&State, Iterations);
+    }
+
+    State.Model->final();
+    delete State.Model;
+
+    BramImageUnmap(&Image);
+
+    return Result;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers of the co-simulation harness of hwdbg
+ * @details The packets and the BRAM images are encoded and decoded by the
+ * same code as HyperDbg (libhyperdbg/code/hwdbg/hwdbg-packet.cpp), which is
+ * compiled with the host definitions of HyperDbg instead of the Windows SDK
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "tests/host/common/HostPlatform.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "include/SDK/headers/Constants.h"
+#include "include/SDK/headers/Connection.h"
+#include "include/SDK/headers/HardwareDebugger.h"
+
+//////////////////////////////////////////////////
+//               hwdbg Packets                  //
+//////////////////////////////////////////////////
+
+#include "libhyperdbg/header/hwdbg-packet.h"
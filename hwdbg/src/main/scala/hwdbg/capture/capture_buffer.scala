@@ -0,0 +1,303 @@
+/**
+ * @file
+ *   capture_buffer.scala
+ * @author
+ *   Sina Karvandi (sina@hyperdbg.org)
+ * @brief
+ *   Capture buffer (logic analyzer) of the pins
+ * @details
+ *   Samples of the pins are run-length encoded and stored in a ring (BRAM). Once the
+ *   trigger pin (driven by the script engine) is set, the post-trigger entries are
+ *   captured and the capture window (pre-trigger entries and post-trigger entries)
+ *   could be read by the debugger
+ * @version 0.1
+ * @date
+ *   2024-12-10
+ *
+ * @copyright
+ *   This project is released under the GNU Public License v3.
+ */
+package hwdbg.capture
+
+import chisel3._
+import chisel3.util.{log2Ceil, log2Up}
+import circt.stage.ChiselStage
+
+import hwdbg.configs._
+import hwdbg.types._
+
+object DebuggerCaptureBufferEnums {
+
+  //
+  // SHOULD BE IN THE SAME ORDER AS HwdbgCaptureStateEnums (the state is reported to the debugger)
+  //
+  object State extends ChiselEnum {
+    val sIdle, sArmed, sTriggered, sDone = Value
+  }
+}
+
+class DebuggerCaptureBuffer(
+    debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+    instanceInfo: HwdbgInstanceInformation
+) extends Module {
+
+  //
+  // Import state enum
+  //
+  import DebuggerCaptureBufferEnums.State
+  import DebuggerCaptureBufferEnums.State._
+
+  val io = IO(new Bundle {
+
+    //
+    // Chip signals
+    //
+    val en = Input(Bool()) // chip enable signal
+
+    //
+    // Input signals
+    //
+    val inputPin = Input(Vec(instanceInfo.numberOfPins, UInt(1.W))) // input pins (sampled at each clock)
+    val triggerPin = Input(Vec(instanceInfo.numberOfPins, UInt(1.W))) // pins driven by the script engine (used as the trigger)
+
+    //
+    // Capture configuration signals
+    //
+    val arm = Input(Bool()) // whether a new capture should start or not?
+    val configuration = Input(new HwdbgCaptureConfiguration()) // configuration of the new capture
+
+    //
+    // Capture status and read signals
+    //
+    val status = Output(new HwdbgCaptureStatus(instanceInfo)) // status of the capture
+    val readEntryIndex = Input(UInt(log2Ceil(instanceInfo.captureBufferDepth).W)) // index of the entry (in the capture window) to read
+    val readEntry = Output(new HwdbgCaptureEntry(instanceInfo)) // the entry (available one clock after the index)
+  })
+
+  //
+  // State registers
+  //
+  val state = RegInit(sIdle)
+
+  //
+  // The capture buffer (ring), inferred as a BRAM
+  //
+  val captureBuffer = SyncReadMem(instanceInfo.captureBufferDepth, new HwdbgCaptureEntry(instanceInfo))
+
+  //
+  // Width of the pointers of the ring
+  //
+  val pointerWidth = log2Ceil(instanceInfo.captureBufferDepth)
+
+  //
+  // Maximum number of samples that can be encoded in a single entry
+  //
+  val maximumRunLength = (BigInt(1) << instanceInfo.captureRunLengthWidth) - 1
+
+  //
+  // The capture window should fit into the ring, otherwise the post-trigger entries
+  // overwrite the pre-trigger entries. The trigger entry is the first post-trigger
+  // entry, so at least one post-trigger entry is captured (otherwise, the capture is
+  // only finished once the counter of the post-trigger entries wraps)
+  //
+  val postTriggerEntries = Mux(
+    io.configuration.PostTriggerEntries === 0.U,
+    1.U,
+    Mux(
+      io.configuration.PostTriggerEntries > instanceInfo.captureBufferDepth.U,
+      instanceInfo.captureBufferDepth.U,
+      io.configuration.PostTriggerEntries
+    )
+  )
+  val maximumPreTriggerEntries = instanceInfo.captureBufferDepth.U - postTriggerEntries
+  val preTriggerEntries = Mux(
+    io.configuration.PreTriggerEntries > maximumPreTriggerEntries,
+    maximumPreTriggerEntries,
+    io.configuration.PreTriggerEntries
+  )
+
+  //
+  // Ring registers
+  //
+  val regWritePointer = RegInit(0.U(pointerWidth.W))
+  val regTriggerPointer = RegInit(0.U(pointerWidth.W))
+  val regNumberOfWrittenEntries = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth + 1).W)) // saturated at the depth of the buffer
+  val regNumberOfPreTriggerEntries = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth + 1).W))
+  val regNumberOfPostTriggerEntries = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth + 1).W))
+
+  //
+  // The current run (the entry which is not yet written into the buffer)
+  //
+  val regRun = Reg(new HwdbgCaptureEntry(instanceInfo))
+  val regRunValid = RegInit(false.B)
+
+  //
+  // Configuration of the current capture
+  //
+  val regConfiguration = Reg(new HwdbgCaptureConfiguration())
+
+  //
+  // Current sample of the pins
+  //
+  val sample = io.inputPin.asUInt
+
+  //
+  // Check the trigger pin (if the trigger pin is not a valid pin, the capture
+  // is triggered immediately)
+  //
+  val trigger = Mux(
+    regConfiguration.TriggerPin < instanceInfo.numberOfPins.U,
+    io.triggerPin(regConfiguration.TriggerPin(log2Up(instanceInfo.numberOfPins) - 1, 0)) === 1.U,
+    true.B
+  )
+
+  //
+  // Apply the chip enable signal
+  //
+  when(io.en === true.B) {
+
+    when(io.arm === true.B) {
+
+      //
+      // Start a new capture (previous capture is discarded), the window is clamped
+      // into the ring
+      //
+      regConfiguration.TriggerPin := io.configuration.TriggerPin
+      regConfiguration.PreTriggerEntries := preTriggerEntries
+      regConfiguration.PostTriggerEntries := postTriggerEntries
+      regWritePointer := 0.U
+      regNumberOfWrittenEntries := 0.U
+      regNumberOfPostTriggerEntries := 0.U
+      regRunValid := false.B
+
+      state := sArmed
+
+    }.elsewhen(state === sArmed || state === sTriggered) {
+
+      //
+      // The sample that triggers the capture always starts a new entry, so the
+      // position of the trigger is exact
+      //
+      val triggered = state === sArmed && trigger
+
+      when(regRunValid && sample === regRun.Sample && regRun.RunLength =/= maximumRunLength.U && !triggered) {
+
+        //
+        // Same value, extend the current run
+        //
+        regRun.RunLength := regRun.RunLength + 1.U
+
+      }.otherwise {
+
+        //
+        // The value is changed (or the run is full), write the current run into the
+        // buffer and start a new run
+        //
+        when(regRunValid) {
+
+          captureBuffer.write(regWritePointer, regRun)
+          regWritePointer := regWritePointer + 1.U
+
+          when(regNumberOfWrittenEntries =/= instanceInfo.captureBufferDepth.U) {
+            regNumberOfWrittenEntries := regNumberOfWrittenEntries + 1.U
+          }
+
+          when(state === sTriggered) {
+
+            //
+            // Check whether all the post-trigger entries are captured
+            //
+            regNumberOfPostTriggerEntries := regNumberOfPostTriggerEntries + 1.U
+
+            when(regNumberOfPostTriggerEntries + 1.U === regConfiguration.PostTriggerEntries) {
+              state := sDone
+            }
+          }
+        }
+
+        regRun.Sample := sample
+        regRun.RunLength := 1.U
+        regRunValid := true.B
+      }
+
+      when(triggered) {
+
+        //
+        // The trigger entry is written after the current run (if any)
+        //
+        val numberOfEntriesBeforeTrigger = Mux(regRunValid, regNumberOfWrittenEntries +& 1.U, regNumberOfWrittenEntries)
+
+        regTriggerPointer := Mux(regRunValid, regWritePointer + 1.U, regWritePointer)
+        regNumberOfPreTriggerEntries := Mux(
+          numberOfEntriesBeforeTrigger < regConfiguration.PreTriggerEntries,
+          numberOfEntriesBeforeTrigger,
+          regConfiguration.PreTriggerEntries
+        )
+
+        state := sTriggered
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------
+
+  //
+  // Read the capture window (it starts from the first pre-trigger entry)
+  //
+  val startOfWindow = regTriggerPointer - regNumberOfPreTriggerEntries(pointerWidth - 1, 0)
+  io.readEntry := captureBuffer.read(startOfWindow + io.readEntryIndex)
+
+  //
+  // Connect the status of the capture
+  //
+  io.status.captureState := state.asUInt
+  io.status.numberOfEntries := Mux(state === sDone, regNumberOfPreTriggerEntries + regNumberOfPostTriggerEntries, 0.U)
+  io.status.triggerEntry := regNumberOfPreTriggerEntries
+}
+
+object DebuggerCaptureBuffer {
+
+  def apply(
+      debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+      instanceInfo: HwdbgInstanceInformation
+  )(
+      en: Bool,
+      inputPin: Vec[UInt],
+      triggerPin: Vec[UInt],
+      arm: Bool,
+      configuration: HwdbgCaptureConfiguration,
+      readEntryIndex: UInt
+  ): (HwdbgCaptureStatus, HwdbgCaptureEntry) = {
+
+    val debuggerCaptureBuffer = Module(
+      new DebuggerCaptureBuffer(
+        debug,
+        instanceInfo
+      )
+    )
+
+    val status = Wire(new HwdbgCaptureStatus(instanceInfo))
+    val readEntry = Wire(new HwdbgCaptureEntry(instanceInfo))
+
+    //
+    // Configure the input signals
+    //
+    debuggerCaptureBuffer.io.en := en
+    debuggerCaptureBuffer.io.inputPin := inputPin
+    debuggerCaptureBuffer.io.triggerPin := triggerPin
+    debuggerCaptureBuffer.io.arm := arm
+    debuggerCaptureBuffer.io.configuration := configuration
+    debuggerCaptureBuffer.io.readEntryIndex := readEntryIndex
+
+    //
+    // Configure the output signals
+    //
+    status := debuggerCaptureBuffer.io.status
+    readEntry := debuggerCaptureBuffer.io.readEntry
+
+    //
+    // Return the output result
+    //
+    (status, readEntry)
+  }
+}
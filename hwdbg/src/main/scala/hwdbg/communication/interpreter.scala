@@ -16,7 +16,7 @@
 package hwdbg.communication.interpreter
 
 import chisel3._
-import chisel3.util.{switch, is}
+import chisel3.util.{switch, is, log2Ceil}
 import circt.stage.ChiselStage
 
 import hwdbg.configs._
@@ -77,6 +77,15 @@ class DebuggerPacketInterpreter(
     val finishedScriptConfiguration = Output(Bool()) // whether script configuration finished or not?
     val configureStage = Output(Bool()) // whether the configuration of stage should start or not?
     val targetOperator = Output(new HwdbgShortSymbol(instanceInfo.scriptVariableLength)) // Current operator to be configured
+
+    //
+    // Capture buffer signals
+    //
+    val captureArm = Output(Bool()) // whether a new capture should start or not?
+    val captureConfiguration = Output(new HwdbgCaptureConfiguration()) // configuration of the new capture
+    val captureStatus = Input(new HwdbgCaptureStatus(instanceInfo)) // status of the capture buffer
+    val captureReadEntryIndex = Output(UInt(log2Ceil(instanceInfo.captureBufferDepth).W)) // index of the entry to read
+    val captureReadEntry = Input(new HwdbgCaptureEntry(instanceInfo)) // the entry read from the capture buffer
   })
 
   //
@@ -93,6 +102,13 @@ class DebuggerPacketInterpreter(
   // Last error register
   //
   val enablePinOfScriptBufferHandler = RegInit(false.B)
+  val enablePinOfCaptureConfigurationHandler = RegInit(false.B)
+  val enablePinOfCaptureReadRequestHandler = RegInit(false.B)
+
+  //
+  // First entry of the requested chunk of the capture buffer
+  //
+  val regCaptureFirstEntry = RegInit(0.U(instanceInfo.bramDataWidth.W))
 
   //
   // Output pins
@@ -114,6 +130,10 @@ class DebuggerPacketInterpreter(
   initialSymbol.Value := 0.U
   val targetOperator = WireInit(initialSymbol)
 
+  val captureArm = WireInit(false.B)
+  val captureConfiguration = WireInit(0.U.asTypeOf(new HwdbgCaptureConfiguration()))
+  val captureReadEntryIndex = WireInit(0.U(log2Ceil(instanceInfo.captureBufferDepth).W))
+
   //
   // Apply the chip enable signal
   //
@@ -237,6 +257,151 @@ class DebuggerPacketInterpreter(
             state := sNewActionReceived
           }
 
+        }.elsewhen(inputAction === HwdbgActionEnums.hwdbgActionConfigureCapture.id.U) {
+
+          //
+          // *** Configure (and arm) the capture buffer ***
+          //
+
+          //
+          // Enable the capture configuration reader module
+          //
+          enablePinOfCaptureConfigurationHandler := true.B
+
+          val (
+            moduleReadNextData,
+            moduleFinishedReadingRequest,
+            moduleRequestFields
+          ) =
+            InterpreterCaptureRequestHandler(
+              debug,
+              instanceInfo,
+              new HwdbgCaptureConfiguration().Size.numberOfFields
+            )(
+              enablePinOfCaptureConfigurationHandler,
+              io.dataValidInput,
+              io.receivingData
+            )
+
+          readNextData := moduleReadNextData
+
+          when(moduleFinishedReadingRequest === true.B) {
+
+            //
+            // Disable the capture configuration reader module
+            //
+            enablePinOfCaptureConfigurationHandler := false.B
+
+            //
+            // Set the response packet type
+            //
+            regRequestedActionOfThePacketOutput := HwdbgResponseEnums.hwdbgResponseSuccessOrErrorMessage.id.U
+
+            //
+            // Fields of the configuration (same order as HWDBG_CAPTURE_CONFIGURATION)
+            //
+            captureConfiguration.TriggerPin := moduleRequestFields(0)
+            captureConfiguration.PreTriggerEntries := moduleRequestFields(1)
+            captureConfiguration.PostTriggerEntries := moduleRequestFields(2)
+
+            //
+            // The pre-trigger and the post-trigger entries should fit into the capture buffer
+            //
+            when(
+              moduleRequestFields(2) =/= 0.U &&
+                moduleRequestFields(1) <= instanceInfo.captureBufferDepth.U &&
+                moduleRequestFields(2) <= instanceInfo.captureBufferDepth.U - moduleRequestFields(1)
+            ) {
+
+              //
+              // Start the new capture
+              //
+              captureArm := true.B
+
+              //
+              // Set the success message
+              //
+              lastSuccesOrErrorMessage := HwdbgSuccessOrErrorEnums.hwdbgOperationWasSuccessful.id.U
+
+            }.otherwise {
+
+              //
+              // Set the latest error
+              //
+              lastSuccesOrErrorMessage := HwdbgSuccessOrErrorEnums.hwdbgErrorInvalidCaptureWindow.id.U
+            }
+
+            //
+            // This action needs a response
+            //
+            state := sSendResponse
+
+          }.otherwise {
+
+            //
+            // Stay at the same state
+            //
+            state := sNewActionReceived
+          }
+
+        }.elsewhen(inputAction === HwdbgActionEnums.hwdbgActionReadCaptureBuffer.id.U) {
+
+          //
+          // *** Read a chunk of the capture buffer ***
+          //
+
+          //
+          // Enable the read request reader module
+          //
+          enablePinOfCaptureReadRequestHandler := true.B
+
+          val (
+            moduleReadNextData,
+            moduleFinishedReadingRequest,
+            moduleRequestFields
+          ) =
+            InterpreterCaptureRequestHandler(
+              debug,
+              instanceInfo,
+              1 // the first entry of the chunk
+            )(
+              enablePinOfCaptureReadRequestHandler,
+              io.dataValidInput,
+              io.receivingData
+            )
+
+          readNextData := moduleReadNextData
+
+          when(moduleFinishedReadingRequest === true.B) {
+
+            //
+            // Disable the read request reader module
+            //
+            enablePinOfCaptureReadRequestHandler := false.B
+
+            //
+            // Set the first entry of the chunk
+            //
+            regCaptureFirstEntry := moduleRequestFields(0)
+
+            //
+            // Set the response packet type
+            //
+            regRequestedActionOfThePacketOutput := HwdbgResponseEnums.hwdbgResponseCaptureBuffer.id.U
+
+            //
+            // This action needs a response
+            //
+            state := sSendResponse
+
+          }.otherwise {
+
+            //
+            // Stay at the same state
+            //
+            state := sNewActionReceived
+          }
+
         }.otherwise {
 
           //
@@ -356,6 +521,53 @@ class DebuggerPacketInterpreter(
             //
             sendingData := sendingDataModule
 
+            //
+            // Once sending data is done, we'll go to the Done state
+            //
+            when(noNewDataSenderModule === true.B) {
+              state := sDone
+            }
+
+          }.elsewhen(regRequestedActionOfThePacketOutput === HwdbgResponseEnums.hwdbgResponseCaptureBuffer.id.U) {
+
+            //
+            // *** Send a chunk of the capture buffer ***
+            //
+
+            //
+            // Instantiate the capture buffer sender module
+            //
+            val (
+              noNewDataSenderModule,
+              dataValidOutputModule,
+              sendingDataModule,
+              readEntryIndexModule
+            ) =
+              InterpreterSendCaptureBuffer(
+                debug,
+                instanceInfo
+              )(
+                io.sendWaitForBuffer, // send waiting for buffer as an activation signal to the module
+                io.captureStatus,
+                regCaptureFirstEntry,
+                io.captureReadEntry
+              )
+
+            //
+            // Set data validity
+            //
+            dataValidOutput := dataValidOutputModule
+
+            //
+            // Set data
+            //
+            sendingData := sendingDataModule
+
+            //
+            // Read the entries of the capture buffer
+            //
+            captureReadEntryIndex := readEntryIndexModule
+
             //
             // Once sending data is done, we'll go to the Done state
             //
@@ -415,6 +627,10 @@ class DebuggerPacketInterpreter(
   io.configureStage := configureStage
   io.finishedScriptConfiguration := finishedScriptConfiguration
   io.targetOperator := targetOperator
+
+  io.captureArm := captureArm
+  io.captureConfiguration := captureConfiguration
+  io.captureReadEntryIndex := captureReadEntryIndex
 }
 
 object DebuggerPacketInterpreter {
@@ -428,8 +644,10 @@ object DebuggerPacketInterpreter {
       requestedActionOfThePacketInputValid: Bool,
       dataValidInput: Bool,
       receivingData: UInt,
-      sendWaitForBuffer: Bool
-  ): (Bool, Bool, Bool, Bool, Bool, UInt, UInt, Bool, Bool, HwdbgShortSymbol) = {
+      sendWaitForBuffer: Bool,
+      captureStatus: HwdbgCaptureStatus,
+      captureReadEntry: HwdbgCaptureEntry
+  ): (Bool, Bool, Bool, Bool, Bool, UInt, UInt, Bool, Bool, HwdbgShortSymbol, Bool, HwdbgCaptureConfiguration, UInt) = {
 
     val debuggerPacketInterpreter = Module(
       new DebuggerPacketInterpreter(
@@ -452,6 +670,10 @@ object DebuggerPacketInterpreter {
     val configureStage = Wire(Bool())
     val targetOperator = Wire(new HwdbgShortSymbol(instanceInfo.scriptVariableLength))
 
+    val captureArm = Wire(Bool())
+    val captureConfiguration = Wire(new HwdbgCaptureConfiguration())
+    val captureReadEntryIndex = Wire(UInt(log2Ceil(instanceInfo.captureBufferDepth).W))
+
     //
     // Configure the input signals
     //
@@ -470,6 +692,12 @@ object DebuggerPacketInterpreter {
     //
     debuggerPacketInterpreter.io.sendWaitForBuffer := sendWaitForBuffer
 
+    //
+    // Configure the input signals related to the capture buffer
+    //
+    debuggerPacketInterpreter.io.captureStatus := captureStatus
+    debuggerPacketInterpreter.io.captureReadEntry := captureReadEntry
+
     //
     // Configure the output signals
     //
@@ -496,6 +724,13 @@ object DebuggerPacketInterpreter {
     configureStage := debuggerPacketInterpreter.io.configureStage
     targetOperator := debuggerPacketInterpreter.io.targetOperator
 
+    //
+    // Configure the output signals related to the capture buffer
+    //
+    captureArm := debuggerPacketInterpreter.io.captureArm
+    captureConfiguration := debuggerPacketInterpreter.io.captureConfiguration
+    captureReadEntryIndex := debuggerPacketInterpreter.io.captureReadEntryIndex
+
     //
     // Return the output result
     //
@@ -509,7 +744,10 @@ object DebuggerPacketInterpreter {
       sendingData,
       finishedScriptConfiguration,
       configureStage,
-      targetOperator
+      targetOperator,
+      captureArm,
+      captureConfiguration,
+      captureReadEntryIndex
     )
   }
 }
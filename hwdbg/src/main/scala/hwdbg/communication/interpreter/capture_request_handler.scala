@@ -0,0 +1,219 @@
+/**
+ * @file
+ *   capture_request_handler.scala
+ * @author
+ *   Sina Karvandi (sina@hyperdbg.org)
+ * @brief
+ *   Read the fields of capture buffer requests (in the interpreter)
+ * @details
+ * @version 0.1
+ * @date
+ *   2024-12-10
+ *
+ * @copyright
+ *   This project is released under the GNU Public License v3.
+ */
+package hwdbg.communication.interpreter
+
+import chisel3._
+import chisel3.util.{switch, is, log2Up}
+import circt.stage.ChiselStage
+
+import hwdbg.configs._
+
+object InterpreterCaptureRequestHandlerEnums {
+  object State extends ChiselEnum {
+    val sIdle, sReadField, sDone = Value
+  }
+}
+
+class InterpreterCaptureRequestHandler(
+    debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+    instanceInfo: HwdbgInstanceInformation,
+    numberOfFields: Int
+) extends Module {
+
+  //
+  // Import state enum
+  //
+  import InterpreterCaptureRequestHandlerEnums.State
+  import InterpreterCaptureRequestHandlerEnums.State._
+
+  val io = IO(new Bundle {
+
+    //
+    // Chip signals
+    //
+    val en = Input(Bool()) // chip enable signal
+
+    //
+    // Receiving signals
+    //
+    val readNextData = Output(Bool()) // whether the next data should be read or not?
+
+    val dataValidInput = Input(Bool()) // whether data on the receiving data line is valid or not?
+    val receivingData = Input(UInt(instanceInfo.bramDataWidth.W)) // data to be received in interpreter
+
+    //
+    // Request signals
+    //
+    val finishedReadingRequest = Output(Bool()) // whether reading the request finished or not?
+    val requestFields = Output(Vec(numberOfFields, UInt(instanceInfo.bramDataWidth.W))) // fields of the request (each field is a word)
+  })
+
+  //
+  // State registers
+  //
+  val state = RegInit(sIdle)
+
+  //
+  // Internal registers
+  //
+  val regNumberOfReadFields = RegInit(0.U(log2Up(numberOfFields).W))
+  val regRequestFields = Reg(Vec(numberOfFields, UInt(instanceInfo.bramDataWidth.W)))
+
+  //
+  // Output pins
+  //
+  val readNextData = WireInit(false.B)
+  val finishedReadingRequest = WireInit(false.B)
+
+  //
+  // Apply the chip enable signal
+  //
+  when(io.en === true.B) {
+
+    switch(state) {
+
+      is(sIdle) {
+
+        //
+        // Read next data for the first field
+        //
+        readNextData := true.B
+
+        //
+        // Move to the next state
+        //
+        state := sReadField
+      }
+      is(sReadField) {
+
+        when(io.dataValidInput) {
+
+          //
+          // Data is valid and the field is now available
+          //
+          regRequestFields(regNumberOfReadFields) := io.receivingData
+
+          when(regNumberOfReadFields === (numberOfFields - 1).U) {
+
+            //
+            // All the fields are read
+            //
+            regNumberOfReadFields := 0.U
+            state := sDone
+
+          }.otherwise {
+
+            //
+            // Request next data
+            //
+            readNextData := true.B
+            regNumberOfReadFields := regNumberOfReadFields + 1.U
+
+            //
+            // Stay at the same state to read the next field
+            //
+            state := sReadField
+          }
+        }.otherwise {
+
+          //
+          // Stay at the same state since the data is not yet received
+          //
+          state := sReadField
+        }
+      }
+      is(sDone) {
+
+        //
+        // Reading the request finished
+        //
+        finishedReadingRequest := true.B
+
+        //
+        // Move to the idle state
+        //
+        state := sIdle
+      }
+    }
+  }
+
+  //
+  // Connect output pins
+  //
+  io.readNextData := readNextData
+
+  io.finishedReadingRequest := finishedReadingRequest
+  io.requestFields := regRequestFields
+
+}
+
+object InterpreterCaptureRequestHandler {
+
+  def apply(
+      debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+      instanceInfo: HwdbgInstanceInformation,
+      numberOfFields: Int
+  )(
+      en: Bool,
+      dataValidInput: Bool,
+      receivingData: UInt
+  ): (Bool, Bool, Vec[UInt]) = {
+
+    val interpreterCaptureRequestHandler = Module(
+      new InterpreterCaptureRequestHandler(
+        debug,
+        instanceInfo,
+        numberOfFields
+      )
+    )
+
+    val readNextData = Wire(Bool())
+
+    val finishedReadingRequest = Wire(Bool())
+    val requestFields = Wire(Vec(numberOfFields, UInt(instanceInfo.bramDataWidth.W)))
+
+    //
+    // Configure the input signals
+    //
+    interpreterCaptureRequestHandler.io.en := en
+
+    //
+    // Configure the input signals related to the receiving signals
+    //
+    interpreterCaptureRequestHandler.io.dataValidInput := dataValidInput
+    interpreterCaptureRequestHandler.io.receivingData := receivingData
+
+    //
+    // Configure the output signals
+    //
+    readNextData := interpreterCaptureRequestHandler.io.readNextData
+
+    //
+    // Configure the output signals related to the request
+    //
+    finishedReadingRequest := interpreterCaptureRequestHandler.io.finishedReadingRequest
+    requestFields := interpreterCaptureRequestHandler.io.requestFields
+
+    //
+    // Return the output result
+    //
+    (
+      readNextData,
+      finishedReadingRequest,
+      requestFields
+    )
+  }
+}
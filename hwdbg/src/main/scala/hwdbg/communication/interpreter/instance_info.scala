@@ -27,7 +27,8 @@ object InterpreterInstanceInfoEnums {
     val sIdle, sSendVersion, sSendMaximumNumberOfStages, sSendScriptVariableLength, sSendNumberOfSupportedLocalAndGlobalVariables,
         sSendNumberOfSupportedTemporaryVariables, sSendMaximumNumberOfSupportedGetScriptOperators, sSendMaximumNumberOfSupportedSetScriptOperators,
         sSendSharedMemorySize, sSendDebuggerAreaOffset, sSendDebuggeeAreaOffset, sSendNumberOfPins, sSendNumberOfPorts, sSendScriptCapabilities1,
-        sSendScriptCapabilities2, sSendBramAddrWidth, sSendBramDataWidth, sSendPortsConfiguration, sDone = Value
+        sSendScriptCapabilities2, sSendBramAddrWidth, sSendBramDataWidth, sSendMaximumNumberOfOperatorsPerStage, sSendCaptureBufferDepth,
+        sSendCaptureRunLengthWidth, sSendPortsConfiguration, sDone = Value
   }
 }
 
@@ -350,6 +351,53 @@ class InterpreterInstanceInfo(
         //
         dataValidOutput := true.B
 
+        state := sSendMaximumNumberOfOperatorsPerStage
+
+      }
+      is(sSendMaximumNumberOfOperatorsPerStage) {
+
+        //
+        // Set the maximum number of operators that are fused into a single stage
+        // by the script engine of this instance of the debugger
+        //
+        sendingData := instanceInfo.maximumNumberOfOperatorsPerStage.U
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendCaptureBufferDepth
+
+      }
+      is(sSendCaptureBufferDepth) {
+
+        //
+        // Set the number of entries in the capture buffer of this instance of the debugger
+        //
+        sendingData := instanceInfo.captureBufferDepth.U
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendCaptureRunLengthWidth
+
+      }
+      is(sSendCaptureRunLengthWidth) {
+
+        //
+        // Set the width of the run-length counter of capture buffer entries in this
+        // instance of the debugger
+        //
+        sendingData := instanceInfo.captureRunLengthWidth.U
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
         state := sSendPortsConfiguration
 
       }
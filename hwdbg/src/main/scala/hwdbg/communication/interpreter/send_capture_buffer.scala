@@ -0,0 +1,378 @@
+/**
+ * @file
+ *   send_capture_buffer.scala
+ * @author
+ *   Sina Karvandi (sina@hyperdbg.org)
+ * @brief
+ *   Send a chunk of the capture buffer (in the interpreter)
+ * @details
+ *   Each chunk starts with the header (HwdbgCaptureBufferChunk) and is followed by
+ *   the entries of the chunk, the number of entries in each chunk is limited by the
+ *   size of the debuggee area of the shared memory
+ * @version 0.1
+ * @date
+ *   2024-12-10
+ *
+ * @copyright
+ *   This project is released under the GNU Public License v3.
+ */
+package hwdbg.communication.interpreter
+
+import chisel3._
+import chisel3.util.{switch, is, log2Ceil, log2Up}
+import circt.stage.ChiselStage
+
+import hwdbg.configs._
+import hwdbg.types._
+import hwdbg.utils._
+
+object InterpreterSendCaptureBufferEnums {
+  object State extends ChiselEnum {
+    val sIdle, sSendCaptureState, sSendTriggerLatency, sSendNumberOfEntries, sSendTriggerEntry, sSendFirstEntry, sSendNumberOfEntriesInChunk,
+        sSendEntries, sDone = Value
+  }
+}
+
+class InterpreterSendCaptureBuffer(
+    debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+    instanceInfo: HwdbgInstanceInformation
+) extends Module {
+
+  //
+  // Import state enum
+  //
+  import InterpreterSendCaptureBufferEnums.State
+  import InterpreterSendCaptureBufferEnums.State._
+
+  //
+  // Number of words of each entry (the run length and then the sample)
+  //
+  val numberOfSampleWords = (instanceInfo.numberOfPins + instanceInfo.bramDataWidth - 1) / instanceInfo.bramDataWidth
+  val numberOfEntryWords = 1 + numberOfSampleWords
+
+  //
+  // Maximum number of entries that fit into the debuggee area (after the packet header
+  // and the chunk header)
+  //
+  val numberOfDebuggeeAreaWords =
+    (instanceInfo.sharedMemorySize - instanceInfo.debuggeeAreaOffset - new DebuggerRemotePacket().Offset.startOfDataBuffer) / (instanceInfo.bramDataWidth >> 3)
+  val maximumNumberOfEntriesInChunk = (numberOfDebuggeeAreaWords - new HwdbgCaptureBufferChunk().Size.numberOfFields) / numberOfEntryWords
+
+  require(
+    maximumNumberOfEntriesInChunk > 0,
+    "err, the debuggee area of the shared memory is not big enough to send the entries of the capture buffer."
+  )
+
+  LogInfo(debug)(s"Maximum number of capture buffer entries in each chunk: ${maximumNumberOfEntriesInChunk}")
+
+  //
+  // Latency of the script engine (the trigger pin is set after the sample that caused it)
+  //
+  val triggerLatency = math.max(instanceInfo.maximumNumberOfStages - 1, 0)
+
+  val io = IO(new Bundle {
+
+    //
+    // Chip signals
+    //
+    val en = Input(Bool()) // chip enable signal
+
+    //
+    // Capture buffer signals
+    //
+    val captureStatus = Input(new HwdbgCaptureStatus(instanceInfo)) // status of the capture buffer
+    val firstEntry = Input(UInt(instanceInfo.bramDataWidth.W)) // first entry of the requested chunk
+    val readEntryIndex = Output(UInt(log2Ceil(instanceInfo.captureBufferDepth).W)) // index of the entry to read
+    val readEntry = Input(new HwdbgCaptureEntry(instanceInfo)) // the entry read from the capture buffer
+
+    //
+    // Sending singals
+    //
+    val noNewDataSender = Output(Bool()) // should sender finish sending buffers or not?
+    val dataValidOutput = Output(Bool()) // should sender send next buffer or not?
+    val sendingData = Output(UInt(instanceInfo.bramDataWidth.W)) // data to be sent to the debugger
+
+  })
+
+  //
+  // State registers
+  //
+  val state = RegInit(sIdle)
+
+  //
+  // Registers for keeping track of sent entries
+  //
+  val regEntryIndex = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth).W))
+  val regNumberOfEntriesInChunk = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth + 1).W))
+  val regNumberOfSentEntries = RegInit(0.U(log2Ceil(instanceInfo.captureBufferDepth + 1).W))
+  val regNumberOfSentWords = RegInit(0.U(log2Up(numberOfEntryWords).W))
+
+  //
+  // Words of the current entry (the sample is split into words)
+  //
+  val paddedSample = io.readEntry.Sample.pad(numberOfSampleWords * instanceInfo.bramDataWidth)
+  val entryWords = VecInit(
+    Seq(io.readEntry.RunLength.pad(instanceInfo.bramDataWidth)) ++
+      Seq.tabulate(numberOfSampleWords)(i => paddedSample((i + 1) * instanceInfo.bramDataWidth - 1, i * instanceInfo.bramDataWidth))
+  )
+
+  //
+  // Output pins
+  //
+  val noNewDataSender = WireInit(false.B)
+  val dataValidOutput = WireInit(false.B)
+  val sendingData = WireInit(0.U(instanceInfo.bramDataWidth.W))
+
+  //
+  // Apply the chip enable signal
+  //
+  when(io.en === true.B) {
+
+    switch(state) {
+
+      is(sIdle) {
+
+        //
+        // Compute the number of entries in this chunk, entries are only sent once the
+        // capture is done
+        //
+        val numberOfRemainingEntries = io.captureStatus.numberOfEntries - io.firstEntry
+
+        when(
+          io.captureStatus.captureState =/= HwdbgCaptureStateEnums.hwdbgCaptureStateDone.id.U ||
+            io.firstEntry >= io.captureStatus.numberOfEntries
+        ) {
+          regNumberOfEntriesInChunk := 0.U
+        }.elsewhen(numberOfRemainingEntries > maximumNumberOfEntriesInChunk.U) {
+          regNumberOfEntriesInChunk := maximumNumberOfEntriesInChunk.U
+        }.otherwise {
+          regNumberOfEntriesInChunk := numberOfRemainingEntries
+        }
+
+        //
+        // Start reading the first entry (the entry is read while the header is sent)
+        //
+        regEntryIndex := io.firstEntry
+        regNumberOfSentEntries := 0.U
+        regNumberOfSentWords := 0.U
+
+        //
+        // Going to the next state (sending the state of the capture)
+        //
+        state := sSendCaptureState
+      }
+      is(sSendCaptureState) {
+
+        //
+        // Set the state of the capture
+        //
+        sendingData := io.captureStatus.captureState
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendTriggerLatency
+
+      }
+      is(sSendTriggerLatency) {
+
+        //
+        // Set the latency of the trigger (number of samples between the sample that caused
+        // the trigger and the trigger entry)
+        //
+        sendingData := triggerLatency.U
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendNumberOfEntries
+
+      }
+      is(sSendNumberOfEntries) {
+
+        //
+        // Set the number of entries in the capture window
+        //
+        sendingData := io.captureStatus.numberOfEntries
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendTriggerEntry
+
+      }
+      is(sSendTriggerEntry) {
+
+        //
+        // Set the index of the trigger entry in the capture window
+        //
+        sendingData := io.captureStatus.triggerEntry
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendFirstEntry
+
+      }
+      is(sSendFirstEntry) {
+
+        //
+        // Set the first entry of this chunk
+        //
+        sendingData := io.firstEntry
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        state := sSendNumberOfEntriesInChunk
+
+      }
+      is(sSendNumberOfEntriesInChunk) {
+
+        //
+        // Set the number of entries in this chunk
+        //
+        sendingData := regNumberOfEntriesInChunk
+
+        //
+        // The output is valid
+        //
+        dataValidOutput := true.B
+
+        when(regNumberOfEntriesInChunk === 0.U) {
+          state := sDone
+        }.otherwise {
+          state := sSendEntries
+        }
+
+      }
+      is(sSendEntries) {
+
+        //
+        // Send the words of the current entry (the entry is available since its index is set
+        // at least one clock before)
+        //
+        sendingData := entryWords(regNumberOfSentWords)
+
+        //
+        // Data is valid
+        //
+        dataValidOutput := true.B
+
+        when(regNumberOfSentWords === (numberOfEntryWords - 1).U) {
+
+          //
+          // Read the next entry
+          //
+          regNumberOfSentWords := 0.U
+          regEntryIndex := regEntryIndex + 1.U
+          regNumberOfSentEntries := regNumberOfSentEntries + 1.U
+
+          when(regNumberOfSentEntries + 1.U === regNumberOfEntriesInChunk) {
+            state := sDone
+          }.otherwise {
+            state := sSendEntries
+          }
+
+        }.otherwise {
+
+          //
+          // Send next word of the entry
+          //
+          regNumberOfSentWords := regNumberOfSentWords + 1.U
+
+          //
+          // Stay at the same state
+          //
+          state := sSendEntries
+        }
+      }
+      is(sDone) {
+
+        //
+        // Indicate that sending data is done
+        //
+        noNewDataSender := true.B
+
+        //
+        // Goto the idle state
+        //
+        state := sIdle
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------
+
+  //
+  // Connect output pins
+  //
+  io.readEntryIndex := regEntryIndex
+
+  io.noNewDataSender := noNewDataSender
+  io.dataValidOutput := dataValidOutput
+  io.sendingData := sendingData
+
+}
+
+object InterpreterSendCaptureBuffer {
+
+  def apply(
+      debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+      instanceInfo: HwdbgInstanceInformation
+  )(
+      en: Bool,
+      captureStatus: HwdbgCaptureStatus,
+      firstEntry: UInt,
+      readEntry: HwdbgCaptureEntry
+  ): (Bool, Bool, UInt, UInt) = {
+
+    val interpreterSendCaptureBuffer = Module(
+      new InterpreterSendCaptureBuffer(
+        debug,
+        instanceInfo
+      )
+    )
+
+    val noNewDataSender = Wire(Bool())
+    val dataValidOutput = Wire(Bool())
+    val sendingData = Wire(UInt(instanceInfo.bramDataWidth.W))
+    val readEntryIndex = Wire(UInt(log2Ceil(instanceInfo.captureBufferDepth).W))
+
+    //
+    // Configure the input signals
+    //
+    interpreterSendCaptureBuffer.io.en := en
+    interpreterSendCaptureBuffer.io.captureStatus := captureStatus
+    interpreterSendCaptureBuffer.io.firstEntry := firstEntry
+    interpreterSendCaptureBuffer.io.readEntry := readEntry
+
+    //
+    // Configure the output signals
+    //
+    noNewDataSender := interpreterSendCaptureBuffer.io.noNewDataSender
+    dataValidOutput := interpreterSendCaptureBuffer.io.dataValidOutput
+    sendingData := interpreterSendCaptureBuffer.io.sendingData
+    readEntryIndex := interpreterSendCaptureBuffer.io.readEntryIndex
+
+    //
+    // Return the output result
+    //
+    (
+      noNewDataSender,
+      dataValidOutput,
+      sendingData,
+      readEntryIndex
+    )
+  }
+}
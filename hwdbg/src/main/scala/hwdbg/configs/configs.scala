@@ -108,6 +108,11 @@ object ScriptEngineConfigurations {
   //
   var MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS: Int = 1 // for get value
 
+  //
+  // Maximum number of operators (funcs) that are fused into a single stage
+  //
+  var MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE: Int = 1 // 1 means each stage evaluates one operator
+
   //
   // Script variable length
   //
@@ -162,6 +167,23 @@ object ScriptEngineConfigurations {
   )
 }
 
+/**
+ * @brief
+ *   Design constants for the capture buffer (logic analyzer) (Definition and Default Values)
+ */
+object CaptureConfigurations {
+
+  //
+  // Number of (run-length encoded) entries in the capture buffer (should be a power of two)
+  //
+  var CAPTURE_BUFFER_DEPTH: Int = 1024
+
+  //
+  // Width of the run-length counter of each entry (maximum number of samples in an entry)
+  //
+  var CAPTURE_RUN_LENGTH_WIDTH: Int = 16
+}
+
 /**
  * @brief
  *   The constants for memory communication (Definition and Default Values)
@@ -213,6 +235,9 @@ case class HwdbgInstanceInformation(
     numberOfSupportedTemporaryVariables: Int, // Number of supported temporary variables
     maximumNumberOfSupportedGetScriptOperators: Int, // Maximum supported GET operators in a single func
     maximumNumberOfSupportedSetScriptOperators: Int, // Maximum supported SET operators in a single func
+    maximumNumberOfOperatorsPerStage: Int, // Maximum number of operators (funcs) fused into a single stage
+    captureBufferDepth: Int, // Number of entries in the capture buffer
+    captureRunLengthWidth: Int, // Width of the run-length counter of capture buffer entries
     sharedMemorySize: Int, // Size of shared memory
     debuggerAreaOffset: Int, // The memory offset of debugger
     debuggeeAreaOffset: Int, // The memory offset of debuggee
@@ -293,6 +318,23 @@ object HwdbgScriptCapabilities {
     func_printf
   )
 
+  //
+  // Operators that are never fused into a stage after its first operator since
+  // they need wide arithmetic logic (and would reduce the maximum clock rate)
+  //
+  // SHOULD BE SYNCHRONIZED WITH HardwareScriptInterpreterIsFusibleOperator IN HYPERDBG
+  //
+  def nonFusibleOperators: Seq[Long] = Seq(
+    func_asr,
+    func_asl,
+    func_add,
+    func_sub,
+    func_mul,
+    func_div,
+    func_mod,
+    func_printf
+  )
+
   //
   // Utility method to create a bitmask from a sequence of capabilities
   //
@@ -307,6 +349,14 @@ object HwdbgScriptCapabilities {
     (supportedCapabilities & capability) != 0
   }
 
+  //
+  // Function to get the capabilities of the fused operators (comparisons, logical operators,
+  // branches and moves) of a stage
+  //
+  def getFusedCapabilities(supportedCapabilities: Long): Long = {
+    supportedCapabilities & ~createCapabilitiesMask(nonFusibleOperators)
+  }
+
 }
 
 object HwdbgInstanceInformation {
@@ -322,6 +372,9 @@ object HwdbgInstanceInformation {
       numberOfSupportedTemporaryVariables: Int,
       maximumNumberOfSupportedGetScriptOperators: Int,
       maximumNumberOfSupportedSetScriptOperators: Int,
+      maximumNumberOfOperatorsPerStage: Int,
+      captureBufferDepth: Int,
+      captureRunLengthWidth: Int,
       sharedMemorySize: Int,
       debuggerAreaOffset: Int,
       debuggeeAreaOffset: Int,
@@ -354,6 +407,9 @@ object HwdbgInstanceInformation {
       numberOfSupportedTemporaryVariables = numberOfSupportedTemporaryVariables,
       maximumNumberOfSupportedGetScriptOperators = maximumNumberOfSupportedGetScriptOperators,
       maximumNumberOfSupportedSetScriptOperators = maximumNumberOfSupportedSetScriptOperators,
+      maximumNumberOfOperatorsPerStage = maximumNumberOfOperatorsPerStage,
+      captureBufferDepth = captureBufferDepth,
+      captureRunLengthWidth = captureRunLengthWidth,
       sharedMemorySize = sharedMemorySize,
       debuggerAreaOffset = debuggerAreaOffset,
       debuggeeAreaOffset = debuggeeAreaOffset,
@@ -386,11 +442,16 @@ object ConfigLoader {
       MAXIMUM_NUMBER_OF_STAGES: Int,
       MAXIMUM_NUMBER_OF_SUPPORTED_GET_SCRIPT_OPERATORS: Int,
       MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS: Int,
+      MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE: Int,
       SCRIPT_VARIABLE_LENGTH: Int,
       NUMBER_OF_SUPPORTED_LOCAL_AND_GLOBAL_VARIABLES: Int,
       NUMBER_OF_SUPPORTED_TEMPORARY_VARIABLES: Int,
       SCRIPT_ENGINE_EVAL_CAPABILITIES: Seq[String]
   )
+  case class CaptureConfigurationsConfig(
+      CAPTURE_BUFFER_DEPTH: Int,
+      CAPTURE_RUN_LENGTH_WIDTH: Int
+  )
   case class MemoryCommunicationConfigurationsConfig(
       BLOCK_RAM_ADDR_WIDTH: Int,
       BLOCK_RAM_DATA_WIDTH: Int,
@@ -403,6 +464,7 @@ object ConfigLoader {
       Version: VersionConfig,
       DebuggerConfigurations: DebuggerConfigurationsConfig,
       ScriptEngineConfigurations: ScriptEngineConfigurationsConfig,
+      CaptureConfigurations: CaptureConfigurationsConfig,
       MemoryCommunicationConfigurations: MemoryCommunicationConfigurationsConfig
   )
 
@@ -454,6 +516,7 @@ object LoadConfiguration {
       ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_STAGES = config.ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_STAGES
       ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_GET_SCRIPT_OPERATORS = config.ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_GET_SCRIPT_OPERATORS
       ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS = config.ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS
+      ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE = config.ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE
       ScriptEngineConfigurations.SCRIPT_VARIABLE_LENGTH = config.ScriptEngineConfigurations.SCRIPT_VARIABLE_LENGTH
       ScriptEngineConfigurations.NUMBER_OF_SUPPORTED_LOCAL_AND_GLOBAL_VARIABLES = config.ScriptEngineConfigurations.NUMBER_OF_SUPPORTED_LOCAL_AND_GLOBAL_VARIABLES
       ScriptEngineConfigurations.NUMBER_OF_SUPPORTED_TEMPORARY_VARIABLES = config.ScriptEngineConfigurations.NUMBER_OF_SUPPORTED_TEMPORARY_VARIABLES
@@ -486,6 +549,12 @@ object LoadConfiguration {
         case _ => None
       }
 
+      //
+      // Read the capture buffer configurations
+      //
+      CaptureConfigurations.CAPTURE_BUFFER_DEPTH = config.CaptureConfigurations.CAPTURE_BUFFER_DEPTH
+      CaptureConfigurations.CAPTURE_RUN_LENGTH_WIDTH = config.CaptureConfigurations.CAPTURE_RUN_LENGTH_WIDTH
+
       //
       // Read memory communication configurations
       //
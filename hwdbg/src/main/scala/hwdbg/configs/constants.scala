@@ -31,6 +31,13 @@ object HyperDbgSharedConstants {
   //
   val INDICATOR_OF_HYPERDBG_PACKET: Long = 0x4859504552444247L // HYPERDBG = 0x4859504552444247
 
+  //
+  // Binary BRAM images (HWDBG_BRAM_IMAGE_HEADER)
+  //
+  val BRAM_IMAGE_FILE_EXTENSION: String = ".bram"
+  val BRAM_IMAGE_MAGIC: Int = 0x4d415242 // 'BRAM'
+  val BRAM_IMAGE_VERSION: Int = 1
+
 }
 
 /**
@@ -15,6 +15,9 @@
  */
 package hwdbg.libs.mem
 
+import java.nio.{ByteBuffer, ByteOrder}
+import java.nio.file.{Files, Paths}
+
 import scala.collection.mutable.ArrayBuffer
 import scala.io.Source
 
@@ -22,6 +25,7 @@ import chisel3._
 
 import hwdbg.utils._
 import hwdbg.configs._
+import hwdbg.constants._
 
 object InitRegMemFromFileTools {
   def readmemh(
@@ -52,6 +56,52 @@ object InitRegMemFromFileTools {
     buffer.toSeq
 
   }
+
+  def readBinaryImage(
+      debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+      path: String,
+      width: Int
+  ): Seq[UInt] = {
+
+    //
+    // The image contains a header (HWDBG_BRAM_IMAGE_HEADER) and the little-endian words of the BRAM
+    //
+    val image = ByteBuffer.wrap(Files.readAllBytes(Paths.get(path))).order(ByteOrder.LITTLE_ENDIAN)
+
+    require(
+      image.getInt(0) == HyperDbgSharedConstants.BRAM_IMAGE_MAGIC && image.getInt(4) == HyperDbgSharedConstants.BRAM_IMAGE_VERSION,
+      s"err, invalid BRAM image: ${path}"
+    )
+
+    val headerSize = image.getInt(8)
+    val numberOfWords = image.getInt(12)
+
+    (0 until numberOfWords).map { index =>
+      val word = image.getInt(headerSize + index * 4).toLong & 0xffffffffL
+
+      LogInfo(debug)(
+        f"Initialize memory [${index * 4}%x]: 0x${word}%x"
+      )
+
+      word.U(width.W)
+    }
+  }
+
+  def readMemoryFile(
+      debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+      path: String,
+      width: Int
+  ): Seq[UInt] = {
+
+    //
+    // Binary images are read directly, other files are text hex files
+    //
+    if (path.endsWith(HyperDbgSharedConstants.BRAM_IMAGE_FILE_EXTENSION)) {
+      readBinaryImage(debug, path, width)
+    } else {
+      readmemh(debug, path, width)
+    }
+  }
 }
 
 class InitRegMemFromFile(
@@ -74,7 +124,7 @@ class InitRegMemFromFile(
   //
   // Not needed to show the BRAM information
   //
-  val mem = RegInit(VecInit(InitRegMemFromFileTools.readmemh(false, memoryFile, width)))
+  val mem = RegInit(VecInit(InitRegMemFromFileTools.readMemoryFile(false, memoryFile, width)))
 
   val actualAddr = Wire(UInt(addrWidth.W))
   val actualData = Wire(UInt(width.W))
@@ -16,12 +16,14 @@
 package hwdbg
 
 import chisel3._
+import chisel3.util.isPow2
 import circt.stage.ChiselStage
 
 import hwdbg.configs._
 import hwdbg.types._
 import hwdbg.utils._
 import hwdbg.script._
+import hwdbg.capture._
 import hwdbg.communication._
 import hwdbg.communication.interpreter._
 
@@ -31,6 +33,9 @@ class DebuggerMain(
     maximumNumberOfStages: Int,
     maximumNumberOfSupportedGetScriptOperators: Int,
     maximumNumberOfSupportedSetScriptOperators: Int,
+    maximumNumberOfOperatorsPerStage: Int,
+    captureBufferDepth: Int,
+    captureRunLengthWidth: Int,
     sharedMemorySize: Int,
     debuggerAreaOffset: Int,
     debuggeeAreaOffset: Int,
@@ -90,6 +95,33 @@ class DebuggerMain(
     "err, the supported number of SET operators can be only 1."
   )
 
+  //
+  // Ensure that each stage contains at least one operator, the rest of operators
+  // of a stage are fused (chained) into the same clock cycle
+  //
+  require(
+    maximumNumberOfOperatorsPerStage >= 1,
+    "err, the maximum number of operators per stage should be at least 1."
+  )
+
+  //
+  // Ensure the capture buffer (ring) depth is a power of two, so the ring pointers
+  // wrap around without extra logic
+  //
+  require(
+    captureBufferDepth >= 2 && isPow2(captureBufferDepth),
+    "err, the capture buffer depth (CAPTURE_BUFFER_DEPTH) should be a power of two."
+  )
+
+  //
+  // Ensure the run-length counter of capture entries fits into a single BRAM word
+  // since it's sent as a separate word to the debugger
+  //
+  require(
+    captureRunLengthWidth >= 1 && captureRunLengthWidth <= bramDataWidth,
+    "err, the run-length width of capture entries should not be bigger than BRAM data width."
+  )
+
   val io = IO(new Bundle {
 
     //
@@ -130,6 +162,9 @@ class DebuggerMain(
     numberOfSupportedTemporaryVariables = numberOfSupportedTemporaryVariables,
     maximumNumberOfSupportedGetScriptOperators = maximumNumberOfSupportedGetScriptOperators,
     maximumNumberOfSupportedSetScriptOperators = maximumNumberOfSupportedSetScriptOperators,
+    maximumNumberOfOperatorsPerStage = maximumNumberOfOperatorsPerStage,
+    captureBufferDepth = captureBufferDepth,
+    captureRunLengthWidth = captureRunLengthWidth,
     sharedMemorySize = sharedMemorySize,
     debuggerAreaOffset = debuggerAreaOffset,
     debuggeeAreaOffset = debuggeeAreaOffset,
@@ -150,6 +185,12 @@ class DebuggerMain(
   val receivingData = Wire(UInt(bramDataWidth.W))
   val sendWaitForBuffer = Wire(Bool())
 
+  //
+  // Wire signals for the capture buffer
+  //
+  val captureStatus = Wire(new HwdbgCaptureStatus(instanceInfo))
+  val captureReadEntry = Wire(new HwdbgCaptureEntry(instanceInfo))
+
   // -----------------------------------------------------------------------
   // Create instance from interpreter
   //
@@ -163,7 +204,10 @@ class DebuggerMain(
     sendingData,
     finishedScriptConfiguration,
     configureStage,
-    targetOperator
+    targetOperator,
+    captureArm,
+    captureConfiguration,
+    captureReadEntryIndex
   ) =
     DebuggerPacketInterpreter(
       debug,
@@ -174,7 +218,9 @@ class DebuggerMain(
       requestedActionOfThePacketOutputValid,
       dataValidOutput,
       receivingData,
-      sendWaitForBuffer
+      sendWaitForBuffer,
+      captureStatus,
+      captureReadEntry
     )
 
   // -----------------------------------------------------------------------
@@ -192,6 +238,26 @@ class DebuggerMain(
       io.inputPin
     )
 
+  // -----------------------------------------------------------------------
+  // Create instance from capture buffer (the output pins of the script engine
+  // are used as the trigger)
+  //
+  val (
+    outCaptureStatus,
+    outCaptureReadEntry
+  ) =
+    DebuggerCaptureBuffer(
+      debug,
+      instanceInfo
+    )(
+      io.en,
+      io.inputPin,
+      outputPin,
+      captureArm,
+      captureConfiguration,
+      captureReadEntryIndex
+    )
+
   // -----------------------------------------------------------------------
   // Create instance from synchronizer
   //
@@ -231,6 +297,12 @@ class DebuggerMain(
   receivingData := outReceivingData
   sendWaitForBuffer := outSendWaitForBuffer
 
+  // -----------------------------------------------------------------------
+  // Connect capture buffer signals to wires
+  //
+  captureStatus := outCaptureStatus
+  captureReadEntry := outCaptureReadEntry
+
   // -----------------------------------------------------------------------
   // Configure the output signals
   //
@@ -252,6 +324,9 @@ object DebuggerMain {
       maximumNumberOfStages: Int,
       maximumNumberOfSupportedGetScriptOperators: Int,
       maximumNumberOfSupportedSetScriptOperators: Int,
+      maximumNumberOfOperatorsPerStage: Int,
+      captureBufferDepth: Int,
+      captureRunLengthWidth: Int,
       sharedMemorySize: Int,
       debuggerAreaOffset: Int,
       debuggeeAreaOffset: Int,
@@ -276,6 +351,9 @@ object DebuggerMain {
         maximumNumberOfStages,
         maximumNumberOfSupportedGetScriptOperators,
         maximumNumberOfSupportedSetScriptOperators,
+        maximumNumberOfOperatorsPerStage,
+        captureBufferDepth,
+        captureRunLengthWidth,
         sharedMemorySize,
         debuggerAreaOffset,
         debuggeeAreaOffset,
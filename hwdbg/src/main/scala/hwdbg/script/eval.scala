@@ -47,7 +47,7 @@ class ScriptEngineEval(
     val nextStage = Output(
       UInt(
         log2Ceil(
-          instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+          instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
         ).W
       )
     )
@@ -69,7 +69,7 @@ class ScriptEngineEval(
   val nextStage = WireInit(
     0.U(
       log2Ceil(
-        instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+        instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
       ).W
     )
   )
@@ -475,7 +475,7 @@ object ScriptEngineEval {
     val nextStage = Wire(
       UInt(
         log2Ceil(
-          instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+          instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
         ).W
       )
     )
@@ -91,10 +91,16 @@ class ScriptExecutionEngine(
   // Create a register with the width based on the maximum value
   //
   val configGetSetOperatorNumber = RegInit(0.U(log2Ceil(maxOperators).W))
+
+  //
+  // Operator number of the current stage (the first operator is the stage symbol and
+  // the rest of them are fused operators)
+  //
+  val configOperatorNumber = RegInit(0.U(log2Up(instanceInfo.maximumNumberOfOperatorsPerStage).W))
   val stageIndex = RegInit(
     0.U(
       log2Ceil(
-        instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+        instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
       ).W
     )
   )
@@ -115,24 +121,47 @@ class ScriptExecutionEngine(
         //
         stageConfigurationValid := false.B
 
-        //
-        // Configure the stage symbol (The first symbol is the stage operator)
-        //
-        stageRegs(configStageNumber).stageSymbol := io.targetOperator
+        when(configOperatorNumber === 0.U) {
+
+          //
+          // Configure the stage symbol (The first symbol is the stage operator)
+          //
+          stageRegs(configStageNumber).stageSymbol := io.targetOperator
+
+          //
+          // Set the stage index
+          //
+          stageRegs(configStageNumber).stageIndex := stageIndex // store the stage index
+          stageRegs(configStageNumber).targetStage := 0.U // reset the target stage
+          stageIndex := stageIndex + 1.U // increment stage index
+
+          //
+          // If it is the very first configuration symbol, then we disable all stages
+          //
+          when(configStageNumber === 0.U) {
+            for (i <- 0 until instanceInfo.maximumNumberOfStages) {
+              stageRegs(i).stageEnable := false.B
+            }
+          }
+        }.otherwise {
 
-        //
-        // Set the stage index
-        //
-        stageRegs(configStageNumber).stageIndex := stageIndex // store the stage index
-        stageRegs(configStageNumber).targetStage := 0.U // reset the target stage
-        stageIndex := stageIndex + 1.U // increment stage index
+          //
+          // Configure the fused operator (The next operators of the stage)
+          //
+          if (instanceInfo.maximumNumberOfOperatorsPerStage > 1) {
 
-        //
-        // If it is the very first configuration symbol, then we disable all stages
-        //
-        when(configStageNumber === 0.U) {
-          for (i <- 0 until instanceInfo.maximumNumberOfStages) {
-            stageRegs(i).stageEnable := false.B
+            val fusedOperator = stageRegs(configStageNumber).fusedOperators(configOperatorNumber - 1.U)
+
+            fusedOperator.operatorSymbol := io.targetOperator
+            fusedOperator.operatorIndex := stageIndex // store the operator index
+            fusedOperator.operatorEnable := io.targetOperator.Type =/= 0.U // empty operators are not evaluated
+          }
+
+          //
+          // Check whether this operator should be counted in stage indexes or its empty
+          //
+          when(io.targetOperator.Type =/= 0.U) {
+            stageIndex := stageIndex + 1.U
           }
         }
 
@@ -146,7 +175,13 @@ class ScriptExecutionEngine(
         //
         // Config GET operator
         //
-        stageRegs(configStageNumber).getOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+        when(configOperatorNumber === 0.U) {
+          stageRegs(configStageNumber).getOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+        }.otherwise {
+          if (instanceInfo.maximumNumberOfOperatorsPerStage > 1) {
+            stageRegs(configStageNumber).fusedOperators(configOperatorNumber - 1.U).getOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+          }
+        }
         configGetSetOperatorNumber := configGetSetOperatorNumber + 1.U
 
         //
@@ -169,7 +204,13 @@ class ScriptExecutionEngine(
         //
         // Config SET operator
         //
-        stageRegs(configStageNumber).setOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+        when(configOperatorNumber === 0.U) {
+          stageRegs(configStageNumber).setOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+        }.otherwise {
+          if (instanceInfo.maximumNumberOfOperatorsPerStage > 1) {
+            stageRegs(configStageNumber).fusedOperators(configOperatorNumber - 1.U).setOperatorSymbol(configGetSetOperatorNumber) := io.targetOperator
+          }
+        }
         stageRegs(configStageNumber).stageEnable := true.B // this stage is enabled
         configGetSetOperatorNumber := configGetSetOperatorNumber + 1.U
 
@@ -187,6 +228,7 @@ class ScriptExecutionEngine(
             // Not configuring anymore, reset the stage number
             //
             configStageNumber := 0.U // reset the stage number
+            configOperatorNumber := 0.U // reset the operator number
             stageIndex := 0.U // reset the stage index
             configState := sConfigStageSymbol
 
@@ -195,8 +237,12 @@ class ScriptExecutionEngine(
             //
             stageConfigurationValid := true.B
 
+          }.elsewhen(configOperatorNumber =/= (instanceInfo.maximumNumberOfOperatorsPerStage - 1).U) {
+            configOperatorNumber := configOperatorNumber + 1.U // the next operator is fused into the same stage
+            configState := sConfigStageSymbol // the next state is again a stage symbol
           }.otherwise {
             configStageNumber := configStageNumber + 1.U // Increment the stage number holder of current configuration
+            configOperatorNumber := 0.U // reset the operator number
             configState := sConfigStageSymbol // the next state is again a stage symbol
           }
         }.otherwise {
@@ -236,20 +282,56 @@ class ScriptExecutionEngine(
     } else {
 
       //
-      // Check if this stage should be ignored (passed to the next stage) or be evaluated
-      // (i - 1) is because the 0th index registers are used for storing data but the
-      // script engine assumes that the symbols start from 0, so -1 is used here
-      //
-      // Also, if the stage data is valid (configuration applied at least once)
+      // The values that are passed through the operators of this stage, each operator (the stage
+      // symbol and then the fused operators) takes the values produced by its previous operator,
+      // thus, the fused operators are chained and evaluated in the same clock
       //
-      when(stageConfigurationValid === true.B && stageRegs(i - 1).stageIndex === stageRegs(i - 1).targetStage && stageRegs(i - 1).stageEnable === true.B) {
+      var pinValues: Vec[UInt] = stageRegs(i - 1).pinValues
+      var targetStage: UInt = stageRegs(i - 1).targetStage
+      var localGlobalVariables: Vec[UInt] = stageRegs(i - 1).localGlobalVariables
+      var tempVariables: Vec[UInt] = stageRegs(i - 1).tempVariables
+
+      for (j <- 0 until instanceInfo.maximumNumberOfOperatorsPerStage) {
+
+        //
+        // The first operator is the stage symbol, the fused operators only support cheap
+        // operators (comparisons, logical operators, branches and moves)
+        //
+        val operatorInstanceInfo =
+          if (j == 0) instanceInfo
+          else instanceInfo.copy(scriptCapabilities = HwdbgScriptCapabilities.getFusedCapabilities(instanceInfo.scriptCapabilities))
+
+        val operatorStage = Wire(new Stage(debug, instanceInfo))
+
+        operatorStage := stageRegs(i - 1)
+        operatorStage.pinValues := pinValues
+        operatorStage.targetStage := targetStage
+        operatorStage.localGlobalVariables := localGlobalVariables
+        operatorStage.tempVariables := tempVariables
+
+        if (j != 0) {
 
+          val fusedOperator = stageRegs(i - 1).fusedOperators(j - 1)
+
+          operatorStage.stageSymbol := fusedOperator.operatorSymbol
+          operatorStage.getOperatorSymbol := fusedOperator.getOperatorSymbol
+          operatorStage.setOperatorSymbol := fusedOperator.setOperatorSymbol
+          operatorStage.stageIndex := fusedOperator.operatorIndex
+          operatorStage.stageEnable := stageRegs(i - 1).stageEnable && fusedOperator.operatorEnable
+        }
+
+        //
+        // Check if this operator should be ignored (passed to the next operator) or be evaluated
+        // (i - 1) is because the 0th index registers are used for storing data but the
+        // script engine assumes that the symbols start from 0, so -1 is used here
         //
-        // *** Based on target stage, this stage needs evaluation ***
+        // Also, if the stage data is valid (configuration applied at least once)
         //
+        val evaluateOperator =
+          stageConfigurationValid === true.B && operatorStage.stageIndex === targetStage && operatorStage.stageEnable === true.B
 
         //
-        // Instantiate an eval engine for this stage
+        // Instantiate an eval engine for this operator
         //
         val (
           nextStage,
@@ -258,64 +340,47 @@ class ScriptExecutionEngine(
           resultingTempVariables
         ) = ScriptEngineEval(
           debug,
-          instanceInfo
+          operatorInstanceInfo
         )(
-          stageRegs(i - 1).stageEnable,
-          stageRegs(i - 1)
+          evaluateOperator,
+          operatorStage
         )
 
         //
-        // At the normal (middle) stage, the result of state registers should be passed to
-        // the next level of stage registers
-        //
-        stageRegs(i).pinValues := outputPin
-
-        //
-        // Pass the target stage symbol number to the next stage
-        //
-        stageRegs(i).targetStage := nextStage
-
-        //
-        // Pass the local (and global) and temporary variables to the next stage
-        //
-        if (HwdbgScriptCapabilities.isCapabilitySupported(instanceInfo.scriptCapabilities, HwdbgScriptCapabilities.assign_local_global_var) == true) {
-          stageRegs(i).localGlobalVariables := resultingLocalGlobalVariables
-        }
-
-        if (
-          HwdbgScriptCapabilities.isCapabilitySupported(
-            instanceInfo.scriptCapabilities,
-            HwdbgScriptCapabilities.conditional_statements_and_comparison_operators
-          ) == true
-        ) {
-          stageRegs(i).tempVariables := resultingTempVariables
-        }
-
-      }.otherwise {
-
-        //
-        // *** Based on target stage, this stage should be ignore ***
+        // Based on target stage, either use the result of this operator or just pass the values
+        // to the next operator
         //
+        pinValues = Mux(evaluateOperator, outputPin, pinValues)
+        targetStage = Mux(evaluateOperator, nextStage, targetStage)
+        localGlobalVariables = Mux(evaluateOperator, resultingLocalGlobalVariables, localGlobalVariables)
+        tempVariables = Mux(evaluateOperator, resultingTempVariables, tempVariables)
+      }
 
-        //
-        // Just pass all the values to the next stage
-        //
-        stageRegs(i).pinValues := stageRegs(i - 1).pinValues
-        stageRegs(i).targetStage := stageRegs(i - 1).targetStage
+      //
+      // At the normal (middle) stage, the result of state registers should be passed to
+      // the next level of stage registers
+      //
+      stageRegs(i).pinValues := pinValues
 
-        if (HwdbgScriptCapabilities.isCapabilitySupported(instanceInfo.scriptCapabilities, HwdbgScriptCapabilities.assign_local_global_var) == true) {
-          stageRegs(i).localGlobalVariables := stageRegs(i - 1).localGlobalVariables
-        }
+      //
+      // Pass the target stage symbol number to the next stage
+      //
+      stageRegs(i).targetStage := targetStage
 
-        if (
-          HwdbgScriptCapabilities.isCapabilitySupported(
-            instanceInfo.scriptCapabilities,
-            HwdbgScriptCapabilities.conditional_statements_and_comparison_operators
-          ) == true
-        ) {
-          stageRegs(i).tempVariables := stageRegs(i - 1).tempVariables
-        }
+      //
+      // Pass the local (and global) and temporary variables to the next stage
+      //
+      if (HwdbgScriptCapabilities.isCapabilitySupported(instanceInfo.scriptCapabilities, HwdbgScriptCapabilities.assign_local_global_var) == true) {
+        stageRegs(i).localGlobalVariables := localGlobalVariables
+      }
 
+      if (
+        HwdbgScriptCapabilities.isCapabilitySupported(
+          instanceInfo.scriptCapabilities,
+          HwdbgScriptCapabilities.conditional_statements_and_comparison_operators
+        ) == true
+      ) {
+        stageRegs(i).tempVariables := tempVariables
       }
     }
   }
@@ -0,0 +1,159 @@
+/**
+ * @file
+ *   capture.scala
+ * @author
+ *   Sina Karvandi (sina@hyperdbg.org)
+ * @brief
+ *   Data types for the capture buffer (logic analyzer)
+ * @details
+ * @version 0.1
+ * @date
+ *   2024-12-10
+ *
+ * @copyright
+ *   This project is released under the GNU Public License v3.
+ */
+package hwdbg.types
+
+import chisel3._
+import chisel3.util.log2Ceil
+
+import hwdbg.configs._
+
+// -----------------------------------------------------------------------
+
+//
+// Structure in C:
+//
+// typedef struct _HWDBG_CAPTURE_CONFIGURATION
+// {
+//     UINT32 TriggerPin;
+//     UINT32 PreTriggerEntries;
+//     UINT32 PostTriggerEntries;
+//
+// } HWDBG_CAPTURE_CONFIGURATION, *PHWDBG_CAPTURE_CONFIGURATION;
+//
+
+/**
+ * @brief
+ *   The configuration of the capture buffer (received from the debugger)
+ */
+class HwdbgCaptureConfiguration() extends Bundle {
+
+  //
+  // Structure fields
+  //
+  val TriggerPin = UInt(32.W) // 4 bytes
+  val PreTriggerEntries = UInt(32.W) // 4 bytes
+  val PostTriggerEntries = UInt(32.W) // 4 bytes
+
+  //
+  // Number of fields (each field is sent in a separate BRAM word)
+  //
+  object Size {
+
+    val numberOfFields = 3
+  }
+}
+
+// -----------------------------------------------------------------------
+
+//
+// Structure in C:
+//
+// typedef struct _HWDBG_CAPTURE_BUFFER_CHUNK
+// {
+//     UINT32 CaptureState;
+//     UINT32 TriggerLatency;
+//     UINT32 NumberOfEntries;
+//     UINT32 TriggerEntry;
+//     UINT32 FirstEntry;
+//     UINT32 NumberOfEntriesInChunk;
+//
+//     /*
+//
+//     Here the entries of the chunk will be available.
+//
+//         UINT32
+//         Run Length
+//
+//         UINT32
+//         Sample[(NumberOfPins + 31) / 32]
+//
+//     */
+//
+// } HWDBG_CAPTURE_BUFFER_CHUNK, *PHWDBG_CAPTURE_BUFFER_CHUNK;
+//
+
+/**
+ * @brief
+ *   The header of each chunk of the capture buffer (sent to the debugger)
+ */
+class HwdbgCaptureBufferChunk() extends Bundle {
+
+  //
+  // Structure fields
+  //
+  val CaptureState = UInt(32.W) // 4 bytes
+  val TriggerLatency = UInt(32.W) // 4 bytes
+  val NumberOfEntries = UInt(32.W) // 4 bytes
+  val TriggerEntry = UInt(32.W) // 4 bytes
+  val FirstEntry = UInt(32.W) // 4 bytes
+  val NumberOfEntriesInChunk = UInt(32.W) // 4 bytes
+
+  //
+  // Number of fields (each field is sent in a separate BRAM word)
+  //
+  object Size {
+
+    val numberOfFields = 6
+  }
+}
+
+// -----------------------------------------------------------------------
+
+/**
+ * @brief
+ *   Each (run-length encoded) entry of the capture buffer
+ */
+class HwdbgCaptureEntry(
+    instanceInfo: HwdbgInstanceInformation
+) extends Bundle {
+
+  val RunLength = UInt(instanceInfo.captureRunLengthWidth.W) // number of samples with the same value
+  val Sample = UInt(instanceInfo.numberOfPins.W) // the value of pins
+}
+
+// -----------------------------------------------------------------------
+
+/**
+ * @brief
+ *   The status of the capture buffer
+ */
+class HwdbgCaptureStatus(
+    instanceInfo: HwdbgInstanceInformation
+) extends Bundle {
+
+  val captureState = UInt(log2Ceil(HwdbgCaptureStateEnums.maxId).W) // state of the capture (HwdbgCaptureStateEnums)
+  val numberOfEntries = UInt(log2Ceil(instanceInfo.captureBufferDepth + 1).W) // number of entries in the capture window
+  val triggerEntry = UInt(log2Ceil(instanceInfo.captureBufferDepth + 1).W) // index of the trigger entry in the capture window
+}
+
+// -----------------------------------------------------------------------
+
+/**
+ * @brief
+ *   Different states of the capture buffer (SHARED WITH HYPERDBG) (HWDBG_CAPTURE_STATE_ENUMS)
+ * @warning
+ *   Used in HyperDbg
+ */
+object HwdbgCaptureStateEnums extends Enumeration {
+
+  val hwdbgCaptureStateIdle = Value(0)
+  val hwdbgCaptureStateArmed = Value(1)
+  val hwdbgCaptureStateTriggered = Value(2)
+  val hwdbgCaptureStateDone = Value(3)
+
+}
+
+// -----------------------------------------------------------------------
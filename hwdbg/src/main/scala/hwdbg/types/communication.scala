@@ -148,6 +148,8 @@ object HwdbgActionEnums extends Enumeration {
 
   val hwdbgActionSendInstanceInfo = Value(1)
   val hwdbgActionConfigureScriptBuffer = Value(2)
+  val hwdbgActionConfigureCapture = Value(3)
+  val hwdbgActionReadCaptureBuffer = Value(4)
 
 }
 
@@ -163,6 +165,7 @@ object HwdbgResponseEnums extends Enumeration {
 
   val hwdbgResponseSuccessOrErrorMessage = Value(1)
   val hwdbgResponseInstanceInfo = Value(2)
+  val hwdbgResponseCaptureBuffer = Value(3)
 
 }
 
@@ -177,6 +180,7 @@ object HwdbgSuccessOrErrorEnums extends Enumeration {
 
   val hwdbgOperationWasSuccessful = Value(0x7fffffff)
   val hwdbgErrorInvalidPacket = Value(1)
+  val hwdbgErrorInvalidCaptureWindow = Value(2)
 
 }
 
@@ -47,7 +47,7 @@ class Stage(
 
   val targetStage = UInt(
     log2Ceil(
-      instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+      instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
     ).W
   ) // Target stage that needs to be executed for the current pin values (should be passed to the next stage)
 
@@ -63,9 +63,42 @@ class Stage(
 
   val stageIndex = UInt(
     log2Ceil(
-      instanceInfo.maximumNumberOfStages * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+      instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
     ).W
   ) // Target stage index of the current stage (configured with script configuration and remains constant during execution)
 
   val stageEnable = Bool() // Target stage is enabled (configured) or not
+
+  val fusedOperators = Vec(
+    instanceInfo.maximumNumberOfOperatorsPerStage - 1,
+    new StageOperator(debug, instanceInfo)
+  ) // Operators that are fused into this stage after the stage symbol (should NOT be passed to the next stage)
+}
+
+class StageOperator(
+    debug: Boolean = DebuggerConfigurations.ENABLE_DEBUG,
+    instanceInfo: HwdbgInstanceInformation
+) extends Bundle {
+
+  val operatorSymbol = new HwdbgShortSymbol(
+    instanceInfo.scriptVariableLength
+  ) // Interpreted script symbol of the fused operator
+
+  val getOperatorSymbol = Vec(
+    instanceInfo.maximumNumberOfSupportedGetScriptOperators,
+    new HwdbgShortSymbol(instanceInfo.scriptVariableLength)
+  ) // GET symbol operand of the fused operator
+
+  val setOperatorSymbol = Vec(
+    instanceInfo.maximumNumberOfSupportedSetScriptOperators,
+    new HwdbgShortSymbol(instanceInfo.scriptVariableLength)
+  ) // SET symbol operand of the fused operator
+
+  val operatorIndex = UInt(
+    log2Ceil(
+      instanceInfo.maximumNumberOfStages * instanceInfo.maximumNumberOfOperatorsPerStage * (instanceInfo.maximumNumberOfSupportedGetScriptOperators + instanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)
+    ).W
+  ) // Index of the fused operator in the script (same as the stage index of the stage symbol)
+
+  val operatorEnable = Bool() // Fused operator is configured or not (empty operators are not evaluated)
 }
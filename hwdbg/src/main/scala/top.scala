@@ -27,6 +27,9 @@ class DebuggerModule(
     maximumNumberOfStages: Int,
     maximumNumberOfSupportedGetScriptOperators: Int,
     maximumNumberOfSupportedSetScriptOperators: Int,
+    maximumNumberOfOperatorsPerStage: Int,
+    captureBufferDepth: Int,
+    captureRunLengthWidth: Int,
     sharedMemorySize: Int,
     debuggerAreaOffset: Int,
     debuggeeAreaOffset: Int,
@@ -77,6 +80,9 @@ class DebuggerModule(
       maximumNumberOfStages,
       maximumNumberOfSupportedGetScriptOperators,
       maximumNumberOfSupportedSetScriptOperators,
+      maximumNumberOfOperatorsPerStage,
+      captureBufferDepth,
+      captureRunLengthWidth,
       sharedMemorySize,
       debuggerAreaOffset,
       debuggeeAreaOffset,
@@ -120,6 +126,9 @@ object Main extends App {
         ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_STAGES,
         ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_GET_SCRIPT_OPERATORS,
         ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_SUPPORTED_SET_SCRIPT_OPERATORS,
+        ScriptEngineConfigurations.MAXIMUM_NUMBER_OF_OPERATORS_PER_STAGE,
+        CaptureConfigurations.CAPTURE_BUFFER_DEPTH,
+        CaptureConfigurations.CAPTURE_RUN_LENGTH_WIDTH,
         MemoryCommunicationConfigurations.DEFAULT_CONFIGURATION_INITIALIZED_MEMORY_SIZE,
         MemoryCommunicationConfigurations.BASE_ADDRESS_OF_PS_TO_PL_COMMUNICATION,
         MemoryCommunicationConfigurations.BASE_ADDRESS_OF_PL_TO_PS_COMMUNICATION,
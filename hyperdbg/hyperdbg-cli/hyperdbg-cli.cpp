@@ -54,10 +54,10 @@ main(int argc, char * argv[])
         //
         // User-passed arguments to the debugger
         //
-        if (!strcmp(argv[1], "--script"))
+        if (!strcmp(argv[1], "--script") || !strcmp(argv[1], "--batch-script"))
         {
             //
-            // Handle the script
+            // Handle the script (or the batch script)
             //
             hyperdbg_u_script_read_file_and_execute_commandline(argc, argv);
         }
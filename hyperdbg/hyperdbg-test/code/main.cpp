@@ -43,6 +43,34 @@ main(int argc, char * argv[])
             printf("\n[x] The main command parser test cases failed\n");
         }
     }
+    else if (!strcmp(argv[1], TEST_CASE_PARAMETER_FOR_COMMAND_PARSER_PERFORMANCE))
+    {
+        //
+        // Measuring the performance of the command parser
+        //
+        if (TestCommandParserPerformance())
+        {
+            printf("\n[*] The performance of the main command parser is measured successfully\n");
+        }
+        else
+        {
+            printf("\n[x] Unable to measure the performance of the main command parser\n");
+        }
+    }
+    else if (!strcmp(argv[1], TEST_CASE_PARAMETER_FOR_SCRIPT_BATCH_PERFORMANCE))
+    {
+        //
+        // Measuring the performance of batch scripts
+        //
+        if (TestScriptBatchPerformance())
+        {
+            printf("\n[*] The performance of batch scripts is measured successfully\n");
+        }
+        else
+        {
+            printf("\n[x] Unable to measure the performance of batch scripts\n");
+        }
+    }
     else if (!strcmp(argv[1], TEST_CASE_PARAMETER_FOR_SCRIPT_SEMANTIC_TEST_CASES))
     {
         //
@@ -378,3 +378,85 @@ TestCommandParser()
 
     return overallResult;
 }
+
+/**
+ * @brief Measure the performance of the command parser
+ * @details All the test cases are tokenized and dispatched for a number of
+ * iterations, once without and once with converting the tokens to strings
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TestCommandParserPerformance()
+{
+    CHAR          filePath[MAX_PATH] = {0};
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER end;
+    UINT64        totalBytes  = 0;
+    UINT64        totalTokens = 0;
+
+    //
+    // Setup the path for the filename
+    //
+    if (!hyperdbg_u_setup_path_for_filename(COMMAND_PARSER_TEST_CASES_FILE, filePath, MAX_PATH, TRUE))
+    {
+        //
+        // Error could not find the test case files
+        //
+        cout << "[-] Could not find the test case files" << endl;
+        return FALSE;
+    }
+
+    //
+    // Parse the test cases from the file
+    //
+    auto testCases = parseTestCases(filePath);
+
+    if (testCases.empty())
+    {
+        cout << "[-] No test cases found" << endl;
+        return FALSE;
+    }
+
+    QueryPerformanceFrequency(&frequency);
+
+    //
+    // Warm up (also initializes the commands and the dispatch table)
+    //
+    for (const auto & testCase : testCases)
+    {
+        totalBytes  += testCase.first.size();
+        totalTokens += hyperdbg_u_test_command_parser_performance((CHAR *)testCase.first.c_str(), 1, TRUE);
+    }
+
+    cout << "Measuring the performance of the command parser (" << testCases.size() << " commands, "
+         << totalBytes << " bytes, " << totalTokens << " tokens, "
+         << COMMAND_PARSER_PERFORMANCE_ITERATIONS << " iterations):" << endl;
+
+    for (UINT32 pass = 0; pass < 2; pass++)
+    {
+        BOOLEAN convertTokens = pass != 0;
+
+        QueryPerformanceCounter(&start);
+
+        for (const auto & testCase : testCases)
+        {
+            hyperdbg_u_test_command_parser_performance((CHAR *)testCase.first.c_str(),
+                                                       COMMAND_PARSER_PERFORMANCE_ITERATIONS,
+                                                       convertTokens);
+        }
+
+        QueryPerformanceCounter(&end);
+
+        double elapsedNs   = (double)(end.QuadPart - start.QuadPart) * 1000000000.0 / (double)frequency.QuadPart;
+        double numCommands = (double)testCases.size() * COMMAND_PARSER_PERFORMANCE_ITERATIONS;
+
+        cout << (convertTokens ? "[+] Tokenize, dispatch and convert: " : "[+] Tokenize and dispatch: ")
+             << fixed << setprecision(1) << elapsedNs / numCommands << " ns/command, "
+             << elapsedNs / (numCommands * totalBytes / testCases.size()) << " ns/byte, "
+             << setprecision(0) << numCommands * 1000000000.0 / elapsedNs << " commands/s" << endl;
+    }
+
+    return TRUE;
+}
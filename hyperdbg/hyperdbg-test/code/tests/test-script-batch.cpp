@@ -0,0 +1,372 @@
+/**
+ * @file test-script-batch.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Measure the performance of batch scripts using a simulated remote debuggee
+ * @details The simulated debuggee doesn't execute the commands (dry-run), it
+ * only sends the end of the results of each command after a fixed latency
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+static SOCKET             g_SimulatedDebuggeeListenSocket = INVALID_SOCKET;
+static SOCKET             g_SimulatedDebuggeeSocket       = INVALID_SOCKET;
+static HANDLE             g_SimulatedDebuggeeCommandReceived;
+static CRITICAL_SECTION   g_SimulatedDebuggeeLock;
+static std::deque<UINT64> g_SimulatedDebuggeeDeadlines;
+static volatile LONG      g_SimulatedDebuggeeNumberOfCommands;
+static LARGE_INTEGER      g_SimulatedDebuggeeFrequency;
+
+/**
+ * @brief Get the current time in microseconds
+ *
+ * @return UINT64
+ */
+static UINT64
+TestScriptBatchGetTime()
+{
+    LARGE_INTEGER Counter;
+
+    QueryPerformanceCounter(&Counter);
+
+    return (UINT64)(Counter.QuadPart * 1000000 / g_SimulatedDebuggeeFrequency.QuadPart);
+}
+
+/**
+ * @brief Ignore the messages of the debugger while measuring
+ *
+ * @param Text
+ *
+ * @return int
+ */
+static int
+TestScriptBatchIgnoreMessages(const char * Text)
+{
+    UNREFERENCED_PARAMETER(Text);
+
+    return 0;
+}
+
+/**
+ * @brief Receive the commands of the debugger (simulated debuggee)
+ * @details Each command is terminated by a null character, the results
+ * of each command are sent after the latency of the simulated debuggee
+ *
+ * @param lpParam
+ *
+ * @return DWORD
+ */
+static DWORD WINAPI
+TestScriptBatchSimulatedDebuggeeReceiver(LPVOID lpParam)
+{
+    CHAR RecvBuf[0x1000];
+    int  Length;
+
+    UNREFERENCED_PARAMETER(lpParam);
+
+    g_SimulatedDebuggeeSocket = accept(g_SimulatedDebuggeeListenSocket, NULL, NULL);
+
+    if (g_SimulatedDebuggeeSocket == INVALID_SOCKET)
+    {
+        return 1;
+    }
+
+    //
+    // Handshake, the build signature is not checked
+    //
+    if (recv(g_SimulatedDebuggeeSocket, RecvBuf, sizeof(RecvBuf), 0) <= 0 ||
+        send(g_SimulatedDebuggeeSocket, "OK", 3, 0) == SOCKET_ERROR)
+    {
+        return 1;
+    }
+
+    while ((Length = recv(g_SimulatedDebuggeeSocket, RecvBuf, sizeof(RecvBuf), 0)) > 0)
+    {
+        for (int i = 0; i < Length; i++)
+        {
+            if (RecvBuf[i] != '\0')
+            {
+                continue;
+            }
+
+            EnterCriticalSection(&g_SimulatedDebuggeeLock);
+            g_SimulatedDebuggeeDeadlines.push_back(TestScriptBatchGetTime() + SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_LATENCY);
+            LeaveCriticalSection(&g_SimulatedDebuggeeLock);
+
+            InterlockedIncrement(&g_SimulatedDebuggeeNumberOfCommands);
+            ReleaseSemaphore(g_SimulatedDebuggeeCommandReceived, 1, NULL);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Send the results of the commands to the debugger (simulated debuggee)
+ * @details The commands are handled in order, the results of each command
+ * are sent once its deadline is reached
+ *
+ * @param lpParam
+ *
+ * @return DWORD
+ */
+static DWORD WINAPI
+TestScriptBatchSimulatedDebuggeeResponder(LPVOID lpParam)
+{
+    const CHAR Results[] = {'o', 'k', '\n', TCP_END_OF_BUFFER_CHAR_1, TCP_END_OF_BUFFER_CHAR_2, TCP_END_OF_BUFFER_CHAR_3, TCP_END_OF_BUFFER_CHAR_4};
+    UINT64     Deadline;
+    UINT64     CurrentTime;
+
+    UNREFERENCED_PARAMETER(lpParam);
+
+    while (WaitForSingleObject(g_SimulatedDebuggeeCommandReceived, INFINITE) == WAIT_OBJECT_0)
+    {
+        EnterCriticalSection(&g_SimulatedDebuggeeLock);
+
+        if (g_SimulatedDebuggeeDeadlines.empty())
+        {
+            //
+            // The simulated debuggee is stopped
+            //
+            LeaveCriticalSection(&g_SimulatedDebuggeeLock);
+            break;
+        }
+
+        Deadline = g_SimulatedDebuggeeDeadlines.front();
+        g_SimulatedDebuggeeDeadlines.pop_front();
+
+        LeaveCriticalSection(&g_SimulatedDebuggeeLock);
+
+        //
+        // Wait for the latency of the command
+        //
+        while ((CurrentTime = TestScriptBatchGetTime()) < Deadline)
+        {
+            Sleep((DWORD)((Deadline - CurrentTime + 999) / 1000));
+        }
+
+        if (send(g_SimulatedDebuggeeSocket, Results, sizeof(Results), 0) == SOCKET_ERROR)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Start the simulated debuggee
+ *
+ * @param ReceiverThread
+ * @param ResponderThread
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestScriptBatchStartSimulatedDebuggee(HANDLE * ReceiverThread, HANDLE * ResponderThread)
+{
+    WSADATA     WsaData;
+    ADDRINFOA   Hints  = {0};
+    ADDRINFOA * Result = NULL;
+
+    if (WSAStartup(MAKEWORD(2, 2), &WsaData) != 0)
+    {
+        return FALSE;
+    }
+
+    Hints.ai_family   = AF_INET;
+    Hints.ai_socktype = SOCK_STREAM;
+    Hints.ai_protocol = IPPROTO_TCP;
+    Hints.ai_flags    = AI_PASSIVE;
+
+    if (getaddrinfo(SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_IP, SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_PORT, &Hints, &Result) != 0)
+    {
+        WSACleanup();
+        return FALSE;
+    }
+
+    g_SimulatedDebuggeeListenSocket = socket(Result->ai_family, Result->ai_socktype, Result->ai_protocol);
+
+    if (g_SimulatedDebuggeeListenSocket == INVALID_SOCKET ||
+        bind(g_SimulatedDebuggeeListenSocket, Result->ai_addr, (int)Result->ai_addrlen) == SOCKET_ERROR ||
+        listen(g_SimulatedDebuggeeListenSocket, 1) == SOCKET_ERROR)
+    {
+        freeaddrinfo(Result);
+        closesocket(g_SimulatedDebuggeeListenSocket);
+        WSACleanup();
+        return FALSE;
+    }
+
+    freeaddrinfo(Result);
+
+    QueryPerformanceFrequency(&g_SimulatedDebuggeeFrequency);
+    InitializeCriticalSection(&g_SimulatedDebuggeeLock);
+
+    g_SimulatedDebuggeeCommandReceived = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+
+    *ReceiverThread  = CreateThread(NULL, 0, TestScriptBatchSimulatedDebuggeeReceiver, NULL, 0, NULL);
+    *ResponderThread = CreateThread(NULL, 0, TestScriptBatchSimulatedDebuggeeResponder, NULL, 0, NULL);
+
+    return TRUE;
+}
+
+/**
+ * @brief Stop the simulated debuggee
+ *
+ * @param ReceiverThread
+ * @param ResponderThread
+ *
+ * @return VOID
+ */
+static VOID
+TestScriptBatchStopSimulatedDebuggee(HANDLE ReceiverThread, HANDLE ResponderThread)
+{
+    //
+    // Closing the sockets stops the receiver and an empty queue stops
+    // the responder
+    //
+    closesocket(g_SimulatedDebuggeeListenSocket);
+    closesocket(g_SimulatedDebuggeeSocket);
+
+    WaitForSingleObject(ReceiverThread, INFINITE);
+
+    EnterCriticalSection(&g_SimulatedDebuggeeLock);
+    g_SimulatedDebuggeeDeadlines.clear();
+    LeaveCriticalSection(&g_SimulatedDebuggeeLock);
+
+    ReleaseSemaphore(g_SimulatedDebuggeeCommandReceived, 1, NULL);
+    WaitForSingleObject(ResponderThread, INFINITE);
+
+    CloseHandle(ReceiverThread);
+    CloseHandle(ResponderThread);
+    CloseHandle(g_SimulatedDebuggeeCommandReceived);
+    DeleteCriticalSection(&g_SimulatedDebuggeeLock);
+
+    WSACleanup();
+}
+
+/**
+ * @brief Create a setup script that registers events and queries the debuggee
+ *
+ * @param ScriptPath
+ *
+ * @return UINT32 number of commands
+ */
+static UINT32
+TestScriptBatchCreateScript(const std::string & ScriptPath)
+{
+    std::ofstream File(ScriptPath);
+    UINT32        NumberOfCommands = 0;
+
+    for (UINT32 i = 0; i < SCRIPT_BATCH_TEST_NUMBER_OF_EVENTS; i++)
+    {
+        //
+        // Events and queries are independent, and 'lm' is a dependent command
+        //
+        File << "!syscall 0x" << hex << i << " script { printf(\"syscall %llx\\n\", @rax); }" << endl;
+        File << "db fffff80000000000+0x" << hex << i * 0x100 << endl;
+        File << "r rax" << endl;
+        NumberOfCommands += 3;
+
+        if (i % 50 == 49)
+        {
+            File << "lm" << endl;
+            NumberOfCommands++;
+        }
+    }
+
+    File.close();
+
+    return NumberOfCommands;
+}
+
+/**
+ * @brief Measure the performance of batch scripts using a simulated debuggee
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TestScriptBatchPerformance()
+{
+    HANDLE      receiverThread;
+    HANDLE      responderThread;
+    CHAR        tempPath[MAX_PATH] = {0};
+    BOOLEAN     overallResult      = TRUE;
+    UINT32      numberOfCommands;
+    UINT64      start;
+    UINT64      elapsed[2];
+    std::string scriptPath;
+    std::string command;
+
+    if (!GetTempPathA(MAX_PATH, tempPath))
+    {
+        cout << "[-] Could not get the temp path" << endl;
+        return FALSE;
+    }
+
+    scriptPath       = std::string(tempPath) + SCRIPT_BATCH_TEST_SCRIPT_FILE;
+    numberOfCommands = TestScriptBatchCreateScript(scriptPath);
+
+    if (!TestScriptBatchStartSimulatedDebuggee(&receiverThread, &responderThread))
+    {
+        cout << "[-] Could not start the simulated debuggee" << endl;
+        return FALSE;
+    }
+
+    if (!hyperdbg_u_connect_remote_debugger(SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_IP, SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_PORT))
+    {
+        cout << "[-] Could not connect to the simulated debuggee" << endl;
+        TestScriptBatchStopSimulatedDebuggee(receiverThread, responderThread);
+        return FALSE;
+    }
+
+    cout << "Running " << numberOfCommands << " commands against a simulated debuggee ("
+         << SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_LATENCY << " us latency):" << endl;
+
+    //
+    // Run the script once normally and once as a batch script
+    //
+    for (UINT32 pass = 0; pass < 2; pass++)
+    {
+        command = (pass == 0 ? ".script \"" : ".script batch \"") + scriptPath + "\"";
+
+        g_SimulatedDebuggeeNumberOfCommands = 0;
+
+        hyperdbg_u_set_text_message_callback((PVOID)TestScriptBatchIgnoreMessages);
+
+        start = TestScriptBatchGetTime();
+        hyperdbg_u_run_command((CHAR *)command.c_str());
+        elapsed[pass] = TestScriptBatchGetTime() - start;
+
+        hyperdbg_u_unset_text_message_callback();
+
+        if ((UINT32)g_SimulatedDebuggeeNumberOfCommands != numberOfCommands)
+        {
+            cout << "[-] The simulated debuggee received " << g_SimulatedDebuggeeNumberOfCommands
+                 << " commands instead of " << numberOfCommands << endl;
+            overallResult = FALSE;
+        }
+
+        cout << (pass == 0 ? "[+] Script: " : "[+] Batch script: ") << dec << elapsed[pass] / 1000 << " ms, "
+             << fixed << setprecision(1) << (double)elapsed[pass] / numberOfCommands << " us/command" << endl;
+    }
+
+    if (elapsed[1] != 0)
+    {
+        cout << "[+] Speedup: " << fixed << setprecision(1) << (double)elapsed[0] / (double)elapsed[1] << "x" << endl;
+    }
+
+    hyperdbg_u_run_command((CHAR *)".disconnect");
+
+    TestScriptBatchStopSimulatedDebuggee(receiverThread, responderThread);
+
+    DeleteFileA(scriptPath.c_str());
+
+    return overallResult;
+}
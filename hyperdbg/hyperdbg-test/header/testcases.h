@@ -18,5 +18,11 @@
 BOOLEAN
 TestCommandParser();
 
+BOOLEAN
+TestCommandParserPerformance();
+
 BOOLEAN
 TestSemanticScripts();
+
+BOOLEAN
+TestScriptBatchPerformance();
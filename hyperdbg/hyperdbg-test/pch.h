@@ -24,6 +24,8 @@ using namespace std;
 //
 // General Headers
 //
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <Windows.h>
 #include <iostream>
 #include <string>
@@ -34,6 +36,9 @@ using namespace std;
 #include <iomanip>
 #include <fstream>
 #include <filesystem>
+#include <deque>
+
+#pragma comment(lib, "Ws2_32.lib")
 
 //
 // Program Defined Headers
@@ -536,3 +536,47 @@ BroadcastDisablePmlOnAllProcessors()
 {
     KeGenericCallDpc(DpcRoutineDisablePml, 0x0);
 }
+
+/**
+ * @brief routines for flushing the PML buffers of all cores
+ *
+ * @return VOID
+ */
+VOID
+BroadcastFlushPmlBuffersOnAllProcessors()
+{
+    KeGenericCallDpc(DpcRoutineFlushPmlBuffer, 0x0);
+}
+
+/**
+ * @brief routines for write-protecting the pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+BroadcastSnapshotProtectPagesOnAllProcessors()
+{
+    KeGenericCallDpc(DpcRoutineSnapshotProtectPages, 0x0);
+}
+
+/**
+ * @brief routines for removing the write protection of the pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+BroadcastSnapshotUnprotectPagesOnAllProcessors()
+{
+    KeGenericCallDpc(DpcRoutineSnapshotUnprotectPages, 0x0);
+}
+
+/**
+ * @brief routines for restoring the modified pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+BroadcastSnapshotRestorePagesOnAllProcessors()
+{
+    KeGenericCallDpc(DpcRoutineSnapshotRestorePages, 0x0);
+}
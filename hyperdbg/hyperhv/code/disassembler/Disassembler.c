@@ -215,6 +215,8 @@ DisassemblerShowOneInstructionInVmxNonRootMode(PVOID Address, UINT64 ActualRip,
  * @brief Disassembler length disassemble engine
  * @details if you want to call it directly, shouldn't not be in VMX-root mode, otherwise, you can
  * call DisassemblerLengthDisassembleEngineInVmxRootOnTargetProcess to access memory safely
+ * the length is computed by the table-driven length decoder and Zydis is only used for the
+ * instructions that are rejected by it
  *
  * @param Address
  * @param Is32Bit
@@ -228,6 +230,18 @@ DisassemblerLengthDisassembleEngine(PVOID Address, BOOLEAN Is32Bit)
     ZydisDecodedInstruction Instruction;
     ZydisDecodedOperand     Operands[ZYDIS_MAX_OPERAND_COUNT];
     ZyanStatus              Status;
+    UINT32                  Length;
+
+    //
+    // Use the table-driven length decoder first, the full disassembler is only
+    // used for the instructions that are not recognized by it
+    //
+    Length = LengthDisassemblerGetInstructionLength(Address, MAXIMUM_INSTR_SIZE, Is32Bit);
+
+    if (Length != NULL_ZERO)
+    {
+        return Length;
+    }
 
     if (ZydisGetVersion() != ZYDIS_VERSION)
     {
@@ -315,6 +329,39 @@ DisassemblerLengthDisassembleEngineInVmxRootOnTargetProcess(PVOID Address, BOOLE
     return DisassemblerLengthDisassembleEngine(SafeMemoryToRead, Is32Bit);
 }
 
+/**
+ * @brief Check whether the instruction is a 'call' or a 'ret'
+ * @details Should be called in VMX-root mode
+ *
+ * @param Address
+ * @param Is32Bit
+ * @param IsRet Whether the instruction is a 'ret' (if return value is TRUE)
+ * @param Length Length of the instruction (if return value is TRUE)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+DisassemblerCheckCallOrRetInVmxRootOnTargetProcess(PVOID Address, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length)
+{
+    BYTE   SafeMemoryToRead[MAXIMUM_INSTR_SIZE] = {0};
+    UINT64 SizeOfSafeBufferToRead               = 0;
+
+    //
+    // Read the maximum number of instruction that is valid to be read in the
+    // target address
+    //
+    SizeOfSafeBufferToRead = CheckAddressMaximumInstructionLength(Address);
+
+    if (!MemoryMapperReadMemorySafeOnTargetProcess((UINT64)Address,
+                                                   SafeMemoryToRead,
+                                                   SizeOfSafeBufferToRead))
+    {
+        return FALSE;
+    }
+
+    return LengthDisassemblerCheckCallOrRet(SafeMemoryToRead, (UINT32)SizeOfSafeBufferToRead, Is32Bit, IsRet, Length);
+}
+
 /**
  * @brief Shows the disassembly of only one instruction
  * @details Should be called in VMX-root mode
@@ -0,0 +1,1013 @@
+/**
+ * @file LengthDisassembler.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Table-driven instruction length decoder
+ * @details This decoder only computes the length of x86/x64 instructions
+ * (legacy and REX encodings) without decoding the operands, it doesn't
+ * allocate and only uses a few bytes of the stack so it's safe to be used in
+ * VMX-root mode. VEX, EVEX, XOP and 3DNow! encodings and the opcodes that
+ * the tables are not sure about return zero, so the callers can fall back to
+ * Zydis
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Short names for the attributes of the opcode tables
+//
+#define __  0
+#define MR  LENGTH_DISASSEMBLER_MODRM
+#define I8  LENGTH_DISASSEMBLER_IMM8
+#define I16 LENGTH_DISASSEMBLER_IMM16
+#define IZ  LENGTH_DISASSEMBLER_IMMZ
+#define IV  LENGTH_DISASSEMBLER_IMMV
+#define MO  LENGTH_DISASSEMBLER_MOFFS
+#define RZ  LENGTH_DISASSEMBLER_REL
+#define SP  LENGTH_DISASSEMBLER_SPECIAL
+#define XX  LENGTH_DISASSEMBLER_INVALID
+#define MI8 (LENGTH_DISASSEMBLER_MODRM | LENGTH_DISASSEMBLER_IMM8)
+#define MIZ (LENGTH_DISASSEMBLER_MODRM | LENGTH_DISASSEMBLER_IMMZ)
+#define ENT (LENGTH_DISASSEMBLER_IMM16 | LENGTH_DISASSEMBLER_IMM8)
+
+/**
+ * @brief Attributes of the one-byte opcode map
+ * @details Prefixes are consumed before looking up this table, salc (D6) is
+ * left to the full disassembler
+ *
+ */
+static const BYTE g_LengthDisassemblerOneByteMap[256] = {
+    /*       0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F   */
+    /* 0 */ MR, MR, MR, MR, I8, IZ, __, __, MR, MR, MR, MR, I8, IZ, __, SP,
+    /* 1 */ MR, MR, MR, MR, I8, IZ, __, __, MR, MR, MR, MR, I8, IZ, __, __,
+    /* 2 */ MR, MR, MR, MR, I8, IZ, __, __, MR, MR, MR, MR, I8, IZ, __, __,
+    /* 3 */ MR, MR, MR, MR, I8, IZ, __, __, MR, MR, MR, MR, I8, IZ, __, __,
+    /* 4 */ __, __, __, __, __, __, __, __, __, __, __, __, __, __, __, __,
+    /* 5 */ __, __, __, __, __, __, __, __, __, __, __, __, __, __, __, __,
+    /* 6 */ __, __, SP, MR, __, __, __, __, IZ, MIZ, I8, MI8, __, __, __, __,
+    /* 7 */ I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8, I8,
+    /* 8 */ MI8, MIZ, MI8, MI8, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, SP,
+    /* 9 */ __, __, __, __, __, __, __, __, __, __, SP, __, __, __, __, __,
+    /* A */ MO, MO, MO, MO, __, __, __, __, I8, IZ, __, __, __, __, __, __,
+    /* B */ I8, I8, I8, I8, I8, I8, I8, I8, IV, IV, IV, IV, IV, IV, IV, IV,
+    /* C */ MI8, MI8, I16, __, SP, SP, MI8, MIZ, ENT, __, I16, __, __, I8, __, __,
+    /* D */ MR, MR, MR, MR, I8, I8, XX, __, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* E */ I8, I8, I8, I8, I8, I8, I8, I8, RZ, RZ, SP, I8, __, __, __, __,
+    /* F */ __, __, __, __, __, __, SP, SP, __, __, __, __, __, __, MR, MR,
+};
+
+/**
+ * @brief Attributes of the two-byte (0F) opcode map
+ * @details The validity of the opcodes is checked by the bitmaps below
+ *
+ */
+static const BYTE g_LengthDisassemblerTwoByteMap[256] = {
+    /*       0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F   */
+    /* 0 */ MR, MR, MR, MR, XX, __, __, __, __, __, XX, __, XX, MR, __, MI8,
+    /* 1 */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* 2 */ SP, SP, SP, SP, XX, XX, XX, XX, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* 3 */ __, __, __, __, __, __, XX, __, SP, XX, SP, XX, XX, XX, XX, XX,
+    /* 4 */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* 5 */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* 6 */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* 7 */ MI8, MI8, MI8, MI8, MR, MR, MR, __, SP, MR, XX, XX, MR, MR, MR, MR,
+    /* 8 */ RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ,
+    /* 9 */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* A */ __, __, __, MR, MI8, MR, XX, XX, __, __, __, MR, MI8, MR, MR, MR,
+    /* B */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MI8, MR, MR, MR, MR, MR,
+    /* C */ MR, MR, MI8, MR, MI8, MI8, MI8, MR, __, __, __, __, __, __, __, __,
+    /* D */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* E */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+    /* F */ MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR, MR,
+};
+
+#undef __
+#undef MR
+#undef I8
+#undef I16
+#undef IZ
+#undef IV
+#undef MO
+#undef RZ
+#undef SP
+#undef XX
+#undef MI8
+#undef MIZ
+#undef ENT
+
+/**
+ * @brief Bitmap of the one-byte opcodes that are invalid in 64-bit mode
+ * @details 06, 07, 0E, 16, 17, 1E, 1F, 27, 2F, 37, 3F, 60, 61, 82, 9A, CE,
+ * D4, D5, D6 and EA
+ *
+ */
+static const UINT32 g_LengthDisassemblerInvalidIn64BitMode[8] = {
+    0xc0c040c0, // 00 - 1F
+    0x80808080, // 20 - 3F
+    0x00000000, // 40 - 5F
+    0x00000003, // 60 - 7F
+    0x04000004, // 80 - 9F
+    0x00000000, // A0 - BF
+    0x00704000, // C0 - DF
+    0x00000400, // E0 - FF
+};
+
+/**
+ * @brief Bitmaps of the escaped opcodes (0F, 0F 38 and 0F 3A) that are valid
+ * with a memory operand (or that don't have a ModR/M byte)
+ * @details Indexed by the map and the mandatory prefix (none, 66, F3, F2),
+ * the opcodes that are not set here (including the groups that are not
+ * checked separately) are left to the full disassembler
+ *
+ */
+static const UINT32 g_LengthDisassemblerValidWithMemory[3][4][8] = {
+    {
+        {0xf3ff6bec, 0x00bfff0f, 0xfffeffff, 0xc3f1cfff, 0xffffffff, 0xfaffbf3f, 0xff3eff5f, 0xff7effbf}, // 0F, no prefix
+        {0xf3ff69ec, 0x00bfff0f, 0xfff2ffff, 0xf071ffff, 0xffffffff, 0xfaffbf3f, 0xff7fff57, 0xff7effff}, // 0F, 66
+        {0xf3476bec, 0x00bf3c0f, 0xff0effff, 0xc0018000, 0xffffffff, 0xfbffbf3f, 0x0000ff07, 0x80000040}, // 0F, F3
+        {0xf30769ec, 0x00bf3c0f, 0xf702ffff, 0x30010000, 0xffffffff, 0xcaffbf3f, 0x0001ff07, 0x80010040}, // 0F, F2
+    },
+    {
+        {0x70000fff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003f00, 0x00030000}, // 0F 38, no prefix
+        {0x70b10fff, 0xffbf0f3f, 0x00000003, 0x00000000, 0x00000007, 0x00000000, 0xf8008000, 0x00030000}, // 0F 38, 66
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 38, F3
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 38, F2
+    },
+    {
+        {0x00008000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001000, 0x00000000}, // 0F 3A, no prefix
+        {0x00f0ff00, 0x00000007, 0x00000017, 0x0000000f, 0x00000000, 0x00000000, 0x8000c000, 0x00000000}, // 0F 3A, 66
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 3A, F3
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 3A, F2
+    },
+};
+
+/**
+ * @brief Bitmaps of the escaped opcodes (0F, 0F 38 and 0F 3A) that are valid
+ * with a register operand (mod == 3)
+ *
+ */
+static const UINT32 g_LengthDisassemblerValidWithRegister[3][4][8] = {
+    {
+        {0xf3774bec, 0x00bff70f, 0xffffffff, 0xc3f1cfff, 0xffffffff, 0xfacbbf3f, 0xffbeff77, 0xfffeff3f}, // 0F, no prefix
+        {0xf33349ec, 0x00bff70f, 0xfff3ffff, 0xf271ffff, 0xffffffff, 0xfacbbf3f, 0xffffff77, 0xfffeff7f}, // 0F, 66
+        {0xf3474bec, 0x00bf340f, 0xff0effff, 0xc0018000, 0xffffffff, 0xfbcbbf3f, 0x00c0ff07, 0x80000040}, // 0F, F3
+        {0xf30749ec, 0x00bf340f, 0xf702ffff, 0x33010000, 0xffffffff, 0xcacbbf3f, 0x00c1ff07, 0x80000040}, // 0F, F2
+    },
+    {
+        {0x70000fff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003f00, 0x00000000}, // 0F 38, no prefix
+        {0x70b10fff, 0xffbf0b3f, 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0xf8008000, 0x00000000}, // 0F 38, 66
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 38, F3
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 38, F2
+    },
+    {
+        {0x00008000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00001000, 0x00000000}, // 0F 3A, no prefix
+        {0x00f0ff00, 0x00000007, 0x00000017, 0x0000000f, 0x00000000, 0x00000000, 0x8000c000, 0x00000000}, // 0F 3A, 66
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 3A, F3
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // 0F 3A, F2
+    },
+};
+
+/**
+ * @brief The reg fields of the x87 opcodes (D8 - DF) that are valid with a
+ * memory operand
+ *
+ */
+static const BYTE g_LengthDisassemblerX87ValidWithMemory[8] = {
+    0xff, // D8
+    0xfd, // D9
+    0xff, // DA
+    0xaf, // DB
+    0xff, // DC
+    0xdf, // DD
+    0xff, // DE
+    0xff, // DF
+};
+
+/**
+ * @brief The reg fields of the x87 opcodes (D8 - DF) that are valid with all
+ * the register operands
+ * @details A few other register forms are valid with a single ModR/M and are
+ * checked separately
+ *
+ */
+static const BYTE g_LengthDisassemblerX87ValidWithRegister[8] = {
+    0xff, // D8
+    0xc3, // D9
+    0x0f, // DA
+    0x6f, // DB
+    0xf3, // DC
+    0x3d, // DD
+    0xf3, // DE
+    0x61, // DF
+};
+
+/**
+ * @brief Check whether the ModR/M of a one-byte opcode is valid
+ *
+ * @param Opcode
+ * @param ModRm Zero if the opcode doesn't have a ModR/M byte
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+LengthDisassemblerIsValidOneByteOpcode(BYTE Opcode, BYTE ModRm)
+{
+    BYTE    Reg      = (ModRm >> 3) & 0x7;
+    BOOLEAN IsMemory = (ModRm >> 6) != 3;
+
+    switch (Opcode)
+    {
+    case 0x8c: // mov r/m, sreg
+        return Reg <= 5;
+
+    case 0x8e: // mov sreg, r/m (cs can't be loaded)
+        return Reg <= 5 && Reg != 1;
+
+    case 0x8d: // lea
+        return IsMemory;
+
+    case 0x8f: // pop r/m (group 1A)
+        return Reg == 0;
+
+    case 0xc0: // shifts (group 2), the /6 alias of shl is left to the full disassembler
+    case 0xc1:
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3:
+        return Reg != 6;
+
+    case 0xc6: // mov r/m, imm (group 11) and xabort/xbegin
+    case 0xc7:
+        return Reg == 0 || ModRm == 0xf8;
+
+    case 0xf6: // group 3, the /1 alias of test is left to the full disassembler
+    case 0xf7:
+        return Reg != 1;
+
+    case 0xfe: // inc, dec (group 4)
+        return Reg <= 1;
+
+    case 0xff: // group 5, far call and far jmp only have memory forms
+        return Reg != 7 && (IsMemory || (Reg != 3 && Reg != 5));
+
+    case 0xd8:
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+    case 0xdc:
+    case 0xdd:
+    case 0xde:
+    case 0xdf:
+        if (IsMemory)
+        {
+            return (g_LengthDisassemblerX87ValidWithMemory[Opcode - 0xd8] & (1 << Reg)) != 0;
+        }
+
+        if (g_LengthDisassemblerX87ValidWithRegister[Opcode - 0xd8] & (1 << Reg))
+        {
+            return TRUE;
+        }
+
+        switch (((UINT32)Opcode << 8) | ModRm)
+        {
+        case 0xd9d0: // fnop
+        case 0xd9e0: // fchs
+        case 0xd9e1: // fabs
+        case 0xd9e4: // ftst
+        case 0xd9e5: // fxam
+        case 0xd9e8: // fld1
+        case 0xd9e9: // fldl2t
+        case 0xd9ea: // fldl2e
+        case 0xd9eb: // fldpi
+        case 0xd9ec: // fldlg2
+        case 0xd9ed: // fldln2
+        case 0xd9ee: // fldz
+        case 0xdae9: // fucompp
+        case 0xdbe2: // fnclex
+        case 0xdbe3: // fninit
+        case 0xded9: // fcompp
+        case 0xdfe0: // fnstsw ax
+            return TRUE;
+        default:
+            return FALSE;
+        }
+
+    default:
+        return TRUE;
+    }
+}
+
+/**
+ * @brief Check whether an opcode of the 0F, 0F 38 or 0F 3A maps is valid
+ *
+ * @param Map 1 for 0F, 2 for 0F 38 and 3 for 0F 3A
+ * @param MandatoryPrefix 0 for none, 1 for 66, 2 for F3 and 3 for F2
+ * @param Opcode
+ * @param ModRm Zero if the opcode doesn't have a ModR/M byte
+ * @param HasRexR
+ * @param Is32Bit
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+LengthDisassemblerIsValidEscapedOpcode(BYTE Map, BYTE MandatoryPrefix, BYTE Opcode, BYTE ModRm, BOOLEAN HasRexR, BOOLEAN Is32Bit)
+{
+    const UINT32 * Bitmap;
+    BYTE           Reg      = (ModRm >> 3) & 0x7;
+    BOOLEAN        IsMemory = (ModRm >> 6) != 3;
+
+    if (Map == 1)
+    {
+        //
+        // Groups that are decided by the reg field (or the whole ModR/M)
+        //
+        switch (Opcode)
+        {
+        case 0x00: // group 6
+            return MandatoryPrefix <= 1 && Reg <= 5;
+
+        case 0x01: // group 7
+            if (MandatoryPrefix != 0)
+            {
+                return FALSE;
+            }
+
+            if (IsMemory)
+            {
+                return Reg != 5;
+            }
+
+            if (Reg == 4 || Reg == 6)
+            {
+                //
+                // smsw and lmsw
+                //
+                return TRUE;
+            }
+
+            switch (ModRm)
+            {
+            case 0xc1: // vmcall
+            case 0xc2: // vmlaunch
+            case 0xc3: // vmresume
+            case 0xc4: // vmxoff
+            case 0xc8: // monitor
+            case 0xc9: // mwait
+            case 0xca: // clac
+            case 0xcb: // stac
+            case 0xd0: // xgetbv
+            case 0xd1: // xsetbv
+            case 0xd4: // vmfunc
+            case 0xd5: // xend
+            case 0xd6: // xtest
+            case 0xf9: // rdtscp
+                return TRUE;
+            case 0xf8: // swapgs
+                return !Is32Bit;
+            default:
+                return FALSE;
+            }
+
+        case 0x20: // mov from/to control registers (only cr0, cr2, cr3, cr4 and cr8)
+        case 0x22:
+            Reg |= HasRexR ? 8 : 0;
+            return MandatoryPrefix == 0 && (Reg == 0 || Reg == 2 || Reg == 3 || Reg == 4 || Reg == 8);
+
+        case 0x21: // mov from/to debug registers
+        case 0x23:
+            return MandatoryPrefix == 0 && !HasRexR;
+
+        case 0x71: // groups 12 and 13
+        case 0x72:
+            return MandatoryPrefix <= 1 && !IsMemory && (Reg == 2 || Reg == 4 || Reg == 6);
+
+        case 0x73: // group 14
+            return MandatoryPrefix <= 1 && !IsMemory && (Reg == 2 || Reg == 6 || (MandatoryPrefix == 1 && (Reg == 3 || Reg == 7)));
+
+        case 0xae: // group 15, only lfence, mfence and sfence have register forms
+            return MandatoryPrefix == 0 && (IsMemory || ModRm == 0xe8 || ModRm == 0xf0 || ModRm == 0xf8);
+
+        case 0xba: // group 8
+            return MandatoryPrefix <= 1 && Reg >= 4;
+
+        case 0xc7: // group 9
+            switch (MandatoryPrefix)
+            {
+            case 0:
+                return IsMemory ? (Reg == 1 || Reg >= 3) : Reg >= 6;
+            case 1:
+                return IsMemory && (Reg == 1 || Reg == 6);
+            case 2:
+                return IsMemory ? Reg == 6 : Reg == 7;
+            default:
+                return FALSE;
+            }
+        }
+    }
+
+    Bitmap = IsMemory ? g_LengthDisassemblerValidWithMemory[Map - 1][MandatoryPrefix] : g_LengthDisassemblerValidWithRegister[Map - 1][MandatoryPrefix];
+
+    return (Bitmap[Opcode >> 5] & (1U << (Opcode & 0x1f))) != 0;
+}
+
+/**
+ * @brief Check whether an instruction accepts the lock prefix
+ *
+ * @param Map 0 for the one-byte map, 1 for 0F, 2 for 0F 38 and 3 for 0F 3A
+ * @param Opcode
+ * @param ModRm
+ * @param HasModRm
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+LengthDisassemblerIsLockable(BYTE Map, BYTE Opcode, BYTE ModRm, BOOLEAN HasModRm)
+{
+    BYTE Reg = (ModRm >> 3) & 0x7;
+
+    //
+    // Only the read-modify-write forms with a memory destination are lockable
+    //
+    if (!HasModRm || (ModRm >> 6) == 3)
+    {
+        return FALSE;
+    }
+
+    if (Map == 0)
+    {
+        if (Opcode < 0x38)
+        {
+            //
+            // add, or, adc, sbb, and, sub and xor (r/m, reg)
+            //
+            return (Opcode & 0x6) == 0;
+        }
+
+        switch (Opcode)
+        {
+        case 0x80: // group 1 (except cmp)
+        case 0x81:
+        case 0x82:
+        case 0x83:
+            return Reg != 7;
+        case 0x86: // xchg
+        case 0x87:
+            return TRUE;
+        case 0xf6: // not, neg (group 3)
+        case 0xf7:
+            return Reg == 2 || Reg == 3;
+        case 0xfe: // inc, dec (groups 4 and 5)
+        case 0xff:
+            return Reg <= 1;
+        default:
+            return FALSE;
+        }
+    }
+
+    if (Map == 1)
+    {
+        switch (Opcode)
+        {
+        case 0xab: // bts
+        case 0xb3: // btr
+        case 0xbb: // btc
+        case 0xb0: // cmpxchg
+        case 0xb1:
+        case 0xc0: // xadd
+        case 0xc1:
+            return TRUE;
+        case 0xba: // bts, btr, btc (group 8)
+            return Reg >= 5;
+        case 0xc7: // cmpxchg8b, cmpxchg16b (group 9)
+            return Reg == 1;
+        default:
+            return FALSE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Compute the length of the ModR/M byte, SIB byte and displacement
+ *
+ * @param Buffer
+ * @param Offset Offset of the ModR/M byte
+ * @param MaximumLength
+ * @param Is16BitAddressing
+ * @param IsRegisterForm The mod field is ignored and always treated as a register
+ *
+ * @return UINT32 zero if the bytes could not be read
+ */
+static UINT32
+LengthDisassemblerGetModRmLength(BYTE * Buffer, UINT32 Offset, UINT32 MaximumLength, BOOLEAN Is16BitAddressing, BOOLEAN IsRegisterForm)
+{
+    BYTE   ModRm;
+    BYTE   Mod;
+    BYTE   Rm;
+    UINT32 Length = 1;
+
+    if (Offset >= MaximumLength)
+    {
+        return NULL_ZERO;
+    }
+
+    ModRm = Buffer[Offset];
+    Mod   = ModRm >> 6;
+    Rm    = ModRm & 0x7;
+
+    if (Mod == 3 || IsRegisterForm)
+    {
+        return Length;
+    }
+
+    if (Is16BitAddressing)
+    {
+        //
+        // 16-bit addressing doesn't have the SIB byte
+        //
+        if (Mod == 0 && Rm == 6)
+        {
+            Length += 2;
+        }
+        else if (Mod == 1)
+        {
+            Length += 1;
+        }
+        else if (Mod == 2)
+        {
+            Length += 2;
+        }
+
+        return Length;
+    }
+
+    if (Rm == 4)
+    {
+        //
+        // Read the SIB byte as the base of it might need a displacement
+        //
+        if (Offset + Length >= MaximumLength)
+        {
+            return NULL_ZERO;
+        }
+
+        if (Mod == 0 && (Buffer[Offset + Length] & 0x7) == 5)
+        {
+            Length += 4;
+        }
+
+        Length += 1;
+    }
+    else if (Mod == 0 && Rm == 5)
+    {
+        //
+        // RIP-relative (64-bit) or absolute (32-bit) displacement
+        //
+        Length += 4;
+    }
+
+    if (Mod == 1)
+    {
+        Length += 1;
+    }
+    else if (Mod == 2)
+    {
+        Length += 4;
+    }
+
+    return Length;
+}
+
+/**
+ * @brief Compute the length of an instruction
+ * @details This function doesn't access any memory other than the buffer,
+ * so it can be used in VMX-root mode. Instructions that are invalid (or not
+ * recognized by the tables) return zero and the caller might use a full
+ * disassembler instead, a non-zero length is only returned for the encodings
+ * that are valid
+ *
+ * @param Buffer
+ * @param BufferLength
+ * @param Is32Bit
+ *
+ * @return UINT32 length of the instruction or zero if it's invalid
+ */
+UINT32
+LengthDisassemblerGetInstructionLength(PVOID Buffer, UINT32 BufferLength, BOOLEAN Is32Bit)
+{
+    BYTE *  Bytes             = (BYTE *)Buffer;
+    UINT32  MaximumLength     = BufferLength;
+    UINT32  Offset            = 0;
+    UINT32  ModRmLength       = 0;
+    UINT32  ImmediateSize     = 0;
+    UINT32  OperandSize       = 0;
+    BYTE    Opcode            = 0;
+    BYTE    Flags             = 0;
+    BYTE    Map               = 0;
+    BYTE    MandatoryPrefix   = 0;
+    BYTE    ModRm             = 0;
+    BOOLEAN IsPrefix          = TRUE;
+    BOOLEAN HasOperandSize    = FALSE;
+    BOOLEAN HasAddressSize    = FALSE;
+    BOOLEAN HasRepeat         = FALSE;
+    BOOLEAN HasRepeatNotEqual = FALSE;
+    BOOLEAN HasLock           = FALSE;
+    BOOLEAN HasRex            = FALSE;
+    BOOLEAN HasRexW           = FALSE;
+    BOOLEAN HasRexR           = FALSE;
+    BOOLEAN IsRegisterForm    = FALSE;
+
+    if (MaximumLength > LENGTH_DISASSEMBLER_MAXIMUM_LENGTH)
+    {
+        MaximumLength = LENGTH_DISASSEMBLER_MAXIMUM_LENGTH;
+    }
+
+    //
+    // Consume the legacy and REX prefixes
+    //
+    while (IsPrefix)
+    {
+        if (Offset >= MaximumLength)
+        {
+            return NULL_ZERO;
+        }
+
+        Opcode = Bytes[Offset];
+
+        if (HasRex && (Opcode == 0x66 || Opcode == 0x67 || Opcode == 0xf0 || Opcode == 0xf2 || Opcode == 0xf3 ||
+                       Opcode == 0x26 || Opcode == 0x2e || Opcode == 0x36 || Opcode == 0x3e || Opcode == 0x64 ||
+                       Opcode == 0x65 || (Opcode & 0xf0) == 0x40))
+        {
+            //
+            // A REX prefix that is not right before the opcode is ignored by
+            // the processor, but the disassemblers don't agree on it
+            //
+            return NULL_ZERO;
+        }
+
+        if (!Is32Bit && (Opcode & 0xf0) == 0x40)
+        {
+            //
+            // REX prefix
+            //
+            HasRex  = TRUE;
+            HasRexW = (Opcode & 0x8) != 0;
+            HasRexR = (Opcode & 0x4) != 0;
+            Offset++;
+            continue;
+        }
+
+        switch (Opcode)
+        {
+        case 0x66:
+            HasOperandSize = TRUE;
+            break;
+        case 0x67:
+            HasAddressSize = TRUE;
+            break;
+        case 0xf0:
+            HasLock = TRUE;
+            break;
+        case 0xf2:
+            HasRepeatNotEqual = TRUE;
+            break;
+        case 0xf3:
+            HasRepeat = TRUE;
+            break;
+        case 0x26:
+        case 0x2e:
+        case 0x36:
+        case 0x3e:
+        case 0x64:
+        case 0x65:
+            break;
+        default:
+            IsPrefix = FALSE;
+            break;
+        }
+
+        if (IsPrefix)
+        {
+            Offset++;
+        }
+    }
+
+    Offset++;
+    OperandSize = (HasOperandSize && !HasRexW) ? 2 : 4;
+
+    if (Opcode == 0x0f)
+    {
+        //
+        // Two-byte and three-byte opcode maps
+        //
+        if (Offset >= MaximumLength)
+        {
+            return NULL_ZERO;
+        }
+
+        Opcode = Bytes[Offset++];
+
+        if (Opcode == 0x38 || Opcode == 0x3a)
+        {
+            Map   = (Opcode == 0x38) ? 2 : 3;
+            Flags = (Opcode == 0x38) ? LENGTH_DISASSEMBLER_MODRM : (LENGTH_DISASSEMBLER_MODRM | LENGTH_DISASSEMBLER_IMM8);
+
+            if (Offset >= MaximumLength)
+            {
+                return NULL_ZERO;
+            }
+
+            Opcode = Bytes[Offset++];
+        }
+        else
+        {
+            Map   = 1;
+            Flags = g_LengthDisassemblerTwoByteMap[Opcode];
+
+            if (Flags == LENGTH_DISASSEMBLER_INVALID)
+            {
+                return NULL_ZERO;
+            }
+
+            if (Opcode >= 0x20 && Opcode <= 0x23)
+            {
+                //
+                // mov to/from control and debug registers ignore the mod field
+                //
+                Flags          = LENGTH_DISASSEMBLER_MODRM;
+                IsRegisterForm = TRUE;
+            }
+            else if (Opcode == 0x78)
+            {
+                //
+                // vmread, or extrq/insertq (SSE4a) that have two 8-bit immediates
+                //
+                Flags = LENGTH_DISASSEMBLER_MODRM;
+
+                if (HasOperandSize || HasRepeatNotEqual)
+                {
+                    ImmediateSize = 2;
+                }
+            }
+        }
+
+        //
+        // The mandatory prefix selects the instruction, if more than one of
+        // them is used, the instruction is left to the full disassembler
+        //
+        if ((HasRepeat && HasRepeatNotEqual) || (HasOperandSize && (HasRepeat || HasRepeatNotEqual)))
+        {
+            return NULL_ZERO;
+        }
+
+        MandatoryPrefix = HasRepeatNotEqual ? 3 : (HasRepeat ? 2 : (HasOperandSize ? 1 : 0));
+    }
+    else if ((Opcode == 0xc4 || Opcode == 0xc5 || Opcode == 0x62 || Opcode == 0x8f) &&
+             Offset < MaximumLength &&
+             (Opcode == 0x8f ? (Bytes[Offset] & 0x1f) >= 8 : (!Is32Bit || (Bytes[Offset] >> 6) == 3)))
+    {
+        //
+        // VEX (C4, C5), EVEX (62) and XOP (8F) prefixes are left to the full
+        // disassembler, in 32-bit mode the same opcodes are les, lds and bound
+        // if the next byte doesn't have a register form (and pop for XOP if
+        // the map is less than 8)
+        //
+        return NULL_ZERO;
+    }
+    else
+    {
+        if (!Is32Bit && (g_LengthDisassemblerInvalidIn64BitMode[Opcode >> 5] & (1U << (Opcode & 0x1f))))
+        {
+            return NULL_ZERO;
+        }
+
+        Flags = g_LengthDisassemblerOneByteMap[Opcode];
+
+        if (Flags == LENGTH_DISASSEMBLER_INVALID)
+        {
+            return NULL_ZERO;
+        }
+
+        if (Flags & LENGTH_DISASSEMBLER_SPECIAL)
+        {
+            switch (Opcode)
+            {
+            case 0x62: // bound
+            case 0xc4: // les
+            case 0xc5: // lds
+            case 0x8f: // pop
+                Flags = LENGTH_DISASSEMBLER_MODRM;
+                break;
+            case 0x9a: // call far
+            case 0xea: // jmp far
+                Flags         = 0;
+                ImmediateSize = OperandSize + 2;
+                break;
+            case 0xf6: // test (group 3) has an immediate
+            case 0xf7:
+                Flags = LENGTH_DISASSEMBLER_MODRM;
+
+                if (Offset >= MaximumLength)
+                {
+                    return NULL_ZERO;
+                }
+
+                if (((Bytes[Offset] >> 3) & 0x7) < 2)
+                {
+                    ImmediateSize = (Opcode == 0xf6) ? 1 : OperandSize;
+                }
+                break;
+            default:
+                return NULL_ZERO;
+            }
+        }
+    }
+
+    //
+    // Reject the opcode extensions, forms and prefixes that are not valid (or
+    // not known to the tables), so the caller can use the full disassembler
+    //
+    if (Flags & LENGTH_DISASSEMBLER_MODRM)
+    {
+        if (Offset >= MaximumLength)
+        {
+            return NULL_ZERO;
+        }
+
+        ModRm = Bytes[Offset];
+    }
+
+    if (Map == 0)
+    {
+        if (!LengthDisassemblerIsValidOneByteOpcode(Opcode, ModRm))
+        {
+            return NULL_ZERO;
+        }
+    }
+    else if (!LengthDisassemblerIsValidEscapedOpcode(Map, MandatoryPrefix, Opcode, ModRm, HasRexR, Is32Bit))
+    {
+        return NULL_ZERO;
+    }
+
+    if (HasLock && !LengthDisassemblerIsLockable(Map, Opcode, ModRm, (Flags & LENGTH_DISASSEMBLER_MODRM) != 0))
+    {
+        return NULL_ZERO;
+    }
+
+    //
+    // ModR/M, SIB and displacement
+    //
+    if (Flags & LENGTH_DISASSEMBLER_MODRM)
+    {
+        ModRmLength = LengthDisassemblerGetModRmLength(Bytes,
+                                                       Offset,
+                                                       MaximumLength,
+                                                       Is32Bit && HasAddressSize,
+                                                       IsRegisterForm);
+
+        if (ModRmLength == NULL_ZERO)
+        {
+            return NULL_ZERO;
+        }
+
+        Offset += ModRmLength;
+    }
+
+    //
+    // Immediates
+    //
+    if (Flags & LENGTH_DISASSEMBLER_IMM8)
+    {
+        ImmediateSize += 1;
+    }
+
+    if (Flags & LENGTH_DISASSEMBLER_IMM16)
+    {
+        ImmediateSize += 2;
+    }
+
+    if (Flags & LENGTH_DISASSEMBLER_IMMZ)
+    {
+        ImmediateSize += OperandSize;
+    }
+
+    if (Flags & LENGTH_DISASSEMBLER_IMMV)
+    {
+        ImmediateSize += HasRexW ? 8 : OperandSize;
+    }
+
+    if (Flags & LENGTH_DISASSEMBLER_MOFFS)
+    {
+        if (Is32Bit)
+        {
+            ImmediateSize += HasAddressSize ? 2 : 4;
+        }
+        else
+        {
+            ImmediateSize += HasAddressSize ? 4 : 8;
+        }
+    }
+
+    if (Flags & LENGTH_DISASSEMBLER_REL)
+    {
+        //
+        // Near branches always have 32-bit offsets in 64-bit mode
+        //
+        ImmediateSize += Is32Bit ? OperandSize : 4;
+    }
+
+    Offset += ImmediateSize;
+
+    if (Offset > MaximumLength)
+    {
+        return NULL_ZERO;
+    }
+
+    return Offset;
+}
+
+/**
+ * @brief Check whether an instruction is a 'call' or a 'ret'
+ * @details Near and far calls and returns are checked (the same instructions
+ * that are treated as 'call' and 'ret' by the debugger), this function
+ * doesn't access any memory other than the buffer, so it can be used in
+ * VMX-root mode
+ *
+ * @param Buffer
+ * @param BufferLength
+ * @param Is32Bit
+ * @param IsRet Whether the instruction is a 'ret' (if return value is TRUE)
+ * @param Length Length of the instruction (if return value is TRUE)
+ *
+ * @return BOOLEAN Whether the instruction is a 'call' or a 'ret'
+ */
+BOOLEAN
+LengthDisassemblerCheckCallOrRet(PVOID Buffer, UINT32 BufferLength, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length)
+{
+    BYTE * Bytes  = (BYTE *)Buffer;
+    UINT32 Offset = 0;
+
+    *Length = LengthDisassemblerGetInstructionLength(Buffer, BufferLength, Is32Bit);
+
+    if (*Length == NULL_ZERO)
+    {
+        return FALSE;
+    }
+
+    //
+    // Skip the prefixes, the instruction is already validated by the length
+    // decoder so the opcode is within the instruction
+    //
+    while (Offset < *Length)
+    {
+        if ((!Is32Bit && (Bytes[Offset] & 0xf0) == 0x40) ||
+            Bytes[Offset] == 0x66 || Bytes[Offset] == 0x67 || Bytes[Offset] == 0xf0 ||
+            Bytes[Offset] == 0xf2 || Bytes[Offset] == 0xf3 || Bytes[Offset] == 0x26 ||
+            Bytes[Offset] == 0x2e || Bytes[Offset] == 0x36 || Bytes[Offset] == 0x3e ||
+            Bytes[Offset] == 0x64 || Bytes[Offset] == 0x65)
+        {
+            Offset++;
+            continue;
+        }
+
+        break;
+    }
+
+    if (Offset >= *Length)
+    {
+        return FALSE;
+    }
+
+    switch (Bytes[Offset])
+    {
+    case 0xe8: // call rel16/rel32
+    case 0x9a: // call ptr16:16/ptr16:32 (invalid in 64-bit mode, rejected by the length decoder)
+        *IsRet = FALSE;
+        return TRUE;
+
+    case 0xff: // call r/m (/2) and call m16:16/m16:32/m16:64 (/3)
+        if (Offset + 1 < *Length && (((Bytes[Offset + 1] >> 3) & 0x7) == 2 || ((Bytes[Offset + 1] >> 3) & 0x7) == 3))
+        {
+            *IsRet = FALSE;
+            return TRUE;
+        }
+
+        return FALSE;
+
+    case 0xc2: // ret imm16
+    case 0xc3: // ret
+    case 0xca: // ret far imm16
+    case 0xcb: // ret far
+        *IsRet = TRUE;
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
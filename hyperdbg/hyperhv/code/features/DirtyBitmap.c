@@ -0,0 +1,307 @@
+/**
+ * @file DirtyBitmap.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Implementation of the bitmap of the dirty physical pages
+ * @details The guest-physical addresses that are drained from the PML
+ * buffers of all cores are accumulated in this bitmap, the pages are
+ * set from vmx-root (VM-exits of different cores) and collected (read
+ * and reset) by the debugger, so all of the updates are atomic
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Get the size of the buffer that is needed for the bitmap
+ *
+ * @param CountOfPages Number of physical pages that are tracked
+ *
+ * @return UINT64
+ */
+UINT64
+DirtyBitmapGetBufferSize(UINT64 CountOfPages)
+{
+    UINT64 CountOfWords        = (CountOfPages + DIRTY_BITMAP_PAGES_PER_WORD - 1) / DIRTY_BITMAP_PAGES_PER_WORD;
+    UINT64 CountOfSummaryWords = (CountOfWords + DIRTY_BITMAP_PAGES_PER_WORD - 1) / DIRTY_BITMAP_PAGES_PER_WORD;
+
+    return (CountOfWords + CountOfSummaryWords) * sizeof(UINT64);
+}
+
+/**
+ * @brief Initialize the bitmap on a buffer
+ *
+ * @param Bitmap The bitmap
+ * @param Buffer A buffer with the size of DirtyBitmapGetBufferSize
+ * @param CountOfPages Number of physical pages that are tracked
+ *
+ * @return VOID
+ */
+VOID
+DirtyBitmapInitialize(DIRTY_BITMAP * Bitmap, PVOID Buffer, UINT64 CountOfPages)
+{
+    Bitmap->CountOfPages        = CountOfPages;
+    Bitmap->CountOfWords        = (CountOfPages + DIRTY_BITMAP_PAGES_PER_WORD - 1) / DIRTY_BITMAP_PAGES_PER_WORD;
+    Bitmap->CountOfSummaryWords = (Bitmap->CountOfWords + DIRTY_BITMAP_PAGES_PER_WORD - 1) / DIRTY_BITMAP_PAGES_PER_WORD;
+    Bitmap->Words               = (volatile LONG64 *)Buffer;
+    Bitmap->Summary             = Bitmap->Words + Bitmap->CountOfWords;
+
+    DirtyBitmapReset(Bitmap);
+}
+
+/**
+ * @brief Mark the summary bit of a word of the bitmap
+ *
+ * @param Bitmap The bitmap
+ * @param WordIndex Index of the word
+ *
+ * @return VOID
+ */
+static VOID
+DirtyBitmapSetSummary(DIRTY_BITMAP * Bitmap, UINT64 WordIndex)
+{
+    UINT64 Mask = 1ull << (WordIndex % DIRTY_BITMAP_PAGES_PER_WORD);
+
+    //
+    // The summary bit is set after the bit of the page so a collector that
+    // clears the summary bit either sees the page or the summary bit is set
+    // again. The bit is checked first to avoid the locked operation (and
+    // the cache line contention) for the pages that are already marked
+    //
+    if (((UINT64)Bitmap->Summary[WordIndex / DIRTY_BITMAP_PAGES_PER_WORD] & Mask) == 0)
+    {
+        InterlockedOr64(&Bitmap->Summary[WordIndex / DIRTY_BITMAP_PAGES_PER_WORD], (LONG64)Mask);
+    }
+}
+
+/**
+ * @brief Mark a physical page as dirty
+ *
+ * @param Bitmap The bitmap
+ * @param PageFrameNumber The page frame number of the page
+ *
+ * @return VOID
+ */
+VOID
+DirtyBitmapSetPage(DIRTY_BITMAP * Bitmap, UINT64 PageFrameNumber)
+{
+    UINT64 WordIndex;
+    UINT64 Mask;
+
+    //
+    // Pages out of the tracked range are ignored
+    //
+    if (PageFrameNumber >= Bitmap->CountOfPages)
+    {
+        return;
+    }
+
+    WordIndex = PageFrameNumber / DIRTY_BITMAP_PAGES_PER_WORD;
+    Mask      = 1ull << (PageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD);
+
+    if (((UINT64)Bitmap->Words[WordIndex] & Mask) == 0)
+    {
+        InterlockedOr64(&Bitmap->Words[WordIndex], (LONG64)Mask);
+    }
+
+    DirtyBitmapSetSummary(Bitmap, WordIndex);
+}
+
+/**
+ * @brief Mark a range of physical pages as dirty
+ *
+ * @param Bitmap The bitmap
+ * @param FirstPageFrameNumber The page frame number of the first page
+ * @param CountOfPages Number of pages
+ *
+ * @return VOID
+ */
+VOID
+DirtyBitmapSetRange(DIRTY_BITMAP * Bitmap, UINT64 FirstPageFrameNumber, UINT64 CountOfPages)
+{
+    UINT64 WordIndex;
+    UINT64 Mask;
+    UINT64 PageFrameNumber    = FirstPageFrameNumber;
+    UINT64 EndPageFrameNumber = FirstPageFrameNumber + CountOfPages;
+
+    if (EndPageFrameNumber > Bitmap->CountOfPages)
+    {
+        EndPageFrameNumber = Bitmap->CountOfPages;
+    }
+
+    while (PageFrameNumber < EndPageFrameNumber)
+    {
+        WordIndex = PageFrameNumber / DIRTY_BITMAP_PAGES_PER_WORD;
+        Mask      = MAXUINT64 << (PageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD);
+
+        //
+        // Remove the pages after the end of the range from the last word
+        //
+        if (EndPageFrameNumber - (WordIndex * DIRTY_BITMAP_PAGES_PER_WORD) < DIRTY_BITMAP_PAGES_PER_WORD)
+        {
+            Mask &= (1ull << (EndPageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD)) - 1;
+        }
+
+        if (((UINT64)Bitmap->Words[WordIndex] & Mask) != Mask)
+        {
+            InterlockedOr64(&Bitmap->Words[WordIndex], (LONG64)Mask);
+        }
+
+        DirtyBitmapSetSummary(Bitmap, WordIndex);
+
+        PageFrameNumber = (WordIndex + 1) * DIRTY_BITMAP_PAGES_PER_WORD;
+    }
+}
+
+/**
+ * @brief Collect (read and reset) the dirty pages of a range
+ * @details The words are visited based on the summary so the clean parts
+ * of the address space are skipped 64 words at a time. The pages that are
+ * marked while collecting are either returned or kept for the next call
+ *
+ * @param Bitmap The bitmap
+ * @param FirstPageFrameNumber The first page of the range
+ * @param EndPageFrameNumber The page after the last page of the range
+ * @param Entries The array that receives the dirty pages
+ * @param MaximumEntries Maximum number of entries of the array
+ * @param NextPageFrameNumber The page that the collection should be continued
+ * from (equals to the end of the range if all of the pages are collected)
+ *
+ * @return UINT32 Number of the filled entries
+ */
+UINT32
+DirtyBitmapCollect(DIRTY_BITMAP *               Bitmap,
+                   UINT64                       FirstPageFrameNumber,
+                   UINT64                       EndPageFrameNumber,
+                   DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                   UINT32                       MaximumEntries,
+                   UINT64 *                     NextPageFrameNumber)
+{
+    UINT64 WordIndex;
+    UINT64 EndWordIndex;
+    UINT64 SummaryIndex;
+    UINT64 SummaryBits;
+    UINT64 Bits;
+    UINT64 Mask;
+    ULONG  Bit;
+    UINT32 CountOfEntries = 0;
+
+    *NextPageFrameNumber = EndPageFrameNumber;
+
+    if (EndPageFrameNumber > Bitmap->CountOfPages)
+    {
+        EndPageFrameNumber = Bitmap->CountOfPages;
+    }
+
+    if (FirstPageFrameNumber >= EndPageFrameNumber)
+    {
+        return 0;
+    }
+
+    WordIndex    = FirstPageFrameNumber / DIRTY_BITMAP_PAGES_PER_WORD;
+    EndWordIndex = (EndPageFrameNumber + DIRTY_BITMAP_PAGES_PER_WORD - 1) / DIRTY_BITMAP_PAGES_PER_WORD;
+
+    while (WordIndex < EndWordIndex)
+    {
+        SummaryIndex = WordIndex / DIRTY_BITMAP_PAGES_PER_WORD;
+        SummaryBits  = (UINT64)Bitmap->Summary[SummaryIndex] & (MAXUINT64 << (WordIndex % DIRTY_BITMAP_PAGES_PER_WORD));
+
+        if (EndWordIndex - (SummaryIndex * DIRTY_BITMAP_PAGES_PER_WORD) < DIRTY_BITMAP_PAGES_PER_WORD)
+        {
+            SummaryBits &= (1ull << (EndWordIndex % DIRTY_BITMAP_PAGES_PER_WORD)) - 1;
+        }
+
+        if (SummaryBits == 0)
+        {
+            //
+            // None of the words of this summary word is dirty
+            //
+            WordIndex = (SummaryIndex + 1) * DIRTY_BITMAP_PAGES_PER_WORD;
+            continue;
+        }
+
+        _BitScanForward64(&Bit, SummaryBits);
+        WordIndex = (SummaryIndex * DIRTY_BITMAP_PAGES_PER_WORD) + Bit;
+
+        if (CountOfEntries == MaximumEntries)
+        {
+            //
+            // The caller should continue from this word
+            //
+            *NextPageFrameNumber = WordIndex * DIRTY_BITMAP_PAGES_PER_WORD;
+
+            if (*NextPageFrameNumber < FirstPageFrameNumber)
+            {
+                *NextPageFrameNumber = FirstPageFrameNumber;
+            }
+
+            return CountOfEntries;
+        }
+
+        //
+        // The pages of the word that are in the range
+        //
+        Mask = MAXUINT64;
+
+        if (WordIndex * DIRTY_BITMAP_PAGES_PER_WORD < FirstPageFrameNumber)
+        {
+            Mask &= MAXUINT64 << (FirstPageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD);
+        }
+
+        if (EndPageFrameNumber - (WordIndex * DIRTY_BITMAP_PAGES_PER_WORD) < DIRTY_BITMAP_PAGES_PER_WORD)
+        {
+            Mask &= (1ull << (EndPageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD)) - 1;
+        }
+
+        //
+        // Clear the summary bit before taking the word, pages that are marked
+        // after this point set the summary bit again
+        //
+        InterlockedAnd64(&Bitmap->Summary[SummaryIndex], ~(LONG64)(1ull << Bit));
+
+        Bits = (UINT64)InterlockedExchange64(&Bitmap->Words[WordIndex], 0);
+
+        if ((Bits & ~Mask) != 0)
+        {
+            //
+            // Put back the pages that are not in the range
+            //
+            InterlockedOr64(&Bitmap->Words[WordIndex], (LONG64)(Bits & ~Mask));
+            DirtyBitmapSetSummary(Bitmap, WordIndex);
+        }
+
+        Bits &= Mask;
+
+        if (Bits != 0)
+        {
+            Entries[CountOfEntries].FirstPageFrameNumber = WordIndex * DIRTY_BITMAP_PAGES_PER_WORD;
+            Entries[CountOfEntries].Bitmap               = Bits;
+            CountOfEntries++;
+        }
+
+        WordIndex++;
+    }
+
+    return CountOfEntries;
+}
+
+/**
+ * @brief Clear all of the pages of the bitmap
+ *
+ * @param Bitmap The bitmap
+ *
+ * @return VOID
+ */
+VOID
+DirtyBitmapReset(DIRTY_BITMAP * Bitmap)
+{
+    if (Bitmap->Words == NULL)
+    {
+        return;
+    }
+
+    RtlZeroMemory((PVOID)Bitmap->Words, (SIZE_T)((Bitmap->CountOfWords + Bitmap->CountOfSummaryWords) * sizeof(UINT64)));
+}
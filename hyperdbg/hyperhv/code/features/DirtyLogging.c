@@ -2,7 +2,9 @@
  * @file DirtyLogging.c
  * @author Sina Karvandi (sina@hyperdbg.org)
  * @brief Implementation of memory hooks functions
- * @details
+ * @details The guest-physical addresses that are drained from the PML
+ * buffers are accumulated in a bitmap which is shared between the cores
+ * and could be collected by the debugger (e.g., for incremental dumps)
  *
  * @version 0.2
  * @date 2023-02-05
@@ -12,15 +14,62 @@
  */
 #include "pch.h"
 
+/**
+ * @brief Get the number of physical pages that are tracked by the dirty bitmap
+ * @details The bitmap covers the RAM ranges up to the highest physical address
+ * that is mapped by the EPT identity table (512 GB)
+ *
+ * @return UINT64
+ */
+static UINT64
+DirtyLoggingGetCountOfPhysicalPages()
+{
+    PPHYSICAL_MEMORY_RANGE PhysicalMemoryRanges;
+    UINT64                 EndAddress;
+    UINT64                 HighestAddress = 0;
+
+    PhysicalMemoryRanges = MmGetPhysicalMemoryRanges();
+
+    if (PhysicalMemoryRanges == NULL)
+    {
+        return 0;
+    }
+
+    for (UINT32 i = 0; PhysicalMemoryRanges[i].BaseAddress.QuadPart != 0 || PhysicalMemoryRanges[i].NumberOfBytes.QuadPart != 0; i++)
+    {
+        EndAddress = PhysicalMemoryRanges[i].BaseAddress.QuadPart + PhysicalMemoryRanges[i].NumberOfBytes.QuadPart;
+
+        if (EndAddress > HighestAddress)
+        {
+            HighestAddress = EndAddress;
+        }
+    }
+
+    ExFreePool(PhysicalMemoryRanges);
+
+    if (HighestAddress > DIRTY_LOGGING_MAXIMUM_PHYSICAL_ADDRESS)
+    {
+        HighestAddress = DIRTY_LOGGING_MAXIMUM_PHYSICAL_ADDRESS;
+    }
+
+    return HighestAddress / PAGE_SIZE;
+}
+
 /**
  * @brief Initialize the dirty logging mechanism
+ * @details Allocates the PML buffers and the dirty bitmap, the logging is
+ * started later by enabling PML on the cores (from vmx-root). Should be
+ * called at PASSIVE_LEVEL, the buffers are allocated only once and are
+ * freed if the allocation fails
  *
  * @return BOOLEAN
  */
 BOOLEAN
 DirtyLoggingInitialize()
 {
-    ULONG ProcessorsCount;
+    ULONG  ProcessorsCount;
+    UINT64 CountOfPages;
+    PVOID  BitmapBuffer;
 
     //
     // Query count of active processors
@@ -44,10 +93,37 @@ DirtyLoggingInitialize()
     //
     if (!g_CompatibilityCheck.PmlSupport)
     {
-        LogWarning("err, dirty logging mechanism is not initialized as the processor doesn't support PML");
+        LogDebugInfo("Dirty logging mechanism is not initialized as the processor doesn't support PML");
         return FALSE;
     }
 
+    //
+    // Check whether the buffers are already allocated
+    //
+    if (g_DirtyLoggingBitmap.Words != NULL)
+    {
+        return TRUE;
+    }
+
+    //
+    // Allocate the bitmap of dirty pages (one bit for each physical page)
+    //
+    CountOfPages = DirtyLoggingGetCountOfPhysicalPages();
+
+    if (CountOfPages == 0)
+    {
+        return FALSE;
+    }
+
+    BitmapBuffer = PlatformMemAllocateNonPagedPool(DirtyBitmapGetBufferSize(CountOfPages));
+
+    if (BitmapBuffer == NULL)
+    {
+        return FALSE;
+    }
+
+    DirtyBitmapInitialize(&g_DirtyLoggingBitmap, BitmapBuffer, CountOfPages);
+
     //
     // A new 64-bit VM-execution control field is defined called the PML address. This is
     // the 4 - KByte aligned physical address of the page - modification log.The page modification
@@ -65,13 +141,7 @@ DirtyLoggingInitialize()
             //
             // Allocation failed
             //
-            for (size_t j = 0; j < ProcessorsCount; j++)
-            {
-                if (g_GuestState[j].PmlBufferAddress != NULL)
-                {
-                    PlatformMemFreePool(g_GuestState[j].PmlBufferAddress);
-                }
-            }
+            DirtyLoggingUninitialize();
 
             return FALSE;
         }
@@ -82,17 +152,66 @@ DirtyLoggingInitialize()
         RtlZeroBytes(g_GuestState[i].PmlBufferAddress, PAGE_SIZE);
     }
 
-    //
-    // Broadcast VMCALL to adjust PML controls from vmx-root
-    //
-    BroadcastEnablePmlOnAllProcessors();
-
     //
     // Initialization was successful
     //
     return TRUE;
 }
 
+/**
+ * @brief Clear the dirty flags of the EPT entries of the core
+ * @details The processor only logs the writes that set the dirty flag, so
+ * the flags should be cleared once the logging is started
+ *
+ * @param VCpu The virtual processor's state
+ *
+ * @return VOID
+ */
+static VOID
+DirtyLoggingClearEptDirtyFlags(VIRTUAL_MACHINE_STATE * VCpu)
+{
+    PEPT_PML2_ENTRY   PML2;
+    PEPT_PML1_ENTRY   PML1;
+    PEPT_PML2_POINTER PML2Pointer;
+
+    for (SIZE_T i = 0; i < VMM_EPT_PML3E_COUNT; i++)
+    {
+        for (SIZE_T j = 0; j < VMM_EPT_PML2E_COUNT; j++)
+        {
+            PML2 = &VCpu->EptPageTable->PML2[i][j];
+
+            if (PML2->LargePage)
+            {
+                if (PML2->Dirty)
+                {
+                    PML2->Dirty = FALSE;
+                }
+
+                continue;
+            }
+
+            //
+            // The large page is split, clear the entries of its PML1 table
+            //
+            PML2Pointer = (PEPT_PML2_POINTER)PML2;
+            PML1        = (PEPT_PML1_ENTRY)PhysicalAddressToVirtualAddress(PML2Pointer->PageFrameNumber * PAGE_SIZE);
+
+            if (PML1 == NULL)
+            {
+                continue;
+            }
+
+            for (SIZE_T k = 0; k < VMM_EPT_PML1E_COUNT; k++)
+            {
+                if (PML1[k].Dirty)
+                {
+                    PML1[k].Dirty = FALSE;
+                }
+            }
+        }
+    }
+}
+
 /**
  * @brief Enables the dirty logging mechanism in VMX-root mode
  * @details should be called in vmx-root mode
@@ -112,6 +231,14 @@ DirtyLoggingEnable(VIRTUAL_MACHINE_STATE * VCpu)
         return FALSE;
     }
 
+    //
+    // Clear the dirty flags so every page that is modified from now on
+    // is logged, the cached translations might have the dirty flag so
+    // they're also invalidated
+    //
+    DirtyLoggingClearEptDirtyFlags(VCpu);
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+
     //
     // Write the address of the buffer
     //
@@ -155,7 +282,13 @@ DirtyLoggingEnable(VIRTUAL_MACHINE_STATE * VCpu)
 VOID
 DirtyLoggingDisable(VIRTUAL_MACHINE_STATE * VCpu)
 {
-    UNREFERENCED_PARAMETER(VCpu);
+    //
+    // Save the remaining logs of the core into the dirty bitmap
+    //
+    if (VCpu->PmlBufferAddress != NULL)
+    {
+        DirtyLoggingFlushPmlBuffer(VCpu);
+    }
 
     //
     // Clear the address
@@ -174,7 +307,9 @@ DirtyLoggingDisable(VIRTUAL_MACHINE_STATE * VCpu)
 }
 
 /**
- * @brief Initialize the dirty logging mechanism
+ * @brief Uninitialize the dirty logging mechanism
+ * @details PML should be already disabled on all cores (or the cores
+ * are not virtualized anymore)
  *
  * @return VOID
  */
@@ -188,11 +323,6 @@ DirtyLoggingUninitialize()
     //
     ProcessorsCount = KeQueryActiveProcessorCount(0);
 
-    //
-    // Broadcast VMCALL to disable PML controls from vmx-root
-    //
-    BroadcastDisablePmlOnAllProcessors();
-
     //
     // Free the allocated pool buffers
     //
@@ -201,8 +331,15 @@ DirtyLoggingUninitialize()
         if (g_GuestState[i].PmlBufferAddress != NULL)
         {
             PlatformMemFreePool(g_GuestState[i].PmlBufferAddress);
+            g_GuestState[i].PmlBufferAddress = NULL;
         }
     }
+
+    if (g_DirtyLoggingBitmap.Words != NULL)
+    {
+        PlatformMemFreePool((PVOID)g_DirtyLoggingBitmap.Words);
+        RtlZeroMemory(&g_DirtyLoggingBitmap, sizeof(DIRTY_BITMAP));
+    }
 }
 
 /**
@@ -224,6 +361,15 @@ DirtyLoggingHandlePageModificationLog(VIRTUAL_MACHINE_STATE * VCpu)
     }
 }
 
+/**
+ * @brief Drain the PML buffer of the core into the dirty bitmap
+ * @details The dirty flags of the logged pages are cleared so the next
+ * writes to these pages are logged again
+ *
+ * @param VCpu The virtual processor's state
+ *
+ * @return BOOLEAN FALSE if the buffer was empty
+ */
 BOOLEAN
 DirtyLoggingFlushPmlBuffer(VIRTUAL_MACHINE_STATE * VCpu)
 {
@@ -273,10 +419,20 @@ DirtyLoggingFlushPmlBuffer(VIRTUAL_MACHINE_STATE * VCpu)
 
         if (IsLargePage)
         {
+            //
+            // Only the first write to a large page is logged, so all of
+            // its pages are considered as modified
+            //
+            DirtyBitmapSetRange(&g_DirtyLoggingBitmap,
+                                (AccessedPhysAddr / PAGE_SIZE) & ~((UINT64)DIRTY_LOGGING_PAGES_PER_LARGE_PAGE - 1),
+                                DIRTY_LOGGING_PAGES_PER_LARGE_PAGE);
+
             ((PEPT_PML2_ENTRY)PmlEntry)->Dirty = FALSE;
         }
         else
         {
+            DirtyBitmapSetPage(&g_DirtyLoggingBitmap, AccessedPhysAddr / PAGE_SIZE);
+
             ((PEPT_PML1_ENTRY)PmlEntry)->Dirty = FALSE;
         }
     }
@@ -286,6 +442,11 @@ DirtyLoggingFlushPmlBuffer(VIRTUAL_MACHINE_STATE * VCpu)
     //
     __vmx_vmwrite(VMCS_GUEST_PML_INDEX, PML_ENTITY_NUM - 1);
 
+    //
+    // The cleared dirty flags might be cached in the TLBs
+    //
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+
     return TRUE;
 }
 
@@ -304,10 +465,6 @@ DirtyLoggingHandleVmexits(VIRTUAL_MACHINE_STATE * VCpu)
     // to the page-modification log and the buffer is full ***
     //
 
-    //
-    // Test log
-    //
-    LogInfo("Dirty Logging VM-exit");
     // DirtyLoggingHandlePageModificationLog(VCpu);
 
     //
@@ -320,3 +477,55 @@ DirtyLoggingHandleVmexits(VIRTUAL_MACHINE_STATE * VCpu)
     //
     HvSuppressRipIncrement(VCpu);
 }
+
+/**
+ * @brief Clear the dirty bitmap
+ *
+ * @return BOOLEAN FALSE if the dirty logging mechanism is not initialized
+ */
+BOOLEAN
+DirtyLoggingResetDirtyPages()
+{
+    if (g_DirtyLoggingBitmap.Words == NULL)
+    {
+        return FALSE;
+    }
+
+    DirtyBitmapReset(&g_DirtyLoggingBitmap);
+
+    return TRUE;
+}
+
+/**
+ * @brief Collect (read and reset) the dirty pages of a range of physical pages
+ * @details The PML buffers of the cores should be flushed before calling
+ * this function, otherwise the last logged pages are not collected
+ *
+ * @param FirstPageFrameNumber
+ * @param EndPageFrameNumber
+ * @param Entries
+ * @param MaximumEntries
+ * @param NextPageFrameNumber
+ *
+ * @return UINT32 Number of the filled entries
+ */
+UINT32
+DirtyLoggingCollectDirtyPages(UINT64                       FirstPageFrameNumber,
+                              UINT64                       EndPageFrameNumber,
+                              DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                              UINT32                       MaximumEntries,
+                              UINT64 *                     NextPageFrameNumber)
+{
+    if (g_DirtyLoggingBitmap.Words == NULL)
+    {
+        *NextPageFrameNumber = EndPageFrameNumber;
+        return 0;
+    }
+
+    return DirtyBitmapCollect(&g_DirtyLoggingBitmap,
+                              FirstPageFrameNumber,
+                              EndPageFrameNumber,
+                              Entries,
+                              MaximumEntries,
+                              NextPageFrameNumber);
+}
@@ -0,0 +1,716 @@
+/**
+ * @file Snapshot.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Memory snapshots and restoring the modified pages
+ * @details The pages of the snapshot are write-protected in EPT, so the
+ * original contents of each page is saved right before the first write
+ * (copy-on-write) and a restore only copies back the pages that are
+ * modified since the last restore. The copies and the split tables of
+ * EPT are preallocated, so the faults and the restores never allocate
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Acquire the lock of the snapshot
+ * @details The lock is also acquired by the EPT violation handler (vmx-root),
+ * so the thread should not be preempted while holding it in vmx non-root
+ *
+ * @param OldIrql Receives the previous IRQL (only in vmx non-root)
+ *
+ * @return VOID
+ */
+static VOID
+SnapshotLock(KIRQL * OldIrql)
+{
+    if (VmxGetCurrentExecutionMode() == FALSE)
+    {
+        KeRaiseIrql(DISPATCH_LEVEL, OldIrql);
+    }
+
+    SpinlockLock(&g_Snapshot.Lock);
+}
+
+/**
+ * @brief Release the lock of the snapshot
+ *
+ * @param OldIrql The previous IRQL (only in vmx non-root)
+ *
+ * @return VOID
+ */
+static VOID
+SnapshotUnlock(KIRQL OldIrql)
+{
+    SpinlockUnlock(&g_Snapshot.Lock);
+
+    if (VmxGetCurrentExecutionMode() == FALSE)
+    {
+        KeLowerIrql(OldIrql);
+    }
+}
+
+/**
+ * @brief Check whether the page is hooked by the EPT hooks
+ * @details The entries of the hooked pages are managed by the hooks, so they
+ * are not protected or unprotected by the snapshot
+ *
+ * @param PageFrameNumber
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+SnapshotIsHookedPage(UINT64 PageFrameNumber)
+{
+    LIST_FOR_EACH_LINK(g_EptState->HookedPagesList, EPT_HOOKED_PAGE_DETAIL, PageHookList, HookedEntry)
+    {
+        if (HookedEntry->PhysicalBaseAddress == PageFrameNumber * PAGE_SIZE)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Check whether the entry could be write-protected by the snapshot
+ * @details Only the identity mapped RAM (write-back) pages are protected
+ *
+ * @param Entry The PML1 entry of the page
+ * @param PageFrameNumber
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+SnapshotIsProtectablePage(EPT_PML1_ENTRY * Entry, UINT64 PageFrameNumber)
+{
+    return Entry->PageFrameNumber == PageFrameNumber &&
+           Entry->ReadAccess &&
+           Entry->ExecuteAccess &&
+           Entry->MemoryType == MEMORY_TYPE_WRITE_BACK &&
+           !SnapshotIsHookedPage(PageFrameNumber);
+}
+
+/**
+ * @brief Allocate the buffers of the snapshot
+ * @details Should be called at PASSIVE_LEVEL, the buffers are kept for the
+ * next snapshots if the number of pages is not changed. The tables for
+ * splitting the large pages of a range with the same number of pages are
+ * also requested (the caller performs the allocations of the pool manager)
+ *
+ * @param MaximumPages Maximum number of pages that could be saved
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SnapshotAllocateBuffers(UINT32 MaximumPages)
+{
+    if (g_Snapshot.IsTaken)
+    {
+        return FALSE;
+    }
+
+    if (g_Snapshot.TrackerBuffer != NULL && g_Snapshot.Tracker.MaximumPages == MaximumPages)
+    {
+        return TRUE;
+    }
+
+    SnapshotFreeBuffers();
+
+    g_Snapshot.TrackerBuffer = PlatformMemAllocateNonPagedPool(SnapshotTrackerGetBufferSize(MaximumPages));
+    g_Snapshot.PageCopies    = PlatformMemAllocateNonPagedPool((SIZE_T)MaximumPages * PAGE_SIZE);
+
+    if (g_Snapshot.TrackerBuffer == NULL || g_Snapshot.PageCopies == NULL)
+    {
+        LogError("Err, insufficient memory for saving %d pages of the snapshot", MaximumPages);
+        SnapshotFreeBuffers();
+        return FALSE;
+    }
+
+    SnapshotTrackerInitialize(&g_Snapshot.Tracker, g_Snapshot.TrackerBuffer, g_Snapshot.PageCopies, MaximumPages);
+
+    //
+    // Each core needs its own splitting page-tables
+    //
+    PoolManagerRequestAllocation(sizeof(VMM_EPT_DYNAMIC_SPLIT),
+                                 ((MaximumPages / SNAPSHOT_TRACKER_PAGES_PER_TABLE) + 2) * KeQueryActiveProcessorCount(0),
+                                 SPLIT_2MB_PAGING_TO_4KB_PAGE);
+
+    return TRUE;
+}
+
+/**
+ * @brief Free the buffers of the snapshot
+ * @details The pages should not be protected anymore
+ *
+ * @return VOID
+ */
+VOID
+SnapshotFreeBuffers()
+{
+    g_Snapshot.IsTaken = FALSE;
+
+    if (g_Snapshot.TrackerBuffer != NULL)
+    {
+        PlatformMemFreePool(g_Snapshot.TrackerBuffer);
+        g_Snapshot.TrackerBuffer = NULL;
+    }
+
+    if (g_Snapshot.PageCopies != NULL)
+    {
+        PlatformMemFreePool(g_Snapshot.PageCopies);
+        g_Snapshot.PageCopies = NULL;
+    }
+
+    g_Snapshot.Tracker.MaximumPages = 0;
+}
+
+/**
+ * @brief Reserve the buffers for splitting the large pages of the range
+ * @details Should be called at PASSIVE_LEVEL, each core has its own EPT
+ * so the large pages of all cores are counted
+ *
+ * @param StartAddress Start physical address of the range
+ * @param EndAddress End physical address of the range
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SnapshotReserveSplitBuffers(UINT64 StartAddress, UINT64 EndAddress)
+{
+    ULONG           ProcessorsCount = KeQueryActiveProcessorCount(0);
+    UINT32          Count           = 0;
+    PEPT_PML2_ENTRY Pml2Entry;
+
+    for (ULONG i = 0; i < ProcessorsCount; i++)
+    {
+        for (UINT64 Address = StartAddress & ~(SIZE_2_MB - 1); Address < EndAddress; Address += SIZE_2_MB)
+        {
+            Pml2Entry = EptGetPml2Entry(g_GuestState[i].EptPageTable, Address);
+
+            if (Pml2Entry != NULL && Pml2Entry->LargePage)
+            {
+                Count++;
+            }
+        }
+    }
+
+    if (Count == 0)
+    {
+        return TRUE;
+    }
+
+    PoolManagerRequestAllocation(sizeof(VMM_EPT_DYNAMIC_SPLIT), Count, SPLIT_2MB_PAGING_TO_4KB_PAGE);
+
+    return PoolManagerCheckAndPerformAllocationAndDeallocation();
+}
+
+/**
+ * @brief Take a snapshot of a range of the physical memory
+ * @details The buffers should be already allocated, the pages are protected
+ * later on all cores by SnapshotProtectPages
+ *
+ * @param StartAddress Start physical address of the range (page aligned)
+ * @param EndAddress End physical address of the range (page aligned)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SnapshotTake(UINT64 StartAddress, UINT64 EndAddress)
+{
+    KIRQL OldIrql = PASSIVE_LEVEL;
+
+    if (g_Snapshot.IsTaken || g_Snapshot.TrackerBuffer == NULL)
+    {
+        return FALSE;
+    }
+
+    SnapshotLock(&OldIrql);
+
+    SnapshotTrackerReset(&g_Snapshot.Tracker);
+
+    RtlZeroMemory(&g_Snapshot.Statistics, sizeof(DEBUGGER_SNAPSHOT_STATISTICS));
+
+    g_Snapshot.Statistics.StartAddress = StartAddress;
+    g_Snapshot.Statistics.EndAddress   = EndAddress;
+    g_Snapshot.Statistics.MaximumPages = g_Snapshot.Tracker.MaximumPages;
+
+    g_Snapshot.FirstPageFrameNumber  = StartAddress / PAGE_SIZE;
+    g_Snapshot.EndPageFrameNumber    = EndAddress / PAGE_SIZE;
+    g_Snapshot.IsProtectionFailed    = FALSE;
+    g_Snapshot.CountOfProtectedCores = 0;
+    g_Snapshot.IsTaken               = TRUE;
+
+    SnapshotUnlock(OldIrql);
+
+    return TRUE;
+}
+
+/**
+ * @brief Write-protect the pages of the snapshot on the current core
+ * @details Should be called from vmx-root on all cores, the large pages are
+ * split by the preallocated buffers
+ *
+ * @param VCpu The virtual processor's state
+ *
+ * @return VOID
+ */
+VOID
+SnapshotProtectPages(VIRTUAL_MACHINE_STATE * VCpu)
+{
+    PEPT_PML2_ENTRY Pml2Entry;
+    PEPT_PML1_ENTRY Pml1Table;
+    PVOID           TargetBuffer;
+    UINT64          PageFrameNumber;
+    UINT64          LastPageFrameNumber;
+
+    for (UINT64 Address = (g_Snapshot.FirstPageFrameNumber * PAGE_SIZE) & ~(SIZE_2_MB - 1);
+         Address < g_Snapshot.EndPageFrameNumber * PAGE_SIZE;
+         Address += SIZE_2_MB)
+    {
+        Pml2Entry = EptGetPml2Entry(VCpu->EptPageTable, Address);
+
+        if (Pml2Entry == NULL)
+        {
+            g_Snapshot.IsProtectionFailed = TRUE;
+            break;
+        }
+
+        if (Pml2Entry->LargePage)
+        {
+            TargetBuffer = (PVOID)PoolManagerRequestPool(SPLIT_2MB_PAGING_TO_4KB_PAGE, TRUE, sizeof(VMM_EPT_DYNAMIC_SPLIT));
+
+            if (TargetBuffer == NULL || !EptSplitLargePage(VCpu->EptPageTable, TargetBuffer, Address))
+            {
+                g_Snapshot.IsProtectionFailed = TRUE;
+                break;
+            }
+        }
+
+        Pml1Table = EptGetPml1Entry(VCpu->EptPageTable, Address);
+
+        if (Pml1Table == NULL)
+        {
+            g_Snapshot.IsProtectionFailed = TRUE;
+            break;
+        }
+
+        //
+        // Protect the pages of this table that are in the range
+        //
+        PageFrameNumber     = Address / PAGE_SIZE;
+        LastPageFrameNumber = (Address + SIZE_2_MB) / PAGE_SIZE;
+
+        if (PageFrameNumber < g_Snapshot.FirstPageFrameNumber)
+        {
+            PageFrameNumber = g_Snapshot.FirstPageFrameNumber;
+        }
+
+        if (LastPageFrameNumber > g_Snapshot.EndPageFrameNumber)
+        {
+            LastPageFrameNumber = g_Snapshot.EndPageFrameNumber;
+        }
+
+        for (; PageFrameNumber < LastPageFrameNumber; PageFrameNumber++)
+        {
+            EPT_PML1_ENTRY * Entry = &Pml1Table[PageFrameNumber % SNAPSHOT_TRACKER_PAGES_PER_TABLE];
+
+            if (Entry->WriteAccess && SnapshotIsProtectablePage(Entry, PageFrameNumber))
+            {
+                Entry->WriteAccess = 0;
+            }
+        }
+    }
+
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+}
+
+/**
+ * @brief Remove the write protection of the pages of the snapshot on the
+ * current core
+ * @details Should be called from vmx-root on all cores, the split tables
+ * are not merged
+ *
+ * @param VCpu The virtual processor's state
+ *
+ * @return VOID
+ */
+VOID
+SnapshotUnprotectPages(VIRTUAL_MACHINE_STATE * VCpu)
+{
+    PEPT_PML1_ENTRY Pml1Table;
+    UINT64          PageFrameNumber;
+    UINT64          LastPageFrameNumber;
+
+    for (UINT64 Address = (g_Snapshot.FirstPageFrameNumber * PAGE_SIZE) & ~(SIZE_2_MB - 1);
+         Address < g_Snapshot.EndPageFrameNumber * PAGE_SIZE;
+         Address += SIZE_2_MB)
+    {
+        Pml1Table = EptGetPml1Entry(VCpu->EptPageTable, Address);
+
+        if (Pml1Table == NULL)
+        {
+            //
+            // Not split (the protection of this table is failed)
+            //
+            continue;
+        }
+
+        PageFrameNumber     = Address / PAGE_SIZE;
+        LastPageFrameNumber = (Address + SIZE_2_MB) / PAGE_SIZE;
+
+        if (PageFrameNumber < g_Snapshot.FirstPageFrameNumber)
+        {
+            PageFrameNumber = g_Snapshot.FirstPageFrameNumber;
+        }
+
+        if (LastPageFrameNumber > g_Snapshot.EndPageFrameNumber)
+        {
+            LastPageFrameNumber = g_Snapshot.EndPageFrameNumber;
+        }
+
+        for (; PageFrameNumber < LastPageFrameNumber; PageFrameNumber++)
+        {
+            EPT_PML1_ENTRY * Entry = &Pml1Table[PageFrameNumber % SNAPSHOT_TRACKER_PAGES_PER_TABLE];
+
+            if (!Entry->WriteAccess && SnapshotIsProtectablePage(Entry, PageFrameNumber))
+            {
+                Entry->WriteAccess = 1;
+            }
+        }
+    }
+
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+}
+
+/**
+ * @brief Check whether the pages of the snapshot are protected on all cores
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SnapshotIsProtected()
+{
+    return g_Snapshot.IsTaken && !g_Snapshot.IsProtectionFailed;
+}
+
+/**
+ * @brief Discard the snapshot
+ * @details The pages should be already unprotected on all cores, the saved
+ * pages are dropped but the buffers are kept for the next snapshot
+ *
+ * @return VOID
+ */
+VOID
+SnapshotDiscard()
+{
+    KIRQL OldIrql = PASSIVE_LEVEL;
+
+    SnapshotLock(&OldIrql);
+
+    g_Snapshot.IsTaken = FALSE;
+
+    if (g_Snapshot.TrackerBuffer != NULL)
+    {
+        SnapshotTrackerReset(&g_Snapshot.Tracker);
+    }
+
+    SnapshotUnlock(OldIrql);
+}
+
+/**
+ * @brief Plan restoring the modified pages of the snapshot
+ * @details Should be called before SnapshotRestorePages, the pages that are
+ * modified after planning remain dirty for the next restore
+ *
+ * @return VOID
+ */
+VOID
+SnapshotPrepareRestore()
+{
+    KIRQL OldIrql = PASSIVE_LEVEL;
+
+    SnapshotLock(&OldIrql);
+
+    g_Snapshot.RestoreStartTsc = __rdtsc();
+
+    SnapshotTrackerPlanRestore(&g_Snapshot.Tracker, SNAPSHOT_MAXIMUM_PAGES_PER_BATCH);
+
+    InterlockedExchange(&g_Snapshot.CountOfProtectedCores, 0);
+
+    SnapshotUnlock(OldIrql);
+}
+
+/**
+ * @brief Write-protect the planned pages on the current core and restore them
+ * @details Should be called from vmx-root on all cores. The pages are copied
+ * back by the last core once the planned pages are write-protected on all of
+ * the cores, so the other cores could not modify them during the copy (their
+ * writes restore the page first, see SnapshotHandleEptViolation)
+ *
+ * @param VCpu The virtual processor's state
+ *
+ * @return VOID
+ */
+VOID
+SnapshotRestorePages(VIRTUAL_MACHINE_STATE * VCpu)
+{
+    SNAPSHOT_TRACKER *       Tracker = &g_Snapshot.Tracker;
+    SNAPSHOT_TRACKER_BATCH * Batch;
+    PEPT_PML1_ENTRY          Pml1Table;
+    PVOID                    PageCopy;
+    BYTE *                   MappedAddress;
+    SIZE_T                   MappedSize;
+    SIZE_T                   BatchSize;
+
+    //
+    // The pages of a batch are in the same table of EPT
+    //
+    for (UINT32 i = 0; i < Tracker->CountOfBatches; i++)
+    {
+        Batch     = &Tracker->Batches[i];
+        Pml1Table = EptGetPml1Entry(VCpu->EptPageTable, Batch->FirstPageFrameNumber * PAGE_SIZE);
+
+        if (Pml1Table == NULL)
+        {
+            continue;
+        }
+
+        for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+        {
+            Pml1Table[j].WriteAccess = 0;
+        }
+    }
+
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+
+    if ((ULONG)InterlockedIncrement(&g_Snapshot.CountOfProtectedCores) != KeQueryActiveProcessorCount(0))
+    {
+        return;
+    }
+
+    //
+    // All of the cores are protected, the lock is held until the pages are
+    // marked as restored so the writes of the other cores wait for the copy
+    //
+    SpinlockLock(&g_Snapshot.Lock);
+
+    for (UINT32 i = 0; i < Tracker->CountOfBatches; i++)
+    {
+        Batch     = &Tracker->Batches[i];
+        BatchSize = (SIZE_T)Batch->CountOfPages * PAGE_SIZE;
+
+        MappedAddress = MemoryMapperMapRange(MEMORY_MAPPER_WRAPPER_READ_PHYSICAL_MEMORY,
+                                             Batch->FirstPageFrameNumber * PAGE_SIZE,
+                                             BatchSize,
+                                             &MappedSize);
+
+        if (MappedAddress != NULL && MappedSize == BatchSize)
+        {
+            for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+            {
+                PageCopy = SnapshotTrackerGetBatchPageCopy(Tracker, Batch, j);
+
+                if (PageCopy != NULL)
+                {
+                    RtlCopyMemory(MappedAddress + ((SIZE_T)j * PAGE_SIZE), PageCopy, PAGE_SIZE);
+                }
+            }
+
+            MemoryMapperUnmapRange();
+        }
+        else
+        {
+            if (MappedAddress != NULL)
+            {
+                MemoryMapperUnmapRange();
+            }
+
+            //
+            // Copy back the pages one by one
+            //
+            for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+            {
+                PageCopy = SnapshotTrackerGetBatchPageCopy(Tracker, Batch, j);
+
+                if (PageCopy != NULL)
+                {
+                    MemoryMapperWriteMemorySafeByPhysicalAddress((Batch->FirstPageFrameNumber + j) * PAGE_SIZE,
+                                                                 (UINT64)PageCopy,
+                                                                 PAGE_SIZE);
+                }
+            }
+        }
+    }
+
+    TranslationCacheInvalidate();
+
+    g_Snapshot.Statistics.CountOfRestoredPages += SnapshotTrackerFinishRestore(Tracker);
+
+    SpinlockUnlock(&g_Snapshot.Lock);
+}
+
+/**
+ * @brief Finish restoring the snapshot
+ * @details Should be called after SnapshotRestorePages is called on all cores
+ * (the pages are already copied back and marked as restored)
+ *
+ * @return BOOLEAN FALSE if some of the modified pages could not be saved
+ * (and therefore restored) because the pool of copies is exhausted
+ */
+BOOLEAN
+SnapshotFinishRestore()
+{
+    UINT64  Cycles  = __rdtsc() - g_Snapshot.RestoreStartTsc;
+    KIRQL   OldIrql = PASSIVE_LEVEL;
+    BOOLEAN Result;
+
+    SnapshotLock(&OldIrql);
+
+    g_Snapshot.Statistics.CountOfRestores++;
+    g_Snapshot.Statistics.LastRestoreCycles = Cycles;
+    g_Snapshot.Statistics.TotalRestoreCycles += Cycles;
+
+    if (g_Snapshot.Statistics.MinimumRestoreCycles == 0 || Cycles < g_Snapshot.Statistics.MinimumRestoreCycles)
+    {
+        g_Snapshot.Statistics.MinimumRestoreCycles = Cycles;
+    }
+
+    if (Cycles > g_Snapshot.Statistics.MaximumRestoreCycles)
+    {
+        g_Snapshot.Statistics.MaximumRestoreCycles = Cycles;
+    }
+
+    Result = !g_Snapshot.Statistics.IsPoolExhausted;
+
+    SnapshotUnlock(OldIrql);
+
+    return Result;
+}
+
+/**
+ * @brief Query the statistics of the snapshot
+ *
+ * @param Statistics Receives the statistics
+ *
+ * @return BOOLEAN Whether the snapshot is taken or not
+ */
+BOOLEAN
+SnapshotQuery(DEBUGGER_SNAPSHOT_STATISTICS * Statistics)
+{
+    BOOLEAN IsTaken;
+    KIRQL   OldIrql = PASSIVE_LEVEL;
+
+    SnapshotLock(&OldIrql);
+
+    IsTaken = g_Snapshot.IsTaken;
+
+    RtlCopyMemory(Statistics, &g_Snapshot.Statistics, sizeof(DEBUGGER_SNAPSHOT_STATISTICS));
+
+    //
+    // Number of the allocated (or preallocated) pages
+    //
+    Statistics->MaximumPages = g_Snapshot.Tracker.MaximumPages;
+
+    if (IsTaken)
+    {
+        Statistics->CountOfSavedPages = g_Snapshot.Tracker.CountOfPages;
+        Statistics->CountOfDirtyPages = g_Snapshot.Tracker.CountOfDirtyPages;
+    }
+
+    SnapshotUnlock(OldIrql);
+
+    return IsTaken;
+}
+
+/**
+ * @brief Handle the EPT violations of the write-protected pages
+ * @details The write is not performed yet, so the page still has the
+ * original contents. The protection is only removed on the current core,
+ * the other cores save (or mark) the page on their first write. If the
+ * page is written while it's being restored, it's restored here before
+ * the write
+ *
+ * @param VCpu The virtual processor's state
+ * @param ViolationQualification The exit qualification of the EPT violation
+ * @param GuestPhysicalAddress The faulting guest-physical address
+ *
+ * @return BOOLEAN Whether the violation is handled by the snapshot or not
+ */
+BOOLEAN
+SnapshotHandleEptViolation(VIRTUAL_MACHINE_STATE *                VCpu,
+                           VMX_EXIT_QUALIFICATION_EPT_VIOLATION * ViolationQualification,
+                           UINT64                                 GuestPhysicalAddress)
+{
+    UINT64                  PageFrameNumber = GuestPhysicalAddress / PAGE_SIZE;
+    PEPT_PML1_ENTRY         Entry;
+    PVOID                   PageCopy;
+    SNAPSHOT_TRACKER_STATUS Status;
+
+    if (!g_Snapshot.IsTaken ||
+        PageFrameNumber < g_Snapshot.FirstPageFrameNumber ||
+        PageFrameNumber >= g_Snapshot.EndPageFrameNumber ||
+        !ViolationQualification->WriteAccess ||
+        ViolationQualification->EptWriteable)
+    {
+        return FALSE;
+    }
+
+    Entry = EptGetPml1Entry(VCpu->EptPageTable, GuestPhysicalAddress);
+
+    if (Entry == NULL || Entry->WriteAccess || !SnapshotIsProtectablePage(Entry, PageFrameNumber))
+    {
+        return FALSE;
+    }
+
+    SpinlockLock(&g_Snapshot.Lock);
+
+    g_Snapshot.Statistics.CountOfWriteFaults++;
+
+    Status = SnapshotTrackerTrackWrite(&g_Snapshot.Tracker, PageFrameNumber, &PageCopy);
+
+    if (Status == SNAPSHOT_TRACKER_STATUS_NEW_PAGE)
+    {
+        MemoryMapperReadMemorySafeByPhysicalAddress(GuestPhysicalAddress & ~((UINT64)PAGE_SIZE - 1),
+                                                    (UINT64)PageCopy,
+                                                    PAGE_SIZE);
+    }
+    else if (Status == SNAPSHOT_TRACKER_STATUS_RESTORED_PAGE)
+    {
+        //
+        // The page is not copied back yet by the restoring core, and the write
+        // should be performed on the restored contents
+        //
+        MemoryMapperWriteMemorySafeByPhysicalAddress(GuestPhysicalAddress & ~((UINT64)PAGE_SIZE - 1),
+                                                     (UINT64)PageCopy,
+                                                     PAGE_SIZE);
+
+        TranslationCacheInvalidate();
+    }
+    else if (Status == SNAPSHOT_TRACKER_STATUS_POOL_EXHAUSTED)
+    {
+        //
+        // The page is not saved, so it can't be restored
+        //
+        g_Snapshot.Statistics.IsPoolExhausted = TRUE;
+        g_Snapshot.Statistics.CountOfDroppedPages++;
+    }
+
+    SpinlockUnlock(&g_Snapshot.Lock);
+
+    //
+    // Let the write be performed (the instruction is executed again)
+    //
+    Entry->WriteAccess = 1;
+
+    EptInveptSingleContext(VCpu->EptPointer.AsUInt);
+
+    HvSuppressRipIncrement(VCpu);
+
+    return TRUE;
+}
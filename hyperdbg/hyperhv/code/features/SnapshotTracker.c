@@ -0,0 +1,371 @@
+/**
+ * @file SnapshotTracker.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tracking the saved pages of memory snapshots and planning restores
+ * @details The original contents of each page is saved on the first write
+ * after the snapshot, and the pages that are modified after each restore
+ * are listed, so a restore only copies back the touched pages. The tracker
+ * only manages the indexes and the copies, it doesn't access the memory
+ * and it's not synchronized (the caller holds the lock of the snapshot)
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Get the number of slots of the hash table
+ * @details The table is at most half full, and its size is a power of two
+ *
+ * @param MaximumPages Maximum number of saved pages
+ *
+ * @return UINT32
+ */
+static UINT32
+SnapshotTrackerGetHashTableSize(UINT32 MaximumPages)
+{
+    UINT32 Size = 16;
+
+    while (Size < MaximumPages * 2)
+    {
+        Size <<= 1;
+    }
+
+    return Size;
+}
+
+/**
+ * @brief Hash a page frame number (Fibonacci hashing)
+ *
+ * @param PageFrameNumber
+ *
+ * @return UINT32
+ */
+static UINT32
+SnapshotTrackerHash(UINT64 PageFrameNumber)
+{
+    return (UINT32)((PageFrameNumber * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+/**
+ * @brief Get the size of the buffer that is needed for the tracker (the
+ * copies of the pages are not included)
+ *
+ * @param MaximumPages Maximum number of saved pages
+ *
+ * @return UINT64
+ */
+UINT64
+SnapshotTrackerGetBufferSize(UINT32 MaximumPages)
+{
+    return ((UINT64)MaximumPages * sizeof(SNAPSHOT_TRACKER_PAGE)) +
+           ((UINT64)MaximumPages * sizeof(SNAPSHOT_TRACKER_BATCH)) +
+           ((UINT64)MaximumPages * sizeof(UINT32)) +
+           ((UINT64)SnapshotTrackerGetHashTableSize(MaximumPages) * sizeof(UINT32));
+}
+
+/**
+ * @brief Initialize the tracker on the preallocated buffers
+ *
+ * @param Tracker The tracker
+ * @param Buffer A buffer with the size of SnapshotTrackerGetBufferSize
+ * @param PageCopies A buffer of MaximumPages pages for the copies
+ * @param MaximumPages Maximum number of saved pages
+ *
+ * @return VOID
+ */
+VOID
+SnapshotTrackerInitialize(SNAPSHOT_TRACKER * Tracker, PVOID Buffer, PVOID PageCopies, UINT32 MaximumPages)
+{
+    Tracker->MaximumPages = MaximumPages;
+    Tracker->HashMask     = SnapshotTrackerGetHashTableSize(MaximumPages) - 1;
+    Tracker->Pages        = (SNAPSHOT_TRACKER_PAGE *)Buffer;
+    Tracker->Batches      = (SNAPSHOT_TRACKER_BATCH *)(Tracker->Pages + MaximumPages);
+    Tracker->DirtyPages   = (UINT32 *)(Tracker->Batches + MaximumPages);
+    Tracker->HashTable    = Tracker->DirtyPages + MaximumPages;
+    Tracker->PageCopies   = (BYTE *)PageCopies;
+
+    SnapshotTrackerReset(Tracker);
+}
+
+/**
+ * @brief Remove all of the saved pages (e.g., for a new snapshot)
+ *
+ * @param Tracker The tracker
+ *
+ * @return VOID
+ */
+VOID
+SnapshotTrackerReset(SNAPSHOT_TRACKER * Tracker)
+{
+    Tracker->CountOfPages        = 0;
+    Tracker->CountOfDirtyPages   = 0;
+    Tracker->CountOfPlannedPages = 0;
+    Tracker->CountOfBatches      = 0;
+
+    RtlZeroMemory(Tracker->HashTable, ((SIZE_T)Tracker->HashMask + 1) * sizeof(UINT32));
+}
+
+/**
+ * @brief Track a write to a page of the snapshot
+ * @details If the page is not saved before, a copy is reserved for the page
+ * and the caller should save the original contents of the page into it
+ * before the write is performed. If the page is written while it's planned
+ * to be restored (the copy is not written back yet), the caller should copy
+ * back the copy into the page before the write, the page is removed from
+ * the current restore and remains dirty for the next restore
+ *
+ * @param Tracker The tracker
+ * @param PageFrameNumber The page that is written
+ * @param PageCopy Receives the copy of the page for new and restored pages
+ *
+ * @return SNAPSHOT_TRACKER_STATUS
+ */
+SNAPSHOT_TRACKER_STATUS
+SnapshotTrackerTrackWrite(SNAPSHOT_TRACKER * Tracker, UINT64 PageFrameNumber, PVOID * PageCopy)
+{
+    UINT32                  Slot = SnapshotTrackerHash(PageFrameNumber) & Tracker->HashMask;
+    UINT32                  Index;
+    SNAPSHOT_TRACKER_PAGE * Page;
+
+    *PageCopy = NULL;
+
+    //
+    // Pages are never removed (except by resetting the tracker), so the
+    // probing stops at the first empty slot
+    //
+    while (Tracker->HashTable[Slot] != SNAPSHOT_TRACKER_EMPTY_SLOT)
+    {
+        Index = Tracker->HashTable[Slot] - 1;
+        Page  = &Tracker->Pages[Index];
+
+        if (Page->PageFrameNumber == PageFrameNumber)
+        {
+            if (Page->IsPlanned)
+            {
+                Page->IsPlanned = FALSE;
+
+                *PageCopy = Tracker->PageCopies + ((SIZE_T)Index * PAGE_SIZE);
+
+                return SNAPSHOT_TRACKER_STATUS_RESTORED_PAGE;
+            }
+
+            if (Page->IsDirty)
+            {
+                return SNAPSHOT_TRACKER_STATUS_ALREADY_DIRTY;
+            }
+
+            //
+            // The copy is still the original contents, the page only needs
+            // to be copied back in the next restore
+            //
+            Page->IsDirty                                     = TRUE;
+            Tracker->DirtyPages[Tracker->CountOfDirtyPages++] = Index;
+
+            return SNAPSHOT_TRACKER_STATUS_DIRTIED_PAGE;
+        }
+
+        Slot = (Slot + 1) & Tracker->HashMask;
+    }
+
+    if (Tracker->CountOfPages == Tracker->MaximumPages)
+    {
+        return SNAPSHOT_TRACKER_STATUS_POOL_EXHAUSTED;
+    }
+
+    Index = Tracker->CountOfPages++;
+
+    Tracker->Pages[Index].PageFrameNumber             = PageFrameNumber;
+    Tracker->Pages[Index].IsDirty                     = TRUE;
+    Tracker->Pages[Index].IsPlanned                   = FALSE;
+    Tracker->HashTable[Slot]                          = Index + 1;
+    Tracker->DirtyPages[Tracker->CountOfDirtyPages++] = Index;
+
+    *PageCopy = Tracker->PageCopies + ((SIZE_T)Index * PAGE_SIZE);
+
+    return SNAPSHOT_TRACKER_STATUS_NEW_PAGE;
+}
+
+/**
+ * @brief Move an item of the heap of the dirty pages down to its place
+ *
+ * @param Tracker The tracker
+ * @param Root The item
+ * @param Count Number of items of the heap
+ *
+ * @return VOID
+ */
+static VOID
+SnapshotTrackerSiftDown(SNAPSHOT_TRACKER * Tracker, UINT32 Root, UINT32 Count)
+{
+    UINT32 Child;
+    UINT32 Temp;
+
+    while ((Child = (Root * 2) + 1) < Count)
+    {
+        if (Child + 1 < Count &&
+            Tracker->Pages[Tracker->DirtyPages[Child + 1]].PageFrameNumber > Tracker->Pages[Tracker->DirtyPages[Child]].PageFrameNumber)
+        {
+            Child++;
+        }
+
+        if (Tracker->Pages[Tracker->DirtyPages[Root]].PageFrameNumber >= Tracker->Pages[Tracker->DirtyPages[Child]].PageFrameNumber)
+        {
+            return;
+        }
+
+        Temp                       = Tracker->DirtyPages[Root];
+        Tracker->DirtyPages[Root]  = Tracker->DirtyPages[Child];
+        Tracker->DirtyPages[Child] = Temp;
+
+        Root = Child;
+    }
+}
+
+/**
+ * @brief Sort the dirty pages based on their addresses
+ * @details Heap sort is used as it needs no extra memory and no recursion
+ * (it's called from vmx-root)
+ *
+ * @param Tracker The tracker
+ *
+ * @return VOID
+ */
+static VOID
+SnapshotTrackerSortDirtyPages(SNAPSHOT_TRACKER * Tracker)
+{
+    UINT32 Count = Tracker->CountOfDirtyPages;
+    UINT32 Temp;
+
+    for (UINT32 i = Count / 2; i > 0; i--)
+    {
+        SnapshotTrackerSiftDown(Tracker, i - 1, Count);
+    }
+
+    while (Count > 1)
+    {
+        Count--;
+
+        Temp                       = Tracker->DirtyPages[0];
+        Tracker->DirtyPages[0]     = Tracker->DirtyPages[Count];
+        Tracker->DirtyPages[Count] = Temp;
+
+        SnapshotTrackerSiftDown(Tracker, 0, Count);
+    }
+}
+
+/**
+ * @brief Plan restoring the dirty pages
+ * @details The dirty pages are sorted and grouped into batches of contiguous
+ * pages, so each batch could be mapped at once and its entries are in the
+ * same table of EPT
+ *
+ * @param Tracker The tracker
+ * @param MaximumPagesPerBatch Maximum number of pages of each batch
+ *
+ * @return UINT32 Number of batches
+ */
+UINT32
+SnapshotTrackerPlanRestore(SNAPSHOT_TRACKER * Tracker, UINT32 MaximumPagesPerBatch)
+{
+    SNAPSHOT_TRACKER_BATCH * Batch = NULL;
+    UINT64                   PageFrameNumber;
+
+    SnapshotTrackerSortDirtyPages(Tracker);
+
+    Tracker->CountOfPlannedPages = Tracker->CountOfDirtyPages;
+    Tracker->CountOfBatches      = 0;
+
+    for (UINT32 i = 0; i < Tracker->CountOfPlannedPages; i++)
+    {
+        PageFrameNumber = Tracker->Pages[Tracker->DirtyPages[i]].PageFrameNumber;
+
+        Tracker->Pages[Tracker->DirtyPages[i]].IsPlanned = TRUE;
+
+        if (Batch == NULL ||
+            PageFrameNumber != Batch->FirstPageFrameNumber + Batch->CountOfPages ||
+            Batch->CountOfPages == MaximumPagesPerBatch ||
+            PageFrameNumber % SNAPSHOT_TRACKER_PAGES_PER_TABLE == 0)
+        {
+            Batch                       = &Tracker->Batches[Tracker->CountOfBatches++];
+            Batch->FirstPageFrameNumber = PageFrameNumber;
+            Batch->CountOfPages         = 0;
+            Batch->FirstDirtyIndex      = i;
+        }
+
+        Batch->CountOfPages++;
+    }
+
+    return Tracker->CountOfBatches;
+}
+
+/**
+ * @brief Get the copy of a page of a batch
+ *
+ * @param Tracker The tracker
+ * @param Batch The batch
+ * @param PageIndex Index of the page in the batch
+ *
+ * @return PVOID NULL if the page is already restored (it's written during
+ * the restore)
+ */
+PVOID
+SnapshotTrackerGetBatchPageCopy(SNAPSHOT_TRACKER * Tracker, SNAPSHOT_TRACKER_BATCH * Batch, UINT32 PageIndex)
+{
+    UINT32 Index = Tracker->DirtyPages[Batch->FirstDirtyIndex + PageIndex];
+
+    if (!Tracker->Pages[Index].IsPlanned)
+    {
+        return NULL;
+    }
+
+    return Tracker->PageCopies + ((SIZE_T)Index * PAGE_SIZE);
+}
+
+/**
+ * @brief Mark the planned pages as restored
+ * @details The copies are kept, the next writes to the pages only mark them
+ * as dirty again. The pages that are modified after planning the restore
+ * (or restored by a write during the restore) are not marked and remain
+ * dirty
+ *
+ * @param Tracker The tracker
+ *
+ * @return UINT32 Number of the planned pages
+ */
+UINT32
+SnapshotTrackerFinishRestore(SNAPSHOT_TRACKER * Tracker)
+{
+    UINT32 CountOfPlannedPages = Tracker->CountOfPlannedPages;
+    UINT32 Count               = 0;
+    UINT32 Index;
+
+    for (UINT32 i = 0; i < CountOfPlannedPages; i++)
+    {
+        Index = Tracker->DirtyPages[i];
+
+        if (Tracker->Pages[Index].IsPlanned)
+        {
+            Tracker->Pages[Index].IsPlanned = FALSE;
+            Tracker->Pages[Index].IsDirty   = FALSE;
+        }
+        else
+        {
+            Tracker->DirtyPages[Count++] = Index;
+        }
+    }
+
+    for (UINT32 i = CountOfPlannedPages; i < Tracker->CountOfDirtyPages; i++)
+    {
+        Tracker->DirtyPages[Count++] = Tracker->DirtyPages[i];
+    }
+
+    Tracker->CountOfDirtyPages   = Count;
+    Tracker->CountOfPlannedPages = 0;
+    Tracker->CountOfBatches      = 0;
+
+    return CountOfPlannedPages;
+}
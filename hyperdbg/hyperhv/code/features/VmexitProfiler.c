@@ -0,0 +1,261 @@
+/**
+ * @file VmexitProfiler.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Implementation of the VM-exit latency and frequency profiler
+ * @details The profiler measures the TSC delta between entering the
+ * VM-exit handler and resuming the guest, and puts it into a log2
+ * histogram for each exit reason. The handling time of the triggered
+ * events is kept with the costs of the events (in the debugger module)
+ * which use the same histograms
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize the VM-exit profiler
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+VmexitProfilerInitialize()
+{
+    ULONG ProcessorsCount;
+
+    //
+    // Query count of active processors
+    //
+    ProcessorsCount = KeQueryActiveProcessorCount(0);
+
+    //
+    // Samples are not collected until the profiler is explicitly enabled
+    //
+    g_VmexitProfilerEnabled = FALSE;
+
+    //
+    // Allocate the per-core samples (page aligned so each core's
+    // structure starts on its own cache line)
+    //
+    g_VmexitProfilerCoreData = (VMEXIT_PROFILER_CORE_DATA *)PlatformMemAllocateZeroedNonPagedPool(
+        ROUND_TO_PAGES(sizeof(VMEXIT_PROFILER_CORE_DATA) * ProcessorsCount));
+
+    if (g_VmexitProfilerCoreData == NULL)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Uninitialize the VM-exit profiler
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerUninitialize()
+{
+    g_VmexitProfilerEnabled = FALSE;
+
+    if (g_VmexitProfilerCoreData != NULL)
+    {
+        PlatformMemFreePool(g_VmexitProfilerCoreData);
+        g_VmexitProfilerCoreData = NULL;
+    }
+}
+
+/**
+ * @brief Enable or disable collecting samples
+ *
+ * @param Enable
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerEnable(BOOLEAN Enable)
+{
+    if (g_VmexitProfilerCoreData == NULL)
+    {
+        //
+        // The profiler is not initialized
+        //
+        return;
+    }
+
+    g_VmexitProfilerEnabled = Enable;
+}
+
+/**
+ * @brief Clear the collected samples on all cores
+ * @details If the profiler is running, the cores might add a few
+ * samples while the buffer is cleared which is fine for a profiler
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerReset()
+{
+    if (g_VmexitProfilerCoreData == NULL)
+    {
+        return;
+    }
+
+    RtlZeroMemory(g_VmexitProfilerCoreData, sizeof(VMEXIT_PROFILER_CORE_DATA) * KeQueryActiveProcessorCount(0));
+
+    //
+    // Also reset the counters of the guest translation cache
+    //
+    TranslationCacheResetStatistics();
+}
+
+/**
+ * @brief Add a sample to a log2 histogram
+ *
+ * @param Histogram
+ * @param Cycles
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles)
+{
+    ULONG Bucket = 0;
+
+    //
+    // Zero and one cycles both go to the first bucket
+    //
+    if (Cycles != 0)
+    {
+        _BitScanReverse64(&Bucket, Cycles);
+
+        if (Bucket >= VMEXIT_PROFILER_HISTOGRAM_BUCKETS)
+        {
+            Bucket = VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    Histogram->Count++;
+    Histogram->TotalCycles += Cycles;
+    Histogram->Buckets[Bucket]++;
+
+    if (Cycles > Histogram->MaxCycles)
+    {
+        Histogram->MaxCycles = Cycles;
+    }
+}
+
+/**
+ * @brief Record the time spent for handling a VM-exit
+ * @details Should be called from vmx-root mode (the VM-exit handler)
+ *
+ * @param CoreId
+ * @param ExitReason
+ * @param Cycles
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerRecordExit(UINT32 CoreId, UINT32 ExitReason, UINT64 Cycles)
+{
+    VMEXIT_PROFILER_RESULTS * Samples = &g_VmexitProfilerCoreData[CoreId].Samples;
+
+    if (ExitReason >= VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS)
+    {
+        Samples->UnknownExitReasons++;
+        return;
+    }
+
+    VmexitProfilerAddSample(&Samples->ExitReasons[ExitReason], Cycles);
+}
+
+/**
+ * @brief Merge two histograms
+ *
+ * @param Destination
+ * @param Source
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerMergeHistogram(VMEXIT_PROFILER_HISTOGRAM * Destination, VMEXIT_PROFILER_HISTOGRAM * Source)
+{
+    Destination->Count += Source->Count;
+    Destination->TotalCycles += Source->TotalCycles;
+
+    if (Source->MaxCycles > Destination->MaxCycles)
+    {
+        Destination->MaxCycles = Source->MaxCycles;
+    }
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        Destination->Buckets[i] += Source->Buckets[i];
+    }
+}
+
+/**
+ * @brief Merge the samples of one core into the results
+ *
+ * @param Results
+ * @param CoreSamples
+ *
+ * @return VOID
+ */
+VOID
+VmexitProfilerMergeCoreData(VMEXIT_PROFILER_RESULTS * Results, VMEXIT_PROFILER_RESULTS * CoreSamples)
+{
+    Results->UnknownExitReasons += CoreSamples->UnknownExitReasons;
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS; i++)
+    {
+        VmexitProfilerMergeHistogram(&Results->ExitReasons[i], &CoreSamples->ExitReasons[i]);
+    }
+}
+
+/**
+ * @brief Query the collected samples
+ *
+ * @param CoreId The target core or DEBUGGER_VMEXIT_PROFILER_ALL_CORES
+ * to aggregate the samples of all cores
+ * @param Results
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+VmexitProfilerQuery(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results)
+{
+    ULONG ProcessorsCount;
+
+    if (g_VmexitProfilerCoreData == NULL)
+    {
+        return FALSE;
+    }
+
+    ProcessorsCount = KeQueryActiveProcessorCount(0);
+
+    if (CoreId != DEBUGGER_VMEXIT_PROFILER_ALL_CORES && CoreId >= ProcessorsCount)
+    {
+        //
+        // Invalid core
+        //
+        return FALSE;
+    }
+
+    RtlZeroMemory(Results, sizeof(VMEXIT_PROFILER_RESULTS));
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        if (CoreId == DEBUGGER_VMEXIT_PROFILER_ALL_CORES || CoreId == i)
+        {
+            VmexitProfilerMergeCoreData(Results, &g_VmexitProfilerCoreData[i].Samples);
+
+            TranslationCacheQueryStatistics(i, &Results->TranslationCacheHits, &Results->TranslationCacheMisses);
+        }
+    }
+
+    return TRUE;
+}
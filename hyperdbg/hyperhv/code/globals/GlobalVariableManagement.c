@@ -19,7 +19,11 @@
 BOOLEAN
 GlobalGuestStateAllocateZeroedMemory(VOID)
 {
-    SSIZE_T BufferSizeInByte = sizeof(VIRTUAL_MACHINE_STATE) * KeQueryActiveProcessorCount(0);
+    //
+    // VIRTUAL_MACHINE_STATE is aligned to the cache line, allocations that are equal or
+    // bigger than a page are page-aligned, so the size is rounded up to pages
+    //
+    SSIZE_T BufferSizeInByte = ROUND_TO_PAGES(sizeof(VIRTUAL_MACHINE_STATE) * KeQueryActiveProcessorCount(0));
 
     //
     // Allocate global variable to hold Guest(s) state
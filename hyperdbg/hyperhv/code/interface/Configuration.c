@@ -87,13 +87,14 @@ ConfigureModeBasedExecHookUninitializeOnAllProcessors()
 
 /**
  * @brief routines for initializing dirty logging mechanism
+ * @details Should be called at PASSIVE_LEVEL
  *
- * @return VOID
+ * @return BOOLEAN
  */
-VOID
+BOOLEAN
 ConfigureDirtyLoggingInitializeOnAllProcessors()
 {
-    DirtyLoggingInitialize();
+    return DirtyLoggingInitialize();
 }
 
 /**
@@ -107,6 +108,102 @@ ConfigureDirtyLoggingUninitializeOnAllProcessors()
     DirtyLoggingUninitialize();
 }
 
+/**
+ * @brief routines for enabling dirty logging mechanism (PML) on all cores
+ *
+ * @return VOID
+ */
+VOID
+ConfigureDirtyLoggingEnableOnAllProcessors()
+{
+    BroadcastEnablePmlOnAllProcessors();
+}
+
+/**
+ * @brief routines for disabling dirty logging mechanism (PML) on all cores
+ *
+ * @return VOID
+ */
+VOID
+ConfigureDirtyLoggingDisableOnAllProcessors()
+{
+    BroadcastDisablePmlOnAllProcessors();
+}
+
+/**
+ * @brief routines for flushing the PML buffers of all cores into the dirty bitmap
+ *
+ * @return VOID
+ */
+VOID
+ConfigureDirtyLoggingFlushOnAllProcessors()
+{
+    BroadcastFlushPmlBuffersOnAllProcessors();
+}
+
+/**
+ * @brief routines for allocating the buffers of the memory snapshot
+ * @details Should be called at PASSIVE_LEVEL
+ *
+ * @param MaximumPages Maximum number of pages that could be saved
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+ConfigureSnapshotAllocateBuffers(UINT32 MaximumPages)
+{
+    return SnapshotAllocateBuffers(MaximumPages);
+}
+
+/**
+ * @brief routines for reserving the buffers of splitting the large pages of
+ * the memory snapshot
+ * @details Should be called at PASSIVE_LEVEL
+ *
+ * @param StartAddress Start physical address of the range
+ * @param EndAddress End physical address of the range
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+ConfigureSnapshotReserveSplitBuffers(UINT64 StartAddress, UINT64 EndAddress)
+{
+    return SnapshotReserveSplitBuffers(StartAddress, EndAddress);
+}
+
+/**
+ * @brief routines for write-protecting the pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+ConfigureSnapshotProtectPagesOnAllProcessors()
+{
+    BroadcastSnapshotProtectPagesOnAllProcessors();
+}
+
+/**
+ * @brief routines for removing the write protection of the pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+ConfigureSnapshotUnprotectPagesOnAllProcessors()
+{
+    BroadcastSnapshotUnprotectPagesOnAllProcessors();
+}
+
+/**
+ * @brief routines for restoring the modified pages of the memory snapshot on all cores
+ *
+ * @return VOID
+ */
+VOID
+ConfigureSnapshotRestorePagesOnAllProcessors()
+{
+    BroadcastSnapshotRestorePagesOnAllProcessors();
+}
+
 /**
  * @brief routines for debugging threads (disable mov-to-cr3 exiting)
  *
@@ -529,3 +529,111 @@ DirectVmcallDisableMov2CrExitingForClearingCrEvents(UINT32                     C
     //
     return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_DISABLE_MOV_TO_CR_EXITING_ONLY_FOR_CR_EVENTS, DirectVmcallOptions);
 }
+
+/**
+ * @brief routines for enabling the dirty logging mechanism (PML)
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallEnableDirtyLogging(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_ENABLE_DIRTY_LOGGING_MECHANISM, DirectVmcallOptions);
+}
+
+/**
+ * @brief routines for disabling the dirty logging mechanism (PML)
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallDisableDirtyLogging(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_DISABLE_DIRTY_LOGGING_MECHANISM, DirectVmcallOptions);
+}
+
+/**
+ * @brief routines for flushing the PML buffer into the dirty bitmap
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallFlushDirtyLoggingBuffer(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_FLUSH_DIRTY_LOGGING_BUFFER, DirectVmcallOptions);
+}
+
+/**
+ * @brief routines for write-protecting the pages of the memory snapshot
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallSnapshotProtectPages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_SNAPSHOT_PROTECT_PAGES, DirectVmcallOptions);
+}
+
+/**
+ * @brief routines for removing the write protection of the pages of the memory snapshot
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallSnapshotUnprotectPages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_SNAPSHOT_UNPROTECT_PAGES, DirectVmcallOptions);
+}
+
+/**
+ * @brief routines for restoring the modified pages of the memory snapshot
+ * @details Should be called from VMX root-mode
+ *
+ * @param CoreId
+ * @param DirectVmcallOptions
+ *
+ * @return NTSTATUS
+ */
+NTSTATUS
+DirectVmcallSnapshotRestorePages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions)
+{
+    //
+    // Call the VMCALL handler (directly)
+    //
+    return VmxVmcallDirectVmcallHandler(&g_GuestState[CoreId], VMCALL_SNAPSHOT_RESTORE_PAGES, DirectVmcallOptions);
+}
@@ -838,3 +838,169 @@ VmFuncApicStoreIoApicFields(IO_APIC_ENTRY_PACKETS * IoApicPackets)
 {
     return ApicStoreIoApicFields(IoApicPackets);
 }
+
+/**
+ * @brief Enable or disable the VM-exit profiler
+ * @param Enable
+ *
+ * @return VOID
+ */
+VOID
+VmFuncVmexitProfilerEnable(BOOLEAN Enable)
+{
+    VmexitProfilerEnable(Enable);
+}
+
+/**
+ * @brief Clear the samples of the VM-exit profiler
+ *
+ * @return VOID
+ */
+VOID
+VmFuncVmexitProfilerReset()
+{
+    VmexitProfilerReset();
+}
+
+/**
+ * @brief Query the samples of the VM-exit profiler
+ * @param CoreId
+ * @param Results
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+VmFuncVmexitProfilerQuery(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results)
+{
+    return VmexitProfilerQuery(CoreId, Results);
+}
+
+/**
+ * @brief Add a sample to a histogram of the VM-exit profiler
+ * @param Histogram
+ * @param Cycles
+ *
+ * @return VOID
+ */
+VOID
+VmFuncVmexitProfilerAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles)
+{
+    VmexitProfilerAddSample(Histogram, Cycles);
+}
+
+/**
+ * @brief Merge two histograms of the VM-exit profiler
+ * @param Destination
+ * @param Source
+ *
+ * @return VOID
+ */
+VOID
+VmFuncVmexitProfilerMergeHistogram(VMEXIT_PROFILER_HISTOGRAM * Destination, VMEXIT_PROFILER_HISTOGRAM * Source)
+{
+    VmexitProfilerMergeHistogram(Destination, Source);
+}
+
+/**
+ * @brief Clear the bitmap of the dirty pages
+ *
+ * @return BOOLEAN FALSE if the dirty logging mechanism is not supported
+ */
+BOOLEAN
+VmFuncDirtyLoggingResetDirtyPages()
+{
+    return DirtyLoggingResetDirtyPages();
+}
+
+/**
+ * @brief Collect (read and reset) the dirty pages of a range of physical pages
+ * @param FirstPageFrameNumber
+ * @param EndPageFrameNumber
+ * @param Entries
+ * @param MaximumEntries
+ * @param NextPageFrameNumber
+ *
+ * @return UINT32 Number of the filled entries
+ */
+UINT32
+VmFuncDirtyLoggingCollectDirtyPages(UINT64                       FirstPageFrameNumber,
+                                    UINT64                       EndPageFrameNumber,
+                                    DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                                    UINT32                       MaximumEntries,
+                                    UINT64 *                     NextPageFrameNumber)
+{
+    return DirtyLoggingCollectDirtyPages(FirstPageFrameNumber,
+                                         EndPageFrameNumber,
+                                         Entries,
+                                         MaximumEntries,
+                                         NextPageFrameNumber);
+}
+
+/**
+ * @brief Take a snapshot of a range of the physical memory
+ * @param StartAddress
+ * @param EndAddress
+ *
+ * @return BOOLEAN FALSE if the buffers are not allocated or a snapshot is already taken
+ */
+BOOLEAN
+VmFuncSnapshotTake(UINT64 StartAddress, UINT64 EndAddress)
+{
+    return SnapshotTake(StartAddress, EndAddress);
+}
+
+/**
+ * @brief Check whether the pages of the snapshot are protected on all cores
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+VmFuncSnapshotIsProtected()
+{
+    return SnapshotIsProtected();
+}
+
+/**
+ * @brief Discard the snapshot (the pages should be already unprotected)
+ *
+ * @return VOID
+ */
+VOID
+VmFuncSnapshotDiscard()
+{
+    SnapshotDiscard();
+}
+
+/**
+ * @brief Plan restoring the modified pages of the snapshot
+ *
+ * @return VOID
+ */
+VOID
+VmFuncSnapshotPrepareRestore()
+{
+    SnapshotPrepareRestore();
+}
+
+/**
+ * @brief Finish restoring the snapshot
+ *
+ * @return BOOLEAN FALSE if some of the modified pages could not be restored
+ */
+BOOLEAN
+VmFuncSnapshotFinishRestore()
+{
+    return SnapshotFinishRestore();
+}
+
+/**
+ * @brief Query the statistics of the snapshot
+ * @param Statistics
+ *
+ * @return BOOLEAN Whether the snapshot is taken or not
+ */
+BOOLEAN
+VmFuncSnapshotQuery(DEBUGGER_SNAPSHOT_STATISTICS * Statistics)
+{
+    return SnapshotQuery(Statistics);
+}
@@ -156,7 +156,6 @@ BOOLEAN
 CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
 {
     CR3_TYPE GuestCr3;
-    UINT64   OriginalCr3;
     BOOLEAN  IsKernelAddress;
     BOOLEAN  Result = FALSE;
 
@@ -178,12 +177,6 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
     //
     GuestCr3.Flags = LayoutGetCurrentProcessCr3().Flags;
 
-    //
-    // Move to new cr3
-    //
-    OriginalCr3 = __readcr3();
-    __writecr3(GuestCr3.Flags);
-
     //
     // We'll only check address with TSX if the address is a kernel-mode
     // address because an exception is thrown if we access user-mode code
@@ -209,7 +202,7 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
     //             //
     //             Result = FALSE;
     //
-    //             goto RestoreCr3;
+    //             goto Return;
     //         }
     //     }
     // }
@@ -223,7 +216,9 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
     //
 
     //
-    // Check if memory is safe and present
+    // Check if memory is safe and present, translations are looked up
+    // in the translation cache first and the page-tables are only walked
+    // (by switching to the guest cr3) on misses
     //
     UINT64 AddressToCheck = (CHAR *)TargetAddress + Size - ((CHAR *)PAGE_ALIGN(TargetAddress));
 
@@ -243,14 +238,14 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
                 ReadSize = Size;
             }
 
-            if (!MemoryMapperCheckIfPageIsPresentByCr3((PVOID)TargetAddress, GuestCr3))
+            if (!TranslationCacheTranslate(GuestCr3, TargetAddress, NULL, NULL))
             {
                 //
                 // Address is not valid
                 //
                 Result = FALSE;
 
-                goto RestoreCr3;
+                goto Return;
             }
 
             /*
@@ -269,14 +264,14 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
     }
     else
     {
-        if (!MemoryMapperCheckIfPageIsPresentByCr3((PVOID)TargetAddress, GuestCr3))
+        if (!TranslationCacheTranslate(GuestCr3, TargetAddress, NULL, NULL))
         {
             //
             // Address is not valid
             //
             Result = FALSE;
 
-            goto RestoreCr3;
+            goto Return;
         }
     }
 
@@ -285,13 +280,6 @@ CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
     //
     Result = TRUE;
 
-RestoreCr3:
-
-    //
-    // Move back to original cr3
-    //
-    __writecr3(OriginalCr3);
-
 Return:
     return Result;
 }
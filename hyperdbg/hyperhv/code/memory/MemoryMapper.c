@@ -650,6 +650,214 @@ MemoryMapperMapPageAndGetPte(PUINT64 PteAddress)
     return Va;
 }
 
+/**
+ * @brief This function reserves the multi-page window and the large page
+ * window of a core
+ * @details The PTEs of the window are not necessarily contiguous (the pages
+ * might be in different page-tables), so the PTE of each page is saved
+ *
+ * @param MemoryMapper The memory mapper details of the target core
+ * @return VOID
+ */
+_Use_decl_annotations_
+VOID
+MemoryMapperReserveRange(PMEMORY_MAPPER_ADDRESSES MemoryMapper)
+{
+    PVOID Va;
+
+    //
+    // Reserve the multi-page window from system va space
+    //
+    Va = MemoryMapperMapReservedPageRange(MEMORY_MAPPER_RANGE_PAGES * PAGE_SIZE);
+
+    if (Va != NULL)
+    {
+        MemoryMapper->VirtualAddressForRange = (UINT64)Va;
+
+        for (UINT32 i = 0; i < MEMORY_MAPPER_RANGE_PAGES; i++)
+        {
+            MemoryMapper->PteVirtualAddressesForRange[i] = (UINT64)MemoryMapperGetPte((PVOID)((UINT64)Va + i * PAGE_SIZE));
+        }
+    }
+
+    //
+    // Reserve two large pages, so there is always one large page aligned
+    // address (and its PDE) inside the reserved range
+    //
+    Va = MemoryMapperMapReservedPageRange(2 * (PAGE_2MB_OFFSET + 1));
+
+    if (Va != NULL)
+    {
+        MemoryMapper->ReservedAddressForLargeRange   = (UINT64)Va;
+        MemoryMapper->VirtualAddressForLargeRange    = ((UINT64)Va + PAGE_2MB_OFFSET) & ~PAGE_2MB_OFFSET;
+        MemoryMapper->PdeVirtualAddressForLargeRange = (UINT64)MemoryMapperGetPteVa((PVOID)MemoryMapper->VirtualAddressForLargeRange,
+                                                                                    PagingLevelPageDirectory);
+    }
+}
+
+/**
+ * @brief Map a physical page into one of the pages of the multi-page window
+ * @details The caller should invalidate the window after mapping all of
+ * the pages by using MemoryMapperInvalidateRange
+ *
+ * @param MemoryMapper The memory mapper details of the current core
+ * @param Index Index of the page in the window
+ * @param PhysicalAddress The physical address to map
+ * @return VOID
+ */
+_Use_decl_annotations_
+VOID
+MemoryMapperMapPageInRange(PMEMORY_MAPPER_ADDRESSES MemoryMapper, UINT32 Index, UINT64 PhysicalAddress)
+{
+    PAGE_ENTRY  PageEntry;
+    PPAGE_ENTRY Pte = (PAGE_ENTRY *)MemoryMapper->PteVirtualAddressesForRange[Index];
+
+    //
+    // Same as mapping a single page, the page is writable and global
+    //
+    PageEntry.Flags                  = Pte->Flags;
+    PageEntry.Fields.Present         = 1;
+    PageEntry.Fields.Write           = 1;
+    PageEntry.Fields.Global          = 1;
+    PageEntry.Fields.PageFrameNumber = PhysicalAddress >> 12;
+
+    //
+    // Apply the page entry in a single instruction
+    //
+    Pte->Flags = PageEntry.Flags;
+}
+
+/**
+ * @brief Invalidate the mapped pages of the multi-page window in
+ * a single pass
+ *
+ * @param MemoryMapper The memory mapper details of the current core
+ * @param PageCount Number of mapped pages
+ * @return VOID
+ */
+_Use_decl_annotations_
+VOID
+MemoryMapperInvalidateRange(PMEMORY_MAPPER_ADDRESSES MemoryMapper, UINT32 PageCount)
+{
+    for (UINT32 i = 0; i < PageCount; i++)
+    {
+        __invlpg((PVOID)(MemoryMapper->VirtualAddressForRange + i * PAGE_SIZE));
+    }
+}
+
+/**
+ * @brief Check whether a large page frame could be mapped by a single
+ * write-back large page
+ * @details The MTRRs should describe the whole frame with the same memory
+ * type (otherwise the frame might contain MMIO ranges) and the type should
+ * be write-back, the check is based on the MTRR map of EPT
+ *
+ * @param FrameAddress The physical address of the large page frame
+ * @return BOOLEAN
+ */
+_Use_decl_annotations_
+BOOLEAN
+MemoryMapperCheckIfLargeFrameIsWriteBack(UINT64 FrameAddress)
+{
+    SIZE_T PageFrameNumber = (SIZE_T)(FrameAddress / SIZE_2_MB);
+
+    if (g_EptState == NULL)
+    {
+        //
+        // The MTRR map is not built yet
+        //
+        return FALSE;
+    }
+
+    if (!EptIsValidForLargePage(PageFrameNumber))
+    {
+        //
+        // The frame lands on more than one memory type
+        //
+        return FALSE;
+    }
+
+    return EptGetMemoryType(PageFrameNumber, TRUE) == MEMORY_TYPE_WRITE_BACK;
+}
+
+/**
+ * @brief Map a physically contiguous range by a single large page
+ * @details The large page frame that contains the physical address is mapped
+ * by replacing the PDE of the large window, the first large page frame is
+ * never mapped as it contains legacy MMIO ranges and the other frames are
+ * only mapped if the whole frame is write-back
+ *
+ * @param MemoryMapper The memory mapper details of the current core
+ * @param PhysicalAddress The physical address to map
+ * @param Size Size of the range
+ * @param MappedSize Size of the range that is accessible from the returned address
+ * @return PVOID The address of the mapped physical address or NULL if the range
+ * could not be mapped by a large page
+ */
+_Use_decl_annotations_
+PVOID
+MemoryMapperMapLargeRange(PMEMORY_MAPPER_ADDRESSES MemoryMapper, UINT64 PhysicalAddress, SIZE_T Size, PSIZE_T MappedSize)
+{
+    PAGE_ENTRY  PageEntry     = {0};
+    PPAGE_ENTRY Pde           = (PAGE_ENTRY *)MemoryMapper->PdeVirtualAddressForLargeRange;
+    UINT64      FrameAddress  = PhysicalAddress & ~PAGE_2MB_OFFSET;
+    UINT64      AvailableSize = (PAGE_2MB_OFFSET + 1) - (PhysicalAddress & PAGE_2MB_OFFSET);
+
+    *MappedSize = 0;
+
+    if (Pde == NULL || FrameAddress == NULL64_ZERO)
+    {
+        return NULL;
+    }
+
+    //
+    // It's only worth it if the rest of the frame doesn't fit into the
+    // multi-page window
+    //
+    if (AvailableSize <= MEMORY_MAPPER_RANGE_PAGES * PAGE_SIZE)
+    {
+        return NULL;
+    }
+
+    //
+    // The PDE should point to the page-table of the reserved range
+    //
+    if (!Pde->Fields.Present || Pde->Fields.LargePage)
+    {
+        return NULL;
+    }
+
+    //
+    // A large page applies a single memory type to the whole frame, so the
+    // frames with other types (or more than one type) are mapped by 4KB pages
+    //
+    if (!MemoryMapperCheckIfLargeFrameIsWriteBack(FrameAddress))
+    {
+        return NULL;
+    }
+
+    MemoryMapper->OriginalPdeForLargeRange = Pde->Flags;
+
+    PageEntry.Fields.Present         = 1;
+    PageEntry.Fields.Write           = 1;
+    PageEntry.Fields.LargePage       = 1;
+    PageEntry.Fields.ExecuteDisable  = 1;
+    PageEntry.Fields.PageFrameNumber = FrameAddress >> 12;
+
+    //
+    // Apply the page entry in a single instruction and invalidate it
+    //
+    Pde->Flags = PageEntry.Flags;
+
+    __invlpg((PVOID)MemoryMapper->VirtualAddressForLargeRange);
+
+    MemoryMapper->IsLargeRangeMapped = TRUE;
+
+    *MappedSize = Size < AvailableSize ? Size : AvailableSize;
+
+    return (PVOID)(MemoryMapper->VirtualAddressForLargeRange + (PhysicalAddress & PAGE_2MB_OFFSET));
+}
+
 /**
  * @brief Initialize the Memory Mapper
  * @details This function should be called in vmx non-root
@@ -702,6 +910,11 @@ MemoryMapperInitialize()
         //
         g_MemoryMapper[i].VirualAddressForWrite     = (UINT64)MemoryMapperMapPageAndGetPte(&TempPte);
         g_MemoryMapper[i].PteVirtualAddressForWrite = TempPte;
+
+        //
+        // Reserve the multi-page windows for bulk operations
+        //
+        MemoryMapperReserveRange(&g_MemoryMapper[i]);
     }
 }
 
@@ -737,6 +950,23 @@ MemoryMapperUninitialize()
 
         g_MemoryMapper[i].VirualAddressForWrite     = NULL64_ZERO;
         g_MemoryMapper[i].PteVirtualAddressForWrite = NULL64_ZERO;
+
+        if (g_MemoryMapper[i].VirtualAddressForRange != NULL64_ZERO)
+        {
+            MemoryMapperUnmapReservedPageRange((PVOID)g_MemoryMapper[i].VirtualAddressForRange);
+        }
+
+        if (g_MemoryMapper[i].ReservedAddressForLargeRange != NULL64_ZERO)
+        {
+            MemoryMapperUnmapReservedPageRange((PVOID)g_MemoryMapper[i].ReservedAddressForLargeRange);
+        }
+
+        RtlZeroMemory(g_MemoryMapper[i].PteVirtualAddressesForRange, sizeof(g_MemoryMapper[i].PteVirtualAddressesForRange));
+
+        g_MemoryMapper[i].VirtualAddressForRange         = NULL64_ZERO;
+        g_MemoryMapper[i].ReservedAddressForLargeRange   = NULL64_ZERO;
+        g_MemoryMapper[i].VirtualAddressForLargeRange    = NULL64_ZERO;
+        g_MemoryMapper[i].PdeVirtualAddressForLargeRange = NULL64_ZERO;
     }
 
     //
@@ -745,6 +975,285 @@ MemoryMapperUninitialize()
     g_MemoryMapper = NULL;
 }
 
+/**
+ * @brief Map a range of memory for reading or writing into the multi-page window
+ * of the current core
+ * @details The read and write accesses only differ in converting the addresses
+ * of the pages to physical addresses
+ *
+ * @param IsWrite Whether the range is mapped for a write access or a read access
+ * @param TypeOfAccess Type of read (MEMORY_MAPPER_WRAPPER_FOR_MEMORY_READ) or
+ * type of write (MEMORY_MAPPER_WRAPPER_FOR_MEMORY_WRITE)
+ * @param Address The address to map
+ * @param Size Size of the range
+ * @param TargetProcessCr3 The process CR3 of write accesses (might be null)
+ * @param TargetProcessId The process PID of write accesses (might be null)
+ * @param MappedSize Size of the range that is accessible from the returned address
+ * @return PVOID The linear address of the mapped range or NULL if it fails
+ */
+_Use_decl_annotations_
+PVOID
+MemoryMapperMapRangeForAccess(BOOLEAN   IsWrite,
+                              UINT32    TypeOfAccess,
+                              UINT64    Address,
+                              SIZE_T    Size,
+                              PCR3_TYPE TargetProcessCr3,
+                              UINT32    TargetProcessId,
+                              PSIZE_T   MappedSize)
+{
+    PMEMORY_MAPPER_ADDRESSES MemoryMapper;
+    PVOID                    MappedAddress;
+    UINT64                   PhysicalAddress;
+    UINT64                   PageAddress;
+    UINT64                   PageOffset = Address & PAGE_4KB_OFFSET;
+    UINT64                   PageCount;
+    UINT64                   AvailableSize;
+    BOOLEAN                  IsPhysical;
+
+    *MappedSize = 0;
+
+    if (g_MemoryMapper == NULL || Size == 0)
+    {
+        return NULL;
+    }
+
+    MemoryMapper = &g_MemoryMapper[KeGetCurrentProcessorNumberEx(NULL)];
+
+    if (MemoryMapper->VirtualAddressForRange == NULL64_ZERO)
+    {
+        //
+        // Not initialized
+        //
+        return NULL;
+    }
+
+    IsPhysical = IsWrite ? TypeOfAccess == MEMORY_MAPPER_WRAPPER_WRITE_PHYSICAL_MEMORY
+                         : TypeOfAccess == MEMORY_MAPPER_WRAPPER_READ_PHYSICAL_MEMORY;
+
+    //
+    // Physical addresses are contiguous, so if the range doesn't fit into the
+    // window, a large page is used
+    //
+    if (IsPhysical && PageOffset + Size > MEMORY_MAPPER_RANGE_PAGES * PAGE_SIZE)
+    {
+        MappedAddress = MemoryMapperMapLargeRange(MemoryMapper, Address, Size, MappedSize);
+
+        if (MappedAddress != NULL)
+        {
+            return MappedAddress;
+        }
+    }
+
+    //
+    // Map each page of the range into the window
+    //
+    PageCount = (PageOffset + Size + PAGE_4KB_OFFSET) >> 12;
+
+    if (PageCount > MEMORY_MAPPER_RANGE_PAGES)
+    {
+        PageCount = MEMORY_MAPPER_RANGE_PAGES;
+    }
+
+    for (UINT32 i = 0; i < PageCount; i++)
+    {
+        PageAddress = (Address & ~PAGE_4KB_OFFSET) + i * PAGE_SIZE;
+
+        if (IsWrite)
+        {
+            PhysicalAddress = MemoryMapperWriteMemorySafeWrapperAddressMaker((MEMORY_MAPPER_WRAPPER_FOR_MEMORY_WRITE)TypeOfAccess,
+                                                                             PageAddress,
+                                                                             TargetProcessCr3,
+                                                                             TargetProcessId);
+        }
+        else
+        {
+            PhysicalAddress = MemoryMapperReadMemorySafeByPhysicalAddressWrapperAddressMaker((MEMORY_MAPPER_WRAPPER_FOR_MEMORY_READ)TypeOfAccess,
+                                                                                             PageAddress);
+        }
+
+        if (!IsPhysical && PhysicalAddress == NULL64_ZERO)
+        {
+            //
+            // The page is not mapped, so the range ends before this page
+            //
+            PageCount = i;
+            break;
+        }
+
+        MemoryMapperMapPageInRange(MemoryMapper, i, PhysicalAddress);
+    }
+
+    if (PageCount == 0)
+    {
+        return NULL;
+    }
+
+    MemoryMapper->MappedPagesInRange = (UINT32)PageCount;
+
+    //
+    // Invalidate all of the mapped pages at once
+    //
+    MemoryMapperInvalidateRange(MemoryMapper, (UINT32)PageCount);
+
+    AvailableSize = PageCount * PAGE_SIZE - PageOffset;
+    *MappedSize   = Size < AvailableSize ? Size : AvailableSize;
+
+    return (PVOID)(MemoryMapper->VirtualAddressForRange + PageOffset);
+}
+
+/**
+ * @brief Map a range of memory into the multi-page window of the current core
+ * @details The pages are mapped with a single invalidation pass and the returned
+ * address is a linear view of the range. Physically contiguous ranges that don't
+ * fit into the window are mapped by a large page (if possible). At most one range
+ * could be mapped on each core, so MemoryMapperUnmapRange should be called before
+ * mapping another range. This function should be called in vmx-root mode or at
+ * IRQL >= DISPATCH_LEVEL. Callers that write into the mapped range should call
+ * TranslationCacheInvalidate after unmapping it
+ *
+ * @param TypeOfAddress Whether the address is a physical address or a virtual address
+ * (based on the current cr3)
+ * @param Address The address to map
+ * @param Size Size of the range
+ * @param MappedSize Size of the range that is accessible from the returned address
+ * (it might be less than the requested size)
+ * @return PVOID The linear address of the mapped range or NULL if it fails
+ */
+_Use_decl_annotations_
+PVOID
+MemoryMapperMapRange(MEMORY_MAPPER_WRAPPER_FOR_MEMORY_READ TypeOfAddress,
+                     UINT64                                Address,
+                     SIZE_T                                Size,
+                     PSIZE_T                               MappedSize)
+{
+    return MemoryMapperMapRangeForAccess(FALSE, TypeOfAddress, Address, Size, NULL, NULL_ZERO, MappedSize);
+}
+
+/**
+ * @brief Unmap the range that is previously mapped by MemoryMapperMapRange
+ * on the current core
+ *
+ * @return VOID
+ */
+VOID
+MemoryMapperUnmapRange()
+{
+    PMEMORY_MAPPER_ADDRESSES MemoryMapper;
+
+    if (g_MemoryMapper == NULL)
+    {
+        return;
+    }
+
+    MemoryMapper = &g_MemoryMapper[KeGetCurrentProcessorNumberEx(NULL)];
+
+    if (MemoryMapper->IsLargeRangeMapped)
+    {
+        //
+        // Restore the original PDE, the large page translation should be removed
+        // from the TLB as the reserved range is later used by the page-table
+        //
+        ((PAGE_ENTRY *)MemoryMapper->PdeVirtualAddressForLargeRange)->Flags = MemoryMapper->OriginalPdeForLargeRange;
+
+        __invlpg((PVOID)MemoryMapper->VirtualAddressForLargeRange);
+
+        MemoryMapper->IsLargeRangeMapped = FALSE;
+
+        return;
+    }
+
+    //
+    // Unmap the pages, same as a single page, the invalidation is performed
+    // on the next mapping
+    //
+    for (UINT32 i = 0; i < MemoryMapper->MappedPagesInRange; i++)
+    {
+        ((PAGE_ENTRY *)MemoryMapper->PteVirtualAddressesForRange[i])->Flags = NULL64_ZERO;
+    }
+
+    MemoryMapper->MappedPagesInRange = 0;
+}
+
+/**
+ * @brief Read or write a range of memory that passes from the page boundary
+ * by mapping it into the multi-page window (or the large window) of the
+ * current core
+ *
+ * @param IsWrite Whether the buffer is written into the range or the range
+ * is read into the buffer
+ * @param TypeOfAccess Type of read (MEMORY_MAPPER_WRAPPER_FOR_MEMORY_READ) or
+ * type of write (MEMORY_MAPPER_WRAPPER_FOR_MEMORY_WRITE)
+ * @param Address The address of the range
+ * @param Buffer The buffer to save the range or the source of the write
+ * @param Size Size of the range
+ * @param TargetProcessCr3 The process CR3 of write accesses (might be null)
+ * @param TargetProcessId The process PID of write accesses (might be null)
+ * @return BOOLEAN returns TRUE if it was successful and FALSE if there was error
+ */
+_Use_decl_annotations_
+BOOLEAN
+MemoryMapperCopyRange(BOOLEAN   IsWrite,
+                      UINT32    TypeOfAccess,
+                      UINT64    Address,
+                      UINT64    Buffer,
+                      SIZE_T    Size,
+                      PCR3_TYPE TargetProcessCr3,
+                      UINT32    TargetProcessId)
+{
+    SIZE_T  MappedSize;
+    PVOID   MappedAddress;
+    BOOLEAN Result = TRUE;
+
+    while (Size != 0)
+    {
+        MappedAddress = MemoryMapperMapRangeForAccess(IsWrite,
+                                                      TypeOfAccess,
+                                                      Address,
+                                                      Size,
+                                                      TargetProcessCr3,
+                                                      TargetProcessId,
+                                                      &MappedSize);
+
+        if (MappedAddress == NULL)
+        {
+            Result = FALSE;
+            break;
+        }
+
+        //
+        // Move the range in a safe manner
+        //
+        if (IsWrite)
+        {
+            memcpy(MappedAddress, (PVOID)Buffer, MappedSize);
+        }
+        else
+        {
+            memcpy((PVOID)Buffer, MappedAddress, MappedSize);
+        }
+
+        MemoryMapperUnmapRange();
+
+        //
+        // Apply the changes to the next addresses (if any)
+        //
+        Size    = Size - MappedSize;
+        Address = Address + MappedSize;
+        Buffer  = Buffer + MappedSize;
+    }
+
+    if (IsWrite)
+    {
+        //
+        // The written memory might be a page-table, so the cached
+        // guest translations are invalidated
+        //
+        TranslationCacheInvalidate();
+    }
+
+    return Result;
+}
+
 /**
  * @brief Read memory safely by mapping the buffer using PTE
  * @param PaAddressToRead Physical address to read
@@ -913,6 +1422,12 @@ MemoryMapperWriteMemorySafeByPte(PVOID            SourceVA,
     //
     Pte->Flags = NULL64_ZERO;
 
+    //
+    // The written memory might be a page-table, so the cached
+    // guest translations are invalidated
+    //
+    TranslationCacheInvalidate();
+
     return TRUE;
 }
 
@@ -931,6 +1446,7 @@ MemoryMapperReadMemorySafeByPhysicalAddressWrapperAddressMaker(
     UINT64                                AddressToRead)
 {
     PHYSICAL_ADDRESS PhysicalAddress = {0};
+    CR3_TYPE         CurrentCr3;
 
     switch (TypeOfRead)
     {
@@ -942,7 +1458,15 @@ MemoryMapperReadMemorySafeByPhysicalAddressWrapperAddressMaker(
 
     case MEMORY_MAPPER_WRAPPER_READ_VIRTUAL_MEMORY:
 
-        PhysicalAddress.QuadPart = VirtualAddressToPhysicalAddress((PVOID)AddressToRead);
+        //
+        // Translate based on the current cr3 (the translation is cached in vmx-root)
+        //
+        CurrentCr3.Flags = __readcr3();
+
+        if (!TranslationCacheTranslate(CurrentCr3, AddressToRead, (PUINT64)&PhysicalAddress.QuadPart, NULL))
+        {
+            PhysicalAddress.QuadPart = VirtualAddressToPhysicalAddress((PVOID)AddressToRead);
+        }
 
         break;
 
@@ -998,52 +1522,11 @@ MemoryMapperReadMemorySafeByPhysicalAddressWrapper(
     if (AddressToCheck > PAGE_SIZE)
     {
         //
-        // Address should be accessed in more than one page
+        // Address should be accessed in more than one page, so the pages are
+        // mapped into the multi-page window (up to MEMORY_MAPPER_RANGE_PAGES
+        // pages or a large page at a time)
         //
-        UINT64 ReadSize = AddressToCheck;
-
-        while (SizeToRead != 0)
-        {
-            ReadSize = (UINT64)PAGE_ALIGN(AddressToRead + PAGE_SIZE) - AddressToRead;
-
-            if (ReadSize == PAGE_SIZE && SizeToRead < PAGE_SIZE)
-            {
-                ReadSize = SizeToRead;
-            }
-
-            /*
-            LogInfo("Addr From : %llx to Addr To : %llx | ReadSize : %llx\n",
-                    AddressToRead,
-                    AddressToRead + ReadSize,
-                    ReadSize);
-            */
-
-            //
-            // One access is enough (page+size won't pass from the PAGE_ALIGN boundary)
-            //
-            PhysicalAddress.QuadPart = MemoryMapperReadMemorySafeByPhysicalAddressWrapperAddressMaker(TypeOfRead,
-                                                                                                      AddressToRead);
-
-            if (!MemoryMapperReadMemorySafeByPte(
-                    PhysicalAddress,
-                    (PVOID)BufferToSaveMemory,
-                    ReadSize,
-                    g_MemoryMapper[CurrentCore].PteVirtualAddressForRead,
-                    g_MemoryMapper[CurrentCore].VirualAddressForRead,
-                    FALSE))
-            {
-                return FALSE;
-            }
-
-            //
-            // Apply the changes to the next addresses (if any)
-            //
-            SizeToRead         = SizeToRead - ReadSize;
-            AddressToRead      = AddressToRead + ReadSize;
-            BufferToSaveMemory = BufferToSaveMemory + ReadSize;
-        }
-
-        return TRUE;
+        return MemoryMapperCopyRange(FALSE, TypeOfRead, AddressToRead, BufferToSaveMemory, SizeToRead, NULL, NULL_ZERO);
     }
     else
     {
@@ -1304,49 +1787,11 @@ MemoryMapperWriteMemorySafeWrapper(MEMORY_MAPPER_WRAPPER_FOR_MEMORY_WRITE TypeOf
     if (AddressToCheck > PAGE_SIZE)
     {
         //
-        // It need multiple accesses to different pages to access the memory
+        // It need multiple accesses to different pages to access the memory, so
+        // the pages are mapped into the multi-page window (up to
+        // MEMORY_MAPPER_RANGE_PAGES pages or a large page at a time)
         //
-
-        UINT64 WriteSize = AddressToCheck;
-
-        while (SizeToWrite != 0)
-        {
-            WriteSize = (UINT64)PAGE_ALIGN(DestinationAddr + PAGE_SIZE) - DestinationAddr;
-
-            if (WriteSize == PAGE_SIZE && SizeToWrite < PAGE_SIZE)
-            {
-                WriteSize = SizeToWrite;
-            }
-
-            /*
-            LogInfo("Addr From : %llx to Addr To : %llx | WriteSize : %llx\n",
-                    DestinationAddr,
-                    DestinationAddr + WriteSize,
-                    WriteSize);
-            */
-
-            PhysicalAddress.QuadPart = MemoryMapperWriteMemorySafeWrapperAddressMaker(TypeOfWrite,
-                                                                                      DestinationAddr,
-                                                                                      TargetProcessCr3,
-                                                                                      TargetProcessId);
-
-            if (!MemoryMapperWriteMemorySafeByPte(
-                    (PVOID)Source,
-                    PhysicalAddress,
-                    WriteSize,
-                    g_MemoryMapper[CurrentCore].PteVirtualAddressForWrite,
-                    g_MemoryMapper[CurrentCore].VirualAddressForWrite,
-                    FALSE))
-            {
-                return FALSE;
-            }
-
-            SizeToWrite     = SizeToWrite - WriteSize;
-            DestinationAddr = DestinationAddr + WriteSize;
-            Source          = Source + WriteSize;
-        }
-
-        return TRUE;
+        return MemoryMapperCopyRange(TRUE, TypeOfWrite, DestinationAddr, Source, SizeToWrite, TargetProcessCr3, TargetProcessId);
     }
     else
     {
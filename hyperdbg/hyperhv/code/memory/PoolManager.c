@@ -17,27 +17,229 @@
 // Private Interfaces
 //
 
-BOOLEAN
-PlmgrAllocateRequestNewAllocation(SIZE_T NumberOfBytes)
+/**
+ * @brief Push a free pool to the global depot of its intention (lock-free)
+ *
+ * @param IntentionState
+ * @param PoolTable
+ * @return VOID
+ */
+VOID
+PlmgrDepotPush(PPOOL_INTENTION_STATE IntentionState, PPOOL_TABLE PoolTable)
 {
+    POOL_DEPOT_HEAD Comparand;
+
     //
-    // Allocate global requesting variable
+    // The snapshot might be torn, but the compare-exchange validates it
     //
-    g_RequestNewAllocation = PlatformMemAllocateZeroedNonPagedPool(NumberOfBytes);
+    Comparand.Top = IntentionState->Depot.Top;
+    Comparand.Tag = IntentionState->Depot.Tag;
 
-    if (!g_RequestNewAllocation)
+    do
     {
-        return FALSE;
+        PoolTable->DepotNext = Comparand.Top;
+
+    } while (!InterlockedCompareExchange128((volatile LONG64 *)&IntentionState->Depot,
+                                            (LONG64)(Comparand.Tag + 1),
+                                            (LONG64)PoolTable,
+                                            (LONG64 *)&Comparand));
+
+    InterlockedIncrement(&IntentionState->DepotCount);
+}
+
+/**
+ * @brief Pop a free pool from the global depot of its intention (lock-free)
+ *
+ * @param IntentionState
+ * @return PPOOL_TABLE NULL if the depot is empty
+ */
+PPOOL_TABLE
+PlmgrDepotPop(PPOOL_INTENTION_STATE IntentionState)
+{
+    POOL_DEPOT_HEAD Comparand;
+    PPOOL_TABLE     Next;
+
+    Comparand.Top = IntentionState->Depot.Top;
+    Comparand.Tag = IntentionState->Depot.Tag;
+
+    do
+    {
+        if (Comparand.Top == NULL)
+        {
+            return NULL;
+        }
+
+        Next = Comparand.Top->DepotNext;
+
+    } while (!InterlockedCompareExchange128((volatile LONG64 *)&IntentionState->Depot,
+                                            (LONG64)(Comparand.Tag + 1),
+                                            (LONG64)Next,
+                                            (LONG64 *)&Comparand));
+
+    InterlockedDecrement(&IntentionState->DepotCount);
+
+    return Comparand.Top;
+}
+
+/**
+ * @brief Pop a free pool from the current core's magazine, the magazine
+ * is refilled from the global depot if it's empty
+ * @details should be called from vmx-root as magazines are not protected against
+ * being used from both vmx-root and vmx non-root of the same core
+ *
+ * @param IntentionState
+ * @param Intention
+ * @return PPOOL_TABLE NULL if there is no free pool
+ */
+PPOOL_TABLE
+PlmgrMagazinePop(PPOOL_INTENTION_STATE IntentionState, POOL_ALLOCATION_INTENTION Intention)
+{
+    ULONG          CurrentCore = KeGetCurrentProcessorNumberEx(NULL);
+    PPOOL_MAGAZINE Magazine;
+    PPOOL_TABLE    PoolTable;
+
+    if (g_PoolPerCoreMagazines == NULL || CurrentCore >= g_PoolPerCoreMagazinesCount)
+    {
+        return PlmgrDepotPop(IntentionState);
     }
 
-    return TRUE;
+    Magazine = &g_PoolPerCoreMagazines[CurrentCore].Magazines[Intention];
+
+    if (Magazine->Count != 0)
+    {
+        InterlockedIncrement64(&IntentionState->MagazineHits);
+        return Magazine->Pools[--Magazine->Count];
+    }
+
+    //
+    // The magazine is empty, get one pool from the depot
+    //
+    PoolTable = PlmgrDepotPop(IntentionState);
+
+    if (PoolTable == NULL)
+    {
+        return NULL;
+    }
+
+    //
+    // Move a batch of pools to the magazine (if the depot has enough pools) so
+    // the next requests from this core don't touch the shared depot
+    //
+    while (Magazine->Count < POOL_MANAGER_MAGAZINE_SIZE &&
+           IntentionState->DepotCount > POOL_MANAGER_MAGAZINE_REFILL_DEPOT_THRESHOLD)
+    {
+        PPOOL_TABLE ExtraPool = PlmgrDepotPop(IntentionState);
+
+        if (ExtraPool == NULL)
+        {
+            break;
+        }
+
+        Magazine->Pools[Magazine->Count++] = ExtraPool;
+    }
+
+    return PoolTable;
+}
+
+/**
+ * @brief Take a free pool from the magazine (vmx-root) or from the depot of the
+ * intention, the pools that are marked to be freed are unlinked and skipped
+ *
+ * @param IntentionState
+ * @param Intention
+ * @return PPOOL_TABLE NULL if there is no free pool
+ */
+PPOOL_TABLE
+PlmgrTakePool(PPOOL_INTENTION_STATE IntentionState, POOL_ALLOCATION_INTENTION Intention)
+{
+    PPOOL_TABLE PoolTable;
+    BOOLEAN     ShouldBeFreed;
+
+    while (TRUE)
+    {
+        //
+        // The per-core magazines are only used in vmx-root, vmx non-root callers
+        // might be preempted or interrupted by a vm-exit on the same core
+        //
+        if (VmxGetCurrentExecutionMode() == VmxExecutionModeRoot)
+        {
+            PoolTable = PlmgrMagazinePop(IntentionState, Intention);
+        }
+        else
+        {
+            PoolTable = PlmgrDepotPop(IntentionState);
+        }
+
+        if (PoolTable == NULL)
+        {
+            return NULL;
+        }
+
+        InterlockedDecrement(&IntentionState->Available);
+
+        ShouldBeFreed = PoolTable->ShouldBeFreed;
+
+        //
+        // The pool is not touched after this point if it should be freed, as it
+        // might be freed from the deallocation pass (on another core)
+        //
+        PoolTable->IsInDepot = FALSE;
+
+        if (!ShouldBeFreed)
+        {
+            return PoolTable;
+        }
+
+        //
+        // The pool is freed while it was in the depot (or in a magazine), now that
+        // it's unlinked, it can be freed on the next safe point
+        //
+        g_IsNewRequestForDeAllocation = TRUE;
+    }
 }
 
+/**
+ * @brief Unlink the free pools that are marked to be freed from the depots
+ * @details should be called from vmx non-root while holding LockForReadingPool,
+ * pools in the magazines are unlinked once they're popped
+ *
+ * @return VOID
+ */
 VOID
-PlmgrFreeRequestNewAllocation(VOID)
+PlmgrUnlinkFreedPoolsFromDepots()
 {
-    PlatformMemFreePool(g_RequestNewAllocation);
-    g_RequestNewAllocation = NULL;
+    for (UINT32 i = 0; i < POOL_MANAGER_NUMBER_OF_INTENTIONS; i++)
+    {
+        PPOOL_INTENTION_STATE IntentionState = &g_PoolIntentions[i];
+        PPOOL_TABLE           KeptPools      = NULL;
+        PPOOL_TABLE           PoolTable;
+
+        //
+        // Drain the depot and push back the pools that are not freed, the requests
+        // that are received in the meantime (from other cores) might miss these pools
+        //
+        while ((PoolTable = PlmgrDepotPop(IntentionState)) != NULL)
+        {
+            if (PoolTable->ShouldBeFreed)
+            {
+                PoolTable->IsInDepot = FALSE;
+                InterlockedDecrement(&IntentionState->Available);
+            }
+            else
+            {
+                PoolTable->DepotNext = KeptPools;
+                KeptPools            = PoolTable;
+            }
+        }
+
+        while (KeptPools != NULL)
+        {
+            PoolTable = KeptPools;
+            KeptPools = KeptPools->DepotNext;
+
+            PlmgrDepotPush(IntentionState, PoolTable);
+        }
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -53,19 +255,28 @@ BOOLEAN
 PoolManagerInitialize()
 {
     //
-    // Allocate global requesting variable
+    // Allocate per-core magazines
     //
-    SIZE_T BufferSize = MaximumRequestsQueueDepth * sizeof(REQUEST_NEW_ALLOCATION);
-    if (!PlmgrAllocateRequestNewAllocation(BufferSize))
+    g_PoolPerCoreMagazinesCount = KeQueryActiveProcessorCount(0);
+
+    g_PoolPerCoreMagazines = PlatformMemAllocateZeroedNonPagedPool(sizeof(POOL_PER_CORE_MAGAZINES) * g_PoolPerCoreMagazinesCount);
+
+    if (!g_PoolPerCoreMagazines)
     {
         LogError("Err, insufficient memory");
         return FALSE;
     }
 
     //
-    // Initialize list head
+    // Reset depots and statistics
+    //
+    RtlZeroMemory(g_PoolIntentions, sizeof(g_PoolIntentions));
+
+    //
+    // Initialize list heads
     //
     InitializeListHead(&g_ListOfAllocatedPoolsHead);
+    InitializeListHead(&g_ListOfRecycledPoolTablesHead);
 
     //
     // Nothing to deallocate
@@ -109,8 +320,9 @@ PoolManagerUninitialize()
         }
 
         //
-        // Unlink the PoolTable
+        // Unlink the PoolTable (the walk continues from the previous entry)
         //
+        ListTemp = PoolTable->PoolsList.Blink;
         RemoveEntryList(&PoolTable->PoolsList);
 
         //
@@ -119,9 +331,30 @@ PoolManagerUninitialize()
         PlatformMemFreePool(PoolTable);
     }
 
-    SpinlockUnlock(&LockForReadingPool);
+    //
+    // Free the records of the freed pools
+    //
+    while (!IsListEmpty(&g_ListOfRecycledPoolTablesHead))
+    {
+        ListTemp = g_ListOfRecycledPoolTablesHead.Flink;
+
+        RemoveEntryList(ListTemp);
+        PlatformMemFreePool(CONTAINING_RECORD(ListTemp, POOL_TABLE, PoolsList));
+    }
+
+    //
+    // Depots and magazines are pointing to the freed pools
+    //
+    RtlZeroMemory(g_PoolIntentions, sizeof(g_PoolIntentions));
+
+    if (g_PoolPerCoreMagazines != NULL)
+    {
+        PlatformMemFreePool(g_PoolPerCoreMagazines);
+        g_PoolPerCoreMagazines      = NULL;
+        g_PoolPerCoreMagazinesCount = 0;
+    }
 
-    PlmgrFreeRequestNewAllocation();
+    SpinlockUnlock(&LockForReadingPool);
 }
 
 /**
@@ -154,8 +387,15 @@ PoolManagerFreePool(UINT64 AddressToFree)
         {
             //
             // We found an entry that matched the detailed from
-            // previously allocated pools
+            // previously allocated pools, if the pool is still free (in the
+            // depot or in a magazine), it's unlinked before being freed, so
+            // it's never given to the requests after this point
             //
+            if (PoolTable->IsBusy && !PoolTable->ShouldBeFreed)
+            {
+                InterlockedDecrement(&g_PoolIntentions[PoolTable->Intention].InUse);
+            }
+
             PoolTable->ShouldBeFreed = TRUE;
             Result                   = TRUE;
 
@@ -191,10 +431,26 @@ PoolManagerShowPreAllocatedPools()
         LogInfo("Pool details, Pool intention: %x | Pool address: %llx | Pool state: %s | Should be freed: %s | Already freed: %s\n",
                 PoolTable->Intention,
                 PoolTable->Address,
-                PoolTable->IsBusy ? "used" : "free",
+                PoolTable->IsBusy ? "used" : (PoolTable->IsInDepot ? "free" : "unlinked"),
                 PoolTable->ShouldBeFreed ? "true" : "false",
                 PoolTable->AlreadyFreed ? "true" : "false");
     }
+
+    for (UINT32 i = 0; i < POOL_MANAGER_NUMBER_OF_INTENTIONS; i++)
+    {
+        PPOOL_INTENTION_STATE IntentionState = &g_PoolIntentions[i];
+
+        LogInfo("Pool statistics, Pool intention: %x | Available: %d | In use: %d | High-water mark: %d | "
+                "Pending: %d | Hits: %lld (magazine: %lld) | Misses: %lld\n",
+                i,
+                IntentionState->Available,
+                IntentionState->InUse,
+                IntentionState->HighWaterMark,
+                IntentionState->PendingAllocations,
+                IntentionState->Hits,
+                IntentionState->MagazineHits,
+                IntentionState->Misses);
+    }
 }
 
 /**
@@ -211,18 +467,48 @@ PoolManagerShowPreAllocatedPools()
 UINT64
 PoolManagerRequestPool(POOL_ALLOCATION_INTENTION Intention, BOOLEAN RequestNewPool, UINT32 Size)
 {
-    UINT64 Address = 0;
+    PPOOL_INTENTION_STATE IntentionState;
+    PPOOL_TABLE           PoolTable;
+    LONG                  InUse;
+    LONG                  HighWaterMark;
+
+    if ((UINT32)Intention >= POOL_MANAGER_NUMBER_OF_INTENTIONS)
+    {
+        return (UINT64)NULL;
+    }
+
+    IntentionState = &g_PoolIntentions[Intention];
+
+    PoolTable = PlmgrTakePool(IntentionState, Intention);
+
+    if (PoolTable != NULL)
+    {
+        PoolTable->IsBusy = TRUE;
+
+        InterlockedIncrement64(&IntentionState->Hits);
+
+        //
+        // Update the high-water mark of the pools in use
+        //
+        InUse         = InterlockedIncrement(&IntentionState->InUse);
+        HighWaterMark = IntentionState->HighWaterMark;
+
+        while (InUse > HighWaterMark)
+        {
+            LONG PreviousHighWaterMark = InterlockedCompareExchange(&IntentionState->HighWaterMark, InUse, HighWaterMark);
 
-    ScopedSpinlock(
-        LockForReadingPool,
-        LIST_FOR_EACH_LINK(g_ListOfAllocatedPoolsHead, POOL_TABLE, PoolsList, PoolTable) {
-            if (PoolTable->Intention == Intention && PoolTable->IsBusy == FALSE)
+            if (PreviousHighWaterMark == HighWaterMark)
             {
-                PoolTable->IsBusy = TRUE;
-                Address           = PoolTable->Address;
                 break;
             }
-        });
+
+            HighWaterMark = PreviousHighWaterMark;
+        }
+    }
+    else
+    {
+        InterlockedIncrement64(&IntentionState->Misses);
+    }
 
     //
     // Check if we need additional pools e.g another pool or the pool
@@ -236,12 +522,13 @@ PoolManagerRequestPool(POOL_ALLOCATION_INTENTION Intention, BOOLEAN RequestNewPo
     //
     // return Address might be null indicating there is no valid pools
     //
-    return Address;
+    return PoolTable != NULL ? PoolTable->Address : (UINT64)NULL;
 }
 
 /**
  * @brief Allocate the new pools and add them to pool table
- * @details This function doesn't need lock as it just calls once from PASSIVE_LEVEL
+ * @details This function should be called from PASSIVE_LEVEL, the new pools are
+ * pushed to the depot of the intention
  *
  * @param Size Size of each chunk
  * @param Count Count of chunks
@@ -256,7 +543,23 @@ PoolManagerAllocateAndAddToPoolTable(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_
     {
         POOL_TABLE * SinglePool = NULL;
 
-        SinglePool = PlatformMemAllocateZeroedNonPagedPool(sizeof(POOL_TABLE));
+        //
+        // Reuse the record of a freed pool (if any)
+        //
+        SpinlockLock(&LockForReadingPool);
+
+        if (!IsListEmpty(&g_ListOfRecycledPoolTablesHead))
+        {
+            SinglePool = CONTAINING_RECORD(g_ListOfRecycledPoolTablesHead.Flink, POOL_TABLE, PoolsList);
+            RemoveEntryList(&SinglePool->PoolsList);
+        }
+
+        SpinlockUnlock(&LockForReadingPool);
+
+        if (!SinglePool)
+        {
+            SinglePool = PlatformMemAllocateZeroedNonPagedPool(sizeof(POOL_TABLE));
+        }
 
         if (!SinglePool)
         {
@@ -271,7 +574,9 @@ PoolManagerAllocateAndAddToPoolTable(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_
 
         if (!SinglePool->Address)
         {
-            PlatformMemFreePool(SinglePool);
+            SpinlockLock(&LockForReadingPool);
+            InsertHeadList(&g_ListOfRecycledPoolTablesHead, &SinglePool->PoolsList);
+            SpinlockUnlock(&LockForReadingPool);
 
             LogError("Err, insufficient memory");
             return FALSE;
@@ -279,6 +584,7 @@ PoolManagerAllocateAndAddToPoolTable(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_
 
         SinglePool->Intention     = Intention;
         SinglePool->IsBusy        = FALSE;
+        SinglePool->IsInDepot     = TRUE;
         SinglePool->ShouldBeFreed = FALSE;
         SinglePool->AlreadyFreed  = FALSE;
         SinglePool->Size          = Size;
@@ -286,7 +592,15 @@ PoolManagerAllocateAndAddToPoolTable(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_
         //
         // Add it to the list
         //
+        SpinlockLock(&LockForReadingPool);
         InsertHeadList(&g_ListOfAllocatedPoolsHead, &(SinglePool->PoolsList));
+        SpinlockUnlock(&LockForReadingPool);
+
+        //
+        // Make it available for the requests
+        //
+        InterlockedIncrement(&g_PoolIntentions[Intention].Available);
+        PlmgrDepotPush(&g_PoolIntentions[Intention], SinglePool);
     }
 
     return TRUE;
@@ -325,22 +639,25 @@ PoolManagerCheckAndPerformAllocationAndDeallocation()
     //
     if (g_IsNewRequestForAllocationReceived)
     {
-        for (SIZE_T i = 0; i < MaximumRequestsQueueDepth; i++)
+        //
+        // The flag is cleared before performing the allocations, so the requests that
+        // are received in the meantime are handled in the next call
+        //
+        g_IsNewRequestForAllocationReceived = FALSE;
+
+        for (UINT32 i = 0; i < POOL_MANAGER_NUMBER_OF_INTENTIONS; i++)
         {
-            REQUEST_NEW_ALLOCATION * CurrentItem = &g_RequestNewAllocation[i];
+            PPOOL_INTENTION_STATE IntentionState = &g_PoolIntentions[i];
+            LONG                  Count          = InterlockedExchange(&IntentionState->PendingAllocations, 0);
 
-            if (CurrentItem->Size != 0)
+            if (Count > 0 && IntentionState->Size != 0)
             {
-                Result = PoolManagerAllocateAndAddToPoolTable(CurrentItem->Size,
-                                                              CurrentItem->Count,
-                                                              CurrentItem->Intention);
-
-                //
-                // Free the data for future use
-                //
-                CurrentItem->Count     = 0;
-                CurrentItem->Intention = 0;
-                CurrentItem->Size      = 0;
+                if (!PoolManagerAllocateAndAddToPoolTable(IntentionState->Size,
+                                                          (UINT32)Count,
+                                                          (POOL_ALLOCATION_INTENTION)i))
+                {
+                    Result = FALSE;
+                }
             }
         }
     }
@@ -350,10 +667,21 @@ PoolManagerCheckAndPerformAllocationAndDeallocation()
     //
     if (g_IsNewRequestForDeAllocation)
     {
+        //
+        // The flag is cleared before the pass, so the pools that are unlinked from
+        // the magazines in the meantime are freed in the next call
+        //
+        g_IsNewRequestForDeAllocation = FALSE;
+
         ListTemp = &g_ListOfAllocatedPoolsHead;
 
         SpinlockLock(&LockForReadingPool);
 
+        //
+        // The free pools that are marked to be freed are unlinked from the depots first
+        //
+        PlmgrUnlinkFreedPoolsFromDepots();
+
         while (&g_ListOfAllocatedPoolsHead != ListTemp->Flink)
         {
             ListTemp = ListTemp->Flink;
@@ -365,9 +693,10 @@ PoolManagerCheckAndPerformAllocationAndDeallocation()
 
             //
             // Check whether this pool should be freed or not and
-            // also check whether it's already freed or not
+            // also check whether it's already freed or not (free pools
+            // that are still in a magazine are freed once they're unlinked)
             //
-            if (PoolTable->ShouldBeFreed && !PoolTable->AlreadyFreed)
+            if (PoolTable->ShouldBeFreed && !PoolTable->AlreadyFreed && !PoolTable->IsInDepot)
             {
                 //
                 // Set the flag to indicate that we freed
@@ -381,25 +710,21 @@ PoolManagerCheckAndPerformAllocationAndDeallocation()
 
                 //
                 // Now we should remove the entry from the g_ListOfAllocatedPoolsHead
+                // (the walk continues from the previous entry)
                 //
+                ListTemp = PoolTable->PoolsList.Blink;
                 RemoveEntryList(&PoolTable->PoolsList);
 
                 //
-                // Free the structure pool
+                // Keep the structure pool to be reused for the next allocations
                 //
-                PlatformMemFreePool(PoolTable);
+                InsertHeadList(&g_ListOfRecycledPoolTablesHead, &PoolTable->PoolsList);
             }
         }
 
         SpinlockUnlock(&LockForReadingPool);
     }
 
-    //
-    // All allocation and deallocation are performed
-    //
-    g_IsNewRequestForDeAllocation       = FALSE;
-    g_IsNewRequestForAllocationReceived = FALSE;
-
     return Result;
 }
 
@@ -414,41 +739,29 @@ PoolManagerCheckAndPerformAllocationAndDeallocation()
 BOOLEAN
 PoolManagerRequestAllocation(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_INTENTION Intention)
 {
-    BOOLEAN FoundAPlace = FALSE;
-
-    //
-    // ******** We check to find a free place to store ********
-    //
-
-    SpinlockLock(&LockForRequestAllocation);
+    PPOOL_INTENTION_STATE IntentionState;
 
-    for (SIZE_T i = 0; i < MaximumRequestsQueueDepth; i++)
+    if ((UINT32)Intention >= POOL_MANAGER_NUMBER_OF_INTENTIONS || Size == 0)
     {
-        REQUEST_NEW_ALLOCATION * CurrentItem = &g_RequestNewAllocation[i];
-
-        if (CurrentItem->Size == 0)
-        {
-            CurrentItem->Count     = Count;
-            CurrentItem->Intention = Intention;
-            CurrentItem->Size      = Size;
-
-            FoundAPlace = TRUE;
-
-            break;
-        }
+        return FALSE;
     }
 
-    if (!FoundAPlace)
+    IntentionState = &g_PoolIntentions[Intention];
+
+    //
+    // Each intention has a fixed size, keep the largest requested size
+    //
+    if (IntentionState->Size < Size)
     {
-        SpinlockUnlock(&LockForRequestAllocation);
-        return FALSE;
+        IntentionState->Size = Size;
     }
 
+    InterlockedAdd(&IntentionState->PendingAllocations, (LONG)Count);
+
     //
     // Signals to show that we have new allocations
     //
     g_IsNewRequestForAllocationReceived = TRUE;
 
-    SpinlockUnlock(&LockForRequestAllocation);
     return TRUE;
 }
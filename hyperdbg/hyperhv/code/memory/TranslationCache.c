@@ -0,0 +1,346 @@
+/**
+ * @file TranslationCache.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Per-core guest translation cache (software TLB)
+ * @details Translations of guest virtual addresses are cached per core
+ * and tagged by the cr3. A cached translation is only valid while both
+ * the global epoch (bumped on mov to cr3, EPT invalidations and memory
+ * writes of the debugger) and the core's generation (bumped on each
+ * VM-exit as the guest might change its page-tables without exiting)
+ * are unchanged
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize the translation cache
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TranslationCacheInitialize()
+{
+    if (g_TranslationCache != NULL)
+    {
+        //
+        // It's already initialized
+        //
+        return TRUE;
+    }
+
+    g_TranslationCacheEpoch = 0;
+
+    //
+    // Allocate the per-core caches (page aligned so each core's
+    // structure starts on its own cache line)
+    //
+    g_TranslationCache = (TRANSLATION_CACHE_CORE_DATA *)PlatformMemAllocateZeroedNonPagedPool(
+        ROUND_TO_PAGES(sizeof(TRANSLATION_CACHE_CORE_DATA) * KeQueryActiveProcessorCount(0)));
+
+    if (g_TranslationCache == NULL)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Uninitialize the translation cache
+ *
+ * @return VOID
+ */
+VOID
+TranslationCacheUninitialize()
+{
+    if (g_TranslationCache != NULL)
+    {
+        PlatformMemFreePool(g_TranslationCache);
+        g_TranslationCache = NULL;
+    }
+}
+
+/**
+ * @brief Invalidate the cached translations of all cores
+ *
+ * @return VOID
+ */
+VOID
+TranslationCacheInvalidate()
+{
+    InterlockedIncrement64((volatile LONG64 *)&g_TranslationCacheEpoch);
+}
+
+/**
+ * @brief Invalidate the cached translations of the current core
+ * once a new VM-exit is started
+ * @details Should be called from vmx-root mode
+ *
+ * @param CoreId
+ *
+ * @return VOID
+ */
+_Use_decl_annotations_
+VOID
+TranslationCacheStartVmexit(UINT32 CoreId)
+{
+    if (g_TranslationCache == NULL)
+    {
+        return;
+    }
+
+    g_TranslationCache[CoreId].Generation++;
+}
+
+/**
+ * @brief Walk the page-tables of the target cr3 to translate the address
+ * @details The caller should switch to the target cr3 (kernel cr3)
+ *
+ * @param Va Virtual address
+ * @param TargetCr3 kernel cr3 of target process
+ * @param PhysicalAddress The translated physical address
+ * @param Permissions The accumulated permissions of the page
+ *
+ * @return BOOLEAN TRUE if the page is present
+ */
+_Use_decl_annotations_
+BOOLEAN
+TranslationCacheWalk(UINT64 Va, CR3_TYPE TargetCr3, PUINT64 PhysicalAddress, PUINT64 Permissions)
+{
+    PUINT64     TableVa;
+    PPAGE_ENTRY Entry;
+    UINT64      Flags = TRANSLATION_CACHE_PERMISSION_WRITE | TRANSLATION_CACHE_PERMISSION_USER | TRANSLATION_CACHE_PERMISSION_EXECUTE;
+
+    TableVa = (UINT64 *)PhysicalAddressToVirtualAddress(TargetCr3.Fields.PageFrameNumber << 12);
+
+    for (PAGING_LEVEL Level = PagingLevelPageMapLevel4;; Level--)
+    {
+        //
+        // Check for invalid address
+        //
+        if (TableVa == NULL)
+        {
+            return FALSE;
+        }
+
+        //
+        // Each level is indexed by 9 bits of the address
+        //
+        Entry = (PAGE_ENTRY *)&TableVa[(Va >> (12 + Level * 9)) & 0x1ff];
+
+        if (!Entry->Fields.Present)
+        {
+            return FALSE;
+        }
+
+        //
+        // The permissions of the page are the intersection of the permissions
+        // of all of the levels
+        //
+        if (!Entry->Fields.Write)
+        {
+            Flags &= ~TRANSLATION_CACHE_PERMISSION_WRITE;
+        }
+
+        if (!Entry->Fields.Supervisor)
+        {
+            Flags &= ~TRANSLATION_CACHE_PERMISSION_USER;
+        }
+
+        if (Entry->Fields.ExecuteDisable)
+        {
+            Flags &= ~TRANSLATION_CACHE_PERMISSION_EXECUTE;
+        }
+
+        if (Level == PagingLevelPageDirectoryPointerTable && Entry->Fields.LargePage)
+        {
+            //
+            // 1GB page (PAT bit is part of the frame number so it's masked out)
+            //
+            *PhysicalAddress = ((Entry->Fields.PageFrameNumber << 12) & ~PAGE_1GB_OFFSET) + (Va & PAGE_1GB_OFFSET);
+            break;
+        }
+
+        if (Level == PagingLevelPageDirectory && Entry->Fields.LargePage)
+        {
+            //
+            // 2MB page (PAT bit is part of the frame number so it's masked out)
+            //
+            *PhysicalAddress = ((Entry->Fields.PageFrameNumber << 12) & ~PAGE_2MB_OFFSET) + (Va & PAGE_2MB_OFFSET);
+            break;
+        }
+
+        if (Level == PagingLevelPageTable)
+        {
+            *PhysicalAddress = (Entry->Fields.PageFrameNumber << 12) + (Va & PAGE_4KB_OFFSET);
+            break;
+        }
+
+        TableVa = (UINT64 *)PhysicalAddressToVirtualAddress(Entry->Fields.PageFrameNumber << 12);
+    }
+
+    *Permissions = Flags;
+
+    return TRUE;
+}
+
+/**
+ * @brief Translate a virtual address based on the target cr3
+ * @details The translation is cached if the caller is in vmx-root mode,
+ * in vmx non-root mode the page-tables are always walked as the thread
+ * might be interrupted by the VM-exits of the same core
+ *
+ * @param TargetCr3 kernel cr3 of target process
+ * @param Va Virtual address
+ * @param PhysicalAddress The translated physical address (optional)
+ * @param Permissions The accumulated permissions of the page (optional)
+ *
+ * @return BOOLEAN TRUE if the page is present
+ */
+_Use_decl_annotations_
+BOOLEAN
+TranslationCacheTranslate(CR3_TYPE TargetCr3, UINT64 Va, PUINT64 PhysicalAddress, PUINT64 Permissions)
+{
+    TRANSLATION_CACHE_CORE_DATA * CoreData = NULL;
+    TRANSLATION_CACHE_ENTRY *     Entry    = NULL;
+    CR3_TYPE                      CurrentProcessCr3;
+    UINT64                        Cr3PageFrame = TargetCr3.Fields.PageFrameNumber;
+    UINT64                        VirtualPage  = (UINT64)PAGE_ALIGN(Va);
+    UINT64                        Epoch        = g_TranslationCacheEpoch;
+    UINT64                        TranslatedAddress;
+    UINT64                        TranslatedPermissions;
+    BOOLEAN                       Result;
+    ULONG                         CurrentCore;
+
+    if (g_TranslationCache != NULL && g_GuestState != NULL)
+    {
+        CurrentCore = KeGetCurrentProcessorNumberEx(NULL);
+
+        if (g_GuestState[CurrentCore].IsOnVmxRootMode)
+        {
+            CoreData = &g_TranslationCache[CurrentCore];
+            Entry    = &CoreData->Entries[((Va >> 12) ^ Cr3PageFrame) & (TRANSLATION_CACHE_ENTRIES - 1)];
+
+            if (Entry->Cr3PageFrame == Cr3PageFrame &&
+                Entry->VirtualPage == VirtualPage &&
+                Entry->Epoch == Epoch &&
+                Entry->Generation == CoreData->Generation)
+            {
+                CoreData->Hits++;
+
+                if (PhysicalAddress != NULL)
+                {
+                    *PhysicalAddress = Entry->PhysicalPage + (Va & PAGE_4KB_OFFSET);
+                }
+
+                if (Permissions != NULL)
+                {
+                    *Permissions = Entry->Permissions;
+                }
+
+                return TRUE;
+            }
+
+            CoreData->Misses++;
+        }
+    }
+
+    //
+    // Walk the page-tables, no need to switch if we're already on the target cr3
+    //
+    CurrentProcessCr3.Flags = __readcr3();
+
+    if (CurrentProcessCr3.Fields.PageFrameNumber != Cr3PageFrame)
+    {
+        SwitchToProcessMemoryLayoutByCr3(TargetCr3);
+        Result = TranslationCacheWalk(Va, TargetCr3, &TranslatedAddress, &TranslatedPermissions);
+        SwitchToPreviousProcess(CurrentProcessCr3);
+    }
+    else
+    {
+        Result = TranslationCacheWalk(Va, TargetCr3, &TranslatedAddress, &TranslatedPermissions);
+    }
+
+    if (!Result)
+    {
+        //
+        // Not-present pages are never cached
+        //
+        return FALSE;
+    }
+
+    if (Entry != NULL)
+    {
+        //
+        // The epoch is read before the walk, so if it's changed in the middle
+        // of the walk, the entry won't be used
+        //
+        Entry->Cr3PageFrame = Cr3PageFrame;
+        Entry->VirtualPage  = VirtualPage;
+        Entry->PhysicalPage = TranslatedAddress & ~PAGE_4KB_OFFSET;
+        Entry->Permissions  = TranslatedPermissions;
+        Entry->Epoch        = Epoch;
+        Entry->Generation   = CoreData->Generation;
+    }
+
+    if (PhysicalAddress != NULL)
+    {
+        *PhysicalAddress = TranslatedAddress;
+    }
+
+    if (Permissions != NULL)
+    {
+        *Permissions = TranslatedPermissions;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Add the hit and miss counters of a core to the results
+ *
+ * @param CoreId
+ * @param Hits
+ * @param Misses
+ *
+ * @return VOID
+ */
+_Use_decl_annotations_
+VOID
+TranslationCacheQueryStatistics(UINT32 CoreId, PUINT64 Hits, PUINT64 Misses)
+{
+    if (g_TranslationCache == NULL)
+    {
+        return;
+    }
+
+    *Hits += g_TranslationCache[CoreId].Hits;
+    *Misses += g_TranslationCache[CoreId].Misses;
+}
+
+/**
+ * @brief Reset the hit and miss counters of all cores
+ *
+ * @return VOID
+ */
+VOID
+TranslationCacheResetStatistics()
+{
+    ULONG ProcessorsCount = KeQueryActiveProcessorCount(0);
+
+    if (g_TranslationCache == NULL)
+    {
+        return;
+    }
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        g_TranslationCache[i].Hits   = 0;
+        g_TranslationCache[i].Misses = 0;
+    }
+}
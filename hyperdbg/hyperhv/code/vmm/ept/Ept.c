@@ -1020,6 +1020,13 @@ EptHandleEptViolation(VIRTUAL_MACHINE_STATE * VCpu)
         //
         return TRUE;
     }
+    else if (SnapshotHandleEptViolation(VCpu, &ViolationQualification, GuestPhysicalAddr))
+    {
+        //
+        // Handled by the memory snapshot (copy-on-write)
+        //
+        return TRUE;
+    }
     else if (VmmCallbackUnhandledEptViolation(VCpu->CoreId, (UINT64)ViolationQualification.AsUInt, GuestPhysicalAddr))
     {
         //
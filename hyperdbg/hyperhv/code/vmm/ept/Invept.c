@@ -27,6 +27,11 @@ EptInvept(_In_ UINT32 Type, _In_ INVEPT_DESCRIPTOR * Descriptor)
         Descriptor                       = &ZeroDescriptor;
     }
 
+    //
+    // EPT is changed, so the cached guest translations are invalidated
+    //
+    TranslationCacheInvalidate();
+
     return AsmInvept(Type, Descriptor);
 }
 
@@ -182,6 +182,11 @@ HvHandleControlRegisterAccess(VIRTUAL_MACHINE_STATE *         VCpu,
             //
             VmxVmwrite64(VMCS_GUEST_CR3, NewCr3Reg.Flags);
 
+            //
+            // Invalidate the cached guest translations
+            //
+            TranslationCacheInvalidate();
+
             //
             // Invalidate as we used VPID tags so the vm-exit won't
             // normally (automatically) flush the TLB, we have to do
@@ -1380,6 +1385,14 @@ HvInitVmm(VMM_CALLBACKS * VmmCallbacks)
     //
     MemoryMapperInitialize();
 
+    //
+    // Initialize the guest translation cache
+    //
+    if (!TranslationCacheInitialize())
+    {
+        return FALSE;
+    }
+
     //
     // Make sure that transparent-mode is disabled
     //
@@ -437,6 +437,40 @@ VmxVmcallHandler(VIRTUAL_MACHINE_STATE * VCpu,
         VmcallStatus = STATUS_SUCCESS;
         break;
     }
+    case VMCALL_FLUSH_DIRTY_LOGGING_BUFFER:
+    {
+        //
+        // The buffer is not allocated if the processor doesn't support PML
+        //
+        if (VCpu->PmlBufferAddress != NULL)
+        {
+            DirtyLoggingFlushPmlBuffer(VCpu);
+        }
+
+        VmcallStatus = STATUS_SUCCESS;
+        break;
+    }
+    case VMCALL_SNAPSHOT_PROTECT_PAGES:
+    {
+        SnapshotProtectPages(VCpu);
+
+        VmcallStatus = STATUS_SUCCESS;
+        break;
+    }
+    case VMCALL_SNAPSHOT_UNPROTECT_PAGES:
+    {
+        SnapshotUnprotectPages(VCpu);
+
+        VmcallStatus = STATUS_SUCCESS;
+        break;
+    }
+    case VMCALL_SNAPSHOT_RESTORE_PAGES:
+    {
+        SnapshotRestorePages(VCpu);
+
+        VmcallStatus = STATUS_SUCCESS;
+        break;
+    }
     case VMCALL_CHANGE_TO_MBEC_SUPPORTED_EPTP:
     {
         ExecTrapChangeToUserDisabledMbecEptp(VCpu);
@@ -24,8 +24,17 @@ VmxVmexitHandler(_Inout_ PGUEST_REGS GuestRegs)
     UINT32                  ExitReason          = 0;
     BOOLEAN                 Result              = FALSE;
     BOOLEAN                 ShouldEmulateRdtscp = TRUE;
+    UINT64                  VmexitStartTsc      = NULL_ZERO;
     VIRTUAL_MACHINE_STATE * VCpu                = NULL;
 
+    //
+    // Take the entry timestamp as early as possible if the VM-exit profiler is running
+    //
+    if (g_VmexitProfilerEnabled)
+    {
+        VmexitStartTsc = __rdtsc();
+    }
+
     //
     // *********** SEND MESSAGE AFTER WE SET THE STATE ***********
     //
@@ -41,6 +50,12 @@ VmxVmexitHandler(_Inout_ PGUEST_REGS GuestRegs)
     //
     VCpu->IsOnVmxRootMode = TRUE;
 
+    //
+    // The guest might have changed its page-tables, so the translations
+    // that are cached in the previous VM-exits are no longer valid
+    //
+    TranslationCacheStartVmexit(VCpu->CoreId);
+
     //
     // read the exit reason and exit qualification
     //
@@ -348,6 +363,15 @@ VmxVmexitHandler(_Inout_ PGUEST_REGS GuestRegs)
         Result = TRUE;
     }
 
+    //
+    // Record the handling time of this VM-exit (before restoring the
+    // previous time in the transparent-mode)
+    //
+    if (VmexitStartTsc != NULL_ZERO && g_VmexitProfilerEnabled)
+    {
+        VmexitProfilerRecordExit(VCpu->CoreId, ExitReason, __rdtsc() - VmexitStartTsc);
+    }
+
     //
     // Restore the previous time
     //
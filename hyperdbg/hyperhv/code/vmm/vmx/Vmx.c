@@ -472,6 +472,15 @@ VmxPerformVirtualizationOnAllCores()
         return FALSE;
     }
 
+    //
+    // Initialize the VM-exit profiler
+    //
+    if (!VmexitProfilerInitialize())
+    {
+        LogError("Err, could not initialize the VM-exit profiler");
+        return FALSE;
+    }
+
     if (!EptLogicalProcessorInitialize())
     {
         //
@@ -1266,11 +1275,31 @@ VmxPerformTermination()
     //
     PoolManagerUninitialize();
 
+    //
+    // Free the VM-exit profiler
+    //
+    VmexitProfilerUninitialize();
+
+    //
+    // Free the buffers of the dirty logging mechanism
+    //
+    DirtyLoggingUninitialize();
+
+    //
+    // Free the buffers of the memory snapshot
+    //
+    SnapshotFreeBuffers();
+
     //
     // Uninitialize memory mapper
     //
     MemoryMapperUninitialize();
 
+    //
+    // Free the guest translation cache
+    //
+    TranslationCacheUninitialize();
+
     //
     // Free g_GuestState
     //
@@ -33,6 +33,18 @@ BroadcastEnablePmlOnAllProcessors();
 VOID
 BroadcastDisablePmlOnAllProcessors();
 
+VOID
+BroadcastFlushPmlBuffersOnAllProcessors();
+
+VOID
+BroadcastSnapshotProtectPagesOnAllProcessors();
+
+VOID
+BroadcastSnapshotUnprotectPagesOnAllProcessors();
+
+VOID
+BroadcastSnapshotRestorePagesOnAllProcessors();
+
 VOID
 BroadcastChangeToMbecSupportedEptpOnAllProcessors();
 
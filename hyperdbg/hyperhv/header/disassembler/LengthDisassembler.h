@@ -0,0 +1,59 @@
+/**
+ * @file LengthDisassembler.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Header for the table-driven instruction length decoder
+ * @details
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum length of an x86 instruction (architectural limit)
+ *
+ */
+#define LENGTH_DISASSEMBLER_MAXIMUM_LENGTH 15
+
+/**
+ * @brief Attributes of opcodes in the opcode tables
+ *
+ */
+#define LENGTH_DISASSEMBLER_MODRM   0x01 // Has a ModR/M byte
+#define LENGTH_DISASSEMBLER_IMM8    0x02 // Has an 8-bit immediate
+#define LENGTH_DISASSEMBLER_IMM16   0x04 // Has a 16-bit immediate
+#define LENGTH_DISASSEMBLER_IMMZ    0x08 // Has a 16-bit or 32-bit immediate (based on the operand size)
+#define LENGTH_DISASSEMBLER_IMMV    0x10 // Has a 16-bit, 32-bit or 64-bit immediate (mov reg, imm)
+#define LENGTH_DISASSEMBLER_MOFFS   0x20 // Has a memory offset (based on the address size)
+#define LENGTH_DISASSEMBLER_REL     0x40 // Has a relative offset (16-bit or 32-bit, always 32-bit in 64-bit mode)
+#define LENGTH_DISASSEMBLER_SPECIAL 0x80 // Needs to be handled separately
+#define LENGTH_DISASSEMBLER_INVALID 0xff // Invalid opcode
+
+//////////////////////////////////////////////////
+//				   Functions					//
+//////////////////////////////////////////////////
+
+static BOOLEAN
+LengthDisassemblerIsValidOneByteOpcode(BYTE Opcode, BYTE ModRm);
+
+static BOOLEAN
+LengthDisassemblerIsValidEscapedOpcode(BYTE Map, BYTE MandatoryPrefix, BYTE Opcode, BYTE ModRm, BOOLEAN HasRexR, BOOLEAN Is32Bit);
+
+static BOOLEAN
+LengthDisassemblerIsLockable(BYTE Map, BYTE Opcode, BYTE ModRm, BOOLEAN HasModRm);
+
+static UINT32
+LengthDisassemblerGetModRmLength(BYTE * Buffer, UINT32 Offset, UINT32 MaximumLength, BOOLEAN Is16BitAddressing, BOOLEAN IsRegisterForm);
+
+UINT32
+LengthDisassemblerGetInstructionLength(PVOID Buffer, UINT32 BufferLength, BOOLEAN Is32Bit);
+
+BOOLEAN
+LengthDisassemblerCheckCallOrRet(PVOID Buffer, UINT32 BufferLength, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length);
@@ -0,0 +1,79 @@
+/**
+ * @file DirtyBitmap.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for the bitmap of the dirty physical pages
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				   Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of pages (bits) in each word of the bitmap
+ *
+ */
+#define DIRTY_BITMAP_PAGES_PER_WORD 64
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The bitmap of the dirty physical pages
+ * @details There is one bit for each physical page in the words, the
+ * summary has one bit for each word of the bitmap which is set when the
+ * word might have a dirty page, so collecting a few dirty pages of a large
+ * address space doesn't need to scan the entire bitmap. The bitmap is
+ * shared between all cores and updated atomically
+ *
+ */
+typedef struct _DIRTY_BITMAP
+{
+    UINT64            CountOfPages;
+    UINT64            CountOfWords;
+    UINT64            CountOfSummaryWords;
+    volatile LONG64 * Words;
+    volatile LONG64 * Summary;
+
+} DIRTY_BITMAP, *PDIRTY_BITMAP;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static VOID
+DirtyBitmapSetSummary(DIRTY_BITMAP * Bitmap, UINT64 WordIndex);
+
+//////////////////////////////////////////////////
+//				   Functions					//
+//////////////////////////////////////////////////
+
+UINT64
+DirtyBitmapGetBufferSize(UINT64 CountOfPages);
+
+VOID
+DirtyBitmapInitialize(DIRTY_BITMAP * Bitmap, PVOID Buffer, UINT64 CountOfPages);
+
+VOID
+DirtyBitmapSetPage(DIRTY_BITMAP * Bitmap, UINT64 PageFrameNumber);
+
+VOID
+DirtyBitmapSetRange(DIRTY_BITMAP * Bitmap, UINT64 FirstPageFrameNumber, UINT64 CountOfPages);
+
+UINT32
+DirtyBitmapCollect(DIRTY_BITMAP *               Bitmap,
+                   UINT64                       FirstPageFrameNumber,
+                   UINT64                       EndPageFrameNumber,
+                   DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                   UINT32                       MaximumEntries,
+                   UINT64 *                     NextPageFrameNumber);
+
+VOID
+DirtyBitmapReset(DIRTY_BITMAP * Bitmap);
@@ -17,6 +17,39 @@
 
 #define PML_ENTITY_NUM 512
 
+/**
+ * @brief Number of 4 KB pages of each large (2 MB) page of EPT
+ *
+ */
+#define DIRTY_LOGGING_PAGES_PER_LARGE_PAGE 512
+
+/**
+ * @brief Highest physical address that is tracked by the dirty bitmap
+ * (the range of the EPT identity table)
+ *
+ */
+#define DIRTY_LOGGING_MAXIMUM_PHYSICAL_ADDRESS (512ull * 1024 * 1024 * 1024)
+
+//////////////////////////////////////////////////
+//				   Globals						//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The bitmap of pages that are modified since the last collection
+ *
+ */
+DIRTY_BITMAP g_DirtyLoggingBitmap;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static UINT64
+DirtyLoggingGetCountOfPhysicalPages();
+
+static VOID
+DirtyLoggingClearEptDirtyFlags(VIRTUAL_MACHINE_STATE * VCpu);
+
 //////////////////////////////////////////////////
 //				   Functions					//
 //////////////////////////////////////////////////
@@ -33,5 +66,18 @@ DirtyLoggingDisable(VIRTUAL_MACHINE_STATE * VCpu);
 VOID
 DirtyLoggingUninitialize();
 
+BOOLEAN
+DirtyLoggingFlushPmlBuffer(VIRTUAL_MACHINE_STATE * VCpu);
+
 VOID
 DirtyLoggingHandleVmexits(VIRTUAL_MACHINE_STATE * VCpu);
+
+BOOLEAN
+DirtyLoggingResetDirtyPages();
+
+UINT32
+DirtyLoggingCollectDirtyPages(UINT64                       FirstPageFrameNumber,
+                              UINT64                       EndPageFrameNumber,
+                              DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                              UINT32                       MaximumEntries,
+                              UINT64 *                     NextPageFrameNumber);
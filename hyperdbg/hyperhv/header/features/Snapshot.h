@@ -0,0 +1,121 @@
+/**
+ * @file Snapshot.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for memory snapshots
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				   Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of pages that are copied back with a single
+ * mapping of the memory mapper
+ *
+ */
+#define SNAPSHOT_MAXIMUM_PAGES_PER_BATCH MEMORY_MAPPER_RANGE_PAGES
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The state of the memory snapshot
+ * @details The pages of the range are write-protected in the EPT of all
+ * cores, the first write to each page saves the original contents of the
+ * page and removes the protection of that page on the faulting core
+ *
+ */
+typedef struct _SNAPSHOT_STATE
+{
+    volatile LONG                Lock;
+    BOOLEAN                      IsTaken;
+    volatile BOOLEAN             IsProtectionFailed;
+    volatile LONG                CountOfProtectedCores; // Cores that protected the planned pages of the restore
+    UINT64                       FirstPageFrameNumber;
+    UINT64                       EndPageFrameNumber;
+    UINT64                       RestoreStartTsc;
+    PVOID                        TrackerBuffer;
+    PVOID                        PageCopies;
+    SNAPSHOT_TRACKER             Tracker;
+    DEBUGGER_SNAPSHOT_STATISTICS Statistics;
+
+} SNAPSHOT_STATE, *PSNAPSHOT_STATE;
+
+//////////////////////////////////////////////////
+//				   Globals						//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The state of the memory snapshot
+ *
+ */
+SNAPSHOT_STATE g_Snapshot;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static VOID
+SnapshotLock(KIRQL * OldIrql);
+
+static VOID
+SnapshotUnlock(KIRQL OldIrql);
+
+static BOOLEAN
+SnapshotIsHookedPage(UINT64 PageFrameNumber);
+
+static BOOLEAN
+SnapshotIsProtectablePage(EPT_PML1_ENTRY * Entry, UINT64 PageFrameNumber);
+
+//////////////////////////////////////////////////
+//				   Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+SnapshotAllocateBuffers(UINT32 MaximumPages);
+
+VOID
+SnapshotFreeBuffers();
+
+BOOLEAN
+SnapshotReserveSplitBuffers(UINT64 StartAddress, UINT64 EndAddress);
+
+BOOLEAN
+SnapshotTake(UINT64 StartAddress, UINT64 EndAddress);
+
+VOID
+SnapshotProtectPages(VIRTUAL_MACHINE_STATE * VCpu);
+
+VOID
+SnapshotUnprotectPages(VIRTUAL_MACHINE_STATE * VCpu);
+
+BOOLEAN
+SnapshotIsProtected();
+
+VOID
+SnapshotDiscard();
+
+VOID
+SnapshotPrepareRestore();
+
+VOID
+SnapshotRestorePages(VIRTUAL_MACHINE_STATE * VCpu);
+
+BOOLEAN
+SnapshotFinishRestore();
+
+BOOLEAN
+SnapshotQuery(DEBUGGER_SNAPSHOT_STATISTICS * Statistics);
+
+BOOLEAN
+SnapshotHandleEptViolation(VIRTUAL_MACHINE_STATE *                VCpu,
+                           VMX_EXIT_QUALIFICATION_EPT_VIOLATION * ViolationQualification,
+                           UINT64                                 GuestPhysicalAddress);
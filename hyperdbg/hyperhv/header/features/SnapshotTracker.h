@@ -0,0 +1,143 @@
+/**
+ * @file SnapshotTracker.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for tracking the saved pages of memory snapshots
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				   Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief An empty slot of the hash table of pages
+ *
+ */
+#define SNAPSHOT_TRACKER_EMPTY_SLOT 0
+
+/**
+ * @brief Number of pages that are covered by one table of EPT (PML1), the
+ * batches of restore never cross this boundary
+ *
+ */
+#define SNAPSHOT_TRACKER_PAGES_PER_TABLE 512
+
+//////////////////////////////////////////////////
+//					Enums						//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The result of tracking a write to a page
+ *
+ */
+typedef enum _SNAPSHOT_TRACKER_STATUS
+{
+    SNAPSHOT_TRACKER_STATUS_NEW_PAGE,      // The caller should save the original contents to the copy
+    SNAPSHOT_TRACKER_STATUS_DIRTIED_PAGE,  // Already saved, modified again after a restore
+    SNAPSHOT_TRACKER_STATUS_ALREADY_DIRTY, // Already modified since the last restore
+    SNAPSHOT_TRACKER_STATUS_RESTORED_PAGE, // Planned to be restored, the caller should copy back the copy before the write
+    SNAPSHOT_TRACKER_STATUS_POOL_EXHAUSTED,
+
+} SNAPSHOT_TRACKER_STATUS;
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief A saved page
+ * @details The copy of the page is the page of the pool with the same index
+ *
+ */
+typedef struct _SNAPSHOT_TRACKER_PAGE
+{
+    UINT64  PageFrameNumber;
+    BOOLEAN IsDirty;
+    BOOLEAN IsPlanned; // In the plan of the current restore and not restored yet
+
+} SNAPSHOT_TRACKER_PAGE, *PSNAPSHOT_TRACKER_PAGE;
+
+/**
+ * @brief A batch of the restore plan
+ * @details Pages of a batch are physically contiguous and in the same table
+ * of EPT, their indexes are in the (sorted) list of dirty pages starting
+ * from FirstDirtyIndex
+ *
+ */
+typedef struct _SNAPSHOT_TRACKER_BATCH
+{
+    UINT64 FirstPageFrameNumber;
+    UINT32 CountOfPages;
+    UINT32 FirstDirtyIndex;
+
+} SNAPSHOT_TRACKER_BATCH, *PSNAPSHOT_TRACKER_BATCH;
+
+/**
+ * @brief The tracker of the pages of a snapshot
+ * @details The tracker doesn't access the memory, the caller copies the
+ * original contents of the pages into the copies and back. All of the
+ * buffers are preallocated, so the tracker could be used from vmx-root
+ *
+ */
+typedef struct _SNAPSHOT_TRACKER
+{
+    UINT32                   MaximumPages;
+    UINT32                   CountOfPages;        // Count of saved pages (and used copies)
+    UINT32                   CountOfDirtyPages;   // Count of pages that are modified since the last restore
+    UINT32                   CountOfPlannedPages; // Count of dirty pages in the last restore plan
+    UINT32                   CountOfBatches;      // Count of batches of the last restore plan
+    UINT32                   HashMask;
+    UINT32 *                 HashTable; // Index of page plus one (zero is empty)
+    SNAPSHOT_TRACKER_PAGE *  Pages;
+    UINT32 *                 DirtyPages; // Indexes of the dirty pages
+    SNAPSHOT_TRACKER_BATCH * Batches;
+    BYTE *                   PageCopies;
+
+} SNAPSHOT_TRACKER, *PSNAPSHOT_TRACKER;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static UINT32
+SnapshotTrackerGetHashTableSize(UINT32 MaximumPages);
+
+static UINT32
+SnapshotTrackerHash(UINT64 PageFrameNumber);
+
+static VOID
+SnapshotTrackerSiftDown(SNAPSHOT_TRACKER * Tracker, UINT32 Root, UINT32 Count);
+
+static VOID
+SnapshotTrackerSortDirtyPages(SNAPSHOT_TRACKER * Tracker);
+
+//////////////////////////////////////////////////
+//				   Functions					//
+//////////////////////////////////////////////////
+
+UINT64
+SnapshotTrackerGetBufferSize(UINT32 MaximumPages);
+
+VOID
+SnapshotTrackerInitialize(SNAPSHOT_TRACKER * Tracker, PVOID Buffer, PVOID PageCopies, UINT32 MaximumPages);
+
+VOID
+SnapshotTrackerReset(SNAPSHOT_TRACKER * Tracker);
+
+SNAPSHOT_TRACKER_STATUS
+SnapshotTrackerTrackWrite(SNAPSHOT_TRACKER * Tracker, UINT64 PageFrameNumber, PVOID * PageCopy);
+
+UINT32
+SnapshotTrackerPlanRestore(SNAPSHOT_TRACKER * Tracker, UINT32 MaximumPagesPerBatch);
+
+PVOID
+SnapshotTrackerGetBatchPageCopy(SNAPSHOT_TRACKER * Tracker, SNAPSHOT_TRACKER_BATCH * Batch, UINT32 PageIndex);
+
+UINT32
+SnapshotTrackerFinishRestore(SNAPSHOT_TRACKER * Tracker);
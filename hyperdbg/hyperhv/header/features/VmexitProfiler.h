@@ -0,0 +1,79 @@
+/**
+ * @file VmexitProfiler.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for the VM-exit latency and frequency profiler
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Per-core samples of the VM-exit profiler
+ * @details Each core only writes into its own structure, so no lock
+ * is needed for recording the samples
+ *
+ */
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _VMEXIT_PROFILER_CORE_DATA
+{
+    VMEXIT_PROFILER_RESULTS Samples;
+
+} VMEXIT_PROFILER_CORE_DATA, *PVMEXIT_PROFILER_CORE_DATA;
+
+//////////////////////////////////////////////////
+//				   Globals						//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Shows whether the VM-exit profiler is collecting samples or not
+ *
+ */
+volatile BOOLEAN g_VmexitProfilerEnabled;
+
+/**
+ * @brief Per-core samples of the VM-exit profiler
+ *
+ */
+VMEXIT_PROFILER_CORE_DATA * g_VmexitProfilerCoreData;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static VOID
+VmexitProfilerMergeCoreData(VMEXIT_PROFILER_RESULTS * Results, VMEXIT_PROFILER_RESULTS * CoreSamples);
+
+//////////////////////////////////////////////////
+//				   Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+VmexitProfilerInitialize();
+
+VOID
+VmexitProfilerUninitialize();
+
+VOID
+VmexitProfilerEnable(BOOLEAN Enable);
+
+VOID
+VmexitProfilerReset();
+
+VOID
+VmexitProfilerRecordExit(UINT32 CoreId, UINT32 ExitReason, UINT64 Cycles);
+
+VOID
+VmexitProfilerAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles);
+
+VOID
+VmexitProfilerMergeHistogram(VMEXIT_PROFILER_HISTOGRAM * Destination, VMEXIT_PROFILER_HISTOGRAM * Source);
+
+BOOLEAN
+VmexitProfilerQuery(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results);
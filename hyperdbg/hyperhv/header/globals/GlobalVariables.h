@@ -43,6 +43,19 @@ VIRTUAL_MACHINE_STATE * g_GuestState;
  */
 MEMORY_MAPPER_ADDRESSES * g_MemoryMapper;
 
+/**
+ * @brief Per-core guest translation cache
+ *
+ */
+TRANSLATION_CACHE_CORE_DATA * g_TranslationCache;
+
+/**
+ * @brief Epoch of the translation cache, cached translations from
+ * older epochs are invalid
+ *
+ */
+volatile UINT64 g_TranslationCacheEpoch;
+
 /**
  * @brief Save the state and variables related to EPT
  *
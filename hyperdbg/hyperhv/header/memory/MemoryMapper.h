@@ -23,6 +23,12 @@
 #define PAGE_4MB_OFFSET ((UINT64)(1 << 22) - 1)
 #define PAGE_1GB_OFFSET ((UINT64)(1 << 30) - 1)
 
+/**
+ * @brief Number of pages in the multi-page mapping window of each core
+ *
+ */
+#define MEMORY_MAPPER_RANGE_PAGES 16
+
 //////////////////////////////////////////////////
 //					   Enums  					//
 //////////////////////////////////////////////////
@@ -106,6 +112,16 @@ typedef struct _MEMORY_MAPPER_ADDRESSES
 
     UINT64 PteVirtualAddressForWrite; // The virtual address of PTE for write operations
     UINT64 VirualAddressForWrite;     // The actual kernel virtual address to write
+
+    UINT64 VirtualAddressForRange;                                // The kernel virtual address of the multi-page window
+    UINT64 PteVirtualAddressesForRange[MEMORY_MAPPER_RANGE_PAGES]; // The virtual addresses of PTEs of the multi-page window
+    UINT32 MappedPagesInRange;                                    // Number of pages that are currently mapped in the window
+
+    UINT64  ReservedAddressForLargeRange;   // The reserved kernel virtual address (two large pages) for the large window
+    UINT64  VirtualAddressForLargeRange;    // The large page aligned address inside the reserved range
+    UINT64  PdeVirtualAddressForLargeRange; // The virtual address of PDE of the large window
+    UINT64  OriginalPdeForLargeRange;       // The original PDE which is restored after unmapping the large window
+    BOOLEAN IsLargeRangeMapped;             // Whether the large window is currently mapped or not
 } MEMORY_MAPPER_ADDRESSES, *PMEMORY_MAPPER_ADDRESSES;
 
 //////////////////////////////////////////////////
@@ -144,6 +160,45 @@ MemoryMapperGetPteByCr3(_In_ PVOID    VirtualAddress,
 static PVOID
 MemoryMapperMapPageAndGetPte(_Out_ PUINT64 PteAddress);
 
+static VOID
+MemoryMapperReserveRange(_Inout_ PMEMORY_MAPPER_ADDRESSES MemoryMapper);
+
+static VOID
+MemoryMapperMapPageInRange(_Inout_ PMEMORY_MAPPER_ADDRESSES MemoryMapper,
+                           _In_ UINT32                      Index,
+                           _In_ UINT64                      PhysicalAddress);
+
+static VOID
+MemoryMapperInvalidateRange(_In_ PMEMORY_MAPPER_ADDRESSES MemoryMapper,
+                            _In_ UINT32                   PageCount);
+
+static BOOLEAN
+MemoryMapperCheckIfLargeFrameIsWriteBack(_In_ UINT64 FrameAddress);
+
+static PVOID
+MemoryMapperMapLargeRange(_Inout_ PMEMORY_MAPPER_ADDRESSES MemoryMapper,
+                          _In_ UINT64                      PhysicalAddress,
+                          _In_ SIZE_T                      Size,
+                          _Out_ PSIZE_T                    MappedSize);
+
+static PVOID
+MemoryMapperMapRangeForAccess(_In_ BOOLEAN       IsWrite,
+                              _In_ UINT32        TypeOfAccess,
+                              _In_ UINT64        Address,
+                              _In_ SIZE_T        Size,
+                              _In_opt_ PCR3_TYPE TargetProcessCr3,
+                              _In_opt_ UINT32    TargetProcessId,
+                              _Out_ PSIZE_T      MappedSize);
+
+static BOOLEAN
+MemoryMapperCopyRange(_In_ BOOLEAN       IsWrite,
+                      _In_ UINT32        TypeOfAccess,
+                      _In_ UINT64        Address,
+                      _Inout_ UINT64     Buffer,
+                      _In_ SIZE_T        Size,
+                      _In_opt_ PCR3_TYPE TargetProcessCr3,
+                      _In_opt_ UINT32    TargetProcessId);
+
 static BOOLEAN
 MemoryMapperReadMemorySafeByPte(_In_ PHYSICAL_ADDRESS PaAddressToRead,
                                 _Inout_ PVOID         BufferToSaveMemory,
@@ -196,6 +251,15 @@ MemoryMapperInitialize();
 VOID
 MemoryMapperUninitialize();
 
+PVOID
+MemoryMapperMapRange(_In_ MEMORY_MAPPER_WRAPPER_FOR_MEMORY_READ TypeOfAddress,
+                     _In_ UINT64                                Address,
+                     _In_ SIZE_T                                Size,
+                     _Out_ PSIZE_T                              MappedSize);
+
+VOID
+MemoryMapperUnmapRange();
+
 BOOLEAN
 MemoryMapperCheckIfPageIsPresentByCr3(_In_ PVOID    Va,
                                       _In_ CR3_TYPE TargetCr3);
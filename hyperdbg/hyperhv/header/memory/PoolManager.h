@@ -16,11 +16,25 @@
 //////////////////////////////////////////////////
 
 /**
- * @brief Maximum Pool Requests (while not allocated)
+ * @brief Number of intentions (each intention has a fixed size, so each
+ * intention is treated as a separate size class)
  *
  */
-#define MaximumRequestsQueueDepth   300
-#define NumberOfPreAllocatedBuffers 10
+#define POOL_MANAGER_NUMBER_OF_INTENTIONS (INSTANT_BIG_SAFE_BUFFER_FOR_EVENTS + 1)
+
+/**
+ * @brief Maximum pools that each core caches for each intention
+ *
+ */
+#define POOL_MANAGER_MAGAZINE_SIZE 4
+
+/**
+ * @brief Extra pools are moved from the global depot to the core's magazine only
+ * if the depot has more than this number of pools (to avoid hoarding the pools in
+ * one core when there are a few pools available)
+ *
+ */
+#define POOL_MANAGER_MAGAZINE_REFILL_DEPOT_THRESHOLD 16
 
 //////////////////////////////////////////////////
 //                   Structures		   			//
@@ -36,42 +50,94 @@ typedef struct _POOL_TABLE
     SIZE_T                    Size;
     POOL_ALLOCATION_INTENTION Intention;
     LIST_ENTRY                PoolsList;
+    struct _POOL_TABLE *      DepotNext; // Next free pool in the depot of the intention
     BOOLEAN                   IsBusy;
+    BOOLEAN                   IsInDepot; // The pool is free and it's in the depot or in a magazine
     BOOLEAN                   ShouldBeFreed;
     BOOLEAN                   AlreadyFreed;
 
 } POOL_TABLE, *PPOOL_TABLE;
 
 /**
- * @brief Manage the requests for new allocations
+ * @brief Head of the lock-free stack of free pools (global depot)
+ * @details Tag is incremented on each change to avoid the ABA problem
  *
  */
-typedef struct _REQUEST_NEW_ALLOCATION
+typedef struct DECLSPEC_ALIGN(16) _POOL_DEPOT_HEAD
 {
-    SIZE_T                    Size;
-    UINT32                    Count;
-    POOL_ALLOCATION_INTENTION Intention;
+    PPOOL_TABLE Top;
+    UINT64      Tag;
+
+} POOL_DEPOT_HEAD, *PPOOL_DEPOT_HEAD;
+
+/**
+ * @brief State and statistics of each intention
+ *
+ */
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _POOL_INTENTION_STATE
+{
+    POOL_DEPOT_HEAD Depot;              // Lock-free stack of free pools
+    volatile LONG   DepotCount;         // Count of pools in the depot
+    volatile LONG   Available;          // Count of free pools (depot and magazines)
+    volatile LONG   InUse;              // Count of pools that are given and not freed yet
+    volatile LONG   HighWaterMark;      // Maximum of InUse
+    volatile LONG   PendingAllocations; // Count of pools that should be allocated in the next safe point
+    volatile LONG64 Hits;
+    volatile LONG64 Misses;
+    volatile LONG64 MagazineHits;
+    volatile SIZE_T Size;
+
+} POOL_INTENTION_STATE, *PPOOL_INTENTION_STATE;
+
+/**
+ * @brief Per-core cache of free pools of an intention
+ *
+ */
+typedef struct _POOL_MAGAZINE
+{
+    UINT32      Count;
+    PPOOL_TABLE Pools[POOL_MANAGER_MAGAZINE_SIZE];
+
+} POOL_MAGAZINE, *PPOOL_MAGAZINE;
+
+/**
+ * @brief Per-core magazines of all of the intentions
+ * @details Aligned to the cache line to avoid false sharing between cores,
+ * magazines are only accessed from vmx-root of their own core
+ *
+ */
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _POOL_PER_CORE_MAGAZINES
+{
+    POOL_MAGAZINE Magazines[POOL_MANAGER_NUMBER_OF_INTENTIONS];
 
-} REQUEST_NEW_ALLOCATION, *PREQUEST_NEW_ALLOCATION;
+} POOL_PER_CORE_MAGAZINES, *PPOOL_PER_CORE_MAGAZINES;
 
 //////////////////////////////////////////////////
 //                   Variables	    			//
 //////////////////////////////////////////////////
 
 /**
- * @brief If sb wants allocation from vmx root, adds it's request to this structure
+ * @brief State of each intention (depot, statistics, and pending allocations)
  *
  */
-REQUEST_NEW_ALLOCATION * g_RequestNewAllocation;
+POOL_INTENTION_STATE g_PoolIntentions[POOL_MANAGER_NUMBER_OF_INTENTIONS];
 
 /**
- * @brief Request allocation Spinlock
+ * @brief Per-core magazines
  *
  */
-volatile LONG LockForRequestAllocation;
+POOL_PER_CORE_MAGAZINES * g_PoolPerCoreMagazines;
+
+/**
+ * @brief Count of per-core magazines
+ *
+ */
+UINT32 g_PoolPerCoreMagazinesCount;
 
 /**
  * @brief Spinlock for reading pool
+ * @details Only protects the list of all pools (freeing and showing the pools),
+ * requesting pools doesn't need this lock
  *
  */
 volatile LONG LockForReadingPool;
@@ -94,6 +160,14 @@ BOOLEAN g_IsNewRequestForDeAllocation;
  */
 LIST_ENTRY g_ListOfAllocatedPoolsHead;
 
+/**
+ * @brief List of the records of the freed pools
+ * @details the records are reused instead of being freed, because a lock-free pop
+ * might still read the next pointer of a record that is already popped and freed
+ *
+ */
+LIST_ENTRY g_ListOfRecycledPoolTablesHead;
+
 //////////////////////////////////////////////////
 //                   Functions		  			//
 //////////////////////////////////////////////////
@@ -102,13 +176,20 @@ LIST_ENTRY g_ListOfAllocatedPoolsHead;
 // Private Interfaces
 //
 
-/// @brief Allocate global requesting variable
-/// @param NumberOfBytes
-/// @return
-static BOOLEAN
-PlmgrAllocateRequestNewAllocation(SIZE_T NumberOfBytes);
+static VOID
+PlmgrDepotPush(PPOOL_INTENTION_STATE IntentionState, PPOOL_TABLE PoolTable);
+
+static PPOOL_TABLE
+PlmgrDepotPop(PPOOL_INTENTION_STATE IntentionState);
+
+static PPOOL_TABLE
+PlmgrMagazinePop(PPOOL_INTENTION_STATE IntentionState, POOL_ALLOCATION_INTENTION Intention);
+
+static PPOOL_TABLE
+PlmgrTakePool(PPOOL_INTENTION_STATE IntentionState, POOL_ALLOCATION_INTENTION Intention);
 
-static VOID PlmgrFreeRequestNewAllocation(VOID);
+static VOID
+PlmgrUnlinkFreedPoolsFromDepots();
 
 // ----------------------------------------------------------------------------
 // Public Interfaces
@@ -0,0 +1,105 @@
+/**
+ * @file TranslationCache.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for the per-core guest translation cache
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Definitions					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of cached translations on each core (should be a power of two)
+ *
+ */
+#define TRANSLATION_CACHE_ENTRIES 64
+
+/**
+ * @brief Permissions of a cached translation (accumulated from all of
+ * the paging levels)
+ *
+ */
+#define TRANSLATION_CACHE_PERMISSION_WRITE   0x1
+#define TRANSLATION_CACHE_PERMISSION_USER    0x2
+#define TRANSLATION_CACHE_PERMISSION_EXECUTE 0x4
+
+//////////////////////////////////////////////////
+//					Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief A cached translation of a virtual page
+ *
+ */
+typedef struct _TRANSLATION_CACHE_ENTRY
+{
+    UINT64 Cr3PageFrame; // Page frame of the cr3 that the translation belongs to
+    UINT64 VirtualPage;  // Page-aligned virtual address
+    UINT64 PhysicalPage; // Page-aligned physical address
+    UINT64 Epoch;        // Global epoch at the time of caching the translation
+    UINT64 Generation;   // Core's generation (VM-exit) at the time of caching the translation
+    UINT64 Permissions;  // TRANSLATION_CACHE_PERMISSION_*
+
+} TRANSLATION_CACHE_ENTRY, *PTRANSLATION_CACHE_ENTRY;
+
+/**
+ * @brief Per-core translation cache
+ * @details Each core only accesses its own structure in vmx-root mode,
+ * so no lock is needed
+ *
+ */
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _TRANSLATION_CACHE_CORE_DATA
+{
+    TRANSLATION_CACHE_ENTRY Entries[TRANSLATION_CACHE_ENTRIES];
+    UINT64                  Generation;
+    UINT64                  Hits;
+    UINT64                  Misses;
+
+} TRANSLATION_CACHE_CORE_DATA, *PTRANSLATION_CACHE_CORE_DATA;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static BOOLEAN
+TranslationCacheWalk(_In_ UINT64   Va,
+                     _In_ CR3_TYPE TargetCr3,
+                     _Out_ PUINT64 PhysicalAddress,
+                     _Out_ PUINT64 Permissions);
+
+//////////////////////////////////////////////////
+//				    Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+TranslationCacheInitialize();
+
+VOID
+TranslationCacheUninitialize();
+
+VOID
+TranslationCacheInvalidate();
+
+VOID
+TranslationCacheStartVmexit(_In_ UINT32 CoreId);
+
+BOOLEAN
+TranslationCacheTranslate(_In_ CR3_TYPE     TargetCr3,
+                          _In_ UINT64       Va,
+                          _Out_opt_ PUINT64 PhysicalAddress,
+                          _Out_opt_ PUINT64 Permissions);
+
+VOID
+TranslationCacheQueryStatistics(_In_ UINT32     CoreId,
+                                _Inout_ PUINT64 Hits,
+                                _Inout_ PUINT64 Misses);
+
+VOID
+TranslationCacheResetStatistics();
@@ -194,6 +194,25 @@ EptCheckFeatures(VOID);
 BOOLEAN
 EptBuildMtrrMap(VOID);
 
+/**
+ * @brief Get the memory type of a small or a large page
+ *
+ * @param PageFrameNumber
+ * @param IsLargePage
+ * @return UINT8
+ */
+UINT8
+EptGetMemoryType(SIZE_T PageFrameNumber, BOOLEAN IsLargePage);
+
+/**
+ * @brief Check if potential large page doesn't land on two or more different cache memory types
+ *
+ * @param PageFrameNumber
+ * @return BOOLEAN
+ */
+BOOLEAN
+EptIsValidForLargePage(SIZE_T PageFrameNumber);
+
 /**
  * @brief Allocates page maps and create identity page table
  *
@@ -297,6 +297,30 @@
  */
 #define VMCALL_DISABLE_OR_ENABLE_MBEC 0x0000002d
 
+/**
+ * @brief VMCALL to flush the PML buffer into the dirty bitmap
+ *
+ */
+#define VMCALL_FLUSH_DIRTY_LOGGING_BUFFER 0x0000002e
+
+/**
+ * @brief VMCALL to write-protect the pages of the memory snapshot
+ *
+ */
+#define VMCALL_SNAPSHOT_PROTECT_PAGES 0x0000002f
+
+/**
+ * @brief VMCALL to remove the write protection of the pages of the memory snapshot
+ *
+ */
+#define VMCALL_SNAPSHOT_UNPROTECT_PAGES 0x00000030
+
+/**
+ * @brief VMCALL to restore the modified pages of the memory snapshot
+ *
+ */
+#define VMCALL_SNAPSHOT_RESTORE_PAGES 0x00000031
+
 //////////////////////////////////////////////////
 //				    Functions					//
 //////////////////////////////////////////////////
@@ -98,6 +98,7 @@
 #include "memory/Layout.h"
 #include "memory/SwitchLayout.h"
 #include "memory/AddressCheck.h"
+#include "memory/TranslationCache.h"
 #include "memory/Segmentation.h"
 #include "common/Bitwise.h"
 #include "common/Common.h"
@@ -120,7 +121,11 @@
 #include "hooks/Hooks.h"
 #include "hooks/ModeBasedExecHook.h"
 #include "interface/Callback.h"
+#include "features/DirtyBitmap.h"
 #include "features/DirtyLogging.h"
+#include "features/SnapshotTracker.h"
+#include "features/Snapshot.h"
+#include "features/VmexitProfiler.h"
 #include "features/CompatibilityChecks.h"
 
 //
@@ -128,6 +133,7 @@
 //
 #include "Zydis/Zydis.h"
 #include "disassembler/Disassembler.h"
+#include "disassembler/LengthDisassembler.h"
 
 //
 // Broadcast headers
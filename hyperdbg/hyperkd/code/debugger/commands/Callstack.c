@@ -12,25 +12,226 @@
 #include "pch.h"
 
 /**
- * @brief Walkthrough the stack
+ * @brief Read the memory of the target process for the unwinder
+ *
+ * @param Address
+ * @param Buffer
+ * @param Size
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+CallstackUnwindReadMemory(UINT64 Address, PVOID Buffer, UINT32 Size)
+{
+    if (!CheckAccessValidityAndSafety(Address, Size))
+    {
+        return FALSE;
+    }
+
+    return MemoryMapperReadMemorySafeOnTargetProcess(Address, Buffer, Size);
+}
+
+/**
+ * @brief Fill the details of a single stack slot
+ *
+ * @param Frame
+ * @param StackAddress
+ * @param AddressMode
+ *
+ * @return BOOLEAN FALSE if the stack is not accessible
+ */
+static BOOLEAN
+CallstackFillFrame(PDEBUGGER_SINGLE_CALLSTACK_FRAME Frame,
+                   UINT64                           StackAddress,
+                   UINT16                           AddressMode)
+{
+    UINT64 Value = (UINT64)NULL;
+
+    if (!CheckAccessValidityAndSafety(StackAddress, AddressMode))
+    {
+        Frame->IsStackAddressValid = FALSE;
+
+        //
+        // Stack is no longer valid or available to access from here
+        //
+        return FALSE;
+    }
+
+    //
+    // Stack address is valid
+    //
+    Frame->IsStackAddressValid = TRUE;
+
+    //
+    // Read the 4 or 8 byte from the target stack
+    //
+    MemoryMapperReadMemorySafeOnTargetProcess(StackAddress, &Value, AddressMode);
+
+    //
+    // Set the value
+    //
+    Frame->Value = Value;
+
+    //
+    // This implementation has a problem, if the target jump is between two page were the second
+    // page is not available, it fails to set it as the valid address,
+    // We should check it for this page attribute (check boundary) but for now, i'm lazy enough
+    // to let it unimplemented
+    //
+    // Check if value is a valid address
+    //
+    if (CheckAccessValidityAndSafety(Value, MAXIMUM_CALL_INSTR_SIZE))
+    {
+        //
+        // It's a valid address
+        //
+        Frame->IsValidAddress = TRUE;
+
+        //
+        // Check if the target page has NX bit (executable page)
+        //
+        Frame->IsExecutable = MemoryMapperCheckIfPageIsNxBitSetOnTargetProcess((PVOID)Value);
+
+        //
+        // Read the memory at the target address
+        //
+        MemoryMapperReadMemorySafeOnTargetProcess(Value - MAXIMUM_CALL_INSTR_SIZE,
+                                                  Frame->InstructionBytesOnRip,
+                                                  MAXIMUM_CALL_INSTR_SIZE);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Walk the frames based on the unwind data of the modules
+ * @details The slots of the return addresses are marked in the frames
  *
  * @param AddressToSaveFrames
  * @param StackBaseAddress
- * @param Size
- * @param Is32Bit
+ * @param FrameCount
+ * @param Regs
+ * @param Rip
+ *
+ * @return UINT32 Number of the slots (from the base) that are covered by
+ * unwinding, the rest of the slots should be interpreted heuristically
+ */
+static UINT32
+CallstackUnwindFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
+                      UINT64                           StackBaseAddress,
+                      UINT32                           FrameCount,
+                      GUEST_REGS *                     Regs,
+                      UINT64                           Rip)
+{
+    UNWIND_CONTEXT Context;
+    UNWIND_STATUS  Status;
+    UINT64         ReturnAddressLocation;
+    UINT32         CoveredFrameCount = MAXUINT32;
+    UINT64         StackEndAddress   = StackBaseAddress + (UINT64)FrameCount * sizeof(UINT64);
+    UINT64         AddressSpace      = LayoutGetCurrentProcessCr3().Flags;
+
+    //
+    // The state (and the caches) of the unwinder are shared between the cores
+    //
+    SpinlockLock(&g_CallstackUnwindStateLock);
+
+    if (g_CallstackUnwindState.ReadMemory == NULL)
+    {
+        UnwindInitialize(&g_CallstackUnwindState, CallstackUnwindReadMemory);
+    }
+
+    //
+    // Registers of the guest have the same order as the encoding of the
+    // registers
+    //
+    Context.Rip = Rip;
+    RtlCopyMemory(Context.Registers, Regs, sizeof(Context.Registers));
+
+    while (Context.Registers[UNWIND_REGISTER_RSP] < StackEndAddress)
+    {
+        if (Context.Rip == (UINT64)NULL)
+        {
+            //
+            // The end of the stack (e.g., start of the thread)
+            //
+            CoveredFrameCount = FrameCount;
+            break;
+        }
+
+        Status = UnwindStep(&g_CallstackUnwindState, AddressSpace, &Context, &ReturnAddressLocation);
+
+        if (Status != UNWIND_STATUS_SUCCESS)
+        {
+            //
+            // The unwind data of the function is not available, the rest of
+            // the stack is interpreted heuristically
+            //
+            break;
+        }
+
+        if (ReturnAddressLocation >= StackBaseAddress && ReturnAddressLocation < StackEndAddress)
+        {
+            UINT32 Index = (UINT32)((ReturnAddressLocation - StackBaseAddress) / sizeof(UINT64));
+
+            if (!CallstackFillFrame(&AddressToSaveFrames[Index], ReturnAddressLocation, sizeof(UINT64)))
+            {
+                CoveredFrameCount = Index;
+                break;
+            }
+
+            AddressToSaveFrames[Index].IsReturnAddress = TRUE;
+        }
+    }
+
+    SpinlockUnlock(&g_CallstackUnwindStateLock);
+
+    if (CoveredFrameCount != MAXUINT32)
+    {
+        return CoveredFrameCount;
+    }
+
+    if (Context.Registers[UNWIND_REGISTER_RSP] <= StackBaseAddress)
+    {
+        return 0;
+    }
+
+    if (Context.Registers[UNWIND_REGISTER_RSP] >= StackEndAddress)
+    {
+        return FrameCount;
+    }
+
+    return (UINT32)((Context.Registers[UNWIND_REGISTER_RSP] - StackBaseAddress) / sizeof(UINT64));
+}
+
+/**
+ * @brief Walkthrough the stack
+ * @details If the registers are available, the frames are found by the
+ * unwind data (.pdata/.xdata) of the modules and the slots that are not
+ * covered by unwinding are interpreted heuristically
+ *
+ * @param CallstackRequest
+ * @param AddressToSaveFrames
+ * @param Regs The registers of the current frame (NULL if the stack is not
+ * walked from the current frame)
+ * @param Rip
  *
  * @return BOOLEAN
  */
 BOOLEAN
-CallstackWalkthroughStack(PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
-                          UINT64                           StackBaseAddress,
-                          UINT32                           Size,
-                          BOOLEAN                          Is32Bit)
+CallstackWalkthroughStack(PDEBUGGER_CALLSTACK_REQUEST      CallstackRequest,
+                          PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
+                          GUEST_REGS *                     Regs,
+                          UINT64                           Rip)
 {
-    UINT32 FrameIndex          = 0;
-    UINT16 AddressMode         = 0;
-    UINT64 Value               = (UINT64)NULL;
-    UINT64 CurrentStackAddress = (UINT64)NULL;
+    UINT32  FrameIndex          = 0;
+    UINT32  UnwoundFrameCount   = 0;
+    UINT16  AddressMode         = 0;
+    UINT64  CurrentStackAddress = (UINT64)NULL;
+    UINT64  StackBaseAddress    = CallstackRequest->BaseAddress;
+    UINT32  Size                = CallstackRequest->Size;
+    BOOLEAN Is32Bit             = CallstackRequest->Is32Bit;
+
+    CallstackRequest->UnwoundFrameCount = 0;
 
     if (Size == 0)
     {
@@ -54,67 +255,41 @@ CallstackWalkthroughStack(PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
         FrameIndex  = Size / AddressMode;
     }
 
+    //
+    // Find the frames based on the unwind data (only for 64-bit stacks that
+    // are walked from the current frame)
+    //
+    if (!Is32Bit && Regs != NULL)
+    {
+        UnwoundFrameCount = CallstackUnwindFrames(AddressToSaveFrames, StackBaseAddress, FrameIndex, Regs, Rip);
+
+        CallstackRequest->UnwoundFrameCount = UnwoundFrameCount;
+    }
+
     //
     // Walkthrough the stack
     //
-    for (size_t i = 0; i < FrameIndex; i++)
+    for (UINT32 i = 0; i < FrameIndex; i++)
     {
         //
-        // Compute the current stack position address
+        // The slots that are covered by unwinding are only needed if the
+        // parameters are shown
         //
-        CurrentStackAddress = StackBaseAddress + (i * AddressMode);
-
-        if (!CheckAccessValidityAndSafety(CurrentStackAddress, AddressMode))
+        if (i < UnwoundFrameCount &&
+            (AddressToSaveFrames[i].IsReturnAddress ||
+             CallstackRequest->DisplayMethod == DEBUGGER_CALLSTACK_DISPLAY_METHOD_WITHOUT_PARAMS))
         {
-            AddressToSaveFrames[i].IsStackAddressValid = FALSE;
-
-            //
-            // Stack is no longer valid or available to access from here
-            //
-            return FALSE;
+            continue;
         }
 
         //
-        // Stack address is valid
-        //
-        AddressToSaveFrames[i].IsStackAddressValid = TRUE;
-
-        //
-        // Read the 4 or 8 byte from the target stack
-        //
-        MemoryMapperReadMemorySafeOnTargetProcess(CurrentStackAddress, &Value, AddressMode);
-
-        //
-        // Set the value
+        // Compute the current stack position address
         //
-        AddressToSaveFrames[i].Value = Value;
+        CurrentStackAddress = StackBaseAddress + (i * AddressMode);
 
-        //
-        // This implementation has a problem, if the target jump is between two page were the second
-        // page is not available, it fails to set it as the valid address,
-        // We should check it for this page attribute (check boundary) but for now, i'm lazy enough
-        // to let it unimplemented
-        //
-        // Check if value is a valid address
-        //
-        if (CheckAccessValidityAndSafety(Value, MAXIMUM_CALL_INSTR_SIZE))
+        if (!CallstackFillFrame(&AddressToSaveFrames[i], CurrentStackAddress, AddressMode))
         {
-            //
-            // It's a valid address
-            //
-            AddressToSaveFrames[i].IsValidAddress = TRUE;
-
-            //
-            // Check if the target page has NX bit (executable page)
-            //
-            AddressToSaveFrames[i].IsExecutable = MemoryMapperCheckIfPageIsNxBitSetOnTargetProcess((PVOID)Value);
-
-            //
-            // Read the memory at the target address
-            //
-            MemoryMapperReadMemorySafeOnTargetProcess(Value - MAXIMUM_CALL_INSTR_SIZE,
-                                                      AddressToSaveFrames[i].InstructionBytesOnRip,
-                                                      MAXIMUM_CALL_INSTR_SIZE);
+            return FALSE;
         }
     }
 
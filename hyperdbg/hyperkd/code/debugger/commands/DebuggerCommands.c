@@ -140,6 +140,7 @@ DebuggerCommandReadMemoryVmxRoot(PDEBUGGER_READ_MEMORY ReadMemRequest, UCHAR * U
     UINT32                    Size;
     UINT64                    Address;
     UINT64                    OffsetInUserBuffer;
+    UINT64                    CurrentPage;
     DEBUGGER_READ_MEMORY_TYPE MemType;
     BOOLEAN                   Is32BitProcess = FALSE;
     PLIST_ENTRY               TempList       = 0;
@@ -155,14 +156,24 @@ DebuggerCommandReadMemoryVmxRoot(PDEBUGGER_READ_MEMORY ReadMemRequest, UCHAR * U
     if (MemType == DEBUGGER_READ_PHYSICAL_ADDRESS)
     {
         //
-        // Check whether the physical memory is valid or not
+        // Check whether the physical memory is valid or not, the request might
+        // be a batch of pages (e.g., the '.dump' command), so every page is checked
         //
-        if (!CheckAddressPhysical(Address))
+        if (Size == 0 || Address + Size - 1 < Address)
         {
             ReadMemRequest->KernelStatus = DEBUGGER_ERROR_INVALID_PHYSICAL_ADDRESS;
             return FALSE;
         }
 
+        for (CurrentPage = (UINT64)PAGE_ALIGN(Address); CurrentPage <= Address + Size - 1; CurrentPage += PAGE_SIZE)
+        {
+            if (!CheckAddressPhysical(CurrentPage))
+            {
+                ReadMemRequest->KernelStatus = DEBUGGER_ERROR_INVALID_PHYSICAL_ADDRESS;
+                return FALSE;
+            }
+        }
+
         MemoryMapperReadMemorySafeByPhysicalAddress(Address, (UINT64)UserBuffer, Size);
     }
     else if (MemType == DEBUGGER_READ_VIRTUAL_ADDRESS)
@@ -654,302 +665,14 @@ DebuggerCommandEditMemoryVmxRoot(PDEBUGGER_EDIT_MEMORY EditMemRequest)
     return TRUE;
 }
 
-/**
- * @brief Search on virtual memory (not work on physical memory)
- *
- * @details This function can be called from vmx-root mode
- * Do NOT directly call this function as the virtual addresses
- * should be valid on the target process memory layout
- * instead call : SearchAddressWrapper
- * the address between StartAddress and EndAddress should be contiguous
- *
- * @param AddressToSaveResults Address to save the search results
- * @param SearchMemRequest request structure of searching memory
- * @param StartAddress valid start address based on target process
- * @param EndAddress valid end address based on target process
- * @param IsDebuggeePaused Set to true when the search is performed in
- * the debugger mode
- * @param CountOfMatchedCases Number of matched cases
- * @return BOOLEAN Whether the search was successful or not
- */
-BOOLEAN
-PerformSearchAddress(UINT64 *                AddressToSaveResults,
-                     PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
-                     UINT64                  StartAddress,
-                     UINT64                  EndAddress,
-                     BOOLEAN                 IsDebuggeePaused,
-                     PUINT32                 CountOfMatchedCases)
-{
-    UINT32   CountOfOccurance      = 0;
-    UINT64   Cmp64                 = 0;
-    UINT32   IndexToArrayOfResults = 0;
-    UINT32   LengthOfEachChunk     = 0;
-    PVOID    TempSourceAddress     = 0;
-    PVOID    SourceAddress         = 0;
-    BOOLEAN  StillMatch            = FALSE;
-    UINT64   TempValue             = (UINT64)NULL;
-    CR3_TYPE CurrentProcessCr3     = {0};
-
-    //
-    // set chunk size in each modification
-    //
-    if (SearchMemRequest->ByteSize == SEARCH_BYTE)
-    {
-        LengthOfEachChunk = 1;
-    }
-    else if (SearchMemRequest->ByteSize == SEARCH_DWORD)
-    {
-        LengthOfEachChunk = 4;
-    }
-    else if (SearchMemRequest->ByteSize == SEARCH_QWORD)
-    {
-        LengthOfEachChunk = 8;
-    }
-    else
-    {
-        //
-        // Invalid parameter
-        //
-        return FALSE;
-    }
-
-    //
-    // Check if address is virtual address or physical address
-    //
-    if (SearchMemRequest->MemoryType == SEARCH_VIRTUAL_MEMORY ||
-        SearchMemRequest->MemoryType == SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY)
-    {
-        //
-        // Search the memory
-        //
-
-        //
-        // Change the memory layout (cr3), if the user specified a
-        // special process
-        //
-        if (IsDebuggeePaused)
-        {
-            //
-            // Switch to target process memory layout
-            //
-            CurrentProcessCr3 = SwitchToProcessMemoryLayoutByCr3(LayoutGetCurrentProcessCr3());
-        }
-        else
-        {
-            if (SearchMemRequest->ProcessId != HANDLE_TO_UINT32(PsGetCurrentProcessId()))
-            {
-                CurrentProcessCr3 = SwitchToProcessMemoryLayout(SearchMemRequest->ProcessId);
-            }
-        }
-
-        //
-        // Here we iterate through the buffer we received from
-        // user-mode
-        //
-        SourceAddress = (PVOID)((UINT64)SearchMemRequest + SIZEOF_DEBUGGER_SEARCH_MEMORY);
-
-        for (size_t BaseIterator = (size_t)StartAddress; BaseIterator < ((UINT64)EndAddress); BaseIterator += LengthOfEachChunk)
-        {
-            //
-            // *** Search the memory ***
-            //
-
-            //
-            // Copy 64bit, 32bit or one byte value into Cmp64 buffer and then compare it
-            // Check if we should access the memory directly, or through safe memory
-            // routine from vmx-root
-            //
-            if (IsDebuggeePaused)
-            {
-                MemoryMapperReadMemorySafe((UINT64)BaseIterator, &Cmp64, LengthOfEachChunk);
-            }
-            else
-            {
-                RtlCopyMemory(&Cmp64, (PVOID)BaseIterator, LengthOfEachChunk);
-            }
-
-            //
-            // Get the searching bytes
-            //
-            TempValue = *(UINT64 *)SourceAddress;
-
-            //
-            // Check whether the byte matches the source or not
-            //
-            if (Cmp64 == TempValue)
-            {
-                //
-                // Indicate that it matches until now
-                //
-                StillMatch = TRUE;
-
-                //
-                // Try to check each element (we don't start from the very first element as
-                // it checked before )
-                //
-                for (size_t i = LengthOfEachChunk; i < SearchMemRequest->CountOf64Chunks; i++)
-                {
-                    //
-                    // I know, we have a double check here ;)
-                    //
-                    TempSourceAddress = (PVOID)((UINT64)SearchMemRequest + SIZEOF_DEBUGGER_SEARCH_MEMORY + (i * sizeof(UINT64)));
-
-                    //
-                    // Add i to BaseIterator and recompute the Cmp64
-                    // Check if we should access the memory directly, or through safe memory
-                    // routine from vmx-root
-                    //
-                    if (IsDebuggeePaused)
-                    {
-                        MemoryMapperReadMemorySafe((UINT64)(BaseIterator + (LengthOfEachChunk * i)), &Cmp64, LengthOfEachChunk);
-                    }
-                    else
-                    {
-                        RtlCopyMemory(&Cmp64, (PVOID)(BaseIterator + (LengthOfEachChunk * i)), LengthOfEachChunk);
-                    }
-
-                    //
-                    // Check if we should access the memory directly,
-                    // or through safe memory routine from vmx-root
-                    //
-                    if (IsDebuggeePaused)
-                    {
-                        MemoryMapperReadMemorySafe((UINT64)TempSourceAddress, &TempValue, sizeof(UINT64));
-                    }
-                    else
-                    {
-                        TempValue = *(UINT64 *)TempSourceAddress;
-                    }
-
-                    if (!(Cmp64 == TempValue))
-                    {
-                        //
-                        // One thing didn't match so this is not the pattern
-                        //
-                        StillMatch = FALSE;
-
-                        //
-                        // Break from the loop
-                        //
-                        break;
-                    }
-                }
-
-                //
-                // Check if we find the pattern or not
-                //
-                if (StillMatch)
-                {
-                    //
-                    // We found the a matching address, let's save the
-                    // address for future use
-                    //
-                    CountOfOccurance++;
-
-                    if (IsDebuggeePaused)
-                    {
-                        if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY)
-                        {
-                            //
-                            // It's a physical memory
-                            //
-                            Log("%llx\n", VirtualAddressToPhysicalAddress((PVOID)BaseIterator));
-                        }
-                        else
-                        {
-                            //
-                            // It's a virtual memory
-                            //
-                            Log("%llx\n", BaseIterator);
-                        }
-                    }
-                    else
-                    {
-                        if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY)
-                        {
-                            //
-                            // It's a physical memory
-                            //
-                            AddressToSaveResults[IndexToArrayOfResults] = VirtualAddressToPhysicalAddress((PVOID)BaseIterator);
-                        }
-                        else
-                        {
-                            //
-                            // It's a virtual memory
-                            //
-                            AddressToSaveResults[IndexToArrayOfResults] = BaseIterator;
-                        }
-                    }
-
-                    //
-                    // Increase the array pointer if it doesn't exceed the limitation
-                    //
-                    if (MaximumSearchResults > IndexToArrayOfResults)
-                    {
-                        IndexToArrayOfResults++;
-                    }
-                    else
-                    {
-                        //
-                        // The result buffer is full!
-                        //
-                        *CountOfMatchedCases = CountOfOccurance;
-                        return TRUE;
-                    }
-                }
-            }
-            else
-            {
-                //
-                // Not found in the place
-                //
-                continue;
-            }
-        }
-
-        //
-        // Restore the previous memory layout (cr3), if the user specified a
-        // special process
-        //
-        if (IsDebuggeePaused || SearchMemRequest->ProcessId != HANDLE_TO_UINT32(PsGetCurrentProcessId()))
-        {
-            SwitchToPreviousProcess(CurrentProcessCr3);
-        }
-    }
-    else if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_MEMORY)
-    {
-        //
-        // That's an error, the physical memory is handled like virtual memory and
-        // thus we should never reach here
-        //
-        LogError("Err, searching physical memory is not allowed without virtual address");
-
-        return FALSE;
-    }
-    else
-    {
-        //
-        // Invalid parameter
-        //
-        return FALSE;
-    }
-
-    //
-    // As we're here the search is finished without error
-    //
-    *CountOfMatchedCases = CountOfOccurance;
-    return TRUE;
-}
-
 /**
  * @brief The wrapper to check for validity of addresses and call
  * the search routines for both physical and virtual memory
  *
  * @details This function can be called from vmx-root mode
- * The address between start address and end address will be checked
- * to make a contiguous address
+ * Pages of the range that are not present are skipped by the
+ * search engine
  *
- * @param AddressToSaveResults Address to save the search results
  * @param SearchMemRequest request structure of searching memory
  * @param StartAddress start address of searching based on target process
  * @param EndAddress start address of searching based on target process
@@ -959,143 +682,42 @@ PerformSearchAddress(UINT64 *                AddressToSaveResults,
  * @return BOOLEAN Whether there was any error or not
  */
 BOOLEAN
-SearchAddressWrapper(PUINT64                 AddressToSaveResults,
-                     PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
+SearchAddressWrapper(PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
                      UINT64                  StartAddress,
                      UINT64                  EndAddress,
                      BOOLEAN                 IsDebuggeePaused,
                      PUINT32                 CountOfMatchedCases)
 {
     CR3_TYPE CurrentProcessCr3;
-    UINT64   BaseAddress         = 0;
-    UINT64   RealPhysicalAddress = 0;
-    UINT64   TempValue           = (UINT64)NULL;
-    UINT64   TempStartAddress    = (UINT64)NULL;
-    BOOLEAN  DoesBaseAddrSaved   = FALSE;
-    BOOLEAN  SearchResult        = FALSE;
+    BOOLEAN  SearchResult = FALSE;
 
     //
     // Reset the count of matched cases
     //
     *CountOfMatchedCases = 0;
 
-    if (SearchMemRequest->MemoryType == SEARCH_VIRTUAL_MEMORY)
-    {
-        //
-        // It's a virtual address search
-        //
-
-        //
-        // Align the page and search with alignment
-        //
-        TempStartAddress = StartAddress;
-        StartAddress     = (UINT64)PAGE_ALIGN(StartAddress);
-
-        if (IsDebuggeePaused)
-        {
-            //
-            // Switch to new process's memory layout
-            //
-            CurrentProcessCr3 = SwitchToProcessMemoryLayoutByCr3(LayoutGetCurrentProcessCr3());
-        }
-        else
-        {
-            //
-            // Switch to new process's memory layout
-            //
-            CurrentProcessCr3 = SwitchToProcessMemoryLayout(SearchMemRequest->ProcessId);
-        }
-
-        //
-        // We will try to find a contigues address
-        //
-        while (StartAddress < EndAddress)
-        {
-            //
-            // Check if address is valid or not
-            // Generally, we can use VirtualAddressToPhysicalAddressByProcessId
-            // but let's not change the cr3 multiple times
-            //
-            TempValue = VirtualAddressToPhysicalAddress((PVOID)StartAddress);
-
-            if (TempValue != 0)
-            {
-                //
-                // Address is valid, let's add a page size to it
-                // nothing to do
-                //
-                if (!DoesBaseAddrSaved)
-                {
-                    BaseAddress       = TempStartAddress;
-                    DoesBaseAddrSaved = TRUE;
-                }
-            }
-            else
-            {
-                //
-                // Address is not valid anymore
-                //
-                break;
-            }
-
-            //
-            // Make the start address ready for next address
-            //
-            StartAddress += PAGE_SIZE;
-        }
-
-        //
-        // Restore the original process
-        //
-        SwitchToPreviousProcess(CurrentProcessCr3);
-
-        //
-        // All of the address chunk was valid
-        //
-        if (DoesBaseAddrSaved && StartAddress > BaseAddress)
-        {
-            SearchResult = PerformSearchAddress(AddressToSaveResults,
-                                                SearchMemRequest,
-                                                BaseAddress,
-                                                EndAddress,
-                                                IsDebuggeePaused,
-                                                CountOfMatchedCases);
-        }
-        else
-        {
-            //
-            // There was an error, address was probably not contiguous
-            //
-            return FALSE;
-        }
-    }
-    else if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_MEMORY)
+    if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_MEMORY)
     {
         //
         // when we reached here, we know that it's a valid physical memory,
-        // so we change the structure and pass it as a virtual address to
-        // the search function
-        //
-        RealPhysicalAddress = SearchMemRequest->Address;
-
-        //
-        // Change the start address
+        // so we search it through its virtual address and the search engine
+        // converts the results back to physical addresses
         //
         if (IsDebuggeePaused)
         {
-            SearchMemRequest->Address = PhysicalAddressToVirtualAddressOnTargetProcess((PVOID)StartAddress);
-            EndAddress                = PhysicalAddressToVirtualAddressOnTargetProcess((PVOID)EndAddress);
+            StartAddress = PhysicalAddressToVirtualAddressOnTargetProcess((PVOID)StartAddress);
+            EndAddress   = PhysicalAddressToVirtualAddressOnTargetProcess((PVOID)EndAddress);
         }
         else if (SearchMemRequest->ProcessId == HANDLE_TO_UINT32(PsGetCurrentProcessId()))
         {
-            SearchMemRequest->Address = PhysicalAddressToVirtualAddress(StartAddress);
-            EndAddress                = PhysicalAddressToVirtualAddress(EndAddress);
+            StartAddress = PhysicalAddressToVirtualAddress(StartAddress);
+            EndAddress   = PhysicalAddressToVirtualAddress(EndAddress);
         }
         else
         {
-            SearchMemRequest->Address = PhysicalAddressToVirtualAddressByProcessId((PVOID)StartAddress,
-                                                                                   SearchMemRequest->ProcessId);
-            EndAddress                = PhysicalAddressToVirtualAddressByProcessId((PVOID)EndAddress,
+            StartAddress = PhysicalAddressToVirtualAddressByProcessId((PVOID)StartAddress,
+                                                                      SearchMemRequest->ProcessId);
+            EndAddress   = PhysicalAddressToVirtualAddressByProcessId((PVOID)EndAddress,
                                                                     SearchMemRequest->ProcessId);
         }
 
@@ -1103,22 +725,47 @@ SearchAddressWrapper(PUINT64                 AddressToSaveResults,
         // Change the type of memory
         //
         SearchMemRequest->MemoryType = SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY;
-
+    }
+    else if (SearchMemRequest->MemoryType != SEARCH_VIRTUAL_MEMORY)
+    {
         //
-        // Call the wrapper
+        // Invalid parameter
         //
-        SearchResult = PerformSearchAddress(AddressToSaveResults,
-                                            SearchMemRequest,
-                                            SearchMemRequest->Address,
-                                            EndAddress,
-                                            IsDebuggeePaused,
-                                            CountOfMatchedCases);
+        return FALSE;
+    }
 
-        //
-        // Restore the previous state
-        //
+    //
+    // Switch to the target process's memory layout once for the entire search
+    //
+    if (IsDebuggeePaused)
+    {
+        CurrentProcessCr3 = SwitchToProcessMemoryLayoutByCr3(LayoutGetCurrentProcessCr3());
+    }
+    else
+    {
+        CurrentProcessCr3 = SwitchToProcessMemoryLayout(SearchMemRequest->ProcessId);
+    }
+
+    //
+    // Call the search engine
+    //
+    SearchResult = MemorySearchPerform(SearchMemRequest,
+                                       StartAddress,
+                                       EndAddress,
+                                       IsDebuggeePaused,
+                                       CountOfMatchedCases);
+
+    //
+    // Restore the original process
+    //
+    SwitchToPreviousProcess(CurrentProcessCr3);
+
+    //
+    // Restore the previous state
+    //
+    if (SearchMemRequest->MemoryType == SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY)
+    {
         SearchMemRequest->MemoryType = SEARCH_PHYSICAL_MEMORY;
-        SearchMemRequest->Address    = RealPhysicalAddress;
     }
 
     return SearchResult;
@@ -1126,6 +773,9 @@ SearchAddressWrapper(PUINT64                 AddressToSaveResults,
 
 /**
  * @brief Start searching memory
+ * @details The results are sent as messages once they're found and
+ * the request buffer is filled with the result of the search
+ * (DEBUGGEE_RESULT_OF_SEARCH_PACKET)
  *
  * @param SearchMemRequest Request to search memory
  * @return NTSTATUS
@@ -1133,94 +783,39 @@ SearchAddressWrapper(PUINT64                 AddressToSaveResults,
 NTSTATUS
 DebuggerCommandSearchMemory(PDEBUGGER_SEARCH_MEMORY SearchMemRequest)
 {
-    PUINT64 SearchResultsStorage = NULL;
-    PUINT64 UsermodeBuffer       = NULL;
-    UINT64  AddressFrom          = 0;
-    UINT64  AddressTo            = 0;
-    UINT64  CurrentValue         = 0;
-    UINT32  ResultsIndex         = 0;
-    UINT32  CountOfResults       = 0;
+    DEBUGGEE_RESULT_OF_SEARCH_PACKET SearchResult = {0};
 
     //
     // Check if process id is valid or not
     //
     if (SearchMemRequest->ProcessId != HANDLE_TO_UINT32(PsGetCurrentProcessId()) && !CommonIsProcessExist(SearchMemRequest->ProcessId))
     {
-        return STATUS_INVALID_PARAMETER;
+        SearchResult.Result = DEBUGGER_ERROR_INVALID_PROCESS_ID;
     }
-
-    //
-    // User-mode buffer is same as SearchMemRequest
-    //
-    UsermodeBuffer = (UINT64 *)SearchMemRequest;
-
-    //
-    // We store the user-mode data in a separate variable because
-    // we will use them later when we Zeroed the SearchMemRequest
-    //
-    AddressFrom = SearchMemRequest->Address;
-    AddressTo   = SearchMemRequest->Address + SearchMemRequest->Length;
-
-    //
-    // We support up to MaximumSearchResults search results
-    //
-    SearchResultsStorage = PlatformMemAllocateZeroedNonPagedPool(MaximumSearchResults * sizeof(UINT64));
-
-    if (SearchResultsStorage == NULL)
+    else if (SearchAddressWrapper(SearchMemRequest,
+                                  SearchMemRequest->Address,
+                                  SearchMemRequest->Address + SearchMemRequest->Length,
+                                  FALSE,
+                                  &SearchResult.CountOfResults))
     {
         //
-        // Not enough memory
+        // The search was successful
         //
-        return STATUS_INSUFFICIENT_RESOURCES;
+        SearchResult.Result = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
     }
-
-    //
-    // Call the wrapper
-    //
-    SearchAddressWrapper(SearchResultsStorage, SearchMemRequest, AddressFrom, AddressTo, FALSE, &CountOfResults);
-
-    //
-    // In this point, we to store the results (if any) to the user-mode
-    // buffer SearchMemRequest itself is the user-mode buffer and we also
-    // checked from the previous function that the output buffer is at
-    // least SearchMemRequest bigger or equal to MaximumSearchResults * sizeof(UINT64)
-    // so we need to clear everything here, and also we should keep in mind that
-    // SearchMemRequest is no longer valid
-    //
-    RtlZeroMemory(SearchMemRequest, MaximumSearchResults * sizeof(UINT64));
-
-    //
-    // It's time to move the results from our temporary buffer to the user-mode
-    // buffer, also there is something that we should check and that's the fact
-    // that we used aligned page addresses so the results should be checked to
-    // see whether the results are between the user's entered addresses or not
-    //
-    for (size_t i = 0; i < MaximumSearchResults; i++)
+    else
     {
-        CurrentValue = SearchResultsStorage[i];
-
-        if (CurrentValue == (UINT64)NULL)
-        {
-            //
-            // Nothing left to move
-            //
-            break;
-        }
-
-        if (CurrentValue >= AddressFrom && CurrentValue <= AddressTo)
-        {
-            //
-            // Move the variable
-            //
-            UsermodeBuffer[ResultsIndex] = CurrentValue;
-            ResultsIndex++;
-        }
+        //
+        // There was an error, probably the address was not valid
+        //
+        SearchResult.Result = DEBUGGER_ERROR_INVALID_ADDRESS;
     }
 
     //
-    // Free the results pool
+    // SearchMemRequest itself is the user-mode buffer, so the result
+    // is moved to the start of the buffer
     //
-    PlatformMemFreePool(SearchResultsStorage);
+    RtlCopyMemory(SearchMemRequest, &SearchResult, sizeof(DEBUGGEE_RESULT_OF_SEARCH_PACKET));
 
     return STATUS_SUCCESS;
 }
@@ -1416,6 +1011,36 @@ DebuggerCommandReservePreallocatedPools(PDEBUGGER_PREALLOC_COMMAND PreallocReque
 
         break;
 
+    case DEBUGGER_PREALLOC_COMMAND_TYPE_SNAPSHOT:
+
+        //
+        // Allocate the copies of the pages for the '!snapshot' command (and
+        // request the tables for splitting the large pages of the range)
+        //
+        if (PreallocRequest->Count == 0 ||
+            PreallocRequest->Count > DEBUGGER_SNAPSHOT_MAXIMUM_PAGES ||
+            !ConfigureSnapshotAllocateBuffers(PreallocRequest->Count))
+        {
+            PreallocRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_PAGES_ARE_NOT_PREALLOCATED;
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        break;
+
+    case DEBUGGER_PREALLOC_COMMAND_TYPE_DIRTY_LOGGING:
+
+        //
+        // Allocate the dirty bitmap and the PML buffers for logging the dirty
+        // pages (they're allocated once, so the count is not used)
+        //
+        if (!ConfigureDirtyLoggingInitializeOnAllProcessors())
+        {
+            PreallocRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_BUFFERS_ARE_NOT_PREALLOCATED;
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        break;
+
     default:
 
         PreallocRequest->KernelStatus = DEBUGGER_ERROR_COULD_NOT_FIND_ALLOCATION_TYPE;
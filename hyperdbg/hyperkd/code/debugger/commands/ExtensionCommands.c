@@ -695,3 +695,373 @@ ExtensionCommandPcitree(PDEBUGGEE_PCITREE_REQUEST_RESPONSE_PACKET PcitreePacket,
         NOP_FUNCTION();
     }
 }
+
+/**
+ * @brief Perform actions regarding the VM-exit profiler
+ *
+ * @param ProfilerRequest
+ *
+ * @return UINT32 Size to send to the debuggee
+ */
+UINT32
+ExtensionCommandPerformActionsForVmexitProfilerRequests(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest)
+{
+    PVMEXIT_PROFILER_RESULTS BufferToStoreResults = (VMEXIT_PROFILER_RESULTS *)(((CHAR *)ProfilerRequest) + sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST));
+
+    switch (ProfilerRequest->RequestType)
+    {
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_ENABLE:
+
+        VmFuncVmexitProfilerEnable(TRUE);
+        g_VmexitProfilerEventsEnabled = TRUE;
+
+        break;
+
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_DISABLE:
+
+        g_VmexitProfilerEventsEnabled = FALSE;
+        VmFuncVmexitProfilerEnable(FALSE);
+
+        break;
+
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_RESET:
+
+        VmFuncVmexitProfilerReset();
+        EventCostsResetHistograms();
+
+        break;
+
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY:
+
+        if (!VmFuncVmexitProfilerQuery(ProfilerRequest->CoreId, BufferToStoreResults))
+        {
+            //
+            // Either the profiler is not initialized or the core is invalid
+            //
+            ProfilerRequest->KernelStatus = DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR;
+
+            return sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST);
+        }
+
+        //
+        // The handling time of the events is kept with the costs of the events
+        //
+        EventCostsQueryHistograms(ProfilerRequest->CoreId, BufferToStoreResults);
+
+        ProfilerRequest->IsEnabled    = g_VmexitProfilerEventsEnabled;
+        ProfilerRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+        return sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST) + sizeof(VMEXIT_PROFILER_RESULTS);
+
+    default:
+
+        //
+        // Invalid request
+        //
+        ProfilerRequest->KernelStatus = DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR;
+
+        return sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST);
+    }
+
+    //
+    // The status was okay
+    //
+    ProfilerRequest->IsEnabled    = g_VmexitProfilerEventsEnabled;
+    ProfilerRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+    return sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST);
+}
+
+/**
+ * @brief Perform actions regarding logging the dirty pages
+ * @details In the Debugger Mode, the cores are halted so the tasks are
+ * broadcasted to the halted cores and the buffers should be preallocated
+ * (by the 'prealloc' command), otherwise DPCs are used
+ *
+ * @param DirtyPagesRequest
+ * @param OperateOnVmxRoot
+ *
+ * @return UINT32 Size to send to the debuggee
+ */
+UINT32
+ExtensionCommandPerformActionsForDirtyPagesRequests(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, BOOLEAN OperateOnVmxRoot)
+{
+    PDEBUGGER_DIRTY_PAGES_ENTRY Entries = (DEBUGGER_DIRTY_PAGES_ENTRY *)(((CHAR *)DirtyPagesRequest) + sizeof(DEBUGGER_DIRTY_PAGES_REQUEST));
+
+    DirtyPagesRequest->CountOfEntries = 0;
+
+    switch (DirtyPagesRequest->RequestType)
+    {
+    case DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_START:
+
+        //
+        // The buffers are allocated once the logging is started for the first
+        // time (we're in PASSIVE_LEVEL), the bitmap is not allocated if the
+        // processor doesn't support PML
+        //
+        if (!OperateOnVmxRoot && !ConfigureDirtyLoggingInitializeOnAllProcessors())
+        {
+            DirtyPagesRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_SUPPORTED;
+            return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+        }
+
+        if (!VmFuncDirtyLoggingResetDirtyPages())
+        {
+            DirtyPagesRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_BUFFERS_ARE_NOT_PREALLOCATED;
+            return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+        }
+
+        if (OperateOnVmxRoot)
+        {
+            HaltedBroadcastEnableDirtyLoggingAllCores();
+        }
+        else
+        {
+            ConfigureDirtyLoggingEnableOnAllProcessors();
+        }
+
+        g_DirtyPagesLoggingStarted = TRUE;
+
+        break;
+
+    case DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_STOP:
+
+        if (!g_DirtyPagesLoggingStarted)
+        {
+            DirtyPagesRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_STARTED;
+            return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+        }
+
+        if (OperateOnVmxRoot)
+        {
+            HaltedBroadcastDisableDirtyLoggingAllCores();
+        }
+        else
+        {
+            ConfigureDirtyLoggingDisableOnAllProcessors();
+        }
+
+        g_DirtyPagesLoggingStarted = FALSE;
+
+        break;
+
+    case DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_COLLECT:
+
+        if (!g_DirtyPagesLoggingStarted)
+        {
+            DirtyPagesRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_STARTED;
+            return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+        }
+
+        //
+        // Save the pages that are logged in the PML buffers (but the buffers
+        // are not full yet) into the dirty bitmap
+        //
+        if (DirtyPagesRequest->FlushBuffers)
+        {
+            if (OperateOnVmxRoot)
+            {
+                HaltedBroadcastFlushDirtyLoggingBufferAllCores();
+            }
+            else
+            {
+                ConfigureDirtyLoggingFlushOnAllProcessors();
+            }
+        }
+
+        DirtyPagesRequest->CountOfEntries = VmFuncDirtyLoggingCollectDirtyPages(DirtyPagesRequest->FirstPageFrameNumber,
+                                                                                DirtyPagesRequest->EndPageFrameNumber,
+                                                                                Entries,
+                                                                                DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES,
+                                                                                &DirtyPagesRequest->NextPageFrameNumber);
+
+        DirtyPagesRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+        return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST) + (DirtyPagesRequest->CountOfEntries * sizeof(DEBUGGER_DIRTY_PAGES_ENTRY));
+
+    default:
+
+        //
+        // Invalid request
+        //
+        DirtyPagesRequest->KernelStatus = DEBUGGER_ERROR_DIRTY_PAGES_ACTIONS_ERROR;
+
+        return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+    }
+
+    //
+    // The status was okay
+    //
+    DirtyPagesRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+    return sizeof(DEBUGGER_DIRTY_PAGES_REQUEST);
+}
+
+/**
+ * @brief Perform actions regarding the memory snapshot
+ * @details In the Debugger Mode, the cores are halted so the tasks are
+ * broadcasted to the halted cores and the pages should be preallocated
+ * (by the 'prealloc' command), otherwise DPCs are used
+ *
+ * @param SnapshotRequest
+ * @param OperateOnVmxRoot
+ *
+ * @return UINT32 Size to send to the debuggee
+ */
+UINT32
+ExtensionCommandPerformActionsForSnapshotRequests(PDEBUGGER_SNAPSHOT_REQUEST SnapshotRequest, BOOLEAN OperateOnVmxRoot)
+{
+    switch (SnapshotRequest->RequestType)
+    {
+    case DEBUGGER_SNAPSHOT_REQUEST_TYPE_TAKE:
+
+        if (VmFuncSnapshotQuery(&SnapshotRequest->Statistics))
+        {
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_IS_ALREADY_TAKEN;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        //
+        // The range should be page aligned and mapped by the EPT identity table
+        //
+        if (SnapshotRequest->StartAddress >= SnapshotRequest->EndAddress ||
+            (SnapshotRequest->StartAddress & (PAGE_SIZE - 1)) != 0 ||
+            (SnapshotRequest->EndAddress & (PAGE_SIZE - 1)) != 0 ||
+            SnapshotRequest->EndAddress > DEBUGGER_SNAPSHOT_MAXIMUM_PHYSICAL_ADDRESS)
+        {
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_INVALID_RANGE;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        //
+        // In VMI mode, we're at PASSIVE_LEVEL, so the pages could be allocated here
+        //
+        if (!OperateOnVmxRoot)
+        {
+            if (SnapshotRequest->MaximumPages != 0 || SnapshotRequest->Statistics.MaximumPages == 0)
+            {
+                if (SnapshotRequest->MaximumPages > DEBUGGER_SNAPSHOT_MAXIMUM_PAGES ||
+                    !ConfigureSnapshotAllocateBuffers(SnapshotRequest->MaximumPages != 0 ? SnapshotRequest->MaximumPages : DEBUGGER_SNAPSHOT_DEFAULT_MAXIMUM_PAGES))
+                {
+                    SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_PAGES_ARE_NOT_PREALLOCATED;
+                    return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+                }
+            }
+
+            ConfigureSnapshotReserveSplitBuffers(SnapshotRequest->StartAddress, SnapshotRequest->EndAddress);
+        }
+
+        if (!VmFuncSnapshotTake(SnapshotRequest->StartAddress, SnapshotRequest->EndAddress))
+        {
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_PAGES_ARE_NOT_PREALLOCATED;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        if (OperateOnVmxRoot)
+        {
+            HaltedBroadcastSnapshotProtectPagesAllCores();
+        }
+        else
+        {
+            ConfigureSnapshotProtectPagesOnAllProcessors();
+        }
+
+        //
+        // The large pages are split by the preallocated tables, if there are
+        // not enough tables, the snapshot is discarded
+        //
+        if (!VmFuncSnapshotIsProtected())
+        {
+            if (OperateOnVmxRoot)
+            {
+                HaltedBroadcastSnapshotUnprotectPagesAllCores();
+            }
+            else
+            {
+                ConfigureSnapshotUnprotectPagesOnAllProcessors();
+            }
+
+            VmFuncSnapshotDiscard();
+
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_PRE_ALLOCATED_BUFFER_IS_EMPTY;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        break;
+
+    case DEBUGGER_SNAPSHOT_REQUEST_TYPE_RESTORE:
+
+        if (!VmFuncSnapshotQuery(&SnapshotRequest->Statistics))
+        {
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_IS_NOT_TAKEN;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        VmFuncSnapshotPrepareRestore();
+
+        if (OperateOnVmxRoot)
+        {
+            HaltedBroadcastSnapshotRestorePagesAllCores();
+        }
+        else
+        {
+            ConfigureSnapshotRestorePagesOnAllProcessors();
+        }
+
+        if (!VmFuncSnapshotFinishRestore())
+        {
+            VmFuncSnapshotQuery(&SnapshotRequest->Statistics);
+
+            SnapshotRequest->IsTaken      = TRUE;
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_POOL_EXHAUSTED;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        break;
+
+    case DEBUGGER_SNAPSHOT_REQUEST_TYPE_DISCARD:
+
+        if (!VmFuncSnapshotQuery(&SnapshotRequest->Statistics))
+        {
+            SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_IS_NOT_TAKEN;
+            return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+        }
+
+        if (OperateOnVmxRoot)
+        {
+            HaltedBroadcastSnapshotUnprotectPagesAllCores();
+        }
+        else
+        {
+            ConfigureSnapshotUnprotectPagesOnAllProcessors();
+        }
+
+        VmFuncSnapshotDiscard();
+
+        break;
+
+    case DEBUGGER_SNAPSHOT_REQUEST_TYPE_QUERY:
+
+        //
+        // The statistics are filled below
+        //
+        break;
+
+    default:
+
+        //
+        // Invalid request
+        //
+        SnapshotRequest->KernelStatus = DEBUGGER_ERROR_SNAPSHOT_ACTIONS_ERROR;
+
+        return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+    }
+
+    //
+    // The status was okay
+    //
+    SnapshotRequest->IsTaken      = VmFuncSnapshotQuery(&SnapshotRequest->Statistics);
+    SnapshotRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+    return sizeof(DEBUGGER_SNAPSHOT_REQUEST);
+}
@@ -0,0 +1,530 @@
+/**
+ * @file MemorySearch.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Page-based memory search engine (s* commands)
+ * @details Each page of the range is checked against the page-tables and
+ * read (or mapped) only once, then eight candidates are filtered at once by
+ * comparing the first and the last non-wildcard bytes of the pattern in a
+ * 64-bit word and only the remaining candidates are fully compared
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Get a byte of the pattern (values or masks) from the chunks
+ *
+ */
+#define MEMORY_SEARCH_PATTERN_BYTE(Buffer, Pattern, Index) \
+    ((Buffer)[(((UINT64)(Index) >> (Pattern)->ChunkShift) << 3) + ((Index) & ((Pattern)->ChunkSize - 1))])
+
+/**
+ * @brief Initialize the memory search engine
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+MemorySearchInitialize()
+{
+    //
+    // The buffer holds the current page and the next page, it's used when the
+    // debuggee is paused and pages are read through the memory mapper
+    //
+    g_MemorySearchBuffer = (UCHAR *)PlatformMemAllocateNonPagedPool(2 * PAGE_SIZE);
+
+    if (g_MemorySearchBuffer == NULL)
+    {
+        LogInfo("err, insufficient memory for allocating the memory search buffer\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Uninitialize the memory search engine
+ *
+ * @return VOID
+ */
+VOID
+MemorySearchUninitialize()
+{
+    if (g_MemorySearchBuffer != NULL)
+    {
+        PlatformMemFreePool(g_MemorySearchBuffer);
+        g_MemorySearchBuffer = NULL;
+    }
+}
+
+/**
+ * @brief Compile the pattern of the search request
+ *
+ * @param SearchMemRequest request structure of searching memory
+ * @param Pattern The compiled pattern
+ *
+ * @return BOOLEAN Whether the pattern was valid or not
+ */
+BOOLEAN
+MemorySearchCompilePattern(PDEBUGGER_SEARCH_MEMORY SearchMemRequest, PMEMORY_SEARCH_PATTERN Pattern)
+{
+    UCHAR AnchorByte;
+
+    //
+    // set chunk size of the pattern
+    //
+    switch (SearchMemRequest->ByteSize)
+    {
+    case SEARCH_BYTE:
+        Pattern->ChunkShift = 0;
+        break;
+
+    case SEARCH_WORD:
+        Pattern->ChunkShift = 1;
+        break;
+
+    case SEARCH_DWORD:
+        Pattern->ChunkShift = 2;
+        break;
+
+    case SEARCH_QWORD:
+        Pattern->ChunkShift = 3;
+        break;
+
+    default:
+
+        //
+        // Invalid parameter
+        //
+        return FALSE;
+    }
+
+    if (SearchMemRequest->CountOf64Chunks == 0)
+    {
+        return FALSE;
+    }
+
+    Pattern->ChunkSize = 1 << Pattern->ChunkShift;
+    Pattern->Length    = SearchMemRequest->CountOf64Chunks << Pattern->ChunkShift;
+    Pattern->Values    = (PUCHAR)SearchMemRequest + SIZEOF_DEBUGGER_SEARCH_MEMORY;
+    Pattern->Masks     = Pattern->Values + (SearchMemRequest->CountOf64Chunks * sizeof(UINT64));
+
+    //
+    // Find the first and the last bytes without wildcard, they're
+    // used for filtering the candidates
+    //
+    Pattern->FirstAnchor = MEMORY_SEARCH_NO_ANCHOR;
+    Pattern->LastAnchor  = MEMORY_SEARCH_NO_ANCHOR;
+
+    for (UINT32 i = 0; i < Pattern->Length; i++)
+    {
+        if (MEMORY_SEARCH_PATTERN_BYTE(Pattern->Masks, Pattern, i) == 0xff)
+        {
+            if (Pattern->FirstAnchor == MEMORY_SEARCH_NO_ANCHOR)
+            {
+                Pattern->FirstAnchor = i;
+            }
+
+            Pattern->LastAnchor = i;
+        }
+    }
+
+    if (Pattern->FirstAnchor != MEMORY_SEARCH_NO_ANCHOR)
+    {
+        AnchorByte                = MEMORY_SEARCH_PATTERN_BYTE(Pattern->Values, Pattern, Pattern->FirstAnchor);
+        Pattern->FirstAnchorBytes = AnchorByte * MEMORY_SEARCH_LOW_BITS;
+
+        AnchorByte               = MEMORY_SEARCH_PATTERN_BYTE(Pattern->Values, Pattern, Pattern->LastAnchor);
+        Pattern->LastAnchorBytes = AnchorByte * MEMORY_SEARCH_LOW_BITS;
+    }
+
+    //
+    // Candidates are aligned to the chunk size (from the start address), so
+    // only bytes 0, ChunkSize, 2 * ChunkSize, ... of each word are candidates
+    //
+    Pattern->CandidateBytesMask = 0;
+
+    for (UINT32 i = 0; i < sizeof(UINT64); i += Pattern->ChunkSize)
+    {
+        Pattern->CandidateBytesMask |= 0x80ull << (i * 8);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Check whether the page is present or not by using the page-tables
+ *
+ * @param Context The search context
+ * @param PageAddress The address of the page
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+MemorySearchIsPagePresent(PMEMORY_SEARCH_CONTEXT Context, UINT64 PageAddress)
+{
+    if (Context->IsDebuggeePaused)
+    {
+        return CheckAccessValidityAndSafety(PageAddress, PAGE_SIZE);
+    }
+    else
+    {
+        return VirtualAddressToPhysicalAddress((PVOID)PageAddress) != NULL64_ZERO;
+    }
+}
+
+/**
+ * @brief Compare the pattern with the memory directly (without the window)
+ * @details It's used for the patterns that straddle the window
+ *
+ * @param Context The search context
+ * @param Address The address to compare
+ *
+ * @return BOOLEAN Whether the pattern matches or not
+ */
+BOOLEAN
+MemorySearchCompareSlow(PMEMORY_SEARCH_CONTEXT Context, UINT64 Address)
+{
+    UCHAR                  Buffer[64];
+    UINT64                 CurrentAddress;
+    UINT32                 ReadSize;
+    PMEMORY_SEARCH_PATTERN Pattern = &Context->Pattern;
+
+    for (UINT32 Offset = 0; Offset < Pattern->Length; Offset += ReadSize)
+    {
+        CurrentAddress = Address + Offset;
+
+        //
+        // Each read is limited to a single page, so the presence of each page is checked
+        //
+        ReadSize = Pattern->Length - Offset;
+
+        if (ReadSize > sizeof(Buffer))
+        {
+            ReadSize = sizeof(Buffer);
+        }
+
+        if (ReadSize > PAGE_SIZE - (CurrentAddress & (PAGE_SIZE - 1)))
+        {
+            ReadSize = (UINT32)(PAGE_SIZE - (CurrentAddress & (PAGE_SIZE - 1)));
+        }
+
+        if (!MemorySearchIsPagePresent(Context, (UINT64)PAGE_ALIGN(CurrentAddress)))
+        {
+            return FALSE;
+        }
+
+        if (Context->IsDebuggeePaused)
+        {
+            MemoryMapperReadMemorySafe(CurrentAddress, Buffer, ReadSize);
+        }
+        else
+        {
+            RtlCopyMemory(Buffer, (PVOID)CurrentAddress, ReadSize);
+        }
+
+        for (UINT32 i = 0; i < ReadSize; i++)
+        {
+            if (((Buffer[i] ^ MEMORY_SEARCH_PATTERN_BYTE(Pattern->Values, Pattern, Offset + i)) &
+                 MEMORY_SEARCH_PATTERN_BYTE(Pattern->Masks, Pattern, Offset + i)) != 0)
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Fully compare a candidate and report it if it matches
+ *
+ * @param Context The search context
+ * @param Window The buffer that contains the page (and the next page if it's present)
+ * @param WindowAddress The address of the first byte of the window
+ * @param WindowSize Size of the window
+ * @param Offset Offset of the candidate in the window
+ *
+ * @return VOID
+ */
+VOID
+MemorySearchCheckCandidate(PMEMORY_SEARCH_CONTEXT Context, PUCHAR Window, UINT64 WindowAddress, UINT64 WindowSize, UINT64 Offset)
+{
+    PMEMORY_SEARCH_PATTERN Pattern = &Context->Pattern;
+    UINT64                 Address = WindowAddress + Offset;
+
+    if (Address < Context->StartAddress || Address >= Context->EndAddress ||
+        Context->CountOfResults >= MaximumSearchResults)
+    {
+        return;
+    }
+
+    if (Offset + Pattern->Length <= WindowSize)
+    {
+        for (UINT32 i = 0; i < Pattern->Length; i++)
+        {
+            if (((Window[Offset + i] ^ MEMORY_SEARCH_PATTERN_BYTE(Pattern->Values, Pattern, i)) &
+                 MEMORY_SEARCH_PATTERN_BYTE(Pattern->Masks, Pattern, i)) != 0)
+            {
+                return;
+            }
+        }
+    }
+    else if (!MemorySearchCompareSlow(Context, Address))
+    {
+        //
+        // The pattern straddles the window and doesn't match
+        //
+        return;
+    }
+
+    //
+    // We found a matching address, the result is sent immediately
+    //
+    Context->CountOfResults++;
+
+    if (Context->MemoryType == SEARCH_PHYSICAL_FROM_VIRTUAL_MEMORY)
+    {
+        //
+        // It's a physical memory
+        //
+        Log("%llx\n", VirtualAddressToPhysicalAddress((PVOID)Address));
+    }
+    else
+    {
+        //
+        // It's a virtual memory
+        //
+        Log("%llx\n", Address);
+    }
+}
+
+/**
+ * @brief Search the candidates of a page
+ *
+ * @param Context The search context
+ * @param Window The buffer that contains the page (and the next page if it's present)
+ * @param PageAddress The address of the page
+ * @param WindowSize Size of the window
+ *
+ * @return VOID
+ */
+VOID
+MemorySearchScanPage(PMEMORY_SEARCH_CONTEXT Context, PUCHAR Window, UINT64 PageAddress, UINT64 WindowSize)
+{
+    PMEMORY_SEARCH_PATTERN Pattern = &Context->Pattern;
+    UINT64                 Offset  = 0;
+    UINT64                 End     = PAGE_SIZE;
+    UINT64                 Word;
+    UINT64                 Matches;
+    ULONG                  Index;
+
+    if (Context->StartAddress > PageAddress)
+    {
+        Offset = Context->StartAddress - PageAddress;
+    }
+
+    if (Context->EndAddress < PageAddress + PAGE_SIZE)
+    {
+        End = Context->EndAddress - PageAddress;
+    }
+
+    //
+    // Move to the first candidate which is aligned to the chunk size
+    //
+    Offset += (Context->StartAddress - (PageAddress + Offset)) & (Pattern->ChunkSize - 1);
+
+    if (Pattern->FirstAnchor != MEMORY_SEARCH_NO_ANCHOR)
+    {
+        //
+        // Filter eight candidates at once, the anchor bytes of candidates are compared
+        // in a 64-bit word and bytes that are zero after xor are the matching bytes
+        //
+        for (; Offset + sizeof(UINT64) <= End && Offset + Pattern->LastAnchor + sizeof(UINT64) <= WindowSize; Offset += sizeof(UINT64))
+        {
+            Word    = *(UINT64 UNALIGNED *)(Window + Offset + Pattern->FirstAnchor) ^ Pattern->FirstAnchorBytes;
+            Matches = (Word - MEMORY_SEARCH_LOW_BITS) & ~Word & Pattern->CandidateBytesMask;
+
+            if (Matches == 0)
+            {
+                continue;
+            }
+
+            Word = *(UINT64 UNALIGNED *)(Window + Offset + Pattern->LastAnchor) ^ Pattern->LastAnchorBytes;
+            Matches &= (Word - MEMORY_SEARCH_LOW_BITS) & ~Word & MEMORY_SEARCH_HIGH_BITS;
+
+            while (Matches != 0)
+            {
+                _BitScanForward64(&Index, Matches);
+
+                MemorySearchCheckCandidate(Context, Window, PageAddress, WindowSize, Offset + (Index >> 3));
+
+                Matches &= Matches - 1;
+            }
+
+            if (Context->CountOfResults >= MaximumSearchResults)
+            {
+                return;
+            }
+        }
+    }
+
+    //
+    // Check the remaining candidates one by one
+    //
+    for (; Offset < End; Offset += Pattern->ChunkSize)
+    {
+        if (Pattern->FirstAnchor != MEMORY_SEARCH_NO_ANCHOR &&
+            Offset + Pattern->LastAnchor < WindowSize &&
+            (Window[Offset + Pattern->FirstAnchor] != (UCHAR)Pattern->FirstAnchorBytes ||
+             Window[Offset + Pattern->LastAnchor] != (UCHAR)Pattern->LastAnchorBytes))
+        {
+            continue;
+        }
+
+        MemorySearchCheckCandidate(Context, Window, PageAddress, WindowSize, Offset);
+
+        if (Context->CountOfResults >= MaximumSearchResults)
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Search on virtual memory
+ *
+ * @details This function can be called from vmx-root mode, the memory
+ * layout should be already switched to the target process. Non-present
+ * pages are skipped and each result is sent once it's found, the search
+ * is stopped after MaximumSearchResults results
+ *
+ * @param SearchMemRequest request structure of searching memory
+ * @param StartAddress start address based on target process
+ * @param EndAddress end address based on target process
+ * @param IsDebuggeePaused Set to true when the search is performed in
+ * the debugger mode
+ * @param CountOfMatchedCases Number of matched cases
+ *
+ * @return BOOLEAN Whether the search was successful or not
+ */
+BOOLEAN
+MemorySearchPerform(PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
+                    UINT64                  StartAddress,
+                    UINT64                  EndAddress,
+                    BOOLEAN                 IsDebuggeePaused,
+                    PUINT32                 CountOfMatchedCases)
+{
+    MEMORY_SEARCH_CONTEXT Context = {0};
+    PUCHAR                Window;
+    UINT64                WindowSize;
+    BOOLEAN               IsPagePresent;
+    BOOLEAN               IsNextPagePresent = FALSE;
+    BOOLEAN               IsNextPageChecked = FALSE;
+    BOOLEAN               IsNextPageRead    = FALSE;
+
+    *CountOfMatchedCases = 0;
+
+    if (!MemorySearchCompilePattern(SearchMemRequest, &Context.Pattern))
+    {
+        return FALSE;
+    }
+
+    if (IsDebuggeePaused && g_MemorySearchBuffer == NULL)
+    {
+        return FALSE;
+    }
+
+    Context.MemoryType       = SearchMemRequest->MemoryType;
+    Context.IsDebuggeePaused = IsDebuggeePaused;
+    Context.StartAddress     = StartAddress;
+    Context.EndAddress       = EndAddress;
+
+    for (UINT64 PageAddress = (UINT64)PAGE_ALIGN(StartAddress); PageAddress < EndAddress; PageAddress += PAGE_SIZE)
+    {
+        //
+        // The presence of this page might be checked while reading the previous page
+        //
+        IsPagePresent     = IsNextPageChecked ? IsNextPagePresent : MemorySearchIsPagePresent(&Context, PageAddress);
+        IsNextPageChecked = FALSE;
+
+        if (!IsPagePresent)
+        {
+            IsNextPageRead = FALSE;
+            continue;
+        }
+
+        Context.CountOfPresentPages++;
+
+        //
+        // The next page is also needed for the patterns that straddle the page,
+        // if it's not going to be searched, these patterns are compared directly
+        //
+        if (PageAddress + PAGE_SIZE < EndAddress && Context.Pattern.Length > 1)
+        {
+            IsNextPagePresent = MemorySearchIsPagePresent(&Context, PageAddress + PAGE_SIZE);
+            IsNextPageChecked = TRUE;
+        }
+        else
+        {
+            IsNextPagePresent = FALSE;
+        }
+
+        if (IsDebuggeePaused)
+        {
+            //
+            // Each page is read only once, if the page is read as the next
+            // page of the previous page, it's just moved to the start of the window
+            //
+            Window = g_MemorySearchBuffer;
+
+            if (IsNextPageRead)
+            {
+                RtlCopyMemory(Window, Window + PAGE_SIZE, PAGE_SIZE);
+            }
+            else
+            {
+                MemoryMapperReadMemorySafe(PageAddress, Window, PAGE_SIZE);
+            }
+
+            WindowSize     = PAGE_SIZE;
+            IsNextPageRead = FALSE;
+
+            if (IsNextPagePresent)
+            {
+                MemoryMapperReadMemorySafe(PageAddress + PAGE_SIZE, Window + PAGE_SIZE, PAGE_SIZE);
+
+                WindowSize += PAGE_SIZE;
+                IsNextPageRead = TRUE;
+            }
+        }
+        else
+        {
+            //
+            // The memory is directly accessible
+            //
+            Window     = (PUCHAR)PageAddress;
+            WindowSize = IsNextPagePresent ? 2 * PAGE_SIZE : PAGE_SIZE;
+        }
+
+        MemorySearchScanPage(&Context, Window, PageAddress, WindowSize);
+
+        if (Context.CountOfResults >= MaximumSearchResults)
+        {
+            //
+            // Too many results, the rest of the range is not searched
+            //
+            break;
+        }
+    }
+
+    *CountOfMatchedCases = Context.CountOfResults;
+
+    //
+    // The search fails if none of the pages were present
+    //
+    return Context.CountOfPresentPages != 0;
+}
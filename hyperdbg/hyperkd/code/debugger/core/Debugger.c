@@ -74,6 +74,30 @@ DebuggerInitialize()
         return FALSE;
     }
 
+    //
+    // Allocate buffer for accounting the costs of events
+    //
+    if (!EventCostsInitialize())
+    {
+        return FALSE;
+    }
+
+    //
+    // Allocate buffer for searching memory
+    //
+    if (!MemorySearchInitialize())
+    {
+        return FALSE;
+    }
+
+    //
+    // Allocate buffer for the records of batched steps
+    //
+    if (!StepTraceInitialize())
+    {
+        return FALSE;
+    }
+
     //
     // Set the core's IDs
     //
@@ -274,6 +298,21 @@ DebuggerUninitialize()
     //
     GlobalEventsFreeMemory();
 
+    //
+    // Free the costs of events
+    //
+    EventCostsUninitialize();
+
+    //
+    // Free the buffer of searching memory
+    //
+    MemorySearchUninitialize();
+
+    //
+    // Free the buffer of batched steps
+    //
+    StepTraceUninitialize();
+
     //
     // Free g_ScriptGlobalVariables
     //
@@ -1063,6 +1102,9 @@ DebuggerTriggerEvents(VMM_EVENT_TYPE_ENUM                   EventType,
     PEPT_HOOKS_CONTEXT               EptContext;
     PLIST_ENTRY                      TempList        = 0;
     PLIST_ENTRY                      TempList2       = 0;
+    UINT64                           EventStartTsc   = NULL_ZERO;
+    UINT64                           EventCycles     = NULL_ZERO;
+    BOOLEAN                          IsEventCostsAccounted;
     const PVOID                      OriginalContext = Context;
 
     //
@@ -1413,6 +1455,17 @@ DebuggerTriggerEvents(VMM_EVENT_TYPE_ENUM                   EventType,
             }
         }
 
+        //
+        // Take the timestamp for accounting the costs of the event (only if
+        // the costs are accounted or the VM-exit profiler collects the events)
+        //
+        IsEventCostsAccounted = g_EventCostsEnabled || g_VmexitProfilerEventsEnabled;
+
+        if (IsEventCostsAccounted)
+        {
+            EventStartTsc = __rdtsc();
+        }
+
         //
         // Check if condition is met or not , if the condition
         // is not met then we have to avoid performing the actions
@@ -1435,6 +1488,13 @@ DebuggerTriggerEvents(VMM_EVENT_TYPE_ENUM                   EventType,
                 // The condition function returns null, mean that the
                 // condition didn't met, we can ignore this event
                 //
+                if (IsEventCostsAccounted)
+                {
+                    EventCycles = __rdtsc() - EventStartTsc;
+
+                    EventCostsRecordTrigger(DbgState->CoreId, CurrentEvent->Tag, FALSE, EventCycles);
+                }
+
                 continue;
             }
         }
@@ -1455,6 +1515,17 @@ DebuggerTriggerEvents(VMM_EVENT_TYPE_ENUM                   EventType,
         // perform the actions
         //
         DebuggerPerformActions(DbgState, CurrentEvent, &EventTriggerDetail);
+
+        //
+        // Account the costs of the event (the handling time of the event
+        // is also reported to the VM-exit profiler)
+        //
+        if (IsEventCostsAccounted)
+        {
+            EventCycles = __rdtsc() - EventStartTsc;
+
+            EventCostsRecordTrigger(DbgState->CoreId, CurrentEvent->Tag, TRUE, EventCycles);
+        }
     }
 
     //
@@ -1665,6 +1736,14 @@ DebuggerPerformRunScript(PROCESSOR_DEBUGGING_STATE *        DbgState,
         EXECUTENUMBER++;
     }
 
+    //
+    // Account the executed instructions to the costs of the event
+    //
+    if (Action != NULL && g_EventCostsEnabled)
+    {
+        EventCostsRecordScriptInstructions(DbgState->CoreId, EventTriggerDetail->Tag, EXECUTENUMBER);
+    }
+
     return TRUE;
 }
 
@@ -2592,6 +2671,11 @@ DebuggerRemoveEvent(UINT64 Tag, BOOLEAN PoolManagerAllocatedMemory)
         return FALSE;
     }
 
+    //
+    // Release the costs of the event so the slots can be reused
+    //
+    EventCostsClear(Tag);
+
     //
     // Remove all of the actions and free its pools
     //
@@ -3693,6 +3777,30 @@ DebuggerParseEventsModification(PDEBUGGER_MODIFY_EVENTS DebuggerEventModificatio
             DebuggerEventModificationRequest->IsEnabled = FALSE;
         }
     }
+    else if (DebuggerEventModificationRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_QUERY_COSTS)
+    {
+        //
+        // check if tag is valid or not
+        //
+        if (!DebuggerIsTagValid(DebuggerEventModificationRequest->Tag))
+        {
+            DebuggerEventModificationRequest->KernelStatus = DEBUGGER_ERROR_TAG_NOT_EXISTS;
+            return FALSE;
+        }
+
+        //
+        // Merge the costs of the event from all cores
+        //
+        EventCostsQuery(DebuggerEventModificationRequest->Tag, &DebuggerEventModificationRequest->Costs);
+    }
+    else if (DebuggerEventModificationRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS)
+    {
+        g_EventCostsEnabled = TRUE;
+    }
+    else if (DebuggerEventModificationRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS)
+    {
+        g_EventCostsEnabled = FALSE;
+    }
     else
     {
         //
@@ -300,6 +300,60 @@ HaltedCorePerformTargetTask(PROCESSOR_DEBUGGING_STATE * DbgState,
 
         break;
     }
+    case DEBUGGER_HALTED_CORE_TASK_ENABLE_DIRTY_LOGGING:
+    {
+        //
+        // Enable the dirty logging mechanism (PML)
+        //
+        DirectVmcallEnableDirtyLogging(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
+    case DEBUGGER_HALTED_CORE_TASK_DISABLE_DIRTY_LOGGING:
+    {
+        //
+        // Disable the dirty logging mechanism (PML)
+        //
+        DirectVmcallDisableDirtyLogging(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
+    case DEBUGGER_HALTED_CORE_TASK_FLUSH_DIRTY_LOGGING_BUFFER:
+    {
+        //
+        // Flush the PML buffer into the dirty bitmap
+        //
+        DirectVmcallFlushDirtyLoggingBuffer(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
+    case DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_PROTECT_PAGES:
+    {
+        //
+        // Write-protect the pages of the snapshot
+        //
+        DirectVmcallSnapshotProtectPages(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
+    case DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_UNPROTECT_PAGES:
+    {
+        //
+        // Remove the write protection of the pages of the snapshot
+        //
+        DirectVmcallSnapshotUnprotectPages(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
+    case DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_RESTORE_PAGES:
+    {
+        //
+        // Restore the modified pages of the snapshot
+        //
+        DirectVmcallSnapshotRestorePages(DbgState->CoreId, (DIRECT_VMCALL_PARAMETERS *)Context);
+
+        break;
+    }
     default:
         LogWarning("Warning, unknown broadcast on halted core received");
         break;
@@ -0,0 +1,401 @@
+/**
+ * @file EventCosts.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Implementation of accounting the costs of triggered events
+ * @details Costs are recorded per-core into the slot of the event's tag
+ * and the slots of all cores are merged once the costs are queried. The
+ * slots also keep the histograms of the handling time of the events for
+ * the VM-exit profiler
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize the event costs accounting
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+EventCostsInitialize()
+{
+    //
+    // EVENT_COSTS_CORE_DATA is aligned to the cache line, allocations that are equal or
+    // bigger than a page are page-aligned, so the size is rounded up to pages
+    //
+    g_EventCosts = (EVENT_COSTS_CORE_DATA *)PlatformMemAllocateZeroedNonPagedPool(
+        ROUND_TO_PAGES(sizeof(EVENT_COSTS_CORE_DATA) * KeQueryActiveProcessorCount(0)));
+
+    if (g_EventCosts == NULL)
+    {
+        LogInfo("err, insufficient memory for allocating event costs\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Uninitialize the event costs accounting
+ *
+ * @return VOID
+ */
+VOID
+EventCostsUninitialize()
+{
+    if (g_EventCosts != NULL)
+    {
+        PlatformMemFreePool(g_EventCosts);
+        g_EventCosts = NULL;
+    }
+}
+
+/**
+ * @brief Get (or claim) the costs slot of an event on the target core
+ * @details should be called on the target core
+ *
+ * @param CoreId
+ * @param Tag
+ *
+ * @return EVENT_COSTS_SLOT* NULL if the slot is owned by another event
+ */
+EVENT_COSTS_SLOT *
+EventCostsGetSlot(UINT32 CoreId, UINT64 Tag)
+{
+    EVENT_COSTS_SLOT * Slot;
+
+    if (g_EventCosts == NULL)
+    {
+        return NULL;
+    }
+
+    Slot = &g_EventCosts[CoreId].Slots[(Tag - DebuggerEventTagStartSeed) % EVENT_COSTS_MAXIMUM_EVENTS];
+
+    if (Slot->Tag == Tag)
+    {
+        return Slot;
+    }
+
+    if (Slot->Tag != NULL_ZERO)
+    {
+        //
+        // More than EVENT_COSTS_MAXIMUM_EVENTS events are alive, the
+        // slot belongs to another event, so the costs are not tracked
+        // but the trigger is reported as untracked
+        //
+        g_EventCosts[CoreId].UntrackedTriggers++;
+
+        return NULL;
+    }
+
+    //
+    // Claim the free slot, the costs might be remained from a cleared
+    // event that was triggered while it was clearing, so zero them first
+    //
+    RtlZeroMemory(&Slot->Costs, sizeof(DEBUGGER_EVENT_COSTS));
+    RtlZeroMemory(&Slot->Histogram, sizeof(VMEXIT_PROFILER_HISTOGRAM));
+    Slot->Tag = Tag;
+
+    return Slot;
+}
+
+/**
+ * @brief Record the costs of a triggered event
+ *
+ * @param CoreId
+ * @param Tag
+ * @param ConditionMet Whether the condition of the event is met or not
+ * @param Cycles Cycles spent on checking the condition and performing the actions
+ *
+ * @return VOID
+ */
+VOID
+EventCostsRecordTrigger(UINT32 CoreId, UINT64 Tag, BOOLEAN ConditionMet, UINT64 Cycles)
+{
+    EVENT_COSTS_SLOT * Slot = EventCostsGetSlot(CoreId, Tag);
+
+    if (Slot == NULL)
+    {
+        return;
+    }
+
+    if (g_EventCostsEnabled)
+    {
+        Slot->Costs.TriggerCount++;
+        Slot->Costs.Cycles += Cycles;
+
+        if (!ConditionMet)
+        {
+            Slot->Costs.ConditionFalseCount++;
+        }
+    }
+
+    //
+    // Report the handling time of the event to the VM-exit profiler
+    //
+    if (g_VmexitProfilerEventsEnabled)
+    {
+        VmFuncVmexitProfilerAddSample(&Slot->Histogram, Cycles);
+    }
+}
+
+/**
+ * @brief Record the number of executed script instructions of an event
+ *
+ * @param CoreId
+ * @param Tag
+ * @param InstructionCount
+ *
+ * @return VOID
+ */
+VOID
+EventCostsRecordScriptInstructions(UINT32 CoreId, UINT64 Tag, UINT64 InstructionCount)
+{
+    EVENT_COSTS_SLOT * Slot = EventCostsGetSlot(CoreId, Tag);
+
+    if (Slot == NULL)
+    {
+        return;
+    }
+
+    Slot->Costs.ScriptInstructionCount += InstructionCount;
+}
+
+/**
+ * @brief Release the slots of an event on all cores
+ * @details called once the event is removed
+ *
+ * @param Tag
+ *
+ * @return VOID
+ */
+VOID
+EventCostsClear(UINT64 Tag)
+{
+    ULONG              ProcessorsCount = KeQueryActiveProcessorCount(0);
+    EVENT_COSTS_SLOT * Slot;
+
+    if (g_EventCosts == NULL)
+    {
+        return;
+    }
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        Slot = &g_EventCosts[i].Slots[(Tag - DebuggerEventTagStartSeed) % EVENT_COSTS_MAXIMUM_EVENTS];
+
+        if (Slot->Tag == Tag)
+        {
+            Slot->Tag = NULL_ZERO;
+        }
+    }
+}
+
+/**
+ * @brief Merge the costs of an event from all cores
+ *
+ * @param Tag
+ * @param Costs
+ *
+ * @return VOID
+ */
+VOID
+EventCostsQuery(UINT64 Tag, DEBUGGER_EVENT_COSTS * Costs)
+{
+    ULONG              ProcessorsCount = KeQueryActiveProcessorCount(0);
+    EVENT_COSTS_SLOT * Slot;
+
+    RtlZeroMemory(Costs, sizeof(DEBUGGER_EVENT_COSTS));
+
+    if (g_EventCosts == NULL)
+    {
+        return;
+    }
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        Slot = &g_EventCosts[i].Slots[(Tag - DebuggerEventTagStartSeed) % EVENT_COSTS_MAXIMUM_EVENTS];
+
+        Costs->UntrackedTriggers += g_EventCosts[i].UntrackedTriggers;
+
+        if (Slot->Tag != Tag)
+        {
+            continue;
+        }
+
+        Costs->TriggerCount += Slot->Costs.TriggerCount;
+        Costs->ConditionFalseCount += Slot->Costs.ConditionFalseCount;
+        Costs->ScriptInstructionCount += Slot->Costs.ScriptInstructionCount;
+        Costs->Cycles += Slot->Costs.Cycles;
+    }
+}
+
+/**
+ * @brief Clear the histograms of the handling time of the events and
+ * the untracked triggers on all cores
+ * @details called once the samples of the VM-exit profiler are reset
+ *
+ * @return VOID
+ */
+VOID
+EventCostsResetHistograms()
+{
+    ULONG ProcessorsCount = KeQueryActiveProcessorCount(0);
+
+    if (g_EventCosts == NULL)
+    {
+        return;
+    }
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        g_EventCosts[i].UntrackedTriggers = 0;
+
+        for (UINT32 j = 0; j < EVENT_COSTS_MAXIMUM_EVENTS; j++)
+        {
+            RtlZeroMemory(&g_EventCosts[i].Slots[j].Histogram, sizeof(VMEXIT_PROFILER_HISTOGRAM));
+        }
+    }
+}
+
+/**
+ * @brief Put the histogram of an event into the results of the VM-exit
+ * profiler
+ * @details Only the most expensive events are reported, if there is no
+ * free entry then the cheapest event is replaced
+ *
+ * @param Results
+ * @param Tag
+ * @param Histogram
+ *
+ * @return VOID
+ */
+VOID
+EventCostsReportHistogram(VMEXIT_PROFILER_RESULTS * Results, UINT64 Tag, VMEXIT_PROFILER_HISTOGRAM * Histogram)
+{
+    VMEXIT_PROFILER_EVENT_HISTOGRAM * Cheapest = &Results->Events[0];
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EVENT_TAGS; i++)
+    {
+        if (Results->Events[i].Tag == NULL_ZERO)
+        {
+            Cheapest = &Results->Events[i];
+            break;
+        }
+
+        if (Results->Events[i].Histogram.TotalCycles < Cheapest->Histogram.TotalCycles)
+        {
+            Cheapest = &Results->Events[i];
+        }
+    }
+
+    if (Cheapest->Tag != NULL_ZERO)
+    {
+        //
+        // Either this event or the cheapest reported event is omitted
+        //
+        Results->OmittedEvents++;
+
+        if (Cheapest->Histogram.TotalCycles >= Histogram->TotalCycles)
+        {
+            return;
+        }
+    }
+
+    Cheapest->Tag = Tag;
+    RtlCopyMemory(&Cheapest->Histogram, Histogram, sizeof(VMEXIT_PROFILER_HISTOGRAM));
+}
+
+/**
+ * @brief Put the histograms of the handling time of the events into the
+ * results of the VM-exit profiler
+ *
+ * @param CoreId The target core or DEBUGGER_VMEXIT_PROFILER_ALL_CORES
+ * to aggregate the histograms of all cores
+ * @param Results
+ *
+ * @return VOID
+ */
+VOID
+EventCostsQueryHistograms(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results)
+{
+    ULONG                     ProcessorsCount = KeQueryActiveProcessorCount(0);
+    VMEXIT_PROFILER_HISTOGRAM Histogram;
+    UINT64                    Tag;
+    BOOLEAN                   IsMerged;
+
+    RtlZeroMemory(Results->Events, sizeof(Results->Events));
+    Results->UntrackedEvents = 0;
+    Results->OmittedEvents   = 0;
+
+    if (g_EventCosts == NULL)
+    {
+        return;
+    }
+
+    for (UINT32 i = 0; i < ProcessorsCount; i++)
+    {
+        if (CoreId == DEBUGGER_VMEXIT_PROFILER_ALL_CORES || CoreId == i)
+        {
+            Results->UntrackedEvents += g_EventCosts[i].UntrackedTriggers;
+        }
+    }
+
+    for (UINT32 j = 0; j < EVENT_COSTS_MAXIMUM_EVENTS; j++)
+    {
+        for (UINT32 i = 0; i < ProcessorsCount; i++)
+        {
+            if (CoreId != DEBUGGER_VMEXIT_PROFILER_ALL_CORES && CoreId != i)
+            {
+                continue;
+            }
+
+            Tag = g_EventCosts[i].Slots[j].Tag;
+
+            if (Tag == NULL_ZERO)
+            {
+                continue;
+            }
+
+            //
+            // Each tag is always put into the same slot on all cores, but
+            // the slot might be owned by a different tag on another core,
+            // so the tag is merged only once (by the first core that owns it)
+            //
+            IsMerged = FALSE;
+
+            for (UINT32 k = 0; k < i; k++)
+            {
+                if ((CoreId == DEBUGGER_VMEXIT_PROFILER_ALL_CORES || CoreId == k) && g_EventCosts[k].Slots[j].Tag == Tag)
+                {
+                    IsMerged = TRUE;
+                    break;
+                }
+            }
+
+            if (IsMerged)
+            {
+                continue;
+            }
+
+            RtlZeroMemory(&Histogram, sizeof(VMEXIT_PROFILER_HISTOGRAM));
+
+            for (UINT32 k = i; k < ProcessorsCount; k++)
+            {
+                if ((CoreId == DEBUGGER_VMEXIT_PROFILER_ALL_CORES || CoreId == k) && g_EventCosts[k].Slots[j].Tag == Tag)
+                {
+                    VmFuncVmexitProfilerMergeHistogram(&Histogram, &g_EventCosts[k].Slots[j].Histogram);
+                }
+            }
+
+            if (Histogram.Count != 0)
+            {
+                EventCostsReportHistogram(Results, Tag, &Histogram);
+            }
+        }
+    }
+}
@@ -482,7 +482,11 @@ KdHandleDebugEventsWhenKernelDebuggerIsAttached(PROCESSOR_DEBUGGING_STATE * DbgS
                 }
             }
 
-            if (!IgnoreDebugEvent)
+            //
+            // Check whether it's one of the batched steps, if so, the next step
+            // is armed and there is no need to halt the debuggee
+            //
+            if (!IgnoreDebugEvent && !StepTraceHandleStep(DbgState, FALSE))
             {
                 //
                 // Handle a regular step
@@ -1187,6 +1191,15 @@ KdHandleRegisteredMtfCallback(UINT32 CoreId)
                                                                 DEBUGGEE_PAUSING_REASON_DEBUGGEE_STEPPED,
                                                                 TRUE))
         {
+            //
+            // Check whether it's one of the batched steps, if so, the next step
+            // is armed and there is no need to halt the debuggee
+            //
+            if (StepTraceHandleStep(DbgState, TRUE))
+            {
+                return;
+            }
+
             //
             // Handle the step (if the disassembly ignored here, it means the debugger wants to use it
             // as a tracking mechanism, so we'll change the reason for that)
@@ -2138,6 +2151,38 @@ KdPerformEventQueryAndModification(PDEBUGGER_MODIFY_EVENTS ModifyAndQueryEvent)
             ModifyAndQueryEvent->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
         }
     }
+    else if (ModifyAndQueryEvent->TypeOfAction == DEBUGGER_MODIFY_EVENTS_QUERY_COSTS)
+    {
+        //
+        // check if tag is valid or not
+        //
+        if (!DebuggerIsTagValid(ModifyAndQueryEvent->Tag))
+        {
+            ModifyAndQueryEvent->KernelStatus = DEBUGGER_ERROR_TAG_NOT_EXISTS;
+        }
+        else
+        {
+            //
+            // Merge the costs of the event from all cores
+            //
+            EventCostsQuery(ModifyAndQueryEvent->Tag, &ModifyAndQueryEvent->Costs);
+
+            //
+            // The function was successful
+            //
+            ModifyAndQueryEvent->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+        }
+    }
+    else if (ModifyAndQueryEvent->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS ||
+             ModifyAndQueryEvent->TypeOfAction == DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS)
+    {
+        g_EventCostsEnabled = ModifyAndQueryEvent->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS;
+
+        //
+        // The function was successful
+        //
+        ModifyAndQueryEvent->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+    }
     else if (ModifyAndQueryEvent->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE)
     {
         if (IsForAllEvents)
@@ -2296,6 +2341,8 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
     PDEBUGGER_FLUSH_LOGGING_BUFFERS                     FlushPacket;
     PDEBUGGER_CALLSTACK_REQUEST                         CallstackPacket;
     PDEBUGGER_SINGLE_CALLSTACK_FRAME                    CallstackFrameBuffer;
+    GUEST_REGS *                                        CallstackUnwindRegs;
+    UINT64                                              CallstackUnwindRip;
     PDEBUGGER_DEBUGGER_TEST_QUERY_BUFFER                TestQueryPacket;
     PDEBUGGEE_REGISTER_READ_DESCRIPTION                 ReadRegisterPacket;
     PDEBUGGEE_REGISTER_WRITE_DESCRIPTION                WriteRegisterPacket;
@@ -2309,6 +2356,9 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
     PDEBUGGEE_BP_PACKET                                 BpPacket;
     PDEBUGGER_READ_PAGE_TABLE_ENTRIES_DETAILS           PtePacket;
     PDEBUGGER_APIC_REQUEST                              ApicPacket;
+    PDEBUGGER_VMEXIT_PROFILER_REQUEST                   VmexitProfilerPacket;
+    PDEBUGGER_DIRTY_PAGES_REQUEST                       DirtyPagesPacket;
+    PDEBUGGER_SNAPSHOT_REQUEST                          SnapshotPacket;
     PDEBUGGER_PAGE_IN_REQUEST                           PageinPacket;
     PDEBUGGER_VA2PA_AND_PA2VA_COMMANDS                  Va2paPa2vaPacket;
     PDEBUGGEE_BP_LIST_OR_MODIFY_PACKET                  BpListOrModifyPacket;
@@ -2405,9 +2455,12 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
                     //
 
                     //
-                    // Indicate a step
+                    // Indicate a step (or start the batched steps)
                     //
-                    KdGuaranteedStepInstruction(DbgState);
+                    if (!StepTraceStart(DbgState, SteppingPacket))
+                    {
+                        KdGuaranteedStepInstruction(DbgState);
+                    }
 
                     //
                     // Unlock just on core
@@ -2431,9 +2484,12 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
                 case DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_OVER_FOR_GU_LAST_INSTRUCTION:
 
                     //
-                    // Step-over (p command)
+                    // Step-over (p command) or the batched steps
                     //
-                    KdRegularStepOver(DbgState, SteppingPacket->IsCurrentInstructionACall, SteppingPacket->CallLength);
+                    if (!StepTraceStart(DbgState, SteppingPacket))
+                    {
+                        KdRegularStepOver(DbgState, SteppingPacket->IsCurrentInstructionACall, SteppingPacket->CallLength);
+                    }
 
                     //
                     // Unlock other cores
@@ -2459,9 +2515,12 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
                     //
 
                     //
-                    // Indicate a step
+                    // Indicate a step (or start the batched steps)
                     //
-                    KdRegularStepInInstruction(DbgState);
+                    if (!StepTraceStart(DbgState, SteppingPacket))
+                    {
+                        KdRegularStepInInstruction(DbgState);
+                    }
 
                     //
                     // Unlock other cores
@@ -2564,21 +2623,28 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
 
                 CallstackFrameBuffer = (DEBUGGER_SINGLE_CALLSTACK_FRAME *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET) + sizeof(DEBUGGER_CALLSTACK_REQUEST));
 
+                CallstackUnwindRegs = NULL;
+                CallstackUnwindRip  = (UINT64)NULL;
+
                 //
-                // If the address is null, we use the current RSP register
+                // If the address is null, we use the current RSP register and
+                // the frames are unwound from the current registers
                 //
                 if (CallstackPacket->BaseAddress == (UINT64)NULL)
                 {
                     CallstackPacket->BaseAddress = DbgState->Regs->rsp;
+
+                    CallstackUnwindRegs = DbgState->Regs;
+                    CallstackUnwindRip  = VmFuncGetLastVmexitRip(DbgState->CoreId);
                 }
 
                 //
                 // Feel the callstack frames the buffers
                 //
-                if (CallstackWalkthroughStack(CallstackFrameBuffer,
-                                              CallstackPacket->BaseAddress,
-                                              CallstackPacket->Size,
-                                              CallstackPacket->Is32Bit))
+                if (CallstackWalkthroughStack(CallstackPacket,
+                                              CallstackFrameBuffer,
+                                              CallstackUnwindRegs,
+                                              CallstackUnwindRip))
                 {
                     CallstackPacket->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
                 }
@@ -2825,8 +2891,7 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
                 // Call the search wrapper
                 //
 
-                if (SearchAddressWrapper(NULL,
-                                         SearchQueryPacket,
+                if (SearchAddressWrapper(SearchQueryPacket,
                                          SearchQueryPacket->Address,
                                          SearchQueryPacket->Address + SearchQueryPacket->Length,
                                          TRUE,
@@ -3015,6 +3080,63 @@ KdDispatchAndPerformCommandsFromDebugger(PROCESSOR_DEBUGGING_STATE * DbgState)
 
                 break;
 
+            case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_VMEXIT_PROFILER:
+
+                VmexitProfilerPacket = (DEBUGGER_VMEXIT_PROFILER_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+                //
+                // Call the VM-exit profiler handler (size to send is computed by this function)
+                //
+                SizeToSend = ExtensionCommandPerformActionsForVmexitProfilerRequests(VmexitProfilerPacket);
+
+                //
+                // Send the result of the VM-exit profiler requests back to the debuggee
+                //
+                KdResponsePacketToDebugger(DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER,
+                                           DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_VMEXIT_PROFILER_REQUESTS,
+                                           (CHAR *)VmexitProfilerPacket,
+                                           SizeToSend);
+
+                break;
+
+            case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_DIRTY_PAGES:
+
+                DirtyPagesPacket = (DEBUGGER_DIRTY_PAGES_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+                //
+                // Call the dirty pages handler (size to send is computed by this function)
+                //
+                SizeToSend = ExtensionCommandPerformActionsForDirtyPagesRequests(DirtyPagesPacket, TRUE);
+
+                //
+                // Send the result of the dirty pages requests back to the debuggee
+                //
+                KdResponsePacketToDebugger(DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER,
+                                           DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_DIRTY_PAGES_REQUESTS,
+                                           (CHAR *)DirtyPagesPacket,
+                                           SizeToSend);
+
+                break;
+
+            case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_SNAPSHOT:
+
+                SnapshotPacket = (DEBUGGER_SNAPSHOT_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+                //
+                // Call the snapshot handler (size to send is computed by this function)
+                //
+                SizeToSend = ExtensionCommandPerformActionsForSnapshotRequests(SnapshotPacket, TRUE);
+
+                //
+                // Send the result of the snapshot requests back to the debuggee
+                //
+                KdResponsePacketToDebugger(DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER,
+                                           DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_SNAPSHOT_REQUESTS,
+                                           (CHAR *)SnapshotPacket,
+                                           SizeToSend);
+
+                break;
+
             case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_INJECT_PAGE_FAULT:
 
                 PageinPacket = (DEBUGGER_PAGE_IN_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
@@ -3212,6 +3334,15 @@ KdManageSystemHaltOnVmxRoot(PROCESSOR_DEBUGGING_STATE *       DbgState,
     //
     KdApplyTasksPreHaltCore(DbgState);
 
+    //
+    // Any halt finishes the batched steps, so the remaining records
+    // are sent before the pausing packet
+    //
+    if (DbgState->MainDebuggingCore)
+    {
+        StepTraceFinish();
+    }
+
 StartAgain:
 
     //
@@ -20,7 +20,11 @@
 BOOLEAN
 GlobalDebuggingStateAllocateZeroedMemory(VOID)
 {
-    SSIZE_T BufferSizeInByte = sizeof(PROCESSOR_DEBUGGING_STATE) * KeQueryActiveProcessorCount(0);
+    //
+    // PROCESSOR_DEBUGGING_STATE is aligned to the cache line, allocations that are equal or
+    // bigger than a page are page-aligned, so the size is rounded up to pages
+    //
+    SSIZE_T BufferSizeInByte = ROUND_TO_PAGES(sizeof(PROCESSOR_DEBUGGING_STATE) * KeQueryActiveProcessorCount(0));
 
     //
     // Allocate global variable to hold Debugging(s) state
@@ -0,0 +1,632 @@
+/**
+ * @file StepTrace.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Batched steps (t, p, and i commands with records)
+ * @details The count of steps, the stop condition, and the type of records
+ * are received once, then the steps are performed in the debuggee without
+ * halting the system, and the records of each step are saved in a
+ * preallocated buffer which is sent to the debugger in large chunks
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize the batched steps
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+StepTraceInitialize()
+{
+    //
+    // The buffer holds the chunk header and the records, it's allocated
+    // once as the records are saved in vmx-root
+    //
+    g_StepTraceState.Buffer = (BYTE *)PlatformMemAllocateNonPagedPool(STEP_TRACE_BUFFER_SIZE);
+
+    if (g_StepTraceState.Buffer == NULL)
+    {
+        LogInfo("err, insufficient memory for allocating the buffer of batched steps\n");
+        return FALSE;
+    }
+
+    g_StepTraceState.ShadowStacks = (STEP_TRACE_SHADOW_STACK *)
+        PlatformMemAllocateZeroedNonPagedPool(sizeof(STEP_TRACE_SHADOW_STACK) * KeQueryActiveProcessorCount(0));
+
+    if (g_StepTraceState.ShadowStacks == NULL)
+    {
+        LogInfo("err, insufficient memory for allocating the shadow call stacks of batched steps\n");
+
+        PlatformMemFreePool(g_StepTraceState.Buffer);
+        g_StepTraceState.Buffer = NULL;
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Uninitialize the batched steps
+ *
+ * @return VOID
+ */
+VOID
+StepTraceUninitialize()
+{
+    g_StepTraceState.IsActive = FALSE;
+
+    if (g_StepTraceState.Buffer != NULL)
+    {
+        PlatformMemFreePool(g_StepTraceState.Buffer);
+        g_StepTraceState.Buffer = NULL;
+    }
+
+    if (g_StepTraceState.ShadowStacks != NULL)
+    {
+        PlatformMemFreePool(g_StepTraceState.ShadowStacks);
+        g_StepTraceState.ShadowStacks = NULL;
+    }
+}
+
+/**
+ * @brief Compute the size of each record
+ *
+ * @param RecordType Type of records
+ * @param RegisterMask Mask of the saved registers
+ *
+ * @return UINT32
+ */
+UINT32
+StepTraceGetRecordSize(DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType, UINT32 RegisterMask)
+{
+    UINT32 RecordSize = sizeof(UINT64); // RIP
+
+    if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        return sizeof(DEBUGGEE_STEP_TRACE_EDGE_RECORD);
+    }
+
+    if (RecordType != DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP)
+    {
+        for (UINT32 i = 0; i <= 16; i++)
+        {
+            if (RegisterMask & (1 << i))
+            {
+                RecordSize += sizeof(UINT64);
+            }
+        }
+    }
+
+    if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+    {
+        RecordSize += MAXIMUM_INSTR_SIZE;
+    }
+
+    return RecordSize;
+}
+
+/**
+ * @brief Arm the next step of the batched steps
+ * @details In the case of step-over, calls are stepped-in (without saving
+ * records) until the call returns, so no hardware debug register is needed
+ * for the step-over
+ *
+ * @param DbgState The state of the debugger on the current core
+ * @param Rip The current RIP
+ *
+ * @return VOID
+ */
+VOID
+StepTraceArmStep(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip)
+{
+    UINT32  InstructionLength = 0;
+    BOOLEAN IsRet             = FALSE;
+
+    if (g_StepTraceState.StepType == DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN)
+    {
+        //
+        // Guaranteed step (i command)
+        //
+        KdGuaranteedStepInstruction(DbgState);
+        return;
+    }
+
+    if (g_StepTraceState.StepType == DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_OVER &&
+        !g_StepTraceState.IsSteppingOverCall)
+    {
+        //
+        // Check whether the current instruction is a call
+        //
+        if (DisassemblerCheckCallOrRetInVmxRootOnTargetProcess((PVOID)Rip, KdIsGuestOnUsermode32Bit(), &IsRet, &InstructionLength) &&
+            !IsRet)
+        {
+            g_StepTraceState.IsSteppingOverCall = TRUE;
+            g_StepTraceState.CallReturnAddress  = Rip + InstructionLength;
+            g_StepTraceState.CallStackPointer   = DbgState->Regs->rsp;
+            g_StepTraceState.StepsInCall        = 0;
+        }
+    }
+
+    //
+    // Regular step (t and p commands)
+    //
+    KdRegularStepInInstruction(DbgState);
+}
+
+/**
+ * @brief Send the records of the current chunk to the debugger
+ *
+ * @param IsLastChunk Whether it's the last chunk of the batched steps
+ *
+ * @return VOID
+ */
+VOID
+StepTraceFlushRecords(BOOLEAN IsLastChunk)
+{
+    PDEBUGGEE_STEP_TRACE_CHUNK Chunk = (PDEBUGGEE_STEP_TRACE_CHUNK)g_StepTraceState.Buffer;
+
+    if (g_StepTraceState.CountOfRecords == 0 && !IsLastChunk)
+    {
+        return;
+    }
+
+    Chunk->RecordType      = g_StepTraceState.RecordType;
+    Chunk->RegisterMask    = g_StepTraceState.RegisterMask;
+    Chunk->RecordSize      = g_StepTraceState.RecordSize;
+    Chunk->CountOfRecords  = g_StepTraceState.CountOfRecords;
+    Chunk->CoreId          = g_StepTraceState.ChunkCoreId;
+    Chunk->FirstStepNumber = g_StepTraceState.FirstStepNumber;
+    Chunk->Is32Bit         = g_StepTraceState.Is32Bit;
+    Chunk->IsLastChunk     = IsLastChunk;
+    Chunk->IsCompleted     = g_StepTraceState.IsCompleted;
+
+    KdResponsePacketToDebugger(DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER,
+                               DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_STEP_TRACE_RECORDS,
+                               (CHAR *)Chunk,
+                               sizeof(DEBUGGEE_STEP_TRACE_CHUNK) + g_StepTraceState.CountOfRecords * g_StepTraceState.RecordSize);
+
+    g_StepTraceState.CountOfRecords = 0;
+}
+
+/**
+ * @brief Allocate a record in the current chunk
+ * @details The current chunk is sent if it's full
+ *
+ * @param CoreId The core that executed the step
+ * @param Is32Bit Whether the debuggee is in 32-bit mode
+ *
+ * @return BYTE* The address of the record in the buffer
+ */
+BYTE *
+StepTraceAllocateRecord(UINT32 CoreId, BOOLEAN Is32Bit)
+{
+    BYTE * Record;
+
+    //
+    // Records of a chunk have the same operating mode and core, so the chunk
+    // is sent if the mode or the core is changed or the buffer is full
+    //
+    if (g_StepTraceState.CountOfRecords != 0 &&
+        (g_StepTraceState.Is32Bit != Is32Bit || g_StepTraceState.ChunkCoreId != CoreId ||
+         sizeof(DEBUGGEE_STEP_TRACE_CHUNK) + (g_StepTraceState.CountOfRecords + 1) * g_StepTraceState.RecordSize > STEP_TRACE_BUFFER_SIZE))
+    {
+        StepTraceFlushRecords(FALSE);
+    }
+
+    if (g_StepTraceState.CountOfRecords == 0)
+    {
+        g_StepTraceState.Is32Bit         = Is32Bit;
+        g_StepTraceState.ChunkCoreId     = CoreId;
+        g_StepTraceState.FirstStepNumber = g_StepTraceState.StepNumber;
+    }
+
+    Record = g_StepTraceState.Buffer + sizeof(DEBUGGEE_STEP_TRACE_CHUNK) +
+             g_StepTraceState.CountOfRecords * g_StepTraceState.RecordSize;
+
+    g_StepTraceState.CountOfRecords++;
+
+    return Record;
+}
+
+/**
+ * @brief Save the record of the current step
+ *
+ * @param DbgState The state of the debugger on the current core
+ * @param Rip The current RIP
+ *
+ * @return VOID
+ */
+VOID
+StepTraceSaveRecord(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip)
+{
+    UINT64 * Values = (UINT64 *)StepTraceAllocateRecord(DbgState->CoreId, KdIsGuestOnUsermode32Bit());
+
+    *Values++ = Rip;
+
+    if (g_StepTraceState.RecordType != DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP)
+    {
+        //
+        // Registers are saved in the order of the bits of the mask
+        //
+        for (UINT32 i = 0; i < 16; i++)
+        {
+            if (g_StepTraceState.RegisterMask & (1 << i))
+            {
+                *Values++ = ((UINT64 *)DbgState->Regs)[i];
+            }
+        }
+
+        if (g_StepTraceState.RegisterMask & DEBUGGER_STEP_TRACE_REGISTER_MASK_RFLAGS)
+        {
+            *Values++ = VmFuncGetRflags();
+        }
+    }
+
+    if (g_StepTraceState.RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+    {
+        //
+        // The memory operands are computed by the debugger from the bytes
+        // of the instruction and the registers
+        //
+        RtlZeroMemory(Values, MAXIMUM_INSTR_SIZE);
+        MemoryMapperReadMemorySafeOnTargetProcess(Rip, Values, CheckAddressMaximumInstructionLength((PVOID)Rip));
+    }
+}
+
+/**
+ * @brief Check whether the instruction of the next step is a 'call' or a 'ret'
+ * @details The record is saved after the step as the target is not known
+ * before executing the instruction
+ *
+ * @param Rip The current RIP
+ *
+ * @return VOID
+ */
+VOID
+StepTraceCheckEdge(UINT64 Rip)
+{
+    UINT32  InstructionLength = 0;
+    BOOLEAN IsRet             = FALSE;
+
+    g_StepTraceState.HasPendingEdge = DisassemblerCheckCallOrRetInVmxRootOnTargetProcess((PVOID)Rip,
+                                                                                         KdIsGuestOnUsermode32Bit(),
+                                                                                         &IsRet,
+                                                                                         &InstructionLength);
+
+    if (g_StepTraceState.HasPendingEdge)
+    {
+        g_StepTraceState.IsPendingEdgeRet         = IsRet;
+        g_StepTraceState.PendingEdgeAddress       = Rip;
+        g_StepTraceState.PendingEdgeReturnAddress = Rip + InstructionLength;
+    }
+}
+
+/**
+ * @brief Save the record of the 'call' or the 'ret' which is executed by
+ * the previous step (if any)
+ * @details The depth is computed by the shadow call stack of the current core,
+ * a 'ret' pops the stack until its target (so the frames that are skipped by
+ * exceptions or longjmps are also removed)
+ *
+ * @param DbgState The state of the debugger on the current core
+ * @param Rip The current RIP (the target of the 'call' or the 'ret')
+ *
+ * @return VOID
+ */
+VOID
+StepTraceSaveEdgeRecord(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip)
+{
+    PDEBUGGEE_STEP_TRACE_EDGE_RECORD Record;
+    STEP_TRACE_SHADOW_STACK *        ShadowStack = &g_StepTraceState.ShadowStacks[DbgState->CoreId];
+    UINT32                           Index;
+
+    if (g_StepTraceState.HasPendingEdge)
+    {
+        Record = (PDEBUGGEE_STEP_TRACE_EDGE_RECORD)StepTraceAllocateRecord(DbgState->CoreId, KdIsGuestOnUsermode32Bit());
+
+        Record->Address = g_StepTraceState.PendingEdgeAddress;
+        Record->Target  = Rip;
+        Record->IsRet   = g_StepTraceState.IsPendingEdgeRet;
+
+        if (!g_StepTraceState.IsPendingEdgeRet)
+        {
+            //
+            // Push the return address (deeper calls are only counted)
+            //
+            Record->Depth = ShadowStack->Depth;
+
+            if (ShadowStack->Depth < STEP_TRACE_SHADOW_STACK_SIZE)
+            {
+                ShadowStack->ReturnAddresses[ShadowStack->Depth] = g_StepTraceState.PendingEdgeReturnAddress;
+            }
+
+            ShadowStack->Depth++;
+        }
+        else
+        {
+            //
+            // Find the frame of the target, otherwise only one frame is popped
+            //
+            Index = ShadowStack->Depth < STEP_TRACE_SHADOW_STACK_SIZE ? ShadowStack->Depth : STEP_TRACE_SHADOW_STACK_SIZE;
+
+            while (Index != 0 && ShadowStack->ReturnAddresses[Index - 1] != Rip)
+            {
+                Index--;
+            }
+
+            if (Index != 0)
+            {
+                ShadowStack->Depth = Index - 1;
+            }
+            else if (ShadowStack->Depth != 0)
+            {
+                ShadowStack->Depth--;
+            }
+
+            Record->Depth = ShadowStack->Depth;
+        }
+    }
+
+    StepTraceCheckEdge(Rip);
+}
+
+/**
+ * @brief Start the batched steps
+ * @details The first step is also armed here
+ *
+ * @param DbgState The state of the debugger on the current core
+ * @param StepPacket The stepping packet
+ *
+ * @return BOOLEAN Whether the batched steps are started or it's a regular step
+ */
+BOOLEAN
+StepTraceStart(PROCESSOR_DEBUGGING_STATE * DbgState, PDEBUGGEE_STEP_PACKET StepPacket)
+{
+    UINT32 RegisterMask = StepPacket->RegisterMask & DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+
+    if (StepPacket->CountOfSteps == 0 || g_StepTraceState.Buffer == NULL)
+    {
+        return FALSE;
+    }
+
+    //
+    // The call/ret records are only supported in the instrumentation step-in
+    // as the shadow call stacks are maintained for each core
+    //
+    if (StepPacket->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES &&
+        StepPacket->StepType != DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN)
+    {
+        return FALSE;
+    }
+
+    if (StepPacket->StepType != DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN &&
+        StepPacket->StepType != DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN &&
+        StepPacket->StepType != DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_OVER)
+    {
+        return FALSE;
+    }
+
+    switch (StepPacket->RecordType)
+    {
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP:
+        RegisterMask = 0;
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS:
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS:
+
+        //
+        // All the registers are needed for computing the memory operands
+        //
+        RegisterMask = DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES:
+        RegisterMask = 0;
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    SpinlockLock(&g_StepTraceState.Lock);
+
+    g_StepTraceState.StepType           = StepPacket->StepType;
+    g_StepTraceState.CoreId             = DbgState->CoreId;
+    g_StepTraceState.ProcessId          = HANDLE_TO_UINT32(PsGetCurrentProcessId());
+    g_StepTraceState.ThreadId           = HANDLE_TO_UINT32(PsGetCurrentThreadId());
+    g_StepTraceState.RemainingSteps     = StepPacket->CountOfSteps;
+    g_StepTraceState.StepNumber         = StepPacket->FirstStepNumber;
+    g_StepTraceState.RecordType         = StepPacket->RecordType;
+    g_StepTraceState.RegisterMask       = RegisterMask;
+    g_StepTraceState.RecordSize         = StepTraceGetRecordSize(StepPacket->RecordType, RegisterMask);
+    g_StepTraceState.StopAtAddress      = StepPacket->StopAtAddress;
+    g_StepTraceState.StopAddress        = StepPacket->StopAddress;
+    g_StepTraceState.IsCompleted        = FALSE;
+    g_StepTraceState.IsSteppingOverCall = FALSE;
+    g_StepTraceState.CountOfRecords     = 0;
+    g_StepTraceState.HasPendingEdge     = FALSE;
+    g_StepTraceState.IsActive           = TRUE;
+
+    if (StepPacket->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        //
+        // The call tree is continued if it's not the first batch of the command
+        //
+        if (StepPacket->FirstStepNumber == 0)
+        {
+            g_StepTraceState.ShadowStacks[DbgState->CoreId].Depth = 0;
+        }
+
+        StepTraceCheckEdge(VmFuncGetLastVmexitRip(DbgState->CoreId));
+    }
+
+    StepTraceArmStep(DbgState, VmFuncGetLastVmexitRip(DbgState->CoreId));
+
+    SpinlockUnlock(&g_StepTraceState.Lock);
+
+    return TRUE;
+}
+
+/**
+ * @brief Handle a step of the batched steps
+ * @details This function should be called in vmx-root
+ *
+ * @param DbgState The state of the debugger on the current core
+ * @param IsInstrumentationStep Whether it's an MTF (instrumentation step-in)
+ * or a trap flag (regular step)
+ *
+ * @return BOOLEAN Whether the step is handled and the next step is armed,
+ * if it returns FALSE the debuggee should be halted
+ */
+BOOLEAN
+StepTraceHandleStep(PROCESSOR_DEBUGGING_STATE * DbgState, BOOLEAN IsInstrumentationStep)
+{
+    UINT64  Rip;
+    BOOLEAN Result = FALSE;
+
+    if (!g_StepTraceState.IsActive)
+    {
+        return FALSE;
+    }
+
+    SpinlockLock(&g_StepTraceState.Lock);
+
+    //
+    // Check whether the step belongs to the batched steps
+    //
+    if (!g_StepTraceState.IsActive ||
+        IsInstrumentationStep != (g_StepTraceState.StepType == DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN))
+    {
+        goto Exit;
+    }
+
+    if (IsInstrumentationStep)
+    {
+        //
+        // Other cores are halted in the instrumentation step-in
+        //
+        if (g_StepTraceState.CoreId != DbgState->CoreId)
+        {
+            goto Exit;
+        }
+    }
+    else if (g_StepTraceState.ProcessId != HANDLE_TO_UINT32(PsGetCurrentProcessId()) ||
+             g_StepTraceState.ThreadId != HANDLE_TO_UINT32(PsGetCurrentThreadId()))
+    {
+        goto Exit;
+    }
+
+    Rip = VmFuncGetLastVmexitRip(DbgState->CoreId);
+
+    if (g_StepTraceState.IsSteppingOverCall)
+    {
+        //
+        // Check whether the call is returned (the stack pointer is also checked
+        // to avoid recursive calls)
+        //
+        if (Rip == g_StepTraceState.CallReturnAddress && DbgState->Regs->rsp >= g_StepTraceState.CallStackPointer)
+        {
+            g_StepTraceState.IsSteppingOverCall = FALSE;
+        }
+        else if (DbgState->Regs->rsp > g_StepTraceState.CallStackPointer)
+        {
+            //
+            // The frame of the call is removed without returning to the
+            // caller (e.g., an exception or a longjmp), so the step-over is
+            // finished at the current instruction
+            //
+            g_StepTraceState.IsSteppingOverCall = FALSE;
+        }
+        else if (++g_StepTraceState.StepsInCall >= STEP_TRACE_MAXIMUM_STEPS_IN_CALL)
+        {
+            //
+            // The call doesn't return (e.g., an endless loop or a thread
+            // that is switched to another stack), the debuggee is halted
+            // and the records are sent
+            //
+            goto Exit;
+        }
+        else
+        {
+            KdRegularStepInInstruction(DbgState);
+
+            Result = TRUE;
+            goto Exit;
+        }
+    }
+
+    if (g_StepTraceState.RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        StepTraceSaveEdgeRecord(DbgState, Rip);
+    }
+    else
+    {
+        StepTraceSaveRecord(DbgState, Rip);
+    }
+
+    g_StepTraceState.StepNumber++;
+    g_StepTraceState.RemainingSteps--;
+
+    //
+    // Check the stop conditions, the records are sent once the debuggee is halted
+    //
+    if (g_StepTraceState.StopAtAddress && Rip == g_StepTraceState.StopAddress)
+    {
+        goto Exit;
+    }
+
+    if (g_StepTraceState.RemainingSteps == 0)
+    {
+        //
+        // The debugger continues with the next batch (if any)
+        //
+        g_StepTraceState.IsCompleted = TRUE;
+        goto Exit;
+    }
+
+    StepTraceArmStep(DbgState, Rip);
+
+    Result = TRUE;
+
+Exit:
+    SpinlockUnlock(&g_StepTraceState.Lock);
+
+    return Result;
+}
+
+/**
+ * @brief Finish the batched steps (if any) and send the remaining records
+ * @details This function is called before halting the debuggee, so the
+ * batched steps are finished by any halt (e.g., breakpoints or pausing
+ * the debuggee)
+ *
+ * @return VOID
+ */
+VOID
+StepTraceFinish()
+{
+    if (!g_StepTraceState.IsActive)
+    {
+        return;
+    }
+
+    SpinlockLock(&g_StepTraceState.Lock);
+
+    if (g_StepTraceState.IsActive)
+    {
+        g_StepTraceState.IsActive = FALSE;
+
+        StepTraceFlushRecords(TRUE);
+    }
+
+    SpinlockUnlock(&g_StepTraceState.Lock);
+}
@@ -148,6 +148,11 @@ AttachingCreateProcessDebuggingDetails(UINT32    ProcessId,
     //
     InsertHeadList(&g_ProcessDebuggingDetailsListHead, &(ProcessDebuggingDetail->AttachedProcessList));
 
+    //
+    // Add it to the process id index
+    //
+    ThreadHolderInsertProcessToIndex(ProcessDebuggingDetail);
+
     //
     // return the token
     //
@@ -186,6 +191,16 @@ AttachingFindProcessDebuggingDetailsByToken(UINT64 Token)
 PUSERMODE_DEBUGGING_PROCESS_DETAILS
 AttachingFindProcessDebuggingDetailsByProcessId(UINT32 ProcessId)
 {
+    PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail;
+
+    //
+    // Check the process id index first
+    //
+    if (ThreadHolderLookupProcessIndex(ProcessId, &ProcessDebuggingDetail))
+    {
+        return ProcessDebuggingDetail;
+    }
+
     LIST_FOR_EACH_LINK(g_ProcessDebuggingDetailsListHead, USERMODE_DEBUGGING_PROCESS_DETAILS, AttachedProcessList, ProcessDebuggingDetails)
     {
         //
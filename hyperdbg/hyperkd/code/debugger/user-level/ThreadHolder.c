@@ -30,6 +30,146 @@ ThreadHolderAllocateThreadHoldingBuffers()
     // a chance to allocate it, we allocate it here as it's safe at PASSIVE_LEVEL
     //
     PoolManagerCheckAndPerformAllocationAndDeallocation();
+
+    //
+    // Allocate the thread id and process id indexes, these indexes are
+    // accessed from vmx-root so they should be pre-allocated here
+    //
+    if (!ThreadHolderAllocateIndex(&g_ThreadHolderThreadIndex, THREAD_HOLDER_THREAD_INDEX_BITS) ||
+        !ThreadHolderAllocateIndex(&g_ThreadHolderProcessIndex, THREAD_HOLDER_PROCESS_INDEX_BITS))
+    {
+        //
+        // Not fatal, lookups fall back to walking the lists
+        //
+        LogWarning("Warning, unable to allocate the thread holder indexes, lookups "
+                   "will walk through the list of threads");
+    }
+}
+
+/**
+ * @brief Allocate a thread id or process id index
+ * @details this function should be called on vmx non-root
+ *
+ * @param Index
+ * @param Bits
+ * @return BOOLEAN
+ */
+BOOLEAN
+ThreadHolderAllocateIndex(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Bits)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries;
+
+    if (Index->Entries != NULL)
+    {
+        //
+        // Already allocated (from a previous initialization)
+        //
+        return TRUE;
+    }
+
+    Entries = (USERMODE_DEBUGGING_INDEX_ENTRY *)
+        PlatformMemAllocateZeroedNonPagedPool(sizeof(USERMODE_DEBUGGING_INDEX_ENTRY) * ((SIZE_T)1 << Bits));
+
+    if (Entries == NULL)
+    {
+        return FALSE;
+    }
+
+    ThreadHolderIndexInitialize(Index, Entries, Bits);
+
+    return TRUE;
+}
+
+/**
+ * @brief Free the thread id and process id indexes
+ * @details this function should be called on vmx non-root, the entries
+ * are freed after the lock-free readers stop accessing them
+ *
+ * @return VOID
+ */
+VOID
+ThreadHolderFreeIndexes()
+{
+    PUSERMODE_DEBUGGING_INDEX       Indexes[] = {&g_ThreadHolderThreadIndex, &g_ThreadHolderProcessIndex};
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries;
+
+    for (size_t i = 0; i < RTL_NUMBER_OF(Indexes); i++)
+    {
+        Entries = ThreadHolderIndexDetach(Indexes[i]);
+
+        if (Entries != NULL)
+        {
+            PlatformMemFreePool(Entries);
+        }
+    }
+}
+
+/**
+ * @brief Add the process debugging details to the process id index
+ * @details this function should be called on vmx non-root
+ *
+ * @param ProcessDebuggingDetail
+ * @return VOID
+ */
+VOID
+ThreadHolderInsertProcessToIndex(PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail)
+{
+    KIRQL OldIrql;
+
+    if (g_ThreadHolderProcessIndex.Entries == NULL)
+    {
+        return;
+    }
+
+    //
+    // Avoid being preempted while holding the vmx-root lock
+    //
+    OldIrql = KeRaiseIrqlToDpcLevel();
+    SpinlockLock(&VmxRootThreadHoldingLock);
+
+    ThreadHolderIndexInsert(&g_ThreadHolderProcessIndex, ProcessDebuggingDetail->ProcessId, ProcessDebuggingDetail);
+
+    SpinlockUnlock(&VmxRootThreadHoldingLock);
+    KeLowerIrql(OldIrql);
+}
+
+/**
+ * @brief Look up the process id index
+ *
+ * @param ProcessId
+ * @param ProcessDebuggingDetail
+ * @return BOOLEAN TRUE if the result is valid, FALSE if the caller should walk
+ * the list of processes
+ */
+BOOLEAN
+ThreadHolderLookupProcessIndex(UINT32 ProcessId, PUSERMODE_DEBUGGING_PROCESS_DETAILS * ProcessDebuggingDetail)
+{
+    PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDetails;
+
+    if (!ThreadHolderIndexLookup(&g_ThreadHolderProcessIndex, ProcessId, (PVOID *)&ProcessDetails))
+    {
+        return FALSE;
+    }
+
+    if (ProcessDetails == NULL)
+    {
+        //
+        // The index contains all of the processes
+        //
+        *ProcessDebuggingDetail = NULL;
+        return TRUE;
+    }
+
+    if (!ProcessDetails->Enabled)
+    {
+        //
+        // Another (enabled) process with the same id might be in the list
+        //
+        return FALSE;
+    }
+
+    *ProcessDebuggingDetail = ProcessDetails;
+    return TRUE;
 }
 
 /**
@@ -110,6 +250,28 @@ ThreadHolderGetProcessThreadDetailsByProcessIdAndThreadId(UINT32 ProcessId, UINT
 {
     PLIST_ENTRY                         TempList = 0;
     PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail;
+    PUSERMODE_DEBUGGING_THREAD_DETAILS  ThreadDetails;
+
+    //
+    // Check the thread id index first
+    //
+    if (ThreadHolderIndexLookup(&g_ThreadHolderThreadIndex, ThreadId, (PVOID *)&ThreadDetails))
+    {
+        if (ThreadDetails == NULL)
+        {
+            //
+            // Active thread not found
+            //
+            return NULL;
+        }
+
+        ProcessDebuggingDetail = ThreadDetails->ProcessDetails;
+
+        if (ProcessDebuggingDetail->ProcessId == ProcessId && ProcessDebuggingDetail->Enabled)
+        {
+            return ThreadDetails;
+        }
+    }
 
     //
     // First, find the process details
@@ -204,8 +366,18 @@ ThreadHolderGetProcessFirstThreadDetailsByProcessId(UINT32 ProcessId)
 PUSERMODE_DEBUGGING_PROCESS_DETAILS
 ThreadHolderGetProcessDebuggingDetailsByThreadId(UINT32 ThreadId)
 {
-    PLIST_ENTRY TempList  = 0;
-    PLIST_ENTRY TempList2 = 0;
+    PLIST_ENTRY                        TempList  = 0;
+    PLIST_ENTRY                        TempList2 = 0;
+    PUSERMODE_DEBUGGING_THREAD_DETAILS ThreadDetails;
+
+    //
+    // Check the thread id index first (if the thread is not found, it's
+    // not an active thread)
+    //
+    if (ThreadHolderIndexLookup(&g_ThreadHolderThreadIndex, ThreadId, (PVOID *)&ThreadDetails))
+    {
+        return ThreadDetails != NULL ? ThreadDetails->ProcessDetails : NULL;
+    }
 
     TempList = &g_ProcessDebuggingDetailsListHead;
 
@@ -256,14 +428,34 @@ ThreadHolderGetProcessDebuggingDetailsByThreadId(UINT32 ThreadId)
 PUSERMODE_DEBUGGING_THREAD_DETAILS
 ThreadHolderFindOrCreateThreadDebuggingDetail(UINT32 ThreadId, PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail)
 {
-    PLIST_ENTRY TempList = 0;
+    PLIST_ENTRY                        TempList      = 0;
+    BOOLEAN                            WalkTheHolder = TRUE;
+    PUSERMODE_DEBUGGING_THREAD_DETAILS ThreadDetails;
+
+    //
+    // Check the thread id index first
+    //
+    if (ThreadHolderIndexLookup(&g_ThreadHolderThreadIndex, ThreadId, (PVOID *)&ThreadDetails))
+    {
+        if (ThreadDetails != NULL && ThreadDetails->ProcessDetails == ProcessDebuggingDetail)
+        {
+            return ThreadDetails;
+        }
+
+        //
+        // If the thread is not in the index, the thread is not in the holders, but
+        // if the thread id is indexed for another process, the holders of this
+        // process still need to be checked
+        //
+        WalkTheHolder = ThreadDetails != NULL;
+    }
 
     TempList = &ProcessDebuggingDetail->ThreadsListHead;
 
     //
     // Let's see if we can find the thread
     //
-    while (&ProcessDebuggingDetail->ThreadsListHead != TempList->Flink)
+    while (WalkTheHolder && &ProcessDebuggingDetail->ThreadsListHead != TempList->Flink)
     {
         TempList = TempList->Flink;
         PUSERMODE_DEBUGGING_THREAD_HOLDER ThreadHolder =
@@ -308,7 +500,13 @@ ThreadHolderFindOrCreateThreadDebuggingDetail(UINT32 ThreadId, PUSERMODE_DEBUGGI
                 //
                 // We find a null thread place, let's return it's structure
                 //
-                ThreadHolder->Threads[i].ThreadId = ThreadId;
+                ThreadHolder->Threads[i].ThreadId       = ThreadId;
+                ThreadHolder->Threads[i].ProcessDetails = ProcessDebuggingDetail;
+
+                //
+                // Add it to the thread id index
+                //
+                ThreadHolderIndexInsert(&g_ThreadHolderThreadIndex, ThreadId, &ThreadHolder->Threads[i]);
 
                 SpinlockUnlock(&VmxRootThreadHoldingLock);
                 return &ThreadHolder->Threads[i];
@@ -336,13 +534,19 @@ ThreadHolderFindOrCreateThreadDebuggingDetail(UINT32 ThreadId, PUSERMODE_DEBUGGI
     //
     // Add the current thread as the first entry of the holder
     //
-    NewThreadHolder->Threads[0].ThreadId = ThreadId;
+    NewThreadHolder->Threads[0].ThreadId       = ThreadId;
+    NewThreadHolder->Threads[0].ProcessDetails = ProcessDebuggingDetail;
 
     //
     // Link to the thread holding structure
     //
     InsertHeadList(&ProcessDebuggingDetail->ThreadsListHead, &(NewThreadHolder->ThreadHolderList));
 
+    //
+    // Add it to the thread id index
+    //
+    ThreadHolderIndexInsert(&g_ThreadHolderThreadIndex, ThreadId, &NewThreadHolder->Threads[0]);
+
     //
     // Other threads are now allowed to use the thread listing mechanism
     //
@@ -465,6 +669,21 @@ VOID
 ThreadHolderFreeHoldingStructures(PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail)
 {
     PLIST_ENTRY TempList = 0;
+    KIRQL       OldIrql;
+
+    //
+    // Avoid being preempted while holding the vmx-root lock
+    //
+    OldIrql = KeRaiseIrqlToDpcLevel();
+    SpinlockLock(&VmxRootThreadHoldingLock);
+
+    //
+    // Remove the process from the process id index
+    //
+    if (g_ThreadHolderProcessIndex.Entries != NULL)
+    {
+        ThreadHolderIndexRemove(&g_ThreadHolderProcessIndex, ProcessDebuggingDetail->ProcessId, ProcessDebuggingDetail);
+    }
 
     TempList = &ProcessDebuggingDetail->ThreadsListHead;
 
@@ -474,12 +693,29 @@ ThreadHolderFreeHoldingStructures(PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDeb
         PUSERMODE_DEBUGGING_THREAD_HOLDER ThreadHolder =
             CONTAINING_RECORD(TempList, USERMODE_DEBUGGING_THREAD_HOLDER, ThreadHolderList);
 
+        //
+        // Remove the threads of this holder from the thread id index
+        //
+        if (g_ThreadHolderThreadIndex.Entries != NULL)
+        {
+            for (size_t i = 0; i < MAX_THREADS_IN_A_PROCESS_HOLDER; i++)
+            {
+                if (ThreadHolder->Threads[i].ThreadId != NULL_ZERO)
+                {
+                    ThreadHolderIndexRemove(&g_ThreadHolderThreadIndex, ThreadHolder->Threads[i].ThreadId, &ThreadHolder->Threads[i]);
+                }
+            }
+        }
+
         //
         // The thread is allocated from the pool management, so we'll
         // free it from there
         //
         PoolManagerFreePool((UINT64)ThreadHolder);
     }
+
+    SpinlockUnlock(&VmxRootThreadHoldingLock);
+    KeLowerIrql(OldIrql);
 }
 
 /**
@@ -0,0 +1,308 @@
+/**
+ * @file ThreadHolderIndex.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Thread id and process id indexes of the thread holder
+ * @details This file only uses the basic types and the interlocked
+ * routines, so it can be tested out of the kernel
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize an index with its pre-allocated (zeroed) entries
+ *
+ * @param Index
+ * @param Entries
+ * @param Bits
+ * @return VOID
+ */
+VOID
+ThreadHolderIndexInitialize(PUSERMODE_DEBUGGING_INDEX Index, PUSERMODE_DEBUGGING_INDEX_ENTRY Entries, UINT32 Bits)
+{
+    Index->Bits          = Bits;
+    Index->OccupiedSlots = 0;
+    Index->LiveSlots     = 0;
+    Index->Overflowed    = FALSE;
+    Index->ActiveReaders = 0;
+
+    //
+    // The entries are published at last
+    //
+    InterlockedExchangePointer((PVOID volatile *)&Index->Entries, Entries);
+}
+
+/**
+ * @brief Detach the entries of an index and wait for the lock-free readers
+ * @details after this function, no reader accesses the entries and the
+ * caller can free them
+ *
+ * @param Index
+ * @return PUSERMODE_DEBUGGING_INDEX_ENTRY the detached entries (NULL if the
+ * index is not initialized)
+ */
+PUSERMODE_DEBUGGING_INDEX_ENTRY
+ThreadHolderIndexDetach(PUSERMODE_DEBUGGING_INDEX Index)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries;
+
+    //
+    // New readers see a NULL index and walk the lists instead
+    //
+    Entries = (PUSERMODE_DEBUGGING_INDEX_ENTRY)InterlockedExchangePointer((PVOID volatile *)&Index->Entries, NULL);
+
+    //
+    // Wait for the readers that are already probing the entries
+    //
+    while (InterlockedCompareExchange(&Index->ActiveReaders, 0, 0) != 0)
+    {
+        YieldProcessor();
+    }
+
+    Index->Bits          = 0;
+    Index->OccupiedSlots = 0;
+    Index->LiveSlots     = 0;
+    Index->Overflowed    = FALSE;
+
+    return Entries;
+}
+
+/**
+ * @brief Find the slot of an id in the index
+ * @details the caller should either hold VmxRootThreadHoldingLock or be
+ * counted as an active reader of the index
+ *
+ * @param Entries
+ * @param Bits
+ * @param Id
+ * @return PUSERMODE_DEBUGGING_INDEX_ENTRY NULL if the id is not in the index
+ */
+static PUSERMODE_DEBUGGING_INDEX_ENTRY
+ThreadHolderIndexFind(PUSERMODE_DEBUGGING_INDEX_ENTRY Entries, UINT32 Bits, UINT32 Id)
+{
+    UINT32 Mask = ((UINT32)1 << Bits) - 1;
+    UINT32 Slot = THREAD_HOLDER_INDEX_HASH(Id, Bits);
+    UINT32 CurrentId;
+
+    if (Id == NULL_ZERO || Id == THREAD_HOLDER_INDEX_TOMBSTONE)
+    {
+        return NULL;
+    }
+
+    for (UINT32 i = 0; i <= Mask; i++)
+    {
+        CurrentId = Entries[Slot].Id;
+
+        if (CurrentId == Id)
+        {
+            return &Entries[Slot];
+        }
+
+        if (CurrentId == NULL_ZERO)
+        {
+            //
+            // Reached to an empty slot, the id is not in the index
+            //
+            return NULL;
+        }
+
+        Slot = (Slot + 1) & Mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Look up an id in the index without holding the lock
+ *
+ * @param Index
+ * @param Id
+ * @param Details the details of the id or NULL if the id is not in the index
+ * @return BOOLEAN TRUE if the result is valid, FALSE if the caller should walk
+ * the lists (the index is not allocated or it is overflowed)
+ */
+BOOLEAN
+ThreadHolderIndexLookup(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID * Details)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries;
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entry;
+    PVOID                           CurrentDetails = NULL;
+    BOOLEAN                         Result         = FALSE;
+
+    *Details = NULL;
+
+    if (Id == NULL_ZERO || Id == THREAD_HOLDER_INDEX_TOMBSTONE)
+    {
+        return FALSE;
+    }
+
+    //
+    // Count this reader before accessing the entries, so the entries are not
+    // freed while they're probed
+    //
+    InterlockedIncrement(&Index->ActiveReaders);
+
+    Entries = Index->Entries;
+
+    if (Entries != NULL)
+    {
+        while (TRUE)
+        {
+            Entry = ThreadHolderIndexFind(Entries, Index->Bits, Id);
+
+            if (Entry == NULL)
+            {
+                //
+                // If the index is not overflowed, it contains all of the ids
+                //
+                Result = !Index->Overflowed;
+                break;
+            }
+
+            CurrentDetails = Entry->Details;
+
+            //
+            // The slot might be removed (and reused for another id) after the
+            // id is checked, the details are only valid if the id is unchanged,
+            // otherwise, the index is probed again
+            //
+            if (Entry->Id == Id)
+            {
+                *Details = CurrentDetails;
+                Result   = CurrentDetails != NULL;
+                break;
+            }
+        }
+    }
+
+    InterlockedDecrement(&Index->ActiveReaders);
+
+    return Result;
+}
+
+/**
+ * @brief Insert (or update) an id in the index
+ * @details the caller should hold VmxRootThreadHoldingLock
+ *
+ * @param Index
+ * @param Id
+ * @param Details
+ * @return BOOLEAN FALSE if the index is full, the index is marked as overflowed
+ */
+BOOLEAN
+ThreadHolderIndexInsert(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID Details)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries = Index->Entries;
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entry;
+    UINT32                          Mask;
+    UINT32                          Slot;
+
+    if (Entries == NULL || Id == NULL_ZERO || Id == THREAD_HOLDER_INDEX_TOMBSTONE)
+    {
+        return FALSE;
+    }
+
+    Mask = ((UINT32)1 << Index->Bits) - 1;
+    Slot = THREAD_HOLDER_INDEX_HASH(Id, Index->Bits);
+
+    //
+    // Check if the id is already in the index, if so, the newer details
+    // replaces the previous one (e.g., the id is reused by the system)
+    //
+    Entry = ThreadHolderIndexFind(Entries, Index->Bits, Id);
+
+    if (Entry != NULL)
+    {
+        InterlockedExchangePointer(&Entry->Details, Details);
+        return TRUE;
+    }
+
+    //
+    // Find the first empty or removed slot
+    //
+    while (Entries[Slot].Id != NULL_ZERO && Entries[Slot].Id != THREAD_HOLDER_INDEX_TOMBSTONE)
+    {
+        Slot = (Slot + 1) & Mask;
+    }
+
+    Entry = &Entries[Slot];
+
+    if (Entry->Id == NULL_ZERO)
+    {
+        //
+        // Keep the load factor below 3/4 to keep the probes short and to make
+        // sure that the lookups always reach to an empty slot
+        //
+        if (Index->OccupiedSlots + 1 > (Mask + 1) - ((Mask + 1) >> 2))
+        {
+            Index->Overflowed = TRUE;
+            return FALSE;
+        }
+
+        Index->OccupiedSlots++;
+    }
+
+    InterlockedExchangePointer(&Entry->Details, Details);
+
+    //
+    // The id is published at last, so lock-free readers never see a
+    // matching id with the details of a previous id
+    //
+    InterlockedExchange((volatile LONG *)&Entry->Id, (LONG)Id);
+
+    Index->LiveSlots++;
+
+    return TRUE;
+}
+
+/**
+ * @brief Remove an id from the index if it still points to the details
+ * @details the caller should hold VmxRootThreadHoldingLock
+ *
+ * @param Index
+ * @param Id
+ * @param Details
+ * @return VOID
+ */
+VOID
+ThreadHolderIndexRemove(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID Details)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries = Index->Entries;
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entry;
+
+    if (Entries == NULL)
+    {
+        return;
+    }
+
+    Entry = ThreadHolderIndexFind(Entries, Index->Bits, Id);
+
+    if (Entry == NULL || Entry->Details != Details)
+    {
+        return;
+    }
+
+    InterlockedExchange((volatile LONG *)&Entry->Id, (LONG)THREAD_HOLDER_INDEX_TOMBSTONE);
+
+    Index->LiveSlots--;
+
+    if (Index->LiveSlots == 0)
+    {
+        //
+        // The index is empty, remove the tombstones and the overflow state (the
+        // readers that see a zeroed slot treat it as a miss which is valid as
+        // there is no live id in the index)
+        //
+        for (UINT32 i = 0; i < ((UINT32)1 << Index->Bits); i++)
+        {
+            InterlockedExchange((volatile LONG *)&Entries[i].Id, (LONG)NULL_ZERO);
+        }
+
+        Index->OccupiedSlots = 0;
+        Index->Overflowed    = FALSE;
+    }
+}
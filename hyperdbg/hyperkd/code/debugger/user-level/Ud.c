@@ -88,6 +88,11 @@ UdUninitializeUserDebugger()
         // thread debugging details
         //
         AttachingRemoveAndFreeAllProcessDebuggingDetails();
+
+        //
+        // Free the thread id and process id indexes
+        //
+        ThreadHolderFreeIndexes();
     }
 }
 
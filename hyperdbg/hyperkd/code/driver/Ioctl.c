@@ -40,6 +40,9 @@ DrvDispatchIoControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
     PDEBUGGER_PREALLOC_COMMAND                              DebuggerReservePreallocPoolRequest;
     PDEBUGGER_PREACTIVATE_COMMAND                           DebuggerPreactivationRequest;
     PDEBUGGER_APIC_REQUEST                                  DebuggerApicRequest;
+    PDEBUGGER_VMEXIT_PROFILER_REQUEST                       DebuggerVmexitProfilerRequest;
+    PDEBUGGER_DIRTY_PAGES_REQUEST                           DebuggerDirtyPagesRequest;
+    PDEBUGGER_SNAPSHOT_REQUEST                              DebuggerSnapshotRequest;
     PDEBUGGER_UD_COMMAND_PACKET                             DebuggerUdCommandRequest;
     PUSERMODE_LOADED_MODULE_DETAILS                         DebuggerUsermodeModulesRequest;
     PDEBUGGER_QUERY_ACTIVE_PROCESSES_OR_THREADS             DebuggerUsermodeProcessOrThreadQueryRequest;
@@ -577,10 +580,10 @@ DrvDispatchIoControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
             OutBuffLength = IrpStack->Parameters.DeviceIoControl.OutputBufferLength;
 
             //
-            // The OutBuffLength should have at least MaximumSearchResults * sizeof(UINT64)
-            // free space to store the results
+            // The OutBuffLength should have enough space to store the result of
+            // the search (the results themselves are sent as messages)
             //
-            if (!InBuffLength || OutBuffLength < MaximumSearchResults * sizeof(UINT64))
+            if (!InBuffLength || OutBuffLength < sizeof(DEBUGGEE_RESULT_OF_SEARCH_PACKET))
             {
                 Status = STATUS_INVALID_PARAMETER;
                 break;
@@ -595,7 +598,7 @@ DrvDispatchIoControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
             // Here we should validate whether the input parameter is
             // valid or in other words whether we received enough space or not
             //
-            if (IrpStack->Parameters.DeviceIoControl.InputBufferLength != SIZEOF_DEBUGGER_SEARCH_MEMORY + DebuggerSearchMemoryRequest->CountOf64Chunks * sizeof(UINT64))
+            if (IrpStack->Parameters.DeviceIoControl.InputBufferLength != SIZEOF_DEBUGGER_SEARCH_MEMORY + 2 * DebuggerSearchMemoryRequest->CountOf64Chunks * sizeof(UINT64))
             {
                 Status = STATUS_INVALID_PARAMETER;
                 break;
@@ -603,23 +606,15 @@ DrvDispatchIoControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
 
             //
             // Both usermode and to send to usermode and the coming buffer are
-            // at the same place
+            // at the same place, the result of the search is written at the
+            // start of the buffer
             //
-            if (DebuggerCommandSearchMemory(DebuggerSearchMemoryRequest) != STATUS_SUCCESS)
-            {
-                //
-                // It is because it was not valid in any of the ways to the function
-                // then we're sure that the usermode code won't interpret it's previous
-                // buffer as a valid buffer and will not show it to the user
-                //
-                RtlZeroMemory(DebuggerSearchMemoryRequest, MaximumSearchResults * sizeof(UINT64));
-            }
+            DebuggerCommandSearchMemory(DebuggerSearchMemoryRequest);
 
             //
-            // Configure IRP status, and also we send the results
-            // buffer, with it's null values (if any)
+            // Configure IRP status, and also we send the result of the search
             //
-            Irp->IoStatus.Information = MaximumSearchResults * sizeof(UINT64);
+            Irp->IoStatus.Information = sizeof(DEBUGGEE_RESULT_OF_SEARCH_PACKET);
             Status                    = STATUS_SUCCESS;
 
             //
@@ -1148,6 +1143,148 @@ DrvDispatchIoControl(PDEVICE_OBJECT DeviceObject, PIRP Irp)
 
             break;
 
+        case IOCTL_PERFORM_ACTIONS_ON_VMEXIT_PROFILER:
+
+            //
+            // First validate the parameters.
+            //
+            if (IrpStack->Parameters.DeviceIoControl.InputBufferLength < SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST || Irp->AssociatedIrp.SystemBuffer == NULL)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                LogError("Err, invalid parameter to IOCTL dispatcher");
+                break;
+            }
+
+            InBuffLength  = IrpStack->Parameters.DeviceIoControl.InputBufferLength;
+            OutBuffLength = IrpStack->Parameters.DeviceIoControl.OutputBufferLength;
+
+            if (!InBuffLength || !OutBuffLength)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            //
+            // Both usermode and to send to usermode and the coming buffer are
+            // at the same place
+            //
+            DebuggerVmexitProfilerRequest = (PDEBUGGER_VMEXIT_PROFILER_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+
+            //
+            // The results of queries are stored after the request, so the output
+            // buffer should be big enough to hold them
+            //
+            if (DebuggerVmexitProfilerRequest->RequestType == DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY &&
+                OutBuffLength < SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST + sizeof(VMEXIT_PROFILER_RESULTS))
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            //
+            // Perform the actions relating to the VM-exit profiler request
+            //
+            Irp->IoStatus.Information = ExtensionCommandPerformActionsForVmexitProfilerRequests(DebuggerVmexitProfilerRequest);
+            Status                    = STATUS_SUCCESS;
+
+            //
+            // Avoid zeroing it
+            //
+            DoNotChangeInformation = TRUE;
+
+            break;
+
+        case IOCTL_PERFORM_ACTIONS_ON_DIRTY_PAGES:
+
+            //
+            // First validate the parameters.
+            //
+            if (IrpStack->Parameters.DeviceIoControl.InputBufferLength < SIZEOF_DEBUGGER_DIRTY_PAGES_REQUEST || Irp->AssociatedIrp.SystemBuffer == NULL)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                LogError("Err, invalid parameter to IOCTL dispatcher");
+                break;
+            }
+
+            InBuffLength  = IrpStack->Parameters.DeviceIoControl.InputBufferLength;
+            OutBuffLength = IrpStack->Parameters.DeviceIoControl.OutputBufferLength;
+
+            if (!InBuffLength || !OutBuffLength)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            //
+            // Both usermode and to send to usermode and the coming buffer are
+            // at the same place
+            //
+            DebuggerDirtyPagesRequest = (PDEBUGGER_DIRTY_PAGES_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+
+            //
+            // The collected pages are stored after the request, so the output
+            // buffer should be big enough to hold the maximum number of entries
+            //
+            if (DebuggerDirtyPagesRequest->RequestType == DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_COLLECT &&
+                OutBuffLength < SIZEOF_DEBUGGER_DIRTY_PAGES_REQUEST + (DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES * sizeof(DEBUGGER_DIRTY_PAGES_ENTRY)))
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            //
+            // Perform the actions relating to the dirty pages request
+            //
+            Irp->IoStatus.Information = ExtensionCommandPerformActionsForDirtyPagesRequests(DebuggerDirtyPagesRequest, FALSE);
+            Status                    = STATUS_SUCCESS;
+
+            //
+            // Avoid zeroing it
+            //
+            DoNotChangeInformation = TRUE;
+
+            break;
+
+        case IOCTL_PERFORM_ACTIONS_ON_SNAPSHOT:
+
+            //
+            // First validate the parameters.
+            //
+            if (IrpStack->Parameters.DeviceIoControl.InputBufferLength < SIZEOF_DEBUGGER_SNAPSHOT_REQUEST || Irp->AssociatedIrp.SystemBuffer == NULL)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                LogError("Err, invalid parameter to IOCTL dispatcher");
+                break;
+            }
+
+            InBuffLength  = IrpStack->Parameters.DeviceIoControl.InputBufferLength;
+            OutBuffLength = IrpStack->Parameters.DeviceIoControl.OutputBufferLength;
+
+            if (!InBuffLength || OutBuffLength < SIZEOF_DEBUGGER_SNAPSHOT_REQUEST)
+            {
+                Status = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            //
+            // Both usermode and to send to usermode and the coming buffer are
+            // at the same place
+            //
+            DebuggerSnapshotRequest = (PDEBUGGER_SNAPSHOT_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+
+            //
+            // Perform the actions relating to the snapshot request
+            //
+            Irp->IoStatus.Information = ExtensionCommandPerformActionsForSnapshotRequests(DebuggerSnapshotRequest, FALSE);
+            Status                    = STATUS_SUCCESS;
+
+            //
+            // Avoid zeroing it
+            //
+            DoNotChangeInformation = TRUE;
+
+            break;
+
         case IOCTL_SEND_USER_DEBUGGER_COMMANDS:
 
             //
@@ -86,3 +86,21 @@ HaltedBroadcastDisableMov2DrExitingForClearingDrEventsAllCores();
 
 VOID
 HaltedBroadcastDisableMov2CrExitingForClearingCrEventsAllCores(DEBUGGER_EVENT_OPTIONS * BroadcastingOption);
+
+VOID
+HaltedBroadcastEnableDirtyLoggingAllCores();
+
+VOID
+HaltedBroadcastDisableDirtyLoggingAllCores();
+
+VOID
+HaltedBroadcastFlushDirtyLoggingBufferAllCores();
+
+VOID
+HaltedBroadcastSnapshotProtectPagesAllCores();
+
+VOID
+HaltedBroadcastSnapshotUnprotectPagesAllCores();
+
+VOID
+HaltedBroadcastSnapshotRestorePagesAllCores();
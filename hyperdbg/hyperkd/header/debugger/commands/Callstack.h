@@ -15,8 +15,23 @@
 //				     Functions		      		//
 //////////////////////////////////////////////////
 
+static BOOLEAN
+CallstackUnwindReadMemory(UINT64 Address, PVOID Buffer, UINT32 Size);
+
+static BOOLEAN
+CallstackFillFrame(PDEBUGGER_SINGLE_CALLSTACK_FRAME Frame,
+                   UINT64                           StackAddress,
+                   UINT16                           AddressMode);
+
+static UINT32
+CallstackUnwindFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
+                      UINT64                           StackBaseAddress,
+                      UINT32                           FrameCount,
+                      GUEST_REGS *                     Regs,
+                      UINT64                           Rip);
+
 BOOLEAN
-CallstackWalkthroughStack(PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
-                          UINT64                           StackBaseAddress,
-                          UINT32                           Size,
-                          BOOLEAN                          Is32Bit);
+CallstackWalkthroughStack(PDEBUGGER_CALLSTACK_REQUEST      CallstackRequest,
+                          PDEBUGGER_SINGLE_CALLSTACK_FRAME AddressToSaveFrames,
+                          GUEST_REGS *                     Regs,
+                          UINT64                           Rip);
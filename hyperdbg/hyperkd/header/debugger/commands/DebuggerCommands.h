@@ -57,8 +57,7 @@ NTSTATUS
 DebuggerCommandPreactivateFunctionality(PDEBUGGER_PREACTIVATE_COMMAND PreactivateRequest);
 
 BOOLEAN
-SearchAddressWrapper(PUINT64                 AddressToSaveResults,
-                     PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
+SearchAddressWrapper(PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
                      UINT64                  StartAddress,
                      UINT64                  EndAddress,
                      BOOLEAN                 IsDebuggeePaused,
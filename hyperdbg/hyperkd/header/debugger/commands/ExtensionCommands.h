@@ -89,3 +89,12 @@ ExtensionCommandDisableMov2ControlRegsExitingForClearingEventsAllCores(PDEBUGGER
 
 VOID
 ExtensionCommandPcitree(PDEBUGGEE_PCITREE_REQUEST_RESPONSE_PACKET PcitreePacket, BOOLEAN OperateOnVmxRoot);
+
+UINT32
+ExtensionCommandPerformActionsForVmexitProfilerRequests(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest);
+
+UINT32
+ExtensionCommandPerformActionsForDirtyPagesRequests(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, BOOLEAN OperateOnVmxRoot);
+
+UINT32
+ExtensionCommandPerformActionsForSnapshotRequests(PDEBUGGER_SNAPSHOT_REQUEST SnapshotRequest, BOOLEAN OperateOnVmxRoot);
@@ -0,0 +1,115 @@
+/**
+ * @file MemorySearch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers of the page-based memory search engine (s* commands)
+ * @details
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Shows that the pattern doesn't have any byte without wildcard
+ *
+ */
+#define MEMORY_SEARCH_NO_ANCHOR 0xffffffff
+
+/**
+ * @brief Each byte of a 64-bit word is set to 0x01 (used for detecting
+ * matching bytes in a word)
+ *
+ */
+#define MEMORY_SEARCH_LOW_BITS 0x0101010101010101ull
+
+/**
+ * @brief Each byte of a 64-bit word is set to 0x80 (used for detecting
+ * matching bytes in a word)
+ *
+ */
+#define MEMORY_SEARCH_HIGH_BITS 0x8080808080808080ull
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The compiled search pattern
+ * @details Each chunk of the pattern is stored in a separate 64-bit value
+ * (the same as the request) so the bytes are accessed in-place without
+ * copying the pattern
+ *
+ */
+typedef struct _MEMORY_SEARCH_PATTERN
+{
+    PUCHAR Values;             // Values of chunks (each chunk in a 64-bit value)
+    PUCHAR Masks;              // Masks of chunks (each chunk in a 64-bit value)
+    UINT32 ChunkSize;          // Size of each chunk (1, 2, 4, or 8)
+    UINT32 ChunkShift;         // Log2 of the chunk size
+    UINT32 Length;             // Length of the pattern in bytes
+    UINT32 FirstAnchor;        // Offset of the first byte without wildcard
+    UINT32 LastAnchor;         // Offset of the last byte without wildcard
+    UINT64 FirstAnchorBytes;   // The first anchor byte repeated in each byte of a word
+    UINT64 LastAnchorBytes;    // The last anchor byte repeated in each byte of a word
+    UINT64 CandidateBytesMask; // High bit of bytes of a word which are aligned to the chunk size
+
+} MEMORY_SEARCH_PATTERN, *PMEMORY_SEARCH_PATTERN;
+
+/**
+ * @brief The state of a search
+ *
+ */
+typedef struct _MEMORY_SEARCH_CONTEXT
+{
+    MEMORY_SEARCH_PATTERN       Pattern;
+    DEBUGGER_SEARCH_MEMORY_TYPE MemoryType;
+    BOOLEAN                     IsDebuggeePaused;
+    UINT64                      StartAddress;
+    UINT64                      EndAddress;
+    UINT32                      CountOfResults;
+    UINT32                      CountOfPresentPages;
+
+} MEMORY_SEARCH_CONTEXT, *PMEMORY_SEARCH_CONTEXT;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static BOOLEAN
+MemorySearchCompilePattern(PDEBUGGER_SEARCH_MEMORY SearchMemRequest, PMEMORY_SEARCH_PATTERN Pattern);
+
+static BOOLEAN
+MemorySearchIsPagePresent(PMEMORY_SEARCH_CONTEXT Context, UINT64 PageAddress);
+
+static BOOLEAN
+MemorySearchCompareSlow(PMEMORY_SEARCH_CONTEXT Context, UINT64 Address);
+
+static VOID
+MemorySearchCheckCandidate(PMEMORY_SEARCH_CONTEXT Context, PUCHAR Window, UINT64 WindowAddress, UINT64 WindowSize, UINT64 Offset);
+
+static VOID
+MemorySearchScanPage(PMEMORY_SEARCH_CONTEXT Context, PUCHAR Window, UINT64 PageAddress, UINT64 WindowSize);
+
+//////////////////////////////////////////////////
+//					Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+MemorySearchInitialize();
+
+VOID
+MemorySearchUninitialize();
+
+BOOLEAN
+MemorySearchPerform(PDEBUGGER_SEARCH_MEMORY SearchMemRequest,
+                    UINT64                  StartAddress,
+                    UINT64                  EndAddress,
+                    BOOLEAN                 IsDebuggeePaused,
+                    PUINT32                 CountOfMatchedCases);
@@ -186,6 +186,42 @@
  */
 #define DEBUGGER_HALTED_CORE_TASK_DISABLE_MOV_TO_CR_EXITING_ONLY_FOR_CR_EVENTS 0x0000001c
 
+/**
+ * @brief Halted core task for enabling the dirty logging mechanism (PML)
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_ENABLE_DIRTY_LOGGING 0x0000001d
+
+/**
+ * @brief Halted core task for disabling the dirty logging mechanism (PML)
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_DISABLE_DIRTY_LOGGING 0x0000001e
+
+/**
+ * @brief Halted core task for flushing the PML buffer into the dirty bitmap
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_FLUSH_DIRTY_LOGGING_BUFFER 0x0000001f
+
+/**
+ * @brief Halted core task for write-protecting the pages of the memory snapshot
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_PROTECT_PAGES 0x00000020
+
+/**
+ * @brief Halted core task for removing the write protection of the pages of the memory snapshot
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_UNPROTECT_PAGES 0x00000021
+
+/**
+ * @brief Halted core task for restoring the modified pages of the memory snapshot
+ *
+ */
+#define DEBUGGER_HALTED_CORE_TASK_SNAPSHOT_RESTORE_PAGES 0x00000022
+
 //////////////////////////////////////////////////
 //			    	 Functions  	      		//
 //////////////////////////////////////////////////
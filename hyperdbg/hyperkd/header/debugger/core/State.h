@@ -158,31 +158,60 @@ typedef struct _DATE_TIME_HOLDER
 /**
  * @brief Saves the debugger state
  * @details Each logical processor contains one of this structure which describes about the
- * state of debuggers, flags, etc.
+ * state of debuggers, flags, etc. The fields that are used on every event are placed in the
+ * first cache line, the fields that are written by other cores (locking and halting) are
+ * placed in a separate cache line, and the rarely used fields are placed after them
  *
  */
-typedef struct _PROCESSOR_DEBUGGING_STATE
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _PROCESSOR_DEBUGGING_STATE
 {
-    volatile LONG                              Lock;
-    volatile BOOLEAN                           MainDebuggingCore;
-    GUEST_REGS *                               Regs;
-    UINT32                                     CoreId;
-    BOOLEAN                                    ShortCircuitingEvent;
-    BOOLEAN                                    IgnoreDisasmInNextPacket;
+    //
+    // Hot block (used by the current core on every event)
+    //
+    GUEST_REGS *                           Regs;
+    UINT64 *                               ScriptEngineCoreSpecificStackBuffer;
+    PDEBUGGEE_BP_DESCRIPTOR                SoftwareBreakpointState;
+    UINT64                                 HardwareDebugRegisterForStepping;
+    UINT32                                 CoreId;
+    UINT16                                 InstructionLengthHint;
+    DEBUGGEE_INSTRUMENTATION_STEP_IN_TRACE InstrumentationStepInTrace;
+    BOOLEAN                                ShortCircuitingEvent;
+    BOOLEAN                                IgnoreDisasmInNextPacket;
+    BOOLEAN                                DoNotNmiNotifyOtherCoresByThisCore;
+    BOOLEAN                                TracingMode; // Indicate that the target processor is on the tracing mode or not
+    BOOLEAN                                BreakStarterCore;
+
+    //
+    // Shared block (written by other cores while halting and locking the cores)
+    //
+    DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE)
+    volatile LONG             Lock;
+    volatile BOOLEAN          MainDebuggingCore;
+    KD_NMI_STATE              NmiState;
+    DEBUGGEE_HALTED_CORE_TASK HaltedCoreTask;
+
+    //
+    // Cold storage
+    //
+    DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE)
     PROCESSOR_DEBUGGING_MSR_READ_OR_WRITE      MsrState;
     DATE_TIME_HOLDER                           DateTimeHolder;
-    PDEBUGGEE_BP_DESCRIPTOR                    SoftwareBreakpointState;
-    DEBUGGEE_INSTRUMENTATION_STEP_IN_TRACE     InstrumentationStepInTrace;
-    BOOLEAN                                    DoNotNmiNotifyOtherCoresByThisCore;
-    BOOLEAN                                    TracingMode; // Indicate that the target processor is on the tracing mode or not
     DEBUGGEE_PROCESS_OR_THREAD_TRACING_DETAILS ThreadOrProcessTracingDetails;
-    KD_NMI_STATE                               NmiState;
-    DEBUGGEE_HALTED_CORE_TASK                  HaltedCoreTask;
-    BOOLEAN                                    BreakStarterCore;
-    UINT16                                     InstructionLengthHint;
-    UINT64                                     HardwareDebugRegisterForStepping;
-    UINT64 *                                   ScriptEngineCoreSpecificStackBuffer;
     PKDPC                                      KdDpcObject;                       // DPC object to be used in kernel debugger
     CHAR                                       KdRecvBuffer[MaxSerialPacketSize]; // Used for debugging buffers (receiving buffers from serial devices)
 
 } PROCESSOR_DEBUGGING_STATE, PPROCESSOR_DEBUGGING_STATE;
+
+//////////////////////////////////////////////////
+//				  Layout Assertions				//
+//////////////////////////////////////////////////
+
+static_assert(FIELD_OFFSET(PROCESSOR_DEBUGGING_STATE, BreakStarterCore) < CPU_CACHE_LINE_SIZE,
+              "err (static_assert), hot fields of PROCESSOR_DEBUGGING_STATE should fit in one cache line");
+
+static_assert(FIELD_OFFSET(PROCESSOR_DEBUGGING_STATE, Lock) % CPU_CACHE_LINE_SIZE == 0 &&
+                  FIELD_OFFSET(PROCESSOR_DEBUGGING_STATE, HaltedCoreTask) + sizeof(DEBUGGEE_HALTED_CORE_TASK) <= 2 * CPU_CACHE_LINE_SIZE,
+              "err (static_assert), shared fields of PROCESSOR_DEBUGGING_STATE should be in a separate cache line");
+
+static_assert(sizeof(PROCESSOR_DEBUGGING_STATE) % CPU_CACHE_LINE_SIZE == 0,
+              "err (static_assert), size of PROCESSOR_DEBUGGING_STATE should be a multiple of the cache line size");
@@ -0,0 +1,93 @@
+/**
+ * @file EventCosts.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers of accounting the costs of triggered events
+ * @details
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of events that their costs are tracked
+ * at the same time on each core
+ *
+ */
+#define EVENT_COSTS_MAXIMUM_EVENTS 512
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The costs of an event on a single core
+ * @details The histogram of the handling time is only filled while the
+ * VM-exit profiler is collecting the events
+ *
+ */
+typedef struct _EVENT_COSTS_SLOT
+{
+    UINT64                    Tag;
+    DEBUGGER_EVENT_COSTS      Costs;
+    VMEXIT_PROFILER_HISTOGRAM Histogram;
+
+} EVENT_COSTS_SLOT, *PEVENT_COSTS_SLOT;
+
+/**
+ * @brief Per-core costs of the events
+ * @details Each core only writes into its own structure, so no lock
+ * is needed for recording the costs and cores won't share cache lines
+ *
+ */
+typedef struct DECLSPEC_ALIGN(CPU_CACHE_LINE_SIZE) _EVENT_COSTS_CORE_DATA
+{
+    UINT64           UntrackedTriggers; // Triggers of the events that their slot is owned by another event
+    EVENT_COSTS_SLOT Slots[EVENT_COSTS_MAXIMUM_EVENTS];
+
+} EVENT_COSTS_CORE_DATA, *PEVENT_COSTS_CORE_DATA;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static EVENT_COSTS_SLOT *
+EventCostsGetSlot(UINT32 CoreId, UINT64 Tag);
+
+static VOID
+EventCostsReportHistogram(VMEXIT_PROFILER_RESULTS * Results, UINT64 Tag, VMEXIT_PROFILER_HISTOGRAM * Histogram);
+
+//////////////////////////////////////////////////
+//					Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+EventCostsInitialize();
+
+VOID
+EventCostsUninitialize();
+
+VOID
+EventCostsRecordTrigger(UINT32 CoreId, UINT64 Tag, BOOLEAN ConditionMet, UINT64 Cycles);
+
+VOID
+EventCostsRecordScriptInstructions(UINT32 CoreId, UINT64 Tag, UINT64 InstructionCount);
+
+VOID
+EventCostsClear(UINT64 Tag);
+
+VOID
+EventCostsQuery(UINT64 Tag, DEBUGGER_EVENT_COSTS * Costs);
+
+VOID
+EventCostsResetHistograms();
+
+VOID
+EventCostsQueryHistograms(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results);
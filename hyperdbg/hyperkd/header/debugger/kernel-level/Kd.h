@@ -132,12 +132,6 @@ KdReloadSymbolDetailsInDebuggee(_In_ PDEBUGGEE_SYMBOL_REQUEST_PACKET SymPacket);
 static VOID
 KdNotifyDebuggeeForUserInput(DEBUGGEE_USER_INPUT_PACKET * Descriptor, UINT32 Len);
 
-static VOID
-KdGuaranteedStepInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
-
-static VOID
-KdRegularStepInInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
-
 static VOID
 KdRegularStepOver(PROCESSOR_DEBUGGING_STATE * DbgState, BOOLEAN IsNextInstructionACall, UINT32 CallLength);
 
@@ -236,6 +230,12 @@ KdCheckGuestOperatingModeChanges(UINT16 PreviousCsSelector, UINT16 CurrentCsSele
 BOOLEAN
 KdIsGuestOnUsermode32Bit();
 
+VOID
+KdGuaranteedStepInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
+
+VOID
+KdRegularStepInInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
+
 VOID
 KdHandleNmiBroadcastDebugBreaks(UINT32 CoreId, BOOLEAN IsOnVmxNmiHandler);
 
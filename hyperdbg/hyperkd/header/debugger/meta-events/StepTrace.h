@@ -0,0 +1,154 @@
+/**
+ * @file StepTrace.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers of the batched steps (t, p, and i commands with records)
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the buffer of records (the chunk header and the records)
+ * which is sent to the debugger in one packet
+ *
+ */
+#define STEP_TRACE_BUFFER_SIZE (MaxSerialPacketSize - sizeof(DEBUGGER_REMOTE_PACKET) - SERIAL_END_OF_BUFFER_CHARS_COUNT)
+
+/**
+ * @brief Maximum number of return addresses in the shadow call stack of
+ * each core (deeper calls are only counted)
+ *
+ */
+#define STEP_TRACE_SHADOW_STACK_SIZE 256
+
+/**
+ * @brief Maximum number of instructions that are stepped inside a call in
+ * the step-over before the debuggee is halted (e.g., the call never returns)
+ *
+ */
+#define STEP_TRACE_MAXIMUM_STEPS_IN_CALL 0x100000
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The shadow call stack of each core which is used for computing
+ * the depth of the 'call' and the 'ret' records
+ *
+ */
+typedef struct _STEP_TRACE_SHADOW_STACK
+{
+    UINT32 Depth;
+    UINT64 ReturnAddresses[STEP_TRACE_SHADOW_STACK_SIZE];
+
+} STEP_TRACE_SHADOW_STACK, *PSTEP_TRACE_SHADOW_STACK;
+
+/**
+ * @brief The state of the batched steps
+ * @details Only one thread (or one core in the case of the instrumentation
+ * step-in) is stepped at a time
+ *
+ */
+typedef struct _STEP_TRACE_STATE
+{
+    volatile LONG                    Lock;
+    volatile BOOLEAN                 IsActive;
+    DEBUGGER_REMOTE_STEPPING_REQUEST StepType;
+    UINT32                           CoreId;    // Only used in the instrumentation step-in
+    UINT32                           ProcessId; // Only used in the regular step-in and step-over
+    UINT32                           ThreadId;  // Only used in the regular step-in and step-over
+    UINT32                           RemainingSteps;
+    UINT64                           StepNumber;
+    DEBUGGER_STEP_TRACE_RECORD_TYPE  RecordType;
+    UINT32                           RegisterMask;
+    UINT32                           RecordSize;
+    BOOLEAN                          StopAtAddress;
+    UINT64                           StopAddress;
+    BOOLEAN                          IsCompleted;
+
+    //
+    // Step-over of calls (calls are stepped-in, but no record is saved
+    // until the call returns)
+    //
+    BOOLEAN IsSteppingOverCall;
+    UINT64  CallReturnAddress;
+    UINT64  CallStackPointer;
+    UINT32  StepsInCall;
+
+    //
+    // The 'call' or the 'ret' which is executed by the current step (only
+    // used in the call/ret records, the target is known after the step)
+    //
+    BOOLEAN HasPendingEdge;
+    BOOLEAN IsPendingEdgeRet;
+    UINT64  PendingEdgeAddress;
+    UINT64  PendingEdgeReturnAddress;
+
+    //
+    // The current chunk of records
+    //
+    BOOLEAN Is32Bit;
+    UINT32  ChunkCoreId;
+    UINT32  CountOfRecords;
+    UINT64  FirstStepNumber;
+    BYTE *  Buffer;
+
+    //
+    // Shadow call stacks (one for each core)
+    //
+    STEP_TRACE_SHADOW_STACK * ShadowStacks;
+
+} STEP_TRACE_STATE, *PSTEP_TRACE_STATE;
+
+//////////////////////////////////////////////////
+//				Private Interfaces				//
+//////////////////////////////////////////////////
+
+static UINT32
+StepTraceGetRecordSize(DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType, UINT32 RegisterMask);
+
+static VOID
+StepTraceArmStep(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip);
+
+static VOID
+StepTraceFlushRecords(BOOLEAN IsLastChunk);
+
+static BYTE *
+StepTraceAllocateRecord(UINT32 CoreId, BOOLEAN Is32Bit);
+
+static VOID
+StepTraceSaveRecord(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip);
+
+static VOID
+StepTraceCheckEdge(UINT64 Rip);
+
+static VOID
+StepTraceSaveEdgeRecord(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 Rip);
+
+//////////////////////////////////////////////////
+//					Functions					//
+//////////////////////////////////////////////////
+
+BOOLEAN
+StepTraceInitialize();
+
+VOID
+StepTraceUninitialize();
+
+BOOLEAN
+StepTraceStart(PROCESSOR_DEBUGGING_STATE * DbgState, PDEBUGGEE_STEP_PACKET StepPacket);
+
+BOOLEAN
+StepTraceHandleStep(PROCESSOR_DEBUGGING_STATE * DbgState, BOOLEAN IsInstrumentationStep);
+
+VOID
+StepTraceFinish();
@@ -31,10 +31,11 @@ volatile LONG VmxRootThreadHoldingLock;
  */
 typedef struct _USERMODE_DEBUGGING_THREAD_DETAILS
 {
-    UINT32                     ThreadId;
-    UINT64                     ThreadRip; // if IsPaused is TRUE
-    BOOLEAN                    IsPaused;
-    DEBUGGER_UD_COMMAND_ACTION UdAction[MAX_USER_ACTIONS_FOR_THREADS];
+    UINT32                              ThreadId;
+    UINT64                              ThreadRip; // if IsPaused is TRUE
+    BOOLEAN                             IsPaused;
+    DEBUGGER_UD_COMMAND_ACTION          UdAction[MAX_USER_ACTIONS_FOR_THREADS];
+    PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDetails; // owner process (set before the thread is indexed)
 
 } USERMODE_DEBUGGING_THREAD_DETAILS, *PUSERMODE_DEBUGGING_THREAD_DETAILS;
 
@@ -53,9 +54,29 @@ typedef struct _USERMODE_DEBUGGING_THREAD_HOLDER
 //				      Functions     			//
 //////////////////////////////////////////////////
 
+// ----------------------------------------------------------------------------
+// Private Interfaces
+//
+
+static BOOLEAN
+ThreadHolderAllocateIndex(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Bits);
+
+// ----------------------------------------------------------------------------
+// Public Interfaces
+//
+
 VOID
 ThreadHolderAllocateThreadHoldingBuffers();
 
+VOID
+ThreadHolderFreeIndexes();
+
+VOID
+ThreadHolderInsertProcessToIndex(PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail);
+
+BOOLEAN
+ThreadHolderLookupProcessIndex(UINT32 ProcessId, PUSERMODE_DEBUGGING_PROCESS_DETAILS * ProcessDebuggingDetail);
+
 BOOLEAN
 ThreadHolderAssignThreadHolderToProcessDebuggingDetails(PUSERMODE_DEBUGGING_PROCESS_DETAILS ProcessDebuggingDetail);
 
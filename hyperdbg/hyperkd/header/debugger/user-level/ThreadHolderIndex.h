@@ -0,0 +1,97 @@
+/**
+ * @file ThreadHolderIndex.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers of the thread id and process id indexes of the thread holder
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				      Constants     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of bits of the thread id index (2^14 slots)
+ *
+ */
+#define THREAD_HOLDER_THREAD_INDEX_BITS 14
+
+/**
+ * @brief Number of bits of the process id index (2^8 slots)
+ *
+ */
+#define THREAD_HOLDER_PROCESS_INDEX_BITS 8
+
+/**
+ * @brief Id of the slots that are removed from the index
+ * @details Windows thread and process ids are multiples of four, so
+ * this value never collides with a valid id
+ *
+ */
+#define THREAD_HOLDER_INDEX_TOMBSTONE 0xffffffff
+
+/**
+ * @brief Hash of thread ids and process ids (Fibonacci hashing)
+ * @details the two low bits are ignored as they're always zero
+ *
+ */
+#define THREAD_HOLDER_INDEX_HASH(Id, Bits) ((UINT32)(((UINT32)(Id) >> 2) * 0x9E3779B1) >> (32 - (Bits)))
+
+//////////////////////////////////////////////////
+//				      Structures     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Each slot of the thread id and process id indexes
+ * @details the details are published with a single pointer-sized store, the
+ * owner process of the thread details is kept in the thread details itself
+ *
+ */
+typedef struct _USERMODE_DEBUGGING_INDEX_ENTRY
+{
+    volatile UINT32 Id;      // 0 means empty, THREAD_HOLDER_INDEX_TOMBSTONE means removed
+    PVOID volatile  Details; // thread details (thread index) or process details (process index)
+
+} USERMODE_DEBUGGING_INDEX_ENTRY, *PUSERMODE_DEBUGGING_INDEX_ENTRY;
+
+/**
+ * @brief Pre-allocated open-addressing hash index for thread ids or process ids
+ * @details Insertions and removals are serialized by VmxRootThreadHoldingLock while
+ * lookups are lock-free, if the index is overflowed (or not allocated), the callers
+ * should fall back to walking the lists
+ *
+ */
+typedef struct _USERMODE_DEBUGGING_INDEX
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY volatile Entries;
+    UINT32                                   Bits;
+    UINT32                                   OccupiedSlots; // live entries plus tombstones
+    UINT32                                   LiveSlots;
+    BOOLEAN                                  Overflowed;
+    volatile LONG                            ActiveReaders; // lock-free lookups that might still access the entries
+
+} USERMODE_DEBUGGING_INDEX, *PUSERMODE_DEBUGGING_INDEX;
+
+//////////////////////////////////////////////////
+//				      Functions     			//
+//////////////////////////////////////////////////
+
+VOID
+ThreadHolderIndexInitialize(PUSERMODE_DEBUGGING_INDEX Index, PUSERMODE_DEBUGGING_INDEX_ENTRY Entries, UINT32 Bits);
+
+PUSERMODE_DEBUGGING_INDEX_ENTRY
+ThreadHolderIndexDetach(PUSERMODE_DEBUGGING_INDEX Index);
+
+BOOLEAN
+ThreadHolderIndexLookup(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID * Details);
+
+BOOLEAN
+ThreadHolderIndexInsert(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID Details);
+
+VOID
+ThreadHolderIndexRemove(PUSERMODE_DEBUGGING_INDEX Index, UINT32 Id, PVOID Details);
@@ -47,6 +47,19 @@ BOOLEAN g_AllowIOCTLFromUsermode;
  */
 DEBUGGER_CORE_EVENTS * g_Events;
 
+/**
+ * @brief Per-core costs of the events
+ *
+ */
+EVENT_COSTS_CORE_DATA * g_EventCosts;
+
+/**
+ * @brief Shows whether the costs of the triggered events are accounted
+ * or not
+ *
+ */
+volatile BOOLEAN g_EventCostsEnabled;
+
 /**
  * @brief Holds the requests to pause the break of debuggee until
  * a special event happens
@@ -151,6 +164,18 @@ BOOLEAN g_IsWaitingForReturnAndRunFromPageFault;
  */
 LIST_ENTRY g_ProcessDebuggingDetailsListHead;
 
+/**
+ * @brief Thread id index of the threads of the debugging processes
+ *
+ */
+USERMODE_DEBUGGING_INDEX g_ThreadHolderThreadIndex;
+
+/**
+ * @brief Process id index of the debugging processes
+ *
+ */
+USERMODE_DEBUGGING_INDEX g_ThreadHolderProcessIndex;
+
 /**
  * @brief Whether the thread attaching mechanism is waiting for #DB or not
  *
@@ -164,3 +189,43 @@ BOOLEAN g_IsWaitingForUserModeProcessEntryToBeCalled;
  *
  */
 BOOLEAN g_InterceptBreakpointsAndEventsForCommandsInRemoteComputer;
+
+/**
+ * @brief Shows whether the handling time of the triggered events should
+ * be reported to the VM-exit profiler or not
+ *
+ */
+volatile BOOLEAN g_VmexitProfilerEventsEnabled;
+
+/**
+ * @brief Shows whether the dirty pages are logged (PML is enabled on
+ * all cores) or not
+ *
+ */
+BOOLEAN g_DirtyPagesLoggingStarted;
+
+/**
+ * @brief The buffer of the memory search engine (current page and the next
+ * page) which is used when the debuggee is paused
+ *
+ */
+UCHAR * g_MemorySearchBuffer;
+
+/**
+ * @brief The state (and the cached unwind tables) of the unwinder of
+ * the callstack command
+ *
+ */
+UNWIND_STATE g_CallstackUnwindState;
+
+/**
+ * @brief The lock of the state of the unwinder of the callstack command
+ *
+ */
+volatile LONG g_CallstackUnwindStateLock;
+
+/**
+ * @brief The state (and the buffer of records) of the batched steps
+ *
+ */
+STEP_TRACE_STATE g_StepTraceState;
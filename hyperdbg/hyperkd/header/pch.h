@@ -81,6 +81,11 @@
 //
 #include "components/spinlock/header/Spinlock.h"
 
+//
+// Unwinder component
+//
+#include "components/unwind/header/Unwind.h"
+
 //
 // Platform independent headers
 //
@@ -117,11 +122,13 @@
 #include "header/debugger/commands/DebuggerCommands.h"
 #include "header/debugger/commands/ExtensionCommands.h"
 #include "header/debugger/commands/Callstack.h"
+#include "header/debugger/commands/MemorySearch.h"
 #include "header/debugger/communication/SerialConnection.h"
 #include "header/debugger/objects/Process.h"
 #include "header/debugger/objects/Thread.h"
 #include "header/debugger/user-level/Attaching.h"
 #include "header/debugger/user-level/UserAccess.h"
+#include "header/debugger/user-level/ThreadHolderIndex.h"
 #include "header/debugger/user-level/ThreadHolder.h"
 #include "header/debugger/core/DebuggerVmcalls.h"
 #include "header/debugger/core/HaltedCore.h"
@@ -144,8 +151,10 @@
 #include "header/debugger/events/ApplyEvents.h"
 #include "header/debugger/events/Termination.h"
 #include "header/debugger/events/DebuggerEvents.h"
+#include "header/debugger/events/EventCosts.h"
 #include "header/debugger/events/ValidateEvents.h"
 #include "header/debugger/meta-events/Tracing.h"
+#include "header/debugger/meta-events/StepTrace.h"
 #include "header/debugger/meta-events/MetaDispatch.h"
 
 //
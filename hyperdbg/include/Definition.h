@@ -79,6 +79,45 @@
  */
 #define TEST_CASE_PARAMETER_FOR_MAIN_COMMAND_PARSER "test-command-parser"
 
+/**
+ * @brief Test case parameter for measuring the performance of the main command parser
+ */
+#define TEST_CASE_PARAMETER_FOR_COMMAND_PARSER_PERFORMANCE "test-command-parser-performance"
+
+/**
+ * @brief Number of iterations of each command for measuring the performance
+ * of the main command parser
+ */
+#define COMMAND_PARSER_PERFORMANCE_ITERATIONS 1000
+
+/**
+ * @brief Test case parameter for measuring the performance of batch scripts
+ */
+#define TEST_CASE_PARAMETER_FOR_SCRIPT_BATCH_PERFORMANCE "test-script-batch-performance"
+
+/**
+ * @brief Address and port of the simulated remote debuggee for measuring
+ * the performance of batch scripts
+ */
+#define SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_IP   "127.0.0.1"
+#define SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_PORT "50100"
+
+/**
+ * @brief Latency of each command in the simulated remote debuggee (in microseconds)
+ */
+#define SCRIPT_BATCH_TEST_SIMULATED_DEBUGGEE_LATENCY 2000
+
+/**
+ * @brief Number of events that are registered by the script for measuring
+ * the performance of batch scripts
+ */
+#define SCRIPT_BATCH_TEST_NUMBER_OF_EVENTS 200
+
+/**
+ * @brief File name of the script for measuring the performance of batch scripts
+ */
+#define SCRIPT_BATCH_TEST_SCRIPT_FILE "hyperdbg-script-batch-test.ds"
+
 /**
  * @brief Test case parameter for testing semantic script tests
  */
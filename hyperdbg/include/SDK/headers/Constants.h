@@ -472,6 +472,12 @@ const unsigned char BuildSignature[] = {
  */
 #define MAXIMUM_CALL_INSTR_SIZE 7
 
+/**
+ * @brief size of the cache line, used to align the per-core structures
+ * to avoid false sharing between cores
+ */
+#define CPU_CACHE_LINE_SIZE 64
+
 //////////////////////////////////////////////////
 //              Symbols Details                 //
 //////////////////////////////////////////////////
@@ -508,7 +514,7 @@ const unsigned char BuildSignature[] = {
 
 /**
  * @brief maximum results that will be returned by !s* s*
- * command
+ * command (the search is stopped after this number of results)
  *
  */
 #define MaximumSearchResults 0x1000
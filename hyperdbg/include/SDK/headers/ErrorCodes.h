@@ -545,6 +545,74 @@
  */
 #define DEBUGGER_ERROR_APIC_ACTIONS_ERROR 0xc0000053
 
+/**
+ * @brief error, could not perform VM-exit profiler actions
+ *
+ */
+#define DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR 0xc0000054
+
+/**
+ * @brief error, logging the dirty pages is not supported (the processor
+ * doesn't support PML)
+ *
+ */
+#define DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_SUPPORTED 0xc0000055
+
+/**
+ * @brief error, logging the dirty pages is not started
+ *
+ */
+#define DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_STARTED 0xc0000056
+
+/**
+ * @brief error, could not perform actions related to the dirty pages
+ *
+ */
+#define DEBUGGER_ERROR_DIRTY_PAGES_ACTIONS_ERROR 0xc0000057
+
+/**
+ * @brief error, the snapshot is already taken
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_IS_ALREADY_TAKEN 0xc0000058
+
+/**
+ * @brief error, the snapshot is not taken
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_IS_NOT_TAKEN 0xc0000059
+
+/**
+ * @brief error, invalid physical range for the snapshot
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_INVALID_RANGE 0xc000005a
+
+/**
+ * @brief error, the pages of the snapshot are not preallocated
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_PAGES_ARE_NOT_PREALLOCATED 0xc000005b
+
+/**
+ * @brief error, the page pool of the snapshot is exhausted (some of the
+ * modified pages are not restored)
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_POOL_EXHAUSTED 0xc000005c
+
+/**
+ * @brief error, could not perform actions related to the snapshot
+ *
+ */
+#define DEBUGGER_ERROR_SNAPSHOT_ACTIONS_ERROR 0xc000005d
+
+/**
+ * @brief error, the buffers of logging the dirty pages are not preallocated
+ *
+ */
+#define DEBUGGER_ERROR_DIRTY_PAGES_BUFFERS_ARE_NOT_PREALLOCATED 0xc000005e
+
 //
 // WHEN YOU ADD ANYTHING TO THIS LIST OF ERRORS, THEN
 // MAKE SURE TO ADD AN ERROR MESSAGE TO ShowErrorMessage(UINT32 Error)
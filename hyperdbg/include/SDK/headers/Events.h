@@ -232,8 +232,25 @@ typedef enum _DEBUGGER_MODIFY_EVENTS_TYPE
     DEBUGGER_MODIFY_EVENTS_ENABLE,
     DEBUGGER_MODIFY_EVENTS_DISABLE,
     DEBUGGER_MODIFY_EVENTS_CLEAR,
+    DEBUGGER_MODIFY_EVENTS_QUERY_COSTS,
+    DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS,
+    DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS,
 } DEBUGGER_MODIFY_EVENTS_TYPE;
 
+/**
+ * @brief costs of handling an event (merged from all the cores)
+ *
+ */
+typedef struct _DEBUGGER_EVENT_COSTS
+{
+    UINT64 TriggerCount;           // Number of times that the event is triggered
+    UINT64 ConditionFalseCount;    // Number of times that the condition of the event is not met
+    UINT64 ScriptInstructionCount; // Number of executed script engine instructions
+    UINT64 Cycles;                 // Number of cycles spent on checking conditions and performing actions
+    UINT64 UntrackedTriggers;      // Number of triggers of all events that are not tracked (too many alive events)
+
+} DEBUGGER_EVENT_COSTS, *PDEBUGGER_EVENT_COSTS;
+
 /**
  * @brief request for modifying events (enable/disable/clear)
  *
@@ -243,8 +260,9 @@ typedef struct _DEBUGGER_MODIFY_EVENTS
     UINT64 Tag;          // Tag of the target event that we want to modify
     UINT64 KernelStatus; // Kernel put the status in this field
     DEBUGGER_MODIFY_EVENTS_TYPE
-    TypeOfAction;      // Determines what's the action (enable | disable | clear)
-    BOOLEAN IsEnabled; // Determines what's the action (enable | disable | clear)
+    TypeOfAction;                   // Determines what's the action (enable | disable | clear)
+    BOOLEAN              IsEnabled; // Determines what's the action (enable | disable | clear)
+    DEBUGGER_EVENT_COSTS Costs;     // If it's a query costs then the costs of the event are put here
 
 } DEBUGGER_MODIFY_EVENTS, *PDEBUGGER_MODIFY_EVENTS;
 
@@ -53,6 +53,62 @@
  */
 #define HWDBG_TEST_WRITE_INSTANCE_INFO_PATH "..\\..\\..\\..\\hwdbg\\src\\test\\bram\\instance_info.hex.txt"
 
+/**
+ * @brief Path to write the sample of the capture configuration requests
+ *
+ */
+#define HWDBG_TEST_WRITE_CAPTURE_CONFIGURATION_PATH "..\\..\\..\\..\\hwdbg\\src\\test\\bram\\capture_configuration.hex.txt"
+
+/**
+ * @brief Path to write the sample of the capture buffer read requests
+ *
+ */
+#define HWDBG_TEST_WRITE_CAPTURE_READ_PATH "..\\..\\..\\..\\hwdbg\\src\\test\\bram\\capture_read.hex.txt"
+
+/**
+ * @brief Path to read the sample of the capture buffer (chunks)
+ *
+ */
+#define HWDBG_TEST_READ_CAPTURE_BUFFER_PATH "..\\..\\..\\..\\hwdbg\\sim\\hwdbg\\DebuggerModuleTestingBRAM\\bram_capture_buffer.txt"
+
+/**
+ * @brief Default path to export the capture buffer (VCD)
+ *
+ */
+#define HWDBG_DEFAULT_CAPTURE_VCD_PATH "hwdbg_capture.vcd"
+
+/**
+ * @brief Extension of binary BRAM images
+ * @details Files with this extension are read and written as binary BRAM
+ * images (HWDBG_BRAM_IMAGE_HEADER) instead of text hex files
+ *
+ */
+#define HWDBG_BRAM_IMAGE_FILE_EXTENSION ".bram"
+
+/**
+ * @brief Magic of binary BRAM images ('BRAM')
+ *
+ */
+#define HWDBG_BRAM_IMAGE_MAGIC 0x4d415242
+
+/**
+ * @brief Version of binary BRAM images
+ *
+ */
+#define HWDBG_BRAM_IMAGE_VERSION 1
+
+/**
+ * @brief Interval of polling the shared BRAM image for the response of hwdbg (in milliseconds)
+ *
+ */
+#define HWDBG_BRAM_IMAGE_POLLING_INTERVAL 1
+
+/**
+ * @brief Maximum time to wait for hwdbg to respond to a packet (in milliseconds)
+ *
+ */
+#define HWDBG_BRAM_IMAGE_RESPONSE_TIMEOUT 10000
+
 //////////////////////////////////////////////////
 //                   Enums                      //
 //////////////////////////////////////////////////
@@ -66,6 +122,8 @@ typedef enum _HWDBG_ACTION_ENUMS
 {
     hwdbgActionSendInstanceInfo      = 1,
     hwdbgActionConfigureScriptBuffer = 2,
+    hwdbgActionConfigureCapture      = 3,
+    hwdbgActionReadCaptureBuffer     = 4,
 
 } HWDBG_ACTION_ENUMS;
 
@@ -78,6 +136,7 @@ typedef enum _HWDBG_RESPONSE_ENUMS
 {
     hwdbgResponseSuccessOrErrorMessage = 1,
     hwdbgResponseInstanceInfo          = 2,
+    hwdbgResponseCaptureBuffer         = 3,
 
 } HWDBG_RESPONSE_ENUMS;
 
@@ -88,11 +147,26 @@ typedef enum _HWDBG_RESPONSE_ENUMS
  */
 typedef enum _HWDBG_SUCCESS_OR_ERROR_ENUMS
 {
-    hwdbgOperationWasSuccessful = 0x7FFFFFFF,
-    hwdbgErrorInvalidPacket     = 1,
+    hwdbgOperationWasSuccessful    = 0x7FFFFFFF,
+    hwdbgErrorInvalidPacket        = 1,
+    hwdbgErrorInvalidCaptureWindow = 2,
 
 } HWDBG_SUCCESS_OR_ERROR_ENUMS;
 
+/**
+ * @brief Different states of the capture buffer in hwdbg
+ * @warning This file should be changed along with hwdbg files
+ *
+ */
+typedef enum _HWDBG_CAPTURE_STATE_ENUMS
+{
+    hwdbgCaptureStateIdle      = 0,
+    hwdbgCaptureStateArmed     = 1,
+    hwdbgCaptureStateTriggered = 2,
+    hwdbgCaptureStateDone      = 3,
+
+} HWDBG_CAPTURE_STATE_ENUMS;
+
 //////////////////////////////////////////////////
 //                   Structures                 //
 //////////////////////////////////////////////////
@@ -175,8 +249,11 @@ typedef struct _HWDBG_INSTANCE_INFORMATION
 
     } scriptCapabilities;
 
-    UINT32 bramAddrWidth; // BRAM address width
-    UINT32 bramDataWidth; // BRAM data width
+    UINT32 bramAddrWidth;                    // BRAM address width
+    UINT32 bramDataWidth;                    // BRAM data width
+    UINT32 maximumNumberOfOperatorsPerStage; // Maximum number of operators (funcs) fused into a single stage
+    UINT32 captureBufferDepth;               // Number of entries of the capture buffer (logic analyzer)
+    UINT32 captureRunLengthWidth;            // Width of the run length of each entry of the capture buffer
 
     //
     // Here the details of port arrangements are located (HWDBG_PORT_INFORMATION_ITEMS)
@@ -187,6 +264,26 @@ typedef struct _HWDBG_INSTANCE_INFORMATION
 } HWDBG_INSTANCE_INFORMATION, *PHWDBG_INSTANCE_INFORMATION;
 #pragma pack(pop) // This is to make sure the structure is packed (without padding alignment)
 
+/**
+ * @brief The header of binary BRAM images
+ * @details The content of the BRAM (32-bit little-endian words) is located
+ * right after the header, so the image could be mapped and used directly as
+ * the shared memory of hwdbg (e.g., by the Verilator co-simulation harness)
+ * @warning This structure should be changed along with hwdbg files
+ *
+ */
+typedef struct _HWDBG_BRAM_IMAGE_HEADER
+{
+    UINT32 Magic;            // HWDBG_BRAM_IMAGE_MAGIC
+    UINT32 Version;          // HWDBG_BRAM_IMAGE_VERSION
+    UINT32 HeaderSize;       // Offset of the content of the BRAM from the start of the image
+    UINT32 NumberOfWords;    // Number of 32-bit words of the BRAM
+    UINT32 DebuggerSequence; // Incremented once the debugger writes a new packet (PS to PL)
+    UINT32 DebuggeeSequence; // Set to the debugger sequence once the debuggee responds (PL to PS)
+    UINT32 Reserved[2];
+
+} HWDBG_BRAM_IMAGE_HEADER, *PHWDBG_BRAM_IMAGE_HEADER;
+
 /**
  * @brief The structure of script buffer in hwdbg
  *
@@ -202,3 +299,41 @@ typedef struct _HWDBG_SCRIPT_BUFFER
     //
 
 } HWDBG_SCRIPT_BUFFER, *PHWDBG_SCRIPT_BUFFER;
+
+/**
+ * @brief The structure of capture configuration in hwdbg
+ * @details The trigger pin is one of the pins driven by the script engine, if
+ * it is not a valid pin, the capture is triggered immediately
+ * @warning This structure should be changed along with hwdbg files
+ *
+ */
+typedef struct _HWDBG_CAPTURE_CONFIGURATION
+{
+    UINT32 TriggerPin;         // The pin (driven by the script engine) that triggers the capture
+    UINT32 PreTriggerEntries;  // Number of entries captured before the trigger
+    UINT32 PostTriggerEntries; // Number of entries captured after the trigger (including the trigger entry)
+
+} HWDBG_CAPTURE_CONFIGURATION, *PHWDBG_CAPTURE_CONFIGURATION;
+
+/**
+ * @brief The structure of each chunk of the capture buffer in hwdbg
+ * @warning This structure should be changed along with hwdbg files
+ *
+ */
+typedef struct _HWDBG_CAPTURE_BUFFER_CHUNK
+{
+    UINT32 CaptureState;           // State of the capture (HWDBG_CAPTURE_STATE_ENUMS)
+    UINT32 TriggerLatency;         // Number of samples between the sample that caused the trigger and the trigger entry
+    UINT32 NumberOfEntries;        // Number of entries in the capture window
+    UINT32 TriggerEntry;           // Index of the trigger entry in the capture window
+    UINT32 FirstEntry;             // Index of the first entry of this chunk
+    UINT32 NumberOfEntriesInChunk; // Number of entries in this chunk
+
+    //
+    // Here the entries of the chunk are located
+    // As the following type:
+    //   UINT32 RunLength                        ; Number of samples with the same value
+    //   UINT32 Sample[(numberOfPins + 31) / 32] ; The value of pins (first word is pin 0 to 31)
+    //
+
+} HWDBG_CAPTURE_BUFFER_CHUNK, *PHWDBG_CAPTURE_BUFFER_CHUNK;
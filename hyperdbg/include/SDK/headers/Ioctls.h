@@ -302,3 +302,24 @@
  */
 #define IOCTL_PERFROM_ACTIONS_ON_APIC \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x822, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+/**
+ * @brief ioctl, to perform actions related to the VM-exit profiler
+ *
+ */
+#define IOCTL_PERFORM_ACTIONS_ON_VMEXIT_PROFILER \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x823, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+/**
+ * @brief ioctl, to perform actions related to logging the dirty pages
+ *
+ */
+#define IOCTL_PERFORM_ACTIONS_ON_DIRTY_PAGES \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x824, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+/**
+ * @brief ioctl, to perform actions on the memory snapshot
+ *
+ */
+#define IOCTL_PERFORM_ACTIONS_ON_SNAPSHOT \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x825, METHOD_BUFFERED, FILE_ANY_ACCESS)
@@ -161,6 +161,8 @@ typedef enum _DEBUGGER_PREALLOC_COMMAND_TYPE
     DEBUGGER_PREALLOC_COMMAND_TYPE_BIG_EVENT,
     DEBUGGER_PREALLOC_COMMAND_TYPE_REGULAR_SAFE_BUFFER,
     DEBUGGER_PREALLOC_COMMAND_TYPE_BIG_SAFE_BUFFER,
+    DEBUGGER_PREALLOC_COMMAND_TYPE_SNAPSHOT,
+    DEBUGGER_PREALLOC_COMMAND_TYPE_DIRTY_LOGGING,
 
 } DEBUGGER_PREALLOC_COMMAND_TYPE;
 
@@ -516,12 +518,16 @@ typedef enum _DEBUGGER_SEARCH_MEMORY_BYTE_SIZE
 {
     SEARCH_BYTE,
     SEARCH_DWORD,
-    SEARCH_QWORD
+    SEARCH_QWORD,
+    SEARCH_WORD
 
 } DEBUGGER_SEARCH_MEMORY_BYTE_SIZE;
 
 /**
  * @brief request for searching memory
+ * @details The structure is followed by CountOf64Chunks values (one value in each
+ * 64-bit chunk) and then CountOf64Chunks masks, each bit of the mask that is zero
+ * is treated as a wildcard
  *
  */
 typedef struct _DEBUGGER_SEARCH_MEMORY
@@ -763,6 +769,7 @@ typedef struct _DEBUGGER_SINGLE_CALLSTACK_FRAME
     BOOLEAN IsStackAddressValid;
     BOOLEAN IsValidAddress;
     BOOLEAN IsExecutable;
+    BOOLEAN IsReturnAddress; // Found by unwinding the frames
     UINT64  Value;
     BYTE    InstructionBytesOnRip[MAXIMUM_CALL_INSTR_SIZE];
 
@@ -793,6 +800,7 @@ typedef struct _DEBUGGER_CALLSTACK_REQUEST
     DEBUGGER_CALLSTACK_DISPLAY_METHOD DisplayMethod;
     UINT32                            Size;
     UINT32                            FrameCount;
+    UINT32                            UnwoundFrameCount; // Slots that are covered by unwinding
     UINT64                            BaseAddress;
     UINT64                            BufferSize;
 
@@ -1000,6 +1008,32 @@ typedef enum _DEBUGGER_REMOTE_STEPPING_REQUEST
 
 } DEBUGGER_REMOTE_STEPPING_REQUEST;
 
+/**
+ * @brief Type of the records of batched steps
+ *
+ */
+typedef enum _DEBUGGER_STEP_TRACE_RECORD_TYPE
+{
+    DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP,
+    DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS,
+    DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS,
+    DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES,
+
+} DEBUGGER_STEP_TRACE_RECORD_TYPE;
+
+/**
+ * @brief Bit of the RFLAGS in the register mask of the batched steps (other
+ * bits are the index of the register in the GUEST_REGS)
+ *
+ */
+#define DEBUGGER_STEP_TRACE_REGISTER_MASK_RFLAGS (1 << 16)
+
+/**
+ * @brief Register mask of all the registers in the batched steps
+ *
+ */
+#define DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL 0x1ffff
+
 /**
  * @brief The structure of stepping packet in HyperDbg
  *
@@ -1015,8 +1049,56 @@ typedef struct _DEBUGGEE_STEP_PACKET
     BOOLEAN IsCurrentInstructionACall;
     UINT32  CallLength;
 
+    //
+    // Only in the case of batched steps, the steps are performed in the
+    // debuggee and the records are sent in chunks (0 means a regular step)
+    //
+    UINT32                          CountOfSteps;
+    DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType;
+    UINT32                          RegisterMask;
+    BOOLEAN                         StopAtAddress;
+    UINT64                          StopAddress;
+    UINT64                          FirstStepNumber; // Steps of the previous batches of the same command
+
 } DEBUGGEE_STEP_PACKET, *PDEBUGGEE_STEP_PACKET;
 
+/**
+ * @brief The header of a chunk of records of batched steps
+ * @details Records are placed after this header, each record starts with the
+ * RIP, then the registers of the register mask (in the order of their bits),
+ * and the bytes of the instruction (in the case of memory operands)
+ *
+ */
+typedef struct _DEBUGGEE_STEP_TRACE_CHUNK
+{
+    DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType;
+    UINT32                          RegisterMask;
+    UINT32                          RecordSize;
+    UINT32                          CountOfRecords;
+    UINT32                          CoreId; // Records of a chunk are from the same core
+    UINT64                          FirstStepNumber;
+    BOOLEAN                         Is32Bit;
+    BOOLEAN                         IsLastChunk;
+    BOOLEAN                         IsCompleted; // All the steps are performed (only valid in the last chunk)
+
+} DEBUGGEE_STEP_TRACE_CHUNK, *PDEBUGGEE_STEP_TRACE_CHUNK;
+
+/**
+ * @brief The record of a 'call' or a 'ret' in batched steps (used in
+ * tracking)
+ * @details Only the 'call' and the 'ret' instructions are saved and the
+ * depth is computed based on the shadow call stack of the debuggee
+ *
+ */
+typedef struct _DEBUGGEE_STEP_TRACE_EDGE_RECORD
+{
+    UINT64  Address; // Address of the 'call' or the 'ret' instruction
+    UINT64  Target;  // Target of the 'call' or the 'ret' instruction
+    UINT32  Depth;   // Depth of the call tree before the 'call' or after the 'ret'
+    BOOLEAN IsRet;
+
+} DEBUGGEE_STEP_TRACE_EDGE_RECORD, *PDEBUGGEE_STEP_TRACE_EDGE_RECORD;
+
 /**
  * @brief default number of instructions used in tracking and stepping
  *
@@ -1390,3 +1472,259 @@ typedef struct _DEBUGGEE_PCITREE_REQUEST_RESPONSE_PACKET
 
 /* ==============================================================================================
  */
+
+/**
+ * @brief Number of log2 buckets in each histogram of the VM-exit profiler
+ * @details Bucket n holds the samples that took [2^n, 2^(n+1)) cycles,
+ * the last bucket holds everything that is bigger than that
+ *
+ */
+#define VMEXIT_PROFILER_HISTOGRAM_BUCKETS 32
+
+/**
+ * @brief Maximum number of exit reasons that are tracked by the VM-exit profiler
+ *
+ */
+#define VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS 80
+
+/**
+ * @brief Maximum number of events that are reported by the VM-exit
+ * profiler (the most expensive events are reported)
+ *
+ */
+#define VMEXIT_PROFILER_MAXIMUM_EVENT_TAGS 32
+
+/**
+ * @brief Apply the VM-exit profiler query to all cores
+ *
+ */
+#define DEBUGGER_VMEXIT_PROFILER_ALL_CORES 0xffffffff
+
+/**
+ * @brief Perform actions related to the VM-exit profiler
+ *
+ */
+typedef enum _DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE
+{
+    DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_ENABLE,
+    DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_DISABLE,
+    DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_RESET,
+    DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY,
+
+} DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE;
+
+/**
+ * @brief Log2 histogram of TSC deltas
+ *
+ */
+typedef struct _VMEXIT_PROFILER_HISTOGRAM
+{
+    UINT64 Count;
+    UINT64 TotalCycles;
+    UINT64 MaxCycles;
+    UINT64 Buckets[VMEXIT_PROFILER_HISTOGRAM_BUCKETS];
+
+} VMEXIT_PROFILER_HISTOGRAM, *PVMEXIT_PROFILER_HISTOGRAM;
+
+/**
+ * @brief Log2 histogram of the time that is spent on a triggered event
+ *
+ */
+typedef struct _VMEXIT_PROFILER_EVENT_HISTOGRAM
+{
+    UINT64                    Tag;
+    VMEXIT_PROFILER_HISTOGRAM Histogram;
+
+} VMEXIT_PROFILER_EVENT_HISTOGRAM, *PVMEXIT_PROFILER_EVENT_HISTOGRAM;
+
+/**
+ * @brief The results of the VM-exit profiler (either for one core or
+ * aggregated from all cores)
+ *
+ */
+typedef struct _VMEXIT_PROFILER_RESULTS
+{
+    UINT64                          UnknownExitReasons;
+    UINT64                          UntrackedEvents; // Triggers that are not tracked (too many alive events)
+    UINT64                          OmittedEvents;   // Events that are not reported (only the most expensive ones are reported)
+    UINT64                          TranslationCacheHits;
+    UINT64                          TranslationCacheMisses;
+    VMEXIT_PROFILER_HISTOGRAM       ExitReasons[VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS];
+    VMEXIT_PROFILER_EVENT_HISTOGRAM Events[VMEXIT_PROFILER_MAXIMUM_EVENT_TAGS];
+
+} VMEXIT_PROFILER_RESULTS, *PVMEXIT_PROFILER_RESULTS;
+
+/**
+ * @brief The structure of actions for the VM-exit profiler
+ * @details In query requests, this structure is followed by a
+ * VMEXIT_PROFILER_RESULTS structure
+ *
+ */
+typedef struct _DEBUGGER_VMEXIT_PROFILER_REQUEST
+{
+    DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE RequestType;
+    UINT32                                CoreId;
+    BOOLEAN                               IsEnabled;
+    UINT32                                KernelStatus;
+
+} DEBUGGER_VMEXIT_PROFILER_REQUEST, *PDEBUGGER_VMEXIT_PROFILER_REQUEST;
+
+/**
+ * @brief Debugger size of DEBUGGER_VMEXIT_PROFILER_REQUEST
+ *
+ */
+#define SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST \
+    sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST)
+
+/* ==============================================================================================
+ */
+
+/**
+ * @brief Maximum number of entries of the dirty pages that are sent in
+ * one request (the request and its entries should fit in one serial packet)
+ *
+ */
+#define DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES 0x1000
+
+/**
+ * @brief Perform actions related to logging the dirty pages
+ *
+ */
+typedef enum _DEBUGGER_DIRTY_PAGES_REQUEST_TYPE
+{
+    DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_START,
+    DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_STOP,
+    DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_COLLECT,
+
+} DEBUGGER_DIRTY_PAGES_REQUEST_TYPE;
+
+/**
+ * @brief An entry of the dirty pages
+ * @details Each entry describes 64 physical pages starting from
+ * FirstPageFrameNumber (which is a multiple of 64), bit i of the
+ * bitmap is set if page (FirstPageFrameNumber + i) is modified
+ *
+ */
+typedef struct _DEBUGGER_DIRTY_PAGES_ENTRY
+{
+    UINT64 FirstPageFrameNumber;
+    UINT64 Bitmap;
+
+} DEBUGGER_DIRTY_PAGES_ENTRY, *PDEBUGGER_DIRTY_PAGES_ENTRY;
+
+/**
+ * @brief The structure of actions for logging the dirty pages
+ * @details In collect requests, this structure is followed by an array
+ * of DEBUGGER_DIRTY_PAGES_ENTRY (at most DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES),
+ * the collected pages are cleared from the dirty bitmap and if the entries
+ * are full, the collection should be continued from NextPageFrameNumber
+ *
+ */
+typedef struct _DEBUGGER_DIRTY_PAGES_REQUEST
+{
+    DEBUGGER_DIRTY_PAGES_REQUEST_TYPE RequestType;
+    BOOLEAN                           FlushBuffers; // Flush the logs of all cores before collecting the pages
+    UINT64                            FirstPageFrameNumber;
+    UINT64                            EndPageFrameNumber;
+    UINT64                            NextPageFrameNumber;
+    UINT32                            CountOfEntries;
+    UINT32                            KernelStatus;
+
+} DEBUGGER_DIRTY_PAGES_REQUEST, *PDEBUGGER_DIRTY_PAGES_REQUEST;
+
+/**
+ * @brief Debugger size of DEBUGGER_DIRTY_PAGES_REQUEST
+ *
+ */
+#define SIZEOF_DEBUGGER_DIRTY_PAGES_REQUEST \
+    sizeof(DEBUGGER_DIRTY_PAGES_REQUEST)
+
+/* ==============================================================================================
+ */
+
+/**
+ * @brief Default number of pages that are reserved for the copies of the
+ * pages of a snapshot
+ *
+ */
+#define DEBUGGER_SNAPSHOT_DEFAULT_MAXIMUM_PAGES 0x4000
+
+/**
+ * @brief Maximum number of pages that could be reserved for the copies of
+ * the pages of a snapshot
+ *
+ */
+#define DEBUGGER_SNAPSHOT_MAXIMUM_PAGES 0x100000
+
+/**
+ * @brief Maximum physical address of the snapshots (the range that is mapped
+ * by the EPT identity table)
+ *
+ */
+#define DEBUGGER_SNAPSHOT_MAXIMUM_PHYSICAL_ADDRESS 0x8000000000
+
+/**
+ * @brief Perform actions related to the memory snapshot
+ *
+ */
+typedef enum _DEBUGGER_SNAPSHOT_REQUEST_TYPE
+{
+    DEBUGGER_SNAPSHOT_REQUEST_TYPE_TAKE,
+    DEBUGGER_SNAPSHOT_REQUEST_TYPE_RESTORE,
+    DEBUGGER_SNAPSHOT_REQUEST_TYPE_DISCARD,
+    DEBUGGER_SNAPSHOT_REQUEST_TYPE_QUERY,
+
+} DEBUGGER_SNAPSHOT_REQUEST_TYPE;
+
+/**
+ * @brief Statistics of the memory snapshot
+ * @details The durations of restores are in TSC cycles
+ *
+ */
+typedef struct _DEBUGGER_SNAPSHOT_STATISTICS
+{
+    UINT64  StartAddress;
+    UINT64  EndAddress;
+    UINT32  MaximumPages;      // Count of pages of the page pool
+    UINT32  CountOfSavedPages; // Count of pages that their original contents are saved
+    UINT32  CountOfDirtyPages; // Count of pages that are modified since the last restore
+    BOOLEAN IsPoolExhausted;   // Some of the modified pages could not be saved
+    UINT64  CountOfWriteFaults;
+    UINT64  CountOfDroppedPages;
+    UINT64  CountOfRestores;
+    UINT64  CountOfRestoredPages;
+    UINT64  LastRestoreCycles;
+    UINT64  MinimumRestoreCycles;
+    UINT64  MaximumRestoreCycles;
+    UINT64  TotalRestoreCycles;
+
+} DEBUGGER_SNAPSHOT_STATISTICS, *PDEBUGGER_SNAPSHOT_STATISTICS;
+
+/**
+ * @brief The structure of actions for the memory snapshot
+ * @details The snapshot covers the physical range of StartAddress to EndAddress,
+ * the pages are allocated in VMI mode (MaximumPages or the preallocated pages
+ * if it's zero), in the Debugger Mode the pages should be preallocated
+ *
+ */
+typedef struct _DEBUGGER_SNAPSHOT_REQUEST
+{
+    DEBUGGER_SNAPSHOT_REQUEST_TYPE RequestType;
+    UINT64                         StartAddress;
+    UINT64                         EndAddress;
+    UINT32                         MaximumPages;
+    BOOLEAN                        IsTaken;
+    DEBUGGER_SNAPSHOT_STATISTICS   Statistics;
+    UINT32                         KernelStatus;
+
+} DEBUGGER_SNAPSHOT_REQUEST, *PDEBUGGER_SNAPSHOT_REQUEST;
+
+/**
+ * @brief Debugger size of DEBUGGER_SNAPSHOT_REQUEST
+ *
+ */
+#define SIZEOF_DEBUGGER_SNAPSHOT_REQUEST \
+    sizeof(DEBUGGER_SNAPSHOT_REQUEST)
+
+/* ==============================================================================================
+ */
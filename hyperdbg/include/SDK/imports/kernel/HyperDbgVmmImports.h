@@ -221,6 +221,49 @@ VmFuncApicStoreLocalApicFields(PLAPIC_PAGE LocalApicBuffer, PBOOLEAN IsUsingX2AP
 IMPORT_EXPORT_VMM BOOLEAN
 VmFuncApicStoreIoApicFields(IO_APIC_ENTRY_PACKETS * IoApicPackets);
 
+IMPORT_EXPORT_VMM VOID
+VmFuncVmexitProfilerEnable(BOOLEAN Enable);
+
+IMPORT_EXPORT_VMM VOID
+VmFuncVmexitProfilerReset();
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncVmexitProfilerQuery(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results);
+
+IMPORT_EXPORT_VMM VOID
+VmFuncVmexitProfilerAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles);
+
+IMPORT_EXPORT_VMM VOID
+VmFuncVmexitProfilerMergeHistogram(VMEXIT_PROFILER_HISTOGRAM * Destination, VMEXIT_PROFILER_HISTOGRAM * Source);
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncDirtyLoggingResetDirtyPages();
+
+IMPORT_EXPORT_VMM UINT32
+VmFuncDirtyLoggingCollectDirtyPages(UINT64                       FirstPageFrameNumber,
+                                    UINT64                       EndPageFrameNumber,
+                                    DEBUGGER_DIRTY_PAGES_ENTRY * Entries,
+                                    UINT32                       MaximumEntries,
+                                    UINT64 *                     NextPageFrameNumber);
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncSnapshotTake(UINT64 StartAddress, UINT64 EndAddress);
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncSnapshotIsProtected();
+
+IMPORT_EXPORT_VMM VOID
+VmFuncSnapshotDiscard();
+
+IMPORT_EXPORT_VMM VOID
+VmFuncSnapshotPrepareRestore();
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncSnapshotFinishRestore();
+
+IMPORT_EXPORT_VMM BOOLEAN
+VmFuncSnapshotQuery(DEBUGGER_SNAPSHOT_STATISTICS * Statistics);
+
 //////////////////////////////////////////////////
 //            Configuration Functions 	   		//
 //////////////////////////////////////////////////
@@ -270,12 +313,36 @@ ConfigureEnableEferSyscallHookOnSingleCore(UINT32 TargetCoreId);
 IMPORT_EXPORT_VMM VOID
 ConfigureSetEferSyscallOrSysretHookType(DEBUGGER_EVENT_SYSCALL_SYSRET_TYPE SyscallHookType);
 
-IMPORT_EXPORT_VMM VOID
+IMPORT_EXPORT_VMM BOOLEAN
 ConfigureDirtyLoggingInitializeOnAllProcessors();
 
 IMPORT_EXPORT_VMM VOID
 ConfigureDirtyLoggingUninitializeOnAllProcessors();
 
+IMPORT_EXPORT_VMM VOID
+ConfigureDirtyLoggingEnableOnAllProcessors();
+
+IMPORT_EXPORT_VMM VOID
+ConfigureDirtyLoggingDisableOnAllProcessors();
+
+IMPORT_EXPORT_VMM VOID
+ConfigureDirtyLoggingFlushOnAllProcessors();
+
+IMPORT_EXPORT_VMM BOOLEAN
+ConfigureSnapshotAllocateBuffers(UINT32 MaximumPages);
+
+IMPORT_EXPORT_VMM BOOLEAN
+ConfigureSnapshotReserveSplitBuffers(UINT64 StartAddress, UINT64 EndAddress);
+
+IMPORT_EXPORT_VMM VOID
+ConfigureSnapshotProtectPagesOnAllProcessors();
+
+IMPORT_EXPORT_VMM VOID
+ConfigureSnapshotUnprotectPagesOnAllProcessors();
+
+IMPORT_EXPORT_VMM VOID
+ConfigureSnapshotRestorePagesOnAllProcessors();
+
 IMPORT_EXPORT_VMM VOID
 ConfigureModeBasedExecHookUninitializeOnAllProcessors();
 
@@ -440,6 +507,24 @@ DirectVmcallDisableMov2DrExitingForClearingDrEvents(UINT32 CoreId, DIRECT_VMCALL
 IMPORT_EXPORT_VMM NTSTATUS
 DirectVmcallDisableMov2CrExitingForClearingCrEvents(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
 
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallEnableDirtyLogging(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallDisableDirtyLogging(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallFlushDirtyLoggingBuffer(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallSnapshotProtectPages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallSnapshotUnprotectPages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
+IMPORT_EXPORT_VMM NTSTATUS
+DirectVmcallSnapshotRestorePages(UINT32 CoreId, DIRECT_VMCALL_PARAMETERS * DirectVmcallOptions);
+
 //////////////////////////////////////////////////
 //                 Disassembler 	    		//
 //////////////////////////////////////////////////
@@ -590,6 +675,9 @@ DisassemblerLengthDisassembleEngine(PVOID Address, BOOLEAN Is32Bit);
 IMPORT_EXPORT_VMM UINT32
 DisassemblerLengthDisassembleEngineInVmxRootOnTargetProcess(PVOID Address, BOOLEAN Is32Bit);
 
+IMPORT_EXPORT_VMM BOOLEAN
+DisassemblerCheckCallOrRetInVmxRootOnTargetProcess(PVOID Address, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length);
+
 // ----------------------------------------------------------------------------
 // Writing Memory Functions
 //
@@ -64,6 +64,9 @@ hyperdbg_u_test_command_parser(CHAR *   command,
 IMPORT_EXPORT_LIBHYPERDBG VOID
 hyperdbg_u_test_command_parser_show_tokens(CHAR * command);
 
+IMPORT_EXPORT_LIBHYPERDBG UINT32
+hyperdbg_u_test_command_parser_performance(CHAR * command, UINT32 iterations, BOOLEAN convert_tokens);
+
 //
 // General imports/exports
 //
@@ -242,6 +245,35 @@ hyperdbg_u_get_local_apic(PLAPIC_PAGE local_apic, BOOLEAN * is_using_x2apic);
 IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
 hyperdbg_u_get_io_apic(IO_APIC_ENTRY_PACKETS * io_apic);
 
+//
+// VM-exit profiler
+// Exported functionality of the '!vmexitprof' command
+//
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_vmexit_profiler_enable(BOOLEAN enable);
+
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_vmexit_profiler_reset();
+
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_vmexit_profiler_query(UINT32 core_id, VMEXIT_PROFILER_RESULTS * results, BOOLEAN * is_enabled);
+
+//
+// Memory snapshot
+// Exported functionality of the '!snapshot' command
+//
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_snapshot_take(UINT64 start_address, UINT64 end_address, UINT32 maximum_pages);
+
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_snapshot_restore();
+
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_snapshot_discard();
+
+IMPORT_EXPORT_LIBHYPERDBG BOOLEAN
+hyperdbg_u_snapshot_query(DEBUGGER_SNAPSHOT_STATISTICS * statistics, BOOLEAN * is_taken);
+
 //
 // Assembler
 // Exported functionality of the 'a' command
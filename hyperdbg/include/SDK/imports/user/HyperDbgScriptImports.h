@@ -51,7 +51,7 @@ HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer(
     HWDBG_INSTANCE_INFORMATION * InstanceInfo,
     SYMBOL *                     SymbolBuffer,
     size_t                       SymbolBufferLength,
-    UINT32                       NumberOfStages,
+    UINT32 *                     NumberOfStages,
     HWDBG_SHORT_SYMBOL **        NewShortSymbolBuffer,
     size_t *                     NewBufferSize);
 
@@ -97,6 +97,9 @@ ScriptEngineGetDataTypeSize(CHAR * TypeName, UINT64 * TypeSize);
 IMPORT_EXPORT_HYPERDBG_SCRIPT_ENGINE BOOLEAN
 ScriptEngineCreateSymbolTableForDisassembler(void * CallbackFunction);
 
+IMPORT_EXPORT_HYPERDBG_SCRIPT_ENGINE BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModule(void * CallbackFunction, UINT64 BaseAddress);
+
 IMPORT_EXPORT_HYPERDBG_SCRIPT_ENGINE BOOLEAN
 ScriptEngineConvertFileToPdbPath(const char * LocalFilePath, char * ResultPath, size_t ResultPathSize);
 
@@ -54,6 +54,9 @@ SymGetDataTypeSize(CHAR * TypeName, UINT64 * TypeSize);
 IMPORT_EXPORT_HYPERDBG_SYMBOL_PARSER BOOLEAN
 SymCreateSymbolTableForDisassembler(void * CallbackFunction);
 
+IMPORT_EXPORT_HYPERDBG_SYMBOL_PARSER BOOLEAN
+SymCreateSymbolTableForDisassemblerFromModule(void * CallbackFunction, UINT64 BaseAddress);
+
 IMPORT_EXPORT_HYPERDBG_SYMBOL_PARSER BOOLEAN
 SymConvertFileToPdbPath(const char * LocalFilePath, char * ResultPath, size_t ResultPathSize);
 
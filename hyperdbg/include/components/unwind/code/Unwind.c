@@ -0,0 +1,940 @@
+/**
+ * @file Unwind.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The x64 stack unwinder (based on the unwind data of PE images)
+ * @details The unwinder interprets the exception directory (.pdata) and the
+ * unwind info (.xdata) of the images, the same way as RtlVirtualUnwind.
+ * It doesn't allocate and only accesses the memory of the target through the
+ * read callback, so it can be used in VMX-root mode
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Initialize the unwinder
+ *
+ * @param State
+ * @param ReadMemory
+ *
+ * @return VOID
+ */
+VOID
+UnwindInitialize(PUNWIND_STATE State, UNWIND_READ_MEMORY ReadMemory)
+{
+    RtlZeroMemory(State, sizeof(UNWIND_STATE));
+
+    State->ReadMemory = ReadMemory;
+}
+
+/**
+ * @brief Remove all of the cached modules and functions
+ *
+ * @param State
+ *
+ * @return VOID
+ */
+VOID
+UnwindFlushCache(PUNWIND_STATE State)
+{
+    State->ModuleCount = 0;
+
+    RtlZeroMemory(State->Modules, sizeof(State->Modules));
+    RtlZeroMemory(State->FunctionCache, sizeof(State->FunctionCache));
+    RtlZeroMemory(State->TableCache, sizeof(State->TableCache));
+    RtlZeroMemory(State->NegativeCache, sizeof(State->NegativeCache));
+}
+
+/**
+ * @brief Remove the cached functions and the cached chunks of the exception
+ * directory of a module (before the module is removed from the cache)
+ *
+ * @param State
+ * @param Module
+ *
+ * @return VOID
+ */
+VOID
+UnwindInvalidateModule(PUNWIND_STATE State, PUNWIND_MODULE Module)
+{
+    for (UINT32 i = 0; i < UNWIND_FUNCTION_CACHE_SIZE; i++)
+    {
+        if (State->FunctionCache[i].ImageBase == Module->ImageBase && State->FunctionCache[i].AddressSpace == Module->AddressSpace)
+        {
+            RtlZeroMemory(&State->FunctionCache[i], sizeof(UNWIND_FUNCTION_CACHE_ENTRY));
+        }
+    }
+
+    for (UINT32 i = 0; i < UNWIND_TABLE_CACHE_SIZE; i++)
+    {
+        if (State->TableCache[i].ImageBase == Module->ImageBase && State->TableCache[i].AddressSpace == Module->AddressSpace)
+        {
+            State->TableCache[i].FunctionCount = 0;
+        }
+    }
+}
+
+/**
+ * @brief Read an entry of the exception directory of a module
+ * @details The exception directory is read (and cached) in chunks, so the
+ * binary search of the functions mostly doesn't read the memory of the target
+ *
+ * @param State
+ * @param Module
+ * @param Index Index of the entry (less than the number of functions of the
+ * module)
+ * @param Function
+ *
+ * @return BOOLEAN FALSE if the memory is not accessible
+ */
+BOOLEAN
+UnwindReadRuntimeFunction(PUNWIND_STATE            State,
+                          PUNWIND_MODULE           Module,
+                          UINT32                   Index,
+                          PUNWIND_RUNTIME_FUNCTION Function)
+{
+    PUNWIND_TABLE_CHUNK Chunk;
+    UINT32              FunctionCount;
+    UINT32              ChunkIndex = Index / UNWIND_TABLE_CHUNK_FUNCTIONS;
+    UINT64              Directory  = Module->ImageBase + Module->ExceptionDirectoryRva;
+
+    Chunk = &State->TableCache[((Module->ImageBase >> 12) ^ (Module->ImageBase >> 20) ^ ChunkIndex) & (UNWIND_TABLE_CACHE_SIZE - 1)];
+
+    if (Chunk->FunctionCount == 0 ||
+        Chunk->ChunkIndex != ChunkIndex ||
+        Chunk->ImageBase != Module->ImageBase ||
+        Chunk->AddressSpace != Module->AddressSpace ||
+        Chunk->TimeDateStamp != Module->TimeDateStamp)
+    {
+        FunctionCount = Module->FunctionCount - ChunkIndex * UNWIND_TABLE_CHUNK_FUNCTIONS;
+
+        if (FunctionCount > UNWIND_TABLE_CHUNK_FUNCTIONS)
+        {
+            FunctionCount = UNWIND_TABLE_CHUNK_FUNCTIONS;
+        }
+
+        if (!State->ReadMemory(Directory + (UINT64)ChunkIndex * UNWIND_TABLE_CHUNK_FUNCTIONS * sizeof(UNWIND_RUNTIME_FUNCTION),
+                               Chunk->Functions,
+                               FunctionCount * sizeof(UNWIND_RUNTIME_FUNCTION)))
+        {
+            //
+            // A part of the chunk is not accessible (e.g., paged out), so
+            // only the entry itself is read
+            //
+            Chunk->FunctionCount = 0;
+
+            return State->ReadMemory(Directory + (UINT64)Index * sizeof(UNWIND_RUNTIME_FUNCTION),
+                                     Function,
+                                     sizeof(UNWIND_RUNTIME_FUNCTION));
+        }
+
+        Chunk->AddressSpace  = Module->AddressSpace;
+        Chunk->ImageBase     = Module->ImageBase;
+        Chunk->TimeDateStamp = Module->TimeDateStamp;
+        Chunk->ChunkIndex    = ChunkIndex;
+        Chunk->FunctionCount = FunctionCount;
+    }
+
+    *Function = Chunk->Functions[Index % UNWIND_TABLE_CHUNK_FUNCTIONS];
+
+    return TRUE;
+}
+
+/**
+ * @brief Find the module that contains the address (and cache its unwind
+ * table)
+ * @details If the module is not cached, the addresses before the address
+ * are scanned to find the image headers (at the alignment of the images and
+ * up to UNWIND_MAXIMUM_IMAGE_SCAN_PROBES addresses). The addresses that are
+ * not in an image are kept in the negative cache, so they're not scanned again
+ *
+ * @param State
+ * @param AddressSpace
+ * @param Address
+ *
+ * @return PUNWIND_MODULE NULL if the address is not in an image
+ */
+PUNWIND_MODULE
+UnwindFindModule(PUNWIND_STATE State, UINT64 AddressSpace, UINT64 Address)
+{
+    PUNWIND_MODULE               Module;
+    PUNWIND_NEGATIVE_CACHE_ENTRY NegativeEntry;
+    UINT64                       PageAddress;
+    UINT64                       ScanAddress;
+    UINT64                       ScanAlignment = UNWIND_USER_IMAGE_ALIGNMENT;
+    UINT16                       DosSignature;
+    UINT32                       NtHeadersOffset;
+    UINT32                       TimeDateStamp;
+    UINT32                       SizeOfImage;
+    UINT32                       NumberOfRvaAndSizes;
+    UINT32                       Victim;
+    UINT32 *                     ExceptionDirectory;
+    BYTE                         NtHeaders[UNWIND_IMAGE_NT_HEADERS64_SIZE];
+
+    //
+    // Kernel modules are shared between all address spaces, and they're only
+    // aligned to the pages
+    //
+    if ((INT64)Address < 0)
+    {
+        AddressSpace  = 0;
+        ScanAlignment = UNWIND_PAGE_SIZE;
+    }
+
+    State->UseCounter++;
+
+    //
+    // Check the cached modules
+    //
+    for (UINT32 i = 0; i < State->ModuleCount; i++)
+    {
+        Module = &State->Modules[i];
+
+        if (Module->AddressSpace != AddressSpace || Address < Module->ImageBase || Address - Module->ImageBase >= Module->SizeOfImage)
+        {
+            continue;
+        }
+
+        //
+        // Make sure that the module is not unloaded (or replaced) since it's
+        // cached
+        //
+        if (State->ReadMemory(Module->ImageBase + Module->NtHeadersOffset + UNWIND_IMAGE_NT_HEADERS_TIME_DATE_STAMP_OFFSET,
+                              &TimeDateStamp,
+                              sizeof(UINT32)) &&
+            TimeDateStamp == Module->TimeDateStamp)
+        {
+            Module->LastUsed = State->UseCounter;
+            return Module;
+        }
+
+        //
+        // The module is no longer valid, the cached functions and the cached
+        // parts of its exception directory are also removed
+        //
+        UnwindInvalidateModule(State, Module);
+
+        State->Modules[i] = State->Modules[--State->ModuleCount];
+        RtlZeroMemory(&State->Modules[State->ModuleCount], sizeof(UNWIND_MODULE));
+        break;
+    }
+
+    //
+    // Check whether the address is already known not to be in an image
+    //
+    PageAddress   = Address & ~((UINT64)UNWIND_PAGE_SIZE - 1);
+    NegativeEntry = &State->NegativeCache[((PageAddress >> 12) ^ (PageAddress >> 22)) & (UNWIND_NEGATIVE_CACHE_SIZE - 1)];
+
+    if (NegativeEntry->PageAddress == PageAddress &&
+        NegativeEntry->AddressSpace == AddressSpace &&
+        State->UseCounter < NegativeEntry->ExpirationTime)
+    {
+        return NULL;
+    }
+
+    //
+    // Scan the aligned addresses backward to find the image headers
+    //
+    ScanAddress = Address & ~(ScanAlignment - 1);
+
+    for (UINT32 i = 0; i < UNWIND_MAXIMUM_IMAGE_SCAN_PROBES; i++, ScanAddress -= ScanAlignment)
+    {
+        if (ScanAddress > Address)
+        {
+            //
+            // Wrapped around the address space
+            //
+            break;
+        }
+
+        if (!State->ReadMemory(ScanAddress, &DosSignature, sizeof(UINT16)) || DosSignature != UNWIND_IMAGE_DOS_SIGNATURE)
+        {
+            continue;
+        }
+
+        if (!State->ReadMemory(ScanAddress + UNWIND_IMAGE_DOS_HEADER_LFANEW_OFFSET, &NtHeadersOffset, sizeof(UINT32)) ||
+            NtHeadersOffset >= UNWIND_PAGE_SIZE)
+        {
+            continue;
+        }
+
+        if (!State->ReadMemory(ScanAddress + NtHeadersOffset, NtHeaders, sizeof(NtHeaders)) ||
+            *(UINT32 *)NtHeaders != UNWIND_IMAGE_NT_SIGNATURE ||
+            *(UINT16 *)&NtHeaders[UNWIND_IMAGE_NT_HEADERS_MAGIC_OFFSET] != UNWIND_IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+        {
+            continue;
+        }
+
+        SizeOfImage = *(UINT32 *)&NtHeaders[UNWIND_IMAGE_NT_HEADERS_SIZE_OF_IMAGE_OFFSET];
+
+        if (Address - ScanAddress >= SizeOfImage)
+        {
+            //
+            // The nearest image doesn't contain the address
+            //
+            break;
+        }
+
+        //
+        // Cache the module, a previous module at the same base (e.g., a
+        // smaller image that is unloaded) or the least recently used module
+        // is replaced
+        //
+        for (Victim = 0; Victim < State->ModuleCount; Victim++)
+        {
+            if (State->Modules[Victim].ImageBase == ScanAddress && State->Modules[Victim].AddressSpace == AddressSpace)
+            {
+                break;
+            }
+        }
+
+        if (Victim == State->ModuleCount && State->ModuleCount < UNWIND_MAXIMUM_CACHED_MODULES)
+        {
+            State->ModuleCount++;
+        }
+        else if (Victim == State->ModuleCount)
+        {
+            Victim = 0;
+
+            for (UINT32 j = 1; j < UNWIND_MAXIMUM_CACHED_MODULES; j++)
+            {
+                if (State->Modules[j].LastUsed < State->Modules[Victim].LastUsed)
+                {
+                    Victim = j;
+                }
+            }
+        }
+
+        UnwindInvalidateModule(State, &State->Modules[Victim]);
+
+        Module                        = &State->Modules[Victim];
+        Module->AddressSpace          = AddressSpace;
+        Module->ImageBase             = ScanAddress;
+        Module->SizeOfImage           = SizeOfImage;
+        Module->TimeDateStamp         = *(UINT32 *)&NtHeaders[UNWIND_IMAGE_NT_HEADERS_TIME_DATE_STAMP_OFFSET];
+        Module->NtHeadersOffset       = NtHeadersOffset;
+        Module->ExceptionDirectoryRva = 0;
+        Module->FunctionCount         = 0;
+        Module->LastUsed              = State->UseCounter;
+
+        NumberOfRvaAndSizes = *(UINT32 *)&NtHeaders[UNWIND_IMAGE_NT_HEADERS_NUMBER_OF_RVA_AND_SIZES_OFFSET];
+
+        if (NumberOfRvaAndSizes > UNWIND_IMAGE_DIRECTORY_ENTRY_EXCEPTION)
+        {
+            //
+            // Each data directory is an RVA and a size
+            //
+            ExceptionDirectory = (UINT32 *)&NtHeaders[UNWIND_IMAGE_NT_HEADERS_DATA_DIRECTORY_OFFSET +
+                                                      UNWIND_IMAGE_DIRECTORY_ENTRY_EXCEPTION * sizeof(UINT64)];
+
+            Module->ExceptionDirectoryRva = ExceptionDirectory[0];
+            Module->FunctionCount         = ExceptionDirectory[1] / sizeof(UNWIND_RUNTIME_FUNCTION);
+        }
+
+        return Module;
+    }
+
+    NegativeEntry->AddressSpace   = AddressSpace;
+    NegativeEntry->PageAddress    = PageAddress;
+    NegativeEntry->ExpirationTime = State->UseCounter + UNWIND_NEGATIVE_CACHE_LIFETIME;
+
+    return NULL;
+}
+
+/**
+ * @brief Find the runtime function (.pdata entry) of an address
+ * @details If the address is in an image that has unwind data but it's
+ * not covered by any of the entries, it's a leaf function and the unwind
+ * data of the function is zero
+ *
+ * @param State
+ * @param AddressSpace
+ * @param Address
+ * @param ImageBase
+ * @param Function
+ *
+ * @return UNWIND_STATUS
+ */
+UNWIND_STATUS
+UnwindLookupFunction(PUNWIND_STATE            State,
+                     UINT64                   AddressSpace,
+                     UINT64                   Address,
+                     PUINT64                  ImageBase,
+                     PUNWIND_RUNTIME_FUNCTION Function)
+{
+    PUNWIND_MODULE               Module;
+    PUNWIND_FUNCTION_CACHE_ENTRY Entry;
+    UINT64                       Rva;
+    UINT32                       Low;
+    UINT32                       High;
+    UINT32                       Middle;
+    UNWIND_RUNTIME_FUNCTION      Current;
+
+    Module = UnwindFindModule(State, AddressSpace, Address);
+
+    if (Module == NULL || Module->FunctionCount == 0)
+    {
+        return UNWIND_STATUS_NO_UNWIND_DATA;
+    }
+
+    *ImageBase = Module->ImageBase;
+    Rva        = Address - Module->ImageBase;
+
+    //
+    // Check the cache of the functions
+    //
+    Entry = &State->FunctionCache[(Address ^ (Address >> 8) ^ (Address >> 20)) & (UNWIND_FUNCTION_CACHE_SIZE - 1)];
+
+    if (Entry->ImageBase == Module->ImageBase && Entry->AddressSpace == Module->AddressSpace &&
+        Rva >= Entry->Function.BeginAddress && Rva < Entry->Function.EndAddress)
+    {
+        *Function = Entry->Function;
+        return UNWIND_STATUS_SUCCESS;
+    }
+
+    //
+    // Binary search the exception directory of the module (it's sorted by
+    // the start address of the functions)
+    //
+    Low  = 0;
+    High = Module->FunctionCount;
+
+    while (Low < High)
+    {
+        Middle = Low + ((High - Low) >> 1);
+
+        if (!UnwindReadRuntimeFunction(State, Module, Middle, &Current))
+        {
+            return UNWIND_STATUS_INVALID_MEMORY;
+        }
+
+        if (Rva < Current.BeginAddress)
+        {
+            High = Middle;
+        }
+        else if (Rva >= Current.EndAddress)
+        {
+            Low = Middle + 1;
+        }
+        else
+        {
+            //
+            // The unwind data might point to another runtime function
+            // (indirect entries)
+            //
+            if (Current.UnwindData & 1)
+            {
+                if (!State->ReadMemory(Module->ImageBase + (Current.UnwindData & ~1),
+                                       &Current,
+                                       sizeof(UNWIND_RUNTIME_FUNCTION)))
+                {
+                    return UNWIND_STATUS_INVALID_MEMORY;
+                }
+            }
+
+            Entry->AddressSpace = Module->AddressSpace;
+            Entry->ImageBase    = Module->ImageBase;
+            Entry->Function     = Current;
+
+            *Function = Current;
+            return UNWIND_STATUS_SUCCESS;
+        }
+    }
+
+    //
+    // Leaf function
+    //
+    RtlZeroMemory(Function, sizeof(UNWIND_RUNTIME_FUNCTION));
+
+    return UNWIND_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Emulate the epilog if the instruction pointer is inside an epilog
+ * @details Epilogs have a strict form on x64: an optional "add rsp, imm" or
+ * "lea rsp, [reg + disp]", followed by the pops of the non-volatile registers
+ * and a "ret" or a jump (tail call)
+ *
+ * @param State
+ * @param Context
+ * @param ReturnAddressLocation
+ *
+ * @return BOOLEAN TRUE if the instruction pointer was in an epilog and the
+ * frame is unwound
+ */
+BOOLEAN
+UnwindEmulateEpilog(PUNWIND_STATE State, PUNWIND_CONTEXT Context, PUINT64 ReturnAddressLocation)
+{
+    BYTE   Code[UNWIND_MAXIMUM_EPILOG_LENGTH] = {0};
+    BYTE   PoppedRegisters[16];
+    UINT32 PopCount = 0;
+    UINT32 Offset   = 0;
+    UINT32 Length   = UNWIND_MAXIMUM_EPILOG_LENGTH;
+    UINT64 Rsp      = Context->Registers[UNWIND_REGISTER_RSP];
+    UINT64 Value;
+    BYTE   Base;
+
+    //
+    // The code might be at the end of the last page
+    //
+    if (!State->ReadMemory(Context->Rip, Code, Length))
+    {
+        Length = UNWIND_PAGE_SIZE - (Context->Rip & (UNWIND_PAGE_SIZE - 1));
+
+        if (Length >= UNWIND_MAXIMUM_EPILOG_LENGTH || !State->ReadMemory(Context->Rip, Code, Length))
+        {
+            return FALSE;
+        }
+    }
+
+    //
+    // Deallocation of the fixed part of the stack
+    //
+    if (Code[0] == 0x48 && Code[1] == 0x83 && Code[2] == 0xc4)
+    {
+        //
+        // add rsp, imm8
+        //
+        Rsp += (INT8)Code[3];
+        Offset = 4;
+    }
+    else if (Code[0] == 0x48 && Code[1] == 0x81 && Code[2] == 0xc4)
+    {
+        //
+        // add rsp, imm32
+        //
+        Rsp += *(INT32 *)&Code[3];
+        Offset = 7;
+    }
+    else if ((Code[0] & 0xfe) == 0x48 && Code[1] == 0x8d && (Code[2] & 0x38) == 0x20 && (Code[2] & 0x7) != 4)
+    {
+        //
+        // lea rsp, [reg + disp8/disp32]
+        //
+        Base = (Code[2] & 0x7) | ((Code[0] & 0x1) << 3);
+
+        if ((Code[2] >> 6) == 1)
+        {
+            Rsp    = Context->Registers[Base] + (INT8)Code[3];
+            Offset = 4;
+        }
+        else if ((Code[2] >> 6) == 2)
+        {
+            Rsp    = Context->Registers[Base] + *(INT32 *)&Code[3];
+            Offset = 7;
+        }
+        else
+        {
+            return FALSE;
+        }
+    }
+
+    //
+    // Pops of the non-volatile registers
+    //
+    while (Offset + 2 < Length && PopCount < sizeof(PoppedRegisters))
+    {
+        if ((Code[Offset] & 0xf8) == 0x58)
+        {
+            PoppedRegisters[PopCount++] = Code[Offset] & 0x7;
+            Offset += 1;
+        }
+        else if (Code[Offset] == 0x41 && (Code[Offset + 1] & 0xf8) == 0x58)
+        {
+            PoppedRegisters[PopCount++] = 8 + (Code[Offset + 1] & 0x7);
+            Offset += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (Offset + 3 > Length)
+    {
+        return FALSE;
+    }
+
+    //
+    // The epilog should be finished by a ret, or by a jump (tail call) if
+    // it's not only a single instruction
+    //
+    if (!(Code[Offset] == 0xc3 ||
+          (Code[Offset] == 0xf3 && Code[Offset + 1] == 0xc3) ||
+          (Offset != 0 && Code[Offset] == 0xe9) ||
+          (Offset != 0 && Code[Offset] == 0xff && Code[Offset + 1] == 0x25) ||
+          (Offset != 0 && Code[Offset] == 0x48 && Code[Offset + 1] == 0xff && Code[Offset + 2] == 0x25)))
+    {
+        return FALSE;
+    }
+
+    //
+    // It's an epilog, emulate it
+    //
+    for (UINT32 i = 0; i < PopCount; i++)
+    {
+        if (!State->ReadMemory(Rsp, &Value, sizeof(UINT64)))
+        {
+            return FALSE;
+        }
+
+        Context->Registers[PoppedRegisters[i]] = Value;
+        Rsp += sizeof(UINT64);
+    }
+
+    if (!State->ReadMemory(Rsp, &Value, sizeof(UINT64)))
+    {
+        return FALSE;
+    }
+
+    *ReturnAddressLocation                  = Rsp;
+    Context->Rip                            = Value;
+    Context->Registers[UNWIND_REGISTER_RSP] = Rsp + sizeof(UINT64);
+
+    return TRUE;
+}
+
+/**
+ * @brief Unwind a frame based on the unwind info of its function
+ *
+ * @param State
+ * @param ImageBase
+ * @param Function
+ * @param Context
+ * @param ReturnAddressLocation
+ *
+ * @return UNWIND_STATUS
+ */
+UNWIND_STATUS
+UnwindVirtualUnwind(PUNWIND_STATE            State,
+                    UINT64                   ImageBase,
+                    PUNWIND_RUNTIME_FUNCTION Function,
+                    PUNWIND_CONTEXT          Context,
+                    PUINT64                  ReturnAddressLocation)
+{
+    UNWIND_INFO_HEADER      Header;
+    UNWIND_RUNTIME_FUNCTION CurrentFunction = *Function;
+    UNWIND_CODE             Codes[UNWIND_MAXIMUM_CODES + sizeof(UNWIND_RUNTIME_FUNCTION) / sizeof(UNWIND_CODE)];
+    UINT64 *                Registers       = Context->Registers;
+    UINT64                  Frame           = Registers[UNWIND_REGISTER_RSP];
+    UINT64                  PrologOffset;
+    UINT64                  Value;
+    UINT32                  CodesSize;
+    UINT32                  SlotCount;
+    UINT32                  Chain;
+    BOOLEAN                 IsMachineFrame = FALSE;
+
+    for (Chain = 0; Chain < UNWIND_MAXIMUM_CHAINED_INFO; Chain++)
+    {
+        if (!State->ReadMemory(ImageBase + CurrentFunction.UnwindData, &Header, sizeof(UNWIND_INFO_HEADER)))
+        {
+            return UNWIND_STATUS_INVALID_MEMORY;
+        }
+
+        if (Header.Version != 1 && Header.Version != 2)
+        {
+            return UNWIND_STATUS_INVALID_UNWIND_DATA;
+        }
+
+        //
+        // Codes are aligned to two slots and the chained function is after them
+        //
+        CodesSize = ((Header.CountOfCodes + 1) & ~1) * sizeof(UNWIND_CODE);
+
+        if (Header.Flags & UNWIND_FLAG_CHAININFO)
+        {
+            CodesSize += sizeof(UNWIND_RUNTIME_FUNCTION);
+        }
+
+        if (CodesSize != 0 &&
+            !State->ReadMemory(ImageBase + CurrentFunction.UnwindData + sizeof(UNWIND_INFO_HEADER), Codes, CodesSize))
+        {
+            return UNWIND_STATUS_INVALID_MEMORY;
+        }
+
+        //
+        // Check whether the instruction pointer is in the prolog (only the
+        // executed part of the prolog is unwound) or in an epilog, the
+        // chained functions are unwound completely
+        //
+        PrologOffset = Context->Rip - (ImageBase + CurrentFunction.BeginAddress);
+
+        if (Chain != 0 || Context->Rip < ImageBase + CurrentFunction.BeginAddress || PrologOffset >= Header.SizeOfProlog)
+        {
+            PrologOffset = MAXUINT64;
+
+            if (Chain == 0 && Header.CountOfCodes != 0 && UnwindEmulateEpilog(State, Context, ReturnAddressLocation))
+            {
+                return UNWIND_STATUS_SUCCESS;
+            }
+        }
+
+        //
+        // Compute the frame (the base of the fixed allocation) based on the
+        // primary function
+        //
+        if (Chain == 0 && Header.FrameRegister != 0)
+        {
+            if (PrologOffset == MAXUINT64)
+            {
+                Frame = Registers[Header.FrameRegister] - Header.FrameOffset * 16;
+            }
+            else
+            {
+                for (UINT32 i = 0; i < Header.CountOfCodes; i++)
+                {
+                    if (Codes[i].UnwindOperation == UNWIND_OPERATION_SET_FPREG)
+                    {
+                        if (PrologOffset >= Codes[i].CodeOffset)
+                        {
+                            Frame = Registers[Header.FrameRegister] - Header.FrameOffset * 16;
+                        }
+
+                        break;
+                    }
+                }
+            }
+        }
+
+        //
+        // Interpret the unwind codes (they're in the reverse order of the
+        // prolog)
+        //
+        for (UINT32 i = 0; i < Header.CountOfCodes; i += SlotCount)
+        {
+            switch (Codes[i].UnwindOperation)
+            {
+            case UNWIND_OPERATION_ALLOC_LARGE:
+                SlotCount = Codes[i].OperationInfo == 0 ? 2 : 3;
+                break;
+            case UNWIND_OPERATION_SAVE_NONVOL:
+            case UNWIND_OPERATION_EPILOG:
+            case UNWIND_OPERATION_SAVE_XMM128:
+                SlotCount = 2;
+                break;
+            case UNWIND_OPERATION_SAVE_NONVOL_FAR:
+            case UNWIND_OPERATION_SPARE_CODE:
+            case UNWIND_OPERATION_SAVE_XMM128_FAR:
+                SlotCount = 3;
+                break;
+            default:
+                SlotCount = 1;
+                break;
+            }
+
+            if (i + SlotCount > Header.CountOfCodes)
+            {
+                return UNWIND_STATUS_INVALID_UNWIND_DATA;
+            }
+
+            //
+            // Skip the parts of the prolog that are not executed yet
+            //
+            if (PrologOffset < Codes[i].CodeOffset)
+            {
+                continue;
+            }
+
+            switch (Codes[i].UnwindOperation)
+            {
+            case UNWIND_OPERATION_PUSH_NONVOL:
+
+                if (!State->ReadMemory(Registers[UNWIND_REGISTER_RSP], &Value, sizeof(UINT64)))
+                {
+                    return UNWIND_STATUS_INVALID_MEMORY;
+                }
+
+                Registers[Codes[i].OperationInfo] = Value;
+                Registers[UNWIND_REGISTER_RSP] += sizeof(UINT64);
+
+                break;
+
+            case UNWIND_OPERATION_ALLOC_LARGE:
+
+                if (Codes[i].OperationInfo == 0)
+                {
+                    Registers[UNWIND_REGISTER_RSP] += (UINT64)Codes[i + 1].FrameOffset * 8;
+                }
+                else if (Codes[i].OperationInfo == 1)
+                {
+                    Registers[UNWIND_REGISTER_RSP] += Codes[i + 1].FrameOffset | ((UINT64)Codes[i + 2].FrameOffset << 16);
+                }
+                else
+                {
+                    return UNWIND_STATUS_INVALID_UNWIND_DATA;
+                }
+
+                break;
+
+            case UNWIND_OPERATION_ALLOC_SMALL:
+
+                Registers[UNWIND_REGISTER_RSP] += Codes[i].OperationInfo * 8 + 8;
+
+                break;
+
+            case UNWIND_OPERATION_SET_FPREG:
+
+                if (Header.FrameRegister == 0)
+                {
+                    return UNWIND_STATUS_INVALID_UNWIND_DATA;
+                }
+
+                Registers[UNWIND_REGISTER_RSP] = Registers[Header.FrameRegister] - Header.FrameOffset * 16;
+
+                break;
+
+            case UNWIND_OPERATION_SAVE_NONVOL:
+            case UNWIND_OPERATION_SAVE_NONVOL_FAR:
+
+                if (Codes[i].UnwindOperation == UNWIND_OPERATION_SAVE_NONVOL)
+                {
+                    Value = Frame + (UINT64)Codes[i + 1].FrameOffset * 8;
+                }
+                else
+                {
+                    Value = Frame + (Codes[i + 1].FrameOffset | ((UINT64)Codes[i + 2].FrameOffset << 16));
+                }
+
+                if (!State->ReadMemory(Value, &Value, sizeof(UINT64)))
+                {
+                    return UNWIND_STATUS_INVALID_MEMORY;
+                }
+
+                Registers[Codes[i].OperationInfo] = Value;
+
+                break;
+
+            case UNWIND_OPERATION_PUSH_MACHFRAME:
+
+                //
+                // Interrupts and exceptions, the error code is pushed if the
+                // operation info is one
+                //
+                if (Codes[i].OperationInfo == 1)
+                {
+                    Registers[UNWIND_REGISTER_RSP] += sizeof(UINT64);
+                }
+
+                *ReturnAddressLocation = Registers[UNWIND_REGISTER_RSP];
+
+                if (!State->ReadMemory(Registers[UNWIND_REGISTER_RSP], &Context->Rip, sizeof(UINT64)) ||
+                    !State->ReadMemory(Registers[UNWIND_REGISTER_RSP] + 3 * sizeof(UINT64), &Value, sizeof(UINT64)))
+                {
+                    return UNWIND_STATUS_INVALID_MEMORY;
+                }
+
+                Registers[UNWIND_REGISTER_RSP] = Value;
+                IsMachineFrame                 = TRUE;
+
+                break;
+
+            default:
+
+                //
+                // Epilogs (version 2) and saves of the XMM registers don't
+                // change the non-volatile integer registers
+                //
+                break;
+            }
+        }
+
+        if (!(Header.Flags & UNWIND_FLAG_CHAININFO))
+        {
+            break;
+        }
+
+        CurrentFunction = *(PUNWIND_RUNTIME_FUNCTION)&Codes[(Header.CountOfCodes + 1) & ~1];
+    }
+
+    if (Chain == UNWIND_MAXIMUM_CHAINED_INFO)
+    {
+        return UNWIND_STATUS_INVALID_UNWIND_DATA;
+    }
+
+    //
+    // Pop the return address
+    //
+    if (!IsMachineFrame)
+    {
+        *ReturnAddressLocation = Registers[UNWIND_REGISTER_RSP];
+
+        if (!State->ReadMemory(Registers[UNWIND_REGISTER_RSP], &Context->Rip, sizeof(UINT64)))
+        {
+            return UNWIND_STATUS_INVALID_MEMORY;
+        }
+
+        Registers[UNWIND_REGISTER_RSP] += sizeof(UINT64);
+    }
+
+    return UNWIND_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Unwind one frame (find the caller of the current function)
+ *
+ * @param State
+ * @param AddressSpace The address space of the user-mode modules (e.g., the
+ * CR3 of the process)
+ * @param Context
+ * @param ReturnAddressLocation The address on the stack where the return
+ * address is read from
+ *
+ * @return UNWIND_STATUS
+ */
+UNWIND_STATUS
+UnwindStep(PUNWIND_STATE   State,
+           UINT64          AddressSpace,
+           PUNWIND_CONTEXT Context,
+           PUINT64         ReturnAddressLocation)
+{
+    UNWIND_STATUS           Status;
+    UNWIND_RUNTIME_FUNCTION Function;
+    UINT64                  ImageBase;
+    UINT64                  PreviousRsp = Context->Registers[UNWIND_REGISTER_RSP];
+
+    Status = UnwindLookupFunction(State, AddressSpace, Context->Rip, &ImageBase, &Function);
+
+    if (Status != UNWIND_STATUS_SUCCESS)
+    {
+        return Status;
+    }
+
+    if (Function.UnwindData == 0)
+    {
+        //
+        // Leaf functions don't change the stack pointer, so the return
+        // address is on the top of the stack
+        //
+        *ReturnAddressLocation = PreviousRsp;
+
+        if (!State->ReadMemory(PreviousRsp, &Context->Rip, sizeof(UINT64)))
+        {
+            return UNWIND_STATUS_INVALID_MEMORY;
+        }
+
+        Context->Registers[UNWIND_REGISTER_RSP] = PreviousRsp + sizeof(UINT64);
+    }
+    else
+    {
+        Status = UnwindVirtualUnwind(State, ImageBase, &Function, Context, ReturnAddressLocation);
+
+        if (Status != UNWIND_STATUS_SUCCESS)
+        {
+            return Status;
+        }
+    }
+
+    //
+    // The return address is always above the previous stack pointer
+    //
+    if (*ReturnAddressLocation < PreviousRsp)
+    {
+        return UNWIND_STATUS_INVALID_UNWIND_DATA;
+    }
+
+    return UNWIND_STATUS_SUCCESS;
+}
@@ -0,0 +1,355 @@
+/**
+ * @file Unwind.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The header file for the x64 stack unwinder (based on the unwind
+ * data of PE images)
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of modules that their unwind tables are cached
+ *
+ */
+#define UNWIND_MAXIMUM_CACHED_MODULES 32
+
+/**
+ * @brief Number of entries of the cache of the function lookups (should be
+ * a power of two)
+ *
+ */
+#define UNWIND_FUNCTION_CACHE_SIZE 256
+
+/**
+ * @brief Number of runtime functions (.pdata entries) in each chunk of the
+ * cached exception directories
+ *
+ */
+#define UNWIND_TABLE_CHUNK_FUNCTIONS 256
+
+/**
+ * @brief Number of chunks of the exception directories that are cached
+ * (should be a power of two)
+ *
+ */
+#define UNWIND_TABLE_CACHE_SIZE 32
+
+/**
+ * @brief Number of the addresses that are known not to be in an image
+ * (should be a power of two)
+ *
+ */
+#define UNWIND_NEGATIVE_CACHE_SIZE 64
+
+/**
+ * @brief Number of lookups that an address remains in the negative cache
+ * (an image might be loaded at that address later)
+ *
+ */
+#define UNWIND_NEGATIVE_CACHE_LIFETIME 0x1000
+
+/**
+ * @brief Maximum number of candidate addresses that are probed (backward)
+ * to find the header of the image that contains an address
+ *
+ */
+#define UNWIND_MAXIMUM_IMAGE_SCAN_PROBES 0x400
+
+/**
+ * @brief Alignment of the user-mode images (allocation granularity), the
+ * kernel-mode images are only page aligned
+ *
+ */
+#define UNWIND_USER_IMAGE_ALIGNMENT 0x10000
+
+/**
+ * @brief Maximum number of chained unwind info structures of a function
+ *
+ */
+#define UNWIND_MAXIMUM_CHAINED_INFO 32
+
+/**
+ * @brief Maximum number of unwind codes (slots) of an unwind info
+ *
+ */
+#define UNWIND_MAXIMUM_CODES 256
+
+/**
+ * @brief Maximum length of an epilog that is emulated
+ *
+ */
+#define UNWIND_MAXIMUM_EPILOG_LENGTH 32
+
+/**
+ * @brief Size of the pages that are scanned for the image headers
+ *
+ */
+#define UNWIND_PAGE_SIZE 0x1000
+
+/**
+ * @brief Index of the stack pointer in the registers of the context
+ *
+ */
+#define UNWIND_REGISTER_RSP 4
+
+/**
+ * @brief PE constants that are used by the unwinder
+ *
+ */
+#define UNWIND_IMAGE_DOS_SIGNATURE             0x5a4d     // MZ
+#define UNWIND_IMAGE_NT_SIGNATURE              0x00004550 // PE00
+#define UNWIND_IMAGE_NT_OPTIONAL_HDR64_MAGIC   0x20b
+#define UNWIND_IMAGE_DOS_HEADER_LFANEW_OFFSET  0x3c
+#define UNWIND_IMAGE_DIRECTORY_ENTRY_EXCEPTION 3
+
+/**
+ * @brief Offsets of the fields in IMAGE_NT_HEADERS64 that are used by the
+ * unwinder
+ *
+ */
+#define UNWIND_IMAGE_NT_HEADERS_TIME_DATE_STAMP_OFFSET         0x08
+#define UNWIND_IMAGE_NT_HEADERS_MAGIC_OFFSET                   0x18
+#define UNWIND_IMAGE_NT_HEADERS_SIZE_OF_IMAGE_OFFSET           0x50
+#define UNWIND_IMAGE_NT_HEADERS_NUMBER_OF_RVA_AND_SIZES_OFFSET 0x84
+#define UNWIND_IMAGE_NT_HEADERS_DATA_DIRECTORY_OFFSET          0x88
+#define UNWIND_IMAGE_NT_HEADERS64_SIZE                         0x108
+
+/**
+ * @brief Flags of the unwind info
+ *
+ */
+#define UNWIND_FLAG_CHAININFO 0x4
+
+//////////////////////////////////////////////////
+//				   Enums						//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Operations of the unwind codes
+ *
+ */
+typedef enum _UNWIND_OPERATION
+{
+    UNWIND_OPERATION_PUSH_NONVOL     = 0,
+    UNWIND_OPERATION_ALLOC_LARGE     = 1,
+    UNWIND_OPERATION_ALLOC_SMALL     = 2,
+    UNWIND_OPERATION_SET_FPREG       = 3,
+    UNWIND_OPERATION_SAVE_NONVOL     = 4,
+    UNWIND_OPERATION_SAVE_NONVOL_FAR = 5,
+    UNWIND_OPERATION_EPILOG          = 6, // Version 2 (UWOP_SAVE_XMM in version 1)
+    UNWIND_OPERATION_SPARE_CODE      = 7, // UWOP_SAVE_XMM_FAR in version 1
+    UNWIND_OPERATION_SAVE_XMM128     = 8,
+    UNWIND_OPERATION_SAVE_XMM128_FAR = 9,
+    UNWIND_OPERATION_PUSH_MACHFRAME  = 10,
+
+} UNWIND_OPERATION;
+
+/**
+ * @brief Result of unwinding a frame
+ *
+ */
+typedef enum _UNWIND_STATUS
+{
+    UNWIND_STATUS_SUCCESS,
+    UNWIND_STATUS_NO_UNWIND_DATA,
+    UNWIND_STATUS_INVALID_MEMORY,
+    UNWIND_STATUS_INVALID_UNWIND_DATA,
+
+} UNWIND_STATUS;
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief An entry of the exception directory (.pdata) of x64 images
+ *
+ */
+typedef struct _UNWIND_RUNTIME_FUNCTION
+{
+    UINT32 BeginAddress;
+    UINT32 EndAddress;
+    UINT32 UnwindData;
+
+} UNWIND_RUNTIME_FUNCTION, *PUNWIND_RUNTIME_FUNCTION;
+
+/**
+ * @brief The header of the unwind info (.xdata)
+ *
+ */
+typedef struct _UNWIND_INFO_HEADER
+{
+    UINT8 Version : 3;
+    UINT8 Flags : 5;
+    UINT8 SizeOfProlog;
+    UINT8 CountOfCodes;
+    UINT8 FrameRegister : 4;
+    UINT8 FrameOffset : 4;
+
+} UNWIND_INFO_HEADER, *PUNWIND_INFO_HEADER;
+
+/**
+ * @brief An unwind code (slot) of the unwind info
+ *
+ */
+typedef union _UNWIND_CODE
+{
+    struct
+    {
+        UINT8 CodeOffset;
+        UINT8 UnwindOperation : 4;
+        UINT8 OperationInfo : 4;
+    };
+
+    UINT16 FrameOffset;
+
+} UNWIND_CODE, *PUNWIND_CODE;
+
+/**
+ * @brief The registers that are restored by unwinding a frame
+ * @details Registers are indexed by their x64 encoding (rax, rcx, rdx,
+ * rbx, rsp, rbp, rsi, rdi, r8 - r15) which is the same as GUEST_REGS
+ *
+ */
+typedef struct _UNWIND_CONTEXT
+{
+    UINT64 Rip;
+    UINT64 Registers[16];
+
+} UNWIND_CONTEXT, *PUNWIND_CONTEXT;
+
+/**
+ * @brief A module that its unwind table is cached
+ *
+ */
+typedef struct _UNWIND_MODULE
+{
+    UINT64 AddressSpace;
+    UINT64 ImageBase;
+    UINT32 SizeOfImage;
+    UINT32 TimeDateStamp;
+    UINT32 NtHeadersOffset;
+    UINT32 ExceptionDirectoryRva;
+    UINT32 FunctionCount;
+    UINT64 LastUsed;
+
+} UNWIND_MODULE, *PUNWIND_MODULE;
+
+/**
+ * @brief A cached result of looking up the function of an address
+ *
+ */
+typedef struct _UNWIND_FUNCTION_CACHE_ENTRY
+{
+    UINT64                  AddressSpace;
+    UINT64                  ImageBase;
+    UNWIND_RUNTIME_FUNCTION Function;
+
+} UNWIND_FUNCTION_CACHE_ENTRY, *PUNWIND_FUNCTION_CACHE_ENTRY;
+
+/**
+ * @brief A cached chunk of the exception directory of a module
+ *
+ */
+typedef struct _UNWIND_TABLE_CHUNK
+{
+    UINT64                  AddressSpace;
+    UINT64                  ImageBase;
+    UINT32                  TimeDateStamp;
+    UINT32                  ChunkIndex;
+    UINT32                  FunctionCount; // Zero if the chunk is not used
+    UNWIND_RUNTIME_FUNCTION Functions[UNWIND_TABLE_CHUNK_FUNCTIONS];
+
+} UNWIND_TABLE_CHUNK, *PUNWIND_TABLE_CHUNK;
+
+/**
+ * @brief An address that is known not to be in an image
+ *
+ */
+typedef struct _UNWIND_NEGATIVE_CACHE_ENTRY
+{
+    UINT64 AddressSpace;
+    UINT64 PageAddress;
+    UINT64 ExpirationTime; // Zero if the entry is not used
+
+} UNWIND_NEGATIVE_CACHE_ENTRY, *PUNWIND_NEGATIVE_CACHE_ENTRY;
+
+/**
+ * @brief Reads the memory of the target (returns FALSE if the memory is
+ * not accessible)
+ *
+ */
+typedef BOOLEAN (*UNWIND_READ_MEMORY)(UINT64 Address, PVOID Buffer, UINT32 Size);
+
+/**
+ * @brief The state (and the caches) of the unwinder
+ * @details Modules on the upper half of the address space (kernel modules)
+ * are shared between all address spaces. The state is not synchronized, the
+ * caller should serialize the calls
+ *
+ */
+typedef struct _UNWIND_STATE
+{
+    UNWIND_READ_MEMORY          ReadMemory;
+    UINT64                      UseCounter;
+    UINT32                      ModuleCount;
+    UNWIND_MODULE               Modules[UNWIND_MAXIMUM_CACHED_MODULES];
+    UNWIND_FUNCTION_CACHE_ENTRY FunctionCache[UNWIND_FUNCTION_CACHE_SIZE];
+    UNWIND_TABLE_CHUNK          TableCache[UNWIND_TABLE_CACHE_SIZE];
+    UNWIND_NEGATIVE_CACHE_ENTRY NegativeCache[UNWIND_NEGATIVE_CACHE_SIZE];
+
+} UNWIND_STATE, *PUNWIND_STATE;
+
+//////////////////////////////////////////////////
+//					Functions					//
+//////////////////////////////////////////////////
+
+VOID
+UnwindInitialize(PUNWIND_STATE State, UNWIND_READ_MEMORY ReadMemory);
+
+VOID
+UnwindFlushCache(PUNWIND_STATE State);
+
+VOID
+UnwindInvalidateModule(PUNWIND_STATE State, PUNWIND_MODULE Module);
+
+BOOLEAN
+UnwindReadRuntimeFunction(PUNWIND_STATE            State,
+                          PUNWIND_MODULE           Module,
+                          UINT32                   Index,
+                          PUNWIND_RUNTIME_FUNCTION Function);
+
+PUNWIND_MODULE
+UnwindFindModule(PUNWIND_STATE State, UINT64 AddressSpace, UINT64 Address);
+
+UNWIND_STATUS
+UnwindLookupFunction(PUNWIND_STATE            State,
+                     UINT64                   AddressSpace,
+                     UINT64                   Address,
+                     PUINT64                  ImageBase,
+                     PUNWIND_RUNTIME_FUNCTION Function);
+
+BOOLEAN
+UnwindEmulateEpilog(PUNWIND_STATE State, PUNWIND_CONTEXT Context, PUINT64 ReturnAddressLocation);
+
+UNWIND_STATUS
+UnwindVirtualUnwind(PUNWIND_STATE            State,
+                    UINT64                   ImageBase,
+                    PUNWIND_RUNTIME_FUNCTION Function,
+                    PUNWIND_CONTEXT          Context,
+                    PUINT64                  ReturnAddressLocation);
+
+UNWIND_STATUS
+UnwindStep(PUNWIND_STATE   State,
+           UINT64          AddressSpace,
+           PUNWIND_CONTEXT Context,
+           PUINT64         ReturnAddressLocation);
@@ -36,10 +36,14 @@ CommandEventsHelp()
     ShowMessages("syntax : \tevents\n");
     ShowMessages("syntax : \tevents [e|d|c all|EventNumber (hex)]\n");
     ShowMessages("syntax : \tevents [sc State (on|off)]\n");
+    ShowMessages("syntax : \tevents [cost]\n");
+    ShowMessages("syntax : \tevents [cost State (on|off)]\n");
 
     ShowMessages("e : enable\n");
     ShowMessages("d : disable\n");
     ShowMessages("c : clear\n");
+    ShowMessages("cost : shows the costs of events (sorted by the spent cycles), or turns "
+                 "accounting the costs on or off (it's off by default)\n");
 
     ShowMessages("note : If you specify 'all' then e, d, or c will be applied to "
                  "all of the events.\n\n");
@@ -52,6 +56,9 @@ CommandEventsHelp()
     ShowMessages("\te.g : events c all\n");
     ShowMessages("\te.g : events sc on\n");
     ShowMessages("\te.g : events sc off\n");
+    ShowMessages("\te.g : events cost on\n");
+    ShowMessages("\te.g : events cost\n");
+    ShowMessages("\te.g : events cost off\n");
 }
 
 /**
@@ -71,7 +78,7 @@ CommandEvents(vector<CommandToken> CommandTokens, string Command)
     //
     // Validate the parameters (size)
     //
-    if (CommandTokens.size() != 1 && CommandTokens.size() != 3)
+    if (CommandTokens.size() != 1 && CommandTokens.size() != 2 && CommandTokens.size() != 3)
     {
         ShowMessages("incorrect use of the '%s'\n\n",
                      GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
@@ -79,6 +86,30 @@ CommandEvents(vector<CommandToken> CommandTokens, string Command)
         return;
     }
 
+    if (CommandTokens.size() == 2)
+    {
+        if (!CompareLowerCaseStrings(CommandTokens.at(1), "cost"))
+        {
+            ShowMessages("incorrect use of the '%s'\n\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
+            CommandEventsHelp();
+            return;
+        }
+
+        if (!g_EventTraceInitialized)
+        {
+            ShowMessages("no active/disabled events \n");
+            return;
+        }
+
+        CommandEventsShowEventsCosts();
+
+        //
+        // No need to continue any further
+        //
+        return;
+    }
+
     if (CommandTokens.size() == 1)
     {
         if (!g_EventTraceInitialized)
@@ -134,6 +165,29 @@ CommandEvents(vector<CommandToken> CommandTokens, string Command)
         //
         return;
     }
+    else if (CompareLowerCaseStrings(CommandTokens.at(1), "cost"))
+    {
+        if (CompareLowerCaseStrings(CommandTokens.at(2), "on"))
+        {
+            CommandEventsModifyAndQueryEvents(DEBUGGER_MODIFY_EVENTS_APPLY_TO_ALL_TAG, DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS);
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(2), "off"))
+        {
+            CommandEventsModifyAndQueryEvents(DEBUGGER_MODIFY_EVENTS_APPLY_TO_ALL_TAG, DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS);
+        }
+        else
+        {
+            ShowMessages(
+                "please specify a correct 'on' or 'off' state for accounting the costs\n\n");
+            CommandEventsHelp();
+            return;
+        }
+
+        //
+        // No need to further continue
+        //
+        return;
+    }
     else
     {
         //
@@ -221,6 +275,154 @@ CommandEventQueryEventState(UINT64 Tag)
     return FALSE;
 }
 
+/**
+ * @brief Query the kernel for the costs of an event
+ *
+ * @param Tag the tag of the target event
+ * @param Costs the merged costs of the event from all cores
+ * @return BOOLEAN if the operation was successful then it returns
+ * true otherwise it returns false
+ */
+BOOLEAN
+CommandEventQueryEventCosts(UINT64 Tag, PDEBUGGER_EVENT_COSTS Costs)
+{
+    BOOLEAN                Status;
+    ULONG                  ReturnedLength;
+    DEBUGGER_MODIFY_EVENTS QueryCostsRequest = {0};
+
+    if (g_IsSerialConnectedToRemoteDebuggee)
+    {
+        //
+        // It's a remote debugger in Debugger Mode
+        //
+        return KdSendEventQueryCostsPacketToDebuggee(Tag, Costs);
+    }
+
+    //
+    // It's a local debugging in VMI Mode
+    //
+    AssertShowMessageReturnStmt(g_DeviceHandle, ASSERT_MESSAGE_DRIVER_NOT_LOADED, AssertReturnFalse);
+
+    //
+    // Fill the structure to send it to the kernel
+    //
+    QueryCostsRequest.Tag          = Tag;
+    QueryCostsRequest.TypeOfAction = DEBUGGER_MODIFY_EVENTS_QUERY_COSTS;
+
+    //
+    // Send the request to the kernel
+    //
+    Status =
+        DeviceIoControl(g_DeviceHandle,                // Handle to device
+                        IOCTL_DEBUGGER_MODIFY_EVENTS,  // IO Control Code (IOCTL)
+                        &QueryCostsRequest,            // Input Buffer to driver.
+                        SIZEOF_DEBUGGER_MODIFY_EVENTS, // Input buffer length
+                        &QueryCostsRequest,            // Output Buffer from driver.
+                        SIZEOF_DEBUGGER_MODIFY_EVENTS, // Length of output
+                                                       // buffer in bytes.
+                        &ReturnedLength,               // Bytes placed in buffer.
+                        NULL                           // synchronous call
+        );
+
+    if (!Status)
+    {
+        ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
+        return FALSE;
+    }
+
+    if (QueryCostsRequest.KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+    {
+        ShowErrorMessage((UINT32)QueryCostsRequest.KernelStatus);
+        return FALSE;
+    }
+
+    memcpy(Costs, &QueryCostsRequest.Costs, sizeof(DEBUGGER_EVENT_COSTS));
+
+    return TRUE;
+}
+
+/**
+ * @brief print the costs of every active and disabled events
+ * @details events are sorted by the cycles that are spent on them
+ * @return VOID
+ */
+VOID
+CommandEventsShowEventsCosts()
+{
+    PLIST_ENTRY                                                        TempList = 0;
+    vector<pair<PDEBUGGER_GENERAL_EVENT_DETAIL, DEBUGGER_EVENT_COSTS>> EventsCosts;
+
+    TempList = &g_EventTrace;
+    while (&g_EventTrace != TempList->Blink)
+    {
+        TempList = TempList->Blink;
+
+        PDEBUGGER_GENERAL_EVENT_DETAIL CommandDetail = CONTAINING_RECORD(TempList, DEBUGGER_GENERAL_EVENT_DETAIL, CommandsEventList);
+        DEBUGGER_EVENT_COSTS           Costs         = {0};
+
+        if (!CommandEventQueryEventCosts(CommandDetail->Tag, &Costs))
+        {
+            ShowMessages("err, unable to get the costs of the event (%x)\n",
+                         CommandDetail->Tag - DebuggerEventTagStartSeed);
+            continue;
+        }
+
+        EventsCosts.push_back({CommandDetail, Costs});
+    }
+
+    if (EventsCosts.empty())
+    {
+        ShowMessages("no active/disabled events \n");
+        return;
+    }
+
+    //
+    // The untracked triggers are counted for all events
+    //
+    if (EventsCosts.front().second.UntrackedTriggers != 0)
+    {
+        ShowMessages("%llu trigger(s) of the events are not tracked (too many alive events)\n",
+                     EventsCosts.front().second.UntrackedTriggers);
+    }
+
+    //
+    // The most expensive events come first
+    //
+    std::sort(EventsCosts.begin(), EventsCosts.end(), [](const auto & A, const auto & B) {
+        return A.second.Cycles > B.second.Cycles;
+    });
+
+    ShowMessages("id\ttriggered         cond-false        script-instr      cycles            avg-cycles        command\n");
+
+    for (auto & Item : EventsCosts)
+    {
+        string CommandMessage((char *)Item.first->CommandStringBuffer);
+
+        //
+        // Do not show the \n(s)
+        //
+        ReplaceAll(CommandMessage, "\n", " ");
+
+        //
+        // Only show portion of message
+        //
+        if (CommandMessage.length() > 40)
+        {
+            CommandMessage = CommandMessage.substr(0, 40);
+            CommandMessage += "...";
+        }
+
+        ShowMessages("%llx\t%-16llx  %-16llx  %-16llx  %-16llx  %-16llx  %s\n",
+                     Item.first->Tag - DebuggerEventTagStartSeed,
+                     Item.second.TriggerCount,
+                     Item.second.ConditionFalseCount,
+                     Item.second.ScriptInstructionCount,
+                     Item.second.Cycles,
+                     Item.second.TriggerCount == 0 ? 0 : Item.second.Cycles / Item.second.TriggerCount,
+                     CommandMessage.c_str());
+    }
+}
+
 /**
  * @brief print every active and disabled events
  * @details this function will not show cleared events
@@ -618,8 +820,14 @@ CommandEventsHandleModifiedEvent(
                 }
             }
         }
-        else if (ModifyEventRequest->TypeOfAction ==
-                 DEBUGGER_MODIFY_EVENTS_QUERY_STATE)
+        else if (ModifyEventRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS ||
+                 ModifyEventRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS)
+        {
+            ShowMessages("accounting the costs of events changed to %s\n",
+                         ModifyEventRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS ? "'on'" : "'off'");
+        }
+        else if (ModifyEventRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_QUERY_STATE ||
+                 ModifyEventRequest->TypeOfAction == DEBUGGER_MODIFY_EVENTS_QUERY_COSTS)
         {
             //
             // Nothing to show
@@ -670,7 +878,11 @@ CommandEventsModifyAndQueryEvents(UINT64                      Tag,
     // tag too, but let's not send it to kernel as we can prevent
     // invalid requests from user-mode too
     //
-    if (!IsTagExist(Tag))
+    // Accounting the costs can be turned on or off even if there is no event
+    //
+    if (TypeOfAction != DEBUGGER_MODIFY_EVENTS_ENABLE_COSTS &&
+        TypeOfAction != DEBUGGER_MODIFY_EVENTS_DISABLE_COSTS &&
+        !IsTagExist(Tag))
     {
         if (Tag == DEBUGGER_MODIFY_EVENTS_APPLY_TO_ALL_TAG)
         {
@@ -37,11 +37,22 @@ CommandIHelp()
     ShowMessages("syntax : \ti [Count (hex)]\n");
     ShowMessages("syntax : \tir\n");
     ShowMessages("syntax : \tir [Count (hex)]\n");
+    ShowMessages("syntax : \ti [Count (hex)] trace [regs [Mask (hex)]] [mem] [until Address (hex)] [file Path]\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : i\n");
     ShowMessages("\t\te.g : ir\n");
     ShowMessages("\t\te.g : ir 1f\n");
+    ShowMessages("\t\te.g : i 10000 trace\n");
+    ShowMessages("\t\te.g : i 10000 trace regs 11 until nt!ExAllocatePoolWithTag\n");
+    ShowMessages("\t\te.g : i 1000 trace mem\n");
+    ShowMessages("\t\te.g : i 100000 trace regs file c:\\traces\\trace.hdt\n");
+
+    ShowMessages("\n");
+    ShowMessages("batched steps (trace) are performed in the debuggee and only the records "
+                 "(rip, registers, or memory operands) are sent to the debugger, bits of the "
+                 "register mask are rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8-r15 (bits 0 to f) "
+                 "and rflags (bit 10).\n");
 }
 
 /**
@@ -55,18 +66,8 @@ CommandIHelp()
 VOID
 CommandI(vector<CommandToken> CommandTokens, string Command)
 {
-    UINT32 StepCount;
-
-    //
-    // Validate the commands
-    //
-    if (CommandTokens.size() != 1 && CommandTokens.size() != 2)
-    {
-        ShowMessages("incorrect use of the '%s'\n\n",
-                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
-        CommandIHelp();
-        return;
-    }
+    UINT32                         StepCount;
+    STEPPING_BATCHED_STEPS_OPTIONS BatchedStepsOptions;
 
     //
     // Check if we're in VMI mode
@@ -80,7 +81,7 @@ CommandI(vector<CommandToken> CommandTokens, string Command)
     //
     // Check if the command has a counter parameter
     //
-    if (CommandTokens.size() == 2)
+    if (CommandTokens.size() >= 2)
     {
         if (!ConvertTokenToUInt32(CommandTokens.at(1), &StepCount))
         {
@@ -94,6 +95,24 @@ CommandI(vector<CommandToken> CommandTokens, string Command)
         StepCount = 1;
     }
 
+    //
+    // Check for the batched steps (the steps are performed in the debuggee)
+    //
+    if (!SteppingParseBatchedStepsOptions(CommandTokens,
+                                          2,
+                                          CompareLowerCaseStrings(CommandTokens.at(0), "ir"),
+                                          &BatchedStepsOptions))
+    {
+        CommandIHelp();
+        return;
+    }
+
+    if (BatchedStepsOptions.IsBatched)
+    {
+        SteppingPerformBatchedSteps(DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN, StepCount, &BatchedStepsOptions);
+        return;
+    }
+
     //
     // Check if the remote serial debuggee or user debugger are paused or not
     //
@@ -34,11 +34,22 @@ CommandPHelp()
     ShowMessages("syntax : \tp [Count (hex)]\n");
     ShowMessages("syntax : \tpr\n");
     ShowMessages("syntax : \tpr [Count (hex)]\n");
+    ShowMessages("syntax : \tp [Count (hex)] trace [regs [Mask (hex)]] [mem] [until Address (hex)] [file Path]\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : p\n");
     ShowMessages("\t\te.g : pr\n");
     ShowMessages("\t\te.g : pr 1f\n");
+    ShowMessages("\t\te.g : p 10000 trace\n");
+    ShowMessages("\t\te.g : p 10000 trace regs 11 until nt!ExAllocatePoolWithTag\n");
+    ShowMessages("\t\te.g : p 1000 trace mem\n");
+    ShowMessages("\t\te.g : p 100000 trace regs file c:\\traces\\trace.hdt\n");
+
+    ShowMessages("\n");
+    ShowMessages("batched steps (trace) are performed in the debuggee and only the records "
+                 "(rip, registers, or memory operands) are sent to the debugger, bits of the "
+                 "register mask are rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8-r15 (bits 0 to f) "
+                 "and rflags (bit 10).\n");
 }
 
 /**
@@ -54,17 +65,7 @@ CommandP(vector<CommandToken> CommandTokens, string Command)
 {
     UINT32                           StepCount;
     DEBUGGER_REMOTE_STEPPING_REQUEST RequestFormat;
-
-    //
-    // Validate the commands
-    //
-    if (CommandTokens.size() != 1 && CommandTokens.size() != 2)
-    {
-        ShowMessages("incorrect use of the '%s'\n\n",
-                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
-        CommandPHelp();
-        return;
-    }
+    STEPPING_BATCHED_STEPS_OPTIONS   BatchedStepsOptions;
 
     //
     // Set type of request
@@ -74,7 +75,7 @@ CommandP(vector<CommandToken> CommandTokens, string Command)
     //
     // Check if the command has a counter parameter
     //
-    if (CommandTokens.size() == 2)
+    if (CommandTokens.size() >= 2)
     {
         if (!ConvertTokenToUInt32(CommandTokens.at(1), &StepCount))
         {
@@ -88,6 +89,24 @@ CommandP(vector<CommandToken> CommandTokens, string Command)
         StepCount = 1;
     }
 
+    //
+    // Check for the batched steps (the steps are performed in the debuggee)
+    //
+    if (!SteppingParseBatchedStepsOptions(CommandTokens,
+                                          2,
+                                          CompareLowerCaseStrings(CommandTokens.at(0), "pr"),
+                                          &BatchedStepsOptions))
+    {
+        CommandPHelp();
+        return;
+    }
+
+    if (BatchedStepsOptions.IsBatched)
+    {
+        SteppingPerformBatchedSteps(RequestFormat, StepCount, &BatchedStepsOptions);
+        return;
+    }
+
     //
     // Check if the remote serial debuggee or user debugger are paused or not
     //
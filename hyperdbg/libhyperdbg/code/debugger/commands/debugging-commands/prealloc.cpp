@@ -30,6 +30,8 @@ CommandPreallocHelp()
     ShowMessages("\t\te.g : prealloc epthook2 3\n");
     ShowMessages("\t\te.g : prealloc regular-event 12\n");
     ShowMessages("\t\te.g : prealloc big-safe-buffert 1\n");
+    ShowMessages("\t\te.g : prealloc snapshot 4000\n");
+    ShowMessages("\t\te.g : prealloc dirty-logging 1\n");
 
     ShowMessages("\n");
     ShowMessages("type of allocations:\n");
@@ -41,6 +43,8 @@ CommandPreallocHelp()
     ShowMessages("\tbig-event: used for pre-allocations of big instant events\n");
     ShowMessages("\tregular-safe-buffer: used for pre-allocations of the regular event safe buffers ($buffer) for instant events\n");
     ShowMessages("\tbig-safe-buffer: used for pre-allocations of the big event safe buffers ($buffer) for instant events\n");
+    ShowMessages("\tsnapshot: used for pre-allocations of the copies of the pages (count of pages) of the '!snapshot' command\n");
+    ShowMessages("\tdirty-logging: used for pre-allocations of the dirty bitmap and the PML buffers for logging the dirty pages (count is ignored)\n");
 }
 
 /**
@@ -105,6 +109,14 @@ CommandPrealloc(vector<CommandToken> CommandTokens, string Command)
     {
         PreallocRequest.Type = DEBUGGER_PREALLOC_COMMAND_TYPE_BIG_SAFE_BUFFER;
     }
+    else if (!SecondParam.compare("snapshot") || !SecondParam.compare("!snapshot"))
+    {
+        PreallocRequest.Type = DEBUGGER_PREALLOC_COMMAND_TYPE_SNAPSHOT;
+    }
+    else if (!SecondParam.compare("dirty-logging"))
+    {
+        PreallocRequest.Type = DEBUGGER_PREALLOC_COMMAND_TYPE_DIRTY_LOGGING;
+    }
     else
     {
         //
@@ -25,9 +25,10 @@ extern ACTIVE_DEBUGGING_PROCESS g_ActiveProcessDebuggingState;
 VOID
 CommandSearchMemoryHelp()
 {
-    ShowMessages("sb !sb sd !sd sq !sq : searches a contiguous memory for a "
+    ShowMessages("sb !sb sw !sw sd !sd sq !sq : searches a contiguous memory for a "
                  "special byte pattern\n");
     ShowMessages("sb  Byte and ASCII characters\n");
+    ShowMessages("sw  Word values (2 bytes)\n");
     ShowMessages("sd  Double-word values (4 bytes)\n");
     ShowMessages("sq  Quad-word values (8 bytes). \n");
 
@@ -35,7 +36,12 @@ CommandSearchMemoryHelp()
         "\n If you want to search in physical (address) memory then add '!' "
         "at the start of the command\n");
 
+    ShowMessages(
+        "\n Each hex digit of the pattern can be a '?' wildcard, pages that are "
+        "not present are skipped\n");
+
     ShowMessages("syntax : \tsb [StartAddress (hex)] [l Length (hex)] [BytePattern (hex)] [pid ProcessId (hex)]\n");
+    ShowMessages("syntax : \tsw [StartAddress (hex)] [l Length (hex)] [BytePattern (hex)] [pid ProcessId (hex)]\n");
     ShowMessages("syntax : \tsd [StartAddress (hex)] [l Length (hex)] [BytePattern (hex)] [pid ProcessId (hex)]\n");
     ShowMessages("syntax : \tsq [StartAddress (hex)] [l Length (hex)] [BytePattern (hex)] [pid ProcessId (hex)]\n");
 
@@ -44,7 +50,10 @@ CommandSearchMemoryHelp()
     ShowMessages("\t\te.g : sb nt!ExAllocatePoolWithTag+5 90 85 95 l ffff \n");
     ShowMessages("\t\te.g : sb @rcx+5 90 85 95 l ffff \n");
     ShowMessages("\t\te.g : sb fffff8077356f010 90 85 95 l ffff \n");
+    ShowMessages("\t\te.g : sb nt!ExAllocatePoolWithTag 48 8b ?? 24 l ffff \n");
+    ShowMessages("\t\te.g : sw fffff8077356f010 8b48 l ffff \n");
     ShowMessages("\t\te.g : sd fffff8077356f010 90423580 l ffff pid 1c0 \n");
+    ShowMessages("\t\te.g : sd fffff8077356f010 9042??8? l ffff \n");
     ShowMessages("\t\te.g : !sq 100000 9090909090909090 l ffff\n");
     ShowMessages("\t\te.g : !sq @rdx+r12 9090909090909090 l ffff\n");
     ShowMessages("\t\te.g : !sq 100000 9090909090909090 9090909090909090 "
@@ -61,70 +70,47 @@ CommandSearchMemoryHelp()
 VOID
 CommandSearchSendRequest(UINT64 * BufferToSendAsIoctl, UINT32 BufferToSendAsIoctlSize)
 {
-    BOOL    Status;
-    UINT64  CurrentValue;
-    PUINT64 ResultsBuffer = NULL;
+    BOOL                             Status;
+    DEBUGGEE_RESULT_OF_SEARCH_PACKET SearchResult = {0};
 
     //
-    // Allocate a buffer to store the results
-    //
-    ResultsBuffer = (PUINT64)malloc(MaximumSearchResults * sizeof(UINT64));
-
-    //
-    // Also it's better to Zero the memory; however it's not necessary
-    // as we zero the buffer in the search routines
-    //
-    ZeroMemory(ResultsBuffer, MaximumSearchResults * sizeof(UINT64));
-
-    //
-    // Fire the IOCTL
+    // Fire the IOCTL, the results are sent as messages once they're
+    // found, so only the result of the search is returned here
     //
     Status =
-        DeviceIoControl(g_DeviceHandle,               // Handle to device
-                        IOCTL_DEBUGGER_SEARCH_MEMORY, // IO Control Code (IOCTL)
-                        BufferToSendAsIoctl,          // Input Buffer to driver.
-                        BufferToSendAsIoctlSize,      // Input buffer length
-                        ResultsBuffer,                // Output Buffer from driver.
-                        MaximumSearchResults *
-                            sizeof(UINT64), // Length of output buffer in bytes.
-                        NULL,               // Bytes placed in buffer.
-                        NULL                // synchronous call
+        DeviceIoControl(g_DeviceHandle,                           // Handle to device
+                        IOCTL_DEBUGGER_SEARCH_MEMORY,             // IO Control Code (IOCTL)
+                        BufferToSendAsIoctl,                      // Input Buffer to driver.
+                        BufferToSendAsIoctlSize,                  // Input buffer length
+                        &SearchResult,                            // Output Buffer from driver.
+                        sizeof(DEBUGGEE_RESULT_OF_SEARCH_PACKET), // Length of output buffer in bytes.
+                        NULL,                                     // Bytes placed in buffer.
+                        NULL                                      // synchronous call
         );
 
     if (!Status)
     {
         ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
-
-        free(ResultsBuffer);
         return;
     }
 
-    //
-    // Show the results (if any)
-    //
-    for (size_t i = 0; i < MaximumSearchResults; i++)
+    if (SearchResult.Result == DEBUGGER_OPERATION_WAS_SUCCESSFUL)
     {
-        CurrentValue = ResultsBuffer[i];
-
-        if (CurrentValue == NULL)
+        if (SearchResult.CountOfResults == 0)
         {
-            //
-            // We ended up the buffer, nothing else to show,
-            // just check whether we found anything or not
-            //
-            if (i == 0)
-            {
-                ShowMessages("not found\n");
-            }
-            break;
+            ShowMessages("not found\n");
+        }
+        else if (SearchResult.CountOfResults >= MaximumSearchResults)
+        {
+            ShowMessages("the search is stopped after 0x%x results, search a smaller range "
+                         "to see the other results\n",
+                         MaximumSearchResults);
         }
-        ShowMessages("%llx\n", CurrentValue);
     }
-
-    //
-    // Free buffer
-    //
-    free(ResultsBuffer);
+    else
+    {
+        ShowErrorMessage(SearchResult.Result);
+    }
 }
 
 /**
@@ -140,6 +126,7 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
 {
     UINT64                 Address;
     vector<UINT64>         ValuesToEdit;
+    vector<UINT64>         MasksOfValues;
     BOOL                   SetAddress          = FALSE;
     BOOL                   SetValue            = FALSE;
     BOOL                   SetProcId           = FALSE;
@@ -148,6 +135,8 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
     BOOL                   NextIsLength        = FALSE;
     DEBUGGER_SEARCH_MEMORY SearchMemoryRequest = {0};
     UINT64                 Value               = 0;
+    UINT64                 Mask                = 0;
+    UINT32                 ChunkSize           = 0;
     UINT64                 Length              = 0;
     UINT32                 ProcId              = 0;
     UINT32                 CountOfValues       = 0;
@@ -184,6 +173,11 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
                 SearchMemoryRequest.MemoryType = SEARCH_PHYSICAL_MEMORY;
                 SearchMemoryRequest.ByteSize   = SEARCH_BYTE;
             }
+            else if (!FirstCommand.compare("!sw"))
+            {
+                SearchMemoryRequest.MemoryType = SEARCH_PHYSICAL_MEMORY;
+                SearchMemoryRequest.ByteSize   = SEARCH_WORD;
+            }
             else if (!FirstCommand.compare("!sd"))
             {
                 SearchMemoryRequest.MemoryType = SEARCH_PHYSICAL_MEMORY;
@@ -199,6 +193,11 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
                 SearchMemoryRequest.MemoryType = SEARCH_VIRTUAL_MEMORY;
                 SearchMemoryRequest.ByteSize   = SEARCH_BYTE;
             }
+            else if (!FirstCommand.compare("sw"))
+            {
+                SearchMemoryRequest.MemoryType = SEARCH_VIRTUAL_MEMORY;
+                SearchMemoryRequest.ByteSize   = SEARCH_WORD;
+            }
             else if (!FirstCommand.compare("sd"))
             {
                 SearchMemoryRequest.MemoryType = SEARCH_VIRTUAL_MEMORY;
@@ -334,6 +333,12 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
                 return;
             }
 
+            if (SearchMemoryRequest.ByteSize == SEARCH_WORD && TargetVal.size() >= 5)
+            {
+                ShowMessages("please specify a word (hex) value for 'sw' or '!sw'\n\n");
+                return;
+            }
+
             if (SearchMemoryRequest.ByteSize == SEARCH_DWORD && TargetVal.size() >= 9)
             {
                 ShowMessages("please specify a dword (hex) value for 'sd' or '!sd'\n\n");
@@ -346,6 +351,38 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
                 return;
             }
 
+            //
+            // Each '?' is a wildcard for a hex digit, the digits that are not
+            // specified (e.g., higher digits of '5' in 'sd') should be zero
+            //
+            if (SearchMemoryRequest.ByteSize == SEARCH_BYTE)
+            {
+                ChunkSize = 1;
+            }
+            else if (SearchMemoryRequest.ByteSize == SEARCH_WORD)
+            {
+                ChunkSize = 2;
+            }
+            else if (SearchMemoryRequest.ByteSize == SEARCH_DWORD)
+            {
+                ChunkSize = 4;
+            }
+            else
+            {
+                ChunkSize = 8;
+            }
+
+            Mask = ChunkSize == 8 ? MAXUINT64 : (1ull << (ChunkSize * 8)) - 1;
+
+            for (size_t i = 0; i < TargetVal.size(); i++)
+            {
+                if (TargetVal[TargetVal.size() - 1 - i] == '?')
+                {
+                    Mask &= ~(0xfull << (i * 4));
+                    TargetVal[TargetVal.size() - 1 - i] = '0';
+                }
+            }
+
             //
             // Qword is checked by the following function, no need to double
             // check it above.
@@ -362,7 +399,8 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
                 //
                 // Add it to the list
                 //
-                ValuesToEdit.push_back(Value);
+                ValuesToEdit.push_back(Value & Mask);
+                MasksOfValues.push_back(Mask);
 
                 //
                 // Keep track of values to modify
@@ -438,9 +476,10 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
     }
 
     //
-    // Now it's time to put everything together in one structure
+    // Now it's time to put everything together in one structure (values
+    // are followed by their masks)
     //
-    FinalSize = (CountOfValues * sizeof(UINT64)) + SIZEOF_DEBUGGER_SEARCH_MEMORY;
+    FinalSize = (2 * CountOfValues * sizeof(UINT64)) + SIZEOF_DEBUGGER_SEARCH_MEMORY;
 
     //
     // Set the size
@@ -482,6 +521,7 @@ CommandSearchMemory(vector<CommandToken> CommandTokens, string Command)
     // Put the values in 64 bit structures
     //
     std::copy(ValuesToEdit.begin(), ValuesToEdit.end(), (UINT64 *)((UINT64)FinalBuffer + SIZEOF_DEBUGGER_SEARCH_MEMORY));
+    std::copy(MasksOfValues.begin(), MasksOfValues.end(), (UINT64 *)((UINT64)FinalBuffer + SIZEOF_DEBUGGER_SEARCH_MEMORY) + CountOfValues);
 
     //
     // Check if it's a connection in debugger mode
@@ -38,6 +38,8 @@ CommandTestHelp()
     ShowMessages("\t\te.g : test breakpoint off\n");
     ShowMessages("\t\te.g : test trap on\n");
     ShowMessages("\t\te.g : test trap off\n");
+    ShowMessages("\t\te.g : test parser-performance\n");
+    ShowMessages("\t\te.g : test script-batch\n");
 }
 
 /**
@@ -146,6 +148,42 @@ CommandTestAllHwdbg()
     }
 }
 
+/**
+ * @brief measure the performance of the command parser
+ *
+ * @return VOID
+ */
+VOID
+CommandTestCommandParserPerformance()
+{
+    HANDLE ThreadHandle;
+    HANDLE ProcessHandle;
+
+    if (!OpenHyperDbgTestProcess(&ThreadHandle, &ProcessHandle, (CHAR *)TEST_CASE_PARAMETER_FOR_COMMAND_PARSER_PERFORMANCE))
+    {
+        ShowMessages("err, start HyperDbg test process for measuring the performance of the command parser\n");
+        return;
+    }
+}
+
+/**
+ * @brief measure the performance of batch scripts
+ *
+ * @return VOID
+ */
+VOID
+CommandTestScriptBatchPerformance()
+{
+    HANDLE ThreadHandle;
+    HANDLE ProcessHandle;
+
+    if (!OpenHyperDbgTestProcess(&ThreadHandle, &ProcessHandle, (CHAR *)TEST_CASE_PARAMETER_FOR_SCRIPT_BATCH_PERFORMANCE))
+    {
+        ShowMessages("err, start HyperDbg test process for measuring the performance of batch scripts\n");
+        return;
+    }
+}
+
 /**
  * @brief perform test on the remote process
  *
@@ -526,6 +564,20 @@ CommandTest(vector<CommandToken> CommandTokens, string Command)
         //
         CommandTestAllHwdbg();
     }
+    else if (CommandSize == 2 && CompareLowerCaseStrings(CommandTokens.at(1), "parser-performance"))
+    {
+        //
+        // For measuring the performance of the command parser
+        //
+        CommandTestCommandParserPerformance();
+    }
+    else if (CommandSize == 2 && CompareLowerCaseStrings(CommandTokens.at(1), "script-batch"))
+    {
+        //
+        // For measuring the performance of batch scripts
+        //
+        CommandTestScriptBatchPerformance();
+    }
     else
     {
         ShowMessages("incorrect use of the '%s'\n\n",
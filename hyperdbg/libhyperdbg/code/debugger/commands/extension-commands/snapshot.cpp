@@ -0,0 +1,319 @@
+/**
+ * @file snapshot.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief !snapshot command
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern BOOLEAN g_IsSerialConnectedToRemoteDebuggee;
+
+/**
+ * @brief help of the !snapshot command
+ *
+ * @return VOID
+ */
+VOID
+CommandSnapshotHelp()
+{
+    ShowMessages("!snapshot : takes a snapshot of a range of the physical memory and restores the modified pages.\n\n");
+
+    ShowMessages("syntax : \t!snapshot [take] [FromAddress (hex)] [ToAddress (hex)] [pages Count (hex)]\n");
+    ShowMessages("syntax : \t!snapshot [restore|discard]\n");
+
+    ShowMessages("\n");
+    ShowMessages("\t\te.g : !snapshot take 1000000 2000000\n");
+    ShowMessages("\t\te.g : !snapshot take 1000000 2000000 pages 8000\n");
+    ShowMessages("\t\te.g : !snapshot restore\n");
+    ShowMessages("\t\te.g : !snapshot\n");
+    ShowMessages("\t\te.g : !snapshot discard\n");
+
+    ShowMessages("\n");
+    ShowMessages("note : the original contents of each page is saved on its first write after taking the snapshot, "
+                 "the count of pages that could be saved is specified by the 'pages' parameter (default: %x). In the "
+                 "Debugger Mode, the pages should be preallocated by using the 'prealloc snapshot' command.\n",
+                 DEBUGGER_SNAPSHOT_DEFAULT_MAXIMUM_PAGES);
+    ShowMessages("note : the range should not contain the memory of the debugger itself (e.g., its buffers).\n");
+    ShowMessages("note : the time of restores is measured in TSC cycles.\n");
+}
+
+/**
+ * @brief Send snapshot requests
+ *
+ * @param SnapshotRequest
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandSnapshotSendRequest(PDEBUGGER_SNAPSHOT_REQUEST SnapshotRequest)
+{
+    BOOL  Status;
+    ULONG ReturnedLength;
+
+    if (g_IsSerialConnectedToRemoteDebuggee)
+    {
+        //
+        // Send the request over serial kernel debugger
+        //
+        if (!KdSendSnapshotActionPacketsToDebuggee(SnapshotRequest))
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        AssertShowMessageReturnStmt(g_DeviceHandle, ASSERT_MESSAGE_DRIVER_NOT_LOADED, AssertReturnFalse);
+
+        //
+        // Send IOCTL
+        //
+        Status = DeviceIoControl(
+            g_DeviceHandle,                    // Handle to device
+            IOCTL_PERFORM_ACTIONS_ON_SNAPSHOT, // IO Control Code (IOCTL)
+            SnapshotRequest,                   // Input Buffer to driver.
+            SIZEOF_DEBUGGER_SNAPSHOT_REQUEST,  // Input buffer length
+            SnapshotRequest,                   // Output Buffer from driver.
+            SIZEOF_DEBUGGER_SNAPSHOT_REQUEST,  // Length of output buffer in bytes.
+            &ReturnedLength,                   // Bytes placed in buffer.
+            NULL                               // synchronous call
+        );
+
+        if (!Status)
+        {
+            ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
+            return FALSE;
+        }
+    }
+
+    if (SnapshotRequest->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+    {
+        ShowErrorMessage(SnapshotRequest->KernelStatus);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Take a snapshot of a range of the physical memory
+ *
+ * @param StartAddress Start physical address (page aligned)
+ * @param EndAddress End physical address (page aligned)
+ * @param MaximumPages Count of pages that could be saved (zero for the
+ * default or the preallocated pages)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgSnapshotTake(UINT64 StartAddress, UINT64 EndAddress, UINT32 MaximumPages)
+{
+    DEBUGGER_SNAPSHOT_REQUEST SnapshotRequest = {0};
+
+    SnapshotRequest.RequestType  = DEBUGGER_SNAPSHOT_REQUEST_TYPE_TAKE;
+    SnapshotRequest.StartAddress = StartAddress;
+    SnapshotRequest.EndAddress   = EndAddress;
+    SnapshotRequest.MaximumPages = MaximumPages;
+
+    return CommandSnapshotSendRequest(&SnapshotRequest);
+}
+
+/**
+ * @brief Restore the pages that are modified since the snapshot (or the
+ * last restore)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgSnapshotRestore()
+{
+    DEBUGGER_SNAPSHOT_REQUEST SnapshotRequest = {0};
+
+    SnapshotRequest.RequestType = DEBUGGER_SNAPSHOT_REQUEST_TYPE_RESTORE;
+
+    return CommandSnapshotSendRequest(&SnapshotRequest);
+}
+
+/**
+ * @brief Discard the snapshot
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgSnapshotDiscard()
+{
+    DEBUGGER_SNAPSHOT_REQUEST SnapshotRequest = {0};
+
+    SnapshotRequest.RequestType = DEBUGGER_SNAPSHOT_REQUEST_TYPE_DISCARD;
+
+    return CommandSnapshotSendRequest(&SnapshotRequest);
+}
+
+/**
+ * @brief Query the statistics of the snapshot
+ *
+ * @param Statistics
+ * @param IsTaken
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgSnapshotQuery(PDEBUGGER_SNAPSHOT_STATISTICS Statistics, PBOOLEAN IsTaken)
+{
+    DEBUGGER_SNAPSHOT_REQUEST SnapshotRequest = {0};
+
+    SnapshotRequest.RequestType = DEBUGGER_SNAPSHOT_REQUEST_TYPE_QUERY;
+
+    if (!CommandSnapshotSendRequest(&SnapshotRequest))
+    {
+        return FALSE;
+    }
+
+    RtlCopyMemory(Statistics, &SnapshotRequest.Statistics, sizeof(DEBUGGER_SNAPSHOT_STATISTICS));
+
+    if (IsTaken != NULL)
+    {
+        *IsTaken = SnapshotRequest.IsTaken;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Show the statistics of the snapshot
+ *
+ * @param Statistics
+ *
+ * @return VOID
+ */
+VOID
+CommandSnapshotShowStatistics(const DEBUGGER_SNAPSHOT_STATISTICS * Statistics)
+{
+    ShowMessages("range: %llx - %llx (%llx pages)\n",
+                 Statistics->StartAddress,
+                 Statistics->EndAddress,
+                 (Statistics->EndAddress - Statistics->StartAddress) / PAGE_SIZE);
+
+    ShowMessages("saved pages: %x of %x, modified pages: %x\n",
+                 Statistics->CountOfSavedPages,
+                 Statistics->MaximumPages,
+                 Statistics->CountOfDirtyPages);
+
+    ShowMessages("write faults: %llu, dropped writes: %llu\n",
+                 Statistics->CountOfWriteFaults,
+                 Statistics->CountOfDroppedPages);
+
+    if (Statistics->IsPoolExhausted)
+    {
+        ShowMessages("warning, the pages of the snapshot are exhausted, some of the modified pages are not restored\n");
+    }
+
+    if (Statistics->CountOfRestores == 0)
+    {
+        ShowMessages("restores: 0\n");
+        return;
+    }
+
+    ShowMessages("restores: %llu, restored pages: %llu (%llu per restore)\n",
+                 Statistics->CountOfRestores,
+                 Statistics->CountOfRestoredPages,
+                 Statistics->CountOfRestoredPages / Statistics->CountOfRestores);
+
+    ShowMessages("restore time: last %llu, min %llu, avg %llu, max %llu\n",
+                 Statistics->LastRestoreCycles,
+                 Statistics->MinimumRestoreCycles,
+                 Statistics->TotalRestoreCycles / Statistics->CountOfRestores,
+                 Statistics->MaximumRestoreCycles);
+}
+
+/**
+ * @brief !snapshot command handler
+ *
+ * @param CommandTokens
+ * @param Command
+ *
+ * @return VOID
+ */
+VOID
+CommandSnapshot(vector<CommandToken> CommandTokens, string Command)
+{
+    DEBUGGER_SNAPSHOT_STATISTICS Statistics   = {0};
+    BOOLEAN                      IsTaken      = FALSE;
+    UINT64                       StartAddress = 0;
+    UINT64                       EndAddress   = 0;
+    UINT64                       MaximumPages = 0;
+
+    if (CommandTokens.size() == 1)
+    {
+        if (HyperDbgSnapshotQuery(&Statistics, &IsTaken))
+        {
+            if (!IsTaken)
+            {
+                ShowMessages("snapshot is not taken, use '!snapshot take' to take a snapshot\n");
+                return;
+            }
+
+            CommandSnapshotShowStatistics(&Statistics);
+        }
+        return;
+    }
+
+    if (CommandTokens.size() == 2 && CompareLowerCaseStrings(CommandTokens.at(1), "restore"))
+    {
+        if (HyperDbgSnapshotRestore())
+        {
+            ShowMessages("the modified pages are restored\n");
+        }
+        return;
+    }
+    else if (CommandTokens.size() == 2 && CompareLowerCaseStrings(CommandTokens.at(1), "discard"))
+    {
+        if (HyperDbgSnapshotDiscard())
+        {
+            ShowMessages("the snapshot is discarded\n");
+        }
+        return;
+    }
+    else if ((CommandTokens.size() != 4 && CommandTokens.size() != 6) ||
+             !CompareLowerCaseStrings(CommandTokens.at(1), "take") ||
+             (CommandTokens.size() == 6 && !CompareLowerCaseStrings(CommandTokens.at(4), "pages")))
+    {
+        ShowMessages("incorrect use of the '%s'\n\n",
+                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
+
+        CommandSnapshotHelp();
+        return;
+    }
+
+    if (!SymbolConvertNameOrExprToAddress(GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)), &StartAddress) ||
+        !SymbolConvertNameOrExprToAddress(GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3)), &EndAddress))
+    {
+        ShowMessages("err, couldn't resolve the range of the snapshot\n");
+        return;
+    }
+
+    if (StartAddress >= EndAddress || (StartAddress % PAGE_SIZE) != 0 || (EndAddress % PAGE_SIZE) != 0)
+    {
+        ShowMessages("err, the range of the snapshot should be page-aligned\n");
+        return;
+    }
+
+    if (CommandTokens.size() == 6 &&
+        (!ConvertTokenToUInt64(CommandTokens.at(5), &MaximumPages) || MaximumPages == 0 || MaximumPages > DEBUGGER_SNAPSHOT_MAXIMUM_PAGES))
+    {
+        ShowMessages("err, the count of pages should be between 1 to %x\n", DEBUGGER_SNAPSHOT_MAXIMUM_PAGES);
+        return;
+    }
+
+    if (HyperDbgSnapshotTake(StartAddress, EndAddress, (UINT32)MaximumPages))
+    {
+        ShowMessages("the snapshot is taken\n");
+    }
+}
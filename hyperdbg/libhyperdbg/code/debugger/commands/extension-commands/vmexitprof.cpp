@@ -0,0 +1,637 @@
+/**
+ * @file vmexitprof.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief !vmexitprof command
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern BOOLEAN g_IsSerialConnectedToRemoteDebuggee;
+
+/**
+ * @brief Names of the basic exit reasons (Intel SDM, Appendix C)
+ *
+ */
+static const CHAR * const VmexitProfilerExitReasonNames[VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS] = {
+    "EXCEPTION_OR_NMI",
+    "EXTERNAL_INTERRUPT",
+    "TRIPLE_FAULT",
+    "INIT_SIGNAL",
+    "STARTUP_IPI",
+    "IO_SMI",
+    "SMI",
+    "INTERRUPT_WINDOW",
+    "NMI_WINDOW",
+    "TASK_SWITCH",
+    "CPUID",
+    "GETSEC",
+    "HLT",
+    "INVD",
+    "INVLPG",
+    "RDPMC",
+    "RDTSC",
+    "RSM",
+    "VMCALL",
+    "VMCLEAR",
+    "VMLAUNCH",
+    "VMPTRLD",
+    "VMPTRST",
+    "VMREAD",
+    "VMRESUME",
+    "VMWRITE",
+    "VMXOFF",
+    "VMXON",
+    "MOV_CR",
+    "MOV_DR",
+    "IO_INSTRUCTION",
+    "RDMSR",
+    "WRMSR",
+    "ERROR_INVALID_GUEST_STATE",
+    "ERROR_MSR_LOAD",
+    NULL,
+    "MWAIT",
+    "MONITOR_TRAP_FLAG",
+    NULL,
+    "MONITOR",
+    "PAUSE",
+    "ERROR_MACHINE_CHECK",
+    NULL,
+    "TPR_BELOW_THRESHOLD",
+    "APIC_ACCESS",
+    "VIRTUALIZED_EOI",
+    "GDTR_IDTR_ACCESS",
+    "LDTR_TR_ACCESS",
+    "EPT_VIOLATION",
+    "EPT_MISCONFIGURATION",
+    "INVEPT",
+    "RDTSCP",
+    "VMX_PREEMPTION_TIMER_EXPIRED",
+    "INVVPID",
+    "WBINVD",
+    "XSETBV",
+    "APIC_WRITE",
+    "RDRAND",
+    "INVPCID",
+    "VMFUNC",
+    "ENCLS",
+    "RDSEED",
+    "PAGE_MODIFICATION_LOG_FULL",
+    "XSAVES",
+    "XRSTORS",
+    "PCONFIG",
+    "SPP_RELATED_EVENT",
+    "UMWAIT",
+    "TPAUSE",
+    "LOADIWKEY",
+    "ENCLV",
+    NULL,
+    "ENQCMD_PASID_TRANSLATION_FAILURE",
+    "ENQCMDS_PASID_TRANSLATION_FAILURE",
+    "BUS_LOCK",
+    "INSTRUCTION_TIMEOUT",
+    "SEAMCALL",
+    "TDCALL",
+};
+
+/**
+ * @brief help of the !vmexitprof command
+ *
+ * @return VOID
+ */
+VOID
+CommandVmexitprofHelp()
+{
+    ShowMessages("!vmexitprof : profiles the latency and the frequency of VM-exits and triggered events.\n\n");
+
+    ShowMessages("syntax : \t!vmexitprof [on|off|reset]\n");
+    ShowMessages("syntax : \t!vmexitprof [show] [core CoreId (hex)] [reason ExitReason (hex)]\n");
+
+    ShowMessages("\n");
+    ShowMessages("\t\te.g : !vmexitprof on\n");
+    ShowMessages("\t\te.g : !vmexitprof\n");
+    ShowMessages("\t\te.g : !vmexitprof show core 2\n");
+    ShowMessages("\t\te.g : !vmexitprof show reason 30\n");
+    ShowMessages("\t\te.g : !vmexitprof reset\n");
+    ShowMessages("\t\te.g : !vmexitprof off\n");
+
+    ShowMessages("\n");
+    ShowMessages("note : the time is measured in TSC cycles from the entry of the VM-exit handler until resuming the guest.\n");
+}
+
+/**
+ * @brief Send VM-exit profiler requests
+ *
+ * @param RequestType
+ * @param CoreId
+ * @param Results
+ * @param IsEnabled
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandVmexitprofSendRequest(DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE RequestType,
+                             UINT32                                CoreId,
+                             PVMEXIT_PROFILER_RESULTS              Results,
+                             PBOOLEAN                              IsEnabled)
+{
+    BOOL                              Status;
+    ULONG                             ReturnedLength;
+    PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest;
+    UINT32                            RequestSize = SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST;
+
+    //
+    // Only queries carry the results
+    //
+    if (RequestType == DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY)
+    {
+        RequestSize += sizeof(VMEXIT_PROFILER_RESULTS);
+    }
+
+    //
+    // Allocate buffer to fill the request
+    //
+    ProfilerRequest = (PDEBUGGER_VMEXIT_PROFILER_REQUEST)malloc(RequestSize);
+
+    if (ProfilerRequest == NULL)
+    {
+        //
+        // Unable to allocate buffer
+        //
+        return FALSE;
+    }
+
+    RtlZeroMemory(ProfilerRequest, RequestSize);
+
+    ProfilerRequest->RequestType = RequestType;
+    ProfilerRequest->CoreId      = CoreId;
+
+    if (g_IsSerialConnectedToRemoteDebuggee)
+    {
+        //
+        // Send the request over serial kernel debugger
+        //
+        if (!KdSendVmexitProfilerActionPacketsToDebuggee(ProfilerRequest, RequestSize))
+        {
+            free(ProfilerRequest);
+            return FALSE;
+        }
+    }
+    else
+    {
+        AssertShowMessageReturnStmt(g_DeviceHandle, ASSERT_MESSAGE_DRIVER_NOT_LOADED, AssertReturnFalse);
+
+        //
+        // Send IOCTL
+        //
+        Status = DeviceIoControl(
+            g_DeviceHandle,                           // Handle to device
+            IOCTL_PERFORM_ACTIONS_ON_VMEXIT_PROFILER, // IO Control Code (IOCTL)
+            ProfilerRequest,                          // Input Buffer to driver.
+            SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST,  // Input buffer length
+            ProfilerRequest,                          // Output Buffer from driver.
+            RequestSize,                              // Length of output buffer in bytes.
+            &ReturnedLength,                          // Bytes placed in buffer.
+            NULL                                      // synchronous call
+        );
+
+        if (!Status)
+        {
+            ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
+
+            free(ProfilerRequest);
+            return FALSE;
+        }
+
+        if (ReturnedLength != RequestSize && ReturnedLength != SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST)
+        {
+            //
+            // An err occurred
+            //
+            ShowMessages("err, VM-exit profiler request failed\n");
+
+            free(ProfilerRequest);
+            return FALSE;
+        }
+    }
+
+    if (ProfilerRequest->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+    {
+        //
+        // An err occurred, no results
+        //
+        ShowErrorMessage(ProfilerRequest->KernelStatus);
+
+        free(ProfilerRequest);
+        return FALSE;
+    }
+
+    if (IsEnabled != NULL)
+    {
+        *IsEnabled = ProfilerRequest->IsEnabled;
+    }
+
+    if (Results != NULL && RequestType == DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY)
+    {
+        RtlCopyMemory(Results, (PVOID)(((CHAR *)ProfilerRequest) + sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST)), sizeof(VMEXIT_PROFILER_RESULTS));
+    }
+
+    free(ProfilerRequest);
+    return TRUE;
+}
+
+/**
+ * @brief Enable or disable the VM-exit profiler
+ *
+ * @param Enable
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgVmexitProfilerEnable(BOOLEAN Enable)
+{
+    return CommandVmexitprofSendRequest(Enable ? DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_ENABLE : DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_DISABLE,
+                                        DEBUGGER_VMEXIT_PROFILER_ALL_CORES,
+                                        NULL,
+                                        NULL);
+}
+
+/**
+ * @brief Clear the samples of the VM-exit profiler
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgVmexitProfilerReset()
+{
+    return CommandVmexitprofSendRequest(DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_RESET,
+                                        DEBUGGER_VMEXIT_PROFILER_ALL_CORES,
+                                        NULL,
+                                        NULL);
+}
+
+/**
+ * @brief Query the samples of the VM-exit profiler
+ *
+ * @param CoreId The target core or DEBUGGER_VMEXIT_PROFILER_ALL_CORES
+ * @param Results
+ * @param IsEnabled
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HyperDbgVmexitProfilerQuery(UINT32 CoreId, PVMEXIT_PROFILER_RESULTS Results, PBOOLEAN IsEnabled)
+{
+    return CommandVmexitprofSendRequest(DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY,
+                                        CoreId,
+                                        Results,
+                                        IsEnabled);
+}
+
+/**
+ * @brief Estimate a percentile from a log2 histogram
+ * @details The result is the upper bound of the bucket that contains
+ * the percentile (and never bigger than the maximum sample)
+ *
+ * @param Histogram
+ * @param Percentile between 1 to 100
+ *
+ * @return UINT64
+ */
+UINT64
+VmexitProfilerEstimatePercentile(const VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT32 Percentile)
+{
+    UINT64 Target;
+    UINT64 Accumulated = 0;
+    UINT64 UpperBound  = 0;
+
+    if (Histogram->Count == 0)
+    {
+        return 0;
+    }
+
+    //
+    // The rank of the sample that we're looking for (rounded up)
+    //
+    Target = (Histogram->Count * Percentile + 99) / 100;
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        Accumulated += Histogram->Buckets[i];
+
+        if (Accumulated >= Target)
+        {
+            UpperBound = (i == VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1) ? Histogram->MaxCycles : (2ull << i) - 1;
+            break;
+        }
+    }
+
+    return UpperBound < Histogram->MaxCycles ? UpperBound : Histogram->MaxCycles;
+}
+
+/**
+ * @brief Sort the non-empty exit reasons based on their total cycles
+ *
+ * @param Results
+ * @param SortedReasons
+ *
+ * @return UINT64 Total cycles of all exit reasons
+ */
+UINT64
+VmexitProfilerSortExitReasons(const VMEXIT_PROFILER_RESULTS * Results, vector<UINT32> & SortedReasons)
+{
+    UINT64 TotalCycles = 0;
+
+    SortedReasons.clear();
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS; i++)
+    {
+        if (Results->ExitReasons[i].Count != 0)
+        {
+            SortedReasons.push_back(i);
+            TotalCycles += Results->ExitReasons[i].TotalCycles;
+        }
+    }
+
+    std::sort(SortedReasons.begin(), SortedReasons.end(), [Results](UINT32 A, UINT32 B) {
+        return Results->ExitReasons[A].TotalCycles > Results->ExitReasons[B].TotalCycles;
+    });
+
+    return TotalCycles;
+}
+
+/**
+ * @brief Show a summary line of a histogram
+ *
+ * @param Name
+ * @param Histogram
+ * @param TotalCycles Total cycles of all entries (for computing the share)
+ *
+ * @return VOID
+ */
+VOID
+CommandVmexitprofShowSummary(const CHAR * Name, const VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 TotalCycles)
+{
+    ShowMessages("%-36s %12llu %6.2f%% %10llu %10llu %10llu %12llu\n",
+                 Name,
+                 Histogram->Count,
+                 TotalCycles == 0 ? 0.0 : ((double)Histogram->TotalCycles * 100.0) / (double)TotalCycles,
+                 Histogram->TotalCycles / Histogram->Count,
+                 VmexitProfilerEstimatePercentile(Histogram, 50),
+                 VmexitProfilerEstimatePercentile(Histogram, 99),
+                 Histogram->MaxCycles);
+}
+
+/**
+ * @brief Show all buckets of a histogram
+ *
+ * @param Histogram
+ *
+ * @return VOID
+ */
+VOID
+CommandVmexitprofShowBuckets(const VMEXIT_PROFILER_HISTOGRAM * Histogram)
+{
+    UINT64 MaxBucket = 0;
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        if (Histogram->Buckets[i] > MaxBucket)
+        {
+            MaxBucket = Histogram->Buckets[i];
+        }
+    }
+
+    if (MaxBucket == 0)
+    {
+        ShowMessages("no samples\n");
+        return;
+    }
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        if (Histogram->Buckets[i] == 0)
+        {
+            continue;
+        }
+
+        ShowMessages("[%10llu, %10llu%s %12llu |%s\n",
+                     i == 0 ? 0ull : (1ull << i),
+                     (2ull << i) - 1,
+                     i == VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1 ? "+]" : "] ",
+                     Histogram->Buckets[i],
+                     string((size_t)((Histogram->Buckets[i] * 40 + MaxBucket - 1) / MaxBucket), '#').c_str());
+    }
+}
+
+/**
+ * @brief Show the results of the VM-exit profiler
+ *
+ * @param Results
+ * @param TargetReason Show the buckets of this exit reason, or
+ * VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS to show the summary
+ *
+ * @return VOID
+ */
+VOID
+CommandVmexitprofShowResults(const VMEXIT_PROFILER_RESULTS * Results, UINT32 TargetReason)
+{
+    vector<UINT32> SortedReasons;
+    UINT64         TotalCycles;
+    UINT64         TotalEventCycles = 0;
+    CHAR           Name[40]         = {0};
+
+    if (TargetReason < VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS)
+    {
+        ShowMessages("exit reason: 0x%x (%s)\n\n",
+                     TargetReason,
+                     VmexitProfilerExitReasonNames[TargetReason] != NULL ? VmexitProfilerExitReasonNames[TargetReason] : "RESERVED");
+
+        CommandVmexitprofShowBuckets(&Results->ExitReasons[TargetReason]);
+        return;
+    }
+
+    TotalCycles = VmexitProfilerSortExitReasons(Results, SortedReasons);
+
+    if (SortedReasons.empty())
+    {
+        ShowMessages("no VM-exit is recorded, use '!vmexitprof on' to start profiling\n");
+        return;
+    }
+
+    ShowMessages("%-36s %12s %7s %10s %10s %10s %12s\n", "exit reason", "count", "time", "avg", "p50", "p99", "max");
+
+    for (UINT32 Reason : SortedReasons)
+    {
+        sprintf_s(Name,
+                  sizeof(Name),
+                  "(%02x) %s",
+                  Reason,
+                  VmexitProfilerExitReasonNames[Reason] != NULL ? VmexitProfilerExitReasonNames[Reason] : "RESERVED");
+
+        CommandVmexitprofShowSummary(Name, &Results->ExitReasons[Reason], TotalCycles);
+    }
+
+    if (Results->UnknownExitReasons != 0)
+    {
+        ShowMessages("%llu VM-exit(s) with unknown exit reasons\n", Results->UnknownExitReasons);
+    }
+
+    //
+    // Show the efficiency of the guest translation cache
+    //
+    if (Results->TranslationCacheHits + Results->TranslationCacheMisses != 0)
+    {
+        ShowMessages("\ntranslation cache: %llu hit(s), %llu miss(es) (%.2f%% hit rate)\n",
+                     Results->TranslationCacheHits,
+                     Results->TranslationCacheMisses,
+                     (double)Results->TranslationCacheHits * 100.0 /
+                         (double)(Results->TranslationCacheHits + Results->TranslationCacheMisses));
+    }
+
+    //
+    // Show the triggered events (if any)
+    //
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EVENT_TAGS; i++)
+    {
+        TotalEventCycles += Results->Events[i].Histogram.TotalCycles;
+    }
+
+    if (Results->UntrackedEvents != 0)
+    {
+        ShowMessages("\n%llu trigger(s) of the events are not tracked (too many alive events)\n", Results->UntrackedEvents);
+    }
+
+    if (TotalEventCycles == 0)
+    {
+        return;
+    }
+
+    ShowMessages("\n%-36s %12s %7s %10s %10s %10s %12s\n", "event", "count", "time", "avg", "p50", "p99", "max");
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EVENT_TAGS; i++)
+    {
+        if (Results->Events[i].Histogram.Count == 0)
+        {
+            continue;
+        }
+
+        sprintf_s(Name, sizeof(Name), "%llx", Results->Events[i].Tag - DebuggerEventTagStartSeed);
+
+        CommandVmexitprofShowSummary(Name, &Results->Events[i].Histogram, TotalEventCycles);
+    }
+
+    if (Results->OmittedEvents != 0)
+    {
+        ShowMessages("%llu cheaper event(s) are not shown\n", Results->OmittedEvents);
+    }
+}
+
+/**
+ * @brief !vmexitprof command handler
+ *
+ * @param CommandTokens
+ * @param Command
+ *
+ * @return VOID
+ */
+VOID
+CommandVmexitprof(vector<CommandToken> CommandTokens, string Command)
+{
+    BOOLEAN                  IsEnabled    = FALSE;
+    UINT32                   CoreId       = DEBUGGER_VMEXIT_PROFILER_ALL_CORES;
+    UINT32                   TargetReason = VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS;
+    UINT32                   Index        = 1;
+    PVMEXIT_PROFILER_RESULTS Results;
+
+    if (CommandTokens.size() == 2)
+    {
+        if (CompareLowerCaseStrings(CommandTokens.at(1), "on"))
+        {
+            if (HyperDbgVmexitProfilerEnable(TRUE))
+            {
+                ShowMessages("VM-exit profiler is enabled\n");
+            }
+            return;
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(1), "off"))
+        {
+            if (HyperDbgVmexitProfilerEnable(FALSE))
+            {
+                ShowMessages("VM-exit profiler is disabled\n");
+            }
+            return;
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(1), "reset"))
+        {
+            if (HyperDbgVmexitProfilerReset())
+            {
+                ShowMessages("VM-exit profiler samples are cleared\n");
+            }
+            return;
+        }
+    }
+
+    //
+    // Parse the 'show' parameters
+    //
+    if (CommandTokens.size() > 1 && CompareLowerCaseStrings(CommandTokens.at(1), "show"))
+    {
+        Index++;
+    }
+
+    while (Index < CommandTokens.size())
+    {
+        if (Index + 1 < CommandTokens.size() && CompareLowerCaseStrings(CommandTokens.at(Index), "core"))
+        {
+            if (!ConvertTokenToUInt32(CommandTokens.at(Index + 1), &CoreId))
+            {
+                ShowMessages("err, invalid core id\n");
+                return;
+            }
+        }
+        else if (Index + 1 < CommandTokens.size() && CompareLowerCaseStrings(CommandTokens.at(Index), "reason"))
+        {
+            if (!ConvertTokenToUInt32(CommandTokens.at(Index + 1), &TargetReason) ||
+                TargetReason >= VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS)
+            {
+                ShowMessages("err, invalid exit reason\n");
+                return;
+            }
+        }
+        else
+        {
+            ShowMessages("incorrect use of the '%s'\n\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
+
+            CommandVmexitprofHelp();
+            return;
+        }
+
+        Index += 2;
+    }
+
+    Results = (PVMEXIT_PROFILER_RESULTS)malloc(sizeof(VMEXIT_PROFILER_RESULTS));
+
+    if (Results == NULL)
+    {
+        ShowMessages("err, unable to allocate memory for the results\n");
+        return;
+    }
+
+    if (HyperDbgVmexitProfilerQuery(CoreId, Results, &IsEnabled))
+    {
+        ShowMessages("VM-exit profiler is %s\n\n", IsEnabled ? "enabled" : "disabled");
+
+        CommandVmexitprofShowResults(Results, TargetReason);
+    }
+
+    free(Results);
+}
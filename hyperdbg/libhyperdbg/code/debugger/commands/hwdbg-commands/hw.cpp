@@ -16,6 +16,7 @@
 //
 extern HWDBG_INSTANCE_INFORMATION g_HwdbgInstanceInfo;
 extern BOOLEAN                    g_HwdbgInstanceInfoIsValid;
+extern std::string                g_HwdbgBramImagePath;
 
 /**
  * @brief help of the !hw command
@@ -29,10 +30,22 @@ CommandHwHelp()
 
     ShowMessages("syntax : \t!hw script [script { Script (string) }]\n");
     ShowMessages("syntax : \t!hw script [unload]\n");
+    ShowMessages("syntax : \t!hw capture [arm TriggerPin (hex) PreTriggerEntries (hex) PostTriggerEntries (hex)]\n");
+    ShowMessages("syntax : \t!hw capture [read]\n");
+    ShowMessages("syntax : \t!hw capture [vcd] [path FilePath (string)]\n");
+    ShowMessages("syntax : \t!hw bram [path FilePath (string)]\n");
+    ShowMessages("syntax : \t!hw bram [default]\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : !hw script { @hw_pin1 = 0; }\n");
     ShowMessages("\t\te.g : !hw unload\n");
+    ShowMessages("\t\te.g : !hw capture arm 1f 10 30\n");
+    ShowMessages("\t\te.g : !hw capture read\n");
+    ShowMessages("\t\te.g : !hw capture vcd\n");
+    ShowMessages("\t\te.g : !hw capture vcd path c:\\capture.vcd\n");
+    ShowMessages("\t\te.g : !hw bram\n");
+    ShowMessages("\t\te.g : !hw bram path c:\\hwdbg.bram\n");
+    ShowMessages("\t\te.g : !hw bram default\n");
 }
 
 /**
@@ -46,6 +59,10 @@ CommandHwHelp()
 VOID
 CommandHw(vector<CommandToken> CommandTokens, string Command)
 {
+    UINT32 TriggerPin         = 0;
+    UINT32 PreTriggerEntries  = 0;
+    UINT32 PostTriggerEntries = 0;
+
     if (CommandTokens.size() >= 2 && CompareLowerCaseStrings(CommandTokens.at(1), "script"))
     {
         //
@@ -71,6 +88,94 @@ CommandHw(vector<CommandToken> CommandTokens, string Command)
         //
         g_HwdbgInstanceInfoIsValid = FALSE;
     }
+    else if (CommandTokens.size() == 6 && CompareLowerCaseStrings(CommandTokens.at(1), "capture") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "arm"))
+    {
+        if (!ConvertTokenToUInt32(CommandTokens.at(3), &TriggerPin) ||
+            !ConvertTokenToUInt32(CommandTokens.at(4), &PreTriggerEntries) ||
+            !ConvertTokenToUInt32(CommandTokens.at(5), &PostTriggerEntries))
+        {
+            ShowMessages("err, please enter valid numbers for the trigger pin and the capture window\n");
+            return;
+        }
+
+        //
+        // Arm the capture buffer with default file path and initial BRAM buffer size
+        //
+        HwdbgCaptureArm(HWDBG_TEST_READ_INSTANCE_INFO_PATH,
+                        HWDBG_TEST_WRITE_CAPTURE_CONFIGURATION_PATH,
+                        DEFAULT_INITIAL_BRAM_BUFFER_SIZE,
+                        TriggerPin,
+                        PreTriggerEntries,
+                        PostTriggerEntries);
+    }
+    else if (CommandTokens.size() == 3 && CompareLowerCaseStrings(CommandTokens.at(1), "capture") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "read"))
+    {
+        //
+        // Read the next chunk of the capture buffer with default file paths
+        //
+        HwdbgCaptureRead(HWDBG_TEST_WRITE_CAPTURE_READ_PATH,
+                         HWDBG_TEST_READ_CAPTURE_BUFFER_PATH);
+    }
+    else if (CommandTokens.size() == 3 && CompareLowerCaseStrings(CommandTokens.at(1), "capture") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "vcd"))
+    {
+        //
+        // Export the capture buffer into the default file
+        //
+        HwdbgCaptureExportVcd(HWDBG_DEFAULT_CAPTURE_VCD_PATH);
+    }
+    else if (CommandTokens.size() == 5 && CompareLowerCaseStrings(CommandTokens.at(1), "capture") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "vcd") && CompareLowerCaseStrings(CommandTokens.at(3), "path"))
+    {
+        //
+        // Export the capture buffer into the specified file
+        //
+        HwdbgCaptureExportVcd(GetCaseSensitiveStringFromCommandToken(CommandTokens.at(4)).c_str());
+    }
+    else if (CommandTokens.size() == 2 && CompareLowerCaseStrings(CommandTokens.at(1), "bram"))
+    {
+        //
+        // Show the file that packets are exchanged through
+        //
+        if (g_HwdbgBramImagePath.empty())
+        {
+            ShowMessages("packets are exchanged through the default test files\n");
+        }
+        else
+        {
+            ShowMessages("packets are exchanged through the BRAM image: %s\n", g_HwdbgBramImagePath.c_str());
+        }
+    }
+    else if (CommandTokens.size() == 4 && CompareLowerCaseStrings(CommandTokens.at(1), "bram") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "path"))
+    {
+        string BramImagePath = GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3));
+
+        //
+        // The image is shared with hwdbg, so it should be a binary image
+        //
+        if (!HwdbgInterpreterIsBinaryImageFile(BramImagePath.c_str()))
+        {
+            ShowMessages("err, the BRAM image should have the '%s' extension\n", HWDBG_BRAM_IMAGE_FILE_EXTENSION);
+            return;
+        }
+
+        g_HwdbgBramImagePath = BramImagePath;
+
+        ShowMessages("packets are exchanged through the BRAM image: %s\n", g_HwdbgBramImagePath.c_str());
+    }
+    else if (CommandTokens.size() == 3 && CompareLowerCaseStrings(CommandTokens.at(1), "bram") &&
+             CompareLowerCaseStrings(CommandTokens.at(2), "default"))
+    {
+        //
+        // Use the default test files
+        //
+        g_HwdbgBramImagePath.clear();
+
+        ShowMessages("packets are exchanged through the default test files\n");
+    }
     else
     {
         ShowMessages("incorrect use of the '%s'\n\n",
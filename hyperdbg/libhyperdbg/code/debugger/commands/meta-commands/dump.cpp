@@ -14,19 +14,11 @@
 //
 // Global Variables
 //
+extern HANDLE                   g_DeviceHandle;
 extern BOOLEAN                  g_IsSerialConnectedToRemoteDebuggee;
+extern BOOLEAN                  g_IsInstrumentingInstructions;
 extern ACTIVE_DEBUGGING_PROCESS g_ActiveProcessDebuggingState;
 
-//
-// Local global variables
-//
-
-/**
- * @brief Holds the handle of the dump file
- *
- */
-HANDLE DumpFileHandle;
-
 /**
  * @brief help of the .dump command
  *
@@ -37,9 +29,24 @@ CommandDumpHelp()
 {
     ShowMessages(".dump & !dump : saves memory context into a file.\n\n");
 
-    ShowMessages("syntax : \t.dump [FromAddress (hex)] [ToAddress (hex)] [pid ProcessId (hex)] [path Path (string)]\n");
+    ShowMessages("syntax : \t.dump [FromAddress (hex)] [ToAddress (hex)] [pid ProcessId (hex)] [path Path (string)] [sparse] [resume]\n");
+    ShowMessages("syntax : \t!dump [FromAddress (hex)] [ToAddress (hex)] [path Path (string)] [dirty]\n");
+    ShowMessages("syntax : \t!dump [dirty] [start|stop]\n");
     ShowMessages("\nIf you want to dump physical memory then add '!' at the "
-                 "start of the command\n\n");
+                 "start of the command\n");
+    ShowMessages("\nIf 'sparse' is specified, the dump file starts with a header and a page map "
+                 "(one 64-bit entry for each page) and only the content of readable non-zero "
+                 "pages is saved into the file, otherwise the memory is saved as a raw file "
+                 "and unreadable pages are filled with zeros\n");
+    ShowMessages("\nIf 'resume' is specified, the dumping continues from the last saved page of "
+                 "an interrupted dump file (the same range and format should be specified)\n");
+    ShowMessages("\nIf 'dirty' is specified (only for the physical memory), an incremental sparse dump "
+                 "is saved which only contains the pages that are modified since the previous "
+                 "'dirty' dump (or since the logging of the dirty pages is started by '!dump dirty start'), "
+                 "other pages are marked as unchanged in the page map. Modified pages are logged by "
+                 "using Page Modification Logging (PML), the logging remains active until "
+                 "'!dump dirty stop' is used. In the Debugger Mode, the buffers of logging should be "
+                 "preallocated by using the 'prealloc dirty-logging 1' command\n\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : .dump 401000 40b000 path c:\\rev\\dump1.dmp\n");
@@ -49,6 +56,488 @@ CommandDumpHelp()
     ShowMessages("\t\te.g : .dump 00007ff8349f2000 00007ff8349f8000 path c:\\rev\\dump5.dmp\n");
     ShowMessages("\t\te.g : .dump @rax+@rcx @rax+@rcx+1000 path c:\\rev\\dump6.dmp\n");
     ShowMessages("\t\te.g : !dump 1000 2100 path c:\\rev\\dump7.dmp\n");
+    ShowMessages("\t\te.g : !dump 0 100000000 path c:\\rev\\dump8.dmp sparse\n");
+    ShowMessages("\t\te.g : !dump 0 100000000 path c:\\rev\\dump8.dmp sparse resume\n");
+    ShowMessages("\t\te.g : !dump dirty start\n");
+    ShowMessages("\t\te.g : !dump 0 100000000 path c:\\rev\\dump9.dmp dirty\n");
+    ShowMessages("\t\te.g : !dump dirty stop\n");
+}
+
+/**
+ * @brief Read pages of the target memory into the read request buffer
+ * @details The read data is placed right after the DEBUGGER_READ_MEMORY
+ * header of the read request of the context
+ *
+ * @param Context The dump context
+ * @param Address Address of the memory to read
+ * @param Size Size of the memory to read
+ * @param IsConnectionLost Set to TRUE if the request is not delivered to the
+ * debuggee (or the driver)
+ *
+ * @return BOOLEAN TRUE if the entire memory was read, otherwise FALSE
+ */
+BOOLEAN
+CommandDumpReadPages(PDUMP_CONTEXT Context, UINT64 Address, UINT32 Size, BOOLEAN * IsConnectionLost)
+{
+    BOOL                   Status;
+    ULONG                  ReturnedLength;
+    DEBUGGER_READ_MEMORY * ReadMem     = Context->ReadRequest;
+    UINT32                 RequestSize = sizeof(DEBUGGER_READ_MEMORY) + Size;
+
+    *IsConnectionLost = FALSE;
+
+    //
+    // Fill the read memory structure (the buffer is reused for all of the reads)
+    //
+    ZeroMemory(ReadMem, sizeof(DEBUGGER_READ_MEMORY));
+
+    ReadMem->Address        = Address;
+    ReadMem->Pid            = Context->Pid;
+    ReadMem->Size           = Size;
+    ReadMem->MemoryType     = Context->MemoryType;
+    ReadMem->ReadingType    = READ_FROM_KERNEL;
+    ReadMem->GetAddressMode = FALSE;
+
+    if (g_IsSerialConnectedToRemoteDebuggee)
+    {
+        //
+        // It's on Debugger mode
+        //
+        if (!KdSendReadMemoryPacketToDebuggee(ReadMem, RequestSize))
+        {
+            *IsConnectionLost = TRUE;
+            return FALSE;
+        }
+
+        ReturnedLength = ReadMem->ReturnLength;
+    }
+    else
+    {
+        //
+        // It's on VMI mode
+        //
+        Status = DeviceIoControl(g_DeviceHandle,              // Handle to device
+                                 IOCTL_DEBUGGER_READ_MEMORY,  // IO Control Code (IOCTL)
+                                 ReadMem,                     // Input Buffer to driver.
+                                 SIZEOF_DEBUGGER_READ_MEMORY, // Input buffer length
+                                 ReadMem,                     // Output Buffer from driver.
+                                 RequestSize,                 // Length of output buffer in bytes.
+                                 &ReturnedLength,             // Bytes placed in buffer.
+                                 NULL                         // synchronous call
+        );
+
+        if (!Status)
+        {
+            ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
+            *IsConnectionLost = TRUE;
+            return FALSE;
+        }
+
+        //
+        // Change the ReturnedLength as it contains the headers
+        //
+        ReturnedLength -= SIZEOF_DEBUGGER_READ_MEMORY;
+    }
+
+    //
+    // The pages are not reported as unavailable, just marked as unreadable, so
+    // no error message is shown here
+    //
+    if (ReadMem->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL || ReturnedLength != Size)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Write the metadata (header or page map) of the dump file
+ * @details The file is opened for overlapped I/O so the function waits
+ * for the write to complete
+ *
+ * @param Context The dump context
+ * @param FileOffset Offset of the target location in the file
+ * @param Buffer The buffer to write
+ * @param Size Size of the buffer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpWriteMetadata(PDUMP_CONTEXT Context, UINT64 FileOffset, PVOID Buffer, UINT32 Size)
+{
+    DWORD BytesWritten = 0;
+
+    Context->MetadataOverlapped.Offset     = (DWORD)FileOffset;
+    Context->MetadataOverlapped.OffsetHigh = (DWORD)(FileOffset >> 32);
+
+    if (!WriteFile(Context->FileHandle, Buffer, Size, NULL, &Context->MetadataOverlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        return FALSE;
+    }
+
+    if (!GetOverlappedResult(Context->FileHandle, &Context->MetadataOverlapped, &BytesWritten, TRUE) ||
+        BytesWritten != Size)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Start writing the content of a write buffer into the dump file
+ * @details The write is performed asynchronously (overlapped), it's waited
+ * for by CommandDumpWaitForWrite
+ *
+ * @param Context The dump context
+ * @param WriteBuffer The write buffer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpStartWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer)
+{
+    WriteBuffer->Overlapped.Offset     = (DWORD)WriteBuffer->FileOffset;
+    WriteBuffer->Overlapped.OffsetHigh = (DWORD)(WriteBuffer->FileOffset >> 32);
+
+    if (!WriteFile(Context->FileHandle, WriteBuffer->Buffer, WriteBuffer->UsedSize, NULL, &WriteBuffer->Overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Wait for the pending write of a write buffer
+ *
+ * @param Context The dump context
+ * @param WriteBuffer The write buffer
+ *
+ * @return BOOLEAN TRUE if the entire buffer was written
+ */
+BOOLEAN
+CommandDumpWaitForWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer)
+{
+    DWORD BytesWritten = 0;
+
+    if (!GetOverlappedResult(Context->FileHandle, &WriteBuffer->Overlapped, &BytesWritten, TRUE) ||
+        BytesWritten != WriteBuffer->UsedSize)
+    {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Send a request for logging the dirty pages
+ *
+ * @param DirtyPagesRequest The request (followed by the buffer of the entries
+ * in the collect requests)
+ * @param RequestSize Size of the request and the buffer of the entries
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpSendDirtyPagesRequest(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, UINT32 RequestSize)
+{
+    BOOL  Status;
+    ULONG ReturnedLength;
+
+    if (g_IsSerialConnectedToRemoteDebuggee)
+    {
+        //
+        // It's on Debugger mode
+        //
+        if (!KdSendDirtyPagesActionPacketsToDebuggee(DirtyPagesRequest, RequestSize))
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        AssertShowMessageReturnStmt(g_DeviceHandle, ASSERT_MESSAGE_DRIVER_NOT_LOADED, AssertReturnFalse);
+
+        //
+        // Send IOCTL
+        //
+        Status = DeviceIoControl(
+            g_DeviceHandle,                       // Handle to device
+            IOCTL_PERFORM_ACTIONS_ON_DIRTY_PAGES, // IO Control Code (IOCTL)
+            DirtyPagesRequest,                    // Input Buffer to driver.
+            SIZEOF_DEBUGGER_DIRTY_PAGES_REQUEST,  // Input buffer length
+            DirtyPagesRequest,                    // Output Buffer from driver.
+            RequestSize,                          // Length of output buffer in bytes.
+            &ReturnedLength,                      // Bytes placed in buffer.
+            NULL                                  // synchronous call
+        );
+
+        if (!Status)
+        {
+            ShowMessages("ioctl failed with code 0x%x\n", GetLastError());
+            return FALSE;
+        }
+    }
+
+    if (DirtyPagesRequest->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+    {
+        ShowErrorMessage(DirtyPagesRequest->KernelStatus);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Collect the pages of the range that are modified since the previous
+ * collection
+ * @details The collected pages are cleared in the debuggee, so the next
+ * incremental dump is based on this dump
+ *
+ * @param Context The dump context (the range should be filled in the header)
+ * @param CountOfDirtyPages Receives the number of the modified pages of the range
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpCollectDirtyPages(PDUMP_CONTEXT Context, UINT64 * CountOfDirtyPages)
+{
+    PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest;
+    PDEBUGGER_DIRTY_PAGES_ENTRY   Entries;
+    UINT64                        FirstPageFrameNumber = Context->Header.StartAddress / PAGE_SIZE;
+    UINT64                        EndPageFrameNumber   = FirstPageFrameNumber + Context->Header.CountOfPages;
+    UINT64                        NextPageFrameNumber  = FirstPageFrameNumber;
+    UINT32                        RequestSize          = sizeof(DEBUGGER_DIRTY_PAGES_REQUEST) + (DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES * sizeof(DEBUGGER_DIRTY_PAGES_ENTRY));
+
+    *CountOfDirtyPages = 0;
+
+    DirtyPagesRequest = (DEBUGGER_DIRTY_PAGES_REQUEST *)malloc(RequestSize);
+
+    if (DirtyPagesRequest == NULL)
+    {
+        return FALSE;
+    }
+
+    Entries = (DEBUGGER_DIRTY_PAGES_ENTRY *)(((CHAR *)DirtyPagesRequest) + sizeof(DEBUGGER_DIRTY_PAGES_REQUEST));
+
+    Context->DirtyPages.assign((SIZE_T)((Context->Header.CountOfPages + 63) / 64), 0);
+
+    while (NextPageFrameNumber < EndPageFrameNumber)
+    {
+        RtlZeroMemory(DirtyPagesRequest, sizeof(DEBUGGER_DIRTY_PAGES_REQUEST));
+
+        DirtyPagesRequest->RequestType          = DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_COLLECT;
+        DirtyPagesRequest->FlushBuffers         = NextPageFrameNumber == FirstPageFrameNumber;
+        DirtyPagesRequest->FirstPageFrameNumber = NextPageFrameNumber;
+        DirtyPagesRequest->EndPageFrameNumber   = EndPageFrameNumber;
+
+        if (!CommandDumpSendDirtyPagesRequest(DirtyPagesRequest, RequestSize) ||
+            DirtyPagesRequest->CountOfEntries > DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES)
+        {
+            std::free(DirtyPagesRequest);
+            return FALSE;
+        }
+
+        *CountOfDirtyPages += CommandDumpMarkDirtyPages(Context, Entries, DirtyPagesRequest->CountOfEntries);
+
+        //
+        // Make sure that the collection moves forward
+        //
+        if (DirtyPagesRequest->NextPageFrameNumber <= NextPageFrameNumber)
+        {
+            break;
+        }
+
+        NextPageFrameNumber = DirtyPagesRequest->NextPageFrameNumber;
+    }
+
+    std::free(DirtyPagesRequest);
+    return TRUE;
+}
+
+/**
+ * @brief Create the dump file or open it for resuming the dump
+ *
+ * @param Context The dump context (the range should be filled in the header)
+ * @param Filepath Path of the dump file
+ * @param IsResume Whether the previous dump should be continued or not
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpPrepareFile(PDUMP_CONTEXT Context, const wstring & Filepath, BOOLEAN IsResume)
+{
+    DWORD                   BytesRead = 0;
+    LARGE_INTEGER           FileSize  = {0};
+    FILE_END_OF_FILE_INFO   EndOfFile = {0};
+    DUMP_SPARSE_FILE_HEADER PreviousHeader;
+
+    //
+    // Create or open the file for writing the dump file
+    //
+    Context->FileHandle = CreateFileW(
+        Filepath.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        0,
+        NULL,
+        IsResume ? OPEN_EXISTING : CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+        NULL);
+
+    if (Context->FileHandle == INVALID_HANDLE_VALUE)
+    {
+        Context->FileHandle = NULL;
+        ShowMessages("err, unable to create or open the file\n");
+        return FALSE;
+    }
+
+    if (Context->IsSparse && IsResume)
+    {
+        //
+        // Read the header of the previous dump
+        //
+        Context->MetadataOverlapped.Offset     = 0;
+        Context->MetadataOverlapped.OffsetHigh = 0;
+
+        if ((!ReadFile(Context->FileHandle, &PreviousHeader, sizeof(DUMP_SPARSE_FILE_HEADER), NULL, &Context->MetadataOverlapped) &&
+             GetLastError() != ERROR_IO_PENDING) ||
+            !GetOverlappedResult(Context->FileHandle, &Context->MetadataOverlapped, &BytesRead, TRUE) ||
+            BytesRead < DUMP_SPARSE_FILE_HEADER_SIZE_V1)
+        {
+            ShowMessages("err, unable to read the header of the dump file\n");
+            return FALSE;
+        }
+
+        if (!CommandDumpResumeSparseFile(Context, &PreviousHeader, BytesRead))
+        {
+            ShowMessages("err, the dump file is not a sparse dump of the specified range\n");
+            return FALSE;
+        }
+    }
+    else if (Context->IsSparse)
+    {
+        CommandDumpInitializeSparseFile(Context);
+
+        if (!CommandDumpWriteMetadata(Context, 0, &Context->Header, sizeof(DUMP_SPARSE_FILE_HEADER)))
+        {
+            ShowMessages("err, unable to write the header of the dump file\n");
+            return FALSE;
+        }
+    }
+    else if (IsResume)
+    {
+        //
+        // Continue from the last complete page of the raw dump
+        //
+        if (!GetFileSizeEx(Context->FileHandle, &FileSize) || !CommandDumpResumeRawFile(Context, (UINT64)FileSize.QuadPart))
+        {
+            ShowMessages("err, the dump file is not a dump of the specified range\n");
+            return FALSE;
+        }
+    }
+
+    //
+    // Discard the uncommitted data of the previous dump (or reserve the
+    // zeroed page map of the sparse file)
+    //
+    EndOfFile.EndOfFile.QuadPart = (LONGLONG)Context->NextFileOffset;
+
+    if (!SetFileInformationByHandle(Context->FileHandle, FileEndOfFileInfo, &EndOfFile, sizeof(FILE_END_OF_FILE_INFO)))
+    {
+        ShowMessages("err, unable to set the size of the dump file (%x)\n", GetLastError());
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Allocate the buffers of the dump context
+ *
+ * @param Context The dump context
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpAllocateContext(PDUMP_CONTEXT Context)
+{
+    Context->ReadRequest = (DEBUGGER_READ_MEMORY *)malloc(sizeof(DEBUGGER_READ_MEMORY) + (DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE));
+
+    if (Context->ReadRequest == NULL)
+    {
+        return FALSE;
+    }
+
+    Context->MetadataOverlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    if (Context->MetadataOverlapped.hEvent == NULL)
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < DUMP_WRITE_BUFFER_COUNT; i++)
+    {
+        Context->WriteBuffers[i].Buffer            = (BYTE *)malloc(DUMP_WRITE_BUFFER_SIZE);
+        Context->WriteBuffers[i].Overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+        if (Context->WriteBuffers[i].Buffer == NULL || Context->WriteBuffers[i].Overlapped.hEvent == NULL)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Free the resources of the dump context
+ * @details Pending writes are waited for before freeing their buffers
+ *
+ * @param Context The dump context
+ *
+ * @return VOID
+ */
+VOID
+CommandDumpFreeContext(PDUMP_CONTEXT Context)
+{
+    DWORD BytesWritten;
+
+    for (UINT32 i = 0; i < DUMP_WRITE_BUFFER_COUNT; i++)
+    {
+        if (Context->WriteBuffers[i].IsPending && Context->WriteBuffers[i].UsedSize != 0)
+        {
+            GetOverlappedResult(Context->FileHandle, &Context->WriteBuffers[i].Overlapped, &BytesWritten, TRUE);
+        }
+
+        if (Context->WriteBuffers[i].Overlapped.hEvent != NULL)
+        {
+            CloseHandle(Context->WriteBuffers[i].Overlapped.hEvent);
+        }
+
+        if (Context->WriteBuffers[i].Buffer != NULL)
+        {
+            std::free(Context->WriteBuffers[i].Buffer);
+        }
+    }
+
+    if (Context->MetadataOverlapped.hEvent != NULL)
+    {
+        CloseHandle(Context->MetadataOverlapped.hEvent);
+    }
+
+    if (Context->ReadRequest != NULL)
+    {
+        std::free(Context->ReadRequest);
+    }
+
+    if (Context->FileHandle != NULL)
+    {
+        CloseHandle(Context->FileHandle);
+    }
 }
 
 /**
@@ -61,21 +550,58 @@ CommandDumpHelp()
 VOID
 CommandDump(vector<CommandToken> CommandTokens, string Command)
 {
-    wstring                   Filepath;
-    UINT32                    ActualLength;
-    UINT32                    Iterator;
-    UINT32                    Pid                 = 0;
-    UINT32                    Length              = 0;
-    UINT64                    StartAddress        = 0;
-    UINT64                    EndAddress          = 0;
-    BOOLEAN                   IsFirstCommand      = TRUE;
-    BOOLEAN                   NextIsProcId        = FALSE;
-    BOOLEAN                   NextIsPath          = FALSE;
-    BOOLEAN                   IsTheFirstAddr      = FALSE;
-    BOOLEAN                   IsTheSecondAddr     = FALSE;
-    BOOLEAN                   IsDumpPathSpecified = FALSE;
-    string                    FirstCommand        = GetLowerStringFromCommandToken(CommandTokens.front());
-    DEBUGGER_READ_MEMORY_TYPE MemoryType          = DEBUGGER_READ_VIRTUAL_ADDRESS;
+    wstring                      Filepath;
+    UINT64                       CountOfDirtyPages;
+    DUMP_CONTEXT                 Context             = {};
+    DEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest   = {0};
+    UINT32                       Pid                 = 0;
+    UINT64                       StartAddress        = 0;
+    UINT64                       EndAddress          = 0;
+    BOOLEAN                      IsFirstCommand      = TRUE;
+    BOOLEAN                      NextIsProcId        = FALSE;
+    BOOLEAN                      NextIsPath          = FALSE;
+    BOOLEAN                      IsTheFirstAddr      = FALSE;
+    BOOLEAN                      IsTheSecondAddr     = FALSE;
+    BOOLEAN                      IsDumpPathSpecified = FALSE;
+    BOOLEAN                      IsSparse            = FALSE;
+    BOOLEAN                      IsResume            = FALSE;
+    BOOLEAN                      IsIncremental       = FALSE;
+    BOOLEAN                      IsInterrupted       = FALSE;
+    BOOLEAN                      IsFailed            = FALSE;
+    string                       FirstCommand        = GetLowerStringFromCommandToken(CommandTokens.front());
+    DEBUGGER_READ_MEMORY_TYPE    MemoryType          = DEBUGGER_READ_VIRTUAL_ADDRESS;
+
+    //
+    // Start or stop logging the dirty pages (!dump dirty start|stop)
+    //
+    if (CommandTokens.size() == 3 &&
+        !FirstCommand.compare("!dump") &&
+        CompareLowerCaseStrings(CommandTokens.at(1), "dirty"))
+    {
+        if (CompareLowerCaseStrings(CommandTokens.at(2), "start"))
+        {
+            DirtyPagesRequest.RequestType = DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_START;
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(2), "stop"))
+        {
+            DirtyPagesRequest.RequestType = DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_STOP;
+        }
+        else
+        {
+            ShowMessages("err, couldn't resolve error at '%s'\n\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)).c_str());
+            CommandDumpHelp();
+            return;
+        }
+
+        if (CommandDumpSendDirtyPagesRequest(&DirtyPagesRequest, sizeof(DEBUGGER_DIRTY_PAGES_REQUEST)))
+        {
+            ShowMessages("logging the dirty pages is %s\n",
+                         DirtyPagesRequest.RequestType == DEBUGGER_DIRTY_PAGES_REQUEST_TYPE_START ? "started" : "stopped");
+        }
+
+        return;
+    }
 
     if (CommandTokens.size() <= 4)
     {
@@ -131,6 +657,21 @@ CommandDump(vector<CommandToken> CommandTokens, string Command)
             NextIsPath = TRUE;
             continue;
         }
+        else if (CompareLowerCaseStrings(Section, "sparse"))
+        {
+            IsSparse = TRUE;
+            continue;
+        }
+        else if (CompareLowerCaseStrings(Section, "resume"))
+        {
+            IsResume = TRUE;
+            continue;
+        }
+        else if (CompareLowerCaseStrings(Section, "dirty"))
+        {
+            IsIncremental = TRUE;
+            continue;
+        }
         //
         // Check the 'From' address
         //
@@ -224,105 +765,174 @@ CommandDump(vector<CommandToken> CommandTokens, string Command)
     }
 
     //
-    // Create or open the file for writing the dump file
+    // The dirty pages are logged based on the physical pages, so the range
+    // should start at the start of a physical page
     //
-    DumpFileHandle = CreateFileW(
-        Filepath.c_str(),
-        GENERIC_WRITE,
-        0,
-        NULL,
-        CREATE_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL);
-
-    if (DumpFileHandle == INVALID_HANDLE_VALUE)
+    if (IsIncremental)
     {
-        ShowMessages("err, unable to create or open the file\n");
-        return;
+        if (MemoryType != DEBUGGER_READ_PHYSICAL_ADDRESS)
+        {
+            ShowMessages("err, the 'dirty' option is only supported for the physical memory (!dump)\n");
+            return;
+        }
+
+        if ((StartAddress & (PAGE_SIZE - 1)) != 0)
+        {
+            ShowMessages("err, the 'from' address should be page-aligned for the 'dirty' option\n");
+            return;
+        }
+
+        if (IsResume)
+        {
+            ShowMessages("err, the incremental dumps couldn't be resumed\n");
+            return;
+        }
+
+        //
+        // Incremental dumps are always sparse (the unchanged pages are marked in the page map)
+        //
+        IsSparse = TRUE;
     }
 
     //
-    // Compute the length
+    // Check if driver is loaded if it's in VMI mode
     //
-    Length = (UINT32)(EndAddress - StartAddress);
+    if (!g_IsSerialConnectedToRemoteDebuggee)
+    {
+        AssertShowMessageReturnStmt(g_DeviceHandle, ASSERT_MESSAGE_DRIVER_NOT_LOADED, AssertReturn);
+    }
+
+    Context.IsSparse      = IsSparse;
+    Context.IsIncremental = IsIncremental;
+    Context.MemoryType    = MemoryType;
+    Context.Pid           = Pid;
 
-    ActualLength = NULL;
-    Iterator     = Length / PAGE_SIZE;
+    CommandDumpInitializeHeader(&Context, StartAddress, EndAddress);
 
-    for (size_t i = 0; i <= Iterator; i++)
+    if (!CommandDumpAllocateContext(&Context))
     {
-        UINT64 Address = StartAddress + (i * PAGE_SIZE);
+        ShowMessages("err, unable to allocate buffers for the dump\n");
+        CommandDumpFreeContext(&Context);
+        return;
+    }
 
-        if (Length >= PAGE_SIZE)
-        {
-            ActualLength = PAGE_SIZE;
-        }
-        else
+    if (!CommandDumpPrepareFile(&Context, Filepath, IsResume))
+    {
+        CommandDumpFreeContext(&Context);
+        return;
+    }
+
+    if (IsIncremental)
+    {
+        //
+        // Get the pages that are modified since the previous checkpoint (this
+        // dump becomes the new checkpoint)
+        //
+        if (!CommandDumpCollectDirtyPages(&Context, &CountOfDirtyPages))
         {
-            ActualLength = Length;
+            CommandDumpFreeContext(&Context);
+            return;
         }
 
-        Length -= ActualLength;
+        ShowMessages("%llx page(s) are modified since the previous checkpoint\n", CountOfDirtyPages);
+    }
+
+    if (IsResume)
+    {
+        ShowMessages("resuming the dump from address: %llx\n", StartAddress + (Context.NextPageIndex * PAGE_SIZE));
+    }
+
+    CommandDumpResetWriteBuffer(&Context, Context.CurrentWriteBuffer);
 
-        if (ActualLength != 0)
+    //
+    // Read the pages in batches, the content of the previous buffer is written
+    // asynchronously while the next pages are read, the dump could be interrupted
+    // by CTRL+C (the same way as the instrumentation of instructions)
+    //
+    g_IsInstrumentingInstructions = TRUE;
+
+    while (Context.NextPageIndex < Context.Header.CountOfPages)
+    {
+        if (!g_IsInstrumentingInstructions)
         {
-            // ShowMessages("address: 0x%llx | actual length: 0x%llx\n", Address, ActualLength);
+            IsInterrupted = TRUE;
+            break;
+        }
 
-            HyperDbgShowMemoryOrDisassemble(
-                DEBUGGER_SHOW_COMMAND_DUMP,
-                Address,
-                MemoryType,
-                READ_FROM_KERNEL,
-                Pid,
-                ActualLength,
-                NULL);
+        if (!CommandDumpNextBatch(&Context))
+        {
+            IsFailed = TRUE;
+            break;
         }
     }
 
+    g_IsInstrumentingInstructions = FALSE;
+
     //
-    // Close the file handle if it's not already closed
+    // Write the remaining pages (pages that are read before a failure are kept
+    // so the dump could be resumed)
     //
-    if (DumpFileHandle != NULL)
+    if (!CommandDumpFinalize(&Context))
     {
-        CloseHandle(DumpFileHandle);
-        DumpFileHandle = NULL;
+        IsFailed = TRUE;
     }
 
-    ShowMessages("the dump file is saved at: %ls\n", Filepath.c_str());
-}
+    CommandDumpFreeContext(&Context);
 
-/**
- * @brief Saves the received buffers into the files
- *
- * @param Buffer
- * @param Length
- *
- * @return VOID
- */
-VOID
-CommandDumpSaveIntoFile(PVOID Buffer, UINT32 Length)
-{
-    DWORD BytesWritten;
+    if (IsIncremental && (IsFailed || IsInterrupted))
+    {
+        //
+        // The modified pages are already collected (and cleared) in the debuggee
+        //
+        ShowMessages("err, the incremental dump is stopped at address: %llx\n"
+                     "the modified pages after this address are lost, a complete dump "
+                     "should be saved as the new checkpoint\n",
+                     StartAddress + (Context.Header.NextPageIndex * PAGE_SIZE));
+        return;
+    }
 
-    //
-    // Check if handle is valid
-    //
-    if (DumpFileHandle == NULL)
+    if (IsFailed)
     {
-        ShowMessages("err, invalid handle for saving the dump buffer is specified\n");
+        ShowMessages("err, unable to dump the memory, the dump is stopped at address: %llx\n"
+                     "you can use the 'resume' option to continue the dump\n",
+                     StartAddress + (Context.Header.NextPageIndex * PAGE_SIZE));
         return;
     }
 
-    //
-    // Write the buffer into the dump file
-    //
-    if (!WriteFile(DumpFileHandle, Buffer, Length, &BytesWritten, NULL))
+    if (IsInterrupted)
     {
-        ShowMessages("err, unable to write buffer into the dump\n");
+        ShowMessages("the dump is interrupted at address: %llx\n"
+                     "you can use the 'resume' option to continue the dump\n",
+                     StartAddress + (Context.Header.NextPageIndex * PAGE_SIZE));
+        return;
+    }
 
-        CloseHandle(DumpFileHandle);
-        DumpFileHandle = NULL;
+    if (Context.IsIncremental)
+    {
+        ShowMessages("pages: %llx saved, %llx zero, %llx unreadable, %llx unchanged\n",
+                     Context.Header.CountOfPresentPages,
+                     Context.Header.CountOfZeroPages,
+                     Context.Header.CountOfUnreadablePages,
+                     Context.Header.CountOfUnchangedPages);
+    }
+    else if (Context.IsSparse)
+    {
+        ShowMessages("pages: %llx saved, %llx zero, %llx unreadable\n",
+                     Context.Header.CountOfPresentPages,
+                     Context.Header.CountOfZeroPages,
+                     Context.Header.CountOfUnreadablePages);
+    }
 
-        return;
+    if (Context.Header.CountOfUnreadablePages != 0)
+    {
+        ShowMessages("%llx page(s) couldn't be read%s\n"
+                     "if you are confident that the address is valid, it may be paged out "
+                     "or not yet available in the current CR3 page table\n"
+                     "you can use the '.pagein' command to load this page table into memory and "
+                     "trigger a page fault (#PF), please refer to the documentation for further details\n",
+                     Context.Header.CountOfUnreadablePages,
+                     Context.IsSparse ? " and are marked as unreadable in the page map" : " and are filled with zeros");
     }
+
+    ShowMessages("the dump file is saved at: %ls\n", Filepath.c_str());
 }
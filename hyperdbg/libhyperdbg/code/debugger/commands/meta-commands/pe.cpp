@@ -25,11 +25,15 @@ CommandPeHelp()
 
     ShowMessages("syntax : \t.pe [header] [FilePath (string)]\n");
     ShowMessages("syntax : \t.pe [section] [SectionName (string)] [FilePath (string)]\n");
+    ShowMessages("syntax : \t.pe [export] [FunctionName (string)] [FilePath (string)]\n");
+    ShowMessages("syntax : \t.pe [import] [ThunkRva (hex)] [FilePath (string)]\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : .pe header c:\\reverse\\myfile.exe\n");
     ShowMessages("\t\te.g : .pe section .text \"c:\\reverse files\\myfile.exe\"\n");
     ShowMessages("\t\te.g : .pe section .rdata \"c:\\reverse files\\myfile.exe\"\n");
+    ShowMessages("\t\te.g : .pe export CreateFileW c:\\windows\\system32\\kernel32.dll\n");
+    ShowMessages("\t\te.g : .pe import 81a8 c:\\reverse\\myfile.exe\n");
 }
 
 /**
@@ -46,6 +50,7 @@ CommandPe(vector<CommandToken> CommandTokens, string Command)
     wstring Filepath;
     string  TempFilePath;
     BOOLEAN ShowDumpOfSection = FALSE;
+    UINT32  ThunkRva;
 
     if (CommandTokens.size() <= 2)
     {
@@ -69,6 +74,35 @@ CommandPe(vector<CommandToken> CommandTokens, string Command)
         ShowDumpOfSection = TRUE;
         TempFilePath      = GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3));
     }
+    else if (CompareLowerCaseStrings(CommandTokens.at(1), "export") ||
+             CompareLowerCaseStrings(CommandTokens.at(1), "import"))
+    {
+        if (CommandTokens.size() != 4)
+        {
+            ShowMessages("please specify a valid PE file\n\n");
+            CommandPeHelp();
+            return;
+        }
+
+        StringToWString(Filepath, GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3)));
+
+        if (CompareLowerCaseStrings(CommandTokens.at(1), "export"))
+        {
+            PeShowExportByName(Filepath.c_str(), GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)).c_str());
+        }
+        else if (!ConvertTokenToUInt32(CommandTokens.at(2), &ThunkRva))
+        {
+            ShowMessages("err, couldn't resolve error at '%s'\n\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)).c_str());
+            CommandPeHelp();
+        }
+        else
+        {
+            PeShowImportByThunkRva(Filepath.c_str(), ThunkRva);
+        }
+
+        return;
+    }
     else if (CompareLowerCaseStrings(CommandTokens.at(1), "header"))
     {
         ShowDumpOfSection = FALSE;
@@ -106,10 +140,10 @@ CommandPe(vector<CommandToken> CommandTokens, string Command)
     //
     if (!ShowDumpOfSection)
     {
-        PeShowSectionInformationAndDump(Filepath.c_str(), NULL, Is32Bit);
+        PeShowSectionInformationAndDump(Filepath.c_str(), NULL);
     }
     else
     {
-        PeShowSectionInformationAndDump(Filepath.c_str(), GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)).c_str(), Is32Bit);
+        PeShowSectionInformationAndDump(Filepath.c_str(), GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2)).c_str());
     }
 }
@@ -16,7 +16,12 @@ using namespace std;
 //
 // Global Variables
 //
-extern BOOLEAN g_ExecutingScript;
+extern BOOLEAN                g_ExecutingScript;
+extern BOOLEAN                g_IsCommandListInitialized;
+extern BOOLEAN                g_IsConnectedToRemoteDebuggee;
+extern BOOLEAN                g_BreakPrintingOutput;
+extern BOOLEAN                g_ShouldPreviousCommandBeContinued;
+extern COMMAND_DISPATCH_TABLE g_CommandsDispatchTable;
 
 /**
  * @brief help of the .script command
@@ -29,6 +34,12 @@ CommandScriptHelp()
     ShowMessages(".script : runs a HyperDbg script.\n\n");
 
     ShowMessages("syntax : .script [FilePath (string)] [Args (string)]\n");
+    ShowMessages("syntax : .script [batch] [FilePath (string)] [Args (string)]\n");
+
+    ShowMessages("\n");
+    ShowMessages("\t\tbatch : parse the whole script first and send the independent commands (memory and "
+                 "register queries, events) to the remote debuggee without waiting for the results of "
+                 "the previous commands\n");
 
     ShowMessages("\n");
     ShowMessages("\t\te.g : .script C:\\scripts\\script.ds\n");
@@ -37,53 +48,29 @@ CommandScriptHelp()
     ShowMessages("\t\te.g : .script \"C:\\scripts\\hello world.ds\" @rax\n");
     ShowMessages("\t\te.g : .script \"C:\\scripts\\hello world.ds\" @rax @rcx+55 $pid\n");
     ShowMessages("\t\te.g : .script \"C:\\scripts\\hello world.ds\" 12 55 @rip\n");
+    ShowMessages("\t\te.g : .script batch C:\\scripts\\setup.ds\n");
 }
 
 /**
  * @brief Run the command
  *
+ * @param Command
+ *
  * @return VOID
  */
 VOID
-CommandScriptRunCommand(std::string Input, vector<string> PathAndArgs)
+CommandScriptRunCommand(const std::string & Command)
 {
-    int    CommandExecutionResult = 0;
-    char * LineContent            = NULL;
-    int    i                      = 0;
-
-    //
-    // Replace the $arg*s
-    // This is not a good approach to replace between strings,
-    // but we let it work this way and in the future versions
-    // we'll integrate the command parsing in the debugger with
-    // the script engine's command parser
-    //
-    for (auto item : PathAndArgs)
-    {
-        string ToReplace = "$arg" + std::to_string(i);
-        i++;
-
-        ReplaceAll(Input, ToReplace, item);
-    }
-
-    //
-    // Convert script to char*
-    //
-    LineContent = (char *)Input.c_str();
-
-    if (IsEmptyString(LineContent))
-    {
-        return;
-    }
+    int CommandExecutionResult = 0;
 
     //
     // Show current running command
     //
     HyperDbgShowSignature();
 
-    ShowMessages("%s\n", LineContent);
+    ShowMessages("%s\n", Command.c_str());
 
-    CommandExecutionResult = HyperDbgInterpreter(LineContent);
+    CommandExecutionResult = HyperDbgInterpreter((CHAR *)Command.c_str());
 
     ShowMessages("\n");
 
@@ -100,15 +87,96 @@ CommandScriptRunCommand(std::string Input, vector<string> PathAndArgs)
 }
 
 /**
- * @brief Read file and run the script
+ * @brief Check whether the command is independent or not
+ * @details the command is independent if it only queries the debuggee or
+ * registers an event and it's not handled locally in the remote connection
+ *
+ * @param Command
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandScriptIsIndependentCommand(const std::string & Command)
+{
+    CommandParser   Parser;
+    PCOMMAND_DETAIL CommandDetail;
+    const CHAR *    CommandName;
+    UINT32          CommandNameLength;
+
+    Parser.Tokenize(Command.c_str(), Command.length());
+
+    if (Parser.GetTokenCount() == 0)
+    {
+        return FALSE;
+    }
+
+    CommandName   = Parser.GetTokenText(0, &CommandNameLength);
+    CommandDetail = CommandDispatchFind(&g_CommandsDispatchTable, CommandName, CommandNameLength);
+
+    if (CommandDetail == NULL)
+    {
+        return FALSE;
+    }
+
+    return (CommandDetail->CommandAttrib & DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT) &&
+           !(CommandDetail->CommandAttrib & DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_REMOTE_CONNECTION);
+}
+
+/**
+ * @brief Add a command of the script to the list of commands
+ *
+ * @param Commands
+ * @param Input
+ * @param PathAndArgs
  *
  * @return VOID
  */
 VOID
-HyperDbgScriptReadFileAndExecuteCommand(std::vector<std::string> & PathAndArgs)
+CommandScriptAddCommand(std::vector<SCRIPT_BATCH_COMMAND> & Commands,
+                        std::string                         Input,
+                        std::vector<std::string> &          PathAndArgs)
+{
+    SCRIPT_BATCH_COMMAND BatchCommand;
+    int                  i = 0;
+
+    //
+    // Replace the $arg*s
+    // This is not a good approach to replace between strings,
+    // but we let it work this way and in the future versions
+    // we'll integrate the command parsing in the debugger with
+    // the script engine's command parser
+    //
+    for (auto item : PathAndArgs)
+    {
+        string ToReplace = "$arg" + std::to_string(i);
+        i++;
+
+        ReplaceAll(Input, ToReplace, item);
+    }
+
+    if (IsEmptyString((char *)Input.c_str()))
+    {
+        return;
+    }
+
+    BatchCommand.Command       = Input;
+    BatchCommand.IsIndependent = CommandScriptIsIndependentCommand(Input);
+
+    Commands.push_back(BatchCommand);
+}
+
+/**
+ * @brief Read the script file and parse it into a list of commands
+ *
+ * @param PathAndArgs
+ * @param Commands
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandScriptParseFile(std::vector<std::string> & PathAndArgs, std::vector<SCRIPT_BATCH_COMMAND> & Commands)
 {
     std::string Line;
-    BOOLEAN     IsOpened         = FALSE;
     bool        Reset            = false;
     string      CommandToExecute = "";
     string      PathOfScriptFile = "";
@@ -122,100 +190,219 @@ HyperDbgScriptReadFileAndExecuteCommand(std::vector<std::string> & PathAndArgs)
 
     ifstream File(PathOfScriptFile);
 
-    if (File.is_open())
+    if (!File.is_open())
     {
-        IsOpened = TRUE;
+        return FALSE;
+    }
 
-        //
-        // Indicate that it's a script
-        //
-        g_ExecutingScript = TRUE;
+    //
+    // Commands should be initialized for classifying the commands
+    //
+    if (!g_IsCommandListInitialized)
+    {
+        InitializeDebugger();
 
+        g_IsCommandListInitialized = TRUE;
+    }
+
+    //
+    // Reset multiline command
+    //
+    Reset = true;
+
+    while (std::getline(File, Line))
+    {
         //
-        // Reset multiline command
+        // Check for multiline commands
         //
-        Reset = true;
-
-        while (std::getline(File, Line))
+        if (CheckMultilineCommand((char *)Line.c_str(), Reset))
         {
             //
-            // Check for multiline commands
+            // if the reset is true, we should make the saving buffer empty
             //
-            if (CheckMultilineCommand((char *)Line.c_str(), Reset))
+            if (Reset)
             {
-                //
-                // if the reset is true, we should make the saving buffer empty
-                //
-                if (Reset)
-                {
-                    CommandToExecute.clear();
-                }
-
-                //
-                // The command is expected to be continued
-                //
-                Reset = false;
+                CommandToExecute.clear();
+            }
 
-                //
-                // Append to the previous command
-                //
-                CommandToExecute += Line + "\n";
+            //
+            // The command is expected to be continued
+            //
+            Reset = false;
 
-                continue;
-            }
-            else
-            {
-                //
-                // Reset for the next commands round
-                //
-                Reset = true;
-
-                //
-                // Append this line too
-                //
-                CommandToExecute += Line;
-            }
+            //
+            // Append to the previous command
+            //
+            CommandToExecute += Line + "\n";
 
+            continue;
+        }
+        else
+        {
             //
-            // Run the command
+            // Reset for the next commands round
             //
-            CommandScriptRunCommand(CommandToExecute, PathAndArgs);
+            Reset = true;
 
             //
-            // Clear the command
+            // Append this line too
             //
-            CommandToExecute.clear();
+            CommandToExecute += Line;
         }
 
         //
-        // Check for some probably not ended commands
+        // Add the command
+        //
+        CommandScriptAddCommand(Commands, CommandToExecute, PathAndArgs);
+
         //
-        if (!CommandToExecute.empty())
+        // Clear the command
+        //
+        CommandToExecute.clear();
+    }
+
+    //
+    // Check for some probably not ended commands
+    //
+    if (!CommandToExecute.empty())
+    {
+        CommandScriptAddCommand(Commands, CommandToExecute, PathAndArgs);
+    }
+
+    File.close();
+
+    return TRUE;
+}
+
+/**
+ * @brief Run the commands of a batch script
+ * @details if the debugger is connected to a remote debuggee, independent
+ * commands are sent without waiting for the results of the previous
+ * commands (at most SCRIPT_BATCH_MAXIMUM_REQUESTS_IN_FLIGHT commands),
+ * each command is shown before its results once they're received, other commands
+ * wait for all the results and run like a normal script
+ *
+ * @param Commands
+ *
+ * @return VOID
+ */
+VOID
+CommandScriptRunBatch(std::vector<SCRIPT_BATCH_COMMAND> & Commands)
+{
+    UINT32 RequestsInFlight = 0;
+
+    for (auto & BatchCommand : Commands)
+    {
+        if (BatchCommand.IsIndependent && g_IsConnectedToRemoteDebuggee)
         {
-            CommandScriptRunCommand(CommandToExecute, PathAndArgs);
+            //
+            // Same as the interpreter, the results of the remote debuggee
+            // should be shown and the command is not continued by enter
+            //
+            g_BreakPrintingOutput              = FALSE;
+            g_ShouldPreviousCommandBeContinued = FALSE;
 
             //
-            // Clear the command
+            // The command is shown by the listening thread once its results
+            // are received, thus, it's not mixed with the previous results
             //
-            CommandToExecute.clear();
+            if (RemoteConnectionSendPipelinedCommand(BatchCommand.Command.c_str(), (UINT32)BatchCommand.Command.length() + 1, TRUE) != 0)
+            {
+                ShowMessages("err, unable to send the command to the remote debuggee\n");
+                break;
+            }
+
+            RequestsInFlight++;
+
+            //
+            // Wait for the oldest command if there are too many commands in flight
+            //
+            if (RequestsInFlight == SCRIPT_BATCH_MAXIMUM_REQUESTS_IN_FLIGHT)
+            {
+                if (RemoteConnectionWaitForResults(1) != 0)
+                {
+                    break;
+                }
+
+                RequestsInFlight--;
+            }
+
+            continue;
         }
 
         //
-        // Indicate that script is finished
+        // Dependent commands wait for the results of all the previous commands
         //
-        g_ExecutingScript = FALSE;
+        if (RequestsInFlight != 0)
+        {
+            if (RemoteConnectionWaitForResults(RequestsInFlight) != 0)
+            {
+                break;
+            }
+
+            RequestsInFlight = 0;
+        }
 
-        File.close();
+        CommandScriptRunCommand(BatchCommand.Command);
     }
 
-    if (!IsOpened)
+    //
+    // Wait for the results of the remaining commands
+    //
+    if (RequestsInFlight != 0 && g_IsConnectedToRemoteDebuggee)
+    {
+        RemoteConnectionWaitForResults(RequestsInFlight);
+    }
+}
+
+/**
+ * @brief Read file and run the script
+ *
+ * @param PathAndArgs
+ * @param IsBatch whether the script should be executed as a batch script
+ *
+ * @return VOID
+ */
+VOID
+HyperDbgScriptReadFileAndExecuteCommand(std::vector<std::string> & PathAndArgs, BOOLEAN IsBatch)
+{
+    std::vector<SCRIPT_BATCH_COMMAND> Commands;
+
+    //
+    // Parse the whole script file before the execution
+    //
+    if (!CommandScriptParseFile(PathAndArgs, Commands))
     {
         ShowMessages("err, invalid file specified for the script\n");
+        return;
+    }
+
+    //
+    // Indicate that it's a script
+    //
+    g_ExecutingScript = TRUE;
+
+    if (IsBatch)
+    {
+        CommandScriptRunBatch(Commands);
     }
+    else
+    {
+        for (auto & BatchCommand : Commands)
+        {
+            CommandScriptRunCommand(BatchCommand.Command);
+        }
+    }
+
+    //
+    // Indicate that script is finished
+    //
+    g_ExecutingScript = FALSE;
 }
 
 /**
  * @brief Parsing the command line options for scripts
+ * @details the first option is either --script or --batch-script
  * @param argc
  * @param argv
  *
@@ -225,6 +412,7 @@ INT
 ScriptReadFileAndExecuteCommandline(INT argc, CHAR * argv[])
 {
     vector<string> Args;
+    BOOLEAN        IsBatch = !strcmp(argv[1], "--batch-script");
 
     //
     // Convert it to the array
@@ -240,7 +428,7 @@ ScriptReadFileAndExecuteCommandline(INT argc, CHAR * argv[])
     //
     if (!Args.empty())
     {
-        HyperDbgScriptReadFileAndExecuteCommand(Args);
+        HyperDbgScriptReadFileAndExecuteCommand(Args, IsBatch);
         printf("\n");
     }
     else
@@ -263,7 +451,7 @@ VOID
 CommandScript(vector<CommandToken> CommandTokens, string Command)
 {
     vector<string> PathAndArgs;
-    BOOLEAN        IsFirstCommand = FALSE;
+    BOOLEAN        IsBatch = FALSE;
 
     if (CommandTokens.size() == 1)
     {
@@ -272,22 +460,24 @@ CommandScript(vector<CommandToken> CommandTokens, string Command)
         return;
     }
 
-    for (auto Section : CommandTokens)
+    //
+    // Check whether it's a batch script (the path is the next token)
+    //
+    if (CommandTokens.size() >= 3 && CompareLowerCaseStrings(CommandTokens.at(1), "batch"))
     {
-        if (!IsFirstCommand)
-        {
-            IsFirstCommand = TRUE;
-            continue;
-        }
+        IsBatch = TRUE;
+    }
 
+    for (size_t i = IsBatch ? 2 : 1; i < CommandTokens.size(); i++)
+    {
         //
         // Add the path and the arguments
         //
-        PathAndArgs.push_back(GetCaseSensitiveStringFromCommandToken(Section));
+        PathAndArgs.push_back(GetCaseSensitiveStringFromCommandToken(CommandTokens.at(i)));
     }
 
     //
     // Parse the file and the possible arguments
     //
-    HyperDbgScriptReadFileAndExecuteCommand(PathAndArgs);
+    HyperDbgScriptReadFileAndExecuteCommand(PathAndArgs, IsBatch);
 }
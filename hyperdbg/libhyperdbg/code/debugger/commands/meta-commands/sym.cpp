@@ -210,6 +210,8 @@ CommandSym(vector<CommandToken> CommandTokens, string Command)
         // all the symbols
         //
         ScriptEngineUnloadAllSymbolsWrapper();
+        SymbolMapClear();
+        PeImageFlushCache();
 
         //
         // Size is 3 there is module name (not working ! I don't know why)
@@ -269,7 +271,13 @@ CommandSym(vector<CommandToken> CommandTokens, string Command)
             // Load the pdb file (the validation of pdb file is checked into pdb
             // parsing functions)
             //
-            ScriptEngineLoadFileSymbolWrapper(BaseAddress, PathToPdb.c_str(), NULL);
+            if (ScriptEngineLoadFileSymbolWrapper(BaseAddress, PathToPdb.c_str(), NULL) == 0)
+            {
+                //
+                // Add the symbols of the module to the disassembler's symbol table
+                //
+                SymbolMapAddModule(BaseAddress);
+            }
         }
         else
         {
@@ -0,0 +1,370 @@
+/**
+ * @file tracefile.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief .tracefile command
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+using namespace std;
+
+/**
+ * @brief Default count of the entries that are shown by the .tracefile command
+ *
+ */
+#define TRACE_FILE_DEFAULT_COUNT_OF_SHOWN_ENTRIES 0x20
+
+/**
+ * @brief help of the .tracefile command
+ *
+ * @return VOID
+ */
+VOID
+CommandTracefileHelp()
+{
+    ShowMessages(".tracefile : analyzes the trace files that are saved by the batched steps "
+                 "('t', 'p', 'i', and '!track' commands with the 'file' option).\n\n");
+
+    ShowMessages("syntax : \t.tracefile [info] [FilePath (string)]\n");
+    ShowMessages("syntax : \t.tracefile [hot] [FilePath (string)] [Count (hex)]\n");
+    ShowMessages("syntax : \t.tracefile [blocks] [FilePath (string)] [Count (hex)]\n");
+    ShowMessages("syntax : \t.tracefile [coverage] [FilePath (string)]\n");
+    ShowMessages("syntax : \t.tracefile [show] [FilePath (string)] [Core (hex)] [RecordNumber (hex)] [Count (hex)]\n");
+    ShowMessages("syntax : \t.tracefile [csv] [FilePath (string)] [OutputPath (string)]\n");
+
+    ShowMessages("\n");
+    ShowMessages("\t\te.g : .tracefile info c:\\traces\\trace.hdt\n");
+    ShowMessages("\t\te.g : .tracefile hot c:\\traces\\trace.hdt 10\n");
+    ShowMessages("\t\te.g : .tracefile blocks c:\\traces\\trace.hdt\n");
+    ShowMessages("\t\te.g : .tracefile show c:\\traces\\trace.hdt 0 1f000 10\n");
+    ShowMessages("\t\te.g : .tracefile csv c:\\traces\\trace.hdt \"c:\\trace files\\trace.csv\"\n");
+
+    ShowMessages("\n");
+    ShowMessages("note : basic blocks are reconstructed from the executed instructions, the lengths of "
+                 "instructions are only known if the bytes of instructions are saved ('mem' records)\n");
+}
+
+/**
+ * @brief Get the length of the instruction of a record (if the bytes of the
+ * instruction are saved)
+ *
+ * @param Record
+ * @param Is32Bit
+ * @param Context
+ *
+ * @return UINT32 Length of the instruction or zero if it's unknown
+ */
+static UINT32
+CommandTracefileGetInstructionLength(const TRACE_FILE_RECORD * Record, BOOLEAN Is32Bit, PVOID Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    if (!Record->HasInstructionBytes)
+    {
+        return 0;
+    }
+
+    return HyperDbgLengthDisassemblerEngine((unsigned char *)Record->InstructionBytes, MAXIMUM_INSTR_SIZE, !Is32Bit);
+}
+
+/**
+ * @brief Show an address and its symbol
+ *
+ * @param Address
+ *
+ * @return VOID
+ */
+static VOID
+CommandTracefileShowAddress(UINT64 Address)
+{
+    UINT64 UsedBaseAddress = NULL;
+
+    ShowMessages("%s   ", SeparateTo64BitValue(Address).c_str());
+    SymbolShowFunctionNameBasedOnAddress(Address, &UsedBaseAddress);
+}
+
+/**
+ * @brief Show the records of a core (random access to the trace file)
+ *
+ * @param Reader
+ * @param CoreId
+ * @param RecordNumber
+ * @param Count
+ *
+ * @return VOID
+ */
+static VOID
+CommandTracefileShowRecords(PTRACE_FILE_READER Reader, UINT32 CoreId, UINT64 RecordNumber, UINT64 Count)
+{
+    TRACE_FILE_CHUNK_HEADER        ChunkHeader;
+    std::vector<TRACE_FILE_RECORD> Records;
+    UINT32                         IndexOfChunk;
+    BOOLEAN                        IsFirstChunk = TRUE;
+
+    while (Count != 0)
+    {
+        if (!TraceFileReaderFindChunk(Reader, CoreId, RecordNumber, &IndexOfChunk))
+        {
+            if (IsFirstChunk)
+            {
+                ShowMessages("record %llx of core %x is not found in the trace file\n", RecordNumber, CoreId);
+                return;
+            }
+
+            //
+            // The records are continued from the next chunk of the core
+            //
+            if (!TraceFileReaderFindNextChunk(Reader, CoreId, RecordNumber, &IndexOfChunk))
+            {
+                return;
+            }
+
+            RecordNumber = Reader->Index[IndexOfChunk].FirstRecordNumber;
+        }
+
+        IsFirstChunk = FALSE;
+
+        if (!TraceFileReaderReadChunk(Reader, IndexOfChunk, &ChunkHeader, Records))
+        {
+            ShowMessages("err, the chunk of record %llx is corrupted\n", RecordNumber);
+            return;
+        }
+
+        for (UINT64 i = RecordNumber - ChunkHeader.FirstRecordNumber; i < Records.size() && Count != 0; i++, Count--)
+        {
+            PTRACE_FILE_RECORD Record = &Records[(size_t)i];
+
+            ShowMessages("%llx   ", Record->RecordNumber);
+
+            if (ChunkHeader.RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+            {
+                ShowMessages("%s (depth: %x)   ", Record->IsRet ? "ret " : "call", Record->Depth);
+                CommandTracefileShowAddress(Record->Rip);
+                ShowMessages(" -> ");
+                CommandTracefileShowAddress(Record->Target);
+                ShowMessages("\n");
+
+                continue;
+            }
+
+            CommandTracefileShowAddress(Record->Rip);
+            ShowMessages("\n");
+
+            if (ChunkHeader.RegisterMask != 0)
+            {
+                ShowMessages("   ");
+
+                for (UINT32 j = 0; j < TRACE_FILE_MAXIMUM_REGISTERS; j++)
+                {
+                    if (ChunkHeader.RegisterMask & (1 << j))
+                    {
+                        ShowMessages(" %x:%llx", j, Record->Registers[j]);
+                    }
+                }
+
+                ShowMessages("\n");
+            }
+        }
+
+        RecordNumber = ChunkHeader.FirstRecordNumber + Records.size();
+    }
+}
+
+/**
+ * @brief .tracefile command handler
+ *
+ * @param CommandTokens
+ * @param Command
+ *
+ * @return VOID
+ */
+VOID
+CommandTracefile(vector<CommandToken> CommandTokens, string Command)
+{
+    TRACE_FILE_READER   Reader;
+    TRACE_FILE_ANALYSIS Analysis = {0};
+    string              Section;
+    string              FilePath;
+    UINT64              Count = TRACE_FILE_DEFAULT_COUNT_OF_SHOWN_ENTRIES;
+    UINT32              CoreId;
+    UINT64              RecordNumber;
+
+    if (CommandTokens.size() <= 2)
+    {
+        ShowMessages("err, incorrect use of the '%s' command\n\n",
+                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(0)).c_str());
+        CommandTracefileHelp();
+        return;
+    }
+
+    Section  = GetLowerStringFromCommandToken(CommandTokens.at(1));
+    FilePath = GetCaseSensitiveStringFromCommandToken(CommandTokens.at(2));
+
+    //
+    // Check the parameters of each option
+    //
+    if ((Section == "info" || Section == "coverage") && CommandTokens.size() != 3)
+    {
+        ShowMessages("err, incorrect use of the '%s' command\n\n", Section.c_str());
+        CommandTracefileHelp();
+        return;
+    }
+    else if (Section == "hot" || Section == "blocks")
+    {
+        if (CommandTokens.size() > 4 ||
+            (CommandTokens.size() == 4 && !ConvertTokenToUInt64(CommandTokens.at(3), &Count)))
+        {
+            ShowMessages("err, please specify a correct count\n\n");
+            return;
+        }
+    }
+    else if (Section == "show")
+    {
+        if (CommandTokens.size() < 5 ||
+            CommandTokens.size() > 6 ||
+            !ConvertTokenToUInt32(CommandTokens.at(3), &CoreId) ||
+            !ConvertTokenToUInt64(CommandTokens.at(4), &RecordNumber) ||
+            (CommandTokens.size() == 6 && !ConvertTokenToUInt64(CommandTokens.at(5), &Count)))
+        {
+            ShowMessages("err, please specify a correct core and record number\n\n");
+            return;
+        }
+    }
+    else if (Section == "csv")
+    {
+        if (CommandTokens.size() != 4)
+        {
+            ShowMessages("err, please specify the path of the CSV file\n\n");
+            return;
+        }
+    }
+    else if (Section != "info" && Section != "coverage")
+    {
+        ShowMessages("err, couldn't resolve error at '%s'\n\n",
+                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(1)).c_str());
+        CommandTracefileHelp();
+        return;
+    }
+
+    if (!TraceFileReaderOpen(&Reader, FilePath.c_str()))
+    {
+        ShowMessages("err, unable to open the trace file (%s)\n", FilePath.c_str());
+        return;
+    }
+
+    if (Reader.IsIndexRebuilt)
+    {
+        ShowMessages("the index of the trace file is not valid (the file might be truncated), "
+                     "the index is rebuilt from %x valid chunks\n",
+                     Reader.Index.size());
+    }
+
+    if (Section == "show")
+    {
+        CommandTracefileShowRecords(&Reader, CoreId, RecordNumber, Count);
+        TraceFileReaderClose(&Reader);
+        return;
+    }
+    else if (Section == "csv")
+    {
+        if (!TraceFileExportCsv(&Reader, GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3)).c_str()))
+        {
+            ShowMessages("err, unable to export the trace file\n");
+        }
+        else
+        {
+            ShowMessages("the trace file is exported to '%s'\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(3)).c_str());
+        }
+
+        TraceFileReaderClose(&Reader);
+        return;
+    }
+
+    //
+    // Other options need the analysis of the entire file
+    //
+    if (!TraceFileAnalyze(&Reader, CommandTracefileGetInstructionLength, NULL, &Analysis))
+    {
+        ShowMessages("err, the trace file is corrupted (the records are analyzed partially)\n");
+    }
+
+    TraceFileReaderClose(&Reader);
+
+    if (Section == "info")
+    {
+        ShowMessages("version: %x\n", Reader.Header.Version);
+        ShowMessages("records: %llx (%llx chunks)\n", Analysis.CountOfRecords, Analysis.CountOfChunks);
+
+        for (auto & RecordsOfCore : Analysis.RecordsOfCores)
+        {
+            ShowMessages("    core %x: %llx records\n", RecordsOfCore.first, RecordsOfCore.second);
+        }
+
+        if (Analysis.CountOfCalls != 0 || Analysis.CountOfRets != 0)
+        {
+            ShowMessages("calls: %llx, rets: %llx, maximum depth: %x\n",
+                         Analysis.CountOfCalls,
+                         Analysis.CountOfRets,
+                         Analysis.MaximumDepth);
+        }
+    }
+    else if (Section == "coverage")
+    {
+        UINT64 CountOfInstructions = 0;
+
+        for (auto & Block : Analysis.BasicBlocks)
+        {
+            CountOfInstructions += Block.second.CountOfInstructions;
+        }
+
+        ShowMessages("unique addresses: %llx\n", (UINT64)Analysis.Hits.size());
+        ShowMessages("basic blocks: %llx (%llx instructions)\n", (UINT64)Analysis.BasicBlocks.size(), CountOfInstructions);
+    }
+    else if (Section == "hot")
+    {
+        vector<pair<UINT64, UINT64>> Hits(Analysis.Hits.begin(), Analysis.Hits.end());
+
+        //
+        // Most executed addresses (or call targets) first
+        //
+        sort(Hits.begin(), Hits.end(), [](const pair<UINT64, UINT64> & First, const pair<UINT64, UINT64> & Second) {
+            return First.second > Second.second || (First.second == Second.second && First.first < Second.first);
+        });
+
+        for (size_t i = 0; i < Hits.size() && i < Count; i++)
+        {
+            ShowMessages("%016llx hits   ", Hits[i].second);
+            CommandTracefileShowAddress(Hits[i].first);
+            ShowMessages("\n");
+        }
+    }
+    else if (Section == "blocks")
+    {
+        vector<TRACE_FILE_BASIC_BLOCK> Blocks;
+
+        for (auto & Block : Analysis.BasicBlocks)
+        {
+            Blocks.push_back(Block.second);
+        }
+
+        //
+        // Blocks that executed the most instructions first
+        //
+        sort(Blocks.begin(), Blocks.end(), [](const TRACE_FILE_BASIC_BLOCK & First, const TRACE_FILE_BASIC_BLOCK & Second) {
+            return First.ExecutionCount * First.CountOfInstructions > Second.ExecutionCount * Second.CountOfInstructions;
+        });
+
+        for (size_t i = 0; i < Blocks.size() && i < Count; i++)
+        {
+            ShowMessages("%016llx times, %x instructions   ", Blocks[i].ExecutionCount, Blocks[i].CountOfInstructions);
+            CommandTracefileShowAddress(Blocks[i].Start);
+            ShowMessages(" - %s\n", SeparateTo64BitValue(Blocks[i].LastInstruction).c_str());
+        }
+    }
+}
@@ -20,7 +20,6 @@ extern BOOLEAN g_IsConnectedToHyperDbgLocally;
 extern BOOLEAN g_IsConnectedToRemoteDebuggee;
 extern BOOLEAN g_IsConnectedToRemoteDebugger;
 extern BOOLEAN g_BreakPrintingOutput;
-extern BOOLEAN g_IsEndOfMessageReceived;
 
 extern SOCKET g_SeverSocket;
 extern SOCKET g_ServerListenSocket;
@@ -28,6 +27,9 @@ extern SOCKET g_ClientConnectSocket;
 
 extern HANDLE g_RemoteDebuggeeListeningThread;
 extern HANDLE g_EndOfMessageReceivedEvent;
+extern HANDLE g_PipelinedCommandsMutex;
+
+extern std::list<std::string> g_PipelinedCommands;
 
 /**
  * @brief Listen of a port and wait for a client connection
@@ -39,7 +41,10 @@ extern HANDLE g_EndOfMessageReceivedEvent;
 VOID
 RemoteConnectionListen(PCSTR Port)
 {
-    char recvbuf[COMMUNICATION_BUFFER_SIZE] = {0};
+    char   recvbuf[COMMUNICATION_BUFFER_SIZE] = {0};
+    UINT32 BuffLenReceived                    = 0;
+    UINT32 PendingLength                      = 0;
+    UINT32 CommandStart;
 
     //
     // Check if the debugger or debuggee is already active
@@ -57,7 +62,7 @@ RemoteConnectionListen(PCSTR Port)
     //
     // Check the version of debuggee and debugger
     //
-    if (CommunicationServerReceiveMessage(g_SeverSocket, recvbuf, COMMUNICATION_BUFFER_SIZE) != 0)
+    if (CommunicationServerReceiveMessage(g_SeverSocket, recvbuf, COMMUNICATION_BUFFER_SIZE, &BuffLenReceived) != 0)
     {
         //
         // Failed
@@ -143,39 +148,79 @@ RemoteConnectionListen(PCSTR Port)
         // we don't send the results to the remote machine by using
         // this tools
         //
-        if (CommunicationServerReceiveMessage(g_SeverSocket, recvbuf, COMMUNICATION_BUFFER_SIZE) != 0)
+        if (CommunicationServerReceiveMessage(g_SeverSocket,
+                                              recvbuf + PendingLength,
+                                              COMMUNICATION_BUFFER_SIZE - PendingLength - 1,
+                                              &BuffLenReceived) != 0 ||
+            BuffLenReceived == 0)
         {
             //
-            // Failed, break
+            // Failed or the connection is closed, break
             //
             break;
         }
 
-        //
-        // Execute the command
-        //
-        int CommandExecutionResult = HyperDbgInterpreter(recvbuf);
+        BuffLenReceived += PendingLength;
+
+        CommandStart = 0;
 
         //
-        // Send end of buffer
+        // Each command is terminated by a null character, the debugger
+        // might send multiple commands without waiting for the results
+        // (pipelined commands of batch scripts), so a single message
+        // could contain multiple commands or a part of the next command
         //
-        RemoteConnectionSendResultsToHost((const char *)g_EndOfBufferCheckTcp, sizeof(g_EndOfBufferCheckTcp));
+        for (UINT32 i = 0; i < BuffLenReceived; i++)
+        {
+            if (recvbuf[i] != '\0')
+            {
+                continue;
+            }
+
+            //
+            // Execute the command
+            //
+            int CommandExecutionResult = HyperDbgInterpreter(recvbuf + CommandStart);
+
+            //
+            // Send end of buffer
+            //
+            RemoteConnectionSendResultsToHost((const char *)g_EndOfBufferCheckTcp, sizeof(g_EndOfBufferCheckTcp));
+
+            //
+            // if the debugger encounters an exit state then the return will be 1
+            //
+            if (CommandExecutionResult == 1)
+            {
+                //
+                // Exit from the debugger
+                //
+                exit(0);
+            }
+
+            CommandStart = i + 1;
+        }
 
         //
-        // if the debugger encounters an exit state then the return will be 1
+        // Keep the remaining part of the next command
         //
-        if (CommandExecutionResult == 1)
+        PendingLength = BuffLenReceived - CommandStart;
+
+        if (PendingLength == COMMUNICATION_BUFFER_SIZE - 1)
         {
             //
-            // Exit from the debugger
+            // The command is too long, ignore it
             //
-            exit(0);
+            ShowMessages("err, the command is too long\n");
+            PendingLength = 0;
         }
 
+        memmove(recvbuf, recvbuf + CommandStart, PendingLength);
+
         //
         // Zero the buffer for next command
         //
-        RtlZeroMemory(recvbuf, COMMUNICATION_BUFFER_SIZE);
+        RtlZeroMemory(recvbuf + PendingLength, COMMUNICATION_BUFFER_SIZE - PendingLength);
     }
 
     //
@@ -200,6 +245,93 @@ RemoteConnectionListen(PCSTR Port)
                                                     g_ServerListenSocket);
 }
 
+/**
+ * @brief Show the oldest command that its results are not received yet
+ * @details the command is shown once before its results, thus, the
+ * results of the pipelined commands are not mixed with the next commands
+ *
+ * @param IsCommandShown whether the command is already shown
+ * @return VOID
+ */
+static VOID
+RemoteConnectionShowPipelinedCommand(BOOLEAN * IsCommandShown)
+{
+    if (*IsCommandShown)
+    {
+        return;
+    }
+
+    WaitForSingleObject(g_PipelinedCommandsMutex, INFINITE);
+
+    if (!g_PipelinedCommands.empty() && !g_PipelinedCommands.front().empty())
+    {
+        //
+        // Show the command the same way as the interpreter
+        //
+        HyperDbgShowSignature();
+
+        ShowMessages("%s\n", g_PipelinedCommands.front().c_str());
+    }
+
+    ReleaseMutex(g_PipelinedCommandsMutex);
+
+    *IsCommandShown = TRUE;
+}
+
+/**
+ * @brief Remove the oldest command once its results are received
+ *
+ * @param IsCommandShown whether the command is already shown
+ * @return VOID
+ */
+static VOID
+RemoteConnectionReleasePipelinedCommand(BOOLEAN * IsCommandShown)
+{
+    //
+    // Commands without any results are also shown
+    //
+    RemoteConnectionShowPipelinedCommand(IsCommandShown);
+
+    WaitForSingleObject(g_PipelinedCommandsMutex, INFINITE);
+
+    if (!g_PipelinedCommands.empty())
+    {
+        g_PipelinedCommands.pop_front();
+    }
+
+    ReleaseMutex(g_PipelinedCommandsMutex);
+
+    *IsCommandShown = FALSE;
+}
+
+/**
+ * @brief Show the results that are received from the server (debuggee)
+ *
+ * @param Buffer
+ * @param Length
+ * @param IsCommandShown whether the command of the results is already shown
+ * @return VOID
+ */
+static VOID
+RemoteConnectionShowResults(const CHAR * Buffer, UINT32 Length, BOOLEAN * IsCommandShown)
+{
+    //
+    // This is just because we want to show a correct signature
+    //
+    if (Length != 0 && !g_BreakPrintingOutput)
+    {
+        //
+        // Show the command of these results first
+        //
+        RemoteConnectionShowPipelinedCommand(IsCommandShown);
+
+        //
+        // Show message from remote debuggee
+        //
+        ShowMessages("%.*s", Length, Buffer);
+    }
+}
+
 /**
  * @brief A thread that listens for server (debuggee) messages
  * and show it by using ShowMessages wrapper
@@ -210,8 +342,11 @@ RemoteConnectionListen(PCSTR Port)
 DWORD WINAPI
 RemoteConnectionThreadListeningToDebuggee(LPVOID lpParam)
 {
-    char   RecvBuf[COMMUNICATION_BUFFER_SIZE + TCP_END_OF_BUFFER_CHARS_COUNT] = {0};
-    UINT32 BuffLenReceived                                                    = 0;
+    char    RecvBuf[COMMUNICATION_BUFFER_SIZE + TCP_END_OF_BUFFER_CHARS_COUNT] = {0};
+    UINT32  BuffLenReceived                                                    = 0;
+    UINT32  MatchedEndOfBufferChars                                            = 0;
+    BOOLEAN IsCommandShown                                                     = FALSE;
+    UINT32  ResultLength;
 
     while (g_IsConnectedToRemoteDebuggee)
     {
@@ -227,52 +362,58 @@ RemoteConnectionThreadListeningToDebuggee(LPVOID lpParam)
         }
 
         //
-        // Check if it's end of the buffer
+        // Remove the end of the buffers, the results of multiple commands
+        // might be received at once (pipelined commands of batch scripts)
+        // and the end of the buffer might be split between two messages,
+        // thus, the matched characters are kept for the next message
         //
-        for (size_t i = 0; i < BuffLenReceived; i++)
+        ResultLength = 0;
+
+        for (UINT32 i = 0; i < BuffLenReceived; i++)
         {
-            if (RecvBuf[i] == g_EndOfBufferCheckTcp[0] &&
-                RecvBuf[i + 1] == g_EndOfBufferCheckTcp[1] &&
-                RecvBuf[i + 2] == g_EndOfBufferCheckTcp[2] &&
-                RecvBuf[i + 3] == g_EndOfBufferCheckTcp[3])
+            if (RecvBuf[i] == (CHAR)g_EndOfBufferCheckTcp[MatchedEndOfBufferChars])
             {
-                g_IsEndOfMessageReceived = TRUE;
+                MatchedEndOfBufferChars++;
+
+                if (MatchedEndOfBufferChars == TCP_END_OF_BUFFER_CHARS_COUNT)
+                {
+                    MatchedEndOfBufferChars = 0;
 
+                    RemoteConnectionShowResults(RecvBuf, ResultLength, &IsCommandShown);
+                    ResultLength = 0;
+
+                    //
+                    // Indicate that the results of one command is received
+                    //
+                    RemoteConnectionReleasePipelinedCommand(&IsCommandShown);
+
+                    ReleaseSemaphore(g_EndOfMessageReceivedEvent, 1, NULL);
+                }
+
+                continue;
+            }
+
+            if (MatchedEndOfBufferChars != 0)
+            {
                 //
-                // Cut the last string using \x00 \x00
+                // The matched characters were a part of the results
                 //
-                RecvBuf[i]     = '\x00';
-                RecvBuf[i + 1] = '\x00';
-                break;
+                RemoteConnectionShowResults(RecvBuf, ResultLength, &IsCommandShown);
+                RemoteConnectionShowResults((const CHAR *)g_EndOfBufferCheckTcp, MatchedEndOfBufferChars, &IsCommandShown);
+                ResultLength            = 0;
+                MatchedEndOfBufferChars = 0;
+
+                if (RecvBuf[i] == (CHAR)g_EndOfBufferCheckTcp[0])
+                {
+                    MatchedEndOfBufferChars = 1;
+                    continue;
+                }
             }
-        }
 
-        //
-        // This is just because we want to show a correct signature
-        //
-        if (!g_BreakPrintingOutput)
-        {
-            //
-            // Show message from remote debuggee
-            //
-            ShowMessages("%s", RecvBuf);
+            RecvBuf[ResultLength++] = RecvBuf[i];
         }
 
-        //
-        // Show the signature
-        //
-        if (g_IsEndOfMessageReceived)
-        {
-            //
-            // it's not end of message anymore
-            //
-            g_IsEndOfMessageReceived = FALSE;
-
-            //
-            // Trigger the event
-            //
-            SetEvent(g_EndOfMessageReceivedEvent);
-        }
+        RemoteConnectionShowResults(RecvBuf, ResultLength, &IsCommandShown);
 
         //
         // Clear the buffer
@@ -408,13 +549,26 @@ RemoteConnectionConnect(PCSTR Ip, PCSTR Port)
         g_IsConnectedToRemoteDebuggee = TRUE;
 
         //
-        // Create an event to show signature when the messages finished
+        // Create a semaphore to show signature when the messages finished, it's
+        // released once for the results of each command as multiple commands
+        // might be sent without waiting for the results
         //
         if (g_EndOfMessageReceivedEvent == NULL)
         {
-            g_EndOfMessageReceivedEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+            g_EndOfMessageReceivedEvent = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+        }
+
+        //
+        // Create a mutex for the commands that their results are not received,
+        // the commands of a previous connection are not received anymore
+        //
+        if (g_PipelinedCommandsMutex == NULL)
+        {
+            g_PipelinedCommandsMutex = CreateMutex(NULL, FALSE, NULL);
         }
 
+        g_PipelinedCommands.clear();
+
         //
         // Now, we should create a thread, which always listens to
         // the remote debuggee for new messages
@@ -447,7 +601,7 @@ RemoteConnectionSendCommand(const char * sendbuf, int len)
     //
     // Send Message
     //
-    if (CommunicationClientSendMessage(g_ClientConnectSocket, sendbuf, len) != 0)
+    if (RemoteConnectionSendPipelinedCommand(sendbuf, len, FALSE) != 0)
     {
         //
         // Failed
@@ -458,9 +612,77 @@ RemoteConnectionSendCommand(const char * sendbuf, int len)
     //
     // We wait for the debuggee to send the message
     //
-    WaitForSingleObject(
-        g_EndOfMessageReceivedEvent,
-        INFINITE);
+    return RemoteConnectionWaitForResults(1);
+}
+
+/**
+ * @brief send the command as a client (debugger, host) to the
+ * server (debuggee, guest) without waiting for the results
+ * @details the results should be waited by RemoteConnectionWaitForResults,
+ * the server executes the commands in order, so the commands are queued
+ * in the same order to show each command before its results
+ *
+ * @param sendbuf address of message buffer (including the null character)
+ * @param len length of buffer
+ * @param ShowCommand whether the command is shown once its results are received
+ * @return int returning 0 means that there was no error in
+ * executing the function and 1 shows there was an error
+ */
+int
+RemoteConnectionSendPipelinedCommand(const char * sendbuf, int len, BOOLEAN ShowCommand)
+{
+    WaitForSingleObject(g_PipelinedCommandsMutex, INFINITE);
+
+    g_PipelinedCommands.push_back(ShowCommand ? std::string(sendbuf) : std::string());
+
+    //
+    // Send Message
+    //
+    if (CommunicationClientSendMessage(g_ClientConnectSocket, sendbuf, len) != 0)
+    {
+        g_PipelinedCommands.pop_back();
+
+        ReleaseMutex(g_PipelinedCommandsMutex);
+
+        //
+        // Failed
+        //
+        return 1;
+    }
+
+    ReleaseMutex(g_PipelinedCommandsMutex);
+
+    //
+    // Successful
+    //
+    return 0;
+}
+
+/**
+ * @brief wait for the results of the commands that are sent to the
+ * server (debuggee, guest)
+ *
+ * @param Count number of commands
+ * @return int returning 0 means that there was no error in
+ * executing the function and 1 shows there was an error
+ */
+int
+RemoteConnectionWaitForResults(UINT32 Count)
+{
+    for (UINT32 i = 0; i < Count; i++)
+    {
+        //
+        // We wait for the debuggee to send the message, the connection
+        // might be closed while waiting
+        //
+        while (WaitForSingleObject(g_EndOfMessageReceivedEvent, REMOTE_CONNECTION_WAIT_FOR_RESULTS_INTERVAL) == WAIT_TIMEOUT)
+        {
+            if (!g_IsConnectedToRemoteDebuggee)
+            {
+                return 1;
+            }
+        }
+    }
 
     //
     // Successful
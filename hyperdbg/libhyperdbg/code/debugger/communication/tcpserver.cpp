@@ -141,19 +141,27 @@ CommunicationServerCreateServerAndWaitForClient(PCSTR    Port,
  * @param ClientSocket
  * @param recvbuf
  * @param recvbuflen
+ * @param BuffLenRecvd
  * @return int
  */
 int
-CommunicationServerReceiveMessage(SOCKET ClientSocket, char * recvbuf, int recvbuflen)
+CommunicationServerReceiveMessage(SOCKET ClientSocket, char * recvbuf, int recvbuflen, PUINT32 BuffLenRecvd)
 {
     int iResult;
 
+    *BuffLenRecvd = 0;
+
     //
     // Receive until the peer shuts down the connection
     //
     iResult = recv(ClientSocket, recvbuf, recvbuflen, 0);
     if (iResult > 0)
     {
+        //
+        // Set recvd buff len
+        //
+        *BuffLenRecvd = iResult;
+
         //
         // ShowMessages("bytes received: %d\n", iResult);
         //
@@ -22,6 +22,7 @@ extern BOOLEAN                  g_IsSerialConnectedToRemoteDebuggee;
 extern BOOLEAN                  g_IsExecutingSymbolLoadingRoutines;
 extern BOOLEAN                  g_IsInstrumentingInstructions;
 extern BOOLEAN                  g_IgnorePauseRequests;
+extern BOOLEAN                  g_HwdbgIsWaitingForResponse;
 extern ACTIVE_DEBUGGING_PROCESS g_ActiveProcessDebuggingState;
 
 /**
@@ -65,6 +66,14 @@ BreakController(DWORD CtrlType)
             ScriptEngineSymbolAbortLoadingWrapper();
         }
 
+        //
+        // Check for aborting the wait for the response of hwdbg
+        //
+        if (g_HwdbgIsWaitingForResponse)
+        {
+            g_HwdbgIsWaitingForResponse = FALSE;
+        }
+
         //
         // Check if the debuggee is running because of pausing or not
         //
@@ -0,0 +1,1293 @@
+/**
+ * @file command-parser.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The command parser (tokenizer) and the dispatch table of commands
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern CommandType g_CommandsList;
+
+/**
+ * @brief Position that is not found
+ *
+ */
+#define COMMAND_PARSER_NOT_FOUND ((SIZE_T)-1)
+
+/**
+ * @brief Check whether the character is a white-space
+ *
+ * @param Character
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+CommandParserIsSpace(CHAR Character)
+{
+    return isspace((unsigned char)Character) != 0;
+}
+
+/**
+ * @brief Convert a character to lowercase
+ *
+ * @param Character
+ *
+ * @return CHAR
+ */
+static CHAR
+CommandParserToLower(CHAR Character)
+{
+    return (CHAR)tolower((unsigned char)Character);
+}
+
+/**
+ * @brief Check whether the character has a special meaning for the parser
+ *
+ * @param Character
+ * @param IsSpaceIgnored Whether spaces are part of the token (in quotes and
+ * brackets)
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+CommandParserIsSpecial(CHAR Character, BOOLEAN IsSpaceIgnored)
+{
+    switch (Character)
+    {
+    case '/':
+    case '"':
+    case '{':
+    case '}':
+    case '\\':
+        return TRUE;
+
+    case ' ':
+        return !IsSpaceIgnored;
+
+    default:
+        return FALSE;
+    }
+}
+
+/**
+ * @brief Check whether a token could be a number
+ * @details Numbers only contain hex digits, their prefixes (0x, 0n, \x,
+ * \n, x, n) and the '`' separator, other tokens are not converted
+ *
+ * @param Text
+ * @param Length
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+CommandParserIsNumberCandidate(const CHAR * Text, UINT32 Length)
+{
+    for (UINT32 i = 0; i < Length; i++)
+    {
+        CHAR c = Text[i];
+
+        if (!isxdigit((unsigned char)c) && c != 'x' && c != 'X' && c != 'n' && c != 'N' && c != '`' && c != '\\')
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Constructor of the command parser
+ *
+ */
+CommandParser::CommandParser()
+{
+    m_Input              = NULL;
+    m_Length             = 0;
+    m_IsCurrentInStorage = FALSE;
+    m_CurrentStart       = 0;
+    m_CurrentEnd         = 0;
+
+    m_Tokens.reserve(COMMAND_PARSER_RESERVED_TOKENS);
+}
+
+/**
+ * @brief Get a character of the input
+ *
+ * @param Position
+ *
+ * @return CHAR The character or a null character if the position is out of range
+ */
+CHAR
+CommandParser::GetChar(SIZE_T Position) const
+{
+    return Position < m_Length ? m_Input[Position] : '\0';
+}
+
+/**
+ * @brief Check whether a character of the input is erased
+ *
+ * @param Position
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandParser::IsErased(SIZE_T Position) const
+{
+    return !m_Erased.empty() && Position < m_Length && m_Erased[Position];
+}
+
+/**
+ * @brief Get the position before a position of the input (erased characters
+ * are skipped)
+ *
+ * @param Position
+ *
+ * @return SIZE_T The position or COMMAND_PARSER_NOT_FOUND
+ */
+SIZE_T
+CommandParser::GetPreviousPosition(SIZE_T Position) const
+{
+    while (Position != 0)
+    {
+        Position--;
+
+        if (!IsErased(Position))
+        {
+            return Position;
+        }
+    }
+
+    return COMMAND_PARSER_NOT_FOUND;
+}
+
+/**
+ * @brief Get the position after a position of the input (erased characters
+ * are skipped)
+ *
+ * @param Position
+ *
+ * @return SIZE_T
+ */
+SIZE_T
+CommandParser::GetNextPosition(SIZE_T Position) const
+{
+    do
+    {
+        Position++;
+
+    } while (IsErased(Position));
+
+    return Position;
+}
+
+/**
+ * @brief Get the character before a position of the input (erased characters
+ * are skipped)
+ *
+ * @param Position
+ *
+ * @return CHAR The character or a null character if there is no previous character
+ */
+CHAR
+CommandParser::GetPreviousChar(SIZE_T Position) const
+{
+    Position = GetPreviousPosition(Position);
+
+    return Position != COMMAND_PARSER_NOT_FOUND ? m_Input[Position] : '\0';
+}
+
+/**
+ * @brief Erase a character after the current position of the input
+ *
+ * @param Position
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::Erase(SIZE_T Position)
+{
+    if (m_Erased.empty())
+    {
+        m_Erased.resize(m_Length, FALSE);
+    }
+
+    m_Erased[Position] = TRUE;
+}
+
+/**
+ * @brief Find a character in the input
+ *
+ * @param Character
+ * @param Position The position to start searching
+ *
+ * @return SIZE_T The position or COMMAND_PARSER_NOT_FOUND
+ */
+SIZE_T
+CommandParser::Find(CHAR Character, SIZE_T Position) const
+{
+    const CHAR * Result;
+
+    if (Position >= m_Length)
+    {
+        return COMMAND_PARSER_NOT_FOUND;
+    }
+
+    Result = (const CHAR *)memchr(m_Input + Position, Character, m_Length - Position);
+
+    return Result != NULL ? (SIZE_T)(Result - m_Input) : COMMAND_PARSER_NOT_FOUND;
+}
+
+/**
+ * @brief Find the "\n" sequence (entered by the user) in the input
+ *
+ * @param Position The position to start searching
+ *
+ * @return SIZE_T The position of the backslash or COMMAND_PARSER_NOT_FOUND
+ */
+SIZE_T
+CommandParser::FindEscapedNewLine(SIZE_T Position) const
+{
+    while ((Position = Find('\\', Position)) != COMMAND_PARSER_NOT_FOUND)
+    {
+        //
+        // Erased characters are always followed by '}' (or other erased
+        // characters), so they're never part of this sequence
+        //
+        if (!IsErased(Position) && GetChar(Position + 1) == 'n')
+        {
+            return Position;
+        }
+
+        Position++;
+    }
+
+    return COMMAND_PARSER_NOT_FOUND;
+}
+
+/**
+ * @brief Append a character of the input to the current token
+ * @details The token remains a range of the input as long as the characters
+ * are contiguous, otherwise it's copied to the storage
+ *
+ * @param Position
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::Append(SIZE_T Position)
+{
+    SIZE_T Start;
+
+    if (!m_IsCurrentInStorage)
+    {
+        if (m_CurrentStart == m_CurrentEnd)
+        {
+            m_CurrentStart = Position;
+            m_CurrentEnd   = Position + 1;
+            return;
+        }
+
+        if (Position == m_CurrentEnd)
+        {
+            m_CurrentEnd++;
+            return;
+        }
+
+        Start = m_Storage.size();
+        m_Storage.append(m_Input + m_CurrentStart, m_CurrentEnd - m_CurrentStart);
+
+        m_IsCurrentInStorage = TRUE;
+        m_CurrentStart       = Start;
+        m_CurrentEnd         = m_Storage.size();
+    }
+
+    m_Storage.push_back(m_Input[Position]);
+    m_CurrentEnd++;
+}
+
+/**
+ * @brief Append contiguous characters of the input to the current token
+ *
+ * @param Start
+ * @param End
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::AppendRun(SIZE_T Start, SIZE_T End)
+{
+    if (!m_IsCurrentInStorage)
+    {
+        if (m_CurrentStart == m_CurrentEnd)
+        {
+            m_CurrentStart = Start;
+            m_CurrentEnd   = End;
+            return;
+        }
+
+        if (Start == m_CurrentEnd)
+        {
+            m_CurrentEnd = End;
+            return;
+        }
+
+        Append(Start++);
+    }
+
+    m_Storage.append(m_Input + Start, End - Start);
+    m_CurrentEnd += End - Start;
+}
+
+/**
+ * @brief Append a range of the input (e.g., a comment) to the current token
+ *
+ * @param Start
+ * @param End
+ * @param FixEscapedNewLines Whether "\\n" sequences should be replaced with "\n"
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::AppendRange(SIZE_T Start, SIZE_T End, BOOLEAN FixEscapedNewLines)
+{
+    for (SIZE_T i = Start; i < End; i++)
+    {
+        if (IsErased(i))
+        {
+            continue;
+        }
+
+        if (FixEscapedNewLines && m_Input[i] == '\\' && GetChar(i + 1) == '\\' && GetChar(i + 2) == 'n')
+        {
+            continue;
+        }
+
+        Append(i);
+    }
+}
+
+/**
+ * @brief Remove the last character of the current token (an escape character)
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::RemoveLastCharacter()
+{
+    if (m_CurrentStart == m_CurrentEnd)
+    {
+        return;
+    }
+
+    if (m_IsCurrentInStorage)
+    {
+        m_Storage.pop_back();
+    }
+
+    m_CurrentEnd--;
+}
+
+/**
+ * @brief Check whether the current token is empty or a single space
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandParser::IsCurrentEmptyOrSpace() const
+{
+    SIZE_T Length = m_CurrentEnd - m_CurrentStart;
+
+    if (Length == 0)
+    {
+        return TRUE;
+    }
+
+    return Length == 1 && (m_IsCurrentInStorage ? m_Storage[m_CurrentStart] : m_Input[m_CurrentStart]) == ' ';
+}
+
+/**
+ * @brief Start a new token
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::ClearCurrent()
+{
+    m_IsCurrentInStorage = FALSE;
+    m_CurrentStart       = 0;
+    m_CurrentEnd         = 0;
+}
+
+/**
+ * @brief Add the current token to the tokens
+ *
+ * @param Type
+ * @param IsNumberAllowed Whether the token could be converted to a number
+ * @param ShouldTrim Whether white-spaces should be removed (empty tokens are
+ * ignored)
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::AddToken(CommandParsingTokenType Type, BOOLEAN IsNumberAllowed, BOOLEAN ShouldTrim)
+{
+    const CHAR *         Text  = m_IsCurrentInStorage ? m_Storage.data() : m_Input;
+    SIZE_T               Start = m_CurrentStart;
+    SIZE_T               End   = m_CurrentEnd;
+    COMMAND_PARSER_TOKEN Token = {};
+
+    if (ShouldTrim)
+    {
+        while (Start < End && CommandParserIsSpace(Text[Start]))
+        {
+            Start++;
+        }
+
+        while (End > Start && CommandParserIsSpace(Text[End - 1]))
+        {
+            End--;
+        }
+
+        if (Start == End)
+        {
+            return;
+        }
+    }
+
+    Token.Type            = Type;
+    Token.IsNumberAllowed = IsNumberAllowed;
+    Token.IsInStorage     = m_IsCurrentInStorage;
+    Token.Offset          = (UINT32)Start;
+    Token.Length          = (UINT32)(End - Start);
+
+    m_Tokens.push_back(Token);
+}
+
+/**
+ * @brief Tokenize the input string (commands)
+ * @details The command is parsed in a single pass, the tokens refer to the
+ * input, so it should not be freed or modified while the tokens are used.
+ * Escape characters are removed and comments are kept in the scripts
+ * (bracket strings), such tokens are copied to the storage of the parser
+ *
+ * @param Input
+ * @param Length
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::Tokenize(const CHAR * Input, SIZE_T Length)
+{
+    BOOLEAN InQuotes   = FALSE;
+    UINT32  IdxBracket = 0;
+    CHAR    c;
+
+    m_Input  = Input;
+    m_Length = Length;
+
+    m_Erased.clear();
+    m_Storage.clear();
+    m_Tokens.clear();
+    ClearCurrent();
+
+    for (SIZE_T i = 0; i < m_Length; i++)
+    {
+        //
+        // Escape characters that are removed while parsing the comments
+        //
+        if (IsErased(i))
+        {
+            continue;
+        }
+
+        c = m_Input[i];
+
+        //
+        // Characters without any special meaning are appended at once
+        //
+        if (!CommandParserIsSpecial(c, InQuotes || IdxBracket))
+        {
+            SIZE_T End = i + 1;
+
+            while (End < m_Length && !CommandParserIsSpecial(m_Input[End], InQuotes || IdxBracket) && !IsErased(End))
+            {
+                End++;
+            }
+
+            AppendRun(i, End);
+
+            i = End - 1;
+            continue;
+        }
+
+        if (c == '/' && !InQuotes) // start comment parse
+        {
+            CHAR c2 = GetChar(i + 1);
+
+            if (c2 == '/') // start to look for comments
+            {
+                SIZE_T  StrLitEnd     = 0;
+                SIZE_T  StrLitBeg     = Find('"', i);
+                SIZE_T  CloseBrktPos  = COMMAND_PARSER_NOT_FOUND;
+                SIZE_T  NewLineSrtPos = COMMAND_PARSER_NOT_FOUND;
+                SIZE_T  NewLineChrPos = COMMAND_PARSER_NOT_FOUND;
+                SIZE_T  Min           = COMMAND_PARSER_NOT_FOUND;
+                BOOLEAN IsNewLineEsc  = FALSE;
+
+                //
+                // to solve cases like: //"}"
+                //
+                if (StrLitBeg != COMMAND_PARSER_NOT_FOUND && GetPreviousChar(i) != '\\')
+                {
+                    StrLitEnd = Find('"', StrLitBeg + 1);
+                }
+
+                //
+                // assuming " }" as the end of a line comment aka //, if we are within {}
+                // (escaped '}' characters are unescaped)
+                //
+                if (IdxBracket)
+                {
+                    CloseBrktPos = Find('}', StrLitEnd != 0 ? StrLitEnd : i);
+
+                    while (CloseBrktPos != COMMAND_PARSER_NOT_FOUND && GetPreviousChar(CloseBrktPos) == '\\')
+                    {
+                        //
+                        // the character after the unescaped '}' is skipped
+                        //
+                        Erase(GetPreviousPosition(CloseBrktPos));
+                        CloseBrktPos = Find('}', GetNextPosition(GetNextPosition(CloseBrktPos)));
+                    }
+                }
+
+                NewLineSrtPos = FindEscapedNewLine(i); // "\\n" entered by user
+                NewLineChrPos = Find('\n', i);
+
+                //
+                // see which one occures first
+                //
+                Min = CloseBrktPos;
+
+                if (NewLineSrtPos < Min)
+                {
+                    Min = NewLineSrtPos;
+                }
+
+                if (NewLineChrPos < Min)
+                {
+                    Min = NewLineChrPos;
+                }
+
+                if (Min != COMMAND_PARSER_NOT_FOUND && GetPreviousChar(Min) != '\\')
+                {
+                    //
+                    // append comments to be passed to script engine
+                    //
+                    if (IdxBracket)
+                    {
+                        AppendRange(i, Min, FALSE);
+                    }
+
+                    //
+                    // forward the buffer
+                    //
+                    i = Min - 1;
+
+                    continue;
+                }
+                else
+                {
+                    //
+                    // no "\\n" nor '\n' found so we just mark the chars as comment till end of string
+                    //
+                    if (NewLineSrtPos != COMMAND_PARSER_NOT_FOUND)
+                    {
+                        IsNewLineEsc = GetPreviousChar(NewLineSrtPos) == '\\';
+                    }
+
+                    //
+                    // append comments to be passed to script engine (and fix the escaped newline)
+                    //
+                    if (IdxBracket)
+                    {
+                        AppendRange(i, m_Length, IsNewLineEsc);
+                    }
+
+                    //
+                    // forward the buffer
+                    //
+                    break;
+                }
+            }
+            else if (c2 == '*')
+            {
+                SIZE_T EndPose = i + 2; // +2 for cases like /*/
+
+                while ((EndPose = Find('*', EndPose)) != COMMAND_PARSER_NOT_FOUND && GetChar(EndPose + 1) != '/')
+                {
+                    EndPose++;
+                }
+
+                if (EndPose != COMMAND_PARSER_NOT_FOUND)
+                {
+                    //
+                    // append comments to be passed to script engine
+                    //
+                    if (IdxBracket)
+                    {
+                        AppendRange(i, EndPose + 2, FALSE); // */ is two bytes long
+                    }
+
+                    //
+                    // forward the buffer
+                    //
+                    i = EndPose + 1; // +1 for /
+
+                    continue;
+                }
+
+                //
+                // error: comment not closed
+                //
+            }
+        }
+
+        if (InQuotes && c == '"')
+        {
+            if (GetPreviousChar(i) != '\\')
+            {
+                InQuotes = FALSE;
+
+                //
+                // if the quoted text is not within brackets, regard it as a StringLiteral token
+                //
+                if (!IdxBracket)
+                {
+                    AddToken(StringLiteral, FALSE, TRUE);
+                    ClearCurrent();
+                    continue; // dont add " char
+                }
+
+                //
+                // if we are indeed within brackets, we continue to add the '"' char to the current buffer
+                //
+                Append(i);
+                continue;
+            }
+            else
+            {
+                RemoveLastCharacter(); // remove the escape character
+                Append(i);
+                continue;
+            }
+        }
+
+        if (c == '}')
+        {
+            if (GetPreviousChar(i) != '\\')
+            {
+                if (IdxBracket)
+                {
+                    if (!InQuotes) // not closing }
+                    {
+                        IdxBracket--;
+                    }
+
+                    if (!IdxBracket) // is closing }
+                    {
+                        AddToken(BracketString, FALSE, FALSE);
+                        ClearCurrent();
+
+                        continue;
+                    }
+                }
+            }
+            else
+            {
+                RemoveLastCharacter(); // remove the escape character
+            }
+        }
+
+        if (c == ' ' && !InQuotes && !IdxBracket) // finding seperator space char
+        {
+            if (!IsCurrentEmptyOrSpace())
+            {
+                AddToken(String, TRUE, TRUE);
+                ClearCurrent();
+            }
+
+            continue; // avoid adding extra space char
+        }
+        else if (c == '"')
+        {
+            if (i) // check if this " is the first char to avoid out of range check
+            {
+                if (GetPreviousChar(i) != ' ' && !IdxBracket && m_CurrentStart != m_CurrentEnd && !InQuotes) // is prev cmd adjacent to "
+                {
+                    AddToken(String, FALSE, TRUE);
+                    ClearCurrent();
+                }
+
+                if (GetPreviousChar(i) != '\\')
+                {
+                    InQuotes = TRUE;
+                    if (!IdxBracket)
+                    {
+                        continue; // don't include '"' in string
+                    }
+                }
+            }
+            else
+            {
+                InQuotes = TRUE;
+                if (!IdxBracket)
+                {
+                    continue; // don't include '"' in string
+                }
+            }
+        }
+        else if (c == '{' && !InQuotes)
+        {
+            if (i) // check if this { is the first char to avoid out of range check
+            {
+                if (GetPreviousChar(i) != '\\')
+                {
+                    if (GetPreviousChar(i) != ' ' && !IdxBracket) // in case '{' is adjacent to previous command like "command{", on first {
+                    {
+                        AddToken(String, TRUE, TRUE);
+                        ClearCurrent();
+                    }
+
+                    IdxBracket++;
+                    if (IdxBracket == 1) // first {
+                        continue;        // don't include '{' in string
+                }
+                else
+                {
+                    RemoveLastCharacter(); // remove the escape character
+                }
+            }
+            else
+            {
+                IdxBracket++;
+                if (IdxBracket == 1) // first {
+                    continue;        // don't include '{' in string
+            }
+        }
+
+        //
+        // ignore astray \n
+        //
+        if (c == '\\' && !InQuotes)
+        {
+            if (m_CurrentStart == m_CurrentEnd && GetChar(i + 1) == 'n')
+            {
+                i++;
+                continue;
+            }
+        }
+
+        Append(i);
+    }
+
+    if (!IsCurrentEmptyOrSpace())
+    {
+        AddToken(String, TRUE, TRUE);
+    }
+
+    //
+    // Unclosed script brackets and quotes are not errors here, the
+    // remaining text is regarded as the last token
+    //
+}
+
+/**
+ * @brief Get the number of tokens
+ *
+ * @return UINT32
+ */
+UINT32
+CommandParser::GetTokenCount() const
+{
+    return (UINT32)m_Tokens.size();
+}
+
+/**
+ * @brief Get the text of a token (it's not null-terminated)
+ *
+ * @param Index
+ * @param Length Receives the length of the text
+ *
+ * @return const CHAR *
+ */
+const CHAR *
+CommandParser::GetTokenText(UINT32 Index, UINT32 * Length) const
+{
+    const COMMAND_PARSER_TOKEN & Token = m_Tokens.at(Index);
+
+    *Length = Token.Length;
+
+    return (Token.IsInStorage ? m_Storage.data() : m_Input) + Token.Offset;
+}
+
+/**
+ * @brief Compare a token with a lowercase string (case-insensitive)
+ *
+ * @param Index
+ * @param LowerCaseText
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandParser::IsTokenEqual(UINT32 Index, const CHAR * LowerCaseText) const
+{
+    UINT32       Length;
+    const CHAR * Text = GetTokenText(Index, &Length);
+
+    for (UINT32 i = 0; i < Length; i++)
+    {
+        if (LowerCaseText[i] == '\0' || CommandParserToLower(Text[i]) != LowerCaseText[i])
+        {
+            return FALSE;
+        }
+    }
+
+    return LowerCaseText[Length] == '\0';
+}
+
+/**
+ * @brief Get the text of a token (case-sensitive)
+ *
+ * @param Index
+ *
+ * @return std::string
+ */
+std::string
+CommandParser::GetTokenString(UINT32 Index) const
+{
+    UINT32       Length;
+    const CHAR * Text = GetTokenText(Index, &Length);
+
+    return std::string(Text, Length);
+}
+
+/**
+ * @brief Convert the tokens to the tokens of commands
+ * @details Numbers are detected here
+ *
+ * @return std::vector<CommandToken>
+ */
+std::vector<CommandToken>
+CommandParser::GetCommandTokens() const
+{
+    std::vector<CommandToken> Tokens;
+    UINT64                    Number;
+
+    Tokens.reserve(m_Tokens.size());
+
+    for (UINT32 i = 0; i < m_Tokens.size(); i++)
+    {
+        UINT32       Length;
+        const CHAR * Text              = GetTokenText(i, &Length);
+        std::string  CaseSensitiveText = std::string(Text, Length);
+        std::string  LowerCaseText     = CaseSensitiveText;
+
+        std::transform(LowerCaseText.begin(), LowerCaseText.end(), LowerCaseText.begin(), CommandParserToLower);
+
+        if (m_Tokens[i].IsNumberAllowed &&
+            CommandParserIsNumberCandidate(Text, Length) &&
+            ConvertStringToUInt64(CaseSensitiveText, &Number))
+        {
+            Tokens.emplace_back(Num, std::move(CaseSensitiveText), std::move(LowerCaseText));
+        }
+        else
+        {
+            Tokens.emplace_back(m_Tokens[i].Type, std::move(CaseSensitiveText), std::move(LowerCaseText));
+        }
+    }
+
+    return Tokens;
+}
+
+/**
+ * @brief Parse the input string (commands)
+ * @param Input
+ *
+ * @return std::vector<CommandToken>
+ */
+std::vector<CommandToken>
+CommandParser::Parse(const std::string & Input)
+{
+    Tokenize(Input.c_str(), Input.length());
+
+    return GetCommandTokens();
+}
+
+/**
+ * @brief Function to convert CommandParsingTokenType to a string
+ * @param Type
+ *
+ * @return std::string
+ */
+std::string
+CommandParser::TokenTypeToString(CommandParsingTokenType Type)
+{
+    switch (Type)
+    {
+    case CommandParsingTokenType::Num:
+        return "Num";
+
+    case CommandParsingTokenType::String:
+        return "String";
+
+    case CommandParsingTokenType::StringLiteral:
+        return "StringLiteral";
+
+    case CommandParsingTokenType::BracketString:
+        return "BracketString";
+
+    default:
+        return "Unknown";
+    }
+}
+
+/**
+ * @brief Function to print the elements of a vector of Tokens
+ * @param Tokens
+ *
+ * @return VOID
+ */
+VOID
+CommandParser::PrintTokens(const std::vector<CommandToken> & Tokens)
+{
+    //
+    // get len of longest string
+    //
+    const int sz      = 200; // size
+    int       g_s1Len = 0, g_s2Len = 0, g_s3Len = 0;
+    int       s1 = 0, s2 = 0, s3 = 0;
+    char      LineToPrint1[sz], LineToPrint2[sz], LineToPrint3[sz];
+
+    for (const auto & Token : Tokens)
+    {
+        s1 = snprintf(LineToPrint1, sz, "CommandParsingTokenType: %s ", TokenTypeToString(std::get<0>(Token)).c_str());
+        s2 = snprintf(LineToPrint2, sz, ", Value 1: '%s'", std::get<1>(Token).c_str());
+        s3 = snprintf(LineToPrint3, sz, ", Value 2 (lower): '%s'", std::get<2>(Token).c_str());
+
+        if (s1 > g_s1Len)
+            g_s1Len = s1;
+
+        if (s2 > g_s2Len)
+            g_s2Len = s2;
+
+        if (s3 > g_s3Len)
+            g_s3Len = s3;
+    }
+
+    for (const auto & Token : Tokens)
+    {
+        auto CaseSensitiveText = std::get<1>(Token);
+        auto LowerCaseText     = std::get<2>(Token);
+
+        if (std::get<0>(Token) == CommandParsingTokenType::BracketString ||
+            std::get<0>(Token) == CommandParsingTokenType::String ||
+            std::get<0>(Token) == CommandParsingTokenType::StringLiteral)
+        {
+            //
+            // Search for \n and replace with \\n
+            //
+            std::string::size_type pos = 0;
+            while ((pos = CaseSensitiveText.find("\n", pos)) != std::string::npos)
+            {
+                CaseSensitiveText.replace(pos, 1, "\\n");
+                pos += 2; // Move past the newly added characters
+            }
+
+            //
+            // Do the same for lower case text
+            //
+            pos = 0;
+            while ((pos = LowerCaseText.find("\n", pos)) != std::string::npos)
+            {
+                LowerCaseText.replace(pos, 1, "\\n");
+                pos += 2; // Move past the newly added characters
+            }
+        }
+
+        snprintf(LineToPrint1, sz, "CommandParsingTokenType: %s ", TokenTypeToString(std::get<0>(Token)).c_str());
+        snprintf(LineToPrint2, sz, ", Value 1: '%s'", CaseSensitiveText.c_str());
+        snprintf(LineToPrint3, sz, ", Value 2 (lower): '%s'", LowerCaseText.c_str());
+
+        ShowMessages("%-*s %-*s %-*s\n", // - for left align
+                     g_s1Len,
+                     LineToPrint1,
+                     g_s2Len,
+                     LineToPrint2,
+                     g_s3Len,
+                     LineToPrint3);
+    }
+}
+
+/**
+ * @brief Hash the name of a command (FNV-1a, case-insensitive)
+ *
+ * @param Name
+ * @param Length
+ *
+ * @return UINT64
+ */
+static UINT64
+CommandDispatchHash(const CHAR * Name, UINT32 Length)
+{
+    UINT64 Hash = 0xcbf29ce484222325;
+
+    for (UINT32 i = 0; i < Length; i++)
+    {
+        Hash ^= (BYTE)CommandParserToLower(Name[i]);
+        Hash *= 0x100000001b3;
+    }
+
+    return Hash;
+}
+
+/**
+ * @brief Mix the bits of a hash (the finalizer of MurmurHash3)
+ *
+ * @param Value
+ *
+ * @return UINT32
+ */
+static UINT32
+CommandDispatchMix(UINT32 Value)
+{
+    Value ^= Value >> 16;
+    Value *= 0x85ebca6b;
+    Value ^= Value >> 13;
+    Value *= 0xc2b2ae35;
+    Value ^= Value >> 16;
+
+    return Value;
+}
+
+/**
+ * @brief Get the bucket of a hash
+ *
+ * @param Table
+ * @param Hash
+ *
+ * @return UINT32
+ */
+static UINT32
+CommandDispatchGetBucket(PCOMMAND_DISPATCH_TABLE Table, UINT64 Hash)
+{
+    return CommandDispatchMix((UINT32)Hash) & Table->BucketMask;
+}
+
+/**
+ * @brief Get the slot of a hash based on the seed of its bucket
+ *
+ * @param Table
+ * @param Hash
+ * @param Seed
+ *
+ * @return UINT32
+ */
+static UINT32
+CommandDispatchGetSlot(PCOMMAND_DISPATCH_TABLE Table, UINT64 Hash, UINT32 Seed)
+{
+    return CommandDispatchMix((UINT32)(Hash >> 32) ^ (Seed * 0x9e3779b9)) & Table->SlotMask;
+}
+
+/**
+ * @brief Place the commands in the slots of the dispatch table
+ * @details The largest buckets are placed first, for each bucket the seeds
+ * are tried until all of its commands are placed in empty slots
+ *
+ * @param Table
+ * @param Entries The commands
+ * @param Hashes The hashes of the commands
+ *
+ * @return BOOLEAN FALSE if a bucket couldn't be placed
+ */
+static BOOLEAN
+CommandDispatchPlace(PCOMMAND_DISPATCH_TABLE                     Table,
+                     const std::vector<COMMAND_DISPATCH_ENTRY> & Entries,
+                     const std::vector<UINT64> &                 Hashes)
+{
+    std::vector<std::vector<UINT32>> Buckets(Table->BucketMask + 1);
+    std::vector<UINT32>              Order;
+    std::vector<UINT32>              Slots;
+    BOOLEAN                          IsPlaced;
+
+    Table->Seeds.assign(Table->BucketMask + 1, 0);
+    Table->Slots.assign(Table->SlotMask + 1, COMMAND_DISPATCH_ENTRY {NULL, 0, NULL});
+
+    for (UINT32 i = 0; i < Entries.size(); i++)
+    {
+        Buckets[CommandDispatchGetBucket(Table, Hashes[i])].push_back(i);
+    }
+
+    for (UINT32 i = 0; i < Buckets.size(); i++)
+    {
+        if (!Buckets[i].empty())
+        {
+            Order.push_back(i);
+        }
+    }
+
+    std::stable_sort(Order.begin(), Order.end(), [&Buckets](UINT32 First, UINT32 Second) {
+        return Buckets[First].size() > Buckets[Second].size();
+    });
+
+    for (UINT32 Bucket : Order)
+    {
+        IsPlaced = FALSE;
+
+        for (UINT32 Seed = 1; Seed <= COMMAND_DISPATCH_MAXIMUM_SEEDS && !IsPlaced; Seed++)
+        {
+            Slots.clear();
+            IsPlaced = TRUE;
+
+            for (UINT32 Index : Buckets[Bucket])
+            {
+                UINT32 Slot = CommandDispatchGetSlot(Table, Hashes[Index], Seed);
+
+                if (Table->Slots[Slot].Name != NULL || std::find(Slots.begin(), Slots.end(), Slot) != Slots.end())
+                {
+                    IsPlaced = FALSE;
+                    break;
+                }
+
+                Slots.push_back(Slot);
+            }
+
+            if (IsPlaced)
+            {
+                Table->Seeds[Bucket] = Seed;
+
+                for (UINT32 i = 0; i < Slots.size(); i++)
+                {
+                    Table->Slots[Slots[i]] = Entries[Buckets[Bucket][i]];
+                }
+            }
+        }
+
+        if (!IsPlaced)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Build the dispatch table of commands
+ * @details The table is built once the commands are initialized, the table
+ * is at most half full and it's enlarged if the commands couldn't be placed
+ *
+ * @param Commands The list of commands (the table refers to its items)
+ * @param Table
+ *
+ * @return BOOLEAN FALSE if the table couldn't be built, then the list of
+ * commands is used for finding the commands
+ */
+BOOLEAN
+CommandDispatchBuildTable(CommandType & Commands, PCOMMAND_DISPATCH_TABLE Table)
+{
+    std::vector<COMMAND_DISPATCH_ENTRY> Entries;
+    std::vector<UINT64>                 Hashes;
+    UINT32                              BucketCount = 1;
+    UINT32                              SlotCount   = 1;
+
+    Table->IsBuilt = FALSE;
+
+    for (auto & Command : Commands)
+    {
+        COMMAND_DISPATCH_ENTRY Entry = {Command.first.c_str(), (UINT32)Command.first.length(), &Command.second};
+
+        Entries.push_back(Entry);
+        Hashes.push_back(CommandDispatchHash(Entry.Name, Entry.Length));
+    }
+
+    while (BucketCount * 2 < Entries.size())
+    {
+        BucketCount <<= 1;
+    }
+
+    while (SlotCount < Entries.size() * 2)
+    {
+        SlotCount <<= 1;
+    }
+
+    Table->BucketMask = BucketCount - 1;
+
+    for (; SlotCount <= COMMAND_DISPATCH_MAXIMUM_SLOTS; SlotCount <<= 1)
+    {
+        Table->SlotMask = SlotCount - 1;
+
+        if (CommandDispatchPlace(Table, Entries, Hashes))
+        {
+            Table->IsBuilt = TRUE;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Find a command
+ *
+ * @param Table The dispatch table
+ * @param Name The name of the command (case-insensitive, it's not
+ * null-terminated)
+ * @param Length The length of the name
+ *
+ * @return PCOMMAND_DETAIL The details of the command or NULL if the command
+ * doesn't exist
+ */
+PCOMMAND_DETAIL
+CommandDispatchFind(PCOMMAND_DISPATCH_TABLE Table, const CHAR * Name, UINT32 Length)
+{
+    UINT64                  Hash;
+    PCOMMAND_DISPATCH_ENTRY Entry;
+    CommandType::iterator   Iterator;
+
+    if (!Table->IsBuilt)
+    {
+        std::string LowerCaseName(Name, Length);
+
+        std::transform(LowerCaseName.begin(), LowerCaseName.end(), LowerCaseName.begin(), CommandParserToLower);
+
+        Iterator = g_CommandsList.find(LowerCaseName);
+
+        return Iterator != g_CommandsList.end() ? &Iterator->second : NULL;
+    }
+
+    Hash  = CommandDispatchHash(Name, Length);
+    Entry = &Table->Slots[CommandDispatchGetSlot(Table, Hash, Table->Seeds[CommandDispatchGetBucket(Table, Hash)])];
+
+    if (Entry->Name == NULL || Entry->Length != Length)
+    {
+        return NULL;
+    }
+
+    for (UINT32 i = 0; i < Length; i++)
+    {
+        if (CommandParserToLower(Name[i]) != Entry->Name[i])
+        {
+            return NULL;
+        }
+    }
+
+    return Entry->Detail;
+}
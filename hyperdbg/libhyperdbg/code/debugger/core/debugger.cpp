@@ -539,6 +539,73 @@ ShowErrorMessage(UINT32 Error)
                      Error);
         break;
 
+    case DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR:
+        ShowMessages("err, could not perform VM-exit profiler actions (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_SUPPORTED:
+        ShowMessages("err, logging the dirty pages is not supported as the processor "
+                     "doesn't support Page Modification Logging (PML) (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_DIRTY_PAGES_LOGGING_IS_NOT_STARTED:
+        ShowMessages("err, logging the dirty pages is not started, you can start it "
+                     "by using the '!dump dirty start' command (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_DIRTY_PAGES_ACTIONS_ERROR:
+        ShowMessages("err, could not perform actions on the dirty pages (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_IS_ALREADY_TAKEN:
+        ShowMessages("err, the snapshot is already taken, you can discard it "
+                     "by using the '!snapshot discard' command (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_IS_NOT_TAKEN:
+        ShowMessages("err, the snapshot is not taken, you can take it "
+                     "by using the '!snapshot take' command (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_INVALID_RANGE:
+        ShowMessages("err, invalid range for the snapshot, the physical addresses should be "
+                     "page-aligned and below 512 GB (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_PAGES_ARE_NOT_PREALLOCATED:
+        ShowMessages("err, the pages of the snapshot are not allocated, either there is not "
+                     "enough memory or the snapshot is already taken. In the Debugger Mode, "
+                     "you should preallocate the pages by using the 'prealloc snapshot' command (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_POOL_EXHAUSTED:
+        ShowMessages("err, the pages of the snapshot are exhausted and some of the modified "
+                     "pages could not be restored, you should take the snapshot again with "
+                     "more pages (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_SNAPSHOT_ACTIONS_ERROR:
+        ShowMessages("err, could not perform actions on the snapshot (%x)\n",
+                     Error);
+        break;
+
+    case DEBUGGER_ERROR_DIRTY_PAGES_BUFFERS_ARE_NOT_PREALLOCATED:
+        ShowMessages("err, the buffers of logging the dirty pages are not allocated, either "
+                     "there is not enough memory or the processor doesn't support Page "
+                     "Modification Logging (PML). In the Debugger Mode, you should preallocate "
+                     "the buffers by using the 'prealloc dirty-logging' command (%x)\n",
+                     Error);
+        break;
+
     default:
         ShowMessages("err, error not found (%x)\n",
                      Error);
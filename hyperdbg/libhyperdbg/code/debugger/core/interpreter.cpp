@@ -16,6 +16,7 @@
 //
 extern ACTIVE_DEBUGGING_PROCESS g_ActiveProcessDebuggingState;
 extern CommandType              g_CommandsList;
+extern COMMAND_DISPATCH_TABLE   g_CommandsDispatchTable;
 
 extern BOOLEAN g_ShouldPreviousCommandBeContinued;
 extern BOOLEAN g_IsCommandListInitialized;
@@ -37,622 +38,6 @@ extern ULONG  g_CurrentRemoteCore;
 extern string g_ServerPort;
 extern string g_ServerIp;
 
-class CommandParser
-{
-public:
-    /**
-     * @brief Parse the input string (commands)
-     * @param input
-     *
-     * @return std::vector<CommandToken>
-     */
-    std::vector<CommandToken> Parse(const std::string & ConstInput)
-    {
-        std::vector<CommandToken> tokens;
-        std::string               current;
-        bool                      InQuotes   = FALSE;
-        int                       IdxBracket = 0;
-
-        //
-        // mainly for removing \ from escaped chars
-        //
-        std::string input = ConstInput;
-        for (size_t i = 0; i < input.length(); ++i)
-        {
-            char c = input[i];
-
-            if (c == '/') // start comment parse
-            {
-                //
-                // if we're in a script bracket, should we skip? it'll be handled later?
-                //
-                if (!InQuotes)
-                {
-                    size_t j  = i;
-                    char   c2 = input[++j];
-
-                    if (c2 == '/') // start to look for comments
-                    {
-                        //
-                        // to solve cases like: //"}"
-                        //
-                        size_t StrLitEnd = 0;
-                        size_t StrLitBeg = input.find("\"", i);
-                        if (StrLitBeg != std::string::npos)
-                        {
-                            if (i)
-                            {
-                                if (input[i - 1] != '\\') // if not escaped
-                                {
-                                    StrLitEnd = input.find("\"", StrLitBeg + 1);
-                                    if (StrLitEnd != std::string::npos)
-                                    {
-                                        std::string StrLit(input.substr(i, StrLitEnd - i + 1));
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                StrLitEnd = input.find("\"", StrLitBeg + 1);
-                                if (StrLitEnd != std::string::npos)
-                                {
-                                    std::string StrLit(input.substr(i, StrLitEnd - i + 1));
-                                }
-                            }
-                        }
-
-                        //
-                        // assuming " }" as the end of a line comment aka //, if we are within {}
-                        //
-                        bool   CmntEndBrkt  = false;
-                        size_t CloseBrktPos = 0;
-                        if (IdxBracket)
-                        {
-                            //
-                            // loop for escaped }
-                            //
-                            for (CloseBrktPos = input.find("}", StrLitEnd); CloseBrktPos != std::string::npos;)
-                            {
-                                CloseBrktPos = input.find("}", CloseBrktPos);
-                                if (input[CloseBrktPos - 1] == '\\')
-                                {
-                                    input.erase(CloseBrktPos - 1, 1);
-                                    CloseBrktPos += 1;
-                                }
-                                else
-                                {
-                                    break;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            CloseBrktPos = std::string::npos;
-                        }
-
-                        size_t NewLineSrtPos = input.find("\\n", i); // "\\n" entered by user
-                        size_t NewLineChrPos = input.find('\n', i);
-
-                        vector<size_t> PosVec;
-                        PosVec.push_back(CloseBrktPos);
-                        PosVec.push_back(NewLineSrtPos);
-                        PosVec.push_back(NewLineChrPos);
-
-                        auto min = *(min_element(PosVec.begin(), PosVec.end())); // see which one occures first
-
-                        if (min != std::string::npos && input[min - 1] != '\\')
-                        {
-                            //
-                            // here we could get the comment but for now we just skip
-                            //
-                            std::string comment(input.substr(i, min - i));
-
-                            //
-                            // append comments to be passed to script engine
-                            //
-                            if (IdxBracket)
-                            {
-                                current += comment;
-                            }
-
-                            //
-                            // forward the buffer
-                            //
-                            i = i + (min - i) - 1;
-
-                            continue;
-                        }
-                        else
-                        {
-                            bool IsNewLineEsc = false;
-                            if (NewLineSrtPos != std::string::npos)
-                            {
-                                IsNewLineEsc = input[NewLineSrtPos - 1] == '\\';
-                            }
-
-                            // if (NewLineSrtPos != std::string::npos && !IsNewLineEsc) // is not escaped
-                            //{
-                            //     //
-                            //     // here we could get the comment but for now we just skip
-                            //     //
-                            //     std::string comment(input.substr(i, NewLineSrtPos - i));
-
-                            //    //
-                            //    // append comments to be passed to script engine
-                            //    //
-                            //    if (IdxBracket)
-                            //    {
-                            //        current += comment;
-                            //    }
-
-                            //    //
-                            //    // forward the buffer
-                            //    //
-                            //    i = i + (NewLineSrtPos - i) + 1; // +1 for "\n". the "continue;" will also go past another time.
-
-                            //    continue;
-                            //}
-                            // else if (NewLineChrPos != std::string::npos)
-                            //{
-                            //    //
-                            //    // here we could get the comment but for now we just skip
-                            //    //
-                            //    std::string comment(input.substr(i, NewLineChrPos - i));
-
-                            //    //
-                            //    // append comments to be passed to script engine
-                            //    //
-                            //    if (IdxBracket)
-                            //    {
-                            //        current += comment;
-                            //    }
-
-                            //    //
-                            //    // forward the buffer
-                            //    //
-                            //    i = i + (NewLineChrPos - i);
-
-                            //    continue; // go past '\n'
-                            //}
-                            // else
-                            //{
-                            //
-                            // no "\\n" nor '\n' found so we just mark the chars as comment till end of string
-                            //
-                            std::string comment(input.substr(i, input.size()));
-
-                            // fix the escaped newline
-                            if (IsNewLineEsc)
-                            {
-                                size_t start_pos = 0;
-                                while ((start_pos = comment.find("\\\\n", start_pos)) != std::string::npos)
-                                {
-                                    comment.replace(start_pos, 3, "\\n");
-                                    start_pos += 2; // Handles case where 'to' is a substring of 'from'
-                                }
-
-                                IsNewLineEsc = false;
-                            }
-
-                            //
-                            // append comments to be passed to script engine
-                            //
-                            if (IdxBracket)
-                            {
-                                current += comment;
-                            }
-
-                            //
-                            // forward the buffer
-                            //
-                            i = i + (input.size() - i);
-
-                            continue;
-                        }
-                        //}
-                    }
-                    else if (c2 == '*')
-                    {
-                        size_t EndPose = input.find("*/", i + 2); // +2 for cases like /*/
-
-                        if (EndPose != std::string::npos)
-                        {
-                            //
-                            // here we could get the comment but for now we just skip
-                            //
-                            std::string comment(input.substr(i, EndPose - i + 2)); // */ is two bytes long
-
-                            //
-                            // append comments to be passed to script engine
-                            //
-                            if (IdxBracket)
-                            {
-                                current += comment;
-                            }
-
-                            //
-                            // forward the buffer
-                            //
-                            i = (i + (EndPose - i)) + 1; // +1 for /
-
-                            continue;
-                        }
-                        else
-                        {
-                            // error: comment not closed
-                        }
-                    }
-                }
-            }
-
-            if (InQuotes)
-            {
-                if (c == '"')
-                {
-                    if (input[i - 1] != '\\')
-                    {
-                        InQuotes = FALSE;
-
-                        //
-                        // if the quoted text is not within brackets, regard it as a StringLiteral token
-                        //
-                        if (!IdxBracket)
-                        {
-                            AddStringToken(tokens, current, TRUE); // TRUE for StringLiteral type
-                            current.clear();
-                            continue; // dont add " char
-                        }
-                        else
-                        {
-                            current += c;
-                            continue; // dont add " char
-                        }
-                        //
-                        // if we are indeed within brackets, we continue to add the '"' char to the current buffer
-                        //
-                    }
-                    else
-                    {
-                        input.erase(i - 1, 1);
-                        i--;                // compensate for the removed char
-                        current.pop_back(); // remove last read \\ 
-                        current += c;
-                        continue;
-                    }
-                }
-            }
-
-            if (c == '}')
-            {
-                if (input[i - 1] != '\\')
-                {
-                    if (IdxBracket)
-                    {
-                        if (!InQuotes) // not closing }
-                        {
-                            IdxBracket--;
-                        }
-
-                        if (!IdxBracket) // is closing }
-                        {
-                            AddBracketStringToken(tokens, current);
-                            current.clear();
-
-                            continue;
-                        }
-                    }
-                }
-                else
-                {
-                    input.erase(i - 1, 1);
-                    i--;                // compensate for the removed char
-                    current.pop_back(); // remove last read \\
-
-                }
-            }
-
-            if ((c == ' ' || c == '    ') && !InQuotes && !IdxBracket) // finding seperator space char // Tab seperator added too
-            {
-                if (!current.empty() && current != " ")
-                {
-                    AddToken(tokens, current);
-                    current.clear();
-
-                    continue;
-                }
-                continue; // avoid adding extra space char
-            }
-            else if (c == '"') //&& !IdxBracket)
-            {
-                if (i) // check if this " is the first char to avoid out of range check
-                {
-                    if (input[i - 1] != ' ' && !IdxBracket && !current.empty() && !InQuotes) // is prev cmd adjacent to "
-                    {
-                        AddStringToken(tokens, current);
-                        current.clear();
-                    }
-
-                    if (input[i - 1] != '\\')
-                    {
-                        InQuotes = TRUE;
-                        if (!IdxBracket)
-                        {
-                            continue; // don't include '"' in string
-                        }
-                    }
-                }
-                else
-                {
-                    InQuotes = TRUE;
-                    if (!IdxBracket)
-                    {
-                        continue; // don't include '"' in string
-                    }
-                }
-            }
-            else if (c == '{' && !InQuotes)
-            {
-                if (i) // check if this { is the first char to avoid out of range check
-                {
-                    if (input[i - 1] != '\\')
-                    {
-                        if (input[i - 1] != ' ' && !IdxBracket) // in case '{' is adjacent to previous command like "command{", on first {
-                        {
-                            AddToken(tokens, current);
-                            current.clear();
-                        }
-
-                        IdxBracket++;
-                        if (IdxBracket == 1) // first {
-                            continue;        // don't include '{' in string
-                    }
-                    else
-                    {
-                        input.erase(i - 1, 1);
-                        i--;                // compensate for the removed char
-                        current.pop_back(); // remove last read \\
-
-                    }
-                }
-                else
-                {
-                    IdxBracket++;
-                    if (IdxBracket == 1) // first {
-                        continue;        // don't include '{' in string
-                }
-            }
-
-            //
-            // ignore astray \n
-            //
-            if (c == '\\' && !InQuotes)
-            {
-                if (current.empty() && input[i + 1] == 'n')
-                {
-                    i++;
-                    continue;
-                }
-            }
-
-            current += c;
-        }
-
-        if (!current.empty() && current != " ")
-        {
-            AddToken(tokens, current);
-        }
-
-        if (IdxBracket)
-        {
-            // error: script bracket not closed
-        }
-
-        if (InQuotes)
-        {
-            // error: Quote not closed
-        }
-
-        return tokens;
-    }
-
-    /**
-     * @brief Function to convert CommandParsingTokenType to a string
-     * @param Type
-     *
-     * @return std::string
-     */
-    std::string TokenTypeToString(CommandParsingTokenType Type)
-    {
-        switch (Type)
-        {
-        case CommandParsingTokenType::Num:
-            return "Num";
-
-        case CommandParsingTokenType::String:
-            return "String";
-
-        case CommandParsingTokenType::StringLiteral:
-            return "StringLiteral";
-
-        case CommandParsingTokenType::BracketString:
-            return "BracketString";
-
-        default:
-            return "Unknown";
-        }
-    }
-
-    /**
-     * @brief Function to print the elements of a vector of Tokens
-     * @param Tokens
-     *
-     * @return VOID
-     */
-    VOID PrintTokens(const std::vector<CommandToken> & Tokens)
-    {
-        //
-        // get len of longest string
-        //
-        const int sz      = 200; // size
-        int       g_s1Len = 0, g_s2Len = 0, g_s3Len = 0;
-        int       s1 = 0, s2 = 0, s3 = 0;
-        char      LineToPrint1[sz], LineToPrint2[sz], LineToPrint3[sz];
-
-        for (const auto & Token : Tokens)
-        {
-            s1 = snprintf(LineToPrint1, sz, "CommandParsingTokenType: %s ", TokenTypeToString(std::get<0>(Token)).c_str());
-            s2 = snprintf(LineToPrint2, sz, ", Value 1: '%s'", std::get<1>(Token).c_str());
-            s3 = snprintf(LineToPrint3, sz, ", Value 2 (lower): '%s'", std::get<2>(Token).c_str());
-
-            if (s1 > g_s1Len)
-                g_s1Len = s1;
-
-            if (s2 > g_s2Len)
-                g_s2Len = s2;
-
-            if (s3 > g_s3Len)
-                g_s3Len = s3;
-        }
-
-        for (const auto & Token : Tokens)
-        {
-            auto CaseSensitiveText = std::get<1>(Token);
-            auto LowerCaseText     = std::get<2>(Token);
-
-            if (std::get<0>(Token) == CommandParsingTokenType::BracketString ||
-                std::get<0>(Token) == CommandParsingTokenType::String ||
-                std::get<0>(Token) == CommandParsingTokenType::StringLiteral)
-            {
-                //
-                // Replace \n with \\n
-                //
-
-                //
-                // Search for \n and replace with \\n
-                //
-                std::string::size_type pos = 0;
-                while ((pos = CaseSensitiveText.find("\n", pos)) != std::string::npos)
-                {
-                    CaseSensitiveText.replace(pos, 1, "\\n");
-                    pos += 2; // Move past the newly added characters
-                }
-
-                //
-                // Do the same for lower case text
-                //
-                pos = 0;
-                while ((pos = LowerCaseText.find("\n", pos)) != std::string::npos)
-                {
-                    LowerCaseText.replace(pos, 1, "\\n");
-                    pos += 2; // Move past the newly added characters
-                }
-            }
-
-            snprintf(LineToPrint1, sz, "CommandParsingTokenType: %s ", TokenTypeToString(std::get<0>(Token)).c_str());
-            snprintf(LineToPrint2, sz, ", Value 1: '%s'", CaseSensitiveText.c_str());
-            snprintf(LineToPrint3, sz, ", Value 2 (lower): '%s'", LowerCaseText.c_str());
-
-            ShowMessages("%-*s %-*s %-*s\n", // - for left align
-                         g_s1Len,
-                         LineToPrint1,
-                         g_s2Len,
-                         LineToPrint2,
-                         g_s3Len,
-                         LineToPrint3);
-
-            /*ShowMessages("CommandParsingTokenType: %s , Value 1: '%s', Value 2 (lower): '%s'\n",
-                         TokenTypeToString(std::get<0>(Token)).c_str(),
-                         CaseSensitiveText.c_str(),
-                         LowerCaseText.c_str());*/
-        }
-    }
-
-private:
-    /**
-     * @brief Convert a string to lowercase
-     * @param str
-     *
-     * @return std::string
-     */
-    std::string ToLower(const std::string & str) const
-    {
-        std::string result = str;
-        std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-
-        return result;
-    }
-
-    /**
-     * @brief Add Token
-     * @param tokens
-     * @param str
-     *
-     * @return VOID
-     */
-    VOID AddToken(std::vector<CommandToken> & tokens, std::string & str)
-    {
-        auto   tmp    = str;
-        UINT64 tmpNum = 0;
-
-        //
-        // Trim the string
-        //
-        Trim(tmp);
-
-        if (ConvertStringToUInt64(tmp, &tmpNum)) // tmp will be modified to actual number
-        {
-            tokens.emplace_back(CommandParsingTokenType::Num, tmp, ToLower(tmp));
-        }
-        else
-        {
-            AddStringToken(tokens, str);
-        }
-    }
-
-    /**
-     * @brief Add String Token
-     * @param tokens
-     * @param str
-     *
-     * @return VOID
-     */
-    VOID AddStringToken(std::vector<CommandToken> & tokens, std::string & str, BOOL isLiteral = FALSE)
-    {
-        auto tmp = str;
-
-        //
-        // Trim the string
-        //
-        Trim(tmp);
-
-        //
-        // If the string is empty, we don't need to add it
-        //
-        if (tmp.empty())
-            return;
-        if (isLiteral)
-        {
-            tokens.emplace_back(CommandParsingTokenType::StringLiteral, tmp, ToLower(tmp));
-        }
-        else
-        {
-            tokens.emplace_back(CommandParsingTokenType::String, tmp, ToLower(tmp));
-        }
-    }
-
-    /**
-     * @brief Add Bracket String Token
-     * @param tokens
-     * @param str
-     *
-     * @return VOID
-     */
-    VOID AddBracketStringToken(std::vector<CommandToken> & tokens, const std::string & str)
-    {
-        tokens.emplace_back(CommandParsingTokenType::BracketString, str, ToLower(str));
-    }
-};
-
 /**
  * @brief Find the position of the first difference between two strings
  * @param Str1 The first string
@@ -783,6 +168,60 @@ HyperDbgTestCommandParserShowTokens(CHAR * Command)
     Parser.PrintTokens(Tokens);
 }
 
+/**
+ * @brief Tokenize and dispatch the command for a number of iterations
+ * (used for measuring the performance of the command parser)
+ * @details The command is not executed, tokens are only converted to
+ * strings if ConvertTokens is set (as if the command is executed locally)
+ *
+ * @param Command The text of command
+ * @param Iterations The number of iterations
+ * @param ConvertTokens Whether the tokens should be converted to strings
+ *
+ * @return UINT32 the number of tokens of the command
+ */
+UINT32
+HyperDbgTestCommandParserPerformance(CHAR * Command, UINT32 Iterations, BOOLEAN ConvertTokens)
+{
+    CommandParser Parser;
+    SIZE_T        CommandLength  = strlen(Command);
+    UINT32        NumberOfTokens = 0;
+    UINT32        CommandNameLength;
+    const CHAR *  CommandName;
+
+    //
+    // The dispatch table is built once the commands are initialized
+    //
+    if (!g_IsCommandListInitialized)
+    {
+        InitializeDebugger();
+
+        g_IsCommandListInitialized = TRUE;
+    }
+
+    for (UINT32 i = 0; i < Iterations; i++)
+    {
+        Parser.Tokenize(Command, CommandLength);
+
+        NumberOfTokens = Parser.GetTokenCount();
+
+        if (NumberOfTokens == 0)
+        {
+            continue;
+        }
+
+        CommandName = Parser.GetTokenText(0, &CommandNameLength);
+        CommandDispatchFind(&g_CommandsDispatchTable, CommandName, CommandNameLength);
+
+        if (ConvertTokens)
+        {
+            Parser.GetCommandTokens();
+        }
+    }
+
+    return NumberOfTokens;
+}
+
 /**
  * @brief Interpret commands
  *
@@ -793,10 +232,12 @@ HyperDbgTestCommandParserShowTokens(CHAR * Command)
 INT
 HyperDbgInterpreter(CHAR * Command)
 {
-    BOOLEAN               HelpCommand       = FALSE;
-    UINT64                CommandAttributes = NULL;
-    CommandType::iterator Iterator;
-    CommandParser         Parser;
+    BOOLEAN         HelpCommand       = FALSE;
+    UINT64          CommandAttributes = NULL;
+    PCOMMAND_DETAIL CommandDetail;
+    const CHAR *    CommandName;
+    UINT32          CommandNameLength;
+    CommandParser   Parser;
 
     //
     // Check if it's the first command and whether the mapping of command is
@@ -822,38 +263,28 @@ HyperDbgInterpreter(CHAR * Command)
     }
 
     //
-    // Convert to string
-    //
-    string CommandString(Command);
-
-    //
-    // Tokenize the command string
-    //
-    auto Tokens = Parser.Parse(CommandString);
-
+    // Tokenize the command string, tokens are only converted to strings
+    // if the command is executed locally
     //
-    // Print the tokens
-    //
-    // Parser.PrintTokens(Tokens);
+    Parser.Tokenize(Command, strlen(Command));
 
     //
     // Check if user entered an empty input
     //
-    if (Tokens.empty())
+    if (Parser.GetTokenCount() == 0)
     {
         ShowMessages("\n");
         return 0;
     }
 
     //
-    // Get the first command (lower case)
+    // Find the first command (case-insensitive) and read the command's
+    // attributes, if the command doesn't exist then it's better to handle
+    // it locally, instead of sending it to the remote computer
     //
-    string FirstCommand = GetLowerStringFromCommandToken(Tokens.front());
-
-    //
-    // Read the command's attributes
-    //
-    CommandAttributes = GetCommandAttributes(FirstCommand);
+    CommandName       = Parser.GetTokenText(0, &CommandNameLength);
+    CommandDetail     = CommandDispatchFind(&g_CommandsDispatchTable, CommandName, CommandNameLength);
+    CommandAttributes = CommandDetail != NULL ? CommandDetail->CommandAttrib : DEBUGGER_COMMAND_ATTRIBUTE_ABSOLUTE_LOCAL;
 
     //
     // Check if the command needs to be continued by pressing enter
@@ -935,21 +366,22 @@ HyperDbgInterpreter(CHAR * Command)
     //
     // Detect whether it's a .help command or not
     //
-    if (!FirstCommand.compare(".help") || !FirstCommand.compare("help") ||
-        !FirstCommand.compare(".hh"))
+    if (Parser.IsTokenEqual(0, ".help") || Parser.IsTokenEqual(0, "help") ||
+        Parser.IsTokenEqual(0, ".hh"))
     {
-        if (Tokens.size() == 2)
+        if (Parser.GetTokenCount() == 2)
         {
             //
             // Show that it's a help command
             //
-            HelpCommand  = TRUE;
-            FirstCommand = GetLowerStringFromCommandToken(Tokens.at(1));
+            HelpCommand   = TRUE;
+            CommandName   = Parser.GetTokenText(1, &CommandNameLength);
+            CommandDetail = CommandDispatchFind(&g_CommandsDispatchTable, CommandName, CommandNameLength);
         }
         else
         {
             ShowMessages("incorrect use of the '%s'\n\n",
-                         GetCaseSensitiveStringFromCommandToken(Tokens.at(0)).c_str());
+                         Parser.GetTokenString(0).c_str());
             CommandHelpHelp();
             return 0;
         }
@@ -958,10 +390,7 @@ HyperDbgInterpreter(CHAR * Command)
     //
     // Start parsing commands
     //
-    string CaseSensitiveCommandString(Command);
-    Iterator = g_CommandsList.find(FirstCommand);
-
-    if (Iterator == g_CommandsList.end())
+    if (CommandDetail == NULL)
     {
         //
         //  Command doesn't exist
@@ -969,26 +398,28 @@ HyperDbgInterpreter(CHAR * Command)
         if (!HelpCommand)
         {
             ShowMessages("err, couldn't resolve command at '%s'\n",
-                         GetCaseSensitiveStringFromCommandToken(Tokens.front()).c_str());
+                         Parser.GetTokenString(0).c_str());
         }
         else
         {
             ShowMessages("err, couldn't find the help for the command at '%s'\n",
-                         GetCaseSensitiveStringFromCommandToken(Tokens.at(1)).c_str());
+                         Parser.GetTokenString(1).c_str());
         }
     }
     else
     {
         if (HelpCommand)
         {
-            Iterator->second.CommandHelpFunction();
+            CommandDetail->CommandHelpFunction();
         }
         else
         {
+            string CaseSensitiveCommandString(Command);
+
             //
             // Call the parser with tokens
             //
-            Iterator->second.CommandFunctionNewParser(Tokens, CaseSensitiveCommandString);
+            CommandDetail->CommandFunctionNewParser(Parser.GetCommandTokens(), CaseSensitiveCommandString);
         }
     }
 
@@ -1247,16 +678,16 @@ ContinuePreviousCommand()
 UINT64
 GetCommandAttributes(const string & FirstCommand)
 {
-    CommandType::iterator Iterator;
+    PCOMMAND_DETAIL CommandDetail;
 
     //
     // Some commands should not be passed to the remote system
     // and instead should be handled in the current debugger
     //
 
-    Iterator = g_CommandsList.find(FirstCommand);
+    CommandDetail = CommandDispatchFind(&g_CommandsDispatchTable, FirstCommand.c_str(), (UINT32)FirstCommand.size());
 
-    if (Iterator == g_CommandsList.end())
+    if (CommandDetail == NULL)
     {
         //
         // Command doesn't exist, if it's not exists then it's better to handle
@@ -1266,7 +697,7 @@ GetCommandAttributes(const string & FirstCommand)
     }
     else
     {
-        return Iterator->second.CommandAttrib;
+        return CommandDetail->CommandAttrib;
     }
 
     return NULL;
@@ -1453,6 +884,10 @@ InitializeCommandsDictionary()
 
     g_CommandsList["!ioapic"] = {&CommandIoapic, &CommandIoapicHelp, DEBUGGER_COMMAND_IOAPIC_ATTRIBUTES};
 
+    g_CommandsList["!vmexitprof"] = {&CommandVmexitprof, &CommandVmexitprofHelp, DEBUGGER_COMMAND_VMEXITPROF_ATTRIBUTES};
+
+    g_CommandsList["!snapshot"] = {&CommandSnapshot, &CommandSnapshotHelp, DEBUGGER_COMMAND_SNAPSHOT_ATTRIBUTES};
+
     g_CommandsList["!monitor"] = {&CommandMonitor, &CommandMonitorHelp, DEBUGGER_COMMAND_MONITOR_ATTRIBUTES};
 
     g_CommandsList["!vmcall"] = {&CommandVmcall, &CommandVmcallHelp, DEBUGGER_COMMAND_VMCALL_ATTRIBUTES};
@@ -1549,9 +984,11 @@ InitializeCommandsDictionary()
     g_CommandsList["!eq"] = {&CommandEditMemory, &CommandEditMemoryHelp, DEBUGGER_COMMAND_E_ATTRIBUTES};
 
     g_CommandsList["sb"]  = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
+    g_CommandsList["sw"]  = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
     g_CommandsList["sd"]  = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
     g_CommandsList["sq"]  = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
     g_CommandsList["!sb"] = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
+    g_CommandsList["!sw"] = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
     g_CommandsList["!sd"] = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
     g_CommandsList["!sq"] = {&CommandSearchMemory, &CommandSearchMemoryHelp, DEBUGGER_COMMAND_S_ATTRIBUTES};
 
@@ -1585,6 +1022,9 @@ InitializeCommandsDictionary()
 
     g_CommandsList[".pe"] = {&CommandPe, &CommandPeHelp, DEBUGGER_COMMAND_PE_ATTRIBUTES};
 
+    g_CommandsList[".tracefile"] = {&CommandTracefile, &CommandTracefileHelp, DEBUGGER_COMMAND_TRACEFILE_ATTRIBUTES};
+    g_CommandsList["tracefile"]  = {&CommandTracefile, &CommandTracefileHelp, DEBUGGER_COMMAND_TRACEFILE_ATTRIBUTES};
+
     g_CommandsList["!rev"] = {&CommandRev, &CommandRevHelp, DEBUGGER_COMMAND_REV_ATTRIBUTES};
     g_CommandsList["rev"]  = {&CommandRev, &CommandRevHelp, DEBUGGER_COMMAND_REV_ATTRIBUTES};
 
@@ -1616,4 +1056,13 @@ InitializeCommandsDictionary()
     g_CommandsList["!hwdbg_clock"] = {&CommandHwClk, &CommandHwClkHelp, DEBUGGER_COMMAND_HWDBG_HW_CLK_ATTRIBUTES};
 
     g_CommandsList["!hw"] = {&CommandHw, &CommandHwHelp, DEBUGGER_COMMAND_HWDBG_HW_ATTRIBUTES};
+
+    //
+    // Build the dispatch table of commands, if it fails, commands are
+    // looked up in the list of commands
+    //
+    if (!CommandDispatchBuildTable(g_CommandsList, &g_CommandsDispatchTable))
+    {
+        ShowMessages("warning, unable to build the dispatch table of commands\n");
+    }
 }
@@ -14,8 +14,36 @@
 //
 // Global Variables
 //
-extern ACTIVE_DEBUGGING_PROCESS g_ActiveProcessDebuggingState;
-extern BOOLEAN                  g_IsSerialConnectedToRemoteDebuggee;
+extern ACTIVE_DEBUGGING_PROCESS  g_ActiveProcessDebuggingState;
+extern BOOLEAN                   g_IsSerialConnectedToRemoteDebuggee;
+extern BOOLEAN                   g_IsInstrumentingInstructions;
+extern STEPPING_TRACE_STATISTICS g_SteppingTraceStatistics;
+extern TRACE_FILE_WRITER         g_SteppingTraceFileWriter;
+
+/**
+ * @brief Names of the registers in the records of batched steps (in the
+ * order of the bits of the register mask)
+ *
+ */
+static const char * SteppingTraceRegisterNames[] = {
+    "rax",
+    "rcx",
+    "rdx",
+    "rbx",
+    "rsp",
+    "rbp",
+    "rsi",
+    "rdi",
+    "r8",
+    "r9",
+    "r10",
+    "r11",
+    "r12",
+    "r13",
+    "r14",
+    "r15",
+    "rflags",
+};
 
 /**
  * @brief Perform Instrumentation Step-in
@@ -198,3 +226,426 @@ SteppingStepOverForGu(BOOLEAN LastInstruction)
         return FALSE;
     }
 }
+
+/**
+ * @brief Parse the options of the batched steps
+ * @details The options are 'trace' followed by the type of records ('regs'
+ * with an optional register mask, or 'mem'), the stop condition ('until'),
+ * and the trace file that the records are saved to ('file')
+ *
+ * @param CommandTokens Tokens of the command
+ * @param FirstOptionIndex Index of the first option (after the count)
+ * @param ShowRegisters Whether the registers should be saved by default
+ * (e.g., the 'tr' command)
+ * @param Options The parsed options
+ *
+ * @return BOOLEAN Whether the options are valid or not
+ */
+BOOLEAN
+SteppingParseBatchedStepsOptions(vector<CommandToken> &          CommandTokens,
+                                 UINT32                          FirstOptionIndex,
+                                 BOOLEAN                         ShowRegisters,
+                                 PSTEPPING_BATCHED_STEPS_OPTIONS Options)
+{
+    UINT32 Index = FirstOptionIndex;
+
+    RtlZeroMemory(Options, sizeof(STEPPING_BATCHED_STEPS_OPTIONS));
+
+    if (Index >= CommandTokens.size())
+    {
+        //
+        // Not a batched step
+        //
+        return TRUE;
+    }
+
+    if (!CompareLowerCaseStrings(CommandTokens.at(Index), "trace"))
+    {
+        ShowMessages("err, couldn't resolve error at '%s'\n\n",
+                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(Index)).c_str());
+        return FALSE;
+    }
+
+    Options->IsBatched = TRUE;
+
+    if (ShowRegisters)
+    {
+        Options->RecordType   = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS;
+        Options->RegisterMask = DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+    }
+    else
+    {
+        Options->RecordType = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP;
+    }
+
+    for (Index++; Index < CommandTokens.size(); Index++)
+    {
+        if (CompareLowerCaseStrings(CommandTokens.at(Index), "regs"))
+        {
+            if (Options->RecordType != DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+            {
+                Options->RecordType = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS;
+            }
+
+            //
+            // The register mask is optional
+            //
+            if (Index + 1 < CommandTokens.size() &&
+                ConvertTokenToUInt32(CommandTokens.at(Index + 1), &Options->RegisterMask))
+            {
+                Index++;
+
+                if (Options->RegisterMask == 0 || (Options->RegisterMask & ~DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL))
+                {
+                    ShowMessages("err, the register mask should be a non-zero value below 0x%x\n\n",
+                                 DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL + 1);
+                    return FALSE;
+                }
+            }
+            else
+            {
+                Options->RegisterMask = DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+            }
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(Index), "mem"))
+        {
+            //
+            // All the registers are needed for computing the memory operands
+            //
+            Options->RecordType   = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS;
+            Options->RegisterMask = DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(Index), "until"))
+        {
+            if (Index + 1 >= CommandTokens.size() ||
+                !SymbolConvertNameOrExprToAddress(GetCaseSensitiveStringFromCommandToken(CommandTokens.at(Index + 1)),
+                                                  &Options->StopAddress))
+            {
+                ShowMessages("err, please specify a correct address for 'until'\n\n");
+                return FALSE;
+            }
+
+            Options->StopAtAddress = TRUE;
+            Index++;
+        }
+        else if (CompareLowerCaseStrings(CommandTokens.at(Index), "file"))
+        {
+            if (Index + 1 >= CommandTokens.size() ||
+                GetCaseSensitiveStringFromCommandToken(CommandTokens.at(Index + 1)).size() >= MAX_PATH)
+            {
+                ShowMessages("err, please specify a correct path for 'file'\n\n");
+                return FALSE;
+            }
+
+            strcpy_s(Options->TraceFilePath,
+                     MAX_PATH,
+                     GetCaseSensitiveStringFromCommandToken(CommandTokens.at(Index + 1)).c_str());
+            Index++;
+        }
+        else
+        {
+            ShowMessages("err, couldn't resolve error at '%s'\n\n",
+                         GetCaseSensitiveStringFromCommandToken(CommandTokens.at(Index)).c_str());
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Perform batched steps (the steps are performed in the debuggee and
+ * the records are received in chunks)
+ * @details The steps are requested in batches, so the steps can be stopped
+ * by CTRL+C between the batches
+ *
+ * @param StepType Type of steps (step-in, step-over, or instrumentation step-in)
+ * @param CountOfSteps Count of steps
+ * @param Options Options of the batched steps
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SteppingPerformBatchedSteps(DEBUGGER_REMOTE_STEPPING_REQUEST StepType,
+                            UINT32                           CountOfSteps,
+                            PSTEPPING_BATCHED_STEPS_OPTIONS  Options)
+{
+    DEBUGGEE_STEP_PACKET StepPacket = {0};
+    UINT64               StartTime;
+    UINT64               ElapsedTime;
+    UINT32               StepsOfBatch;
+    UINT32               PerformedSteps = 0;
+    BOOLEAN              IsInterrupted  = FALSE;
+    BOOLEAN              Result;
+
+    if (!g_IsSerialConnectedToRemoteDebuggee)
+    {
+        ShowMessages("err, batched steps are only supported in Debugger Mode\n");
+        return FALSE;
+    }
+
+    if (CountOfSteps == 0)
+    {
+        ShowMessages("err, the count of steps should be greater than zero\n");
+        return FALSE;
+    }
+
+    StepPacket.StepType      = StepType;
+    StepPacket.RecordType    = Options->RecordType;
+    StepPacket.RegisterMask  = Options->RegisterMask;
+    StepPacket.StopAtAddress = Options->StopAtAddress;
+    StepPacket.StopAddress   = Options->StopAddress;
+
+    RtlZeroMemory(&g_SteppingTraceStatistics, sizeof(STEPPING_TRACE_STATISTICS));
+
+    //
+    // Records are saved to the trace file instead of being shown
+    //
+    if (Options->TraceFilePath[0] != '\0' && !TraceFileWriterOpen(&g_SteppingTraceFileWriter, Options->TraceFilePath))
+    {
+        ShowMessages("err, unable to create the trace file (%s)\n", Options->TraceFilePath);
+        return FALSE;
+    }
+
+    StartTime = GetTickCount64();
+
+    //
+    // Indicate that we're instrumenting (CTRL+C clears it)
+    //
+    g_IsInstrumentingInstructions = TRUE;
+
+    do
+    {
+        StepsOfBatch = CountOfSteps - PerformedSteps;
+
+        if (StepsOfBatch > STEPPING_BATCHED_STEPS_MAXIMUM_STEPS_PER_REQUEST)
+        {
+            StepsOfBatch = STEPPING_BATCHED_STEPS_MAXIMUM_STEPS_PER_REQUEST;
+        }
+
+        //
+        // Step numbers are continued from the previous batch
+        //
+        StepPacket.CountOfSteps    = StepsOfBatch;
+        StepPacket.FirstStepNumber = PerformedSteps;
+
+        g_SteppingTraceStatistics.IsBatchCompleted = FALSE;
+
+        Result = KdSendBatchedStepPacketToDebuggee(&StepPacket);
+
+        //
+        // The batch is not completed if the debuggee is halted before
+        // performing all the steps (e.g., the stop address or a breakpoint)
+        //
+        if (!Result || !g_SteppingTraceStatistics.IsBatchCompleted)
+        {
+            break;
+        }
+
+        PerformedSteps += StepsOfBatch;
+
+        //
+        // Check if user pressed CTRL+C
+        //
+        if (PerformedSteps < CountOfSteps && !g_IsInstrumentingInstructions)
+        {
+            IsInterrupted = TRUE;
+            break;
+        }
+
+    } while (PerformedSteps < CountOfSteps);
+
+    //
+    // We're not instrumenting instructions anymore
+    //
+    g_IsInstrumentingInstructions = FALSE;
+
+    ElapsedTime = GetTickCount64() - StartTime;
+
+    if (g_SteppingTraceFileWriter.File != NULL)
+    {
+        if (!TraceFileWriterClose(&g_SteppingTraceFileWriter))
+        {
+            ShowMessages("err, unable to write the trace file (%s)\n", Options->TraceFilePath);
+            return FALSE;
+        }
+
+        if (Result)
+        {
+            ShowMessages("records are saved to the trace file (%s)", Options->TraceFilePath);
+        }
+    }
+
+    if (!Result)
+    {
+        return FALSE;
+    }
+
+    ShowMessages("\n%llx records (%llx chunks, %llx bytes of records) in %llu ms",
+                 g_SteppingTraceStatistics.CountOfRecords,
+                 g_SteppingTraceStatistics.CountOfChunks,
+                 g_SteppingTraceStatistics.CountOfBytes,
+                 ElapsedTime);
+
+    if (ElapsedTime != 0)
+    {
+        ShowMessages(" (%llu records/s)", g_SteppingTraceStatistics.CountOfRecords * 1000 / ElapsedTime);
+    }
+
+    ShowMessages("\n");
+
+    if (IsInterrupted)
+    {
+        ShowMessages("stepping is stopped by the user after %x steps\n", PerformedSteps);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Show the records of batched steps
+ * @details Records are decoded in the debugger, the debuggee only saves the
+ * RIP, the registers, and the bytes of the instruction
+ *
+ * @param Chunk The received chunk of records
+ * @param Length Length of the chunk (including the header)
+ *
+ * @return VOID
+ */
+VOID
+SteppingShowTraceRecords(PDEBUGGEE_STEP_TRACE_CHUNK Chunk, UINT32 Length)
+{
+    BYTE *     Records = (BYTE *)Chunk + sizeof(DEBUGGEE_STEP_TRACE_CHUNK);
+    GUEST_REGS Registers;
+    RFLAGS     Rflags;
+    UINT64     UsedBaseAddress;
+
+    if (Length < sizeof(DEBUGGEE_STEP_TRACE_CHUNK) ||
+        Chunk->RecordSize < sizeof(UINT64) ||
+        (UINT64)Chunk->CountOfRecords * Chunk->RecordSize > Length - sizeof(DEBUGGEE_STEP_TRACE_CHUNK))
+    {
+        ShowMessages("err, invalid records of batched steps are received\n");
+        return;
+    }
+
+    g_SteppingTraceStatistics.CountOfRecords += Chunk->CountOfRecords;
+    g_SteppingTraceStatistics.CountOfChunks++;
+    g_SteppingTraceStatistics.CountOfBytes += Length;
+
+    if (Chunk->IsLastChunk)
+    {
+        g_SteppingTraceStatistics.IsBatchCompleted = Chunk->IsCompleted;
+    }
+
+    if (g_SteppingTraceFileWriter.File != NULL)
+    {
+        if (!TraceFileWriterAddStepTraceChunk(&g_SteppingTraceFileWriter, Chunk, Length))
+        {
+            ShowMessages("err, unable to save the records to the trace file\n");
+        }
+
+        return;
+    }
+
+    if (Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        //
+        // Only the 'call' and the 'ret' instructions are received (tracking)
+        //
+        if (Chunk->RecordSize < sizeof(DEBUGGEE_STEP_TRACE_EDGE_RECORD))
+        {
+            ShowMessages("err, invalid records of batched steps are received\n");
+            return;
+        }
+
+        for (UINT32 i = 0; i < Chunk->CountOfRecords; i++)
+        {
+            CommandTrackHandleReceivedEdgeRecord((PDEBUGGEE_STEP_TRACE_EDGE_RECORD)(Records + (UINT64)i * Chunk->RecordSize));
+        }
+
+        return;
+    }
+
+    for (UINT32 i = 0; i < Chunk->CountOfRecords; i++)
+    {
+        UINT64 * Values     = (UINT64 *)(Records + (UINT64)i * Chunk->RecordSize);
+        UINT64 * LastValue  = (UINT64 *)(Records + (UINT64)(i + 1) * Chunk->RecordSize);
+        UINT64   Rip        = *Values++;
+        UINT32   ShownCount = 0;
+
+        switch (Chunk->RecordType)
+        {
+        case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP:
+        case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS:
+
+            ShowMessages("%llx   %s   ", Chunk->FirstStepNumber + i, SeparateTo64BitValue(Rip).c_str());
+
+            UsedBaseAddress = NULL;
+            SymbolShowFunctionNameBasedOnAddress(Rip, &UsedBaseAddress);
+
+            ShowMessages("\n");
+
+            if (Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP)
+            {
+                break;
+            }
+
+            //
+            // Show the saved registers (in the order of the bits of the mask)
+            //
+            for (UINT32 j = 0; j <= 16 && Values < LastValue; j++)
+            {
+                if (Chunk->RegisterMask & (1 << j))
+                {
+                    ShowMessages("%s%s=%016llx", (ShownCount % 4) == 0 ? "    " : " ", SteppingTraceRegisterNames[j], *Values++);
+
+                    if ((++ShownCount % 4) == 0)
+                    {
+                        ShowMessages("\n");
+                    }
+                }
+            }
+
+            if ((ShownCount % 4) != 0)
+            {
+                ShowMessages("\n");
+            }
+
+            break;
+
+        case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS:
+
+            //
+            // All the registers are saved, then the bytes of the instruction
+            //
+            if (Chunk->RecordSize < sizeof(UINT64) + sizeof(GUEST_REGS) + sizeof(UINT64) + MAXIMUM_INSTR_SIZE)
+            {
+                ShowMessages("err, invalid records of batched steps are received\n");
+                return;
+            }
+
+            memcpy(&Registers, Values, sizeof(GUEST_REGS));
+            Values += sizeof(GUEST_REGS) / sizeof(UINT64);
+
+            Rflags.AsUInt = *Values++;
+
+            if (Chunk->Is32Bit)
+            {
+                HyperDbgDisassembler32((unsigned char *)Values, Rip, MAXIMUM_INSTR_SIZE, 1, TRUE, &Rflags);
+            }
+            else
+            {
+                HyperDbgDisassembler64((unsigned char *)Values, Rip, MAXIMUM_INSTR_SIZE, 1, TRUE, &Rflags);
+            }
+
+            HyperDbgShowMemoryOperandsOfInstruction((unsigned char *)Values, MAXIMUM_INSTR_SIZE, Rip, !Chunk->Is32Bit, &Registers);
+
+            break;
+
+        default:
+
+            ShowMessages("err, unknown type of records of batched steps\n");
+            return;
+        }
+    }
+}
@@ -28,6 +28,7 @@ extern OVERLAPPED                       g_OverlappedIoStructureForReadDebugger;
 extern OVERLAPPED                       g_OverlappedIoStructureForWriteDebugger;
 extern OVERLAPPED                       g_OverlappedIoStructureForReadDebuggee;
 extern DEBUGGER_EVENT_AND_ACTION_RESULT g_DebuggeeResultOfRegisteringEvent;
+extern DEBUGGER_MODIFY_EVENTS           g_SharedEventCostsResult;
 extern DEBUGGER_EVENT_AND_ACTION_RESULT
                g_DebuggeeResultOfAddingActionsToEvent;
 extern BOOLEAN g_IsSerialConnectedToRemoteDebuggee;
@@ -305,6 +306,57 @@ KdSendEventQueryAndModifyPacketToDebuggee(
     return TRUE;
 }
 
+/**
+ * @brief Sends a query of the costs of an event to the debuggee
+ * @param Tag
+ * @param Costs The merged costs of the event from all cores
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+KdSendEventQueryCostsPacketToDebuggee(UINT64 Tag, PDEBUGGER_EVENT_COSTS Costs)
+{
+    DEBUGGER_MODIFY_EVENTS ModifyAndQueryEventPacket = {0};
+
+    RtlZeroMemory(&g_SharedEventCostsResult, sizeof(DEBUGGER_MODIFY_EVENTS));
+
+    //
+    // Fill the structure of packet
+    //
+    ModifyAndQueryEventPacket.Tag          = Tag;
+    ModifyAndQueryEventPacket.TypeOfAction = DEBUGGER_MODIFY_EVENTS_QUERY_COSTS;
+
+    //
+    // Send query costs packet
+    //
+    if (!KdCommandPacketAndBufferToDebuggee(
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_EXECUTE_ON_VMX_ROOT,
+            DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_QUERY_AND_MODIFY_EVENT,
+            (CHAR *)&ModifyAndQueryEventPacket,
+            sizeof(DEBUGGER_MODIFY_EVENTS)))
+    {
+        return FALSE;
+    }
+
+    //
+    // Wait until the result of query is received
+    //
+    DbgWaitForKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_MODIFY_AND_QUERY_EVENT);
+
+    //
+    // Check the result that is set by the listening thread
+    //
+    if (g_SharedEventCostsResult.KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+    {
+        ShowErrorMessage((UINT32)g_SharedEventCostsResult.KernelStatus);
+        return FALSE;
+    }
+
+    memcpy(Costs, &g_SharedEventCostsResult.Costs, sizeof(DEBUGGER_EVENT_COSTS));
+
+    return TRUE;
+}
+
 /**
  * @brief Send a flush request to the debuggee
  *
@@ -1020,6 +1072,112 @@ KdSendApicActionPacketsToDebuggee(PDEBUGGER_APIC_REQUEST ApicRequest, UINT32 Exp
     return TRUE;
 }
 
+/**
+ * @brief Send requests for the VM-exit profiler to the debuggee
+ * @param ProfilerRequest
+ * @param ExpectedRequestSize
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+KdSendVmexitProfilerActionPacketsToDebuggee(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest, UINT32 ExpectedRequestSize)
+{
+    //
+    // Set the request data
+    //
+    DbgWaitSetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_VMEXIT_PROFILER_ACTIONS, ProfilerRequest, ExpectedRequestSize);
+
+    //
+    // Send the VM-exit profiler request packets
+    //
+    if (!KdCommandPacketAndBufferToDebuggee(
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_EXECUTE_ON_VMX_ROOT,
+            DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_VMEXIT_PROFILER,
+            (CHAR *)ProfilerRequest,
+            sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST) // only sending the request header
+            ))
+    {
+        return FALSE;
+    }
+
+    //
+    // Wait until the result of actions to the VM-exit profiler is received
+    //
+    DbgWaitForKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_VMEXIT_PROFILER_ACTIONS);
+
+    return TRUE;
+}
+
+/**
+ * @brief Send requests for logging the dirty pages to the debuggee
+ * @param DirtyPagesRequest
+ * @param ExpectedRequestSize
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+KdSendDirtyPagesActionPacketsToDebuggee(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, UINT32 ExpectedRequestSize)
+{
+    //
+    // Set the request data
+    //
+    DbgWaitSetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_DIRTY_PAGES_ACTIONS, DirtyPagesRequest, ExpectedRequestSize);
+
+    //
+    // Send the dirty pages request packets
+    //
+    if (!KdCommandPacketAndBufferToDebuggee(
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_EXECUTE_ON_VMX_ROOT,
+            DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_DIRTY_PAGES,
+            (CHAR *)DirtyPagesRequest,
+            sizeof(DEBUGGER_DIRTY_PAGES_REQUEST) // only sending the request header
+            ))
+    {
+        return FALSE;
+    }
+
+    //
+    // Wait until the result of actions to the dirty pages is received
+    //
+    DbgWaitForKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_DIRTY_PAGES_ACTIONS);
+
+    return TRUE;
+}
+
+/**
+ * @brief Send requests for the memory snapshot to the debuggee
+ * @param SnapshotRequest
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+KdSendSnapshotActionPacketsToDebuggee(PDEBUGGER_SNAPSHOT_REQUEST SnapshotRequest)
+{
+    //
+    // Set the request data
+    //
+    DbgWaitSetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_SNAPSHOT_ACTIONS, SnapshotRequest, sizeof(DEBUGGER_SNAPSHOT_REQUEST));
+
+    //
+    // Send the snapshot request packets
+    //
+    if (!KdCommandPacketAndBufferToDebuggee(
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_EXECUTE_ON_VMX_ROOT,
+            DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_PERFORM_ACTIONS_ON_SNAPSHOT,
+            (CHAR *)SnapshotRequest,
+            sizeof(DEBUGGER_SNAPSHOT_REQUEST)))
+    {
+        return FALSE;
+    }
+
+    //
+    // Wait until the result of actions to the snapshot is received
+    //
+    DbgWaitForKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_SNAPSHOT_ACTIONS);
+
+    return TRUE;
+}
+
 /**
  * @brief Sends a breakpoint set or 'bp' command packet to the debuggee
  * @param BpPacket
@@ -1314,6 +1472,47 @@ KdSendStepPacketToDebuggee(DEBUGGER_REMOTE_STEPPING_REQUEST StepRequestType)
     return TRUE;
 }
 
+/**
+ * @brief Sends the packet of batched steps (t, p, and i commands with
+ * records) to the debuggee
+ * @details The records are received in chunks until the debuggee is paused
+ *
+ * @param StepPacket
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+KdSendBatchedStepPacketToDebuggee(PDEBUGGEE_STEP_PACKET StepPacket)
+{
+    //
+    // Other cores are continued in the regular step-in and the step-over, so
+    // the debuggee is running (and could be paused) until the steps are finished
+    //
+    if (StepPacket->StepType != DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN)
+    {
+        g_IsDebuggeeRunning = TRUE;
+    }
+
+    //
+    // Send step packet to the serial
+    //
+    if (!KdCommandPacketAndBufferToDebuggee(
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_EXECUTE_ON_VMX_ROOT,
+            DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_ON_VMX_ROOT_MODE_STEP,
+            (CHAR *)StepPacket,
+            sizeof(DEBUGGEE_STEP_PACKET)))
+    {
+        return FALSE;
+    }
+
+    //
+    // Wait until the steps are finished (records are handled once they're received)
+    //
+    DbgWaitForKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_IS_DEBUGGER_RUNNING);
+
+    return TRUE;
+}
+
 /**
  * @brief Sends a PAUSE packet to the debuggee
  *
@@ -25,6 +25,7 @@ extern BOOLEAN                          g_IsSerialConnectedToRemoteDebuggee;
 extern BOOLEAN                          g_IsDebuggeeRunning;
 extern BOOLEAN                          g_IgnoreNewLoggingMessages;
 extern BOOLEAN                          g_SharedEventStatus;
+extern DEBUGGER_MODIFY_EVENTS           g_SharedEventCostsResult;
 extern BOOLEAN                          g_IsRunningInstruction32Bit;
 extern BOOLEAN                          g_OutputSourcesInitialized;
 extern ULONG                            g_CurrentRemoteCore;
@@ -64,6 +65,9 @@ ListeningSerialPortInDebugger()
     PDEBUGGEE_REGISTER_READ_DESCRIPTION         ReadRegisterPacket;
     PDEBUGGEE_REGISTER_WRITE_DESCRIPTION        WriteRegisterPacket;
     PDEBUGGER_APIC_REQUEST                      ApicRequestPacket;
+    PDEBUGGER_VMEXIT_PROFILER_REQUEST           VmexitProfilerRequestPacket;
+    PDEBUGGER_DIRTY_PAGES_REQUEST               DirtyPagesRequestPacket;
+    PDEBUGGER_SNAPSHOT_REQUEST                  SnapshotRequestPacket;
     PDEBUGGER_READ_MEMORY                       ReadMemoryPacket;
     PDEBUGGER_EDIT_MEMORY                       EditMemoryPacket;
     PDEBUGGEE_BP_PACKET                         BpPacket;
@@ -72,6 +76,7 @@ ListeningSerialPortInDebugger()
     PDEBUGGER_PAGE_IN_REQUEST                   PageinPacket;
     PDEBUGGER_VA2PA_AND_PA2VA_COMMANDS          Va2paPa2vaPacket;
     PDEBUGGEE_BP_LIST_OR_MODIFY_PACKET          ListOrModifyBreakpointPacket;
+    PDEBUGGEE_STEP_TRACE_CHUNK                  StepTraceChunkPacket;
     BOOLEAN                                     ShowSignatureWhenDisconnected = FALSE;
     PVOID                                       CallerAddress                 = NULL;
     UINT32                                      CallerSize                    = NULL_ZERO;
@@ -500,6 +505,12 @@ StartAgain:
                 {
                     ShowMessages("not found\n");
                 }
+                else if (SearchResultsPacket->CountOfResults >= MaximumSearchResults)
+                {
+                    ShowMessages("the search is stopped after 0x%x results, search a smaller range "
+                                 "to see the other results\n",
+                                 MaximumSearchResults);
+                }
             }
             else
             {
@@ -586,6 +597,7 @@ StartAgain:
                 //
                 CallstackShowFrames(CallstackFramePacket,
                                     CallstackPacket->FrameCount,
+                                    CallstackPacket->UnwoundFrameCount,
                                     CallstackPacket->DisplayMethod,
                                     CallstackPacket->Is32Bit);
             }
@@ -734,7 +746,14 @@ StartAgain:
             //
             // Set the result of query
             //
-            if (EventModifyAndQueryPacket->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
+            if (EventModifyAndQueryPacket->TypeOfAction == DEBUGGER_MODIFY_EVENTS_QUERY_COSTS)
+            {
+                //
+                // Set the costs of the event (the status is checked by the sender)
+                //
+                memcpy(&g_SharedEventCostsResult, EventModifyAndQueryPacket, sizeof(DEBUGGER_MODIFY_EVENTS));
+            }
+            else if (EventModifyAndQueryPacket->KernelStatus != DEBUGGER_OPERATION_WAS_SUCCESSFUL)
             {
                 //
                 // There was an error
@@ -854,6 +873,84 @@ StartAgain:
 
             break;
 
+        case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_VMEXIT_PROFILER_REQUESTS:
+
+            VmexitProfilerRequestPacket = (DEBUGGER_VMEXIT_PROFILER_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+            //
+            // Get the address and size of the caller
+            //
+            DbgWaitGetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_VMEXIT_PROFILER_ACTIONS, &CallerAddress, &CallerSize);
+
+            //
+            // Copy the memory buffer for the caller
+            //
+            memcpy(CallerAddress, VmexitProfilerRequestPacket, CallerSize);
+
+            //
+            // Signal the event relating to receiving result of performing actions into the VM-exit profiler
+            //
+            DbgReceivedKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_VMEXIT_PROFILER_ACTIONS);
+
+            break;
+
+        case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_DIRTY_PAGES_REQUESTS:
+
+            DirtyPagesRequestPacket = (DEBUGGER_DIRTY_PAGES_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+            //
+            // Get the address and size of the caller
+            //
+            DbgWaitGetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_DIRTY_PAGES_ACTIONS, &CallerAddress, &CallerSize);
+
+            //
+            // Copy the memory buffer for the caller
+            //
+            memcpy(CallerAddress, DirtyPagesRequestPacket, CallerSize);
+
+            //
+            // Signal the event relating to receiving result of performing actions on the dirty pages
+            //
+            DbgReceivedKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_DIRTY_PAGES_ACTIONS);
+
+            break;
+
+        case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_SNAPSHOT_REQUESTS:
+
+            SnapshotRequestPacket = (DEBUGGER_SNAPSHOT_REQUEST *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+            //
+            // Get the address and size of the caller
+            //
+            DbgWaitGetRequestData(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_SNAPSHOT_ACTIONS, &CallerAddress, &CallerSize);
+
+            //
+            // Copy the memory buffer for the caller
+            //
+            memcpy(CallerAddress, SnapshotRequestPacket, CallerSize);
+
+            //
+            // Signal the event relating to receiving result of performing actions on the snapshot
+            //
+            DbgReceivedKernelResponse(DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_SNAPSHOT_ACTIONS);
+
+            break;
+
+        case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_STEP_TRACE_RECORDS:
+
+            StepTraceChunkPacket = (DEBUGGEE_STEP_TRACE_CHUNK *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
+
+            //
+            // Show the records of batched steps (the debuggee is not halted, the
+            // steps are finished once the pausing packet is received)
+            //
+            if (LengthReceived >= sizeof(DEBUGGER_REMOTE_PACKET))
+            {
+                SteppingShowTraceRecords(StepTraceChunkPacket, LengthReceived - sizeof(DEBUGGER_REMOTE_PACKET));
+            }
+
+            break;
+
         case DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_READING_MEMORY:
 
             ReadMemoryPacket = (DEBUGGER_READ_MEMORY *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
@@ -14,7 +14,9 @@
 //
 // Global Variables
 //
-extern BOOLEAN g_AddressConversion;
+extern BOOLEAN               g_AddressConversion;
+extern PMODULE_SYMBOL_DETAIL g_SymbolTable;
+extern UINT32                g_SymbolTableSize;
 
 /**
  * @brief Walkthrough the stack
@@ -198,11 +200,154 @@ CallstackReturnAddressToCallingAddress(UCHAR * ReturnAddress, PUINT32 IndexOfCal
     return FALSE;
 }
 
+/**
+ * @brief Show the nearest exported function of an address
+ * @details It's used when the symbols of the module are not loaded, the
+ * image of the module is mapped from the path that is reported by the
+ * debuggee and it's only used if its PDB GUID and age match the module
+ *
+ * @param Address
+ *
+ * @return BOOLEAN shows whether the name is shown or not
+ */
+BOOLEAN
+CallstackShowExportNameBasedOnAddress(UINT64 Address)
+{
+    PMODULE_SYMBOL_DETAIL     Module;
+    std::shared_ptr<PE_IMAGE> Image;
+    const PE_IMAGE_EXPORT *   Export;
+    std::string               ModuleName;
+    UINT64                    Rva;
+
+    Module = SymbolGetModuleByAddress(Address);
+
+    if (Module == NULL)
+    {
+        return FALSE;
+    }
+
+    Image = PeImageOpenModule(Module);
+
+    if (Image == nullptr)
+    {
+        return FALSE;
+    }
+
+    Rva = Address - Module->BaseAddress;
+
+    if (Rva >= Image->SizeOfImage)
+    {
+        return FALSE;
+    }
+
+    Export = PeImageFindExportByRva(Image.get(), (UINT32)Rva);
+
+    if (Export == NULL)
+    {
+        return FALSE;
+    }
+
+    ModuleName = SymbolGetModuleName(Module);
+
+    if (Export->Name != NULL)
+    {
+        ShowMessages("%s!%s+0x%llx", ModuleName.c_str(), Export->Name, Rva - Export->Rva);
+    }
+    else
+    {
+        ShowMessages("%s!#%d+0x%llx", ModuleName.c_str(), Export->Ordinal, Rva - Export->Rva);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Show the imported function that is called by an indirect call
+ * through the import address table (call [rip+disp32] or call [disp32])
+ * @details The thunk is resolved based on the import directory of the image
+ * of the module that contains the thunk
+ *
+ * @param ReturnAddress The return address of the call
+ * @param InstructionBytes The bytes before the return address
+ * @param Is32Bit
+ *
+ * @return BOOLEAN shows whether the name is shown or not
+ */
+BOOLEAN
+CallstackShowImportNameOfCall(UINT64 ReturnAddress, UCHAR * InstructionBytes, BOOLEAN Is32Bit)
+{
+    PMODULE_SYMBOL_DETAIL     Module;
+    std::shared_ptr<PE_IMAGE> Image;
+    const PE_IMAGE_IMPORT *   Import;
+    UINT64                    ThunkAddress;
+    INT32                     Displacement;
+
+    //
+    // FF 15 [4-byte displacement]
+    //
+    if (InstructionBytes[-6] != 0xFF || InstructionBytes[-5] != 0x15)
+    {
+        return FALSE;
+    }
+
+    memcpy(&Displacement, &InstructionBytes[-4], sizeof(Displacement));
+
+    if (Is32Bit)
+    {
+        //
+        // The displacement is the absolute address of the thunk
+        //
+        ThunkAddress = (UINT32)Displacement;
+    }
+    else
+    {
+        //
+        // The displacement is relative to the next instruction
+        //
+        ThunkAddress = ReturnAddress + (INT64)Displacement;
+    }
+
+    Module = SymbolGetModuleByAddress(ThunkAddress);
+
+    if (Module == NULL)
+    {
+        return FALSE;
+    }
+
+    Image = PeImageOpenModule(Module);
+
+    if (Image == nullptr || ThunkAddress - Module->BaseAddress >= Image->SizeOfImage)
+    {
+        return FALSE;
+    }
+
+    Import = PeImageFindImportByThunkRva(Image.get(), (UINT32)(ThunkAddress - Module->BaseAddress));
+
+    if (Import == NULL)
+    {
+        return FALSE;
+    }
+
+    if (Import->Name != NULL)
+    {
+        ShowMessages(" -> %s!%s", Import->ModuleName, Import->Name);
+    }
+    else
+    {
+        ShowMessages(" -> %s!#%d", Import->ModuleName, Import->OrdinalOrHint);
+    }
+
+    return TRUE;
+}
+
 /**
  * @brief Show stack frames
+ * @details The first slots (UnwoundFrameCount) are walked based on the unwind
+ * data of the modules, the rest of the slots are interpreted heuristically
  *
  * @param CallstackFrames
  * @param FrameCount
+ * @param UnwoundFrameCount
  * @param DisplayMethod
  * @param Is32Bit
  *
@@ -211,14 +356,14 @@ CallstackReturnAddressToCallingAddress(UCHAR * ReturnAddress, PUINT32 IndexOfCal
 VOID
 CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
                     UINT32                            FrameCount,
+                    UINT32                            UnwoundFrameCount,
                     DEBUGGER_CALLSTACK_DISPLAY_METHOD DisplayMethod,
                     BOOLEAN                           Is32Bit)
 {
-    UINT32                                                 CallLength;
-    UINT64                                                 TargetAddress;
-    UINT64                                                 UsedBaseAddress;
-    BOOLEAN                                                IsCall = FALSE;
-    std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION>::iterator Iterate;
+    UINT32  CallLength;
+    UINT64  TargetAddress;
+    UINT64  UsedBaseAddress;
+    BOOLEAN IsCall = FALSE;
 
     //
     // Print callstack frames
@@ -227,23 +372,44 @@ CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
     {
         IsCall = FALSE;
 
-        if (CallstackFrames[i].IsValidAddress)
+        if (i < UnwoundFrameCount)
         {
             //
-            // Check if it's call or just a simple code address
+            // The return addresses are found by unwinding, so they're calls
+            // even if the call instruction is not recognized
             //
-            if (CallstackFrames[i].IsExecutable && CallstackReturnAddressToCallingAddress(
-                                                       (unsigned char *)&CallstackFrames[i].InstructionBytesOnRip[MAXIMUM_CALL_INSTR_SIZE],
-                                                       &CallLength))
+            if (CallstackFrames[i].IsReturnAddress)
             {
-                //
-                // Computer the "call" instruction address
-                //
-                TargetAddress = CallstackFrames[i].Value - CallLength;
+                if (CallstackReturnAddressToCallingAddress(
+                        (unsigned char *)&CallstackFrames[i].InstructionBytesOnRip[MAXIMUM_CALL_INSTR_SIZE],
+                        &CallLength))
+                {
+                    TargetAddress = CallstackFrames[i].Value - CallLength;
+                }
+                else
+                {
+                    TargetAddress = CallstackFrames[i].Value;
+                }
 
                 IsCall = TRUE;
             }
-            else
+        }
+        else if (CallstackFrames[i].IsValidAddress && CallstackFrames[i].IsExecutable &&
+                 CallstackReturnAddressToCallingAddress(
+                     (unsigned char *)&CallstackFrames[i].InstructionBytesOnRip[MAXIMUM_CALL_INSTR_SIZE],
+                     &CallLength))
+        {
+            //
+            // Computer the "call" instruction address
+            //
+            TargetAddress = CallstackFrames[i].Value - CallLength;
+
+            IsCall = TRUE;
+        }
+
+        if (IsCall || CallstackFrames[i].IsValidAddress)
+        {
+            if (!IsCall)
             {
                 //
                 // Check if we wanna show the stack params
@@ -253,7 +419,6 @@ CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
                     continue;
                 }
 
-                IsCall        = FALSE;
                 TargetAddress = CallstackFrames[i].Value;
             }
 
@@ -288,7 +453,8 @@ CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
             //
             if (g_AddressConversion)
             {
-                if (SymbolShowFunctionNameBasedOnAddress(TargetAddress, &UsedBaseAddress))
+                if (SymbolShowFunctionNameBasedOnAddress(TargetAddress, &UsedBaseAddress) ||
+                    CallstackShowExportNameBasedOnAddress(TargetAddress))
                 {
                     ShowMessages(" ");
                 }
@@ -296,12 +462,21 @@ CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
 
             if (Is32Bit)
             {
-                ShowMessages("<%08x>)\n", TargetAddress);
+                ShowMessages("<%08x>)", TargetAddress);
             }
             else
             {
-                ShowMessages("<%016llx>)\n", TargetAddress);
+                ShowMessages("<%016llx>)", TargetAddress);
+            }
+
+            if (IsCall && g_AddressConversion)
+            {
+                CallstackShowImportNameOfCall(CallstackFrames[i].Value,
+                                              (UCHAR *)&CallstackFrames[i].InstructionBytesOnRip[MAXIMUM_CALL_INSTR_SIZE],
+                                              Is32Bit);
             }
+
+            ShowMessages("\n");
         }
         else
         {
@@ -0,0 +1,301 @@
+/**
+ * @file disassembler-cache.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The decoded instructions cache of the disassembler
+ * @details The disassembler is used by the command thread and by the threads
+ * that receive the packets of the debuggee (e.g., the tracker), so the cache
+ * is accessed under its lock and the instructions are copied out of it
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include "Zydis/Zydis.h"
+#include "header/disassembler-cache.h"
+
+/**
+ * @brief The decoded instructions cache
+ *
+ */
+DISASSEMBLER_CACHE g_DisassemblerCache = {0};
+
+/**
+ * @brief Compute the hash of the key of an instruction in the decoded
+ * instructions cache (FNV-1a)
+ *
+ * @param Mode
+ * @param Address
+ * @param Bytes
+ * @param WindowLength
+ *
+ * @return UINT32
+ */
+static UINT32
+DisassemblerCacheHash(UINT32 Mode, UINT64 Address, const ZyanU8 * Bytes, UINT32 WindowLength)
+{
+    UINT64 Hash = 0xcbf29ce484222325ull;
+
+    Hash = (Hash ^ Mode) * 0x100000001b3ull;
+    Hash = (Hash ^ Address) * 0x100000001b3ull;
+
+    for (UINT32 i = 0; i < WindowLength; i++)
+    {
+        Hash = (Hash ^ Bytes[i]) * 0x100000001b3ull;
+    }
+
+    return (UINT32)(Hash ^ (Hash >> 32));
+}
+
+/**
+ * @brief Remove an entry from the LRU list of the decoded instructions cache
+ *
+ * @param Index
+ *
+ * @return VOID
+ */
+static VOID
+DisassemblerCacheUnlink(UINT32 Index)
+{
+    DISASSEMBLER_CACHE_ENTRY * Entry = &g_DisassemblerCache.Entries[Index];
+
+    if (Entry->MoreRecent != DISASSEMBLER_CACHE_INVALID_INDEX)
+    {
+        g_DisassemblerCache.Entries[Entry->MoreRecent].LessRecent = Entry->LessRecent;
+    }
+    else
+    {
+        g_DisassemblerCache.MostRecent = Entry->LessRecent;
+    }
+
+    if (Entry->LessRecent != DISASSEMBLER_CACHE_INVALID_INDEX)
+    {
+        g_DisassemblerCache.Entries[Entry->LessRecent].MoreRecent = Entry->MoreRecent;
+    }
+    else
+    {
+        g_DisassemblerCache.LeastRecent = Entry->MoreRecent;
+    }
+}
+
+/**
+ * @brief Make an entry the most recently used entry of the decoded
+ * instructions cache
+ *
+ * @param Index
+ *
+ * @return VOID
+ */
+static VOID
+DisassemblerCacheLinkAsMostRecent(UINT32 Index)
+{
+    DISASSEMBLER_CACHE_ENTRY * Entry = &g_DisassemblerCache.Entries[Index];
+
+    Entry->MoreRecent = DISASSEMBLER_CACHE_INVALID_INDEX;
+    Entry->LessRecent = g_DisassemblerCache.MostRecent;
+
+    if (g_DisassemblerCache.MostRecent != DISASSEMBLER_CACHE_INVALID_INDEX)
+    {
+        g_DisassemblerCache.Entries[g_DisassemblerCache.MostRecent].MoreRecent = Index;
+    }
+    else
+    {
+        g_DisassemblerCache.LeastRecent = Index;
+    }
+
+    g_DisassemblerCache.MostRecent = Index;
+}
+
+/**
+ * @brief Remove the least recently used entry of the decoded instructions
+ * cache and return its index to be reused
+ *
+ * @return UINT32
+ */
+static UINT32
+DisassemblerCacheEvict()
+{
+    UINT32   Index = g_DisassemblerCache.LeastRecent;
+    UINT32 * Link  = &g_DisassemblerCache.Buckets[g_DisassemblerCache.Entries[Index].Hash & (DISASSEMBLER_CACHE_HASH_BUCKETS - 1)];
+
+    DisassemblerCacheUnlink(Index);
+
+    //
+    // Remove it from the chain of its bucket
+    //
+    while (*Link != Index)
+    {
+        Link = &g_DisassemblerCache.Entries[*Link].NextInBucket;
+    }
+
+    *Link = g_DisassemblerCache.Entries[Index].NextInBucket;
+
+    return Index;
+}
+
+/**
+ * @brief Find an instruction in the decoded instructions cache
+ * @details The lock of the cache should be held
+ *
+ * @param Mode
+ * @param Address
+ * @param Buffer
+ * @param WindowLength
+ * @param Hash
+ *
+ * @return DISASSEMBLER_CACHE_ENTRY * NULL if it's not found
+ */
+static DISASSEMBLER_CACHE_ENTRY *
+DisassemblerCacheFind(UINT32 Mode, UINT64 Address, const ZyanU8 * Buffer, UINT32 WindowLength, UINT32 Hash)
+{
+    DISASSEMBLER_CACHE_ENTRY * Entry;
+
+    for (UINT32 Index = g_DisassemblerCache.Buckets[Hash & (DISASSEMBLER_CACHE_HASH_BUCKETS - 1)];
+         Index != DISASSEMBLER_CACHE_INVALID_INDEX;
+         Index = Entry->NextInBucket)
+    {
+        Entry = &g_DisassemblerCache.Entries[Index];
+
+        if (Entry->Hash == Hash &&
+            Entry->Address == Address &&
+            Entry->Mode == Mode &&
+            Entry->WindowLength == WindowLength &&
+            memcmp(Entry->Bytes, Buffer, WindowLength) == 0)
+        {
+            //
+            // Make it the most recently used instruction
+            //
+            DisassemblerCacheUnlink(Index);
+            DisassemblerCacheLinkAsMostRecent(Index);
+
+            return Entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Remove all of the instructions from the decoded instructions cache
+ *
+ * @return VOID
+ */
+VOID
+DisassemblerCacheClear()
+{
+    SpinlockLock(&g_DisassemblerCache.Lock);
+
+    memset(g_DisassemblerCache.Buckets, 0xff, sizeof(g_DisassemblerCache.Buckets));
+
+    g_DisassemblerCache.CountOfEntries = 0;
+    g_DisassemblerCache.MostRecent     = DISASSEMBLER_CACHE_INVALID_INDEX;
+    g_DisassemblerCache.LeastRecent    = DISASSEMBLER_CACHE_INVALID_INDEX;
+
+    SpinlockUnlock(&g_DisassemblerCache.Lock);
+}
+
+/**
+ * @brief Get a decoded instruction from the decoded instructions cache
+ *
+ * @param Mode Mode of the decoder
+ * @param Address Runtime address of the instruction
+ * @param Buffer Bytes of the instruction
+ * @param WindowLength Number of bytes that the instruction is decoded from
+ * @param Instruction The decoded instruction
+ * @param Operands The decoded operands
+ *
+ * @return BOOLEAN Whether the instruction was found or not
+ */
+BOOLEAN
+DisassemblerCacheLookup(UINT32                    Mode,
+                        UINT64                    Address,
+                        const ZyanU8 *            Buffer,
+                        UINT32                    WindowLength,
+                        ZydisDecodedInstruction * Instruction,
+                        ZydisDecodedOperand *     Operands)
+{
+    UINT32                     Hash = DisassemblerCacheHash(Mode, Address, Buffer, WindowLength);
+    DISASSEMBLER_CACHE_ENTRY * Entry;
+
+    SpinlockLock(&g_DisassemblerCache.Lock);
+
+    Entry = DisassemblerCacheFind(Mode, Address, Buffer, WindowLength, Hash);
+
+    if (Entry != NULL)
+    {
+        *Instruction = Entry->Instruction;
+        memcpy(Operands, Entry->Operands, Entry->Instruction.operand_count * sizeof(ZydisDecodedOperand));
+    }
+
+    SpinlockUnlock(&g_DisassemblerCache.Lock);
+
+    return Entry != NULL;
+}
+
+/**
+ * @brief Add a decoded instruction to the decoded instructions cache
+ * @details The least recently used instruction is replaced if the cache is full
+ *
+ * @param Mode Mode of the decoder
+ * @param Address Runtime address of the instruction
+ * @param Buffer Bytes of the instruction
+ * @param WindowLength Number of bytes that the instruction is decoded from
+ * @param Instruction The decoded instruction
+ * @param Operands The decoded operands
+ *
+ * @return VOID
+ */
+VOID
+DisassemblerCacheInsert(UINT32                          Mode,
+                        UINT64                          Address,
+                        const ZyanU8 *                  Buffer,
+                        UINT32                          WindowLength,
+                        const ZydisDecodedInstruction * Instruction,
+                        const ZydisDecodedOperand *     Operands)
+{
+    UINT32                     Hash   = DisassemblerCacheHash(Mode, Address, Buffer, WindowLength);
+    UINT32                     Bucket = Hash & (DISASSEMBLER_CACHE_HASH_BUCKETS - 1);
+    UINT32                     Index;
+    DISASSEMBLER_CACHE_ENTRY * Entry;
+
+    SpinlockLock(&g_DisassemblerCache.Lock);
+
+    //
+    // Another thread might have added the same instruction while it was decoded
+    //
+    if (DisassemblerCacheFind(Mode, Address, Buffer, WindowLength, Hash) != NULL)
+    {
+        SpinlockUnlock(&g_DisassemblerCache.Lock);
+        return;
+    }
+
+    if (g_DisassemblerCache.CountOfEntries < DISASSEMBLER_CACHE_MAXIMUM_ENTRIES)
+    {
+        Index = g_DisassemblerCache.CountOfEntries++;
+    }
+    else
+    {
+        Index = DisassemblerCacheEvict();
+    }
+
+    Entry = &g_DisassemblerCache.Entries[Index];
+
+    Entry->Address      = Address;
+    Entry->Mode         = Mode;
+    Entry->Hash         = Hash;
+    Entry->WindowLength = WindowLength;
+    Entry->Instruction  = *Instruction;
+
+    memcpy(Entry->Bytes, Buffer, WindowLength);
+    memcpy(Entry->Operands, Operands, Instruction->operand_count * sizeof(ZydisDecodedOperand));
+
+    Entry->NextInBucket                 = g_DisassemblerCache.Buckets[Bucket];
+    g_DisassemblerCache.Buckets[Bucket] = Index;
+
+    DisassemblerCacheLinkAsMostRecent(Index);
+
+    SpinlockUnlock(&g_DisassemblerCache.Lock);
+}
@@ -32,6 +32,7 @@ all
 #include "Zycore/Format.h"
 #include "Zycore/LibC.h"
 #include "Zydis/Zydis.h"
+#include "header/disassembler-cache.h"
 
 #pragma comment(lib, "Zydis.lib")
 #pragma comment(lib, "Zycore.lib")
@@ -39,9 +40,8 @@ all
 //
 // Global Variables
 //
-extern UINT32                                       g_DisassemblerSyntax;
-extern std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION> g_DisassemblerSymbolMap;
-extern BOOLEAN                                      g_AddressConversion;
+extern UINT32  g_DisassemblerSyntax;
+extern BOOLEAN g_AddressConversion;
 
 /**
  * @brief Defines the `ZydisSymbol` struct.
@@ -58,8 +58,45 @@ typedef struct ZydisSymbol_
     const char * name;
 } ZydisSymbol;
 
+/**
+ * @brief Indexes of the decoders of each mode
+ *
+ */
+#define DISASSEMBLER_MODE_32    0
+#define DISASSEMBLER_MODE_64    1
+#define DISASSEMBLER_MODE_COUNT 2
+
+/**
+ * @brief Persistent decoders and formatters of the disassembler
+ *
+ */
+typedef struct _DISASSEMBLER_CONTEXT
+{
+    volatile LONG  Lock; // Protects the initialization of the decoders and the formatter
+    BOOLEAN        IsInitialized;
+    BOOLEAN        IsFormatterInitialized;
+    UINT32         FormatterSyntax; // The syntax that the formatter is initialized for
+    ZydisDecoder   Decoders[DISASSEMBLER_MODE_COUNT];
+    ZydisDecoder   MinimalDecoders[DISASSEMBLER_MODE_COUNT]; // Only length, mnemonic, and attributes
+    ZydisFormatter Formatter;
+    ZydisFormatter TrackingFormatter;
+
+} DISASSEMBLER_CONTEXT, *PDISASSEMBLER_CONTEXT;
+
 ZydisFormatterFunc default_print_address_absolute;
 
+/**
+ * @brief The original address printer of the formatter of tracking instructions
+ *
+ */
+ZydisFormatterFunc default_print_address_absolute_for_tracking;
+
+/**
+ * @brief Persistent decoders and formatters of the disassembler
+ *
+ */
+DISASSEMBLER_CONTEXT g_DisassemblerContext = {0};
+
 /**
  * @brief Print addresses
  *
@@ -73,8 +110,8 @@ ZydisFormatterPrintAddressAbsolute(const ZydisFormatter *  formatter,
                                    ZydisFormatterBuffer *  buffer,
                                    ZydisFormatterContext * context)
 {
-    ZyanU64                                                address;
-    std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION>::iterator Iterate;
+    ZyanU64      address;
+    const char * ObjectName;
 
     ZYAN_CHECK(ZydisCalcAbsoluteAddress(context->instruction, context->operand, context->runtime_address, &address));
 
@@ -86,17 +123,17 @@ ZydisFormatterPrintAddressAbsolute(const ZydisFormatter *  formatter,
         //
         // Check to find the symbol of address
         //
-        Iterate = g_DisassemblerSymbolMap.find(address);
+        ObjectName = SymbolMapLookupExact(address);
 
-        if (Iterate != g_DisassemblerSymbolMap.end())
+        if (ObjectName != NULL)
         {
             ZYAN_CHECK(ZydisFormatterBufferAppend(buffer, ZYDIS_TOKEN_SYMBOL));
             ZyanString * string;
             ZYAN_CHECK(ZydisFormatterBufferGetString(buffer, &string));
             return ZyanStringAppendFormat(string,
                                           "<%s (%s)>",
-                                          Iterate->second.ObjectName.c_str(),
-                                          SeparateTo64BitValue(Iterate->first).c_str());
+                                          ObjectName,
+                                          SeparateTo64BitValue(address).c_str());
         }
     }
 
@@ -104,51 +141,168 @@ ZydisFormatterPrintAddressAbsolute(const ZydisFormatter *  formatter,
 }
 
 /**
- * @brief Disassemble a user-mode buffer
+ * @brief Print addresses (and deliver the targets of calls to the tracker)
  *
- * @param decoder
- * @param runtime_address
- * @param data
- * @param length
- * @param maximum_instr
- * @param is_x86_64
- * @param show_of_branch_is_taken
- * @param rflags just used in the case show_of_branch_is_taken is true
+ * @param formatter
+ * @param buffer
+ * @param context
+ * @return ZyanStatus
  */
-VOID
-DisassembleBuffer(ZydisDecoder * decoder,
-                  ZyanU64        runtime_address,
-                  ZyanU8 *       data,
-                  ZyanUSize      length,
-                  uint32_t       maximum_instr,
-                  BOOLEAN        is_x86_64,
-                  BOOLEAN        show_of_branch_is_taken,
-                  PRFLAGS        rflags)
+static ZyanStatus
+ZydisFormatterPrintAddressAbsoluteForTrackingInstructions(const ZydisFormatter *  formatter,
+                                                          ZydisFormatterBuffer *  buffer,
+                                                          ZydisFormatterContext * context)
 {
-    ZydisFormatter formatter;
-    int            instr_decoded   = 0;
-    UINT64         UsedBaseAddress = NULL;
+    ZyanU64      address;
+    const char * ObjectName;
+
+    ZYAN_CHECK(ZydisCalcAbsoluteAddress(context->instruction, context->operand, context->runtime_address, &address));
+
+    //
+    // Apply addressconversion of settings here
+    //
+    if (g_AddressConversion)
+    {
+        //
+        // Check to find the symbol of address
+        //
+        ObjectName = SymbolMapLookupExact(address);
+
+        if (ObjectName != NULL)
+        {
+            ZYAN_CHECK(ZydisFormatterBufferAppend(buffer, ZYDIS_TOKEN_SYMBOL));
+            ZyanString * string;
+            ZYAN_CHECK(ZydisFormatterBufferGetString(buffer, &string));
+
+            //
+            // Call the tracker callback (with function name)
+            //
+            CommandTrackHandleReceivedCallInstructions(ObjectName, address);
+
+            return ZyanStringAppendFormat(string,
+                                          "<%s (%s)>",
+                                          ObjectName,
+                                          SeparateTo64BitValue(address).c_str());
+        }
+    }
+
+    //
+    // Call the tracker callback (without function name)
+    //
+    CommandTrackHandleReceivedCallInstructions(NULL, address);
+
+    return default_print_address_absolute_for_tracking(formatter, buffer, context);
+}
+
+/**
+ * @brief Initialize the persistent decoders and formatters of the disassembler
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+DisassemblerInitializeContext()
+{
+    DISASSEMBLER_CONTEXT * Context = &g_DisassemblerContext;
+
+    if (Context->IsInitialized)
+    {
+        return TRUE;
+    }
+
+    if (ZydisGetVersion() != ZYDIS_VERSION)
+    {
+        ShowMessages("invalid Zydis version\n");
+        return FALSE;
+    }
+
+    SpinlockLock(&Context->Lock);
+
+    //
+    // Another thread might have initialized it
+    //
+    if (Context->IsInitialized)
+    {
+        SpinlockUnlock(&Context->Lock);
+        return TRUE;
+    }
+
+    ZydisDecoderInit(&Context->Decoders[DISASSEMBLER_MODE_64], ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
+    ZydisDecoderInit(&Context->Decoders[DISASSEMBLER_MODE_32], ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
+
+    //
+    // Minimal decoders skip the operands and the semantic analysis, they're
+    // used when only the length or the mnemonic of instructions is needed
+    //
+    for (UINT32 i = 0; i < DISASSEMBLER_MODE_COUNT; i++)
+    {
+        Context->MinimalDecoders[i] = Context->Decoders[i];
+        ZydisDecoderEnableMode(&Context->MinimalDecoders[i], ZYDIS_DECODER_MODE_MINIMAL, ZYAN_TRUE);
+    }
+
+    ZydisFormatterInit(&Context->TrackingFormatter, ZYDIS_FORMATTER_STYLE_INTEL);
+
+    ZydisFormatterSetProperty(&Context->TrackingFormatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
+    ZydisFormatterSetProperty(&Context->TrackingFormatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
+
+    //
+    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
+    // formats the absolute addresses
+    //
+    default_print_address_absolute_for_tracking =
+        (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsoluteForTrackingInstructions;
+    ZydisFormatterSetHook(&Context->TrackingFormatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute_for_tracking);
+
+    DisassemblerCacheClear();
+
+    Context->IsInitialized = TRUE;
+
+    SpinlockUnlock(&Context->Lock);
+
+    return TRUE;
+}
+
+/**
+ * @brief Get the formatter of the disassembler
+ * @details The formatter is initialized again if the syntax is changed
+ * by the 'settings' command
+ *
+ * @return ZydisFormatter * NULL if the syntax is not valid
+ */
+static ZydisFormatter *
+DisassemblerGetFormatter()
+{
+    DISASSEMBLER_CONTEXT * Context = &g_DisassemblerContext;
+    ZydisFormatterStyle    Style;
+
+    if (Context->IsFormatterInitialized && Context->FormatterSyntax == g_DisassemblerSyntax)
+    {
+        return &Context->Formatter;
+    }
 
     if (g_DisassemblerSyntax == 1)
     {
-        ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
+        Style = ZYDIS_FORMATTER_STYLE_INTEL;
     }
     else if (g_DisassemblerSyntax == 2)
     {
-        ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_ATT);
+        Style = ZYDIS_FORMATTER_STYLE_ATT;
     }
     else if (g_DisassemblerSyntax == 3)
     {
-        ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL_MASM);
+        Style = ZYDIS_FORMATTER_STYLE_INTEL_MASM;
     }
     else
     {
         ShowMessages("err, in selecting disassembler syntax\n");
-        return;
+        return NULL;
     }
 
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
+    SpinlockLock(&Context->Lock);
+
+    ZydisFormatterInit(&Context->Formatter, Style);
+
+    ZydisFormatterSetProperty(&Context->Formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
+    ZydisFormatterSetProperty(&Context->Formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
 
     //
     // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that formats
@@ -156,13 +310,132 @@ DisassembleBuffer(ZydisDecoder * decoder,
     //
     default_print_address_absolute =
         (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsolute;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
+    ZydisFormatterSetHook(&Context->Formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
+
+    Context->FormatterSyntax        = g_DisassemblerSyntax;
+    Context->IsFormatterInitialized = TRUE;
+
+    SpinlockUnlock(&Context->Lock);
+
+    return &Context->Formatter;
+}
+
+/**
+ * @brief Decode an instruction (with operands) through the decoded
+ * instructions cache
+ * @details The instruction and the operands are copied from the cache, so
+ * they remain valid while other threads use the cache
+ *
+ * @param Isx86_64 Whether it's an x86 or x64
+ * @param Address Runtime address of the instruction
+ * @param Buffer Bytes of the instruction
+ * @param Length Length of the buffer
+ * @param Instruction The decoded instruction
+ * @param Operands The decoded operands (ZYDIS_MAX_OPERAND_COUNT operands)
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+DisassemblerDecode(BOOLEAN                   Isx86_64,
+                   UINT64                    Address,
+                   const ZyanU8 *            Buffer,
+                   ZyanUSize                 Length,
+                   ZydisDecodedInstruction * Instruction,
+                   ZydisDecodedOperand *     Operands)
+{
+    UINT32 Mode         = Isx86_64 ? DISASSEMBLER_MODE_64 : DISASSEMBLER_MODE_32;
+    UINT32 WindowLength = (UINT32)(Length < ZYDIS_MAX_INSTRUCTION_LENGTH ? Length : ZYDIS_MAX_INSTRUCTION_LENGTH);
+
+    if (!DisassemblerInitializeContext() || WindowLength == 0)
+    {
+        return FALSE;
+    }
+
+    if (DisassemblerCacheLookup(Mode, Address, Buffer, WindowLength, Instruction, Operands))
+    {
+        //
+        // Already decoded
+        //
+        return TRUE;
+    }
+
+    //
+    // The instruction is decoded without holding the lock of the cache
+    //
+    if (!ZYAN_SUCCESS(ZydisDecoderDecodeFull(&g_DisassemblerContext.Decoders[Mode], Buffer, Length, Instruction, Operands)))
+    {
+        return FALSE;
+    }
+
+    DisassemblerCacheInsert(Mode, Address, Buffer, WindowLength, Instruction, Operands);
+
+    return TRUE;
+}
+
+/**
+ * @brief Decode only the length, the mnemonic, and the attributes of an
+ * instruction
+ *
+ * @param Buffer Bytes of the instruction
+ * @param Length Length of the buffer
+ * @param Isx86_64 Whether it's an x86 or x64
+ * @param Instruction The decoded instruction
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+DisassemblerDecodeMinimal(const ZyanU8 * Buffer, ZyanUSize Length, BOOLEAN Isx86_64, ZydisDecodedInstruction * Instruction)
+{
+    if (!DisassemblerInitializeContext())
+    {
+        return FALSE;
+    }
+
+    return ZYAN_SUCCESS(ZydisDecoderDecodeInstruction(&g_DisassemblerContext.MinimalDecoders[Isx86_64 ? DISASSEMBLER_MODE_64 : DISASSEMBLER_MODE_32],
+                                                      ZYAN_NULL,
+                                                      Buffer,
+                                                      Length,
+                                                      Instruction));
+}
 
+/**
+ * @brief Disassemble a user-mode buffer
+ *
+ * @param runtime_address
+ * @param data
+ * @param length
+ * @param maximum_instr
+ * @param is_x86_64
+ * @param show_of_branch_is_taken
+ * @param rflags just used in the case show_of_branch_is_taken is true
+ */
+VOID
+DisassembleBuffer(ZyanU64   runtime_address,
+                  ZyanU8 *  data,
+                  ZyanUSize length,
+                  uint32_t  maximum_instr,
+                  BOOLEAN   is_x86_64,
+                  BOOLEAN   show_of_branch_is_taken,
+                  PRFLAGS   rflags)
+{
+    ZydisFormatter *        formatter;
+    int                     instr_decoded   = 0;
+    UINT64                  UsedBaseAddress = NULL;
     ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
     ZydisDecodedInstruction instruction;
     char                    buffer[256];
 
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(decoder, data, length, &instruction, operands)))
+    //
+    // Get the (persistent) formatter of the current syntax
+    //
+    formatter = DisassemblerGetFormatter();
+
+    if (formatter == NULL)
+    {
+        return;
+    }
+
+    while (DisassemblerDecode(is_x86_64, runtime_address, data, length, &instruction, operands))
     {
         //
         // Apply addressconversion of settings here
@@ -187,7 +460,7 @@ DisassembleBuffer(ZydisDecoder * decoder,
         // We have to pass a `runtime_address` different to
         // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
         //
-        ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), runtime_address, ZYAN_NULL);
+        ZydisFormatterFormatInstruction(formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), runtime_address, ZYAN_NULL);
 
         //
         // Show the memory for this instruction
@@ -306,10 +579,7 @@ ZydisTest()
         0x00 // jmp <SomeModule.EntryPoint>
     };
 
-    ZydisDecoder decoder;
-    ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-
-    DisassembleBuffer(&decoder, 0x007FFFFFFF400000, &data[0], sizeof(data), 0xffffffff, TRUE, FALSE, NULL);
+    DisassembleBuffer(0x007FFFFFFF400000, &data[0], sizeof(data), 0xffffffff, TRUE, FALSE, NULL);
 
     return 0;
 }
@@ -337,19 +607,15 @@ HyperDbgDisassembler64(unsigned char * BufferToDisassemble,
                        BOOLEAN         ShowBranchIsTakenOrNot,
                        PRFLAGS         Rflags)
 {
-    if (ZydisGetVersion() != ZYDIS_VERSION)
+    if (!DisassemblerInitializeContext())
     {
-        fputs("Invalid Zydis version\n", ZYAN_STDERR);
         return EXIT_FAILURE;
     }
 
-    ZydisDecoder decoder;
-    ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-
     //
     // Disassembling buffer
     //
-    DisassembleBuffer(&decoder, BaseAddress, &BufferToDisassemble[0], Size, MaximumInstrDecoded, TRUE, ShowBranchIsTakenOrNot, Rflags);
+    DisassembleBuffer(BaseAddress, &BufferToDisassemble[0], Size, MaximumInstrDecoded, TRUE, ShowBranchIsTakenOrNot, Rflags);
 
     return 0;
 }
@@ -377,19 +643,15 @@ HyperDbgDisassembler32(unsigned char * BufferToDisassemble,
                        BOOLEAN         ShowBranchIsTakenOrNot,
                        PRFLAGS         Rflags)
 {
-    if (ZydisGetVersion() != ZYDIS_VERSION)
+    if (!DisassemblerInitializeContext())
     {
-        fputs("Invalid Zydis version\n", ZYAN_STDERR);
         return EXIT_FAILURE;
     }
 
-    ZydisDecoder decoder;
-    ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-
     //
     // Disassembling buffer
     //
-    DisassembleBuffer(&decoder, (UINT32)BaseAddress, &BufferToDisassemble[0], Size, MaximumInstrDecoded, FALSE, ShowBranchIsTakenOrNot, Rflags);
+    DisassembleBuffer((UINT32)BaseAddress, &BufferToDisassemble[0], Size, MaximumInstrDecoded, FALSE, ShowBranchIsTakenOrNot, Rflags);
 
     return 0;
 }
@@ -412,50 +674,13 @@ HyperDbgIsConditionalJumpTaken(unsigned char * BufferToDisassemble,
                                RFLAGS          Rflags,
                                BOOLEAN         Isx86_64)
 {
-    ZydisDecoder            decoder;
-    ZydisFormatter          formatter;
-    ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
-    UINT64                  CurrentRip    = 0;
-    int                     instr_decoded = 0;
     ZydisDecodedInstruction instruction;
-    UINT32                  MaximumInstrDecoded = 1;
-
-    if (ZydisGetVersion() != ZYDIS_VERSION)
-    {
-        ShowMessages("invalid Zydis version\n");
-        return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
-    }
-
-    if (Isx86_64)
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-    }
-    else
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-    }
-
-    ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
-
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
 
     //
-    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
-    // formats the absolute addresses
+    // Only the mnemonic is needed
     //
-    default_print_address_absolute = (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsolute;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
-
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, BufferToDisassemble, BuffLength, &instruction, operands)))
+    if (DisassemblerDecodeMinimal(BufferToDisassemble, BuffLength, Isx86_64, &instruction))
     {
-        //
-        // We have to pass a `runtime_address` different to
-        // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
-        //
-
-        // ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
-
         switch (instruction.mnemonic)
         {
         case ZydisMnemonic::ZYDIS_MNEMONIC_JO:
@@ -736,7 +961,7 @@ HyperDbgIsConditionalJumpTaken(unsigned char * BufferToDisassemble,
     }
 
     //
-    // Should not reach here
+    // Error in disassembling buffer
     //
     return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
 }
@@ -758,57 +983,18 @@ HyperDbgCheckWhetherTheCurrentInstructionIsCall(
     BOOLEAN         Isx86_64,
     PUINT32         CallLength)
 {
-    ZydisDecoder            decoder;
-    ZydisFormatter          formatter;
-    ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
-    UINT64                  CurrentRip    = 0;
-    int                     instr_decoded = 0;
     ZydisDecodedInstruction instruction;
-    char                    buffer[256];
-    UINT32                  MaximumInstrDecoded = 1;
 
     //
     // Default length
     //
     *CallLength = 0;
 
-    if (ZydisGetVersion() != ZYDIS_VERSION)
-    {
-        ShowMessages("invalid zydis version\n");
-        return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
-    }
-
-    if (Isx86_64)
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-    }
-    else
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-    }
-
-    ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
-
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
-
     //
-    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
-    // formats the absolute addresses
+    // Only the mnemonic and the length are needed
     //
-    default_print_address_absolute =
-        (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsolute;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
-
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, BufferToDisassemble, BuffLength, &instruction, operands)))
+    if (DisassemblerDecodeMinimal(BufferToDisassemble, BuffLength, Isx86_64, &instruction))
     {
-        //
-        // We have to pass a `runtime_address` different to
-        // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
-        //
-
-        ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
-
         if (instruction.mnemonic == ZydisMnemonic::ZYDIS_MNEMONIC_CALL)
         {
             //
@@ -858,50 +1044,13 @@ HyperDbgLengthDisassemblerEngine(
     UINT64          BuffLength,
     BOOLEAN         Isx86_64)
 {
-    ZydisDecoder            decoder;
-    ZydisFormatter          formatter;
-    ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
-    UINT64                  CurrentRip    = 0;
-    int                     instr_decoded = 0;
     ZydisDecodedInstruction instruction;
-    UINT32                  MaximumInstrDecoded = 1;
-
-    if (ZydisGetVersion() != ZYDIS_VERSION)
-    {
-        ShowMessages("invalid Zydis version\n");
-        return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
-    }
-
-    if (Isx86_64)
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-    }
-    else
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-    }
-
-    ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
-
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
 
     //
-    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
-    // formats the absolute addresses
+    // Only the length is needed
     //
-    default_print_address_absolute =
-        (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsolute;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
-
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, BufferToDisassemble, BuffLength, &instruction, operands)))
+    if (DisassemblerDecodeMinimal(BufferToDisassemble, BuffLength, Isx86_64, &instruction))
     {
-        //
-        // We have to pass a `runtime_address` different to
-        // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
-        //
-        // ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
-
         //
         // Return len of buffer
         //
@@ -914,60 +1063,6 @@ HyperDbgLengthDisassemblerEngine(
     return 0;
 }
 
-/**
- * @brief Print addresses
- *
- * @param formatter
- * @param buffer
- * @param context
- * @return ZyanStatus
- */
-static ZyanStatus
-ZydisFormatterPrintAddressAbsoluteForTrackingInstructions(const ZydisFormatter *  formatter,
-                                                          ZydisFormatterBuffer *  buffer,
-                                                          ZydisFormatterContext * context)
-{
-    ZyanU64                                                address;
-    std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION>::iterator Iterate;
-
-    ZYAN_CHECK(ZydisCalcAbsoluteAddress(context->instruction, context->operand, context->runtime_address, &address));
-
-    //
-    // Apply addressconversion of settings here
-    //
-    if (g_AddressConversion)
-    {
-        //
-        // Check to find the symbol of address
-        //
-        Iterate = g_DisassemblerSymbolMap.find(address);
-
-        if (Iterate != g_DisassemblerSymbolMap.end())
-        {
-            ZYAN_CHECK(ZydisFormatterBufferAppend(buffer, ZYDIS_TOKEN_SYMBOL));
-            ZyanString * string;
-            ZYAN_CHECK(ZydisFormatterBufferGetString(buffer, &string));
-
-            //
-            // Call the tracker callback (with function name)
-            //
-            CommandTrackHandleReceivedCallInstructions(Iterate->second.ObjectName.c_str(), Iterate->first);
-
-            return ZyanStringAppendFormat(string,
-                                          "<%s (%s)>",
-                                          Iterate->second.ObjectName.c_str(),
-                                          SeparateTo64BitValue(Iterate->first).c_str());
-        }
-    }
-
-    //
-    // Call the tracker callback (without function name)
-    //
-    CommandTrackHandleReceivedCallInstructions(NULL, address);
-
-    return default_print_address_absolute(formatter, buffer, context);
-}
-
 /**
  * @brief Check whether the current instruction is a 'call' or 'ret' or not
  *
@@ -987,43 +1082,16 @@ HyperDbgCheckWhetherTheCurrentInstructionIsCallOrRet(
     BOOLEAN         Isx86_64,
     PBOOLEAN        IsRet)
 {
-    ZydisDecoder            decoder;
-    ZydisFormatter          formatter;
     ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
-    int                     instr_decoded = 0;
     ZydisDecodedInstruction instruction;
     char                    buffer[256];
-    UINT32                  MaximumInstrDecoded = 1;
-
-    if (ZydisGetVersion() != ZYDIS_VERSION)
-    {
-        ShowMessages("invalid zydis version\n");
-        return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
-    }
-
-    if (!Isx86_64)
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-    }
-    else
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-    }
-
-    ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
-
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
 
     //
-    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
-    // formats the absolute addresses
+    // The operands are needed for formatting the target of calls, the
+    // decoded instructions are cached as the same instructions are checked
+    // while tracking loops
     //
-    default_print_address_absolute =
-        (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsoluteForTrackingInstructions;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
-
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, BufferToDisassemble, BuffLength, &instruction, operands)))
+    if (DisassemblerDecode(Isx86_64, CurrentRip, BufferToDisassemble, BuffLength, &instruction, operands))
     {
         if (instruction.mnemonic == ZydisMnemonic::ZYDIS_MNEMONIC_CALL)
         {
@@ -1041,7 +1109,7 @@ HyperDbgCheckWhetherTheCurrentInstructionIsCallOrRet(
             // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
             //
 
-            ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
+            ZydisFormatterFormatInstruction(&g_DisassemblerContext.TrackingFormatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
 
             *IsRet = FALSE;
 
@@ -1098,52 +1166,13 @@ HyperDbgCheckWhetherTheCurrentInstructionIsRet(
     UINT64          BuffLength,
     BOOLEAN         Isx86_64)
 {
-    ZydisDecoder            decoder;
-    ZydisFormatter          formatter;
-    ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
-    UINT64                  CurrentRip    = 0;
-    int                     instr_decoded = 0;
     ZydisDecodedInstruction instruction;
-    char                    buffer[256];
-    UINT32                  MaximumInstrDecoded = 1;
-
-    if (ZydisGetVersion() != ZYDIS_VERSION)
-    {
-        ShowMessages("invalid zydis version\n");
-        return DEBUGGER_CONDITIONAL_JUMP_STATUS_ERROR;
-    }
-
-    if (Isx86_64)
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
-    }
-    else
-    {
-        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_COMPAT_32, ZYDIS_STACK_WIDTH_32);
-    }
-
-    ZydisFormatterInit(&formatter, ZYDIS_FORMATTER_STYLE_INTEL);
-
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SEGMENT, ZYAN_TRUE);
-    ZydisFormatterSetProperty(&formatter, ZYDIS_FORMATTER_PROP_FORCE_SIZE, ZYAN_TRUE);
 
     //
-    // Replace the `ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS` function that
-    // formats the absolute addresses
+    // Only the mnemonic is needed
     //
-    default_print_address_absolute =
-        (ZydisFormatterFunc)&ZydisFormatterPrintAddressAbsolute;
-    ZydisFormatterSetHook(&formatter, ZYDIS_FORMATTER_FUNC_PRINT_ADDRESS_ABS, (const void **)&default_print_address_absolute);
-
-    while (ZYAN_SUCCESS(ZydisDecoderDecodeFull(&decoder, BufferToDisassemble, BuffLength, &instruction, operands)))
+    if (DisassemblerDecodeMinimal(BufferToDisassemble, BuffLength, Isx86_64, &instruction))
     {
-        //
-        // We have to pass a `runtime_address` different to
-        // `ZYDIS_RUNTIME_ADDRESS_NONE` to enable printing of absolute addresses
-        //
-
-        ZydisFormatterFormatInstruction(&formatter, &instruction, operands, instruction.operand_count_visible, &buffer[0], sizeof(buffer), (ZyanU64)CurrentRip, ZYAN_NULL);
-
         if (instruction.mnemonic == ZydisMnemonic::ZYDIS_MNEMONIC_RET)
         {
             //
@@ -1171,3 +1200,116 @@ HyperDbgCheckWhetherTheCurrentInstructionIsRet(
     //
     return FALSE;
 }
+
+/**
+ * @brief Show the effective addresses of the memory operands of an instruction
+ * @details The addresses are computed from the registers before executing the
+ * instruction, the base of the segments (e.g., fs and gs) is not added
+ *
+ * @param BufferToDisassemble Current Bytes of assembly
+ * @param BuffLength Length of buffer
+ * @param CurrentRip Address of the instruction
+ * @param Isx86_64 Whether it's an x86 or x64
+ * @param Registers Registers before executing the instruction
+ *
+ * @return UINT32 Count of memory operands
+ */
+UINT32
+HyperDbgShowMemoryOperandsOfInstruction(
+    unsigned char *    BufferToDisassemble,
+    UINT64             BuffLength,
+    UINT64             CurrentRip,
+    BOOLEAN            Isx86_64,
+    const GUEST_REGS * Registers)
+{
+    ZydisDecodedInstruction instruction;
+    ZydisDecodedOperand     operands[ZYDIS_MAX_OPERAND_COUNT];
+    const UINT64 *          RegisterValues        = (const UINT64 *)Registers;
+    UINT32                  CountOfMemoryOperands = 0;
+
+    if (!DisassemblerDecode(Isx86_64, CurrentRip, BufferToDisassemble, BuffLength, &instruction, operands))
+    {
+        return 0;
+    }
+
+    for (UINT32 i = 0; i < instruction.operand_count; i++)
+    {
+        const ZydisDecodedOperand * Operand = &operands[i];
+        ZydisRegister               Base;
+        ZydisRegister               Index;
+        UINT64                      Address;
+        const char *                Segment;
+
+        //
+        // Address generations (e.g., lea) don't access the memory
+        //
+        if (Operand->type != ZYDIS_OPERAND_TYPE_MEMORY || Operand->mem.type != ZYDIS_MEMOP_TYPE_MEM)
+        {
+            continue;
+        }
+
+        Base    = ZydisRegisterGetLargestEnclosing(ZYDIS_MACHINE_MODE_LONG_64, Operand->mem.base);
+        Index   = ZydisRegisterGetLargestEnclosing(ZYDIS_MACHINE_MODE_LONG_64, Operand->mem.index);
+        Address = (UINT64)Operand->mem.disp.value;
+
+        if (Base == ZYDIS_REGISTER_RIP)
+        {
+            Address += CurrentRip + instruction.length;
+        }
+        else if (Base >= ZYDIS_REGISTER_RAX && Base <= ZYDIS_REGISTER_R15)
+        {
+            //
+            // General-purpose registers have the same order as GUEST_REGS
+            //
+            Address += RegisterValues[Base - ZYDIS_REGISTER_RAX];
+        }
+        else if (Base != ZYDIS_REGISTER_NONE)
+        {
+            continue;
+        }
+
+        if (Index >= ZYDIS_REGISTER_RAX && Index <= ZYDIS_REGISTER_R15)
+        {
+            Address += RegisterValues[Index - ZYDIS_REGISTER_RAX] * Operand->mem.scale;
+        }
+        else if (Index != ZYDIS_REGISTER_NONE)
+        {
+            //
+            // Vector indexes (VSIB) are not computed
+            //
+            continue;
+        }
+
+        if (!Isx86_64)
+        {
+            Address &= 0xffffffff;
+        }
+
+        //
+        // Only the fs and gs segments have a base in 64-bit mode
+        //
+        if (Operand->mem.segment == ZYDIS_REGISTER_FS)
+        {
+            Segment = "fs:";
+        }
+        else if (Operand->mem.segment == ZYDIS_REGISTER_GS)
+        {
+            Segment = "gs:";
+        }
+        else
+        {
+            Segment = "";
+        }
+
+        ShowMessages("    %s%s %s[%s] (0x%x bytes)\n",
+                     (Operand->actions & ZYDIS_OPERAND_ACTION_MASK_READ) ? "r" : "-",
+                     (Operand->actions & ZYDIS_OPERAND_ACTION_MASK_WRITE) ? "w" : "-",
+                     Segment,
+                     SeparateTo64BitValue(Address).c_str(),
+                     Operand->size / 8);
+
+        CountOfMemoryOperands++;
+    }
+
+    return CountOfMemoryOperands;
+}
@@ -0,0 +1,595 @@
+/**
+ * @file dump-file.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Raw and sparse dump files (batching, page map, and resuming)
+ * @details The pages of the dumped range are read in batches and appended to
+ * write buffers, each buffer is written while the next pages are read and its
+ * pages are committed (the page map and the header of sparse files) once the
+ * write is completed, so an interrupted dump could be resumed from the last
+ * committed page.
+ *
+ * Reading the pages and writing the file is up to the .dump command (dump.cpp),
+ * so this file only uses the C runtime and the STL, and it's portable
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Fill the header of the dump for the range
+ * @details The type of memory, the process id, and the format (sparse and
+ * incremental) should be filled in the context
+ *
+ * @param Context The dump context
+ * @param StartAddress Start address of the range
+ * @param EndAddress End address of the range
+ *
+ * @return VOID
+ */
+VOID
+CommandDumpInitializeHeader(PDUMP_CONTEXT Context, UINT64 StartAddress, UINT64 EndAddress)
+{
+    Context->Header.Magic        = DUMP_SPARSE_FILE_MAGIC;
+    Context->Header.Version      = DUMP_SPARSE_FILE_VERSION;
+    Context->Header.HeaderSize   = sizeof(DUMP_SPARSE_FILE_HEADER);
+    Context->Header.StartAddress = StartAddress;
+    Context->Header.EndAddress   = EndAddress;
+    Context->Header.MemoryType   = Context->MemoryType;
+    Context->Header.ProcessId    = Context->Pid;
+    Context->Header.CountOfPages = ((EndAddress - StartAddress) + PAGE_SIZE - 1) / PAGE_SIZE;
+    Context->Header.Flags        = Context->IsIncremental ? DUMP_SPARSE_FILE_FLAG_INCREMENTAL : 0;
+}
+
+/**
+ * @brief Start a new sparse dump file
+ * @details The page map is reserved right after the header and the content
+ * of pages starts at the first page after the page map, the header should be
+ * written into the file by the caller
+ *
+ * @param Context The dump context (the header should be initialized)
+ *
+ * @return VOID
+ */
+VOID
+CommandDumpInitializeSparseFile(PDUMP_CONTEXT Context)
+{
+    UINT64 PageMapSize = ((Context->Header.CountOfPages * sizeof(UINT64)) + PAGE_SIZE - 1) & ~((UINT64)PAGE_SIZE - 1);
+
+    Context->PageMap.assign((SIZE_T)Context->Header.CountOfPages, DUMP_PAGE_MAP_ENTRY_NOT_DUMPED);
+
+    Context->Header.PageMapOffset  = DUMP_SPARSE_PAGE_MAP_OFFSET;
+    Context->Header.DataOffset     = DUMP_SPARSE_PAGE_MAP_OFFSET + PageMapSize;
+    Context->Header.NextDataOffset = Context->Header.DataOffset;
+
+    Context->NextPageIndex  = Context->Header.NextPageIndex;
+    Context->NextFileOffset = Context->Header.NextDataOffset;
+}
+
+/**
+ * @brief Continue a sparse dump file from its last committed page
+ * @details The dumps of the first version (non-incremental) are also resumed
+ * and the header of these files is kept in the same version
+ *
+ * @param Context The dump context (the header should be initialized)
+ * @param PreviousHeader The header that is read from the file
+ * @param BytesRead Number of bytes of the header that are read from the file
+ *
+ * @return BOOLEAN FALSE if the file is not a sparse dump of the same range
+ */
+BOOLEAN
+CommandDumpResumeSparseFile(PDUMP_CONTEXT Context, DUMP_SPARSE_FILE_HEADER * PreviousHeader, UINT32 BytesRead)
+{
+    if (BytesRead < DUMP_SPARSE_FILE_HEADER_SIZE_V1 ||
+        PreviousHeader->Magic != DUMP_SPARSE_FILE_MAGIC ||
+        !((PreviousHeader->Version == DUMP_SPARSE_FILE_VERSION && PreviousHeader->HeaderSize == sizeof(DUMP_SPARSE_FILE_HEADER) && BytesRead == sizeof(DUMP_SPARSE_FILE_HEADER)) ||
+          (PreviousHeader->Version == DUMP_SPARSE_FILE_VERSION_1 && PreviousHeader->HeaderSize == DUMP_SPARSE_FILE_HEADER_SIZE_V1)) ||
+        PreviousHeader->StartAddress != Context->Header.StartAddress ||
+        PreviousHeader->EndAddress != Context->Header.EndAddress ||
+        PreviousHeader->MemoryType != Context->Header.MemoryType ||
+        PreviousHeader->CountOfPages != Context->Header.CountOfPages ||
+        PreviousHeader->NextPageIndex > PreviousHeader->CountOfPages)
+    {
+        return FALSE;
+    }
+
+    if (PreviousHeader->Version == DUMP_SPARSE_FILE_VERSION_1)
+    {
+        PreviousHeader->CountOfUnchangedPages = 0;
+        PreviousHeader->Flags                 = 0;
+        PreviousHeader->Reserved              = 0;
+    }
+
+    //
+    // The process id is not compared as the default process might be changed
+    //
+    Context->Header = *PreviousHeader;
+
+    Context->PageMap.assign((SIZE_T)Context->Header.CountOfPages, DUMP_PAGE_MAP_ENTRY_NOT_DUMPED);
+
+    Context->NextPageIndex  = Context->Header.NextPageIndex;
+    Context->NextFileOffset = Context->Header.NextDataOffset;
+
+    return TRUE;
+}
+
+/**
+ * @brief Continue a raw dump file from its last complete page
+ *
+ * @param Context The dump context (the header should be initialized)
+ * @param FileSize Size of the previous dump file
+ *
+ * @return BOOLEAN FALSE if the file is larger than the range
+ */
+BOOLEAN
+CommandDumpResumeRawFile(PDUMP_CONTEXT Context, UINT64 FileSize)
+{
+    if (FileSize > Context->Header.EndAddress - Context->Header.StartAddress)
+    {
+        return FALSE;
+    }
+
+    Context->NextPageIndex  = FileSize / PAGE_SIZE;
+    Context->NextFileOffset = Context->NextPageIndex * PAGE_SIZE;
+
+    Context->Header.NextPageIndex  = Context->NextPageIndex;
+    Context->Header.NextDataOffset = Context->NextFileOffset;
+
+    return TRUE;
+}
+
+/**
+ * @brief Check whether the page is entirely filled with zero or not
+ *
+ * @param PageBuffer The content of the page
+ * @param Size Size of the page
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpIsZeroPage(BYTE * PageBuffer, UINT32 Size)
+{
+    UINT64 Word;
+    UINT32 Index = 0;
+
+    //
+    // Check 64-bit words and then the remaining bytes (the buffer might not
+    // be aligned, so words are copied and compiled as unaligned loads)
+    //
+    for (; Index + sizeof(UINT64) <= Size; Index += sizeof(UINT64))
+    {
+        memcpy(&Word, PageBuffer + Index, sizeof(UINT64));
+
+        if (Word != 0)
+        {
+            return FALSE;
+        }
+    }
+
+    for (; Index < Size; Index++)
+    {
+        if (PageBuffer[Index] != 0)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Start filling a write buffer from the next page
+ *
+ * @param Context The dump context
+ * @param Index Index of the write buffer
+ *
+ * @return VOID
+ */
+VOID
+CommandDumpResetWriteBuffer(PDUMP_CONTEXT Context, UINT32 Index)
+{
+    PDUMP_WRITE_BUFFER WriteBuffer = &Context->WriteBuffers[Index];
+
+    WriteBuffer->UsedSize               = 0;
+    WriteBuffer->FileOffset             = Context->NextFileOffset;
+    WriteBuffer->EndPageIndex           = Context->NextPageIndex;
+    WriteBuffer->CountOfPresentPages    = 0;
+    WriteBuffer->CountOfZeroPages       = 0;
+    WriteBuffer->CountOfUnreadablePages = 0;
+    WriteBuffer->CountOfUnchangedPages  = 0;
+}
+
+/**
+ * @brief Wait for the pending write of a buffer and commit its pages
+ * @details Committing pages means updating the page map and the header
+ * (in sparse files) so the committed pages are never lost if the dump
+ * is interrupted. Buffers should be completed in the same order that
+ * they're flushed
+ *
+ * @param Context The dump context
+ * @param Index Index of the write buffer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpCompleteWriteBuffer(PDUMP_CONTEXT Context, UINT32 Index)
+{
+    PDUMP_WRITE_BUFFER WriteBuffer    = &Context->WriteBuffers[Index];
+    UINT64             FirstPageIndex = Context->Header.NextPageIndex;
+
+    if (!WriteBuffer->IsPending)
+    {
+        return TRUE;
+    }
+
+    WriteBuffer->IsPending = FALSE;
+
+    //
+    // Wait for the content of the pages to be written
+    //
+    if (WriteBuffer->UsedSize != 0 && !CommandDumpWaitForWrite(Context, WriteBuffer))
+    {
+        return FALSE;
+    }
+
+    //
+    // Commit the pages
+    //
+    Context->Header.NextPageIndex  = WriteBuffer->EndPageIndex;
+    Context->Header.NextDataOffset = WriteBuffer->FileOffset + WriteBuffer->UsedSize;
+
+    Context->Header.CountOfPresentPages += WriteBuffer->CountOfPresentPages;
+    Context->Header.CountOfZeroPages += WriteBuffer->CountOfZeroPages;
+    Context->Header.CountOfUnreadablePages += WriteBuffer->CountOfUnreadablePages;
+    Context->Header.CountOfUnchangedPages += WriteBuffer->CountOfUnchangedPages;
+
+    if (!Context->IsSparse)
+    {
+        return TRUE;
+    }
+
+    if (WriteBuffer->EndPageIndex > FirstPageIndex &&
+        !CommandDumpWriteMetadata(Context,
+                                  Context->Header.PageMapOffset + (FirstPageIndex * sizeof(UINT64)),
+                                  &Context->PageMap[(SIZE_T)FirstPageIndex],
+                                  (UINT32)((WriteBuffer->EndPageIndex - FirstPageIndex) * sizeof(UINT64))))
+    {
+        return FALSE;
+    }
+
+    return CommandDumpWriteMetadata(Context, 0, &Context->Header, Context->Header.HeaderSize);
+}
+
+/**
+ * @brief Start writing the current buffer and switch to the next buffer
+ * @details The write is performed asynchronously so the next pages are
+ * read while the previous pages are being written
+ *
+ * @param Context The dump context
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpFlushWriteBuffer(PDUMP_CONTEXT Context)
+{
+    PDUMP_WRITE_BUFFER WriteBuffer = &Context->WriteBuffers[Context->CurrentWriteBuffer];
+
+    if (WriteBuffer->UsedSize != 0 && !CommandDumpStartWrite(Context, WriteBuffer))
+    {
+        return FALSE;
+    }
+
+    WriteBuffer->IsPending = TRUE;
+
+    //
+    // The next buffer is the oldest one, wait for it to be written
+    //
+    Context->CurrentWriteBuffer = (Context->CurrentWriteBuffer + 1) % DUMP_WRITE_BUFFER_COUNT;
+
+    if (!CommandDumpCompleteWriteBuffer(Context, Context->CurrentWriteBuffer))
+    {
+        return FALSE;
+    }
+
+    CommandDumpResetWriteBuffer(Context, Context->CurrentWriteBuffer);
+
+    return TRUE;
+}
+
+/**
+ * @brief Append the next page to the dump
+ *
+ * @param Context The dump context
+ * @param PageBuffer The content of the page (ignored if the page is not readable)
+ * @param Size Size of the page (the last page might be smaller than a page)
+ * @param IsReadable Whether the page was read or not
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpAppendPage(PDUMP_CONTEXT Context, BYTE * PageBuffer, UINT32 Size, BOOLEAN IsReadable)
+{
+    PDUMP_WRITE_BUFFER WriteBuffer = &Context->WriteBuffers[Context->CurrentWriteBuffer];
+
+    //
+    // Check if the current buffer is full
+    //
+    if (WriteBuffer->UsedSize + PAGE_SIZE > DUMP_WRITE_BUFFER_SIZE)
+    {
+        if (!CommandDumpFlushWriteBuffer(Context))
+        {
+            return FALSE;
+        }
+
+        WriteBuffer = &Context->WriteBuffers[Context->CurrentWriteBuffer];
+    }
+
+    if (Context->IsSparse)
+    {
+        if (!IsReadable)
+        {
+            Context->PageMap[(SIZE_T)Context->NextPageIndex] = DUMP_PAGE_MAP_ENTRY_UNREADABLE_PAGE;
+            WriteBuffer->CountOfUnreadablePages++;
+        }
+        else if (CommandDumpIsZeroPage(PageBuffer, Size))
+        {
+            Context->PageMap[(SIZE_T)Context->NextPageIndex] = DUMP_PAGE_MAP_ENTRY_ZERO_PAGE;
+            WriteBuffer->CountOfZeroPages++;
+        }
+        else
+        {
+            //
+            // Pages are saved as complete pages so they remain page-aligned in the file
+            //
+            memcpy(WriteBuffer->Buffer + WriteBuffer->UsedSize, PageBuffer, Size);
+            ZeroMemory(WriteBuffer->Buffer + WriteBuffer->UsedSize + Size, PAGE_SIZE - Size);
+
+            Context->PageMap[(SIZE_T)Context->NextPageIndex] = Context->NextFileOffset;
+            WriteBuffer->CountOfPresentPages++;
+
+            WriteBuffer->UsedSize += PAGE_SIZE;
+            Context->NextFileOffset += PAGE_SIZE;
+        }
+    }
+    else
+    {
+        //
+        // Unreadable pages are filled with zeros to keep the offsets of the raw file
+        //
+        if (IsReadable)
+        {
+            memcpy(WriteBuffer->Buffer + WriteBuffer->UsedSize, PageBuffer, Size);
+            WriteBuffer->CountOfPresentPages++;
+        }
+        else
+        {
+            ZeroMemory(WriteBuffer->Buffer + WriteBuffer->UsedSize, Size);
+            WriteBuffer->CountOfUnreadablePages++;
+        }
+
+        WriteBuffer->UsedSize += Size;
+        Context->NextFileOffset += Size;
+    }
+
+    Context->NextPageIndex++;
+    WriteBuffer->EndPageIndex = Context->NextPageIndex;
+
+    return TRUE;
+}
+
+/**
+ * @brief Append the next page to the dump as an unchanged page
+ * @details Only used in the incremental dumps, the content of the page
+ * is not read and nothing is written into the data of the file
+ *
+ * @param Context The dump context
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpAppendUnchangedPage(PDUMP_CONTEXT Context)
+{
+    PDUMP_WRITE_BUFFER WriteBuffer = &Context->WriteBuffers[Context->CurrentWriteBuffer];
+
+    Context->PageMap[(SIZE_T)Context->NextPageIndex] = DUMP_PAGE_MAP_ENTRY_UNCHANGED_PAGE;
+    WriteBuffer->CountOfUnchangedPages++;
+
+    Context->NextPageIndex++;
+    WriteBuffer->EndPageIndex = Context->NextPageIndex;
+
+    return TRUE;
+}
+
+/**
+ * @brief Read a batch of pages and append them to the dump
+ * @details Pages are requested in batches to reduce the number of the round-trips
+ * to the debuggee, if the batch couldn't be read then its pages are read one by
+ * one to find the unreadable pages
+ *
+ * @param Context The dump context
+ * @param Address Address of the first page of the batch
+ * @param Size Size of the batch
+ *
+ * @return BOOLEAN FALSE if the dump should be stopped
+ */
+BOOLEAN
+CommandDumpReadAndAppendBatch(PDUMP_CONTEXT Context, UINT64 Address, UINT32 Size)
+{
+    UINT32  PageSize;
+    BOOLEAN IsReadable;
+    BOOLEAN IsConnectionLost = FALSE;
+    BYTE *  Data             = ((BYTE *)Context->ReadRequest) + sizeof(DEBUGGER_READ_MEMORY);
+
+    if (CommandDumpReadPages(Context, Address, Size, &IsConnectionLost))
+    {
+        for (UINT32 Offset = 0; Offset < Size; Offset += PAGE_SIZE)
+        {
+            PageSize = (Size - Offset >= PAGE_SIZE) ? PAGE_SIZE : Size - Offset;
+
+            if (!CommandDumpAppendPage(Context, Data + Offset, PageSize, TRUE))
+            {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+
+    if (IsConnectionLost)
+    {
+        return FALSE;
+    }
+
+    //
+    // At least one of the pages is not readable
+    //
+    for (UINT32 Offset = 0; Offset < Size; Offset += PAGE_SIZE)
+    {
+        PageSize   = (Size - Offset >= PAGE_SIZE) ? PAGE_SIZE : Size - Offset;
+        IsReadable = CommandDumpReadPages(Context, Address + Offset, PageSize, &IsConnectionLost);
+
+        if (IsConnectionLost || !CommandDumpAppendPage(Context, Data, PageSize, IsReadable))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Mark the collected dirty pages of the range
+ * @details The bitmap of the dirty pages (DirtyPages) should be allocated
+ * for the range
+ *
+ * @param Context The dump context
+ * @param Entries The collected entries
+ * @param CountOfEntries Number of the entries
+ *
+ * @return UINT64 Number of the marked pages that are in the range
+ */
+UINT64
+CommandDumpMarkDirtyPages(PDUMP_CONTEXT Context, PDEBUGGER_DIRTY_PAGES_ENTRY Entries, UINT32 CountOfEntries)
+{
+    UINT64 Bits;
+    UINT64 PageIndex;
+    ULONG  Bit;
+    UINT64 CountOfDirtyPages    = 0;
+    UINT64 FirstPageFrameNumber = Context->Header.StartAddress / PAGE_SIZE;
+
+    for (UINT32 i = 0; i < CountOfEntries; i++)
+    {
+        Bits = Entries[i].Bitmap;
+
+        while (Bits != 0)
+        {
+            _BitScanForward64(&Bit, Bits);
+            Bits &= Bits - 1;
+
+            PageIndex = Entries[i].FirstPageFrameNumber + Bit - FirstPageFrameNumber;
+
+            if (PageIndex < Context->Header.CountOfPages)
+            {
+                Context->DirtyPages[(SIZE_T)(PageIndex / 64)] |= 1ull << (PageIndex % 64);
+                CountOfDirtyPages++;
+            }
+        }
+    }
+
+    return CountOfDirtyPages;
+}
+
+/**
+ * @brief Check whether a page of the range is modified or not
+ *
+ * @param Context The dump context
+ * @param PageIndex Index of the page in the range
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpIsDirtyPage(PDUMP_CONTEXT Context, UINT64 PageIndex)
+{
+    return (Context->DirtyPages[(SIZE_T)(PageIndex / 64)] & (1ull << (PageIndex % 64))) != 0;
+}
+
+/**
+ * @brief Dump the next batch of pages
+ * @details In the incremental dumps, the unchanged pages are skipped and only
+ * the consecutive modified pages are read in one batch
+ *
+ * @param Context The dump context
+ *
+ * @return BOOLEAN FALSE if the dump should be stopped
+ */
+BOOLEAN
+CommandDumpNextBatch(PDUMP_CONTEXT Context)
+{
+    UINT64 BatchPages;
+    UINT64 Length    = Context->Header.EndAddress - Context->Header.StartAddress;
+    UINT64 BatchSize = Length - (Context->NextPageIndex * PAGE_SIZE);
+
+    if (BatchSize > DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE)
+    {
+        BatchSize = DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE;
+    }
+
+    if (Context->IsIncremental)
+    {
+        if (!CommandDumpIsDirtyPage(Context, Context->NextPageIndex))
+        {
+            return CommandDumpAppendUnchangedPage(Context);
+        }
+
+        //
+        // Only the consecutive modified pages are read in one batch
+        //
+        BatchPages = 1;
+
+        while (BatchPages * PAGE_SIZE < BatchSize && CommandDumpIsDirtyPage(Context, Context->NextPageIndex + BatchPages))
+        {
+            BatchPages++;
+        }
+
+        if (BatchPages * PAGE_SIZE < BatchSize)
+        {
+            BatchSize = BatchPages * PAGE_SIZE;
+        }
+    }
+
+    return CommandDumpReadAndAppendBatch(Context,
+                                         Context->Header.StartAddress + (Context->NextPageIndex * PAGE_SIZE),
+                                         (UINT32)BatchSize);
+}
+
+/**
+ * @brief Write the remaining pages and wait for all of the buffers
+ *
+ * @param Context The dump context
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpFinalize(PDUMP_CONTEXT Context)
+{
+    if (!CommandDumpFlushWriteBuffer(Context))
+    {
+        return FALSE;
+    }
+
+    //
+    // Complete the buffers from the oldest to the newest one
+    //
+    for (UINT32 i = 1; i <= DUMP_WRITE_BUFFER_COUNT; i++)
+    {
+        if (!CommandDumpCompleteWriteBuffer(Context, (Context->CurrentWriteBuffer + i) % DUMP_WRITE_BUFFER_COUNT))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -330,12 +330,6 @@ HyperDbgShowMemoryOrDisassemble(DEBUGGER_SHOW_MEMORY_STYLE   Style,
 
         break;
 
-    case DEBUGGER_SHOW_COMMAND_DUMP:
-
-        CommandDumpSaveIntoFile(Buffer, Size);
-
-        break;
-
     case DEBUGGER_SHOW_COMMAND_DISASSEMBLE64:
 
         //
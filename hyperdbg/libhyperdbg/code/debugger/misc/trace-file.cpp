@@ -0,0 +1,1144 @@
+/**
+ * @file trace-file.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Binary execution trace files (writer, reader, and analysis)
+ * @details A trace file is a header, then chunks of records, then an index of
+ * the chunks and a footer. Each chunk holds the records of one core and is a
+ * sync point (the RIPs and the registers are delta-encoded from the start of
+ * the chunk), so chunks can be decoded independently. If the index is missing
+ * (e.g., the file is truncated) the index is rebuilt by scanning the chunks.
+ *
+ * This file only uses the C runtime and the STL, so it's portable
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// 64-bit offsets of files
+//
+#ifdef _WIN32
+#    define TraceFileSeek _fseeki64
+#    define TraceFileTell _ftelli64
+#else
+#    define TraceFileSeek fseeko
+#    define TraceFileTell ftello
+#endif
+
+/**
+ * @brief Append a variable-length (LEB128) integer
+ *
+ * @param Buffer
+ * @param Value
+ *
+ * @return VOID
+ */
+static VOID
+TraceFileWriteVarint(std::vector<BYTE> & Buffer, UINT64 Value)
+{
+    while (Value >= 0x80)
+    {
+        Buffer.push_back((BYTE)(Value | 0x80));
+        Value >>= 7;
+    }
+
+    Buffer.push_back((BYTE)Value);
+}
+
+/**
+ * @brief Read a variable-length (LEB128) integer
+ *
+ * @param Buffer
+ * @param Size
+ * @param Offset
+ * @param Value
+ *
+ * @return BOOLEAN FALSE if the integer exceeds the buffer
+ */
+static BOOLEAN
+TraceFileReadVarint(const BYTE * Buffer, UINT32 Size, UINT32 * Offset, UINT64 * Value)
+{
+    UINT64 Result = 0;
+    UINT32 Shift  = 0;
+
+    while (*Offset < Size && Shift < 64)
+    {
+        BYTE Current = Buffer[(*Offset)++];
+
+        Result |= (UINT64)(Current & 0x7f) << Shift;
+
+        if ((Current & 0x80) == 0)
+        {
+            *Value = Result;
+            return TRUE;
+        }
+
+        Shift += 7;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Append the signed difference of two values (zigzag encoding)
+ *
+ * @param Buffer
+ * @param Value
+ * @param PreviousValue
+ *
+ * @return VOID
+ */
+static VOID
+TraceFileWriteDelta(std::vector<BYTE> & Buffer, UINT64 Value, UINT64 PreviousValue)
+{
+    INT64 Delta = (INT64)(Value - PreviousValue);
+
+    TraceFileWriteVarint(Buffer, ((UINT64)Delta << 1) ^ (UINT64)(Delta >> 63));
+}
+
+/**
+ * @brief Read the signed difference of two values (zigzag encoding)
+ *
+ * @param Buffer
+ * @param Size
+ * @param Offset
+ * @param PreviousValue
+ * @param Value
+ *
+ * @return BOOLEAN FALSE if the integer exceeds the buffer
+ */
+static BOOLEAN
+TraceFileReadDelta(const BYTE * Buffer, UINT32 Size, UINT32 * Offset, UINT64 PreviousValue, UINT64 * Value)
+{
+    UINT64 Encoded;
+
+    if (!TraceFileReadVarint(Buffer, Size, Offset, &Encoded))
+    {
+        return FALSE;
+    }
+
+    *Value = PreviousValue + ((Encoded >> 1) ^ (0 - (Encoded & 1)));
+
+    return TRUE;
+}
+
+/**
+ * @brief Write the records of a stream as a chunk
+ *
+ * @param Writer
+ * @param Stream
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TraceFileWriterFlushStream(PTRACE_FILE_WRITER Writer, PTRACE_FILE_STREAM Stream)
+{
+    TRACE_FILE_CHUNK_HEADER ChunkHeader = {0};
+    TRACE_FILE_INDEX_ENTRY  IndexEntry  = {0};
+
+    if (Stream->CountOfRecords == 0)
+    {
+        return TRUE;
+    }
+
+    ChunkHeader.Magic             = TRACE_FILE_CHUNK_MAGIC;
+    ChunkHeader.CoreId            = Stream->CoreId;
+    ChunkHeader.RecordType        = (UINT8)Stream->RecordType;
+    ChunkHeader.Compression       = TRACE_FILE_COMPRESSION_NONE;
+    ChunkHeader.Is32Bit           = Stream->Is32Bit;
+    ChunkHeader.RegisterMask      = Stream->RegisterMask;
+    ChunkHeader.CountOfRecords    = Stream->CountOfRecords;
+    ChunkHeader.PayloadSize       = (UINT32)Stream->Payload.size();
+    ChunkHeader.UncompressedSize  = (UINT32)Stream->Payload.size();
+    ChunkHeader.FirstRecordNumber = Stream->FirstRecordNumber;
+
+    IndexEntry.Offset            = Writer->Offset;
+    IndexEntry.FirstRecordNumber = Stream->FirstRecordNumber;
+    IndexEntry.CountOfRecords    = Stream->CountOfRecords;
+    IndexEntry.CoreId            = Stream->CoreId;
+
+    Stream->CountOfRecords = 0;
+
+    if (fwrite(&ChunkHeader, sizeof(TRACE_FILE_CHUNK_HEADER), 1, Writer->File) != 1 ||
+        (!Stream->Payload.empty() && fwrite(Stream->Payload.data(), Stream->Payload.size(), 1, Writer->File) != 1))
+    {
+        return FALSE;
+    }
+
+    Writer->Offset += sizeof(TRACE_FILE_CHUNK_HEADER) + Stream->Payload.size();
+    Writer->Index.push_back(IndexEntry);
+
+    return TRUE;
+}
+
+/**
+ * @brief Create a trace file
+ *
+ * @param Writer
+ * @param Path
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileWriterOpen(PTRACE_FILE_WRITER Writer, const CHAR * Path)
+{
+    TRACE_FILE_HEADER Header = {0};
+
+    Writer->Streams.clear();
+    Writer->Index.clear();
+
+    Writer->File = fopen(Path, "wb");
+
+    if (Writer->File == NULL)
+    {
+        return FALSE;
+    }
+
+    //
+    // Records are written in small pieces
+    //
+    setvbuf(Writer->File, NULL, _IOFBF, 1024 * 1024);
+
+    Header.Magic           = TRACE_FILE_MAGIC;
+    Header.Version         = TRACE_FILE_VERSION;
+    Header.HeaderSize      = sizeof(TRACE_FILE_HEADER);
+    Header.RecordsPerChunk = TRACE_FILE_RECORDS_PER_CHUNK;
+
+    if (fwrite(&Header, sizeof(TRACE_FILE_HEADER), 1, Writer->File) != 1)
+    {
+        fclose(Writer->File);
+        Writer->File = NULL;
+        return FALSE;
+    }
+
+    Writer->Offset = sizeof(TRACE_FILE_HEADER);
+
+    return TRUE;
+}
+
+/**
+ * @brief Add a record to the stream of a core
+ * @details The stream is written as a chunk once it's full, the type of
+ * the records is changed, or the record numbers are not contiguous
+ *
+ * @param Writer
+ * @param CoreId
+ * @param RecordType
+ * @param RegisterMask
+ * @param Is32Bit
+ * @param Record The record (record numbers of each core should be increasing)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileWriterAddRecord(PTRACE_FILE_WRITER              Writer,
+                         UINT32                          CoreId,
+                         DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType,
+                         UINT32                          RegisterMask,
+                         BOOLEAN                         Is32Bit,
+                         const TRACE_FILE_RECORD *       Record)
+{
+    PTRACE_FILE_STREAM Stream;
+    auto               Iterator = Writer->Streams.find(CoreId);
+
+    if (Iterator == Writer->Streams.end())
+    {
+        Stream                   = &Writer->Streams[CoreId];
+        Stream->CoreId           = CoreId;
+        Stream->CountOfRecords   = 0;
+        Stream->NextRecordNumber = 0;
+    }
+    else
+    {
+        Stream = &Iterator->second;
+    }
+
+    //
+    // Chunks of a core shouldn't overlap (they're sorted by the record numbers)
+    //
+    if (Record->RecordNumber < Stream->NextRecordNumber)
+    {
+        return FALSE;
+    }
+
+    if (Stream->CountOfRecords != 0 &&
+        (Stream->CountOfRecords >= TRACE_FILE_RECORDS_PER_CHUNK ||
+         Record->RecordNumber != Stream->NextRecordNumber ||
+         Stream->RecordType != RecordType ||
+         Stream->RegisterMask != RegisterMask ||
+         Stream->Is32Bit != Is32Bit))
+    {
+        if (!TraceFileWriterFlushStream(Writer, Stream))
+        {
+            return FALSE;
+        }
+    }
+
+    if (Stream->CountOfRecords == 0)
+    {
+        //
+        // A new chunk (sync point)
+        //
+        Stream->RecordType        = RecordType;
+        Stream->RegisterMask      = RegisterMask;
+        Stream->Is32Bit           = Is32Bit;
+        Stream->FirstRecordNumber = Record->RecordNumber;
+        Stream->PreviousRip       = 0;
+
+        memset(Stream->PreviousRegisters, 0, sizeof(Stream->PreviousRegisters));
+        Stream->Payload.clear();
+    }
+
+    if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        TraceFileWriteVarint(Stream->Payload, ((UINT64)Record->Depth << 1) | (Record->IsRet ? 1 : 0));
+        TraceFileWriteDelta(Stream->Payload, Record->Rip, Stream->PreviousRip);
+        TraceFileWriteDelta(Stream->Payload, Record->Target, Record->Rip);
+
+        Stream->PreviousRip = Record->Target;
+    }
+    else
+    {
+        TraceFileWriteDelta(Stream->Payload, Record->Rip, Stream->PreviousRip);
+
+        Stream->PreviousRip = Record->Rip;
+
+        for (UINT32 i = 0; i < TRACE_FILE_MAXIMUM_REGISTERS; i++)
+        {
+            if (RegisterMask & (1 << i))
+            {
+                TraceFileWriteDelta(Stream->Payload, Record->Registers[i], Stream->PreviousRegisters[i]);
+
+                Stream->PreviousRegisters[i] = Record->Registers[i];
+            }
+        }
+
+        if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+        {
+            Stream->Payload.insert(Stream->Payload.end(), Record->InstructionBytes, Record->InstructionBytes + MAXIMUM_INSTR_SIZE);
+        }
+    }
+
+    Stream->CountOfRecords++;
+    Stream->NextRecordNumber = Record->RecordNumber + 1;
+
+    return TRUE;
+}
+
+/**
+ * @brief Add the records of a chunk of batched steps (received from the
+ * debuggee)
+ * @details The record numbers are the step numbers of the debuggee, except
+ * in the call/ret records that are numbered in the order of the edges (the
+ * steps without a 'call' or a 'ret' have no record)
+ *
+ * @param Writer
+ * @param Chunk
+ * @param Length Length of the chunk (including the header)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileWriterAddStepTraceChunk(PTRACE_FILE_WRITER Writer, PDEBUGGEE_STEP_TRACE_CHUNK Chunk, UINT32 Length)
+{
+    BYTE *            Records = (BYTE *)Chunk + sizeof(DEBUGGEE_STEP_TRACE_CHUNK);
+    TRACE_FILE_RECORD Record  = {0};
+    UINT32            RegisterMask;
+    UINT32            MinimumSize;
+    UINT64            RecordNumber = Chunk->FirstStepNumber;
+
+    switch (Chunk->RecordType)
+    {
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP:
+        RegisterMask = 0;
+        MinimumSize  = sizeof(UINT64);
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS:
+        RegisterMask = Chunk->RegisterMask & DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+        MinimumSize  = sizeof(UINT64);
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS:
+
+        //
+        // All the registers are saved, then the bytes of the instruction
+        //
+        RegisterMask = DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL;
+        MinimumSize  = sizeof(UINT64) * (1 + TRACE_FILE_MAXIMUM_REGISTERS) + MAXIMUM_INSTR_SIZE;
+        break;
+
+    case DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES:
+        RegisterMask = 0;
+        MinimumSize  = sizeof(DEBUGGEE_STEP_TRACE_EDGE_RECORD);
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    if (Length < sizeof(DEBUGGEE_STEP_TRACE_CHUNK) ||
+        Chunk->RecordSize < MinimumSize ||
+        (UINT64)Chunk->CountOfRecords * Chunk->RecordSize > Length - sizeof(DEBUGGEE_STEP_TRACE_CHUNK))
+    {
+        return FALSE;
+    }
+
+    if (Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        auto Iterator = Writer->Streams.find(Chunk->CoreId);
+
+        RecordNumber = Iterator != Writer->Streams.end() ? Iterator->second.NextRecordNumber : 0;
+    }
+
+    for (UINT32 i = 0; i < Chunk->CountOfRecords; i++)
+    {
+        BYTE *   Current   = Records + (UINT64)i * Chunk->RecordSize;
+        UINT64 * Values    = (UINT64 *)Current;
+        UINT64 * LastValue = (UINT64 *)(Current + Chunk->RecordSize);
+
+        Record.RecordNumber = RecordNumber + i;
+
+        if (Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+        {
+            PDEBUGGEE_STEP_TRACE_EDGE_RECORD EdgeRecord = (PDEBUGGEE_STEP_TRACE_EDGE_RECORD)Current;
+
+            Record.Rip    = EdgeRecord->Address;
+            Record.Target = EdgeRecord->Target;
+            Record.Depth  = EdgeRecord->Depth;
+            Record.IsRet  = EdgeRecord->IsRet;
+        }
+        else
+        {
+            Record.Rip = *Values++;
+
+            //
+            // Registers are saved in the order of the bits of the mask
+            //
+            for (UINT32 j = 0; j < TRACE_FILE_MAXIMUM_REGISTERS; j++)
+            {
+                Record.Registers[j] = 0;
+
+                if ((RegisterMask & (1 << j)) && Values < LastValue)
+                {
+                    Record.Registers[j] = *Values++;
+                }
+            }
+
+            Record.HasInstructionBytes = Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS;
+
+            if (Record.HasInstructionBytes)
+            {
+                memcpy(Record.InstructionBytes, Values, MAXIMUM_INSTR_SIZE);
+            }
+        }
+
+        if (!TraceFileWriterAddRecord(Writer,
+                                      Chunk->CoreId,
+                                      Chunk->RecordType,
+                                      RegisterMask,
+                                      Chunk->Is32Bit,
+                                      &Record))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Write the remaining records, the index and the footer, then close
+ * the trace file
+ *
+ * @param Writer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileWriterClose(PTRACE_FILE_WRITER Writer)
+{
+    TRACE_FILE_FOOTER Footer = {0};
+    BOOLEAN           Result = TRUE;
+
+    if (Writer->File == NULL)
+    {
+        return FALSE;
+    }
+
+    for (auto & Stream : Writer->Streams)
+    {
+        if (!TraceFileWriterFlushStream(Writer, &Stream.second))
+        {
+            Result = FALSE;
+        }
+    }
+
+    Footer.IndexOffset    = Writer->Offset;
+    Footer.CountOfEntries = Writer->Index.size();
+    Footer.Magic          = TRACE_FILE_INDEX_MAGIC;
+
+    if ((!Writer->Index.empty() &&
+         fwrite(Writer->Index.data(), sizeof(TRACE_FILE_INDEX_ENTRY), Writer->Index.size(), Writer->File) != Writer->Index.size()) ||
+        fwrite(&Footer, sizeof(TRACE_FILE_FOOTER), 1, Writer->File) != 1)
+    {
+        Result = FALSE;
+    }
+
+    if (fclose(Writer->File) != 0)
+    {
+        Result = FALSE;
+    }
+
+    Writer->File = NULL;
+    Writer->Streams.clear();
+    Writer->Index.clear();
+
+    return Result;
+}
+
+/**
+ * @brief Read the index of a trace file from its footer
+ *
+ * @param Reader
+ *
+ * @return BOOLEAN FALSE if the file has no valid index
+ */
+static BOOLEAN
+TraceFileReaderReadIndex(PTRACE_FILE_READER Reader)
+{
+    TRACE_FILE_FOOTER Footer;
+
+    if (Reader->FileSize < Reader->Header.HeaderSize + sizeof(TRACE_FILE_FOOTER) ||
+        TraceFileSeek(Reader->File, Reader->FileSize - sizeof(TRACE_FILE_FOOTER), SEEK_SET) != 0 ||
+        fread(&Footer, sizeof(TRACE_FILE_FOOTER), 1, Reader->File) != 1)
+    {
+        return FALSE;
+    }
+
+    if (Footer.Magic != TRACE_FILE_INDEX_MAGIC ||
+        Footer.IndexOffset < Reader->Header.HeaderSize ||
+        Footer.CountOfEntries > (Reader->FileSize - Footer.IndexOffset) / sizeof(TRACE_FILE_INDEX_ENTRY) ||
+        Footer.IndexOffset + Footer.CountOfEntries * sizeof(TRACE_FILE_INDEX_ENTRY) + sizeof(TRACE_FILE_FOOTER) != Reader->FileSize)
+    {
+        return FALSE;
+    }
+
+    Reader->Index.resize((size_t)Footer.CountOfEntries);
+
+    if (TraceFileSeek(Reader->File, Footer.IndexOffset, SEEK_SET) != 0 ||
+        (!Reader->Index.empty() &&
+         fread(Reader->Index.data(), sizeof(TRACE_FILE_INDEX_ENTRY), Reader->Index.size(), Reader->File) != Reader->Index.size()))
+    {
+        Reader->Index.clear();
+        return FALSE;
+    }
+
+    for (auto & Entry : Reader->Index)
+    {
+        if (Entry.Offset < Reader->Header.HeaderSize || Entry.Offset + sizeof(TRACE_FILE_CHUNK_HEADER) > Footer.IndexOffset ||
+            Entry.CountOfRecords > Reader->Header.RecordsPerChunk)
+        {
+            Reader->Index.clear();
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Rebuild the index of a trace file by scanning its chunks
+ * @details The scan stops at the first invalid (or truncated) chunk
+ *
+ * @param Reader
+ *
+ * @return VOID
+ */
+static VOID
+TraceFileReaderRebuildIndex(PTRACE_FILE_READER Reader)
+{
+    TRACE_FILE_CHUNK_HEADER ChunkHeader;
+    TRACE_FILE_INDEX_ENTRY  IndexEntry;
+    UINT64                  Offset = Reader->Header.HeaderSize;
+
+    Reader->Index.clear();
+
+    while (Offset + sizeof(TRACE_FILE_CHUNK_HEADER) <= Reader->FileSize)
+    {
+        if (TraceFileSeek(Reader->File, Offset, SEEK_SET) != 0 ||
+            fread(&ChunkHeader, sizeof(TRACE_FILE_CHUNK_HEADER), 1, Reader->File) != 1 ||
+            ChunkHeader.Magic != TRACE_FILE_CHUNK_MAGIC ||
+            ChunkHeader.CountOfRecords > Reader->Header.RecordsPerChunk ||
+            ChunkHeader.PayloadSize > TRACE_FILE_MAXIMUM_PAYLOAD_SIZE ||
+            Offset + sizeof(TRACE_FILE_CHUNK_HEADER) + ChunkHeader.PayloadSize > Reader->FileSize)
+        {
+            break;
+        }
+
+        IndexEntry.Offset            = Offset;
+        IndexEntry.FirstRecordNumber = ChunkHeader.FirstRecordNumber;
+        IndexEntry.CountOfRecords    = ChunkHeader.CountOfRecords;
+        IndexEntry.CoreId            = ChunkHeader.CoreId;
+
+        Reader->Index.push_back(IndexEntry);
+
+        Offset += sizeof(TRACE_FILE_CHUNK_HEADER) + ChunkHeader.PayloadSize;
+    }
+
+    Reader->IsIndexRebuilt = TRUE;
+}
+
+/**
+ * @brief Open a trace file
+ *
+ * @param Reader
+ * @param Path
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileReaderOpen(PTRACE_FILE_READER Reader, const CHAR * Path)
+{
+    Reader->Index.clear();
+    Reader->ChunksOfCores.clear();
+    Reader->IsIndexRebuilt = FALSE;
+
+    Reader->File = fopen(Path, "rb");
+
+    if (Reader->File == NULL)
+    {
+        return FALSE;
+    }
+
+    if (TraceFileSeek(Reader->File, 0, SEEK_END) != 0 ||
+        (INT64)(Reader->FileSize = TraceFileTell(Reader->File)) < 0 ||
+        TraceFileSeek(Reader->File, 0, SEEK_SET) != 0 ||
+        fread(&Reader->Header, sizeof(TRACE_FILE_HEADER), 1, Reader->File) != 1 ||
+        Reader->Header.Magic != TRACE_FILE_MAGIC ||
+        Reader->Header.Version > TRACE_FILE_VERSION ||
+        Reader->Header.HeaderSize < sizeof(TRACE_FILE_HEADER) ||
+        Reader->Header.RecordsPerChunk == 0 ||
+        Reader->Header.RecordsPerChunk > TRACE_FILE_RECORDS_PER_CHUNK)
+    {
+        TraceFileReaderClose(Reader);
+        return FALSE;
+    }
+
+    if (!TraceFileReaderReadIndex(Reader))
+    {
+        TraceFileReaderRebuildIndex(Reader);
+    }
+
+    //
+    // Chunks of each core are sorted by their record numbers for random access
+    //
+    for (UINT32 i = 0; i < Reader->Index.size(); i++)
+    {
+        Reader->ChunksOfCores[Reader->Index[i].CoreId].push_back(i);
+    }
+
+    for (auto & Chunks : Reader->ChunksOfCores)
+    {
+        std::sort(Chunks.second.begin(), Chunks.second.end(), [Reader](UINT32 First, UINT32 Second) {
+            return Reader->Index[First].FirstRecordNumber < Reader->Index[Second].FirstRecordNumber;
+        });
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Close a trace file
+ *
+ * @param Reader
+ *
+ * @return VOID
+ */
+VOID
+TraceFileReaderClose(PTRACE_FILE_READER Reader)
+{
+    if (Reader->File != NULL)
+    {
+        fclose(Reader->File);
+        Reader->File = NULL;
+    }
+
+    Reader->Index.clear();
+    Reader->ChunksOfCores.clear();
+    Reader->Payload.clear();
+}
+
+/**
+ * @brief Get the minimum size of an encoded record
+ * @details Each delta is at least one byte
+ *
+ * @param RecordType
+ * @param RegisterMask
+ *
+ * @return UINT32
+ */
+static UINT32
+TraceFileGetMinimumRecordSize(UINT8 RecordType, UINT32 RegisterMask)
+{
+    UINT32 Size = 1;
+
+    if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+    {
+        return 3;
+    }
+
+    for (UINT32 i = 0; i < TRACE_FILE_MAXIMUM_REGISTERS; i++)
+    {
+        if (RegisterMask & (1 << i))
+        {
+            Size++;
+        }
+    }
+
+    if (RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+    {
+        Size += MAXIMUM_INSTR_SIZE;
+    }
+
+    return Size;
+}
+
+/**
+ * @brief Read and decode the records of a chunk
+ *
+ * @param Reader
+ * @param IndexOfChunk Index of the chunk in the index of the file
+ * @param ChunkHeader The header of the chunk
+ * @param Records The decoded records
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileReaderReadChunk(PTRACE_FILE_READER               Reader,
+                         UINT32                           IndexOfChunk,
+                         PTRACE_FILE_CHUNK_HEADER         ChunkHeader,
+                         std::vector<TRACE_FILE_RECORD> & Records)
+{
+    UINT32 Offset = 0;
+    UINT64 PreviousRip;
+    UINT64 PreviousRegisters[TRACE_FILE_MAXIMUM_REGISTERS] = {0};
+    UINT64 Value;
+
+    if (IndexOfChunk >= Reader->Index.size() ||
+        TraceFileSeek(Reader->File, Reader->Index[IndexOfChunk].Offset, SEEK_SET) != 0 ||
+        fread(ChunkHeader, sizeof(TRACE_FILE_CHUNK_HEADER), 1, Reader->File) != 1)
+    {
+        return FALSE;
+    }
+
+    //
+    // The count of records is checked before the records are allocated
+    //
+    if (ChunkHeader->Magic != TRACE_FILE_CHUNK_MAGIC ||
+        ChunkHeader->Compression != TRACE_FILE_COMPRESSION_NONE ||
+        ChunkHeader->PayloadSize > TRACE_FILE_MAXIMUM_PAYLOAD_SIZE ||
+        ChunkHeader->RecordType > DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES ||
+        ChunkHeader->CountOfRecords > Reader->Header.RecordsPerChunk ||
+        ChunkHeader->CountOfRecords > ChunkHeader->PayloadSize / TraceFileGetMinimumRecordSize(ChunkHeader->RecordType, ChunkHeader->RegisterMask))
+    {
+        return FALSE;
+    }
+
+    Reader->Payload.resize(ChunkHeader->PayloadSize);
+
+    if (ChunkHeader->PayloadSize != 0 &&
+        fread(Reader->Payload.data(), ChunkHeader->PayloadSize, 1, Reader->File) != 1)
+    {
+        return FALSE;
+    }
+
+    const BYTE * Payload = Reader->Payload.data();
+    UINT32       Size    = ChunkHeader->PayloadSize;
+
+    Records.resize(ChunkHeader->CountOfRecords);
+    PreviousRip = 0;
+
+    for (UINT32 i = 0; i < ChunkHeader->CountOfRecords; i++)
+    {
+        PTRACE_FILE_RECORD Record = &Records[i];
+
+        Record->RecordNumber        = ChunkHeader->FirstRecordNumber + i;
+        Record->HasInstructionBytes = FALSE;
+
+        if (ChunkHeader->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+        {
+            if (!TraceFileReadVarint(Payload, Size, &Offset, &Value) ||
+                !TraceFileReadDelta(Payload, Size, &Offset, PreviousRip, &Record->Rip) ||
+                !TraceFileReadDelta(Payload, Size, &Offset, Record->Rip, &Record->Target))
+            {
+                return FALSE;
+            }
+
+            Record->Depth = (UINT32)(Value >> 1);
+            Record->IsRet = (Value & 1) != 0;
+            PreviousRip   = Record->Target;
+
+            continue;
+        }
+
+        if (!TraceFileReadDelta(Payload, Size, &Offset, PreviousRip, &Record->Rip))
+        {
+            return FALSE;
+        }
+
+        PreviousRip = Record->Rip;
+
+        for (UINT32 j = 0; j < TRACE_FILE_MAXIMUM_REGISTERS; j++)
+        {
+            if (ChunkHeader->RegisterMask & (1 << j))
+            {
+                if (!TraceFileReadDelta(Payload, Size, &Offset, PreviousRegisters[j], &PreviousRegisters[j]))
+                {
+                    return FALSE;
+                }
+            }
+
+            Record->Registers[j] = PreviousRegisters[j];
+        }
+
+        if (ChunkHeader->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS)
+        {
+            if (Offset + MAXIMUM_INSTR_SIZE > Size)
+            {
+                return FALSE;
+            }
+
+            memcpy(Record->InstructionBytes, Payload + Offset, MAXIMUM_INSTR_SIZE);
+            Record->HasInstructionBytes = TRUE;
+            Offset += MAXIMUM_INSTR_SIZE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Find the chunk that contains a record of a core
+ *
+ * @param Reader
+ * @param CoreId
+ * @param RecordNumber
+ * @param IndexOfChunk Index of the chunk in the index of the file
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileReaderFindChunk(PTRACE_FILE_READER Reader, UINT32 CoreId, UINT64 RecordNumber, UINT32 * IndexOfChunk)
+{
+    auto Iterator = Reader->ChunksOfCores.find(CoreId);
+
+    if (Iterator == Reader->ChunksOfCores.end())
+    {
+        return FALSE;
+    }
+
+    //
+    // Find the last chunk that starts before (or at) the record
+    //
+    auto & Chunks = Iterator->second;
+    auto   Chunk  = std::upper_bound(Chunks.begin(), Chunks.end(), RecordNumber, [Reader](UINT64 Number, UINT32 Index) {
+        return Number < Reader->Index[Index].FirstRecordNumber;
+    });
+
+    if (Chunk == Chunks.begin())
+    {
+        return FALSE;
+    }
+
+    Chunk--;
+
+    if (RecordNumber - Reader->Index[*Chunk].FirstRecordNumber >= Reader->Index[*Chunk].CountOfRecords)
+    {
+        return FALSE;
+    }
+
+    *IndexOfChunk = *Chunk;
+
+    return TRUE;
+}
+
+/**
+ * @brief Find the first chunk of a core that starts after (or at) a record
+ * @details Record numbers of the chunks of a core are not contiguous if the
+ * steps are performed on other cores
+ *
+ * @param Reader
+ * @param CoreId
+ * @param RecordNumber
+ * @param IndexOfChunk Index of the chunk in the index of the file
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileReaderFindNextChunk(PTRACE_FILE_READER Reader, UINT32 CoreId, UINT64 RecordNumber, UINT32 * IndexOfChunk)
+{
+    auto Iterator = Reader->ChunksOfCores.find(CoreId);
+
+    if (Iterator == Reader->ChunksOfCores.end())
+    {
+        return FALSE;
+    }
+
+    auto & Chunks = Iterator->second;
+    auto   Chunk  = std::lower_bound(Chunks.begin(), Chunks.end(), RecordNumber, [Reader](UINT32 Index, UINT64 Number) {
+        return Reader->Index[Index].FirstRecordNumber < Number;
+    });
+
+    if (Chunk == Chunks.end())
+    {
+        return FALSE;
+    }
+
+    *IndexOfChunk = *Chunk;
+
+    return TRUE;
+}
+
+/**
+ * @brief Finish the current basic block of a core
+ *
+ * @param Analysis
+ * @param State
+ *
+ * @return VOID
+ */
+static VOID
+TraceFileAnalyzeFinishBlock(PTRACE_FILE_ANALYSIS Analysis, PTRACE_FILE_BLOCK_STATE State)
+{
+    if (!State->IsInBlock)
+    {
+        return;
+    }
+
+    TRACE_FILE_BASIC_BLOCK & Block = Analysis->BasicBlocks[State->Start];
+
+    if (Block.ExecutionCount == 0 || State->CountOfInstructions > Block.CountOfInstructions)
+    {
+        //
+        // Blocks that end in different places are counted under their start
+        //
+        Block.Start               = State->Start;
+        Block.LastInstruction     = State->LastInstruction;
+        Block.CountOfInstructions = State->CountOfInstructions;
+    }
+
+    Block.ExecutionCount++;
+    State->IsInBlock = FALSE;
+}
+
+/**
+ * @brief Analyze a trace file (hot spots, coverage, and basic blocks)
+ * @details Basic blocks are the runs of instructions that fall through to
+ * each other. The lengths of instructions are provided by the callback (e.g.,
+ * from the bytes of the records), if the length is unknown, an instruction
+ * is considered as a fall-through if the next instruction is less than 16
+ * bytes after it
+ *
+ * @param Reader
+ * @param LengthCallback The callback that computes the length of instructions (optional)
+ * @param Context The context of the callback
+ * @param Analysis The result
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileAnalyze(PTRACE_FILE_READER                     Reader,
+                 TRACE_FILE_INSTRUCTION_LENGTH_CALLBACK LengthCallback,
+                 PVOID                                  Context,
+                 PTRACE_FILE_ANALYSIS                   Analysis)
+{
+    TRACE_FILE_CHUNK_HEADER        ChunkHeader;
+    std::vector<TRACE_FILE_RECORD> Records;
+
+    for (UINT32 i = 0; i < Reader->Index.size(); i++)
+    {
+        if (!TraceFileReaderReadChunk(Reader, i, &ChunkHeader, Records))
+        {
+            return FALSE;
+        }
+
+        Analysis->CountOfChunks++;
+        Analysis->CountOfRecords += Records.size();
+        Analysis->RecordsOfCores[ChunkHeader.CoreId] += Records.size();
+
+        if (ChunkHeader.RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+        {
+            for (auto & Record : Records)
+            {
+                if (Record.IsRet)
+                {
+                    Analysis->CountOfRets++;
+                }
+                else
+                {
+                    Analysis->CountOfCalls++;
+                    Analysis->Hits[Record.Target]++;
+                }
+
+                if (Record.Depth > Analysis->MaximumDepth)
+                {
+                    Analysis->MaximumDepth = Record.Depth;
+                }
+            }
+
+            continue;
+        }
+
+        TRACE_FILE_BLOCK_STATE & State = Analysis->BlockStates[ChunkHeader.CoreId];
+
+        for (auto & Record : Records)
+        {
+            Analysis->Hits[Record.Rip]++;
+
+            if (State.IsInBlock &&
+                (State.LastLength != 0 ? Record.Rip != State.LastInstruction + State.LastLength
+                                       : Record.Rip - State.LastInstruction - 1 >= MAXIMUM_INSTR_SIZE - 1))
+            {
+                TraceFileAnalyzeFinishBlock(Analysis, &State);
+            }
+
+            if (!State.IsInBlock)
+            {
+                State.IsInBlock           = TRUE;
+                State.Start               = Record.Rip;
+                State.CountOfInstructions = 0;
+            }
+
+            State.CountOfInstructions++;
+            State.LastInstruction = Record.Rip;
+            State.LastLength      = LengthCallback != NULL ? LengthCallback(&Record, ChunkHeader.Is32Bit, Context) : 0;
+        }
+    }
+
+    for (auto & State : Analysis->BlockStates)
+    {
+        TraceFileAnalyzeFinishBlock(Analysis, &State.second);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Export the records of a trace file to a flat CSV file
+ * @details Each line is a record, the columns of the fields that are not
+ * saved in the record are empty
+ *
+ * @param Reader
+ * @param Path
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+TraceFileExportCsv(PTRACE_FILE_READER Reader, const CHAR * Path)
+{
+    TRACE_FILE_CHUNK_HEADER        ChunkHeader;
+    std::vector<TRACE_FILE_RECORD> Records;
+    FILE *                         File;
+    BOOLEAN                        Result = TRUE;
+
+    static const CHAR * RegisterNames[TRACE_FILE_MAXIMUM_REGISTERS] = {
+        "rax",
+        "rcx",
+        "rdx",
+        "rbx",
+        "rsp",
+        "rbp",
+        "rsi",
+        "rdi",
+        "r8",
+        "r9",
+        "r10",
+        "r11",
+        "r12",
+        "r13",
+        "r14",
+        "r15",
+        "rflags",
+    };
+
+    File = fopen(Path, "w");
+
+    if (File == NULL)
+    {
+        return FALSE;
+    }
+
+    setvbuf(File, NULL, _IOFBF, 1024 * 1024);
+
+    fprintf(File, "core,record,rip,target,depth,is_ret");
+
+    for (UINT32 i = 0; i < TRACE_FILE_MAXIMUM_REGISTERS; i++)
+    {
+        fprintf(File, ",%s", RegisterNames[i]);
+    }
+
+    fprintf(File, ",bytes\n");
+
+    for (UINT32 i = 0; i < Reader->Index.size() && Result; i++)
+    {
+        if (!TraceFileReaderReadChunk(Reader, i, &ChunkHeader, Records))
+        {
+            Result = FALSE;
+            break;
+        }
+
+        for (auto & Record : Records)
+        {
+            fprintf(File, "%u,%llu,%llx", ChunkHeader.CoreId, Record.RecordNumber, Record.Rip);
+
+            if (ChunkHeader.RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES)
+            {
+                fprintf(File, ",%llx,%u,%u", Record.Target, Record.Depth, Record.IsRet ? 1 : 0);
+            }
+            else
+            {
+                fprintf(File, ",,,");
+            }
+
+            for (UINT32 j = 0; j < TRACE_FILE_MAXIMUM_REGISTERS; j++)
+            {
+                if (ChunkHeader.RegisterMask & (1 << j))
+                {
+                    fprintf(File, ",%llx", Record.Registers[j]);
+                }
+                else
+                {
+                    fprintf(File, ",");
+                }
+            }
+
+            fprintf(File, ",");
+
+            if (Record.HasInstructionBytes)
+            {
+                for (UINT32 j = 0; j < MAXIMUM_INSTR_SIZE; j++)
+                {
+                    fprintf(File, "%02x", Record.InstructionBytes[j]);
+                }
+            }
+
+            if (fprintf(File, "\n") < 0)
+            {
+                Result = FALSE;
+                break;
+            }
+        }
+    }
+
+    if (fclose(File) != 0)
+    {
+        Result = FALSE;
+    }
+
+    return Result;
+}
@@ -163,6 +163,20 @@ ScriptEngineCreateSymbolTableForDisassemblerWrapper(void * CallbackFunction)
     return ScriptEngineCreateSymbolTableForDisassembler(CallbackFunction);
 }
 
+/**
+ * @brief ScriptEngineCreateSymbolTableForDisassemblerFromModule wrapper
+ *
+ * @param CallbackFunction
+ * @param BaseAddress
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModuleWrapper(void * CallbackFunction, UINT64 BaseAddress)
+{
+    return ScriptEngineCreateSymbolTableForDisassemblerFromModule(CallbackFunction, BaseAddress);
+}
+
 /**
  * @brief ScriptEngineConvertFileToPdbPath wrapper
  *
@@ -0,0 +1,602 @@
+/**
+ * @file symbol-map.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The address to symbol map (used by the disassembler and the call stack)
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern SYMBOL_MAP         g_DisassemblerSymbolMap;
+extern SYMBOL_MAP_STAGING g_DisassemblerSymbolMapStaging;
+
+/**
+ * @brief Compare two staged symbols (by address and then by the order
+ * of receiving them)
+ *
+ * @param First
+ * @param Second
+ *
+ * @return bool
+ */
+static bool
+SymbolMapCompareStagedSymbols(const SYMBOL_MAP_STAGED_SYMBOL & First, const SYMBOL_MAP_STAGED_SYMBOL & Second)
+{
+    if (First.Address != Second.Address)
+    {
+        return First.Address < Second.Address;
+    }
+
+    return First.Sequence < Second.Sequence;
+}
+
+/**
+ * @brief Callback for receiving symbols from the symbol parser
+ * @details The symbols are only staged here, they're added to the map
+ * after the enumeration is finished
+ *
+ * @param Address
+ * @param ModuleName
+ * @param ObjectName
+ * @param ObjectSize
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapStageSymbol(UINT64       Address,
+                     char *       ModuleName,
+                     char *       ObjectName,
+                     unsigned int ObjectSize)
+{
+    SYMBOL_MAP_STAGING *     Staging      = &g_DisassemblerSymbolMapStaging;
+    SYMBOL_MAP_STAGED_SYMBOL StagedSymbol = {0};
+    const char *             TargetModule = ModuleName != NULL ? ModuleName : "";
+    SYMBOL_MAP_MODULE *      Module;
+
+    //
+    // Symbols of each module are delivered one after another, so only
+    // the last module is checked
+    //
+    if (Staging->Modules.empty() || strcmp(Staging->Modules.back().ModuleName.c_str(), TargetModule) != 0)
+    {
+        Staging->Modules.emplace_back();
+        Staging->Modules.back().ModuleName = TargetModule;
+    }
+
+    Module = &Staging->Modules.back();
+
+    if (ObjectSize == 0)
+    {
+        ObjectSize = DISASSEMBLY_MAXIMUM_DISTANCE_FROM_OBJECT_NAME;
+    }
+
+    StagedSymbol.Address     = Address;
+    StagedSymbol.Size        = ObjectSize;
+    StagedSymbol.NameOffset  = (UINT32)Module->Names.size();
+    StagedSymbol.Sequence    = (UINT32)Staging->Symbols.size();
+    StagedSymbol.ModuleIndex = (UINT32)(Staging->Modules.size() - 1);
+
+    //
+    // Append the name (module!object) to the names of the module
+    //
+    if (ModuleName != NULL)
+    {
+        Module->Names.insert(Module->Names.end(), ModuleName, ModuleName + strlen(ModuleName));
+        Module->Names.push_back('!');
+    }
+
+    if (ObjectName != NULL)
+    {
+        Module->Names.insert(Module->Names.end(), ObjectName, ObjectName + strlen(ObjectName));
+    }
+
+    Module->Names.push_back('\0');
+
+    Staging->Symbols.push_back(StagedSymbol);
+}
+
+/**
+ * @brief Thread routine for sorting (or merging) a range of staged symbols
+ *
+ * @param Parameter
+ *
+ * @return DWORD
+ */
+DWORD WINAPI
+SymbolMapSortWorker(LPVOID Parameter)
+{
+    SYMBOL_MAP_SORT_TASK * Task = (SYMBOL_MAP_SORT_TASK *)Parameter;
+
+    if (Task->Middle == Task->Begin)
+    {
+        std::sort(Task->Begin, Task->End, SymbolMapCompareStagedSymbols);
+    }
+    else
+    {
+        std::inplace_merge(Task->Begin, Task->Middle, Task->End, SymbolMapCompareStagedSymbols);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Run the sort (or merge) tasks in parallel and wait for them
+ *
+ * @param Tasks
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapRunSortTasks(std::vector<SYMBOL_MAP_SORT_TASK> & Tasks)
+{
+    std::vector<HANDLE> Threads(Tasks.size(), NULL);
+
+    //
+    // The first task is performed by the current thread
+    //
+    for (size_t i = 1; i < Tasks.size(); i++)
+    {
+        Threads[i] = CreateThread(NULL, 0, SymbolMapSortWorker, &Tasks[i], 0, NULL);
+
+        if (Threads[i] == NULL)
+        {
+            //
+            // Not able to create a thread, perform it here
+            //
+            SymbolMapSortWorker(&Tasks[i]);
+        }
+    }
+
+    if (!Tasks.empty())
+    {
+        SymbolMapSortWorker(&Tasks[0]);
+    }
+
+    for (size_t i = 1; i < Threads.size(); i++)
+    {
+        if (Threads[i] != NULL)
+        {
+            WaitForSingleObject(Threads[i], INFINITE);
+            CloseHandle(Threads[i]);
+        }
+    }
+}
+
+/**
+ * @brief Sort the staged symbols
+ * @details Large tables are split into ranges that are sorted by separate
+ * threads, then the sorted ranges are merged pairwise (also in parallel)
+ *
+ * @param Symbols
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapSortStagedSymbols(std::vector<SYMBOL_MAP_STAGED_SYMBOL> & Symbols)
+{
+    SYSTEM_INFO                             SystemInfo  = {0};
+    size_t                                  CountOfRuns = 1;
+    std::vector<SYMBOL_MAP_STAGED_SYMBOL *> Boundaries;
+    std::vector<SYMBOL_MAP_SORT_TASK>       Tasks;
+
+    if (Symbols.size() >= SYMBOL_MAP_PARALLEL_SORT_THRESHOLD)
+    {
+        GetSystemInfo(&SystemInfo);
+
+        //
+        // Each thread sorts at least half of the threshold
+        //
+        CountOfRuns = Symbols.size() / (SYMBOL_MAP_PARALLEL_SORT_THRESHOLD / 2);
+
+        if (CountOfRuns > SystemInfo.dwNumberOfProcessors)
+        {
+            CountOfRuns = SystemInfo.dwNumberOfProcessors;
+        }
+
+        if (CountOfRuns > SYMBOL_MAP_MAXIMUM_SORT_THREADS)
+        {
+            CountOfRuns = SYMBOL_MAP_MAXIMUM_SORT_THREADS;
+        }
+
+        if (CountOfRuns == 0)
+        {
+            CountOfRuns = 1;
+        }
+    }
+
+    //
+    // Split the symbols into (almost) equal ranges and sort each of them
+    //
+    for (size_t i = 0; i <= CountOfRuns; i++)
+    {
+        Boundaries.push_back(Symbols.data() + (Symbols.size() * i) / CountOfRuns);
+    }
+
+    for (size_t i = 0; i < CountOfRuns; i++)
+    {
+        Tasks.push_back({Boundaries[i], Boundaries[i], Boundaries[i + 1]});
+    }
+
+    SymbolMapRunSortTasks(Tasks);
+
+    //
+    // Merge the sorted ranges pairwise until one range remains
+    //
+    while (Boundaries.size() > 2)
+    {
+        std::vector<SYMBOL_MAP_STAGED_SYMBOL *> NextBoundaries;
+
+        Tasks.clear();
+
+        for (size_t i = 0; i + 2 < Boundaries.size(); i += 2)
+        {
+            Tasks.push_back({Boundaries[i], Boundaries[i + 1], Boundaries[i + 2]});
+            NextBoundaries.push_back(Boundaries[i]);
+        }
+
+        //
+        // An odd range is carried to the next round
+        //
+        if (Boundaries.size() % 2 == 0)
+        {
+            NextBoundaries.push_back(Boundaries[Boundaries.size() - 2]);
+        }
+
+        NextBoundaries.push_back(Boundaries.back());
+
+        SymbolMapRunSortTasks(Tasks);
+
+        Boundaries = std::move(NextBoundaries);
+    }
+}
+
+/**
+ * @brief Merge the (sorted) staged symbols into the map
+ * @details Symbols at the same address are kept in the order of receiving
+ * them, so the lookup finds the last one (and the previous ones are still
+ * there if its module is removed)
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapMergeStagedSymbols()
+{
+    SYMBOL_MAP *                            Map         = &g_DisassemblerSymbolMap;
+    std::vector<SYMBOL_MAP_STAGED_SYMBOL> & Staged      = g_DisassemblerSymbolMapStaging.Symbols;
+    size_t                                  OldCount    = Map->Addresses.size();
+    UINT32                                  ModuleDelta = (UINT32)Map->Modules.size();
+    size_t                                  OldIndex    = 0;
+    size_t                                  NewIndex    = 0;
+    std::vector<UINT64>                     Addresses;
+    std::vector<UINT32>                     Sizes;
+    std::vector<UINT32>                     NameOffsets;
+    std::vector<UINT32>                     ModuleIndexes;
+
+    Addresses.reserve(OldCount + Staged.size());
+    Sizes.reserve(OldCount + Staged.size());
+    NameOffsets.reserve(OldCount + Staged.size());
+    ModuleIndexes.reserve(OldCount + Staged.size());
+
+    while (OldIndex < OldCount || NewIndex < Staged.size())
+    {
+        if (NewIndex == Staged.size() || (OldIndex < OldCount && Map->Addresses[OldIndex] <= Staged[NewIndex].Address))
+        {
+            Addresses.push_back(Map->Addresses[OldIndex]);
+            Sizes.push_back(Map->Sizes[OldIndex]);
+            NameOffsets.push_back(Map->NameOffsets[OldIndex]);
+            ModuleIndexes.push_back(Map->ModuleIndexes[OldIndex]);
+            OldIndex++;
+        }
+        else
+        {
+            Addresses.push_back(Staged[NewIndex].Address);
+            Sizes.push_back(Staged[NewIndex].Size);
+            NameOffsets.push_back(Staged[NewIndex].NameOffset);
+            ModuleIndexes.push_back(Staged[NewIndex].ModuleIndex + ModuleDelta);
+            NewIndex++;
+        }
+    }
+
+    Map->Addresses     = std::move(Addresses);
+    Map->Sizes         = std::move(Sizes);
+    Map->NameOffsets   = std::move(NameOffsets);
+    Map->ModuleIndexes = std::move(ModuleIndexes);
+
+    for (auto & Module : g_DisassemblerSymbolMapStaging.Modules)
+    {
+        Map->Modules.push_back(std::move(Module));
+    }
+
+    g_DisassemblerSymbolMapStaging.Symbols.clear();
+    g_DisassemblerSymbolMapStaging.Modules.clear();
+}
+
+/**
+ * @brief Fill the Eytzinger layout of the map (in-order traversal of the
+ * implicit tree)
+ *
+ * @param SortedIndex Index of the next element in the sorted arrays
+ * @param LayoutIndex Index of the current node in the layout
+ *
+ * @return UINT32 Index of the next element in the sorted arrays
+ */
+UINT32
+SymbolMapFillLayout(UINT32 SortedIndex, UINT64 LayoutIndex)
+{
+    SYMBOL_MAP * Map = &g_DisassemblerSymbolMap;
+
+    if (LayoutIndex <= Map->Addresses.size())
+    {
+        SortedIndex = SymbolMapFillLayout(SortedIndex, 2 * LayoutIndex);
+
+        Map->LayoutAddresses[LayoutIndex] = Map->Addresses[SortedIndex];
+        Map->LayoutRanks[LayoutIndex]     = SortedIndex;
+        SortedIndex++;
+
+        SortedIndex = SymbolMapFillLayout(SortedIndex, 2 * LayoutIndex + 1);
+    }
+
+    return SortedIndex;
+}
+
+/**
+ * @brief Rebuild the search layout of the map
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapBuildLayout()
+{
+    SYMBOL_MAP * Map = &g_DisassemblerSymbolMap;
+
+    Map->LayoutAddresses.assign(Map->Addresses.size() + 1, 0);
+    Map->LayoutRanks.assign(Map->Addresses.size() + 1, 0);
+
+    SymbolMapFillLayout(0, 1);
+}
+
+/**
+ * @brief Remove the symbols of the modules (with the same names) from the map
+ * @details The search layout should be rebuilt after calling this function
+ *
+ * @param Modules
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapRemoveModules(const std::vector<SYMBOL_MAP_MODULE> & Modules)
+{
+    SYMBOL_MAP *        Map        = &g_DisassemblerSymbolMap;
+    std::vector<UINT32> NewIndexes = std::vector<UINT32>(Map->Modules.size(), 0);
+    BOOLEAN             IsRemoved  = FALSE;
+    UINT32              NextIndex  = 0;
+    size_t              Count      = 0;
+
+    //
+    // Find the new index of each module (or mark it as removed)
+    //
+    for (size_t i = 0; i < Map->Modules.size(); i++)
+    {
+        BOOLEAN IsTarget = FALSE;
+
+        for (auto & Module : Modules)
+        {
+            if (Map->Modules[i].ModuleName == Module.ModuleName)
+            {
+                IsTarget = TRUE;
+                break;
+            }
+        }
+
+        if (IsTarget)
+        {
+            NewIndexes[i] = MAXUINT32;
+            IsRemoved     = TRUE;
+        }
+        else
+        {
+            NewIndexes[i] = NextIndex++;
+        }
+    }
+
+    if (!IsRemoved)
+    {
+        return;
+    }
+
+    //
+    // Compact the table (it remains sorted)
+    //
+    for (size_t i = 0; i < Map->Addresses.size(); i++)
+    {
+        UINT32 NewModuleIndex = NewIndexes[Map->ModuleIndexes[i]];
+
+        if (NewModuleIndex != MAXUINT32)
+        {
+            Map->Addresses[Count]     = Map->Addresses[i];
+            Map->Sizes[Count]         = Map->Sizes[i];
+            Map->NameOffsets[Count]   = Map->NameOffsets[i];
+            Map->ModuleIndexes[Count] = NewModuleIndex;
+            Count++;
+        }
+    }
+
+    Map->Addresses.resize(Count);
+    Map->Sizes.resize(Count);
+    Map->NameOffsets.resize(Count);
+    Map->ModuleIndexes.resize(Count);
+
+    for (size_t i = Map->Modules.size(); i-- > 0;)
+    {
+        if (NewIndexes[i] == MAXUINT32)
+        {
+            Map->Modules.erase(Map->Modules.begin() + i);
+        }
+    }
+}
+
+/**
+ * @brief Build the map from the symbols of all of the loaded modules
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapBuild()
+{
+    SymbolMapClear();
+
+    //
+    // Get all the symbols in the callback
+    //
+    ScriptEngineCreateSymbolTableForDisassemblerWrapper(SymbolMapStageSymbol);
+
+    SymbolMapSortStagedSymbols(g_DisassemblerSymbolMapStaging.Symbols);
+    SymbolMapMergeStagedSymbols();
+    SymbolMapBuildLayout();
+}
+
+/**
+ * @brief Add (or replace) the symbols of one loaded module to the map
+ * without rebuilding the symbols of the other modules
+ *
+ * @param BaseAddress Base address of the module
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapAddModule(UINT64 BaseAddress)
+{
+    g_DisassemblerSymbolMapStaging.Symbols.clear();
+    g_DisassemblerSymbolMapStaging.Modules.clear();
+
+    //
+    // Get the symbols of the module in the callback
+    //
+    ScriptEngineCreateSymbolTableForDisassemblerFromModuleWrapper(SymbolMapStageSymbol, BaseAddress);
+
+    if (g_DisassemblerSymbolMapStaging.Symbols.empty())
+    {
+        return;
+    }
+
+    //
+    // If the module is reloaded, its previous symbols are removed
+    //
+    SymbolMapRemoveModules(g_DisassemblerSymbolMapStaging.Modules);
+
+    SymbolMapSortStagedSymbols(g_DisassemblerSymbolMapStaging.Symbols);
+    SymbolMapMergeStagedSymbols();
+    SymbolMapBuildLayout();
+}
+
+/**
+ * @brief Remove all of the symbols from the map
+ *
+ * @return VOID
+ */
+VOID
+SymbolMapClear()
+{
+    g_DisassemblerSymbolMap.Addresses.clear();
+    g_DisassemblerSymbolMap.Sizes.clear();
+    g_DisassemblerSymbolMap.NameOffsets.clear();
+    g_DisassemblerSymbolMap.ModuleIndexes.clear();
+    g_DisassemblerSymbolMap.LayoutAddresses.clear();
+    g_DisassemblerSymbolMap.LayoutRanks.clear();
+    g_DisassemblerSymbolMap.Modules.clear();
+
+    g_DisassemblerSymbolMapStaging.Symbols.clear();
+    g_DisassemblerSymbolMapStaging.Modules.clear();
+}
+
+/**
+ * @brief Find the symbol at (or the nearest symbol before) an address
+ *
+ * @param Address
+ * @param ObjectAddress Address of the found symbol
+ * @param ObjectSize Size of the found symbol
+ * @param ObjectName Name of the found symbol (module!object)
+ *
+ * @return BOOLEAN shows whether any symbol is found or not
+ */
+BOOLEAN
+SymbolMapLookup(UINT64 Address, PUINT64 ObjectAddress, PUINT32 ObjectSize, const char ** ObjectName)
+{
+    SYMBOL_MAP *   Map    = &g_DisassemblerSymbolMap;
+    UINT64         Count  = Map->Addresses.size();
+    const UINT64 * Layout = Map->LayoutAddresses.data();
+    UINT64         Index  = 1;
+    UINT64         Rank   = 0;
+    DWORD          Shift  = 0;
+
+    if (Count == 0)
+    {
+        return FALSE;
+    }
+
+    //
+    // Descend the implicit tree, the nodes of the next levels are
+    // prefetched as they're located next to each other
+    //
+    while (Index <= Count)
+    {
+        _mm_prefetch((const char *)(Layout + Index * SYMBOL_MAP_ENTRIES_PER_CACHE_LINE), _MM_HINT_T0);
+        Index = 2 * Index + (Layout[Index] <= Address);
+    }
+
+    //
+    // Cancel the right turns (and the last left turn) to reach the first
+    // symbol above the address, the result is zero if all of the symbols
+    // are at or below the address. The symbol before it is the last one
+    // that is received for its address
+    //
+    _BitScanForward64(&Shift, ~Index);
+    Index >>= Shift + 1;
+
+    Rank = Index == 0 ? Count : Map->LayoutRanks[Index];
+
+    if (Rank == 0)
+    {
+        //
+        // Address is below the lowest entry in the symbol table
+        //
+        return FALSE;
+    }
+
+    Rank--;
+
+    *ObjectAddress = Map->Addresses[Rank];
+    *ObjectSize    = Map->Sizes[Rank];
+    *ObjectName    = Map->Modules[Map->ModuleIndexes[Rank]].Names.data() + Map->NameOffsets[Rank];
+
+    return TRUE;
+}
+
+/**
+ * @brief Find the name of the symbol that is exactly at an address
+ *
+ * @param Address
+ *
+ * @return const char * Name of the symbol (module!object) or NULL if not found
+ */
+const char *
+SymbolMapLookupExact(UINT64 Address)
+{
+    UINT64       ObjectAddress;
+    UINT32       ObjectSize;
+    const char * ObjectName;
+
+    if (SymbolMapLookup(Address, &ObjectAddress, &ObjectSize, &ObjectName) && ObjectAddress == Address)
+    {
+        return ObjectName;
+    }
+
+    return NULL;
+}
@@ -15,13 +15,12 @@
 //
 // Global Variables
 //
-extern PMODULE_SYMBOL_DETAIL                        g_SymbolTable;
-extern UINT32                                       g_SymbolTableSize;
-extern UINT32                                       g_SymbolTableCurrentIndex;
-extern BOOLEAN                                      g_IsExecutingSymbolLoadingRoutines;
-extern BOOLEAN                                      g_IsSerialConnectedToRemoteDebugger;
-extern BOOLEAN                                      g_AddressConversion;
-extern std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION> g_DisassemblerSymbolMap;
+extern PMODULE_SYMBOL_DETAIL g_SymbolTable;
+extern UINT32                g_SymbolTableSize;
+extern UINT32                g_SymbolTableCurrentIndex;
+extern BOOLEAN               g_IsExecutingSymbolLoadingRoutines;
+extern BOOLEAN               g_IsSerialConnectedToRemoteDebugger;
+extern BOOLEAN               g_AddressConversion;
 
 using namespace std;
 
@@ -75,82 +74,6 @@ SymbolPrepareDebuggerWithSymbolInfo(UINT32 UserProcessId)
     SymbolBuildSymbolTable(&g_SymbolTable, &g_SymbolTableSize, UserProcessId, TRUE);
 }
 
-/**
- * @brief Callback for creating symbol map for disassembler
- *
- * @param Address
- * @param ModuleName
- * @param ObjectName
- * @param ObjectSize
- *
- * @return VOID
- */
-VOID
-SymbolCreateDisassemblerMapCallback(UINT64       Address,
-                                    char *       ModuleName,
-                                    char *       ObjectName,
-                                    unsigned int ObjectSize)
-{
-    //
-    // It has a string, should not be initialized with zero
-    //
-    LOCAL_FUNCTION_DESCRIPTION LocalFunctionDescription = {};
-    string                     FinalModuleName          = "";
-
-    if (ObjectSize == 0)
-    {
-        ObjectSize = DISASSEMBLY_MAXIMUM_DISTANCE_FROM_OBJECT_NAME;
-    }
-
-    //
-    // Convert module name to string
-    //
-    if (ModuleName != NULL)
-    {
-        FinalModuleName += std::string(ModuleName) + "!";
-    }
-
-    //
-    // Convert object name to string
-    //
-    if (ObjectName != NULL)
-    {
-        FinalModuleName += std::string(ObjectName);
-    }
-
-    //
-    // Create the structure
-    //
-    LocalFunctionDescription.ObjectName = std::move(FinalModuleName);
-    LocalFunctionDescription.ObjectSize = ObjectSize;
-
-    //
-    // Add to disassembler map
-    //
-    g_DisassemblerSymbolMap[Address] = LocalFunctionDescription;
-}
-
-/**
- * @brief Update (or create) symbol map for the disassembler
- *
- * @return BOOLEAN
- */
-BOOLEAN
-SymbolCreateDisassemblerSymbolMap()
-{
-    //
-    // Clear the map table
-    //
-    g_DisassemblerSymbolMap.clear();
-
-    //
-    // Get all the symbols in the callback
-    //
-    ScriptEngineCreateSymbolTableForDisassemblerWrapper(SymbolCreateDisassemblerMapCallback);
-
-    return TRUE;
-}
-
 /**
  * @brief shows the functions' name for the disassembler
  * @param Address
@@ -161,8 +84,10 @@ SymbolCreateDisassemblerSymbolMap()
 BOOLEAN
 SymbolShowFunctionNameBasedOnAddress(UINT64 Address, PUINT64 UsedBaseAddress)
 {
-    std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION>::iterator Low, Prev;
-    UINT64                                                 Pos = Address;
+    UINT64       ObjectAddress;
+    UINT32       ObjectSize;
+    const char * ObjectName;
+    UINT64       Diff;
 
     //
     // Check if showing function (object) names is not prohibited
@@ -174,77 +99,61 @@ SymbolShowFunctionNameBasedOnAddress(UINT64 Address, PUINT64 UsedBaseAddress)
     }
 
     //
-    // Check if we already built the symbol map for disassembler or not
+    // Find the nearest symbol at or below the address (nothing is found if the
+    // symbol map is not built or the address is below the lowest entry)
     //
-    if (!g_DisassemblerSymbolMap.empty())
+    if (!SymbolMapLookup(Address, &ObjectAddress, &ObjectSize, &ObjectName))
     {
-        Low = g_DisassemblerSymbolMap.lower_bound(Pos);
+        return FALSE;
+    }
 
-        if (Low == g_DisassemblerSymbolMap.end())
-        {
-            //
-            // Nothing found, maybe use rbegin()
-            //
-            return FALSE;
-        }
-        else if (Low == g_DisassemblerSymbolMap.begin() && Low->first > Address)
+    if (ObjectAddress == Address)
+    {
+        if (*UsedBaseAddress != Address)
         {
-            //
-            // Nothing to do, address is below the lowest entry in symbol table
-            //
-            return FALSE;
+            ShowMessages("%s", ObjectName);
+            *UsedBaseAddress = Address;
+            return TRUE;
         }
-        else if (Low->first == Address)
-        {
-            if (*UsedBaseAddress != Address)
-            {
-                ShowMessages("%s", Low->second.ObjectName.c_str());
-                *UsedBaseAddress = Address;
-                return TRUE;
-            }
 
-            return FALSE;
-        }
-        else
-        {
-            Prev        = std::prev(Low);
-            UINT64 Diff = Address - Prev->first;
+        return FALSE;
+    }
 
-            //
-            // Check, so we have a threshold boundary to add +xx to the
-            // symbols function name, in otherwords, the maximum number of
-            // bytes that a function could contain (it's definitely not the
-            // best option to find start and end of function, it's an approximate
-            // and not always might be true)
-            //
-            if (Prev->second.ObjectSize >= Diff)
-            {
-                if (*UsedBaseAddress != Prev->first)
-                {
-                    ShowMessages("%s+0x%x", Prev->second.ObjectName.c_str(), Diff);
-                    *UsedBaseAddress = Prev->first;
-                    return TRUE;
-                }
+    Diff = Address - ObjectAddress;
 
-                return FALSE;
-            }
-            else if (DISASSEMBLY_MAXIMUM_DISTANCE_FROM_OBJECT_NAME >= Diff)
-            {
-                //
-                // We add the logic of adding Name+X+X to show that a address is x bytes
-                // after the Object Name and not within the size of the function but x
-                // bytes from the above of the function
-                //
-                if (*UsedBaseAddress != Prev->first)
-                {
-                    ShowMessages("%s+0x%x+0x%x", Prev->second.ObjectName.c_str(), Diff, Diff - Prev->second.ObjectSize);
-                    *UsedBaseAddress = Prev->first;
-                    return TRUE;
-                }
+    //
+    // Check, so we have a threshold boundary to add +xx to the
+    // symbols function name, in otherwords, the maximum number of
+    // bytes that a function could contain (it's definitely not the
+    // best option to find start and end of function, it's an approximate
+    // and not always might be true)
+    //
+    if (ObjectSize >= Diff)
+    {
+        if (*UsedBaseAddress != ObjectAddress)
+        {
+            ShowMessages("%s+0x%x", ObjectName, Diff);
+            *UsedBaseAddress = ObjectAddress;
+            return TRUE;
+        }
 
-                return FALSE;
-            }
+        return FALSE;
+    }
+    else if (DISASSEMBLY_MAXIMUM_DISTANCE_FROM_OBJECT_NAME >= Diff)
+    {
+        //
+        // We add the logic of adding Name+X+X to show that a address is x bytes
+        // after the Object Name and not within the size of the function but x
+        // bytes from the above of the function
+        //
+        if (*UsedBaseAddress != ObjectAddress)
+        {
+            ShowMessages("%s+0x%x+0x%x", ObjectName, Diff, Diff - ObjectSize);
+            *UsedBaseAddress = ObjectAddress;
+            return TRUE;
         }
+
+        return FALSE;
     }
 
     //
@@ -337,7 +246,7 @@ SymbolLoadOrDownloadSymbols(BOOLEAN IsDownload, BOOLEAN SilentLoad)
     //
     // Build symbol table for disassembler
     //
-    SymbolCreateDisassemblerSymbolMap();
+    SymbolMapBuild();
 
     //
     // Not in loading routines anymore
@@ -371,6 +280,15 @@ SymbolConvertNameOrExprToAddress(const string & TextToConvert, PUINT64 Result)
         string ConstTextToConvert = TextToConvert;
         Address                   = ScriptEngineConvertNameToAddressWrapper(ConstTextToConvert.c_str(), &IsFound);
 
+        //
+        // If the symbols of the module are not loaded, the exported functions
+        // of its image are checked (e.g., kernel32!CreateFileW)
+        //
+        if (!IsFound)
+        {
+            IsFound = SymbolConvertExportNameToAddress(TextToConvert, &Address);
+        }
+
         if (!IsFound)
         {
             //
@@ -424,6 +342,143 @@ SymbolConvertNameOrExprToAddress(const string & TextToConvert, PUINT64 Result)
     return IsFound;
 }
 
+/**
+ * @brief Find the module of an address in the symbol table
+ * @details The module with the highest base address that is below the
+ * address is returned (the size of the modules is not in the symbol table)
+ *
+ * @param Address
+ *
+ * @return PMODULE_SYMBOL_DETAIL NULL if not found
+ */
+PMODULE_SYMBOL_DETAIL
+SymbolGetModuleByAddress(UINT64 Address)
+{
+    PMODULE_SYMBOL_DETAIL Module = NULL;
+
+    if (g_SymbolTable == NULL)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < g_SymbolTableSize / sizeof(MODULE_SYMBOL_DETAIL); i++)
+    {
+        if (g_SymbolTable[i].BaseAddress <= Address &&
+            (Module == NULL || g_SymbolTable[i].BaseAddress > Module->BaseAddress))
+        {
+            Module = &g_SymbolTable[i];
+        }
+    }
+
+    return Module;
+}
+
+/**
+ * @brief Find a module in the symbol table by its name
+ *
+ * @param ModuleName The name of the module (without the extension)
+ *
+ * @return PMODULE_SYMBOL_DETAIL NULL if not found
+ */
+PMODULE_SYMBOL_DETAIL
+SymbolGetModuleByName(const string & ModuleName)
+{
+    if (g_SymbolTable == NULL)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < g_SymbolTableSize / sizeof(MODULE_SYMBOL_DETAIL); i++)
+    {
+        if (!_stricmp(SymbolGetModuleName(&g_SymbolTable[i]).c_str(), ModuleName.c_str()))
+        {
+            return &g_SymbolTable[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get the name of a module (the name of its file without the extension)
+ *
+ * @param Module
+ *
+ * @return string
+ */
+string
+SymbolGetModuleName(PMODULE_SYMBOL_DETAIL Module)
+{
+    string ModuleName = Module->FilePath;
+    size_t Position   = ModuleName.find_last_of("\\/");
+
+    if (Position != string::npos)
+    {
+        ModuleName = ModuleName.substr(Position + 1);
+    }
+
+    Position = ModuleName.rfind('.');
+
+    if (Position != string::npos)
+    {
+        ModuleName = ModuleName.substr(0, Position);
+    }
+
+    return ModuleName;
+}
+
+/**
+ * @brief Convert the name of an exported function (module!function) to its
+ * address based on the image of the module
+ * @details It's used when the symbols of the module are not loaded
+ *
+ * @param TextToConvert
+ * @param Result
+ *
+ * @return BOOLEAN shows whether the function is found or not
+ */
+BOOLEAN
+SymbolConvertExportNameToAddress(const string & TextToConvert, PUINT64 Result)
+{
+    PMODULE_SYMBOL_DETAIL     Module;
+    std::shared_ptr<PE_IMAGE> Image;
+    const PE_IMAGE_EXPORT *   Export;
+    size_t                    Position = TextToConvert.find('!');
+
+    if (Position == string::npos || Position == 0 || Position + 1 == TextToConvert.size())
+    {
+        return FALSE;
+    }
+
+    Module = SymbolGetModuleByName(TextToConvert.substr(0, Position));
+
+    if (Module == NULL)
+    {
+        return FALSE;
+    }
+
+    Image = PeImageOpenModule(Module);
+
+    if (Image == nullptr)
+    {
+        return FALSE;
+    }
+
+    Export = PeImageFindExportByName(Image.get(), TextToConvert.substr(Position + 1).c_str());
+
+    //
+    // Forwarded functions are not in this module
+    //
+    if (Export == NULL || Export->IsForwarder)
+    {
+        return FALSE;
+    }
+
+    *Result = Module->BaseAddress + Export->Rva;
+
+    return TRUE;
+}
+
 /**
  * @brief Delete and free structures and variables related to the symbols
  *
@@ -436,6 +491,13 @@ SymbolDeleteSymTable()
     // Unload all symbols
     //
     ScriptEngineUnloadAllSymbolsWrapper();
+    SymbolMapClear();
+
+    //
+    // The images are mapped again once the symbol table is rebuilt (the
+    // files might be replaced)
+    //
+    PeImageFlushCache();
 
     //
     // Delete symbols
@@ -455,6 +517,44 @@ SymbolDeleteSymTable()
     }
 }
 
+/**
+ * @brief Get the PDB file path and its GUID and age of a module
+ * @details 64-bit modules are parsed from the cached mapped image, 32-bit
+ * modules (or modules that their image can't be mapped) are passed to the
+ * symbol parser as it converts the WOW64 paths
+ *
+ * @param ModulePath
+ * @param PdbFilePath
+ * @param GuidAndAgeDetails
+ * @param Is32BitModule
+ *
+ * @return BOOLEAN shows whether the operation was successful or not
+ */
+BOOLEAN
+SymbolGetPdbDetailsOfModule(const char * ModulePath, char * PdbFilePath, char * GuidAndAgeDetails, BOOLEAN Is32BitModule)
+{
+    std::shared_ptr<PE_IMAGE> Image;
+    std::wstring              ModulePathWide;
+
+    if (!Is32BitModule)
+    {
+        StringToWString(ModulePathWide, ModulePath);
+
+        Image = PeImageOpen(ModulePathWide.c_str());
+
+        if (Image != nullptr &&
+            PeImageGetPdbDetails(Image.get(), PdbFilePath, MAX_PATH, GuidAndAgeDetails, MAXIMUM_GUID_AND_AGE_SIZE))
+        {
+            return TRUE;
+        }
+    }
+
+    return ScriptEngineConvertFileToPdbFileAndGuidAndAgeDetailsWrapper(ModulePath,
+                                                                       PdbFilePath,
+                                                                       GuidAndAgeDetails,
+                                                                       Is32BitModule);
+}
+
 /**
  * @brief make the initial packet required for symbol server
  * or reload packet
@@ -759,11 +859,10 @@ SymbolBuildSymbolTable(PMODULE_SYMBOL_DETAIL * BufferToStoreDetails,
             //
             wcstombs(TempPath, Modules[i].FilePath, MAX_PATH);
 
-            if (ScriptEngineConvertFileToPdbFileAndGuidAndAgeDetailsWrapper(
-                    TempPath,
-                    ModuleSymbolPath,
-                    ModuleSymbolGuidAndAge,
-                    ModuleDetailsRequest->Is32Bit))
+            if (SymbolGetPdbDetailsOfModule(TempPath,
+                                            ModuleSymbolPath,
+                                            ModuleSymbolGuidAndAge,
+                                            ModuleDetailsRequest->Is32Bit))
             {
                 IsSymbolPdbDetailAvailable = TRUE;
 
@@ -850,10 +949,10 @@ SymbolBuildSymbolTable(PMODULE_SYMBOL_DETAIL * BufferToStoreDetails,
         //
         // Kernel modules are all 64-bit
         //
-        if (ScriptEngineConvertFileToPdbFileAndGuidAndAgeDetailsWrapper(ModuleFullPath.c_str(),
-                                                                        ModuleSymbolPath,
-                                                                        ModuleSymbolGuidAndAge,
-                                                                        FALSE))
+        if (SymbolGetPdbDetailsOfModule(ModuleFullPath.c_str(),
+                                        ModuleSymbolPath,
+                                        ModuleSymbolGuidAndAge,
+                                        FALSE))
         {
             IsSymbolPdbDetailAvailable = TRUE;
 
@@ -0,0 +1,299 @@
+/**
+ * @file pe-image-file.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Mapping the PE images and the cache of the mapped images
+ * @details The parsing of the images (pe-image.cpp) doesn't depend on the
+ * operating system, this file maps the files and keeps them in the cache
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern PE_IMAGE_CACHE g_PeImageCache;
+
+/**
+ * @brief Map a file to the memory
+ *
+ * @param Image
+ * @param Path
+ * @param LastWriteTime
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PeImageMapFile(PPE_IMAGE Image, const WCHAR * Path, UINT64 LastWriteTime)
+{
+    LARGE_INTEGER FileSize;
+
+    Image->Path          = Path;
+    Image->LastWriteTime = LastWriteTime;
+
+    //
+    // The file can be deleted (or renamed) while it's mapped, so the image
+    // can be rebuilt while it's in the cache. Modules that are opened for
+    // writing by other processes (e.g., a build that is being debugged) can
+    // also be opened, a modified file is mapped again as its last write time
+    // is changed
+    //
+    Image->FileHandle = CreateFileW(Path,
+                                    GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    NULL,
+                                    OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL,
+                                    NULL);
+
+    if (Image->FileHandle == INVALID_HANDLE_VALUE)
+    {
+        Image->FileHandle = NULL;
+        return FALSE;
+    }
+
+    if (!GetFileSizeEx(Image->FileHandle, &FileSize) || FileSize.QuadPart == 0)
+    {
+        PeImageUnmapFile(Image);
+        return FALSE;
+    }
+
+    Image->MappingHandle = CreateFileMappingW(Image->FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (Image->MappingHandle == NULL)
+    {
+        PeImageUnmapFile(Image);
+        return FALSE;
+    }
+
+    Image->Base = (const BYTE *)MapViewOfFile(Image->MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (Image->Base == NULL)
+    {
+        PeImageUnmapFile(Image);
+        return FALSE;
+    }
+
+    Image->Size = FileSize.QuadPart;
+
+    return TRUE;
+}
+
+/**
+ * @brief Unmap the file of the image
+ *
+ * @param Image
+ *
+ * @return VOID
+ */
+VOID
+PeImageUnmapFile(PPE_IMAGE Image)
+{
+    if (Image->Base != NULL)
+    {
+        UnmapViewOfFile(Image->Base);
+        Image->Base = NULL;
+    }
+
+    if (Image->MappingHandle != NULL)
+    {
+        CloseHandle(Image->MappingHandle);
+        Image->MappingHandle = NULL;
+    }
+
+    if (Image->FileHandle != NULL)
+    {
+        CloseHandle(Image->FileHandle);
+        Image->FileHandle = NULL;
+    }
+}
+
+/**
+ * @brief Unmap and free the image (once it's no longer referenced)
+ *
+ * @param Image
+ *
+ * @return VOID
+ */
+VOID
+PeImageRelease(PPE_IMAGE Image)
+{
+    PeImageUnmapFile(Image);
+
+    delete Image;
+}
+
+/**
+ * @brief Find a mapped image in the cache
+ * @details The image is moved to the front of the cache (most recently used),
+ * and if the file is modified, its previous image is removed from the cache
+ *
+ * @param Path
+ * @param LastWriteTime
+ *
+ * @return std::shared_ptr<PE_IMAGE> nullptr if the image is not in the cache
+ */
+static std::shared_ptr<PE_IMAGE>
+PeImageFindInCache(const WCHAR * Path, UINT64 LastWriteTime)
+{
+    std::shared_ptr<PE_IMAGE> Image;
+
+    SpinlockLock(&g_PeImageCache.Lock);
+
+    for (auto It = g_PeImageCache.Images.begin(); It != g_PeImageCache.Images.end(); It++)
+    {
+        if (_wcsicmp((*It)->Path.c_str(), Path))
+        {
+            continue;
+        }
+
+        if ((*It)->LastWriteTime == LastWriteTime)
+        {
+            //
+            // Move the image to the front (most recently used)
+            //
+            g_PeImageCache.Images.splice(g_PeImageCache.Images.begin(), g_PeImageCache.Images, It);
+            Image = g_PeImageCache.Images.front();
+            break;
+        }
+
+        //
+        // The file is modified, it's unmapped once it's no longer referenced
+        //
+        g_PeImageCache.Images.erase(It);
+        break;
+    }
+
+    SpinlockUnlock(&g_PeImageCache.Lock);
+
+    return Image;
+}
+
+/**
+ * @brief Open a PE image (from the cache if it's already mapped)
+ * @details Images are identified by their path and the last write time of
+ * the file, so modified files are mapped again
+ *
+ * @param Path
+ *
+ * @return std::shared_ptr<PE_IMAGE> nullptr if the file is not accessible or
+ * not a valid PE image
+ */
+std::shared_ptr<PE_IMAGE>
+PeImageOpen(const WCHAR * Path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA Attributes;
+    UINT64                    LastWriteTime;
+    std::shared_ptr<PE_IMAGE> Image;
+
+    if (!GetFileAttributesExW(Path, GetFileExInfoStandard, &Attributes))
+    {
+        return nullptr;
+    }
+
+    LastWriteTime = ((UINT64)Attributes.ftLastWriteTime.dwHighDateTime << 32) | Attributes.ftLastWriteTime.dwLowDateTime;
+
+    Image = PeImageFindInCache(Path, LastWriteTime);
+
+    if (Image != nullptr)
+    {
+        return Image;
+    }
+
+    //
+    // Images are mapped one at a time, so if the same file is opened by
+    // another thread, it's found in the cache once the other thread mapped it
+    //
+    SpinlockLock(&g_PeImageCache.OpenLock);
+
+    Image = PeImageFindInCache(Path, LastWriteTime);
+
+    if (Image != nullptr)
+    {
+        SpinlockUnlock(&g_PeImageCache.OpenLock);
+        return Image;
+    }
+
+    //
+    // Map and parse the image
+    //
+    Image = std::shared_ptr<PE_IMAGE>(new PE_IMAGE(), PeImageRelease);
+
+    if (!PeImageMapFile(Image.get(), Path, LastWriteTime) || !PeImageParseHeaders(Image.get()))
+    {
+        SpinlockUnlock(&g_PeImageCache.OpenLock);
+        return nullptr;
+    }
+
+    SpinlockLock(&g_PeImageCache.Lock);
+
+    g_PeImageCache.Images.push_front(Image);
+
+    if (g_PeImageCache.Images.size() > PE_IMAGE_CACHE_MAXIMUM_ENTRIES)
+    {
+        g_PeImageCache.Images.pop_back();
+    }
+
+    SpinlockUnlock(&g_PeImageCache.Lock);
+
+    SpinlockUnlock(&g_PeImageCache.OpenLock);
+
+    return Image;
+}
+
+/**
+ * @brief Open the image of a module of the debuggee
+ * @details The image is mapped from the path that is reported by the
+ * debuggee, and it's only used if its PDB GUID and age match the module
+ * (the local file is the same build as the module)
+ *
+ * @param Module
+ *
+ * @return std::shared_ptr<PE_IMAGE> nullptr if the image is not available
+ */
+std::shared_ptr<PE_IMAGE>
+PeImageOpenModule(PMODULE_SYMBOL_DETAIL Module)
+{
+    std::shared_ptr<PE_IMAGE> Image;
+    std::wstring              FilePath;
+    CHAR                      PdbFilePath[MAX_PATH]                 = {0};
+    CHAR                      GuidAndAge[MAXIMUM_GUID_AND_AGE_SIZE] = {0};
+
+    if (!Module->IsSymbolDetailsFound)
+    {
+        return nullptr;
+    }
+
+    StringToWString(FilePath, Module->FilePath);
+
+    Image = PeImageOpen(FilePath.c_str());
+
+    if (Image == nullptr ||
+        !PeImageGetPdbDetails(Image.get(), PdbFilePath, sizeof(PdbFilePath), GuidAndAge, sizeof(GuidAndAge)) ||
+        _stricmp(GuidAndAge, Module->ModuleSymbolGuidAndAge))
+    {
+        return nullptr;
+    }
+
+    return Image;
+}
+
+/**
+ * @brief Remove all of the images from the cache
+ * @details The images are unmapped once they're no longer referenced
+ *
+ * @return VOID
+ */
+VOID
+PeImageFlushCache()
+{
+    SpinlockLock(&g_PeImageCache.Lock);
+
+    g_PeImageCache.Images.clear();
+
+    SpinlockUnlock(&g_PeImageCache.Lock);
+}
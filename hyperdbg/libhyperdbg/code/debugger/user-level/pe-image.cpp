@@ -0,0 +1,863 @@
+/**
+ * @file pe-image.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Memory-mapped PE images and their cached indexes
+ * @details The images are parsed in place (zero-copy), every access to the
+ * mapped file is bounds-checked so corrupted images are safely rejected. The
+ * parsing doesn't depend on the operating system, the files are mapped in
+ * pe-image-file.cpp
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Validate the headers of the mapped image and build the index of
+ * the sections
+ *
+ * @param Image The image (Base and Size should be set)
+ *
+ * @return BOOLEAN TRUE if the image is a valid PE32 or PE32+ image
+ */
+BOOLEAN
+PeImageParseHeaders(PPE_IMAGE Image)
+{
+    const IMAGE_NT_HEADERS32 * NtHeaders;
+    UINT64                     NtHeadersOffset;
+    UINT64                     SectionsOffset;
+    UINT64                     DataDirectoriesOffset;
+    UINT16                     Magic;
+
+    if (Image->Size < sizeof(IMAGE_DOS_HEADER))
+    {
+        return FALSE;
+    }
+
+    Image->DosHeader = (const IMAGE_DOS_HEADER *)Image->Base;
+
+    if (Image->DosHeader->e_magic != IMAGE_DOS_SIGNATURE || Image->DosHeader->e_lfanew < 0)
+    {
+        return FALSE;
+    }
+
+    //
+    // The signature, the file header and the magic of the optional header
+    //
+    NtHeadersOffset = (UINT64)Image->DosHeader->e_lfanew;
+
+    if (NtHeadersOffset + FIELD_OFFSET(IMAGE_NT_HEADERS32, OptionalHeader) + sizeof(UINT16) > Image->Size)
+    {
+        return FALSE;
+    }
+
+    NtHeaders = (const IMAGE_NT_HEADERS32 *)(Image->Base + NtHeadersOffset);
+
+    if (NtHeaders->Signature != IMAGE_NT_SIGNATURE)
+    {
+        return FALSE;
+    }
+
+    Image->FileHeader = &NtHeaders->FileHeader;
+    Magic             = NtHeaders->OptionalHeader.Magic;
+
+    if (Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC)
+    {
+        if (NtHeadersOffset + sizeof(IMAGE_NT_HEADERS32) > Image->Size ||
+            Image->FileHeader->SizeOfOptionalHeader < FIELD_OFFSET(IMAGE_OPTIONAL_HEADER32, DataDirectory))
+        {
+            return FALSE;
+        }
+
+        Image->Is32Bit                 = TRUE;
+        Image->NtHeaders32             = NtHeaders;
+        Image->ImageBase               = Image->NtHeaders32->OptionalHeader.ImageBase;
+        Image->SizeOfImage             = Image->NtHeaders32->OptionalHeader.SizeOfImage;
+        Image->SizeOfHeaders           = Image->NtHeaders32->OptionalHeader.SizeOfHeaders;
+        Image->DataDirectories         = Image->NtHeaders32->OptionalHeader.DataDirectory;
+        Image->NumberOfDataDirectories = Image->NtHeaders32->OptionalHeader.NumberOfRvaAndSizes;
+        DataDirectoriesOffset          = FIELD_OFFSET(IMAGE_OPTIONAL_HEADER32, DataDirectory);
+    }
+    else if (Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+    {
+        if (NtHeadersOffset + sizeof(IMAGE_NT_HEADERS64) > Image->Size ||
+            Image->FileHeader->SizeOfOptionalHeader < FIELD_OFFSET(IMAGE_OPTIONAL_HEADER64, DataDirectory))
+        {
+            return FALSE;
+        }
+
+        Image->Is32Bit                 = FALSE;
+        Image->NtHeaders64             = (const IMAGE_NT_HEADERS64 *)NtHeaders;
+        Image->ImageBase               = Image->NtHeaders64->OptionalHeader.ImageBase;
+        Image->SizeOfImage             = Image->NtHeaders64->OptionalHeader.SizeOfImage;
+        Image->SizeOfHeaders           = Image->NtHeaders64->OptionalHeader.SizeOfHeaders;
+        Image->DataDirectories         = Image->NtHeaders64->OptionalHeader.DataDirectory;
+        Image->NumberOfDataDirectories = Image->NtHeaders64->OptionalHeader.NumberOfRvaAndSizes;
+        DataDirectoriesOffset          = FIELD_OFFSET(IMAGE_OPTIONAL_HEADER64, DataDirectory);
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    //
+    // Only the data directories that are inside the optional header are used
+    //
+    Image->NumberOfDataDirectories = std::min<UINT32>(Image->NumberOfDataDirectories, IMAGE_NUMBEROF_DIRECTORY_ENTRIES);
+    Image->NumberOfDataDirectories = std::min<UINT32>(Image->NumberOfDataDirectories,
+                                                       (UINT32)((Image->FileHeader->SizeOfOptionalHeader - DataDirectoriesOffset) / sizeof(IMAGE_DATA_DIRECTORY)));
+
+    //
+    // Section headers are after the optional header
+    //
+    SectionsOffset = NtHeadersOffset + FIELD_OFFSET(IMAGE_NT_HEADERS32, OptionalHeader) + Image->FileHeader->SizeOfOptionalHeader;
+
+    Image->NumberOfSections = Image->FileHeader->NumberOfSections;
+
+    if (SectionsOffset + (UINT64)Image->NumberOfSections * sizeof(IMAGE_SECTION_HEADER) > Image->Size)
+    {
+        return FALSE;
+    }
+
+    Image->Sections = (const IMAGE_SECTION_HEADER *)(Image->Base + SectionsOffset);
+
+    //
+    // The index of the sections is always needed for converting RVAs
+    //
+    PeImageBuildSectionIndex(Image);
+
+    return TRUE;
+}
+
+/**
+ * @brief Build the index of the sections (sorted by their RVAs)
+ *
+ * @param Image
+ *
+ * @return VOID
+ */
+VOID
+PeImageBuildSectionIndex(PPE_IMAGE Image)
+{
+    Image->SectionsByRva.resize(Image->NumberOfSections);
+
+    for (UINT32 i = 0; i < Image->NumberOfSections; i++)
+    {
+        Image->SectionsByRva[i] = i;
+    }
+
+    std::sort(Image->SectionsByRva.begin(), Image->SectionsByRva.end(), [Image](UINT32 First, UINT32 Second) {
+        return Image->Sections[First].VirtualAddress < Image->Sections[Second].VirtualAddress;
+    });
+}
+
+/**
+ * @brief Find the section that contains the RVA
+ *
+ * @param Image
+ * @param Rva
+ *
+ * @return const IMAGE_SECTION_HEADER * NULL if no section contains the RVA
+ */
+const IMAGE_SECTION_HEADER *
+PeImageFindSectionByRva(PPE_IMAGE Image, UINT32 Rva)
+{
+    const IMAGE_SECTION_HEADER * Section;
+    UINT32                       Low  = 0;
+    UINT32                       High = (UINT32)Image->SectionsByRva.size();
+    UINT32                       Middle;
+
+    //
+    // Find the last section that starts at or below the RVA
+    //
+    while (Low < High)
+    {
+        Middle = Low + ((High - Low) >> 1);
+
+        if (Image->Sections[Image->SectionsByRva[Middle]].VirtualAddress <= Rva)
+        {
+            Low = Middle + 1;
+        }
+        else
+        {
+            High = Middle;
+        }
+    }
+
+    if (Low == 0)
+    {
+        return NULL;
+    }
+
+    Section = &Image->Sections[Image->SectionsByRva[Low - 1]];
+
+    if ((UINT64)Rva - Section->VirtualAddress >= std::max<UINT32>(Section->Misc.VirtualSize, Section->SizeOfRawData))
+    {
+        return NULL;
+    }
+
+    return Section;
+}
+
+/**
+ * @brief Find a section by its name (case-insensitive)
+ *
+ * @param Image
+ * @param Name
+ *
+ * @return const IMAGE_SECTION_HEADER * NULL if not found
+ */
+const IMAGE_SECTION_HEADER *
+PeImageFindSectionByName(PPE_IMAGE Image, const CHAR * Name)
+{
+    if (strlen(Name) > IMAGE_SIZEOF_SHORT_NAME)
+    {
+        return NULL;
+    }
+
+    //
+    // Names of the sections are not null-terminated if they're eight
+    // characters
+    //
+    for (UINT32 i = 0; i < Image->NumberOfSections; i++)
+    {
+        const BYTE * SectionName = Image->Sections[i].Name;
+        UINT32       j           = 0;
+
+        while (j < IMAGE_SIZEOF_SHORT_NAME && Name[j] != '\0' && tolower((BYTE)Name[j]) == tolower(SectionName[j]))
+        {
+            j++;
+        }
+
+        if (j == IMAGE_SIZEOF_SHORT_NAME || (Name[j] == '\0' && SectionName[j] == '\0'))
+        {
+            return &Image->Sections[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Convert an RVA to an offset in the file
+ *
+ * @param Image
+ * @param Rva
+ * @param Offset
+ * @param Available Number of the bytes that are available in the file from
+ * the offset (in the same section)
+ *
+ * @return BOOLEAN FALSE if the RVA is not backed by the file
+ */
+BOOLEAN
+PeImageRvaToOffset(PPE_IMAGE Image, UINT32 Rva, PUINT64 Offset, PUINT64 Available)
+{
+    const IMAGE_SECTION_HEADER * Section;
+    UINT64                       End;
+
+    if (Rva < Image->SizeOfHeaders)
+    {
+        *Offset = Rva;
+        End     = std::min<UINT64>(Image->SizeOfHeaders, Image->Size);
+    }
+    else
+    {
+        Section = PeImageFindSectionByRva(Image, Rva);
+
+        if (Section == NULL || (UINT64)Rva - Section->VirtualAddress >= Section->SizeOfRawData)
+        {
+            //
+            // Not in a section, or in the part of the section that is not
+            // in the file (filled by zero)
+            //
+            return FALSE;
+        }
+
+        *Offset = (UINT64)Section->PointerToRawData + (Rva - Section->VirtualAddress);
+        End     = std::min<UINT64>((UINT64)Section->PointerToRawData + Section->SizeOfRawData, Image->Size);
+    }
+
+    if (*Offset >= End)
+    {
+        return FALSE;
+    }
+
+    *Available = End - *Offset;
+
+    return TRUE;
+}
+
+/**
+ * @brief Get a pointer to the data of an RVA in the mapped file
+ *
+ * @param Image
+ * @param Rva
+ * @param Size The size that should be accessible from the pointer
+ *
+ * @return const VOID * NULL if the data is not entirely in the file
+ */
+const VOID *
+PeImageRvaToPointer(PPE_IMAGE Image, UINT32 Rva, UINT32 Size)
+{
+    UINT64 Offset;
+    UINT64 Available;
+
+    if (!PeImageRvaToOffset(Image, Rva, &Offset, &Available) || Available < Size)
+    {
+        return NULL;
+    }
+
+    return Image->Base + Offset;
+}
+
+/**
+ * @brief Get a null-terminated string of an RVA in the mapped file
+ *
+ * @param Image
+ * @param Rva
+ *
+ * @return const CHAR * NULL if the string is not entirely in the file
+ */
+const CHAR *
+PeImageRvaToString(PPE_IMAGE Image, UINT32 Rva)
+{
+    UINT64 Offset;
+    UINT64 Available;
+
+    if (!PeImageRvaToOffset(Image, Rva, &Offset, &Available) ||
+        memchr(Image->Base + Offset, 0, (SIZE_T)Available) == NULL)
+    {
+        return NULL;
+    }
+
+    return (const CHAR *)(Image->Base + Offset);
+}
+
+/**
+ * @brief Get a pointer to the data of a data directory
+ *
+ * @param Image
+ * @param Index The index of the data directory (IMAGE_DIRECTORY_ENTRY_*)
+ * @param MinimumSize
+ * @param Size The size of the data directory
+ *
+ * @return const VOID * NULL if the data directory is not available
+ */
+const VOID *
+PeImageGetDataDirectory(PPE_IMAGE Image, UINT32 Index, UINT32 MinimumSize, PUINT32 Size)
+{
+    if (Index >= Image->NumberOfDataDirectories ||
+        Image->DataDirectories[Index].VirtualAddress == 0 ||
+        Image->DataDirectories[Index].Size < MinimumSize)
+    {
+        return NULL;
+    }
+
+    *Size = Image->DataDirectories[Index].Size;
+
+    return PeImageRvaToPointer(Image, Image->DataDirectories[Index].VirtualAddress, MinimumSize);
+}
+
+/**
+ * @brief Get the raw data of a section in the mapped file
+ *
+ * @param Image
+ * @param Section
+ * @param Size The size of the raw data that is in the file
+ *
+ * @return const BYTE * NULL if the section has no raw data in the file
+ */
+const BYTE *
+PeImageGetSectionRawData(PPE_IMAGE Image, const IMAGE_SECTION_HEADER * Section, PUINT32 Size)
+{
+    if (Section->SizeOfRawData == 0 || Section->PointerToRawData >= Image->Size)
+    {
+        return NULL;
+    }
+
+    *Size = (UINT32)std::min<UINT64>(Section->SizeOfRawData, Image->Size - Section->PointerToRawData);
+
+    return Image->Base + Section->PointerToRawData;
+}
+
+/**
+ * @brief Hash the name of an export (FNV-1a)
+ *
+ * @param Name
+ *
+ * @return UINT32
+ */
+UINT32
+PeImageHashName(const CHAR * Name)
+{
+    UINT32 Hash = 2166136261;
+
+    while (*Name)
+    {
+        Hash ^= (BYTE)*Name++;
+        Hash *= 16777619;
+    }
+
+    return Hash;
+}
+
+/**
+ * @brief Build the indexes of the exported functions (sorted by RVA and
+ * hashed by name)
+ * @details The indexes are only built the first time, the lookups call it
+ * before they access the indexes
+ *
+ * @param Image
+ *
+ * @return VOID
+ */
+VOID
+PeImageBuildExportIndex(PPE_IMAGE Image)
+{
+    const IMAGE_EXPORT_DIRECTORY * ExportDirectory;
+    const UINT32 *                 Functions;
+    const UINT32 *                 Names    = NULL;
+    const UINT16 *                 Ordinals = NULL;
+    const CHAR *                   Name;
+    UINT32                         DirectoryRva;
+    UINT32                         DirectorySize;
+    UINT32                         NumberOfFunctions;
+    UINT32                         NumberOfNames;
+    UINT32                         BucketCount;
+    UINT32                         Bucket;
+    std::vector<BOOLEAN>           IsNamed;
+
+    SpinlockLock(&Image->IndexLock);
+
+    if (Image->IsExportIndexBuilt)
+    {
+        SpinlockUnlock(&Image->IndexLock);
+        return;
+    }
+
+    ExportDirectory = (const IMAGE_EXPORT_DIRECTORY *)PeImageGetDataDirectory(Image,
+                                                                                IMAGE_DIRECTORY_ENTRY_EXPORT,
+                                                                                sizeof(IMAGE_EXPORT_DIRECTORY),
+                                                                                &DirectorySize);
+
+    if (ExportDirectory == NULL ||
+        ExportDirectory->NumberOfFunctions > PE_IMAGE_MAXIMUM_INDEXED_ENTRIES ||
+        ExportDirectory->NumberOfNames > PE_IMAGE_MAXIMUM_INDEXED_ENTRIES)
+    {
+        goto Finished;
+    }
+
+    DirectoryRva      = Image->DataDirectories[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress;
+    NumberOfFunctions = ExportDirectory->NumberOfFunctions;
+    NumberOfNames     = ExportDirectory->NumberOfNames;
+
+    Functions = (const UINT32 *)PeImageRvaToPointer(Image, ExportDirectory->AddressOfFunctions, NumberOfFunctions * sizeof(UINT32));
+
+    if (Functions == NULL)
+    {
+        goto Finished;
+    }
+
+    if (NumberOfNames != 0)
+    {
+        Names    = (const UINT32 *)PeImageRvaToPointer(Image, ExportDirectory->AddressOfNames, NumberOfNames * sizeof(UINT32));
+        Ordinals = (const UINT16 *)PeImageRvaToPointer(Image, ExportDirectory->AddressOfNameOrdinals, NumberOfNames * sizeof(UINT16));
+
+        if (Names == NULL || Ordinals == NULL)
+        {
+            NumberOfNames = 0;
+        }
+    }
+
+    IsNamed.resize(NumberOfFunctions, FALSE);
+    Image->ExportsByRva.reserve(NumberOfFunctions);
+
+    //
+    // Named exports (a function might have more than one name)
+    //
+    for (UINT32 i = 0; i < NumberOfNames; i++)
+    {
+        if (Ordinals[i] >= NumberOfFunctions || Functions[Ordinals[i]] == 0)
+        {
+            continue;
+        }
+
+        Name = PeImageRvaToString(Image, Names[i]);
+
+        if (Name == NULL)
+        {
+            continue;
+        }
+
+        Image->ExportsByRva.push_back({Functions[Ordinals[i]],
+                                       ExportDirectory->Base + Ordinals[i],
+                                       Name,
+                                       (BOOLEAN)(Functions[Ordinals[i]] - DirectoryRva < DirectorySize)});
+
+        IsNamed[Ordinals[i]] = TRUE;
+    }
+
+    //
+    // Exports by ordinal
+    //
+    for (UINT32 i = 0; i < NumberOfFunctions; i++)
+    {
+        if (IsNamed[i] || Functions[i] == 0)
+        {
+            continue;
+        }
+
+        Image->ExportsByRva.push_back({Functions[i],
+                                       ExportDirectory->Base + i,
+                                       NULL,
+                                       (BOOLEAN)(Functions[i] - DirectoryRva < DirectorySize)});
+    }
+
+    std::sort(Image->ExportsByRva.begin(), Image->ExportsByRva.end(), [](const PE_IMAGE_EXPORT & First, const PE_IMAGE_EXPORT & Second) {
+        return First.Rva < Second.Rva || (First.Rva == Second.Rva && First.Ordinal < Second.Ordinal);
+    });
+
+    //
+    // Hash the names, the table is at most half full
+    //
+    BucketCount = 16;
+
+    while (BucketCount < Image->ExportsByRva.size() * 2)
+    {
+        BucketCount <<= 1;
+    }
+
+    Image->ExportNameBuckets.assign(BucketCount, 0);
+
+    for (UINT32 i = 0; i < Image->ExportsByRva.size(); i++)
+    {
+        if (Image->ExportsByRva[i].Name == NULL)
+        {
+            continue;
+        }
+
+        Bucket = PeImageHashName(Image->ExportsByRva[i].Name) & (BucketCount - 1);
+
+        while (Image->ExportNameBuckets[Bucket] != 0)
+        {
+            Bucket = (Bucket + 1) & (BucketCount - 1);
+        }
+
+        Image->ExportNameBuckets[Bucket] = i + 1;
+    }
+
+Finished:
+    Image->IsExportIndexBuilt = TRUE;
+
+    SpinlockUnlock(&Image->IndexLock);
+}
+
+/**
+ * @brief Find an exported function by its name
+ *
+ * @param Image
+ * @param Name
+ *
+ * @return const PE_IMAGE_EXPORT * NULL if not found
+ */
+const PE_IMAGE_EXPORT *
+PeImageFindExportByName(PPE_IMAGE Image, const CHAR * Name)
+{
+    UINT32 Bucket;
+    UINT32 Mask;
+
+    //
+    // The index is built once (the flag is checked while the lock is held)
+    //
+    PeImageBuildExportIndex(Image);
+
+    if (Image->ExportNameBuckets.empty())
+    {
+        return NULL;
+    }
+
+    Mask   = (UINT32)Image->ExportNameBuckets.size() - 1;
+    Bucket = PeImageHashName(Name) & Mask;
+
+    while (Image->ExportNameBuckets[Bucket] != 0)
+    {
+        const PE_IMAGE_EXPORT * Export = &Image->ExportsByRva[Image->ExportNameBuckets[Bucket] - 1];
+
+        if (!strcmp(Export->Name, Name))
+        {
+            return Export;
+        }
+
+        Bucket = (Bucket + 1) & Mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Find the nearest exported function at or below an RVA
+ * @details Forwarders are not code, so they're skipped
+ *
+ * @param Image
+ * @param Rva
+ *
+ * @return const PE_IMAGE_EXPORT * NULL if not found
+ */
+const PE_IMAGE_EXPORT *
+PeImageFindExportByRva(PPE_IMAGE Image, UINT32 Rva)
+{
+    PeImageBuildExportIndex(Image);
+
+    auto It = std::upper_bound(Image->ExportsByRva.begin(), Image->ExportsByRva.end(), Rva, [](UINT32 Value, const PE_IMAGE_EXPORT & Export) {
+        return Value < Export.Rva;
+    });
+
+    while (It != Image->ExportsByRva.begin())
+    {
+        --It;
+
+        if (!It->IsForwarder)
+        {
+            return &*It;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Build the index of the imported functions (sorted by the RVA of
+ * their thunks in the import address table)
+ * @details The index is only built the first time, the lookups call it
+ * before they access the index
+ *
+ * @param Image
+ *
+ * @return VOID
+ */
+VOID
+PeImageBuildImportIndex(PPE_IMAGE Image)
+{
+    const IMAGE_IMPORT_DESCRIPTOR * Descriptor;
+    const VOID *                    Thunk;
+    const CHAR *                    ModuleName;
+    PE_IMAGE_IMPORT                 Import;
+    UINT32                          DirectoryRva;
+    UINT32                          DirectorySize;
+    UINT32                          LookupRva;
+    UINT32                          ThunkSize = Image->Is32Bit ? sizeof(UINT32) : sizeof(UINT64);
+    UINT64                          Value;
+
+    SpinlockLock(&Image->IndexLock);
+
+    if (Image->IsImportIndexBuilt)
+    {
+        SpinlockUnlock(&Image->IndexLock);
+        return;
+    }
+
+    if (PeImageGetDataDirectory(Image, IMAGE_DIRECTORY_ENTRY_IMPORT, sizeof(IMAGE_IMPORT_DESCRIPTOR), &DirectorySize) == NULL)
+    {
+        goto Finished;
+    }
+
+    DirectoryRva = Image->DataDirectories[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress;
+
+    //
+    // The descriptors are terminated by an empty descriptor
+    //
+    for (UINT32 i = 0; Image->ImportsByThunkRva.size() < PE_IMAGE_MAXIMUM_INDEXED_ENTRIES; i++)
+    {
+        Descriptor = (const IMAGE_IMPORT_DESCRIPTOR *)PeImageRvaToPointer(Image,
+                                                                           DirectoryRva + i * sizeof(IMAGE_IMPORT_DESCRIPTOR),
+                                                                           sizeof(IMAGE_IMPORT_DESCRIPTOR));
+
+        if (Descriptor == NULL || (Descriptor->Name == 0 && Descriptor->FirstThunk == 0))
+        {
+            break;
+        }
+
+        ModuleName = PeImageRvaToString(Image, Descriptor->Name);
+
+        if (ModuleName == NULL)
+        {
+            continue;
+        }
+
+        //
+        // The import lookup table is not available on some bound images, the
+        // import address table has the same content in the file
+        //
+        LookupRva = Descriptor->OriginalFirstThunk != 0 ? Descriptor->OriginalFirstThunk : Descriptor->FirstThunk;
+
+        for (UINT32 j = 0; Image->ImportsByThunkRva.size() < PE_IMAGE_MAXIMUM_INDEXED_ENTRIES; j++)
+        {
+            Thunk = PeImageRvaToPointer(Image, LookupRva + j * ThunkSize, ThunkSize);
+
+            if (Thunk == NULL)
+            {
+                break;
+            }
+
+            Value = Image->Is32Bit ? *(const UINT32 *)Thunk : *(const UINT64 *)Thunk;
+
+            if (Value == 0)
+            {
+                break;
+            }
+
+            Import.ThunkRva   = Descriptor->FirstThunk + j * ThunkSize;
+            Import.ModuleName = ModuleName;
+
+            if (Image->Is32Bit ? IMAGE_SNAP_BY_ORDINAL32(Value) : IMAGE_SNAP_BY_ORDINAL64(Value))
+            {
+                Import.IsOrdinal     = TRUE;
+                Import.OrdinalOrHint = (UINT16)IMAGE_ORDINAL64(Value);
+                Import.Name          = NULL;
+            }
+            else
+            {
+                //
+                // The hint is followed by the name
+                //
+                const UINT16 * Hint = (const UINT16 *)PeImageRvaToPointer(Image, (UINT32)Value, sizeof(UINT16));
+
+                Import.IsOrdinal     = FALSE;
+                Import.OrdinalOrHint = Hint != NULL ? *Hint : 0;
+                Import.Name          = PeImageRvaToString(Image, (UINT32)Value + sizeof(UINT16));
+
+                if (Import.Name == NULL)
+                {
+                    continue;
+                }
+            }
+
+            Image->ImportsByThunkRva.push_back(Import);
+        }
+    }
+
+    std::sort(Image->ImportsByThunkRva.begin(), Image->ImportsByThunkRva.end(), [](const PE_IMAGE_IMPORT & First, const PE_IMAGE_IMPORT & Second) {
+        return First.ThunkRva < Second.ThunkRva;
+    });
+
+Finished:
+    Image->IsImportIndexBuilt = TRUE;
+
+    SpinlockUnlock(&Image->IndexLock);
+}
+
+/**
+ * @brief Find the imported function of a thunk in the import address table
+ *
+ * @param Image
+ * @param ThunkRva
+ *
+ * @return const PE_IMAGE_IMPORT * NULL if not found
+ */
+const PE_IMAGE_IMPORT *
+PeImageFindImportByThunkRva(PPE_IMAGE Image, UINT32 ThunkRva)
+{
+    PeImageBuildImportIndex(Image);
+
+    auto It = std::lower_bound(Image->ImportsByThunkRva.begin(), Image->ImportsByThunkRva.end(), ThunkRva, [](const PE_IMAGE_IMPORT & Import, UINT32 Value) {
+        return Import.ThunkRva < Value;
+    });
+
+    if (It == Image->ImportsByThunkRva.end() || It->ThunkRva != ThunkRva)
+    {
+        return NULL;
+    }
+
+    return &*It;
+}
+
+/**
+ * @brief Get the name of the PDB file and its GUID and age from the
+ * CodeView debug information of the image
+ * @details The format is the same as the format that is used by the symbol
+ * server (and SymSrvGetFileIndexInfo), the path of the PDB file is the
+ * path that is stored by the linker (it might be a full local path)
+ *
+ * @param Image
+ * @param PdbFilePath
+ * @param PdbFilePathSize
+ * @param GuidAndAgeDetails
+ * @param GuidAndAgeDetailsSize
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PeImageGetPdbDetails(PPE_IMAGE Image, CHAR * PdbFilePath, UINT32 PdbFilePathSize, CHAR * GuidAndAgeDetails, UINT32 GuidAndAgeDetailsSize)
+{
+    const IMAGE_DEBUG_DIRECTORY *  DebugDirectory;
+    const PE_IMAGE_CODEVIEW_RSDS * CodeView;
+    UINT32                         DirectoryRva;
+    UINT32                         DirectorySize;
+
+    if (PeImageGetDataDirectory(Image, IMAGE_DIRECTORY_ENTRY_DEBUG, sizeof(IMAGE_DEBUG_DIRECTORY), &DirectorySize) == NULL)
+    {
+        return FALSE;
+    }
+
+    DirectoryRva = Image->DataDirectories[IMAGE_DIRECTORY_ENTRY_DEBUG].VirtualAddress;
+
+    for (UINT32 i = 0; i < DirectorySize / sizeof(IMAGE_DEBUG_DIRECTORY); i++)
+    {
+        DebugDirectory = (const IMAGE_DEBUG_DIRECTORY *)PeImageRvaToPointer(Image,
+                                                                             DirectoryRva + i * sizeof(IMAGE_DEBUG_DIRECTORY),
+                                                                             sizeof(IMAGE_DEBUG_DIRECTORY));
+
+        if (DebugDirectory == NULL)
+        {
+            break;
+        }
+
+        //
+        // The debug information is referenced by its offset in the file
+        //
+        if (DebugDirectory->Type != IMAGE_DEBUG_TYPE_CODEVIEW ||
+            DebugDirectory->SizeOfData <= FIELD_OFFSET(PE_IMAGE_CODEVIEW_RSDS, PdbFileName) ||
+            (UINT64)DebugDirectory->PointerToRawData + DebugDirectory->SizeOfData > Image->Size)
+        {
+            continue;
+        }
+
+        CodeView = (const PE_IMAGE_CODEVIEW_RSDS *)(Image->Base + DebugDirectory->PointerToRawData);
+
+        if (CodeView->Signature != PE_IMAGE_CODEVIEW_RSDS_SIGNATURE ||
+            memchr(CodeView->PdbFileName, 0, DebugDirectory->SizeOfData - FIELD_OFFSET(PE_IMAGE_CODEVIEW_RSDS, PdbFileName)) == NULL)
+        {
+            continue;
+        }
+
+        if (strlen(CodeView->PdbFileName) >= PdbFilePathSize)
+        {
+            continue;
+        }
+
+        sprintf_s(PdbFilePath, PdbFilePathSize, "%s", CodeView->PdbFileName);
+
+        sprintf_s(GuidAndAgeDetails,
+                  GuidAndAgeDetailsSize,
+                  "%08x%04x%04x%02x%02x%02x%02x%02x%02x%02x%02x%x",
+                  CodeView->Guid.Data1,
+                  CodeView->Guid.Data2,
+                  CodeView->Guid.Data3,
+                  CodeView->Guid.Data4[0],
+                  CodeView->Guid.Data4[1],
+                  CodeView->Guid.Data4[2],
+                  CodeView->Guid.Data4[3],
+                  CodeView->Guid.Data4[4],
+                  CodeView->Guid.Data4[5],
+                  CodeView->Guid.Data4[6],
+                  CodeView->Guid.Data4[7],
+                  CodeView->Age);
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
@@ -13,6 +13,8 @@
 
 /**
  * @brief Show hex dump of sections of PE
+ * @details Each line is formatted in a buffer and shown at once
+ *
  * @param Ptr
  * @param Size
  * @param SecAddress
@@ -20,46 +22,51 @@
  * @return VOID
  */
 VOID
-PeHexDump(CHAR * Ptr, int Size, int SecAddress)
+PeHexDump(const BYTE * Ptr, UINT32 Size, UINT64 SecAddress)
 {
-    int i = 1, Temp = 0;
-
-    //
-    // Buffer to store the character dump displayed at the
-    // right side
-    //
-    wchar_t Buf[18];
-    ShowMessages("\n\n%x: |", SecAddress);
+    CHAR   Line[128];
+    UINT32 Length;
+    UINT32 LineSize;
 
-    Buf[Temp]      = ' '; // initial space
-    Buf[Temp + 16] = ' '; // final space
-    Buf[Temp + 17] = 0;   // End of Buf
-    Temp++;               // Temp = 1;
+    ShowMessages("\n\n");
 
-    for (; i <= Size; i++, Ptr++, Temp++)
+    for (UINT32 i = 0; i < Size; i += 16, SecAddress += 16)
     {
-        Buf[Temp] = !iswcntrl((*Ptr) & 0xff) ? (*Ptr) & 0xff : '.';
-        ShowMessages("%-3.2x", (*Ptr) & 0xff);
+        LineSize = std::min<UINT32>(16, Size - i);
+        Length   = sprintf_s(Line, sizeof(Line), "%llx: | ", SecAddress);
 
-        if (i % 16 == 0)
+        //
+        // Hex bytes, separated in groups of four bytes
+        //
+        for (UINT32 j = 0; j < 16; j++)
         {
-            //
-            // print the character dump to the right
-            //
-            _putws(Buf);
-            if (i + 1 <= Size)
-                ShowMessages("%x: ", SecAddress += 16);
-            Temp = 0;
+            if (j < LineSize)
+            {
+                Length += sprintf_s(Line + Length, sizeof(Line) - Length, "%02x ", Ptr[i + j]);
+            }
+            else
+            {
+                Length += sprintf_s(Line + Length, sizeof(Line) - Length, "   ");
+            }
+
+            if ((j + 1) % 4 == 0)
+            {
+                Length += sprintf_s(Line + Length, sizeof(Line) - Length, "| ");
+            }
         }
-        if (i % 4 == 0)
-            ShowMessages("| ");
-    }
-    if (i % 16 != 0)
-    {
-        Buf[Temp] = 0;
-        for (; i % 16 != 0; i++)
-            ShowMessages("%-3.2c", ' ');
-        _putws(Buf);
+
+        //
+        // The character dump displayed at the right side
+        //
+        for (UINT32 j = 0; j < LineSize; j++)
+        {
+            Line[Length++] = isprint(Ptr[i + j]) ? Ptr[i + j] : '.';
+        }
+
+        Line[Length++] = '\n';
+        Line[Length]   = '\0';
+
+        ShowMessages("%s", Line);
     }
 }
 
@@ -67,140 +74,84 @@ PeHexDump(CHAR * Ptr, int Size, int SecAddress)
  * @brief Show information about different sections of PE and the dump of sections
  * @param AddressOfFile
  * @param SectionToShow
- * @param Is32Bit
  *
  * @return BOOLEAN
  */
 BOOLEAN
-PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * SectionToShow, BOOLEAN Is32Bit)
+PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * SectionToShow)
 {
-    BOOLEAN                 Result = FALSE;
-    HANDLE                  MapObjectHandle, FileHandle; // File Mapping Object
-    UINT32                  NumberOfSections;            // Number of sections
-    LPVOID                  BaseAddr;                    // Pointer to the base memory of mapped file
-    PIMAGE_DOS_HEADER       DosHeader;                   // Pointer to DOS Header
-    PIMAGE_NT_HEADERS32     NtHeader32 = NULL;           // Pointer to NT Header 32 bit
-    PIMAGE_NT_HEADERS64     NtHeader64 = NULL;           // Pointer to NT Header 64 bit
-    IMAGE_FILE_HEADER       Header;                      // Pointer to image file header of NT Header
-    IMAGE_OPTIONAL_HEADER32 OpHeader32;                  // Optional Header of PE files present in NT Header structure
-    IMAGE_OPTIONAL_HEADER64 OpHeader64;                  // Optional Header of PE files present in NT Header structure
-    PIMAGE_SECTION_HEADER   SecHeader;                   // Section Header or Section Table Header
+    std::shared_ptr<PE_IMAGE>    Image;
+    const IMAGE_DOS_HEADER *     DosHeader;            // Pointer to DOS Header
+    const IMAGE_FILE_HEADER *    Header;               // Pointer to image file header of NT Header
+    const IMAGE_SECTION_HEADER * SecHeader;            // Section Header or Section Table Header
+    const IMAGE_SECTION_HEADER * SectionToDump = NULL; // The section that its hex dump is shown
+    const BYTE *                 RawData;
+    UINT32                       RawDataSize;
+    time_t                       TimeDateStamp;
 
     //
-    // Open the EXE File
+    // Map the file (or use the cached image)
     //
-    FileHandle = CreateFileW(AddressOfFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (FileHandle == INVALID_HANDLE_VALUE)
-    {
-        ShowMessages("err, could not open the file specified\n");
-        return FALSE;
-    };
+    Image = PeImageOpen(AddressOfFile);
 
-    //
-    // Mapping Given EXE file to Memory
-    //
-    MapObjectHandle =
-        CreateFileMapping(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
-
-    if (MapObjectHandle == NULL)
+    if (Image == nullptr)
     {
-        CloseHandle(FileHandle);
+        ShowMessages("err, the specified file is not a valid PE file\n");
         return FALSE;
     }
 
-    BaseAddr = MapViewOfFile(MapObjectHandle, FILE_MAP_READ, 0, 0, 0);
-
-    if (BaseAddr == NULL)
-    {
-        CloseHandle(FileHandle);
-        return FALSE;
-    }
+    DosHeader = Image->DosHeader;
+    Header    = Image->FileHeader;
 
-    //
-    // Get the DOS Header Base
-    //
-    DosHeader = (PIMAGE_DOS_HEADER)BaseAddr; // 0x04000000
-
-    //
-    // Check for Valid DOS file
-    //
-    if (DosHeader->e_magic == IMAGE_DOS_SIGNATURE)
-    {
-        //
-        // Dump the Dos Header info
-        //
-        ShowMessages("\nValid Dos Exe File\n------------------\n");
-        ShowMessages("\nDumping DOS Header Info....\n---------------------------");
-        ShowMessages("\n%-36s%s ",
-                     "Magic number : ",
-                     DosHeader->e_magic == 0x5a4d ? "MZ" : "-");
-        ShowMessages("\n%-36s%#x", "Bytes on last page of file :", DosHeader->e_cblp);
-        ShowMessages("\n%-36s%#x", "Pages in file : ", DosHeader->e_cp);
-        ShowMessages("\n%-36s%#x", "Relocation : ", DosHeader->e_crlc);
-        ShowMessages("\n%-36s%#x",
-                     "Size of header in paragraphs : ",
-                     DosHeader->e_cparhdr);
-        ShowMessages("\n%-36s%#x",
-                     "Minimum extra paragraphs needed : ",
-                     DosHeader->e_minalloc);
-        ShowMessages("\n%-36s%#x",
-                     "Maximum extra paragraphs needed : ",
-                     DosHeader->e_maxalloc);
-        ShowMessages("\n%-36s%#x", "Initial (relative) SS value : ", DosHeader->e_ss);
-        ShowMessages("\n%-36s%#x", "Initial SP value : ", DosHeader->e_sp);
-        ShowMessages("\n%-36s%#x", "Checksum : ", DosHeader->e_csum);
-        ShowMessages("\n%-36s%#x", "Initial IP value : ", DosHeader->e_ip);
-        ShowMessages("\n%-36s%#x", "Initial (relative) CS value : ", DosHeader->e_cs);
-        ShowMessages("\n%-36s%#x",
-                     "File address of relocation table : ",
-                     DosHeader->e_lfarlc);
-        ShowMessages("\n%-36s%#x", "Overlay number : ", DosHeader->e_ovno);
-        ShowMessages("\n%-36s%#x", "OEM identifier : ", DosHeader->e_oemid);
-        ShowMessages("\n%-36s%#x",
-                     "OEM information(e_oemid specific) :",
-                     DosHeader->e_oeminfo);
-        ShowMessages("\n%-36s%#x", "RVA address of PE header : ", DosHeader->e_lfanew);
-        ShowMessages("\n==============================================================="
-                     "================\n");
-    }
-    else
+    if (SectionToShow != NULL)
     {
-        ShowMessages("\nGiven File is not a valid DOS file\n");
-        Result = FALSE;
-        goto Finished;
+        SectionToDump = PeImageFindSectionByName(Image.get(), SectionToShow);
     }
 
     //
-    // Offset of NT Header is found at 0x3c location in DOS header specified by
-    // e_lfanew
-    // Get the Base of NT Header(PE Header) 	= DosHeader + RVA address of PE
-    // header
-    //
-    if (Is32Bit)
-    {
-        NtHeader32 = (PIMAGE_NT_HEADERS32)((UINT64)(DosHeader) + (DosHeader->e_lfanew));
-    }
-    else
-    {
-        NtHeader64 = (PIMAGE_NT_HEADERS64)((UINT64)(DosHeader) + (DosHeader->e_lfanew));
-    }
+    // Dump the Dos Header info (the headers are already validated)
+    //
+    ShowMessages("\nValid Dos Exe File\n------------------\n");
+    ShowMessages("\nDumping DOS Header Info....\n---------------------------");
+    ShowMessages("\n%-36s%s ",
+                 "Magic number : ",
+                 DosHeader->e_magic == 0x5a4d ? "MZ" : "-");
+    ShowMessages("\n%-36s%#x", "Bytes on last page of file :", DosHeader->e_cblp);
+    ShowMessages("\n%-36s%#x", "Pages in file : ", DosHeader->e_cp);
+    ShowMessages("\n%-36s%#x", "Relocation : ", DosHeader->e_crlc);
+    ShowMessages("\n%-36s%#x",
+                 "Size of header in paragraphs : ",
+                 DosHeader->e_cparhdr);
+    ShowMessages("\n%-36s%#x",
+                 "Minimum extra paragraphs needed : ",
+                 DosHeader->e_minalloc);
+    ShowMessages("\n%-36s%#x",
+                 "Maximum extra paragraphs needed : ",
+                 DosHeader->e_maxalloc);
+    ShowMessages("\n%-36s%#x", "Initial (relative) SS value : ", DosHeader->e_ss);
+    ShowMessages("\n%-36s%#x", "Initial SP value : ", DosHeader->e_sp);
+    ShowMessages("\n%-36s%#x", "Checksum : ", DosHeader->e_csum);
+    ShowMessages("\n%-36s%#x", "Initial IP value : ", DosHeader->e_ip);
+    ShowMessages("\n%-36s%#x", "Initial (relative) CS value : ", DosHeader->e_cs);
+    ShowMessages("\n%-36s%#x",
+                 "File address of relocation table : ",
+                 DosHeader->e_lfarlc);
+    ShowMessages("\n%-36s%#x", "Overlay number : ", DosHeader->e_ovno);
+    ShowMessages("\n%-36s%#x", "OEM identifier : ", DosHeader->e_oemid);
+    ShowMessages("\n%-36s%#x",
+                 "OEM information(e_oemid specific) :",
+                 DosHeader->e_oeminfo);
+    ShowMessages("\n%-36s%#x", "RVA address of PE header : ", DosHeader->e_lfanew);
+    ShowMessages("\n==============================================================="
+                 "================\n");
 
-    //
-    // Identify for valid PE file
-    //
-    if (Is32Bit && NtHeader32->Signature == IMAGE_NT_SIGNATURE)
+    if (Image->Is32Bit)
     {
         ShowMessages("\nValid PE32 file \n-------------\n");
     }
-    else if (!Is32Bit && NtHeader64->Signature == IMAGE_NT_SIGNATURE)
-    {
-        ShowMessages("\nValid PE64 file \n-------------\n");
-    }
     else
     {
-        ShowMessages("err, the specified file is not a valid PE file");
-        Result = FALSE;
-        goto Finished;
+        ShowMessages("\nValid PE64 file \n-------------\n");
     }
 
     //
@@ -210,18 +161,6 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
                  "Info....\n--------------------------------");
     ShowMessages("\n%-36s%s", "Signature :", "PE");
 
-    //
-    // Get the IMAGE FILE HEADER Structure
-    //
-    if (Is32Bit)
-    {
-        Header = NtHeader32->FileHeader;
-    }
-    else
-    {
-        Header = NtHeader64->FileHeader;
-    }
-
     //
     // Determine Machine Architecture
     //
@@ -231,7 +170,7 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
     // Only few are determined (for remaining refer
     // to the above specification)
     //
-    switch (Header.Machine)
+    switch (Header->Machine)
     {
     case 0x0:
         ShowMessages("All ");
@@ -266,97 +205,100 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
     // Determine the characteristics of the given file
     //
     ShowMessages("\n%-36s", "Characteristics : ");
-    if ((Header.Characteristics & 0x0002) == 0x0002)
+    if ((Header->Characteristics & 0x0002) == 0x0002)
         ShowMessages("Executable Image, ");
-    if ((Header.Characteristics & 0x0020) == 0x0020)
+    if ((Header->Characteristics & 0x0020) == 0x0020)
         ShowMessages("Application can address > 2GB, ");
-    if ((Header.Characteristics & 0x1000) == 0x1000)
+    if ((Header->Characteristics & 0x1000) == 0x1000)
         ShowMessages("System file (Kernel Mode Driver(I think)), ");
-    if ((Header.Characteristics & 0x2000) == 0x2000)
+    if ((Header->Characteristics & 0x2000) == 0x2000)
         ShowMessages("Dll file, ");
-    if ((Header.Characteristics & 0x4000) == 0x4000)
+    if ((Header->Characteristics & 0x4000) == 0x4000)
         ShowMessages("Application runs only in Uniprocessor, ");
 
     //
     // Determine Time Stamp
     //
+    TimeDateStamp = Header->TimeDateStamp;
     ShowMessages("\n%-36s%s",
                  "Time Stamp :",
-                 ctime((const time_t *)&(Header.TimeDateStamp)));
+                 ctime(&TimeDateStamp));
 
     //
     // Determine number of sections
     //
-    ShowMessages("%-36s%d", "No.sections(size) :", Header.NumberOfSections);
-    ShowMessages("\n%-36s%d", "No.entries in symbol table :", Header.NumberOfSymbols);
+    ShowMessages("%-36s%d", "No.sections(size) :", Header->NumberOfSections);
+    ShowMessages("\n%-36s%d", "No.entries in symbol table :", Header->NumberOfSymbols);
     ShowMessages("\n%-36s%d",
                  "Size of optional header :",
-                 Header.SizeOfOptionalHeader);
+                 Header->SizeOfOptionalHeader);
 
     ShowMessages("\n\nDumping PE Optional Header "
                  "Info....\n-----------------------------------");
 
-    if (Is32Bit)
+    if (Image->Is32Bit)
     {
         //
         // Info about Optional Header
         //
-        OpHeader32 = NtHeader32->OptionalHeader;
+        const IMAGE_OPTIONAL_HEADER32 * OpHeader32 = &Image->NtHeaders32->OptionalHeader;
+
         ShowMessages("\n\nInfo of optional Header\n-----------------------");
         ShowMessages("\n%-36s%#x",
                      "Address of Entry Point : ",
-                     OpHeader32.AddressOfEntryPoint);
-        ShowMessages("\n%-36s%#llx", "Base Address of the Image : ", OpHeader32.ImageBase);
-        ShowMessages("\n%-36s%s", "SubSystem type : ", OpHeader32.Subsystem == 1 ? "Device Driver(Native windows Process)" : OpHeader32.Subsystem == 2 ? "Windows GUI"
-                                                                                                                         : OpHeader32.Subsystem == 3   ? "Windows CLI"
-                                                                                                                         : OpHeader32.Subsystem == 3   ? "Windows CLI"
-                                                                                                                         : OpHeader32.Subsystem == 9   ? "Windows CE GUI"
+                     OpHeader32->AddressOfEntryPoint);
+        ShowMessages("\n%-36s%#llx", "Base Address of the Image : ", OpHeader32->ImageBase);
+        ShowMessages("\n%-36s%s", "SubSystem type : ", OpHeader32->Subsystem == 1 ? "Device Driver(Native windows Process)" : OpHeader32->Subsystem == 2 ? "Windows GUI"
+                                                                                                                         : OpHeader32->Subsystem == 3   ? "Windows CLI"
+                                                                                                                         : OpHeader32->Subsystem == 3   ? "Windows CLI"
+                                                                                                                         : OpHeader32->Subsystem == 9   ? "Windows CE GUI"
                                                                                                                                                        : "Unknown");
-        ShowMessages("\n%-36s%s", "Given file is a : ", OpHeader32.Magic == 0x20b ? "PE32+(64)" : "PE32");
-        ShowMessages("\n%-36s%d", "Size of code segment(.text) : ", OpHeader32.SizeOfCode);
+        ShowMessages("\n%-36s%s", "Given file is a : ", OpHeader32->Magic == 0x20b ? "PE32+(64)" : "PE32");
+        ShowMessages("\n%-36s%d", "Size of code segment(.text) : ", OpHeader32->SizeOfCode);
         ShowMessages("\n%-36s%#x",
                      "Base address of code segment(RVA) :",
-                     OpHeader32.BaseOfCode);
+                     OpHeader32->BaseOfCode);
         ShowMessages("\n%-36s%d",
                      "Size of Initialized data : ",
-                     OpHeader32.SizeOfInitializedData);
+                     OpHeader32->SizeOfInitializedData);
 
         ShowMessages("\n%-36s%#x",
                      "Base address of data segment(RVA) :",
-                     OpHeader32.BaseOfData);
+                     OpHeader32->BaseOfData);
 
-        ShowMessages("\n%-36s%#x", "Section Alignment :", OpHeader32.SectionAlignment);
-        ShowMessages("\n%-36s%d", "Major Linker Version : ", OpHeader32.MajorLinkerVersion);
-        ShowMessages("\n%-36s%d", "Minor Linker Version : ", OpHeader32.MinorLinkerVersion);
+        ShowMessages("\n%-36s%#x", "Section Alignment :", OpHeader32->SectionAlignment);
+        ShowMessages("\n%-36s%d", "Major Linker Version : ", OpHeader32->MajorLinkerVersion);
+        ShowMessages("\n%-36s%d", "Minor Linker Version : ", OpHeader32->MinorLinkerVersion);
     }
     else
     {
         //
         // Info about Optional Header
         //
-        OpHeader64 = NtHeader64->OptionalHeader;
+        const IMAGE_OPTIONAL_HEADER64 * OpHeader64 = &Image->NtHeaders64->OptionalHeader;
+
         ShowMessages("\n\nInfo of optional Header\n-----------------------");
         ShowMessages("\n%-36s%#x",
                      "Address of Entry Point : ",
-                     OpHeader64.AddressOfEntryPoint);
-        ShowMessages("\n%-36s%#llx", "Base Address of the Image : ", OpHeader64.ImageBase);
-        ShowMessages("\n%-36s%s", "SubSystem type : ", OpHeader64.Subsystem == 1 ? "Device Driver(Native windows Process)" : OpHeader64.Subsystem == 2 ? "Windows GUI"
-                                                                                                                         : OpHeader64.Subsystem == 3   ? "Windows CLI"
-                                                                                                                         : OpHeader64.Subsystem == 3   ? "Windows CLI"
-                                                                                                                         : OpHeader64.Subsystem == 9   ? "Windows CE GUI"
+                     OpHeader64->AddressOfEntryPoint);
+        ShowMessages("\n%-36s%#llx", "Base Address of the Image : ", OpHeader64->ImageBase);
+        ShowMessages("\n%-36s%s", "SubSystem type : ", OpHeader64->Subsystem == 1 ? "Device Driver(Native windows Process)" : OpHeader64->Subsystem == 2 ? "Windows GUI"
+                                                                                                                         : OpHeader64->Subsystem == 3   ? "Windows CLI"
+                                                                                                                         : OpHeader64->Subsystem == 3   ? "Windows CLI"
+                                                                                                                         : OpHeader64->Subsystem == 9   ? "Windows CE GUI"
                                                                                                                                                        : "Unknown");
-        ShowMessages("\n%-36s%s", "Given file is a : ", OpHeader64.Magic == 0x20b ? "PE32+(64)" : "PE32");
-        ShowMessages("\n%-36s%d", "Size of code segment(.text) : ", OpHeader64.SizeOfCode);
+        ShowMessages("\n%-36s%s", "Given file is a : ", OpHeader64->Magic == 0x20b ? "PE32+(64)" : "PE32");
+        ShowMessages("\n%-36s%d", "Size of code segment(.text) : ", OpHeader64->SizeOfCode);
         ShowMessages("\n%-36s%#x",
                      "Base address of code segment(RVA) :",
-                     OpHeader64.BaseOfCode);
+                     OpHeader64->BaseOfCode);
         ShowMessages("\n%-36s%d",
                      "Size of Initialized data : ",
-                     OpHeader64.SizeOfInitializedData);
+                     OpHeader64->SizeOfInitializedData);
 
-        ShowMessages("\n%-36s%#x", "Section Alignment :", OpHeader64.SectionAlignment);
-        ShowMessages("\n%-36s%d", "Major Linker Version : ", OpHeader64.MajorLinkerVersion);
-        ShowMessages("\n%-36s%d", "Minor Linker Version : ", OpHeader64.MinorLinkerVersion);
+        ShowMessages("\n%-36s%#x", "Section Alignment :", OpHeader64->SectionAlignment);
+        ShowMessages("\n%-36s%d", "Major Linker Version : ", OpHeader64->MajorLinkerVersion);
+        ShowMessages("\n%-36s%d", "Minor Linker Version : ", OpHeader64->MinorLinkerVersion);
     }
 
     ShowMessages("\n\nDumping Sections Header "
@@ -365,30 +307,14 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
     //
     // Retrieve a pointer to First Section Header(or Section Table Entry)
     //
-    if (Is32Bit)
-    {
-        SecHeader        = IMAGE_FIRST_SECTION(NtHeader32);
-        NumberOfSections = NtHeader32->FileHeader.NumberOfSections;
-    }
-    else
-    {
-        SecHeader        = IMAGE_FIRST_SECTION(NtHeader64);
-        NumberOfSections = NtHeader64->FileHeader.NumberOfSections;
-    }
+    SecHeader = Image->Sections;
 
-    for (UINT32 i = 0; i < NumberOfSections; i++, SecHeader++)
+    for (UINT32 i = 0; i < Image->NumberOfSections; i++, SecHeader++)
     {
-        if (Is32Bit)
-        {
-            ShowMessages("\n\nSection Info (%d of %d)", i + 1, NtHeader32->FileHeader.NumberOfSections);
-        }
-        else
-        {
-            ShowMessages("\n\nSection Info (%d of %d)", i + 1, NtHeader64->FileHeader.NumberOfSections);
-        }
+        ShowMessages("\n\nSection Info (%d of %d)", i + 1, Image->NumberOfSections);
 
         ShowMessages("\n---------------------");
-        ShowMessages("\n%-36s%s", "Section Header name : ", SecHeader->Name);
+        ShowMessages("\n%-36s%.8s", "Section Header name : ", SecHeader->Name);
         ShowMessages("\n%-36s%#x",
                      "ActualSize of code or data : ",
                      SecHeader->Misc.VirtualSize);
@@ -430,25 +356,13 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
         //
         // show the hex dump if the user needs it
         //
-        if (SectionToShow != NULL)
+        if (SecHeader == SectionToDump)
         {
-            if (!_strcmpi(SectionToShow, (const char *)SecHeader->Name))
+            RawData = PeImageGetSectionRawData(Image.get(), SecHeader, &RawDataSize);
+
+            if (RawData != NULL)
             {
-                if (SecHeader->SizeOfRawData != 0)
-                {
-                    if (Is32Bit)
-                    {
-                        PeHexDump((char *)((UINT64)DosHeader + SecHeader->PointerToRawData),
-                                  SecHeader->SizeOfRawData,
-                                  OpHeader32.ImageBase + SecHeader->VirtualAddress);
-                    }
-                    else
-                    {
-                        PeHexDump((char *)((UINT64)DosHeader + SecHeader->PointerToRawData),
-                                  SecHeader->SizeOfRawData,
-                                  (int)(OpHeader64.ImageBase + SecHeader->VirtualAddress));
-                    }
-                }
+                PeHexDump(RawData, RawDataSize, Image->ImageBase + SecHeader->VirtualAddress);
             }
         }
     }
@@ -456,19 +370,7 @@ PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * Sectio
     ShowMessages("\n==============================================================="
                  "================\n");
 
-    //
-    // Set result to true
-    //
-    Result = TRUE;
-
-Finished:
-    //
-    // Unmap and close the handles
-    //
-    UnmapViewOfFile(BaseAddr);
-    CloseHandle(MapObjectHandle);
-
-    return Result;
+    return TRUE;
 }
 
 /**
@@ -481,124 +383,129 @@ Finished:
 BOOLEAN
 PeIsPE32BitOr64Bit(const WCHAR * AddressOfFile, PBOOLEAN Is32Bit)
 {
-    BOOLEAN                 Result = FALSE;
-    HANDLE                  MapObjectHandle, FileHandle; // File Mapping Object
-    LPVOID                  BaseAddr;                    // Pointer to the base memory of mapped file
-    PIMAGE_DOS_HEADER       DosHeader;                   // Pointer to DOS Header
-    PIMAGE_NT_HEADERS32     NtHeader32 = NULL;           // Pointer to NT Header 32 bit
-    IMAGE_OPTIONAL_HEADER32 OpHeader32;                  // Optional Header of PE files present in NT Header structure
-    IMAGE_FILE_HEADER       Header;                      // Pointer to image file header of NT Header
+    std::shared_ptr<PE_IMAGE> Image;
 
     //
-    // Open the EXE File
+    // Map the file (or use the cached image)
     //
-    FileHandle = CreateFileW(AddressOfFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (FileHandle == INVALID_HANDLE_VALUE)
+    Image = PeImageOpen(AddressOfFile);
+
+    if (Image == nullptr)
     {
-        ShowMessages("err, unable to read the file (%x)\n", GetLastError());
+        ShowMessages("err, the selected file is not in a valid PE format\n");
         return FALSE;
-    };
+    }
 
     //
-    // Mapping Given EXE file to Memory
+    // Only few are determined (for remaining refer
+    // to the above specification)
     //
-    MapObjectHandle =
-        CreateFileMapping(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
-
-    if (MapObjectHandle == NULL)
+    switch (Image->FileHeader->Machine)
     {
-        CloseHandle(FileHandle);
-
-        ShowMessages("err, unable to create file mappings (%x)\n", GetLastError());
+    case IMAGE_FILE_MACHINE_I386:
+        *Is32Bit = TRUE;
+        return TRUE;
+    case IMAGE_FILE_MACHINE_AMD64:
+        *Is32Bit = FALSE;
+        return TRUE;
+    default:
+        ShowMessages("err, PE file is not i386 or AMD64; thus, it's not supported "
+                     "in HyperDbg\n");
         return FALSE;
     }
+}
+
+/**
+ * @brief Show an exported function of a PE file by its name
+ *
+ * @param AddressOfFile
+ * @param FunctionName
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PeShowExportByName(const WCHAR * AddressOfFile, const CHAR * FunctionName)
+{
+    std::shared_ptr<PE_IMAGE> Image;
+    const PE_IMAGE_EXPORT *   Export;
+    const CHAR *              ForwardedTo;
 
-    BaseAddr = MapViewOfFile(MapObjectHandle, FILE_MAP_READ, 0, 0, 0);
+    Image = PeImageOpen(AddressOfFile);
 
-    if (BaseAddr == NULL)
+    if (Image == nullptr)
     {
-        CloseHandle(FileHandle);
-
-        ShowMessages("err, unable to create map view of file (%x)\n", GetLastError());
+        ShowMessages("err, the specified file is not a valid PE file\n");
         return FALSE;
     }
 
-    //
-    // Get the DOS Header Base
-    //
-    DosHeader = (PIMAGE_DOS_HEADER)BaseAddr; // 0x04000000
+    Export = PeImageFindExportByName(Image.get(), FunctionName);
 
-    //
-    // Check for Valid DOS file
-    //
-    if (DosHeader->e_magic != IMAGE_DOS_SIGNATURE)
+    if (Export == NULL)
     {
-        Result = FALSE;
+        ShowMessages("err, the function '%s' is not exported by the file\n", FunctionName);
+        return FALSE;
+    }
 
-        ShowMessages("err, the selected file is not in a valid PE format\n");
-        goto Finished;
+    if (Export->IsForwarder)
+    {
+        ForwardedTo = PeImageRvaToString(Image.get(), Export->Rva);
+
+        ShowMessages("%s (ordinal: %d) is forwarded to %s\n",
+                     Export->Name,
+                     Export->Ordinal,
+                     ForwardedTo != NULL ? ForwardedTo : "(invalid)");
+    }
+    else
+    {
+        ShowMessages("%s (ordinal: %d) rva: %x, image base + rva: %llx\n",
+                     Export->Name,
+                     Export->Ordinal,
+                     Export->Rva,
+                     Image->ImageBase + Export->Rva);
     }
 
-    //
-    // Offset of NT Header is found at 0x3c location in DOS header specified by
-    // e_lfanew
-    // Get the Base of NT Header(PE Header) 	= DosHeader + RVA address of PE
-    // header
-    //
+    return TRUE;
+}
 
-    NtHeader32 = (PIMAGE_NT_HEADERS32)((UINT64)(DosHeader) + (DosHeader->e_lfanew));
+/**
+ * @brief Show the imported function of a thunk of the import address table
+ * of a PE file
+ *
+ * @param AddressOfFile
+ * @param ThunkRva
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PeShowImportByThunkRva(const WCHAR * AddressOfFile, UINT32 ThunkRva)
+{
+    std::shared_ptr<PE_IMAGE> Image;
+    const PE_IMAGE_IMPORT *   Import;
 
-    //
-    // Identify for valid PE file
-    //
-    if (NtHeader32->Signature != IMAGE_NT_SIGNATURE)
-    {
-        Result = FALSE;
+    Image = PeImageOpen(AddressOfFile);
 
-        ShowMessages("err, invalid image NT signature\n");
-        goto Finished;
+    if (Image == nullptr)
+    {
+        ShowMessages("err, the specified file is not a valid PE file\n");
+        return FALSE;
     }
 
-    //
-    // Info about Optional Header
-    //
-    OpHeader32 = NtHeader32->OptionalHeader;
-
-    //
-    // Get the IMAGE FILE HEADER Structure
-    //
-    Header = NtHeader32->FileHeader;
+    Import = PeImageFindImportByThunkRva(Image.get(), ThunkRva);
 
-    //
-    // Only few are determined (for remaining refer
-    // to the above specification)
-    //
-    switch (Header.Machine)
+    if (Import == NULL)
     {
-    case IMAGE_FILE_MACHINE_I386:
-        *Is32Bit = TRUE;
-        Result   = TRUE;
-        goto Finished;
-        break;
-    case IMAGE_FILE_MACHINE_AMD64:
-        *Is32Bit = FALSE;
-        Result   = TRUE;
-        goto Finished;
-        break;
-    default:
-        ShowMessages("err, PE file is not i386 or AMD64; thus, it's not supported "
-                     "in HyperDbg\n");
-        Result = FALSE;
-        goto Finished;
-        break;
+        ShowMessages("err, the rva %x is not a thunk of the import address table\n", ThunkRva);
+        return FALSE;
     }
 
-Finished:
-    //
-    // Unmap and close the handles
-    //
-    UnmapViewOfFile(BaseAddr);
-    CloseHandle(MapObjectHandle);
+    if (Import->IsOrdinal)
+    {
+        ShowMessages("%s!#%d\n", Import->ModuleName, Import->OrdinalOrHint);
+    }
+    else
+    {
+        ShowMessages("%s!%s (hint: %d)\n", Import->ModuleName, Import->Name, Import->OrdinalOrHint);
+    }
 
-    return Result;
+    return TRUE;
 }
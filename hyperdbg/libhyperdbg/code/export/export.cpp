@@ -139,6 +139,22 @@ hyperdbg_u_test_command_parser_show_tokens(CHAR * command)
     return HyperDbgTestCommandParserShowTokens(command);
 }
 
+/**
+ * @brief Tokenize and dispatch the command for a number of iterations
+ * (used for testing purposes)
+ *
+ * @param command The text of command
+ * @param iterations The number of iterations
+ * @param convert_tokens Whether the tokens should be converted to strings
+ *
+ * @return UINT32 the number of tokens of the command
+ */
+UINT32
+hyperdbg_u_test_command_parser_performance(CHAR * command, UINT32 iterations, BOOLEAN convert_tokens)
+{
+    return HyperDbgTestCommandParserPerformance(command, iterations, convert_tokens);
+}
+
 /**
  * @brief Show the signature of the debugger
  *
@@ -713,6 +729,96 @@ hyperdbg_u_get_io_apic(IO_APIC_ENTRY_PACKETS * io_apic)
     return HyperDbgGetIoApic(io_apic);
 }
 
+/**
+ * @brief Enable or disable the VM-exit profiler
+ *
+ * @param enable
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_vmexit_profiler_enable(BOOLEAN enable)
+{
+    return HyperDbgVmexitProfilerEnable(enable);
+}
+
+/**
+ * @brief Clear the samples of the VM-exit profiler
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_vmexit_profiler_reset()
+{
+    return HyperDbgVmexitProfilerReset();
+}
+
+/**
+ * @brief Query the samples of the VM-exit profiler
+ *
+ * @param core_id the target core or DEBUGGER_VMEXIT_PROFILER_ALL_CORES
+ * @param results
+ * @param is_enabled
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_vmexit_profiler_query(UINT32 core_id, VMEXIT_PROFILER_RESULTS * results, BOOLEAN * is_enabled)
+{
+    return HyperDbgVmexitProfilerQuery(core_id, results, is_enabled);
+}
+
+/**
+ * @brief Take a snapshot of a range of the physical memory
+ *
+ * @param start_address start physical address (page aligned)
+ * @param end_address end physical address (page aligned)
+ * @param maximum_pages count of pages that could be saved (zero for the default)
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_snapshot_take(UINT64 start_address, UINT64 end_address, UINT32 maximum_pages)
+{
+    return HyperDbgSnapshotTake(start_address, end_address, maximum_pages);
+}
+
+/**
+ * @brief Restore the modified pages of the snapshot
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_snapshot_restore()
+{
+    return HyperDbgSnapshotRestore();
+}
+
+/**
+ * @brief Discard the snapshot
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_snapshot_discard()
+{
+    return HyperDbgSnapshotDiscard();
+}
+
+/**
+ * @brief Query the statistics of the snapshot
+ *
+ * @param statistics
+ * @param is_taken
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+hyperdbg_u_snapshot_query(DEBUGGER_SNAPSHOT_STATISTICS * statistics, BOOLEAN * is_taken)
+{
+    return HyperDbgSnapshotQuery(statistics, is_taken);
+}
+
 /**
  * @brief Run hwdbg script
  *
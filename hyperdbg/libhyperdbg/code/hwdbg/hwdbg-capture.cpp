@@ -0,0 +1,541 @@
+/**
+ * @file hwdbg-capture.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Capture buffer (logic analyzer) of hwdbg
+ * @details The capture buffer keeps run-length encoded samples of the pins,
+ * the entries are read in chunks and could be exported as a VCD file
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//
+// Global Variables
+//
+extern HWDBG_INSTANCE_INFORMATION g_HwdbgInstanceInfo;
+extern BOOLEAN                    g_HwdbgInstanceInfoIsValid;
+extern HWDBG_CAPTURE_BUFFER_CHUNK g_HwdbgCaptureHeader;
+extern std::vector<UINT32>        g_HwdbgCaptureEntries;
+
+/**
+ * @brief Get the number of words of each entry of the capture buffer
+ * @details Each entry is the run length followed by the words of the sample
+ *
+ * @param InstanceInfo
+ *
+ * @return UINT32
+ */
+UINT32
+HwdbgCaptureGetNumberOfEntryWords(HWDBG_INSTANCE_INFORMATION * InstanceInfo)
+{
+    return 1 + (InstanceInfo->numberOfPins + InstanceInfo->bramDataWidth - 1) / InstanceInfo->bramDataWidth;
+}
+
+/**
+ * @brief Get the name of the state of the capture buffer
+ *
+ * @param CaptureState
+ *
+ * @return const CHAR *
+ */
+const CHAR *
+HwdbgCaptureGetStateName(UINT32 CaptureState)
+{
+    switch (CaptureState)
+    {
+    case hwdbgCaptureStateIdle:
+        return "idle";
+    case hwdbgCaptureStateArmed:
+        return "armed";
+    case hwdbgCaptureStateTriggered:
+        return "triggered";
+    case hwdbgCaptureStateDone:
+        return "done";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @brief Get the VCD identifier of a signal
+ * @details Identifiers are made of the printable ASCII characters ('!' to '~')
+ *
+ * @param Index
+ *
+ * @return std::string
+ */
+std::string
+HwdbgCaptureGetVcdIdentifier(UINT32 Index)
+{
+    std::string Identifier;
+
+    do
+    {
+        Identifier.push_back((CHAR)('!' + (Index % 94)));
+        Index = Index / 94;
+
+    } while (Index != 0);
+
+    return Identifier;
+}
+
+/**
+ * @brief Interpret a chunk of the capture buffer
+ * @details The entries of the chunk are appended to the received entries
+ *
+ * @param Chunk
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgCaptureInterpretChunk(HWDBG_CAPTURE_BUFFER_CHUNK * Chunk)
+{
+    UINT32   NumberOfEntryWords;
+    UINT32   NumberOfReceivedEntries;
+    UINT32   MaximumNumberOfEntriesInChunk;
+    UINT32 * Entries;
+
+    if (!g_HwdbgInstanceInfoIsValid)
+    {
+        ShowMessages("err, the instance info is not available\n");
+        return FALSE;
+    }
+
+    NumberOfEntryWords = HwdbgCaptureGetNumberOfEntryWords(&g_HwdbgInstanceInfo);
+
+    //
+    // Keep the header of the chunk
+    //
+    RtlCopyMemory(&g_HwdbgCaptureHeader, Chunk, sizeof(HWDBG_CAPTURE_BUFFER_CHUNK));
+
+    if (Chunk->CaptureState != hwdbgCaptureStateDone)
+    {
+        //
+        // Entries are only sent once the capture is done
+        //
+        ShowMessages("the capture is not finished yet (state: %s)\n", HwdbgCaptureGetStateName(Chunk->CaptureState));
+        return TRUE;
+    }
+
+    //
+    // A new capture window starts from the first entry
+    //
+    if (Chunk->FirstEntry == 0)
+    {
+        g_HwdbgCaptureEntries.clear();
+    }
+
+    NumberOfReceivedEntries = (UINT32)(g_HwdbgCaptureEntries.size() / NumberOfEntryWords);
+
+    //
+    // Check whether the chunk is the next chunk of the capture window
+    //
+    MaximumNumberOfEntriesInChunk = (g_HwdbgInstanceInfo.sharedMemorySize - g_HwdbgInstanceInfo.debuggeeAreaOffset -
+                                     sizeof(DEBUGGER_REMOTE_PACKET) - sizeof(HWDBG_CAPTURE_BUFFER_CHUNK)) /
+                                    (NumberOfEntryWords * sizeof(UINT32));
+
+    if (Chunk->FirstEntry != NumberOfReceivedEntries ||
+        Chunk->NumberOfEntriesInChunk > MaximumNumberOfEntriesInChunk ||
+        (UINT64)Chunk->FirstEntry + Chunk->NumberOfEntriesInChunk > Chunk->NumberOfEntries)
+    {
+        ShowMessages("err, invalid chunk of the capture buffer (first entry: %d, expected: %d, entries in chunk: %d)\n",
+                     Chunk->FirstEntry,
+                     NumberOfReceivedEntries,
+                     Chunk->NumberOfEntriesInChunk);
+        return FALSE;
+    }
+
+    //
+    // Append the entries of the chunk
+    //
+    Entries = (UINT32 *)(((CHAR *)Chunk) + sizeof(HWDBG_CAPTURE_BUFFER_CHUNK));
+
+    g_HwdbgCaptureEntries.insert(g_HwdbgCaptureEntries.end(),
+                                 Entries,
+                                 Entries + (SIZE_T)Chunk->NumberOfEntriesInChunk * NumberOfEntryWords);
+
+    ShowMessages("received %d entries of the capture buffer (%d of %d entries)\n",
+                 Chunk->NumberOfEntriesInChunk,
+                 Chunk->FirstEntry + Chunk->NumberOfEntriesInChunk,
+                 Chunk->NumberOfEntries);
+
+    return TRUE;
+}
+
+/**
+ * @brief Arm the capture buffer of hwdbg
+ *
+ * @param InstanceFilePathToRead
+ * @param CaptureConfigurationFilePathToSave
+ * @param InitialBramBufferSize
+ * @param TriggerPin
+ * @param PreTriggerEntries
+ * @param PostTriggerEntries
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgCaptureArm(const TCHAR * InstanceFilePathToRead,
+                const TCHAR * CaptureConfigurationFilePathToSave,
+                UINT32        InitialBramBufferSize,
+                UINT32        TriggerPin,
+                UINT32        PreTriggerEntries,
+                UINT32        PostTriggerEntries)
+{
+    HWDBG_CAPTURE_CONFIGURATION CaptureConfiguration   = {0};
+    TCHAR                       TestFilePath[MAX_PATH] = {0};
+
+    //
+    // Load the instance info
+    //
+    if (!HwdbgLoadInstanceInfo(InstanceFilePathToRead, InitialBramBufferSize))
+    {
+        //
+        // Unable to load the instance info
+        //
+        return FALSE;
+    }
+
+    if (g_HwdbgInstanceInfo.captureBufferDepth == 0)
+    {
+        ShowMessages("err, this instance of hwdbg doesn't support the capture buffer\n");
+        return FALSE;
+    }
+
+    //
+    // Check the capture window (the same check is performed in hwdbg)
+    //
+    if (PostTriggerEntries == 0 ||
+        (UINT64)PreTriggerEntries + PostTriggerEntries > g_HwdbgInstanceInfo.captureBufferDepth)
+    {
+        ShowMessages("err, invalid capture window, the post-trigger entries should be at least 1 and "
+                     "the total entries should not exceed the depth of the capture buffer (%d entries)\n",
+                     g_HwdbgInstanceInfo.captureBufferDepth);
+        return FALSE;
+    }
+
+    if (TriggerPin >= g_HwdbgInstanceInfo.numberOfPins)
+    {
+        ShowMessages("the trigger pin is not a valid pin, the capture is triggered immediately\n");
+    }
+
+    CaptureConfiguration.TriggerPin         = TriggerPin;
+    CaptureConfiguration.PreTriggerEntries  = PreTriggerEntries;
+    CaptureConfiguration.PostTriggerEntries = PostTriggerEntries;
+
+    //
+    // Discard the entries of the previous capture
+    //
+    g_HwdbgCaptureEntries.clear();
+    RtlZeroMemory(&g_HwdbgCaptureHeader, sizeof(HWDBG_CAPTURE_BUFFER_CHUNK));
+
+    //
+    // Write the capture configuration request into a file
+    //
+    if (HwdbgInterpreterSetupPacketPath(CaptureConfigurationFilePathToSave, TestFilePath, sizeof(TestFilePath), FALSE) &&
+        HwdbgInterpreterSendPacketAndBufferToHwdbg(
+            &g_HwdbgInstanceInfo,
+            TestFilePath,
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+            hwdbgActionConfigureCapture,
+            (CHAR *)&CaptureConfiguration,
+            sizeof(HWDBG_CAPTURE_CONFIGURATION)))
+    {
+        ShowMessages("[*] capture configuration request successfully written into file: %s\n", TestFilePath);
+        return TRUE;
+    }
+
+    //
+    // Unable to write capture configuration request into a file
+    //
+    return FALSE;
+}
+
+/**
+ * @brief Read the next chunk of the capture buffer of hwdbg
+ *
+ * @param CaptureReadFilePathToSave
+ * @param CaptureBufferFilePathToRead
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgCaptureRead(const TCHAR * CaptureReadFilePathToSave,
+                 const TCHAR * CaptureBufferFilePathToRead)
+{
+    TCHAR    TestFilePath[MAX_PATH] = {0};
+    UINT32   FirstEntry;
+    UINT32   BufferSize;
+    UINT32 * MemoryBuffer = NULL;
+    BOOLEAN  Result       = FALSE;
+
+    if (!g_HwdbgInstanceInfoIsValid)
+    {
+        ShowMessages("err, the instance info is not available, arm the capture buffer first\n");
+        return FALSE;
+    }
+
+    //
+    // Continue from the entries that are already received
+    //
+    FirstEntry = (UINT32)(g_HwdbgCaptureEntries.size() / HwdbgCaptureGetNumberOfEntryWords(&g_HwdbgInstanceInfo));
+
+    if (g_HwdbgCaptureHeader.CaptureState == hwdbgCaptureStateDone && FirstEntry != 0 &&
+        FirstEntry >= g_HwdbgCaptureHeader.NumberOfEntries)
+    {
+        ShowMessages("all the entries of the capture buffer are already received\n");
+        return TRUE;
+    }
+
+    //
+    // Write the read request into a file
+    //
+    if (!HwdbgInterpreterSetupPacketPath(CaptureReadFilePathToSave, TestFilePath, sizeof(TestFilePath), FALSE) ||
+        !HwdbgInterpreterSendPacketAndBufferToHwdbg(
+            &g_HwdbgInstanceInfo,
+            TestFilePath,
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+            hwdbgActionReadCaptureBuffer,
+            (CHAR *)&FirstEntry,
+            sizeof(UINT32)))
+    {
+        ShowMessages("err, unable to write the capture buffer read request\n");
+        return FALSE;
+    }
+
+    ShowMessages("[*] capture buffer read request (first entry: %d) successfully written into file: %s\n", FirstEntry, TestFilePath);
+
+    //
+    // Allocate memory buffer to read the chunk (the whole shared memory)
+    //
+    BufferSize   = g_HwdbgInstanceInfo.sharedMemorySize / sizeof(UINT32);
+    MemoryBuffer = (UINT32 *)malloc(BufferSize * sizeof(UINT32));
+
+    if (MemoryBuffer == NULL)
+    {
+        ShowMessages("err, unable to allocate memory for the capture buffer packet of the debuggee\n");
+        return FALSE;
+    }
+
+    RtlZeroMemory(MemoryBuffer, BufferSize * sizeof(UINT32));
+
+    //
+    // Read and interpret the chunk
+    //
+    RtlZeroMemory(TestFilePath, sizeof(TestFilePath));
+
+    if (HwdbgInterpreterSetupPacketPath(CaptureBufferFilePathToRead, TestFilePath, sizeof(TestFilePath), TRUE) &&
+        HwdbgInterpreterFillMemoryFromFile(TestFilePath, MemoryBuffer, BufferSize))
+    {
+        Result = HwdbgInterpretPacket(MemoryBuffer, BufferSize);
+    }
+    else
+    {
+        ShowMessages("err, unable to read the capture buffer packet of the debuggee\n");
+    }
+
+    free(MemoryBuffer);
+
+    if (Result && g_HwdbgCaptureHeader.CaptureState == hwdbgCaptureStateDone)
+    {
+        FirstEntry = (UINT32)(g_HwdbgCaptureEntries.size() / HwdbgCaptureGetNumberOfEntryWords(&g_HwdbgInstanceInfo));
+
+        if (FirstEntry < g_HwdbgCaptureHeader.NumberOfEntries)
+        {
+            ShowMessages("%d entries are remained, read the capture buffer again to receive the next chunk\n",
+                         g_HwdbgCaptureHeader.NumberOfEntries - FirstEntry);
+        }
+        else
+        {
+            HwdbgCaptureShowSummary();
+        }
+    }
+
+    return Result;
+}
+
+/**
+ * @brief Show the summary of the received capture buffer
+ * @details The effective depth (number of samples covered by the entries) is
+ * compared with the raw sampling (one sample per entry of the same buffer)
+ *
+ * @return VOID
+ */
+VOID
+HwdbgCaptureShowSummary()
+{
+    UINT32 NumberOfEntryWords;
+    UINT32 NumberOfReceivedEntries;
+    UINT64 NumberOfSamples = 0;
+
+    if (!g_HwdbgInstanceInfoIsValid)
+    {
+        ShowMessages("err, the instance info is not available\n");
+        return;
+    }
+
+    NumberOfEntryWords      = HwdbgCaptureGetNumberOfEntryWords(&g_HwdbgInstanceInfo);
+    NumberOfReceivedEntries = (UINT32)(g_HwdbgCaptureEntries.size() / NumberOfEntryWords);
+
+    for (UINT32 I = 0; I < NumberOfReceivedEntries; I++)
+    {
+        NumberOfSamples += g_HwdbgCaptureEntries[(SIZE_T)I * NumberOfEntryWords];
+    }
+
+    ShowMessages("Capture State: %s\n", HwdbgCaptureGetStateName(g_HwdbgCaptureHeader.CaptureState));
+    ShowMessages("Capture Window: %d entries (%d received)\n", g_HwdbgCaptureHeader.NumberOfEntries, NumberOfReceivedEntries);
+    ShowMessages("Trigger Entry: %d (latency: %d samples)\n", g_HwdbgCaptureHeader.TriggerEntry, g_HwdbgCaptureHeader.TriggerLatency);
+
+    if (NumberOfReceivedEntries != 0)
+    {
+        ShowMessages("Effective Depth: %llu samples in %d entries (%.2fx of raw sampling)\n",
+                     NumberOfSamples,
+                     NumberOfReceivedEntries,
+                     (double)NumberOfSamples / NumberOfReceivedEntries);
+    }
+}
+
+/**
+ * @brief Export the received capture buffer as a VCD file
+ * @details Each time unit of the VCD is a sample (clock) of hwdbg, the trigger
+ * marker is located at the sample that caused the trigger (the latency of the
+ * script engine is deducted from the trigger entry)
+ *
+ * @param VcdFilePathToSave
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgCaptureExportVcd(const TCHAR * VcdFilePathToSave)
+{
+    std::map<UINT64, std::string> Changes;
+    std::string                   TriggerIdentifier;
+    UINT32                        NumberOfEntryWords;
+    UINT32                        NumberOfReceivedEntries;
+    UINT32 *                      Entry;
+    UINT32 *                      PreviousEntry = NULL;
+    UINT64                        Time          = 0;
+    UINT64                        TriggerTime   = 0;
+    BOOLEAN                       HasTrigger    = FALSE;
+
+    if (!g_HwdbgInstanceInfoIsValid)
+    {
+        ShowMessages("err, the instance info is not available\n");
+        return FALSE;
+    }
+
+    NumberOfEntryWords      = HwdbgCaptureGetNumberOfEntryWords(&g_HwdbgInstanceInfo);
+    NumberOfReceivedEntries = (UINT32)(g_HwdbgCaptureEntries.size() / NumberOfEntryWords);
+
+    if (NumberOfReceivedEntries == 0)
+    {
+        ShowMessages("err, no entries of the capture buffer are received\n");
+        return FALSE;
+    }
+
+    if (NumberOfReceivedEntries < g_HwdbgCaptureHeader.NumberOfEntries)
+    {
+        ShowMessages("warning, only %d of %d entries are received, the exported capture is partial\n",
+                     NumberOfReceivedEntries,
+                     g_HwdbgCaptureHeader.NumberOfEntries);
+    }
+
+    //
+    // The trigger marker comes after the pins
+    //
+    TriggerIdentifier = HwdbgCaptureGetVcdIdentifier(g_HwdbgInstanceInfo.numberOfPins);
+
+    //
+    // Expand the run lengths into value changes
+    //
+    for (UINT32 I = 0; I < NumberOfReceivedEntries; I++)
+    {
+        Entry = &g_HwdbgCaptureEntries[(SIZE_T)I * NumberOfEntryWords];
+
+        for (UINT32 Pin = 0; Pin < g_HwdbgInstanceInfo.numberOfPins; Pin++)
+        {
+            UINT32 Word  = 1 + Pin / g_HwdbgInstanceInfo.bramDataWidth;
+            UINT32 Bit   = Pin % g_HwdbgInstanceInfo.bramDataWidth;
+            UINT32 Value = (Entry[Word] >> Bit) & 1;
+
+            if (PreviousEntry == NULL || Value != ((PreviousEntry[Word] >> Bit) & 1))
+            {
+                Changes[Time] += (Value ? "1" : "0") + HwdbgCaptureGetVcdIdentifier(Pin) + "\n";
+            }
+        }
+
+        if (I == g_HwdbgCaptureHeader.TriggerEntry)
+        {
+            HasTrigger  = TRUE;
+            TriggerTime = Time > g_HwdbgCaptureHeader.TriggerLatency ? Time - g_HwdbgCaptureHeader.TriggerLatency : 0;
+        }
+
+        PreviousEntry = Entry;
+        Time += Entry[0];
+    }
+
+    //
+    // Add the trigger marker (a single sample pulse)
+    //
+    if (!HasTrigger || TriggerTime != 0)
+    {
+        Changes[0] += "0" + TriggerIdentifier + "\n";
+    }
+
+    if (HasTrigger)
+    {
+        Changes[TriggerTime] += "1" + TriggerIdentifier + "\n";
+        Changes[TriggerTime + 1] += "0" + TriggerIdentifier + "\n";
+    }
+
+    std::ofstream File(VcdFilePathToSave);
+
+    if (!File.is_open())
+    {
+        ShowMessages("err, unable to open file %s\n", VcdFilePathToSave);
+        return FALSE;
+    }
+
+    //
+    // Write the header and the definitions of the signals
+    //
+    File << "$version HyperDbg hwdbg capture buffer $end\n";
+    File << "$comment each time unit is a sample (clock) of hwdbg $end\n";
+    File << "$timescale 1ns $end\n";
+    File << "$scope module hwdbg $end\n";
+
+    for (UINT32 Pin = 0; Pin < g_HwdbgInstanceInfo.numberOfPins; Pin++)
+    {
+        File << "$var wire 1 " << HwdbgCaptureGetVcdIdentifier(Pin) << " hw_pin" << std::dec << Pin << " $end\n";
+    }
+
+    File << "$var wire 1 " << TriggerIdentifier << " trigger $end\n";
+    File << "$upscope $end\n";
+    File << "$enddefinitions $end\n";
+
+    //
+    // Write the value changes
+    //
+    for (auto & Change : Changes)
+    {
+        File << "#" << std::dec << Change.first << "\n"
+             << Change.second;
+    }
+
+    //
+    // The end of the last run
+    //
+    if (Changes.rbegin()->first < Time)
+    {
+        File << "#" << std::dec << Time << "\n";
+    }
+
+    File.close();
+
+    ShowMessages("[*] capture buffer (%llu samples) successfully exported into file: %s\n", Time, VcdFilePathToSave);
+
+    return TRUE;
+}
@@ -17,12 +17,14 @@
 extern HWDBG_INSTANCE_INFORMATION g_HwdbgInstanceInfo;
 extern BOOLEAN                    g_HwdbgInstanceInfoIsValid;
 extern std::vector<UINT32>        g_HwdbgPortConfiguration;
+extern std::string                g_HwdbgBramImagePath;
+extern BOOLEAN                    g_HwdbgIsWaitingForResponse;
 
 /**
  * @brief Interpret packets of hwdbg
  *
  * @param BufferReceived
- * @param LengthReceived
+ * @param LengthReceived number of 32-bit words of the buffer
  * @return BOOLEAN
  */
 BOOLEAN
@@ -34,37 +36,17 @@ HwdbgInterpretPacket(PVOID BufferReceived, UINT32 LengthReceived)
     BOOLEAN                     Result          = FALSE;
 
     //
-    // Apply the initial offset
+    // Apply the initial offset, the debuggee's preferred offset (area) is used
+    // if the instance info already received and interpreted, otherwise the
+    // default initial offset is used as there is no information from debuggee
+    // (the length is in 32-bit words)
     //
-    if (g_HwdbgInstanceInfoIsValid)
-    {
-        //
-        // Use the debuggee's preferred offset (area) since the instance info
-        // already received and interpreted
-        //
-        TheActualPacket = (DEBUGGER_REMOTE_PACKET *)(((CHAR *)BufferReceived) + g_HwdbgInstanceInfo.debuggeeAreaOffset);
-    }
-    else
-    {
-        //
-        // Use default initial offset as there is no information (instance info)
-        // from debuggee
-        //
-        TheActualPacket = (DEBUGGER_REMOTE_PACKET *)(((CHAR *)BufferReceived) + DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET);
-    }
+    TheActualPacket = HwdbgPacketDecode(BufferReceived,
+                                        (SIZE_T)LengthReceived * sizeof(UINT32),
+                                        g_HwdbgInstanceInfoIsValid ? g_HwdbgInstanceInfo.debuggeeAreaOffset : DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET);
 
-    if (TheActualPacket->Indicator == INDICATOR_OF_HYPERDBG_PACKET)
+    if (TheActualPacket != NULL)
     {
-        //
-        // Check checksum (for hwdbg, checksum is ignored)
-        //
-        // if (KdComputeDataChecksum((PVOID)&TheActualPacket->Indicator,
-        //                           LengthReceived - sizeof(BYTE)) != TheActualPacket->Checksum)
-        // {
-        //     ShowMessages("err, checksum is invalid\n");
-        //     return FALSE;
-        // }
-
         //
         // Check if the packet type is correct
         //
@@ -95,10 +77,20 @@ HwdbgInterpretPacket(PVOID BufferReceived, UINT32 LengthReceived)
 
         case hwdbgResponseInstanceInfo:
 
-            Result             = TRUE;
             InstanceInfoPacket = (HWDBG_INSTANCE_INFORMATION *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET));
             InstanceInfoPorts  = (UINT32 *)(((CHAR *)InstanceInfoPacket) + sizeof(HWDBG_INSTANCE_INFORMATION));
 
+            //
+            // Each stage holds at least one operator (the operator of the stage)
+            //
+            if (InstanceInfoPacket->maximumNumberOfOperatorsPerStage == 0)
+            {
+                ShowMessages("err, invalid instance info, the maximum number of operators per stage is zero\n");
+                break;
+            }
+
+            Result = TRUE;
+
             //
             // Copy the instance info into the global hwdbg instance info
             //
@@ -129,6 +121,15 @@ HwdbgInterpretPacket(PVOID BufferReceived, UINT32 LengthReceived)
 
             break;
 
+        case hwdbgResponseCaptureBuffer:
+
+            //
+            // Interpret the chunk of the capture buffer
+            //
+            Result = HwdbgCaptureInterpretChunk((HWDBG_CAPTURE_BUFFER_CHUNK *)(((CHAR *)TheActualPacket) + sizeof(DEBUGGER_REMOTE_PACKET)));
+
+            break;
+
         default:
 
             Result = FALSE;
@@ -145,31 +146,171 @@ HwdbgInterpretPacket(PVOID BufferReceived, UINT32 LengthReceived)
 }
 
 /**
- * @brief Function to parse a single line of the memory content
+ * @brief Check whether the file is a binary BRAM image or a text hex file
  *
- * @param Line
- * @return VOID
+ * @param FileName
+ * @return BOOLEAN
  */
-std::vector<UINT32>
-HwdbgParseStringMemoryLine(const std::string & Line)
+BOOLEAN
+HwdbgInterpreterIsBinaryImageFile(const TCHAR * FileName)
 {
-    std::vector<UINT32> Values;
-    std::stringstream   Ss(Line);
-    std::string         Token;
+    SIZE_T FileNameLength  = strlen(FileName);
+    SIZE_T ExtensionLength = sizeof(HWDBG_BRAM_IMAGE_FILE_EXTENSION) - 1;
 
-    // Skip the memory address part
-    std::getline(Ss, Token, ':');
+    return FileNameLength >= ExtensionLength &&
+           _stricmp(FileName + FileNameLength - ExtensionLength, HWDBG_BRAM_IMAGE_FILE_EXTENSION) == 0;
+}
 
-    // Read the hex value
-    while (std::getline(Ss, Token, ' '))
+/**
+ * @brief Function to read the binary BRAM image and fill the memory buffer
+ *
+ * @param FileName
+ * @param MemoryBuffer
+ * @param BufferSize
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgInterpreterFillMemoryFromBinaryFile(
+    const TCHAR * FileName,
+    UINT32 *      MemoryBuffer,
+    size_t        BufferSize)
+{
+    std::ifstream           File(FileName, std::ios::binary);
+    HWDBG_BRAM_IMAGE_HEADER Header = {0};
+
+    if (!File.is_open())
     {
-        if (Token.length() == 8 && std::all_of(Token.begin(), Token.end(), ::isxdigit))
+        ShowMessages("err, unable to open file %s\n", FileName);
+        return FALSE;
+    }
+
+    //
+    // Read and validate the header of the image
+    //
+    if (!File.read((char *)&Header, sizeof(HWDBG_BRAM_IMAGE_HEADER)) ||
+        !HwdbgPacketIsValidBramImageHeader(&Header, 0))
+    {
+        ShowMessages("err, invalid BRAM image %s\n", FileName);
+        return FALSE;
+    }
+
+    //
+    // The image could be the whole shared memory of hwdbg, so only the
+    // words that fit into the buffer are read
+    //
+    if (Header.NumberOfWords < BufferSize)
+    {
+        BufferSize = Header.NumberOfWords;
+    }
+
+    //
+    // The content is read at once, there is no need to parse it
+    //
+    File.seekg(Header.HeaderSize);
+
+    if (!File.read((char *)MemoryBuffer, BufferSize * sizeof(UINT32)))
+    {
+        ShowMessages("err, the BRAM image %s is truncated\n", FileName);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Wait for hwdbg to respond to the last packet of the binary BRAM image
+ * @details hwdbg (or the simulator) sets the sequence of the debuggee to the
+ * sequence of the debugger once the response is written into the image
+ *
+ * @param FileName
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgInterpreterWaitForResponse(const TCHAR * FileName)
+{
+    HWDBG_BRAM_IMAGE_HEADER Header    = {0};
+    UINT64                  StartTime = GetTickCount64();
+
+    g_HwdbgIsWaitingForResponse = TRUE;
+
+    while (g_HwdbgIsWaitingForResponse)
+    {
+        std::ifstream File(FileName, std::ios::binary);
+
+        if (!File.is_open() ||
+            !File.read((char *)&Header, sizeof(HWDBG_BRAM_IMAGE_HEADER)) ||
+            !HwdbgPacketIsValidBramImageHeader(&Header, 0))
         {
-            Values.push_back(static_cast<UINT32>(std::stoul(Token, nullptr, 16)));
+            ShowMessages("err, invalid BRAM image %s\n", FileName);
+            g_HwdbgIsWaitingForResponse = FALSE;
+            return FALSE;
         }
+
+        File.close();
+
+        if (Header.DebuggeeSequence == Header.DebuggerSequence)
+        {
+            //
+            // The response is available
+            //
+            g_HwdbgIsWaitingForResponse = FALSE;
+            return TRUE;
+        }
+
+        if (GetTickCount64() - StartTime >= HWDBG_BRAM_IMAGE_RESPONSE_TIMEOUT)
+        {
+            ShowMessages("err, hwdbg didn't respond to the packet (sequence: %d)\n", Header.DebuggerSequence);
+            g_HwdbgIsWaitingForResponse = FALSE;
+            return FALSE;
+        }
+
+        Sleep(HWDBG_BRAM_IMAGE_POLLING_INTERVAL);
+    }
+
+    //
+    // The user pressed CTRL+C
+    //
+    ShowMessages("waiting for the response of hwdbg is aborted\n");
+
+    return FALSE;
+}
+
+/**
+ * @brief Setup the path of the file that packets of hwdbg are exchanged through
+ * @details If a binary BRAM image is configured (!hw bram), all the packets are
+ * exchanged through the image, otherwise the default file (relative to the
+ * location of HyperDbg) is used
+ *
+ * @param DefaultFileName
+ * @param FilePath
+ * @param FilePathLength
+ * @param CheckFileExists
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgInterpreterSetupPacketPath(const TCHAR * DefaultFileName,
+                                TCHAR *       FilePath,
+                                ULONG         FilePathLength,
+                                BOOLEAN       CheckFileExists)
+{
+    if (g_HwdbgBramImagePath.empty())
+    {
+        return SetupPathForFileName(DefaultFileName, FilePath, FilePathLength, CheckFileExists);
     }
 
-    return Values;
+    if (FAILED(StringCbCopy(FilePath, FilePathLength, g_HwdbgBramImagePath.c_str())))
+    {
+        ShowMessages("err, the path of the BRAM image is too long\n");
+        return FALSE;
+    }
+
+    if (CheckFileExists && GetFileAttributes(FilePath) == INVALID_FILE_ATTRIBUTES)
+    {
+        ShowMessages("err, unable to find the BRAM image %s\n", FilePath);
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
 /**
@@ -186,6 +327,11 @@ HwdbgInterpreterFillMemoryFromFile(
     UINT32 *      MemoryBuffer,
     size_t        BufferSize)
 {
+    if (HwdbgInterpreterIsBinaryImageFile(FileName))
+    {
+        return HwdbgInterpreterFillMemoryFromBinaryFile(FileName, MemoryBuffer, BufferSize);
+    }
+
     std::ifstream File(FileName);
     std::string   Line;
     BOOLEAN       Result = TRUE;
@@ -206,7 +352,14 @@ HwdbgInterpreterFillMemoryFromFile(
             break;
         }
 
-        vector<UINT32> Values = HwdbgParseStringMemoryLine(Line);
+        vector<UINT32> Values;
+
+        if (!HwdbgPacketParseTextLine(Line, Values))
+        {
+            ShowMessages("err, invalid line in file %s: %s\n", FileName, Line.c_str());
+            File.close();
+            return FALSE;
+        }
 
         for (UINT32 Value : Values)
         {
@@ -228,88 +381,141 @@ HwdbgInterpreterFillMemoryFromFile(
 }
 
 /**
- * @brief Function to write the memory buffer to a file in the specified format
+ * @brief Function to write the memory buffer to a binary BRAM image
+ * @details The image is updated in place (if it exists) and the sequence of
+ * the debugger is incremented after the content is written, thus a simulator
+ * that mapped the image never sees a truncated file or a partial packet
  *
  * @param InstanceInfo
  * @param FileName
  * @param MemoryBuffer
  * @param BufferSize
- * @param RequestedAction
  *
  * @return BOOLEAN
  */
 BOOLEAN
-HwdbgInterpreterFillFileFromMemory(
+HwdbgInterpreterFillBinaryFileFromMemory(
     HWDBG_INSTANCE_INFORMATION * InstanceInfo,
     const TCHAR *                FileName,
     UINT32 *                     MemoryBuffer,
-    size_t                       BufferSize,
-    HWDBG_ACTION_ENUMS           RequestedAction)
+    size_t                       BufferSize)
 {
-    std::ofstream File(FileName);
+    HWDBG_BRAM_IMAGE_HEADER Header        = {0};
+    HWDBG_BRAM_IMAGE_HEADER CurrentHeader = {0};
+    size_t                  NumberOfWords = BufferSize / sizeof(UINT32);
+    std::vector<UINT32>     Content;
 
-    if (!File.is_open())
-    {
-        printf("err, unable to open file %s\n", FileName);
-        return FALSE;
-    }
+    std::fstream File(FileName, std::ios::in | std::ios::out | std::ios::binary);
 
-    size_t Address = 0;
-    for (size_t I = 0; I < BufferSize / sizeof(UINT32); ++I)
+    if (File.is_open())
     {
-        File << std::hex << std::setw(8) << std::setfill('0') << MemoryBuffer[I];
-        File << " ; +0x" << std::hex << std::setw(1) << std::setfill('0') << Address;
-
-        if (I == 0)
-        {
-            File << "   | Checksum";
-        }
-        else if (I == 1)
-        {
-            File << "   | Checksum";
-        }
-        else if (I == 2)
-        {
-            File << "   | Indicator";
-        }
-        else if (I == 3)
-        {
-            File << "   | Indicator";
-        }
-        else if (I == 4)
-        {
-            File << "  | TypeOfThePacket - DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL (0x4)";
-        }
-        else if (I == 5)
+        //
+        // Keep the sequences and the size of the current image
+        //
+        if (!File.read((char *)&CurrentHeader, sizeof(HWDBG_BRAM_IMAGE_HEADER)) ||
+            !HwdbgPacketIsValidBramImageHeader(&CurrentHeader, 0))
         {
-            File << "  | RequestedActionOfThePacket - Value" << " (0x" << std::hex << std::setw(1) << std::setfill('0') << RequestedAction << ")";
+            RtlZeroMemory(&CurrentHeader, sizeof(HWDBG_BRAM_IMAGE_HEADER));
         }
-        else if (I == 6)
+
+        File.clear();
+    }
+    else
+    {
+        File.open(FileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (!File.is_open())
         {
-            File << "  | Start of Optional Data";
+            ShowMessages("err, unable to open file %s\n", FileName);
+            return FALSE;
         }
-
-        File << "\n";
-        Address += 4;
     }
 
     //
-    // Add zeros to the end of the file to fill the shared memory
+    // Add zeros to the end of the image to fill the shared memory
     //
     if (g_HwdbgInstanceInfoIsValid)
     {
-        while (Address < InstanceInfo->sharedMemorySize)
-        {
-            File << "00000000 ; +0x" << std::hex << std::setw(1) << std::setfill('0') << Address;
-            Address += 4;
+        NumberOfWords = std::max<size_t>(NumberOfWords, InstanceInfo->sharedMemorySize / sizeof(UINT32));
+    }
 
-            if (Address < InstanceInfo->sharedMemorySize)
-            {
-                File << "\n";
-            }
-        }
+    NumberOfWords = std::max<size_t>(NumberOfWords, CurrentHeader.NumberOfWords);
+
+    Content.resize(NumberOfWords, 0);
+    memcpy(Content.data(), MemoryBuffer, BufferSize / sizeof(UINT32) * sizeof(UINT32));
+
+    HwdbgPacketInitializeBramImageHeader(&Header, (UINT32)NumberOfWords);
+
+    Header.DebuggerSequence = CurrentHeader.DebuggerSequence;
+    Header.DebuggeeSequence = CurrentHeader.DebuggeeSequence;
+
+    File.seekp(0);
+    File.write((const char *)&Header, sizeof(HWDBG_BRAM_IMAGE_HEADER));
+    File.write((const char *)Content.data(), NumberOfWords * sizeof(UINT32));
+    File.flush();
+
+    //
+    // Indicate that a new packet is available
+    //
+    Header.DebuggerSequence++;
+
+    File.seekp(offsetof(HWDBG_BRAM_IMAGE_HEADER, DebuggerSequence));
+    File.write((const char *)&Header.DebuggerSequence, sizeof(UINT32));
+    File.close();
+
+    if (File.fail())
+    {
+        ShowMessages("err, unable to write the BRAM image %s\n", FileName);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Function to write the memory buffer to a file in the specified format
+ * @details If the file is a binary BRAM image (HWDBG_BRAM_IMAGE_FILE_EXTENSION),
+ * the memory is written as a binary image, otherwise it's written as a text hex file
+ *
+ * @param InstanceInfo
+ * @param FileName
+ * @param MemoryBuffer
+ * @param BufferSize
+ * @param RequestedAction
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgInterpreterFillFileFromMemory(
+    HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+    const TCHAR *                FileName,
+    UINT32 *                     MemoryBuffer,
+    size_t                       BufferSize,
+    HWDBG_ACTION_ENUMS           RequestedAction)
+{
+    if (HwdbgInterpreterIsBinaryImageFile(FileName))
+    {
+        return HwdbgInterpreterFillBinaryFileFromMemory(InstanceInfo, FileName, MemoryBuffer, BufferSize);
+    }
+
+    std::ofstream File(FileName);
+
+    if (!File.is_open())
+    {
+        printf("err, unable to open file %s\n", FileName);
+        return FALSE;
     }
 
+    //
+    // Write the packet, and add zeros to the end of the file to fill the
+    // shared memory (if the instance info is available)
+    //
+    HwdbgPacketWriteTextFile(File,
+                             MemoryBuffer,
+                             BufferSize / sizeof(UINT32),
+                             g_HwdbgInstanceInfoIsValid ? InstanceInfo->sharedMemorySize : 0,
+                             RequestedAction);
+
     //
     // Close the file
     //
@@ -339,17 +545,18 @@ HwdbgComputeNumberOfFlipFlopsNeeded(
     SIZE_T NumberOfNeededFlipFlopsInTargetDevice = 0;
 
     //
-    // size of operator (GET and SET)
+    // size of operator (GET and SET) for each operator of the stage (the stage symbol and the fused operators)
     //
     NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages *
+                                              g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage *
                                               (g_HwdbgInstanceInfo.maximumNumberOfSupportedGetScriptOperators + g_HwdbgInstanceInfo.maximumNumberOfSupportedSetScriptOperators) *
                                               g_HwdbgInstanceInfo.scriptVariableLength *
                                               sizeof(HWDBG_SHORT_SYMBOL) / sizeof(UINT64));
 
     //
-    // size of main operator (/ 2 is becasue Type is not inffered)
+    // size of main operator and fused operators (/ 2 is becasue Type is not inffered)
     //
-    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages * g_HwdbgInstanceInfo.scriptVariableLength * (sizeof(HWDBG_SHORT_SYMBOL) / sizeof(UINT64)) / 2);
+    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages * g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage * g_HwdbgInstanceInfo.scriptVariableLength * (sizeof(HWDBG_SHORT_SYMBOL) / sizeof(UINT64)) / 2);
 
     //
     // size of local (and global) variables
@@ -362,14 +569,18 @@ HwdbgComputeNumberOfFlipFlopsNeeded(
     NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages * g_HwdbgInstanceInfo.numberOfSupportedTemporaryVariables * g_HwdbgInstanceInfo.scriptVariableLength);
 
     //
-    // size of stage index register + targetStage (* 2)
+    // size of stage index register (+ index of fused operators) + targetStage
     //
-    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages * Log2Ceil(g_HwdbgInstanceInfo.maximumNumberOfStages * (g_HwdbgInstanceInfo.maximumNumberOfSupportedGetScriptOperators + g_HwdbgInstanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)) * 2);
+    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages *
+                                              Log2Ceil(g_HwdbgInstanceInfo.maximumNumberOfStages *
+                                                       g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage *
+                                                       (g_HwdbgInstanceInfo.maximumNumberOfSupportedGetScriptOperators + g_HwdbgInstanceInfo.maximumNumberOfSupportedSetScriptOperators + 1)) *
+                                              (g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage + 1));
 
     //
-    // stage enable flip-flop
+    // stage enable flip-flop (+ enable flip-flop of fused operators)
     //
-    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages);
+    NumberOfNeededFlipFlopsInTargetDevice += (NumberOfStages * g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage);
 
     //
     // input => output flip-flop
@@ -402,13 +613,15 @@ HwdbgInterpreterSendPacketAndBufferToHwdbg(HWDBG_INSTANCE_INFORMATION * Instance
                                            CHAR *                       Buffer,
                                            UINT32                       BufferLength)
 {
-    DEBUGGER_REMOTE_PACKET Packet          = {0};
-    SIZE_T                 CommandMaxSize  = 0;
-    SIZE_T                 FinalBufferSize = 0;
+    SIZE_T  CommandMaxSize  = 0;
+    SIZE_T  FinalBufferSize = 0;
+    UINT32  Offset          = 0;
+    BOOLEAN Result          = FALSE;
 
     if (g_HwdbgInstanceInfoIsValid)
     {
         CommandMaxSize = InstanceInfo->debuggeeAreaOffset - InstanceInfo->debuggerAreaOffset;
+        Offset         = InstanceInfo->debuggerAreaOffset;
     }
     else
     {
@@ -416,6 +629,7 @@ HwdbgInterpreterSendPacketAndBufferToHwdbg(HWDBG_INSTANCE_INFORMATION * Instance
         // Use default limitation
         //
         CommandMaxSize = DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET - DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET;
+        Offset         = DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET;
     }
 
     //
@@ -426,61 +640,22 @@ HwdbgInterpreterSendPacketAndBufferToHwdbg(HWDBG_INSTANCE_INFORMATION * Instance
         BufferLength = 0;
     }
 
-    //
-    // Compute the final buffer size
-    //
-    FinalBufferSize = sizeof(DEBUGGER_REMOTE_PACKET) + BufferLength;
-
     //
     // Check if buffer not pass the boundary
     //
-    if (FinalBufferSize > CommandMaxSize)
+    if (sizeof(DEBUGGER_REMOTE_PACKET) + BufferLength > CommandMaxSize)
     {
         ShowMessages("err, buffer is above the maximum buffer size that can be sent to hwdbg (%d > %d)\n",
-                     FinalBufferSize,
+                     sizeof(DEBUGGER_REMOTE_PACKET) + BufferLength,
                      CommandMaxSize);
 
         return FALSE;
     }
 
     //
-    // Make the packet's structure
-    //
-    Packet.Indicator       = INDICATOR_OF_HYPERDBG_PACKET;
-    Packet.TypeOfThePacket = PacketType;
-
-    //
-    // Set the requested action
-    //
-    Packet.RequestedActionOfThePacket = (DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION)RequestedAction;
-
-    //
-    // calculate checksum of the packet
-    //
-    Packet.Checksum =
-        KdComputeDataChecksum((PVOID)((UINT64)&Packet + 1),
-                              sizeof(DEBUGGER_REMOTE_PACKET) - sizeof(BYTE));
-
-    if (Buffer != NULL)
-    {
-        Packet.Checksum += KdComputeDataChecksum((PVOID)Buffer, BufferLength);
-    }
-
-    //
-    // If there is an offset for debugger to debuggee command, we'll apply it here
-    //
-    if (g_HwdbgInstanceInfoIsValid)
-    {
-        FinalBufferSize += InstanceInfo->debuggerAreaOffset;
-    }
-    else
-    {
-        FinalBufferSize += DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET;
-    }
-
-    //
-    // Allocate a buffer for storing the header packet + buffer (if not empty)
+    // Allocate a buffer for storing the offset + header packet + buffer (if not empty)
     //
+    FinalBufferSize    = HwdbgPacketGetEncodedSize(Offset, BufferLength);
     CHAR * FinalBuffer = (CHAR *)malloc(FinalBufferSize);
 
     if (!FinalBuffer)
@@ -488,37 +663,31 @@ HwdbgInterpreterSendPacketAndBufferToHwdbg(HWDBG_INSTANCE_INFORMATION * Instance
         return FALSE;
     }
 
-    RtlZeroMemory(FinalBuffer, FinalBufferSize);
-
-    //
-    // Leave the offset
-    //
-    SIZE_T Offset = g_HwdbgInstanceInfoIsValid ? InstanceInfo->debuggerAreaOffset : DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET;
-
     //
-    // Copy the packet into the FinalBuffer
+    // Make the packet's structure and copy the buffer (if available) after it
     //
-    memcpy(FinalBuffer + Offset, &Packet, sizeof(DEBUGGER_REMOTE_PACKET));
-
-    //
-    // Copy the buffer (if available) into the FinalBuffer
-    //
-    if (Buffer != NULL)
-    {
-        memcpy(FinalBuffer + Offset + sizeof(DEBUGGER_REMOTE_PACKET), Buffer, BufferLength);
-    }
+    HwdbgPacketEncode(FinalBuffer, FinalBufferSize, Offset, PacketType, RequestedAction, Buffer, BufferLength);
 
     //
     // Here you would send FinalBuffer to the hardware debugger
     //
-    HwdbgInterpreterFillFileFromMemory(InstanceInfo, FileName, (UINT32 *)FinalBuffer, FinalBufferSize, RequestedAction);
+    Result = HwdbgInterpreterFillFileFromMemory(InstanceInfo, FileName, (UINT32 *)FinalBuffer, FinalBufferSize, RequestedAction);
 
     //
     // Free the allocated memory after use
     //
     free(FinalBuffer);
 
-    return TRUE;
+    //
+    // Binary images are shared with hwdbg, so the response is in the same
+    // image once hwdbg handled the packet
+    //
+    if (Result && HwdbgInterpreterIsBinaryImageFile(FileName))
+    {
+        Result = HwdbgInterpreterWaitForResponse(FileName);
+    }
+
+    return Result;
 }
 
 /**
@@ -540,6 +709,7 @@ HwdbgShowIntanceInfo(HWDBG_INSTANCE_INFORMATION * InstanceInfo)
     ShowMessages("Debuggee Number of Supported Temporary Variables: 0x%x\n", InstanceInfo->numberOfSupportedTemporaryVariables);
     ShowMessages("Debuggee Maximum Number Of Supported GET Script Operators: 0x%x\n", InstanceInfo->maximumNumberOfSupportedGetScriptOperators);
     ShowMessages("Debuggee Maximum Number Of Supported SET Script Operators: 0x%x\n", InstanceInfo->maximumNumberOfSupportedSetScriptOperators);
+    ShowMessages("Debuggee Maximum Number Of Operators Per Stage: 0x%x\n", InstanceInfo->maximumNumberOfOperatorsPerStage);
     ShowMessages("Debuggee Shared Memory Size: 0x%x\n", InstanceInfo->sharedMemorySize);
     ShowMessages("Debuggee Debugger Area Offset: 0x%x\n", InstanceInfo->debuggerAreaOffset);
     ShowMessages("Debuggee Debuggee Area Offset: 0x%x\n", InstanceInfo->debuggeeAreaOffset);
@@ -556,6 +726,9 @@ HwdbgShowIntanceInfo(HWDBG_INSTANCE_INFORMATION * InstanceInfo)
     ShowMessages("Debuggee BRAM Address Width: 0x%x\n", InstanceInfo->bramAddrWidth);
     ShowMessages("Debuggee BRAM Data Width: 0x%x (%d bit)\n", InstanceInfo->bramDataWidth, InstanceInfo->bramDataWidth);
 
+    ShowMessages("Debuggee Capture Buffer Depth: 0x%x (%d entries)\n", InstanceInfo->captureBufferDepth, InstanceInfo->captureBufferDepth);
+    ShowMessages("Debuggee Capture Run Length Width: 0x%x (%d bit)\n", InstanceInfo->captureRunLengthWidth, InstanceInfo->captureRunLengthWidth);
+
     for (auto item : g_HwdbgPortConfiguration)
     {
         ShowMessages("Port number %d ($hw_port%d): 0x%x\n", PortNum, PortNum, item);
@@ -576,8 +749,28 @@ HwdbgReadInstanceInfoFromFile(const TCHAR * FileName, UINT32 * MemoryBuffer, siz
 {
     TCHAR TestFilePath[MAX_PATH] = {0};
 
-    if (SetupPathForFileName(HWDBG_TEST_READ_INSTANCE_INFO_PATH, TestFilePath, sizeof(TestFilePath), TRUE) &&
-        HwdbgInterpreterFillMemoryFromFile(TestFilePath, MemoryBuffer, BufferSize))
+    if (!HwdbgInterpreterSetupPacketPath(FileName, TestFilePath, sizeof(TestFilePath), FALSE))
+    {
+        return FALSE;
+    }
+
+    //
+    // Binary images are shared with hwdbg, so the instance info should be
+    // requested before reading it
+    //
+    if (HwdbgInterpreterIsBinaryImageFile(TestFilePath) &&
+        !HwdbgInterpreterSendPacketAndBufferToHwdbg(
+            &g_HwdbgInstanceInfo,
+            TestFilePath,
+            DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+            hwdbgActionSendInstanceInfo,
+            NULL,
+            NULL_ZERO))
+    {
+        return FALSE;
+    }
+
+    if (HwdbgInterpreterFillMemoryFromFile(TestFilePath, MemoryBuffer, BufferSize))
     {
         //
         // Print the content of MemoryBuffer for verification
@@ -617,7 +810,7 @@ HwdbgWriteTestInstanceInfoRequestIntoFile(HWDBG_INSTANCE_INFORMATION * InstanceI
     //
     // Write test instance info request into a file
     //
-    if (SetupPathForFileName(FileName, TestFilePath, sizeof(TestFilePath), FALSE) &&
+    if (HwdbgInterpreterSetupPacketPath(FileName, TestFilePath, sizeof(TestFilePath), FALSE) &&
         HwdbgInterpreterSendPacketAndBufferToHwdbg(
             InstanceInfo,
             TestFilePath,
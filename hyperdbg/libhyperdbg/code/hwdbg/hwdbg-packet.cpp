@@ -0,0 +1,313 @@
+/**
+ * @file hwdbg-packet.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Encoding and decoding hwdbg packets and BRAM images
+ * @details The layout of the packets, the binary BRAM images, and the text
+ * hex files is implemented here once, and it's used by the interpreter of
+ * hwdbg and the co-simulation harness (hwdbg/sim/verilator), thus this file
+ * should not depend on Windows
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Compute the checksum of a buffer (same as KdComputeDataChecksum)
+ *
+ * @param Buffer
+ * @param Length
+ *
+ * @return BYTE
+ */
+BYTE
+HwdbgPacketComputeChecksum(const VOID * Buffer, SIZE_T Length)
+{
+    const BYTE * Bytes    = (const BYTE *)Buffer;
+    BYTE         Checksum = 0;
+
+    while (Length--)
+    {
+        Checksum += *Bytes++;
+    }
+
+    return Checksum;
+}
+
+/**
+ * @brief Compute the size of the buffer that holds an encoded packet
+ *
+ * @param DebuggerAreaOffset
+ * @param PayloadLength
+ *
+ * @return SIZE_T
+ */
+SIZE_T
+HwdbgPacketGetEncodedSize(UINT32 DebuggerAreaOffset, UINT32 PayloadLength)
+{
+    return (SIZE_T)DebuggerAreaOffset + sizeof(DEBUGGER_REMOTE_PACKET) + PayloadLength;
+}
+
+/**
+ * @brief Encode a HyperDbg packet (+ the payload) into the debugger area of the BRAM
+ * @details The buffer should be at least HwdbgPacketGetEncodedSize bytes, the
+ * bytes before the debugger area are zeroed
+ *
+ * @param Buffer
+ * @param BufferSize
+ * @param DebuggerAreaOffset
+ * @param PacketType
+ * @param RequestedAction
+ * @param Payload
+ * @param PayloadLength
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgPacketEncode(VOID *                      Buffer,
+                  SIZE_T                      BufferSize,
+                  UINT32                      DebuggerAreaOffset,
+                  DEBUGGER_REMOTE_PACKET_TYPE PacketType,
+                  HWDBG_ACTION_ENUMS          RequestedAction,
+                  const VOID *                Payload,
+                  UINT32                      PayloadLength)
+{
+    DEBUGGER_REMOTE_PACKET Packet = {0};
+
+    //
+    // If payload is not available, then the length is zero
+    //
+    if (Payload == NULL)
+    {
+        PayloadLength = 0;
+    }
+
+    if (HwdbgPacketGetEncodedSize(DebuggerAreaOffset, PayloadLength) > BufferSize)
+    {
+        return FALSE;
+    }
+
+    //
+    // Make the packet's structure
+    //
+    Packet.Indicator                  = INDICATOR_OF_HYPERDBG_PACKET;
+    Packet.TypeOfThePacket            = PacketType;
+    Packet.RequestedActionOfThePacket = (DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION)RequestedAction;
+
+    //
+    // Calculate checksum of the packet (the checksum itself is not counted)
+    //
+    Packet.Checksum = HwdbgPacketComputeChecksum((const BYTE *)&Packet + sizeof(BYTE),
+                                                 sizeof(DEBUGGER_REMOTE_PACKET) - sizeof(BYTE));
+
+    if (Payload != NULL)
+    {
+        Packet.Checksum += HwdbgPacketComputeChecksum(Payload, PayloadLength);
+    }
+
+    //
+    // Leave the offset and copy the packet and the payload after it
+    //
+    memset(Buffer, 0, DebuggerAreaOffset);
+    memcpy((CHAR *)Buffer + DebuggerAreaOffset, &Packet, sizeof(DEBUGGER_REMOTE_PACKET));
+
+    if (Payload != NULL)
+    {
+        memcpy((CHAR *)Buffer + DebuggerAreaOffset + sizeof(DEBUGGER_REMOTE_PACKET), Payload, PayloadLength);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Decode the HyperDbg packet in the debuggee area of the BRAM
+ * @details The checksum is ignored for hwdbg, and the type of the packet is
+ * checked by the caller
+ *
+ * @param Buffer
+ * @param BufferSize
+ * @param DebuggeeAreaOffset
+ *
+ * @return DEBUGGER_REMOTE_PACKET * NULL if there is no HyperDbg packet
+ */
+DEBUGGER_REMOTE_PACKET *
+HwdbgPacketDecode(const VOID * Buffer, SIZE_T BufferSize, UINT32 DebuggeeAreaOffset)
+{
+    DEBUGGER_REMOTE_PACKET * Packet;
+
+    if ((SIZE_T)DebuggeeAreaOffset + sizeof(DEBUGGER_REMOTE_PACKET) > BufferSize)
+    {
+        return NULL;
+    }
+
+    Packet = (DEBUGGER_REMOTE_PACKET *)((const CHAR *)Buffer + DebuggeeAreaOffset);
+
+    if (Packet->Indicator != INDICATOR_OF_HYPERDBG_PACKET)
+    {
+        return NULL;
+    }
+
+    return Packet;
+}
+
+/**
+ * @brief Initialize the header of a binary BRAM image
+ *
+ * @param Header
+ * @param NumberOfWords
+ *
+ * @return VOID
+ */
+VOID
+HwdbgPacketInitializeBramImageHeader(HWDBG_BRAM_IMAGE_HEADER * Header, UINT32 NumberOfWords)
+{
+    memset(Header, 0, sizeof(HWDBG_BRAM_IMAGE_HEADER));
+
+    Header->Magic         = HWDBG_BRAM_IMAGE_MAGIC;
+    Header->Version       = HWDBG_BRAM_IMAGE_VERSION;
+    Header->HeaderSize    = sizeof(HWDBG_BRAM_IMAGE_HEADER);
+    Header->NumberOfWords = NumberOfWords;
+}
+
+/**
+ * @brief Check whether the header of a binary BRAM image is valid
+ *
+ * @param Header
+ * @param ImageSize size of the whole image, or zero if the content is not checked
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HwdbgPacketIsValidBramImageHeader(const HWDBG_BRAM_IMAGE_HEADER * Header, UINT64 ImageSize)
+{
+    if (Header->Magic != HWDBG_BRAM_IMAGE_MAGIC ||
+        Header->Version != HWDBG_BRAM_IMAGE_VERSION ||
+        Header->HeaderSize < sizeof(HWDBG_BRAM_IMAGE_HEADER))
+    {
+        return FALSE;
+    }
+
+    return ImageSize == 0 ||
+           ImageSize >= (UINT64)Header->HeaderSize + (UINT64)Header->NumberOfWords * sizeof(UINT32);
+}
+
+/**
+ * @brief Parse a single line of a text hex file of the BRAM
+ * @details Both the requests (a hex word per line, same as readmemh) and the
+ * responses of the test bench ("mem_N: hex word") are accepted, and the
+ * comments (after ';', '|', or '//') are ignored
+ *
+ * @param Line
+ * @param Values the words of the line are appended to it
+ *
+ * @return BOOLEAN FALSE if the line contains anything other than hex words
+ */
+BOOLEAN
+HwdbgPacketParseTextLine(const std::string & Line, std::vector<UINT32> & Values)
+{
+    SIZE_T End   = std::min(std::min(Line.find(';'), Line.find('|')), Line.find("//"));
+    SIZE_T Start = Line.find(':');
+    SIZE_T TokenEnd;
+
+    if (End == std::string::npos)
+    {
+        End = Line.length();
+    }
+
+    //
+    // Skip the memory address part
+    //
+    Start = (Start < End) ? Start + 1 : 0;
+
+    while (TRUE)
+    {
+        Start = Line.find_first_not_of(" \t\r\n", Start);
+
+        if (Start == std::string::npos || Start >= End)
+        {
+            return TRUE;
+        }
+
+        TokenEnd = std::min<SIZE_T>(Line.find_first_of(" \t\r\n", Start), End);
+
+        if (TokenEnd - Start > 8 ||
+            !std::all_of(Line.begin() + Start, Line.begin() + TokenEnd, ::isxdigit))
+        {
+            return FALSE;
+        }
+
+        Values.push_back((UINT32)std::stoul(Line.substr(Start, TokenEnd - Start), nullptr, 16));
+
+        Start = TokenEnd;
+    }
+}
+
+/**
+ * @brief Write the BRAM as a text hex file (readable by readmemh)
+ * @details The header of the packet is annotated, and if the size of the
+ * shared memory is specified, zeros are added to the end of the file to
+ * fill the shared memory
+ *
+ * @param Stream
+ * @param Words
+ * @param NumberOfWords
+ * @param SharedMemorySize size of the shared memory (in bytes) or zero
+ * @param RequestedAction
+ *
+ * @return VOID
+ */
+VOID
+HwdbgPacketWriteTextFile(std::ostream & Stream,
+                         const UINT32 * Words,
+                         SIZE_T         NumberOfWords,
+                         SIZE_T         SharedMemorySize,
+                         UINT32         RequestedAction)
+{
+    SIZE_T Address = 0;
+
+    for (SIZE_T I = 0; I < NumberOfWords; ++I)
+    {
+        Stream << std::hex << std::setw(8) << std::setfill('0') << Words[I];
+        Stream << " ; +0x" << std::hex << std::setw(1) << std::setfill('0') << Address;
+
+        if (I == 0 || I == 1)
+        {
+            Stream << "   | Checksum";
+        }
+        else if (I == 2 || I == 3)
+        {
+            Stream << "   | Indicator";
+        }
+        else if (I == 4)
+        {
+            Stream << "  | TypeOfThePacket - DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL (0x4)";
+        }
+        else if (I == 5)
+        {
+            Stream << "  | RequestedActionOfThePacket - Value" << " (0x" << std::hex << std::setw(1) << std::setfill('0') << RequestedAction << ")";
+        }
+        else if (I == 6)
+        {
+            Stream << "  | Start of Optional Data";
+        }
+
+        Stream << "\n";
+        Address += sizeof(UINT32);
+    }
+
+    //
+    // Add zeros to the end of the file to fill the shared memory
+    //
+    while (Address < SharedMemorySize)
+    {
+        Stream << "00000000 ; +0x" << std::hex << std::setw(1) << std::setfill('0') << Address;
+        Address += sizeof(UINT32);
+
+        if (Address < SharedMemorySize)
+        {
+            Stream << "\n";
+        }
+    }
+}
@@ -50,7 +50,7 @@ HwdbgScriptPrintScriptBuffer(CHAR * ScriptBuffer, UINT32 ScriptBufferSize)
  * @param InstanceInfo
  * @param ScriptBuffer
  * @param ScriptBufferSize
- * @param NumberOfStagesForScript
+ * @param NumberOfStagesForScript Number of stages after packing the operators
  * @param NewScriptBuffer
  * @param NewCompressedBufferSize
  * @param NumberOfBytesPerChunk
@@ -61,7 +61,7 @@ BOOLEAN
 HwdbgScriptCompressScriptBuffer(HWDBG_INSTANCE_INFORMATION * InstanceInfo,
                                 SYMBOL *                     ScriptBuffer,
                                 size_t                       ScriptBufferSize,
-                                UINT32                       NumberOfStagesForScript,
+                                UINT32 *                     NumberOfStagesForScript,
                                 HWDBG_SHORT_SYMBOL **        NewScriptBuffer,
                                 size_t *                     NewCompressedBufferSize,
                                 size_t *                     NumberOfBytesPerChunk)
@@ -203,11 +203,11 @@ HwdbgScriptWriteScriptConfigurationPacketIntoFile(HWDBG_INSTANCE_INFORMATION * I
 
     ShowMessages("\n\nwriting script configuration packet into the file\n");
 
-    if (SetupPathForFileName(FileName, TestFilePath, sizeof(TestFilePath), FALSE) &&
+    if (HwdbgInterpreterSetupPacketPath(FileName, TestFilePath, sizeof(TestFilePath), FALSE) &&
         HwdbgScriptSendScriptPacket(
             InstanceInfo,
             TestFilePath,
-            NumberOfStagesForScript + NumberOfOperandsImplemented - 1, // Number of symbols = Number of stages + Number of operands - 1
+            NumberOfStagesForScript * InstanceInfo->maximumNumberOfOperatorsPerStage + NumberOfOperandsImplemented - 1, // Number of symbols = Number of operators + Number of operands - 1
             NewScriptBuffer,
             (UINT32)NewCompressedBufferSize))
     {
@@ -235,6 +235,7 @@ HwdbgScriptCreateHwdbgScript(CHAR *        ScriptBuffer,
                              const TCHAR * HardwareScriptFilePathToSave)
 {
     UINT32               NumberOfStagesForScript               = 0;
+    UINT32               NumberOfOperatorsForScript            = 0;
     UINT32               NumberOfOperandsImplemented           = 0;
     UINT32               NumberOfOperandsForScript             = 0;
     size_t               NewCompressedBufferSize               = 0;
@@ -260,13 +261,18 @@ HwdbgScriptCreateHwdbgScript(CHAR *        ScriptBuffer,
         ShowMessages("\n[+] target script is supported by this instance of hwdbg!\n");
     }
 
+    //
+    // Each operator needs one stage without fusing operators
+    //
+    NumberOfOperatorsForScript = NumberOfStagesForScript;
+
     //
     // *** Compress the script buffer based on the instance info ***
     //
     if (!HwdbgScriptCompressScriptBuffer(&g_HwdbgInstanceInfo,
                                          (SYMBOL *)ScriptBuffer,
                                          ScriptBufferSize,
-                                         NumberOfStagesForScript,
+                                         &NumberOfStagesForScript,
                                          &NewScriptBuffer,
                                          &NewCompressedBufferSize,
                                          &NumberOfBytesPerChunk))
@@ -275,6 +281,19 @@ HwdbgScriptCreateHwdbgScript(CHAR *        ScriptBuffer,
         return FALSE;
     }
 
+    //
+    // The operands of the fused operators are also implemented
+    //
+    NumberOfOperandsImplemented = NumberOfStagesForScript *
+                                  g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage *
+                                  (g_HwdbgInstanceInfo.maximumNumberOfSupportedGetScriptOperators + g_HwdbgInstanceInfo.maximumNumberOfSupportedSetScriptOperators);
+
+    ShowMessages("\n[*] %d operators are packed into %d stages (maximum operators per stage: %d, supported stages: %d)\n",
+                 NumberOfOperatorsForScript,
+                 NumberOfStagesForScript,
+                 g_HwdbgInstanceInfo.maximumNumberOfOperatorsPerStage,
+                 g_HwdbgInstanceInfo.maximumNumberOfStages);
+
     //
     // Print the hwdbg script buffer
     //
@@ -0,0 +1,178 @@
+/**
+ * @file command-parser.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the command parser (tokenizer) and the dispatch table of commands
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of tokens that are reserved for each command (most of
+ * the commands have fewer tokens)
+ *
+ */
+#define COMMAND_PARSER_RESERVED_TOKENS 16
+
+/**
+ * @brief Maximum number of seeds that are tried for each bucket of the
+ * dispatch table before the table is enlarged
+ *
+ */
+#define COMMAND_DISPATCH_MAXIMUM_SEEDS 0x10000
+
+/**
+ * @brief Maximum number of slots of the dispatch table
+ *
+ */
+#define COMMAND_DISPATCH_MAXIMUM_SLOTS 0x10000
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief A token of the command
+ * @details The text of the token is either a part of the command itself
+ * (zero-copy) or a part of the storage of the parser, if the token is
+ * rewritten (e.g., escaped characters or comments of the scripts)
+ *
+ */
+typedef struct _COMMAND_PARSER_TOKEN
+{
+    CommandParsingTokenType Type;            // Numbers are detected once the token is converted
+    BOOLEAN                 IsNumberAllowed; // The token could be converted to a number
+    BOOLEAN                 IsInStorage;     // The offset is in the storage of the parser
+    UINT32                  Offset;
+    UINT32                  Length;
+
+} COMMAND_PARSER_TOKEN, *PCOMMAND_PARSER_TOKEN;
+
+/**
+ * @brief An entry of the dispatch table
+ * @details The name points to the key of the list of commands
+ *
+ */
+typedef struct _COMMAND_DISPATCH_ENTRY
+{
+    const CHAR *    Name; // NULL if the slot is empty
+    UINT32          Length;
+    PCOMMAND_DETAIL Detail;
+
+} COMMAND_DISPATCH_ENTRY, *PCOMMAND_DISPATCH_ENTRY;
+
+/**
+ * @brief The dispatch table of commands (a perfect hash table)
+ * @details The hash of each name selects a bucket, and the seed of the
+ * bucket selects the slot of the name, the seeds are chosen once the
+ * commands are initialized so that the slots never collide, thus each
+ * lookup is a single hash and a single comparison
+ *
+ */
+typedef struct _COMMAND_DISPATCH_TABLE
+{
+    BOOLEAN                             IsBuilt;
+    UINT32                              BucketMask;
+    UINT32                              SlotMask;
+    std::vector<UINT32>                 Seeds;
+    std::vector<COMMAND_DISPATCH_ENTRY> Slots;
+
+} COMMAND_DISPATCH_TABLE, *PCOMMAND_DISPATCH_TABLE;
+
+//////////////////////////////////////////////////
+//				     Classes					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The command parser
+ * @details The command is tokenized in a single pass and the tokens refer
+ * to the command, tokens are only converted to strings (CommandToken) once
+ * the command is executed locally
+ *
+ */
+class CommandParser
+{
+public:
+    CommandParser();
+
+    VOID Tokenize(const CHAR * Input, SIZE_T Length);
+
+    UINT32 GetTokenCount() const;
+
+    const CHAR * GetTokenText(UINT32 Index, UINT32 * Length) const;
+
+    BOOLEAN IsTokenEqual(UINT32 Index, const CHAR * LowerCaseText) const;
+
+    std::string GetTokenString(UINT32 Index) const;
+
+    std::vector<CommandToken> GetCommandTokens() const;
+
+    std::vector<CommandToken> Parse(const std::string & Input);
+
+    std::string TokenTypeToString(CommandParsingTokenType Type);
+
+    VOID PrintTokens(const std::vector<CommandToken> & Tokens);
+
+private:
+    CHAR GetChar(SIZE_T Position) const;
+
+    SIZE_T GetPreviousPosition(SIZE_T Position) const;
+
+    SIZE_T GetNextPosition(SIZE_T Position) const;
+
+    CHAR GetPreviousChar(SIZE_T Position) const;
+
+    BOOLEAN IsErased(SIZE_T Position) const;
+
+    VOID Erase(SIZE_T Position);
+
+    SIZE_T Find(CHAR Character, SIZE_T Position) const;
+
+    SIZE_T FindEscapedNewLine(SIZE_T Position) const;
+
+    VOID Append(SIZE_T Position);
+
+    VOID AppendRun(SIZE_T Start, SIZE_T End);
+
+    VOID AppendRange(SIZE_T Start, SIZE_T End, BOOLEAN FixEscapedNewLines);
+
+    VOID RemoveLastCharacter();
+
+    BOOLEAN IsCurrentEmptyOrSpace() const;
+
+    VOID ClearCurrent();
+
+    VOID AddToken(CommandParsingTokenType Type, BOOLEAN IsNumberAllowed, BOOLEAN ShouldTrim);
+
+    const CHAR *                      m_Input;
+    SIZE_T                            m_Length;
+    std::vector<BOOLEAN>              m_Erased; // Only allocated if characters after the current position are erased
+    std::string                       m_Storage;
+    std::vector<COMMAND_PARSER_TOKEN> m_Tokens;
+
+    //
+    // The token that is being parsed, it's a range of the input unless
+    // it's rewritten, then it's the end of the storage
+    //
+    BOOLEAN m_IsCurrentInStorage;
+    SIZE_T  m_CurrentStart;
+    SIZE_T  m_CurrentEnd;
+};
+
+//////////////////////////////////////////////////
+//            	    Functions                   //
+//////////////////////////////////////////////////
+
+BOOLEAN
+CommandDispatchBuildTable(CommandType & Commands, PCOMMAND_DISPATCH_TABLE Table);
+
+PCOMMAND_DETAIL
+CommandDispatchFind(PCOMMAND_DISPATCH_TABLE Table, const CHAR * Name, UINT32 Length);
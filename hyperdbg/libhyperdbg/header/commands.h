@@ -113,6 +113,14 @@ HyperDbgCheckWhetherTheCurrentInstructionIsRet(
     UINT64          BuffLength,
     BOOLEAN         Isx86_64);
 
+UINT32
+HyperDbgShowMemoryOperandsOfInstruction(
+    unsigned char *    BufferToDisassemble,
+    UINT64             BuffLength,
+    UINT64             CurrentRip,
+    BOOLEAN            Isx86_64,
+    const GUEST_REGS * Registers);
+
 VOID
 HyperDbgShowMemoryOrDisassemble(DEBUGGER_SHOW_MEMORY_STYLE   Style,
                                 UINT64                       Address,
@@ -145,9 +153,6 @@ CheckMultilineCommand(CHAR * CurrentCommand, BOOLEAN Reset);
 BOOLEAN
 ContinuePreviousCommand();
 
-VOID
-CommandDumpSaveIntoFile(PVOID Buffer, UINT32 Length);
-
 //////////////////////////////////////////////////
 //              Type of Commands                //
 //////////////////////////////////////////////////
@@ -200,16 +205,38 @@ typedef struct _COMMAND_DETAIL
  */
 typedef std::map<std::string, COMMAND_DETAIL> CommandType;
 
+/**
+ * @brief Maximum number of independent commands of batch scripts that are
+ * sent to the remote debuggee without waiting for their results
+ *
+ */
+#define SCRIPT_BATCH_MAXIMUM_REQUESTS_IN_FLIGHT 32
+
+/**
+ * @brief A command of the script that is parsed before the execution
+ *
+ */
+typedef struct _SCRIPT_BATCH_COMMAND
+{
+    std::string Command;
+    BOOLEAN     IsIndependent;
+
+} SCRIPT_BATCH_COMMAND, *PSCRIPT_BATCH_COMMAND;
+
 /**
  * @brief Different attributes of commands
+ * @details Independent commands only query the debuggee or register events,
+ * the next commands don't depend on their results, so batch scripts send
+ * them to the remote debuggee without waiting for their results
  *
  */
 #define DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE     0x1
-#define DEBUGGER_COMMAND_ATTRIBUTE_EVENT                              0x2 | DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+#define DEBUGGER_COMMAND_ATTRIBUTE_EVENT                              0x2 | DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 #define DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_REMOTE_CONNECTION 0x4
 #define DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER                    0x8
 #define DEBUGGER_COMMAND_ATTRIBUTE_WONT_STOP_DEBUGGER_AGAIN           0x10
 #define DEBUGGER_COMMAND_ATTRIBUTE_HWDBG                              0x20
+#define DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT                        0x40
 
 /**
  * @brief Absolute local commands
@@ -315,19 +342,23 @@ typedef std::map<std::string, COMMAND_DETAIL> CommandType;
 
 #define DEBUGGER_COMMAND_RDMSR_ATTRIBUTES NULL
 
-#define DEBUGGER_COMMAND_VA2PA_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+#define DEBUGGER_COMMAND_VA2PA_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
-#define DEBUGGER_COMMAND_PA2VA_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+#define DEBUGGER_COMMAND_PA2VA_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_FORMATS_ATTRIBUTES \
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER
 
-#define DEBUGGER_COMMAND_PTE_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+#define DEBUGGER_COMMAND_PTE_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_APIC_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
 #define DEBUGGER_COMMAND_IOAPIC_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
+#define DEBUGGER_COMMAND_VMEXITPROF_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+
+#define DEBUGGER_COMMAND_SNAPSHOT_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+
 #define DEBUGGER_COMMAND_CORE_ATTRIBUTES \
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
@@ -387,16 +418,16 @@ typedef std::map<std::string, COMMAND_DETAIL> CommandType;
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER
 
 #define DEBUGGER_COMMAND_D_AND_U_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_E_ATTRIBUTES \
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
 #define DEBUGGER_COMMAND_S_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_R_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_BP_ATTRIBUTES \
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
@@ -420,23 +451,25 @@ typedef std::map<std::string, COMMAND_DETAIL> CommandType;
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
 #define DEBUGGER_COMMAND_X_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_PREALLOC_ATTRIBUTES NULL
 
 #define DEBUGGER_COMMAND_PREACTIVATE_ATTRIBUTES NULL
 
 #define DEBUGGER_COMMAND_K_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_DT_ATTRIBUTES \
-    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER
+    DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE | DEBUGGER_COMMAND_ATTRIBUTE_REPEAT_ON_ENTER | DEBUGGER_COMMAND_ATTRIBUTE_INDEPENDENT
 
 #define DEBUGGER_COMMAND_STRUCT_ATTRIBUTES \
     DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
 
 #define DEBUGGER_COMMAND_PE_ATTRIBUTES NULL
 
+#define DEBUGGER_COMMAND_TRACEFILE_ATTRIBUTES NULL
+
 #define DEBUGGER_COMMAND_REV_ATTRIBUTES NULL
 
 #define DEBUGGER_COMMAND_TRACK_ATTRIBUTES DEBUGGER_COMMAND_ATTRIBUTE_LOCAL_COMMAND_IN_DEBUGGER_MODE
@@ -715,6 +748,12 @@ CommandApic(vector<CommandToken> CommandTokens, string Command);
 VOID
 CommandIoapic(vector<CommandToken> CommandTokens, string Command);
 
+VOID
+CommandVmexitprof(vector<CommandToken> CommandTokens, string Command);
+
+VOID
+CommandSnapshot(vector<CommandToken> CommandTokens, string Command);
+
 VOID
 CommandTrack(vector<CommandToken> CommandTokens, string Command);
 
@@ -733,6 +772,9 @@ CommandAssemble(vector<CommandToken> CommandTokens, string Command);
 VOID
 CommandPcitree(vector<CommandToken> CommandTokens, string Command);
 
+VOID
+CommandTracefile(vector<CommandToken> CommandTokens, string Command);
+
 //
 // hwdbg commands
 //
@@ -20,6 +20,17 @@
 #define COM3_PORT 0x03E8
 #define COM4_PORT 0x02E8
 
+//////////////////////////////////////////
+//			 Remote Constants            //
+//////////////////////////////////////////
+
+/**
+ * @brief Interval (in milliseconds) of checking whether the connection is
+ * still alive while waiting for the results of the remote debuggee
+ *
+ */
+#define REMOTE_CONNECTION_WAIT_FOR_RESULTS_INTERVAL 100
+
 //////////////////////////////////////////
 //			   	Server 		            //
 //////////////////////////////////////////
@@ -30,7 +41,7 @@ CommunicationServerCreateServerAndWaitForClient(PCSTR    Port,
                                                 SOCKET * ListenSocketArg);
 
 int
-CommunicationServerReceiveMessage(SOCKET ClientSocket, char * recvbuf, int recvbuflen);
+CommunicationServerReceiveMessage(SOCKET ClientSocket, char * recvbuf, int recvbuflen, PUINT32 BuffLenRecvd);
 
 int
 CommunicationServerSendMessage(SOCKET ClientSocket, const char * sendbuf, int length);
@@ -71,6 +82,12 @@ RemoteConnectionConnect(PCSTR Ip, PCSTR Port);
 int
 RemoteConnectionSendCommand(const char * sendbuf, int len);
 
+int
+RemoteConnectionSendPipelinedCommand(const char * sendbuf, int len, BOOLEAN ShowCommand);
+
+int
+RemoteConnectionWaitForResults(UINT32 Count);
+
 int
 RemoteConnectionSendResultsToHost(const char * sendbuf, int len);
 
@@ -58,6 +58,9 @@
 #define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_WRITE_REGISTER                      0x1a
 #define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_PCITREE_RESULT                      0x1b
 #define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_APIC_ACTIONS                        0x1c
+#define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_VMEXIT_PROFILER_ACTIONS             0x1d
+#define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_DIRTY_PAGES_ACTIONS                 0x1e
+#define DEBUGGER_SYNCRONIZATION_OBJECT_KERNEL_DEBUGGER_SNAPSHOT_ACTIONS                    0x1f
 
 //////////////////////////////////////////////////
 //               Event Details                  //
@@ -175,9 +178,16 @@ InterpretGeneralEventAndActionsFields(
 BOOLEAN
 CallstackReturnAddressToCallingAddress(UCHAR * ReturnAddress, PUINT32 IndexOfCallFromReturnAddress);
 
+BOOLEAN
+CallstackShowExportNameBasedOnAddress(UINT64 Address);
+
+BOOLEAN
+CallstackShowImportNameOfCall(UINT64 ReturnAddress, UCHAR * InstructionBytes, BOOLEAN Is32Bit);
+
 VOID
 CallstackShowFrames(PDEBUGGER_SINGLE_CALLSTACK_FRAME  CallstackFrames,
                     UINT32                            FrameCount,
+                    UINT32                            UnwoundFrameCount,
                     DEBUGGER_CALLSTACK_DISPLAY_METHOD DisplayMethod,
                     BOOLEAN                           Is32Bit);
 
@@ -199,6 +209,9 @@ BreakController(DWORD CtrlType);
 VOID
 CommandEventsShowEvents();
 
+VOID
+CommandEventsShowEventsCosts();
+
 BOOLEAN
 CommandEventsModifyAndQueryEvents(UINT64                      Tag,
                                   DEBUGGER_MODIFY_EVENTS_TYPE TypeOfAction);
@@ -242,6 +255,9 @@ CommandTrackHandleReceivedCallInstructions(const char * NameOfFunctionFromSymbol
 VOID
 CommandTrackHandleReceivedRetInstructions(UINT64 CurrentRip);
 
+VOID
+CommandTrackHandleReceivedEdgeRecord(PDEBUGGEE_STEP_TRACE_EDGE_RECORD Record);
+
 BOOLEAN
 HyperDbgWriteMemory(PVOID                     DestinationAddress,
                     DEBUGGER_EDIT_MEMORY_TYPE MemoryType,
@@ -291,3 +307,30 @@ CommandApicSendRequest(DEBUGGER_APIC_REQUEST_TYPE ApicType,
                        PVOID                      ApicBuffer,
                        UINT32                     ExpectedRequestSize,
                        PBOOLEAN                   IsUsingX2APIC);
+
+BOOLEAN
+HyperDbgVmexitProfilerEnable(BOOLEAN Enable);
+
+BOOLEAN
+HyperDbgVmexitProfilerReset();
+
+BOOLEAN
+HyperDbgVmexitProfilerQuery(UINT32 CoreId, PVMEXIT_PROFILER_RESULTS Results, PBOOLEAN IsEnabled);
+
+BOOLEAN
+HyperDbgSnapshotTake(UINT64 StartAddress, UINT64 EndAddress, UINT32 MaximumPages);
+
+BOOLEAN
+HyperDbgSnapshotRestore();
+
+BOOLEAN
+HyperDbgSnapshotDiscard();
+
+BOOLEAN
+HyperDbgSnapshotQuery(PDEBUGGER_SNAPSHOT_STATISTICS Statistics, PBOOLEAN IsTaken);
+
+UINT64
+VmexitProfilerEstimatePercentile(const VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT32 Percentile);
+
+UINT64
+VmexitProfilerSortExitReasons(const VMEXIT_PROFILER_RESULTS * Results, vector<UINT32> & SortedReasons);
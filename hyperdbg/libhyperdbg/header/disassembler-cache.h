@@ -0,0 +1,99 @@
+/**
+ * @file disassembler-cache.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the decoded instructions cache of the disassembler
+ * @details This file needs the Zydis headers, so it's included after them
+ * (not in the pre-compiled headers)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//					Constants                   //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of instructions in the decoded instructions cache
+ *
+ */
+#define DISASSEMBLER_CACHE_MAXIMUM_ENTRIES 2048
+
+/**
+ * @brief Number of hash buckets of the decoded instructions cache
+ * (should be a power of two)
+ *
+ */
+#define DISASSEMBLER_CACHE_HASH_BUCKETS 4096
+
+/**
+ * @brief Shows an empty link in the decoded instructions cache
+ *
+ */
+#define DISASSEMBLER_CACHE_INVALID_INDEX 0xffffffff
+
+//////////////////////////////////////////////////
+//					Structures                  //
+//////////////////////////////////////////////////
+
+/**
+ * @brief An instruction in the decoded instructions cache
+ * @details The key is the mode, the address, and the bytes that the
+ * instruction is decoded from (at most ZYDIS_MAX_INSTRUCTION_LENGTH bytes)
+ *
+ */
+typedef struct _DISASSEMBLER_CACHE_ENTRY
+{
+    UINT64                  Address;
+    UINT32                  Mode;
+    UINT32                  Hash;
+    UINT32                  WindowLength;
+    UINT32                  NextInBucket;
+    UINT32                  MoreRecent; // Links of the LRU list
+    UINT32                  LessRecent;
+    ZyanU8                  Bytes[ZYDIS_MAX_INSTRUCTION_LENGTH];
+    ZydisDecodedInstruction Instruction;
+    ZydisDecodedOperand     Operands[ZYDIS_MAX_OPERAND_COUNT];
+
+} DISASSEMBLER_CACHE_ENTRY, *PDISASSEMBLER_CACHE_ENTRY;
+
+/**
+ * @brief The decoded instructions cache (LRU)
+ *
+ */
+typedef struct _DISASSEMBLER_CACHE
+{
+    volatile LONG            Lock;
+    UINT32                   Buckets[DISASSEMBLER_CACHE_HASH_BUCKETS];
+    UINT32                   CountOfEntries;
+    UINT32                   MostRecent;
+    UINT32                   LeastRecent;
+    DISASSEMBLER_CACHE_ENTRY Entries[DISASSEMBLER_CACHE_MAXIMUM_ENTRIES];
+
+} DISASSEMBLER_CACHE, *PDISASSEMBLER_CACHE;
+
+//////////////////////////////////////////////////
+//					Functions                   //
+//////////////////////////////////////////////////
+
+VOID
+DisassemblerCacheClear();
+
+BOOLEAN
+DisassemblerCacheLookup(UINT32                    Mode,
+                        UINT64                    Address,
+                        const ZyanU8 *            Buffer,
+                        UINT32                    WindowLength,
+                        ZydisDecodedInstruction * Instruction,
+                        ZydisDecodedOperand *     Operands);
+
+VOID
+DisassemblerCacheInsert(UINT32                          Mode,
+                        UINT64                          Address,
+                        const ZyanU8 *                  Buffer,
+                        UINT32                          WindowLength,
+                        const ZydisDecodedInstruction * Instruction,
+                        const ZydisDecodedOperand *     Operands);
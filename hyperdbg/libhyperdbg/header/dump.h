@@ -0,0 +1,267 @@
+/**
+ * @file dump.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers for the .dump command and its file formats
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of pages that are requested in one read request
+ * @details The request and its result should fit in one serial packet
+ * (MaxSerialPacketSize)
+ *
+ */
+#define DUMP_MAXIMUM_PAGES_PER_READ 16
+
+/**
+ * @brief Size of each of the buffers that are asynchronously written
+ * into the dump file
+ *
+ */
+#define DUMP_WRITE_BUFFER_SIZE (256 * PAGE_SIZE)
+
+/**
+ * @brief Number of write buffers (one is filled while the other one
+ * is being written)
+ *
+ */
+#define DUMP_WRITE_BUFFER_COUNT 2
+
+/**
+ * @brief Magic of the sparse dump files ('HDSPDUMP')
+ *
+ */
+#define DUMP_SPARSE_FILE_MAGIC 0x504d554450534448ull
+
+/**
+ * @brief Version of the sparse dump file format
+ *
+ */
+#define DUMP_SPARSE_FILE_VERSION 2
+
+/**
+ * @brief The first version of the sparse dump file format (without the
+ * incremental dumps), these files could still be resumed
+ *
+ */
+#define DUMP_SPARSE_FILE_VERSION_1 1
+
+/**
+ * @brief Size of the header of the first version of the sparse dump files
+ * (it ends before the fields of the incremental dumps)
+ *
+ */
+#define DUMP_SPARSE_FILE_HEADER_SIZE_V1 FIELD_OFFSET(DUMP_SPARSE_FILE_HEADER, CountOfUnchangedPages)
+
+/**
+ * @brief Offset of the page map in the sparse dump files
+ *
+ */
+#define DUMP_SPARSE_PAGE_MAP_OFFSET PAGE_SIZE
+
+/**
+ * @brief Page map entry of the pages that are not dumped yet
+ *
+ */
+#define DUMP_PAGE_MAP_ENTRY_NOT_DUMPED 0
+
+/**
+ * @brief Page map entry of the pages that are entirely filled with zero
+ *
+ */
+#define DUMP_PAGE_MAP_ENTRY_ZERO_PAGE 1
+
+/**
+ * @brief Page map entry of the pages that couldn't be read
+ *
+ */
+#define DUMP_PAGE_MAP_ENTRY_UNREADABLE_PAGE 2
+
+/**
+ * @brief Page map entry of the pages that are not modified since the
+ * previous dump (only in the incremental dumps)
+ *
+ */
+#define DUMP_PAGE_MAP_ENTRY_UNCHANGED_PAGE 3
+
+/**
+ * @brief Flag of the sparse dump files that only contain the pages that
+ * are modified since the previous dump (checkpoint) of the same range
+ *
+ */
+#define DUMP_SPARSE_FILE_FLAG_INCREMENTAL 0x1
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Header of the sparse dump files
+ * @details The header is located at the start of the file, followed by the
+ * page map at DUMP_SPARSE_PAGE_MAP_OFFSET. The page map contains one 64-bit
+ * entry for each page of the dumped range which is either one of the
+ * DUMP_PAGE_MAP_ENTRY_* values or the (page-aligned) file offset of the
+ * content of the page. The content of pages starts at DataOffset so the file
+ * could be mapped and the pages could be directly accessed by the tools. In
+ * the incremental dumps, the unchanged pages should be taken from the previous
+ * dumps of the same range
+ *
+ */
+typedef struct _DUMP_SPARSE_FILE_HEADER
+{
+    UINT64 Magic;
+    UINT32 Version;
+    UINT32 HeaderSize;
+    UINT64 StartAddress;
+    UINT64 EndAddress;
+    UINT32 MemoryType; // DEBUGGER_READ_MEMORY_TYPE
+    UINT32 ProcessId;
+    UINT64 CountOfPages;
+    UINT64 PageMapOffset;
+    UINT64 DataOffset;
+    UINT64 NextPageIndex;  // Index of the first page that is not dumped yet
+    UINT64 NextDataOffset; // File offset for the content of the next page
+    UINT64 CountOfPresentPages;
+    UINT64 CountOfZeroPages;
+    UINT64 CountOfUnreadablePages;
+    UINT64 CountOfUnchangedPages;
+    UINT32 Flags; // DUMP_SPARSE_FILE_FLAG_*
+    UINT32 Reserved;
+
+} DUMP_SPARSE_FILE_HEADER, *PDUMP_SPARSE_FILE_HEADER;
+
+/**
+ * @brief A buffer that is asynchronously written into the dump file
+ *
+ */
+typedef struct _DUMP_WRITE_BUFFER
+{
+    OVERLAPPED Overlapped;
+    BYTE *     Buffer;
+    UINT32     UsedSize;
+    BOOLEAN    IsPending;
+    UINT64     FileOffset;
+    UINT64     EndPageIndex; // The page after the last page that its state is described by this buffer
+    UINT64     CountOfPresentPages;
+    UINT64     CountOfZeroPages;
+    UINT64     CountOfUnreadablePages;
+    UINT64     CountOfUnchangedPages;
+
+} DUMP_WRITE_BUFFER, *PDUMP_WRITE_BUFFER;
+
+/**
+ * @brief The state of a dump operation
+ *
+ */
+typedef struct _DUMP_CONTEXT
+{
+    HANDLE                    FileHandle;
+    BOOLEAN                   IsSparse;
+    BOOLEAN                   IsIncremental;
+    DEBUGGER_READ_MEMORY_TYPE MemoryType;
+    UINT32                    Pid;
+    DEBUGGER_READ_MEMORY *    ReadRequest;
+    DUMP_SPARSE_FILE_HEADER   Header;
+    std::vector<UINT64>       PageMap;
+    OVERLAPPED                MetadataOverlapped;
+    DUMP_WRITE_BUFFER         WriteBuffers[DUMP_WRITE_BUFFER_COUNT];
+    UINT32                    CurrentWriteBuffer;
+    UINT64                    NextPageIndex;  // Index of the next page to read
+    UINT64                    NextFileOffset; // File offset for the next written byte
+    std::vector<UINT64>       DirtyPages;     // One bit for each page of the range (only in the incremental dumps)
+
+} DUMP_CONTEXT, *PDUMP_CONTEXT;
+
+//////////////////////////////////////////////////
+//            	    Functions                   //
+//////////////////////////////////////////////////
+
+//
+// Reading the pages and writing the file (dump.cpp)
+//
+
+BOOLEAN
+CommandDumpReadPages(PDUMP_CONTEXT Context, UINT64 Address, UINT32 Size, BOOLEAN * IsConnectionLost);
+
+BOOLEAN
+CommandDumpWriteMetadata(PDUMP_CONTEXT Context, UINT64 FileOffset, PVOID Buffer, UINT32 Size);
+
+BOOLEAN
+CommandDumpStartWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer);
+
+BOOLEAN
+CommandDumpWaitForWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer);
+
+BOOLEAN
+CommandDumpSendDirtyPagesRequest(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, UINT32 RequestSize);
+
+BOOLEAN
+CommandDumpCollectDirtyPages(PDUMP_CONTEXT Context, UINT64 * CountOfDirtyPages);
+
+BOOLEAN
+CommandDumpPrepareFile(PDUMP_CONTEXT Context, const wstring & Filepath, BOOLEAN IsResume);
+
+BOOLEAN
+CommandDumpAllocateContext(PDUMP_CONTEXT Context);
+
+VOID
+CommandDumpFreeContext(PDUMP_CONTEXT Context);
+
+//
+// Batching, page map, and resuming (dump-file.cpp)
+//
+
+VOID
+CommandDumpInitializeHeader(PDUMP_CONTEXT Context, UINT64 StartAddress, UINT64 EndAddress);
+
+VOID
+CommandDumpInitializeSparseFile(PDUMP_CONTEXT Context);
+
+BOOLEAN
+CommandDumpResumeSparseFile(PDUMP_CONTEXT Context, DUMP_SPARSE_FILE_HEADER * PreviousHeader, UINT32 BytesRead);
+
+BOOLEAN
+CommandDumpResumeRawFile(PDUMP_CONTEXT Context, UINT64 FileSize);
+
+BOOLEAN
+CommandDumpIsZeroPage(BYTE * PageBuffer, UINT32 Size);
+
+VOID
+CommandDumpResetWriteBuffer(PDUMP_CONTEXT Context, UINT32 Index);
+
+BOOLEAN
+CommandDumpCompleteWriteBuffer(PDUMP_CONTEXT Context, UINT32 Index);
+
+BOOLEAN
+CommandDumpFlushWriteBuffer(PDUMP_CONTEXT Context);
+
+BOOLEAN
+CommandDumpAppendPage(PDUMP_CONTEXT Context, BYTE * PageBuffer, UINT32 Size, BOOLEAN IsReadable);
+
+BOOLEAN
+CommandDumpAppendUnchangedPage(PDUMP_CONTEXT Context);
+
+BOOLEAN
+CommandDumpReadAndAppendBatch(PDUMP_CONTEXT Context, UINT64 Address, UINT32 Size);
+
+UINT64
+CommandDumpMarkDirtyPages(PDUMP_CONTEXT Context, PDEBUGGER_DIRTY_PAGES_ENTRY Entries, UINT32 CountOfEntries);
+
+BOOLEAN
+CommandDumpIsDirtyPage(PDUMP_CONTEXT Context, UINT64 PageIndex);
+
+BOOLEAN
+CommandDumpNextBatch(PDUMP_CONTEXT Context);
+
+BOOLEAN
+CommandDumpFinalize(PDUMP_CONTEXT Context);
@@ -131,17 +131,25 @@ HANDLE g_IsDriverLoadedSuccessfully = NULL;
 
 /**
  * @brief Handle to if the end of the message received (for showing
- * signature)
+ * signature), it's a semaphore that is released for each message
  *
  */
 HANDLE g_EndOfMessageReceivedEvent = NULL;
 
 /**
- * @brief variable to keep track if the end of the message received
- * (for showing signature)
+ * @brief Mutex of the commands that are sent to the remote debuggee
+ * and their results are not received yet
  *
  */
-BOOLEAN g_IsEndOfMessageReceived = FALSE;
+HANDLE g_PipelinedCommandsMutex = NULL;
+
+/**
+ * @brief The commands that are sent to the remote debuggee and their
+ * results are not received yet (in the order of sending them), an empty
+ * command is not shown once its results are received
+ *
+ */
+std::list<std::string> g_PipelinedCommands;
 
 /**
  * @brief In both debuggee and debugger we save the state of
@@ -306,6 +314,13 @@ OVERLAPPED g_OverlappedIoStructureForReadDebuggee = {0};
  */
 BOOLEAN g_SharedEventStatus = FALSE;
 
+/**
+ * @brief Holds the result of querying the costs of an event (the
+ * kernel status and the costs)
+ *
+ */
+DEBUGGER_MODIFY_EVENTS g_SharedEventCostsResult = {0};
+
 //////////////////////////////////////////////////
 //				 Global Variables               //
 //////////////////////////////////////////////////
@@ -323,6 +338,12 @@ BOOLEAN g_ShouldPreviousCommandBeContinued;
  */
 CommandType g_CommandsList;
 
+/**
+ * @brief The dispatch table of commands
+ *
+ */
+COMMAND_DISPATCH_TABLE g_CommandsDispatchTable;
+
 /**
  * @brief Holder of global variables for script engine
  *
@@ -503,7 +524,14 @@ BOOLEAN g_IsExecutingSymbolLoadingRoutines = FALSE;
  * @brief Symbol table for disassembler
  *
  */
-std::map<UINT64, LOCAL_FUNCTION_DESCRIPTION> g_DisassemblerSymbolMap;
+SYMBOL_MAP g_DisassemblerSymbolMap;
+
+/**
+ * @brief Symbols that are received for the disassembler symbol table
+ * but are not yet added to it
+ *
+ */
+SYMBOL_MAP_STAGING g_DisassemblerSymbolMapStaging;
 
 /**
  * @brief Shows whether the user executed and mesaured '!measure'
@@ -554,6 +582,18 @@ UINT64 g_RdtscMedian = 0;
  */
 BOOLEAN g_IsInstrumentingInstructions = FALSE;
 
+/**
+ * @brief Statistics of the received records of the batched steps
+ * ('t', 'p', or 'i' command with records)
+ */
+STEPPING_TRACE_STATISTICS g_SteppingTraceStatistics = {0};
+
+/**
+ * @brief The trace file that the records of the batched steps are saved to
+ * (if it's open)
+ */
+TRACE_FILE_WRITER g_SteppingTraceFileWriter;
+
 /**
  * @brief Shows the kernel base address
  */
@@ -630,6 +670,16 @@ UINT64 g_ResultOfEvaluatedExpression = NULL;
  */
 UINT32 g_ErrorStateOfResultOfEvaluatedExpression = NULL;
 
+//////////////////////////////////////////////////
+//			        PE Images			        //
+//////////////////////////////////////////////////
+
+/**
+ * @brief The cache of the memory-mapped PE images
+ *
+ */
+PE_IMAGE_CACHE g_PeImageCache;
+
 //////////////////////////////////////////////////
 //			 User mode Debugging		        //
 //////////////////////////////////////////////////
@@ -680,6 +730,19 @@ HWDBG_INSTANCE_INFORMATION g_HwdbgInstanceInfo;
  */
 BOOLEAN g_HwdbgInstanceInfoIsValid;
 
+/**
+ * @brief Path of the binary BRAM image that is shared with hwdbg (if empty,
+ * the packets are exchanged through the test hex files)
+ *
+ */
+std::string g_HwdbgBramImagePath = "";
+
+/**
+ * @brief Shows whether the debugger is waiting for hwdbg to respond to a packet
+ *
+ */
+BOOLEAN g_HwdbgIsWaitingForResponse = FALSE;
+
 /**
  * @brief Ports configuration of hwdbg
  *
@@ -691,3 +754,16 @@ std::vector<UINT32> g_HwdbgPortConfiguration;
  *
  */
 UINT64 * g_HwdbgPinsStatus;
+
+/**
+ * @brief Header of the last received chunk of the hwdbg capture buffer
+ *
+ */
+HWDBG_CAPTURE_BUFFER_CHUNK g_HwdbgCaptureHeader;
+
+/**
+ * @brief Entries of the hwdbg capture buffer (run length and sample words
+ * of each entry) which are received from the chunks
+ *
+ */
+std::vector<UINT32> g_HwdbgCaptureEntries;
@@ -222,6 +222,12 @@ CommandApicHelp();
 VOID
 CommandIoapicHelp();
 
+VOID
+CommandVmexitprofHelp();
+
+VOID
+CommandSnapshotHelp();
+
 VOID
 CommandProcessHelp();
 
@@ -297,6 +303,9 @@ CommandAssembleHelp();
 VOID
 CommandPcitreeHelp();
 
+VOID
+CommandTracefileHelp();
+
 //
 // hwdbg commands
 //
@@ -0,0 +1,46 @@
+/**
+ * @file hwdbg-capture.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for the capture buffer (logic analyzer) of hwdbg
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Functions                   //
+//////////////////////////////////////////////////
+
+UINT32
+HwdbgCaptureGetNumberOfEntryWords(HWDBG_INSTANCE_INFORMATION * InstanceInfo);
+
+const CHAR *
+HwdbgCaptureGetStateName(UINT32 CaptureState);
+
+std::string
+HwdbgCaptureGetVcdIdentifier(UINT32 Index);
+
+BOOLEAN
+HwdbgCaptureInterpretChunk(HWDBG_CAPTURE_BUFFER_CHUNK * Chunk);
+
+BOOLEAN
+HwdbgCaptureArm(const TCHAR * InstanceFilePathToRead,
+                const TCHAR * CaptureConfigurationFilePathToSave,
+                UINT32        InitialBramBufferSize,
+                UINT32        TriggerPin,
+                UINT32        PreTriggerEntries,
+                UINT32        PostTriggerEntries);
+
+BOOLEAN
+HwdbgCaptureRead(const TCHAR * CaptureReadFilePathToSave,
+                 const TCHAR * CaptureBufferFilePathToRead);
+
+VOID
+HwdbgCaptureShowSummary();
+
+BOOLEAN
+HwdbgCaptureExportVcd(const TCHAR * VcdFilePathToSave);
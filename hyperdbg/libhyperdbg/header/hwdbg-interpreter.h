@@ -34,6 +34,30 @@ HwdbgInterpreterFillMemoryFromFile(const TCHAR * FileName,
                                    UINT32 *      MemoryBuffer,
                                    size_t        BufferSize);
 
+BOOLEAN
+HwdbgInterpreterIsBinaryImageFile(const TCHAR * FileName);
+
+BOOLEAN
+HwdbgInterpreterWaitForResponse(const TCHAR * FileName);
+
+BOOLEAN
+HwdbgInterpreterSetupPacketPath(const TCHAR * DefaultFileName,
+                                TCHAR *       FilePath,
+                                ULONG         FilePathLength,
+                                BOOLEAN       CheckFileExists);
+
+BOOLEAN
+HwdbgInterpreterFillBinaryFileFromMemory(
+    HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+    const TCHAR *                FileName,
+    UINT32 *                     MemoryBuffer,
+    size_t                       BufferSize);
+
+BOOLEAN
+HwdbgInterpreterFillMemoryFromBinaryFile(const TCHAR * FileName,
+                                         UINT32 *      MemoryBuffer,
+                                         size_t        BufferSize);
+
 SIZE_T
 HwdbgComputeNumberOfFlipFlopsNeeded(
     HWDBG_INSTANCE_INFORMATION * InstanceInfo,
@@ -0,0 +1,51 @@
+/**
+ * @file hwdbg-packet.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for encoding and decoding hwdbg packets and BRAM images
+ * @details This file is shared with the co-simulation harness of hwdbg
+ * (hwdbg/sim/verilator), thus it should not depend on Windows
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Functions                   //
+//////////////////////////////////////////////////
+
+BYTE
+HwdbgPacketComputeChecksum(const VOID * Buffer, SIZE_T Length);
+
+SIZE_T
+HwdbgPacketGetEncodedSize(UINT32 DebuggerAreaOffset, UINT32 PayloadLength);
+
+BOOLEAN
+HwdbgPacketEncode(VOID *                      Buffer,
+                  SIZE_T                      BufferSize,
+                  UINT32                      DebuggerAreaOffset,
+                  DEBUGGER_REMOTE_PACKET_TYPE PacketType,
+                  HWDBG_ACTION_ENUMS          RequestedAction,
+                  const VOID *                Payload,
+                  UINT32                      PayloadLength);
+
+DEBUGGER_REMOTE_PACKET *
+HwdbgPacketDecode(const VOID * Buffer, SIZE_T BufferSize, UINT32 DebuggeeAreaOffset);
+
+VOID
+HwdbgPacketInitializeBramImageHeader(HWDBG_BRAM_IMAGE_HEADER * Header, UINT32 NumberOfWords);
+
+BOOLEAN
+HwdbgPacketIsValidBramImageHeader(const HWDBG_BRAM_IMAGE_HEADER * Header, UINT64 ImageSize);
+
+BOOLEAN
+HwdbgPacketParseTextLine(const std::string & Line, std::vector<UINT32> & Values);
+
+VOID
+HwdbgPacketWriteTextFile(std::ostream & Stream,
+                         const UINT32 * Words,
+                         SIZE_T         NumberOfWords,
+                         SIZE_T         SharedMemorySize,
+                         UINT32         RequestedAction);
@@ -140,6 +140,9 @@ KdSendEventQueryAndModifyPacketToDebuggee(
     DEBUGGER_MODIFY_EVENTS_TYPE TypeOfAction,
     BOOLEAN *                   IsEnabled);
 
+BOOLEAN
+KdSendEventQueryCostsPacketToDebuggee(UINT64 Tag, PDEBUGGER_EVENT_COSTS Costs);
+
 BOOLEAN
 KdSendFlushPacketToDebuggee();
 
@@ -201,6 +204,15 @@ KdSendVa2paAndPa2vaPacketToDebuggee(PDEBUGGER_VA2PA_AND_PA2VA_COMMANDS Va2paAndP
 BOOLEAN
 KdSendApicActionPacketsToDebuggee(PDEBUGGER_APIC_REQUEST ApicRequest, UINT32 ExpectedRequestSize);
 
+BOOLEAN
+KdSendVmexitProfilerActionPacketsToDebuggee(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest, UINT32 ExpectedRequestSize);
+
+BOOLEAN
+KdSendDirtyPagesActionPacketsToDebuggee(PDEBUGGER_DIRTY_PAGES_REQUEST DirtyPagesRequest, UINT32 ExpectedRequestSize);
+
+BOOLEAN
+KdSendSnapshotActionPacketsToDebuggee(PDEBUGGER_SNAPSHOT_REQUEST SnapshotRequest);
+
 BOOLEAN
 KdSendPtePacketToDebuggee(PDEBUGGER_READ_PAGE_TABLE_ENTRIES_DETAILS PtePacket);
 
@@ -223,6 +235,9 @@ KdSendSearchRequestPacketToDebuggee(UINT64 * SearchRequestBuffer, UINT32 SearchR
 BOOLEAN
 KdSendStepPacketToDebuggee(DEBUGGER_REMOTE_STEPPING_REQUEST StepRequestType);
 
+BOOLEAN
+KdSendBatchedStepPacketToDebuggee(PDEBUGGEE_STEP_PACKET StepPacket);
+
 BYTE
 KdComputeDataChecksum(PVOID Buffer, UINT32 Length);
 
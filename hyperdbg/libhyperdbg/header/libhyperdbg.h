@@ -46,6 +46,9 @@ HyperDbgTestCommandParser(CHAR *   Command,
 VOID
 HyperDbgTestCommandParserShowTokens(CHAR * Command);
 
+UINT32
+HyperDbgTestCommandParserPerformance(CHAR * Command, UINT32 Iterations, BOOLEAN ConvertTokens);
+
 INT
 ScriptReadFileAndExecuteCommandline(INT argc, CHAR * argv[]);
 
@@ -0,0 +1,210 @@
+/**
+ * @file pe-image.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the memory-mapped PE images and their cached indexes
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of mapped images that are kept in the cache
+ *
+ */
+#define PE_IMAGE_CACHE_MAXIMUM_ENTRIES 16
+
+/**
+ * @brief Maximum number of exported functions (or imported functions of a
+ * module) that are indexed, larger tables are considered as corrupted
+ *
+ */
+#define PE_IMAGE_MAXIMUM_INDEXED_ENTRIES 0x100000
+
+/**
+ * @brief Signature of the CodeView (PDB 7.0) debug information ('RSDS')
+ *
+ */
+#define PE_IMAGE_CODEVIEW_RSDS_SIGNATURE 0x53445352
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief An exported function of the image
+ * @details Names point to the mapped file
+ *
+ */
+typedef struct _PE_IMAGE_EXPORT
+{
+    UINT32       Rva;
+    UINT32       Ordinal;
+    const CHAR * Name;        // NULL if the function is only exported by ordinal
+    BOOLEAN      IsForwarder; // The RVA points to the name of the forwarded function
+
+} PE_IMAGE_EXPORT, *PPE_IMAGE_EXPORT;
+
+/**
+ * @brief An imported function of the image (a thunk of the import address
+ * table)
+ * @details Names point to the mapped file
+ *
+ */
+typedef struct _PE_IMAGE_IMPORT
+{
+    UINT32       ThunkRva;
+    UINT16       OrdinalOrHint;
+    BOOLEAN      IsOrdinal;
+    const CHAR * ModuleName;
+    const CHAR * Name; // NULL if the function is imported by ordinal
+
+} PE_IMAGE_IMPORT, *PPE_IMAGE_IMPORT;
+
+/**
+ * @brief The CodeView (PDB 7.0) debug information
+ *
+ */
+typedef struct _PE_IMAGE_CODEVIEW_RSDS
+{
+    UINT32 Signature;
+    GUID   Guid;
+    UINT32 Age;
+    CHAR   PdbFileName[1];
+
+} PE_IMAGE_CODEVIEW_RSDS, *PPE_IMAGE_CODEVIEW_RSDS;
+
+/**
+ * @brief A memory-mapped PE image
+ * @details The headers are validated and the sections are indexed once the
+ * image is mapped, other indexes are built the first time that they're used
+ *
+ */
+typedef struct _PE_IMAGE
+{
+    std::wstring Path;
+    UINT64       LastWriteTime;
+    HANDLE       FileHandle;
+    HANDLE       MappingHandle;
+    const BYTE * Base;
+    UINT64       Size;
+
+    //
+    // Headers
+    //
+    BOOLEAN                      Is32Bit; // PE32 (otherwise PE32+)
+    const IMAGE_DOS_HEADER *     DosHeader;
+    const IMAGE_NT_HEADERS32 *   NtHeaders32; // Only valid for PE32 images
+    const IMAGE_NT_HEADERS64 *   NtHeaders64; // Only valid for PE32+ images
+    const IMAGE_FILE_HEADER *    FileHeader;
+    const IMAGE_SECTION_HEADER * Sections;
+    UINT32                       NumberOfSections;
+    const IMAGE_DATA_DIRECTORY * DataDirectories;
+    UINT32                       NumberOfDataDirectories;
+    UINT64                       ImageBase;
+    UINT32                       SizeOfImage;
+    UINT32                       SizeOfHeaders;
+
+    //
+    // Indexes (the flags are only accessed while IndexLock is held, and the
+    // indexes are not modified once they're built)
+    //
+    std::vector<UINT32>          SectionsByRva; // Indexes of the sections sorted by their RVAs (built once mapped)
+    volatile LONG                IndexLock;
+    BOOLEAN                      IsExportIndexBuilt;
+    std::vector<PE_IMAGE_EXPORT> ExportsByRva;
+    std::vector<UINT32>          ExportNameBuckets; // Open addressing, index of the export plus one (zero if empty)
+    BOOLEAN                      IsImportIndexBuilt;
+    std::vector<PE_IMAGE_IMPORT> ImportsByThunkRva;
+
+} PE_IMAGE, *PPE_IMAGE;
+
+/**
+ * @brief The cache of the mapped images (least recently used images are
+ * unmapped first)
+ *
+ */
+typedef struct _PE_IMAGE_CACHE
+{
+    volatile LONG                        Lock;
+    volatile LONG                        OpenLock; // Held while an image is mapped (a file is not mapped twice)
+    std::list<std::shared_ptr<PE_IMAGE>> Images;   // The most recently used image is the first one
+
+} PE_IMAGE_CACHE, *PPE_IMAGE_CACHE;
+
+//////////////////////////////////////////////////
+//            	    Functions                   //
+//////////////////////////////////////////////////
+
+BOOLEAN
+PeImageParseHeaders(PPE_IMAGE Image);
+
+BOOLEAN
+PeImageRvaToOffset(PPE_IMAGE Image, UINT32 Rva, PUINT64 Offset, PUINT64 Available);
+
+const VOID *
+PeImageRvaToPointer(PPE_IMAGE Image, UINT32 Rva, UINT32 Size);
+
+const CHAR *
+PeImageRvaToString(PPE_IMAGE Image, UINT32 Rva);
+
+const VOID *
+PeImageGetDataDirectory(PPE_IMAGE Image, UINT32 Index, UINT32 MinimumSize, PUINT32 Size);
+
+const BYTE *
+PeImageGetSectionRawData(PPE_IMAGE Image, const IMAGE_SECTION_HEADER * Section, PUINT32 Size);
+
+VOID
+PeImageBuildSectionIndex(PPE_IMAGE Image);
+
+const IMAGE_SECTION_HEADER *
+PeImageFindSectionByRva(PPE_IMAGE Image, UINT32 Rva);
+
+const IMAGE_SECTION_HEADER *
+PeImageFindSectionByName(PPE_IMAGE Image, const CHAR * Name);
+
+UINT32
+PeImageHashName(const CHAR * Name);
+
+VOID
+PeImageBuildExportIndex(PPE_IMAGE Image);
+
+const PE_IMAGE_EXPORT *
+PeImageFindExportByName(PPE_IMAGE Image, const CHAR * Name);
+
+const PE_IMAGE_EXPORT *
+PeImageFindExportByRva(PPE_IMAGE Image, UINT32 Rva);
+
+VOID
+PeImageBuildImportIndex(PPE_IMAGE Image);
+
+const PE_IMAGE_IMPORT *
+PeImageFindImportByThunkRva(PPE_IMAGE Image, UINT32 ThunkRva);
+
+BOOLEAN
+PeImageGetPdbDetails(PPE_IMAGE Image, CHAR * PdbFilePath, UINT32 PdbFilePathSize, CHAR * GuidAndAgeDetails, UINT32 GuidAndAgeDetailsSize);
+
+BOOLEAN
+PeImageMapFile(PPE_IMAGE Image, const WCHAR * Path, UINT64 LastWriteTime);
+
+VOID
+PeImageUnmapFile(PPE_IMAGE Image);
+
+VOID
+PeImageRelease(PPE_IMAGE Image);
+
+std::shared_ptr<PE_IMAGE>
+PeImageOpen(const WCHAR * Path);
+
+std::shared_ptr<PE_IMAGE>
+PeImageOpenModule(PMODULE_SYMBOL_DETAIL Module);
+
+VOID
+PeImageFlushCache();
@@ -16,7 +16,13 @@
 //////////////////////////////////////////////////
 
 BOOLEAN
-PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * SectionToShow, BOOLEAN Is32Bit);
+PeShowSectionInformationAndDump(const WCHAR * AddressOfFile, const CHAR * SectionToShow);
 
 BOOLEAN
 PeIsPE32BitOr64Bit(const WCHAR * AddressOfFile, PBOOLEAN Is32Bit);
+
+BOOLEAN
+PeShowExportByName(const WCHAR * AddressOfFile, const CHAR * FunctionName);
+
+BOOLEAN
+PeShowImportByThunkRva(const WCHAR * AddressOfFile, UINT32 ThunkRva);
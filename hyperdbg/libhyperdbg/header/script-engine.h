@@ -41,6 +41,9 @@ ScriptEngineGetDataTypeSizeWrapper(CHAR * TypeName, UINT64 * TypeSize);
 BOOLEAN
 ScriptEngineCreateSymbolTableForDisassemblerWrapper(void * CallbackFunction);
 
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModuleWrapper(void * CallbackFunction, UINT64 BaseAddress);
+
 BOOLEAN
 ScriptEngineConvertFileToPdbPathWrapper(const char * LocalFilePath, char * ResultPath, size_t ResultPathSize);
 
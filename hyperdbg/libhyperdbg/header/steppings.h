@@ -11,6 +11,51 @@
  */
 #pragma once
 
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Maximum number of steps that are requested from the debuggee at once
+ * @details The debuggee can't be paused while it performs the batched steps,
+ * so the steps are requested in batches and CTRL+C is checked between them
+ *
+ */
+#define STEPPING_BATCHED_STEPS_MAXIMUM_STEPS_PER_REQUEST 0x1000
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Options of the batched steps (the steps are performed in the
+ * debuggee and the records are received in chunks)
+ *
+ */
+typedef struct _STEPPING_BATCHED_STEPS_OPTIONS
+{
+    BOOLEAN                         IsBatched;
+    DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType;
+    UINT32                          RegisterMask;
+    BOOLEAN                         StopAtAddress;
+    UINT64                          StopAddress;
+    CHAR                            TraceFilePath[MAX_PATH]; // Records are saved to this file (if not empty)
+
+} STEPPING_BATCHED_STEPS_OPTIONS, *PSTEPPING_BATCHED_STEPS_OPTIONS;
+
+/**
+ * @brief Statistics of the received records of the batched steps
+ *
+ */
+typedef struct _STEPPING_TRACE_STATISTICS
+{
+    UINT64  CountOfRecords;
+    UINT64  CountOfChunks;
+    UINT64  CountOfBytes;
+    BOOLEAN IsBatchCompleted; // All the steps of the last batch are performed
+
+} STEPPING_TRACE_STATISTICS, *PSTEPPING_TRACE_STATISTICS;
+
 //////////////////////////////////////////////////
 //            	    Functions                   //
 //////////////////////////////////////////////////
@@ -29,3 +74,17 @@ SteppingInstrumentationStepInForTracking();
 
 BOOLEAN
 SteppingStepOverForGu(BOOLEAN LastInstruction);
+
+BOOLEAN
+SteppingParseBatchedStepsOptions(vector<CommandToken> &          CommandTokens,
+                                 UINT32                          FirstOptionIndex,
+                                 BOOLEAN                         ShowRegisters,
+                                 PSTEPPING_BATCHED_STEPS_OPTIONS Options);
+
+BOOLEAN
+SteppingPerformBatchedSteps(DEBUGGER_REMOTE_STEPPING_REQUEST StepType,
+                            UINT32                           CountOfSteps,
+                            PSTEPPING_BATCHED_STEPS_OPTIONS  Options);
+
+VOID
+SteppingShowTraceRecords(PDEBUGGEE_STEP_TRACE_CHUNK Chunk, UINT32 Length);
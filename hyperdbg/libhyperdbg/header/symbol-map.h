@@ -0,0 +1,153 @@
+/**
+ * @file symbol-map.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the address to symbol map (used by the disassembler and
+ * the call stack)
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Minimum number of symbols that are sorted by more than one thread
+ *
+ */
+#define SYMBOL_MAP_PARALLEL_SORT_THRESHOLD 0x10000
+
+/**
+ * @brief Maximum number of threads that sort the symbols
+ *
+ */
+#define SYMBOL_MAP_MAXIMUM_SORT_THREADS 16
+
+/**
+ * @brief Number of entries of the search layout in each cache line
+ *
+ */
+#define SYMBOL_MAP_ENTRIES_PER_CACHE_LINE (64 / sizeof(UINT64))
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief A symbol that is received from the symbol parser and is not yet
+ * added to the map
+ *
+ */
+typedef struct _SYMBOL_MAP_STAGED_SYMBOL
+{
+    UINT64 Address;
+    UINT32 Size;
+    UINT32 NameOffset;
+    UINT32 Sequence; // Order of receiving the symbol (the last one is shown on duplicates)
+    UINT32 ModuleIndex;
+
+} SYMBOL_MAP_STAGED_SYMBOL, *PSYMBOL_MAP_STAGED_SYMBOL;
+
+/**
+ * @brief A module that its symbols are in the map
+ * @details Names of the symbols ("module!object") are stored one after
+ * another (null-terminated) in a single buffer for each module
+ *
+ */
+typedef struct _SYMBOL_MAP_MODULE
+{
+    std::string       ModuleName;
+    std::vector<CHAR> Names;
+
+} SYMBOL_MAP_MODULE, *PSYMBOL_MAP_MODULE;
+
+/**
+ * @brief The address to symbol map
+ * @details Symbols are kept sorted by their addresses in separate arrays
+ * (struct of arrays). The addresses are also stored in the Eytzinger
+ * (BFS) order to make the binary search cache-friendly, the rank of each
+ * element of this layout is its index in the sorted arrays
+ *
+ */
+typedef struct _SYMBOL_MAP
+{
+    std::vector<UINT64>            Addresses;
+    std::vector<UINT32>            Sizes;
+    std::vector<UINT32>            NameOffsets;
+    std::vector<UINT32>            ModuleIndexes;
+    std::vector<UINT64>            LayoutAddresses; // 1-based, the first element is not used
+    std::vector<UINT32>            LayoutRanks;     // 1-based, the first element is not used
+    std::vector<SYMBOL_MAP_MODULE> Modules;
+
+} SYMBOL_MAP, *PSYMBOL_MAP;
+
+/**
+ * @brief The state of receiving symbols from the symbol parser
+ *
+ */
+typedef struct _SYMBOL_MAP_STAGING
+{
+    std::vector<SYMBOL_MAP_STAGED_SYMBOL> Symbols;
+    std::vector<SYMBOL_MAP_MODULE>        Modules;
+
+} SYMBOL_MAP_STAGING, *PSYMBOL_MAP_STAGING;
+
+/**
+ * @brief A range of staged symbols that is sorted (or merged) by a thread
+ *
+ */
+typedef struct _SYMBOL_MAP_SORT_TASK
+{
+    SYMBOL_MAP_STAGED_SYMBOL * Begin;
+    SYMBOL_MAP_STAGED_SYMBOL * Middle; // Equal to Begin if the range should be sorted
+    SYMBOL_MAP_STAGED_SYMBOL * End;
+
+} SYMBOL_MAP_SORT_TASK, *PSYMBOL_MAP_SORT_TASK;
+
+//////////////////////////////////////////////////
+//            	    Functions                   //
+//////////////////////////////////////////////////
+
+VOID
+SymbolMapStageSymbol(UINT64 Address, char * ModuleName, char * ObjectName, unsigned int ObjectSize);
+
+DWORD WINAPI
+SymbolMapSortWorker(LPVOID Parameter);
+
+VOID
+SymbolMapRunSortTasks(std::vector<SYMBOL_MAP_SORT_TASK> & Tasks);
+
+VOID
+SymbolMapSortStagedSymbols(std::vector<SYMBOL_MAP_STAGED_SYMBOL> & Symbols);
+
+VOID
+SymbolMapMergeStagedSymbols();
+
+UINT32
+SymbolMapFillLayout(UINT32 SortedIndex, UINT64 LayoutIndex);
+
+VOID
+SymbolMapBuildLayout();
+
+VOID
+SymbolMapRemoveModules(const std::vector<SYMBOL_MAP_MODULE> & Modules);
+
+VOID
+SymbolMapBuild();
+
+VOID
+SymbolMapAddModule(UINT64 BaseAddress);
+
+VOID
+SymbolMapClear();
+
+BOOLEAN
+SymbolMapLookup(UINT64 Address, PUINT64 ObjectAddress, PUINT32 ObjectSize, const char ** ObjectName);
+
+const char *
+SymbolMapLookupExact(UINT64 Address);
@@ -11,21 +11,6 @@
  */
 #pragma once
 
-//////////////////////////////////////////////////
-//			        Structures		            //
-//////////////////////////////////////////////////
-
-/**
- * @brief Save the local function symbols' description
- *
- */
-typedef struct _LOCAL_FUNCTION_DESCRIPTION
-{
-    std::string ObjectName;
-    UINT32      ObjectSize;
-
-} LOCAL_FUNCTION_DESCRIPTION, *PLOCAL_FUNCTION_DESCRIPTION;
-
 //////////////////////////////////////////////////
 //			    	    Pdbex                   //
 //////////////////////////////////////////////////
@@ -51,6 +36,21 @@ SymbolConvertNameOrExprToAddress(const string & TextToConvert, PUINT64 Result);
 BOOLEAN
 SymbolDeleteSymTable();
 
+BOOLEAN
+SymbolGetPdbDetailsOfModule(const char * ModulePath, char * PdbFilePath, char * GuidAndAgeDetails, BOOLEAN Is32BitModule);
+
+PMODULE_SYMBOL_DETAIL
+SymbolGetModuleByAddress(UINT64 Address);
+
+PMODULE_SYMBOL_DETAIL
+SymbolGetModuleByName(const string & ModuleName);
+
+string
+SymbolGetModuleName(PMODULE_SYMBOL_DETAIL Module);
+
+BOOLEAN
+SymbolConvertExportNameToAddress(const string & TextToConvert, PUINT64 Result);
+
 BOOLEAN
 SymbolBuildSymbolTable(PMODULE_SYMBOL_DETAIL * BufferToStoreDetails,
                        PUINT32                 StoredLength,
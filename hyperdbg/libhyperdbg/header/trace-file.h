@@ -0,0 +1,306 @@
+/**
+ * @file trace-file.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the binary execution trace files (writer, reader, and analysis)
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				    Constants					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Signatures of the parts of the trace files ('HDTR', 'CHNK', and 'INDX')
+ *
+ */
+#define TRACE_FILE_MAGIC       0x52544448
+#define TRACE_FILE_CHUNK_MAGIC 0x4b4e4843
+#define TRACE_FILE_INDEX_MAGIC 0x58444e49
+
+/**
+ * @brief Version of the format of the trace files
+ *
+ */
+#define TRACE_FILE_VERSION 1
+
+/**
+ * @brief Maximum number of records of each chunk, each chunk is a sync point
+ * (values are delta-encoded from the start of the chunk)
+ *
+ */
+#define TRACE_FILE_RECORDS_PER_CHUNK 0x4000
+
+/**
+ * @brief Maximum size of the payload of a chunk (larger chunks are
+ * considered as corrupted)
+ *
+ */
+#define TRACE_FILE_MAXIMUM_PAYLOAD_SIZE (64 * 1024 * 1024)
+
+/**
+ * @brief Number of registers in the records (the general-purpose registers
+ * in the order of GUEST_REGS and the RFLAGS)
+ *
+ */
+#define TRACE_FILE_MAXIMUM_REGISTERS 17
+
+//////////////////////////////////////////////////
+//				      Enums 					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Compression of the payload of chunks
+ * @details Only the uncompressed payloads are supported by this version, the
+ * values are reserved so the framing doesn't change once a codec is added
+ *
+ */
+typedef enum _TRACE_FILE_COMPRESSION
+{
+    TRACE_FILE_COMPRESSION_NONE,
+    TRACE_FILE_COMPRESSION_LZ4,
+    TRACE_FILE_COMPRESSION_ZSTD,
+
+} TRACE_FILE_COMPRESSION;
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+#pragma pack(push, 1)
+
+/**
+ * @brief The header of the trace file
+ *
+ */
+typedef struct _TRACE_FILE_HEADER
+{
+    UINT32 Magic;
+    UINT16 Version;
+    UINT16 HeaderSize;
+    UINT32 RecordsPerChunk;
+    UINT32 Reserved;
+
+} TRACE_FILE_HEADER, *PTRACE_FILE_HEADER;
+
+/**
+ * @brief The header of a chunk of records
+ * @details Records of a chunk are from the same core (stream) and have the
+ * same type, the payload is placed after this header
+ *
+ */
+typedef struct _TRACE_FILE_CHUNK_HEADER
+{
+    UINT32 Magic;
+    UINT32 CoreId;
+    UINT8  RecordType; // DEBUGGER_STEP_TRACE_RECORD_TYPE
+    UINT8  Compression;
+    UINT8  Is32Bit;
+    UINT8  Reserved;
+    UINT32 RegisterMask;
+    UINT32 CountOfRecords;
+    UINT32 PayloadSize;
+    UINT32 UncompressedSize;
+    UINT64 FirstRecordNumber; // Record numbers of a core are increasing (e.g., the step numbers)
+
+} TRACE_FILE_CHUNK_HEADER, *PTRACE_FILE_CHUNK_HEADER;
+
+/**
+ * @brief An entry of the chunk index (placed at the end of the file)
+ *
+ */
+typedef struct _TRACE_FILE_INDEX_ENTRY
+{
+    UINT64 Offset;
+    UINT64 FirstRecordNumber;
+    UINT32 CountOfRecords;
+    UINT32 CoreId;
+
+} TRACE_FILE_INDEX_ENTRY, *PTRACE_FILE_INDEX_ENTRY;
+
+/**
+ * @brief The footer of the trace file
+ *
+ */
+typedef struct _TRACE_FILE_FOOTER
+{
+    UINT64 IndexOffset;
+    UINT64 CountOfEntries;
+    UINT32 Magic;
+    UINT32 Reserved;
+
+} TRACE_FILE_FOOTER, *PTRACE_FILE_FOOTER;
+
+#pragma pack(pop)
+
+/**
+ * @brief A decoded record
+ *
+ */
+typedef struct _TRACE_FILE_RECORD
+{
+    UINT64  RecordNumber;
+    UINT64  Rip;    // Address of the instruction (or the 'call' or the 'ret')
+    UINT64  Target; // Only used in the call/ret records
+    UINT32  Depth;  // Only used in the call/ret records
+    BOOLEAN IsRet;  // Only used in the call/ret records
+    BOOLEAN HasInstructionBytes;
+    BYTE    InstructionBytes[MAXIMUM_INSTR_SIZE];
+    UINT64  Registers[TRACE_FILE_MAXIMUM_REGISTERS]; // Indexed by the bits of the register mask
+
+} TRACE_FILE_RECORD, *PTRACE_FILE_RECORD;
+
+/**
+ * @brief The records of a core which are not yet written to the file
+ *
+ */
+typedef struct _TRACE_FILE_STREAM
+{
+    UINT32                          CoreId;
+    DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType;
+    UINT32                          RegisterMask;
+    BOOLEAN                         Is32Bit;
+    UINT32                          CountOfRecords;
+    UINT64                          FirstRecordNumber;
+    UINT64                          NextRecordNumber;
+    UINT64                          PreviousRip;
+    UINT64                          PreviousRegisters[TRACE_FILE_MAXIMUM_REGISTERS];
+    std::vector<BYTE>               Payload;
+
+} TRACE_FILE_STREAM, *PTRACE_FILE_STREAM;
+
+/**
+ * @brief The writer of trace files
+ *
+ */
+typedef struct _TRACE_FILE_WRITER
+{
+    FILE *                              File;
+    UINT64                              Offset;
+    std::map<UINT32, TRACE_FILE_STREAM> Streams; // Key is the core
+    std::vector<TRACE_FILE_INDEX_ENTRY> Index;
+
+} TRACE_FILE_WRITER, *PTRACE_FILE_WRITER;
+
+/**
+ * @brief The reader of trace files
+ *
+ */
+typedef struct _TRACE_FILE_READER
+{
+    FILE *                                File;
+    UINT64                                FileSize;
+    TRACE_FILE_HEADER                     Header;
+    std::vector<TRACE_FILE_INDEX_ENTRY>   Index;
+    BOOLEAN                               IsIndexRebuilt; // The file has no valid index (e.g., it's truncated)
+    std::map<UINT32, std::vector<UINT32>> ChunksOfCores;  // Indexes of the chunks of each core (sorted by the record numbers)
+    std::vector<BYTE>                     Payload;
+
+} TRACE_FILE_READER, *PTRACE_FILE_READER;
+
+/**
+ * @brief Get the length of the instruction of a record (zero if unknown)
+ *
+ */
+typedef UINT32 (*TRACE_FILE_INSTRUCTION_LENGTH_CALLBACK)(const TRACE_FILE_RECORD * Record,
+                                                         BOOLEAN                   Is32Bit,
+                                                         PVOID                     Context);
+
+/**
+ * @brief A reconstructed basic block
+ *
+ */
+typedef struct _TRACE_FILE_BASIC_BLOCK
+{
+    UINT64 Start;
+    UINT64 LastInstruction;
+    UINT32 CountOfInstructions;
+    UINT64 ExecutionCount;
+
+} TRACE_FILE_BASIC_BLOCK, *PTRACE_FILE_BASIC_BLOCK;
+
+/**
+ * @brief The state of a core while the basic blocks are reconstructed
+ *
+ */
+typedef struct _TRACE_FILE_BLOCK_STATE
+{
+    BOOLEAN IsInBlock;
+    UINT64  Start;
+    UINT64  LastInstruction;
+    UINT32  LastLength;
+    UINT32  CountOfInstructions;
+
+} TRACE_FILE_BLOCK_STATE, *PTRACE_FILE_BLOCK_STATE;
+
+/**
+ * @brief The result of analyzing a trace file
+ * @details The hits of call/ret records are counted for the targets of calls
+ *
+ */
+typedef struct _TRACE_FILE_ANALYSIS
+{
+    UINT64                                             CountOfRecords;
+    UINT64                                             CountOfChunks;
+    UINT64                                             CountOfCalls;
+    UINT64                                             CountOfRets;
+    UINT32                                             MaximumDepth;
+    std::unordered_map<UINT64, UINT64>                 Hits;
+    std::unordered_map<UINT64, TRACE_FILE_BASIC_BLOCK> BasicBlocks; // Key is the start of the block
+    std::map<UINT32, TRACE_FILE_BLOCK_STATE>           BlockStates; // Key is the core
+    std::map<UINT32, UINT64>                           RecordsOfCores;
+
+} TRACE_FILE_ANALYSIS, *PTRACE_FILE_ANALYSIS;
+
+//////////////////////////////////////////////////
+//            	    Functions                   //
+//////////////////////////////////////////////////
+
+BOOLEAN
+TraceFileWriterOpen(PTRACE_FILE_WRITER Writer, const CHAR * Path);
+
+BOOLEAN
+TraceFileWriterAddRecord(PTRACE_FILE_WRITER              Writer,
+                         UINT32                          CoreId,
+                         DEBUGGER_STEP_TRACE_RECORD_TYPE RecordType,
+                         UINT32                          RegisterMask,
+                         BOOLEAN                         Is32Bit,
+                         const TRACE_FILE_RECORD *       Record);
+
+BOOLEAN
+TraceFileWriterAddStepTraceChunk(PTRACE_FILE_WRITER Writer, PDEBUGGEE_STEP_TRACE_CHUNK Chunk, UINT32 Length);
+
+BOOLEAN
+TraceFileWriterClose(PTRACE_FILE_WRITER Writer);
+
+BOOLEAN
+TraceFileReaderOpen(PTRACE_FILE_READER Reader, const CHAR * Path);
+
+VOID
+TraceFileReaderClose(PTRACE_FILE_READER Reader);
+
+BOOLEAN
+TraceFileReaderReadChunk(PTRACE_FILE_READER               Reader,
+                         UINT32                           IndexOfChunk,
+                         PTRACE_FILE_CHUNK_HEADER         ChunkHeader,
+                         std::vector<TRACE_FILE_RECORD> & Records);
+
+BOOLEAN
+TraceFileReaderFindChunk(PTRACE_FILE_READER Reader, UINT32 CoreId, UINT64 RecordNumber, UINT32 * IndexOfChunk);
+
+BOOLEAN
+TraceFileReaderFindNextChunk(PTRACE_FILE_READER Reader, UINT32 CoreId, UINT64 RecordNumber, UINT32 * IndexOfChunk);
+
+BOOLEAN
+TraceFileAnalyze(PTRACE_FILE_READER                     Reader,
+                 TRACE_FILE_INSTRUCTION_LENGTH_CALLBACK LengthCallback,
+                 PVOID                                  Context,
+                 PTRACE_FILE_ANALYSIS                   Analysis);
+
+BOOLEAN
+TraceFileExportCsv(PTRACE_FILE_READER Reader, const CHAR * Path);
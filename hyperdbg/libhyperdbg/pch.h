@@ -102,6 +102,7 @@ typedef const wchar_t *LPCWCHAR, *PCWCHAR;
 #include <cctype>
 #include <cstring>
 #include <unordered_set>
+#include <unordered_map>
 #include <regex>
 
 //
@@ -148,8 +149,10 @@ typedef const wchar_t *LPCWCHAR, *PCWCHAR;
 #include "header/export.h"
 #include "header/inipp.h"
 #include "header/commands.h"
+#include "header/command-parser.h"
 #include "header/common.h"
 #include "header/symbol.h"
+#include "header/symbol-map.h"
 #include "header/debugger.h"
 #include "header/script-engine.h"
 #include "header/help.h"
@@ -161,18 +164,23 @@ typedef const wchar_t *LPCWCHAR, *PCWCHAR;
 #include "header/namedpipe.h"
 #include "header/forwarding.h"
 #include "header/kd.h"
+#include "header/pe-image.h"
 #include "header/pe-parser.h"
 #include "header/ud.h"
 #include "header/objects.h"
+#include "header/trace-file.h"
 #include "header/steppings.h"
 #include "header/rev-ctrl.h"
 #include "header/assembler.h"
+#include "header/dump.h"
 
 //
 // hwdbg
 //
 #include "header/hwdbg-interpreter.h"
+#include "header/hwdbg-packet.h"
 #include "header/hwdbg-scripts.h"
+#include "header/hwdbg-capture.h"
 
 //
 // Libraries
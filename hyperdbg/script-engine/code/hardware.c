@@ -507,13 +507,139 @@ HardwareScriptInterpreterCompressBuffer(UINT64 * Buffer,
     return TRUE;
 }
 
+/**
+ * @brief Check whether the operator can be fused into a stage after its first operator
+ * @details The fused operators of a stage are chained in the same clock, so only the
+ * cheap operators (comparisons, logical operators, branches and moves) are fused
+ * @warning SHOULD BE SYNCHRONIZED WITH HwdbgScriptCapabilities.nonFusibleOperators IN HWDBG
+ *
+ * @param Operator
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HardwareScriptInterpreterIsFusibleOperator(UINT64 Operator)
+{
+    switch (Operator)
+    {
+    case FUNC_OR:
+    case FUNC_XOR:
+    case FUNC_AND:
+    case FUNC_GT:
+    case FUNC_LT:
+    case FUNC_EGT:
+    case FUNC_ELT:
+    case FUNC_EQUAL:
+    case FUNC_NEQ:
+    case FUNC_JMP:
+    case FUNC_JZ:
+    case FUNC_JNZ:
+    case FUNC_MOV:
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+/**
+ * @brief Check whether the operator can be fused into the current stage
+ * @details Jump targets don't need to start a new stage since each operator of
+ * a stage is only evaluated if the script reaches its index
+ *
+ * @param InstanceInfo
+ * @param NumberOfOperatorsInStage Number of operators that are already in the current stage
+ * @param Operator
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HardwareScriptInterpreterCanFuseOperator(HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+                                         UINT32                       NumberOfOperatorsInStage,
+                                         UINT64                       Operator)
+{
+    return NumberOfOperatorsInStage != 0 &&
+           NumberOfOperatorsInStage < InstanceInfo->maximumNumberOfOperatorsPerStage &&
+           HardwareScriptInterpreterIsFusibleOperator(Operator);
+}
+
+/**
+ * @brief Pack the operators of the script into stages
+ * @details The operators are packed in order, an operator is fused into the
+ * current stage if the stage has a free operator and the operator is fusible,
+ * otherwise, it starts a new stage
+ *
+ * @param InstanceInfo
+ * @param SymbolBuffer
+ * @param NumberOfSymbols
+ * @param NumberOfStages
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+HardwareScriptInterpreterPackStages(HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+                                    SYMBOL *                     SymbolBuffer,
+                                    size_t                       NumberOfSymbols,
+                                    UINT32 *                     NumberOfStages)
+{
+    UINT32 Stages                   = 0;
+    UINT32 NumberOfOperatorsInStage = 0;
+
+    //
+    // Each stage holds at least the operator of the stage, otherwise, no room
+    // is reserved for the operators in the short symbol buffer
+    //
+    if (InstanceInfo->maximumNumberOfOperatorsPerStage == 0)
+    {
+        ShowMessages("err, invalid instance info, the maximum number of operators per stage is zero\n");
+        return FALSE;
+    }
+
+    for (size_t i = 0; i < NumberOfSymbols; i++)
+    {
+        if (SymbolBuffer[i].Type != SYMBOL_SEMANTIC_RULE_TYPE)
+        {
+            //
+            // Operands are placed along with their operators
+            //
+            continue;
+        }
+
+        if (!HardwareScriptInterpreterCanFuseOperator(InstanceInfo, NumberOfOperatorsInStage, SymbolBuffer[i].Value))
+        {
+            //
+            // Start a new stage
+            //
+            Stages++;
+            NumberOfOperatorsInStage = 0;
+        }
+
+        NumberOfOperatorsInStage++;
+    }
+
+    if (Stages > InstanceInfo->maximumNumberOfStages)
+    {
+        ShowMessages("err, the script needs %d stages but this instance of hwdbg only supports %d stages\n",
+                     Stages,
+                     InstanceInfo->maximumNumberOfStages);
+        return FALSE;
+    }
+
+    *NumberOfStages = Stages;
+
+    return TRUE;
+}
+
 /**
  * @brief Function to compress the buffer
+ * @details The operators are packed into stages, each stage contains the stage
+ * operator and the fused operators (maximumNumberOfOperatorsPerStage operators),
+ * each of them followed by their GET and SET operands
  *
  * @param InstanceInfo
  * @param SymbolBuffer
  * @param SymbolBufferLength
- * @param NumberOfStages
+ * @param NumberOfStages Number of stages after packing the operators
  * @param NewShortSymbolBuffer
  * @param NewBufferSize
  *
@@ -524,7 +650,7 @@ HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer(
     HWDBG_INSTANCE_INFORMATION * InstanceInfo,
     SYMBOL *                     SymbolBuffer,
     size_t                       SymbolBufferLength,
-    UINT32                       NumberOfStages,
+    UINT32 *                     NumberOfStages,
     HWDBG_SHORT_SYMBOL **        NewShortSymbolBuffer,
     size_t *                     NewBufferSize)
 
@@ -545,7 +671,15 @@ HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer(
 
     SIZE_T NumberOfSymbols = SymbolBufferLength / sizeof(SymbolBuffer[0]);
 
-    *NewBufferSize = NumberOfStages * (NumberOfOperands + 1) * sizeof(HWDBG_SHORT_SYMBOL); // number of stage + maximum number of operands
+    //
+    // Pack the operators into stages
+    //
+    if (!HardwareScriptInterpreterPackStages(InstanceInfo, SymbolBuffer, NumberOfSymbols, NumberOfStages))
+    {
+        return FALSE;
+    }
+
+    *NewBufferSize = *NumberOfStages * InstanceInfo->maximumNumberOfOperatorsPerStage * (NumberOfOperands + 1) * sizeof(HWDBG_SHORT_SYMBOL); // number of operators + maximum number of operands
 
     //
     // Create a temporary buffer to hold the compressed data
@@ -567,6 +701,7 @@ HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer(
     // Filling the short symbol buffer from original buffer
     //
     UINT32 IndexOfShortSymbolBuffer = 0;
+    UINT32 NumberOfOperatorsInStage = 0;
 
     for (UINT32 i = 0; i < NumberOfSymbols; i++)
     {
@@ -576,6 +711,22 @@ HardwareScriptInterpreterConvertSymbolToHwdbgShortSymbolBuffer(
             // *** This is an operator ***
             //
 
+            //
+            // Check whether the operator is fused into the current stage or starts a new stage
+            // (same as HardwareScriptInterpreterPackStages)
+            //
+            if (NumberOfOperatorsInStage != 0 &&
+                !HardwareScriptInterpreterCanFuseOperator(InstanceInfo, NumberOfOperatorsInStage, SymbolBuffer[i].Value))
+            {
+                //
+                // Leave empty space for the fused operators that are not used in the current stage
+                //
+                IndexOfShortSymbolBuffer = IndexOfShortSymbolBuffer + (InstanceInfo->maximumNumberOfOperatorsPerStage - NumberOfOperatorsInStage) * (NumberOfOperands + 1);
+                NumberOfOperatorsInStage = 0;
+            }
+
+            NumberOfOperatorsInStage++;
+
             //
             // Move the symbol buffer into a short symbol buffer
             //
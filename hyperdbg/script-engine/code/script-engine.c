@@ -205,6 +205,22 @@ ScriptEngineCreateSymbolTableForDisassembler(void * CallbackFunction)
     return SymCreateSymbolTableForDisassembler(CallbackFunction);
 }
 
+/**
+ * @brief Create symbol table for disassembler from the symbols of one module
+ *
+ * @param CallbackFunction
+ * @param BaseAddress
+ * @return BOOLEAN
+ */
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModule(void * CallbackFunction, UINT64 BaseAddress)
+{
+    //
+    // A wrapper for pdb symbol table callback creator
+    //
+    return SymCreateSymbolTableForDisassemblerFromModule(CallbackFunction, BaseAddress);
+}
+
 /**
  * @brief Convert local file to pdb path
  *
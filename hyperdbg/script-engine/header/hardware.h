@@ -18,3 +18,17 @@
 //
 // Some of the functions are exported at HyperDbgScriptImports.h
 //
+
+BOOLEAN
+HardwareScriptInterpreterIsFusibleOperator(UINT64 Operator);
+
+BOOLEAN
+HardwareScriptInterpreterCanFuseOperator(HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+                                         UINT32                       NumberOfOperatorsInStage,
+                                         UINT64                       Operator);
+
+BOOLEAN
+HardwareScriptInterpreterPackStages(HWDBG_INSTANCE_INFORMATION * InstanceInfo,
+                                    SYMBOL *                     SymbolBuffer,
+                                    size_t                       NumberOfSymbols,
+                                    UINT32 *                     NumberOfStages);
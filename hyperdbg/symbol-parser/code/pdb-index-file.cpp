@@ -0,0 +1,250 @@
+/**
+ * @file pdb-index-file.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Opening and saving the symbol index files
+ * @details The parser and the lookups of the index are portable (in
+ * pdb-index.cpp), this file contains the (Windows) file mappings
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Map a file into the memory (read-only)
+ *
+ * @param FilePath Path of the file
+ * @param FileHandle Handle of the file
+ * @param MappingHandle Handle of the file mapping
+ * @param Size Size of the file
+ *
+ * @return const BYTE * The mapped view or NULL
+ */
+const BYTE *
+PdbMapFile(const char * FilePath, HANDLE * FileHandle, HANDLE * MappingHandle, UINT64 * Size)
+{
+    LARGE_INTEGER FileSize;
+    const BYTE *  View;
+
+    *FileHandle    = NULL;
+    *MappingHandle = NULL;
+
+    *FileHandle = CreateFileA(FilePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (*FileHandle == INVALID_HANDLE_VALUE)
+    {
+        *FileHandle = NULL;
+        return NULL;
+    }
+
+    if (!GetFileSizeEx(*FileHandle, &FileSize) || FileSize.QuadPart == 0)
+    {
+        CloseHandle(*FileHandle);
+        *FileHandle = NULL;
+        return NULL;
+    }
+
+    *MappingHandle = CreateFileMappingA(*FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (*MappingHandle == NULL)
+    {
+        CloseHandle(*FileHandle);
+        *FileHandle = NULL;
+        return NULL;
+    }
+
+    View = (const BYTE *)MapViewOfFile(*MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (View == NULL)
+    {
+        CloseHandle(*MappingHandle);
+        CloseHandle(*FileHandle);
+        *MappingHandle = NULL;
+        *FileHandle    = NULL;
+        return NULL;
+    }
+
+    *Size = (UINT64)FileSize.QuadPart;
+
+    return View;
+}
+
+/**
+ * @brief Unmap a file that is mapped by PdbMapFile
+ *
+ * @param View The mapped view
+ * @param FileHandle Handle of the file
+ * @param MappingHandle Handle of the file mapping
+ *
+ * @return VOID
+ */
+VOID
+PdbUnmapFile(const BYTE * View, HANDLE FileHandle, HANDLE MappingHandle)
+{
+    if (View != NULL)
+    {
+        UnmapViewOfFile(View);
+    }
+
+    if (MappingHandle != NULL)
+    {
+        CloseHandle(MappingHandle);
+    }
+
+    if (FileHandle != NULL)
+    {
+        CloseHandle(FileHandle);
+    }
+}
+
+/**
+ * @brief Open the symbol index of a PDB file
+ * @details If the index file doesn't exist or it's outdated, then the PDB
+ * file is parsed and the index is saved next to the PDB file
+ *
+ * @param PdbFilePath Path of the PDB file
+ *
+ * @return PPDB_INDEX The index or NULL if the PDB file couldn't be parsed
+ */
+PPDB_INDEX
+PdbIndexOpen(const char * PdbFilePath)
+{
+    WIN32_FILE_ATTRIBUTE_DATA PdbAttributes;
+    PPDB_INDEX                Index;
+    PDB_MSF_FILE              Msf;
+    HANDLE                    PdbFileHandle;
+    HANDLE                    PdbMappingHandle;
+    HANDLE                    IndexFileHandle;
+    const BYTE *              PdbView;
+    const BYTE *              IndexView;
+    UINT64                    PdbFileSize;
+    UINT64                    PdbLastWriteTime;
+    UINT64                    IndexSize;
+    DWORD                     BytesWritten;
+    BOOLEAN                   Result;
+    string                    IndexFilePath = string(PdbFilePath) + PDB_INDEX_FILE_EXTENSION;
+
+    if (!GetFileAttributesExA(PdbFilePath, GetFileExInfoStandard, &PdbAttributes))
+    {
+        return NULL;
+    }
+
+    PdbFileSize      = ((UINT64)PdbAttributes.nFileSizeHigh << 32) | PdbAttributes.nFileSizeLow;
+    PdbLastWriteTime = ((UINT64)PdbAttributes.ftLastWriteTime.dwHighDateTime << 32) | PdbAttributes.ftLastWriteTime.dwLowDateTime;
+
+    Index = new PDB_INDEX();
+
+    //
+    // Use the previously saved index if it belongs to the same PDB file
+    //
+    IndexView = PdbMapFile(IndexFilePath.c_str(), &Index->FileHandle, &Index->MappingHandle, &IndexSize);
+
+    if (IndexView != NULL)
+    {
+        if (PdbIndexAttach(Index, IndexView, IndexSize) &&
+            Index->Header->PdbFileSize == PdbFileSize &&
+            Index->Header->PdbLastWriteTime == PdbLastWriteTime)
+        {
+            return Index;
+        }
+
+        PdbUnmapFile(IndexView, Index->FileHandle, Index->MappingHandle);
+
+        Index->FileHandle    = NULL;
+        Index->MappingHandle = NULL;
+    }
+
+    //
+    // Parse the PDB file and build the index
+    //
+    PdbView = PdbMapFile(PdbFilePath, &PdbFileHandle, &PdbMappingHandle, &PdbFileSize);
+
+    if (PdbView == NULL)
+    {
+        delete Index;
+        return NULL;
+    }
+
+    Result = PdbMsfOpen(PdbView, PdbFileSize, &Msf) &&
+             PdbIndexBuild(&Msf, PdbFileSize, PdbLastWriteTime, Index->Buffer);
+
+    PdbUnmapFile(PdbView, PdbFileHandle, PdbMappingHandle);
+
+    if (!Result)
+    {
+        delete Index;
+        return NULL;
+    }
+
+    //
+    // Save the index, so the next sessions only map the index file
+    //
+    IndexFileHandle = CreateFileA(IndexFilePath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (IndexFileHandle != INVALID_HANDLE_VALUE)
+    {
+        Result = WriteFile(IndexFileHandle, Index->Buffer.data(), (DWORD)Index->Buffer.size(), &BytesWritten, NULL) &&
+                 BytesWritten == Index->Buffer.size();
+
+        CloseHandle(IndexFileHandle);
+
+        if (Result)
+        {
+            IndexView = PdbMapFile(IndexFilePath.c_str(), &Index->FileHandle, &Index->MappingHandle, &IndexSize);
+
+            if (IndexView != NULL && PdbIndexAttach(Index, IndexView, IndexSize))
+            {
+                Index->Buffer.clear();
+                Index->Buffer.shrink_to_fit();
+
+                return Index;
+            }
+
+            PdbUnmapFile(IndexView, Index->FileHandle, Index->MappingHandle);
+
+            Index->FileHandle    = NULL;
+            Index->MappingHandle = NULL;
+        }
+        else
+        {
+            DeleteFileA(IndexFilePath.c_str());
+        }
+    }
+
+    //
+    // The index couldn't be saved (e.g., read-only symbol path), keep it in the memory
+    //
+    if (!PdbIndexAttach(Index, Index->Buffer.data(), Index->Buffer.size()))
+    {
+        delete Index;
+        return NULL;
+    }
+
+    return Index;
+}
+
+/**
+ * @brief Close a symbol index
+ *
+ * @param Index
+ *
+ * @return VOID
+ */
+VOID
+PdbIndexClose(PPDB_INDEX Index)
+{
+    if (Index == NULL)
+    {
+        return;
+    }
+
+    if (Index->FileHandle != NULL)
+    {
+        PdbUnmapFile(Index->Base, Index->FileHandle, Index->MappingHandle);
+    }
+
+    delete Index;
+}
@@ -0,0 +1,1284 @@
+/**
+ * @file pdb-index.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Native PDB (MSF) reader and the memory-mapped symbol index
+ * @details The PDB file is parsed once and a compact index (symbols sorted
+ * by RVA, hash tables of names, and flattened fields of types) is saved next
+ * to the PDB file, later loads only map the index file
+ *
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+/**
+ * @brief Compute the (case-insensitive) hash of a name
+ *
+ * @param Name
+ *
+ * @return UINT32
+ */
+UINT32
+PdbIndexHashName(const char * Name)
+{
+    UINT32 Hash = 0x811c9dc5;
+
+    //
+    // FNV-1a of the lower-case characters
+    //
+    while (*Name != '\0')
+    {
+        Hash ^= (UINT32)tolower((unsigned char)*Name);
+        Hash *= 0x01000193;
+        Name++;
+    }
+
+    return Hash;
+}
+
+/**
+ * @brief Compare two names (case-insensitive)
+ * @details Same as _stricmp but it's also used in the portable parts of
+ * the index (it matches the lower-case hash of the names)
+ *
+ * @param Name1
+ * @param Name2
+ *
+ * @return INT32 Zero if the names are equal
+ */
+INT32
+PdbIndexCompareNames(const char * Name1, const char * Name2)
+{
+    while (*Name1 != '\0' && tolower((unsigned char)*Name1) == tolower((unsigned char)*Name2))
+    {
+        Name1++;
+        Name2++;
+    }
+
+    return tolower((unsigned char)*Name1) - tolower((unsigned char)*Name2);
+}
+
+/**
+ * @brief Get the number of buckets of a hash table
+ * @details The table is at most half full, so the linear probing always
+ * reaches an empty bucket
+ *
+ * @param CountOfEntries
+ *
+ * @return UINT32
+ */
+UINT32
+PdbIndexGetCountOfBuckets(UINT32 CountOfEntries)
+{
+    UINT32 CountOfBuckets = 1;
+
+    while (CountOfBuckets < CountOfEntries * 2)
+    {
+        CountOfBuckets <<= 1;
+    }
+
+    return CountOfBuckets;
+}
+
+/**
+ * @brief Read a numeric leaf of a CodeView record
+ *
+ * @param Current The start of the numeric leaf
+ * @param End The end of the record
+ * @param Value The value of the leaf
+ *
+ * @return UINT32 The size of the leaf or zero if the leaf is invalid
+ */
+UINT32
+PdbReadNumericLeaf(const BYTE * Current, const BYTE * End, UINT64 * Value)
+{
+    UINT16 Leaf;
+    UINT32 Size;
+
+    if (Current + sizeof(UINT16) > End)
+    {
+        return 0;
+    }
+
+    Leaf = *(UINT16 UNALIGNED *)Current;
+
+    if (Leaf < PDB_LF_NUMERIC)
+    {
+        *Value = Leaf;
+        return sizeof(UINT16);
+    }
+
+    switch (Leaf)
+    {
+    case PDB_LF_CHAR:
+        Size = sizeof(UINT8);
+        break;
+
+    case PDB_LF_SHORT:
+    case PDB_LF_USHORT:
+        Size = sizeof(UINT16);
+        break;
+
+    case PDB_LF_LONG:
+    case PDB_LF_ULONG:
+        Size = sizeof(UINT32);
+        break;
+
+    case PDB_LF_QUADWORD:
+    case PDB_LF_UQUADWORD:
+        Size = sizeof(UINT64);
+        break;
+
+    default:
+        return 0;
+    }
+
+    if (Current + sizeof(UINT16) + Size > End)
+    {
+        return 0;
+    }
+
+    *Value = 0;
+    memcpy(Value, Current + sizeof(UINT16), Size);
+
+    return sizeof(UINT16) + Size;
+}
+
+/**
+ * @brief Read a null-terminated name of a CodeView record
+ *
+ * @param Current The start of the name
+ * @param End The end of the record
+ * @param Length The length of the name
+ *
+ * @return const char * The name or NULL if it's not terminated in the record
+ */
+const char *
+PdbReadName(const BYTE * Current, const BYTE * End, UINT32 * Length)
+{
+    const BYTE * Terminator;
+
+    if (Current >= End)
+    {
+        return NULL;
+    }
+
+    Terminator = (const BYTE *)memchr(Current, '\0', End - Current);
+
+    if (Terminator == NULL)
+    {
+        return NULL;
+    }
+
+    *Length = (UINT32)(Terminator - Current);
+
+    return (const char *)Current;
+}
+
+/**
+ * @brief Parse the super block and the stream directory of an MSF file
+ *
+ * @param Base The mapped view of the file
+ * @param Size Size of the file
+ * @param Msf The opened MSF file
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbMsfOpen(const BYTE * Base, UINT64 Size, PPDB_MSF_FILE Msf)
+{
+    PPDB_MSF_SUPER_BLOCK SuperBlock = (PPDB_MSF_SUPER_BLOCK)Base;
+    const UINT32 *       DirectoryBlocks;
+    const UINT32 *       DirectoryEntries;
+    UINT64               CountOfDirectoryBlocks;
+    UINT32               CountOfDirectoryEntries;
+    UINT32               CountOfStreams;
+    UINT64               CurrentBlock;
+    UINT32               StreamSize;
+
+    if (Size < sizeof(PDB_MSF_SUPER_BLOCK) ||
+        memcmp(SuperBlock->FileMagic, PDB_MSF_MAGIC, sizeof(SuperBlock->FileMagic)) != 0)
+    {
+        return FALSE;
+    }
+
+    //
+    // Validate the geometry of the file
+    //
+    if (SuperBlock->BlockSize < 512 ||
+        (SuperBlock->BlockSize & (SuperBlock->BlockSize - 1)) != 0 ||
+        (UINT64)SuperBlock->NumberOfBlocks * SuperBlock->BlockSize > Size ||
+        SuperBlock->NumberOfDirectoryBytes < sizeof(UINT32))
+    {
+        return FALSE;
+    }
+
+    Msf->Base          = Base;
+    Msf->Size          = Size;
+    Msf->BlockSize     = SuperBlock->BlockSize;
+    Msf->CountOfBlocks = SuperBlock->NumberOfBlocks;
+
+    //
+    // The sizes are computed in 64-bit to avoid overflows of the malformed files
+    //
+    CountOfDirectoryBlocks = ((UINT64)SuperBlock->NumberOfDirectoryBytes + Msf->BlockSize - 1) / Msf->BlockSize;
+
+    if (SuperBlock->BlockMapAddress >= Msf->CountOfBlocks ||
+        CountOfDirectoryBlocks * sizeof(UINT32) > Msf->BlockSize)
+    {
+        return FALSE;
+    }
+
+    //
+    // Gather the blocks of the stream directory
+    //
+    DirectoryBlocks = (const UINT32 *)(Base + ((UINT64)SuperBlock->BlockMapAddress * Msf->BlockSize));
+
+    Msf->Directory.resize((SIZE_T)CountOfDirectoryBlocks * Msf->BlockSize);
+
+    for (UINT32 i = 0; i < (UINT32)CountOfDirectoryBlocks; i++)
+    {
+        if (DirectoryBlocks[i] >= Msf->CountOfBlocks)
+        {
+            return FALSE;
+        }
+
+        memcpy(&Msf->Directory[(SIZE_T)i * Msf->BlockSize],
+               Base + ((UINT64)DirectoryBlocks[i] * Msf->BlockSize),
+               Msf->BlockSize);
+    }
+
+    //
+    // The directory contains the number of streams, the size of streams and
+    // then the blocks of each stream
+    //
+    DirectoryEntries        = (const UINT32 *)Msf->Directory.data();
+    CountOfDirectoryEntries = SuperBlock->NumberOfDirectoryBytes / sizeof(UINT32);
+    CountOfStreams          = DirectoryEntries[0];
+
+    if (CountOfStreams > CountOfDirectoryEntries - 1)
+    {
+        return FALSE;
+    }
+
+    CurrentBlock = 1 + CountOfStreams;
+
+    Msf->StreamSizes.resize(CountOfStreams);
+    Msf->StreamFirstBlock.resize(CountOfStreams);
+
+    for (UINT32 i = 0; i < CountOfStreams; i++)
+    {
+        StreamSize = DirectoryEntries[1 + i];
+
+        //
+        // Nil streams are considered as empty streams
+        //
+        if (StreamSize == 0xffffffff)
+        {
+            StreamSize = 0;
+        }
+
+        Msf->StreamSizes[i]      = StreamSize;
+        Msf->StreamFirstBlock[i] = (UINT32)CurrentBlock;
+
+        //
+        // The blocks of the stream should be in the block map (directory)
+        //
+        CurrentBlock += ((UINT64)StreamSize + Msf->BlockSize - 1) / Msf->BlockSize;
+
+        if (CurrentBlock > CountOfDirectoryEntries)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Read a stream of an MSF file
+ *
+ * @param Msf The opened MSF file
+ * @param StreamIndex Index of the stream
+ * @param Stream The content of the stream
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbMsfReadStream(PPDB_MSF_FILE Msf, UINT32 StreamIndex, std::vector<BYTE> & Stream)
+{
+    const UINT32 * Blocks;
+    UINT32         StreamSize;
+    UINT32         CopySize;
+
+    if (StreamIndex >= Msf->StreamSizes.size())
+    {
+        return FALSE;
+    }
+
+    StreamSize = Msf->StreamSizes[StreamIndex];
+    Blocks     = ((const UINT32 *)Msf->Directory.data()) + Msf->StreamFirstBlock[StreamIndex];
+
+    Stream.resize(StreamSize);
+
+    for (UINT32 Offset = 0, i = 0; Offset < StreamSize; Offset += CopySize, i++)
+    {
+        if (Blocks[i] >= Msf->CountOfBlocks)
+        {
+            return FALSE;
+        }
+
+        CopySize = (StreamSize - Offset < Msf->BlockSize) ? StreamSize - Offset : Msf->BlockSize;
+
+        memcpy(&Stream[Offset], Msf->Base + ((UINT64)Blocks[i] * Msf->BlockSize), CopySize);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Add a name to the names of the index
+ *
+ * @param Names The names of the index
+ * @param Name The name to add
+ * @param Length Length of the name
+ *
+ * @return UINT32 Offset of the name
+ */
+UINT32
+PdbIndexAddName(std::vector<CHAR> & Names, const char * Name, UINT32 Length)
+{
+    UINT32 Offset = (UINT32)Names.size();
+
+    Names.insert(Names.end(), Name, Name + Length);
+    Names.push_back('\0');
+
+    return Offset;
+}
+
+/**
+ * @brief Collect the public and global data symbols of the PDB
+ *
+ * @param Msf The opened MSF file
+ * @param Symbols The collected symbols
+ * @param Names The names of the index
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexCollectSymbols(PPDB_MSF_FILE Msf, std::vector<PDB_INDEX_SYMBOL> & Symbols, std::vector<CHAR> & Names)
+{
+    std::vector<BYTE>      DbiStream;
+    std::vector<BYTE>      SectionHeadersStream;
+    std::vector<BYTE>      SymbolRecordStream;
+    PPDB_DBI_STREAM_HEADER DbiHeader;
+    PIMAGE_SECTION_HEADER  SectionHeaders;
+    UINT32                 CountOfSections;
+    UINT64                 DebugHeaderOffset;
+    UINT16                 SectionHeadersStreamIndex;
+    const BYTE *           Record;
+    const BYTE *           RecordEnd;
+    const BYTE *           StreamEnd;
+    const char *           Name;
+    UINT32                 NameLength;
+    UINT16                 Kind;
+    UINT32                 Offset;
+    UINT16                 Segment;
+    PDB_INDEX_SYMBOL       Symbol;
+
+    if (!PdbMsfReadStream(Msf, PDB_STREAM_DBI, DbiStream) || DbiStream.size() < sizeof(PDB_DBI_STREAM_HEADER))
+    {
+        return FALSE;
+    }
+
+    DbiHeader = (PPDB_DBI_STREAM_HEADER)DbiStream.data();
+
+    //
+    // Find the section headers (for converting segment:offset to RVA), the optional
+    // debug header is located after all of the other substreams
+    //
+    DebugHeaderOffset = sizeof(PDB_DBI_STREAM_HEADER) + (UINT64)(UINT32)DbiHeader->ModuleInfoSize +
+                        (UINT32)DbiHeader->SectionContributionSize + (UINT32)DbiHeader->SectionMapSize +
+                        (UINT32)DbiHeader->SourceInfoSize + (UINT32)DbiHeader->TypeServerMapSize +
+                        (UINT32)DbiHeader->EcSubstreamSize;
+
+    if (DbiHeader->OptionalDebugHeaderSize < (INT32)((PDB_DBI_DEBUG_HEADER_SECTION_HEADERS + 1) * sizeof(UINT16)) ||
+        DebugHeaderOffset + (UINT32)DbiHeader->OptionalDebugHeaderSize > DbiStream.size())
+    {
+        return FALSE;
+    }
+
+    SectionHeadersStreamIndex = *(UINT16 UNALIGNED *)&DbiStream[(SIZE_T)DebugHeaderOffset + (PDB_DBI_DEBUG_HEADER_SECTION_HEADERS * sizeof(UINT16))];
+
+    if (!PdbMsfReadStream(Msf, SectionHeadersStreamIndex, SectionHeadersStream) ||
+        !PdbMsfReadStream(Msf, DbiHeader->SymbolRecordStreamIndex, SymbolRecordStream))
+    {
+        return FALSE;
+    }
+
+    SectionHeaders  = (PIMAGE_SECTION_HEADER)SectionHeadersStream.data();
+    CountOfSections = (UINT32)(SectionHeadersStream.size() / sizeof(IMAGE_SECTION_HEADER));
+
+    //
+    // Walk the symbol records (each record starts with its length and kind)
+    //
+    Record    = SymbolRecordStream.data();
+    StreamEnd = Record + SymbolRecordStream.size();
+
+    while (Record + (2 * sizeof(UINT16)) <= StreamEnd)
+    {
+        RecordEnd = Record + sizeof(UINT16) + *(UINT16 UNALIGNED *)Record;
+        Kind      = *(UINT16 UNALIGNED *)(Record + sizeof(UINT16));
+
+        if (RecordEnd > StreamEnd)
+        {
+            break;
+        }
+
+        //
+        // Public symbols (flags) and data symbols (type index) have the same layout
+        //
+        if ((Kind == PDB_S_PUB32 || Kind == PDB_S_GDATA32 || Kind == PDB_S_LDATA32 ||
+             Kind == PDB_S_GTHREAD32 || Kind == PDB_S_LTHREAD32) &&
+            Record + 14 < RecordEnd)
+        {
+            Offset  = *(UINT32 UNALIGNED *)(Record + 8);
+            Segment = *(UINT16 UNALIGNED *)(Record + 12);
+            Name    = PdbReadName(Record + 14, RecordEnd, &NameLength);
+
+            if (Name != NULL && NameLength != 0 && Segment != 0 && Segment <= CountOfSections)
+            {
+                Symbol.Rva        = SectionHeaders[Segment - 1].VirtualAddress + Offset;
+                Symbol.NameOffset = PdbIndexAddName(Names, Name, NameLength);
+
+                Symbols.push_back(Symbol);
+            }
+        }
+
+        Record = RecordEnd;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Collect the fields of a field list record
+ *
+ * @param TpiStream The TPI stream
+ * @param TpiHeader Header of the TPI stream
+ * @param RecordOffsets Offsets of the type records in the TPI stream
+ * @param FieldListIndex Type index of the field list
+ * @param Fields The collected fields
+ * @param Names The names of the index
+ *
+ * @return BOOLEAN FALSE if the field list has an unknown member
+ */
+BOOLEAN
+PdbIndexCollectFields(std::vector<BYTE> &            TpiStream,
+                      PPDB_TPI_STREAM_HEADER         TpiHeader,
+                      std::vector<UINT32> &          RecordOffsets,
+                      UINT32                         FieldListIndex,
+                      std::vector<PDB_INDEX_FIELD> & Fields,
+                      std::vector<CHAR> &            Names)
+{
+    const BYTE *    Current;
+    const BYTE *    End;
+    const BYTE *    TypeRecord;
+    const char *    Name;
+    UINT32          NameLength;
+    UINT32          LeafSize;
+    UINT32          MemberType;
+    UINT16          Leaf;
+    UINT16          Attributes;
+    UINT64          Value;
+    UINT32          Depth = 0;
+    PDB_INDEX_FIELD Field;
+
+    //
+    // Long field lists are continued in other field lists (LF_INDEX)
+    //
+    while (FieldListIndex >= TpiHeader->TypeIndexBegin && FieldListIndex < TpiHeader->TypeIndexEnd && Depth++ < 0x1000)
+    {
+        Current = &TpiStream[RecordOffsets[FieldListIndex - TpiHeader->TypeIndexBegin]];
+        End     = Current + sizeof(UINT16) + *(UINT16 UNALIGNED *)Current;
+
+        //
+        // The records are already checked to be in the stream
+        //
+        if (*(UINT16 UNALIGNED *)Current < sizeof(UINT16) ||
+            *(UINT16 UNALIGNED *)(Current + sizeof(UINT16)) != PDB_LF_FIELDLIST)
+        {
+            return FALSE;
+        }
+
+        Current += 2 * sizeof(UINT16);
+        FieldListIndex = 0;
+
+        while (Current + sizeof(UINT16) <= End)
+        {
+            Leaf = *(UINT16 UNALIGNED *)Current;
+            Current += sizeof(UINT16);
+
+            switch (Leaf)
+            {
+            case PDB_LF_MEMBER:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                MemberType = *(UINT32 UNALIGNED *)(Current + sizeof(UINT16));
+                Current += sizeof(UINT16) + sizeof(UINT32);
+
+                LeafSize = PdbReadNumericLeaf(Current, End, &Value);
+                Name     = PdbReadName(Current + LeafSize, End, &NameLength);
+
+                if (LeafSize == 0 || Name == NULL)
+                {
+                    return FALSE;
+                }
+
+                Field.NameOffset  = PdbIndexAddName(Names, Name, NameLength);
+                Field.Offset      = (UINT32)Value;
+                Field.BitPosition = 0;
+                Field.BitLength   = 0;
+
+                //
+                // Check whether the member is a bit-field
+                //
+                if (MemberType >= TpiHeader->TypeIndexBegin && MemberType < TpiHeader->TypeIndexEnd)
+                {
+                    TypeRecord = &TpiStream[RecordOffsets[MemberType - TpiHeader->TypeIndexBegin]];
+
+                    if (*(UINT16 UNALIGNED *)TypeRecord >= sizeof(UINT16) + sizeof(UINT32) + 2 &&
+                        *(UINT16 UNALIGNED *)(TypeRecord + sizeof(UINT16)) == PDB_LF_BITFIELD)
+                    {
+                        Field.BitLength   = TypeRecord[8];
+                        Field.BitPosition = TypeRecord[9];
+                    }
+                }
+
+                Fields.push_back(Field);
+
+                Current += LeafSize + NameLength + 1;
+                break;
+
+            case PDB_LF_BCLASS:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                Current += sizeof(UINT16) + sizeof(UINT32);
+                LeafSize = PdbReadNumericLeaf(Current, End, &Value);
+
+                if (LeafSize == 0)
+                {
+                    return FALSE;
+                }
+
+                Current += LeafSize;
+                break;
+
+            case PDB_LF_VBCLASS:
+            case PDB_LF_IVBCLASS:
+
+                if (Current + sizeof(UINT16) + (2 * sizeof(UINT32)) > End)
+                {
+                    return FALSE;
+                }
+
+                Current += sizeof(UINT16) + (2 * sizeof(UINT32));
+                LeafSize = PdbReadNumericLeaf(Current, End, &Value);
+
+                if (LeafSize == 0)
+                {
+                    return FALSE;
+                }
+
+                Current += LeafSize;
+                LeafSize = PdbReadNumericLeaf(Current, End, &Value);
+
+                if (LeafSize == 0)
+                {
+                    return FALSE;
+                }
+
+                Current += LeafSize;
+                break;
+
+            case PDB_LF_ENUMERATE:
+
+                if (Current + sizeof(UINT16) > End)
+                {
+                    return FALSE;
+                }
+
+                Current += sizeof(UINT16);
+                LeafSize = PdbReadNumericLeaf(Current, End, &Value);
+                Name     = PdbReadName(Current + LeafSize, End, &NameLength);
+
+                if (LeafSize == 0 || Name == NULL)
+                {
+                    return FALSE;
+                }
+
+                Current += LeafSize + NameLength + 1;
+                break;
+
+            case PDB_LF_STMEMBER:
+            case PDB_LF_METHOD:
+            case PDB_LF_NESTTYPE:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                Name = PdbReadName(Current + sizeof(UINT16) + sizeof(UINT32), End, &NameLength);
+
+                if (Name == NULL)
+                {
+                    return FALSE;
+                }
+
+                Current += sizeof(UINT16) + sizeof(UINT32) + NameLength + 1;
+                break;
+
+            case PDB_LF_ONEMETHOD:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                //
+                // Introducing virtual methods have an extra virtual base offset
+                //
+                Attributes = *(UINT16 UNALIGNED *)Current;
+                Current += sizeof(UINT16) + sizeof(UINT32);
+
+                if (((Attributes >> 2) & 7) == 4 || ((Attributes >> 2) & 7) == 6)
+                {
+                    if (Current + sizeof(UINT32) > End)
+                    {
+                        return FALSE;
+                    }
+
+                    Current += sizeof(UINT32);
+                }
+
+                Name = PdbReadName(Current, End, &NameLength);
+
+                if (Name == NULL)
+                {
+                    return FALSE;
+                }
+
+                Current += NameLength + 1;
+                break;
+
+            case PDB_LF_VFUNCTAB:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                Current += sizeof(UINT16) + sizeof(UINT32);
+                break;
+
+            case PDB_LF_INDEX:
+
+                if (Current + sizeof(UINT16) + sizeof(UINT32) > End)
+                {
+                    return FALSE;
+                }
+
+                FieldListIndex = *(UINT32 UNALIGNED *)(Current + sizeof(UINT16));
+                Current += sizeof(UINT16) + sizeof(UINT32);
+                break;
+
+            default:
+
+                //
+                // Unknown member, the type is left for DbgHelp
+                //
+                return FALSE;
+            }
+
+            //
+            // Skip the padding of the members
+            //
+            while (Current < End && *Current > PDB_LF_PAD0)
+            {
+                Current++;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Collect the structures, classes, and unions of the PDB
+ *
+ * @param Msf The opened MSF file
+ * @param Types The collected types
+ * @param Fields The collected fields
+ * @param Names The names of the index
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexCollectTypes(PPDB_MSF_FILE                  Msf,
+                     std::vector<PDB_INDEX_TYPE> &  Types,
+                     std::vector<PDB_INDEX_FIELD> & Fields,
+                     std::vector<CHAR> &            Names)
+{
+    std::vector<BYTE>      TpiStream;
+    std::vector<UINT32>    RecordOffsets;
+    PPDB_TPI_STREAM_HEADER TpiHeader;
+    const BYTE *           Record;
+    const BYTE *           RecordEnd;
+    const BYTE *           StreamEnd;
+    const BYTE *           Current;
+    const char *           Name;
+    UINT32                 NameLength;
+    UINT32                 LeafSize;
+    UINT32                 FieldList;
+    UINT16                 Kind;
+    UINT16                 Properties;
+    UINT64                 Size;
+    SIZE_T                 CountOfFields;
+    PDB_INDEX_TYPE         Type = {0};
+
+    if (!PdbMsfReadStream(Msf, PDB_STREAM_TPI, TpiStream) ||
+        TpiStream.size() < sizeof(PDB_TPI_STREAM_HEADER))
+    {
+        return FALSE;
+    }
+
+    TpiHeader = (PPDB_TPI_STREAM_HEADER)TpiStream.data();
+
+    if (TpiHeader->HeaderSize < sizeof(PDB_TPI_STREAM_HEADER) ||
+        (UINT64)TpiHeader->HeaderSize + TpiHeader->TypeRecordBytes > TpiStream.size() ||
+        TpiHeader->TypeIndexEnd < TpiHeader->TypeIndexBegin)
+    {
+        return FALSE;
+    }
+
+    //
+    // Find the offsets of the type records (records are addressed by type indexes)
+    //
+    Record    = &TpiStream[TpiHeader->HeaderSize];
+    StreamEnd = Record + TpiHeader->TypeRecordBytes;
+
+    while (Record + (2 * sizeof(UINT16)) <= StreamEnd)
+    {
+        RecordEnd = Record + sizeof(UINT16) + *(UINT16 UNALIGNED *)Record;
+
+        if (RecordEnd > StreamEnd)
+        {
+            break;
+        }
+
+        RecordOffsets.push_back((UINT32)(Record - TpiStream.data()));
+        Record = RecordEnd;
+    }
+
+    if (RecordOffsets.size() != TpiHeader->TypeIndexEnd - TpiHeader->TypeIndexBegin)
+    {
+        return FALSE;
+    }
+
+    for (UINT32 Offset : RecordOffsets)
+    {
+        Record    = &TpiStream[Offset];
+        RecordEnd = Record + sizeof(UINT16) + *(UINT16 UNALIGNED *)Record;
+        Kind      = *(UINT16 UNALIGNED *)(Record + sizeof(UINT16));
+
+        //
+        // Structures and classes have the derivation list and the vtable shape
+        // before the size
+        //
+        if (Kind == PDB_LF_STRUCTURE || Kind == PDB_LF_CLASS)
+        {
+            Current = Record + 20;
+        }
+        else if (Kind == PDB_LF_UNION)
+        {
+            Current = Record + 12;
+        }
+        else
+        {
+            continue;
+        }
+
+        if (Current > RecordEnd)
+        {
+            continue;
+        }
+
+        Properties = *(UINT16 UNALIGNED *)(Record + 6);
+        FieldList  = *(UINT32 UNALIGNED *)(Record + 8);
+
+        //
+        // Forward references don't have any field
+        //
+        if (Properties & PDB_TYPE_PROPERTY_FORWARD_REFERENCE)
+        {
+            continue;
+        }
+
+        LeafSize = PdbReadNumericLeaf(Current, RecordEnd, &Size);
+        Name     = PdbReadName(Current + LeafSize, RecordEnd, &NameLength);
+
+        if (LeafSize == 0 || Name == NULL || NameLength == 0)
+        {
+            continue;
+        }
+
+        CountOfFields = Fields.size();
+
+        if (!PdbIndexCollectFields(TpiStream, TpiHeader, RecordOffsets, FieldList, Fields, Names))
+        {
+            Fields.resize(CountOfFields);
+            continue;
+        }
+
+        Type.NameOffset    = PdbIndexAddName(Names, Name, NameLength);
+        Type.FirstField    = (UINT32)CountOfFields;
+        Type.CountOfFields = (UINT32)(Fields.size() - CountOfFields);
+        Type.Size          = Size;
+
+        Types.push_back(Type);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Build a hash table of names
+ * @details Entries with duplicated names are not inserted, so the first
+ * one is always found
+ *
+ * @param Hash The hash table (each bucket is the index of the entry plus one)
+ * @param Entries The entries (symbols or types)
+ * @param Names The names of the index
+ *
+ * @return VOID
+ */
+template <typename T>
+VOID
+PdbIndexBuildHash(std::vector<UINT32> & Hash, std::vector<T> & Entries, std::vector<CHAR> & Names)
+{
+    UINT32 Mask;
+    UINT32 Bucket;
+
+    Hash.assign(PdbIndexGetCountOfBuckets((UINT32)Entries.size()), 0);
+
+    Mask = (UINT32)Hash.size() - 1;
+
+    for (UINT32 i = 0; i < Entries.size(); i++)
+    {
+        const char * Name = &Names[Entries[i].NameOffset];
+
+        for (Bucket = PdbIndexHashName(Name) & Mask; Hash[Bucket] != 0; Bucket = (Bucket + 1) & Mask)
+        {
+            if (PdbIndexCompareNames(&Names[Entries[Hash[Bucket] - 1].NameOffset], Name) == 0)
+            {
+                break;
+            }
+        }
+
+        if (Hash[Bucket] == 0)
+        {
+            Hash[Bucket] = i + 1;
+        }
+    }
+}
+
+/**
+ * @brief Append a table to the image of the index
+ *
+ * @param Image The image of the index
+ * @param Table The table to append
+ * @param Size Size of the table
+ *
+ * @return UINT64 Offset of the table
+ */
+UINT64
+PdbIndexAppendTable(std::vector<BYTE> & Image, const VOID * Table, SIZE_T Size)
+{
+    UINT64 Offset;
+
+    //
+    // Tables are 8-byte aligned
+    //
+    Image.resize((Image.size() + 7) & ~(SIZE_T)7);
+
+    Offset = Image.size();
+
+    if (Size != 0)
+    {
+        Image.insert(Image.end(), (const BYTE *)Table, (const BYTE *)Table + Size);
+    }
+
+    return Offset;
+}
+
+/**
+ * @brief Build the image of the symbol index from a PDB file
+ *
+ * @param Msf The opened MSF (PDB) file
+ * @param PdbFileSize Size of the PDB file (to validate the index later)
+ * @param PdbLastWriteTime Last write time of the PDB file (to validate the index later)
+ * @param Image The image of the index
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexBuild(PPDB_MSF_FILE Msf, UINT64 PdbFileSize, UINT64 PdbLastWriteTime, std::vector<BYTE> & Image)
+{
+    std::vector<PDB_INDEX_SYMBOL> Symbols;
+    std::vector<PDB_INDEX_TYPE>   Types;
+    std::vector<PDB_INDEX_FIELD>  Fields;
+    std::vector<CHAR>             Names;
+    std::vector<UINT32>           SymbolHash;
+    std::vector<UINT32>           TypeHash;
+    BOOLEAN                       IsSymbolsCollected;
+    BOOLEAN                       IsTypesCollected;
+    PDB_INDEX_HEADER              Header = {0};
+
+    //
+    // Types might be stripped (public PDBs) and symbols might not be available
+    // (no section headers), the index is useful if at least one of them exists
+    //
+    IsSymbolsCollected = PdbIndexCollectSymbols(Msf, Symbols, Names);
+    IsTypesCollected   = PdbIndexCollectTypes(Msf, Types, Fields, Names);
+
+    if (!IsSymbolsCollected && !IsTypesCollected)
+    {
+        return FALSE;
+    }
+
+    std::stable_sort(Symbols.begin(), Symbols.end(), [](const PDB_INDEX_SYMBOL & A, const PDB_INDEX_SYMBOL & B) {
+        return A.Rva < B.Rva;
+    });
+
+    PdbIndexBuildHash(SymbolHash, Symbols, Names);
+    PdbIndexBuildHash(TypeHash, Types, Names);
+
+    Header.Magic                    = PDB_INDEX_MAGIC;
+    Header.Version                  = PDB_INDEX_VERSION;
+    Header.HeaderSize               = sizeof(PDB_INDEX_HEADER);
+    Header.PdbFileSize              = PdbFileSize;
+    Header.PdbLastWriteTime         = PdbLastWriteTime;
+    Header.CountOfSymbols           = (UINT32)Symbols.size();
+    Header.CountOfSymbolHashBuckets = (UINT32)SymbolHash.size();
+    Header.CountOfTypes             = (UINT32)Types.size();
+    Header.CountOfTypeHashBuckets   = (UINT32)TypeHash.size();
+    Header.CountOfFields            = (UINT32)Fields.size();
+    Header.SizeOfNames              = (UINT32)Names.size();
+
+    Image.clear();
+    Image.resize(sizeof(PDB_INDEX_HEADER));
+
+    Header.SymbolsOffset    = PdbIndexAppendTable(Image, Symbols.data(), Symbols.size() * sizeof(PDB_INDEX_SYMBOL));
+    Header.SymbolHashOffset = PdbIndexAppendTable(Image, SymbolHash.data(), SymbolHash.size() * sizeof(UINT32));
+    Header.TypesOffset      = PdbIndexAppendTable(Image, Types.data(), Types.size() * sizeof(PDB_INDEX_TYPE));
+    Header.TypeHashOffset   = PdbIndexAppendTable(Image, TypeHash.data(), TypeHash.size() * sizeof(UINT32));
+    Header.FieldsOffset     = PdbIndexAppendTable(Image, Fields.data(), Fields.size() * sizeof(PDB_INDEX_FIELD));
+    Header.NamesOffset      = PdbIndexAppendTable(Image, Names.data(), Names.size());
+
+    memcpy(Image.data(), &Header, sizeof(PDB_INDEX_HEADER));
+
+    return TRUE;
+}
+
+/**
+ * @brief Check the names and the hash table of the entries of an index
+ *
+ * @param Entries The entries (symbols or types)
+ * @param CountOfEntries Number of entries
+ * @param Hash The hash table of the entries
+ * @param CountOfBuckets Number of buckets of the hash table
+ * @param SizeOfNames Size of the names of the index
+ *
+ * @return BOOLEAN
+ */
+template <typename T>
+BOOLEAN
+PdbIndexCheckEntries(const T * Entries, UINT32 CountOfEntries, const UINT32 * Hash, UINT32 CountOfBuckets, UINT32 SizeOfNames)
+{
+    BOOLEAN IsEmptyBucketFound = FALSE;
+
+    for (UINT32 i = 0; i < CountOfEntries; i++)
+    {
+        if (Entries[i].NameOffset >= SizeOfNames)
+        {
+            return FALSE;
+        }
+    }
+
+    //
+    // The probing stops at an empty bucket, so at least one of them should exist
+    //
+    for (UINT32 i = 0; i < CountOfBuckets; i++)
+    {
+        if (Hash[i] > CountOfEntries)
+        {
+            return FALSE;
+        }
+
+        IsEmptyBucketFound |= (Hash[i] == 0);
+    }
+
+    return IsEmptyBucketFound;
+}
+
+/**
+ * @brief Set the tables of an index from its image
+ *
+ * @param Index The index
+ * @param Base The image of the index
+ * @param Size Size of the image
+ *
+ * @return BOOLEAN FALSE if the image is not a valid index
+ */
+BOOLEAN
+PdbIndexAttach(PPDB_INDEX Index, const BYTE * Base, UINT64 Size)
+{
+    PPDB_INDEX_HEADER Header = (PPDB_INDEX_HEADER)Base;
+
+    if (Size < sizeof(PDB_INDEX_HEADER) ||
+        Header->Magic != PDB_INDEX_MAGIC ||
+        Header->Version != PDB_INDEX_VERSION ||
+        Header->HeaderSize != sizeof(PDB_INDEX_HEADER))
+    {
+        return FALSE;
+    }
+
+    //
+    // Check the bounds of the tables
+    //
+    if (Header->SymbolsOffset > Size || Header->SymbolHashOffset > Size ||
+        Header->TypesOffset > Size || Header->TypeHashOffset > Size ||
+        Header->FieldsOffset > Size || Header->NamesOffset > Size ||
+        Header->SymbolsOffset + ((UINT64)Header->CountOfSymbols * sizeof(PDB_INDEX_SYMBOL)) > Size ||
+        Header->SymbolHashOffset + ((UINT64)Header->CountOfSymbolHashBuckets * sizeof(UINT32)) > Size ||
+        Header->TypesOffset + ((UINT64)Header->CountOfTypes * sizeof(PDB_INDEX_TYPE)) > Size ||
+        Header->TypeHashOffset + ((UINT64)Header->CountOfTypeHashBuckets * sizeof(UINT32)) > Size ||
+        Header->FieldsOffset + ((UINT64)Header->CountOfFields * sizeof(PDB_INDEX_FIELD)) > Size ||
+        Header->NamesOffset + Header->SizeOfNames > Size ||
+        Header->CountOfSymbolHashBuckets == 0 ||
+        Header->CountOfTypeHashBuckets == 0 ||
+        (Header->CountOfSymbolHashBuckets & (Header->CountOfSymbolHashBuckets - 1)) != 0 ||
+        (Header->CountOfTypeHashBuckets & (Header->CountOfTypeHashBuckets - 1)) != 0 ||
+        Header->SizeOfNames == 0 ||
+        Base[Header->NamesOffset + Header->SizeOfNames - 1] != '\0')
+    {
+        return FALSE;
+    }
+
+    //
+    // Check the entries of the tables (the index file might be corrupted), so
+    // the lookups don't need to check them
+    //
+    if (!PdbIndexCheckEntries((PPDB_INDEX_SYMBOL)(Base + Header->SymbolsOffset),
+                              Header->CountOfSymbols,
+                              (UINT32 *)(Base + Header->SymbolHashOffset),
+                              Header->CountOfSymbolHashBuckets,
+                              Header->SizeOfNames) ||
+        !PdbIndexCheckEntries((PPDB_INDEX_TYPE)(Base + Header->TypesOffset),
+                              Header->CountOfTypes,
+                              (UINT32 *)(Base + Header->TypeHashOffset),
+                              Header->CountOfTypeHashBuckets,
+                              Header->SizeOfNames))
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < Header->CountOfTypes; i++)
+    {
+        PPDB_INDEX_TYPE Type = &((PPDB_INDEX_TYPE)(Base + Header->TypesOffset))[i];
+
+        if ((UINT64)Type->FirstField + Type->CountOfFields > Header->CountOfFields)
+        {
+            return FALSE;
+        }
+    }
+
+    for (UINT32 i = 0; i < Header->CountOfFields; i++)
+    {
+        if (((PPDB_INDEX_FIELD)(Base + Header->FieldsOffset))[i].NameOffset >= Header->SizeOfNames)
+        {
+            return FALSE;
+        }
+    }
+
+    Index->Base       = Base;
+    Index->Size       = Size;
+    Index->Header     = Header;
+    Index->Symbols    = (PPDB_INDEX_SYMBOL)(Base + Header->SymbolsOffset);
+    Index->SymbolHash = (UINT32 *)(Base + Header->SymbolHashOffset);
+    Index->Types      = (PPDB_INDEX_TYPE)(Base + Header->TypesOffset);
+    Index->TypeHash   = (UINT32 *)(Base + Header->TypeHashOffset);
+    Index->Fields     = (PPDB_INDEX_FIELD)(Base + Header->FieldsOffset);
+    Index->Names      = (const CHAR *)(Base + Header->NamesOffset);
+
+    return TRUE;
+}
+
+/**
+ * @brief Find the RVA of a symbol by its name (case-insensitive)
+ *
+ * @param Index The symbol index
+ * @param Name Name of the symbol (without the module name)
+ * @param Rva The RVA of the symbol
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexLookupSymbol(PPDB_INDEX Index, const char * Name, UINT32 * Rva)
+{
+    UINT32 Mask = Index->Header->CountOfSymbolHashBuckets - 1;
+
+    for (UINT32 Bucket = PdbIndexHashName(Name) & Mask; Index->SymbolHash[Bucket] != 0; Bucket = (Bucket + 1) & Mask)
+    {
+        PPDB_INDEX_SYMBOL Symbol = &Index->Symbols[Index->SymbolHash[Bucket] - 1];
+
+        if (PdbIndexCompareNames(Index->Names + Symbol->NameOffset, Name) == 0)
+        {
+            *Rva = Symbol->Rva;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Find the nearest symbol at or before an RVA
+ *
+ * @param Index The symbol index
+ * @param Rva The target RVA
+ * @param Displacement Distance of the RVA from the start of the symbol
+ *
+ * @return const char * Name of the symbol or NULL if not found
+ */
+const char *
+PdbIndexLookupAddress(PPDB_INDEX Index, UINT32 Rva, UINT32 * Displacement)
+{
+    PPDB_INDEX_SYMBOL First = Index->Symbols;
+    PPDB_INDEX_SYMBOL Last  = Index->Symbols + Index->Header->CountOfSymbols;
+    PPDB_INDEX_SYMBOL Found;
+
+    Found = std::upper_bound(First, Last, Rva, [](UINT32 Target, const PDB_INDEX_SYMBOL & Symbol) {
+        return Target < Symbol.Rva;
+    });
+
+    if (Found == First)
+    {
+        return NULL;
+    }
+
+    Found--;
+
+    *Displacement = Rva - Found->Rva;
+
+    return Index->Names + Found->NameOffset;
+}
+
+/**
+ * @brief Find a type by its name (case-insensitive)
+ *
+ * @param Index The symbol index
+ * @param TypeName Name of the type
+ *
+ * @return PPDB_INDEX_TYPE The type or NULL if not found
+ */
+PPDB_INDEX_TYPE
+PdbIndexFindType(PPDB_INDEX Index, const char * TypeName)
+{
+    UINT32 Mask = Index->Header->CountOfTypeHashBuckets - 1;
+
+    for (UINT32 Bucket = PdbIndexHashName(TypeName) & Mask; Index->TypeHash[Bucket] != 0; Bucket = (Bucket + 1) & Mask)
+    {
+        PPDB_INDEX_TYPE Type = &Index->Types[Index->TypeHash[Bucket] - 1];
+
+        if (PdbIndexCompareNames(Index->Names + Type->NameOffset, TypeName) == 0)
+        {
+            return Type;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get the size of a type from the index
+ *
+ * @param Index The symbol index
+ * @param TypeName Name of the type
+ * @param TypeSize Size of the type
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexLookupTypeSize(PPDB_INDEX Index, const char * TypeName, UINT64 * TypeSize)
+{
+    PPDB_INDEX_TYPE Type = PdbIndexFindType(Index, TypeName);
+
+    if (Type == NULL)
+    {
+        return FALSE;
+    }
+
+    *TypeSize = Type->Size;
+
+    return TRUE;
+}
+
+/**
+ * @brief Get the offset of a field of a type from the index
+ * @details Similar to the DbgHelp based implementation, the bit position
+ * is returned for single-bit fields
+ *
+ * @param Index The symbol index
+ * @param TypeName Name of the type
+ * @param FieldName Name of the field
+ * @param FieldOffset Offset of the field
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+PdbIndexLookupFieldOffset(PPDB_INDEX Index, const char * TypeName, const char * FieldName, UINT32 * FieldOffset)
+{
+    PPDB_INDEX_TYPE  Type = PdbIndexFindType(Index, TypeName);
+    PPDB_INDEX_FIELD Field;
+
+    if (Type == NULL || (UINT64)Type->FirstField + Type->CountOfFields > Index->Header->CountOfFields)
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < Type->CountOfFields; i++)
+    {
+        Field = &Index->Fields[Type->FirstField + i];
+
+        if (strcmp(Index->Names + Field->NameOffset, FieldName) == 0)
+        {
+            *FieldOffset = (Field->BitLength == 1) ? Field->BitPosition : Field->Offset;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
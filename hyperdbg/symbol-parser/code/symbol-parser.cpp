@@ -389,6 +389,12 @@ SymInit()
     //
     Options |= SYMOPT_DEBUG;
     Options |= SYMOPT_CASE_INSENSITIVE;
+
+    //
+    // Most of the queries are answered by the native symbol index, so
+    // DbgHelp only parses the PDB file if it's really needed
+    //
+    Options |= SYMOPT_DEFERRED_LOADS;
     SymSetOptions(Options);
 
     //
@@ -633,6 +639,11 @@ SymLoadFileSymbol(UINT64 BaseAddress, const char * PdbFileName, const char * Cus
 
 #endif // !DoNotShowDetailedResult
 
+    //
+    // Open (or build) the native symbol index of the PDB file
+    //
+    ModuleDetails->PdbIndex = PdbIndexOpen(PdbFileName);
+
     //
     // Make the details (to save)
     //
@@ -690,6 +701,7 @@ SymUnloadModuleSymbol(char * ModuleName)
 
             OneModuleFound = TRUE;
 
+            PdbIndexClose(item->PdbIndex);
             free(item);
 
             break;
@@ -754,6 +766,7 @@ SymUnloadAllSymbols()
             //              GetLastError());
         }
 
+        PdbIndexClose(item->PdbIndex);
         free(item);
     }
 
@@ -803,14 +816,16 @@ SymUnloadAllSymbols()
 UINT64
 SymConvertNameToAddress(const char * FunctionOrVariableName, PBOOLEAN WasFound)
 {
-    BOOLEAN      Found   = FALSE;
-    UINT64       Address = NULL;
-    UINT64       Buffer[(sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(CHAR) + sizeof(UINT64) - 1) / sizeof(UINT64)];
-    PSYMBOL_INFO Symbol = (PSYMBOL_INFO)Buffer;
-    string       FinalModuleName;
-    string       TempName(FunctionOrVariableName);
-    string       ExtractedModuleName;
-    string       FunctionName;
+    BOOLEAN                       Found   = FALSE;
+    UINT64                        Address = NULL;
+    UINT32                        Rva     = 0;
+    UINT64                        Buffer[(sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(CHAR) + sizeof(UINT64) - 1) / sizeof(UINT64)];
+    PSYMBOL_INFO                  Symbol       = (PSYMBOL_INFO)Buffer;
+    PSYMBOL_LOADED_MODULE_DETAILS TargetModule = NULL;
+    string                        FinalModuleName;
+    string                        TempName(FunctionOrVariableName);
+    string                        ExtractedModuleName;
+    string                        FunctionName;
 
     //
     // Not found by default
@@ -856,6 +871,7 @@ SymConvertNameToAddress(const char * FunctionOrVariableName, PBOOLEAN WasFound)
             {
                 string ModuleName(item->ModuleName);
                 FinalModuleName = ModuleName + "!" + FunctionName;
+                TargetModule    = item;
                 break;
             }
 
@@ -869,6 +885,7 @@ SymConvertNameToAddress(const char * FunctionOrVariableName, PBOOLEAN WasFound)
                 //
                 string ModuleName(item->ModuleName);
                 FinalModuleName = ModuleName + "!" + FunctionName;
+                TargetModule    = item;
                 break;
             }
         }
@@ -890,6 +907,8 @@ SymConvertNameToAddress(const char * FunctionOrVariableName, PBOOLEAN WasFound)
                 //
                 string ModuleName(item->ModuleName);
                 FinalModuleName = ModuleName + "!" + TempName;
+                FunctionName    = TempName;
+                TargetModule    = item;
                 break;
             }
         }
@@ -904,6 +923,16 @@ SymConvertNameToAddress(const char * FunctionOrVariableName, PBOOLEAN WasFound)
         return NULL;
     }
 
+    //
+    // Check the native symbol index of the module before querying DbgHelp
+    //
+    if (TargetModule->PdbIndex != NULL &&
+        PdbIndexLookupSymbol(TargetModule->PdbIndex, FunctionName.c_str(), &Rva))
+    {
+        *WasFound = TRUE;
+        return TargetModule->BaseAddress + Rva;
+    }
+
     if (SymFromName(GetCurrentProcess(), FinalModuleName.c_str(), Symbol))
     {
         //
@@ -977,6 +1006,15 @@ SymGetFieldOffset(CHAR * TypeName, CHAR * FieldName, UINT32 * FieldOffset)
         Index++;
     }
 
+    //
+    // Check the native symbol index of the module before querying DbgHelp
+    //
+    if (SymbolInfo->PdbIndex != NULL &&
+        PdbIndexLookupFieldOffset(SymbolInfo->PdbIndex, TypeName, FieldName, FieldOffset))
+    {
+        return TRUE;
+    }
+
     //
     // Convert TypeName to wide-char, it's because SymGetTypeInfo supports
     // wide-char
@@ -1066,6 +1104,15 @@ SymGetDataTypeSize(CHAR * TypeName, UINT64 * TypeSize)
         Index++;
     }
 
+    //
+    // Check the native symbol index of the module before querying DbgHelp
+    //
+    if (SymbolInfo->PdbIndex != NULL &&
+        PdbIndexLookupTypeSize(SymbolInfo->PdbIndex, TypeName, TypeSize))
+    {
+        return TRUE;
+    }
+
     //
     // Convert FieldName to wide-char, it's because SymGetTypeInfo supports
     // wide-char
@@ -1188,6 +1235,54 @@ SymCreateSymbolTableForDisassembler(void * CallbackFunction)
     return Result;
 }
 
+/**
+ * @brief Create symbol table for disassembler from the symbols of one module
+ * @details used for updating the disassembler's symbol table when a module
+ * is loaded
+ *
+ * @param CallbackFunction
+ * @param BaseAddress Base address of the module
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+SymCreateSymbolTableForDisassemblerFromModule(void * CallbackFunction, UINT64 BaseAddress)
+{
+    //
+    // Set the callback function to deliver the name of module!ObjectName
+    //
+    g_SymbolMapForDisassembler = (SymbolMapCallback)CallbackFunction;
+
+    for (auto item : g_LoadedModules)
+    {
+        if (item->BaseAddress != BaseAddress)
+        {
+            continue;
+        }
+
+        //
+        // Set module name
+        //
+        g_CurrentModuleName = (char *)item->ModuleName;
+
+        //
+        // Call the callback for the symbols of the module
+        //
+        return SymEnumSymbols(
+                   GetCurrentProcess(),                     // Process handle of the current process
+                   item->BaseAddress,                       // Base address of the module
+                   NULL,                                    // Mask (NULL -> all symbols)
+                   SymDeliverDisassemblerSymbolMapCallback, // The callback function
+                   NULL                                     // A used-defined context can be passed here, if necessary
+                   ) != FALSE;
+    }
+
+    //
+    // Module not found
+    //
+    return FALSE;
+}
+
 /**
  * @brief add ` between 64 bit values and convert them to string
  *
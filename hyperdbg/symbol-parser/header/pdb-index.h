@@ -0,0 +1,319 @@
+/**
+ * @file pdb-index.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief headers of the native PDB (MSF) reader and the symbol index
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//					Constants                   //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Magic of the MSF 7.00 files (PDB files)
+ *
+ */
+#define PDB_MSF_MAGIC "Microsoft C/C++ MSF 7.00\r\n\x1a" \
+                      "DS\0\0\0"
+
+/**
+ * @brief Indexes of the fixed streams of the PDB files
+ *
+ */
+#define PDB_STREAM_INFO 1
+#define PDB_STREAM_TPI  2
+#define PDB_STREAM_DBI  3
+
+/**
+ * @brief Index of the section headers stream in the optional debug
+ * header of the DBI stream
+ *
+ */
+#define PDB_DBI_DEBUG_HEADER_SECTION_HEADERS 5
+
+/**
+ * @brief Symbol record kinds (CodeView)
+ *
+ */
+#define PDB_S_LDATA32   0x110c
+#define PDB_S_GDATA32   0x110d
+#define PDB_S_PUB32     0x110e
+#define PDB_S_LTHREAD32 0x1112
+#define PDB_S_GTHREAD32 0x1113
+
+/**
+ * @brief Type record kinds (CodeView)
+ *
+ */
+#define PDB_LF_FIELDLIST 0x1203
+#define PDB_LF_BITFIELD  0x1205
+#define PDB_LF_BCLASS    0x1400
+#define PDB_LF_VBCLASS   0x1401
+#define PDB_LF_IVBCLASS  0x1402
+#define PDB_LF_INDEX     0x1404
+#define PDB_LF_VFUNCTAB  0x1409
+#define PDB_LF_ENUMERATE 0x1502
+#define PDB_LF_CLASS     0x1504
+#define PDB_LF_STRUCTURE 0x1505
+#define PDB_LF_UNION     0x1506
+#define PDB_LF_MEMBER    0x150d
+#define PDB_LF_STMEMBER  0x150e
+#define PDB_LF_METHOD    0x150f
+#define PDB_LF_NESTTYPE  0x1510
+#define PDB_LF_ONEMETHOD 0x1511
+
+/**
+ * @brief Numeric leaves (CodeView)
+ *
+ */
+#define PDB_LF_NUMERIC   0x8000
+#define PDB_LF_CHAR      0x8000
+#define PDB_LF_SHORT     0x8001
+#define PDB_LF_USHORT    0x8002
+#define PDB_LF_LONG      0x8003
+#define PDB_LF_ULONG     0x8004
+#define PDB_LF_QUADWORD  0x8009
+#define PDB_LF_UQUADWORD 0x800a
+#define PDB_LF_PAD0      0xf0
+
+/**
+ * @brief The forward reference flag of the properties of the structures
+ *
+ */
+#define PDB_TYPE_PROPERTY_FORWARD_REFERENCE 0x80
+
+/**
+ * @brief Magic of the symbol index files ('HDSYMIDX')
+ *
+ */
+#define PDB_INDEX_MAGIC 0x5844494d59534448ull
+
+/**
+ * @brief Version of the symbol index files
+ *
+ */
+#define PDB_INDEX_VERSION 1
+
+/**
+ * @brief Extension of the symbol index files (saved next to the PDB files)
+ *
+ */
+#define PDB_INDEX_FILE_EXTENSION ".hdidx"
+
+//////////////////////////////////////////////////
+//					Structures                  //
+//////////////////////////////////////////////////
+
+/**
+ * @brief The super block of the MSF files
+ *
+ */
+typedef struct _PDB_MSF_SUPER_BLOCK
+{
+    CHAR   FileMagic[32];
+    UINT32 BlockSize;
+    UINT32 FreeBlockMapBlock;
+    UINT32 NumberOfBlocks;
+    UINT32 NumberOfDirectoryBytes;
+    UINT32 Unknown;
+    UINT32 BlockMapAddress;
+
+} PDB_MSF_SUPER_BLOCK, *PPDB_MSF_SUPER_BLOCK;
+
+/**
+ * @brief The header of the DBI stream
+ *
+ */
+typedef struct _PDB_DBI_STREAM_HEADER
+{
+    INT32  VersionSignature;
+    UINT32 VersionHeader;
+    UINT32 Age;
+    UINT16 GlobalStreamIndex;
+    UINT16 BuildNumber;
+    UINT16 PublicStreamIndex;
+    UINT16 PdbDllVersion;
+    UINT16 SymbolRecordStreamIndex;
+    UINT16 PdbDllRebuild;
+    INT32  ModuleInfoSize;
+    INT32  SectionContributionSize;
+    INT32  SectionMapSize;
+    INT32  SourceInfoSize;
+    INT32  TypeServerMapSize;
+    UINT32 MfcTypeServerIndex;
+    INT32  OptionalDebugHeaderSize;
+    INT32  EcSubstreamSize;
+    UINT16 Flags;
+    UINT16 Machine;
+    UINT32 Padding;
+
+} PDB_DBI_STREAM_HEADER, *PPDB_DBI_STREAM_HEADER;
+
+/**
+ * @brief The header of the TPI stream
+ *
+ */
+typedef struct _PDB_TPI_STREAM_HEADER
+{
+    UINT32 Version;
+    UINT32 HeaderSize;
+    UINT32 TypeIndexBegin;
+    UINT32 TypeIndexEnd;
+    UINT32 TypeRecordBytes;
+    UINT16 HashStreamIndex;
+    UINT16 HashAuxStreamIndex;
+    UINT32 HashKeySize;
+    UINT32 NumberOfHashBuckets;
+    INT32  HashValueBufferOffset;
+    UINT32 HashValueBufferLength;
+    INT32  IndexOffsetBufferOffset;
+    UINT32 IndexOffsetBufferLength;
+    INT32  HashAdjBufferOffset;
+    UINT32 HashAdjBufferLength;
+
+} PDB_TPI_STREAM_HEADER, *PPDB_TPI_STREAM_HEADER;
+
+/**
+ * @brief An opened (mapped) MSF file
+ *
+ */
+typedef struct _PDB_MSF_FILE
+{
+    const BYTE *        Base;
+    UINT64              Size;
+    UINT32              BlockSize;
+    UINT32              CountOfBlocks;
+    std::vector<BYTE>   Directory;
+    std::vector<UINT32> StreamSizes;
+    std::vector<UINT32> StreamFirstBlock; // Index of the first block of each stream in the directory
+
+} PDB_MSF_FILE, *PPDB_MSF_FILE;
+
+/**
+ * @brief The header of the symbol index files
+ * @details The index file contains a table of symbols sorted by their RVAs,
+ * hash tables of the names of the symbols and types, the flattened fields
+ * of the types and a blob of the (null-terminated) names. All of the offsets
+ * are from the start of the file, so it's used directly from the mapped view
+ *
+ */
+typedef struct _PDB_INDEX_HEADER
+{
+    UINT64 Magic;
+    UINT32 Version;
+    UINT32 HeaderSize;
+    UINT64 PdbFileSize;
+    UINT64 PdbLastWriteTime;
+    UINT32 CountOfSymbols;
+    UINT32 CountOfSymbolHashBuckets;
+    UINT32 CountOfTypes;
+    UINT32 CountOfTypeHashBuckets;
+    UINT32 CountOfFields;
+    UINT32 SizeOfNames;
+    UINT64 SymbolsOffset;
+    UINT64 SymbolHashOffset;
+    UINT64 TypesOffset;
+    UINT64 TypeHashOffset;
+    UINT64 FieldsOffset;
+    UINT64 NamesOffset;
+
+} PDB_INDEX_HEADER, *PPDB_INDEX_HEADER;
+
+/**
+ * @brief A symbol in the index (sorted by RVA)
+ *
+ */
+typedef struct _PDB_INDEX_SYMBOL
+{
+    UINT32 Rva;
+    UINT32 NameOffset;
+
+} PDB_INDEX_SYMBOL, *PPDB_INDEX_SYMBOL;
+
+/**
+ * @brief A type (structure, class, or union) in the index
+ *
+ */
+typedef struct _PDB_INDEX_TYPE
+{
+    UINT32 NameOffset;
+    UINT32 FirstField;
+    UINT32 CountOfFields;
+    UINT32 Reserved;
+    UINT64 Size;
+
+} PDB_INDEX_TYPE, *PPDB_INDEX_TYPE;
+
+/**
+ * @brief A field of a type in the index
+ *
+ */
+typedef struct _PDB_INDEX_FIELD
+{
+    UINT32 NameOffset;
+    UINT32 Offset;
+    UINT32 BitPosition;
+    UINT32 BitLength; // Zero if the field is not a bit-field
+
+} PDB_INDEX_FIELD, *PPDB_INDEX_FIELD;
+
+/**
+ * @brief A loaded symbol index
+ *
+ */
+typedef struct _PDB_INDEX
+{
+    HANDLE            FileHandle;
+    HANDLE            MappingHandle;
+    const BYTE *      Base;
+    UINT64            Size;
+    std::vector<BYTE> Buffer; // Used if the index couldn't be saved into a file
+    PPDB_INDEX_HEADER Header;
+    PPDB_INDEX_SYMBOL Symbols;
+    UINT32 *          SymbolHash;
+    PPDB_INDEX_TYPE   Types;
+    UINT32 *          TypeHash;
+    PPDB_INDEX_FIELD  Fields;
+    const CHAR *      Names;
+
+} PDB_INDEX, *PPDB_INDEX;
+
+//////////////////////////////////////////////////
+//					Functions                   //
+//////////////////////////////////////////////////
+
+BOOLEAN
+PdbMsfOpen(const BYTE * Base, UINT64 Size, PPDB_MSF_FILE Msf);
+
+BOOLEAN
+PdbMsfReadStream(PPDB_MSF_FILE Msf, UINT32 StreamIndex, std::vector<BYTE> & Stream);
+
+BOOLEAN
+PdbIndexBuild(PPDB_MSF_FILE Msf, UINT64 PdbFileSize, UINT64 PdbLastWriteTime, std::vector<BYTE> & Image);
+
+BOOLEAN
+PdbIndexAttach(PPDB_INDEX Index, const BYTE * Base, UINT64 Size);
+
+PPDB_INDEX
+PdbIndexOpen(const char * PdbFilePath);
+
+VOID
+PdbIndexClose(PPDB_INDEX Index);
+
+BOOLEAN
+PdbIndexLookupSymbol(PPDB_INDEX Index, const char * Name, UINT32 * Rva);
+
+const char *
+PdbIndexLookupAddress(PPDB_INDEX Index, UINT32 Rva, UINT32 * Displacement);
+
+BOOLEAN
+PdbIndexLookupTypeSize(PPDB_INDEX Index, const char * TypeName, UINT64 * TypeSize);
+
+BOOLEAN
+PdbIndexLookupFieldOffset(PPDB_INDEX Index, const char * TypeName, const char * FieldName, UINT32 * FieldOffset);
@@ -27,11 +27,12 @@
  */
 typedef struct _SYMBOL_LOADED_MODULE_DETAILS
 {
-    UINT64 BaseAddress;
-    UINT64 ModuleBase;
-    char   ModuleName[_MAX_FNAME];
-    char   ModuleAlternativeName[_MAX_FNAME];
-    char   PdbFilePath[MAX_PATH];
+    UINT64     BaseAddress;
+    UINT64     ModuleBase;
+    char       ModuleName[_MAX_FNAME];
+    char       ModuleAlternativeName[_MAX_FNAME];
+    char       PdbFilePath[MAX_PATH];
+    PPDB_INDEX PdbIndex; // NULL if the native index is not available
 
 } SYMBOL_LOADED_MODULE_DETAILS, *PSYMBOL_LOADED_MODULE_DETAILS;
 
@@ -50,6 +50,7 @@ typedef RFLAGS * PRFLAGS;
 #include "Definition.h"
 #include "SDK/imports/user/HyperDbgLibImports.h"
 #include "../symbol-parser/header/common-utils.h"
+#include "../symbol-parser/header/pdb-index.h"
 #include "../symbol-parser/header/symbol-parser.h"
 
 //
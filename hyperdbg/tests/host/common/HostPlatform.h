@@ -0,0 +1,264 @@
+/**
+ * @file HostPlatform.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Definitions for building the portable parts of HyperDbg on a host (Linux/GCC)
+ * @details The tests in this directory compile the portable source files of
+ * HyperDbg with a local 'pch.h' that includes this file instead of the WDK/SDK
+ * headers
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <immintrin.h>
+
+//////////////////////////////////////////////////
+//               Basic Datatypes                //
+//////////////////////////////////////////////////
+
+#define __int64 long long
+
+#include "../../../include/SDK/headers/BasicTypes.h"
+
+typedef void *    PVOID;
+typedef void *    HANDLE;
+typedef int32_t   LONG;
+typedef int64_t   LONG64;
+typedef uint64_t  SIZE_T;
+typedef SIZE_T *  PSIZE_T;
+typedef uint64_t  ULONG_PTR;
+typedef CHAR *    PCHAR;
+typedef UCHAR *   PUCHAR;
+
+#ifndef NULL
+#    define NULL ((void *)0)
+#endif
+
+#define PAGE_SIZE  0x1000
+#define PAGE_SHIFT 12
+
+#define RTL_NUMBER_OF(A) (sizeof(A) / sizeof((A)[0]))
+
+#define RtlZeroMemory(Destination, Length)         memset((Destination), 0, (Length))
+#define RtlCopyMemory(Destination, Source, Length) memcpy((Destination), (Source), (Length))
+
+#define CONTAINING_RECORD(Address, Type, Field) ((Type *)((char *)(Address) - offsetof(Type, Field)))
+
+#define DECLSPEC_ALIGN(Alignment) __attribute__((aligned(Alignment)))
+
+#define PAGED_CODE()
+
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+
+#define ROUND_TO_PAGES(Size)  (((SIZE_T)(Size) + PAGE_SIZE - 1) & ~(SIZE_T)(PAGE_SIZE - 1))
+#define BYTES_TO_PAGES(Size)  (((SIZE_T)(Size) >> PAGE_SHIFT) + (((SIZE_T)(Size) & (PAGE_SIZE - 1)) != 0))
+
+//////////////////////////////////////////////////
+//               SAL Annotations                //
+//////////////////////////////////////////////////
+
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _Inout_opt_
+#define _Use_decl_annotations_
+
+//////////////////////////////////////////////////
+//               Doubly Linked Lists            //
+//////////////////////////////////////////////////
+
+typedef struct _LIST_ENTRY
+{
+    struct _LIST_ENTRY * Flink;
+    struct _LIST_ENTRY * Blink;
+
+} LIST_ENTRY, *PLIST_ENTRY;
+
+static inline VOID
+InitializeListHead(PLIST_ENTRY ListHead)
+{
+    ListHead->Flink = ListHead->Blink = ListHead;
+}
+
+static inline BOOLEAN
+IsListEmpty(PLIST_ENTRY ListHead)
+{
+    return ListHead->Flink == ListHead;
+}
+
+static inline VOID
+InsertHeadList(PLIST_ENTRY ListHead, PLIST_ENTRY Entry)
+{
+    Entry->Flink           = ListHead->Flink;
+    Entry->Blink           = ListHead;
+    ListHead->Flink->Blink = Entry;
+    ListHead->Flink        = Entry;
+}
+
+static inline VOID
+InsertTailList(PLIST_ENTRY ListHead, PLIST_ENTRY Entry)
+{
+    Entry->Flink           = ListHead;
+    Entry->Blink           = ListHead->Blink;
+    ListHead->Blink->Flink = Entry;
+    ListHead->Blink        = Entry;
+}
+
+static inline BOOLEAN
+RemoveEntryList(PLIST_ENTRY Entry)
+{
+    Entry->Blink->Flink = Entry->Flink;
+    Entry->Flink->Blink = Entry->Blink;
+
+    return Entry->Flink == Entry->Blink;
+}
+
+//////////////////////////////////////////////////
+//               Interlocked Routines           //
+//////////////////////////////////////////////////
+
+static inline LONG
+InterlockedIncrement(volatile LONG * Target)
+{
+    return __atomic_add_fetch(Target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG
+InterlockedDecrement(volatile LONG * Target)
+{
+    return __atomic_sub_fetch(Target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG
+InterlockedExchange(volatile LONG * Target, LONG Value)
+{
+    return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG
+InterlockedExchangeAdd(volatile LONG * Target, LONG Value)
+{
+    return __atomic_fetch_add(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG
+InterlockedCompareExchange(volatile LONG * Target, LONG Exchange, LONG Comparand)
+{
+    return __sync_val_compare_and_swap(Target, Comparand, Exchange);
+}
+
+static inline PVOID
+InterlockedExchangePointer(PVOID volatile * Target, PVOID Value)
+{
+    return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline PVOID
+InterlockedCompareExchangePointer(PVOID volatile * Target, PVOID Exchange, PVOID Comparand)
+{
+    return __sync_val_compare_and_swap(Target, Comparand, Exchange);
+}
+
+static inline LONG
+InterlockedAdd(volatile LONG * Target, LONG Value)
+{
+    return __atomic_add_fetch(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64
+InterlockedIncrement64(volatile LONG64 * Target)
+{
+    return __atomic_add_fetch(Target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64
+InterlockedAdd64(volatile LONG64 * Target, LONG64 Value)
+{
+    return __atomic_add_fetch(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline BOOLEAN
+InterlockedCompareExchange128(volatile LONG64 * Destination, LONG64 ExchangeHigh, LONG64 ExchangeLow, LONG64 * ComparandResult)
+{
+    unsigned __int128 Comparand = ((unsigned __int128)(UINT64)ComparandResult[1] << 64) | (UINT64)ComparandResult[0];
+    unsigned __int128 Exchange  = ((unsigned __int128)(UINT64)ExchangeHigh << 64) | (UINT64)ExchangeLow;
+    unsigned __int128 Original  = __sync_val_compare_and_swap((volatile unsigned __int128 *)Destination, Comparand, Exchange);
+
+    ComparandResult[0] = (LONG64)(UINT64)Original;
+    ComparandResult[1] = (LONG64)(UINT64)(Original >> 64);
+
+    return Original == Comparand;
+}
+
+static inline UCHAR
+_interlockedbittestandset(volatile LONG * Base, LONG Offset)
+{
+    return (__atomic_fetch_or(Base, (LONG)1 << Offset, __ATOMIC_SEQ_CST) >> Offset) & 1;
+}
+
+#define YieldProcessor() _mm_pause()
+
+//////////////////////////////////////////////////
+//               Test Helpers                   //
+//////////////////////////////////////////////////
+
+/**
+ * @brief Current time in nanoseconds
+ *
+ */
+static inline UINT64
+HostTimeNs()
+{
+    struct timespec Time;
+
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+
+    return (UINT64)Time.tv_sec * 1000000000ull + (UINT64)Time.tv_nsec;
+}
+
+/**
+ * @brief A small deterministic pseudo-random generator (xorshift64)
+ *
+ */
+static inline UINT64
+HostRandom(UINT64 * State)
+{
+    UINT64 X = *State;
+
+    X ^= X << 13;
+    X ^= X >> 7;
+    X ^= X << 17;
+
+    return *State = X;
+}
+
+/**
+ * @brief Check a condition and stop the test if it's not satisfied
+ *
+ */
+#define HOST_CHECK(Condition)                                                     \
+    do                                                                            \
+    {                                                                             \
+        if (!(Condition))                                                         \
+        {                                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); \
+            exit(1);                                                              \
+        }                                                                         \
+    } while (0)
@@ -0,0 +1,62 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the bitmap of the dirty physical pages on the host
+ * @details The PML buffers are not simulated, each thread is a core that
+ * marks pages (the same as draining its PML buffer in vmx-root) while the
+ * debugger collects them
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <pthread.h>
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define MAXUINT64 ((UINT64) ~((UINT64)0))
+
+static inline LONG64
+InterlockedOr64(volatile LONG64 * Target, LONG64 Value)
+{
+    return __atomic_fetch_or(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64
+InterlockedAnd64(volatile LONG64 * Target, LONG64 Value)
+{
+    return __atomic_fetch_and(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64
+InterlockedExchange64(volatile LONG64 * Target, LONG64 Value)
+{
+    return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST);
+}
+
+static inline UCHAR
+_BitScanForward64(ULONG * Index, UINT64 Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+
+    *Index = (ULONG)__builtin_ctzll(Mask);
+
+    return 1;
+}
+
+#include "../../../hyperhv/header/features/DirtyBitmap.h"
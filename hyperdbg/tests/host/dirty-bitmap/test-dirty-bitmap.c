@@ -0,0 +1,677 @@
+/**
+ * @file test-dirty-bitmap.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the bitmap of the dirty physical pages
+ * @details Pages and ranges (with partial words) are marked and collected
+ * and compared with a reference (a byte per page), the collections are
+ * resumed with small arrays of entries, cores mark pages concurrently while
+ * the debugger collects them, and collecting the dirty pages of a large
+ * physical memory (64 GB by default) is measured
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of pages of the tests (three summary words and a partial word)
+ *
+ */
+#define TEST_COUNT_OF_PAGES (DIRTY_BITMAP_PAGES_PER_WORD * DIRTY_BITMAP_PAGES_PER_WORD * 3 + 37)
+
+/**
+ * @brief Number of rounds of the random tests
+ *
+ */
+#define TEST_COUNT_OF_ROUNDS 20000
+
+/**
+ * @brief Number of simulated cores that mark the pages concurrently
+ *
+ */
+#define TEST_NUMBER_OF_CORES 4
+
+/**
+ * @brief Number of pages of the concurrent test (more than a summary word)
+ *
+ */
+#define TEST_CONCURRENT_COUNT_OF_PAGES (DIRTY_BITMAP_PAGES_PER_WORD * DIRTY_BITMAP_PAGES_PER_WORD * 64)
+
+/**
+ * @brief Number of pages (or ranges) that are marked by each core
+ *
+ */
+#define TEST_PAGES_PER_CORE 1000000
+
+/**
+ * @brief Number of dirty pages of the sparse benchmark
+ *
+ */
+#define TEST_BENCHMARK_SPARSE_PAGES 1000
+
+//////////////////////////////////////////////////
+//				       Globals     				//
+//////////////////////////////////////////////////
+
+static DIRTY_BITMAP      g_TestBitmap;
+static volatile UINT64 * g_TestMarked;    // Time of the last mark of each page
+static UINT64 *          g_TestCollected; // Time of the last collection of each page
+static volatile UINT64   g_TestClock;
+static volatile LONG     g_TestRunningCores;
+
+//////////////////////////////////////////////////
+//				       Helpers     				//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Create a bitmap
+ *
+ * @param Bitmap
+ * @param CountOfPages
+ *
+ * @return VOID
+ */
+static VOID
+TestCreateBitmap(DIRTY_BITMAP * Bitmap, UINT64 CountOfPages)
+{
+    PVOID Buffer = malloc(DirtyBitmapGetBufferSize(CountOfPages));
+
+    HOST_CHECK(Buffer != NULL);
+
+    //
+    // The buffer is not zeroed by the allocator
+    //
+    memset(Buffer, 0xa5, DirtyBitmapGetBufferSize(CountOfPages));
+
+    DirtyBitmapInitialize(Bitmap, Buffer, CountOfPages);
+}
+
+/**
+ * @brief Collect all of the dirty pages of a range (the collection is resumed
+ * until the end of the range)
+ *
+ * @param Bitmap
+ * @param FirstPageFrameNumber
+ * @param EndPageFrameNumber
+ * @param MaximumEntries
+ * @param Collected receives a byte for each collected page (or NULL)
+ * @param NumberOfCalls receives the number of calls (or NULL)
+ *
+ * @return UINT64 number of collected pages
+ */
+static UINT64
+TestCollect(DIRTY_BITMAP * Bitmap,
+            UINT64         FirstPageFrameNumber,
+            UINT64         EndPageFrameNumber,
+            UINT32         MaximumEntries,
+            UINT8 *        Collected,
+            UINT64 *       NumberOfCalls)
+{
+    DEBUGGER_DIRTY_PAGES_ENTRY * Entries = malloc(sizeof(DEBUGGER_DIRTY_PAGES_ENTRY) * MaximumEntries);
+    UINT64                       Next    = FirstPageFrameNumber;
+    UINT64                       Pages   = 0;
+    UINT64                       Calls   = 0;
+    UINT64                       Previous;
+    UINT32                       Count;
+
+    HOST_CHECK(Entries != NULL);
+
+    do
+    {
+        Previous = Next;
+        Count    = DirtyBitmapCollect(Bitmap, Previous, EndPageFrameNumber, Entries, MaximumEntries, &Next);
+
+        Calls++;
+
+        HOST_CHECK(Count <= MaximumEntries);
+        HOST_CHECK(Next >= Previous && Next <= EndPageFrameNumber);
+        HOST_CHECK(Count == MaximumEntries || Next == EndPageFrameNumber);
+
+        for (UINT32 i = 0; i < Count; i++)
+        {
+            HOST_CHECK(Entries[i].FirstPageFrameNumber % DIRTY_BITMAP_PAGES_PER_WORD == 0);
+            HOST_CHECK(Entries[i].Bitmap != 0);
+            HOST_CHECK(i == 0 || Entries[i].FirstPageFrameNumber > Entries[i - 1].FirstPageFrameNumber);
+
+            for (UINT32 Bit = 0; Bit < DIRTY_BITMAP_PAGES_PER_WORD; Bit++)
+            {
+                UINT64 Page = Entries[i].FirstPageFrameNumber + Bit;
+
+                if ((Entries[i].Bitmap & (1ull << Bit)) == 0)
+                {
+                    continue;
+                }
+
+                //
+                // Only the pages of the range are collected
+                //
+                HOST_CHECK(Page >= Previous && Page < EndPageFrameNumber);
+
+                if (Collected != NULL && Collected[Page] != 0xff)
+                {
+                    Collected[Page]++;
+                }
+
+                Pages++;
+            }
+        }
+
+    } while (Next != EndPageFrameNumber);
+
+    free(Entries);
+
+    if (NumberOfCalls != NULL)
+    {
+        *NumberOfCalls = Calls;
+    }
+
+    return Pages;
+}
+
+//////////////////////////////////////////////////
+//				        Tests     				//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Mark pages and ranges with partial words and collect random ranges
+ *
+ * @return VOID
+ */
+static VOID
+TestPartialWords()
+{
+    DIRTY_BITMAP Bitmap;
+    UINT8 *      Reference   = calloc(TEST_COUNT_OF_PAGES, 1);
+    UINT8 *      Collected   = calloc(TEST_COUNT_OF_PAGES, 1);
+    UINT64       RandomState = 0x5eed;
+    UINT64       Pages       = 0;
+
+    HOST_CHECK(Reference != NULL && Collected != NULL);
+
+    TestCreateBitmap(&Bitmap, TEST_COUNT_OF_PAGES);
+
+    //
+    // A new bitmap is clean, and the pages out of the range are ignored
+    //
+    HOST_CHECK(TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, 1, NULL, NULL) == 0);
+
+    DirtyBitmapSetPage(&Bitmap, TEST_COUNT_OF_PAGES);
+    DirtyBitmapSetPage(&Bitmap, MAXUINT64);
+    DirtyBitmapSetRange(&Bitmap, TEST_COUNT_OF_PAGES, 100);
+    HOST_CHECK(TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES + 1000, 1, NULL, NULL) == 0);
+
+    for (UINT32 Round = 0; Round < TEST_COUNT_OF_ROUNDS; Round++)
+    {
+        UINT64 First = HostRandom(&RandomState) % (TEST_COUNT_OF_PAGES + 64);
+        UINT64 Count;
+        UINT64 End;
+
+        //
+        // Mark a page or a range, the ranges cross the words, the summary
+        // words, and the end of the bitmap
+        //
+        switch (HostRandom(&RandomState) % 4)
+        {
+        case 0:
+            DirtyBitmapSetPage(&Bitmap, First);
+            Count = 1;
+            break;
+
+        case 1:
+            Count = HostRandom(&RandomState) % DIRTY_BITMAP_PAGES_PER_WORD;
+            DirtyBitmapSetRange(&Bitmap, First, Count);
+            break;
+
+        case 2:
+            Count = HostRandom(&RandomState) % (DIRTY_BITMAP_PAGES_PER_WORD * 4);
+            DirtyBitmapSetRange(&Bitmap, First, Count);
+            break;
+
+        default:
+            Count = HostRandom(&RandomState) % (DIRTY_BITMAP_PAGES_PER_WORD * DIRTY_BITMAP_PAGES_PER_WORD * 2);
+            DirtyBitmapSetRange(&Bitmap, First, Count);
+            break;
+        }
+
+        for (UINT64 Page = First; Page < First + Count && Page < TEST_COUNT_OF_PAGES; Page++)
+        {
+            Reference[Page] = 1;
+        }
+
+        if (HostRandom(&RandomState) % 4 != 0)
+        {
+            continue;
+        }
+
+        //
+        // Collect a random range (the pages out of the range are kept)
+        //
+        First = HostRandom(&RandomState) % TEST_COUNT_OF_PAGES;
+        End   = First + HostRandom(&RandomState) % (TEST_COUNT_OF_PAGES - First + 64);
+
+        memset(Collected, 0, TEST_COUNT_OF_PAGES);
+        Pages += TestCollect(&Bitmap, First, End, 1 + (UINT32)(HostRandom(&RandomState) % 8), Collected, NULL);
+
+        for (UINT64 Page = 0; Page < TEST_COUNT_OF_PAGES; Page++)
+        {
+            if (Page >= First && Page < End)
+            {
+                HOST_CHECK(Collected[Page] == Reference[Page]);
+                Reference[Page] = 0;
+            }
+            else
+            {
+                HOST_CHECK(Collected[Page] == 0);
+            }
+        }
+    }
+
+    //
+    // The remaining pages are collected at once
+    //
+    memset(Collected, 0, TEST_COUNT_OF_PAGES);
+    TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES, Collected, NULL);
+    HOST_CHECK(memcmp(Collected, Reference, TEST_COUNT_OF_PAGES) == 0);
+    HOST_CHECK(TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, 1, NULL, NULL) == 0);
+
+    //
+    // Resetting clears everything
+    //
+    DirtyBitmapSetRange(&Bitmap, 0, TEST_COUNT_OF_PAGES);
+    DirtyBitmapReset(&Bitmap);
+    HOST_CHECK(TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, 1, NULL, NULL) == 0);
+
+    free((PVOID)Bitmap.Words);
+    free(Reference);
+    free(Collected);
+
+    printf("partial words: %u random pages and ranges, %llu pages collected from random ranges\n",
+           TEST_COUNT_OF_ROUNDS,
+           (unsigned long long)Pages);
+}
+
+/**
+ * @brief Resume the collections with small arrays of entries
+ *
+ * @return VOID
+ */
+static VOID
+TestResume()
+{
+    DIRTY_BITMAP               Bitmap;
+    DEBUGGER_DIRTY_PAGES_ENTRY Entries[2];
+    UINT8 *                    Collected = calloc(TEST_COUNT_OF_PAGES, 1);
+    UINT64                     Calls;
+    UINT64                     Next;
+    UINT64                     DirtyWords = 0;
+    UINT32                     Count;
+
+    HOST_CHECK(Collected != NULL);
+
+    TestCreateBitmap(&Bitmap, TEST_COUNT_OF_PAGES);
+
+    //
+    // A page in every 5th word, each call returns a single word
+    //
+    for (UINT64 Word = 0; Word * DIRTY_BITMAP_PAGES_PER_WORD < TEST_COUNT_OF_PAGES; Word += 5)
+    {
+        DirtyBitmapSetPage(&Bitmap, Word * DIRTY_BITMAP_PAGES_PER_WORD + (Word % DIRTY_BITMAP_PAGES_PER_WORD));
+        DirtyWords++;
+    }
+
+    HOST_CHECK(TestCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, 1, Collected, &Calls) == DirtyWords);
+    HOST_CHECK(Calls == DirtyWords);
+
+    //
+    // The collection continues from the word that didn't fit
+    //
+    DirtyBitmapSetPage(&Bitmap, 10);
+    DirtyBitmapSetPage(&Bitmap, 64 * 70 + 3);
+    DirtyBitmapSetPage(&Bitmap, 64 * 150 + 63);
+
+    Count = DirtyBitmapCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, Entries, 2, &Next);
+    HOST_CHECK(Count == 2 && Next == 64 * 150);
+    HOST_CHECK(Entries[0].FirstPageFrameNumber == 0 && Entries[0].Bitmap == 1ull << 10);
+    HOST_CHECK(Entries[1].FirstPageFrameNumber == 64 * 70 && Entries[1].Bitmap == 1ull << 3);
+
+    //
+    // Pages that are marked behind the resumed position are kept for the next
+    // collection, the pages after it are returned
+    //
+    DirtyBitmapSetPage(&Bitmap, 11);
+    DirtyBitmapSetPage(&Bitmap, 64 * 150 + 1);
+
+    Count = DirtyBitmapCollect(&Bitmap, Next, TEST_COUNT_OF_PAGES, Entries, 2, &Next);
+    HOST_CHECK(Count == 1 && Next == TEST_COUNT_OF_PAGES);
+    HOST_CHECK(Entries[0].FirstPageFrameNumber == 64 * 150 && Entries[0].Bitmap == ((1ull << 63) | 2));
+
+    Count = DirtyBitmapCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, Entries, 2, &Next);
+    HOST_CHECK(Count == 1 && Entries[0].Bitmap == 1ull << 11 && Next == TEST_COUNT_OF_PAGES);
+
+    //
+    // A resumed position in the middle of a word only collects the pages
+    // after it, and the pages before it are kept
+    //
+    DirtyBitmapSetRange(&Bitmap, 64 * 9, 64);
+
+    Count = DirtyBitmapCollect(&Bitmap, 64 * 9 + 40, 64 * 9 + 50, Entries, 2, &Next);
+    HOST_CHECK(Count == 1 && Entries[0].Bitmap == ((1ull << 50) - 1) - ((1ull << 40) - 1) && Next == 64 * 9 + 50);
+
+    Count = DirtyBitmapCollect(&Bitmap, 0, TEST_COUNT_OF_PAGES, Entries, 2, &Next);
+    HOST_CHECK(Count == 1 && Entries[0].Bitmap == ~(((1ull << 50) - 1) - ((1ull << 40) - 1)));
+
+    //
+    // Empty ranges and ranges after the end of the bitmap
+    //
+    HOST_CHECK(DirtyBitmapCollect(&Bitmap, 100, 100, Entries, 2, &Next) == 0 && Next == 100);
+    HOST_CHECK(DirtyBitmapCollect(&Bitmap, TEST_COUNT_OF_PAGES + 1, MAXUINT64, Entries, 2, &Next) == 0 && Next == MAXUINT64);
+
+    free((PVOID)Bitmap.Words);
+    free(Collected);
+
+    printf("resume: %llu words are collected one per call, and pages marked behind the position are kept\n",
+           (unsigned long long)DirtyWords);
+}
+
+/**
+ * @brief A simulated core that marks random pages and ranges
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestCoreThread(void * Parameter)
+{
+    UINT64 RandomState = (UINT64)(ULONG_PTR)Parameter * 0x9E3779B97F4A7C15ull + 7;
+
+    for (UINT32 i = 0; i < TEST_PAGES_PER_CORE; i++)
+    {
+        UINT64 Page  = HostRandom(&RandomState) % TEST_CONCURRENT_COUNT_OF_PAGES;
+        UINT64 Count = ((i & 0xff) == 0) ? 1 + HostRandom(&RandomState) % 100 : 1;
+
+        //
+        // The time of marking is saved before the page is marked, so if the
+        // mark is lost, the last collection of the page is before it
+        //
+        for (UINT64 j = Page; j < Page + Count && j < TEST_CONCURRENT_COUNT_OF_PAGES; j++)
+        {
+            __atomic_store_n(&g_TestMarked[j], __atomic_add_fetch(&g_TestClock, 1, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+        }
+
+        if (Count == 1)
+        {
+            DirtyBitmapSetPage(&g_TestBitmap, Page);
+        }
+        else
+        {
+            DirtyBitmapSetRange(&g_TestBitmap, Page, Count);
+        }
+
+        if ((i & 0xffff) == 0)
+        {
+            //
+            // Let the other cores (and the debugger) run on small hosts
+            //
+            sched_yield();
+        }
+    }
+
+    InterlockedDecrement(&g_TestRunningCores);
+
+    return NULL;
+}
+
+/**
+ * @brief Collect all of the dirty pages and save the time of the collection
+ *
+ * @param MaximumEntries
+ *
+ * @return UINT64 number of collected pages
+ */
+static UINT64
+TestCollectConcurrently(UINT32 MaximumEntries)
+{
+    DEBUGGER_DIRTY_PAGES_ENTRY Entries[16];
+    UINT64                     Next  = 0;
+    UINT64                     Pages = 0;
+    UINT64                     Time;
+    UINT32                     Count;
+
+    do
+    {
+        Count = DirtyBitmapCollect(&g_TestBitmap, Next, TEST_CONCURRENT_COUNT_OF_PAGES, Entries, MaximumEntries, &Next);
+        Time  = __atomic_load_n(&g_TestClock, __ATOMIC_SEQ_CST);
+
+        for (UINT32 i = 0; i < Count; i++)
+        {
+            for (UINT64 Bits = Entries[i].Bitmap; Bits != 0; Bits &= Bits - 1)
+            {
+                g_TestCollected[Entries[i].FirstPageFrameNumber + __builtin_ctzll(Bits)] = Time;
+                Pages++;
+            }
+        }
+
+    } while (Next != TEST_CONCURRENT_COUNT_OF_PAGES);
+
+    return Pages;
+}
+
+/**
+ * @brief Cores mark pages while the debugger collects them, none of the marks
+ * should be lost
+ * @details Each mark should be followed by a collection of the page, and
+ * after the cores are finished and the pages are collected, none of the
+ * words of the bitmap should be left dirty
+ *
+ * @return VOID
+ */
+static VOID
+TestConcurrentWriters()
+{
+    pthread_t Cores[TEST_NUMBER_OF_CORES];
+    UINT64    Collections = 0;
+    UINT64    Pages       = 0;
+    UINT64    Marked      = 0;
+    UINT64    Start;
+
+    g_TestMarked       = calloc(TEST_CONCURRENT_COUNT_OF_PAGES, sizeof(UINT64));
+    g_TestCollected    = calloc(TEST_CONCURRENT_COUNT_OF_PAGES, sizeof(UINT64));
+    g_TestRunningCores = TEST_NUMBER_OF_CORES;
+
+    HOST_CHECK(g_TestMarked != NULL && g_TestCollected != NULL);
+
+    TestCreateBitmap(&g_TestBitmap, TEST_CONCURRENT_COUNT_OF_PAGES);
+
+    Start = HostTimeNs();
+
+    for (ULONG_PTR i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        HOST_CHECK(pthread_create(&Cores[i], NULL, TestCoreThread, (void *)i) == 0);
+    }
+
+    //
+    // The debugger collects and resumes with small arrays
+    //
+    while (g_TestRunningCores != 0)
+    {
+        Pages += TestCollectConcurrently(1 + (UINT32)(Collections % 16));
+        Collections++;
+
+        sched_yield();
+    }
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        pthread_join(Cores[i], NULL);
+    }
+
+    Pages += TestCollectConcurrently(16);
+
+    for (UINT64 Page = 0; Page < TEST_CONCURRENT_COUNT_OF_PAGES; Page++)
+    {
+        //
+        // The page is collected after its last mark, and only the marked
+        // pages are collected
+        //
+        HOST_CHECK(g_TestCollected[Page] >= g_TestMarked[Page]);
+        HOST_CHECK((g_TestMarked[Page] != 0) == (g_TestCollected[Page] != 0));
+
+        Marked += g_TestMarked[Page] != 0;
+    }
+
+    //
+    // Nothing is left in the words (not even without a summary bit)
+    //
+    for (UINT64 i = 0; i < g_TestBitmap.CountOfWords + g_TestBitmap.CountOfSummaryWords; i++)
+    {
+        HOST_CHECK(g_TestBitmap.Words[i] == 0);
+    }
+
+    printf("concurrent writers: %u cores x %u marks in %.1f ms, %llu collections, %llu of %llu pages marked, %llu pages collected\n",
+           TEST_NUMBER_OF_CORES,
+           TEST_PAGES_PER_CORE,
+           (double)(HostTimeNs() - Start) / 1000000,
+           (unsigned long long)Collections,
+           (unsigned long long)Marked,
+           (unsigned long long)TEST_CONCURRENT_COUNT_OF_PAGES,
+           (unsigned long long)Pages);
+
+    free((PVOID)g_TestBitmap.Words);
+    free((PVOID)g_TestMarked);
+    free(g_TestCollected);
+}
+
+/**
+ * @brief Measure collecting the dirty pages of a large physical memory
+ *
+ * @param SizeOfMemoryGb
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark(UINT64 SizeOfMemoryGb)
+{
+    DIRTY_BITMAP Bitmap;
+    UINT64       CountOfPages = (SizeOfMemoryGb << 30) / PAGE_SIZE;
+    UINT64       RandomState  = 0x5eed;
+    UINT64       Pages;
+    UINT64       Calls;
+    UINT64       Start;
+    UINT64       Elapsed;
+    UINT64       Sum = 0;
+
+    TestCreateBitmap(&Bitmap, CountOfPages);
+
+    printf("benchmark (%llu GB, %llu pages, bitmap of %llu KB, %u entries per call):\n",
+           (unsigned long long)SizeOfMemoryGb,
+           (unsigned long long)CountOfPages,
+           (unsigned long long)(DirtyBitmapGetBufferSize(CountOfPages) / 1024),
+           DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES);
+
+    //
+    // A clean bitmap (only the summary is scanned)
+    //
+    Start   = HostTimeNs();
+    Pages   = TestCollect(&Bitmap, 0, CountOfPages, DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES, NULL, &Calls);
+    Elapsed = HostTimeNs() - Start;
+
+    HOST_CHECK(Pages == 0);
+    printf("\tclean                : %10.3f ms\n", (double)Elapsed / 1000000);
+
+    //
+    // A few random dirty pages
+    //
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < TEST_BENCHMARK_SPARSE_PAGES; i++)
+    {
+        DirtyBitmapSetPage(&Bitmap, HostRandom(&RandomState) % CountOfPages);
+    }
+
+    Elapsed = HostTimeNs() - Start;
+    printf("\tmark a page          : %10.1f ns\n", (double)Elapsed / TEST_BENCHMARK_SPARSE_PAGES);
+
+    Start   = HostTimeNs();
+    Pages   = TestCollect(&Bitmap, 0, CountOfPages, DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES, NULL, &Calls);
+    Elapsed = HostTimeNs() - Start;
+
+    printf("\t%u random pages    : %10.3f ms (%llu pages, %llu calls)\n",
+           TEST_BENCHMARK_SPARSE_PAGES,
+           (double)Elapsed / 1000000,
+           (unsigned long long)Pages,
+           (unsigned long long)Calls);
+
+    //
+    // 1% of the pages (in runs of 64 pages, e.g., a few modified buffers)
+    //
+    for (UINT64 i = 0; i < CountOfPages / 100 / 64; i++)
+    {
+        DirtyBitmapSetRange(&Bitmap, HostRandom(&RandomState) % CountOfPages, 64);
+    }
+
+    Start   = HostTimeNs();
+    Pages   = TestCollect(&Bitmap, 0, CountOfPages, DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES, NULL, &Calls);
+    Elapsed = HostTimeNs() - Start;
+
+    printf("\t1%% of the pages      : %10.3f ms (%llu pages, %llu calls)\n",
+           (double)Elapsed / 1000000,
+           (unsigned long long)Pages,
+           (unsigned long long)Calls);
+
+    //
+    // All of the pages
+    //
+    Start = HostTimeNs();
+    DirtyBitmapSetRange(&Bitmap, 0, CountOfPages);
+    Elapsed = HostTimeNs() - Start;
+
+    printf("\tmark all of the pages: %10.3f ms\n", (double)Elapsed / 1000000);
+
+    Start   = HostTimeNs();
+    Pages   = TestCollect(&Bitmap, 0, CountOfPages, DEBUGGER_DIRTY_PAGES_MAXIMUM_ENTRIES, NULL, &Calls);
+    Elapsed = HostTimeNs() - Start;
+
+    HOST_CHECK(Pages == CountOfPages);
+    printf("\tall of the pages     : %10.3f ms (%llu pages, %llu calls)\n",
+           (double)Elapsed / 1000000,
+           (unsigned long long)Pages,
+           (unsigned long long)Calls);
+
+    //
+    // Scanning the whole bitmap without the summary (for comparison)
+    //
+    Start = HostTimeNs();
+
+    for (UINT64 i = 0; i < Bitmap.CountOfWords; i++)
+    {
+        Sum += (UINT64)Bitmap.Words[i];
+    }
+
+    Elapsed = HostTimeNs() - Start;
+
+    HOST_CHECK(Sum == 0);
+    printf("\tscan without summary : %10.3f ms\n", (double)Elapsed / 1000000);
+
+    free((PVOID)Bitmap.Words);
+}
+
+int
+main(int argc, char ** argv)
+{
+    UINT64 SizeOfMemoryGb = argc > 1 ? strtoull(argv[1], NULL, 0) : 64;
+
+    TestPartialWords();
+    TestResume();
+    TestConcurrentWriters();
+    TestBenchmark(SizeOfMemoryGb);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file Zydis.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The decoded instruction types of Zydis for testing the cache on the host
+ * @details Zydis is not needed by the cache (it only copies the decoded
+ * instructions), so only the types are defined here
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+typedef uint8_t  ZyanU8;
+typedef uint32_t ZyanU32;
+typedef uint64_t ZyanU64;
+
+#define ZYDIS_MAX_INSTRUCTION_LENGTH 15
+#define ZYDIS_MAX_OPERAND_COUNT      10
+
+//
+// The sizes are close to the decoded instructions and operands of Zydis 4
+//
+typedef struct ZydisDecodedInstruction_
+{
+    ZyanU32 mnemonic;
+    ZyanU8  length;
+    ZyanU8  operand_count;
+    ZyanU8  operand_count_visible;
+    ZyanU8  raw[305];
+
+} ZydisDecodedInstruction;
+
+typedef struct ZydisDecodedOperand_
+{
+    ZyanU8  id;
+    ZyanU64 value;
+    ZyanU8  raw[64];
+
+} ZydisDecodedOperand;
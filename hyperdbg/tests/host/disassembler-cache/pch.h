@@ -0,0 +1,30 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the decoded instructions cache of the disassembler on the host
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+//////////////////////////////////////////////////
+//               Spinlocks                      //
+//////////////////////////////////////////////////
+
+BOOLEAN
+SpinlockTryLock(volatile LONG * Lock);
+
+void
+SpinlockLock(volatile LONG * Lock);
+
+void
+SpinlockLockWithCustomWait(volatile LONG * Lock, unsigned MaximumWait);
+
+void
+SpinlockUnlock(volatile LONG * Lock);
@@ -0,0 +1,318 @@
+/**
+ * @file test-disassembler-cache.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the decoded instructions cache of the disassembler
+ * @details The instructions are 'decoded' by a deterministic function of the
+ * mode, the address and the bytes, so the results of the cache are compared
+ * with the direct decoding (also from multiple threads)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+
+#include "Zydis/Zydis.h"
+#include "header/disassembler-cache.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the code of the test
+ *
+ */
+#define TEST_CODE_SIZE 0x10000
+
+/**
+ * @brief Number of threads of the concurrency test and the benchmark
+ *
+ */
+#define TEST_COUNT_OF_THREADS 4
+
+extern DISASSEMBLER_CACHE g_DisassemblerCache;
+
+UINT8 g_TestCode[TEST_CODE_SIZE + ZYDIS_MAX_INSTRUCTION_LENGTH];
+
+/**
+ * @brief Number of instructions that are decoded (not found in the cache)
+ *
+ */
+volatile LONG g_TestCountOfDecodes;
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Decode an instruction (a deterministic function of the key)
+ *
+ * @param Mode
+ * @param Address
+ * @param Buffer
+ * @param WindowLength
+ * @param Instruction
+ * @param Operands
+ * @return VOID
+ */
+static VOID
+TestDecode(UINT32 Mode, UINT64 Address, const ZyanU8 * Buffer, UINT32 WindowLength, ZydisDecodedInstruction * Instruction, ZydisDecodedOperand * Operands)
+{
+    UINT64 State = (Address * 0x9e3779b97f4a7c15ull) ^ Mode;
+
+    for (UINT32 i = 0; i < WindowLength; i++)
+    {
+        State = (State ^ Buffer[i]) * 0x100000001b3ull;
+    }
+
+    memset(Instruction, 0, sizeof(ZydisDecodedInstruction));
+
+    Instruction->mnemonic              = (ZyanU32)State;
+    Instruction->length                = (ZyanU8)(1 + Buffer[0] % WindowLength);
+    Instruction->operand_count         = (ZyanU8)(Buffer[1] % (ZYDIS_MAX_OPERAND_COUNT + 1));
+    Instruction->operand_count_visible = Instruction->operand_count;
+
+    for (UINT32 i = 0; i < Instruction->operand_count; i++)
+    {
+        memset(&Operands[i], 0, sizeof(ZydisDecodedOperand));
+
+        Operands[i].id    = (ZyanU8)i;
+        Operands[i].value = HostRandom(&State);
+    }
+}
+
+/**
+ * @brief Decode an instruction through the cache (same as DisassemblerDecode)
+ *
+ * @param Mode
+ * @param Address
+ * @param Buffer
+ * @param Instruction
+ * @param Operands
+ * @return VOID
+ */
+static VOID
+TestDecodeCached(UINT32 Mode, UINT64 Address, const ZyanU8 * Buffer, ZydisDecodedInstruction * Instruction, ZydisDecodedOperand * Operands)
+{
+    if (DisassemblerCacheLookup(Mode, Address, Buffer, ZYDIS_MAX_INSTRUCTION_LENGTH, Instruction, Operands))
+    {
+        return;
+    }
+
+    InterlockedIncrement(&g_TestCountOfDecodes);
+
+    TestDecode(Mode, Address, Buffer, ZYDIS_MAX_INSTRUCTION_LENGTH, Instruction, Operands);
+    DisassemblerCacheInsert(Mode, Address, Buffer, ZYDIS_MAX_INSTRUCTION_LENGTH, Instruction, Operands);
+}
+
+/**
+ * @brief Decode an instruction through the cache and compare it with the direct decoding
+ *
+ * @param Mode
+ * @param Offset Offset of the instruction in the code
+ * @return VOID
+ */
+static VOID
+TestCheckDecode(UINT32 Mode, UINT32 Offset)
+{
+    ZydisDecodedInstruction Instruction;
+    ZydisDecodedInstruction Expected;
+    ZydisDecodedOperand     Operands[ZYDIS_MAX_OPERAND_COUNT];
+    ZydisDecodedOperand     ExpectedOperands[ZYDIS_MAX_OPERAND_COUNT];
+
+    TestDecodeCached(Mode, 0x7ff600000000ull + Offset, &g_TestCode[Offset], &Instruction, Operands);
+    TestDecode(Mode, 0x7ff600000000ull + Offset, &g_TestCode[Offset], ZYDIS_MAX_INSTRUCTION_LENGTH, &Expected, ExpectedOperands);
+
+    HOST_CHECK(memcmp(&Instruction, &Expected, sizeof(Expected)) == 0);
+    HOST_CHECK(memcmp(Operands, ExpectedOperands, Expected.operand_count * sizeof(ZydisDecodedOperand)) == 0);
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Hits, misses, changed bytes and the LRU replacement
+ *
+ * @return VOID
+ */
+static VOID
+TestLeastRecentlyUsed()
+{
+    ZydisDecodedInstruction Instruction;
+    ZydisDecodedOperand     Operands[ZYDIS_MAX_OPERAND_COUNT];
+    UINT8                   Changed[ZYDIS_MAX_INSTRUCTION_LENGTH];
+
+    DisassemblerCacheClear();
+    g_TestCountOfDecodes = 0;
+
+    //
+    // Fill the cache, then use the first instruction again, so the second one
+    // is the least recently used instruction
+    //
+    for (UINT32 i = 0; i < DISASSEMBLER_CACHE_MAXIMUM_ENTRIES; i++)
+    {
+        TestCheckDecode(1, i);
+    }
+
+    TestCheckDecode(1, 0);
+    HOST_CHECK(g_TestCountOfDecodes == DISASSEMBLER_CACHE_MAXIMUM_ENTRIES);
+
+    TestCheckDecode(1, DISASSEMBLER_CACHE_MAXIMUM_ENTRIES);
+
+    HOST_CHECK(DisassemblerCacheLookup(1, 0x7ff600000000ull, &g_TestCode[0], ZYDIS_MAX_INSTRUCTION_LENGTH, &Instruction, Operands));
+    HOST_CHECK(!DisassemblerCacheLookup(1, 0x7ff600000001ull, &g_TestCode[1], ZYDIS_MAX_INSTRUCTION_LENGTH, &Instruction, Operands));
+    HOST_CHECK(DisassemblerCacheLookup(1, 0x7ff600000002ull, &g_TestCode[2], ZYDIS_MAX_INSTRUCTION_LENGTH, &Instruction, Operands));
+
+    //
+    // The mode and the bytes are parts of the key (e.g., a breakpoint or a
+    // modified instruction at the same address)
+    //
+    HOST_CHECK(!DisassemblerCacheLookup(0, 0x7ff600000002ull, &g_TestCode[2], ZYDIS_MAX_INSTRUCTION_LENGTH, &Instruction, Operands));
+
+    memcpy(Changed, &g_TestCode[2], sizeof(Changed));
+    Changed[ZYDIS_MAX_INSTRUCTION_LENGTH - 1] ^= 0xcc;
+
+    HOST_CHECK(!DisassemblerCacheLookup(1, 0x7ff600000002ull, Changed, ZYDIS_MAX_INSTRUCTION_LENGTH, &Instruction, Operands));
+
+    printf("lru: the least recently used instruction is replaced and changed bytes are not found\n");
+}
+
+/**
+ * @brief Thread routine of the concurrency test
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestConcurrencyThread(void * Parameter)
+{
+    UINT64 RandomState = 0x7777 + (UINT64)Parameter;
+
+    for (UINT32 i = 0; i < 200000; i++)
+    {
+        //
+        // The working set is larger than the cache, so entries are replaced
+        // while the other threads read them
+        //
+        TestCheckDecode((UINT32)(HostRandom(&RandomState) % 2), (UINT32)(HostRandom(&RandomState) % 3000));
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Multiple threads decode through the cache
+ *
+ * @return VOID
+ */
+static VOID
+TestConcurrency()
+{
+    pthread_t Threads[TEST_COUNT_OF_THREADS];
+
+    DisassemblerCacheClear();
+    g_TestCountOfDecodes = 0;
+
+    for (UINT64 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+    {
+        HOST_CHECK(pthread_create(&Threads[i], NULL, TestConcurrencyThread, (void *)i) == 0);
+    }
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+    {
+        pthread_join(Threads[i], NULL);
+    }
+
+    HOST_CHECK(g_DisassemblerCache.Lock == 0);
+    HOST_CHECK(g_DisassemblerCache.CountOfEntries == DISASSEMBLER_CACHE_MAXIMUM_ENTRIES);
+
+    printf("concurrency: %u threads decoded 200000 instructions each (%u decodes), all of them matched\n",
+           TEST_COUNT_OF_THREADS,
+           (UINT32)g_TestCountOfDecodes);
+}
+
+/**
+ * @brief Thread routine of the benchmark (disassembles the same region again)
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestBenchmarkThread(void * Parameter)
+{
+    ZydisDecodedInstruction Instruction;
+    ZydisDecodedOperand     Operands[ZYDIS_MAX_OPERAND_COUNT];
+
+    for (UINT32 Round = 0; Round < 1000; Round++)
+    {
+        for (UINT32 Offset = 0; Offset < 1000; Offset++)
+        {
+            TestDecodeCached(1, 0x7ff600000000ull + Offset, &g_TestCode[Offset], &Instruction, Operands);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Time of the cache hits with one and multiple threads
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    pthread_t Threads[TEST_COUNT_OF_THREADS];
+    UINT64    Begin;
+    UINT64    Time[2];
+
+    DisassemblerCacheClear();
+
+    Begin = HostTimeNs();
+    TestBenchmarkThread(NULL);
+    Time[0] = HostTimeNs() - Begin;
+
+    Begin = HostTimeNs();
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+    {
+        HOST_CHECK(pthread_create(&Threads[i], NULL, TestBenchmarkThread, NULL) == 0);
+    }
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+    {
+        pthread_join(Threads[i], NULL);
+    }
+
+    Time[1] = HostTimeNs() - Begin;
+
+    printf("benchmark: re-disassembling 1000 instructions 1000 times, %.0f ns per cached decode "
+           "(1 thread), %.0f ns per cached decode (%u threads on the same lock)\n",
+           (double)Time[0] / 1e6,
+           (double)Time[1] / (1e6 * TEST_COUNT_OF_THREADS),
+           TEST_COUNT_OF_THREADS);
+}
+
+int
+main()
+{
+    UINT64 RandomState = 0x6666;
+
+    for (UINT32 i = 0; i < sizeof(g_TestCode); i++)
+    {
+        g_TestCode[i] = (UINT8)HostRandom(&RandomState);
+    }
+
+    TestLeastRecentlyUsed();
+    TestConcurrency();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
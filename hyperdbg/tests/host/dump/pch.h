@@ -0,0 +1,71 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the dump files of the .dump command on the host
+ * @details Only the portable parts (dump-file.cpp) are compiled, reading the
+ * pages (the debuggee) and writing the file (POSIX) are simulated by the test
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/ErrorCodes.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define FIELD_OFFSET(Type, Field) ((LONG)offsetof(Type, Field))
+#define ZeroMemory RtlZeroMemory
+
+/**
+ * @brief Same fields as the OVERLAPPED of Windows, the writes of the test
+ * are synchronous and their results are kept in the internal fields
+ *
+ */
+typedef struct _OVERLAPPED
+{
+    ULONG_PTR Internal;     // Result of the write (0 if succeeded)
+    ULONG_PTR InternalHigh; // Number of the written bytes
+    DWORD     Offset;
+    DWORD     OffsetHigh;
+    HANDLE    hEvent;
+
+} OVERLAPPED;
+
+static inline UCHAR
+_BitScanForward64(ULONG * Index, UINT64 Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+
+    *Index = (ULONG)__builtin_ctzll(Mask);
+
+    return 1;
+}
+
+//////////////////////////////////////////////////
+//               Dump Files                     //
+//////////////////////////////////////////////////
+
+#include "../../../libhyperdbg/header/dump.h"
@@ -0,0 +1,969 @@
+/**
+ * @file test-dump.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the dump files of the .dump command
+ * @details A simulated debuggee (readable, zero, and unreadable pages) is
+ * dumped into raw and sparse files which are compared with the reference
+ * content. Dumps are interrupted (lost connection, failed writes, and CTRL+C)
+ * and resumed, and the result should be the same as an uninterrupted dump.
+ * The throughput is measured with and without a latency for each read request
+ * of the debuggee, both in batches and page by page
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+#define TEST_DUMP_FILE_PATH      "test-dump.dmp"
+#define TEST_REFERENCE_FILE_PATH "test-dump.ref"
+#define TEST_START_ADDRESS       0x7ff600000000ull
+#define TEST_COUNT_OF_PAGES      2000
+#define TEST_UNALIGNED_END       0x234 // The last page of the tested ranges is not complete
+
+/**
+ * @brief Kinds of the pages of the simulated debuggee
+ *
+ */
+typedef enum _TEST_PAGE_KIND
+{
+    TestPageData,
+    TestPageZero,
+    TestPageUnreadable,
+
+} TEST_PAGE_KIND;
+
+/**
+ * @brief The simulated debuggee
+ *
+ */
+static UINT64              g_TestStartAddress;
+static std::vector<BYTE>   g_TestMemory;
+static std::vector<BYTE>   g_TestKinds;
+static UINT64              g_TestLatencyNs;           // Latency of each read request
+static UINT64              g_TestCountOfRequests;     // Number of the read requests
+static UINT64              g_TestLostAfterRequests;   // Connection is lost after this number of requests (0 = never)
+static UINT64              g_TestCountOfWrites;       // Number of the writes of the write buffers
+static UINT64              g_TestFailedAfterWrites;   // Writes fail after this number of writes (0 = never)
+static UINT64              g_TestInterruptAfterBatch; // The dump is interrupted (CTRL+C) after this number of batches (0 = never)
+static UINT32              g_TestMaximumReadSize;
+
+//////////////////////////////////////////////////
+//				  Simulated Debuggee     		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Generate the memory of the debuggee
+ * @details Some of the pages only have one non-zero byte at their end
+ * which is the worst case for detecting the zero pages
+ *
+ * @param StartAddress
+ * @param CountOfPages
+ * @param Seed
+ *
+ * @return VOID
+ */
+static VOID
+TestCreateDebuggee(UINT64 StartAddress, UINT64 CountOfPages, UINT64 Seed)
+{
+    UINT64 RandomState = Seed;
+
+    g_TestStartAddress = StartAddress;
+    g_TestMemory.assign((size_t)(CountOfPages * PAGE_SIZE), 0);
+    g_TestKinds.assign((size_t)CountOfPages, TestPageData);
+
+    for (UINT64 i = 0; i < CountOfPages; i++)
+    {
+        UINT64   Random = HostRandom(&RandomState) % 100;
+        UINT64 * Words  = (UINT64 *)&g_TestMemory[(size_t)(i * PAGE_SIZE)];
+
+        if (Random < 15)
+        {
+            g_TestKinds[(size_t)i] = TestPageZero;
+        }
+        else if (Random < 18)
+        {
+            g_TestKinds[(size_t)i] = TestPageUnreadable;
+        }
+        else if (Random < 28)
+        {
+            g_TestMemory[(size_t)(i * PAGE_SIZE) + PAGE_SIZE - 1] = 0xcc;
+        }
+        else
+        {
+            for (UINT32 j = 0; j < PAGE_SIZE / sizeof(UINT64); j++)
+            {
+                Words[j] = HostRandom(&RandomState);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Read pages of the simulated debuggee (same as the debuggee, the
+ * request fails if any of the pages is not readable)
+ *
+ * @param Context
+ * @param Address
+ * @param Size
+ * @param IsConnectionLost
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpReadPages(PDUMP_CONTEXT Context, UINT64 Address, UINT32 Size, BOOLEAN * IsConnectionLost)
+{
+    DEBUGGER_READ_MEMORY * ReadMem = Context->ReadRequest;
+    UINT64                 Offset  = Address - g_TestStartAddress;
+    UINT64                 Start   = HostTimeNs();
+
+    *IsConnectionLost = FALSE;
+
+    //
+    // The request and its result should fit in one serial packet
+    //
+    HOST_CHECK(Size != 0 && Size <= DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE);
+    HOST_CHECK(sizeof(DEBUGGER_READ_MEMORY) + Size <= MaxSerialPacketSize);
+    HOST_CHECK(Address >= g_TestStartAddress && Offset + Size <= g_TestMemory.size());
+
+    if (Size > g_TestMaximumReadSize)
+    {
+        g_TestMaximumReadSize = Size;
+    }
+
+    g_TestCountOfRequests++;
+
+    if (g_TestLostAfterRequests != 0 && g_TestCountOfRequests > g_TestLostAfterRequests)
+    {
+        *IsConnectionLost = TRUE;
+        return FALSE;
+    }
+
+    while (HostTimeNs() - Start < g_TestLatencyNs)
+    {
+        YieldProcessor();
+    }
+
+    ReadMem->Address      = Address;
+    ReadMem->Size         = Size;
+    ReadMem->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+    ReadMem->ReturnLength = Size;
+
+    for (UINT64 Page = Offset / PAGE_SIZE; Page <= (Offset + Size - 1) / PAGE_SIZE; Page++)
+    {
+        if (g_TestKinds[(size_t)Page] == TestPageUnreadable)
+        {
+            ReadMem->KernelStatus = DEBUGGER_ERROR_READING_MEMORY_INVALID_PARAMETER;
+            ReadMem->ReturnLength = 0;
+            return FALSE;
+        }
+    }
+
+    memcpy(((BYTE *)ReadMem) + sizeof(DEBUGGER_READ_MEMORY), &g_TestMemory[(size_t)Offset], Size);
+
+    return TRUE;
+}
+
+//////////////////////////////////////////////////
+//				    Simulated File       		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Write the metadata (header or page map) of the dump file
+ *
+ * @param Context
+ * @param FileOffset
+ * @param Buffer
+ * @param Size
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpWriteMetadata(PDUMP_CONTEXT Context, UINT64 FileOffset, PVOID Buffer, UINT32 Size)
+{
+    return pwrite((int)(intptr_t)Context->FileHandle, Buffer, Size, (off_t)FileOffset) == (ssize_t)Size;
+}
+
+/**
+ * @brief Write the content of a write buffer into the dump file
+ *
+ * @param Context
+ * @param WriteBuffer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpStartWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer)
+{
+    ssize_t Written;
+
+    g_TestCountOfWrites++;
+
+    if (g_TestFailedAfterWrites != 0 && g_TestCountOfWrites > g_TestFailedAfterWrites)
+    {
+        return FALSE;
+    }
+
+    Written = pwrite((int)(intptr_t)Context->FileHandle, WriteBuffer->Buffer, WriteBuffer->UsedSize, (off_t)WriteBuffer->FileOffset);
+
+    WriteBuffer->Overlapped.Internal     = Written < 0 ? 1 : 0;
+    WriteBuffer->Overlapped.InternalHigh = Written < 0 ? 0 : (ULONG_PTR)Written;
+
+    return TRUE;
+}
+
+/**
+ * @brief Wait for the write of a write buffer
+ *
+ * @param Context
+ * @param WriteBuffer
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+CommandDumpWaitForWrite(PDUMP_CONTEXT Context, PDUMP_WRITE_BUFFER WriteBuffer)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    return WriteBuffer->Overlapped.Internal == 0 && WriteBuffer->Overlapped.InternalHigh == WriteBuffer->UsedSize;
+}
+
+/**
+ * @brief Read a file
+ *
+ * @param Path
+ *
+ * @return std::vector<BYTE>
+ */
+static std::vector<BYTE>
+TestReadFile(const char * Path)
+{
+    std::vector<BYTE> Content;
+    FILE *            File = fopen(Path, "rb");
+
+    HOST_CHECK(File != NULL);
+
+    fseek(File, 0, SEEK_END);
+    Content.resize((size_t)ftell(File));
+    fseek(File, 0, SEEK_SET);
+
+    HOST_CHECK(Content.empty() || fread(Content.data(), 1, Content.size(), File) == Content.size());
+
+    fclose(File);
+
+    return Content;
+}
+
+//////////////////////////////////////////////////
+//				      Dumps             		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Options of a dump (same as the options of the .dump command)
+ *
+ */
+typedef struct _TEST_DUMP_OPTIONS
+{
+    UINT64                              EndAddress;
+    BOOLEAN                             IsSparse;
+    BOOLEAN                             IsResume;
+    BOOLEAN                             IsIncremental;
+    BOOLEAN                             IsPageByPage; // Pages are not read in batches
+    std::vector<DEBUGGER_DIRTY_PAGES_ENTRY> DirtyEntries;
+
+} TEST_DUMP_OPTIONS;
+
+/**
+ * @brief Dump the simulated debuggee, the same way as CommandDump and
+ * CommandDumpPrepareFile
+ *
+ * @param Path
+ * @param Options
+ * @param Header Receives the committed header
+ * @param CountOfDirtyPages Receives the number of the marked dirty pages
+ *
+ * @return BOOLEAN FALSE if the file couldn't be prepared
+ * or the dump didn't complete
+ */
+static BOOLEAN
+TestDump(const char * Path, const TEST_DUMP_OPTIONS & Options, DUMP_SPARSE_FILE_HEADER * Header, UINT64 * CountOfDirtyPages = NULL)
+{
+    DUMP_CONTEXT            Context = {};
+    DUMP_SPARSE_FILE_HEADER PreviousHeader;
+    ssize_t                 BytesRead;
+    struct stat             FileStat;
+    int                     File;
+    UINT64                  Batches  = 0;
+    BOOLEAN                 Result   = TRUE;
+    UINT64                  Length   = Options.EndAddress - g_TestStartAddress;
+
+    Context.IsSparse      = Options.IsSparse || Options.IsIncremental;
+    Context.IsIncremental = Options.IsIncremental;
+    Context.MemoryType    = Options.IsIncremental ? DEBUGGER_READ_PHYSICAL_ADDRESS : DEBUGGER_READ_VIRTUAL_ADDRESS;
+    Context.Pid           = 0x1c0;
+
+    CommandDumpInitializeHeader(&Context, g_TestStartAddress, Options.EndAddress);
+
+    File = open(Path, O_RDWR | (Options.IsResume ? 0 : O_CREAT | O_TRUNC), 0644);
+    HOST_CHECK(File >= 0);
+
+    Context.FileHandle  = (HANDLE)(intptr_t)File;
+    Context.ReadRequest = (DEBUGGER_READ_MEMORY *)malloc(sizeof(DEBUGGER_READ_MEMORY) + (DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE));
+
+    for (UINT32 i = 0; i < DUMP_WRITE_BUFFER_COUNT; i++)
+    {
+        Context.WriteBuffers[i].Buffer = (BYTE *)malloc(DUMP_WRITE_BUFFER_SIZE);
+    }
+
+    if (Context.IsSparse && Options.IsResume)
+    {
+        BytesRead = pread(File, &PreviousHeader, sizeof(DUMP_SPARSE_FILE_HEADER), 0);
+        Result    = BytesRead > 0 && CommandDumpResumeSparseFile(&Context, &PreviousHeader, (UINT32)BytesRead);
+    }
+    else if (Context.IsSparse)
+    {
+        CommandDumpInitializeSparseFile(&Context);
+        Result = CommandDumpWriteMetadata(&Context, 0, &Context.Header, sizeof(DUMP_SPARSE_FILE_HEADER));
+    }
+    else if (Options.IsResume)
+    {
+        Result = fstat(File, &FileStat) == 0 && CommandDumpResumeRawFile(&Context, (UINT64)FileStat.st_size);
+    }
+
+    if (Result)
+    {
+        HOST_CHECK(ftruncate(File, (off_t)Context.NextFileOffset) == 0);
+    }
+
+    if (Result && Options.IsIncremental)
+    {
+        Context.DirtyPages.assign((SIZE_T)((Context.Header.CountOfPages + 63) / 64), 0);
+
+        *CountOfDirtyPages = CommandDumpMarkDirtyPages(&Context,
+                                                       (PDEBUGGER_DIRTY_PAGES_ENTRY)Options.DirtyEntries.data(),
+                                                       (UINT32)Options.DirtyEntries.size());
+    }
+
+    if (Result)
+    {
+        CommandDumpResetWriteBuffer(&Context, Context.CurrentWriteBuffer);
+
+        while (Context.NextPageIndex < Context.Header.CountOfPages)
+        {
+            if (g_TestInterruptAfterBatch != 0 && Batches++ == g_TestInterruptAfterBatch)
+            {
+                Result = FALSE;
+                break;
+            }
+
+            if (Options.IsPageByPage)
+            {
+                UINT64 Size = Length - (Context.NextPageIndex * PAGE_SIZE);
+
+                Result = CommandDumpReadAndAppendBatch(&Context,
+                                                       g_TestStartAddress + (Context.NextPageIndex * PAGE_SIZE),
+                                                       Size > PAGE_SIZE ? PAGE_SIZE : (UINT32)Size);
+            }
+            else
+            {
+                Result = CommandDumpNextBatch(&Context);
+            }
+
+            if (!Result)
+            {
+                break;
+            }
+        }
+
+        //
+        // Pages that are read before a failure are kept
+        //
+        if (!CommandDumpFinalize(&Context))
+        {
+            Result = FALSE;
+        }
+    }
+
+    *Header = Context.Header;
+
+    for (UINT32 i = 0; i < DUMP_WRITE_BUFFER_COUNT; i++)
+    {
+        free(Context.WriteBuffers[i].Buffer);
+    }
+
+    free(Context.ReadRequest);
+    close(File);
+
+    return Result;
+}
+
+/**
+ * @brief Reset the simulated failures
+ *
+ * @return VOID
+ */
+static VOID
+TestResetFailures()
+{
+    g_TestLostAfterRequests   = 0;
+    g_TestFailedAfterWrites   = 0;
+    g_TestInterruptAfterBatch = 0;
+    g_TestCountOfRequests     = 0;
+    g_TestCountOfWrites       = 0;
+}
+
+/**
+ * @brief Get the expected kind of a page of the range
+ * @details The last page might be smaller than a page, it's a zero page if
+ * its bytes in the range are zero
+ *
+ * @param PageIndex
+ * @param EndAddress
+ * @param Size Receives the size of the page in the range
+ *
+ * @return TEST_PAGE_KIND
+ */
+static TEST_PAGE_KIND
+TestGetPageKind(UINT64 PageIndex, UINT64 EndAddress, UINT32 * Size)
+{
+    UINT64 Remaining = EndAddress - g_TestStartAddress - (PageIndex * PAGE_SIZE);
+    BYTE * Page      = &g_TestMemory[(size_t)(PageIndex * PAGE_SIZE)];
+
+    *Size = Remaining >= PAGE_SIZE ? PAGE_SIZE : (UINT32)Remaining;
+
+    if (g_TestKinds[(size_t)PageIndex] == TestPageUnreadable)
+    {
+        return TestPageUnreadable;
+    }
+
+    for (UINT32 i = 0; i < *Size; i++)
+    {
+        if (Page[i] != 0)
+        {
+            return TestPageData;
+        }
+    }
+
+    return TestPageZero;
+}
+
+/**
+ * @brief Check a raw dump file with the memory of the debuggee
+ *
+ * @param Path
+ * @param EndAddress
+ *
+ * @return VOID
+ */
+static VOID
+TestCheckRawFile(const char * Path, UINT64 EndAddress)
+{
+    std::vector<BYTE> Content = TestReadFile(Path);
+    UINT32            Size;
+
+    HOST_CHECK(Content.size() == EndAddress - g_TestStartAddress);
+
+    for (UINT64 i = 0; i * PAGE_SIZE < Content.size(); i++)
+    {
+        BYTE * Page = &Content[(size_t)(i * PAGE_SIZE)];
+
+        if (TestGetPageKind(i, EndAddress, &Size) == TestPageUnreadable)
+        {
+            HOST_CHECK(CommandDumpIsZeroPage(Page, Size));
+        }
+        else
+        {
+            HOST_CHECK(memcmp(Page, &g_TestMemory[(size_t)(i * PAGE_SIZE)], Size) == 0);
+        }
+    }
+}
+
+/**
+ * @brief Check a sparse dump file with the memory of the debuggee
+ *
+ * @param Path
+ * @param EndAddress
+ * @param DirtyPages The pages that are expected to be dumped in the
+ * incremental dumps (empty if all of the pages are dumped)
+ *
+ * @return VOID
+ */
+static VOID
+TestCheckSparseFile(const char * Path, UINT64 EndAddress, const std::vector<BOOLEAN> & DirtyPages)
+{
+    std::vector<BYTE>         Content = TestReadFile(Path);
+    DUMP_SPARSE_FILE_HEADER * Header  = (DUMP_SPARSE_FILE_HEADER *)Content.data();
+    UINT64 *                  PageMap;
+    UINT64                    Counts[4]      = {0};
+    UINT64                    NextDataOffset = 0;
+    UINT32                    Size;
+
+    HOST_CHECK(Content.size() >= PAGE_SIZE);
+    HOST_CHECK(Header->Magic == DUMP_SPARSE_FILE_MAGIC);
+    HOST_CHECK(Header->StartAddress == g_TestStartAddress && Header->EndAddress == EndAddress);
+    HOST_CHECK(Header->CountOfPages == (EndAddress - g_TestStartAddress + PAGE_SIZE - 1) / PAGE_SIZE);
+    HOST_CHECK(Header->NextPageIndex == Header->CountOfPages);
+    HOST_CHECK(Header->PageMapOffset == DUMP_SPARSE_PAGE_MAP_OFFSET);
+    HOST_CHECK(Header->DataOffset == DUMP_SPARSE_PAGE_MAP_OFFSET + ROUND_TO_PAGES(Header->CountOfPages * sizeof(UINT64)));
+    HOST_CHECK(Content.size() == Header->NextDataOffset);
+
+    PageMap        = (UINT64 *)&Content[(size_t)Header->PageMapOffset];
+    NextDataOffset = Header->DataOffset;
+
+    for (UINT64 i = 0; i < Header->CountOfPages; i++)
+    {
+        TEST_PAGE_KIND Kind = TestGetPageKind(i, EndAddress, &Size);
+
+        if (!DirtyPages.empty() && !DirtyPages[(size_t)i])
+        {
+            HOST_CHECK(PageMap[i] == DUMP_PAGE_MAP_ENTRY_UNCHANGED_PAGE);
+            Counts[3]++;
+        }
+        else if (Kind == TestPageUnreadable)
+        {
+            HOST_CHECK(PageMap[i] == DUMP_PAGE_MAP_ENTRY_UNREADABLE_PAGE);
+            Counts[2]++;
+        }
+        else if (Kind == TestPageZero)
+        {
+            HOST_CHECK(PageMap[i] == DUMP_PAGE_MAP_ENTRY_ZERO_PAGE);
+            Counts[1]++;
+        }
+        else
+        {
+            //
+            // Pages are saved in order, as complete (zero-padded) pages
+            //
+            HOST_CHECK(PageMap[i] == NextDataOffset);
+            HOST_CHECK(memcmp(&Content[(size_t)PageMap[i]], &g_TestMemory[(size_t)(i * PAGE_SIZE)], Size) == 0);
+            HOST_CHECK(CommandDumpIsZeroPage(&Content[(size_t)PageMap[i] + Size], PAGE_SIZE - Size));
+
+            NextDataOffset += PAGE_SIZE;
+            Counts[0]++;
+        }
+    }
+
+    HOST_CHECK(Header->NextDataOffset == NextDataOffset);
+    HOST_CHECK(Header->CountOfPresentPages == Counts[0]);
+    HOST_CHECK(Header->CountOfZeroPages == Counts[1]);
+    HOST_CHECK(Header->CountOfUnreadablePages == Counts[2]);
+
+    if (Header->Version == DUMP_SPARSE_FILE_VERSION)
+    {
+        HOST_CHECK(Header->CountOfUnchangedPages == Counts[3]);
+        HOST_CHECK(Header->Flags == (DirtyPages.empty() ? 0 : DUMP_SPARSE_FILE_FLAG_INCREMENTAL));
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Tests             		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Complete raw and sparse dumps
+ *
+ * @return VOID
+ */
+static VOID
+TestCompleteDumps()
+{
+    TEST_DUMP_OPTIONS       Options;
+    DUMP_SPARSE_FILE_HEADER Header;
+
+    TestCreateDebuggee(TEST_START_ADDRESS, TEST_COUNT_OF_PAGES, 0x5eed);
+
+    Options.EndAddress    = TEST_START_ADDRESS + (TEST_COUNT_OF_PAGES * PAGE_SIZE) - TEST_UNALIGNED_END;
+    Options.IsSparse      = FALSE;
+    Options.IsResume      = FALSE;
+    Options.IsIncremental = FALSE;
+    Options.IsPageByPage  = FALSE;
+
+    TestResetFailures();
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+    HOST_CHECK(Header.NextPageIndex == TEST_COUNT_OF_PAGES && Header.NextDataOffset == Options.EndAddress - TEST_START_ADDRESS);
+    HOST_CHECK(g_TestMaximumReadSize == DUMP_MAXIMUM_PAGES_PER_READ * PAGE_SIZE);
+
+    TestCheckRawFile(TEST_DUMP_FILE_PATH, Options.EndAddress);
+
+    printf("raw dump: %u pages (%llu present, %llu unreadable) in %llu read requests\n",
+           TEST_COUNT_OF_PAGES,
+           Header.CountOfPresentPages,
+           Header.CountOfUnreadablePages,
+           g_TestCountOfRequests);
+
+    Options.IsSparse = TRUE;
+
+    TestResetFailures();
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+
+    TestCheckSparseFile(TEST_DUMP_FILE_PATH, Options.EndAddress, std::vector<BOOLEAN>());
+
+    printf("sparse dump: %llu present, %llu zero, %llu unreadable pages in %llu read requests\n",
+           Header.CountOfPresentPages,
+           Header.CountOfZeroPages,
+           Header.CountOfUnreadablePages,
+           g_TestCountOfRequests);
+
+    //
+    // Page by page dumps are the same
+    //
+    std::vector<BYTE> Batched = TestReadFile(TEST_DUMP_FILE_PATH);
+
+    Options.IsPageByPage = TRUE;
+
+    TestResetFailures();
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+    HOST_CHECK(TestReadFile(TEST_DUMP_FILE_PATH) == Batched);
+
+    remove(TEST_DUMP_FILE_PATH);
+}
+
+/**
+ * @brief Interrupt a dump, resume it, and compare it with a complete dump
+ *
+ * @param Options The options of the dump
+ * @param Reference The complete dump
+ * @param Failure Kind of the failure (0 = lost connection, 1 = failed write,
+ * 2 = CTRL+C)
+ * @param After The failure happens after this number of requests, writes,
+ * or batches
+ *
+ * @return UINT64 The committed page of the interrupted dump
+ */
+static UINT64
+TestInterruptAndResume(TEST_DUMP_OPTIONS Options, const std::vector<BYTE> & Reference, UINT32 Failure, UINT64 After)
+{
+    DUMP_SPARSE_FILE_HEADER Header;
+    UINT64                  CommittedPage;
+
+    TestResetFailures();
+
+    if (Failure == 0)
+    {
+        g_TestLostAfterRequests = After;
+    }
+    else if (Failure == 1)
+    {
+        g_TestFailedAfterWrites = After;
+    }
+    else
+    {
+        g_TestInterruptAfterBatch = After;
+    }
+
+    Options.IsResume = FALSE;
+
+    HOST_CHECK(!TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+    HOST_CHECK(Header.NextPageIndex < Header.CountOfPages);
+
+    CommittedPage = Header.NextPageIndex;
+
+    //
+    // The committed pages are in the file
+    //
+    if (!Options.IsSparse)
+    {
+        HOST_CHECK(TestReadFile(TEST_DUMP_FILE_PATH).size() >= CommittedPage * PAGE_SIZE);
+    }
+    else
+    {
+        HOST_CHECK(((DUMP_SPARSE_FILE_HEADER *)TestReadFile(TEST_DUMP_FILE_PATH).data())->NextPageIndex == CommittedPage);
+    }
+
+    TestResetFailures();
+
+    Options.IsResume = TRUE;
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+    HOST_CHECK(TestReadFile(TEST_DUMP_FILE_PATH) == Reference);
+
+    //
+    // Only the pages after the committed page are read again
+    //
+    HOST_CHECK(g_TestCountOfRequests <= ((TEST_COUNT_OF_PAGES - CommittedPage + DUMP_MAXIMUM_PAGES_PER_READ - 1) / DUMP_MAXIMUM_PAGES_PER_READ) +
+                                            (TEST_COUNT_OF_PAGES - CommittedPage));
+
+    return CommittedPage;
+}
+
+/**
+ * @brief Resume interrupted raw and sparse dumps
+ *
+ * @return VOID
+ */
+static VOID
+TestResumedDumps()
+{
+    TEST_DUMP_OPTIONS       Options;
+    DUMP_SPARSE_FILE_HEADER Header;
+    std::vector<BYTE>       Reference;
+    UINT64                  CountOfResumes = 0;
+    int                     File;
+
+    TestCreateDebuggee(TEST_START_ADDRESS, TEST_COUNT_OF_PAGES, 0xfeed);
+
+    Options.EndAddress    = TEST_START_ADDRESS + (TEST_COUNT_OF_PAGES * PAGE_SIZE) - TEST_UNALIGNED_END;
+    Options.IsResume      = FALSE;
+    Options.IsIncremental = FALSE;
+    Options.IsPageByPage  = FALSE;
+
+    for (UINT32 Sparse = 0; Sparse < 2; Sparse++)
+    {
+        Options.IsSparse = (BOOLEAN)Sparse;
+
+        TestResetFailures();
+
+        HOST_CHECK(TestDump(TEST_REFERENCE_FILE_PATH, Options, &Header));
+
+        Reference = TestReadFile(TEST_REFERENCE_FILE_PATH);
+
+        //
+        // Failures before, within, and after the first write buffers
+        //
+        for (UINT64 After : {1, 7, 16, 17, 40, 100, 120})
+        {
+            TestInterruptAndResume(Options, Reference, 0, After);
+            TestInterruptAndResume(Options, Reference, 2, After);
+            CountOfResumes += 2;
+        }
+
+        for (UINT64 After : {1, 2, 3, 5})
+        {
+            TestInterruptAndResume(Options, Reference, 1, After);
+            CountOfResumes++;
+        }
+    }
+
+    //
+    // Sparse dumps of the first version are resumed in the same version
+    //
+    Options.IsSparse = TRUE;
+
+    TestResetFailures();
+    g_TestInterruptAfterBatch = 50;
+
+    HOST_CHECK(!TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+
+    Header.Version    = DUMP_SPARSE_FILE_VERSION_1;
+    Header.HeaderSize = DUMP_SPARSE_FILE_HEADER_SIZE_V1;
+
+    File = open(TEST_DUMP_FILE_PATH, O_RDWR);
+    HOST_CHECK(File >= 0);
+    HOST_CHECK(pwrite(File, &Header, DUMP_SPARSE_FILE_HEADER_SIZE_V1, 0) == DUMP_SPARSE_FILE_HEADER_SIZE_V1);
+    close(File);
+
+    TestResetFailures();
+    Options.IsResume = TRUE;
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+    HOST_CHECK(Header.Version == DUMP_SPARSE_FILE_VERSION_1);
+
+    TestCheckSparseFile(TEST_DUMP_FILE_PATH, Options.EndAddress, std::vector<BOOLEAN>());
+
+    //
+    // Files of other ranges or formats are not resumed
+    //
+    Options.EndAddress -= PAGE_SIZE;
+    HOST_CHECK(!TestDump(TEST_REFERENCE_FILE_PATH, Options, &Header));
+    Options.EndAddress += PAGE_SIZE;
+
+    Reference = TestReadFile(TEST_REFERENCE_FILE_PATH);
+    ((DUMP_SPARSE_FILE_HEADER *)Reference.data())->NextPageIndex = TEST_COUNT_OF_PAGES + 1;
+
+    File = open(TEST_DUMP_FILE_PATH, O_RDWR | O_TRUNC);
+    HOST_CHECK(File >= 0);
+    HOST_CHECK(pwrite(File, Reference.data(), Reference.size(), 0) == (ssize_t)Reference.size());
+    close(File);
+
+    HOST_CHECK(!TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+
+    Options.IsSparse   = FALSE;
+    Options.EndAddress = TEST_START_ADDRESS + (TEST_COUNT_OF_PAGES / 2 * PAGE_SIZE);
+
+    HOST_CHECK(!TestDump(TEST_REFERENCE_FILE_PATH, Options, &Header));
+
+    remove(TEST_DUMP_FILE_PATH);
+    remove(TEST_REFERENCE_FILE_PATH);
+
+    printf("resumed dumps: %llu interrupted dumps are resumed and equal to the complete dumps\n", CountOfResumes);
+}
+
+/**
+ * @brief Incremental dumps of the collected dirty pages
+ *
+ * @return VOID
+ */
+static VOID
+TestIncrementalDumps()
+{
+    TEST_DUMP_OPTIONS          Options;
+    DUMP_SPARSE_FILE_HEADER    Header;
+    DEBUGGER_DIRTY_PAGES_ENTRY Entry;
+    UINT64                     CountOfDirtyPages;
+    UINT64                     ExpectedDirtyPages = 0;
+    UINT64                     ExpectedRequests   = 0;
+    UINT64                     RandomState        = 0xd1e7;
+    UINT64                     FirstPageFrameNumber;
+    std::vector<BOOLEAN>       DirtyPages(TEST_COUNT_OF_PAGES, FALSE);
+
+    //
+    // The range doesn't start at a multiple of 64 pages
+    //
+    TestCreateDebuggee(0x12345000, TEST_COUNT_OF_PAGES, 0xabcd);
+
+    FirstPageFrameNumber = g_TestStartAddress / PAGE_SIZE;
+
+    //
+    // Entries (64 pages each) around the range, runs of dirty pages
+    //
+    for (UINT64 Base = (FirstPageFrameNumber & ~63ull) - 64; Base < FirstPageFrameNumber + TEST_COUNT_OF_PAGES + 64; Base += 64)
+    {
+        Entry.FirstPageFrameNumber = Base;
+        Entry.Bitmap               = HostRandom(&RandomState) & HostRandom(&RandomState);
+
+        if (Base % 256 == 0)
+        {
+            Entry.Bitmap = ~0ull;
+        }
+
+        for (UINT32 Bit = 0; Bit < 64; Bit++)
+        {
+            if ((Entry.Bitmap & (1ull << Bit)) && Base + Bit >= FirstPageFrameNumber && Base + Bit < FirstPageFrameNumber + TEST_COUNT_OF_PAGES)
+            {
+                DirtyPages[(size_t)(Base + Bit - FirstPageFrameNumber)] = TRUE;
+                ExpectedDirtyPages++;
+            }
+        }
+
+        Options.DirtyEntries.push_back(Entry);
+    }
+
+    //
+    // Runs of consecutive dirty pages are read in batches
+    //
+    for (UINT64 i = 0; i < TEST_COUNT_OF_PAGES;)
+    {
+        UINT64 Run = 0;
+
+        while (i + Run < TEST_COUNT_OF_PAGES && DirtyPages[(size_t)(i + Run)] && Run < DUMP_MAXIMUM_PAGES_PER_READ)
+        {
+            Run++;
+        }
+
+        ExpectedRequests += Run != 0;
+        i += Run != 0 ? Run : 1;
+    }
+
+    Options.EndAddress    = g_TestStartAddress + (TEST_COUNT_OF_PAGES * PAGE_SIZE);
+    Options.IsSparse      = TRUE;
+    Options.IsResume      = FALSE;
+    Options.IsIncremental = TRUE;
+    Options.IsPageByPage  = FALSE;
+
+    TestResetFailures();
+
+    HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header, &CountOfDirtyPages));
+    HOST_CHECK(CountOfDirtyPages == ExpectedDirtyPages);
+    HOST_CHECK(Header.CountOfUnchangedPages == TEST_COUNT_OF_PAGES - ExpectedDirtyPages);
+
+    TestCheckSparseFile(TEST_DUMP_FILE_PATH, Options.EndAddress, DirtyPages);
+
+    //
+    // Batches with unreadable pages are read again page by page
+    //
+    HOST_CHECK(g_TestCountOfRequests >= ExpectedRequests);
+
+    remove(TEST_DUMP_FILE_PATH);
+
+    printf("incremental dump: %llu of %u pages are modified, %llu read requests (%llu batches of the modified pages)\n",
+           CountOfDirtyPages,
+           TEST_COUNT_OF_PAGES,
+           g_TestCountOfRequests,
+           ExpectedRequests);
+}
+
+//////////////////////////////////////////////////
+//				     Benchmark            		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Measure the throughput of the dumps
+ * @details The latency of each request models the round-trip to the
+ * debuggee (e.g., the serial connection or the IOCTLs of the driver)
+ *
+ * @param SizeOfRangeMb
+ * @param LatencyUs
+ *
+ * @return VOID
+ */
+static VOID
+TestThroughput(UINT64 SizeOfRangeMb, UINT64 LatencyUs)
+{
+    TEST_DUMP_OPTIONS       Options;
+    DUMP_SPARSE_FILE_HEADER Header;
+    UINT64                  CountOfPages = SizeOfRangeMb * 1024 * 1024 / PAGE_SIZE;
+    UINT64                  Start;
+    double                  Seconds;
+
+    TestCreateDebuggee(TEST_START_ADDRESS, CountOfPages, 0xbeef);
+
+    Options.EndAddress    = TEST_START_ADDRESS + (CountOfPages * PAGE_SIZE);
+    Options.IsResume      = FALSE;
+    Options.IsIncremental = FALSE;
+
+    for (UINT64 Latency : {0ull, LatencyUs})
+    {
+        g_TestLatencyNs = Latency * 1000;
+
+        for (UINT32 Sparse = 0; Sparse < 2; Sparse++)
+        {
+            for (UINT32 PageByPage = 0; PageByPage < 2; PageByPage++)
+            {
+                Options.IsSparse     = (BOOLEAN)Sparse;
+                Options.IsPageByPage = (BOOLEAN)PageByPage;
+
+                TestResetFailures();
+
+                Start = HostTimeNs();
+                HOST_CHECK(TestDump(TEST_DUMP_FILE_PATH, Options, &Header));
+                Seconds = (double)(HostTimeNs() - Start) / 1e9;
+
+                printf("throughput: %s, %s, %llu us per request: %.1f MB/s (%llu requests, %llu buffer writes)\n",
+                       Sparse ? "sparse" : "raw   ",
+                       PageByPage ? "page by page" : "batches     ",
+                       Latency,
+                       (double)SizeOfRangeMb / Seconds,
+                       g_TestCountOfRequests,
+                       g_TestCountOfWrites);
+            }
+        }
+    }
+
+    g_TestLatencyNs = 0;
+
+    remove(TEST_DUMP_FILE_PATH);
+}
+
+int
+main(int argc, char ** argv)
+{
+    UINT64 SizeOfRangeMb = argc > 1 ? strtoull(argv[1], NULL, 0) : 256;
+    UINT64 LatencyUs     = argc > 2 ? strtoull(argv[2], NULL, 0) : 20;
+
+    TestCompleteDumps();
+    TestResumedDumps();
+    TestIncrementalDumps();
+    TestThroughput(SizeOfRangeMb, LatencyUs);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
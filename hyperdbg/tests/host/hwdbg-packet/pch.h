@@ -0,0 +1,33 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the encoding and decoding of hwdbg packets on the host
+ * @details Only the portable parts (hwdbg-packet.cpp) are compiled, the same
+ * as the co-simulation harness of hwdbg (hwdbg/sim/verilator)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/HardwareDebugger.h"
+
+//////////////////////////////////////////////////
+//               hwdbg Packets                  //
+//////////////////////////////////////////////////
+
+#include "../../../libhyperdbg/header/hwdbg-packet.h"
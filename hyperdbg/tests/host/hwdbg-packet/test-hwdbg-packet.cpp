@@ -0,0 +1,435 @@
+/**
+ * @file test-hwdbg-packet.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of encoding and decoding hwdbg packets
+ * @details The packets are encoded and compared with the test vectors of
+ * hwdbg, the responses of the test bench are decoded, the text hex files and
+ * the binary BRAM images are round-tripped, and exchanging a packet through
+ * text hex files is compared with binary BRAM images
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+#define TEST_TEXT_FILE_PATH       "test-hwdbg-packet.hex.txt"
+#define TEST_IMAGE_FILE_PATH      "test-hwdbg-packet.bram"
+#define TEST_SHARED_MEMORY_SIZE   1024
+#define TEST_NUMBER_OF_WORDS      (TEST_SHARED_MEMORY_SIZE / sizeof(UINT32))
+#define TEST_COUNT_OF_FUZZ_ROUNDS 100000
+
+/**
+ * @brief Test vectors of hwdbg (relative to the hwdbg directory)
+ *
+ */
+#define TEST_INSTANCE_INFO_REQUEST_PATH  "/src/test/bram/instance_info.hex.txt"
+#define TEST_SCRIPT_BUFFER_REQUEST_PATH  "/src/test/bram/script_buffer.hex.txt"
+#define TEST_INSTANCE_INFO_RESPONSE_PATH "/sim/hwdbg/DebuggerModuleTestingBRAM/bram_instance_info.txt"
+#define TEST_SCRIPT_BUFFER_RESPONSE_PATH "/sim/hwdbg/DebuggerModuleTestingBRAM/script_buffer_response.txt"
+
+//////////////////////////////////////////////////
+//				     Helpers     		     	//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Read a whole file
+ *
+ * @param Path
+ * @param Content
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestReadFile(const std::string & Path, std::string & Content)
+{
+    std::ifstream     File(Path, std::ios::binary);
+    std::stringstream Stream;
+
+    if (!File.is_open())
+    {
+        return FALSE;
+    }
+
+    Stream << File.rdbuf();
+    Content = Stream.str();
+
+    return TRUE;
+}
+
+/**
+ * @brief Parse a text hex file
+ *
+ * @param Content
+ * @param Words
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestParseText(const std::string & Content, std::vector<UINT32> & Words)
+{
+    std::stringstream Stream(Content);
+    std::string       Line;
+
+    Words.clear();
+
+    while (std::getline(Stream, Line))
+    {
+        if (!HwdbgPacketParseTextLine(Line, Words))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+//////////////////////////////////////////////////
+//				       Tests     		     	//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Encode and decode packets
+ *
+ */
+static VOID
+TestEncodeAndDecode()
+{
+    BYTE                     Buffer[TEST_SHARED_MEMORY_SIZE];
+    BYTE                     Payload[100];
+    DEBUGGER_REMOTE_PACKET * Packet;
+    SIZE_T                   Size;
+    BYTE                     Checksum = 0;
+
+    for (UINT32 i = 0; i < sizeof(Payload); i++)
+    {
+        Payload[i] = (BYTE)(i * 7 + 3);
+    }
+
+    //
+    // The packet is placed after the offset, and the checksum covers
+    // everything except the checksum itself
+    //
+    memset(Buffer, 0xcc, sizeof(Buffer));
+
+    Size = HwdbgPacketGetEncodedSize(0x40, sizeof(Payload));
+    HOST_CHECK(Size == 0x40 + sizeof(DEBUGGER_REMOTE_PACKET) + sizeof(Payload));
+
+    HOST_CHECK(HwdbgPacketEncode(Buffer,
+                                 Size,
+                                 0x40,
+                                 DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+                                 hwdbgActionConfigureScriptBuffer,
+                                 Payload,
+                                 sizeof(Payload)));
+
+    for (UINT32 i = 0; i < 0x40; i++)
+    {
+        HOST_CHECK(Buffer[i] == 0);
+    }
+
+    HOST_CHECK(Buffer[Size] == 0xcc);
+
+    for (SIZE_T i = 0x40 + 1; i < Size; i++)
+    {
+        Checksum += Buffer[i];
+    }
+
+    HOST_CHECK(Buffer[0x40] == Checksum);
+    HOST_CHECK(HwdbgPacketComputeChecksum(Buffer + 0x40 + 1, Size - 0x40 - 1) == Checksum);
+    HOST_CHECK(memcmp(Buffer + 0x40 + sizeof(DEBUGGER_REMOTE_PACKET), Payload, sizeof(Payload)) == 0);
+
+    //
+    // The words are the same as the text hex files of hwdbg
+    //
+    HOST_CHECK(((UINT32 *)(Buffer + 0x40))[2] == 0x52444247);
+    HOST_CHECK(((UINT32 *)(Buffer + 0x40))[3] == 0x48595045);
+    HOST_CHECK(((UINT32 *)(Buffer + 0x40))[4] == DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL);
+    HOST_CHECK(((UINT32 *)(Buffer + 0x40))[5] == hwdbgActionConfigureScriptBuffer);
+
+    Packet = HwdbgPacketDecode(Buffer, Size, 0x40);
+    HOST_CHECK(Packet == (DEBUGGER_REMOTE_PACKET *)(Buffer + 0x40));
+    HOST_CHECK(Packet->TypeOfThePacket == DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL);
+    HOST_CHECK(Packet->RequestedActionOfThePacket == (DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION)hwdbgActionConfigureScriptBuffer);
+
+    //
+    // Packets without payloads, small buffers, and packets out of the buffer
+    //
+    HOST_CHECK(HwdbgPacketEncode(Buffer, sizeof(DEBUGGER_REMOTE_PACKET), 0, DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL, hwdbgActionSendInstanceInfo, NULL, 100));
+    HOST_CHECK(Buffer[0] == HwdbgPacketComputeChecksum(Buffer + 1, sizeof(DEBUGGER_REMOTE_PACKET) - 1));
+    HOST_CHECK(!HwdbgPacketEncode(Buffer, Size - 1, 0x40, DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL, hwdbgActionSendInstanceInfo, Payload, sizeof(Payload)));
+
+    HOST_CHECK(HwdbgPacketDecode(Buffer, sizeof(DEBUGGER_REMOTE_PACKET), 0) != NULL);
+    HOST_CHECK(HwdbgPacketDecode(Buffer, sizeof(DEBUGGER_REMOTE_PACKET) - 1, 0) == NULL);
+    HOST_CHECK(HwdbgPacketDecode(Buffer, sizeof(Buffer), 0xffffffff) == NULL);
+
+    Buffer[8] ^= 1;
+    HOST_CHECK(HwdbgPacketDecode(Buffer, sizeof(Buffer), 0) == NULL);
+
+    printf("encode and decode: the layout, checksum, and boundaries of the packets are correct\n");
+}
+
+/**
+ * @brief Check the packets with the test vectors of hwdbg
+ *
+ * @param HwdbgDirectory
+ */
+static VOID
+TestVectors(const std::string & HwdbgDirectory)
+{
+    BYTE                     Buffer[TEST_SHARED_MEMORY_SIZE];
+    std::string              Content;
+    std::string              Expected;
+    std::vector<UINT32>      Words;
+    std::vector<UINT32>      Reparsed;
+    std::ostringstream       Stream;
+    DEBUGGER_REMOTE_PACKET * Packet;
+    PHWDBG_INSTANCE_INFORMATION InstanceInfo;
+
+    //
+    // The instance info request of HyperDbg is the same as the test vector
+    //
+    HOST_CHECK(TestReadFile(HwdbgDirectory + TEST_INSTANCE_INFO_REQUEST_PATH, Expected));
+    HOST_CHECK(HwdbgPacketEncode(Buffer,
+                                 sizeof(Buffer),
+                                 DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET,
+                                 DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+                                 hwdbgActionSendInstanceInfo,
+                                 NULL,
+                                 0));
+
+    HwdbgPacketWriteTextFile(Stream,
+                             (UINT32 *)Buffer,
+                             HwdbgPacketGetEncodedSize(DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET, 0) / sizeof(UINT32),
+                             TEST_SHARED_MEMORY_SIZE,
+                             hwdbgActionSendInstanceInfo);
+
+    HOST_CHECK(Stream.str() == Expected);
+
+    //
+    // The script buffer request is parsed and written back the same
+    //
+    HOST_CHECK(TestReadFile(HwdbgDirectory + TEST_SCRIPT_BUFFER_REQUEST_PATH, Content));
+    HOST_CHECK(TestParseText(Content, Words) && Words.size() == TEST_NUMBER_OF_WORDS);
+
+    Packet = HwdbgPacketDecode(Words.data(), Words.size() * sizeof(UINT32), DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET);
+    HOST_CHECK(Packet != NULL && Packet->RequestedActionOfThePacket == (DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION)hwdbgActionConfigureScriptBuffer);
+
+    Stream.str("");
+    HwdbgPacketWriteTextFile(Stream, Words.data(), Words.size(), 0, Words[5]);
+    HOST_CHECK(TestParseText(Stream.str(), Reparsed) && Reparsed == Words);
+
+    //
+    // Responses of the test bench are decoded from the debuggee area
+    //
+    HOST_CHECK(TestReadFile(HwdbgDirectory + TEST_INSTANCE_INFO_RESPONSE_PATH, Content));
+    HOST_CHECK(TestParseText(Content, Words) && Words.size() == TEST_NUMBER_OF_WORDS);
+
+    Packet = HwdbgPacketDecode(Words.data(), Words.size() * sizeof(UINT32), DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET);
+    HOST_CHECK(Packet != NULL);
+    HOST_CHECK(Packet->TypeOfThePacket == DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER_HARDWARE_LEVEL);
+    HOST_CHECK(Packet->RequestedActionOfThePacket == (DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION)hwdbgResponseInstanceInfo);
+
+    InstanceInfo = (PHWDBG_INSTANCE_INFORMATION)(Packet + 1);
+    HOST_CHECK(InstanceInfo->sharedMemorySize == TEST_SHARED_MEMORY_SIZE);
+    HOST_CHECK(InstanceInfo->debuggeeAreaOffset == DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET);
+
+    HOST_CHECK(TestReadFile(HwdbgDirectory + TEST_SCRIPT_BUFFER_RESPONSE_PATH, Content));
+    HOST_CHECK(TestParseText(Content, Words) && Words.size() == TEST_NUMBER_OF_WORDS);
+    HOST_CHECK(HwdbgPacketDecode(Words.data(), Words.size() * sizeof(UINT32), DEFAULT_INITIAL_DEBUGGEE_TO_DEBUGGER_OFFSET) != NULL);
+
+    printf("test vectors: the instance info request is identical, and the responses of the test bench are decoded\n");
+}
+
+/**
+ * @brief Parse the lines of the text hex files
+ *
+ */
+static VOID
+TestTextLines()
+{
+    std::vector<UINT32> Values;
+    std::string         Line;
+    UINT64              RandomState = 0x5eed;
+
+    HOST_CHECK(HwdbgPacketParseTextLine("0000005a ; +0x0   | Checksum", Values) && Values.size() == 1 && Values[0] == 0x5a);
+    HOST_CHECK(HwdbgPacketParseTextLine("mem_130: 52444247   | Indicator", Values) && Values.size() == 2 && Values[1] == 0x52444247);
+    HOST_CHECK(HwdbgPacketParseTextLine("1234 // comment\r", Values) && Values.size() == 3 && Values[2] == 0x1234);
+    HOST_CHECK(HwdbgPacketParseTextLine("Content of BRAM after emulation:", Values) && Values.size() == 3);
+    HOST_CHECK(HwdbgPacketParseTextLine("", Values) && Values.size() == 3);
+    HOST_CHECK(HwdbgPacketParseTextLine("deadbeef cafebabe", Values) && Values.size() == 5 && Values[4] == 0xcafebabe);
+
+    HOST_CHECK(!HwdbgPacketParseTextLine("123456789", Values));
+    HOST_CHECK(!HwdbgPacketParseTextLine("mem_0: xyz", Values));
+    HOST_CHECK(!HwdbgPacketParseTextLine("-1", Values));
+
+    //
+    // Random lines are either rejected or parsed as hex words
+    //
+    for (UINT32 Round = 0; Round < TEST_COUNT_OF_FUZZ_ROUNDS; Round++)
+    {
+        static const CHAR Alphabet[] = "0123456789abcdefABCDEFxmem_ :;|/\t\r-+";
+
+        Line.clear();
+
+        for (UINT32 i = 0, Length = (UINT32)(HostRandom(&RandomState) % 24); i < Length; i++)
+        {
+            Line += Alphabet[HostRandom(&RandomState) % (sizeof(Alphabet) - 1)];
+        }
+
+        Values.clear();
+        HwdbgPacketParseTextLine(Line, Values);
+        HOST_CHECK(Values.size() <= Line.length() / 2 + 1);
+    }
+
+    printf("text lines: requests, responses, comments, and malformed lines are handled (%u fuzzed lines)\n",
+           TEST_COUNT_OF_FUZZ_ROUNDS);
+}
+
+/**
+ * @brief Check the headers of the binary BRAM images
+ *
+ */
+static VOID
+TestBramImageHeaders()
+{
+    HWDBG_BRAM_IMAGE_HEADER Header;
+    HWDBG_BRAM_IMAGE_HEADER Invalid;
+    UINT64                  ImageSize;
+
+    HwdbgPacketInitializeBramImageHeader(&Header, TEST_NUMBER_OF_WORDS);
+    ImageSize = sizeof(HWDBG_BRAM_IMAGE_HEADER) + TEST_SHARED_MEMORY_SIZE;
+
+    HOST_CHECK(Header.DebuggerSequence == 0 && Header.DebuggeeSequence == 0);
+    HOST_CHECK(HwdbgPacketIsValidBramImageHeader(&Header, 0));
+    HOST_CHECK(HwdbgPacketIsValidBramImageHeader(&Header, ImageSize));
+    HOST_CHECK(!HwdbgPacketIsValidBramImageHeader(&Header, ImageSize - 1));
+
+    Invalid       = Header;
+    Invalid.Magic = 0;
+    HOST_CHECK(!HwdbgPacketIsValidBramImageHeader(&Invalid, 0));
+
+    Invalid         = Header;
+    Invalid.Version = HWDBG_BRAM_IMAGE_VERSION + 1;
+    HOST_CHECK(!HwdbgPacketIsValidBramImageHeader(&Invalid, 0));
+
+    Invalid            = Header;
+    Invalid.HeaderSize = sizeof(HWDBG_BRAM_IMAGE_HEADER) - 1;
+    HOST_CHECK(!HwdbgPacketIsValidBramImageHeader(&Invalid, 0));
+
+    //
+    // Larger headers (newer images) are accepted if the content fits
+    //
+    Invalid               = Header;
+    Invalid.HeaderSize    = 0x100;
+    Invalid.NumberOfWords = 0xffffffff;
+    HOST_CHECK(HwdbgPacketIsValidBramImageHeader(&Invalid, 0));
+    HOST_CHECK(!HwdbgPacketIsValidBramImageHeader(&Invalid, ImageSize));
+
+    printf("BRAM images: invalid magics, versions, headers, and truncated images are rejected\n");
+}
+
+/**
+ * @brief Compare exchanging packets through text hex files and binary BRAM images
+ * @details Each packet is written by the debugger and read by the simulator,
+ * then the whole BRAM is written back and read by the debugger (the same as
+ * the co-simulation harness without the simulation)
+ *
+ * @param CountOfPackets
+ */
+static VOID
+TestBenchmark(UINT32 CountOfPackets)
+{
+    BYTE                    Buffer[TEST_SHARED_MEMORY_SIZE] = {0};
+    HWDBG_BRAM_IMAGE_HEADER Header;
+    std::vector<UINT32>     Words;
+    std::string             Content;
+    UINT64                  Start;
+    double                  Text;
+    double                  Binary;
+
+    HwdbgPacketEncode(Buffer,
+                      sizeof(Buffer),
+                      DEFAULT_INITIAL_DEBUGGER_TO_DEBUGGEE_OFFSET,
+                      DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGER_TO_DEBUGGEE_HARDWARE_LEVEL,
+                      hwdbgActionSendInstanceInfo,
+                      NULL,
+                      0);
+
+    //
+    // Text hex files
+    //
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < CountOfPackets * 2; i++)
+    {
+        {
+            std::ofstream File(TEST_TEXT_FILE_PATH);
+
+            HwdbgPacketWriteTextFile(File, (UINT32 *)Buffer, TEST_NUMBER_OF_WORDS, 0, hwdbgActionSendInstanceInfo);
+        }
+
+        HOST_CHECK(TestReadFile(TEST_TEXT_FILE_PATH, Content));
+        HOST_CHECK(TestParseText(Content, Words) && Words.size() == TEST_NUMBER_OF_WORDS);
+    }
+
+    Text = (double)(HostTimeNs() - Start) / CountOfPackets / 1000.0;
+
+    //
+    // Binary BRAM images
+    //
+    HwdbgPacketInitializeBramImageHeader(&Header, TEST_NUMBER_OF_WORDS);
+    Words.resize(TEST_NUMBER_OF_WORDS);
+
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < CountOfPackets * 2; i++)
+    {
+        {
+            std::ofstream File(TEST_IMAGE_FILE_PATH, std::ios::binary);
+
+            Header.DebuggerSequence++;
+            File.write((const char *)&Header, sizeof(Header));
+            File.write((const char *)Buffer, sizeof(Buffer));
+        }
+
+        std::ifstream File(TEST_IMAGE_FILE_PATH, std::ios::binary);
+
+        HOST_CHECK(File.read((char *)&Header, sizeof(Header)) && HwdbgPacketIsValidBramImageHeader(&Header, 0));
+        HOST_CHECK(File.read((char *)Words.data(), Header.NumberOfWords * sizeof(UINT32)));
+    }
+
+    Binary = (double)(HostTimeNs() - Start) / CountOfPackets / 1000.0;
+
+    HOST_CHECK(memcmp(Words.data(), Buffer, sizeof(Buffer)) == 0);
+
+    remove(TEST_TEXT_FILE_PATH);
+    remove(TEST_IMAGE_FILE_PATH);
+
+    printf("benchmark (%u packets of %u bytes, request and response):\n", CountOfPackets, TEST_SHARED_MEMORY_SIZE);
+    printf("\ttext transfer per packet  : %.2f us (%.0f packets/s)\n", Text, 1000000.0 / Text);
+    printf("\tbinary transfer per packet: %.2f us (%.0f packets/s)\n", Binary, 1000000.0 / Binary);
+    printf("\tspeedup                   : %.1fx\n", Text / Binary);
+}
+
+int
+main(int argc, char ** argv)
+{
+    std::string HwdbgDirectory = argc > 1 ? argv[1] : "../../../../hwdbg";
+    UINT32      CountOfPackets = argc > 2 ? (UINT32)strtoul(argv[2], NULL, 0) : 10000;
+
+    TestEncodeAndDecode();
+    TestVectors(HwdbgDirectory);
+    TestTextLines();
+    TestBramImageHeaders();
+    TestBenchmark(CountOfPackets);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
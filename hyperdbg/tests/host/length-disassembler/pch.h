@@ -0,0 +1,16 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the table-driven length decoder on the host
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../hyperhv/header/disassembler/LengthDisassembler.h"
@@ -0,0 +1,875 @@
+/**
+ * @file test-length-disassembler.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Differential tests and benchmark of the table-driven length decoder
+ * @details Zydis is not part of the host build, so GNU objdump is used as the
+ * reference decoder. Whenever the length decoder returns a length, the
+ * reference should decode the same bytes as a valid instruction of the same
+ * length, the instructions that are rejected (zero) are handled by Zydis in
+ * HyperDbg and are only counted
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <unistd.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the slots of the random corpus, each sample is followed by
+ * nops, so the reference decoder is synchronized again at the next slot
+ *
+ */
+#define TEST_SLOT_SIZE 40
+
+/**
+ * @brief Number of bytes of each random sample
+ *
+ */
+#define TEST_SAMPLE_SIZE 16
+
+/**
+ * @brief Default number of random samples of each mode
+ *
+ */
+#define TEST_DEFAULT_RANDOM_SAMPLES 60000
+
+/**
+ * @brief Maximum number of failures that are shown
+ *
+ */
+#define TEST_MAXIMUM_SHOWN_FAILURES 32
+
+/**
+ * @brief Number of times the real corpus is decoded by the benchmark
+ *
+ */
+#define TEST_BENCHMARK_ROUNDS 20
+
+/**
+ * @brief An instruction that is decoded by the reference decoder
+ *
+ */
+typedef struct _TEST_REFERENCE_INSTRUCTION
+{
+    UINT64  Address;
+    UINT32  Length;
+    BOOLEAN IsInvalid;      // The reference decoder shows (bad)
+    BOOLEAN IsLonePrefix;   // The reference decoder shows a prefix as a separate instruction
+    char    Mnemonic[48];
+
+} TEST_REFERENCE_INSTRUCTION, *PTEST_REFERENCE_INSTRUCTION;
+
+/**
+ * @brief A corpus of instructions (the bytes and their reference decoding)
+ *
+ */
+typedef struct _TEST_CORPUS
+{
+    BYTE *                      Bytes;
+    SIZE_T                      SizeOfBytes;
+    PTEST_REFERENCE_INSTRUCTION Instructions;
+    SIZE_T                      CountOfInstructions;
+    SIZE_T                      MaximumInstructions;
+
+} TEST_CORPUS, *PTEST_CORPUS;
+
+/**
+ * @brief Results of a differential run
+ *
+ */
+typedef struct _TEST_RESULTS
+{
+    UINT64 Matched;      // Same length as the reference decoder
+    UINT64 Rejected;     // Rejected by the length decoder (handled by Zydis)
+    UINT64 Inconclusive; // The reference decoder is known to differ from Zydis
+    UINT64 Failed;       // Accepted by the length decoder, but invalid or of another length
+
+} TEST_RESULTS, *PTEST_RESULTS;
+
+/**
+ * @brief A known encoding and its expected length
+ *
+ */
+typedef struct _TEST_KNOWN_ENCODING
+{
+    BOOLEAN     Is32Bit;
+    const char * Bytes;
+    UINT32      Length; // Zero if the encoding should be rejected
+
+} TEST_KNOWN_ENCODING;
+
+//////////////////////////////////////////////////
+//				     Known Encodings     		//
+//////////////////////////////////////////////////
+
+static const TEST_KNOWN_ENCODING g_TestKnownEncodings[] = {
+    //
+    // Valid encodings
+    //
+    {FALSE, "90", 1},
+    {FALSE, "c3", 1},
+    {FALSE, "e8 00 00 00 00", 5},
+    {FALSE, "66 e8 00 00 00 00", 6},
+    {FALSE, "48 b8 00 00 00 00 00 00 00 00", 10},
+    {FALSE, "48 8b 05 00 00 00 00", 7},
+    {FALSE, "c7 44 24 08 00 00 00 00", 8},
+    {FALSE, "66 c7 44 24 08 00 00", 7},
+    {FALSE, "c6 00 01", 3},
+    {FALSE, "c6 f8 01", 3},
+    {FALSE, "c7 f8 00 00 00 00", 6},
+    {FALSE, "fe c0", 2},
+    {FALSE, "fe 08", 2},
+    {FALSE, "f0 01 00", 3},
+    {FALSE, "f0 0f b1 0a", 4},
+    {FALSE, "f0 0f c7 0e", 4},
+    {FALSE, "f0 ff 00", 3},
+    {FALSE, "f0 80 08 01", 4},
+    {FALSE, "66 0f 6d c1", 4},
+    {FALSE, "f2 0f f0 00", 4},
+    {FALSE, "66 0f 38 00 c1", 5},
+    {FALSE, "66 0f 3a 0f c1 08", 6},
+    {FALSE, "f3 0f b8 c1", 4},
+    {FALSE, "0f 20 c0", 3},
+    {FALSE, "0f 01 d0", 3},
+    {FALSE, "44 0f 22 c0", 4},
+    {TRUE, "c4 00", 2},
+    {TRUE, "62 00", 2},
+    {TRUE, "9a 00 00 00 00 00 00", 7},
+    {TRUE, "67 8b 46 00", 4},
+
+    //
+    // Invalid encodings (FE /2-/7, C6 /1-/7, C7 /1-/7, LOCK prefix on
+    // instructions that can't be locked, SSE opcodes without their
+    // mandatory prefix, reserved registers and opcodes that are invalid in
+    // 64-bit mode), and the encodings that are left to Zydis (VEX, EVEX and
+    // 3DNow!)
+    //
+    {FALSE, "fe d0", 0},
+    {FALSE, "fe 10", 0},
+    {FALSE, "fe f8", 0},
+    {FALSE, "c6 c8 01", 0},
+    {FALSE, "c6 48 00 01", 0},
+    {FALSE, "c6 f9 01", 0},
+    {FALSE, "c7 c8 00 00 00 00", 0},
+    {FALSE, "f0 90", 0},
+    {FALSE, "f0 01 c0", 0},
+    {FALSE, "f0 8b 00", 0},
+    {FALSE, "f0 80 38 01", 0},
+    {FALSE, "f0 0f 05", 0},
+    {FALSE, "0f 6d c0", 0},
+    {FALSE, "f2 0f e2 c0", 0},
+    {FALSE, "0f f0 00", 0},
+    {FALSE, "8f 20", 0},
+    {FALSE, "8f c0", 2},
+    {FALSE, "ff f8", 0},
+    {FALSE, "ff d8", 0},
+    {FALSE, "06", 0},
+    {FALSE, "0f 04", 0},
+    {FALSE, "0f 20 c8", 0},
+    {FALSE, "8c f8", 0},
+    {FALSE, "8e c8", 0},
+    {FALSE, "8d c0", 0},
+    {FALSE, "c5 f8 77", 0},
+    {FALSE, "62 f1 7c 48 10 00", 0},
+    {FALSE, "0f 0f c1 b4", 0},
+    {TRUE, "c5 f8 77", 0},
+    {FALSE, "0f 0b", 2},
+    {FALSE, "66 66 66 66 66 66 66 66 66 66 66 66 66 66 90", 15},
+    {FALSE, "66 66 66 66 66 66 66 66 66 66 66 66 66 66 66 90", 0},
+};
+
+//////////////////////////////////////////////////
+//				      Reference Decoder     	//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Whether the reference decoder is available
+ *
+ */
+BOOLEAN g_TestIsReferenceAvailable;
+
+/**
+ * @brief Check whether a mnemonic of the reference decoder is a lone prefix
+ *
+ * @param Mnemonic
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsLonePrefix(const char * Mnemonic)
+{
+    static const char * Prefixes[] = {"data16", "data32", "addr16", "addr32", "lock", "rep", "repz", "repnz",
+                                      "repe", "repne", "cs", "ds", "es", "ss", "fs", "gs", "bnd", "notrack",
+                                      "xacquire", "xrelease", "rex", "fwait"};
+
+    if (strchr(Mnemonic, ' ') != NULL)
+    {
+        return FALSE;
+    }
+
+    if (strncmp(Mnemonic, "rex.", 4) == 0)
+    {
+        return TRUE;
+    }
+
+    for (SIZE_T i = 0; i < RTL_NUMBER_OF(Prefixes); i++)
+    {
+        if (strcmp(Mnemonic, Prefixes[i]) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Add an instruction to the corpus
+ *
+ * @param Corpus
+ * @param Instruction
+ *
+ * @return VOID
+ */
+static VOID
+TestCorpusAddInstruction(PTEST_CORPUS Corpus, PTEST_REFERENCE_INSTRUCTION Instruction)
+{
+    if (Corpus->CountOfInstructions == Corpus->MaximumInstructions)
+    {
+        Corpus->MaximumInstructions  = Corpus->MaximumInstructions ? Corpus->MaximumInstructions * 2 : 0x10000;
+        Corpus->Instructions         = realloc(Corpus->Instructions, Corpus->MaximumInstructions * sizeof(TEST_REFERENCE_INSTRUCTION));
+        HOST_CHECK(Corpus->Instructions != NULL);
+    }
+
+    Corpus->Instructions[Corpus->CountOfInstructions++] = *Instruction;
+}
+
+/**
+ * @brief Run the reference decoder and parse its instructions
+ * @details Lines look like "  addr:\t0f 1f 00 \tnopl (%rax)", the bytes of an
+ * instruction are appended to the bytes of the corpus if it's an ELF file
+ *
+ * @param Command
+ * @param Corpus
+ * @param AppendBytes Whether the bytes are read from the output (ELF files)
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestRunReferenceDecoder(const char * Command, PTEST_CORPUS Corpus, BOOLEAN AppendBytes)
+{
+    char                       Line[512];
+    FILE *                     Output;
+    TEST_REFERENCE_INSTRUCTION Instruction;
+    SIZE_T                     MaximumBytes = 0;
+
+    Output = popen(Command, "r");
+
+    if (Output == NULL)
+    {
+        return FALSE;
+    }
+
+    while (fgets(Line, sizeof(Line), Output) != NULL)
+    {
+        char *             Cursor = Line;
+        char *             Tab;
+        unsigned long long Address;
+        unsigned int       Byte;
+        int                Consumed = -1;
+
+        while (*Cursor == ' ')
+        {
+            Cursor++;
+        }
+
+        if (sscanf(Cursor, "%llx:%n", &Address, &Consumed) != 1 || Consumed < 0 || Cursor[Consumed] != '\t')
+        {
+            continue;
+        }
+
+        RtlZeroMemory(&Instruction, sizeof(Instruction));
+        Instruction.Address = Address;
+        Cursor += Consumed + 1;
+        Tab = strchr(Cursor, '\t');
+
+        while (sscanf(Cursor, "%2x%n", &Byte, &Consumed) == 1 && (Tab == NULL || Cursor < Tab))
+        {
+            if (AppendBytes)
+            {
+                if (Corpus->SizeOfBytes == MaximumBytes)
+                {
+                    MaximumBytes        = MaximumBytes ? MaximumBytes * 2 : 0x100000;
+                    Corpus->Bytes       = realloc(Corpus->Bytes, MaximumBytes + LENGTH_DISASSEMBLER_MAXIMUM_LENGTH);
+                    HOST_CHECK(Corpus->Bytes != NULL);
+                }
+
+                Corpus->Bytes[Corpus->SizeOfBytes++] = (BYTE)Byte;
+            }
+
+            Instruction.Length++;
+            Cursor += Consumed;
+
+            while (*Cursor == ' ')
+            {
+                Cursor++;
+            }
+        }
+
+        if (Tab != NULL)
+        {
+            SIZE_T Length;
+
+            Cursor = Tab + 1;
+            Length = strcspn(Cursor, "\n");
+
+            while (Length > 0 && Cursor[Length - 1] == ' ')
+            {
+                Length--;
+            }
+
+            if (Length >= sizeof(Instruction.Mnemonic))
+            {
+                Length = sizeof(Instruction.Mnemonic) - 1;
+            }
+
+            memcpy(Instruction.Mnemonic, Cursor, Length);
+        }
+
+        //
+        // Continuation lines (without a mnemonic) belong to the previous instruction
+        //
+        if (Tab == NULL)
+        {
+            if (Corpus->CountOfInstructions != 0)
+            {
+                Corpus->Instructions[Corpus->CountOfInstructions - 1].Length += Instruction.Length;
+            }
+
+            continue;
+        }
+
+        Instruction.IsInvalid    = strstr(Instruction.Mnemonic, "(bad)") != NULL;
+        Instruction.IsLonePrefix = TestIsLonePrefix(Instruction.Mnemonic);
+
+        TestCorpusAddInstruction(Corpus, &Instruction);
+    }
+
+    return pclose(Output) == 0;
+}
+
+/**
+ * @brief Free the corpus
+ *
+ * @param Corpus
+ *
+ * @return VOID
+ */
+static VOID
+TestCorpusFree(PTEST_CORPUS Corpus)
+{
+    free(Corpus->Bytes);
+    free(Corpus->Instructions);
+    RtlZeroMemory(Corpus, sizeof(TEST_CORPUS));
+}
+
+//////////////////////////////////////////////////
+//				      Comparison     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Check whether the reference decoder is known to differ from Zydis
+ * for the instruction
+ * @details objdump merges fwait (9B) with the next x87 instruction and uses
+ * 16-bit offsets for near branches with the operand-size prefix in 64-bit
+ * mode (Zydis and Intel ignore the prefix)
+ *
+ * @param Bytes
+ * @param Length
+ * @param Is32Bit
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsReferenceInconclusive(BYTE * Bytes, UINT32 Length, BOOLEAN Is32Bit)
+{
+    UINT32  Offset         = 0;
+    BOOLEAN HasOperandSize = FALSE;
+
+    while (Offset < Length)
+    {
+        BYTE Byte = Bytes[Offset];
+
+        if (Byte == 0x66)
+        {
+            HasOperandSize = TRUE;
+        }
+        else if (!(Byte == 0x67 || Byte == 0xf0 || Byte == 0xf2 || Byte == 0xf3 || Byte == 0x26 ||
+                   Byte == 0x2e || Byte == 0x36 || Byte == 0x3e || Byte == 0x64 || Byte == 0x65 ||
+                   (!Is32Bit && (Byte & 0xf0) == 0x40)))
+        {
+            break;
+        }
+
+        Offset++;
+    }
+
+    if (Offset >= Length)
+    {
+        return FALSE;
+    }
+
+    if (Bytes[Offset] == 0x9b)
+    {
+        return TRUE;
+    }
+
+    if (!Is32Bit && HasOperandSize &&
+        (Bytes[Offset] == 0xe8 || Bytes[Offset] == 0xe9 ||
+         (Bytes[Offset] == 0x0f && Offset + 1 < Length && (Bytes[Offset + 1] & 0xf0) == 0x80)))
+    {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Show the bytes of a failed instruction
+ *
+ * @param Name
+ * @param Bytes
+ * @param Length
+ * @param Decoded
+ * @param Reference
+ *
+ * @return VOID
+ */
+static VOID
+TestShowFailure(const char * Name, BYTE * Bytes, UINT32 Length, UINT32 Decoded, PTEST_REFERENCE_INSTRUCTION Reference)
+{
+    fprintf(stderr, "%s: mismatch:", Name);
+
+    for (UINT32 i = 0; i < Length; i++)
+    {
+        fprintf(stderr, " %02x", Bytes[i]);
+    }
+
+    fprintf(stderr, " => length decoder: %d, reference: %d (%s)\n", Decoded, Reference->Length, Reference->Mnemonic);
+}
+
+/**
+ * @brief Compare the length decoder with a reference instruction
+ *
+ * @param Name
+ * @param Bytes
+ * @param SizeOfBytes Number of bytes that can be read
+ * @param Is32Bit
+ * @param Reference
+ * @param Results
+ *
+ * @return VOID
+ */
+static VOID
+TestCompare(const char * Name, BYTE * Bytes, UINT32 SizeOfBytes, BOOLEAN Is32Bit, PTEST_REFERENCE_INSTRUCTION Reference, PTEST_RESULTS Results)
+{
+    UINT32 Length = LengthDisassemblerGetInstructionLength(Bytes, SizeOfBytes, Is32Bit);
+
+    if (Length == NULL_ZERO)
+    {
+        Results->Rejected++;
+        return;
+    }
+
+    if (Reference->IsLonePrefix || TestIsReferenceInconclusive(Bytes, Length, Is32Bit))
+    {
+        Results->Inconclusive++;
+        return;
+    }
+
+    if (!Reference->IsInvalid && Reference->Length == Length)
+    {
+        Results->Matched++;
+        return;
+    }
+
+    if (Results->Failed++ < TEST_MAXIMUM_SHOWN_FAILURES)
+    {
+        TestShowFailure(Name, Bytes, SizeOfBytes < LENGTH_DISASSEMBLER_MAXIMUM_LENGTH ? SizeOfBytes : LENGTH_DISASSEMBLER_MAXIMUM_LENGTH, Length, Reference);
+    }
+}
+
+/**
+ * @brief Show the results of a differential run
+ *
+ * @param Name
+ * @param Results
+ *
+ * @return VOID
+ */
+static VOID
+TestShowResults(const char * Name, PTEST_RESULTS Results)
+{
+    UINT64 Total = Results->Matched + Results->Rejected + Results->Inconclusive + Results->Failed;
+
+    printf("%s: %llu instructions, %llu matched, %llu rejected (%.2f%%, handled by Zydis), %llu inconclusive, %llu failed\n",
+           Name,
+           (unsigned long long)Total,
+           (unsigned long long)Results->Matched,
+           (unsigned long long)Results->Rejected,
+           Total ? Results->Rejected * 100.0 / Total : 0.0,
+           (unsigned long long)Results->Inconclusive,
+           (unsigned long long)Results->Failed);
+}
+
+//////////////////////////////////////////////////
+//				      Tests     				//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Check the known encodings
+ *
+ * @return VOID
+ */
+static VOID
+TestKnownEncodings()
+{
+    UINT32 Failed = 0;
+
+    for (SIZE_T i = 0; i < RTL_NUMBER_OF(g_TestKnownEncodings); i++)
+    {
+        BYTE         Bytes[32] = {0};
+        UINT32       Count     = 0;
+        UINT32       Length;
+        const char * Cursor = g_TestKnownEncodings[i].Bytes;
+        unsigned int Byte;
+        int          Consumed;
+
+        while (sscanf(Cursor, "%2x%n", &Byte, &Consumed) == 1)
+        {
+            Bytes[Count++] = (BYTE)Byte;
+            Cursor += Consumed;
+        }
+
+        //
+        // The rest of the buffer is filled with nops, so truncated
+        // instructions are not accepted because of the buffer size
+        //
+        memset(Bytes + Count, 0x90, sizeof(Bytes) - Count);
+
+        Length = LengthDisassemblerGetInstructionLength(Bytes, sizeof(Bytes), g_TestKnownEncodings[i].Is32Bit);
+
+        if (Length != g_TestKnownEncodings[i].Length)
+        {
+            fprintf(stderr, "known encoding (%s-bit) %s => %d, expected %d\n",
+                    g_TestKnownEncodings[i].Is32Bit ? "32" : "64",
+                    g_TestKnownEncodings[i].Bytes,
+                    Length,
+                    g_TestKnownEncodings[i].Length);
+            Failed++;
+        }
+    }
+
+    HOST_CHECK(Failed == 0);
+
+    printf("known encodings: %d encodings checked\n", (int)RTL_NUMBER_OF(g_TestKnownEncodings));
+}
+
+/**
+ * @brief Check the truncated buffers
+ * @details An instruction that doesn't fit in the buffer should be rejected
+ *
+ * @return VOID
+ */
+static VOID
+TestTruncatedBuffers()
+{
+    static const BYTE Instruction[] = {0x48, 0xc7, 0x84, 0x24, 0x00, 0x01, 0x00, 0x00, 0x78, 0x56, 0x34, 0x12};
+
+    HOST_CHECK(LengthDisassemblerGetInstructionLength((PVOID)Instruction, sizeof(Instruction), FALSE) == sizeof(Instruction));
+
+    for (UINT32 i = 0; i < sizeof(Instruction); i++)
+    {
+        HOST_CHECK(LengthDisassemblerGetInstructionLength((PVOID)Instruction, i, FALSE) == NULL_ZERO);
+    }
+
+    printf("truncated buffers: passed\n");
+}
+
+/**
+ * @brief Generate a random sample, biased towards prefixes and escapes
+ *
+ * @param Sample
+ * @param Is32Bit
+ * @param Seed
+ *
+ * @return VOID
+ */
+static VOID
+TestGenerateSample(BYTE * Sample, BOOLEAN Is32Bit, UINT64 * Seed)
+{
+    static const BYTE Prefixes[] = {0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x2e, 0x3e, 0x26, 0x64, 0x65, 0x36};
+    UINT32            Offset     = 0;
+    UINT64            Random     = HostRandom(Seed);
+    UINT32            Count      = (UINT32)(Random % 4);
+
+    for (UINT32 i = 0; i < TEST_SAMPLE_SIZE; i++)
+    {
+        Sample[i] = (BYTE)HostRandom(Seed);
+    }
+
+    for (UINT32 i = 0; i < Count; i++)
+    {
+        Sample[Offset++] = Prefixes[HostRandom(Seed) % sizeof(Prefixes)];
+    }
+
+    if (!Is32Bit && (HostRandom(Seed) % 3) == 0)
+    {
+        Sample[Offset++] = 0x40 | (BYTE)(HostRandom(Seed) & 0xf);
+    }
+
+    switch ((Random >> 8) % 10)
+    {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+        //
+        // One-byte map (the random byte)
+        //
+        break;
+    case 4:
+    case 5:
+    case 6:
+        Sample[Offset++] = 0x0f;
+        break;
+    case 7:
+        Sample[Offset++] = 0x0f;
+        Sample[Offset++] = 0x38;
+        break;
+    case 8:
+        Sample[Offset++] = 0x0f;
+        Sample[Offset++] = 0x3a;
+        break;
+    default:
+    {
+        static const BYTE Escapes[] = {0xc4, 0xc5, 0x62, 0x8f};
+
+        Sample[Offset++] = Escapes[HostRandom(Seed) % sizeof(Escapes)];
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Compare the length decoder with the reference on random samples
+ *
+ * @param Is32Bit
+ * @param CountOfSamples
+ *
+ * @return VOID
+ */
+static VOID
+TestRandomSamples(BOOLEAN Is32Bit, UINT32 CountOfSamples)
+{
+    char         Command[512];
+    char         Path[]  = "/tmp/hyperdbg-length-disassembler-XXXXXX";
+    TEST_CORPUS  Corpus  = {0};
+    TEST_RESULTS Results = {0};
+    UINT64       Seed    = Is32Bit ? 0x32323232 : 0x64646464;
+    BYTE *       Bytes;
+    SIZE_T       Index = 0;
+    FILE *       File;
+    int          Descriptor;
+
+    Bytes = malloc((SIZE_T)CountOfSamples * TEST_SLOT_SIZE);
+    HOST_CHECK(Bytes != NULL);
+
+    memset(Bytes, 0x90, (SIZE_T)CountOfSamples * TEST_SLOT_SIZE);
+
+    for (UINT32 i = 0; i < CountOfSamples; i++)
+    {
+        TestGenerateSample(Bytes + (SIZE_T)i * TEST_SLOT_SIZE, Is32Bit, &Seed);
+    }
+
+    Descriptor = mkstemp(Path);
+    HOST_CHECK(Descriptor >= 0);
+
+    File = fdopen(Descriptor, "wb");
+    HOST_CHECK(File != NULL);
+    HOST_CHECK(fwrite(Bytes, TEST_SLOT_SIZE, CountOfSamples, File) == CountOfSamples);
+    fclose(File);
+
+    snprintf(Command,
+             sizeof(Command),
+             "objdump -D -b binary -m %s -w --insn-width=16 %s",
+             Is32Bit ? "i386" : "i386:x86-64",
+             Path);
+
+    HOST_CHECK(TestRunReferenceDecoder(Command, &Corpus, FALSE));
+    unlink(Path);
+
+    //
+    // Only the instructions that start at the slots are compared
+    //
+    for (UINT32 i = 0; i < CountOfSamples; i++)
+    {
+        UINT64 Address = (UINT64)i * TEST_SLOT_SIZE;
+
+        while (Index < Corpus.CountOfInstructions && Corpus.Instructions[Index].Address < Address)
+        {
+            Index++;
+        }
+
+        if (Index == Corpus.CountOfInstructions || Corpus.Instructions[Index].Address != Address)
+        {
+            //
+            // The reference decoder is not synchronized with the slot
+            //
+            Results.Inconclusive++;
+            continue;
+        }
+
+        TestCompare(Is32Bit ? "random (32-bit)" : "random (64-bit)",
+                    Bytes + Address,
+                    TEST_SAMPLE_SIZE,
+                    Is32Bit,
+                    &Corpus.Instructions[Index],
+                    &Results);
+    }
+
+    TestShowResults(Is32Bit ? "random (32-bit)" : "random (64-bit)", &Results);
+
+    HOST_CHECK(Results.Failed == 0);
+
+    TestCorpusFree(&Corpus);
+    free(Bytes);
+}
+
+/**
+ * @brief Compare the length decoder with the reference on the code of a binary
+ * and measure the decoding time
+ *
+ * @param FileName
+ * @param Is32Bit
+ *
+ * @return VOID
+ */
+static VOID
+TestRealBinary(const char * FileName, BOOLEAN Is32Bit)
+{
+    char         Command[512];
+    TEST_CORPUS  Corpus  = {0};
+    TEST_RESULTS Results = {0};
+    SIZE_T       Offset  = 0;
+    UINT64       StartTime;
+    UINT64       ElapsedTime;
+    UINT64       Checksum = 0;
+
+    if (access(FileName, R_OK) != 0)
+    {
+        printf("%s: not found, skipped\n", FileName);
+        return;
+    }
+
+    snprintf(Command, sizeof(Command), "objdump -d -z -w --insn-width=16 -j .text %s", FileName);
+
+    HOST_CHECK(TestRunReferenceDecoder(Command, &Corpus, TRUE));
+    HOST_CHECK(Corpus.CountOfInstructions != 0);
+
+    //
+    // The bytes after the last instruction are padded, so the length decoder
+    // can always read the maximum length of an instruction
+    //
+    memset(Corpus.Bytes + Corpus.SizeOfBytes, 0xcc, LENGTH_DISASSEMBLER_MAXIMUM_LENGTH);
+
+    for (SIZE_T i = 0; i < Corpus.CountOfInstructions; i++)
+    {
+        TestCompare(FileName,
+                    Corpus.Bytes + Offset,
+                    LENGTH_DISASSEMBLER_MAXIMUM_LENGTH,
+                    Is32Bit,
+                    &Corpus.Instructions[i],
+                    &Results);
+
+        Offset += Corpus.Instructions[i].Length;
+    }
+
+    TestShowResults(FileName, &Results);
+
+    HOST_CHECK(Results.Failed == 0);
+
+    //
+    // Benchmark of the length decoder on the same instructions
+    //
+    StartTime = HostTimeNs();
+
+    for (UINT32 Round = 0; Round < TEST_BENCHMARK_ROUNDS; Round++)
+    {
+        Offset = 0;
+
+        for (SIZE_T i = 0; i < Corpus.CountOfInstructions; i++)
+        {
+            Checksum += LengthDisassemblerGetInstructionLength(Corpus.Bytes + Offset, LENGTH_DISASSEMBLER_MAXIMUM_LENGTH, Is32Bit);
+            Offset += Corpus.Instructions[i].Length;
+        }
+    }
+
+    ElapsedTime = HostTimeNs() - StartTime;
+
+    printf("benchmark: %.1f ns per instruction over %llu instructions (checksum: %llx)\n",
+           (double)ElapsedTime / ((double)Corpus.CountOfInstructions * TEST_BENCHMARK_ROUNDS),
+           (unsigned long long)Corpus.CountOfInstructions,
+           (unsigned long long)Checksum);
+
+    TestCorpusFree(&Corpus);
+}
+
+/**
+ * @brief Main function of the test
+ *
+ * @param argc
+ * @param argv Number of random samples of each mode (optional)
+ *
+ * @return int
+ */
+int
+main(int argc, char ** argv)
+{
+    UINT32 CountOfSamples = TEST_DEFAULT_RANDOM_SAMPLES;
+
+    if (argc > 1)
+    {
+        CountOfSamples = (UINT32)strtoul(argv[1], NULL, 0);
+    }
+
+    TestKnownEncodings();
+    TestTruncatedBuffers();
+
+    g_TestIsReferenceAvailable = system("objdump --version > /dev/null 2>&1") == 0;
+
+    if (!g_TestIsReferenceAvailable)
+    {
+        printf("objdump is not available, the differential tests are skipped\n");
+        printf("all tests passed\n");
+        return 0;
+    }
+
+    TestRandomSamples(FALSE, CountOfSamples);
+    TestRandomSamples(TRUE, CountOfSamples);
+
+    TestRealBinary("/usr/lib/x86_64-linux-gnu/libc.so.6", FALSE);
+    TestRealBinary("/usr/lib/x86_64-linux-gnu/libstdc++.so.6", FALSE);
+    TestRealBinary("/usr/lib32/libc.so.6", TRUE);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the memory mapper on the host
+ * @details The physical memory is simulated by a shared memory file and the
+ * page-tables of the reserved ranges are built inside it, invalidating an
+ * address (invlpg) maps the frame of its page entry (like filling the TLB)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+typedef union _LARGE_INTEGER
+{
+    struct
+    {
+        UINT32 LowPart;
+        LONG   HighPart;
+    };
+
+    LONG64 QuadPart;
+
+} LARGE_INTEGER, PHYSICAL_ADDRESS;
+
+//
+// Paging structures of ia32-doc (only used as members of PAGE_ENTRY)
+//
+typedef UINT64 PML4E_64;
+typedef UINT64 PDPTE_1GB_64;
+typedef UINT64 PDPTE_64;
+typedef UINT64 PDE_2MB_64;
+typedef UINT64 PDE_64;
+typedef UINT64 PTE_64;
+
+#define PAGE_ALIGN(Va)         ((PVOID)((ULONG_PTR)(Va) & ~(PAGE_SIZE - 1)))
+#define SIZE_2_MB              ((SIZE_T)(512 * PAGE_SIZE))
+#define MEMORY_TYPE_WRITE_BACK 0x00000006
+
+//
+// Processes are not simulated (the functions of the target processes fail)
+//
+typedef LONG   NTSTATUS;
+typedef PVOID  PEPROCESS;
+typedef UINT64 KAPC_STATE;
+
+#define STATUS_SUCCESS         ((NTSTATUS)0)
+#define STATUS_UNSUCCESSFUL    ((NTSTATUS)0xC0000001)
+#define NT_SUCCESS(Status)     (((NTSTATUS)(Status)) >= 0)
+#define MEM_COMMIT             0x00001000
+#define MEM_RESERVE            0x00002000
+#define MEM_RELEASE            0x00008000
+#define PAGE_EXECUTE_READWRITE 0x40
+
+#define NtCurrentProcess()                     ((HANDLE)(ULONG_PTR)-1)
+#define PsGetCurrentProcessId()                ((HANDLE)(ULONG_PTR)4)
+#define PsLookupProcessByProcessId(Id, Process) (*(Process) = NULL, STATUS_UNSUCCESSFUL)
+#define KeStackAttachProcess(Process, State)   ((VOID)(Process), (VOID)(State))
+#define KeUnstackDetachProcess(State)          ((VOID)(State))
+#define ObDereferenceObject(Object)            ((VOID)(Object))
+#define ZwAllocateVirtualMemory(Process, Base, ZeroBits, Size, Type, Protect) ((VOID)(Size), STATUS_UNSUCCESSFUL)
+#define ZwFreeVirtualMemory(Process, Base, Size, Type)                        ((VOID)(Size), STATUS_UNSUCCESSFUL)
+
+//
+// Exceptions are not simulated
+//
+#define EXCEPTION_EXECUTE_HANDLER 1
+#define __try                     if (TRUE)
+#define __except(Filter)          else
+
+typedef struct _VIRTUAL_MACHINE_STATE VIRTUAL_MACHINE_STATE;
+
+/**
+ * @brief The MTRR map of EPT (only checked to be built)
+ *
+ */
+typedef struct _EPT_STATE
+{
+    UINT32 NumberOfEnabledMemoryRanges;
+
+} EPT_STATE;
+
+extern EPT_STATE *     g_EptState;
+extern __thread ULONG  g_TestCurrentCore;
+extern __thread UINT64 g_TestCurrentCr3;
+extern ULONG           g_TestNumberOfCores;
+extern UINT8 *         g_TestPhysicalMemory;
+extern UINT64          g_TestPhysicalMemorySize;
+
+#define KeGetCurrentProcessorNumberEx(Number) (g_TestCurrentCore)
+#define KeQueryActiveProcessorCount(Affinity) (g_TestNumberOfCores)
+#define __readcr3()                           (g_TestCurrentCr3)
+#define __writecr3(Cr3)                       (g_TestCurrentCr3 = (Cr3))
+#define __invvpid_addr(Vpid, Address)         ((VOID)(Vpid), (VOID)(Address))
+
+//
+// Implemented by the test
+//
+PVOID
+MmAllocateMappingAddress(SIZE_T NumberOfBytes, ULONG PoolTag);
+
+VOID
+MmFreeMappingAddress(PVOID BaseAddress, ULONG PoolTag);
+
+VOID
+__invlpg(PVOID Address);
+
+UINT64
+VirtualAddressToPhysicalAddress(PVOID VirtualAddress);
+
+UINT8
+EptGetMemoryType(SIZE_T PageFrameNumber, BOOLEAN IsLargePage);
+
+BOOLEAN
+EptIsValidForLargePage(SIZE_T PageFrameNumber);
+
+static inline PVOID
+PlatformMemAllocateZeroedNonPagedPool(SIZE_T NumberOfBytes)
+{
+    return calloc(1, NumberOfBytes);
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    free(BufferAddress);
+}
+
+static inline UINT64
+PhysicalAddressToVirtualAddress(UINT64 PhysicalAddress)
+{
+    if (PhysicalAddress >= g_TestPhysicalMemorySize)
+    {
+        return (UINT64)NULL;
+    }
+
+    return (UINT64)(g_TestPhysicalMemory + PhysicalAddress);
+}
+
+static inline UINT64
+VirtualAddressToPhysicalAddressByProcessId(PVOID VirtualAddress, UINT32 ProcessId)
+{
+    UNREFERENCED_PARAMETER(ProcessId);
+
+    return VirtualAddressToPhysicalAddress(VirtualAddress);
+}
+
+static inline UINT64
+VirtualAddressToPhysicalAddressByProcessCr3(PVOID VirtualAddress, CR3_TYPE TargetCr3)
+{
+    UNREFERENCED_PARAMETER(TargetCr3);
+
+    return VirtualAddressToPhysicalAddress(VirtualAddress);
+}
+
+static inline CR3_TYPE
+LayoutGetCurrentProcessCr3()
+{
+    CR3_TYPE Cr3;
+
+    Cr3.Flags = g_TestCurrentCr3;
+
+    return Cr3;
+}
+
+static inline CR3_TYPE
+SwitchToProcessMemoryLayoutByCr3(CR3_TYPE TargetCr3)
+{
+    CR3_TYPE PreviousCr3;
+
+    PreviousCr3.Flags = g_TestCurrentCr3;
+    g_TestCurrentCr3  = TargetCr3.Flags;
+
+    return PreviousCr3;
+}
+
+static inline VOID
+SwitchToPreviousProcess(CR3_TYPE PreviousProcess)
+{
+    g_TestCurrentCr3 = PreviousProcess.Flags;
+}
+
+//
+// The guest translations are not cached in the test
+//
+static inline BOOLEAN
+TranslationCacheTranslate(CR3_TYPE Cr3, UINT64 VirtualAddress, PUINT64 PhysicalAddress, PUINT64 Permissions)
+{
+    UNREFERENCED_PARAMETER(Cr3);
+    UNREFERENCED_PARAMETER(VirtualAddress);
+    UNREFERENCED_PARAMETER(PhysicalAddress);
+    UNREFERENCED_PARAMETER(Permissions);
+
+    return FALSE;
+}
+
+static inline VOID
+TranslationCacheInvalidate()
+{
+}
+
+//////////////////////////////////////////////////
+//   Exported functions (HyperDbgVmmImports.h)  //
+//////////////////////////////////////////////////
+
+// ----------------------------------------------------------------------------
+// PTE-related Functions
+//
+
+PVOID
+MemoryMapperGetPteVa(_In_ PVOID        Va,
+                     _In_ PAGING_LEVEL Level);
+
+PVOID
+MemoryMapperGetPteVaByCr3(_In_ PVOID        Va,
+                          _In_ PAGING_LEVEL Level,
+                          _In_ CR3_TYPE     TargetCr3);
+
+PVOID
+MemoryMapperGetPteVaWithoutSwitchingByCr3(_In_ PVOID        Va,
+                                          _In_ PAGING_LEVEL Level,
+                                          _In_ CR3_TYPE     TargetCr3);
+
+PVOID
+MemoryMapperGetPteVaOnTargetProcess(_In_ PVOID        Va,
+                                    _In_ PAGING_LEVEL Level);
+
+PVOID
+MemoryMapperSetExecuteDisableToPteOnTargetProcess(_In_ PVOID   Va,
+                                                  _In_ BOOLEAN Set);
+
+BOOLEAN
+MemoryMapperCheckPteIsPresentOnTargetProcess(PVOID        Va,
+                                             PAGING_LEVEL Level);
+
+// ----------------------------------------------------------------------------
+// Reading Memory Functions
+//
+BOOLEAN
+MemoryMapperReadMemorySafe(_In_ UINT64   VaAddressToRead,
+                           _Inout_ PVOID BufferToSaveMemory,
+                           _In_ SIZE_T   SizeToRead);
+
+BOOLEAN
+MemoryMapperReadMemorySafeByPhysicalAddress(_In_ UINT64    PaAddressToRead,
+                                            _Inout_ UINT64 BufferToSaveMemory,
+                                            _In_ SIZE_T    SizeToRead);
+
+BOOLEAN
+MemoryMapperReadMemorySafeOnTargetProcess(_In_ UINT64   VaAddressToRead,
+                                          _Inout_ PVOID BufferToSaveMemory,
+                                          _In_ SIZE_T   SizeToRead);
+
+// ----------------------------------------------------------------------------
+// Writing Memory Functions
+//
+BOOLEAN
+MemoryMapperWriteMemorySafe(_Inout_ UINT64 Destination,
+                            _In_ PVOID     Source,
+                            _In_ SIZE_T    SizeToWrite,
+                            _In_ CR3_TYPE  TargetProcessCr3);
+
+BOOLEAN
+MemoryMapperWriteMemorySafeOnTargetProcess(_Inout_ UINT64 Destination,
+                                           _In_ PVOID     Source,
+                                           _In_ SIZE_T    Size);
+
+BOOLEAN
+MemoryMapperWriteMemorySafeByPhysicalAddress(_Inout_ UINT64 DestinationPa,
+                                             _In_ UINT64    Source,
+                                             _In_ SIZE_T    SizeToWrite);
+
+BOOLEAN
+MemoryMapperWriteMemoryUnsafe(_Inout_ UINT64 Destination,
+                              _In_ PVOID     Source,
+                              _In_ SIZE_T    SizeToWrite,
+                              _In_ UINT32    TargetProcessId);
+
+// ----------------------------------------------------------------------------
+// Reserving Memory Functions
+//
+UINT64
+MemoryMapperReserveUsermodeAddressOnTargetProcess(_In_ UINT32  ProcessId,
+                                                  _In_ BOOLEAN Allocate);
+
+BOOLEAN
+MemoryMapperFreeMemoryOnTargetProcess(_In_ UINT32   ProcessId,
+                                      _Inout_ PVOID BaseAddress);
+
+// ----------------------------------------------------------------------------
+// Miscellaneous Memory Functions
+//
+BOOLEAN
+MemoryMapperSetSupervisorBitWithoutSwitchingByCr3(_In_ PVOID        Va,
+                                                  _In_ BOOLEAN      Set,
+                                                  _In_ PAGING_LEVEL Level,
+                                                  _In_ CR3_TYPE     TargetCr3);
+
+BOOLEAN
+MemoryMapperCheckIfPageIsNxBitSetOnTargetProcess(_In_ PVOID Va);
+
+BOOLEAN
+MemoryMapperCheckIfPdeIsLargePageOnTargetProcess(_In_ PVOID Va);
+
+#include "../../../hyperhv/header/memory/MemoryMapper.h"
+
+//////////////////////////////////////////////////
+//               Globals (GlobalVariables.h)    //
+//////////////////////////////////////////////////
+
+extern MEMORY_MAPPER_ADDRESSES * g_MemoryMapper;
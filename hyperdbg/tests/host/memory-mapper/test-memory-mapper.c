@@ -0,0 +1,757 @@
+/**
+ * @file test-memory-mapper.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Simulation test and benchmark of the multi-page and the large windows
+ * of the memory mapper
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the simulated physical memory (the first large page frame
+ * keeps the page-tables)
+ *
+ */
+#define TEST_PHYSICAL_MEMORY_SIZE (64 * SIZE_2_MB)
+
+/**
+ * @brief The large page frame that is uncacheable (MMIO)
+ *
+ */
+#define TEST_UNCACHEABLE_FRAME 5
+
+/**
+ * @brief The large page frame that lands on two memory types
+ *
+ */
+#define TEST_MIXED_FRAME 9
+
+/**
+ * @brief The simulated guest virtual range (the pages are scattered in the
+ * physical memory)
+ *
+ */
+#define TEST_GUEST_VA_BASE 0x100000000000ull
+#define TEST_GUEST_PAGES   4096
+
+/**
+ * @brief The page of the guest range that is not mapped
+ *
+ */
+#define TEST_GUEST_UNMAPPED_PAGE 3000
+
+/**
+ * @brief Maximum number of reserved ranges and cached large translations
+ *
+ */
+#define TEST_MAXIMUM_RESERVED_RANGES 16
+#define TEST_MAXIMUM_LARGE_ENTRIES   8
+
+/**
+ * @brief A reserved system range
+ *
+ */
+typedef struct _TEST_RESERVED_RANGE
+{
+    PVOID  Address;
+    SIZE_T Size;
+
+} TEST_RESERVED_RANGE;
+
+MEMORY_MAPPER_ADDRESSES * g_MemoryMapper;
+EPT_STATE *               g_EptState;
+
+__thread ULONG  g_TestCurrentCore;
+__thread UINT64 g_TestCurrentCr3;
+ULONG           g_TestNumberOfCores = 1;
+UINT8 *         g_TestPhysicalMemory;
+UINT64          g_TestPhysicalMemorySize = TEST_PHYSICAL_MEMORY_SIZE;
+
+EPT_STATE g_TestEptState;
+int       g_TestPhysicalMemoryFile;
+UINT64    g_TestNextPageTable;
+UINT64    g_TestGuestPages[TEST_GUEST_PAGES];
+UINT64    g_TestInvalidations;
+UINT64    g_TestLargeFrames;
+
+TEST_RESERVED_RANGE g_TestReservedRanges[TEST_MAXIMUM_RESERVED_RANGES];
+UINT64              g_TestLargeEntries[TEST_MAXIMUM_LARGE_ENTRIES];
+
+//////////////////////////////////////////////////
+//				  Simulated Platform   			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Get the entry of the paging structure that maps the address (and
+ * optionally allocate the paging structures on the way)
+ *
+ * @param Address
+ * @param Level
+ * @param Allocate
+ * @return PPAGE_ENTRY
+ */
+static PPAGE_ENTRY
+TestGetPageEntry(UINT64 Address, PAGING_LEVEL Level, BOOLEAN Allocate)
+{
+    UINT64      Table = g_TestCurrentCr3 & ~PAGE_4KB_OFFSET;
+    PPAGE_ENTRY Entry = NULL;
+
+    for (INT32 Current = PagingLevelPageMapLevel4; Current >= (INT32)Level; Current--)
+    {
+        Entry = (PPAGE_ENTRY)(g_TestPhysicalMemory + Table) + ((Address >> (12 + Current * 9)) & 0x1ff);
+
+        if (Current == (INT32)Level)
+        {
+            break;
+        }
+
+        if (!Entry->Fields.Present)
+        {
+            if (!Allocate)
+            {
+                return NULL;
+            }
+
+            HOST_CHECK(g_TestNextPageTable < SIZE_2_MB);
+
+            Entry->Flags                  = 0;
+            Entry->Fields.Present         = 1;
+            Entry->Fields.Write           = 1;
+            Entry->Fields.PageFrameNumber = g_TestNextPageTable >> 12;
+
+            g_TestNextPageTable += PAGE_SIZE;
+        }
+
+        if (Entry->Fields.LargePage)
+        {
+            return Entry;
+        }
+
+        Table = (UINT64)Entry->Fields.PageFrameNumber << 12;
+    }
+
+    return Entry;
+}
+
+/**
+ * @brief Map a frame of the physical memory into the host address (or make
+ * it inaccessible)
+ *
+ * @param Address
+ * @param Size
+ * @param PhysicalAddress
+ * @param Present
+ * @return VOID
+ */
+static VOID
+TestMapHostAddress(UINT64 Address, SIZE_T Size, UINT64 PhysicalAddress, BOOLEAN Present)
+{
+    PVOID Result;
+
+    if (Present)
+    {
+        HOST_CHECK(PhysicalAddress + Size <= TEST_PHYSICAL_MEMORY_SIZE);
+
+        Result = mmap((PVOID)Address, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, g_TestPhysicalMemoryFile, PhysicalAddress);
+    }
+    else
+    {
+        Result = mmap((PVOID)Address, Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    }
+
+    HOST_CHECK(Result == (PVOID)Address);
+}
+
+/**
+ * @brief Reserve a range of system addresses (the page-tables of the range
+ * are built with non-present entries)
+ *
+ * @param NumberOfBytes
+ * @param PoolTag
+ * @return PVOID
+ */
+PVOID
+MmAllocateMappingAddress(SIZE_T NumberOfBytes, ULONG PoolTag)
+{
+    PVOID Address;
+
+    UNREFERENCED_PARAMETER(PoolTag);
+
+    Address = mmap(NULL, NumberOfBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    HOST_CHECK(Address != MAP_FAILED);
+
+    for (UINT64 Page = 0; Page < NumberOfBytes; Page += PAGE_SIZE)
+    {
+        HOST_CHECK(TestGetPageEntry((UINT64)Address + Page, PagingLevelPageTable, TRUE) != NULL);
+    }
+
+    for (UINT32 i = 0; i < TEST_MAXIMUM_RESERVED_RANGES; i++)
+    {
+        if (g_TestReservedRanges[i].Address == NULL)
+        {
+            g_TestReservedRanges[i].Address = Address;
+            g_TestReservedRanges[i].Size    = NumberOfBytes;
+
+            return Address;
+        }
+    }
+
+    HOST_CHECK(FALSE);
+
+    return NULL;
+}
+
+/**
+ * @brief Free a reserved range
+ *
+ * @param BaseAddress
+ * @param PoolTag
+ * @return VOID
+ */
+VOID
+MmFreeMappingAddress(PVOID BaseAddress, ULONG PoolTag)
+{
+    UNREFERENCED_PARAMETER(PoolTag);
+
+    for (UINT32 i = 0; i < TEST_MAXIMUM_RESERVED_RANGES; i++)
+    {
+        if (g_TestReservedRanges[i].Address == BaseAddress)
+        {
+            //
+            // The range should not be mapped anymore
+            //
+            for (UINT64 Page = 0; Page < g_TestReservedRanges[i].Size; Page += PAGE_SIZE)
+            {
+                PPAGE_ENTRY Entry = TestGetPageEntry((UINT64)BaseAddress + Page, PagingLevelPageTable, FALSE);
+
+                HOST_CHECK(Entry != NULL && !Entry->Fields.LargePage);
+            }
+
+            munmap(BaseAddress, g_TestReservedRanges[i].Size);
+
+            g_TestReservedRanges[i].Address = NULL;
+
+            return;
+        }
+    }
+
+    HOST_CHECK(FALSE);
+}
+
+/**
+ * @brief Invalidate the translation of an address, the translation is filled
+ * again from the page-tables (a cached large translation is removed entirely)
+ *
+ * @param Address
+ * @return VOID
+ */
+VOID
+__invlpg(PVOID Address)
+{
+    UINT64      Page      = (UINT64)Address & ~PAGE_4KB_OFFSET;
+    UINT64      LargePage = (UINT64)Address & ~PAGE_2MB_OFFSET;
+    PPAGE_ENTRY Entry;
+
+    g_TestInvalidations++;
+
+    for (UINT32 i = 0; i < TEST_MAXIMUM_LARGE_ENTRIES; i++)
+    {
+        if (g_TestLargeEntries[i] == LargePage)
+        {
+            g_TestLargeEntries[i] = 0;
+
+            //
+            // Fill the small pages of the removed large translation
+            //
+            TestMapHostAddress(LargePage, SIZE_2_MB, 0, FALSE);
+
+            for (UINT64 SmallPage = LargePage; SmallPage < LargePage + SIZE_2_MB; SmallPage += PAGE_SIZE)
+            {
+                Entry = TestGetPageEntry(SmallPage, PagingLevelPageTable, FALSE);
+
+                if (Entry != NULL && Entry->Fields.Present && !Entry->Fields.LargePage)
+                {
+                    TestMapHostAddress(SmallPage, PAGE_SIZE, (UINT64)Entry->Fields.PageFrameNumber << 12, TRUE);
+                }
+            }
+
+            return;
+        }
+    }
+
+    Entry = TestGetPageEntry(Page, PagingLevelPageDirectory, FALSE);
+    HOST_CHECK(Entry != NULL);
+
+    if (Entry->Fields.Present && Entry->Fields.LargePage)
+    {
+        UINT64 Frame = (UINT64)Entry->Fields.PageFrameNumber << 12;
+
+        HOST_CHECK((Frame & PAGE_2MB_OFFSET) == 0);
+
+        TestMapHostAddress(LargePage, SIZE_2_MB, Frame, TRUE);
+
+        g_TestLargeFrames |= 1ull << (Frame / SIZE_2_MB);
+
+        for (UINT32 i = 0; i < TEST_MAXIMUM_LARGE_ENTRIES; i++)
+        {
+            if (g_TestLargeEntries[i] == 0)
+            {
+                g_TestLargeEntries[i] = LargePage;
+                return;
+            }
+        }
+
+        HOST_CHECK(FALSE);
+    }
+
+    Entry = TestGetPageEntry(Page, PagingLevelPageTable, FALSE);
+    HOST_CHECK(Entry != NULL);
+
+    TestMapHostAddress(Page, PAGE_SIZE, (UINT64)Entry->Fields.PageFrameNumber << 12, Entry->Fields.Present);
+}
+
+/**
+ * @brief Translate the simulated guest virtual addresses
+ *
+ * @param VirtualAddress
+ * @return UINT64
+ */
+UINT64
+VirtualAddressToPhysicalAddress(PVOID VirtualAddress)
+{
+    UINT64 Page = ((UINT64)VirtualAddress - TEST_GUEST_VA_BASE) >> 12;
+
+    if ((UINT64)VirtualAddress < TEST_GUEST_VA_BASE || Page >= TEST_GUEST_PAGES)
+    {
+        return 0;
+    }
+
+    if (g_TestGuestPages[Page] == 0)
+    {
+        return 0;
+    }
+
+    return g_TestGuestPages[Page] + ((UINT64)VirtualAddress & PAGE_4KB_OFFSET);
+}
+
+/**
+ * @brief Memory type of the simulated MTRRs
+ *
+ * @param PageFrameNumber
+ * @param IsLargePage
+ * @return UINT8
+ */
+UINT8
+EptGetMemoryType(SIZE_T PageFrameNumber, BOOLEAN IsLargePage)
+{
+    HOST_CHECK(IsLargePage);
+
+    return PageFrameNumber == TEST_UNCACHEABLE_FRAME ? 0 : MEMORY_TYPE_WRITE_BACK;
+}
+
+/**
+ * @brief Whether the large frame lands on a single memory type
+ *
+ * @param PageFrameNumber
+ * @return BOOLEAN
+ */
+BOOLEAN
+EptIsValidForLargePage(SIZE_T PageFrameNumber)
+{
+    return PageFrameNumber != TEST_MIXED_FRAME && PageFrameNumber != 0;
+}
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Create the physical memory, the page-tables and the memory mapper
+ *
+ * @return VOID
+ */
+static VOID
+TestInitialize()
+{
+    UINT64 RandomState = 0x0123456789abcdefull;
+
+    g_TestPhysicalMemoryFile = memfd_create("hyperdbg-physical-memory", 0);
+    HOST_CHECK(g_TestPhysicalMemoryFile >= 0);
+    HOST_CHECK(ftruncate(g_TestPhysicalMemoryFile, TEST_PHYSICAL_MEMORY_SIZE) == 0);
+
+    g_TestPhysicalMemory = mmap(NULL, TEST_PHYSICAL_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, g_TestPhysicalMemoryFile, 0);
+    HOST_CHECK(g_TestPhysicalMemory != MAP_FAILED);
+
+    //
+    // The first page is the PML4 and the data frames are filled randomly
+    //
+    g_TestCurrentCr3    = 0;
+    g_TestNextPageTable = PAGE_SIZE;
+
+    for (UINT64 i = SIZE_2_MB / sizeof(UINT64); i < TEST_PHYSICAL_MEMORY_SIZE / sizeof(UINT64); i++)
+    {
+        ((UINT64 *)g_TestPhysicalMemory)[i] = HostRandom(&RandomState);
+    }
+
+    //
+    // Scatter the pages of the guest range (each page has a distinct physical
+    // page as the stride is coprime with the number of the data pages)
+    //
+    for (UINT64 i = 0; i < TEST_GUEST_PAGES; i++)
+    {
+        g_TestGuestPages[i] = SIZE_2_MB + ((i * 7919) % ((TEST_PHYSICAL_MEMORY_SIZE - SIZE_2_MB) / PAGE_SIZE)) * PAGE_SIZE;
+    }
+
+    g_TestGuestPages[TEST_GUEST_UNMAPPED_PAGE] = 0;
+
+    g_EptState = &g_TestEptState;
+
+    MemoryMapperInitialize();
+
+    HOST_CHECK(g_MemoryMapper != NULL && g_MemoryMapper[0].VirtualAddressForRange != 0);
+    HOST_CHECK(g_MemoryMapper[0].PdeVirtualAddressForLargeRange != 0);
+}
+
+/**
+ * @brief Free the memory mapper and the physical memory
+ *
+ * @return VOID
+ */
+static VOID
+TestUninitialize()
+{
+    MEMORY_MAPPER_ADDRESSES * MemoryMapper = g_MemoryMapper;
+
+    MemoryMapperUninitialize();
+    free(MemoryMapper);
+
+    munmap(g_TestPhysicalMemory, TEST_PHYSICAL_MEMORY_SIZE);
+    close(g_TestPhysicalMemoryFile);
+}
+
+/**
+ * @brief Get a random size (mostly small, sometimes larger than the window
+ * or a large page)
+ *
+ * @param RandomState
+ * @return SIZE_T
+ */
+static SIZE_T
+TestRandomSize(UINT64 * RandomState)
+{
+    switch (HostRandom(RandomState) % 8)
+    {
+    case 0:
+        return 1 + HostRandom(RandomState) % (3 * SIZE_2_MB);
+    case 1:
+    case 2:
+        return 1 + HostRandom(RandomState) % (MEMORY_MAPPER_RANGE_PAGES * PAGE_SIZE * 2);
+    default:
+        return 1 + HostRandom(RandomState) % (PAGE_SIZE * 2);
+    }
+}
+
+/**
+ * @brief Whether the mapper doesn't keep any mapping
+ *
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsUnmapped()
+{
+    PPAGE_ENTRY Pde = (PPAGE_ENTRY)g_MemoryMapper[0].PdeVirtualAddressForLargeRange;
+
+    if (g_MemoryMapper[0].IsLargeRangeMapped || Pde->Fields.LargePage || g_MemoryMapper[0].MappedPagesInRange != 0)
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < MEMORY_MAPPER_RANGE_PAGES; i++)
+    {
+        if (((PPAGE_ENTRY)g_MemoryMapper[0].PteVirtualAddressesForRange[i])->Fields.Present)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Random reads and writes of the physical memory (crossing the pages,
+ * the window and the large frames)
+ *
+ * @return VOID
+ */
+static VOID
+TestPhysicalAccesses()
+{
+    UINT64  RandomState = 0x1111;
+    UINT8 * Buffer      = malloc(3 * SIZE_2_MB);
+    UINT64  Bytes       = 0;
+
+    HOST_CHECK(Buffer != NULL);
+
+    for (UINT32 Step = 0; Step < 4000; Step++)
+    {
+        SIZE_T Size = TestRandomSize(&RandomState);
+
+        if (HostRandom(&RandomState) & 1)
+        {
+            UINT64 Address = HostRandom(&RandomState) % (TEST_PHYSICAL_MEMORY_SIZE - Size);
+
+            HOST_CHECK(MemoryMapperReadMemorySafeByPhysicalAddress(Address, (UINT64)Buffer, Size));
+            HOST_CHECK(memcmp(Buffer, g_TestPhysicalMemory + Address, Size) == 0);
+        }
+        else
+        {
+            //
+            // The first large frame keeps the page-tables
+            //
+            UINT64 Address = SIZE_2_MB + HostRandom(&RandomState) % (TEST_PHYSICAL_MEMORY_SIZE - SIZE_2_MB - Size);
+
+            for (SIZE_T i = 0; i < Size; i++)
+            {
+                Buffer[i] = (UINT8)HostRandom(&RandomState);
+            }
+
+            HOST_CHECK(MemoryMapperWriteMemorySafeByPhysicalAddress(Address, (UINT64)Buffer, Size));
+            HOST_CHECK(memcmp(Buffer, g_TestPhysicalMemory + Address, Size) == 0);
+        }
+
+        HOST_CHECK(TestIsUnmapped());
+
+        Bytes += Size;
+    }
+
+    free(Buffer);
+
+    printf("physical: 4000 random reads/writes (%llu MB) matched the physical memory\n", (unsigned long long)(Bytes >> 20));
+}
+
+/**
+ * @brief Random reads and writes of the scattered guest virtual range
+ *
+ * @return VOID
+ */
+static VOID
+TestVirtualAccesses()
+{
+    UINT64  RandomState = 0x2222;
+    UINT8 * Buffer      = malloc(TEST_GUEST_PAGES * PAGE_SIZE);
+    UINT32  Failed      = 0;
+    CR3_TYPE Cr3        = {0};
+
+    HOST_CHECK(Buffer != NULL);
+
+    for (UINT32 Step = 0; Step < 4000; Step++)
+    {
+        SIZE_T  Size     = 1 + HostRandom(&RandomState) % (MEMORY_MAPPER_RANGE_PAGES * PAGE_SIZE * 3);
+        UINT64  Offset   = HostRandom(&RandomState) % (TEST_GUEST_PAGES * PAGE_SIZE - Size);
+        UINT64  Address  = TEST_GUEST_VA_BASE + Offset;
+        BOOLEAN IsWrite  = HostRandom(&RandomState) & 1;
+        BOOLEAN Expected = Offset + Size <= TEST_GUEST_UNMAPPED_PAGE * PAGE_SIZE ||
+                           Offset >= (TEST_GUEST_UNMAPPED_PAGE + 1) * PAGE_SIZE;
+        BOOLEAN Result;
+
+        //
+        // Multi-page accesses only (single pages are accessed by the other windows)
+        //
+        if ((Offset & PAGE_4KB_OFFSET) + Size <= PAGE_SIZE)
+        {
+            continue;
+        }
+
+        if (IsWrite)
+        {
+            for (SIZE_T i = 0; i < Size; i++)
+            {
+                Buffer[i] = (UINT8)HostRandom(&RandomState);
+            }
+
+            Result = MemoryMapperWriteMemorySafe(Address, Buffer, Size, Cr3);
+        }
+        else
+        {
+            Result = MemoryMapperReadMemorySafe(Address, Buffer, Size);
+        }
+
+        HOST_CHECK(Result == Expected);
+        HOST_CHECK(TestIsUnmapped());
+
+        if (!Result)
+        {
+            Failed++;
+            continue;
+        }
+
+        //
+        // Compare each page with its physical page
+        //
+        for (UINT64 Done = 0; Done < Size;)
+        {
+            UINT64 Part = PAGE_SIZE - ((Address + Done) & PAGE_4KB_OFFSET);
+
+            Part = Part < Size - Done ? Part : Size - Done;
+
+            HOST_CHECK(memcmp(Buffer + Done, g_TestPhysicalMemory + VirtualAddressToPhysicalAddress((PVOID)(Address + Done)), Part) == 0);
+
+            Done += Part;
+        }
+    }
+
+    free(Buffer);
+
+    printf("virtual: 4000 random reads/writes of scattered pages matched, %u accesses to the unmapped page failed\n", Failed);
+}
+
+/**
+ * @brief Large frames are only mapped by large pages if they are write-back
+ *
+ * @return VOID
+ */
+static VOID
+TestMemoryTypes()
+{
+    UINT8 * Buffer = malloc(SIZE_2_MB);
+
+    HOST_CHECK(Buffer != NULL);
+
+    g_TestLargeFrames = 0;
+
+    for (UINT64 Frame = 0; Frame < TEST_PHYSICAL_MEMORY_SIZE / SIZE_2_MB; Frame++)
+    {
+        HOST_CHECK(MemoryMapperReadMemorySafeByPhysicalAddress(Frame * SIZE_2_MB, (UINT64)Buffer, SIZE_2_MB));
+
+        //
+        // The page-tables of the first frame are changed while it's read
+        //
+        HOST_CHECK(Frame == 0 || memcmp(Buffer, g_TestPhysicalMemory + Frame * SIZE_2_MB, SIZE_2_MB) == 0);
+    }
+
+    HOST_CHECK((g_TestLargeFrames & (1ull << 0)) == 0);
+    HOST_CHECK((g_TestLargeFrames & (1ull << TEST_UNCACHEABLE_FRAME)) == 0);
+    HOST_CHECK((g_TestLargeFrames & (1ull << TEST_MIXED_FRAME)) == 0);
+    HOST_CHECK(__builtin_popcountll(g_TestLargeFrames) == TEST_PHYSICAL_MEMORY_SIZE / SIZE_2_MB - 3);
+
+    //
+    // Without the MTRR map, no large page is used
+    //
+    g_EptState        = NULL;
+    g_TestLargeFrames = 0;
+
+    HOST_CHECK(MemoryMapperReadMemorySafeByPhysicalAddress(SIZE_2_MB * 3, (UINT64)Buffer, SIZE_2_MB));
+    HOST_CHECK(memcmp(Buffer, g_TestPhysicalMemory + SIZE_2_MB * 3, SIZE_2_MB) == 0);
+    HOST_CHECK(g_TestLargeFrames == 0);
+
+    g_EptState = &g_TestEptState;
+
+    free(Buffer);
+
+    printf("memory types: the uncacheable, the mixed and the first frames are mapped by 4KB pages\n");
+}
+
+/**
+ * @brief Compare reading 1MB by single pages, by the multi-page window and
+ * by the large window
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    const SIZE_T Size       = 1 << 20;
+    const UINT32 Rounds     = 64;
+    UINT8 *      Buffer     = malloc(Size);
+    UINT64       Address    = SIZE_2_MB * 2 + 0x800;
+    UINT64       Time[3]    = {0};
+    UINT64       Flushes[3] = {0};
+
+    HOST_CHECK(Buffer != NULL);
+
+    for (UINT32 Mode = 0; Mode < 3; Mode++)
+    {
+        UINT64 Start;
+
+        g_EptState          = Mode == 2 ? &g_TestEptState : NULL;
+        g_TestInvalidations = 0;
+        Start               = HostTimeNs();
+
+        for (UINT32 Round = 0; Round < Rounds; Round++)
+        {
+            if (Mode == 0)
+            {
+                //
+                // Each page is mapped and invalidated separately
+                //
+                for (UINT64 Offset = 0; Offset < Size;)
+                {
+                    UINT64 Part = PAGE_SIZE - ((Address + Offset) & PAGE_4KB_OFFSET);
+
+                    Part = Part < Size - Offset ? Part : Size - Offset;
+
+                    HOST_CHECK(MemoryMapperReadMemorySafeByPhysicalAddress(Address + Offset, (UINT64)Buffer + Offset, Part));
+
+                    Offset += Part;
+                }
+            }
+            else
+            {
+                HOST_CHECK(MemoryMapperReadMemorySafeByPhysicalAddress(Address, (UINT64)Buffer, Size));
+            }
+        }
+
+        Time[Mode]    = HostTimeNs() - Start;
+        Flushes[Mode] = g_TestInvalidations / Rounds;
+
+        HOST_CHECK(memcmp(Buffer, g_TestPhysicalMemory + Address, Size) == 0);
+    }
+
+    g_EptState = &g_TestEptState;
+
+    printf("benchmark: reading 1MB by single pages %.1f us (%llu invalidations), by the window %.1f us (%llu invalidations), "
+           "by the large window %.1f us (%llu invalidations)\n",
+           (double)Time[0] / Rounds / 1000,
+           (unsigned long long)Flushes[0],
+           (double)Time[1] / Rounds / 1000,
+           (unsigned long long)Flushes[1],
+           (double)Time[2] / Rounds / 1000,
+           (unsigned long long)Flushes[2]);
+
+    HOST_CHECK(Flushes[2] < Flushes[1] && Flushes[1] <= Flushes[0]);
+
+    free(Buffer);
+}
+
+int
+main()
+{
+    TestInitialize();
+
+    TestPhysicalAccesses();
+    TestVirtualAccesses();
+    TestMemoryTypes();
+    TestBenchmark();
+
+    TestUninitialize();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
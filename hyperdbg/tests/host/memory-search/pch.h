@@ -0,0 +1,81 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the memory search engine on the host
+ * @details The searched memory is a buffer of the test, the non-present
+ * pages are inaccessible and the results are collected by the test
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define UNALIGNED
+#define PAGE_ALIGN(Va) ((PVOID)((ULONG_PTR)(Va) & ~(PAGE_SIZE - 1)))
+
+static inline UCHAR
+_BitScanForward64(ULONG * Index, UINT64 Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+
+    *Index = (ULONG)__builtin_ctzll(Mask);
+
+    return 1;
+}
+
+//
+// Implemented by the test
+//
+BOOLEAN
+CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size);
+
+UINT64
+VirtualAddressToPhysicalAddress(PVOID VirtualAddress);
+
+BOOLEAN
+MemoryMapperReadMemorySafe(UINT64 VaAddressToRead, PVOID BufferToSaveMemory, SIZE_T SizeToRead);
+
+VOID
+TestReportResult(UINT64 Address);
+
+//
+// The results are collected by the test (instead of being sent as messages)
+//
+#define Log(Format, Address) TestReportResult(Address)
+#define LogInfo(Format, ...) printf(Format, ##__VA_ARGS__)
+
+static inline PVOID
+PlatformMemAllocateNonPagedPool(SIZE_T NumberOfBytes)
+{
+    return malloc(NumberOfBytes);
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    free(BufferAddress);
+}
+
+#include "../../../hyperkd/header/debugger/commands/MemorySearch.h"
+
+//////////////////////////////////////////////////
+//               Globals (Global.h)             //
+//////////////////////////////////////////////////
+
+extern UCHAR * g_MemorySearchBuffer;
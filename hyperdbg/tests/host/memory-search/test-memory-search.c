@@ -0,0 +1,444 @@
+/**
+ * @file test-memory-search.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Model test and benchmark of the memory search engine
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <sys/mman.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the searched memory
+ *
+ */
+#define TEST_MEMORY_SIZE (64 << 20)
+
+/**
+ * @brief Size of the memory of the model test (bytes are from a small
+ * alphabet, so there are many candidates and matches)
+ *
+ */
+#define TEST_MODEL_MEMORY_SIZE (1 << 20)
+
+/**
+ * @brief Each page with this remainder (of the page number) is not present
+ *
+ */
+#define TEST_HOLE_PERIOD    37
+#define TEST_HOLE_REMAINDER 11
+
+/**
+ * @brief The simulated physical address of the memory
+ *
+ */
+#define TEST_PHYSICAL_BASE 0x100000
+
+UCHAR * g_MemorySearchBuffer;
+
+UINT8 * g_TestMemory;
+UINT64  g_TestResults[MaximumSearchResults + 1];
+UINT32  g_TestCountOfResults;
+
+//////////////////////////////////////////////////
+//				  Simulated Platform   			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Whether the page is present or not
+ *
+ * @param Address
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsPresent(UINT64 Address)
+{
+    UINT64 Page;
+
+    if (Address < (UINT64)g_TestMemory || Address >= (UINT64)g_TestMemory + TEST_MEMORY_SIZE)
+    {
+        return FALSE;
+    }
+
+    Page = (Address - (UINT64)g_TestMemory) >> PAGE_SHIFT;
+
+    return Page % TEST_HOLE_PERIOD != TEST_HOLE_REMAINDER;
+}
+
+BOOLEAN
+CheckAccessValidityAndSafety(UINT64 TargetAddress, UINT32 Size)
+{
+    for (UINT64 Page = (UINT64)PAGE_ALIGN(TargetAddress); Page < TargetAddress + Size; Page += PAGE_SIZE)
+    {
+        if (!TestIsPresent(Page))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+UINT64
+VirtualAddressToPhysicalAddress(PVOID VirtualAddress)
+{
+    if (!TestIsPresent((UINT64)VirtualAddress))
+    {
+        return 0;
+    }
+
+    return TEST_PHYSICAL_BASE + ((UINT64)VirtualAddress - (UINT64)g_TestMemory);
+}
+
+BOOLEAN
+MemoryMapperReadMemorySafe(UINT64 VaAddressToRead, PVOID BufferToSaveMemory, SIZE_T SizeToRead)
+{
+    HOST_CHECK(CheckAccessValidityAndSafety(VaAddressToRead, (UINT32)SizeToRead));
+
+    memcpy(BufferToSaveMemory, (PVOID)VaAddressToRead, SizeToRead);
+
+    return TRUE;
+}
+
+VOID
+TestReportResult(UINT64 Address)
+{
+    HOST_CHECK(g_TestCountOfResults < RTL_NUMBER_OF(g_TestResults));
+
+    g_TestResults[g_TestCountOfResults++] = Address;
+}
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Create a search request
+ *
+ * @param ByteSize
+ * @param CountOf64Chunks
+ * @return PDEBUGGER_SEARCH_MEMORY
+ */
+static PDEBUGGER_SEARCH_MEMORY
+TestCreateRequest(DEBUGGER_SEARCH_MEMORY_BYTE_SIZE ByteSize, UINT32 CountOf64Chunks)
+{
+    PDEBUGGER_SEARCH_MEMORY Request = calloc(1, SIZEOF_DEBUGGER_SEARCH_MEMORY + 2 * CountOf64Chunks * sizeof(UINT64));
+
+    HOST_CHECK(Request != NULL);
+
+    Request->ByteSize        = ByteSize;
+    Request->CountOf64Chunks = CountOf64Chunks;
+    Request->MemoryType      = SEARCH_VIRTUAL_MEMORY;
+
+    return Request;
+}
+
+/**
+ * @brief Get the size of chunks of the request
+ *
+ * @param Request
+ * @return UINT32
+ */
+static UINT32
+TestChunkSize(PDEBUGGER_SEARCH_MEMORY Request)
+{
+    switch (Request->ByteSize)
+    {
+    case SEARCH_WORD:
+        return 2;
+    case SEARCH_DWORD:
+        return 4;
+    case SEARCH_QWORD:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Get a byte of the values or the masks of the request
+ *
+ * @param Request
+ * @param IsMask
+ * @param Index
+ * @return PUINT8
+ */
+static PUINT8
+TestPatternByte(PDEBUGGER_SEARCH_MEMORY Request, BOOLEAN IsMask, UINT32 Index)
+{
+    UINT32 ChunkSize = TestChunkSize(Request);
+    PUINT8 Values    = (PUINT8)Request + SIZEOF_DEBUGGER_SEARCH_MEMORY;
+
+    if (IsMask)
+    {
+        Values += Request->CountOf64Chunks * sizeof(UINT64);
+    }
+
+    return &Values[(Index / ChunkSize) * sizeof(UINT64) + Index % ChunkSize];
+}
+
+/**
+ * @brief Search the memory byte by byte (the reference of the engine)
+ *
+ * @param Request
+ * @param Start
+ * @param End
+ * @param Results
+ * @return UINT32 Number of results
+ */
+static UINT32
+TestNaiveSearch(PDEBUGGER_SEARCH_MEMORY Request, UINT64 Start, UINT64 End, UINT64 * Results)
+{
+    UINT32 ChunkSize = TestChunkSize(Request);
+    UINT32 Length    = Request->CountOf64Chunks * ChunkSize;
+    UINT32 Count     = 0;
+
+    for (UINT64 Address = Start; Address < End && Count < MaximumSearchResults; Address += ChunkSize)
+    {
+        UINT32 i;
+
+        for (i = 0; i < Length; i++)
+        {
+            if (!TestIsPresent(Address + i) ||
+                ((*(PUINT8)(Address + i) ^ *TestPatternByte(Request, FALSE, i)) & *TestPatternByte(Request, TRUE, i)) != 0)
+            {
+                break;
+            }
+        }
+
+        if (i == Length)
+        {
+            if (Results != NULL)
+            {
+                Results[Count] = Address;
+            }
+
+            Count++;
+        }
+    }
+
+    return Count;
+}
+
+/**
+ * @brief Search with the engine and compare the results with the reference
+ *
+ * @param Request
+ * @param Start
+ * @param End
+ * @param IsDebuggeePaused
+ * @return UINT32 Number of results
+ */
+static UINT32
+TestSearchAndCompare(PDEBUGGER_SEARCH_MEMORY Request, UINT64 Start, UINT64 End, BOOLEAN IsDebuggeePaused)
+{
+    static UINT64 Reference[MaximumSearchResults];
+    UINT32        CountOfMatchedCases;
+    UINT32        CountOfReference;
+    BOOLEAN       Result;
+
+    g_TestCountOfResults = 0;
+
+    Result           = MemorySearchPerform(Request, Start, End, IsDebuggeePaused, &CountOfMatchedCases);
+    CountOfReference = TestNaiveSearch(Request, Start, End, Reference);
+
+    HOST_CHECK(Result || CountOfMatchedCases == 0);
+    HOST_CHECK(CountOfMatchedCases == g_TestCountOfResults);
+    HOST_CHECK(CountOfMatchedCases == CountOfReference);
+    HOST_CHECK(memcmp(g_TestResults, Reference, CountOfReference * sizeof(UINT64)) == 0);
+
+    return CountOfMatchedCases;
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Random patterns (with wildcards) on random ranges of a memory with
+ * a small alphabet
+ *
+ * @return VOID
+ */
+static VOID
+TestModel()
+{
+    static const UINT8 MaskBytes[] = {0xff, 0xff, 0xff, 0xff, 0x00, 0x0f, 0xf0};
+    UINT64             RandomState = 0x3333;
+    UINT64             Matches     = 0;
+
+    for (UINT64 i = 0; i < TEST_MODEL_MEMORY_SIZE; i++)
+    {
+        if (TestIsPresent((UINT64)g_TestMemory + i))
+        {
+            g_TestMemory[i] = (UINT8)(HostRandom(&RandomState) % 3);
+        }
+    }
+
+    for (UINT32 Step = 0; Step < 3000; Step++)
+    {
+        DEBUGGER_SEARCH_MEMORY_BYTE_SIZE ByteSize = (DEBUGGER_SEARCH_MEMORY_BYTE_SIZE)(HostRandom(&RandomState) % 4);
+        UINT32                           Chunks   = 1 + (UINT32)(HostRandom(&RandomState) % (ByteSize == SEARCH_BYTE ? 8 : 3));
+        PDEBUGGER_SEARCH_MEMORY          Request  = TestCreateRequest(ByteSize, Chunks);
+        UINT32                           Length   = Chunks * TestChunkSize(Request);
+        UINT64                           Start    = (UINT64)g_TestMemory + HostRandom(&RandomState) % (TEST_MODEL_MEMORY_SIZE - 0x10000);
+        UINT64                           End      = Start + 1 + HostRandom(&RandomState) % 0x8000;
+
+        //
+        // The pattern is mostly taken from the memory (to have matches)
+        //
+        for (UINT32 i = 0; i < Length; i++)
+        {
+            *TestPatternByte(Request, FALSE, i) = (UINT8)(HostRandom(&RandomState) % 3);
+            *TestPatternByte(Request, TRUE, i)  = MaskBytes[HostRandom(&RandomState) % RTL_NUMBER_OF(MaskBytes)];
+        }
+
+        Matches += TestSearchAndCompare(Request, Start, End, Step & 1);
+
+        free(Request);
+    }
+
+    printf("model: 3000 random patterns with wildcards matched the naive search (%llu matches)\n", (unsigned long long)Matches);
+}
+
+/**
+ * @brief The search is stopped after MaximumSearchResults results
+ *
+ * @return VOID
+ */
+static VOID
+TestResultsCap()
+{
+    PDEBUGGER_SEARCH_MEMORY Request = TestCreateRequest(SEARCH_BYTE, 1);
+    UINT64                  Start   = (UINT64)g_TestMemory;
+
+    for (UINT64 Page = 0; Page < TEST_MODEL_MEMORY_SIZE; Page += PAGE_SIZE)
+    {
+        if (TestIsPresent(Start + Page))
+        {
+            memset(g_TestMemory + Page, 0x41, PAGE_SIZE);
+        }
+    }
+
+    *TestPatternByte(Request, FALSE, 0) = 0x41;
+    *TestPatternByte(Request, TRUE, 0)  = 0xff;
+
+    for (UINT32 Paused = 0; Paused < 2; Paused++)
+    {
+        HOST_CHECK(TestSearchAndCompare(Request, Start, Start + TEST_MODEL_MEMORY_SIZE, (BOOLEAN)Paused) == MaximumSearchResults);
+    }
+
+    free(Request);
+
+    printf("cap: the search of a filled range is stopped after 0x%x results\n", MaximumSearchResults);
+}
+
+/**
+ * @brief Compare the engine with the naive search on the whole memory
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    UINT64                  RandomState = 0x4444;
+    PDEBUGGER_SEARCH_MEMORY Request     = TestCreateRequest(SEARCH_DWORD, 2);
+    UINT64                  Start       = (UINT64)g_TestMemory;
+    UINT64                  End         = Start + TEST_MEMORY_SIZE;
+    UINT64                  Time[3];
+    UINT32                  Count[3];
+    UINT64                  Begin;
+
+    for (UINT64 i = 0; i < TEST_MEMORY_SIZE; i += sizeof(UINT64))
+    {
+        if (TestIsPresent(Start + i))
+        {
+            *(UINT64 *)(g_TestMemory + i) = HostRandom(&RandomState);
+        }
+    }
+
+    //
+    // The pattern is 'sd ... 9042??8? c3c3c3c3' and a few copies are planted
+    //
+    *(UINT64 *)TestPatternByte(Request, FALSE, 0) = 0x90420080;
+    *(UINT64 *)TestPatternByte(Request, TRUE, 0)  = 0xffff00f0;
+    *(UINT64 *)TestPatternByte(Request, FALSE, 4) = 0xc3c3c3c3;
+    *(UINT64 *)TestPatternByte(Request, TRUE, 4)  = 0xffffffff;
+
+    for (UINT32 i = 0; i < 16; i++)
+    {
+        UINT64 Offset = (HostRandom(&RandomState) % (TEST_MEMORY_SIZE - 8)) & ~3ull;
+
+        if (TestIsPresent(Start + Offset) && TestIsPresent(Start + Offset + 7))
+        {
+            *(UINT32 *)(g_TestMemory + Offset)     = 0x90421185;
+            *(UINT32 *)(g_TestMemory + Offset + 4) = 0xc3c3c3c3;
+        }
+    }
+
+    for (UINT32 Mode = 0; Mode < 2; Mode++)
+    {
+        g_TestCountOfResults = 0;
+        Begin                = HostTimeNs();
+
+        HOST_CHECK(MemorySearchPerform(Request, Start, End, (BOOLEAN)Mode, &Count[Mode]));
+
+        Time[Mode] = HostTimeNs() - Begin;
+    }
+
+    Begin    = HostTimeNs();
+    Count[2] = TestNaiveSearch(Request, Start, End, NULL);
+    Time[2]  = HostTimeNs() - Begin;
+
+    HOST_CHECK(Count[0] == Count[2] && Count[1] == Count[2] && Count[2] != 0);
+
+    printf("benchmark: searching %u MB, engine %.0f MB/s (directly), %.0f MB/s (paused, page reads), "
+           "naive search %.0f MB/s, %u results\n",
+           TEST_MEMORY_SIZE >> 20,
+           (double)TEST_MEMORY_SIZE / 1.048576 / Time[0] * 1000,
+           (double)TEST_MEMORY_SIZE / 1.048576 / Time[1] * 1000,
+           (double)TEST_MEMORY_SIZE / 1.048576 / Time[2] * 1000,
+           Count[2]);
+
+    free(Request);
+}
+
+int
+main()
+{
+    g_TestMemory = mmap(NULL, TEST_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    HOST_CHECK(g_TestMemory != MAP_FAILED);
+
+    //
+    // The non-present pages are inaccessible
+    //
+    for (UINT64 Page = 0; Page < TEST_MEMORY_SIZE; Page += PAGE_SIZE)
+    {
+        if (!TestIsPresent((UINT64)g_TestMemory + Page))
+        {
+            HOST_CHECK(mprotect(g_TestMemory + Page, PAGE_SIZE, PROT_NONE) == 0);
+        }
+    }
+
+    HOST_CHECK(MemorySearchInitialize());
+
+    TestModel();
+    TestResultsCap();
+    TestBenchmark();
+
+    MemorySearchUninitialize();
+    munmap(g_TestMemory, TEST_MEMORY_SIZE);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
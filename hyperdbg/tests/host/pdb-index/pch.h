@@ -0,0 +1,59 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the native PDB reader and the symbol index on the host
+ * @details Only the portable parts (pdb-index.cpp) are compiled, the PDB files
+ * are generated by the test
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+//////////////////////////////////////////////////
+//               Windows Definitions            //
+//////////////////////////////////////////////////
+
+#define UNALIGNED
+
+//
+// The section headers of the PE files (DWORD is 64-bit on Linux, so the
+// fields are defined by the fixed-size types)
+//
+#define IMAGE_SIZEOF_SHORT_NAME 8
+
+typedef struct _IMAGE_SECTION_HEADER
+{
+    BYTE   Name[IMAGE_SIZEOF_SHORT_NAME];
+    union
+    {
+        UINT32 PhysicalAddress;
+        UINT32 VirtualSize;
+    } Misc;
+    UINT32 VirtualAddress;
+    UINT32 SizeOfRawData;
+    UINT32 PointerToRawData;
+    UINT32 PointerToRelocations;
+    UINT32 PointerToLinenumbers;
+    UINT16 NumberOfRelocations;
+    UINT16 NumberOfLinenumbers;
+    UINT32 Characteristics;
+
+} IMAGE_SECTION_HEADER, *PIMAGE_SECTION_HEADER;
+
+//////////////////////////////////////////////////
+//               Symbol Index                   //
+//////////////////////////////////////////////////
+
+#include "../../../symbol-parser/header/pdb-index.h"
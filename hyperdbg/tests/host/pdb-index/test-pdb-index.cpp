@@ -0,0 +1,853 @@
+/**
+ * @file test-pdb-index.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests, fuzzing and benchmark of the native PDB reader and the symbol index
+ * @details The PDB (MSF) files are generated by the test with public and data
+ * symbols, structures, classes and unions (including bit-fields, base classes,
+ * methods and continued field lists)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the blocks of the generated MSF files
+ *
+ */
+#define TEST_BLOCK_SIZE 0x1000
+
+/**
+ * @brief The first type index of the TPI stream
+ *
+ */
+#define TEST_TYPE_INDEX_BEGIN 0x1000
+
+/**
+ * @brief Fields of a field list, the rest of the fields are in a continued list
+ *
+ */
+#define TEST_FIELDS_PER_LIST 20
+
+/**
+ * @brief Streams of the generated PDB files
+ *
+ */
+#define TEST_STREAM_SECTION_HEADERS 4
+#define TEST_STREAM_SYMBOL_RECORDS  5
+#define TEST_COUNT_OF_STREAMS       6
+
+/**
+ * @brief Virtual address of the sections of the generated PDB files
+ *
+ */
+#define TEST_TEXT_SECTION_RVA 0x1000
+#define TEST_DATA_SECTION_RVA 0x800000
+
+/**
+ * @brief Symbol record kinds that are not indexed
+ *
+ */
+#define TEST_S_PROCREF 0x1125
+
+//////////////////////////////////////////////////
+//				   PDB Generation     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Append a value to a buffer
+ *
+ * @param Buffer
+ * @param Value
+ * @return VOID
+ */
+template <typename T>
+static VOID
+TestAppend(std::vector<BYTE> & Buffer, T Value)
+{
+    Buffer.insert(Buffer.end(), (BYTE *)&Value, (BYTE *)&Value + sizeof(T));
+}
+
+/**
+ * @brief Append a null-terminated name to a buffer
+ *
+ * @param Buffer
+ * @param Name
+ * @return VOID
+ */
+static VOID
+TestAppendName(std::vector<BYTE> & Buffer, const string & Name)
+{
+    Buffer.insert(Buffer.end(), Name.begin(), Name.end());
+    Buffer.push_back('\0');
+}
+
+/**
+ * @brief Append a numeric leaf to a buffer
+ *
+ * @param Buffer
+ * @param Value
+ * @return VOID
+ */
+static VOID
+TestAppendNumeric(std::vector<BYTE> & Buffer, UINT32 Value)
+{
+    if (Value < PDB_LF_NUMERIC)
+    {
+        TestAppend<UINT16>(Buffer, (UINT16)Value);
+    }
+    else
+    {
+        TestAppend<UINT16>(Buffer, PDB_LF_ULONG);
+        TestAppend<UINT32>(Buffer, Value);
+    }
+}
+
+/**
+ * @brief Pad a buffer to 4 bytes with the padding leaves
+ *
+ * @param Buffer
+ * @return VOID
+ */
+static VOID
+TestPad(std::vector<BYTE> & Buffer)
+{
+    while (Buffer.size() % 4 != 0)
+    {
+        Buffer.push_back((BYTE)(PDB_LF_PAD0 + (4 - Buffer.size() % 4)));
+    }
+}
+
+/**
+ * @brief Start a CodeView record (the length is set by TestEndRecord)
+ *
+ * @param Kind
+ * @return std::vector<BYTE>
+ */
+static std::vector<BYTE>
+TestBeginRecord(UINT16 Kind)
+{
+    std::vector<BYTE> Record;
+
+    TestAppend<UINT16>(Record, 0);
+    TestAppend<UINT16>(Record, Kind);
+
+    return Record;
+}
+
+/**
+ * @brief Finish a CodeView record and append it to a stream
+ *
+ * @param Stream
+ * @param Record
+ * @return VOID
+ */
+static VOID
+TestEndRecord(std::vector<BYTE> & Stream, std::vector<BYTE> & Record)
+{
+    TestPad(Record);
+
+    *(UINT16 *)Record.data() = (UINT16)(Record.size() - sizeof(UINT16));
+
+    Stream.insert(Stream.end(), Record.begin(), Record.end());
+}
+
+/**
+ * @brief The expected content of a generated PDB file
+ *
+ */
+typedef struct _TEST_PDB
+{
+    std::vector<BYTE>   File;
+    std::vector<string> SymbolNames;
+    std::vector<UINT32> SymbolRvas;
+    UINT32              CountOfTypes;
+
+} TEST_PDB, *PTEST_PDB;
+
+/**
+ * @brief Name of a generated type
+ *
+ * @param Index
+ * @return string
+ */
+static string
+TestTypeName(UINT32 Index)
+{
+    return "_TEST_STRUCT_" + to_string(Index);
+}
+
+/**
+ * @brief Number of fields of a generated type
+ *
+ * @param Index
+ * @return UINT32
+ */
+static UINT32
+TestCountOfFields(UINT32 Index)
+{
+    return 2 + Index % 40;
+}
+
+/**
+ * @brief Offset of a field of a generated type
+ *
+ * @param Index
+ * @param Field
+ * @return UINT32
+ */
+static UINT32
+TestFieldOffset(UINT32 Index, UINT32 Field)
+{
+    //
+    // Large types have the offsets in LF_ULONG leaves
+    //
+    return (Index % 4 == 3) ? 0x10000 + Field * 0x1000 : Field * 8;
+}
+
+/**
+ * @brief Size of a generated type
+ *
+ * @param Index
+ * @return UINT32
+ */
+static UINT32
+TestTypeSize(UINT32 Index)
+{
+    return TestFieldOffset(Index, TestCountOfFields(Index)) + 8;
+}
+
+/**
+ * @brief Append the members of a field list
+ *
+ * @param Record
+ * @param Index Index of the type
+ * @param FirstField
+ * @param LastField
+ * @param BitFieldType
+ * @return VOID
+ */
+static VOID
+TestAppendMembers(std::vector<BYTE> & Record, UINT32 Index, UINT32 FirstField, UINT32 LastField, UINT32 BitFieldType)
+{
+    for (UINT32 i = FirstField; i < LastField; i++)
+    {
+        TestAppend<UINT16>(Record, PDB_LF_MEMBER);
+        TestAppend<UINT16>(Record, 3); // public
+        TestAppend<UINT32>(Record, i == 1 ? BitFieldType : 0x23);
+        TestAppendNumeric(Record, TestFieldOffset(Index, i));
+        TestAppendName(Record, "Field" + to_string(i));
+        TestPad(Record);
+    }
+}
+
+/**
+ * @brief Generate a PDB file
+ *
+ * @param CountOfSymbols
+ * @param CountOfTypes
+ * @param Pdb
+ * @return VOID
+ */
+static VOID
+TestGeneratePdb(UINT32 CountOfSymbols, UINT32 CountOfTypes, PTEST_PDB Pdb)
+{
+    std::vector<std::vector<BYTE>> Streams(TEST_COUNT_OF_STREAMS);
+    std::vector<BYTE>               TypeRecords;
+    std::vector<BYTE>               Record;
+    PDB_DBI_STREAM_HEADER           DbiHeader = {0};
+    PDB_TPI_STREAM_HEADER           TpiHeader = {0};
+    IMAGE_SECTION_HEADER            Sections[2];
+    UINT32                          TypeIndex = TEST_TYPE_INDEX_BEGIN;
+
+    Pdb->SymbolNames.clear();
+    Pdb->SymbolRvas.clear();
+    Pdb->CountOfTypes = CountOfTypes;
+
+    //
+    // Info stream (not used by the reader)
+    //
+    TestAppend<UINT32>(Streams[PDB_STREAM_INFO], 20000404);
+
+    //
+    // Section headers
+    //
+    memset(Sections, 0, sizeof(Sections));
+    memcpy(Sections[0].Name, ".text", 5);
+    memcpy(Sections[1].Name, ".data", 5);
+    Sections[0].VirtualAddress = TEST_TEXT_SECTION_RVA;
+    Sections[1].VirtualAddress = TEST_DATA_SECTION_RVA;
+
+    Streams[TEST_STREAM_SECTION_HEADERS].assign((BYTE *)Sections, (BYTE *)Sections + sizeof(Sections));
+
+    //
+    // Public and data symbols (and some records that are not indexed)
+    //
+    for (UINT32 i = 0; i < CountOfSymbols; i++)
+    {
+        BOOLEAN IsData = (i % 5 == 4);
+        string  Name   = (IsData ? "g_TestData" : "TestFunction") + to_string(i);
+        UINT32  Offset = i * 0x40;
+
+        Record = TestBeginRecord(IsData ? PDB_S_GDATA32 : PDB_S_PUB32);
+        TestAppend<UINT32>(Record, IsData ? 0x23 : 2); // type index or flags
+        TestAppend<UINT32>(Record, Offset);
+        TestAppend<UINT16>(Record, IsData ? 2 : 1);
+        TestAppendName(Record, Name);
+        TestEndRecord(Streams[TEST_STREAM_SYMBOL_RECORDS], Record);
+
+        Pdb->SymbolNames.push_back(Name);
+        Pdb->SymbolRvas.push_back((IsData ? TEST_DATA_SECTION_RVA : TEST_TEXT_SECTION_RVA) + Offset);
+
+        if (i % 7 == 0)
+        {
+            Record = TestBeginRecord(TEST_S_PROCREF);
+            TestAppend<UINT32>(Record, 0);
+            TestAppend<UINT32>(Record, i);
+            TestAppend<UINT16>(Record, 1);
+            TestAppendName(Record, "ProcRef" + to_string(i));
+            TestEndRecord(Streams[TEST_STREAM_SYMBOL_RECORDS], Record);
+        }
+    }
+
+    //
+    // Types, each one has a bit-field type, field lists and a forward reference
+    //
+    for (UINT32 i = 0; i < CountOfTypes; i++)
+    {
+        UINT32 CountOfFields = TestCountOfFields(i);
+        UINT32 BitFieldType;
+        UINT32 ContinuedFieldList = 0;
+        UINT32 FieldList;
+        UINT16 Kind = (i % 3 == 0) ? PDB_LF_STRUCTURE : ((i % 3 == 1) ? PDB_LF_CLASS : PDB_LF_UNION);
+
+        Record = TestBeginRecord(PDB_LF_BITFIELD);
+        TestAppend<UINT32>(Record, 0x75);
+        Record.push_back(1);        // length
+        Record.push_back(i % 32);   // position
+        TestEndRecord(TypeRecords, Record);
+        BitFieldType = TypeIndex++;
+
+        if (CountOfFields > TEST_FIELDS_PER_LIST)
+        {
+            Record = TestBeginRecord(PDB_LF_FIELDLIST);
+            TestAppendMembers(Record, i, TEST_FIELDS_PER_LIST, CountOfFields, BitFieldType);
+            TestEndRecord(TypeRecords, Record);
+            ContinuedFieldList = TypeIndex++;
+        }
+
+        Record = TestBeginRecord(PDB_LF_FIELDLIST);
+
+        if (Kind == PDB_LF_CLASS)
+        {
+            TestAppend<UINT16>(Record, PDB_LF_BCLASS);
+            TestAppend<UINT16>(Record, 3);
+            TestAppend<UINT32>(Record, TEST_TYPE_INDEX_BEGIN);
+            TestAppendNumeric(Record, 0);
+            TestPad(Record);
+
+            TestAppend<UINT16>(Record, PDB_LF_VFUNCTAB);
+            TestAppend<UINT16>(Record, 0);
+            TestAppend<UINT32>(Record, 0x23);
+
+            //
+            // Introducing virtual method (with the virtual base offset)
+            //
+            TestAppend<UINT16>(Record, PDB_LF_ONEMETHOD);
+            TestAppend<UINT16>(Record, 3 | (4 << 2));
+            TestAppend<UINT32>(Record, 0x23);
+            TestAppend<UINT32>(Record, 0);
+            TestAppendName(Record, "VirtualMethod");
+            TestPad(Record);
+
+            TestAppend<UINT16>(Record, PDB_LF_ONEMETHOD);
+            TestAppend<UINT16>(Record, 3);
+            TestAppend<UINT32>(Record, 0x23);
+            TestAppendName(Record, "Method");
+            TestPad(Record);
+
+            TestAppend<UINT16>(Record, PDB_LF_NESTTYPE);
+            TestAppend<UINT16>(Record, 0);
+            TestAppend<UINT32>(Record, 0x23);
+            TestAppendName(Record, "NestedType");
+            TestPad(Record);
+
+            TestAppend<UINT16>(Record, PDB_LF_STMEMBER);
+            TestAppend<UINT16>(Record, 3);
+            TestAppend<UINT32>(Record, 0x23);
+            TestAppendName(Record, "StaticMember");
+            TestPad(Record);
+        }
+
+        TestAppendMembers(Record, i, 0, min(CountOfFields, (UINT32)TEST_FIELDS_PER_LIST), BitFieldType);
+
+        if (ContinuedFieldList != 0)
+        {
+            TestAppend<UINT16>(Record, PDB_LF_INDEX);
+            TestAppend<UINT16>(Record, 0);
+            TestAppend<UINT32>(Record, ContinuedFieldList);
+        }
+
+        TestEndRecord(TypeRecords, Record);
+        FieldList = TypeIndex++;
+
+        //
+        // The forward reference and the definition
+        //
+        for (UINT32 IsDefinition = 0; IsDefinition < 2; IsDefinition++)
+        {
+            Record = TestBeginRecord(Kind);
+            TestAppend<UINT16>(Record, IsDefinition ? (UINT16)CountOfFields : 0);
+            TestAppend<UINT16>(Record, IsDefinition ? 0 : PDB_TYPE_PROPERTY_FORWARD_REFERENCE);
+            TestAppend<UINT32>(Record, IsDefinition ? FieldList : 0);
+
+            if (Kind != PDB_LF_UNION)
+            {
+                TestAppend<UINT32>(Record, 0); // derivation list
+                TestAppend<UINT32>(Record, 0); // vtable shape
+            }
+
+            TestAppendNumeric(Record, IsDefinition ? TestTypeSize(i) : 0);
+            TestAppendName(Record, TestTypeName(i));
+            TestEndRecord(TypeRecords, Record);
+            TypeIndex++;
+        }
+    }
+
+    TpiHeader.Version         = 20040203;
+    TpiHeader.HeaderSize      = sizeof(PDB_TPI_STREAM_HEADER);
+    TpiHeader.TypeIndexBegin  = TEST_TYPE_INDEX_BEGIN;
+    TpiHeader.TypeIndexEnd    = TypeIndex;
+    TpiHeader.TypeRecordBytes = (UINT32)TypeRecords.size();
+    TpiHeader.HashStreamIndex = 0xffff;
+
+    TestAppend(Streams[PDB_STREAM_TPI], TpiHeader);
+    Streams[PDB_STREAM_TPI].insert(Streams[PDB_STREAM_TPI].end(), TypeRecords.begin(), TypeRecords.end());
+
+    //
+    // DBI stream, only the optional debug header (the section headers) is used
+    //
+    DbiHeader.VersionSignature        = -1;
+    DbiHeader.VersionHeader           = 19990903;
+    DbiHeader.SymbolRecordStreamIndex = TEST_STREAM_SYMBOL_RECORDS;
+    DbiHeader.OptionalDebugHeaderSize = 11 * sizeof(UINT16);
+
+    TestAppend(Streams[PDB_STREAM_DBI], DbiHeader);
+
+    for (UINT32 i = 0; i < 11; i++)
+    {
+        TestAppend<UINT16>(Streams[PDB_STREAM_DBI], i == PDB_DBI_DEBUG_HEADER_SECTION_HEADERS ? TEST_STREAM_SECTION_HEADERS : 0xffff);
+    }
+
+    //
+    // Write the MSF file, blocks 1 and 2 are the free block maps, then the
+    // streams, the directory and the block map of the directory
+    //
+    std::vector<UINT32> Directory;
+    UINT32              NextBlock = 3;
+    UINT32              CountOfDirectoryBlocks;
+    UINT32              FirstDirectoryBlock;
+    UINT32              BlockMapBlock;
+    PDB_MSF_SUPER_BLOCK SuperBlock = {{0}};
+
+    Directory.push_back((UINT32)Streams.size());
+
+    for (auto & Stream : Streams)
+    {
+        Directory.push_back((UINT32)Stream.size());
+    }
+
+    for (auto & Stream : Streams)
+    {
+        for (SIZE_T Offset = 0; Offset < Stream.size(); Offset += TEST_BLOCK_SIZE)
+        {
+            Directory.push_back(NextBlock++);
+        }
+    }
+
+    CountOfDirectoryBlocks = (UINT32)((Directory.size() * sizeof(UINT32) + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE);
+    FirstDirectoryBlock    = NextBlock;
+    NextBlock += CountOfDirectoryBlocks;
+    BlockMapBlock = NextBlock++;
+
+    HOST_CHECK(CountOfDirectoryBlocks * sizeof(UINT32) <= TEST_BLOCK_SIZE);
+
+    Pdb->File.assign((SIZE_T)NextBlock * TEST_BLOCK_SIZE, 0);
+
+    memcpy(SuperBlock.FileMagic, PDB_MSF_MAGIC, sizeof(SuperBlock.FileMagic));
+    SuperBlock.BlockSize              = TEST_BLOCK_SIZE;
+    SuperBlock.FreeBlockMapBlock      = 1;
+    SuperBlock.NumberOfBlocks         = NextBlock;
+    SuperBlock.NumberOfDirectoryBytes = (UINT32)(Directory.size() * sizeof(UINT32));
+    SuperBlock.BlockMapAddress        = BlockMapBlock;
+
+    memcpy(Pdb->File.data(), &SuperBlock, sizeof(SuperBlock));
+
+    NextBlock = 3;
+
+    for (auto & Stream : Streams)
+    {
+        for (SIZE_T Offset = 0; Offset < Stream.size(); Offset += TEST_BLOCK_SIZE)
+        {
+            memcpy(&Pdb->File[(SIZE_T)NextBlock++ * TEST_BLOCK_SIZE],
+                   &Stream[Offset],
+                   min((SIZE_T)TEST_BLOCK_SIZE, Stream.size() - Offset));
+        }
+    }
+
+    memcpy(&Pdb->File[(SIZE_T)FirstDirectoryBlock * TEST_BLOCK_SIZE], Directory.data(), Directory.size() * sizeof(UINT32));
+
+    for (UINT32 i = 0; i < CountOfDirectoryBlocks; i++)
+    {
+        ((UINT32 *)&Pdb->File[(SIZE_T)BlockMapBlock * TEST_BLOCK_SIZE])[i] = FirstDirectoryBlock + i;
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Build and attach the index of a PDB image
+ *
+ * @param File The PDB file (copied to an exact-size buffer, so overreads are detected)
+ * @param Size Size of the file
+ * @param Image The image of the index
+ * @param Index The attached index
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestBuildIndex(const BYTE * File, UINT64 Size, std::vector<BYTE> & Image, PPDB_INDEX Index)
+{
+    PDB_MSF_FILE Msf;
+    BYTE *       Copy   = (BYTE *)malloc(Size);
+    BOOLEAN      Result = FALSE;
+
+    HOST_CHECK(Copy != NULL);
+    memcpy(Copy, File, Size);
+
+    if (PdbMsfOpen(Copy, Size, &Msf) && PdbIndexBuild(&Msf, Size, 0, Image))
+    {
+        Result = PdbIndexAttach(Index, Image.data(), Image.size());
+    }
+
+    free(Copy);
+
+    return Result;
+}
+
+/**
+ * @brief Query the index (the results are not checked, used for fuzzing)
+ *
+ * @param Index
+ * @param RandomState
+ * @return VOID
+ */
+static VOID
+TestQueryIndex(PPDB_INDEX Index, UINT64 * RandomState)
+{
+    UINT32       Rva;
+    UINT32       Displacement;
+    UINT32       FieldOffset;
+    UINT64       TypeSize;
+    UINT32       i = (UINT32)(HostRandom(RandomState) % 64);
+    const char * Name;
+
+    PdbIndexLookupSymbol(Index, ("TestFunction" + to_string(i)).c_str(), &Rva);
+    PdbIndexLookupTypeSize(Index, TestTypeName(i).c_str(), &TypeSize);
+    PdbIndexLookupFieldOffset(Index, TestTypeName(i).c_str(), ("Field" + to_string(i % 8)).c_str(), &FieldOffset);
+
+    Name = PdbIndexLookupAddress(Index, (UINT32)HostRandom(RandomState) % (TEST_DATA_SECTION_RVA * 2), &Displacement);
+
+    if (Name != NULL)
+    {
+        HOST_CHECK(strlen(Name) < Index->Header->SizeOfNames);
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Check the symbols and types of a generated PDB in the index
+ *
+ * @return VOID
+ */
+static VOID
+TestLookups()
+{
+    TEST_PDB          Pdb;
+    std::vector<BYTE> Image;
+    PDB_INDEX         Index;
+    UINT32            Rva;
+    UINT32            Displacement;
+    UINT32            FieldOffset;
+    UINT64            TypeSize;
+    string            Name;
+
+    TestGeneratePdb(3000, 300, &Pdb);
+
+    HOST_CHECK(TestBuildIndex(Pdb.File.data(), Pdb.File.size(), Image, &Index));
+    HOST_CHECK(Index.Header->CountOfSymbols == Pdb.SymbolNames.size());
+    HOST_CHECK(Index.Header->CountOfTypes == Pdb.CountOfTypes);
+
+    for (UINT32 i = 0; i < Pdb.SymbolNames.size(); i++)
+    {
+        //
+        // Names are case-insensitive
+        //
+        Name = Pdb.SymbolNames[i];
+        transform(Name.begin(), Name.end(), Name.begin(), ::toupper);
+
+        HOST_CHECK(PdbIndexLookupSymbol(&Index, Name.c_str(), &Rva) && Rva == Pdb.SymbolRvas[i]);
+        HOST_CHECK(Pdb.SymbolNames[i] == PdbIndexLookupAddress(&Index, Pdb.SymbolRvas[i] + 3, &Displacement));
+        HOST_CHECK(Displacement == 3);
+    }
+
+    HOST_CHECK(!PdbIndexLookupSymbol(&Index, "ProcRef0", &Rva));
+    HOST_CHECK(!PdbIndexLookupSymbol(&Index, "TestFunction", &Rva));
+    HOST_CHECK(PdbIndexLookupAddress(&Index, TEST_TEXT_SECTION_RVA - 1, &Displacement) == NULL);
+
+    for (UINT32 i = 0; i < Pdb.CountOfTypes; i++)
+    {
+        HOST_CHECK(PdbIndexLookupTypeSize(&Index, TestTypeName(i).c_str(), &TypeSize) && TypeSize == TestTypeSize(i));
+
+        for (UINT32 j = 0; j < TestCountOfFields(i); j++)
+        {
+            HOST_CHECK(PdbIndexLookupFieldOffset(&Index, TestTypeName(i).c_str(), ("Field" + to_string(j)).c_str(), &FieldOffset));
+
+            //
+            // The bit position is returned for the single-bit fields
+            //
+            HOST_CHECK(FieldOffset == (j == 1 ? i % 32 : TestFieldOffset(i, j)));
+        }
+
+        HOST_CHECK(!PdbIndexLookupFieldOffset(&Index, TestTypeName(i).c_str(), "Method", &FieldOffset));
+    }
+
+    HOST_CHECK(!PdbIndexLookupTypeSize(&Index, "_TEST_STRUCT_", &TypeSize));
+
+    printf("lookups: %u symbols and %u types (with continued field lists and bit-fields) are found\n",
+           (UINT32)Pdb.SymbolNames.size(),
+           Pdb.CountOfTypes);
+}
+
+/**
+ * @brief Malformed MSF headers and directories are rejected
+ *
+ * @return VOID
+ */
+static VOID
+TestMalformedDirectory()
+{
+    TEST_PDB             Pdb;
+    std::vector<BYTE>    File;
+    std::vector<BYTE>    Image;
+    PDB_INDEX            Index;
+    PPDB_MSF_SUPER_BLOCK SuperBlock;
+    UINT32 *             Directory;
+
+    TestGeneratePdb(10, 10, &Pdb);
+
+    SuperBlock = (PPDB_MSF_SUPER_BLOCK)Pdb.File.data();
+    Directory  = (UINT32 *)&Pdb.File[(SIZE_T)((UINT32 *)&Pdb.File[(SIZE_T)SuperBlock->BlockMapAddress * TEST_BLOCK_SIZE])[0] * TEST_BLOCK_SIZE];
+
+    //
+    // The size of the stream wraps the number of blocks in 32-bit
+    //
+    for (UINT32 StreamSize : {0xfffff001u, 0xfffffffeu, 0xffffefffu})
+    {
+        File = Pdb.File;
+
+        ((UINT32 *)&File[(UINT8 *)Directory - Pdb.File.data()])[1 + PDB_STREAM_TPI] = StreamSize;
+
+        HOST_CHECK(!TestBuildIndex(File.data(), File.size(), Image, &Index));
+    }
+
+    //
+    // The size of the directory wraps the number of directory blocks in 32-bit
+    //
+    File = Pdb.File;
+    ((PPDB_MSF_SUPER_BLOCK)File.data())->NumberOfDirectoryBytes = 0xfffffffc;
+
+    HOST_CHECK(!TestBuildIndex(File.data(), File.size(), Image, &Index));
+
+    //
+    // Truncated files
+    //
+    for (UINT64 Size : {(UINT64)0, (UINT64)sizeof(PDB_MSF_SUPER_BLOCK) - 1, (UINT64)Pdb.File.size() - TEST_BLOCK_SIZE})
+    {
+        HOST_CHECK(!TestBuildIndex(Pdb.File.data(), Size, Image, &Index));
+    }
+
+    printf("malformed: wrapped stream and directory sizes and truncated files are rejected\n");
+}
+
+/**
+ * @brief Random mutations of the PDB files and the index images
+ *
+ * @return VOID
+ */
+static VOID
+TestFuzz()
+{
+    static const UINT32 Values[] = {0, 1, 2, 0x7f, 0x80, 0xf1, 0xff, 0x7fff, 0x8000, 0x8004, 0x800a, 0xffff, 0x1000, 0x1203, 0x1404, 0x7fffffff, 0xfffffffe, 0xffffffff};
+    UINT64              RandomState = 0x5555;
+    TEST_PDB            Pdb;
+    std::vector<BYTE>   File;
+    std::vector<BYTE>   Image;
+    std::vector<BYTE>   ValidImage;
+    PDB_INDEX           Index;
+    UINT32              CountOfBuilt    = 0;
+    UINT32              CountOfAttached = 0;
+    UINT32              Iterations      = 20000;
+
+    TestGeneratePdb(64, 64, &Pdb);
+
+    HOST_CHECK(TestBuildIndex(Pdb.File.data(), Pdb.File.size(), ValidImage, &Index));
+
+    for (UINT32 Iteration = 0; Iteration < Iterations; Iteration++)
+    {
+        UINT32 CountOfMutations = 1 + (UINT32)(HostRandom(&RandomState) % 8);
+
+        //
+        // Mutate the PDB file, the mutations are mostly on the type records and
+        // symbols (the first blocks after the super block and the free block maps)
+        //
+        File = Pdb.File;
+
+        for (UINT32 i = 0; i < CountOfMutations; i++)
+        {
+            UINT64 Offset = HostRandom(&RandomState) % (File.size() - sizeof(UINT32));
+
+            if (HostRandom(&RandomState) % 4 != 0)
+            {
+                Offset = 3 * TEST_BLOCK_SIZE + Offset % (File.size() - 3 * TEST_BLOCK_SIZE - sizeof(UINT32));
+            }
+
+            switch (HostRandom(&RandomState) % 3)
+            {
+            case 0:
+                File[Offset] = (BYTE)HostRandom(&RandomState);
+                break;
+            case 1:
+                *(UINT16 *)&File[Offset] = (UINT16)Values[HostRandom(&RandomState) % RTL_NUMBER_OF(Values)];
+                break;
+            default:
+                *(UINT32 *)&File[Offset] = Values[HostRandom(&RandomState) % RTL_NUMBER_OF(Values)];
+                break;
+            }
+        }
+
+        if (HostRandom(&RandomState) % 16 == 0)
+        {
+            File.resize(HostRandom(&RandomState) % File.size());
+        }
+
+        if (TestBuildIndex(File.data(), File.size(), Image, &Index))
+        {
+            CountOfBuilt++;
+            TestQueryIndex(&Index, &RandomState);
+        }
+
+        //
+        // Mutate the index image (e.g., a corrupted index file)
+        //
+        Image = ValidImage;
+
+        for (UINT32 i = 0; i < CountOfMutations; i++)
+        {
+            UINT64 Offset = HostRandom(&RandomState) % (Image.size() - sizeof(UINT32));
+
+            if (i == 0 && HostRandom(&RandomState) % 2 == 0)
+            {
+                Offset = HostRandom(&RandomState) % (sizeof(PDB_INDEX_HEADER) - sizeof(UINT32));
+            }
+
+            *(UINT32 *)&Image[Offset] = (HostRandom(&RandomState) % 2) ? Values[HostRandom(&RandomState) % RTL_NUMBER_OF(Values)] : (UINT32)HostRandom(&RandomState);
+        }
+
+        if (PdbIndexAttach(&Index, Image.data(), Image.size()))
+        {
+            CountOfAttached++;
+            TestQueryIndex(&Index, &RandomState);
+        }
+    }
+
+    HOST_CHECK(CountOfBuilt != 0 && CountOfAttached != 0);
+
+    printf("fuzz: %u mutated PDB files (%u indexed) and index images (%u attached)\n",
+           Iterations,
+           CountOfBuilt,
+           CountOfAttached);
+}
+
+/**
+ * @brief Time of building, attaching and querying the index of a large PDB
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    TEST_PDB          Pdb;
+    std::vector<BYTE> Image;
+    PDB_INDEX         Index;
+    PDB_MSF_FILE      Msf;
+    UINT64            Begin;
+    UINT64            BuildTime;
+    UINT64            AttachTime;
+    UINT64            LookupTime;
+    UINT32            Rva;
+    UINT32            FieldOffset;
+    UINT32            Found = 0;
+
+    TestGeneratePdb(50000, 5000, &Pdb);
+
+    Begin = HostTimeNs();
+    HOST_CHECK(PdbMsfOpen(Pdb.File.data(), Pdb.File.size(), &Msf) && PdbIndexBuild(&Msf, Pdb.File.size(), 0, Image));
+    BuildTime = HostTimeNs() - Begin;
+
+    Begin = HostTimeNs();
+    HOST_CHECK(PdbIndexAttach(&Index, Image.data(), Image.size()));
+    AttachTime = HostTimeNs() - Begin;
+
+    Begin = HostTimeNs();
+
+    for (UINT32 i = 0; i < Pdb.SymbolNames.size(); i++)
+    {
+        Found += PdbIndexLookupSymbol(&Index, Pdb.SymbolNames[i].c_str(), &Rva);
+        Found += PdbIndexLookupFieldOffset(&Index, TestTypeName(i % 5000).c_str(), "Field0", &FieldOffset);
+    }
+
+    LookupTime = HostTimeNs() - Begin;
+
+    HOST_CHECK(Found == 2 * Pdb.SymbolNames.size());
+
+    printf("benchmark: %u MB PDB with 50000 symbols and 5000 types, build %.1f ms, "
+           "attach (validation) %.2f ms, %.0f ns per lookup\n",
+           (UINT32)(Pdb.File.size() >> 20),
+           BuildTime / 1e6,
+           AttachTime / 1e6,
+           (double)LookupTime / (2 * Pdb.SymbolNames.size()));
+}
+
+int
+main()
+{
+    TestLookups();
+    TestMalformedDirectory();
+    TestFuzz();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the parser of the PE images on the host
+ * @details Only the portable parts (pe-image.cpp) are compiled, the images
+ * are generated by the test
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <algorithm>
+
+//////////////////////////////////////////////////
+//               Windows Definitions            //
+//////////////////////////////////////////////////
+
+#define sprintf_s snprintf
+
+#define FIELD_OFFSET(Type, Field) ((LONG)offsetof(Type, Field))
+
+//
+// The structures of the PE files (DWORD is 64-bit on Linux, so the fields
+// are defined by the fixed-size types)
+//
+typedef struct _GUID
+{
+    UINT32 Data1;
+    UINT16 Data2;
+    UINT16 Data3;
+    BYTE   Data4[8];
+
+} GUID;
+
+#define IMAGE_DOS_SIGNATURE                0x5A4D
+#define IMAGE_NT_SIGNATURE                 0x00004550
+#define IMAGE_NT_OPTIONAL_HDR32_MAGIC      0x10b
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC      0x20b
+#define IMAGE_NUMBEROF_DIRECTORY_ENTRIES   16
+#define IMAGE_SIZEOF_SHORT_NAME            8
+#define IMAGE_DIRECTORY_ENTRY_EXPORT       0
+#define IMAGE_DIRECTORY_ENTRY_IMPORT       1
+#define IMAGE_DIRECTORY_ENTRY_DEBUG        6
+#define IMAGE_DEBUG_TYPE_CODEVIEW          2
+#define IMAGE_FILE_MACHINE_I386            0x014c
+#define IMAGE_FILE_MACHINE_AMD64           0x8664
+#define IMAGE_ORDINAL_FLAG64               0x8000000000000000ull
+#define IMAGE_ORDINAL_FLAG32               0x80000000
+#define IMAGE_ORDINAL64(Ordinal)           (Ordinal & 0xffff)
+#define IMAGE_SNAP_BY_ORDINAL64(Ordinal)   ((Ordinal & IMAGE_ORDINAL_FLAG64) != 0)
+#define IMAGE_SNAP_BY_ORDINAL32(Ordinal)   ((Ordinal & IMAGE_ORDINAL_FLAG32) != 0)
+
+typedef struct _IMAGE_DOS_HEADER
+{
+    UINT16 e_magic;
+    UINT16 e_cblp;
+    UINT16 e_cp;
+    UINT16 e_crlc;
+    UINT16 e_cparhdr;
+    UINT16 e_minalloc;
+    UINT16 e_maxalloc;
+    UINT16 e_ss;
+    UINT16 e_sp;
+    UINT16 e_csum;
+    UINT16 e_ip;
+    UINT16 e_cs;
+    UINT16 e_lfarlc;
+    UINT16 e_ovno;
+    UINT16 e_res[4];
+    UINT16 e_oemid;
+    UINT16 e_oeminfo;
+    UINT16 e_res2[10];
+    INT32  e_lfanew;
+
+} IMAGE_DOS_HEADER;
+
+typedef struct _IMAGE_FILE_HEADER
+{
+    UINT16 Machine;
+    UINT16 NumberOfSections;
+    UINT32 TimeDateStamp;
+    UINT32 PointerToSymbolTable;
+    UINT32 NumberOfSymbols;
+    UINT16 SizeOfOptionalHeader;
+    UINT16 Characteristics;
+
+} IMAGE_FILE_HEADER;
+
+typedef struct _IMAGE_DATA_DIRECTORY
+{
+    UINT32 VirtualAddress;
+    UINT32 Size;
+
+} IMAGE_DATA_DIRECTORY;
+
+typedef struct _IMAGE_OPTIONAL_HEADER32
+{
+    UINT16               Magic;
+    BYTE                 MajorLinkerVersion;
+    BYTE                 MinorLinkerVersion;
+    UINT32               SizeOfCode;
+    UINT32               SizeOfInitializedData;
+    UINT32               SizeOfUninitializedData;
+    UINT32               AddressOfEntryPoint;
+    UINT32               BaseOfCode;
+    UINT32               BaseOfData;
+    UINT32               ImageBase;
+    UINT32               SectionAlignment;
+    UINT32               FileAlignment;
+    UINT16               MajorOperatingSystemVersion;
+    UINT16               MinorOperatingSystemVersion;
+    UINT16               MajorImageVersion;
+    UINT16               MinorImageVersion;
+    UINT16               MajorSubsystemVersion;
+    UINT16               MinorSubsystemVersion;
+    UINT32               Win32VersionValue;
+    UINT32               SizeOfImage;
+    UINT32               SizeOfHeaders;
+    UINT32               CheckSum;
+    UINT16               Subsystem;
+    UINT16               DllCharacteristics;
+    UINT32               SizeOfStackReserve;
+    UINT32               SizeOfStackCommit;
+    UINT32               SizeOfHeapReserve;
+    UINT32               SizeOfHeapCommit;
+    UINT32               LoaderFlags;
+    UINT32               NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+
+} IMAGE_OPTIONAL_HEADER32;
+
+typedef struct _IMAGE_OPTIONAL_HEADER64
+{
+    UINT16               Magic;
+    BYTE                 MajorLinkerVersion;
+    BYTE                 MinorLinkerVersion;
+    UINT32               SizeOfCode;
+    UINT32               SizeOfInitializedData;
+    UINT32               SizeOfUninitializedData;
+    UINT32               AddressOfEntryPoint;
+    UINT32               BaseOfCode;
+    UINT64               ImageBase;
+    UINT32               SectionAlignment;
+    UINT32               FileAlignment;
+    UINT16               MajorOperatingSystemVersion;
+    UINT16               MinorOperatingSystemVersion;
+    UINT16               MajorImageVersion;
+    UINT16               MinorImageVersion;
+    UINT16               MajorSubsystemVersion;
+    UINT16               MinorSubsystemVersion;
+    UINT32               Win32VersionValue;
+    UINT32               SizeOfImage;
+    UINT32               SizeOfHeaders;
+    UINT32               CheckSum;
+    UINT16               Subsystem;
+    UINT16               DllCharacteristics;
+    UINT64               SizeOfStackReserve;
+    UINT64               SizeOfStackCommit;
+    UINT64               SizeOfHeapReserve;
+    UINT64               SizeOfHeapCommit;
+    UINT32               LoaderFlags;
+    UINT32               NumberOfRvaAndSizes;
+    IMAGE_DATA_DIRECTORY DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+
+} IMAGE_OPTIONAL_HEADER64;
+
+typedef struct _IMAGE_NT_HEADERS32
+{
+    UINT32                  Signature;
+    IMAGE_FILE_HEADER       FileHeader;
+    IMAGE_OPTIONAL_HEADER32 OptionalHeader;
+
+} IMAGE_NT_HEADERS32;
+
+typedef struct _IMAGE_NT_HEADERS64
+{
+    UINT32                  Signature;
+    IMAGE_FILE_HEADER       FileHeader;
+    IMAGE_OPTIONAL_HEADER64 OptionalHeader;
+
+} IMAGE_NT_HEADERS64;
+
+typedef struct _IMAGE_SECTION_HEADER
+{
+    BYTE Name[IMAGE_SIZEOF_SHORT_NAME];
+    union
+    {
+        UINT32 PhysicalAddress;
+        UINT32 VirtualSize;
+    } Misc;
+    UINT32 VirtualAddress;
+    UINT32 SizeOfRawData;
+    UINT32 PointerToRawData;
+    UINT32 PointerToRelocations;
+    UINT32 PointerToLinenumbers;
+    UINT16 NumberOfRelocations;
+    UINT16 NumberOfLinenumbers;
+    UINT32 Characteristics;
+
+} IMAGE_SECTION_HEADER;
+
+typedef struct _IMAGE_EXPORT_DIRECTORY
+{
+    UINT32 Characteristics;
+    UINT32 TimeDateStamp;
+    UINT16 MajorVersion;
+    UINT16 MinorVersion;
+    UINT32 Name;
+    UINT32 Base;
+    UINT32 NumberOfFunctions;
+    UINT32 NumberOfNames;
+    UINT32 AddressOfFunctions;
+    UINT32 AddressOfNames;
+    UINT32 AddressOfNameOrdinals;
+
+} IMAGE_EXPORT_DIRECTORY;
+
+typedef struct _IMAGE_IMPORT_DESCRIPTOR
+{
+    UINT32 OriginalFirstThunk;
+    UINT32 TimeDateStamp;
+    UINT32 ForwarderChain;
+    UINT32 Name;
+    UINT32 FirstThunk;
+
+} IMAGE_IMPORT_DESCRIPTOR;
+
+typedef struct _IMAGE_DEBUG_DIRECTORY
+{
+    UINT32 Characteristics;
+    UINT32 TimeDateStamp;
+    UINT16 MajorVersion;
+    UINT16 MinorVersion;
+    UINT32 Type;
+    UINT32 SizeOfData;
+    UINT32 AddressOfRawData;
+    UINT32 PointerToRawData;
+
+} IMAGE_DEBUG_DIRECTORY;
+
+typedef struct _MODULE_SYMBOL_DETAIL * PMODULE_SYMBOL_DETAIL;
+
+//////////////////////////////////////////////////
+//               Spinlocks                      //
+//////////////////////////////////////////////////
+
+BOOLEAN
+SpinlockTryLock(volatile LONG * Lock);
+
+void
+SpinlockLock(volatile LONG * Lock);
+
+void
+SpinlockLockWithCustomWait(volatile LONG * Lock, unsigned MaximumWait);
+
+void
+SpinlockUnlock(volatile LONG * Lock);
+
+//////////////////////////////////////////////////
+//               PE Images                      //
+//////////////////////////////////////////////////
+
+#include "../../../libhyperdbg/header/pe-image.h"
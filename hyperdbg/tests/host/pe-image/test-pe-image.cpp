@@ -0,0 +1,757 @@
+/**
+ * @file test-pe-image.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests, fuzzing and benchmark of the parser of the PE images
+ * @details Synthetic PE32 and PE32+ images (sections, exports, imports and
+ * the CodeView debug information) are parsed, then the images are mutated
+ * and truncated to check that corrupted images are safely rejected (the
+ * images are allocated by their exact size, so it should be built with
+ * the address sanitizer)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Layout of the synthetic images (the RVAs are the same as the
+ * offsets in the file)
+ *
+ */
+#define TEST_NT_HEADERS_OFFSET  0x80
+#define TEST_SIZE_OF_HEADERS    0x400
+#define TEST_TEXT_RVA           0x1000
+#define TEST_TEXT_SIZE          0x1000
+#define TEST_RDATA_RVA          0x2000
+#define TEST_RDATA_SIZE         0x8000
+#define TEST_DATA_RVA           0xa000
+#define TEST_DATA_RAW_SIZE      0x200
+#define TEST_DATA_VIRTUAL_SIZE  0x1000
+#define TEST_IMAGE_FILE_SIZE    (TEST_DATA_RVA + TEST_DATA_RAW_SIZE)
+#define TEST_EXPORT_RVA         TEST_RDATA_RVA
+#define TEST_IMPORT_RVA         0x8000
+#define TEST_DEBUG_RVA          0x9000
+#define TEST_CODEVIEW_RVA       0x9100
+#define TEST_COUNT_OF_NAMED     1000
+#define TEST_ORDINAL_BASE       10
+#define TEST_COUNT_OF_THREADS   4
+
+/**
+ * @brief The imported functions of the synthetic images
+ *
+ */
+typedef struct _TEST_IMPORT
+{
+    const CHAR * ModuleName;
+    const CHAR * Name; // NULL if imported by ordinal
+    UINT16       OrdinalOrHint;
+
+} TEST_IMPORT;
+
+static const TEST_IMPORT g_TestImports[] = {
+    {"KERNEL32.dll", "CreateFileW", 5},
+    {"KERNEL32.dll", "ReadFile", 9},
+    {"KERNEL32.dll", NULL, 7},
+    {"USER32.dll", "MessageBoxA", 3},
+};
+
+/**
+ * @brief RVA of the first thunk of the import address table of the image of
+ * the concurrency test
+ *
+ */
+static UINT32 g_TestThunkRva;
+
+static const GUID g_TestGuid = {0x12345678, 0x9abc, 0xdef0, {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef}};
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief RVA of the nth named export
+ *
+ */
+static UINT32
+TestExportRva(UINT32 Index)
+{
+    return TEST_TEXT_RVA + Index * 2;
+}
+
+/**
+ * @brief Write a string to the image and return its RVA
+ *
+ */
+static UINT32
+TestWriteString(std::vector<BYTE> & Buffer, UINT32 * Cursor, const CHAR * String)
+{
+    UINT32 Rva = *Cursor;
+
+    memcpy(&Buffer[Rva], String, strlen(String) + 1);
+    *Cursor += (UINT32)strlen(String) + 1;
+
+    return Rva;
+}
+
+/**
+ * @brief Build a synthetic image
+ * @details The exports are Function0...FunctionN (by name), an export by
+ * ordinal and a forwarder, the imports are g_TestImports
+ *
+ * @param Is32Bit PE32 or PE32+
+ *
+ * @return std::vector<BYTE> The file
+ */
+static std::vector<BYTE>
+TestBuildImage(BOOLEAN Is32Bit)
+{
+    std::vector<BYTE>        Buffer(TEST_IMAGE_FILE_SIZE, 0);
+    IMAGE_DOS_HEADER *       DosHeader = (IMAGE_DOS_HEADER *)&Buffer[0];
+    IMAGE_FILE_HEADER *      FileHeader;
+    IMAGE_DATA_DIRECTORY *   DataDirectories;
+    IMAGE_SECTION_HEADER *   Sections;
+    IMAGE_EXPORT_DIRECTORY * ExportDirectory;
+    IMAGE_DEBUG_DIRECTORY *  DebugDirectory;
+    UINT32                   SizeOfOptionalHeader;
+    UINT32                   CountOfFunctions = TEST_COUNT_OF_NAMED + 2;
+    UINT32                   Cursor;
+    UINT32                   ThunkSize = Is32Bit ? sizeof(UINT32) : sizeof(UINT64);
+    CHAR                     Name[32];
+
+    DosHeader->e_magic  = IMAGE_DOS_SIGNATURE;
+    DosHeader->e_lfanew = TEST_NT_HEADERS_OFFSET;
+
+    *(UINT32 *)&Buffer[TEST_NT_HEADERS_OFFSET] = IMAGE_NT_SIGNATURE;
+    FileHeader                                 = (IMAGE_FILE_HEADER *)&Buffer[TEST_NT_HEADERS_OFFSET + sizeof(UINT32)];
+
+    if (Is32Bit)
+    {
+        IMAGE_OPTIONAL_HEADER32 * OptionalHeader = &((IMAGE_NT_HEADERS32 *)&Buffer[TEST_NT_HEADERS_OFFSET])->OptionalHeader;
+
+        OptionalHeader->Magic               = IMAGE_NT_OPTIONAL_HDR32_MAGIC;
+        OptionalHeader->ImageBase           = 0x400000;
+        OptionalHeader->SizeOfImage         = TEST_DATA_RVA + TEST_DATA_VIRTUAL_SIZE;
+        OptionalHeader->SizeOfHeaders       = TEST_SIZE_OF_HEADERS;
+        OptionalHeader->NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+        DataDirectories                     = OptionalHeader->DataDirectory;
+        SizeOfOptionalHeader                = sizeof(IMAGE_OPTIONAL_HEADER32);
+        FileHeader->Machine                 = IMAGE_FILE_MACHINE_I386;
+    }
+    else
+    {
+        IMAGE_OPTIONAL_HEADER64 * OptionalHeader = &((IMAGE_NT_HEADERS64 *)&Buffer[TEST_NT_HEADERS_OFFSET])->OptionalHeader;
+
+        OptionalHeader->Magic               = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+        OptionalHeader->ImageBase           = 0x140000000ull;
+        OptionalHeader->SizeOfImage         = TEST_DATA_RVA + TEST_DATA_VIRTUAL_SIZE;
+        OptionalHeader->SizeOfHeaders       = TEST_SIZE_OF_HEADERS;
+        OptionalHeader->NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+        DataDirectories                     = OptionalHeader->DataDirectory;
+        SizeOfOptionalHeader                = sizeof(IMAGE_OPTIONAL_HEADER64);
+        FileHeader->Machine                 = IMAGE_FILE_MACHINE_AMD64;
+    }
+
+    FileHeader->NumberOfSections     = 3;
+    FileHeader->SizeOfOptionalHeader = (UINT16)SizeOfOptionalHeader;
+
+    //
+    // Sections (the .data section is larger in memory than in the file)
+    //
+    Sections = (IMAGE_SECTION_HEADER *)&Buffer[TEST_NT_HEADERS_OFFSET + sizeof(UINT32) + sizeof(IMAGE_FILE_HEADER) + SizeOfOptionalHeader];
+
+    memcpy(Sections[0].Name, ".rdata", 6);
+    Sections[0].VirtualAddress   = TEST_RDATA_RVA;
+    Sections[0].Misc.VirtualSize = TEST_RDATA_SIZE;
+    Sections[0].SizeOfRawData    = TEST_RDATA_SIZE;
+    Sections[0].PointerToRawData = TEST_RDATA_RVA;
+
+    memcpy(Sections[1].Name, ".text", 5);
+    Sections[1].VirtualAddress   = TEST_TEXT_RVA;
+    Sections[1].Misc.VirtualSize = TEST_TEXT_SIZE;
+    Sections[1].SizeOfRawData    = TEST_TEXT_SIZE;
+    Sections[1].PointerToRawData = TEST_TEXT_RVA;
+
+    memcpy(Sections[2].Name, ".data", 5);
+    Sections[2].VirtualAddress   = TEST_DATA_RVA;
+    Sections[2].Misc.VirtualSize = TEST_DATA_VIRTUAL_SIZE;
+    Sections[2].SizeOfRawData    = TEST_DATA_RAW_SIZE;
+    Sections[2].PointerToRawData = TEST_DATA_RVA;
+
+    //
+    // Exports: the named functions, one function by ordinal and a forwarder
+    // (the names are not sorted, the index doesn't depend on it)
+    //
+    ExportDirectory                        = (IMAGE_EXPORT_DIRECTORY *)&Buffer[TEST_EXPORT_RVA];
+    ExportDirectory->Base                  = TEST_ORDINAL_BASE;
+    ExportDirectory->NumberOfFunctions     = CountOfFunctions;
+    ExportDirectory->NumberOfNames         = TEST_COUNT_OF_NAMED + 1;
+    ExportDirectory->AddressOfFunctions    = TEST_EXPORT_RVA + sizeof(IMAGE_EXPORT_DIRECTORY);
+    ExportDirectory->AddressOfNames        = ExportDirectory->AddressOfFunctions + CountOfFunctions * sizeof(UINT32);
+    ExportDirectory->AddressOfNameOrdinals = ExportDirectory->AddressOfNames + (TEST_COUNT_OF_NAMED + 1) * sizeof(UINT32);
+
+    Cursor = ExportDirectory->AddressOfNameOrdinals + (TEST_COUNT_OF_NAMED + 1) * sizeof(UINT16);
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_NAMED; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", i);
+
+        ((UINT32 *)&Buffer[ExportDirectory->AddressOfFunctions])[i]   = TestExportRva(i);
+        ((UINT32 *)&Buffer[ExportDirectory->AddressOfNames])[i]       = TestWriteString(Buffer, &Cursor, Name);
+        ((UINT16 *)&Buffer[ExportDirectory->AddressOfNameOrdinals])[i] = (UINT16)i;
+    }
+
+    //
+    // Exported by ordinal (no name)
+    //
+    ((UINT32 *)&Buffer[ExportDirectory->AddressOfFunctions])[TEST_COUNT_OF_NAMED] = TEST_TEXT_RVA + 0xff0;
+
+    //
+    // The forwarder points to a string in the export directory
+    //
+    ((UINT32 *)&Buffer[ExportDirectory->AddressOfFunctions])[TEST_COUNT_OF_NAMED + 1] = TestWriteString(Buffer, &Cursor, "NTDLL.RtlForwarded");
+    ((UINT32 *)&Buffer[ExportDirectory->AddressOfNames])[TEST_COUNT_OF_NAMED]         = TestWriteString(Buffer, &Cursor, "Forwarded");
+    ((UINT16 *)&Buffer[ExportDirectory->AddressOfNameOrdinals])[TEST_COUNT_OF_NAMED]  = TEST_COUNT_OF_NAMED + 1;
+
+    HOST_CHECK(Cursor < TEST_IMPORT_RVA);
+
+    DataDirectories[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress = TEST_EXPORT_RVA;
+    DataDirectories[IMAGE_DIRECTORY_ENTRY_EXPORT].Size           = Cursor - TEST_EXPORT_RVA;
+
+    //
+    // Imports: a descriptor per module, the lookup tables and the import
+    // address tables are separated
+    //
+    {
+        UINT32 DescriptorsRva = TEST_IMPORT_RVA;
+        UINT32 TablesRva      = TEST_IMPORT_RVA + 0x100;
+        UINT32 NamesRva       = TEST_IMPORT_RVA + 0x400;
+        UINT32 CountOfModules = 0;
+
+        for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestImports);)
+        {
+            IMAGE_IMPORT_DESCRIPTOR * Descriptor = &((IMAGE_IMPORT_DESCRIPTOR *)&Buffer[DescriptorsRva])[CountOfModules++];
+            UINT32                    Count      = 0;
+
+            while (i + Count < RTL_NUMBER_OF(g_TestImports) &&
+                   !strcmp(g_TestImports[i + Count].ModuleName, g_TestImports[i].ModuleName))
+            {
+                Count++;
+            }
+
+            Descriptor->Name               = TestWriteString(Buffer, &NamesRva, g_TestImports[i].ModuleName);
+            Descriptor->OriginalFirstThunk = TablesRva;
+            Descriptor->FirstThunk         = TablesRva + (Count + 1) * ThunkSize;
+            TablesRva += 2 * (Count + 1) * ThunkSize;
+
+            for (UINT32 j = 0; j < Count; j++)
+            {
+                const TEST_IMPORT * Import = &g_TestImports[i + j];
+                UINT64              Value;
+
+                if (Import->Name == NULL)
+                {
+                    Value = (Is32Bit ? IMAGE_ORDINAL_FLAG32 : IMAGE_ORDINAL_FLAG64) | Import->OrdinalOrHint;
+                }
+                else
+                {
+                    Value = NamesRva;
+
+                    *(UINT16 *)&Buffer[NamesRva] = Import->OrdinalOrHint;
+                    NamesRva += sizeof(UINT16);
+                    TestWriteString(Buffer, &NamesRva, Import->Name);
+                }
+
+                memcpy(&Buffer[Descriptor->OriginalFirstThunk + j * ThunkSize], &Value, ThunkSize);
+                memcpy(&Buffer[Descriptor->FirstThunk + j * ThunkSize], &Value, ThunkSize);
+            }
+
+            i += Count;
+        }
+
+        DataDirectories[IMAGE_DIRECTORY_ENTRY_IMPORT].VirtualAddress = DescriptorsRva;
+        DataDirectories[IMAGE_DIRECTORY_ENTRY_IMPORT].Size           = (CountOfModules + 1) * sizeof(IMAGE_IMPORT_DESCRIPTOR);
+    }
+
+    //
+    // The CodeView debug information
+    //
+    DebugDirectory                   = (IMAGE_DEBUG_DIRECTORY *)&Buffer[TEST_DEBUG_RVA];
+    DebugDirectory->Type             = IMAGE_DEBUG_TYPE_CODEVIEW;
+    DebugDirectory->AddressOfRawData = TEST_CODEVIEW_RVA;
+    DebugDirectory->PointerToRawData = TEST_CODEVIEW_RVA;
+
+    Cursor = TEST_CODEVIEW_RVA;
+
+    *(UINT32 *)&Buffer[Cursor] = PE_IMAGE_CODEVIEW_RSDS_SIGNATURE;
+    memcpy(&Buffer[Cursor + sizeof(UINT32)], &g_TestGuid, sizeof(GUID));
+    *(UINT32 *)&Buffer[Cursor + sizeof(UINT32) + sizeof(GUID)] = 3;
+
+    Cursor += sizeof(UINT32) + sizeof(GUID) + sizeof(UINT32);
+    TestWriteString(Buffer, &Cursor, "c:\\build\\test.pdb");
+
+    DebugDirectory->SizeOfData = Cursor - TEST_CODEVIEW_RVA;
+
+    DataDirectories[IMAGE_DIRECTORY_ENTRY_DEBUG].VirtualAddress = TEST_DEBUG_RVA;
+    DataDirectories[IMAGE_DIRECTORY_ENTRY_DEBUG].Size           = sizeof(IMAGE_DEBUG_DIRECTORY);
+
+    return Buffer;
+}
+
+/**
+ * @brief Copy a file to a buffer of its exact size and parse it
+ *
+ * @param Image
+ * @param File
+ * @param Size
+ *
+ * @return BOOLEAN result of PeImageParseHeaders
+ */
+static BOOLEAN
+TestParse(PE_IMAGE * Image, const BYTE * File, UINT64 Size)
+{
+    BYTE * Copy = (BYTE *)malloc(Size != 0 ? Size : 1);
+
+    memcpy(Copy, File, Size);
+
+    Image->Base = Copy;
+    Image->Size = Size;
+
+    return PeImageParseHeaders(Image);
+}
+
+/**
+ * @brief Free the buffer of a parsed image
+ *
+ */
+static VOID
+TestFree(PE_IMAGE * Image)
+{
+    free((VOID *)Image->Base);
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Parse the synthetic image and check the lookups
+ *
+ * @param Is32Bit
+ *
+ * @return VOID
+ */
+static VOID
+TestLookups(BOOLEAN Is32Bit)
+{
+    std::vector<BYTE>            File = TestBuildImage(Is32Bit);
+    PE_IMAGE                     Image{};
+    const PE_IMAGE_EXPORT *      Export;
+    const PE_IMAGE_IMPORT *      Import;
+    const IMAGE_IMPORT_DESCRIPTOR * Descriptors;
+    CHAR                         Name[32];
+    CHAR                         PdbFilePath[260];
+    CHAR                         GuidAndAge[64];
+    UINT32                       ThunkSize = Is32Bit ? sizeof(UINT32) : sizeof(UINT64);
+    UINT32                       CountOfImports;
+
+    HOST_CHECK(TestParse(&Image, File.data(), File.size()));
+    HOST_CHECK(Image.Is32Bit == Is32Bit);
+    HOST_CHECK(Image.NumberOfSections == 3);
+    HOST_CHECK(Image.SizeOfImage == TEST_DATA_RVA + TEST_DATA_VIRTUAL_SIZE);
+
+    //
+    // Sections
+    //
+    HOST_CHECK(PeImageFindSectionByName(&Image, ".TEXT") == &Image.Sections[1]);
+    HOST_CHECK(PeImageFindSectionByName(&Image, ".rdata") == &Image.Sections[0]);
+    HOST_CHECK(PeImageFindSectionByName(&Image, ".tex") == NULL);
+    HOST_CHECK(PeImageFindSectionByName(&Image, ".textbss00") == NULL);
+    HOST_CHECK(PeImageFindSectionByRva(&Image, TEST_TEXT_RVA + 4) == &Image.Sections[1]);
+    HOST_CHECK(PeImageFindSectionByRva(&Image, TEST_DATA_RVA + 0x800) == &Image.Sections[2]);
+    HOST_CHECK(PeImageFindSectionByRva(&Image, TEST_DATA_RVA + TEST_DATA_VIRTUAL_SIZE) == NULL);
+    HOST_CHECK(PeImageFindSectionByRva(&Image, TEST_SIZE_OF_HEADERS) == NULL);
+
+    //
+    // The part of the section that is not in the file is not accessible
+    //
+    HOST_CHECK(PeImageRvaToPointer(&Image, TEST_DATA_RVA, TEST_DATA_RAW_SIZE) != NULL);
+    HOST_CHECK(PeImageRvaToPointer(&Image, TEST_DATA_RVA, TEST_DATA_RAW_SIZE + 1) == NULL);
+    HOST_CHECK(PeImageRvaToPointer(&Image, TEST_DATA_RVA + 0x800, 1) == NULL);
+
+    //
+    // Exports by name, by RVA, by ordinal and the forwarder
+    //
+    for (UINT32 i = 0; i < TEST_COUNT_OF_NAMED; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", i);
+
+        Export = PeImageFindExportByName(&Image, Name);
+
+        HOST_CHECK(Export != NULL && Export->Rva == TestExportRva(i) && Export->Ordinal == TEST_ORDINAL_BASE + i);
+        HOST_CHECK(!Export->IsForwarder && !strcmp(Export->Name, Name));
+
+        Export = PeImageFindExportByRva(&Image, TestExportRva(i) + 1);
+
+        HOST_CHECK(Export != NULL && !strcmp(Export->Name, Name));
+    }
+
+    HOST_CHECK(PeImageFindExportByName(&Image, "function1") == NULL);
+    HOST_CHECK(PeImageFindExportByName(&Image, "Function") == NULL);
+    HOST_CHECK(PeImageFindExportByRva(&Image, TEST_TEXT_RVA - 1) == NULL);
+
+    Export = PeImageFindExportByRva(&Image, TEST_TEXT_RVA + 0xff8);
+
+    HOST_CHECK(Export != NULL && Export->Name == NULL && Export->Ordinal == TEST_ORDINAL_BASE + TEST_COUNT_OF_NAMED);
+
+    Export = PeImageFindExportByName(&Image, "Forwarded");
+
+    HOST_CHECK(Export != NULL && Export->IsForwarder);
+    HOST_CHECK(!strcmp(PeImageRvaToString(&Image, Export->Rva), "NTDLL.RtlForwarded"));
+
+    //
+    // The forwarder is in the export directory (after the functions), it's
+    // not returned as the nearest function
+    //
+    Export = PeImageFindExportByRva(&Image, TEST_RDATA_RVA + 0x7000);
+
+    HOST_CHECK(Export != NULL && Export->Name == NULL);
+
+    //
+    // Imports by the RVAs of the thunks in the import address tables
+    //
+    Descriptors    = (const IMAGE_IMPORT_DESCRIPTOR *)&File[TEST_IMPORT_RVA];
+    CountOfImports = 0;
+
+    for (UINT32 i = 0; Descriptors[i].Name != 0; i++)
+    {
+        for (UINT32 j = 0;; j++)
+        {
+            const TEST_IMPORT * Expected = &g_TestImports[CountOfImports];
+            UINT64              Value    = 0;
+
+            memcpy(&Value, &File[Descriptors[i].FirstThunk + j * ThunkSize], ThunkSize);
+
+            if (Value == 0)
+            {
+                HOST_CHECK(PeImageFindImportByThunkRva(&Image, Descriptors[i].FirstThunk + j * ThunkSize) == NULL);
+                break;
+            }
+
+            Import = PeImageFindImportByThunkRva(&Image, Descriptors[i].FirstThunk + j * ThunkSize);
+
+            HOST_CHECK(Import != NULL && !strcmp(Import->ModuleName, Expected->ModuleName));
+            HOST_CHECK(Import->OrdinalOrHint == Expected->OrdinalOrHint);
+            HOST_CHECK(Import->IsOrdinal == (Expected->Name == NULL));
+            HOST_CHECK(Expected->Name == NULL ? Import->Name == NULL : !strcmp(Import->Name, Expected->Name));
+
+            //
+            // The lookup tables are not the import address tables
+            //
+            HOST_CHECK(PeImageFindImportByThunkRva(&Image, Descriptors[i].OriginalFirstThunk + j * ThunkSize) == NULL);
+
+            CountOfImports++;
+        }
+    }
+
+    HOST_CHECK(CountOfImports == RTL_NUMBER_OF(g_TestImports));
+    HOST_CHECK(Image.ImportsByThunkRva.size() == RTL_NUMBER_OF(g_TestImports));
+
+    //
+    // The PDB file and its GUID and age (the format of the symbol server)
+    //
+    HOST_CHECK(PeImageGetPdbDetails(&Image, PdbFilePath, sizeof(PdbFilePath), GuidAndAge, sizeof(GuidAndAge)));
+    HOST_CHECK(!strcmp(PdbFilePath, "c:\\build\\test.pdb"));
+    HOST_CHECK(!strcmp(GuidAndAge, "123456789abcdef00123456789abcdef3"));
+    HOST_CHECK(!PeImageGetPdbDetails(&Image, PdbFilePath, 8, GuidAndAge, sizeof(GuidAndAge)));
+
+    TestFree(&Image);
+
+    printf("lookups (%s): sections, %u exports by name and rva, %u imports and the pdb details are found\n",
+           Is32Bit ? "pe32" : "pe32+",
+           TEST_COUNT_OF_NAMED + 2,
+           CountOfImports);
+}
+
+/**
+ * @brief Run all the lookups on a (possibly corrupted) image
+ *
+ * @param Image
+ * @param RandomState
+ *
+ * @return VOID
+ */
+static VOID
+TestAllLookups(PE_IMAGE * Image, UINT64 * RandomState)
+{
+    CHAR   Name[32];
+    CHAR   PdbFilePath[260];
+    CHAR   GuidAndAge[64];
+    UINT32 Size;
+
+    PeImageFindSectionByName(Image, ".text");
+    PeImageFindSectionByRva(Image, (UINT32)(HostRandom(RandomState) % 0x10000));
+
+    for (UINT32 i = 0; i < Image->NumberOfSections; i++)
+    {
+        const BYTE * RawData = PeImageGetSectionRawData(Image, &Image->Sections[i], &Size);
+
+        if (RawData != NULL)
+        {
+            HOST_CHECK(RawData >= Image->Base && RawData + Size <= Image->Base + Image->Size);
+        }
+    }
+
+    for (UINT32 i = 0; i < 8; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", (UINT32)(HostRandom(RandomState) % TEST_COUNT_OF_NAMED));
+
+        PeImageFindExportByName(Image, Name);
+        PeImageFindExportByRva(Image, (UINT32)(HostRandom(RandomState) % 0x10000));
+        PeImageFindImportByThunkRva(Image, (UINT32)(HostRandom(RandomState) % 0x10000));
+    }
+
+    //
+    // All the exported names are accessible
+    //
+    for (const PE_IMAGE_EXPORT & Export : Image->ExportsByRva)
+    {
+        if (Export.Name != NULL)
+        {
+            HOST_CHECK(PeImageFindExportByName(Image, Export.Name) != NULL);
+        }
+    }
+
+    for (const PE_IMAGE_IMPORT & Import : Image->ImportsByThunkRva)
+    {
+        HOST_CHECK(strlen(Import.ModuleName) < Image->Size);
+    }
+
+    PeImageGetPdbDetails(Image, PdbFilePath, sizeof(PdbFilePath), GuidAndAge, sizeof(GuidAndAge));
+}
+
+/**
+ * @brief Mutated and truncated images
+ *
+ * @return VOID
+ */
+static VOID
+TestFuzz()
+{
+    std::vector<BYTE> Files[2]    = {TestBuildImage(TRUE), TestBuildImage(FALSE)};
+    UINT64            RandomState = 0x4040;
+    UINT32            CountOfParsed = 0;
+    const UINT32      Iterations    = 20000;
+
+    //
+    // Interesting offsets: the headers, the directories and the tables
+    //
+    static const UINT32 Regions[][2] = {
+        {0, TEST_SIZE_OF_HEADERS},
+        {TEST_EXPORT_RVA, 0x100},
+        {TEST_EXPORT_RVA + sizeof(IMAGE_EXPORT_DIRECTORY), 0x4000},
+        {TEST_IMPORT_RVA, 0x500},
+        {TEST_DEBUG_RVA, 0x200},
+    };
+
+    for (UINT32 Iteration = 0; Iteration < Iterations; Iteration++)
+    {
+        std::vector<BYTE> File = Files[Iteration & 1];
+        PE_IMAGE          Image{};
+        UINT64            Size = File.size();
+        UINT32            CountOfMutations = 1 + (UINT32)(HostRandom(&RandomState) % 8);
+
+        for (UINT32 i = 0; i < CountOfMutations; i++)
+        {
+            const UINT32 * Region = Regions[HostRandom(&RandomState) % RTL_NUMBER_OF(Regions)];
+            UINT32         Offset = Region[0] + (UINT32)(HostRandom(&RandomState) % Region[1]);
+
+            switch (HostRandom(&RandomState) % 4)
+            {
+            case 0:
+                File[Offset] = (BYTE)HostRandom(&RandomState);
+                break;
+            case 1:
+                File[Offset] ^= (BYTE)(1 << (HostRandom(&RandomState) % 8));
+                break;
+            case 2:
+            {
+                //
+                // Large values (sizes, counts and RVAs)
+                //
+                static const UINT32 Values[] = {0, 0xffffffff, 0x80000000, 0x7fffffff, TEST_IMAGE_FILE_SIZE, TEST_IMAGE_FILE_SIZE - 1, 0x10000};
+                UINT32              Value    = Values[HostRandom(&RandomState) % RTL_NUMBER_OF(Values)];
+
+                memcpy(&File[Offset & ~3u], &Value, sizeof(Value));
+                break;
+            }
+            default:
+                File[Offset] = 0;
+                break;
+            }
+        }
+
+        if (HostRandom(&RandomState) % 4 == 0)
+        {
+            Size = HostRandom(&RandomState) % File.size();
+        }
+
+        if (TestParse(&Image, File.data(), Size))
+        {
+            CountOfParsed++;
+            TestAllLookups(&Image, &RandomState);
+        }
+
+        TestFree(&Image);
+    }
+
+    printf("fuzz: %u mutated or truncated images (%u of them parsed) are safely handled\n", Iterations, CountOfParsed);
+}
+
+/**
+ * @brief Thread routine of the concurrency test
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestConcurrencyThread(void * Parameter)
+{
+    PE_IMAGE * Image = (PE_IMAGE *)Parameter;
+    CHAR       Name[32];
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_NAMED; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", i);
+
+        HOST_CHECK(PeImageFindExportByName(Image, Name) != NULL);
+        HOST_CHECK(PeImageFindImportByThunkRva(Image, g_TestThunkRva) != NULL);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Multiple threads use the indexes of a new image (they're built once)
+ *
+ * @return VOID
+ */
+static VOID
+TestConcurrency()
+{
+    std::vector<BYTE> File = TestBuildImage(FALSE);
+    pthread_t         Threads[TEST_COUNT_OF_THREADS];
+
+    g_TestThunkRva = ((const IMAGE_IMPORT_DESCRIPTOR *)&File[TEST_IMPORT_RVA])->FirstThunk;
+
+    for (UINT32 Round = 0; Round < 50; Round++)
+    {
+        PE_IMAGE Image{};
+
+        HOST_CHECK(TestParse(&Image, File.data(), File.size()));
+
+        for (UINT32 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+        {
+            HOST_CHECK(pthread_create(&Threads[i], NULL, TestConcurrencyThread, &Image) == 0);
+        }
+
+        for (UINT32 i = 0; i < TEST_COUNT_OF_THREADS; i++)
+        {
+            pthread_join(Threads[i], NULL);
+        }
+
+        HOST_CHECK(Image.IndexLock == 0);
+        HOST_CHECK(Image.ExportsByRva.size() == TEST_COUNT_OF_NAMED + 2);
+        HOST_CHECK(Image.ImportsByThunkRva.size() == RTL_NUMBER_OF(g_TestImports));
+
+        TestFree(&Image);
+    }
+
+    printf("concurrency: %u threads build and use the indexes of the same image\n", TEST_COUNT_OF_THREADS);
+}
+
+/**
+ * @brief Time of the lookups by name (the hash) and the linear search of
+ * the export directory
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    std::vector<BYTE>              File = TestBuildImage(FALSE);
+    PE_IMAGE                       Image{};
+    const IMAGE_EXPORT_DIRECTORY * ExportDirectory;
+    const UINT32 *                 Names;
+    CHAR                           Name[32];
+    UINT64                         RandomState = 0x5050;
+    UINT64                         Begin;
+    UINT64                         Time[2];
+    UINT64                         Found = 0;
+    const UINT32                   Lookups = 200000;
+
+    HOST_CHECK(TestParse(&Image, File.data(), File.size()));
+
+    ExportDirectory = (const IMAGE_EXPORT_DIRECTORY *)PeImageRvaToPointer(&Image, TEST_EXPORT_RVA, sizeof(IMAGE_EXPORT_DIRECTORY));
+    Names           = (const UINT32 *)PeImageRvaToPointer(&Image, ExportDirectory->AddressOfNames, ExportDirectory->NumberOfNames * sizeof(UINT32));
+
+    PeImageBuildExportIndex(&Image);
+
+    Begin = HostTimeNs();
+
+    for (UINT32 i = 0; i < Lookups; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", (UINT32)(HostRandom(&RandomState) % TEST_COUNT_OF_NAMED));
+        Found += PeImageFindExportByName(&Image, Name) != NULL;
+    }
+
+    Time[0] = HostTimeNs() - Begin;
+
+    Begin = HostTimeNs();
+
+    for (UINT32 i = 0; i < Lookups / 100; i++)
+    {
+        snprintf(Name, sizeof(Name), "Function%u", (UINT32)(HostRandom(&RandomState) % TEST_COUNT_OF_NAMED));
+
+        for (UINT32 j = 0; j < ExportDirectory->NumberOfNames; j++)
+        {
+            if (!strcmp(PeImageRvaToString(&Image, Names[j]), Name))
+            {
+                Found++;
+                break;
+            }
+        }
+    }
+
+    Time[1] = HostTimeNs() - Begin;
+
+    HOST_CHECK(Found == Lookups + Lookups / 100);
+
+    printf("benchmark: %u exports, %.0f ns per lookup by name (hash), %.0f ns per lookup by name (linear search)\n",
+           TEST_COUNT_OF_NAMED + 2,
+           (double)Time[0] / Lookups,
+           (double)Time[1] / (Lookups / 100));
+
+    TestFree(&Image);
+}
+
+int
+main()
+{
+    TestLookups(TRUE);
+    TestLookups(FALSE);
+    TestFuzz();
+    TestConcurrency();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
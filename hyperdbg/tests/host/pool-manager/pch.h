@@ -0,0 +1,91 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the pool manager on the host
+ * @details Cores are simulated with threads, each thread has its own
+ * core number and execution mode (vmx-root or vmx non-root)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+extern __thread ULONG   g_TestCurrentCore;
+extern __thread BOOLEAN g_TestIsVmxRoot;
+extern ULONG            g_TestNumberOfCores;
+extern volatile LONG64  g_TestAllocatedBuffers;
+
+#define KeGetCurrentProcessorNumberEx(Number) (g_TestCurrentCore)
+#define KeQueryActiveProcessorCount(Affinity) (g_TestNumberOfCores)
+
+static inline VMX_EXECUTION_MODE
+VmxGetCurrentExecutionMode()
+{
+    return g_TestIsVmxRoot ? VmxExecutionModeRoot : VmxExecutionModeNonRoot;
+}
+
+static inline PVOID
+PlatformMemAllocateZeroedNonPagedPool(SIZE_T NumberOfBytes)
+{
+    PVOID Buffer = calloc(1, NumberOfBytes);
+
+    if (Buffer != NULL)
+    {
+        InterlockedIncrement64(&g_TestAllocatedBuffers);
+    }
+
+    return Buffer;
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    __atomic_sub_fetch(&g_TestAllocatedBuffers, 1, __ATOMIC_SEQ_CST);
+    free(BufferAddress);
+}
+
+static inline VOID
+TestLogInfo(const char * Format, ...)
+{
+    //
+    // The details of the pools are not shown in the test
+    //
+}
+
+#define LogInfo(Format, ...)    TestLogInfo(Format, ##__VA_ARGS__)
+#define LogError(Format, ...)   fprintf(stderr, Format "\n", ##__VA_ARGS__)
+#define LogWarning(Format, ...) fprintf(stderr, Format "\n", ##__VA_ARGS__)
+
+#include "../../../include/components/spinlock/header/Spinlock.h"
+#include "../../../hyperhv/header/memory/PoolManager.h"
+
+//////////////////////////////////////////////////
+//    Exported Functions (HyperDbgVmmImports.h) //
+//////////////////////////////////////////////////
+
+BOOLEAN
+PoolManagerCheckAndPerformAllocationAndDeallocation();
+
+BOOLEAN
+PoolManagerRequestAllocation(SIZE_T Size, UINT32 Count, POOL_ALLOCATION_INTENTION Intention);
+
+UINT64
+PoolManagerRequestPool(POOL_ALLOCATION_INTENTION Intention, BOOLEAN RequestNewPool, UINT32 Size);
+
+BOOLEAN
+PoolManagerFreePool(UINT64 AddressToFree);
+
+VOID
+PoolManagerShowPreAllocatedPools();
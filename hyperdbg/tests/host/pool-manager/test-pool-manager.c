@@ -0,0 +1,351 @@
+/**
+ * @file test-pool-manager.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Stress test and benchmark of the pool manager
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of simulated cores
+ *
+ */
+#define TEST_NUMBER_OF_CORES 4
+
+/**
+ * @brief Size of the pools of the test
+ *
+ */
+#define TEST_POOL_SIZE 256
+
+/**
+ * @brief Number of requests of each core in the stress test
+ *
+ */
+#define TEST_STRESS_REQUESTS_PER_CORE 100000
+
+__thread ULONG   g_TestCurrentCore;
+__thread BOOLEAN g_TestIsVmxRoot;
+ULONG            g_TestNumberOfCores = TEST_NUMBER_OF_CORES;
+volatile LONG64  g_TestAllocatedBuffers;
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Free a pool that is still in the depot (or in a magazine) and make
+ * sure that it's never given to the requests and it's freed
+ *
+ * @return VOID
+ */
+static VOID
+TestFreeUnusedPools()
+{
+    UINT64 Pools[8];
+    UINT64 Address;
+    LONG64 BuffersBeforeFree;
+
+    HOST_CHECK(PoolManagerInitialize());
+
+    PoolManagerRequestAllocation(TEST_POOL_SIZE, 8, TRACKING_HOOKED_PAGES);
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    //
+    // Get all of the pools (from vmx-root to fill the magazine) and give them back
+    // by freeing them, then allocate new ones
+    //
+    g_TestIsVmxRoot = TRUE;
+
+    for (UINT32 i = 0; i < 8; i++)
+    {
+        Pools[i] = PoolManagerRequestPool(TRACKING_HOOKED_PAGES, FALSE, 0);
+        HOST_CHECK(Pools[i] != (UINT64)NULL);
+    }
+
+    HOST_CHECK(PoolManagerRequestPool(TRACKING_HOOKED_PAGES, FALSE, 0) == (UINT64)NULL);
+
+    g_TestIsVmxRoot = FALSE;
+
+    PoolManagerRequestAllocation(TEST_POOL_SIZE, 16, TRACKING_HOOKED_PAGES);
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    //
+    // Move some of the free pools to the magazine of the core
+    //
+    g_TestIsVmxRoot = TRUE;
+    Address         = PoolManagerRequestPool(TRACKING_HOOKED_PAGES, FALSE, 0);
+    HOST_CHECK(Address != (UINT64)NULL);
+    g_TestIsVmxRoot = FALSE;
+
+    //
+    // Free all of the free pools (in the depot and in the magazine)
+    //
+    {
+        PLIST_ENTRY ListTemp = &g_ListOfAllocatedPoolsHead;
+        UINT32      Freed    = 0;
+
+        while (&g_ListOfAllocatedPoolsHead != ListTemp->Flink)
+        {
+            PPOOL_TABLE PoolTable;
+
+            ListTemp  = ListTemp->Flink;
+            PoolTable = CONTAINING_RECORD(ListTemp, POOL_TABLE, PoolsList);
+
+            if (!PoolTable->IsBusy)
+            {
+                HOST_CHECK(PoolManagerFreePool(PoolTable->Address));
+                Freed++;
+            }
+        }
+
+        HOST_CHECK(Freed == 15);
+    }
+
+    BuffersBeforeFree = g_TestAllocatedBuffers;
+
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    //
+    // The pools of the depot are freed immediately (the records are recycled)
+    //
+    HOST_CHECK(g_TestAllocatedBuffers < BuffersBeforeFree);
+
+    //
+    // The freed pools are never given, even from the magazine
+    //
+    g_TestIsVmxRoot = TRUE;
+    HOST_CHECK(PoolManagerRequestPool(TRACKING_HOOKED_PAGES, FALSE, 0) == (UINT64)NULL);
+    g_TestIsVmxRoot = FALSE;
+
+    HOST_CHECK(g_PoolIntentions[TRACKING_HOOKED_PAGES].Available == 0);
+
+    //
+    // Now the pools that were in the magazine are unlinked and freed too
+    //
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    {
+        PLIST_ENTRY ListTemp = &g_ListOfAllocatedPoolsHead;
+        UINT32      Pools    = 0;
+
+        while (&g_ListOfAllocatedPoolsHead != ListTemp->Flink)
+        {
+            ListTemp = ListTemp->Flink;
+            HOST_CHECK(CONTAINING_RECORD(ListTemp, POOL_TABLE, PoolsList)->IsBusy);
+            Pools++;
+        }
+
+        HOST_CHECK(Pools == 9);
+    }
+
+    PoolManagerUninitialize();
+
+    HOST_CHECK(g_TestAllocatedBuffers == 0);
+
+    printf("free: freed pools in the depot and in the magazines are unlinked and never given\n");
+}
+
+/**
+ * @brief A simulated core that requests and frees pools from vmx-root
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestCoreThread(void * Parameter)
+{
+    UINT64 RandomState = (UINT64)(ULONG_PTR)Parameter * 0x9E3779B97F4A7C15ull + 7;
+    UINT64 Held[4]     = {0};
+    UINT64 Misses      = 0;
+
+    g_TestCurrentCore = (ULONG)(ULONG_PTR)Parameter;
+    g_TestIsVmxRoot   = TRUE;
+
+    for (UINT32 i = 0; i < TEST_STRESS_REQUESTS_PER_CORE; i++)
+    {
+        UINT32 Slot = (UINT32)(HostRandom(&RandomState) % RTL_NUMBER_OF(Held));
+
+        if ((i & 0x3f) == 0)
+        {
+            //
+            // Let the safe points (and the other cores) run on small hosts
+            //
+            sched_yield();
+        }
+
+        if (Held[Slot] != (UINT64)NULL)
+        {
+            //
+            // The pool should not be changed by other cores
+            //
+            for (UINT32 j = 0; j < TEST_POOL_SIZE / sizeof(UINT64); j++)
+            {
+                HOST_CHECK(((UINT64 *)Held[Slot])[j] == Held[Slot]);
+            }
+
+            HOST_CHECK(PoolManagerFreePool(Held[Slot]));
+            Held[Slot] = (UINT64)NULL;
+        }
+        else
+        {
+            Held[Slot] = PoolManagerRequestPool(INSTANT_REGULAR_EVENT_BUFFER, TRUE, TEST_POOL_SIZE);
+
+            if (Held[Slot] == (UINT64)NULL)
+            {
+                Misses++;
+                continue;
+            }
+
+            for (UINT32 j = 0; j < TEST_POOL_SIZE / sizeof(UINT64); j++)
+            {
+                ((UINT64 *)Held[Slot])[j] = Held[Slot];
+            }
+        }
+    }
+
+    for (UINT32 Slot = 0; Slot < RTL_NUMBER_OF(Held); Slot++)
+    {
+        if (Held[Slot] != (UINT64)NULL)
+        {
+            PoolManagerFreePool(Held[Slot]);
+        }
+    }
+
+    return (void *)(ULONG_PTR)Misses;
+}
+
+/**
+ * @brief Cores request and free pools while the safe points allocate and free
+ * the pools concurrently
+ *
+ * @return VOID
+ */
+static VOID
+TestStress()
+{
+    pthread_t Cores[TEST_NUMBER_OF_CORES];
+    void *    CoreMisses;
+    UINT64    Misses     = 0;
+    UINT64    SafePoints = 0;
+    UINT64    Start;
+
+    HOST_CHECK(PoolManagerInitialize());
+
+    PoolManagerRequestAllocation(TEST_POOL_SIZE, 64, INSTANT_REGULAR_EVENT_BUFFER);
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    Start = HostTimeNs();
+
+    for (ULONG_PTR i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        HOST_CHECK(pthread_create(&Cores[i], NULL, TestCoreThread, (void *)i) == 0);
+    }
+
+    //
+    // The safe points (vmx non-root) run while the cores are working
+    //
+    g_TestCurrentCore = 0;
+    g_TestIsVmxRoot   = FALSE;
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        while (pthread_tryjoin_np(Cores[i], &CoreMisses) != 0)
+        {
+            PoolManagerCheckAndPerformAllocationAndDeallocation();
+            SafePoints++;
+            sched_yield();
+        }
+
+        Misses += (UINT64)(ULONG_PTR)CoreMisses;
+    }
+
+    printf("stress: %u cores x %u requests/frees in %.1f ms, %llu safe points, %llu misses, high-water mark %d\n",
+           TEST_NUMBER_OF_CORES,
+           TEST_STRESS_REQUESTS_PER_CORE,
+           (double)(HostTimeNs() - Start) / 1000000,
+           (unsigned long long)SafePoints,
+           (unsigned long long)Misses,
+           g_PoolIntentions[INSTANT_REGULAR_EVENT_BUFFER].HighWaterMark);
+
+    HOST_CHECK(g_PoolIntentions[INSTANT_REGULAR_EVENT_BUFFER].InUse == 0);
+
+    PoolManagerCheckAndPerformAllocationAndDeallocation();
+    PoolManagerUninitialize();
+
+    HOST_CHECK(g_TestAllocatedBuffers == 0);
+}
+
+/**
+ * @brief Measure the time of requesting a pool (vmx-root and vmx non-root)
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    const UINT32 Count = 4096;
+    UINT64 *     Pools = malloc(sizeof(UINT64) * Count);
+    UINT64       Start;
+    UINT64       RootTime;
+    UINT64       NonRootTime;
+
+    HOST_CHECK(Pools != NULL);
+    HOST_CHECK(PoolManagerInitialize());
+
+    PoolManagerRequestAllocation(TEST_POOL_SIZE, Count * 2 + POOL_MANAGER_MAGAZINE_SIZE, BREAKPOINT_DEFINITION_STRUCTURE);
+    HOST_CHECK(PoolManagerCheckAndPerformAllocationAndDeallocation());
+
+    g_TestIsVmxRoot = TRUE;
+    Start           = HostTimeNs();
+
+    for (UINT32 i = 0; i < Count; i++)
+    {
+        Pools[i] = PoolManagerRequestPool(BREAKPOINT_DEFINITION_STRUCTURE, FALSE, 0);
+        HOST_CHECK(Pools[i] != (UINT64)NULL);
+    }
+
+    RootTime        = HostTimeNs() - Start;
+    g_TestIsVmxRoot = FALSE;
+    Start           = HostTimeNs();
+
+    for (UINT32 i = 0; i < Count; i++)
+    {
+        HOST_CHECK(PoolManagerRequestPool(BREAKPOINT_DEFINITION_STRUCTURE, FALSE, 0) != (UINT64)NULL);
+    }
+
+    NonRootTime = HostTimeNs() - Start;
+
+    printf("benchmark: %u pools in the list, request from vmx-root %.1f ns, from vmx non-root %.1f ns\n",
+           Count * 2,
+           (double)RootTime / Count,
+           (double)NonRootTime / Count);
+
+    PoolManagerUninitialize();
+    free(Pools);
+
+    HOST_CHECK(g_TestAllocatedBuffers == 0);
+}
+
+int
+main()
+{
+    TestFreeUnusedPools();
+    TestStress();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
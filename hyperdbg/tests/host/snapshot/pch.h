@@ -0,0 +1,22 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the snapshot tracker on the host
+ * @details The physical memory of the guest is simulated by a buffer, each
+ * thread is a core with its own write permissions of the pages (the EPT)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+
+#include "../../../include/components/spinlock/header/Spinlock.h"
+#include "../../../hyperhv/header/features/SnapshotTracker.h"
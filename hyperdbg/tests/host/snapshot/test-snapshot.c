@@ -0,0 +1,611 @@
+/**
+ * @file test-snapshot.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests of the memory snapshots on a simulated physical memory
+ * @details The write faults and the restores follow SnapshotHandleEptViolation
+ * and SnapshotRestorePages, the write permissions of each core (its EPT) are
+ * only changed by the thread of that core (or by its broadcasted restore)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of simulated cores
+ *
+ */
+#define TEST_NUMBER_OF_CORES 4
+
+/**
+ * @brief Number of pages of the snapshot
+ *
+ */
+#define TEST_NUMBER_OF_PAGES 1200
+
+/**
+ * @brief The first page of the snapshot (the range crosses the boundaries
+ * of the tables of EPT)
+ *
+ */
+#define TEST_FIRST_PAGE_FRAME_NUMBER 0x3f0
+
+/**
+ * @brief Maximum number of pages of each batch of the restores
+ *
+ */
+#define TEST_MAXIMUM_PAGES_PER_BATCH 16
+
+/**
+ * @brief Number of restores while the cores are writing
+ *
+ */
+#define TEST_CONCURRENT_RESTORES 3000
+
+/**
+ * @brief Number of writes of each core between two restores
+ *
+ */
+#define TEST_WRITES_PER_RESTORE 64
+
+/**
+ * @brief The simulated snapshot (SNAPSHOT_STATE)
+ *
+ */
+typedef struct _TEST_SNAPSHOT
+{
+    volatile LONG    Lock;
+    volatile LONG    CountOfProtectedCores;
+    PVOID            TrackerBuffer;
+    PVOID            PageCopies;
+    SNAPSHOT_TRACKER Tracker;
+    UINT64           CountOfDroppedPages;
+    UINT64           CountOfRestoredPages;
+    UINT64           CountOfEarlyRestoredPages;
+
+} TEST_SNAPSHOT;
+
+TEST_SNAPSHOT    g_TestSnapshot;
+BYTE *           g_TestPhysicalMemory; // The pages of the snapshot
+BYTE *           g_TestOriginalMemory;
+BOOLEAN          g_TestWriteAccess[TEST_NUMBER_OF_CORES][TEST_NUMBER_OF_PAGES];
+volatile LONG    g_TestRestoreGeneration;
+volatile LONG    g_TestCountOfAcknowledgedCores;
+volatile BOOLEAN g_TestStop;
+
+//////////////////////////////////////////////////
+//				  Simulated Snapshot  			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Get the simulated page of a page frame number
+ *
+ */
+static BYTE *
+TestGetPage(UINT64 PageFrameNumber)
+{
+    return g_TestPhysicalMemory + ((PageFrameNumber - TEST_FIRST_PAGE_FRAME_NUMBER) * PAGE_SIZE);
+}
+
+/**
+ * @brief Take a snapshot of the pages (the pages are write-protected on all cores)
+ *
+ */
+static VOID
+TestTakeSnapshot(UINT32 MaximumPages)
+{
+    g_TestSnapshot.TrackerBuffer = malloc(SnapshotTrackerGetBufferSize(MaximumPages));
+    g_TestSnapshot.PageCopies    = malloc((SIZE_T)MaximumPages * PAGE_SIZE);
+
+    HOST_CHECK(g_TestSnapshot.TrackerBuffer != NULL && g_TestSnapshot.PageCopies != NULL);
+
+    SnapshotTrackerInitialize(&g_TestSnapshot.Tracker, g_TestSnapshot.TrackerBuffer, g_TestSnapshot.PageCopies, MaximumPages);
+
+    g_TestSnapshot.CountOfDroppedPages       = 0;
+    g_TestSnapshot.CountOfRestoredPages      = 0;
+    g_TestSnapshot.CountOfEarlyRestoredPages = 0;
+
+    memcpy(g_TestOriginalMemory, g_TestPhysicalMemory, (SIZE_T)TEST_NUMBER_OF_PAGES * PAGE_SIZE);
+    memset(g_TestWriteAccess, 0, sizeof(g_TestWriteAccess));
+}
+
+/**
+ * @brief Discard the snapshot
+ *
+ */
+static VOID
+TestDiscardSnapshot()
+{
+    free(g_TestSnapshot.TrackerBuffer);
+    free(g_TestSnapshot.PageCopies);
+
+    g_TestSnapshot.TrackerBuffer = NULL;
+    g_TestSnapshot.PageCopies    = NULL;
+}
+
+/**
+ * @brief Handle the write fault of a write-protected page (SnapshotHandleEptViolation)
+ *
+ */
+static VOID
+TestHandleWriteFault(UINT32 Core, UINT64 PageFrameNumber)
+{
+    PVOID                   PageCopy;
+    SNAPSHOT_TRACKER_STATUS Status;
+
+    SpinlockLock(&g_TestSnapshot.Lock);
+
+    Status = SnapshotTrackerTrackWrite(&g_TestSnapshot.Tracker, PageFrameNumber, &PageCopy);
+
+    if (Status == SNAPSHOT_TRACKER_STATUS_NEW_PAGE)
+    {
+        HOST_CHECK(PageCopy != NULL);
+        memcpy(PageCopy, TestGetPage(PageFrameNumber), PAGE_SIZE);
+    }
+    else if (Status == SNAPSHOT_TRACKER_STATUS_RESTORED_PAGE)
+    {
+        HOST_CHECK(PageCopy != NULL);
+        memcpy(TestGetPage(PageFrameNumber), PageCopy, PAGE_SIZE);
+
+        g_TestSnapshot.CountOfEarlyRestoredPages++;
+    }
+    else if (Status == SNAPSHOT_TRACKER_STATUS_POOL_EXHAUSTED)
+    {
+        g_TestSnapshot.CountOfDroppedPages++;
+    }
+
+    SpinlockUnlock(&g_TestSnapshot.Lock);
+
+    g_TestWriteAccess[Core][PageFrameNumber - TEST_FIRST_PAGE_FRAME_NUMBER] = TRUE;
+}
+
+/**
+ * @brief Write to a page from a core
+ *
+ */
+static VOID
+TestWrite(UINT32 Core, UINT64 PageFrameNumber, UINT32 Offset, UINT64 Value)
+{
+    if (!g_TestWriteAccess[Core][PageFrameNumber - TEST_FIRST_PAGE_FRAME_NUMBER])
+    {
+        TestHandleWriteFault(Core, PageFrameNumber);
+    }
+
+    memcpy(TestGetPage(PageFrameNumber) + Offset, &Value, sizeof(UINT64));
+}
+
+/**
+ * @brief Plan the restore (SnapshotPrepareRestore)
+ *
+ */
+static VOID
+TestPrepareRestore()
+{
+    SpinlockLock(&g_TestSnapshot.Lock);
+
+    SnapshotTrackerPlanRestore(&g_TestSnapshot.Tracker, TEST_MAXIMUM_PAGES_PER_BATCH);
+
+    InterlockedExchange(&g_TestSnapshot.CountOfProtectedCores, 0);
+
+    SpinlockUnlock(&g_TestSnapshot.Lock);
+}
+
+/**
+ * @brief Protect the planned pages on the core and copy them back on the
+ * last core (SnapshotRestorePages)
+ *
+ */
+static VOID
+TestRestorePages(UINT32 Core)
+{
+    SNAPSHOT_TRACKER *       Tracker = &g_TestSnapshot.Tracker;
+    SNAPSHOT_TRACKER_BATCH * Batch;
+    PVOID                    PageCopy;
+
+    for (UINT32 i = 0; i < Tracker->CountOfBatches; i++)
+    {
+        Batch = &Tracker->Batches[i];
+
+        for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+        {
+            g_TestWriteAccess[Core][Batch->FirstPageFrameNumber + j - TEST_FIRST_PAGE_FRAME_NUMBER] = FALSE;
+        }
+    }
+
+    if (InterlockedIncrement(&g_TestSnapshot.CountOfProtectedCores) != TEST_NUMBER_OF_CORES)
+    {
+        return;
+    }
+
+    SpinlockLock(&g_TestSnapshot.Lock);
+
+    for (UINT32 i = 0; i < Tracker->CountOfBatches; i++)
+    {
+        Batch = &Tracker->Batches[i];
+
+        for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+        {
+            PageCopy = SnapshotTrackerGetBatchPageCopy(Tracker, Batch, j);
+
+            if (PageCopy != NULL)
+            {
+                memcpy(TestGetPage(Batch->FirstPageFrameNumber + j), PageCopy, PAGE_SIZE);
+            }
+        }
+    }
+
+    g_TestSnapshot.CountOfRestoredPages += SnapshotTrackerFinishRestore(Tracker);
+
+    SpinlockUnlock(&g_TestSnapshot.Lock);
+}
+
+/**
+ * @brief Restore the snapshot while all of the cores are stopped
+ *
+ */
+static VOID
+TestRestoreOnAllCores()
+{
+    TestPrepareRestore();
+
+    for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES; Core++)
+    {
+        TestRestorePages(Core);
+    }
+}
+
+/**
+ * @brief Check that the pages are restored and the pages that are writable
+ * on any core are tracked as dirty
+ *
+ */
+static VOID
+TestCheckRestored()
+{
+    HOST_CHECK(memcmp(g_TestPhysicalMemory, g_TestOriginalMemory, (SIZE_T)TEST_NUMBER_OF_PAGES * PAGE_SIZE) == 0);
+    HOST_CHECK(g_TestSnapshot.Tracker.CountOfDirtyPages == 0);
+
+    for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES; Core++)
+    {
+        for (UINT32 i = 0; i < TEST_NUMBER_OF_PAGES; i++)
+        {
+            HOST_CHECK(!g_TestWriteAccess[Core][i]);
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Check the batches of the restore plan
+ *
+ * @return VOID
+ */
+static VOID
+TestPlanBatches()
+{
+    SNAPSHOT_TRACKER *       Tracker = &g_TestSnapshot.Tracker;
+    SNAPSHOT_TRACKER_BATCH * Batch;
+    UINT64                   Seed = 0x5eed;
+    UINT32                   CountOfPages;
+    UINT64                   PreviousPageFrameNumber = 0;
+    BOOLEAN                  IsWritten[TEST_NUMBER_OF_PAGES] = {0};
+
+    TestTakeSnapshot(TEST_NUMBER_OF_PAGES);
+
+    //
+    // Pages around the boundary of the tables and random pages
+    //
+    for (UINT64 PageFrameNumber = 0x3fa; PageFrameNumber < 0x418; PageFrameNumber++)
+    {
+        TestWrite(0, PageFrameNumber, 0, PageFrameNumber);
+        IsWritten[PageFrameNumber - TEST_FIRST_PAGE_FRAME_NUMBER] = TRUE;
+    }
+
+    for (UINT32 i = 0; i < 300; i++)
+    {
+        UINT32 Index = (UINT32)(HostRandom(&Seed) % TEST_NUMBER_OF_PAGES);
+
+        TestWrite(0, TEST_FIRST_PAGE_FRAME_NUMBER + Index, 8, i);
+        IsWritten[Index] = TRUE;
+    }
+
+    TestPrepareRestore();
+
+    CountOfPages = 0;
+
+    for (UINT32 i = 0; i < Tracker->CountOfBatches; i++)
+    {
+        Batch = &Tracker->Batches[i];
+
+        HOST_CHECK(Batch->CountOfPages >= 1 && Batch->CountOfPages <= TEST_MAXIMUM_PAGES_PER_BATCH);
+        HOST_CHECK(i == 0 || Batch->FirstPageFrameNumber > PreviousPageFrameNumber);
+        HOST_CHECK(Batch->FirstPageFrameNumber / SNAPSHOT_TRACKER_PAGES_PER_TABLE ==
+                   (Batch->FirstPageFrameNumber + Batch->CountOfPages - 1) / SNAPSHOT_TRACKER_PAGES_PER_TABLE);
+
+        for (UINT32 j = 0; j < Batch->CountOfPages; j++)
+        {
+            HOST_CHECK(IsWritten[Batch->FirstPageFrameNumber + j - TEST_FIRST_PAGE_FRAME_NUMBER]);
+            HOST_CHECK(SnapshotTrackerGetBatchPageCopy(Tracker, Batch, j) != NULL);
+        }
+
+        PreviousPageFrameNumber = Batch->FirstPageFrameNumber + Batch->CountOfPages - 1;
+        CountOfPages += Batch->CountOfPages;
+    }
+
+    HOST_CHECK(CountOfPages == Tracker->CountOfDirtyPages);
+
+    for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES; Core++)
+    {
+        TestRestorePages(Core);
+    }
+
+    TestCheckRestored();
+    TestDiscardSnapshot();
+}
+
+/**
+ * @brief Write and restore randomly on a single core, the writes during the
+ * restore (between planning and copying back) are also checked
+ *
+ * @return VOID
+ */
+static VOID
+TestRandomRestores()
+{
+    UINT64 Seed = 0x1234567;
+    UINT64 PageFrameNumber;
+
+    TestTakeSnapshot(TEST_NUMBER_OF_PAGES);
+
+    for (UINT32 Iteration = 0; Iteration < 2000; Iteration++)
+    {
+        UINT32 CountOfWrites = (UINT32)(HostRandom(&Seed) % 64);
+
+        for (UINT32 i = 0; i < CountOfWrites; i++)
+        {
+            PageFrameNumber = TEST_FIRST_PAGE_FRAME_NUMBER + (HostRandom(&Seed) % TEST_NUMBER_OF_PAGES);
+
+            TestWrite((UINT32)(HostRandom(&Seed) % TEST_NUMBER_OF_CORES),
+                      PageFrameNumber,
+                      (UINT32)(HostRandom(&Seed) % (PAGE_SIZE / sizeof(UINT64))) * sizeof(UINT64),
+                      HostRandom(&Seed));
+        }
+
+        if (HostRandom(&Seed) % 2)
+        {
+            TestRestoreOnAllCores();
+            TestCheckRestored();
+            continue;
+        }
+
+        //
+        // Some of the cores protect the planned pages, then the pages are
+        // written by the cores before the last core copies them back
+        //
+        TestPrepareRestore();
+
+        for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES - 1; Core++)
+        {
+            TestRestorePages(Core);
+        }
+
+        for (UINT32 i = 0; i < 8; i++)
+        {
+            PageFrameNumber = TEST_FIRST_PAGE_FRAME_NUMBER + (HostRandom(&Seed) % TEST_NUMBER_OF_PAGES);
+
+            TestWrite((UINT32)(HostRandom(&Seed) % TEST_NUMBER_OF_CORES), PageFrameNumber, 0, HostRandom(&Seed));
+        }
+
+        TestRestorePages(TEST_NUMBER_OF_CORES - 1);
+
+        //
+        // The pages that are written during the restore remain dirty
+        //
+        TestRestoreOnAllCores();
+        TestCheckRestored();
+    }
+
+    HOST_CHECK(g_TestSnapshot.CountOfDroppedPages == 0);
+    HOST_CHECK(g_TestSnapshot.CountOfEarlyRestoredPages != 0);
+
+    TestDiscardSnapshot();
+}
+
+/**
+ * @brief Check that the pages are dropped (and reported) if the pool of the
+ * copies is exhausted
+ *
+ * @return VOID
+ */
+static VOID
+TestPoolExhausted()
+{
+    TestTakeSnapshot(8);
+
+    for (UINT64 i = 0; i < 16; i++)
+    {
+        TestWrite(0, TEST_FIRST_PAGE_FRAME_NUMBER + (i * 3), 0, ~i);
+    }
+
+    HOST_CHECK(g_TestSnapshot.CountOfDroppedPages == 8);
+    HOST_CHECK(g_TestSnapshot.Tracker.CountOfPages == 8);
+
+    TestRestoreOnAllCores();
+
+    for (UINT64 i = 0; i < 16; i++)
+    {
+        BYTE * Page = TestGetPage(TEST_FIRST_PAGE_FRAME_NUMBER + (i * 3));
+
+        HOST_CHECK((memcmp(Page, g_TestOriginalMemory + (i * 3 * PAGE_SIZE), PAGE_SIZE) == 0) == (i < 8));
+    }
+
+    TestDiscardSnapshot();
+}
+
+/**
+ * @brief A simulated core that writes to random pages and performs the
+ * broadcasted restores between its writes
+ *
+ */
+static void *
+TestCoreThread(void * Parameter)
+{
+    UINT32 Core           = (UINT32)(UINT64)Parameter;
+    UINT64 Seed           = 0x9e3779b9ull * (Core + 1);
+    LONG   LastGeneration = 0;
+    UINT32 CountOfWrites  = 0;
+    UINT64 PageFrameNumber;
+
+    while (!g_TestStop)
+    {
+        if (g_TestRestoreGeneration != LastGeneration)
+        {
+            LastGeneration = g_TestRestoreGeneration;
+            CountOfWrites  = 0;
+
+            TestRestorePages(Core);
+
+            InterlockedIncrement(&g_TestCountOfAcknowledgedCores);
+        }
+
+        //
+        // The other cores (threads) should also run between the writes
+        //
+        if (CountOfWrites == TEST_WRITES_PER_RESTORE || HostRandom(&Seed) % 8 == 0)
+        {
+            sched_yield();
+
+            if (CountOfWrites == TEST_WRITES_PER_RESTORE)
+            {
+                continue;
+            }
+        }
+
+        CountOfWrites++;
+
+        //
+        // Most of the writes are to a small set of pages, so the cores
+        // write to the same pages during the restores
+        //
+        if (HostRandom(&Seed) % 4)
+        {
+            PageFrameNumber = TEST_FIRST_PAGE_FRAME_NUMBER + 500 + (HostRandom(&Seed) % 32);
+        }
+        else
+        {
+            PageFrameNumber = TEST_FIRST_PAGE_FRAME_NUMBER + (HostRandom(&Seed) % TEST_NUMBER_OF_PAGES);
+        }
+
+        TestWrite(Core,
+                  PageFrameNumber,
+                  (UINT32)(HostRandom(&Seed) % (PAGE_SIZE / sizeof(UINT64))) * sizeof(UINT64),
+                  HostRandom(&Seed) | 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Restore the snapshot while the cores are writing to the pages, the
+ * restores are broadcasted to the cores (the same way as DPCs)
+ *
+ * @return VOID
+ */
+static VOID
+TestConcurrentRestores()
+{
+    pthread_t Threads[TEST_NUMBER_OF_CORES];
+    UINT64    Start;
+    UINT64    Time;
+
+    TestTakeSnapshot(TEST_NUMBER_OF_PAGES);
+
+    g_TestStop                     = FALSE;
+    g_TestRestoreGeneration        = 0;
+    g_TestCountOfAcknowledgedCores = 0;
+
+    for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES; Core++)
+    {
+        HOST_CHECK(pthread_create(&Threads[Core], NULL, TestCoreThread, (void *)(UINT64)Core) == 0);
+    }
+
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < TEST_CONCURRENT_RESTORES; i++)
+    {
+        TestPrepareRestore();
+
+        InterlockedExchange(&g_TestCountOfAcknowledgedCores, 0);
+        InterlockedIncrement(&g_TestRestoreGeneration);
+
+        while (g_TestCountOfAcknowledgedCores != TEST_NUMBER_OF_CORES)
+        {
+            sched_yield();
+        }
+    }
+
+    Time = HostTimeNs() - Start;
+
+    g_TestStop = TRUE;
+
+    for (UINT32 Core = 0; Core < TEST_NUMBER_OF_CORES; Core++)
+    {
+        pthread_join(Threads[Core], NULL);
+    }
+
+    printf("concurrent restores: %u restores of %llu pages (%llu restored by the writes) in %.1f ms\n",
+           TEST_CONCURRENT_RESTORES,
+           g_TestSnapshot.CountOfRestoredPages,
+           g_TestSnapshot.CountOfEarlyRestoredPages,
+           (double)Time / 1000000);
+
+    //
+    // The pages that are written after the last restore are restored now
+    //
+    TestRestoreOnAllCores();
+    TestCheckRestored();
+
+    HOST_CHECK(g_TestSnapshot.CountOfDroppedPages == 0);
+
+    TestDiscardSnapshot();
+}
+
+int
+main()
+{
+    UINT64 Seed = 0xabcdef;
+
+    g_TestPhysicalMemory = malloc((SIZE_T)TEST_NUMBER_OF_PAGES * PAGE_SIZE);
+    g_TestOriginalMemory = malloc((SIZE_T)TEST_NUMBER_OF_PAGES * PAGE_SIZE);
+
+    HOST_CHECK(g_TestPhysicalMemory != NULL && g_TestOriginalMemory != NULL);
+
+    for (SIZE_T i = 0; i < (SIZE_T)TEST_NUMBER_OF_PAGES * PAGE_SIZE / sizeof(UINT64); i++)
+    {
+        ((UINT64 *)g_TestPhysicalMemory)[i] = HostRandom(&Seed);
+    }
+
+    TestPlanBatches();
+    TestRandomRestores();
+    TestPoolExhausted();
+    TestConcurrentRestores();
+
+    free(g_TestPhysicalMemory);
+    free(g_TestOriginalMemory);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file LegacyState.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief The per-core states before splitting them into hot and cold blocks
+ * @details Same fields as hyperhv/header/common/State.h and
+ * hyperkd/header/debugger/core/State.h in their previous order, without
+ * any alignment (only used for comparing the layouts)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+//////////////////////////////////////////////////
+//				   Structures					//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The previous layout of VIRTUAL_MACHINE_STATE
+ *
+ */
+typedef struct _LEGACY_VIRTUAL_MACHINE_STATE
+{
+    BOOLEAN                 IsOnVmxRootMode;
+    BOOLEAN                 IncrementRip;
+    BOOLEAN                 HasLaunched;
+    BOOLEAN                 IgnoreMtfUnset;
+    BOOLEAN                 WaitForImmediateVmexit;
+    BOOLEAN                 EnableExternalInterruptsOnContinue;
+    BOOLEAN                 EnableExternalInterruptsOnContinueMtf;
+    BOOLEAN                 RegisterBreakOnMtf;
+    BOOLEAN                 IgnoreOneMtf;
+    BOOLEAN                 NotNormalEptp;
+    BOOLEAN                 MbecEnabled;
+    PUINT64                 PmlBufferAddress;
+    BOOLEAN                 Test;
+    UINT64                  TestNumber;
+    GUEST_REGS *            Regs;
+    UINT32                  CoreId;
+    UINT32                  ExitReason;
+    UINT32                  ExitQualification;
+    UINT64                  LastVmexitRip;
+    UINT64                  VmxonRegionPhysicalAddress;
+    UINT64                  VmxonRegionVirtualAddress;
+    UINT64                  VmcsRegionPhysicalAddress;
+    UINT64                  VmcsRegionVirtualAddress;
+    UINT64                  VmmStack;
+    UINT64                  MsrBitmapVirtualAddress;
+    UINT64                  MsrBitmapPhysicalAddress;
+    UINT64                  IoBitmapVirtualAddressA;
+    UINT64                  IoBitmapPhysicalAddressA;
+    UINT64                  IoBitmapVirtualAddressB;
+    UINT64                  IoBitmapPhysicalAddressB;
+    UINT32                  QueuedNmi;
+    UINT32                  PendingExternalInterrupts[PENDING_INTERRUPTS_BUFFER_CAPACITY];
+    VMX_VMXOFF_STATE        VmxoffState;
+    NMI_BROADCASTING_STATE  NmiBroadcastingState;
+    VM_EXIT_TRANSPARENCY    TransparencyState;
+    PEPT_HOOKED_PAGE_DETAIL MtfEptHookRestorePoint;
+    UINT8                   LastExceptionOccuredInHost;
+    UINT64                  HostIdt;
+    UINT64                  HostGdt;
+    UINT64                  HostTss;
+    UINT64                  HostInterruptStack;
+    EPT_POINTER             EptPointer;
+    PVMM_EPT_PAGE_TABLE     EptPageTable;
+
+} LEGACY_VIRTUAL_MACHINE_STATE;
+
+/**
+ * @brief The previous layout of PROCESSOR_DEBUGGING_STATE
+ *
+ */
+typedef struct _LEGACY_PROCESSOR_DEBUGGING_STATE
+{
+    volatile LONG                              Lock;
+    volatile BOOLEAN                           MainDebuggingCore;
+    GUEST_REGS *                               Regs;
+    UINT32                                     CoreId;
+    BOOLEAN                                    ShortCircuitingEvent;
+    BOOLEAN                                    IgnoreDisasmInNextPacket;
+    PROCESSOR_DEBUGGING_MSR_READ_OR_WRITE      MsrState;
+    DATE_TIME_HOLDER                           DateTimeHolder;
+    PDEBUGGEE_BP_DESCRIPTOR                    SoftwareBreakpointState;
+    DEBUGGEE_INSTRUMENTATION_STEP_IN_TRACE     InstrumentationStepInTrace;
+    BOOLEAN                                    DoNotNmiNotifyOtherCoresByThisCore;
+    BOOLEAN                                    TracingMode;
+    DEBUGGEE_PROCESS_OR_THREAD_TRACING_DETAILS ThreadOrProcessTracingDetails;
+    KD_NMI_STATE                               NmiState;
+    DEBUGGEE_HALTED_CORE_TASK                  HaltedCoreTask;
+    BOOLEAN                                    BreakStarterCore;
+    UINT16                                     InstructionLengthHint;
+    UINT64                                     HardwareDebugRegisterForStepping;
+    UINT64 *                                   ScriptEngineCoreSpecificStackBuffer;
+    PKDPC                                      KdDpcObject;
+    CHAR                                       KdRecvBuffer[MaxSerialPacketSize];
+
+} LEGACY_PROCESSOR_DEBUGGING_STATE;
@@ -0,0 +1,65 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for benchmarking the layout of the per-core states on the host
+ * @details The per-core states of the hypervisor (VIRTUAL_MACHINE_STATE) and
+ * the debugger (PROCESSOR_DEBUGGING_STATE) are compiled from their real
+ * headers, and compared with their layout before splitting them into hot and
+ * cold blocks (LegacyState.h)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <assert.h>
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define FIELD_OFFSET(Type, Field) ((LONG)offsetof(Type, Field))
+
+typedef short CSHORT;
+
+typedef struct _TIME_FIELDS
+{
+    CSHORT Year;
+    CSHORT Month;
+    CSHORT Day;
+    CSHORT Hour;
+    CSHORT Minute;
+    CSHORT Second;
+    CSHORT Milliseconds;
+    CSHORT Weekday;
+
+} TIME_FIELDS;
+
+typedef PVOID PKDPC;
+
+//
+// Paging structures of ia32-doc (only used as members of the states)
+//
+typedef UINT64 EPT_PML4E;
+typedef UINT64 EPT_PDPTE;
+typedef UINT64 EPT_PDE_2MB;
+typedef UINT64 EPT_PDE;
+typedef UINT64 EPT_PTE;
+typedef UINT64 EPT_POINTER;
+
+//////////////////////////////////////////////////
+//               Per-core States                //
+//////////////////////////////////////////////////
+
+#include "../../../hyperhv/header/common/State.h"
+#include "../../../hyperkd/header/debugger/core/State.h"
+
+#include "LegacyState.h"
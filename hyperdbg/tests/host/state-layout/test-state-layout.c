@@ -0,0 +1,701 @@
+/**
+ * @file test-state-layout.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Benchmark of the layout of the per-core states
+ * @details Each thread is a core that handles synthetic VM-exits, it touches
+ * the same fields of g_GuestState and g_DbgState as the VM-exit handler and
+ * the main debugging core sometimes locks the other cores (same as halting
+ * them), the cache lines that are touched by each VM-exit and the lines that
+ * are shared between the cores are counted from the layouts, and the cache
+ * misses are measured by the hardware counters (if perf_event_open is
+ * available)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Default number of VM-exits that are handled by each core
+ *
+ */
+#define TEST_DEFAULT_VMEXITS_PER_CORE 10000000
+
+/**
+ * @brief The main debugging core locks another core once per this many VM-exits
+ *
+ */
+#define TEST_HALT_INTERVAL 256
+
+/**
+ * @brief One of this many VM-exits is an EPT violation (reads the EPT pointer)
+ *
+ */
+#define TEST_EPT_VIOLATION_INTERVAL 16
+
+/**
+ * @brief Exit reasons of the benchmark (ia32-doc)
+ *
+ */
+#define VMX_EXIT_REASON_EXECUTE_CPUID 0x0000000A
+#define VMX_EXIT_REASON_EPT_VIOLATION 0x00000030
+
+/**
+ * @brief A field that is accessed by the handler
+ *
+ */
+typedef struct _TEST_FIELD
+{
+    UINT32  Offset;
+    UINT32  Size;
+    BOOLEAN IsWritten;
+    BOOLEAN IsOnEveryVmexit; // FALSE if only accessed by the EPT violations
+
+} TEST_FIELD;
+
+#define TEST_FIELD_OF(Type, Field, IsWritten, IsOnEveryVmexit) \
+    {(UINT32)offsetof(Type, Field), (UINT32)sizeof(((Type *)0)->Field), IsWritten, IsOnEveryVmexit}
+
+/**
+ * @brief Fields of VIRTUAL_MACHINE_STATE that are accessed by TEST_HANDLE_VMEXIT
+ *
+ */
+#define TEST_VMX_FIELDS(Type)                                           \
+    {                                                                   \
+        TEST_FIELD_OF(Type, IsOnVmxRootMode, TRUE, TRUE),               \
+        TEST_FIELD_OF(Type, Regs, FALSE, TRUE),                         \
+        TEST_FIELD_OF(Type, ExitReason, TRUE, TRUE),                    \
+        TEST_FIELD_OF(Type, ExitQualification, TRUE, TRUE),             \
+        TEST_FIELD_OF(Type, LastVmexitRip, TRUE, TRUE),                 \
+        TEST_FIELD_OF(Type, IncrementRip, TRUE, TRUE),                  \
+        TEST_FIELD_OF(Type, IgnoreMtfUnset, FALSE, TRUE),               \
+        TEST_FIELD_OF(Type, VmxoffState.IsVmxoffExecuted, FALSE, TRUE), \
+        TEST_FIELD_OF(Type, NotNormalEptp, FALSE, FALSE),               \
+        TEST_FIELD_OF(Type, EptPointer, FALSE, FALSE),                  \
+    }
+
+/**
+ * @brief Fields of PROCESSOR_DEBUGGING_STATE that are accessed by TEST_HANDLE_VMEXIT
+ *
+ */
+#define TEST_DBG_FIELDS(Type)                                      \
+    {                                                              \
+        TEST_FIELD_OF(Type, Regs, FALSE, TRUE),                    \
+        TEST_FIELD_OF(Type, ShortCircuitingEvent, TRUE, TRUE),     \
+        TEST_FIELD_OF(Type, TracingMode, FALSE, TRUE),             \
+        TEST_FIELD_OF(Type, InstructionLengthHint, TRUE, TRUE),    \
+        TEST_FIELD_OF(Type, SoftwareBreakpointState, FALSE, TRUE), \
+    }
+
+/**
+ * @brief Handle a synthetic VM-exit (the same accesses as the handler)
+ *
+ */
+#define TEST_HANDLE_VMEXIT(VCpu, DbgState, Iteration)                                \
+    do                                                                               \
+    {                                                                                \
+        (VCpu)->IsOnVmxRootMode   = TRUE;                                            \
+        (VCpu)->ExitReason        = ((Iteration) % TEST_EPT_VIOLATION_INTERVAL) == 0 \
+                                        ? VMX_EXIT_REASON_EPT_VIOLATION              \
+                                        : VMX_EXIT_REASON_EXECUTE_CPUID;             \
+        (VCpu)->ExitQualification = (UINT32)(Iteration);                             \
+        (VCpu)->IncrementRip      = TRUE;                                            \
+                                                                                     \
+        (DbgState)->ShortCircuitingEvent = FALSE;                                    \
+                                                                                     \
+        if ((VCpu)->ExitReason == VMX_EXIT_REASON_EPT_VIOLATION)                     \
+        {                                                                            \
+            (VCpu)->Regs->rax += (VCpu)->NotNormalEptp ? 0 : (VCpu)->EptPointer;     \
+        }                                                                            \
+        else                                                                         \
+        {                                                                            \
+            (DbgState)->Regs->rax += (DbgState)->TracingMode;                        \
+        }                                                                            \
+                                                                                     \
+        if ((DbgState)->SoftwareBreakpointState != NULL)                             \
+        {                                                                            \
+            (DbgState)->InstructionLengthHint = 0;                                   \
+        }                                                                            \
+                                                                                     \
+        if ((VCpu)->IncrementRip && !(VCpu)->IgnoreMtfUnset)                         \
+        {                                                                            \
+            (VCpu)->LastVmexitRip += 2;                                              \
+        }                                                                            \
+                                                                                     \
+        if ((VCpu)->VmxoffState.IsVmxoffExecuted)                                    \
+        {                                                                            \
+            break;                                                                   \
+        }                                                                            \
+                                                                                     \
+        (VCpu)->IsOnVmxRootMode = FALSE;                                             \
+    } while (0)
+
+/**
+ * @brief Lock another core (same as halting it by the main debugging core)
+ *
+ */
+#define TEST_HALT_CORE(DbgState)                                         \
+    do                                                                   \
+    {                                                                    \
+        while (InterlockedCompareExchange(&(DbgState)->Lock, 1, 0) != 0) \
+        {                                                                \
+            YieldProcessor();                                            \
+        }                                                                \
+                                                                         \
+        (DbgState)->NmiState.WaitingToBeLocked = FALSE;                  \
+        InterlockedExchange(&(DbgState)->Lock, 0);                       \
+    } while (0)
+
+/**
+ * @brief A layout of the per-core states
+ *
+ */
+typedef struct _TEST_LAYOUT
+{
+    const CHAR * Name;
+    SIZE_T       SizeOfVmxState;
+    SIZE_T       SizeOfDbgState;
+    UINT32       LockOffset;
+    TEST_FIELD * VmxFields;
+    UINT32       NumberOfVmxFields;
+    TEST_FIELD * DbgFields;
+    UINT32       NumberOfDbgFields;
+    VOID * (*Worker)(VOID * Parameter);
+
+} TEST_LAYOUT;
+
+/**
+ * @brief The hardware counters of the benchmark
+ *
+ */
+typedef struct _TEST_COUNTER
+{
+    const CHAR * Name;
+    UINT32       Type;
+    UINT64       Config;
+    int          Fd;
+
+} TEST_COUNTER;
+
+//////////////////////////////////////////////////
+//				       Globals     				//
+//////////////////////////////////////////////////
+
+static UINT32          g_TestNumberOfCores;
+static UINT64          g_TestVmexitsPerCore;
+static PVOID           g_TestGuestState; // g_GuestState of the current layout
+static PVOID           g_TestDbgState;   // g_DbgState of the current layout
+static CHAR *          g_TestRegs;       // A page for the registers of each core
+static volatile LONG   g_TestReadyCores;
+
+static TEST_FIELD g_TestVmxFields[]       = TEST_VMX_FIELDS(VIRTUAL_MACHINE_STATE);
+static TEST_FIELD g_TestDbgFields[]       = TEST_DBG_FIELDS(PROCESSOR_DEBUGGING_STATE);
+static TEST_FIELD g_TestLegacyVmxFields[] = TEST_VMX_FIELDS(LEGACY_VIRTUAL_MACHINE_STATE);
+static TEST_FIELD g_TestLegacyDbgFields[] = TEST_DBG_FIELDS(LEGACY_PROCESSOR_DEBUGGING_STATE);
+
+static TEST_COUNTER g_TestCounters[] = {
+    {"LLC misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1},
+    {"L1D misses",
+     PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+     -1},
+};
+
+//////////////////////////////////////////////////
+//				  Simulated Cores     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Wait until all cores are ready (so they're running together)
+ *
+ * @return VOID
+ */
+static VOID
+TestWaitForAllCores()
+{
+    InterlockedIncrement(&g_TestReadyCores);
+
+    while (g_TestReadyCores != (LONG)g_TestNumberOfCores)
+    {
+        YieldProcessor();
+    }
+}
+
+/**
+ * @brief Pin the current thread to a processor
+ *
+ * @param CoreId
+ * @return VOID
+ */
+static VOID
+TestPinToProcessor(UINT32 CoreId)
+{
+    cpu_set_t Set;
+
+    CPU_ZERO(&Set);
+    CPU_SET(CoreId % (UINT32)sysconf(_SC_NPROCESSORS_ONLN), &Set);
+
+    pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+}
+
+/**
+ * @brief A core with the current layout
+ *
+ * @param Parameter the core id
+ * @return VOID *
+ */
+static VOID *
+TestCoreWorker(VOID * Parameter)
+{
+    UINT32                      CoreId   = (UINT32)(ULONG_PTR)Parameter;
+    VIRTUAL_MACHINE_STATE *     VCpu     = &((VIRTUAL_MACHINE_STATE *)g_TestGuestState)[CoreId];
+    PROCESSOR_DEBUGGING_STATE * DbgState = &((PROCESSOR_DEBUGGING_STATE *)g_TestDbgState)[CoreId];
+
+    //
+    // Each core has its own registers (on its own stack)
+    //
+    VCpu->Regs = DbgState->Regs = (GUEST_REGS *)(g_TestRegs + PAGE_SIZE * CoreId);
+
+    TestPinToProcessor(CoreId);
+    TestWaitForAllCores();
+
+    for (UINT64 i = 1; i <= g_TestVmexitsPerCore; i++)
+    {
+        TEST_HANDLE_VMEXIT(VCpu, DbgState, i);
+
+        if (CoreId == 0 && i % TEST_HALT_INTERVAL == 0)
+        {
+            TEST_HALT_CORE(&((PROCESSOR_DEBUGGING_STATE *)g_TestDbgState)[1 + (i / TEST_HALT_INTERVAL) % (g_TestNumberOfCores - 1)]);
+        }
+    }
+
+    HOST_CHECK(VCpu->LastVmexitRip == 2 * g_TestVmexitsPerCore);
+
+    return NULL;
+}
+
+/**
+ * @brief A core with the legacy layout
+ *
+ * @param Parameter the core id
+ * @return VOID *
+ */
+static VOID *
+TestLegacyCoreWorker(VOID * Parameter)
+{
+    UINT32                             CoreId   = (UINT32)(ULONG_PTR)Parameter;
+    LEGACY_VIRTUAL_MACHINE_STATE *     VCpu     = &((LEGACY_VIRTUAL_MACHINE_STATE *)g_TestGuestState)[CoreId];
+    LEGACY_PROCESSOR_DEBUGGING_STATE * DbgState = &((LEGACY_PROCESSOR_DEBUGGING_STATE *)g_TestDbgState)[CoreId];
+
+    //
+    // Each core has its own registers (on its own stack)
+    //
+    VCpu->Regs = DbgState->Regs = (GUEST_REGS *)(g_TestRegs + PAGE_SIZE * CoreId);
+
+    TestPinToProcessor(CoreId);
+    TestWaitForAllCores();
+
+    for (UINT64 i = 1; i <= g_TestVmexitsPerCore; i++)
+    {
+        TEST_HANDLE_VMEXIT(VCpu, DbgState, i);
+
+        if (CoreId == 0 && i % TEST_HALT_INTERVAL == 0)
+        {
+            TEST_HALT_CORE(&((LEGACY_PROCESSOR_DEBUGGING_STATE *)g_TestDbgState)[1 + (i / TEST_HALT_INTERVAL) % (g_TestNumberOfCores - 1)]);
+        }
+    }
+
+    HOST_CHECK(VCpu->LastVmexitRip == 2 * g_TestVmexitsPerCore);
+
+    return NULL;
+}
+
+//////////////////////////////////////////////////
+//				    Cache Lines     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Count the cache lines of a state that are touched by each VM-exit
+ *
+ * @param Fields
+ * @param NumberOfFields
+ * @return UINT32
+ */
+static UINT32
+TestCountLinesPerVmexit(TEST_FIELD * Fields, UINT32 NumberOfFields)
+{
+    UINT64 Lines = 0;
+
+    for (UINT32 i = 0; i < NumberOfFields; i++)
+    {
+        if (!Fields[i].IsOnEveryVmexit)
+        {
+            continue;
+        }
+
+        for (UINT32 Line = Fields[i].Offset / CPU_CACHE_LINE_SIZE;
+             Line <= (Fields[i].Offset + Fields[i].Size - 1) / CPU_CACHE_LINE_SIZE;
+             Line++)
+        {
+            HOST_CHECK(Line < 64);
+            Lines |= 1ull << Line;
+        }
+    }
+
+    return (UINT32)__builtin_popcountll(Lines);
+}
+
+/**
+ * @brief Check whether a range of bytes is accessed by a field
+ *
+ * @param Field
+ * @param Start
+ * @param End
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsFieldInRange(TEST_FIELD * Field, UINT64 Start, UINT64 End)
+{
+    return Field->Offset < End && Field->Offset + Field->Size > Start;
+}
+
+/**
+ * @brief Count the cache lines that are accessed by two neighbouring cores
+ * (and at least one of them writes into it) in an array of states that
+ * starts at a page
+ *
+ * @param Fields
+ * @param NumberOfFields
+ * @param SizeOfState
+ * @return UINT32
+ */
+static UINT32
+TestCountFalseSharedLines(TEST_FIELD * Fields, UINT32 NumberOfFields, SIZE_T SizeOfState)
+{
+    UINT32 SharedLines = 0;
+
+    for (UINT32 Core = 0; Core + 1 < g_TestNumberOfCores; Core++)
+    {
+        UINT64 Boundary = (UINT64)SizeOfState * (Core + 1);
+        UINT64 Line     = Boundary & ~(UINT64)(CPU_CACHE_LINE_SIZE - 1);
+
+        if (Line == Boundary)
+        {
+            continue;
+        }
+
+        //
+        // The line of the boundary holds the end of the first core's state and
+        // the beginning of the second core's state
+        //
+        BOOLEAN IsAccessedByFirst  = FALSE;
+        BOOLEAN IsAccessedBySecond = FALSE;
+        BOOLEAN IsWritten          = FALSE;
+
+        for (UINT32 i = 0; i < NumberOfFields; i++)
+        {
+            if (TestIsFieldInRange(&Fields[i], Line - (Boundary - SizeOfState), SizeOfState))
+            {
+                IsAccessedByFirst = TRUE;
+                IsWritten |= Fields[i].IsWritten;
+            }
+
+            if (TestIsFieldInRange(&Fields[i], 0, Line + CPU_CACHE_LINE_SIZE - Boundary))
+            {
+                IsAccessedBySecond = TRUE;
+                IsWritten |= Fields[i].IsWritten;
+            }
+        }
+
+        SharedLines += IsAccessedByFirst && IsAccessedBySecond && IsWritten;
+    }
+
+    return SharedLines;
+}
+
+/**
+ * @brief Check whether the lock (written by the other cores) is in the
+ * same cache line as the fields of the owner core
+ *
+ * @param Fields
+ * @param NumberOfFields
+ * @param LockOffset
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestIsLockSharingLine(TEST_FIELD * Fields, UINT32 NumberOfFields, UINT32 LockOffset)
+{
+    UINT64 Line = LockOffset & ~(UINT64)(CPU_CACHE_LINE_SIZE - 1);
+
+    for (UINT32 i = 0; i < NumberOfFields; i++)
+    {
+        if (TestIsFieldInRange(&Fields[i], Line, Line + CPU_CACHE_LINE_SIZE))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+//////////////////////////////////////////////////
+//				  Hardware Counters    			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Open the hardware counters (inherited by the cores)
+ *
+ * @return BOOLEAN FALSE if none of them is available
+ */
+static BOOLEAN
+TestOpenCounters()
+{
+    BOOLEAN IsAvailable = FALSE;
+    int     Error       = 0;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestCounters); i++)
+    {
+        struct perf_event_attr Attributes;
+
+        memset(&Attributes, 0, sizeof(Attributes));
+
+        Attributes.type           = g_TestCounters[i].Type;
+        Attributes.size           = sizeof(Attributes);
+        Attributes.config         = g_TestCounters[i].Config;
+        Attributes.disabled       = 1;
+        Attributes.inherit        = 1;
+        Attributes.exclude_kernel = 1;
+        Attributes.exclude_hv     = 1;
+
+        g_TestCounters[i].Fd = (int)syscall(__NR_perf_event_open, &Attributes, 0, -1, -1, 0);
+
+        if (g_TestCounters[i].Fd >= 0)
+        {
+            IsAvailable = TRUE;
+        }
+        else
+        {
+            Error = errno;
+        }
+    }
+
+    if (!IsAvailable)
+    {
+        printf("hardware counters are not available (perf_event_open: %s), only the time is measured\n\n", strerror(Error));
+    }
+
+    return IsAvailable;
+}
+
+/**
+ * @brief Close the hardware counters
+ *
+ * @return VOID
+ */
+static VOID
+TestCloseCounters()
+{
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestCounters); i++)
+    {
+        if (g_TestCounters[i].Fd >= 0)
+        {
+            close(g_TestCounters[i].Fd);
+            g_TestCounters[i].Fd = -1;
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Benchmark     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Run the cores with a layout and show the results
+ *
+ * @param Layout
+ * @return VOID
+ */
+static VOID
+TestRunLayout(TEST_LAYOUT * Layout)
+{
+    pthread_t Threads[256];
+    UINT64    Counts[RTL_NUMBER_OF(g_TestCounters)] = {0};
+    UINT64    TotalVmexits                          = g_TestVmexitsPerCore * g_TestNumberOfCores;
+    UINT64    Start;
+    UINT64    Elapsed;
+    UINT32    VmxLines;
+    UINT32    DbgLines;
+
+    //
+    // Same as the driver, the arrays are page aligned
+    //
+    g_TestGuestState = aligned_alloc(PAGE_SIZE, ROUND_TO_PAGES(Layout->SizeOfVmxState * g_TestNumberOfCores));
+    g_TestDbgState   = aligned_alloc(PAGE_SIZE, ROUND_TO_PAGES(Layout->SizeOfDbgState * g_TestNumberOfCores));
+
+    HOST_CHECK(g_TestGuestState != NULL && g_TestDbgState != NULL);
+
+    memset(g_TestGuestState, 0, ROUND_TO_PAGES(Layout->SizeOfVmxState * g_TestNumberOfCores));
+    memset(g_TestDbgState, 0, ROUND_TO_PAGES(Layout->SizeOfDbgState * g_TestNumberOfCores));
+    memset(g_TestRegs, 0, PAGE_SIZE * g_TestNumberOfCores);
+
+    g_TestReadyCores = 0;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestCounters); i++)
+    {
+        if (g_TestCounters[i].Fd >= 0)
+        {
+            ioctl(g_TestCounters[i].Fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(g_TestCounters[i].Fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < g_TestNumberOfCores; i++)
+    {
+        HOST_CHECK(pthread_create(&Threads[i], NULL, Layout->Worker, (VOID *)(ULONG_PTR)i) == 0);
+    }
+
+    for (UINT32 i = 0; i < g_TestNumberOfCores; i++)
+    {
+        HOST_CHECK(pthread_join(Threads[i], NULL) == 0);
+    }
+
+    Elapsed = HostTimeNs() - Start;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestCounters); i++)
+    {
+        if (g_TestCounters[i].Fd >= 0)
+        {
+            ioctl(g_TestCounters[i].Fd, PERF_EVENT_IOC_DISABLE, 0);
+            HOST_CHECK(read(g_TestCounters[i].Fd, &Counts[i], sizeof(UINT64)) == sizeof(UINT64));
+        }
+    }
+
+    VmxLines = TestCountLinesPerVmexit(Layout->VmxFields, Layout->NumberOfVmxFields);
+    DbgLines = TestCountLinesPerVmexit(Layout->DbgFields, Layout->NumberOfDbgFields);
+
+    printf("%s layout (VIRTUAL_MACHINE_STATE: %zu bytes, PROCESSOR_DEBUGGING_STATE: %zu bytes)\n",
+           Layout->Name,
+           Layout->SizeOfVmxState,
+           Layout->SizeOfDbgState);
+    printf("    cache lines touched by each vm-exit   : %u (%u + %u)\n", VmxLines + DbgLines, VmxLines, DbgLines);
+    printf("    lines shared by neighbouring cores    : %u + %u\n",
+           TestCountFalseSharedLines(Layout->VmxFields, Layout->NumberOfVmxFields, Layout->SizeOfVmxState),
+           TestCountFalseSharedLines(Layout->DbgFields, Layout->NumberOfDbgFields, Layout->SizeOfDbgState));
+    printf("    lock shares a line with the hot fields: %s\n",
+           TestIsLockSharingLine(Layout->DbgFields, Layout->NumberOfDbgFields, Layout->LockOffset) ? "yes" : "no");
+    printf("    time per vm-exit                      : %.2f ns (%.3f s)\n",
+           (double)Elapsed * g_TestNumberOfCores / (double)TotalVmexits,
+           (double)Elapsed / 1e9);
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestCounters); i++)
+    {
+        if (g_TestCounters[i].Fd >= 0)
+        {
+            printf("    %-38s: %.4f per vm-exit (%llu)\n",
+                   g_TestCounters[i].Name,
+                   (double)Counts[i] / (double)TotalVmexits,
+                   Counts[i]);
+        }
+    }
+
+    printf("\n");
+
+    free(g_TestGuestState);
+    free(g_TestDbgState);
+}
+
+int
+main(int argc, char ** argv)
+{
+    TEST_LAYOUT Layouts[] = {
+        {"legacy",
+         sizeof(LEGACY_VIRTUAL_MACHINE_STATE),
+         sizeof(LEGACY_PROCESSOR_DEBUGGING_STATE),
+         (UINT32)offsetof(LEGACY_PROCESSOR_DEBUGGING_STATE, Lock),
+         g_TestLegacyVmxFields,
+         RTL_NUMBER_OF(g_TestLegacyVmxFields),
+         g_TestLegacyDbgFields,
+         RTL_NUMBER_OF(g_TestLegacyDbgFields),
+         TestLegacyCoreWorker},
+        {"current",
+         sizeof(VIRTUAL_MACHINE_STATE),
+         sizeof(PROCESSOR_DEBUGGING_STATE),
+         (UINT32)offsetof(PROCESSOR_DEBUGGING_STATE, Lock),
+         g_TestVmxFields,
+         RTL_NUMBER_OF(g_TestVmxFields),
+         g_TestDbgFields,
+         RTL_NUMBER_OF(g_TestDbgFields),
+         TestCoreWorker},
+    };
+
+    g_TestNumberOfCores  = argc > 1 ? (UINT32)strtoul(argv[1], NULL, 0) : 0;
+    g_TestVmexitsPerCore = argc > 2 ? strtoull(argv[2], NULL, 0) : TEST_DEFAULT_VMEXITS_PER_CORE;
+
+    if (g_TestNumberOfCores == 0)
+    {
+        g_TestNumberOfCores = (UINT32)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    //
+    // At least one core is halted by the main debugging core
+    //
+    g_TestNumberOfCores = g_TestNumberOfCores < 2 ? 2 : g_TestNumberOfCores;
+    g_TestNumberOfCores = g_TestNumberOfCores > 256 ? 256 : g_TestNumberOfCores;
+
+    //
+    // Registers of each core are on a separate page
+    //
+    g_TestRegs = aligned_alloc(PAGE_SIZE, PAGE_SIZE * g_TestNumberOfCores);
+    HOST_CHECK(g_TestRegs != NULL);
+
+    printf("%u cores (%ld processors), %llu vm-exits per core\n\n",
+           g_TestNumberOfCores,
+           sysconf(_SC_NPROCESSORS_ONLN),
+           g_TestVmexitsPerCore);
+
+    if (g_TestNumberOfCores > (UINT32)sysconf(_SC_NPROCESSORS_ONLN))
+    {
+        printf("cores are sharing the processors, the time of false sharing is not measured\n\n");
+    }
+
+    TestOpenCounters();
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(Layouts); i++)
+    {
+        TestRunLayout(&Layouts[i]);
+    }
+
+    TestCloseCounters();
+
+    //
+    // The hot fields of each state are in one cache line, and the cores
+    // never share a line of the states
+    //
+    HOST_CHECK(TestCountLinesPerVmexit(g_TestVmxFields, RTL_NUMBER_OF(g_TestVmxFields)) == 1);
+    HOST_CHECK(TestCountLinesPerVmexit(g_TestDbgFields, RTL_NUMBER_OF(g_TestDbgFields)) == 1);
+    HOST_CHECK(TestCountFalseSharedLines(g_TestVmxFields, RTL_NUMBER_OF(g_TestVmxFields), sizeof(VIRTUAL_MACHINE_STATE)) == 0);
+    HOST_CHECK(TestCountFalseSharedLines(g_TestDbgFields, RTL_NUMBER_OF(g_TestDbgFields), sizeof(PROCESSOR_DEBUGGING_STATE)) == 0);
+    HOST_CHECK(!TestIsLockSharingLine(g_TestDbgFields, RTL_NUMBER_OF(g_TestDbgFields), offsetof(PROCESSOR_DEBUGGING_STATE, Lock)));
+
+    free(g_TestRegs);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the batched steps on the host
+ * @details The debuggee is simulated by the test (a small program that is
+ * executed one instruction at a time), and the chunks of records are
+ * decoded by the test instead of being sent to the debugger
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define _Strict_type_match_
+#define _In_reads_bytes_opt_(Size)
+
+#define HANDLE_TO_UINT32(Handle) ((UINT32)(UINT64)(Handle))
+
+extern UINT32 g_TestNumberOfCores;
+extern UINT32 g_TestCurrentThreadId;
+
+#define KeQueryActiveProcessorCount(Affinity) (g_TestNumberOfCores)
+#define PsGetCurrentProcessId()               ((HANDLE)(UINT64)4)
+#define PsGetCurrentThreadId()                ((HANDLE)(UINT64)g_TestCurrentThreadId)
+
+#define LogInfo(Format, ...) printf(Format, ##__VA_ARGS__)
+
+static inline PVOID
+PlatformMemAllocateNonPagedPool(SIZE_T NumberOfBytes)
+{
+    return malloc(NumberOfBytes);
+}
+
+static inline PVOID
+PlatformMemAllocateZeroedNonPagedPool(SIZE_T NumberOfBytes)
+{
+    return calloc(1, NumberOfBytes);
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    free(BufferAddress);
+}
+
+/**
+ * @brief The state of the debugger on each core (only the fields that are
+ * used by the batched steps)
+ *
+ */
+typedef struct _PROCESSOR_DEBUGGING_STATE
+{
+    UINT32       CoreId;
+    GUEST_REGS * Regs;
+
+} PROCESSOR_DEBUGGING_STATE;
+
+#include "../../../include/components/spinlock/header/Spinlock.h"
+
+//
+// Implemented by the test (the simulated debuggee and debugger)
+//
+BOOLEAN
+KdResponsePacketToDebugger(_In_ _Strict_type_match_ DEBUGGER_REMOTE_PACKET_TYPE             PacketType,
+                           _In_ _Strict_type_match_ DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION Response,
+                           _In_reads_bytes_opt_(OptionalBufferLength) CHAR *                OptionalBuffer,
+                           _In_ UINT32                                                      OptionalBufferLength);
+
+BOOLEAN
+KdIsGuestOnUsermode32Bit();
+
+VOID
+KdGuaranteedStepInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
+
+VOID
+KdRegularStepInInstruction(PROCESSOR_DEBUGGING_STATE * DbgState);
+
+UINT64
+VmFuncGetLastVmexitRip(UINT32 CoreId);
+
+UINT64
+VmFuncGetRflags();
+
+UINT32
+CheckAddressMaximumInstructionLength(PVOID Address);
+
+BOOLEAN
+MemoryMapperReadMemorySafeOnTargetProcess(_In_ UINT64   VaAddressToRead,
+                                          _Inout_ PVOID BufferToSaveMemory,
+                                          _In_ SIZE_T   SizeToRead);
+
+BOOLEAN
+DisassemblerCheckCallOrRetInVmxRootOnTargetProcess(PVOID Address, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length);
+
+#include "../../../hyperkd/header/debugger/meta-events/StepTrace.h"
+
+//////////////////////////////////////////////////
+//               Globals (Global.h)             //
+//////////////////////////////////////////////////
+
+extern STEP_TRACE_STATE g_StepTraceState;
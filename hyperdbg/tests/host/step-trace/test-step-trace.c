@@ -0,0 +1,688 @@
+/**
+ * @file test-step-trace.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the batched steps
+ * @details A simulated debuggee executes a small program one instruction at
+ * a time (the steps that are armed by the batched steps), the chunks of
+ * records are decoded and compared with the instructions that are executed
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+#define TEST_MEMORY_SIZE         0x10000
+#define TEST_STACK_BASE          0x7e000
+#define TEST_STACK_TOP           0x7f000
+#define TEST_MAXIMUM_RECORDS     0x10000
+#define TEST_MAXIMUM_INSTRUCTIONS 0x40
+#define TEST_SERIAL_BYTES_PER_SECOND (115200 / 10)
+#define TEST_STEPS_PER_BATCH     3
+
+/**
+ * @brief Types of the instructions of the simulated debuggee
+ *
+ */
+typedef enum _TEST_INSTRUCTION_TYPE
+{
+    TEST_INSTRUCTION_NOP,
+    TEST_INSTRUCTION_CALL,
+    TEST_INSTRUCTION_RET,
+    TEST_INSTRUCTION_JMP,
+    TEST_INSTRUCTION_LONGJMP, // Jumps to the target and removes the frame of the caller
+
+} TEST_INSTRUCTION_TYPE;
+
+typedef struct _TEST_INSTRUCTION
+{
+    UINT64                Address;
+    TEST_INSTRUCTION_TYPE Type;
+    UINT32                Length;
+    UINT64                Target;
+
+} TEST_INSTRUCTION;
+
+/**
+ * @brief The program of the tests
+ * @details main calls F (which calls F2), G (which never returns to main
+ * but jumps to a handler) and H (an endless loop)
+ *
+ */
+static const TEST_INSTRUCTION g_TestProgram[] = {
+    {0x1000, TEST_INSTRUCTION_NOP, 1, 0},
+    {0x1001, TEST_INSTRUCTION_CALL, 5, 0x2000},
+    {0x1006, TEST_INSTRUCTION_NOP, 2, 0},
+    {0x1008, TEST_INSTRUCTION_CALL, 5, 0x3000},
+    {0x100d, TEST_INSTRUCTION_CALL, 5, 0x4000},
+    {0x1012, TEST_INSTRUCTION_JMP, 2, 0x1000},
+    {0x1100, TEST_INSTRUCTION_NOP, 1, 0},
+    {0x1101, TEST_INSTRUCTION_JMP, 2, 0x100d},
+    {0x2000, TEST_INSTRUCTION_NOP, 3, 0},
+    {0x2003, TEST_INSTRUCTION_CALL, 5, 0x2100},
+    {0x2008, TEST_INSTRUCTION_RET, 1, 0},
+    {0x2100, TEST_INSTRUCTION_NOP, 1, 0},
+    {0x2101, TEST_INSTRUCTION_RET, 1, 0},
+    {0x3000, TEST_INSTRUCTION_NOP, 1, 0},
+    {0x3001, TEST_INSTRUCTION_LONGJMP, 2, 0x1100},
+    {0x4000, TEST_INSTRUCTION_JMP, 2, 0x4000},
+};
+
+UINT32           g_TestNumberOfCores   = 2;
+UINT32           g_TestCurrentThreadId = 0x100;
+STEP_TRACE_STATE g_StepTraceState;
+
+/**
+ * @brief The simulated debuggee
+ *
+ */
+static TEST_INSTRUCTION g_TestInstructions[0x800];
+static UINT32           g_TestCountOfInstructions;
+static UINT16           g_TestCodeMap[TEST_MEMORY_SIZE]; // Index of the instruction plus one
+static BYTE             g_TestMemory[TEST_MEMORY_SIZE];
+static UINT64           g_TestStack[(TEST_STACK_TOP - TEST_STACK_BASE) / sizeof(UINT64)];
+static GUEST_REGS       g_TestRegs;
+static UINT64           g_TestRip;
+static UINT64           g_TestRflags;
+static BOOLEAN          g_TestIsStepArmed;
+static BOOLEAN          g_TestIsMtfArmed;
+static UINT64           g_TestCountOfExecuted;
+
+/**
+ * @brief The state after each executed instruction (to be compared with
+ * the records)
+ *
+ */
+static UINT64     g_TestExecutedRips[TEST_MAXIMUM_RECORDS];
+static GUEST_REGS g_TestExecutedRegs[TEST_MAXIMUM_RECORDS];
+static UINT64     g_TestExecutedRflags[TEST_MAXIMUM_RECORDS];
+
+/**
+ * @brief The simulated debugger (decoded records)
+ *
+ */
+static BYTE    g_TestRecords[TEST_MAXIMUM_RECORDS * 256];
+static UINT32  g_TestRecordSize;
+static UINT64  g_TestCountOfRecords;
+static UINT64  g_TestCountOfChunks;
+static UINT64  g_TestBytesOnWire;
+static BOOLEAN g_TestIsLastChunkReceived;
+static BOOLEAN g_TestIsCompleted;
+static BYTE    g_TestReferenceRecords[0x1000 * 256];
+
+//////////////////////////////////////////////////
+//				 Simulated Debuggee  			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Load a program to the memory of the simulated debuggee
+ *
+ */
+static VOID
+TestLoadProgram(const TEST_INSTRUCTION * Program, UINT32 Count)
+{
+    UINT64 RandomState = 0x1234;
+
+    HOST_CHECK(g_TestCountOfInstructions + Count <= RTL_NUMBER_OF(g_TestInstructions));
+
+    for (UINT32 i = 0; i < Count; i++)
+    {
+        g_TestInstructions[g_TestCountOfInstructions] = Program[i];
+        g_TestCodeMap[Program[i].Address]             = (UINT16)(++g_TestCountOfInstructions);
+
+        for (UINT32 j = 0; j < Program[i].Length; j++)
+        {
+            g_TestMemory[Program[i].Address + j] = (BYTE)HostRandom(&RandomState);
+        }
+    }
+}
+
+static const TEST_INSTRUCTION *
+TestFindInstruction(UINT64 Address)
+{
+    if (Address >= TEST_MEMORY_SIZE || g_TestCodeMap[Address] == 0)
+    {
+        return NULL;
+    }
+
+    return &g_TestInstructions[g_TestCodeMap[Address] - 1];
+}
+
+/**
+ * @brief Set the state of the simulated debuggee and the debugger
+ *
+ */
+static VOID
+TestReset(UINT64 Rip)
+{
+    memset(&g_TestRegs, 0, sizeof(g_TestRegs));
+
+    g_TestRegs.rsp            = TEST_STACK_TOP - 0x100;
+    g_TestRip                 = Rip;
+    g_TestRflags              = 0x202;
+    g_TestIsStepArmed         = FALSE;
+    g_TestIsMtfArmed          = FALSE;
+    g_TestCountOfExecuted     = 0;
+    g_TestCountOfRecords      = 0;
+    g_TestCountOfChunks       = 0;
+    g_TestBytesOnWire         = 0;
+    g_TestIsLastChunkReceived = FALSE;
+    g_TestIsCompleted         = FALSE;
+}
+
+/**
+ * @brief Execute one instruction of the simulated debuggee
+ *
+ */
+static VOID
+TestExecute()
+{
+    const TEST_INSTRUCTION * Instruction = TestFindInstruction(g_TestRip);
+
+    HOST_CHECK(Instruction != NULL);
+
+    switch (Instruction->Type)
+    {
+    case TEST_INSTRUCTION_NOP:
+        g_TestRip += Instruction->Length;
+        g_TestRegs.rax++;
+        g_TestRegs.r15 ^= g_TestRegs.rax << 7;
+        g_TestRflags ^= 0x40;
+        break;
+
+    case TEST_INSTRUCTION_CALL:
+        g_TestRegs.rsp -= sizeof(UINT64);
+        HOST_CHECK(g_TestRegs.rsp >= TEST_STACK_BASE && g_TestRegs.rsp < TEST_STACK_TOP);
+        g_TestStack[(g_TestRegs.rsp - TEST_STACK_BASE) / sizeof(UINT64)] = g_TestRip + Instruction->Length;
+        g_TestRip                                                        = Instruction->Target;
+        break;
+
+    case TEST_INSTRUCTION_RET:
+        g_TestRip = g_TestStack[(g_TestRegs.rsp - TEST_STACK_BASE) / sizeof(UINT64)];
+        g_TestRegs.rsp += sizeof(UINT64);
+        break;
+
+    case TEST_INSTRUCTION_JMP:
+        g_TestRip = Instruction->Target;
+        break;
+
+    case TEST_INSTRUCTION_LONGJMP:
+        g_TestRegs.rsp += sizeof(UINT64) + 0x20;
+        g_TestRip = Instruction->Target;
+        break;
+    }
+
+    if (g_TestCountOfExecuted < TEST_MAXIMUM_RECORDS)
+    {
+        g_TestExecutedRips[g_TestCountOfExecuted]   = g_TestRip;
+        g_TestExecutedRegs[g_TestCountOfExecuted]   = g_TestRegs;
+        g_TestExecutedRflags[g_TestCountOfExecuted] = g_TestRflags;
+    }
+
+    g_TestCountOfExecuted++;
+}
+
+/**
+ * @brief Run the simulated debuggee while the steps are armed
+ *
+ * @param DbgState
+ * @param MaximumInstructions The simulation is stopped after this count
+ *
+ * @return BOOLEAN TRUE if the debuggee is halted by the batched steps
+ */
+static BOOLEAN
+TestRun(PROCESSOR_DEBUGGING_STATE * DbgState, UINT64 MaximumInstructions)
+{
+    BOOLEAN IsInstrumentationStep;
+
+    while ((g_TestIsStepArmed || g_TestIsMtfArmed) && g_TestCountOfExecuted < MaximumInstructions)
+    {
+        IsInstrumentationStep = g_TestIsMtfArmed;
+
+        g_TestIsStepArmed = FALSE;
+        g_TestIsMtfArmed  = FALSE;
+
+        TestExecute();
+
+        if (!StepTraceHandleStep(DbgState, IsInstrumentationStep))
+        {
+            //
+            // The debuggee is halted, so the remaining records are sent
+            //
+            StepTraceFinish();
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Start the batched steps and run the simulated debuggee
+ *
+ */
+static BOOLEAN
+TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST StepType,
+              DEBUGGER_STEP_TRACE_RECORD_TYPE  RecordType,
+              UINT32                           RegisterMask,
+              UINT32                           CountOfSteps,
+              BOOLEAN                          StopAtAddress,
+              UINT64                           StopAddress,
+              UINT64                           MaximumInstructions)
+{
+    PROCESSOR_DEBUGGING_STATE DbgState   = {1, &g_TestRegs};
+    DEBUGGEE_STEP_PACKET      StepPacket = {0};
+
+    StepPacket.StepType      = StepType;
+    StepPacket.CountOfSteps  = CountOfSteps;
+    StepPacket.RecordType    = RecordType;
+    StepPacket.RegisterMask  = RegisterMask;
+    StepPacket.StopAtAddress = StopAtAddress;
+    StepPacket.StopAddress   = StopAddress;
+
+    HOST_CHECK(StepTraceStart(&DbgState, &StepPacket));
+
+    return TestRun(&DbgState, MaximumInstructions);
+}
+
+//////////////////////////////////////////////////
+//		Functions of the Debugger (Shims)		//
+//////////////////////////////////////////////////
+
+BOOLEAN
+KdResponsePacketToDebugger(DEBUGGER_REMOTE_PACKET_TYPE             PacketType,
+                           DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION Response,
+                           CHAR *                                  OptionalBuffer,
+                           UINT32                                  OptionalBufferLength)
+{
+    PDEBUGGEE_STEP_TRACE_CHUNK Chunk = (PDEBUGGEE_STEP_TRACE_CHUNK)OptionalBuffer;
+    UINT64                     CountToCopy;
+
+    HOST_CHECK(PacketType == DEBUGGER_REMOTE_PACKET_TYPE_DEBUGGEE_TO_DEBUGGER);
+    HOST_CHECK(Response == DEBUGGER_REMOTE_PACKET_REQUESTED_ACTION_DEBUGGEE_RESULT_OF_STEP_TRACE_RECORDS);
+    HOST_CHECK(OptionalBufferLength <= STEP_TRACE_BUFFER_SIZE);
+    HOST_CHECK(OptionalBufferLength == sizeof(DEBUGGEE_STEP_TRACE_CHUNK) + Chunk->CountOfRecords * Chunk->RecordSize);
+    HOST_CHECK(!g_TestIsLastChunkReceived);
+
+    //
+    // Chunks are contiguous (the step numbers are continued), the steps
+    // without a 'call' or a 'ret' have no record in the call/ret records
+    //
+    HOST_CHECK(Chunk->CountOfRecords == 0 || Chunk->RecordType == DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES ||
+               Chunk->FirstStepNumber == g_TestCountOfRecords);
+
+    g_TestRecordSize = Chunk->RecordSize;
+    CountToCopy      = Chunk->CountOfRecords;
+
+    if (g_TestCountOfRecords + CountToCopy > TEST_MAXIMUM_RECORDS)
+    {
+        CountToCopy = g_TestCountOfRecords < TEST_MAXIMUM_RECORDS ? TEST_MAXIMUM_RECORDS - g_TestCountOfRecords : 0;
+    }
+
+    if (CountToCopy != 0)
+    {
+        HOST_CHECK(g_TestCountOfRecords * Chunk->RecordSize + CountToCopy * Chunk->RecordSize <= sizeof(g_TestRecords));
+
+        memcpy(&g_TestRecords[g_TestCountOfRecords * Chunk->RecordSize],
+               OptionalBuffer + sizeof(DEBUGGEE_STEP_TRACE_CHUNK),
+               CountToCopy * Chunk->RecordSize);
+    }
+
+    g_TestCountOfRecords += Chunk->CountOfRecords;
+    g_TestCountOfChunks++;
+    g_TestBytesOnWire += sizeof(DEBUGGER_REMOTE_PACKET) + OptionalBufferLength + SERIAL_END_OF_BUFFER_CHARS_COUNT;
+    g_TestIsLastChunkReceived = Chunk->IsLastChunk;
+    g_TestIsCompleted         = Chunk->IsCompleted;
+
+    return TRUE;
+}
+
+BOOLEAN
+KdIsGuestOnUsermode32Bit()
+{
+    return FALSE;
+}
+
+VOID
+KdGuaranteedStepInstruction(PROCESSOR_DEBUGGING_STATE * DbgState)
+{
+    g_TestIsMtfArmed = TRUE;
+}
+
+VOID
+KdRegularStepInInstruction(PROCESSOR_DEBUGGING_STATE * DbgState)
+{
+    g_TestIsStepArmed = TRUE;
+}
+
+UINT64
+VmFuncGetLastVmexitRip(UINT32 CoreId)
+{
+    return g_TestRip;
+}
+
+UINT64
+VmFuncGetRflags()
+{
+    return g_TestRflags;
+}
+
+UINT32
+CheckAddressMaximumInstructionLength(PVOID Address)
+{
+    return MAXIMUM_INSTR_SIZE;
+}
+
+BOOLEAN
+MemoryMapperReadMemorySafeOnTargetProcess(UINT64 VaAddressToRead, PVOID BufferToSaveMemory, SIZE_T SizeToRead)
+{
+    HOST_CHECK(VaAddressToRead + SizeToRead <= TEST_MEMORY_SIZE);
+
+    memcpy(BufferToSaveMemory, &g_TestMemory[VaAddressToRead], SizeToRead);
+
+    return TRUE;
+}
+
+BOOLEAN
+DisassemblerCheckCallOrRetInVmxRootOnTargetProcess(PVOID Address, BOOLEAN Is32Bit, BOOLEAN * IsRet, UINT32 * Length)
+{
+    const TEST_INSTRUCTION * Instruction = TestFindInstruction((UINT64)Address);
+
+    if (Instruction == NULL || (Instruction->Type != TEST_INSTRUCTION_CALL && Instruction->Type != TEST_INSTRUCTION_RET))
+    {
+        return FALSE;
+    }
+
+    *IsRet  = Instruction->Type == TEST_INSTRUCTION_RET;
+    *Length = Instruction->Length;
+
+    return TRUE;
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+static UINT64
+TestGetRecordRip(UINT64 Index)
+{
+    return *(UINT64 *)&g_TestRecords[Index * g_TestRecordSize];
+}
+
+/**
+ * @brief Step-in and the instrumentation step-in, every executed
+ * instruction has a record
+ *
+ * @return VOID
+ */
+static VOID
+TestStepIn()
+{
+    DEBUGGER_REMOTE_STEPPING_REQUEST StepTypes[] = {DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN,
+                                                    DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN};
+
+    for (UINT32 Type = 0; Type < RTL_NUMBER_OF(StepTypes); Type++)
+    {
+        TestReset(0x1000);
+
+        HOST_CHECK(TestStepTrace(StepTypes[Type], DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP, 0, 20000, FALSE, 0, 1000000));
+
+        HOST_CHECK(g_TestIsLastChunkReceived);
+        HOST_CHECK(g_TestCountOfExecuted == 20000 && g_TestCountOfRecords == 20000);
+        HOST_CHECK(g_TestCountOfChunks > 1);
+
+        for (UINT64 i = 0; i < g_TestCountOfRecords; i++)
+        {
+            HOST_CHECK(TestGetRecordRip(i) == g_TestExecutedRips[i]);
+        }
+    }
+
+    printf("step-in: 20000 steps in %llu chunks, every instruction is recorded\n", g_TestCountOfChunks);
+}
+
+/**
+ * @brief Records with the registers and the bytes of the instructions
+ *
+ * @return VOID
+ */
+static VOID
+TestRegistersAndMemory()
+{
+    UINT32   Mask = (1 << 0) | (1 << 4) | (1 << 15) | DEBUGGER_STEP_TRACE_REGISTER_MASK_RFLAGS;
+    UINT64 * Values;
+
+    //
+    // RAX, RSP, R15 and RFLAGS
+    //
+    TestReset(0x1000);
+
+    HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS, Mask, 3000, FALSE, 0, 1000000));
+    HOST_CHECK(g_TestRecordSize == 5 * sizeof(UINT64) && g_TestCountOfRecords == 3000);
+
+    for (UINT64 i = 0; i < g_TestCountOfRecords; i++)
+    {
+        Values = (UINT64 *)&g_TestRecords[i * g_TestRecordSize];
+
+        HOST_CHECK(Values[0] == g_TestExecutedRips[i]);
+        HOST_CHECK(Values[1] == g_TestExecutedRegs[i].rax);
+        HOST_CHECK(Values[2] == g_TestExecutedRegs[i].rsp);
+        HOST_CHECK(Values[3] == g_TestExecutedRegs[i].r15);
+        HOST_CHECK(Values[4] == g_TestExecutedRflags[i]);
+    }
+
+    //
+    // All the registers and the bytes of the instruction
+    //
+    TestReset(0x1000);
+
+    HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS, 0, 3000, FALSE, 0, 1000000));
+    HOST_CHECK(g_TestRecordSize == 18 * sizeof(UINT64) + MAXIMUM_INSTR_SIZE && g_TestCountOfRecords == 3000);
+
+    for (UINT64 i = 0; i < g_TestCountOfRecords; i++)
+    {
+        Values = (UINT64 *)&g_TestRecords[i * g_TestRecordSize];
+
+        HOST_CHECK(Values[0] == g_TestExecutedRips[i]);
+        HOST_CHECK(memcmp(&Values[1], &g_TestExecutedRegs[i], sizeof(GUEST_REGS)) == 0);
+        HOST_CHECK(Values[17] == g_TestExecutedRflags[i]);
+        HOST_CHECK(memcmp(&Values[18], &g_TestMemory[Values[0]], MAXIMUM_INSTR_SIZE) == 0);
+    }
+
+    printf("records: the registers, the rflags and the bytes of the instructions match the debuggee\n");
+}
+
+/**
+ * @brief The stop condition (an address)
+ *
+ * @return VOID
+ */
+static VOID
+TestStopAddress()
+{
+    TestReset(0x1000);
+
+    HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP, 0, 1000, TRUE, 0x2101, 1000000));
+
+    //
+    // 0x1001 (call), 0x2000, 0x2003 (call), 0x2100, 0x2101
+    //
+    HOST_CHECK(g_TestIsLastChunkReceived && !g_TestIsCompleted && g_TestCountOfRecords == 5);
+    HOST_CHECK(TestGetRecordRip(4) == 0x2101 && g_TestRip == 0x2101);
+
+    printf("stop address: the steps are stopped at the address\n");
+}
+
+/**
+ * @brief The steps are requested in batches (the debugger checks CTRL+C
+ * between them), the records are the same as the records of one request
+ *
+ * @return VOID
+ */
+static VOID
+TestBatches()
+{
+    DEBUGGER_STEP_TRACE_RECORD_TYPE RecordTypes[] = {DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP,
+                                                     DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES};
+    PROCESSOR_DEBUGGING_STATE       DbgState      = {1, &g_TestRegs};
+    DEBUGGEE_STEP_PACKET            StepPacket    = {0};
+    const UINT32                    CountOfSteps  = 200;
+    UINT64                          SizeOfRecords;
+    UINT32                          PerformedSteps;
+
+    for (UINT32 Type = 0; Type < RTL_NUMBER_OF(RecordTypes); Type++)
+    {
+        //
+        // One request
+        //
+        TestReset(0x1000);
+
+        HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN, RecordTypes[Type], 0, CountOfSteps, FALSE, 0, 1000000));
+        HOST_CHECK(g_TestIsCompleted && g_TestCountOfExecuted == CountOfSteps);
+
+        SizeOfRecords = g_TestCountOfRecords * g_TestRecordSize;
+
+        HOST_CHECK(SizeOfRecords != 0 && SizeOfRecords <= sizeof(g_TestReferenceRecords));
+        memcpy(g_TestReferenceRecords, g_TestRecords, SizeOfRecords);
+
+        //
+        // The same steps in batches (the step numbers and the depth of the
+        // calls are continued)
+        //
+        TestReset(0x1000);
+
+        StepPacket.StepType   = DEBUGGER_REMOTE_STEPPING_REQUEST_INSTRUMENTATION_STEP_IN;
+        StepPacket.RecordType = RecordTypes[Type];
+        PerformedSteps        = 0;
+
+        while (PerformedSteps < CountOfSteps)
+        {
+            StepPacket.CountOfSteps    = CountOfSteps - PerformedSteps < TEST_STEPS_PER_BATCH ? CountOfSteps - PerformedSteps : TEST_STEPS_PER_BATCH;
+            StepPacket.FirstStepNumber = PerformedSteps;
+
+            g_TestIsLastChunkReceived = FALSE;
+
+            HOST_CHECK(StepTraceStart(&DbgState, &StepPacket));
+            HOST_CHECK(TestRun(&DbgState, 1000000));
+            HOST_CHECK(g_TestIsLastChunkReceived && g_TestIsCompleted);
+
+            PerformedSteps += StepPacket.CountOfSteps;
+        }
+
+        HOST_CHECK(g_TestCountOfExecuted == CountOfSteps);
+        HOST_CHECK(g_TestCountOfRecords * g_TestRecordSize == SizeOfRecords);
+        HOST_CHECK(memcmp(g_TestRecords, g_TestReferenceRecords, SizeOfRecords) == 0);
+    }
+
+    printf("batches: the records of the batches are the same as the records of one request\n");
+}
+
+/**
+ * @brief Step-over of a call that returns, a call that never returns to
+ * the caller (its frame is removed), and a call that never returns
+ *
+ * @return VOID
+ */
+static VOID
+TestStepOver()
+{
+    static const UINT64 Expected[] = {0x1001, 0x1006, 0x1008, 0x1100, 0x1101, 0x100d};
+
+    TestReset(0x1000);
+
+    //
+    // The simulation is stopped if the step-over never finishes
+    //
+    HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_OVER, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP, 0, 1000, FALSE, 0, 16 * STEP_TRACE_MAXIMUM_STEPS_IN_CALL));
+
+    HOST_CHECK(g_TestIsLastChunkReceived);
+    HOST_CHECK(g_TestCountOfRecords == RTL_NUMBER_OF(Expected));
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(Expected); i++)
+    {
+        HOST_CHECK(TestGetRecordRip(i) == Expected[i]);
+    }
+
+    //
+    // The debuggee is halted in the endless loop of H after the budget
+    //
+    HOST_CHECK(g_TestRip == 0x4000);
+    HOST_CHECK(g_TestCountOfExecuted < 2 * STEP_TRACE_MAXIMUM_STEPS_IN_CALL);
+    HOST_CHECK(!g_StepTraceState.IsActive);
+
+    printf("step-over: returned calls and removed frames are stepped over, the endless call is halted after %llu instructions\n",
+           g_TestCountOfExecuted);
+}
+
+/**
+ * @brief Steps per second of the batched steps (the debuggee side and a
+ * 115200 baud serial link), compared with one step per round trip
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    TEST_INSTRUCTION Loop[1001];
+    const UINT32     CountOfSteps = 10000000;
+    UINT64           Begin;
+    UINT64           Time;
+    double           BytesPerRegularStep;
+
+    for (UINT32 i = 0; i < 1000; i++)
+    {
+        Loop[i] = (TEST_INSTRUCTION) {0x8000 + i, TEST_INSTRUCTION_NOP, 1, 0};
+    }
+
+    Loop[1000] = (TEST_INSTRUCTION) {0x8000 + 1000, TEST_INSTRUCTION_JMP, 2, 0x8000};
+
+    TestLoadProgram(Loop, RTL_NUMBER_OF(Loop));
+
+    TestReset(0x8000);
+
+    Begin = HostTimeNs();
+    HOST_CHECK(TestStepTrace(DEBUGGER_REMOTE_STEPPING_REQUEST_STEP_IN, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP, 0, CountOfSteps, FALSE, 0, CountOfSteps + 1));
+    Time = HostTimeNs() - Begin;
+
+    HOST_CHECK(g_TestCountOfRecords == CountOfSteps);
+
+    //
+    // A regular step is a stepping packet and a paused packet
+    //
+    BytesPerRegularStep = (double)(sizeof(DEBUGGER_REMOTE_PACKET) + sizeof(DEBUGGEE_STEP_PACKET) + SERIAL_END_OF_BUFFER_CHARS_COUNT) +
+                          (double)(sizeof(DEBUGGER_REMOTE_PACKET) + sizeof(DEBUGGEE_KD_PAUSED_PACKET) + SERIAL_END_OF_BUFFER_CHARS_COUNT);
+
+    printf("benchmark: %u steps (rip records) in %llu chunks, %.1f M steps/s in the simulated debuggee, "
+           "%.0f steps/s on a 115200 baud link (%.1f bytes per step) vs %.0f steps/s with a round trip per step\n",
+           CountOfSteps,
+           g_TestCountOfChunks,
+           (double)CountOfSteps * 1e3 / (double)Time,
+           (double)CountOfSteps * TEST_SERIAL_BYTES_PER_SECOND / (double)g_TestBytesOnWire,
+           (double)g_TestBytesOnWire / CountOfSteps,
+           TEST_SERIAL_BYTES_PER_SECOND / BytesPerRegularStep);
+}
+
+int
+main()
+{
+    HOST_CHECK(StepTraceInitialize());
+
+    TestLoadProgram(g_TestProgram, RTL_NUMBER_OF(g_TestProgram));
+
+    TestStepIn();
+    TestRegistersAndMemory();
+    TestStopAddress();
+    TestBatches();
+    TestStepOver();
+    TestBenchmark();
+
+    StepTraceUninitialize();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the address to symbol map on the host
+ * @details The map (symbol-map.cpp) is compiled as it is, the threads of
+ * sorting the symbols are simulated by POSIX threads, and the symbols of
+ * the modules are generated by the test instead of the symbol parser
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "../../../include/SDK/headers/Constants.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define MAXUINT32 ((UINT32) ~((UINT32)0))
+#define MAXUINT64 ((UINT64) ~((UINT64)0))
+#define WINAPI
+#define INFINITE 0xffffffff
+
+typedef PVOID LPVOID;
+
+typedef DWORD (*LPTHREAD_START_ROUTINE)(LPVOID Parameter);
+
+static inline UCHAR
+_BitScanForward64(ULONG * Index, UINT64 Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+
+    *Index = (ULONG)__builtin_ctzll(Mask);
+
+    return 1;
+}
+
+//
+// Number of the processors that are reported to the map (set by the test,
+// so the parallel sort is also tested on machines with fewer processors)
+//
+extern DWORD g_TestNumberOfProcessors;
+
+typedef struct _SYSTEM_INFO
+{
+    DWORD dwNumberOfProcessors;
+
+} SYSTEM_INFO;
+
+static inline VOID
+GetSystemInfo(SYSTEM_INFO * SystemInfo)
+{
+    SystemInfo->dwNumberOfProcessors = g_TestNumberOfProcessors;
+}
+
+/**
+ * @brief A simulated thread (the handle points to this structure)
+ *
+ */
+typedef struct _TEST_THREAD
+{
+    pthread_t              Thread;
+    LPTHREAD_START_ROUTINE StartRoutine;
+    LPVOID                 Parameter;
+
+} TEST_THREAD;
+
+static inline void *
+TestThreadRoutine(void * Parameter)
+{
+    TEST_THREAD * Thread = (TEST_THREAD *)Parameter;
+
+    Thread->StartRoutine(Thread->Parameter);
+
+    return NULL;
+}
+
+static inline HANDLE
+CreateThread(PVOID Attributes, SIZE_T StackSize, LPTHREAD_START_ROUTINE StartRoutine, LPVOID Parameter, DWORD Flags, DWORD * ThreadId)
+{
+    TEST_THREAD * Thread = new TEST_THREAD;
+
+    UNREFERENCED_PARAMETER(Attributes);
+    UNREFERENCED_PARAMETER(StackSize);
+    UNREFERENCED_PARAMETER(Flags);
+    UNREFERENCED_PARAMETER(ThreadId);
+
+    Thread->StartRoutine = StartRoutine;
+    Thread->Parameter    = Parameter;
+
+    if (pthread_create(&Thread->Thread, NULL, TestThreadRoutine, Thread) != 0)
+    {
+        delete Thread;
+        return NULL;
+    }
+
+    return (HANDLE)Thread;
+}
+
+static inline DWORD
+WaitForSingleObject(HANDLE Handle, DWORD Milliseconds)
+{
+    UNREFERENCED_PARAMETER(Milliseconds);
+
+    pthread_join(((TEST_THREAD *)Handle)->Thread, NULL);
+
+    return 0;
+}
+
+static inline BOOL
+CloseHandle(HANDLE Handle)
+{
+    delete (TEST_THREAD *)Handle;
+
+    return TRUE;
+}
+
+//
+// Implemented by the test (the symbols of the loaded modules), the callback
+// is passed by its type as GCC doesn't convert function pointers to void *
+//
+typedef VOID (*TEST_SYMBOL_CALLBACK)(UINT64 Address, char * ModuleName, char * ObjectName, unsigned int ObjectSize);
+
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerWrapper(TEST_SYMBOL_CALLBACK CallbackFunction);
+
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModuleWrapper(TEST_SYMBOL_CALLBACK CallbackFunction, UINT64 BaseAddress);
+
+//////////////////////////////////////////////////
+//               Symbol Map                     //
+//////////////////////////////////////////////////
+
+#include "../../../libhyperdbg/header/symbol-map.h"
@@ -0,0 +1,649 @@
+/**
+ * @file test-symbol-map.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the address to symbol map
+ * @details Modules are loaded, reloaded, and unloaded in a random order and
+ * the lookups are compared with a reference std::map (symbols at the same
+ * address are shown in the order of loading them). The build time and the
+ * lookup time of a large map (2M symbols by default) are also measured
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+#define TEST_MODULES_BASE            0x7ff800000000ull
+#define TEST_SIZE_OF_MODULE          0x400000ull
+#define TEST_COUNT_OF_MODULES        48
+#define TEST_COUNT_OF_OVERLAPPED     8
+#define TEST_COUNT_OF_ROUNDS         300
+#define TEST_LOOKUPS_PER_ROUND       2000
+#define TEST_COUNT_OF_LOOKUPS        10000000
+#define TEST_SYMBOLS_PER_BIG_MODULE  2000000
+
+/**
+ * @brief A module of the simulated symbol parser
+ *
+ */
+typedef struct _TEST_MODULE
+{
+    std::string         Name;
+    UINT64              BaseAddress;
+    UINT32              Generation; // Changed when the module is reloaded (names are also changed)
+    std::vector<UINT64> Addresses;
+    std::vector<UINT32> Sizes;
+
+} TEST_MODULE;
+
+/**
+ * @brief A symbol of the reference map
+ *
+ */
+typedef struct _TEST_REFERENCE_SYMBOL
+{
+    struct _TEST_MODULE * Module;
+    UINT32                Index;
+    UINT32                Generation; // Generation of the module when the symbol is added
+
+} TEST_REFERENCE_SYMBOL;
+
+//
+// Global variables of libhyperdbg
+//
+SYMBOL_MAP         g_DisassemblerSymbolMap;
+SYMBOL_MAP_STAGING g_DisassemblerSymbolMapStaging;
+DWORD              g_TestNumberOfProcessors = 1;
+
+//
+// Modules of the simulated symbol parser (in the order of loading them)
+//
+static std::vector<TEST_MODULE *> g_TestLoadedModules;
+
+//////////////////////////////////////////////////
+//				Simulated Symbol Parser    		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Generate the symbols of a module
+ * @details Symbols are not sorted (same as the PDB files), some of them
+ * have the same address and some of them don't have a size
+ *
+ * @param Module
+ * @param CountOfSymbols
+ * @param RandomState
+ *
+ * @return VOID
+ */
+static VOID
+TestGenerateModule(TEST_MODULE * Module, UINT32 CountOfSymbols, UINT64 * RandomState)
+{
+    Module->Addresses.resize(CountOfSymbols);
+    Module->Sizes.resize(CountOfSymbols);
+
+    for (UINT32 i = 0; i < CountOfSymbols; i++)
+    {
+        UINT64 Random = HostRandom(RandomState);
+
+        if (i != 0 && Random % 32 == 0)
+        {
+            Module->Addresses[i] = Module->Addresses[(size_t)((Random >> 8) % i)];
+        }
+        else
+        {
+            Module->Addresses[i] = Module->BaseAddress + (((Random >> 8) % TEST_SIZE_OF_MODULE) & ~0xfull);
+        }
+
+        Module->Sizes[i] = (Random >> 48) % 8 == 0 ? 0 : (UINT32)((Random >> 32) % 0x400);
+    }
+}
+
+/**
+ * @brief Get the name of a symbol of a module
+ *
+ * @param Module
+ * @param Index
+ * @param Name
+ * @param NameSize
+ *
+ * @return VOID
+ */
+static VOID
+TestGetSymbolName(TEST_MODULE * Module, UINT32 Index, char * Name, size_t NameSize)
+{
+    snprintf(Name, NameSize, "Function%x_%u", Index, Module->Generation);
+}
+
+/**
+ * @brief Pass the symbols of a module to the callback
+ *
+ * @param Callback
+ * @param Module
+ *
+ * @return VOID
+ */
+static VOID
+TestEnumerateModule(TEST_SYMBOL_CALLBACK Callback, TEST_MODULE * Module)
+{
+    char Name[64];
+
+    for (UINT32 i = 0; i < Module->Addresses.size(); i++)
+    {
+        TestGetSymbolName(Module, i, Name, sizeof(Name));
+        Callback(Module->Addresses[i], (char *)Module->Name.c_str(), Name, Module->Sizes[i]);
+    }
+}
+
+/**
+ * @brief Enumerate the symbols of all of the loaded modules
+ *
+ * @param CallbackFunction
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerWrapper(TEST_SYMBOL_CALLBACK CallbackFunction)
+{
+    for (auto Module : g_TestLoadedModules)
+    {
+        TestEnumerateModule(CallbackFunction, Module);
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Enumerate the symbols of one loaded module
+ *
+ * @param CallbackFunction
+ * @param BaseAddress
+ *
+ * @return BOOLEAN
+ */
+BOOLEAN
+ScriptEngineCreateSymbolTableForDisassemblerFromModuleWrapper(TEST_SYMBOL_CALLBACK CallbackFunction, UINT64 BaseAddress)
+{
+    for (auto Module : g_TestLoadedModules)
+    {
+        if (Module->BaseAddress == BaseAddress)
+        {
+            TestEnumerateModule(CallbackFunction, Module);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+//////////////////////////////////////////////////
+//				    Reference Map       		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Add the symbols of a module to the reference map (after the
+ * symbols that are already at the same addresses)
+ *
+ * @param Reference
+ * @param Module
+ *
+ * @return VOID
+ */
+static VOID
+TestReferenceAddModule(std::map<UINT64, std::vector<TEST_REFERENCE_SYMBOL>> & Reference, TEST_MODULE * Module)
+{
+    for (UINT32 i = 0; i < Module->Addresses.size(); i++)
+    {
+        Reference[Module->Addresses[i]].push_back({Module, i, Module->Generation});
+    }
+}
+
+/**
+ * @brief Remove the symbols of a module from the reference map
+ *
+ * @param Reference
+ * @param Module
+ *
+ * @return VOID
+ */
+static VOID
+TestReferenceRemoveModule(std::map<UINT64, std::vector<TEST_REFERENCE_SYMBOL>> & Reference, TEST_MODULE * Module)
+{
+    for (auto Address : Module->Addresses)
+    {
+        auto It = Reference.find(Address);
+
+        if (It == Reference.end())
+        {
+            continue;
+        }
+
+        auto & Symbols = It->second;
+
+        Symbols.erase(std::remove_if(Symbols.begin(), Symbols.end(), [&](const TEST_REFERENCE_SYMBOL & Symbol) { return Symbol.Module == Module; }),
+                      Symbols.end());
+
+        if (Symbols.empty())
+        {
+            Reference.erase(It);
+        }
+    }
+}
+
+/**
+ * @brief Compare a lookup of the map with the reference map
+ *
+ * @param Reference
+ * @param Address
+ *
+ * @return VOID
+ */
+static VOID
+TestCheckLookup(const std::map<UINT64, std::vector<TEST_REFERENCE_SYMBOL>> & Reference, UINT64 Address)
+{
+    UINT64                        ObjectAddress = 0;
+    UINT32                        ObjectSize    = 0;
+    const char *                  ObjectName    = NULL;
+    BOOLEAN                       IsFound       = SymbolMapLookup(Address, &ObjectAddress, &ObjectSize, &ObjectName);
+    auto                          It            = Reference.upper_bound(Address);
+    const TEST_REFERENCE_SYMBOL * Symbol;
+    char                          Name[128];
+
+    if (It == Reference.begin())
+    {
+        HOST_CHECK(!IsFound);
+        HOST_CHECK(SymbolMapLookupExact(Address) == NULL);
+        return;
+    }
+
+    It--;
+
+    //
+    // The last symbol of the address is shown
+    //
+    Symbol = &It->second.back();
+
+    HOST_CHECK(Symbol->Generation == Symbol->Module->Generation);
+
+    snprintf(Name, sizeof(Name), "%s!", Symbol->Module->Name.c_str());
+    TestGetSymbolName(Symbol->Module, Symbol->Index, Name + strlen(Name), sizeof(Name) - strlen(Name));
+
+    HOST_CHECK(IsFound);
+    HOST_CHECK(ObjectAddress == It->first);
+    HOST_CHECK(ObjectSize == (Symbol->Module->Sizes[Symbol->Index] == 0 ? DISASSEMBLY_MAXIMUM_DISTANCE_FROM_OBJECT_NAME : Symbol->Module->Sizes[Symbol->Index]));
+    HOST_CHECK(strcmp(ObjectName, Name) == 0);
+
+    if (It->first == Address)
+    {
+        HOST_CHECK(SymbolMapLookupExact(Address) == ObjectName);
+    }
+    else
+    {
+        HOST_CHECK(SymbolMapLookupExact(Address) == NULL);
+    }
+}
+
+/**
+ * @brief Compare the map with the reference map
+ *
+ * @param Reference
+ * @param RandomState
+ *
+ * @return VOID
+ */
+static VOID
+TestCheckMap(const std::map<UINT64, std::vector<TEST_REFERENCE_SYMBOL>> & Reference, UINT64 * RandomState)
+{
+    size_t CountOfSymbols = 0;
+
+    for (auto & Entry : Reference)
+    {
+        CountOfSymbols += Entry.second.size();
+    }
+
+    HOST_CHECK(g_DisassemblerSymbolMap.Addresses.size() == CountOfSymbols);
+    HOST_CHECK(std::is_sorted(g_DisassemblerSymbolMap.Addresses.begin(), g_DisassemblerSymbolMap.Addresses.end()));
+
+    //
+    // Boundaries of the map
+    //
+    TestCheckLookup(Reference, 0);
+    TestCheckLookup(Reference, MAXUINT64);
+
+    if (!Reference.empty())
+    {
+        TestCheckLookup(Reference, Reference.begin()->first - 1);
+        TestCheckLookup(Reference, Reference.begin()->first);
+        TestCheckLookup(Reference, Reference.rbegin()->first);
+        TestCheckLookup(Reference, Reference.rbegin()->first + 1);
+    }
+
+    for (UINT32 i = 0; i < TEST_LOOKUPS_PER_ROUND; i++)
+    {
+        UINT64 Random  = HostRandom(RandomState);
+        UINT64 Address = TEST_MODULES_BASE - TEST_SIZE_OF_MODULE + (Random % ((TEST_COUNT_OF_MODULES + 2) * TEST_SIZE_OF_MODULE));
+
+        TestCheckLookup(Reference, Address);
+
+        //
+        // Exact addresses of the symbols and their neighbors
+        //
+        auto It = Reference.lower_bound(Address);
+
+        if (It != Reference.end())
+        {
+            TestCheckLookup(Reference, It->first - 1);
+            TestCheckLookup(Reference, It->first);
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+//				      Tests             		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Load, reload, and unload modules in a random order
+ * @details Some of the modules are located at the same addresses, so the
+ * previous symbols should be shown again when the last module is unloaded
+ *
+ * @return VOID
+ */
+static VOID
+TestIncrementalLoading()
+{
+    std::vector<TEST_MODULE>                               Modules(TEST_COUNT_OF_MODULES);
+    std::map<UINT64, std::vector<TEST_REFERENCE_SYMBOL>>   Reference;
+    UINT64                                                 RandomState = 0x5eed;
+    UINT32                                                 Counts[4]   = {0};
+    const DWORD                                            Processors[] = {1, 2, 3, 4, 7, 16};
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_MODULES; i++)
+    {
+        UINT32 Overlapped = i % TEST_COUNT_OF_OVERLAPPED;
+
+        Modules[i].Name        = "module" + std::to_string(i);
+        Modules[i].BaseAddress = TEST_MODULES_BASE + (i * TEST_SIZE_OF_MODULE);
+        Modules[i].Generation  = 0;
+
+        //
+        // One of the modules is large enough to be sorted in parallel (by
+        // an odd number of threads if there are enough processors)
+        //
+        TestGenerateModule(&Modules[i],
+                           i == 0 ? SYMBOL_MAP_PARALLEL_SORT_THRESHOLD * 2 + 17 : 100 + (UINT32)(HostRandom(&RandomState) % 3000),
+                           &RandomState);
+
+        //
+        // The last modules overlap the first ones (half of their symbols are
+        // at the addresses of the symbols of the overlapped module)
+        //
+        if (i >= TEST_COUNT_OF_MODULES - TEST_COUNT_OF_OVERLAPPED)
+        {
+            Modules[i].BaseAddress = Modules[Overlapped].BaseAddress + 0x1000;
+
+            for (size_t j = 0; j < Modules[i].Addresses.size(); j++)
+            {
+                UINT64 Random = HostRandom(&RandomState);
+
+                Modules[i].Addresses[j] = (Random & 1) ? Modules[Overlapped].Addresses[(size_t)((Random >> 8) % Modules[Overlapped].Addresses.size())]
+                                                       : Modules[i].BaseAddress + (((Random >> 8) % TEST_SIZE_OF_MODULE) & ~0xfull);
+            }
+        }
+    }
+
+    SymbolMapClear();
+
+    for (UINT32 Round = 0; Round < TEST_COUNT_OF_ROUNDS; Round++)
+    {
+        TEST_MODULE * Module    = &Modules[(size_t)(HostRandom(&RandomState) % TEST_COUNT_OF_MODULES)];
+        UINT64        Operation = HostRandom(&RandomState) % 16;
+        auto          Loaded    = std::find(g_TestLoadedModules.begin(), g_TestLoadedModules.end(), Module);
+
+        g_TestNumberOfProcessors = Processors[HostRandom(&RandomState) % RTL_NUMBER_OF(Processors)];
+
+        if (Operation == 0)
+        {
+            //
+            // Rebuild the map from all of the loaded modules
+            //
+            SymbolMapBuild();
+
+            Reference.clear();
+
+            for (auto LoadedModule : g_TestLoadedModules)
+            {
+                TestReferenceAddModule(Reference, LoadedModule);
+            }
+
+            Counts[0]++;
+        }
+        else if (Loaded == g_TestLoadedModules.end())
+        {
+            //
+            // Load the module
+            //
+            g_TestLoadedModules.push_back(Module);
+            SymbolMapAddModule(Module->BaseAddress);
+
+            TestReferenceAddModule(Reference, Module);
+
+            Counts[1]++;
+        }
+        else if (Operation < 9)
+        {
+            //
+            // Reload the module (its symbols are replaced, and it's moved
+            // after the other modules)
+            //
+            g_TestLoadedModules.erase(Loaded);
+            g_TestLoadedModules.push_back(Module);
+
+            Module->Generation++;
+
+            SymbolMapAddModule(Module->BaseAddress);
+
+            TestReferenceRemoveModule(Reference, Module);
+            TestReferenceAddModule(Reference, Module);
+
+            Counts[2]++;
+        }
+        else
+        {
+            //
+            // Unload the module
+            //
+            std::vector<SYMBOL_MAP_MODULE> Unloaded(1);
+
+            Unloaded[0].ModuleName = Module->Name;
+
+            g_TestLoadedModules.erase(Loaded);
+
+            SymbolMapRemoveModules(Unloaded);
+            SymbolMapBuildLayout();
+
+            TestReferenceRemoveModule(Reference, Module);
+
+            Counts[3]++;
+        }
+
+        HOST_CHECK(g_DisassemblerSymbolMapStaging.Symbols.empty());
+
+        TestCheckMap(Reference, &RandomState);
+    }
+
+    SymbolMapClear();
+    g_TestLoadedModules.clear();
+
+    printf("incremental loading: %u rebuilds, %u loads, %u reloads, %u unloads are equal to the reference map\n",
+           Counts[0],
+           Counts[1],
+           Counts[2],
+           Counts[3]);
+}
+
+/**
+ * @brief Measure the build time and the lookup time of a large map
+ * @details The lookups are compared with a binary search of the sorted
+ * addresses and with a std::map
+ *
+ * @param CountOfSymbols
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark(UINT32 CountOfSymbols)
+{
+    std::vector<TEST_MODULE> Modules((CountOfSymbols + TEST_SYMBOLS_PER_BIG_MODULE - 1) / TEST_SYMBOLS_PER_BIG_MODULE + 1);
+    std::map<UINT64, UINT32> StdMap;
+    std::vector<UINT64>      Addresses(TEST_COUNT_OF_LOOKUPS);
+    UINT64                   RandomState = 0xbeef;
+    UINT64                   ObjectAddress;
+    UINT32                   ObjectSize;
+    const char *             ObjectName;
+    UINT64                   Checksum[3] = {0};
+    UINT64                   Start;
+    UINT64                   Remaining = CountOfSymbols;
+    double                   LookupNs[3];
+    UINT64                   Lowest;
+    UINT64                   Highest;
+
+    //
+    // Large modules (e.g., the kernel and its drivers), the symbols are
+    // spread over a larger range so most of the addresses are distinct
+    //
+    for (size_t i = 0; i < Modules.size() && Remaining != 0; i++)
+    {
+        UINT32 Count = Remaining > TEST_SYMBOLS_PER_BIG_MODULE ? TEST_SYMBOLS_PER_BIG_MODULE : (UINT32)Remaining;
+
+        Modules[i].Name        = "nt" + std::to_string(i);
+        Modules[i].BaseAddress = TEST_MODULES_BASE + i * TEST_SIZE_OF_MODULE * 64;
+        Modules[i].Generation  = 0;
+
+        Modules[i].Addresses.resize(Count);
+        Modules[i].Sizes.resize(Count);
+
+        for (UINT32 j = 0; j < Count; j++)
+        {
+            UINT64 Random = HostRandom(&RandomState);
+
+            Modules[i].Addresses[j] = Modules[i].BaseAddress + ((Random % (TEST_SIZE_OF_MODULE * 64)) & ~0xfull);
+            Modules[i].Sizes[j]     = (UINT32)((Random >> 40) % 0x400);
+        }
+
+        g_TestLoadedModules.push_back(&Modules[i]);
+        Remaining -= Count;
+    }
+
+    for (DWORD Processors : {1u, 4u, 16u})
+    {
+        g_TestNumberOfProcessors = Processors;
+
+        Start = HostTimeNs();
+        SymbolMapBuild();
+
+        printf("benchmark: %u symbols are built in %.1f ms (%lu processors reported to the sort, %ld online)\n",
+               CountOfSymbols,
+               (double)(HostTimeNs() - Start) / 1e6,
+               Processors,
+               sysconf(_SC_NPROCESSORS_ONLN));
+    }
+
+    HOST_CHECK(g_DisassemblerSymbolMap.Addresses.size() == CountOfSymbols);
+
+    //
+    // Last symbol of each address (same as the map)
+    //
+    for (size_t i = 0; i < g_DisassemblerSymbolMap.Addresses.size(); i++)
+    {
+        StdMap[g_DisassemblerSymbolMap.Addresses[i]] = (UINT32)i;
+    }
+
+    Lowest  = g_DisassemblerSymbolMap.Addresses.front();
+    Highest = g_DisassemblerSymbolMap.Addresses.back() + 0x1000;
+
+    for (auto & Address : Addresses)
+    {
+        Address = Lowest - 0x100 + (HostRandom(&RandomState) % (Highest - Lowest + 0x100));
+    }
+
+    //
+    // The map (Eytzinger layout)
+    //
+    Start = HostTimeNs();
+
+    for (auto Address : Addresses)
+    {
+        if (SymbolMapLookup(Address, &ObjectAddress, &ObjectSize, &ObjectName))
+        {
+            Checksum[0] += ObjectAddress + ObjectSize;
+        }
+    }
+
+    LookupNs[0] = (double)(HostTimeNs() - Start) / TEST_COUNT_OF_LOOKUPS;
+
+    //
+    // Binary search of the sorted addresses
+    //
+    Start = HostTimeNs();
+
+    for (auto Address : Addresses)
+    {
+        auto It = std::upper_bound(g_DisassemblerSymbolMap.Addresses.begin(), g_DisassemblerSymbolMap.Addresses.end(), Address);
+
+        if (It != g_DisassemblerSymbolMap.Addresses.begin())
+        {
+            size_t Index = It - g_DisassemblerSymbolMap.Addresses.begin() - 1;
+
+            Checksum[1] += g_DisassemblerSymbolMap.Addresses[Index] + g_DisassemblerSymbolMap.Sizes[Index];
+        }
+    }
+
+    LookupNs[1] = (double)(HostTimeNs() - Start) / TEST_COUNT_OF_LOOKUPS;
+
+    //
+    // std::map
+    //
+    Start = HostTimeNs();
+
+    for (auto Address : Addresses)
+    {
+        auto It = StdMap.upper_bound(Address);
+
+        if (It != StdMap.begin())
+        {
+            It--;
+            Checksum[2] += It->first + g_DisassemblerSymbolMap.Sizes[It->second];
+        }
+    }
+
+    LookupNs[2] = (double)(HostTimeNs() - Start) / TEST_COUNT_OF_LOOKUPS;
+
+    HOST_CHECK(Checksum[0] == Checksum[1] && Checksum[0] == Checksum[2]);
+
+    printf("benchmark: %u lookups, %.1f ns per lookup (binary search: %.1f ns, std::map: %.1f ns)\n",
+           TEST_COUNT_OF_LOOKUPS,
+           LookupNs[0],
+           LookupNs[1],
+           LookupNs[2]);
+
+    SymbolMapClear();
+    g_TestLoadedModules.clear();
+}
+
+int
+main(int argc, char ** argv)
+{
+    UINT32 CountOfSymbols = argc > 1 ? (UINT32)strtoul(argv[1], NULL, 0) : 2000000;
+
+    TestIncrementalLoading();
+    TestBenchmark(CountOfSymbols);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
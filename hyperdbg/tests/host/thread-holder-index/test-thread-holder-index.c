@@ -0,0 +1,390 @@
+/**
+ * @file test-thread-holder-index.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Model test and benchmark of the thread holder indexes
+ * @details
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of simulated ids (thread ids are multiples of four)
+ *
+ */
+#define TEST_MAXIMUM_IDS 12000
+
+/**
+ * @brief Number of threads in the benchmark
+ *
+ */
+#define TEST_BENCHMARK_THREADS 10000
+
+/**
+ * @brief Simulated details of a thread (the id is kept in the details to
+ * check the lock-free readers)
+ *
+ */
+typedef struct _TEST_DETAILS
+{
+    UINT32 Id;
+    UINT32 Generation;
+
+} TEST_DETAILS, *PTEST_DETAILS;
+
+/**
+ * @brief The index under test (and the lock of its writers)
+ *
+ */
+USERMODE_DEBUGGING_INDEX g_TestIndex;
+pthread_mutex_t          g_TestIndexLock = PTHREAD_MUTEX_INITIALIZER;
+volatile BOOLEAN         g_TestStopReaders;
+
+//////////////////////////////////////////////////
+//				      Helpers       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Allocate and initialize the index under test
+ *
+ * @param Bits
+ * @return VOID
+ */
+static VOID
+TestAllocateIndex(UINT32 Bits)
+{
+    PUSERMODE_DEBUGGING_INDEX_ENTRY Entries;
+
+    Entries = calloc((SIZE_T)1 << Bits, sizeof(USERMODE_DEBUGGING_INDEX_ENTRY));
+    HOST_CHECK(Entries != NULL);
+
+    ThreadHolderIndexInitialize(&g_TestIndex, Entries, Bits);
+}
+
+/**
+ * @brief Detach and free the index under test
+ *
+ * @return VOID
+ */
+static VOID
+TestFreeIndex()
+{
+    free(ThreadHolderIndexDetach(&g_TestIndex));
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Compare the index with a reference map after random insertions,
+ * replacements and removals
+ *
+ * @return VOID
+ */
+static VOID
+TestModel(UINT32 Bits, UINT32 MaximumIds, UINT32 Steps)
+{
+    static TEST_DETAILS  Details[TEST_MAXIMUM_IDS][2];
+    static PTEST_DETAILS Reference[TEST_MAXIMUM_IDS];
+    UINT64               RandomState = 0x1234567887654321ull;
+    UINT32               LiveIds     = 0;
+    UINT32               Overflows   = 0;
+    PVOID                Result;
+
+    memset(Reference, 0, sizeof(Reference));
+
+    TestAllocateIndex(Bits);
+
+    for (UINT32 i = 0; i < MaximumIds; i++)
+    {
+        Details[i][0].Id = Details[i][1].Id = (i + 1) * 4;
+    }
+
+    for (UINT32 Step = 0; Step < Steps; Step++)
+    {
+        UINT32 Number = (UINT32)(HostRandom(&RandomState) % MaximumIds);
+        UINT32 Id     = (Number + 1) * 4;
+        UINT32 Action = (UINT32)(HostRandom(&RandomState) % 8);
+
+        if (Action < 3)
+        {
+            //
+            // Insert (or replace the details of) the id
+            //
+            PTEST_DETAILS NewDetails = &Details[Number][HostRandom(&RandomState) & 1];
+
+            if (ThreadHolderIndexInsert(&g_TestIndex, Id, NewDetails))
+            {
+                LiveIds += Reference[Number] == NULL;
+                Reference[Number] = NewDetails;
+            }
+            else
+            {
+                //
+                // The index is full, it should be marked as overflowed
+                //
+                HOST_CHECK(g_TestIndex.Overflowed);
+                Overflows++;
+            }
+        }
+        else if (Action < 5)
+        {
+            //
+            // Removing with other details should not remove the id
+            //
+            PTEST_DETAILS OtherDetails = Reference[Number] == &Details[Number][0] ? &Details[Number][1] : &Details[Number][0];
+
+            ThreadHolderIndexRemove(&g_TestIndex, Id, OtherDetails);
+
+            if (Reference[Number] != NULL)
+            {
+                ThreadHolderIndexRemove(&g_TestIndex, Id, Reference[Number]);
+                Reference[Number] = NULL;
+                LiveIds--;
+            }
+        }
+
+        //
+        // Check the id with the reference
+        //
+        if (ThreadHolderIndexLookup(&g_TestIndex, Id, &Result))
+        {
+            HOST_CHECK(Result == Reference[Number]);
+        }
+        else
+        {
+            HOST_CHECK(g_TestIndex.Overflowed);
+        }
+
+        HOST_CHECK(g_TestIndex.LiveSlots == LiveIds);
+    }
+
+    //
+    // Check all of the ids
+    //
+    for (UINT32 i = 0; i < MaximumIds; i++)
+    {
+        if (ThreadHolderIndexLookup(&g_TestIndex, (i + 1) * 4, &Result))
+        {
+            HOST_CHECK(Result == Reference[i]);
+        }
+        else
+        {
+            HOST_CHECK(g_TestIndex.Overflowed);
+        }
+    }
+
+    printf("model: %u random operations on %u slots matched the reference map (%u live ids, %u overflows)\n",
+           Steps,
+           1 << Bits,
+           LiveIds,
+           Overflows);
+
+    TestFreeIndex();
+
+    //
+    // A detached index falls back to the lists
+    //
+    HOST_CHECK(!ThreadHolderIndexLookup(&g_TestIndex, 4, &Result) && Result == NULL);
+    HOST_CHECK(!ThreadHolderIndexInsert(&g_TestIndex, 4, &Details[0][0]));
+}
+
+/**
+ * @brief Lock-free reader of the concurrent test
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestReaderThread(void * Parameter)
+{
+    UINT64 RandomState = (UINT64)(ULONG_PTR)Parameter * 0x9E3779B97F4A7C15ull + 1;
+    UINT64 Hits        = 0;
+    PVOID  Result;
+
+    while (!g_TestStopReaders)
+    {
+        UINT32 Id = (UINT32)((HostRandom(&RandomState) % 256) + 1) * 4;
+
+        if (ThreadHolderIndexLookup(&g_TestIndex, Id, &Result) && Result != NULL)
+        {
+            //
+            // The details should always belong to the id (never a torn entry)
+            //
+            HOST_CHECK(((PTEST_DETAILS)Result)->Id == Id);
+            Hits++;
+        }
+    }
+
+    return (void *)(ULONG_PTR)Hits;
+}
+
+/**
+ * @brief Concurrent insertions and removals with lock-free readers, then
+ * free the index while the readers are still running
+ *
+ * @return VOID
+ */
+static VOID
+TestConcurrentReaders()
+{
+    static TEST_DETAILS Details[256][4];
+    pthread_t           Readers[4];
+    UINT64              RandomState = 0xabcdef;
+    UINT64              Hits        = 0;
+    void *              ReaderHits;
+
+    //
+    // A small index to have many reused slots
+    //
+    TestAllocateIndex(9);
+
+    for (UINT32 i = 0; i < 256; i++)
+    {
+        for (UINT32 j = 0; j < 4; j++)
+        {
+            Details[i][j].Id         = (i + 1) * 4;
+            Details[i][j].Generation = j;
+        }
+    }
+
+    g_TestStopReaders = FALSE;
+
+    for (ULONG_PTR i = 0; i < RTL_NUMBER_OF(Readers); i++)
+    {
+        HOST_CHECK(pthread_create(&Readers[i], NULL, TestReaderThread, (void *)i) == 0);
+    }
+
+    for (UINT32 Step = 0; Step < 1000000; Step++)
+    {
+        UINT32 Number = (UINT32)(HostRandom(&RandomState) % 256);
+
+        pthread_mutex_lock(&g_TestIndexLock);
+
+        if (HostRandom(&RandomState) & 1)
+        {
+            ThreadHolderIndexInsert(&g_TestIndex, (Number + 1) * 4, &Details[Number][HostRandom(&RandomState) % 4]);
+        }
+        else
+        {
+            for (UINT32 j = 0; j < 4; j++)
+            {
+                ThreadHolderIndexRemove(&g_TestIndex, (Number + 1) * 4, &Details[Number][j]);
+            }
+        }
+
+        pthread_mutex_unlock(&g_TestIndexLock);
+    }
+
+    //
+    // Free the entries while the readers are running, the freed memory is
+    // poisoned to make a late reader fail the id check
+    //
+    {
+        UINT32                          Size    = sizeof(USERMODE_DEBUGGING_INDEX_ENTRY) << g_TestIndex.Bits;
+        PUSERMODE_DEBUGGING_INDEX_ENTRY Entries = ThreadHolderIndexDetach(&g_TestIndex);
+
+        memset(Entries, 0x41, Size);
+        free(Entries);
+    }
+
+    g_TestStopReaders = TRUE;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(Readers); i++)
+    {
+        pthread_join(Readers[i], &ReaderHits);
+        Hits += (UINT64)(ULONG_PTR)ReaderHits;
+    }
+
+    printf("concurrent: %llu lock-free hits during 1000000 insertions/removals, no torn entry\n", (unsigned long long)Hits);
+}
+
+/**
+ * @brief Compare the index lookups with walking the threads for 10k threads
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    static TEST_DETAILS Details[TEST_BENCHMARK_THREADS];
+    UINT64              RandomState = 0x5555;
+    UINT64              Start;
+    UINT64              IndexTime;
+    UINT64              WalkTime;
+    UINT64              Checksum = 0;
+    PVOID               Result;
+    const UINT32        Lookups  = 2000000;
+
+    TestAllocateIndex(THREAD_HOLDER_THREAD_INDEX_BITS);
+
+    for (UINT32 i = 0; i < TEST_BENCHMARK_THREADS; i++)
+    {
+        Details[i].Id = (i + 1) * 4;
+        HOST_CHECK(ThreadHolderIndexInsert(&g_TestIndex, Details[i].Id, &Details[i]));
+    }
+
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < Lookups; i++)
+    {
+        UINT32 Id = (UINT32)(HostRandom(&RandomState) % TEST_BENCHMARK_THREADS + 1) * 4;
+
+        HOST_CHECK(ThreadHolderIndexLookup(&g_TestIndex, Id, &Result));
+        Checksum += ((PTEST_DETAILS)Result)->Id;
+    }
+
+    IndexTime = HostTimeNs() - Start;
+
+    //
+    // Walking the threads (like the lists of the thread holders)
+    //
+    Start = HostTimeNs();
+
+    for (UINT32 i = 0; i < Lookups / 100; i++)
+    {
+        UINT32 Id = (UINT32)(HostRandom(&RandomState) % TEST_BENCHMARK_THREADS + 1) * 4;
+
+        for (UINT32 j = 0; j < TEST_BENCHMARK_THREADS; j++)
+        {
+            if (((volatile TEST_DETAILS *)Details)[j].Id == Id)
+            {
+                Checksum += j;
+                break;
+            }
+        }
+    }
+
+    WalkTime = (HostTimeNs() - Start) * 100;
+
+    printf("benchmark: %u threads, index lookup %.1f ns, walking the threads %.1f ns (checksum %llx)\n",
+           TEST_BENCHMARK_THREADS,
+           (double)IndexTime / Lookups,
+           (double)WalkTime / Lookups,
+           (unsigned long long)Checksum);
+
+    TestFreeIndex();
+}
+
+int
+main()
+{
+    TestModel(THREAD_HOLDER_THREAD_INDEX_BITS, TEST_MAXIMUM_IDS, 2000000);
+    TestModel(6, 100, 200000);
+    TestConcurrentReaders();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
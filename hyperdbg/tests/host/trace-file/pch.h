@@ -0,0 +1,31 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the binary execution trace files on the host
+ * @details Only the portable parts (trace-file.cpp) are compiled, the traces
+ * are generated by the test
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Trace Files                    //
+//////////////////////////////////////////////////
+
+#include "../../../libhyperdbg/header/trace-file.h"
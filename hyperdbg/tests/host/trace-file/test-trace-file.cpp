@@ -0,0 +1,631 @@
+/**
+ * @file test-trace-file.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the binary execution trace files
+ * @details A synthetic trace (1e9 instructions by default) of a program with
+ * known basic blocks is written, then it's randomly accessed and analyzed.
+ * The chunks of the batched steps are also saved with their step numbers,
+ * and corrupted files are checked to be safely rejected (it should be built
+ * with the address sanitizer)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+#define TEST_TRACE_FILE_PATH       "test-trace-file.trace"
+#define TEST_CSV_FILE_PATH         "test-trace-file.csv"
+#define TEST_IMAGE_BASE            0x140001000ull
+#define TEST_COUNT_OF_BLOCKS       256
+#define TEST_BLOCK_ALIGNMENT       0x100
+#define TEST_COUNT_OF_RANDOM_READS 1000
+#define TEST_COUNT_OF_FUZZ_ROUNDS  2000
+
+/**
+ * @brief The synthetic program, the blocks are executed in a fixed order
+ * (a permutation) which is repeated
+ *
+ */
+static UINT32              g_TestSizeOfBlocks[TEST_COUNT_OF_BLOCKS]; // Count of instructions of each block
+static UINT8               g_TestLengths[TEST_COUNT_OF_BLOCKS * TEST_BLOCK_ALIGNMENT];
+static std::vector<UINT64> g_TestRips;                              // RIPs of one period
+static std::vector<UINT32> g_TestBlocksOfRips;                      // Block of each RIP of the period
+
+//////////////////////////////////////////////////
+//				  Synthetic Program     		//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Generate the synthetic program
+ *
+ */
+static VOID
+TestGenerateProgram()
+{
+    UINT32 Order[TEST_COUNT_OF_BLOCKS];
+    UINT64 RandomState = 0x5eed;
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_BLOCKS; i++)
+    {
+        Order[i] = i;
+    }
+
+    for (UINT32 i = TEST_COUNT_OF_BLOCKS - 1; i != 0; i--)
+    {
+        std::swap(Order[i], Order[HostRandom(&RandomState) % (i + 1)]);
+    }
+
+    //
+    // Each block has 1 to 16 instructions of 1 to 15 bytes (so a block never
+    // falls through to the next one)
+    //
+    for (UINT32 i = 0; i < TEST_COUNT_OF_BLOCKS; i++)
+    {
+        UINT32 Offset = 0;
+
+        g_TestSizeOfBlocks[i] = 1 + (UINT32)(HostRandom(&RandomState) % 16);
+
+        for (UINT32 j = 0; j < g_TestSizeOfBlocks[i]; j++)
+        {
+            UINT8 Length = (UINT8)(1 + HostRandom(&RandomState) % 15);
+
+            g_TestLengths[i * TEST_BLOCK_ALIGNMENT + Offset] = Length;
+            Offset += Length;
+        }
+    }
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_BLOCKS; i++)
+    {
+        UINT32 Block  = Order[i];
+        UINT32 Offset = 0;
+
+        for (UINT32 j = 0; j < g_TestSizeOfBlocks[Block]; j++)
+        {
+            g_TestRips.push_back(TEST_IMAGE_BASE + Block * TEST_BLOCK_ALIGNMENT + Offset);
+            g_TestBlocksOfRips.push_back(Block);
+
+            Offset += g_TestLengths[Block * TEST_BLOCK_ALIGNMENT + Offset];
+        }
+    }
+}
+
+/**
+ * @brief Get the length of the instruction of a record (instead of the
+ * disassembler)
+ *
+ */
+static UINT32
+TestGetInstructionLength(const TRACE_FILE_RECORD * Record, BOOLEAN Is32Bit, PVOID Context)
+{
+    UINT64 Offset = Record->Rip - TEST_IMAGE_BASE;
+
+    return Offset < sizeof(g_TestLengths) ? g_TestLengths[Offset] : 0;
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Write, randomly access and analyze a synthetic trace
+ *
+ * @param CountOfInstructions
+ *
+ * @return VOID
+ */
+static VOID
+TestSyntheticTrace(UINT64 CountOfInstructions)
+{
+    TRACE_FILE_WRITER              Writer;
+    TRACE_FILE_READER              Reader;
+    TRACE_FILE_RECORD              Record = {0};
+    TRACE_FILE_CHUNK_HEADER        ChunkHeader;
+    TRACE_FILE_ANALYSIS            Analysis = {0};
+    std::vector<TRACE_FILE_RECORD> Records;
+    UINT64                         Period = g_TestRips.size();
+    UINT64                         ExecutedBlocks[TEST_COUNT_OF_BLOCKS] = {0};
+    UINT64                         RandomState                          = 0x1234;
+    UINT64                         Time;
+    UINT64                         WriteTime;
+    UINT64                         ReadTime;
+    UINT64                         AnalysisTime;
+    UINT32                         IndexOfChunk;
+
+    //
+    // Write the trace (the RIP records of one core)
+    //
+    Time = HostTimeNs();
+
+    HOST_CHECK(TraceFileWriterOpen(&Writer, TEST_TRACE_FILE_PATH));
+
+    for (UINT64 i = 0, j = 0; i < CountOfInstructions; i++)
+    {
+        Record.RecordNumber = i;
+        Record.Rip          = g_TestRips[j];
+
+        HOST_CHECK(TraceFileWriterAddRecord(&Writer, 0, DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP, 0, FALSE, &Record));
+
+        if (++j == Period)
+        {
+            j = 0;
+        }
+    }
+
+    HOST_CHECK(TraceFileWriterClose(&Writer));
+
+    WriteTime = HostTimeNs() - Time;
+
+    //
+    // Random access by the chunk index
+    //
+    Time = HostTimeNs();
+
+    HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+    HOST_CHECK(!Reader.IsIndexRebuilt);
+    HOST_CHECK(Reader.Index.size() == (CountOfInstructions + TRACE_FILE_RECORDS_PER_CHUNK - 1) / TRACE_FILE_RECORDS_PER_CHUNK);
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_RANDOM_READS; i++)
+    {
+        UINT64 RecordNumber = HostRandom(&RandomState) % CountOfInstructions;
+
+        HOST_CHECK(TraceFileReaderFindChunk(&Reader, 0, RecordNumber, &IndexOfChunk));
+        HOST_CHECK(TraceFileReaderReadChunk(&Reader, IndexOfChunk, &ChunkHeader, Records));
+
+        PTRACE_FILE_RECORD Found = &Records[(size_t)(RecordNumber - ChunkHeader.FirstRecordNumber)];
+
+        HOST_CHECK(Found->RecordNumber == RecordNumber);
+        HOST_CHECK(Found->Rip == g_TestRips[RecordNumber % Period]);
+    }
+
+    HOST_CHECK(!TraceFileReaderFindChunk(&Reader, 0, CountOfInstructions, &IndexOfChunk));
+    HOST_CHECK(!TraceFileReaderFindChunk(&Reader, 1, 0, &IndexOfChunk));
+
+    ReadTime = HostTimeNs() - Time;
+
+    //
+    // Hot spots and basic blocks
+    //
+    Time = HostTimeNs();
+
+    HOST_CHECK(TraceFileAnalyze(&Reader, TestGetInstructionLength, NULL, &Analysis));
+
+    AnalysisTime = HostTimeNs() - Time;
+
+    for (UINT64 i = 0; i < CountOfInstructions % Period; i++)
+    {
+        if (i == 0 || g_TestBlocksOfRips[i] != g_TestBlocksOfRips[i - 1])
+        {
+            ExecutedBlocks[g_TestBlocksOfRips[i]]++;
+        }
+    }
+
+    HOST_CHECK(Analysis.CountOfRecords == CountOfInstructions);
+    HOST_CHECK(Analysis.RecordsOfCores[0] == CountOfInstructions);
+    HOST_CHECK(Analysis.CountOfChunks == Reader.Index.size());
+    HOST_CHECK(CountOfInstructions < Period || Analysis.Hits.size() == Period);
+    HOST_CHECK(CountOfInstructions < Period || Analysis.BasicBlocks.size() == TEST_COUNT_OF_BLOCKS);
+
+    for (UINT32 i = 0; i < TEST_COUNT_OF_BLOCKS && CountOfInstructions >= Period; i++)
+    {
+        UINT64                   Start = TEST_IMAGE_BASE + i * TEST_BLOCK_ALIGNMENT;
+        TRACE_FILE_BASIC_BLOCK & Block = Analysis.BasicBlocks[Start];
+
+        HOST_CHECK(Block.CountOfInstructions == g_TestSizeOfBlocks[i]);
+        HOST_CHECK(Block.ExecutionCount == CountOfInstructions / Period + ExecutedBlocks[i]);
+        HOST_CHECK(Analysis.Hits[Start] == Block.ExecutionCount);
+    }
+
+    printf("synthetic trace: %llu instructions, %llu chunks, %.2f bytes per instruction\n",
+           CountOfInstructions,
+           (UINT64)Reader.Index.size(),
+           (double)Reader.FileSize / CountOfInstructions);
+
+    printf("synthetic trace: write %.1f M records/s, %u random reads in %.1f ms, analysis %.1f M records/s (%zu basic blocks)\n",
+           (double)CountOfInstructions * 1e3 / WriteTime,
+           TEST_COUNT_OF_RANDOM_READS,
+           (double)ReadTime / 1e6,
+           (double)CountOfInstructions * 1e3 / AnalysisTime,
+           Analysis.BasicBlocks.size());
+
+    TraceFileReaderClose(&Reader);
+    remove(TEST_TRACE_FILE_PATH);
+}
+
+/**
+ * @brief Add a chunk of RIP records of batched steps
+ *
+ */
+static BOOLEAN
+TestAddStepTraceChunk(PTRACE_FILE_WRITER Writer, UINT32 CoreId, UINT64 FirstStepNumber, UINT32 CountOfRecords)
+{
+    std::vector<BYTE>          Buffer(sizeof(DEBUGGEE_STEP_TRACE_CHUNK) + CountOfRecords * sizeof(UINT64));
+    PDEBUGGEE_STEP_TRACE_CHUNK Chunk = (PDEBUGGEE_STEP_TRACE_CHUNK)Buffer.data();
+    UINT64 *                   Rips  = (UINT64 *)(Buffer.data() + sizeof(DEBUGGEE_STEP_TRACE_CHUNK));
+
+    Chunk->RecordType      = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP;
+    Chunk->RecordSize      = sizeof(UINT64);
+    Chunk->CountOfRecords  = CountOfRecords;
+    Chunk->CoreId          = CoreId;
+    Chunk->FirstStepNumber = FirstStepNumber;
+
+    for (UINT32 i = 0; i < CountOfRecords; i++)
+    {
+        Rips[i] = g_TestRips[(FirstStepNumber + i) % g_TestRips.size()];
+    }
+
+    return TraceFileWriterAddStepTraceChunk(Writer, Chunk, (UINT32)Buffer.size());
+}
+
+/**
+ * @brief The records of batched steps are saved with the step numbers of the
+ * debuggee (the steps of a core are not contiguous if the steps are
+ * performed on other cores)
+ *
+ * @return VOID
+ */
+static VOID
+TestStepTraceChunks()
+{
+    TRACE_FILE_WRITER                Writer;
+    TRACE_FILE_READER                Reader;
+    TRACE_FILE_CHUNK_HEADER          ChunkHeader;
+    std::vector<TRACE_FILE_RECORD>   Records;
+    std::vector<BYTE>                Buffer(sizeof(DEBUGGEE_STEP_TRACE_CHUNK) + 3 * sizeof(DEBUGGEE_STEP_TRACE_EDGE_RECORD));
+    PDEBUGGEE_STEP_TRACE_CHUNK       Chunk = (PDEBUGGEE_STEP_TRACE_CHUNK)Buffer.data();
+    PDEBUGGEE_STEP_TRACE_EDGE_RECORD Edges = (PDEBUGGEE_STEP_TRACE_EDGE_RECORD)(Buffer.data() + sizeof(DEBUGGEE_STEP_TRACE_CHUNK));
+    UINT32                           IndexOfChunk;
+
+    HOST_CHECK(TraceFileWriterOpen(&Writer, TEST_TRACE_FILE_PATH));
+
+    //
+    // Steps 0 to 0x4fff on core 0, 0x5000 to 0x50ff on core 1, then
+    // 0x5100 to 0x51ff on core 0 (a batch of 0x1000 steps is received in
+    // several chunks)
+    //
+    for (UINT64 Step = 0; Step < 0x5000; Step += 0x400)
+    {
+        HOST_CHECK(TestAddStepTraceChunk(&Writer, 0, Step, 0x400));
+    }
+
+    HOST_CHECK(TestAddStepTraceChunk(&Writer, 1, 0x5000, 0x100));
+    HOST_CHECK(TestAddStepTraceChunk(&Writer, 0, 0x5100, 0x100));
+
+    //
+    // Steps of a core can't go back
+    //
+    HOST_CHECK(!TestAddStepTraceChunk(&Writer, 0, 0x5100, 0x10));
+
+    //
+    // The call/ret records of core 2 are numbered in the order of the edges
+    //
+    Chunk->RecordType      = DEBUGGER_STEP_TRACE_RECORD_TYPE_CALL_RET_EDGES;
+    Chunk->RecordSize      = sizeof(DEBUGGEE_STEP_TRACE_EDGE_RECORD);
+    Chunk->CountOfRecords  = 3;
+    Chunk->CoreId          = 2;
+    Chunk->FirstStepNumber = 0x1234;
+
+    Edges[0] = {0x1000, 0x2000, 0, FALSE};
+    Edges[1] = {0x2008, 0x1005, 0, TRUE};
+    Edges[2] = {0x1010, 0x3000, 0, FALSE};
+
+    HOST_CHECK(TraceFileWriterAddStepTraceChunk(&Writer, Chunk, (UINT32)Buffer.size()));
+    HOST_CHECK(TraceFileWriterAddStepTraceChunk(&Writer, Chunk, (UINT32)Buffer.size()));
+
+    //
+    // Invalid chunks
+    //
+    Chunk->CountOfRecords = 4;
+    HOST_CHECK(!TraceFileWriterAddStepTraceChunk(&Writer, Chunk, (UINT32)Buffer.size()));
+
+    Chunk->CountOfRecords = 1;
+    Chunk->RecordSize     = sizeof(UINT64);
+    HOST_CHECK(!TraceFileWriterAddStepTraceChunk(&Writer, Chunk, (UINT32)Buffer.size()));
+
+    HOST_CHECK(TraceFileWriterClose(&Writer));
+
+    HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+
+    HOST_CHECK(TraceFileReaderFindChunk(&Reader, 0, 0x5150, &IndexOfChunk));
+    HOST_CHECK(TraceFileReaderReadChunk(&Reader, IndexOfChunk, &ChunkHeader, Records));
+    HOST_CHECK(ChunkHeader.FirstRecordNumber == 0x5100 && Records.size() == 0x100);
+    HOST_CHECK(Records[0x50].RecordNumber == 0x5150 && Records[0x50].Rip == g_TestRips[0x5150 % g_TestRips.size()]);
+
+    HOST_CHECK(TraceFileReaderFindChunk(&Reader, 0, 0x4fff, &IndexOfChunk));
+    HOST_CHECK(TraceFileReaderReadChunk(&Reader, IndexOfChunk, &ChunkHeader, Records));
+    HOST_CHECK(ChunkHeader.FirstRecordNumber == 0x4000 && Records.size() == 0x1000);
+
+    HOST_CHECK(!TraceFileReaderFindChunk(&Reader, 0, 0x5000, &IndexOfChunk));
+    HOST_CHECK(TraceFileReaderFindNextChunk(&Reader, 0, 0x5000, &IndexOfChunk));
+    HOST_CHECK(Reader.Index[IndexOfChunk].FirstRecordNumber == 0x5100);
+    HOST_CHECK(!TraceFileReaderFindNextChunk(&Reader, 0, 0x5101, &IndexOfChunk));
+
+    HOST_CHECK(TraceFileReaderFindChunk(&Reader, 1, 0x50ff, &IndexOfChunk));
+    HOST_CHECK(Reader.Index[IndexOfChunk].FirstRecordNumber == 0x5000);
+
+    HOST_CHECK(TraceFileReaderFindChunk(&Reader, 2, 5, &IndexOfChunk));
+    HOST_CHECK(TraceFileReaderReadChunk(&Reader, IndexOfChunk, &ChunkHeader, Records));
+    HOST_CHECK(ChunkHeader.FirstRecordNumber == 0 && Records.size() == 6);
+    HOST_CHECK(Records[4].IsRet && Records[4].Rip == 0x2008 && Records[4].Target == 0x1005);
+    HOST_CHECK(!TraceFileReaderFindChunk(&Reader, 2, 6, &IndexOfChunk));
+
+    TraceFileReaderClose(&Reader);
+    remove(TEST_TRACE_FILE_PATH);
+
+    printf("batched steps: records are saved with the step numbers of the debuggee\n");
+}
+
+/**
+ * @brief Read a file to the memory
+ *
+ */
+static std::vector<BYTE>
+TestReadFile(const CHAR * Path)
+{
+    std::vector<BYTE> Content;
+    FILE *            File = fopen(Path, "rb");
+
+    HOST_CHECK(File != NULL);
+
+    fseek(File, 0, SEEK_END);
+    Content.resize(ftell(File));
+    fseek(File, 0, SEEK_SET);
+
+    HOST_CHECK(fread(Content.data(), Content.size(), 1, File) == 1);
+    fclose(File);
+
+    return Content;
+}
+
+/**
+ * @brief Write the memory to a file
+ *
+ */
+static VOID
+TestWriteFile(const CHAR * Path, const std::vector<BYTE> & Content, size_t Size)
+{
+    FILE * File = fopen(Path, "wb");
+
+    HOST_CHECK(File != NULL);
+    HOST_CHECK(Size == 0 || fwrite(Content.data(), Size, 1, File) == 1);
+
+    fclose(File);
+}
+
+/**
+ * @brief Open a trace file and decode all of its chunks
+ *
+ * @return BOOLEAN FALSE if any chunk is rejected
+ */
+static BOOLEAN
+TestReadAllChunks(PTRACE_FILE_READER Reader)
+{
+    TRACE_FILE_CHUNK_HEADER        ChunkHeader;
+    std::vector<TRACE_FILE_RECORD> Records;
+    BOOLEAN                        Result = TRUE;
+
+    for (UINT32 i = 0; i < Reader->Index.size(); i++)
+    {
+        if (!TraceFileReaderReadChunk(Reader, i, &ChunkHeader, Records))
+        {
+            Result = FALSE;
+            continue;
+        }
+
+        //
+        // Records are never more than the count of a chunk
+        //
+        HOST_CHECK(Records.size() <= TRACE_FILE_RECORDS_PER_CHUNK);
+    }
+
+    return Result;
+}
+
+/**
+ * @brief Truncated and corrupted files (the counts of records are bounded
+ * before the records are allocated)
+ *
+ * @return VOID
+ */
+static VOID
+TestCorruptedFiles()
+{
+    TRACE_FILE_WRITER        Writer;
+    TRACE_FILE_READER        Reader;
+    TRACE_FILE_RECORD        Record      = {0};
+    UINT64                   RandomState = 0x4321;
+    std::vector<BYTE>        Original;
+    std::vector<BYTE>        Content;
+    PTRACE_FILE_CHUNK_HEADER ChunkHeader;
+    UINT32                   CountOfLines = 0;
+    CHAR                     Line[1024];
+    FILE *                   File;
+
+    //
+    // A small trace with the registers and the bytes of the instructions
+    //
+    HOST_CHECK(TraceFileWriterOpen(&Writer, TEST_TRACE_FILE_PATH));
+
+    for (UINT32 i = 0; i < 3 * TRACE_FILE_RECORDS_PER_CHUNK / 2; i++)
+    {
+        Record.RecordNumber = i / 2;
+        Record.Rip          = g_TestRips[i % g_TestRips.size()];
+        Record.Registers[0] = i * 3;
+        Record.Registers[4] = 0x7fff0000 - i * 8;
+        memset(Record.InstructionBytes, i, MAXIMUM_INSTR_SIZE);
+
+        HOST_CHECK(TraceFileWriterAddRecord(&Writer,
+                                            i % 2,
+                                            i < TRACE_FILE_RECORDS_PER_CHUNK ? DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_AND_REGISTERS
+                                                                              : DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP_REGISTERS_AND_MEMORY_OPERANDS,
+                                            i < TRACE_FILE_RECORDS_PER_CHUNK ? 0x11 : DEBUGGER_STEP_TRACE_REGISTER_MASK_ALL,
+                                            FALSE,
+                                            &Record));
+    }
+
+    HOST_CHECK(TraceFileWriterClose(&Writer));
+
+    Original = TestReadFile(TEST_TRACE_FILE_PATH);
+
+    //
+    // The CSV export has a line for each record
+    //
+    HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+    HOST_CHECK(TestReadAllChunks(&Reader));
+    HOST_CHECK(TraceFileExportCsv(&Reader, TEST_CSV_FILE_PATH));
+    TraceFileReaderClose(&Reader);
+
+    File = fopen(TEST_CSV_FILE_PATH, "r");
+    HOST_CHECK(File != NULL);
+
+    while (fgets(Line, sizeof(Line), File) != NULL)
+    {
+        CountOfLines++;
+    }
+
+    fclose(File);
+    remove(TEST_CSV_FILE_PATH);
+
+    HOST_CHECK(CountOfLines == 1 + 3 * TRACE_FILE_RECORDS_PER_CHUNK / 2);
+
+    //
+    // The index is rebuilt if the file is truncated
+    //
+    TestWriteFile(TEST_TRACE_FILE_PATH, Original, Original.size() - sizeof(TRACE_FILE_FOOTER));
+    HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+    HOST_CHECK(Reader.IsIndexRebuilt && Reader.Index.size() == 4);
+    HOST_CHECK(TestReadAllChunks(&Reader));
+    TraceFileReaderClose(&Reader);
+
+    //
+    // The count of records of a chunk is more than the records of a chunk
+    // or more than its payload
+    //
+    ChunkHeader = (PTRACE_FILE_CHUNK_HEADER)&Original[sizeof(TRACE_FILE_HEADER)];
+
+    UINT32 CountsOfRecords[] = {0xffffffff, TRACE_FILE_RECORDS_PER_CHUNK + 1, ChunkHeader->PayloadSize / 3 + 1};
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(CountsOfRecords); i++)
+    {
+        Content = Original;
+
+        ((PTRACE_FILE_CHUNK_HEADER)&Content[sizeof(TRACE_FILE_HEADER)])->CountOfRecords = CountsOfRecords[i];
+
+        TestWriteFile(TEST_TRACE_FILE_PATH, Content, Content.size());
+        HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+        HOST_CHECK(!TestReadAllChunks(&Reader));
+        TraceFileReaderClose(&Reader);
+
+        //
+        // The same count in a file without the index (the scan is stopped
+        // or the chunk is rejected)
+        //
+        TestWriteFile(TEST_TRACE_FILE_PATH, Content, Content.size() - sizeof(TRACE_FILE_FOOTER));
+        HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+        HOST_CHECK(Reader.Index.empty() || !TestReadAllChunks(&Reader));
+        TraceFileReaderClose(&Reader);
+    }
+
+    //
+    // A chunk of zeros (valid records) with more records than the records
+    // of a chunk, only the index is valid
+    //
+    TRACE_FILE_HEADER       Header     = {TRACE_FILE_MAGIC, TRACE_FILE_VERSION, sizeof(TRACE_FILE_HEADER), TRACE_FILE_RECORDS_PER_CHUNK, 0};
+    TRACE_FILE_CHUNK_HEADER Chunk      = {0};
+    TRACE_FILE_INDEX_ENTRY  IndexEntry = {sizeof(TRACE_FILE_HEADER), 0, 1, 0};
+    TRACE_FILE_FOOTER       Footer     = {0};
+
+    Chunk.Magic            = TRACE_FILE_CHUNK_MAGIC;
+    Chunk.RecordType       = DEBUGGER_STEP_TRACE_RECORD_TYPE_RIP;
+    Chunk.CountOfRecords   = 4 * TRACE_FILE_RECORDS_PER_CHUNK;
+    Chunk.PayloadSize      = Chunk.CountOfRecords;
+    Chunk.UncompressedSize = Chunk.CountOfRecords;
+    Footer.IndexOffset     = sizeof(TRACE_FILE_HEADER) + sizeof(TRACE_FILE_CHUNK_HEADER) + Chunk.PayloadSize;
+    Footer.CountOfEntries  = 1;
+    Footer.Magic           = TRACE_FILE_INDEX_MAGIC;
+
+    Content.assign((BYTE *)&Header, (BYTE *)(&Header + 1));
+    Content.insert(Content.end(), (BYTE *)&Chunk, (BYTE *)(&Chunk + 1));
+    Content.resize(Content.size() + Chunk.PayloadSize);
+    Content.insert(Content.end(), (BYTE *)&IndexEntry, (BYTE *)(&IndexEntry + 1));
+    Content.insert(Content.end(), (BYTE *)&Footer, (BYTE *)(&Footer + 1));
+
+    TestWriteFile(TEST_TRACE_FILE_PATH, Content, Content.size());
+    HOST_CHECK(TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+    HOST_CHECK(!Reader.IsIndexRebuilt && !TestReadAllChunks(&Reader));
+    TraceFileReaderClose(&Reader);
+
+    //
+    // Invalid records per chunk in the header of the file
+    //
+    UINT32 RecordsPerChunk[] = {0, TRACE_FILE_RECORDS_PER_CHUNK + 1};
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(RecordsPerChunk); i++)
+    {
+        Content = Original;
+
+        ((PTRACE_FILE_HEADER)Content.data())->RecordsPerChunk = RecordsPerChunk[i];
+
+        TestWriteFile(TEST_TRACE_FILE_PATH, Content, Content.size());
+        HOST_CHECK(!TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH));
+    }
+
+    //
+    // Random bytes are corrupted, and the file is truncated
+    //
+    for (UINT32 Round = 0; Round < TEST_COUNT_OF_FUZZ_ROUNDS; Round++)
+    {
+        Content = Original;
+
+        for (UINT32 i = 0, Count = 1 + HostRandom(&RandomState) % 8; i < Count; i++)
+        {
+            UINT64 Random = HostRandom(&RandomState);
+
+            //
+            // Headers are more likely to be corrupted
+            //
+            size_t Offset = (Random & 1) ? (size_t)((Random >> 8) % Content.size())
+                                         : (size_t)((Random >> 8) % (sizeof(TRACE_FILE_HEADER) + sizeof(TRACE_FILE_CHUNK_HEADER)));
+
+            Content[Offset] = (BYTE)(Random >> 40);
+        }
+
+        TestWriteFile(TEST_TRACE_FILE_PATH, Content, (Round % 4) == 0 ? (size_t)(HostRandom(&RandomState) % Content.size()) : Content.size());
+
+        if (TraceFileReaderOpen(&Reader, TEST_TRACE_FILE_PATH))
+        {
+            TRACE_FILE_ANALYSIS Analysis = {0};
+
+            TestReadAllChunks(&Reader);
+            TraceFileAnalyze(&Reader, TestGetInstructionLength, NULL, &Analysis);
+
+            TraceFileReaderClose(&Reader);
+        }
+    }
+
+    remove(TEST_TRACE_FILE_PATH);
+
+    printf("corrupted files: truncated files are indexed again, invalid counts of records are rejected (%u fuzzed files)\n",
+           TEST_COUNT_OF_FUZZ_ROUNDS);
+}
+
+int
+main(int argc, char ** argv)
+{
+    UINT64 CountOfInstructions = argc > 1 ? strtoull(argv[1], NULL, 0) : 1000000000ull;
+
+    TestGenerateProgram();
+
+    TestStepTraceChunks();
+    TestCorruptedFiles();
+    TestSyntheticTrace(CountOfInstructions);
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the guest translation cache on the host
+ * @details The physical memory of the guest is simulated by a buffer and
+ * the page-tables are built inside it, each thread is a core with its own
+ * cr3 and execution mode (vmx-root or vmx non-root)
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+typedef union _LARGE_INTEGER
+{
+    struct
+    {
+        UINT32 LowPart;
+        LONG   HighPart;
+    };
+
+    LONG64 QuadPart;
+
+} LARGE_INTEGER, PHYSICAL_ADDRESS;
+
+//
+// Paging structures of ia32-doc (only used as members of PAGE_ENTRY)
+//
+typedef UINT64 PML4E_64;
+typedef UINT64 PDPTE_1GB_64;
+typedef UINT64 PDPTE_64;
+typedef UINT64 PDE_2MB_64;
+typedef UINT64 PDE_64;
+typedef UINT64 PTE_64;
+
+#define PAGE_ALIGN(Va) ((PVOID)((ULONG_PTR)(Va) & ~(PAGE_SIZE - 1)))
+
+/**
+ * @brief The state of the simulated cores
+ *
+ */
+typedef struct _VIRTUAL_MACHINE_STATE
+{
+    BOOLEAN IsOnVmxRootMode;
+
+} VIRTUAL_MACHINE_STATE;
+
+extern VIRTUAL_MACHINE_STATE * g_GuestState;
+extern __thread ULONG          g_TestCurrentCore;
+extern __thread UINT64         g_TestCurrentCr3;
+extern ULONG                   g_TestNumberOfCores;
+extern UINT8 *                 g_TestPhysicalMemory;
+extern UINT64                  g_TestPhysicalMemorySize;
+extern VOID (*g_TestPageTableAccessCallback)(UINT64 PhysicalAddress);
+
+#define KeGetCurrentProcessorNumberEx(Number) (g_TestCurrentCore)
+#define KeQueryActiveProcessorCount(Affinity) (g_TestNumberOfCores)
+#define __readcr3()                           (g_TestCurrentCr3)
+
+static inline PVOID
+PlatformMemAllocateZeroedNonPagedPool(SIZE_T NumberOfBytes)
+{
+    return calloc(1, NumberOfBytes);
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    free(BufferAddress);
+}
+
+static inline UINT64
+PhysicalAddressToVirtualAddress(UINT64 PhysicalAddress)
+{
+    if (PhysicalAddress >= g_TestPhysicalMemorySize)
+    {
+        return (UINT64)NULL;
+    }
+
+    //
+    // Let the test change the page-tables in the middle of a walk
+    //
+    if (g_TestPageTableAccessCallback != NULL)
+    {
+        g_TestPageTableAccessCallback(PhysicalAddress);
+    }
+
+    return (UINT64)(g_TestPhysicalMemory + PhysicalAddress);
+}
+
+static inline CR3_TYPE
+SwitchToProcessMemoryLayoutByCr3(CR3_TYPE TargetCr3)
+{
+    CR3_TYPE PreviousCr3;
+
+    PreviousCr3.Flags = g_TestCurrentCr3;
+    g_TestCurrentCr3  = TargetCr3.Flags;
+
+    return PreviousCr3;
+}
+
+static inline VOID
+SwitchToPreviousProcess(CR3_TYPE PreviousProcess)
+{
+    g_TestCurrentCr3 = PreviousProcess.Flags;
+}
+
+#include "../../../hyperhv/header/memory/MemoryMapper.h"
+#include "../../../hyperhv/header/memory/TranslationCache.h"
+
+//////////////////////////////////////////////////
+//               Globals (GlobalVariables.h)    //
+//////////////////////////////////////////////////
+
+extern TRANSLATION_CACHE_CORE_DATA * g_TranslationCache;
+extern volatile UINT64               g_TranslationCacheEpoch;
@@ -0,0 +1,659 @@
+/**
+ * @file test-translation-cache.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Coherence test and benchmark of the guest translation cache
+ * @details The page-tables of the simulated guest are changed randomly and
+ * the translations of the cache are compared with a reference walker
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Size of the simulated physical memory
+ *
+ */
+#define TEST_PHYSICAL_MEMORY_SIZE (128ull * 1024 * 1024)
+
+/**
+ * @brief Number of simulated cores
+ *
+ */
+#define TEST_NUMBER_OF_CORES 2
+
+/**
+ * @brief Number of simulated address spaces (cr3s)
+ *
+ */
+#define TEST_NUMBER_OF_ADDRESS_SPACES 2
+
+/**
+ * @brief Number of virtual pages that are changed and translated in the tests
+ *
+ */
+#define TEST_NUMBER_OF_PAGES 96
+
+/**
+ * @brief The first simulated data frame (frames below it are page-tables)
+ *
+ */
+#define TEST_FIRST_DATA_FRAME ((96ull * 1024 * 1024) >> 12)
+
+/**
+ * @brief Bits of the page entries
+ *
+ */
+#define TEST_PAGE_PRESENT 0x1ull
+#define TEST_PAGE_WRITE   0x2ull
+#define TEST_PAGE_USER    0x4ull
+#define TEST_PAGE_LARGE   0x80ull
+#define TEST_PAGE_NX      (1ull << 63)
+#define TEST_PAGE_FRAME   0x000ffffffffff000ull
+
+VIRTUAL_MACHINE_STATE * g_GuestState;
+__thread ULONG          g_TestCurrentCore;
+__thread UINT64         g_TestCurrentCr3;
+ULONG                   g_TestNumberOfCores = TEST_NUMBER_OF_CORES;
+UINT8 *                 g_TestPhysicalMemory;
+UINT64                  g_TestPhysicalMemorySize;
+VOID (*g_TestPageTableAccessCallback)(UINT64 PhysicalAddress);
+
+TRANSLATION_CACHE_CORE_DATA * g_TranslationCache;
+volatile UINT64               g_TranslationCacheEpoch;
+
+/**
+ * @brief Next free frame for the page-tables
+ *
+ */
+UINT64 g_TestNextTableFrame;
+
+/**
+ * @brief The cr3s of the simulated address spaces
+ *
+ */
+CR3_TYPE g_TestCr3[TEST_NUMBER_OF_ADDRESS_SPACES];
+
+/**
+ * @brief The virtual pages of the tests (some of them share the same
+ * entry of the cache and some of them are in the same large page)
+ *
+ */
+UINT64 g_TestPages[TEST_NUMBER_OF_PAGES];
+
+//////////////////////////////////////////////////
+//				  Simulated Guest     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Get the pointer of a physical address in the simulated memory
+ *
+ * @param PhysicalAddress
+ * @return UINT64 *
+ */
+static UINT64 *
+TestPhysical(UINT64 PhysicalAddress)
+{
+    HOST_CHECK(PhysicalAddress < g_TestPhysicalMemorySize);
+
+    return (UINT64 *)(g_TestPhysicalMemory + PhysicalAddress);
+}
+
+/**
+ * @brief Allocate a zeroed page-table
+ *
+ * @return UINT64 physical address of the table
+ */
+static UINT64
+TestAllocateTable()
+{
+    UINT64 Address = g_TestNextTableFrame++ << 12;
+
+    HOST_CHECK(g_TestNextTableFrame < TEST_FIRST_DATA_FRAME);
+    memset(TestPhysical(Address), 0, PAGE_SIZE);
+
+    return Address;
+}
+
+/**
+ * @brief Get the entry of an address in the target level (the upper
+ * levels are created if they don't exist)
+ *
+ * @param Cr3
+ * @param Va
+ * @param TargetLevel
+ * @return UINT64 * the entry in the simulated memory
+ */
+static UINT64 *
+TestGetEntry(CR3_TYPE Cr3, UINT64 Va, PAGING_LEVEL TargetLevel)
+{
+    UINT64 Table = Cr3.Fields.PageFrameNumber << 12;
+
+    for (PAGING_LEVEL Level = PagingLevelPageMapLevel4;; Level--)
+    {
+        UINT64 * Entry = TestPhysical(Table + ((Va >> (12 + Level * 9)) & 0x1ff) * sizeof(UINT64));
+
+        if (Level == TargetLevel)
+        {
+            return Entry;
+        }
+
+        if (!(*Entry & TEST_PAGE_PRESENT) || (*Entry & TEST_PAGE_LARGE))
+        {
+            //
+            // Create (or replace the large page with) a new table
+            //
+            *Entry = TestAllocateTable() | TEST_PAGE_PRESENT | TEST_PAGE_WRITE | TEST_PAGE_USER;
+        }
+
+        Table = *Entry & TEST_PAGE_FRAME;
+    }
+}
+
+/**
+ * @brief Reference walker of the simulated page-tables
+ *
+ * @param Cr3
+ * @param Va
+ * @param PhysicalAddress
+ * @param Permissions
+ * @return BOOLEAN TRUE if the page is present
+ */
+static BOOLEAN
+TestReferenceWalk(CR3_TYPE Cr3, UINT64 Va, UINT64 * PhysicalAddress, UINT64 * Permissions)
+{
+    UINT64 Table = Cr3.Fields.PageFrameNumber << 12;
+    UINT64 Flags = TRANSLATION_CACHE_PERMISSION_WRITE | TRANSLATION_CACHE_PERMISSION_USER | TRANSLATION_CACHE_PERMISSION_EXECUTE;
+
+    for (int Level = 3; Level >= 0; Level--)
+    {
+        UINT64 Entry = *TestPhysical(Table + ((Va >> (12 + Level * 9)) & 0x1ff) * sizeof(UINT64));
+
+        if (!(Entry & TEST_PAGE_PRESENT))
+        {
+            return FALSE;
+        }
+
+        Flags &= ~((Entry & TEST_PAGE_WRITE) ? 0 : TRANSLATION_CACHE_PERMISSION_WRITE);
+        Flags &= ~((Entry & TEST_PAGE_USER) ? 0 : TRANSLATION_CACHE_PERMISSION_USER);
+        Flags &= ~((Entry & TEST_PAGE_NX) ? TRANSLATION_CACHE_PERMISSION_EXECUTE : 0);
+
+        if (Level == 0 || ((Level == 1 || Level == 2) && (Entry & TEST_PAGE_LARGE)))
+        {
+            UINT64 Offset = (1ull << (12 + Level * 9)) - 1;
+
+            *PhysicalAddress = ((Entry & TEST_PAGE_FRAME) & ~Offset) + (Va & Offset);
+            *Permissions     = Flags;
+
+            return TRUE;
+        }
+
+        Table = Entry & TEST_PAGE_FRAME;
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Apply a random change to the page-tables of the guest
+ *
+ * @param RandomState
+ * @return VOID
+ */
+static VOID
+TestChangePageTables(UINT64 * RandomState)
+{
+    CR3_TYPE Cr3    = g_TestCr3[HostRandom(RandomState) % TEST_NUMBER_OF_ADDRESS_SPACES];
+    UINT64   Va     = g_TestPages[HostRandom(RandomState) % TEST_NUMBER_OF_PAGES];
+    UINT64   Frame  = TEST_FIRST_DATA_FRAME + HostRandom(RandomState) % 4096;
+    UINT64 * Entry;
+
+    switch (HostRandom(RandomState) % 8)
+    {
+    case 0:
+    case 1:
+
+        //
+        // Map the page to another frame
+        //
+        Entry  = TestGetEntry(Cr3, Va, PagingLevelPageTable);
+        *Entry = (Frame << 12) | TEST_PAGE_PRESENT | (HostRandom(RandomState) & (TEST_PAGE_WRITE | TEST_PAGE_USER)) |
+                 ((HostRandom(RandomState) & 1) ? TEST_PAGE_NX : 0);
+        break;
+
+    case 2:
+
+        //
+        // Unmap the page
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageTable) &= ~TEST_PAGE_PRESENT;
+        break;
+
+    case 3:
+
+        //
+        // Toggle the write permission of the page
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageTable) ^= TEST_PAGE_WRITE;
+        break;
+
+    case 4:
+
+        //
+        // Toggle the permissions of the whole page directory (changes the
+        // accumulated permissions of 512 pages)
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageDirectoryPointerTable) ^= (HostRandom(RandomState) & 1) ? TEST_PAGE_USER : TEST_PAGE_NX;
+        break;
+
+    case 5:
+
+        //
+        // Map the 2MB region as a large page
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageDirectory) = ((Frame << 12) & ~PAGE_2MB_OFFSET) | TEST_PAGE_PRESENT | TEST_PAGE_WRITE | TEST_PAGE_LARGE;
+        break;
+
+    case 6:
+
+        //
+        // Unmap the whole 2MB region
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageDirectory) &= ~TEST_PAGE_PRESENT;
+        break;
+
+    default:
+
+        //
+        // Map the 2MB region by a new page-table that maps the page
+        //
+        *TestGetEntry(Cr3, Va, PagingLevelPageDirectory) = TestAllocateTable() | TEST_PAGE_PRESENT | TEST_PAGE_WRITE;
+        *TestGetEntry(Cr3, Va, PagingLevelPageTable)     = (Frame << 12) | TEST_PAGE_PRESENT | TEST_PAGE_WRITE;
+        break;
+    }
+}
+
+/**
+ * @brief Translate an address by the cache and compare it with the
+ * reference walker
+ *
+ * @param Cr3
+ * @param Va
+ * @return VOID
+ */
+static VOID
+TestCheckTranslation(CR3_TYPE Cr3, UINT64 Va)
+{
+    UINT64  PhysicalAddress = 0, Permissions = 0;
+    UINT64  ExpectedPhysicalAddress = 0, ExpectedPermissions = 0;
+    BOOLEAN Present;
+
+    Present = TranslationCacheTranslate(Cr3, Va, &PhysicalAddress, &Permissions);
+
+    HOST_CHECK(Present == TestReferenceWalk(Cr3, Va, &ExpectedPhysicalAddress, &ExpectedPermissions));
+
+    if (Present)
+    {
+        HOST_CHECK(PhysicalAddress == ExpectedPhysicalAddress);
+        HOST_CHECK(Permissions == ExpectedPermissions);
+    }
+}
+
+/**
+ * @brief Build the simulated guest (two address spaces that map the same
+ * virtual pages)
+ *
+ * @return VOID
+ */
+static VOID
+TestInitializeGuest()
+{
+    UINT64 RandomState = 0x7777;
+
+    g_TestPhysicalMemorySize = TEST_PHYSICAL_MEMORY_SIZE;
+    g_TestPhysicalMemory     = calloc(1, TEST_PHYSICAL_MEMORY_SIZE);
+    g_GuestState             = calloc(TEST_NUMBER_OF_CORES, sizeof(VIRTUAL_MACHINE_STATE));
+    g_TestNextTableFrame     = 1;
+
+    HOST_CHECK(g_TestPhysicalMemory != NULL && g_GuestState != NULL);
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_ADDRESS_SPACES; i++)
+    {
+        g_TestCr3[i].Flags                 = 0;
+        g_TestCr3[i].Fields.PageFrameNumber = TestAllocateTable() >> 12;
+    }
+
+    //
+    // A third of the pages share the same entry of the cache, a third of them are
+    // in the same 2MB region and the others are scattered in the kernel and user
+    // halves of the address space
+    //
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_PAGES; i++)
+    {
+        if (i % 3 == 0)
+        {
+            g_TestPages[i] = 0xfffff80000000000ull + (UINT64)i * TRANSLATION_CACHE_ENTRIES * PAGE_SIZE * 7;
+        }
+        else if (i % 3 == 1)
+        {
+            g_TestPages[i] = 0x7ff600000000ull + (UINT64)i * PAGE_SIZE;
+        }
+        else
+        {
+            g_TestPages[i] = (HostRandom(&RandomState) & 0x7ffffffff000ull) | ((i & 4) ? 0xffff800000000000ull : 0);
+        }
+
+        for (UINT32 j = 0; j < TEST_NUMBER_OF_ADDRESS_SPACES; j++)
+        {
+            *TestGetEntry(g_TestCr3[j], g_TestPages[i], PagingLevelPageTable) =
+                ((TEST_FIRST_DATA_FRAME + i * TEST_NUMBER_OF_ADDRESS_SPACES + j) << 12) | TEST_PAGE_PRESENT | TEST_PAGE_WRITE;
+        }
+    }
+
+    HOST_CHECK(TranslationCacheInitialize());
+
+    //
+    // The kernel cr3 of the system
+    //
+    g_TestCurrentCr3 = g_TestCr3[0].Flags;
+}
+
+/**
+ * @brief Free the simulated guest
+ *
+ * @return VOID
+ */
+static VOID
+TestUninitializeGuest()
+{
+    TranslationCacheUninitialize();
+
+    free(g_TestPhysicalMemory);
+    free(g_GuestState);
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Change the page-tables randomly, each change is followed by either
+ * a VM-exit of the core (the guest changed its page-tables) or an invalidation
+ * (mov to cr3, INVEPT or a write of the debugger), then compare the
+ * translations with the reference walker
+ *
+ * @return VOID
+ */
+static VOID
+TestCoherence()
+{
+    UINT64 RandomState = 0x1234;
+    UINT64 Hits        = 0;
+    UINT64 Misses      = 0;
+    UINT64 Changes     = 0;
+
+    for (UINT32 Step = 0; Step < 200000; Step++)
+    {
+        g_TestCurrentCore                                 = (ULONG)(HostRandom(&RandomState) % TEST_NUMBER_OF_CORES);
+        g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = TRUE;
+
+        if (HostRandom(&RandomState) % 4 == 0)
+        {
+            TestChangePageTables(&RandomState);
+            Changes++;
+
+            if (HostRandom(&RandomState) & 1)
+            {
+                //
+                // The guest changed the page-tables, the other cores will have
+                // a VM-exit before handling it in vmx-root mode
+                //
+                for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+                {
+                    TranslationCacheStartVmexit(i);
+                }
+            }
+            else
+            {
+                TranslationCacheInvalidate();
+            }
+        }
+
+        //
+        // Translate a few pages twice in the same VM-exit (the second ones
+        // are the hits)
+        //
+        for (UINT32 i = 0; i < 4; i++)
+        {
+            UINT64 PageState = RandomState;
+
+            for (UINT32 j = 0; j < 2; j++)
+            {
+                RandomState = PageState;
+
+                TestCheckTranslation(g_TestCr3[HostRandom(&RandomState) % TEST_NUMBER_OF_ADDRESS_SPACES],
+                                     g_TestPages[HostRandom(&RandomState) % TEST_NUMBER_OF_PAGES] + HostRandom(&RandomState) % PAGE_SIZE);
+            }
+        }
+    }
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        TranslationCacheQueryStatistics(i, &Hits, &Misses);
+    }
+
+    //
+    // Make sure that the cache is actually used
+    //
+    HOST_CHECK(Hits > Misses / 4);
+
+    printf("coherence: %llu translations matched the page-tables after %llu random changes (%llu hits, %llu misses)\n",
+           (unsigned long long)(Hits + Misses),
+           (unsigned long long)Changes,
+           (unsigned long long)Hits,
+           (unsigned long long)Misses);
+}
+
+/**
+ * @brief Change the page-tables without an invalidation, the cached translation
+ * is kept until the next VM-exit (or invalidation), but it's never used in vmx
+ * non-root mode
+ *
+ * @return VOID
+ */
+static VOID
+TestInvalidationRequired()
+{
+    UINT64   Va  = g_TestPages[1];
+    CR3_TYPE Cr3 = g_TestCr3[0];
+    UINT64   PhysicalAddress;
+    UINT64   CachedPhysicalAddress;
+    UINT64   Permissions;
+
+    g_TestCurrentCore                                 = 0;
+    g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = TRUE;
+
+    *TestGetEntry(Cr3, Va, PagingLevelPageTable) = ((UINT64)TEST_FIRST_DATA_FRAME << 12) | TEST_PAGE_PRESENT;
+    TranslationCacheInvalidate();
+
+    HOST_CHECK(TranslationCacheTranslate(Cr3, Va, &CachedPhysicalAddress, &Permissions));
+
+    //
+    // Remap the page, the same VM-exit still uses the cached translation
+    //
+    *TestGetEntry(Cr3, Va, PagingLevelPageTable) = ((UINT64)(TEST_FIRST_DATA_FRAME + 1) << 12) | TEST_PAGE_PRESENT;
+
+    HOST_CHECK(TranslationCacheTranslate(Cr3, Va, &PhysicalAddress, &Permissions));
+    HOST_CHECK(PhysicalAddress == CachedPhysicalAddress);
+
+    //
+    // The other core doesn't have it, and vmx non-root mode never uses the cache
+    //
+    g_TestCurrentCore = 1;
+    TestCheckTranslation(Cr3, Va);
+
+    g_TestCurrentCore                                 = 0;
+    g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = FALSE;
+    TestCheckTranslation(Cr3, Va);
+
+    //
+    // The next VM-exit sees the new translation
+    //
+    g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = TRUE;
+    TranslationCacheStartVmexit(g_TestCurrentCore);
+    TestCheckTranslation(Cr3, Va);
+
+    //
+    // Unmapping a page is also seen after the invalidation
+    //
+    *TestGetEntry(Cr3, Va, PagingLevelPageTable) = 0;
+    TranslationCacheInvalidate();
+    HOST_CHECK(!TranslationCacheTranslate(Cr3, Va, &PhysicalAddress, &Permissions));
+
+    printf("invalidation: cached translations are dropped on the next VM-exit or invalidation, never used in vmx non-root\n");
+}
+
+/**
+ * @brief Page-table accesses that change the page-table and invalidate
+ * the cache while a walk is in progress
+ *
+ */
+UINT32 g_TestAccessesBeforeChange;
+UINT64 g_TestChangedEntry;
+
+static VOID
+TestChangeInMiddleOfWalk(UINT64 PhysicalAddress)
+{
+    UNREFERENCED_PARAMETER(PhysicalAddress);
+
+    if (g_TestAccessesBeforeChange != 0 && --g_TestAccessesBeforeChange == 0)
+    {
+        //
+        // Another core (or the debugger) remaps the page and invalidates
+        //
+        *TestPhysical(g_TestChangedEntry) = ((UINT64)(TEST_FIRST_DATA_FRAME + 2) << 12) | TEST_PAGE_PRESENT;
+        TranslationCacheInvalidate();
+    }
+}
+
+/**
+ * @brief The translation of a walk that races with an invalidation is not
+ * used after the invalidation
+ *
+ * @return VOID
+ */
+static VOID
+TestInvalidationInMiddleOfWalk()
+{
+    UINT64   Va  = g_TestPages[4];
+    CR3_TYPE Cr3 = g_TestCr3[0];
+    UINT64 * Entry;
+
+    g_TestCurrentCore                                 = 0;
+    g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = TRUE;
+
+    for (UINT32 Access = 1; Access <= 4; Access++)
+    {
+        Entry  = TestGetEntry(Cr3, Va, PagingLevelPageTable);
+        *Entry = ((UINT64)(TEST_FIRST_DATA_FRAME + 3) << 12) | TEST_PAGE_PRESENT;
+        TranslationCacheInvalidate();
+
+        g_TestChangedEntry            = (UINT64)((UINT8 *)Entry - g_TestPhysicalMemory);
+        g_TestAccessesBeforeChange    = Access;
+        g_TestPageTableAccessCallback = TestChangeInMiddleOfWalk;
+
+        //
+        // The result of this walk might be either of the translations
+        //
+        TranslationCacheTranslate(Cr3, Va, NULL, NULL);
+
+        g_TestPageTableAccessCallback = NULL;
+
+        //
+        // But the next translation in the same VM-exit must be the new one
+        //
+        TestCheckTranslation(Cr3, Va);
+    }
+
+    printf("race: translations of walks that raced with an invalidation are not reused\n");
+}
+
+/**
+ * @brief Compare the cached translations with walking the page-tables
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    const UINT32 Count       = 4000000;
+    UINT64       RandomState = 0x9999;
+    UINT64       Checksum    = 0;
+    UINT64       PhysicalAddress;
+    UINT64       Start;
+    UINT64       CachedTime;
+    UINT64       WalkTime;
+
+    //
+    // Restore the pages (only the pages of a small working set are translated)
+    //
+    for (UINT32 i = 0; i < 16; i++)
+    {
+        *TestGetEntry(g_TestCr3[0], g_TestPages[i * 3 + 1], PagingLevelPageTable) =
+            ((TEST_FIRST_DATA_FRAME + i) << 12) | TEST_PAGE_PRESENT | TEST_PAGE_WRITE;
+    }
+
+    TranslationCacheInvalidate();
+
+    g_TestCurrentCore = 0;
+
+    for (UINT32 Mode = 0; Mode < 2; Mode++)
+    {
+        g_GuestState[g_TestCurrentCore].IsOnVmxRootMode = Mode == 0;
+
+        Start = HostTimeNs();
+
+        for (UINT32 i = 0; i < Count; i++)
+        {
+            HOST_CHECK(TranslationCacheTranslate(g_TestCr3[0], g_TestPages[(HostRandom(&RandomState) % 16) * 3 + 1], &PhysicalAddress, NULL));
+            Checksum += PhysicalAddress;
+        }
+
+        if (Mode == 0)
+        {
+            CachedTime = HostTimeNs() - Start;
+        }
+        else
+        {
+            WalkTime = HostTimeNs() - Start;
+        }
+    }
+
+    printf("benchmark: cached translation %.1f ns, walking the page-tables %.1f ns (checksum %llx)\n",
+           (double)CachedTime / Count,
+           (double)WalkTime / Count,
+           (unsigned long long)Checksum);
+}
+
+int
+main()
+{
+    TestInitializeGuest();
+
+    TestCoherence();
+    TestInvalidationRequired();
+    TestInvalidationInMiddleOfWalk();
+    TestBenchmark();
+
+    TestUninitializeGuest();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
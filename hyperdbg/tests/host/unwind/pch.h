@@ -0,0 +1,19 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the x64 stack unwinder on the host
+ * @details The memory of the target is simulated by a set of regions that
+ * contain the images and the stacks
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#define MAXUINT64 ((UINT64) ~((UINT64)0))
+
+#include "../../../include/components/unwind/header/Unwind.h"
@@ -0,0 +1,570 @@
+/**
+ * @file test-unwind.c
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests and benchmark of the caches of the x64 stack unwinder
+ * @details Synthetic images (headers, exception directory and unwind info)
+ * and stacks are built in the simulated memory, the stacks are unwound and
+ * compared with the frames that are used to build them
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Layout of the synthetic images
+ *
+ */
+#define TEST_IMAGE_NT_HEADERS_OFFSET 0x80
+#define TEST_IMAGE_UNWIND_INFO_RVA   0x1000
+#define TEST_IMAGE_DIRECTORY_RVA     0x2000
+#define TEST_IMAGE_CODE_RVA          0x100000
+#define TEST_IMAGE_FUNCTION_COUNT    20000
+
+/**
+ * @brief Number of frames of each synthetic stack
+ *
+ */
+#define TEST_STACK_FRAMES 64
+
+/**
+ * @brief Kinds of the functions of the synthetic images
+ *
+ */
+typedef enum _TEST_FUNCTION_KIND
+{
+    TEST_FUNCTION_KIND_LEAF,     // No unwind data
+    TEST_FUNCTION_KIND_PUSH_RBX, // push rbx; sub rsp, 20h
+    TEST_FUNCTION_KIND_PUSH_RBP, // push rbp; push rsi; sub rsp, 48h
+
+} TEST_FUNCTION_KIND;
+
+/**
+ * @brief A region of the simulated memory
+ *
+ */
+typedef struct _TEST_REGION
+{
+    UINT64  Base;
+    UINT64  Size;
+    BYTE *  Data;
+    BOOLEAN IsMapped;
+
+} TEST_REGION;
+
+/**
+ * @brief A synthetic image
+ *
+ */
+typedef struct _TEST_IMAGE
+{
+    TEST_REGION * Region;
+    UINT32        FunctionSize; // Distance of the functions
+    UINT32        TimeDateStamp;
+
+} TEST_IMAGE;
+
+/**
+ * @brief An expected frame of a synthetic stack
+ *
+ */
+typedef struct _TEST_FRAME
+{
+    UINT64 Rip;
+    UINT64 ReturnAddressLocation;
+    UINT64 Rbx;
+    UINT64 Rbp;
+    UINT64 Rsi;
+
+} TEST_FRAME;
+
+TEST_REGION g_TestRegions[4];
+UINT64      g_TestCountOfReads;
+
+#define TEST_REGION_USER_IMAGE   (&g_TestRegions[0])
+#define TEST_REGION_KERNEL_IMAGE (&g_TestRegions[1])
+#define TEST_REGION_STACK        (&g_TestRegions[2])
+#define TEST_REGION_JIT          (&g_TestRegions[3])
+
+//////////////////////////////////////////////////
+//				   Simulated Memory 			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Read the simulated memory (the read callback of the unwinder)
+ *
+ * @param Address
+ * @param Buffer
+ * @param Size
+ * @return BOOLEAN
+ */
+static BOOLEAN
+TestReadMemory(UINT64 Address, PVOID Buffer, UINT32 Size)
+{
+    g_TestCountOfReads++;
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(g_TestRegions); i++)
+    {
+        TEST_REGION * Region = &g_TestRegions[i];
+
+        if (Region->IsMapped && Address >= Region->Base && Address - Region->Base <= Region->Size &&
+            Size <= Region->Size - (Address - Region->Base))
+        {
+            memcpy(Buffer, &Region->Data[Address - Region->Base], Size);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Map a region of the simulated memory
+ *
+ * @param Region
+ * @param Base
+ * @param Size
+ * @return VOID
+ */
+static VOID
+TestMapRegion(TEST_REGION * Region, UINT64 Base, UINT64 Size)
+{
+    free(Region->Data);
+
+    Region->Base     = Base;
+    Region->Size     = Size;
+    Region->Data     = calloc(1, Size);
+    Region->IsMapped = TRUE;
+
+    HOST_CHECK(Region->Data != NULL);
+}
+
+static VOID
+TestWrite16(BYTE * Data, UINT16 Value)
+{
+    memcpy(Data, &Value, sizeof(Value));
+}
+
+static VOID
+TestWrite32(BYTE * Data, UINT32 Value)
+{
+    memcpy(Data, &Value, sizeof(Value));
+}
+
+static VOID
+TestWrite64(BYTE * Data, UINT64 Value)
+{
+    memcpy(Data, &Value, sizeof(Value));
+}
+
+//////////////////////////////////////////////////
+//				   Synthetic Images 			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Get the kind of a function of the synthetic images
+ *
+ * @param Index
+ * @return TEST_FUNCTION_KIND
+ */
+static TEST_FUNCTION_KIND
+TestGetFunctionKind(UINT32 Index)
+{
+    if (Index % 5 == 0)
+    {
+        return TEST_FUNCTION_KIND_LEAF;
+    }
+
+    return Index % 2 ? TEST_FUNCTION_KIND_PUSH_RBX : TEST_FUNCTION_KIND_PUSH_RBP;
+}
+
+/**
+ * @brief Build a synthetic image (the headers, the unwind info and the
+ * exception directory)
+ *
+ * @param Image
+ * @param Region
+ * @param Base
+ * @param FunctionSize
+ * @param TimeDateStamp
+ * @return VOID
+ */
+static VOID
+TestBuildImage(TEST_IMAGE * Image, TEST_REGION * Region, UINT64 Base, UINT32 FunctionSize, UINT32 TimeDateStamp)
+{
+    BYTE * Data;
+    BYTE * NtHeaders;
+    UINT32 SizeOfImage = TEST_IMAGE_CODE_RVA + TEST_IMAGE_FUNCTION_COUNT * FunctionSize;
+    UINT32 CountOfEntries = 0;
+
+    //
+    // push rbx (1) ; sub rsp, 20h (5)
+    //
+    static const BYTE PushRbxUnwindInfo[] = {0x01, 0x05, 0x02, 0x00, 0x05, 0x32, 0x01, 0x30};
+
+    //
+    // push rbp (1) ; push rsi (2) ; sub rsp, 48h (6)
+    //
+    static const BYTE PushRbpUnwindInfo[] = {0x01, 0x06, 0x03, 0x00, 0x06, 0x82, 0x02, 0x60, 0x01, 0x50, 0x00, 0x00};
+
+    TestMapRegion(Region, Base, SizeOfImage);
+
+    Data      = Region->Data;
+    NtHeaders = &Data[TEST_IMAGE_NT_HEADERS_OFFSET];
+
+    TestWrite16(Data, UNWIND_IMAGE_DOS_SIGNATURE);
+    TestWrite32(&Data[UNWIND_IMAGE_DOS_HEADER_LFANEW_OFFSET], TEST_IMAGE_NT_HEADERS_OFFSET);
+    TestWrite32(NtHeaders, UNWIND_IMAGE_NT_SIGNATURE);
+    TestWrite32(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_TIME_DATE_STAMP_OFFSET], TimeDateStamp);
+    TestWrite16(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_MAGIC_OFFSET], UNWIND_IMAGE_NT_OPTIONAL_HDR64_MAGIC);
+    TestWrite32(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_SIZE_OF_IMAGE_OFFSET], SizeOfImage);
+    TestWrite32(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_NUMBER_OF_RVA_AND_SIZES_OFFSET], 16);
+
+    memcpy(&Data[TEST_IMAGE_UNWIND_INFO_RVA], PushRbxUnwindInfo, sizeof(PushRbxUnwindInfo));
+    memcpy(&Data[TEST_IMAGE_UNWIND_INFO_RVA + 0x10], PushRbpUnwindInfo, sizeof(PushRbpUnwindInfo));
+
+    //
+    // The leaf functions don't have entries in the exception directory
+    //
+    for (UINT32 i = 0; i < TEST_IMAGE_FUNCTION_COUNT; i++)
+    {
+        UNWIND_RUNTIME_FUNCTION Function;
+
+        if (TestGetFunctionKind(i) == TEST_FUNCTION_KIND_LEAF)
+        {
+            continue;
+        }
+
+        Function.BeginAddress = TEST_IMAGE_CODE_RVA + i * FunctionSize;
+        Function.EndAddress   = Function.BeginAddress + FunctionSize - 0x10;
+        Function.UnwindData   = TEST_IMAGE_UNWIND_INFO_RVA + (TestGetFunctionKind(i) == TEST_FUNCTION_KIND_PUSH_RBX ? 0 : 0x10);
+
+        memcpy(&Data[TEST_IMAGE_DIRECTORY_RVA + CountOfEntries++ * sizeof(UNWIND_RUNTIME_FUNCTION)], &Function, sizeof(Function));
+    }
+
+    TestWrite32(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_DATA_DIRECTORY_OFFSET + UNWIND_IMAGE_DIRECTORY_ENTRY_EXCEPTION * sizeof(UINT64)],
+                TEST_IMAGE_DIRECTORY_RVA);
+    TestWrite32(&NtHeaders[UNWIND_IMAGE_NT_HEADERS_DATA_DIRECTORY_OFFSET + UNWIND_IMAGE_DIRECTORY_ENTRY_EXCEPTION * sizeof(UINT64) + 4],
+                CountOfEntries * sizeof(UNWIND_RUNTIME_FUNCTION));
+
+    HOST_CHECK(TEST_IMAGE_DIRECTORY_RVA + CountOfEntries * sizeof(UNWIND_RUNTIME_FUNCTION) <= TEST_IMAGE_CODE_RVA);
+
+    Image->Region        = Region;
+    Image->FunctionSize  = FunctionSize;
+    Image->TimeDateStamp = TimeDateStamp;
+}
+
+/**
+ * @brief Build a synthetic stack, the frames are in the functions of the
+ * images (the body of the functions, after their prologs)
+ *
+ * @param Images
+ * @param CountOfImages
+ * @param Frames The expected frames (the last frame returns to zero)
+ * @param RandomState
+ * @param Context The context of the first frame
+ * @return VOID
+ */
+static VOID
+TestBuildStack(TEST_IMAGE * Images, UINT32 CountOfImages, TEST_FRAME * Frames, UINT64 * RandomState, UNWIND_CONTEXT * Context)
+{
+    TEST_REGION * Stack = TEST_REGION_STACK;
+    UINT64        Rsp   = Stack->Base + 0x100;
+    UINT64        Rbx   = HostRandom(RandomState);
+    UINT64        Rbp   = HostRandom(RandomState);
+    UINT64        Rsi   = HostRandom(RandomState);
+    UINT64        Rip;
+
+    memset(Context, 0, sizeof(UNWIND_CONTEXT));
+
+    for (UINT32 i = 0; i < TEST_STACK_FRAMES; i++)
+    {
+        TEST_IMAGE * Image    = &Images[HostRandom(RandomState) % CountOfImages];
+        UINT32       Function = (UINT32)(HostRandom(RandomState) % TEST_IMAGE_FUNCTION_COUNT);
+        UINT64       Offset;
+        UINT64       ReturnAddress;
+
+        Rip = Image->Region->Base + TEST_IMAGE_CODE_RVA + (UINT64)Function * Image->FunctionSize + 8 + HostRandom(RandomState) % 0x20;
+
+        if (i == 0)
+        {
+            Context->Rip                            = Rip;
+            Context->Registers[UNWIND_REGISTER_RSP] = Rsp;
+            Context->Registers[3]                   = Rbx;
+            Context->Registers[5]                   = Rbp;
+            Context->Registers[6]                   = Rsi;
+        }
+        else
+        {
+            //
+            // The return address of the previous frame
+            //
+            TestWrite64(&Stack->Data[Frames[i - 1].ReturnAddressLocation - Stack->Base], Rip);
+        }
+
+        Frames[i].Rip = Rip;
+
+        //
+        // Save the non-volatile registers of the caller
+        //
+        switch (TestGetFunctionKind(Function))
+        {
+        case TEST_FUNCTION_KIND_LEAF:
+            Offset = 0;
+            break;
+        case TEST_FUNCTION_KIND_PUSH_RBX:
+            Rbx = HostRandom(RandomState);
+            TestWrite64(&Stack->Data[Rsp + 0x20 - Stack->Base], Rbx);
+            Offset = 0x28;
+            break;
+        default:
+            Rsi = HostRandom(RandomState);
+            Rbp = HostRandom(RandomState);
+            TestWrite64(&Stack->Data[Rsp + 0x48 - Stack->Base], Rsi);
+            TestWrite64(&Stack->Data[Rsp + 0x50 - Stack->Base], Rbp);
+            Offset = 0x58;
+            break;
+        }
+
+        Frames[i].ReturnAddressLocation = Rsp + Offset;
+        Frames[i].Rbx                   = Rbx;
+        Frames[i].Rbp                   = Rbp;
+        Frames[i].Rsi                   = Rsi;
+
+        ReturnAddress = 0;
+        TestWrite64(&Stack->Data[Frames[i].ReturnAddressLocation - Stack->Base], ReturnAddress);
+
+        Rsp = Frames[i].ReturnAddressLocation + sizeof(UINT64);
+    }
+}
+
+/**
+ * @brief Unwind a synthetic stack and compare it with the expected frames
+ *
+ * @param State
+ * @param AddressSpace
+ * @param Frames
+ * @param Context
+ * @return VOID
+ */
+static VOID
+TestUnwindStack(UNWIND_STATE * State, UINT64 AddressSpace, TEST_FRAME * Frames, UNWIND_CONTEXT * Context)
+{
+    UINT64 ReturnAddressLocation;
+
+    for (UINT32 i = 0; i < TEST_STACK_FRAMES; i++)
+    {
+        HOST_CHECK(Context->Rip == Frames[i].Rip);
+        HOST_CHECK(UnwindStep(State, AddressSpace, Context, &ReturnAddressLocation) == UNWIND_STATUS_SUCCESS);
+        HOST_CHECK(ReturnAddressLocation == Frames[i].ReturnAddressLocation);
+        HOST_CHECK(Context->Registers[UNWIND_REGISTER_RSP] == ReturnAddressLocation + sizeof(UINT64));
+        HOST_CHECK(Context->Registers[3] == Frames[i].Rbx);
+        HOST_CHECK(Context->Registers[5] == Frames[i].Rbp);
+        HOST_CHECK(Context->Registers[6] == Frames[i].Rsi);
+    }
+
+    HOST_CHECK(Context->Rip == 0);
+}
+
+//////////////////////////////////////////////////
+//				      Tests         			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Unwind stacks in a user-mode image and a kernel-mode image, then
+ * replace the user-mode image (same base, different exception directory)
+ *
+ * @return VOID
+ */
+static VOID
+TestUnwindAndReplaceImage()
+{
+    static UNWIND_STATE State;
+    TEST_IMAGE          Images[2];
+    TEST_FRAME          Frames[TEST_STACK_FRAMES];
+    UNWIND_CONTEXT      Context;
+    UINT64              RandomState = 0x1234;
+    UINT64              ColdReads;
+    UINT64              WarmReads;
+
+    UnwindInitialize(&State, TestReadMemory);
+
+    TestMapRegion(TEST_REGION_STACK, 0x000000e000000000ull, 0x10000);
+    TestBuildImage(&Images[0], TEST_REGION_USER_IMAGE, 0x00007ff700000000ull, 0x40, 0x11111111);
+    TestBuildImage(&Images[1], TEST_REGION_KERNEL_IMAGE, 0xfffff80000123000ull, 0x40, 0x22222222);
+
+    g_TestCountOfReads = 0;
+
+    TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+    TestUnwindStack(&State, 0x1000, Frames, &Context);
+
+    ColdReads = g_TestCountOfReads;
+
+    for (UINT32 i = 0; i < 1000; i++)
+    {
+        TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+        TestUnwindStack(&State, 0x1000, Frames, &Context);
+    }
+
+    WarmReads = g_TestCountOfReads - ColdReads;
+
+    printf("unwind: %u stacks of %u frames, %.1f reads per frame (cold), %.1f reads per frame (warm)\n",
+           1001,
+           TEST_STACK_FRAMES,
+           (double)ColdReads / TEST_STACK_FRAMES,
+           (double)WarmReads / (1000.0 * TEST_STACK_FRAMES));
+
+    //
+    // Without the cached exception directory, each frame needs a read for
+    // each step of the binary search (about 14 for 16000 functions), the
+    // unwind info and the stack need about 7 reads
+    //
+    HOST_CHECK(WarmReads < 1000ull * TEST_STACK_FRAMES * 12);
+
+    //
+    // Another image is loaded at the same base, the cached functions and the
+    // cached parts of the exception directory should not be used
+    //
+    TestBuildImage(&Images[0], TEST_REGION_USER_IMAGE, 0x00007ff700000000ull, 0x50, 0x33333333);
+
+    for (UINT32 i = 0; i < 1000; i++)
+    {
+        TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+        TestUnwindStack(&State, 0x1000, Frames, &Context);
+    }
+
+    //
+    // The same image in another address space (it's a user-mode image)
+    //
+    for (UINT32 i = 0; i < 100; i++)
+    {
+        TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+        TestUnwindStack(&State, 0x2000, Frames, &Context);
+    }
+
+    HOST_CHECK(State.ModuleCount == 3);
+
+    printf("replace: the stacks of a replaced image are unwound with its new exception directory\n");
+}
+
+/**
+ * @brief Addresses that are not in an image are not scanned again
+ *
+ * @return VOID
+ */
+static VOID
+TestNegativeCache()
+{
+    static UNWIND_STATE     State;
+    UNWIND_RUNTIME_FUNCTION Function;
+    TEST_IMAGE              Image;
+    UINT64                  ImageBase;
+    UINT64                  ScanReads;
+    UINT64                  JitAddress = 0x0000000020123456ull;
+
+    UnwindInitialize(&State, TestReadMemory);
+
+    //
+    // A region of code without an image (e.g., JIT code)
+    //
+    TestMapRegion(TEST_REGION_JIT, 0x0000000020000000ull, 0x800000);
+
+    g_TestCountOfReads = 0;
+    HOST_CHECK(UnwindLookupFunction(&State, 0x1000, JitAddress, &ImageBase, &Function) == UNWIND_STATUS_NO_UNWIND_DATA);
+    ScanReads = g_TestCountOfReads;
+
+    HOST_CHECK(ScanReads > 0 && ScanReads <= UNWIND_MAXIMUM_IMAGE_SCAN_PROBES);
+
+    g_TestCountOfReads = 0;
+    HOST_CHECK(UnwindLookupFunction(&State, 0x1000, JitAddress + 0x10, &ImageBase, &Function) == UNWIND_STATUS_NO_UNWIND_DATA);
+    HOST_CHECK(g_TestCountOfReads == 0);
+
+    //
+    // Another page is scanned
+    //
+    HOST_CHECK(UnwindLookupFunction(&State, 0x1000, JitAddress + 0x10000, &ImageBase, &Function) == UNWIND_STATUS_NO_UNWIND_DATA);
+    HOST_CHECK(g_TestCountOfReads == ScanReads);
+
+    //
+    // An image is loaded there, it's found when the entry is expired (or
+    // after flushing the cache)
+    //
+    TestBuildImage(&Image, TEST_REGION_JIT, 0x0000000020000000ull, 0x40, 0x44444444);
+
+    HOST_CHECK(UnwindLookupFunction(&State, 0x1000, JitAddress, &ImageBase, &Function) == UNWIND_STATUS_NO_UNWIND_DATA);
+
+    for (UINT32 i = 0; i < UNWIND_NEGATIVE_CACHE_LIFETIME; i++)
+    {
+        UnwindFindModule(&State, 0x1000, 0x00007ff700000000ull);
+    }
+
+    HOST_CHECK(UnwindLookupFunction(&State, 0x1000, JitAddress, &ImageBase, &Function) == UNWIND_STATUS_SUCCESS);
+    HOST_CHECK(ImageBase == 0x0000000020000000ull);
+
+    printf("negative: %llu reads to scan an address that is not in an image, no reads for the next lookups\n",
+           (unsigned long long)ScanReads);
+}
+
+/**
+ * @brief Time of unwinding the synthetic stacks
+ *
+ * @return VOID
+ */
+static VOID
+TestBenchmark()
+{
+    static UNWIND_STATE State;
+    TEST_IMAGE          Images[2];
+    TEST_FRAME          Frames[TEST_STACK_FRAMES];
+    UNWIND_CONTEXT      Context;
+    UINT64              RandomState = 0x5678;
+    UINT64              ReturnAddressLocation;
+    UINT64              Begin;
+    UINT64              Time;
+    UINT32              Rounds = 2000;
+
+    UnwindInitialize(&State, TestReadMemory);
+
+    TestBuildImage(&Images[0], TEST_REGION_USER_IMAGE, 0x00007ff700000000ull, 0x40, 0x11111111);
+    TestBuildImage(&Images[1], TEST_REGION_KERNEL_IMAGE, 0xfffff80000123000ull, 0x40, 0x22222222);
+
+    TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+    TestUnwindStack(&State, 0x1000, Frames, &Context);
+
+    Begin = HostTimeNs();
+
+    for (UINT32 Round = 0; Round < Rounds; Round++)
+    {
+        TestBuildStack(Images, 2, Frames, &RandomState, &Context);
+
+        for (UINT32 i = 0; i < TEST_STACK_FRAMES; i++)
+        {
+            UnwindStep(&State, 0x1000, &Context, &ReturnAddressLocation);
+        }
+
+        HOST_CHECK(Context.Rip == 0);
+    }
+
+    Time = HostTimeNs() - Begin;
+
+    printf("benchmark: %.2f M frames per second (warm caches, including building the stacks)\n",
+           (double)Rounds * TEST_STACK_FRAMES * 1e3 / (double)Time);
+}
+
+int
+main()
+{
+    TestUnwindAndReplaceImage();
+    TestNegativeCache();
+    TestBenchmark();
+
+    printf("all tests passed\n");
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file pch.h
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Headers for testing the VM-exit profiler on the host
+ * @details The collecting part (hyperhv) is compiled as C and the showing
+ * part (the !vmexitprof command of libhyperdbg) is compiled as C++, the
+ * driver is simulated by the test which passes the requests of the command
+ * to the profiler, and the messages are captured instead of being shown
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#pragma once
+
+#include "../common/HostPlatform.h"
+
+#ifdef __cplusplus
+
+#    include <algorithm>
+#    include <string>
+#    include <tuple>
+#    include <vector>
+
+using namespace std;
+
+extern "C" {
+#endif
+
+#include "../../../include/SDK/headers/Constants.h"
+#include "../../../include/SDK/headers/Connection.h"
+#include "../../../include/SDK/headers/ErrorCodes.h"
+#include "../../../include/SDK/headers/Ioctls.h"
+#include "../../../include/SDK/headers/DataTypes.h"
+#include "../../../include/SDK/headers/RequestStructures.h"
+
+//////////////////////////////////////////////////
+//               Simulated Platform             //
+//////////////////////////////////////////////////
+
+#define MAXUINT64 ((UINT64) ~((UINT64)0))
+
+extern ULONG g_TestNumberOfCores;
+
+#define KeQueryActiveProcessorCount(Affinity) (g_TestNumberOfCores)
+
+//
+// Same as the pool, allocations of one page or more are page aligned
+//
+static inline PVOID
+PlatformMemAllocateZeroedNonPagedPool(SIZE_T NumberOfBytes)
+{
+    PVOID Buffer = aligned_alloc(PAGE_SIZE, ROUND_TO_PAGES(NumberOfBytes));
+
+    if (Buffer != NULL)
+    {
+        RtlZeroMemory(Buffer, NumberOfBytes);
+    }
+
+    return Buffer;
+}
+
+static inline VOID
+PlatformMemFreePool(PVOID BufferAddress)
+{
+    free(BufferAddress);
+}
+
+static inline UCHAR
+_BitScanReverse64(ULONG * Index, UINT64 Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+
+    *Index = (ULONG)(63 - __builtin_clzll(Mask));
+
+    return 1;
+}
+
+//
+// Implemented by the test (the counters of the guest translation cache)
+//
+VOID
+TranslationCacheResetStatistics();
+
+VOID
+TranslationCacheQueryStatistics(UINT32 CoreId, UINT64 * Hits, UINT64 * Misses);
+
+//////////////////////////////////////////////////
+//               VM-exit Profiler               //
+//////////////////////////////////////////////////
+
+#ifndef __cplusplus
+
+#    include "../../../hyperhv/header/features/VmexitProfiler.h"
+
+#else
+
+//
+// The globals are defined in the header, so it's only included in the C part
+//
+extern volatile BOOLEAN g_VmexitProfilerEnabled;
+extern PVOID            g_VmexitProfilerCoreData;
+
+BOOLEAN
+VmexitProfilerInitialize();
+
+VOID
+VmexitProfilerUninitialize();
+
+VOID
+VmexitProfilerEnable(BOOLEAN Enable);
+
+VOID
+VmexitProfilerReset();
+
+VOID
+VmexitProfilerRecordExit(UINT32 CoreId, UINT32 ExitReason, UINT64 Cycles);
+
+VOID
+VmexitProfilerAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles);
+
+BOOLEAN
+VmexitProfilerQuery(UINT32 CoreId, VMEXIT_PROFILER_RESULTS * Results);
+}
+
+//////////////////////////////////////////////////
+//               Simulated libhyperdbg          //
+//////////////////////////////////////////////////
+
+#    define AssertReturnFalse               return FALSE;
+#    define ASSERT_MESSAGE_DRIVER_NOT_LOADED "handle of the driver not found, probably the driver is not loaded. Did you use 'load' command?\n"
+
+#    define AssertShowMessageReturnStmt(expr, message, rc) \
+        do                                                 \
+        {                                                  \
+            if (!(expr))                                   \
+            {                                              \
+                ShowMessages(message);                     \
+                rc;                                        \
+            }                                              \
+        } while (0)
+
+#    define sprintf_s snprintf
+
+typedef enum
+{
+    Num,
+    String,
+    StringLiteral,
+    BracketString
+} CommandParsingTokenType;
+
+typedef std::tuple<CommandParsingTokenType, std::string, std::string> CommandToken;
+
+extern HANDLE g_DeviceHandle;
+
+//
+// Implemented by the test
+//
+VOID
+ShowMessages(const char * Fmt, ...);
+
+BOOLEAN
+ShowErrorMessage(UINT32 Error);
+
+UINT32
+GetLastError();
+
+BOOL
+DeviceIoControl(HANDLE  Device,
+                UINT32  IoControlCode,
+                PVOID   InBuffer,
+                UINT32  InBufferSize,
+                PVOID   OutBuffer,
+                UINT32  OutBufferSize,
+                ULONG * BytesReturned,
+                PVOID   Overlapped);
+
+BOOLEAN
+KdSendVmexitProfilerActionPacketsToDebuggee(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest, UINT32 ExpectedRequestSize);
+
+BOOLEAN
+CompareLowerCaseStrings(CommandToken TargetToken, const char * StringToCompare);
+
+BOOLEAN
+ConvertTokenToUInt32(CommandToken TargetToken, PUINT32 Result);
+
+std::string
+GetCaseSensitiveStringFromCommandToken(CommandToken TargetToken);
+
+//
+// Functions of the !vmexitprof command (debugger.h and commands.h)
+//
+UINT64
+VmexitProfilerEstimatePercentile(const VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT32 Percentile);
+
+UINT64
+VmexitProfilerSortExitReasons(const VMEXIT_PROFILER_RESULTS * Results, vector<UINT32> & SortedReasons);
+
+VOID
+CommandVmexitprofShowResults(const VMEXIT_PROFILER_RESULTS * Results, UINT32 TargetReason);
+
+VOID
+CommandVmexitprof(vector<CommandToken> CommandTokens, string Command);
+
+#endif
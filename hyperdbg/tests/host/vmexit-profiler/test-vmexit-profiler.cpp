@@ -0,0 +1,826 @@
+/**
+ * @file test-vmexit-profiler.cpp
+ * @author Sina Karvandi (sina@hyperdbg.org)
+ * @brief Tests of the VM-exit profiler (aggregation, percentiles, and formatting)
+ * @details Synthetic samples are recorded on the simulated cores and the
+ * histograms, the estimated percentiles, and the messages of the
+ * !vmexitprof command are compared with a reference computed from the
+ * samples themselves
+ * @version 0.12
+ * @date 2024-12-10
+ *
+ * @copyright This project is released under the GNU Public License v3.
+ *
+ */
+#include "pch.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+
+//////////////////////////////////////////////////
+//				      Definitions     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Number of simulated cores
+ *
+ */
+#define TEST_NUMBER_OF_CORES 4
+
+/**
+ * @brief Number of samples that each core records in the aggregation test
+ *
+ */
+#define TEST_SAMPLES_PER_CORE 200000
+
+/**
+ * @brief Exit reasons of the tests (ia32-doc)
+ *
+ */
+#define VMX_EXIT_REASON_EXECUTE_CPUID 0x0000000A
+#define VMX_EXIT_REASON_EXECUTE_RDTSC 0x00000010
+#define VMX_EXIT_REASON_EPT_VIOLATION 0x00000030
+
+ULONG   g_TestNumberOfCores = TEST_NUMBER_OF_CORES;
+HANDLE  g_DeviceHandle      = (HANDLE)1;
+BOOLEAN g_IsSerialConnectedToRemoteDebuggee;
+
+/**
+ * @brief Hits and misses of the simulated guest translation cache
+ *
+ */
+UINT64 g_TestTranslationCacheHits[TEST_NUMBER_OF_CORES];
+UINT64 g_TestTranslationCacheMisses[TEST_NUMBER_OF_CORES];
+
+/**
+ * @brief The messages that are shown by the command
+ *
+ */
+string g_TestMessages;
+
+/**
+ * @brief The last error that is shown by ShowErrorMessage
+ *
+ */
+UINT32 g_TestLastError;
+
+//////////////////////////////////////////////////
+//				 Simulated Platform   			//
+//////////////////////////////////////////////////
+
+VOID
+TranslationCacheResetStatistics()
+{
+    RtlZeroMemory(g_TestTranslationCacheHits, sizeof(g_TestTranslationCacheHits));
+    RtlZeroMemory(g_TestTranslationCacheMisses, sizeof(g_TestTranslationCacheMisses));
+}
+
+VOID
+TranslationCacheQueryStatistics(UINT32 CoreId, UINT64 * Hits, UINT64 * Misses)
+{
+    *Hits += g_TestTranslationCacheHits[CoreId];
+    *Misses += g_TestTranslationCacheMisses[CoreId];
+}
+
+VOID
+ShowMessages(const char * Fmt, ...)
+{
+    va_list ArgList;
+    CHAR    Buffer[1024];
+
+    va_start(ArgList, Fmt);
+    vsnprintf(Buffer, sizeof(Buffer), Fmt, ArgList);
+    va_end(ArgList);
+
+    g_TestMessages += Buffer;
+}
+
+BOOLEAN
+ShowErrorMessage(UINT32 Error)
+{
+    g_TestLastError = Error;
+
+    return TRUE;
+}
+
+UINT32
+GetLastError()
+{
+    return 0;
+}
+
+BOOLEAN
+KdSendVmexitProfilerActionPacketsToDebuggee(PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest, UINT32 ExpectedRequestSize)
+{
+    return FALSE;
+}
+
+/**
+ * @brief Simulate the driver (ExtensionCommandPerformActionsForVmexitProfilerRequests
+ * without the histograms of the events)
+ *
+ */
+BOOL
+DeviceIoControl(HANDLE  Device,
+                UINT32  IoControlCode,
+                PVOID   InBuffer,
+                UINT32  InBufferSize,
+                PVOID   OutBuffer,
+                UINT32  OutBufferSize,
+                ULONG * BytesReturned,
+                PVOID   Overlapped)
+{
+    PDEBUGGER_VMEXIT_PROFILER_REQUEST ProfilerRequest = (PDEBUGGER_VMEXIT_PROFILER_REQUEST)OutBuffer;
+    PVMEXIT_PROFILER_RESULTS          Results         = (PVMEXIT_PROFILER_RESULTS)(ProfilerRequest + 1);
+
+    HOST_CHECK(IoControlCode == IOCTL_PERFORM_ACTIONS_ON_VMEXIT_PROFILER);
+    HOST_CHECK(InBuffer == OutBuffer && InBufferSize == SIZEOF_DEBUGGER_VMEXIT_PROFILER_REQUEST);
+
+    *BytesReturned                = sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST);
+    ProfilerRequest->KernelStatus = DEBUGGER_OPERATION_WAS_SUCCESSFUL;
+
+    switch (ProfilerRequest->RequestType)
+    {
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_ENABLE:
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_DISABLE:
+
+        VmexitProfilerEnable(ProfilerRequest->RequestType == DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_ENABLE);
+        break;
+
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_RESET:
+
+        VmexitProfilerReset();
+        break;
+
+    case DEBUGGER_VMEXIT_PROFILER_REQUEST_TYPE_QUERY:
+
+        HOST_CHECK(OutBufferSize == sizeof(DEBUGGER_VMEXIT_PROFILER_REQUEST) + sizeof(VMEXIT_PROFILER_RESULTS));
+
+        if (!VmexitProfilerQuery(ProfilerRequest->CoreId, Results))
+        {
+            ProfilerRequest->KernelStatus = DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR;
+            break;
+        }
+
+        *BytesReturned = OutBufferSize;
+        break;
+
+    default:
+
+        ProfilerRequest->KernelStatus = DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR;
+        break;
+    }
+
+    ProfilerRequest->IsEnabled = g_VmexitProfilerEnabled;
+
+    return TRUE;
+}
+
+//////////////////////////////////////////////////
+//				 Simulated Tokens     			//
+//////////////////////////////////////////////////
+
+BOOLEAN
+CompareLowerCaseStrings(CommandToken TargetToken, const char * StringToCompare)
+{
+    return strcasecmp(std::get<2>(TargetToken).c_str(), StringToCompare) == 0;
+}
+
+BOOLEAN
+ConvertTokenToUInt32(CommandToken TargetToken, PUINT32 Result)
+{
+    const string & Value = std::get<1>(TargetToken);
+    CHAR *         End;
+
+    *Result = (UINT32)strtoul(Value.c_str(), &End, 16);
+
+    return !Value.empty() && *End == '\0';
+}
+
+std::string
+GetCaseSensitiveStringFromCommandToken(CommandToken TargetToken)
+{
+    return std::get<1>(TargetToken);
+}
+
+/**
+ * @brief Run the !vmexitprof command and return its messages
+ *
+ * @param Command
+ * @return string
+ */
+static string
+TestRunCommand(const string & Command)
+{
+    vector<CommandToken> Tokens;
+    size_t               Start = 0;
+
+    while ((Start = Command.find_first_not_of(' ', Start)) != string::npos)
+    {
+        size_t End   = std::min(Command.find(' ', Start), Command.length());
+        string Value = Command.substr(Start, End - Start);
+        string Lower = Value;
+
+        std::transform(Lower.begin(), Lower.end(), Lower.begin(), ::tolower);
+        Tokens.push_back(CommandToken(CommandParsingTokenType::String, Value, Lower));
+
+        Start = End;
+    }
+
+    g_TestMessages.clear();
+    CommandVmexitprof(Tokens, Command);
+
+    return g_TestMessages;
+}
+
+//////////////////////////////////////////////////
+//				      Reference     			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief The bucket of a sample (floor of log2, clamped to the last bucket)
+ *
+ * @param Cycles
+ * @return UINT32
+ */
+static UINT32
+TestReferenceBucket(UINT64 Cycles)
+{
+    UINT32 Bucket = 0;
+
+    while (Cycles > 1)
+    {
+        Cycles >>= 1;
+        Bucket++;
+    }
+
+    return Bucket < VMEXIT_PROFILER_HISTOGRAM_BUCKETS ? Bucket : VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * @brief Add a sample to the reference histogram
+ *
+ * @param Histogram
+ * @param Cycles
+ * @return VOID
+ */
+static VOID
+TestReferenceAddSample(VMEXIT_PROFILER_HISTOGRAM * Histogram, UINT64 Cycles)
+{
+    Histogram->Count++;
+    Histogram->TotalCycles += Cycles;
+    Histogram->Buckets[TestReferenceBucket(Cycles)]++;
+    Histogram->MaxCycles = std::max(Histogram->MaxCycles, Cycles);
+}
+
+/**
+ * @brief A random latency with a long tail (most of the samples are
+ * short, a few of them are very long)
+ *
+ * @param State
+ * @return UINT64
+ */
+static UINT64
+TestRandomCycles(UINT64 * State)
+{
+    UINT64 Random = HostRandom(State);
+    UINT32 Shift  = (UINT32)(Random % 1000) < 990 ? 6 + (UINT32)(Random >> 10) % 8 : 14 + (UINT32)(Random >> 10) % 30;
+
+    return (Random >> 20) & ((1ull << Shift) - 1);
+}
+
+//////////////////////////////////////////////////
+//				        Tests       			//
+//////////////////////////////////////////////////
+
+/**
+ * @brief Check the buckets of the samples (including the boundaries)
+ *
+ * @return VOID
+ */
+static VOID
+TestBuckets()
+{
+    VMEXIT_PROFILER_HISTOGRAM Histogram = {0};
+    VMEXIT_PROFILER_HISTOGRAM Reference = {0};
+    UINT64                    State     = 0x2545f4914f6cdd1dull;
+
+    const struct
+    {
+        UINT64 Cycles;
+        UINT32 Bucket;
+    } Boundaries[] = {
+        {0, 0},
+        {1, 0},
+        {2, 1},
+        {3, 1},
+        {4, 2},
+        {1023, 9},
+        {1024, 10},
+        {(1ull << 31) - 1, 30},
+        {1ull << 31, 31},
+        {1ull << 40, 31},
+        {MAXUINT64, 31},
+    };
+
+    for (UINT32 i = 0; i < RTL_NUMBER_OF(Boundaries); i++)
+    {
+        RtlZeroMemory(&Histogram, sizeof(Histogram));
+        VmexitProfilerAddSample(&Histogram, Boundaries[i].Cycles);
+
+        HOST_CHECK(Histogram.Count == 1);
+        HOST_CHECK(Histogram.TotalCycles == Boundaries[i].Cycles);
+        HOST_CHECK(Histogram.MaxCycles == Boundaries[i].Cycles);
+        HOST_CHECK(Histogram.Buckets[Boundaries[i].Bucket] == 1);
+        HOST_CHECK(TestReferenceBucket(Boundaries[i].Cycles) == Boundaries[i].Bucket);
+    }
+
+    RtlZeroMemory(&Histogram, sizeof(Histogram));
+
+    for (UINT32 i = 0; i < 100000; i++)
+    {
+        UINT64 Cycles = TestRandomCycles(&State);
+
+        VmexitProfilerAddSample(&Histogram, Cycles);
+        TestReferenceAddSample(&Reference, Cycles);
+    }
+
+    HOST_CHECK(memcmp(&Histogram, &Reference, sizeof(Histogram)) == 0);
+
+    printf("buckets: ok\n");
+}
+
+/**
+ * @brief Arguments of the recording threads
+ *
+ */
+typedef struct _TEST_CORE_ARGUMENTS
+{
+    UINT32                  CoreId;
+    VMEXIT_PROFILER_RESULTS Reference;
+
+} TEST_CORE_ARGUMENTS;
+
+/**
+ * @brief Record random VM-exits on a simulated core
+ *
+ * @param Parameter
+ * @return void *
+ */
+static void *
+TestRecordingThread(void * Parameter)
+{
+    TEST_CORE_ARGUMENTS * Arguments = (TEST_CORE_ARGUMENTS *)Parameter;
+    UINT64                State     = 0x9e3779b97f4a7c15ull * (Arguments->CoreId + 1);
+
+    for (UINT32 i = 0; i < TEST_SAMPLES_PER_CORE; i++)
+    {
+        UINT64 Random = HostRandom(&State);
+        UINT32 Reason = (UINT32)(Random % 100) < 95 ? (UINT32)(Random >> 8) % 4 * 16 : (UINT32)(Random >> 8) % 100;
+        UINT64 Cycles = TestRandomCycles(&State);
+
+        VmexitProfilerRecordExit(Arguments->CoreId, Reason, Cycles);
+
+        if (Reason >= VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS)
+        {
+            Arguments->Reference.UnknownExitReasons++;
+        }
+        else
+        {
+            TestReferenceAddSample(&Arguments->Reference.ExitReasons[Reason], Cycles);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Record on all cores concurrently and check the per-core and the
+ * aggregated results
+ *
+ * @return VOID
+ */
+static VOID
+TestAggregation()
+{
+    static TEST_CORE_ARGUMENTS      Arguments[TEST_NUMBER_OF_CORES];
+    static VMEXIT_PROFILER_RESULTS  Results;
+    static VMEXIT_PROFILER_RESULTS  Expected;
+    pthread_t                       Threads[TEST_NUMBER_OF_CORES];
+
+    HOST_CHECK(((ULONG_PTR)g_VmexitProfilerCoreData & (CPU_CACHE_LINE_SIZE - 1)) == 0);
+
+    VmexitProfilerReset();
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        RtlZeroMemory(&Arguments[i], sizeof(TEST_CORE_ARGUMENTS));
+        Arguments[i].CoreId = i;
+
+        g_TestTranslationCacheHits[i]   = 1000 * (i + 1);
+        g_TestTranslationCacheMisses[i] = 10 * (i + 1);
+
+        HOST_CHECK(pthread_create(&Threads[i], NULL, TestRecordingThread, &Arguments[i]) == 0);
+    }
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        HOST_CHECK(pthread_join(Threads[i], NULL) == 0);
+    }
+
+    //
+    // Each core separately
+    //
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        Expected                        = Arguments[i].Reference;
+        Expected.TranslationCacheHits   = g_TestTranslationCacheHits[i];
+        Expected.TranslationCacheMisses = g_TestTranslationCacheMisses[i];
+
+        memset(&Results, 0xcc, sizeof(Results));
+        HOST_CHECK(VmexitProfilerQuery(i, &Results));
+        HOST_CHECK(memcmp(&Results, &Expected, sizeof(Results)) == 0);
+    }
+
+    //
+    // All cores (the reference is merged in a different way)
+    //
+    RtlZeroMemory(&Expected, sizeof(Expected));
+
+    for (UINT32 i = 0; i < TEST_NUMBER_OF_CORES; i++)
+    {
+        Expected.UnknownExitReasons += Arguments[i].Reference.UnknownExitReasons;
+        Expected.TranslationCacheHits += g_TestTranslationCacheHits[i];
+        Expected.TranslationCacheMisses += g_TestTranslationCacheMisses[i];
+
+        for (UINT32 Reason = 0; Reason < VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS; Reason++)
+        {
+            VMEXIT_PROFILER_HISTOGRAM * Source      = &Arguments[i].Reference.ExitReasons[Reason];
+            VMEXIT_PROFILER_HISTOGRAM * Destination = &Expected.ExitReasons[Reason];
+
+            Destination->Count += Source->Count;
+            Destination->TotalCycles += Source->TotalCycles;
+            Destination->MaxCycles = std::max(Destination->MaxCycles, Source->MaxCycles);
+
+            for (UINT32 Bucket = 0; Bucket < VMEXIT_PROFILER_HISTOGRAM_BUCKETS; Bucket++)
+            {
+                Destination->Buckets[Bucket] += Source->Buckets[Bucket];
+            }
+        }
+    }
+
+    HOST_CHECK(Expected.UnknownExitReasons != 0);
+
+    HOST_CHECK(VmexitProfilerQuery(DEBUGGER_VMEXIT_PROFILER_ALL_CORES, &Results));
+    HOST_CHECK(memcmp(&Results, &Expected, sizeof(Results)) == 0);
+
+    //
+    // Invalid core
+    //
+    HOST_CHECK(!VmexitProfilerQuery(TEST_NUMBER_OF_CORES, &Results));
+
+    //
+    // Reset clears the samples and the counters of the translation cache
+    //
+    VmexitProfilerReset();
+
+    RtlZeroMemory(&Expected, sizeof(Expected));
+    HOST_CHECK(VmexitProfilerQuery(DEBUGGER_VMEXIT_PROFILER_ALL_CORES, &Results));
+    HOST_CHECK(memcmp(&Results, &Expected, sizeof(Results)) == 0);
+
+    printf("aggregation: ok (%u cores, %u samples per core)\n", TEST_NUMBER_OF_CORES, TEST_SAMPLES_PER_CORE);
+}
+
+/**
+ * @brief Compare the estimated percentiles with the exact percentiles
+ * of the samples
+ *
+ * @return VOID
+ */
+static VOID
+TestPercentiles()
+{
+    VMEXIT_PROFILER_HISTOGRAM Histogram  = {0};
+    UINT64                    State      = 0xd1b54a32d192ed03ull;
+    const UINT32              Counts[]   = {1, 2, 3, 10, 99, 100, 101, 1000, 54321};
+    const UINT32              Percents[] = {1, 25, 50, 90, 99, 100};
+    vector<UINT64>            Samples;
+
+    //
+    // No samples
+    //
+    HOST_CHECK(VmexitProfilerEstimatePercentile(&Histogram, 50) == 0);
+
+    for (UINT32 Distribution = 0; Distribution < 4; Distribution++)
+    {
+        for (UINT32 Count : Counts)
+        {
+            RtlZeroMemory(&Histogram, sizeof(Histogram));
+            Samples.clear();
+
+            for (UINT32 i = 0; i < Count; i++)
+            {
+                UINT64 Cycles;
+
+                switch (Distribution)
+                {
+                case 0:
+                    Cycles = TestRandomCycles(&State);
+                    break;
+                case 1:
+                    Cycles = 1000;
+                    break;
+                case 2:
+                    Cycles = HostRandom(&State) % 4;
+                    break;
+                default:
+                    Cycles = (1ull << 31) + HostRandom(&State) % (1ull << 40);
+                    break;
+                }
+
+                Samples.push_back(Cycles);
+                VmexitProfilerAddSample(&Histogram, Cycles);
+            }
+
+            std::sort(Samples.begin(), Samples.end());
+
+            for (UINT32 Percent : Percents)
+            {
+                UINT64 Rank     = ((UINT64)Count * Percent + 99) / 100;
+                UINT64 Exact    = Samples[Rank - 1];
+                UINT32 Bucket   = TestReferenceBucket(Exact);
+                UINT64 Estimate = VmexitProfilerEstimatePercentile(&Histogram, Percent);
+
+                //
+                // The upper bound of the bucket of the exact percentile,
+                // but never bigger than the maximum sample
+                //
+                UINT64 UpperBound = Bucket == VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1 ? Samples.back() : (2ull << Bucket) - 1;
+
+                HOST_CHECK(Estimate == std::min(UpperBound, Samples.back()));
+                HOST_CHECK(Estimate >= Exact && Estimate <= Samples.back());
+                HOST_CHECK(Bucket == VMEXIT_PROFILER_HISTOGRAM_BUCKETS - 1 || Estimate <= 2 * Exact + 1);
+
+                if (Percent == 100)
+                {
+                    HOST_CHECK(Estimate == Samples.back());
+                }
+            }
+        }
+    }
+
+    printf("percentiles: ok\n");
+}
+
+/**
+ * @brief Check the order of the exit reasons
+ *
+ * @return VOID
+ */
+static VOID
+TestSortExitReasons()
+{
+    static VMEXIT_PROFILER_RESULTS Results;
+    vector<UINT32>                 SortedReasons = {1, 2, 3};
+    UINT64                         State         = 0x8badf00dull;
+    UINT64                         TotalCycles   = 0;
+    UINT32                         NonEmpty      = 0;
+
+    RtlZeroMemory(&Results, sizeof(Results));
+
+    //
+    // No samples, the previous content is removed
+    //
+    HOST_CHECK(VmexitProfilerSortExitReasons(&Results, SortedReasons) == 0);
+    HOST_CHECK(SortedReasons.empty());
+
+    for (UINT32 i = 0; i < VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS; i++)
+    {
+        UINT32 Count = (UINT32)(HostRandom(&State) % 4);
+
+        for (UINT32 j = 0; j < Count; j++)
+        {
+            UINT64 Cycles = HostRandom(&State) % 100000;
+
+            VmexitProfilerAddSample(&Results.ExitReasons[i], Cycles);
+            TotalCycles += Cycles;
+        }
+
+        NonEmpty += Count != 0;
+    }
+
+    HOST_CHECK(VmexitProfilerSortExitReasons(&Results, SortedReasons) == TotalCycles);
+    HOST_CHECK(SortedReasons.size() == NonEmpty);
+
+    for (UINT32 i = 0; i < SortedReasons.size(); i++)
+    {
+        HOST_CHECK(Results.ExitReasons[SortedReasons[i]].Count != 0);
+        HOST_CHECK(i == 0 || Results.ExitReasons[SortedReasons[i - 1]].TotalCycles >= Results.ExitReasons[SortedReasons[i]].TotalCycles);
+        HOST_CHECK(std::count(SortedReasons.begin(), SortedReasons.end(), SortedReasons[i]) == 1);
+    }
+
+    printf("sorting: ok (%u exit reasons)\n", NonEmpty);
+}
+
+/**
+ * @brief Check the messages of the results
+ *
+ * @return VOID
+ */
+static VOID
+TestFormatting()
+{
+    static VMEXIT_PROFILER_RESULTS Results;
+
+    RtlZeroMemory(&Results, sizeof(Results));
+
+    //
+    // CPUID: avg 1400, p50 is in [128, 255], p99 is capped at the maximum
+    //
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EXECUTE_CPUID], 100);
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EXECUTE_CPUID], 200);
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EXECUTE_CPUID], 300);
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EXECUTE_CPUID], 5000);
+
+    //
+    // EPT violation: both percentiles are capped at the maximum
+    //
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EPT_VIOLATION], 1000);
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EPT_VIOLATION], 1000);
+
+    //
+    // A reserved exit reason
+    //
+    VmexitProfilerAddSample(&Results.ExitReasons[35], 4);
+
+    Results.UnknownExitReasons     = 7;
+    Results.TranslationCacheHits   = 3;
+    Results.TranslationCacheMisses = 1;
+
+    //
+    // Events (they're already sorted by the debugger module)
+    //
+    Results.Events[0].Tag = DebuggerEventTagStartSeed + 3;
+    VmexitProfilerAddSample(&Results.Events[0].Histogram, 300);
+    VmexitProfilerAddSample(&Results.Events[0].Histogram, 500);
+
+    Results.Events[2].Tag = DebuggerEventTagStartSeed + 0x1a;
+    VmexitProfilerAddSample(&Results.Events[2].Histogram, 200);
+
+    Results.UntrackedEvents = 2;
+    Results.OmittedEvents   = 5;
+
+    g_TestMessages.clear();
+    CommandVmexitprofShowResults(&Results, VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS);
+
+    HOST_CHECK(g_TestMessages ==
+               "exit reason                                 count    time        avg        p50        p99          max\n"
+               "(0a) CPUID                                      4  73.65%       1400        255       5000         5000\n"
+               "(30) EPT_VIOLATION                              2  26.30%       1000       1000       1000         1000\n"
+               "(23) RESERVED                                   1   0.05%          4          4          4            4\n"
+               "7 VM-exit(s) with unknown exit reasons\n"
+               "\n"
+               "translation cache: 3 hit(s), 1 miss(es) (75.00% hit rate)\n"
+               "\n"
+               "2 trigger(s) of the events are not tracked (too many alive events)\n"
+               "\n"
+               "event                                       count    time        avg        p50        p99          max\n"
+               "3                                               2  80.00%        400        500        500          500\n"
+               "1a                                              1  20.00%        200        200        200          200\n"
+               "5 cheaper event(s) are not shown\n");
+
+    //
+    // The buckets of an exit reason
+    //
+    g_TestMessages.clear();
+    VmexitProfilerAddSample(&Results.ExitReasons[VMX_EXIT_REASON_EXECUTE_CPUID], 150);
+    CommandVmexitprofShowResults(&Results, VMX_EXIT_REASON_EXECUTE_CPUID);
+
+    HOST_CHECK(g_TestMessages ==
+               "exit reason: 0xa (CPUID)\n"
+               "\n"
+               "[        64,        127]             1 |####################\n"
+               "[       128,        255]             2 |########################################\n"
+               "[       256,        511]             1 |####################\n"
+               "[      4096,       8191]             1 |####################\n");
+
+    g_TestMessages.clear();
+    CommandVmexitprofShowResults(&Results, 1);
+
+    HOST_CHECK(g_TestMessages == "exit reason: 0x1 (EXTERNAL_INTERRUPT)\n\nno samples\n");
+
+    //
+    // The first and the last buckets
+    //
+    RtlZeroMemory(&Results, sizeof(Results));
+    VmexitProfilerAddSample(&Results.ExitReasons[0], 1);
+    VmexitProfilerAddSample(&Results.ExitReasons[0], 1ull << 33);
+
+    g_TestMessages.clear();
+    CommandVmexitprofShowResults(&Results, 0);
+
+    HOST_CHECK(g_TestMessages ==
+               "exit reason: 0x0 (EXCEPTION_OR_NMI)\n"
+               "\n"
+               "[         0,          1]             1 |########################################\n"
+               "[2147483648, 4294967295+]            1 |########################################\n");
+
+    //
+    // No samples at all
+    //
+    RtlZeroMemory(&Results, sizeof(Results));
+
+    g_TestMessages.clear();
+    CommandVmexitprofShowResults(&Results, VMEXIT_PROFILER_MAXIMUM_EXIT_REASONS);
+
+    HOST_CHECK(g_TestMessages == "no VM-exit is recorded, use '!vmexitprof on' to start profiling\n");
+
+    printf("formatting: ok\n");
+}
+
+/**
+ * @brief Run the !vmexitprof command against the simulated driver
+ *
+ * @return VOID
+ */
+static VOID
+TestCommand()
+{
+    string Messages;
+
+    HOST_CHECK(TestRunCommand("!vmexitprof reset") == "VM-exit profiler samples are cleared\n");
+    HOST_CHECK(TestRunCommand("!vmexitprof on") == "VM-exit profiler is enabled\n");
+    HOST_CHECK(g_VmexitProfilerEnabled);
+
+    VmexitProfilerRecordExit(1, VMX_EXIT_REASON_EXECUTE_RDTSC, 50);
+    VmexitProfilerRecordExit(2, VMX_EXIT_REASON_EXECUTE_RDTSC, 70);
+
+    //
+    // Only the samples of the second core
+    //
+    Messages = TestRunCommand("!vmexitprof show core 2");
+
+    HOST_CHECK(Messages ==
+               "VM-exit profiler is enabled\n"
+               "\n"
+               "exit reason                                 count    time        avg        p50        p99          max\n"
+               "(10) RDTSC                                      1 100.00%         70         70         70           70\n");
+
+    //
+    // All cores
+    //
+    Messages = TestRunCommand("!vmexitprof");
+
+    HOST_CHECK(Messages.find("(10) RDTSC                                      2 100.00%         60         63         70           70\n") != string::npos);
+
+    Messages = TestRunCommand("!vmexitprof show reason 10");
+
+    HOST_CHECK(Messages ==
+               "VM-exit profiler is enabled\n"
+               "\n"
+               "exit reason: 0x10 (RDTSC)\n"
+               "\n"
+               "[        32,         63]             1 |########################################\n"
+               "[        64,        127]             1 |########################################\n");
+
+    //
+    // Invalid parameters
+    //
+    g_TestLastError = 0;
+    HOST_CHECK(TestRunCommand("!vmexitprof core 4") == "");
+    HOST_CHECK(g_TestLastError == DEBUGGER_ERROR_VMEXIT_PROFILER_ACTIONS_ERROR);
+
+    HOST_CHECK(TestRunCommand("!vmexitprof reason 50") == "err, invalid exit reason\n");
+    HOST_CHECK(TestRunCommand("!vmexitprof core xyz") == "err, invalid core id\n");
+    HOST_CHECK(TestRunCommand("!vmexitprof show core").find("incorrect use of the '!vmexitprof'") == 0);
+
+    HOST_CHECK(TestRunCommand("!vmexitprof off") == "VM-exit profiler is disabled\n");
+    HOST_CHECK(!g_VmexitProfilerEnabled);
+
+    HOST_CHECK(TestRunCommand("!vmexitprof reset") == "VM-exit profiler samples are cleared\n");
+    HOST_CHECK(TestRunCommand("!vmexitprof") ==
+               "VM-exit profiler is disabled\n"
+               "\n"
+               "no VM-exit is recorded, use '!vmexitprof on' to start profiling\n");
+
+    printf("command: ok\n");
+}
+
+int
+main()
+{
+    HOST_CHECK(VmexitProfilerInitialize());
+
+    TestBuckets();
+    TestAggregation();
+    TestPercentiles();
+    TestSortExitReasons();
+    TestFormatting();
+    TestCommand();
+
+    VmexitProfilerUninitialize();
+
+    printf("all tests passed\n");
+
+    return 0;
+}